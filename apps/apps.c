@@ -2420,6 +2420,58 @@ int app_isdir(const char *name)
 }
 #endif
 
+/* app_map_read section */
+#if defined(OPENSSL_SYS_UNIX) && !defined(OPENSSL_NO_POSIX_IO)
+# include <unistd.h>
+# include <sys/mman.h>
+
+/* A multiple of any page size, so that every window stays aligned */
+# define APP_MAP_CHUNK   ((off_t)1 << 26)
+
+int app_map_read(BIO *in,
+                 int (*fn)(void *arg, const unsigned char *data, size_t len),
+                 void *arg)
+{
+    FILE *fp = NULL;
+    struct stat st;
+    off_t pos, start, len, skip;
+    long page = sysconf(_SC_PAGESIZE);
+    unsigned char *p;
+    int ok;
+
+    if (BIO_method_type(in) != BIO_TYPE_FILE
+            || BIO_get_fp(in, &fp) <= 0 || fp == NULL || page <= 0
+            || fstat(fileno(fp), &st) != 0 || !S_ISREG(st.st_mode)
+            || (pos = ftello(fp)) < 0 || pos >= st.st_size)
+        return -1;
+
+    for (start = pos - pos % page; start < st.st_size; start += len) {
+        len = st.st_size - start;
+        if (len > APP_MAP_CHUNK)
+            len = APP_MAP_CHUNK;
+        p = mmap(NULL, (size_t)len, PROT_READ, MAP_PRIVATE, fileno(fp), start);
+        if (p == MAP_FAILED)
+            return start <= pos ? -1 : 0;
+# ifdef MADV_SEQUENTIAL
+        (void)madvise(p, (size_t)len, MADV_SEQUENTIAL);
+# endif
+        skip = start < pos ? pos - start : 0;
+        ok = fn(arg, p + skip, (size_t)(len - skip));
+        munmap(p, (size_t)len);
+        if (!ok)
+            return 0;
+    }
+    return fseeko(fp, st.st_size, SEEK_SET) == 0;
+}
+#else
+int app_map_read(BIO *in,
+                 int (*fn)(void *arg, const unsigned char *data, size_t len),
+                 void *arg)
+{
+    return -1;
+}
+#endif
+
 /* raw_read|write section */
 #if defined(__VMS)
 # include "vms_term_sock.h"
@@ -2794,3 +2846,33 @@ void make_uppercase(char *string)
     for (i = 0; string[i] != '\0'; i++)
         string[i] = toupper((unsigned char)string[i]);
 }
+
+/*
+ * Finds the ECDH hybrid of the OQS KEM |nid| and, if |curve| is not NULL,
+ * the curve it is combined with. Returns NID_undef if there is none.
+ */
+int oqs_kem_hybrid_nid(int nid, int *curve)
+{
+    static const struct {
+        const char *prefix;
+        int curve;
+    } hybrid_curves[] = {
+        {"p256_", NID_X9_62_prime256v1},
+        {"p384_", NID_secp384r1},
+        {"p521_", NID_secp521r1}
+    };
+    char sn[80];
+    size_t i;
+    int hybrid;
+
+    for (i = 0; i < OSSL_NELEM(hybrid_curves); i++) {
+        BIO_snprintf(sn, sizeof(sn), "%s%s", hybrid_curves[i].prefix,
+                     OBJ_nid2sn(nid));
+        if ((hybrid = OBJ_sn2nid(sn)) != NID_undef) {
+            if (curve != NULL)
+                *curve = hybrid_curves[i].curve;
+            return hybrid;
+        }
+    }
+    return NID_undef;
+}
@@ -617,12 +617,24 @@ int fileno_stdout(void);
 int raw_read_stdin(void *, int);
 int raw_write_stdout(const void *, int);
 
+/*
+ * Passes the rest of the regular file read by the file BIO |in| to |fn|, a
+ * large memory-mapped window at a time, and leaves |in| at end of file.
+ * Returns 1 on success and 0 if |fn| or a later window fails; -1 means that
+ * |in| cannot be mapped and has been left untouched.
+ */
+int app_map_read(BIO *in,
+                 int (*fn)(void *arg, const unsigned char *data, size_t len),
+                 void *arg);
+
 # define TM_START        0
 # define TM_STOP         1
 double app_tminterval(int stop, int usertime);
 
 void make_uppercase(char *string);
 
+int oqs_kem_hybrid_nid(int nid, int *curve);
+
 typedef struct verify_options_st {
     int depth;
     int quiet;
@@ -33,6 +33,11 @@
 
 #include "apps.h"
 #include "progs.h"
+#include "internal/o_dir.h"
+#if defined(OPENSSL_THREADS) && !defined(OPENSSL_SYS_WINDOWS)
+# include <pthread.h>
+# define CA_THREADS
+#endif
 
 #ifndef W_OK
 # define F_OK 0
@@ -131,10 +136,18 @@ static char *make_revocation_str(REVINFO_TYPE rev_type, const char *rev_arg);
 static int make_revoked(X509_REVOKED *rev, const char *str);
 static int old_entry_print(const ASN1_OBJECT *obj, const ASN1_STRING *str);
 static void write_new_certificate(BIO *bp, X509 *x, int output_der, int notext);
+static int ca_name_cmp(const char *const *a, const char *const *b);
+static void str_free(char *s);
+static int add_dir_files(STACK_OF(OPENSSL_STRING) *files, const char *dir);
+static int sign_certs(STACK_OF(X509) *certs, EVP_PKEY *pkey,
+                      const EVP_MD *dgst, STACK_OF(OPENSSL_STRING) *sigopts,
+                      int threads);
 
 static CONF *extconf = NULL;
 static int preserve = 0;
 static int msie_hack = 0;
+/* do_body() leaves the certificates to sign_certs() */
+static int sign_later = 0;
 
 typedef enum OPTION_choice {
     OPT_ERR = -1, OPT_EOF = 0, OPT_HELP,
@@ -146,7 +159,7 @@ typedef enum OPTION_choice {
     OPT_GENCRL, OPT_MSIE_HACK, OPT_CRLDAYS, OPT_CRLHOURS, OPT_CRLSEC,
     OPT_INFILES, OPT_SS_CERT, OPT_SPKAC, OPT_REVOKE, OPT_VALID,
     OPT_EXTENSIONS, OPT_EXTFILE, OPT_STATUS, OPT_UPDATEDB, OPT_CRLEXTS,
-    OPT_RAND_SERIAL,
+    OPT_RAND_SERIAL, OPT_INDIR, OPT_THREADS,
     OPT_R_ENUM,
     /* Do not change the order here; see related case statements below */
     OPT_CRL_REASON, OPT_CRL_HOLD, OPT_CRL_COMPROMISE, OPT_CRL_CA_COMPROMISE
@@ -193,6 +206,10 @@ const OPTIONS ca_options[] = {
     {"crlhours", OPT_CRLHOURS, 'p', "Hours until the next CRL is due"},
     {"crlsec", OPT_CRLSEC, 'p', "Seconds until the next CRL is due"},
     {"infiles", OPT_INFILES, '-', "The last argument, requests to process"},
+    {"indir", OPT_INDIR, '/', "Directory of requests to process"},
+#ifdef CA_THREADS
+    {"threads", OPT_THREADS, 'p', "Sign the certificates on that many threads"},
+#endif
     {"ss_cert", OPT_SS_CERT, '<', "File contains a self signed cert to sign"},
     {"spkac", OPT_SPKAC, '<',
      "File contains DN and signed public key and challenge"},
@@ -233,7 +250,7 @@ int ca_main(int argc, char **argv)
     CA_DB *db = NULL;
     DB_ATTR db_attr;
     STACK_OF(CONF_VALUE) *attribs = NULL;
-    STACK_OF(OPENSSL_STRING) *sigopts = NULL;
+    STACK_OF(OPENSSL_STRING) *sigopts = NULL, *dirfiles = NULL;
     STACK_OF(X509) *cert_sk = NULL;
     X509_CRL *crl = NULL;
     const EVP_MD *dgst = NULL;
@@ -243,7 +260,7 @@ int ca_main(int argc, char **argv)
     const char *infile = NULL, *spkac_file = NULL, *ss_cert_file = NULL;
     const char *extensions = NULL, *extfile = NULL, *passinarg = NULL;
     char *outdir = NULL, *outfile = NULL, *rev_arg = NULL, *ser_status = NULL;
-    const char *serialfile = NULL, *subj = NULL;
+    const char *serialfile = NULL, *subj = NULL, *indir = NULL;
     char *prog, *startdate = NULL, *enddate = NULL;
     char *dbfile = NULL, *f;
     char new_cert[PATH_MAX];
@@ -255,7 +272,7 @@ int ca_main(int argc, char **argv)
     int batch = 0, default_op = 1, doupdatedb = 0, ext_copy = EXT_COPY_NONE;
     int keyformat = FORMAT_PEM, multirdn = 0, notext = 0, output_der = 0;
     int ret = 1, email_dn = 1, req = 0, verbose = 0, gencrl = 0, dorevoke = 0;
-    int rand_ser = 0, i, j, selfsign = 0, def_nid, def_ret;
+    int rand_ser = 0, i, j, selfsign = 0, def_nid, def_ret, threads = 1;
     long crldays = 0, crlhours = 0, crlsec = 0, days = 0;
     unsigned long chtype = MBSTRING_ASC, certopt = 0;
     X509 *x509 = NULL, *x509p = NULL, *x = NULL;
@@ -384,6 +401,13 @@ opthelp:
         case OPT_INFILES:
             req = 1;
             goto end_of_options;
+        case OPT_INDIR:
+            req = 1;
+            indir = opt_arg();
+            break;
+        case OPT_THREADS:
+            threads = atoi(opt_arg());
+            break;
         case OPT_SS_CERT:
             ss_cert_file = opt_arg();
             req = 1;
@@ -928,9 +952,17 @@ end_of_options:
                 }
             }
         }
-        for (i = 0; i < argc; i++) {
+        dirfiles = sk_OPENSSL_STRING_new(ca_name_cmp);
+        if (dirfiles == NULL
+                || (indir != NULL && !add_dir_files(dirfiles, indir)))
+            goto end;
+        sign_later = threads > 1;
+        for (i = 0; i < argc + sk_OPENSSL_STRING_num(dirfiles); i++) {
+            const char *reqfile = i < argc ? argv[i]
+                : sk_OPENSSL_STRING_value(dirfiles, i - argc);
+
             total++;
-            j = certify(&x, argv[i], pkey, x509p, dgst, sigopts, attribs, db,
+            j = certify(&x, reqfile, pkey, x509p, dgst, sigopts, attribs, db,
                         serial, subj, chtype, multirdn, email_dn, startdate,
                         enddate, days, batch, extensions, conf, verbose,
                         certopt, get_nameopt(), default_op, ext_copy, selfsign);
@@ -950,6 +982,9 @@ end_of_options:
                 }
             }
         }
+        if (sign_later
+                && !sign_certs(cert_sk, pkey, dgst, sigopts, threads))
+            goto end;
         /*
          * we have a stack of newly certified certificates and a data base
          * and serial number that need updating
@@ -1245,6 +1280,7 @@ end_of_options:
     BN_free(crlnumber);
     free_index(db);
     sk_OPENSSL_STRING_free(sigopts);
+    sk_OPENSSL_STRING_pop_free(dirfiles, str_free);
     EVP_PKEY_free(pkey);
     X509_free(x509);
     X509_CRL_free(crl);
@@ -1853,7 +1889,7 @@ static int do_body(X509 **xret, EVP_PKEY *pkey, X509 *x509,
         !EVP_PKEY_missing_parameters(pkey))
         EVP_PKEY_copy_parameters(pktmp, pkey);
 
-    if (!do_X509_sign(ret, pkey, dgst, sigopts))
+    if (!sign_later && !do_X509_sign(ret, pkey, dgst, sigopts))
         goto end;
 
     /* We now just add it to the database as DB_TYPE_VAL('V') */
@@ -1910,6 +1946,133 @@ static void write_new_certificate(BIO *bp, X509 *x, int output_der, int notext)
     PEM_write_bio_X509(bp, x);
 }
 
+static int ca_name_cmp(const char *const *a, const char *const *b)
+{
+    return strcmp(*a, *b);
+}
+
+static void str_free(char *s)
+{
+    OPENSSL_free(s);
+}
+
+/*
+ * Adds the paths of the files in |dir| to |files|, which keeps them in name
+ * order, skipping hidden files and subdirectories.
+ */
+static int add_dir_files(STACK_OF(OPENSSL_STRING) *files, const char *dir)
+{
+    OPENSSL_DIR_CTX *d = NULL;
+    const char *name;
+    char *path;
+    size_t len;
+
+    while ((name = OPENSSL_DIR_read(&d, dir)) != NULL) {
+        if (name[0] == '.')
+            continue;
+        len = strlen(dir) + strlen(name) + 2;
+        path = app_malloc(len, "request file name");
+        BIO_snprintf(path, len, "%s/%s", dir, name);
+        if (app_isdir(path) != 0) {
+            OPENSSL_free(path);
+            continue;
+        }
+        if (!sk_OPENSSL_STRING_push(files, path)) {
+            OPENSSL_free(path);
+            OPENSSL_DIR_end(&d);
+            BIO_printf(bio_err, "Memory allocation failure\n");
+            return 0;
+        }
+    }
+    OPENSSL_DIR_end(&d);
+    sk_OPENSSL_STRING_sort(files);
+    return 1;
+}
+
+typedef struct ca_sign_st {
+    STACK_OF(X509) *certs;
+    EVP_PKEY *pkey;
+    const EVP_MD *dgst;
+    STACK_OF(OPENSSL_STRING) *sigopts;
+    int next, failed;
+#ifdef CA_THREADS
+    pthread_mutex_t lock;
+#endif
+} CA_SIGN;
+
+static void *sign_worker(void *arg)
+{
+    CA_SIGN *cs = arg;
+    int i;
+
+    for (;;) {
+#ifdef CA_THREADS
+        pthread_mutex_lock(&cs->lock);
+#endif
+        i = cs->failed || cs->next >= sk_X509_num(cs->certs) ? -1 : cs->next++;
+#ifdef CA_THREADS
+        pthread_mutex_unlock(&cs->lock);
+#endif
+        if (i < 0)
+            break;
+        if (!do_X509_sign(sk_X509_value(cs->certs, i), cs->pkey, cs->dgst,
+                          cs->sigopts)) {
+            BIO_printf(bio_err, "Error signing certificate\n");
+            ERR_print_errors(bio_err);
+#ifdef CA_THREADS
+            pthread_mutex_lock(&cs->lock);
+#endif
+            cs->failed = 1;
+#ifdef CA_THREADS
+            pthread_mutex_unlock(&cs->lock);
+#endif
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Signs the certificates that do_body() left unsigned, on up to |threads|
+ * threads counting the calling one. They are all in the database already,
+ * which is not written unless every one of them is signed.
+ */
+static int sign_certs(STACK_OF(X509) *certs, EVP_PKEY *pkey,
+                      const EVP_MD *dgst, STACK_OF(OPENSSL_STRING) *sigopts,
+                      int threads)
+{
+    CA_SIGN cs;
+#ifdef CA_THREADS
+    pthread_t *tids;
+    int i, started = 0;
+#endif
+
+    cs.certs = certs;
+    cs.pkey = pkey;
+    cs.dgst = dgst;
+    cs.sigopts = sigopts;
+    cs.next = 0;
+    cs.failed = 0;
+#ifdef CA_THREADS
+    if (threads > sk_X509_num(certs))
+        threads = sk_X509_num(certs);
+    if (threads < 1)
+        threads = 1;
+    tids = app_malloc(threads * sizeof(*tids), "signing threads");
+    pthread_mutex_init(&cs.lock, NULL);
+    for (i = 1; i < threads; i++)
+        if (pthread_create(&tids[started], NULL, sign_worker, &cs) == 0)
+            started++;
+    sign_worker(&cs);
+    for (i = 0; i < started; i++)
+        pthread_join(tids[i], NULL);
+    pthread_mutex_destroy(&cs.lock);
+    OPENSSL_free(tids);
+#else
+    sign_worker(&cs);
+#endif
+    return !cs.failed;
+}
+
 static int certify_spkac(X509 **xret, const char *infile, EVP_PKEY *pkey,
                          X509 *x509, const EVP_MD *dgst,
                          STACK_OF(OPENSSL_STRING) *sigopts,
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <stdio.h>
+#include "apps.h"
+#include "progs.h"
+#include <openssl/err.h>
+#include <openssl/x509.h>
+#include <openssl/x509_vfy.h>
+
+typedef enum OPTION_choice {
+    OPT_ERR = -1, OPT_EOF = 0, OPT_HELP, OPT_OUT
+} OPTION_CHOICE;
+
+const OPTIONS cabundle_options[] = {
+    {OPT_HELP_STR, 1, '-', "Usage: %s [options] file...\n"},
+    {OPT_HELP_STR, 1, '-', "Valid options are:\n"},
+    {"help", OPT_HELP, '-', "Display this summary"},
+    {"out", OPT_OUT, '>', "Output file - default stdout"},
+    {NULL}
+};
+
+int cabundle_main(int argc, char **argv)
+{
+    BIO *out = NULL;
+    STACK_OF(X509) *certs = NULL, *file_certs = NULL;
+    char *outfile = NULL, *prog;
+    int i, ret = 1;
+    OPTION_CHOICE o;
+
+    prog = opt_init(argc, argv, cabundle_options);
+    while ((o = opt_next()) != OPT_EOF) {
+        switch (o) {
+        case OPT_EOF:
+        case OPT_ERR:
+ opthelp:
+            BIO_printf(bio_err, "%s: Use -help for summary.\n", prog);
+            goto end;
+        case OPT_HELP:
+            opt_help(cabundle_options);
+            ret = 0;
+            goto end;
+        case OPT_OUT:
+            outfile = opt_arg();
+            break;
+        }
+    }
+    argc = opt_num_rest();
+    argv = opt_rest();
+    if (argc == 0)
+        goto opthelp;
+
+    if ((certs = sk_X509_new_null()) == NULL)
+        goto end;
+    for (i = 0; i < argc; i++) {
+        if (!load_certs(argv[i], &file_certs, FORMAT_PEM, NULL,
+                        "certificates"))
+            goto end;
+        while (sk_X509_num(file_certs) > 0) {
+            X509 *x = sk_X509_shift(file_certs);
+
+            if (!sk_X509_push(certs, x)) {
+                X509_free(x);
+                goto end;
+            }
+        }
+        sk_X509_free(file_certs);
+        file_certs = NULL;
+    }
+
+    out = bio_open_default(outfile, 'w', FORMAT_ASN1);
+    if (out == NULL)
+        goto end;
+    if (!X509_write_bundle_bio(out, certs)) {
+        BIO_printf(bio_err, "%s: Error writing bundle\n", prog);
+        ERR_print_errors(bio_err);
+        goto end;
+    }
+    ret = 0;
+
+ end:
+    sk_X509_pop_free(file_certs, X509_free);
+    sk_X509_pop_free(certs, X509_free);
+    BIO_free_all(out);
+    return ret;
+}
@@ -20,6 +20,10 @@
 #include <openssl/pem.h>
 #include <openssl/hmac.h>
 #include <ctype.h>
+#if defined(OPENSSL_THREADS) && !defined(OPENSSL_SYS_WINDOWS)
+# include <pthread.h>
+# define DGST_THREADS
+#endif
 
 #undef BUFSIZE
 #define BUFSIZE 1024*8
@@ -29,6 +33,14 @@ int do_fp(BIO *out, unsigned char *buf, BIO *bp, int sep, int binout,
           const char *sig_name, const char *md_name,
           const char *file);
 static void show_digests(const OBJ_NAME *name, void *bio_);
+static int map_fp(BIO *bmd, BIO *in, const char *file);
+#ifdef DGST_THREADS
+typedef struct dgst_job_st DGST_JOB;
+static DGST_JOB *map_files(BIO *bmd, char **files, int num, int threads);
+static int map_job(DGST_JOB *jobs, int i, BIO *bmd, BIO *in,
+                   const char *file);
+static void free_jobs(DGST_JOB *jobs, int num);
+#endif
 
 struct doall_dgst_digests {
     BIO *bio;
@@ -41,7 +53,7 @@ typedef enum OPTION_choice {
     OPT_PRVERIFY, OPT_SIGNATURE, OPT_KEYFORM, OPT_ENGINE, OPT_ENGINE_IMPL,
     OPT_HEX, OPT_BINARY, OPT_DEBUG, OPT_FIPS_FINGERPRINT,
     OPT_HMAC, OPT_MAC, OPT_SIGOPT, OPT_MACOPT,
-    OPT_DIGEST,
+    OPT_DIGEST, OPT_THREADS,
     OPT_R_ENUM
 } OPTION_CHOICE;
 
@@ -73,6 +85,10 @@ const OPTIONS dgst_options[] = {
     {"sigopt", OPT_SIGOPT, 's', "Signature parameter in n:v form"},
     {"macopt", OPT_MACOPT, 's', "MAC algorithm parameters in n:v form or key"},
     {"", OPT_DIGEST, '-', "Any supported digest"},
+#ifdef DGST_THREADS
+    {"threads", OPT_THREADS, 'p',
+     "Digest up to that many of the given files at once"},
+#endif
     OPT_R_OPTIONS,
 #ifndef OPENSSL_NO_ENGINE
     {"engine", OPT_ENGINE, 's', "Use engine e, possibly a hardware device"},
@@ -98,8 +114,11 @@ int dgst_main(int argc, char **argv)
     int separator = 0, debug = 0, keyform = FORMAT_PEM, siglen = 0;
     int i, ret = 1, out_bin = -1, want_pub = 0, do_verify = 0;
     unsigned char *buf = NULL, *sigbuf = NULL;
-    int engine_impl = 0;
+    int engine_impl = 0, threads = 1;
     struct doall_dgst_digests dec;
+#ifdef DGST_THREADS
+    DGST_JOB *jobs = NULL;
+#endif
 
     prog = opt_progname(argv[0]);
     buf = app_malloc(BUFSIZE, "I/O buffer");
@@ -201,6 +220,9 @@ int dgst_main(int argc, char **argv)
                 goto opthelp;
             md = m;
             break;
+        case OPT_THREADS:
+            threads = atoi(opt_arg());
+            break;
         }
     }
     argc = opt_num_rest();
@@ -386,6 +408,8 @@ int dgst_main(int argc, char **argv)
 
     if (argc == 0) {
         BIO_set_fp(in, stdin, BIO_NOCLOSE);
+        if (!debug && map_fp(bmd, in, "stdin") == 0)
+            goto end;
         ret = do_fp(out, buf, inp, separator, out_bin, sigkey, sigbuf,
                     siglen, NULL, NULL, "stdin");
     } else {
@@ -402,22 +426,38 @@ int dgst_main(int argc, char **argv)
                 md_name = EVP_MD_name(md);
         }
         ret = 0;
+#ifdef DGST_THREADS
+        if (threads > 1 && argc > 1 && !debug)
+            jobs = map_files(bmd, argv, argc, threads);
+#endif
         for (i = 0; i < argc; i++) {
             int r;
             if (BIO_read_filename(in, argv[i]) <= 0) {
                 perror(argv[i]);
                 ret++;
                 continue;
-            } else {
+            }
+            r = -1;
+#ifdef DGST_THREADS
+            if (jobs != NULL)
+                r = map_job(jobs, i, bmd, in, argv[i]);
+#endif
+            if (r < 0 && !debug)
+                r = map_fp(bmd, in, argv[i]);
+            if (r != 0)
                 r = do_fp(out, buf, inp, separator, out_bin, sigkey, sigbuf,
                           siglen, sig_name, md_name, argv[i]);
-            }
+            else
+                r = 1;
             if (r)
                 ret = r;
             (void)BIO_reset(bmd);
         }
     }
  end:
+#ifdef DGST_THREADS
+    free_jobs(jobs, argc);
+#endif
     OPENSSL_clear_free(buf, BUFSIZE);
     BIO_free(in);
     OPENSSL_free(passin);
@@ -457,6 +497,137 @@ static void show_digests(const OBJ_NAME *name, void *arg)
     }
 }
 
+static int md_update(void *ctx, const unsigned char *data, size_t len)
+{
+    return EVP_DigestUpdate(ctx, data, len);
+}
+
+/*
+ * Digests a regular file straight into the context of |bmd| rather than
+ * through BIO_read() on |bmd|, leaving |in| at end of file for do_fp().
+ * Returns -1 if |in| is left for do_fp() to read after all.
+ */
+static int map_fp(BIO *bmd, BIO *in, const char *file)
+{
+    EVP_MD_CTX *ctx;
+    int ret;
+
+    BIO_get_md_ctx(bmd, &ctx);
+    if ((ret = app_map_read(in, md_update, ctx)) == 0) {
+        BIO_printf(bio_err, "Read Error in %s\n", file);
+        ERR_print_errors(bio_err);
+    }
+    return ret;
+}
+
+#ifdef DGST_THREADS
+struct dgst_job_st {
+    const char *file;
+    EVP_MD_CTX *ctx;
+    int status;                 /* as returned by app_map_read() */
+};
+
+typedef struct dgst_queue_st {
+    DGST_JOB *jobs;
+    int num, next;
+    pthread_mutex_t lock;
+} DGST_QUEUE;
+
+static void *map_worker(void *arg)
+{
+    DGST_QUEUE *q = arg;
+    DGST_JOB *job;
+    BIO *in;
+
+    for (;;) {
+        pthread_mutex_lock(&q->lock);
+        job = q->next < q->num ? &q->jobs[q->next++] : NULL;
+        pthread_mutex_unlock(&q->lock);
+        if (job == NULL)
+            break;
+        if (job->ctx != NULL && (in = BIO_new_file(job->file, "rb")) != NULL) {
+            job->status = app_map_read(in, md_update, job->ctx);
+            BIO_free(in);
+        }
+    }
+    /* Whatever went wrong is reported again when the main thread gets there */
+    ERR_clear_error();
+    return NULL;
+}
+
+/*
+ * Digests the files on up to |threads| threads, each into a copy of the
+ * freshly initialised context of |bmd|; map_job() later hands the result of
+ * one to the main loop.
+ */
+static DGST_JOB *map_files(BIO *bmd, char **files, int num, int threads)
+{
+    DGST_QUEUE q;
+    pthread_t *tids;
+    EVP_MD_CTX *ctx;
+    int i, started = 0;
+
+    BIO_get_md_ctx(bmd, &ctx);
+    q.jobs = app_malloc(num * sizeof(*q.jobs), "digest jobs");
+    for (i = 0; i < num; i++) {
+        q.jobs[i].file = files[i];
+        q.jobs[i].status = -1;
+        if ((q.jobs[i].ctx = EVP_MD_CTX_new()) != NULL
+                && !EVP_MD_CTX_copy_ex(q.jobs[i].ctx, ctx)) {
+            EVP_MD_CTX_free(q.jobs[i].ctx);
+            q.jobs[i].ctx = NULL;
+        }
+    }
+    ERR_clear_error();
+    q.num = num;
+    q.next = 0;
+    if (threads > num)
+        threads = num;
+    tids = app_malloc(threads * sizeof(*tids), "digest threads");
+    pthread_mutex_init(&q.lock, NULL);
+    for (i = 0; i < threads; i++)
+        if (pthread_create(&tids[started], NULL, map_worker, &q) == 0)
+            started++;
+    if (started == 0)
+        map_worker(&q);
+    for (i = 0; i < started; i++)
+        pthread_join(tids[i], NULL);
+    pthread_mutex_destroy(&q.lock);
+    OPENSSL_free(tids);
+    return q.jobs;
+}
+
+static int map_job(DGST_JOB *jobs, int i, BIO *bmd, BIO *in,
+                   const char *file)
+{
+    EVP_MD_CTX *ctx;
+    FILE *fp = NULL;
+
+    if (jobs[i].status < 0)
+        return -1;
+    BIO_get_md_ctx(bmd, &ctx);
+    if (jobs[i].status == 0 || BIO_get_fp(in, &fp) <= 0
+            || fseek(fp, 0, SEEK_END) != 0
+            || !EVP_MD_CTX_copy_ex(ctx, jobs[i].ctx)) {
+        BIO_printf(bio_err, "Read Error in %s\n", file);
+        ERR_print_errors(bio_err);
+        return 0;
+    }
+    return 1;
+}
+
+static void free_jobs(DGST_JOB *jobs, int num)
+{
+    int i;
+
+    if (jobs == NULL)
+        return;
+    for (i = 0; i < num; i++)
+        EVP_MD_CTX_free(jobs[i].ctx);
+    OPENSSL_free(jobs);
+}
+#endif
+
 /*
  * The newline_escape_filename function performs newline escaping for any
  * filename that contains a newline.  This function also takes a pointer
@@ -29,9 +29,12 @@
 #undef BSIZE
 #define SIZE    (512)
 #define BSIZE   (8*1024)
+#define MSIZE   (1024*1024)
 
 static int set_hex(const char *in, unsigned char *out, int size);
 static void show_ciphers(const OBJ_NAME *name, void *bio_);
+static int map_cipher(BIO *in, BIO *out, EVP_CIPHER_CTX *ctx,
+                      uint64_t *nread);
 
 struct doall_enc_ciphers {
     BIO *bio;
@@ -107,12 +110,13 @@ int enc_main(int argc, char **argv)
     int bsize = BSIZE, verbose = 0, debug = 0, olb64 = 0, nosalt = 0;
     int enc = 1, printkey = 0, i, k;
     int base64 = 0, informat = FORMAT_BINARY, outformat = FORMAT_BINARY;
-    int ret = 1, inl, nopad = 0;
+    int ret = 1, inl, nopad = 0, mapped = -1;
     unsigned char key[EVP_MAX_KEY_LENGTH], iv[EVP_MAX_IV_LENGTH];
     unsigned char *buff = NULL, salt[PKCS5_SALT_LEN];
     int pbkdf2 = 0;
     int iter = 0;
     long n;
+    uint64_t nmapped = 0;
     struct doall_enc_ciphers dec;
 #ifdef ZLIB
     int do_zlib = 0;
@@ -583,27 +587,36 @@ int enc_main(int argc, char **argv)
         }
     }
 
-    /* Only encrypt/decrypt as we write the file */
-    if (benc != NULL)
-        wbio = BIO_push(benc, wbio);
+    /* A regular input file can bypass the BIO chain on the cipher side */
+    if (benc != NULL && rbio == in && !debug)
+        mapped = map_cipher(in, wbio, ctx, &nmapped);
+    if (mapped == 0)
+        goto end;
 
-    while (BIO_pending(rbio) || !BIO_eof(rbio)) {
-        inl = BIO_read(rbio, (char *)buff, bsize);
-        if (inl <= 0)
-            break;
-        if (BIO_write(wbio, (char *)buff, inl) != inl) {
-            BIO_printf(bio_err, "error writing output file\n");
+    if (mapped < 0) {
+        /* Only encrypt/decrypt as we write the file */
+        if (benc != NULL)
+            wbio = BIO_push(benc, wbio);
+
+        while (BIO_pending(rbio) || !BIO_eof(rbio)) {
+            inl = BIO_read(rbio, (char *)buff, bsize);
+            if (inl <= 0)
+                break;
+            if (BIO_write(wbio, (char *)buff, inl) != inl) {
+                BIO_printf(bio_err, "error writing output file\n");
+                goto end;
+            }
+        }
+        if (!BIO_flush(wbio)) {
+            BIO_printf(bio_err, "bad decrypt\n");
             goto end;
         }
     }
-    if (!BIO_flush(wbio)) {
-        BIO_printf(bio_err, "bad decrypt\n");
-        goto end;
-    }
 
     ret = 0;
     if (verbose) {
-        BIO_printf(bio_err, "bytes read   : %8ju\n", BIO_number_read(in));
+        BIO_printf(bio_err, "bytes read   : %8ju\n",
+                   BIO_number_read(in) + nmapped);
         BIO_printf(bio_err, "bytes written: %8ju\n", BIO_number_written(out));
     }
  end:
@@ -674,3 +687,60 @@ static int set_hex(const char *in, unsigned char *out, int size)
     }
     return 1;
 }
+
+struct map_cipher_st {
+    EVP_CIPHER_CTX *ctx;
+    BIO *out;
+    unsigned char *buf;
+    uint64_t nread;
+};
+
+static int cipher_update(void *arg, const unsigned char *data, size_t len)
+{
+    struct map_cipher_st *mc = arg;
+    int inl, outl;
+
+    for (; len > 0; data += inl, len -= inl) {
+        inl = len < MSIZE ? (int)len : MSIZE;
+        if (!EVP_CipherUpdate(mc->ctx, mc->buf, &outl, data, inl)) {
+            BIO_printf(bio_err, "bad decrypt\n");
+            return 0;
+        }
+        if (BIO_write(mc->out, mc->buf, outl) != outl) {
+            BIO_printf(bio_err, "error writing output file\n");
+            return 0;
+        }
+        mc->nread += inl;
+    }
+    return 1;
+}
+
+/*
+ * Runs the cipher of |ctx| over a regular input file mapped into memory a
+ * megabyte at a time, instead of in BIO_f_cipher() sized pieces, writing
+ * straight to |out|. Returns -1 if |in| is left for the BIO chain to read.
+ */
+static int map_cipher(BIO *in, BIO *out, EVP_CIPHER_CTX *ctx,
+                      uint64_t *nread)
+{
+    struct map_cipher_st mc;
+    int outl, ret;
+
+    mc.ctx = ctx;
+    mc.out = out;
+    mc.buf = app_malloc(MSIZE + EVP_MAX_BLOCK_LENGTH, "cipher buffer");
+    mc.nread = 0;
+    ret = app_map_read(in, cipher_update, &mc);
+    if (ret > 0) {
+        if (!EVP_CipherFinal_ex(ctx, mc.buf, &outl)) {
+            BIO_printf(bio_err, "bad decrypt\n");
+            ret = 0;
+        } else if (BIO_write(out, mc.buf, outl) != outl || !BIO_flush(out)) {
+            BIO_printf(bio_err, "error writing output file\n");
+            ret = 0;
+        }
+    }
+    *nread = mc.nread;
+    OPENSSL_clear_free(mc.buf, MSIZE + EVP_MAX_BLOCK_LENGTH);
+    return ret;
+}
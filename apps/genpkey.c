@@ -17,14 +17,38 @@
 #ifndef OPENSSL_NO_ENGINE
 # include <openssl/engine.h>
 #endif
+#if defined(OPENSSL_THREADS) && !defined(OPENSSL_SYS_WINDOWS)
+# include <pthread.h>
+# define GENPKEY_THREADS
+#endif
+
+#ifndef PATH_MAX
+# define PATH_MAX 4096
+#endif
+
+/* What to generate and how to write it, shared by every key of a batch */
+typedef struct genpkey_batch_st {
+    EVP_PKEY_CTX *ctx;
+    const EVP_CIPHER *cipher;
+    char *pass;
+    const char *outdir;
+    int outformat, text, do_param;
+    int count, next, failed;
+#ifdef GENPKEY_THREADS
+    pthread_mutex_t lock;
+#endif
+} GENPKEY_BATCH;
 
 static int init_keygen_file(EVP_PKEY_CTX **pctx, const char *file, ENGINE *e);
 static int genpkey_cb(EVP_PKEY_CTX *ctx);
+static int gen_write(GENPKEY_BATCH *b, EVP_PKEY_CTX *ctx, BIO *out);
+static int gen_batch(GENPKEY_BATCH *b, int threads);
 
 typedef enum OPTION_choice {
     OPT_ERR = -1, OPT_EOF = 0, OPT_HELP,
     OPT_ENGINE, OPT_OUTFORM, OPT_OUT, OPT_PASS, OPT_PARAMFILE,
-    OPT_ALGORITHM, OPT_PKEYOPT, OPT_GENPARAM, OPT_TEXT, OPT_CIPHER
+    OPT_ALGORITHM, OPT_PKEYOPT, OPT_GENPARAM, OPT_TEXT, OPT_CIPHER,
+    OPT_COUNT, OPT_OUTDIR, OPT_THREADS
 } OPTION_CHOICE;
 
 const OPTIONS genpkey_options[] = {
@@ -38,6 +62,12 @@ const OPTIONS genpkey_options[] = {
      "Set the public key algorithm option as opt:value"},
     {"genparam", OPT_GENPARAM, '-', "Generate parameters, not key"},
     {"text", OPT_TEXT, '-', "Print the in text"},
+    {"count", OPT_COUNT, 'p', "Number of keys to generate into -outdir"},
+    {"outdir", OPT_OUTDIR, '/', "Directory to write the generated keys to"},
+#ifdef GENPKEY_THREADS
+    {"threads", OPT_THREADS, 'p',
+     "Generate the keys for -outdir on that many threads"},
+#endif
     {"", OPT_CIPHER, '-', "Cipher to use to encrypt the key"},
 #ifndef OPENSSL_NO_ENGINE
     {"engine", OPT_ENGINE, 's', "Use engine, possibly a hardware device"},
@@ -52,13 +82,14 @@ int genpkey_main(int argc, char **argv)
 {
     BIO *in = NULL, *out = NULL;
     ENGINE *e = NULL;
-    EVP_PKEY *pkey = NULL;
     EVP_PKEY_CTX *ctx = NULL;
     char *outfile = NULL, *passarg = NULL, *pass = NULL, *prog;
+    const char *outdir = NULL;
     const EVP_CIPHER *cipher = NULL;
     OPTION_CHOICE o;
-    int outformat = FORMAT_PEM, text = 0, ret = 1, rv, do_param = 0;
-    int private = 0;
+    GENPKEY_BATCH batch;
+    int outformat = FORMAT_PEM, text = 0, ret = 1, do_param = 0;
+    int private = 0, count = 1, threads = 1;
 
     prog = opt_init(argc, argv, genpkey_options);
     while ((o = opt_next()) != OPT_EOF) {
@@ -116,6 +147,15 @@ int genpkey_main(int argc, char **argv)
         case OPT_TEXT:
             text = 1;
             break;
+        case OPT_COUNT:
+            count = atoi(opt_arg());
+            break;
+        case OPT_OUTDIR:
+            outdir = opt_arg();
+            break;
+        case OPT_THREADS:
+            threads = atoi(opt_arg());
+            break;
         case OPT_CIPHER:
             if (!opt_cipher(opt_unknown(), &cipher)
                 || do_param == 1)
@@ -143,6 +183,32 @@ int genpkey_main(int argc, char **argv)
         goto end;
     }
 
+    memset(&batch, 0, sizeof(batch));
+    batch.ctx = ctx;
+    batch.cipher = cipher;
+    batch.pass = pass;
+    batch.outdir = outdir;
+    batch.outformat = outformat;
+    batch.text = text;
+    batch.do_param = do_param;
+    batch.count = count;
+
+    if (outdir != NULL) {
+        if (outfile != NULL) {
+            BIO_printf(bio_err, "%s: Cannot use both -out and -outdir\n",
+                       prog);
+            goto end;
+        }
+        if (!gen_batch(&batch, threads))
+            goto end;
+        ret = 0;
+        goto end;
+    }
+    if (count != 1) {
+        BIO_printf(bio_err, "%s: -count requires -outdir\n", prog);
+        goto end;
+    }
+
     out = bio_open_owner(outfile, outformat, private);
     if (out == NULL)
         goto end;
@@ -150,7 +216,28 @@ int genpkey_main(int argc, char **argv)
     EVP_PKEY_CTX_set_cb(ctx, genpkey_cb);
     EVP_PKEY_CTX_set_app_data(ctx, bio_err);
 
-    if (do_param) {
+    if (gen_write(&batch, ctx, out))
+        ret = 0;
+
+ end:
+    EVP_PKEY_CTX_free(ctx);
+    BIO_free_all(out);
+    BIO_free(in);
+    release_engine(e);
+    OPENSSL_free(pass);
+    return ret;
+}
+
+/*
+ * Generates one key, or set of parameters, with |ctx| and writes it to |out|
+ * as |b| says. Returns 0 after reporting an error.
+ */
+static int gen_write(GENPKEY_BATCH *b, EVP_PKEY_CTX *ctx, BIO *out)
+{
+    EVP_PKEY *pkey = NULL;
+    int rv, ret = 0;
+
+    if (b->do_param) {
         if (EVP_PKEY_paramgen(ctx, &pkey) <= 0) {
             BIO_puts(bio_err, "Error generating parameters\n");
             ERR_print_errors(bio_err);
@@ -164,29 +251,28 @@ int genpkey_main(int argc, char **argv)
         }
     }
 
-    if (do_param) {
+    if (b->do_param) {
         rv = PEM_write_bio_Parameters(out, pkey);
-    } else if (outformat == FORMAT_PEM) {
-        assert(private);
-        rv = PEM_write_bio_PrivateKey(out, pkey, cipher, NULL, 0, NULL, pass);
-    } else if (outformat == FORMAT_ASN1) {
-        assert(private);
+    } else if (b->outformat == FORMAT_PEM) {
+        rv = PEM_write_bio_PrivateKey(out, pkey, b->cipher, NULL, 0, NULL,
+                                      b->pass);
+    } else if (b->outformat == FORMAT_ASN1) {
         rv = i2d_PrivateKey_bio(out, pkey);
     } else {
         BIO_printf(bio_err, "Bad format specified for key\n");
         goto end;
     }
 
-    ret = 0;
+    ret = 1;
 
     if (rv <= 0) {
         BIO_puts(bio_err, "Error writing key\n");
         ERR_print_errors(bio_err);
-        ret = 1;
+        ret = 0;
     }
 
-    if (text) {
-        if (do_param)
+    if (b->text) {
+        if (b->do_param)
             rv = EVP_PKEY_print_params(out, pkey, 0, NULL);
         else
             rv = EVP_PKEY_print_private(out, pkey, 0, NULL);
@@ -194,20 +280,109 @@ int genpkey_main(int argc, char **argv)
         if (rv <= 0) {
             BIO_puts(bio_err, "Error printing key\n");
             ERR_print_errors(bio_err);
-            ret = 1;
+            ret = 0;
         }
     }
 
  end:
     EVP_PKEY_free(pkey);
-    EVP_PKEY_CTX_free(ctx);
-    BIO_free_all(out);
-    BIO_free(in);
-    release_engine(e);
-    OPENSSL_free(pass);
     return ret;
 }
 
+static void batch_fail(GENPKEY_BATCH *b)
+{
+#ifdef GENPKEY_THREADS
+    pthread_mutex_lock(&b->lock);
+    b->failed = 1;
+    pthread_mutex_unlock(&b->lock);
+#else
+    b->failed = 1;
+#endif
+}
+
+/* Returns the number of the next key of the batch to generate, or 0 */
+static int batch_next(GENPKEY_BATCH *b)
+{
+    int n;
+
+#ifdef GENPKEY_THREADS
+    pthread_mutex_lock(&b->lock);
+#endif
+    n = b->failed || b->next >= b->count ? 0 : ++b->next;
+#ifdef GENPKEY_THREADS
+    pthread_mutex_unlock(&b->lock);
+#endif
+    return n;
+}
+
+/*
+ * Takes the keys of a batch one at a time, numbered from 1, and writes each
+ * to its own file in the output directory.
+ */
+static void gen_keys(GENPKEY_BATCH *b, EVP_PKEY_CTX *ctx)
+{
+    BIO *out;
+    char path[PATH_MAX];
+    int n;
+
+    while ((n = batch_next(b)) != 0) {
+        BIO_snprintf(path, sizeof(path), "%s/%d.%s", b->outdir, n,
+                     b->outformat == FORMAT_ASN1 ? "der" : "pem");
+        out = bio_open_owner(path, b->outformat, !b->do_param);
+        if (out == NULL || !gen_write(b, ctx, out))
+            batch_fail(b);
+        BIO_free_all(out);
+    }
+}
+
+#ifdef GENPKEY_THREADS
+static void *gen_worker(void *arg)
+{
+    GENPKEY_BATCH *b = arg;
+    EVP_PKEY_CTX *ctx;
+
+    if ((ctx = EVP_PKEY_CTX_dup(b->ctx)) == NULL) {
+        BIO_puts(bio_err, "Error copying key generation context\n");
+        ERR_print_errors(bio_err);
+        batch_fail(b);
+        return NULL;
+    }
+    EVP_PKEY_CTX_set_cb(ctx, NULL);
+    gen_keys(b, ctx);
+    EVP_PKEY_CTX_free(ctx);
+    return NULL;
+}
+#endif
+
+/*
+ * Generates the |b->count| keys of a batch in the one process, so that the
+ * library and configuration are only loaded once, on up to |threads|
+ * threads counting the calling one.
+ */
+static int gen_batch(GENPKEY_BATCH *b, int threads)
+{
+#ifdef GENPKEY_THREADS
+    pthread_t *tids;
+    int i, started = 0;
+
+    if (threads > b->count)
+        threads = b->count;
+    tids = app_malloc(threads * sizeof(*tids), "key generation threads");
+    pthread_mutex_init(&b->lock, NULL);
+    for (i = 1; i < threads; i++)
+        if (pthread_create(&tids[started], NULL, gen_worker, b) == 0)
+            started++;
+    gen_keys(b, b->ctx);
+    for (i = 0; i < started; i++)
+        pthread_join(tids[i], NULL);
+    pthread_mutex_destroy(&b->lock);
+    OPENSSL_free(tids);
+#else
+    gen_keys(b, b->ctx);
+#endif
+    return !b->failed;
+}
+
 static int init_keygen_file(EVP_PKEY_CTX **pctx, const char *file, ENGINE *e)
 {
     BIO *pbio;
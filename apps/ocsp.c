@@ -99,6 +99,29 @@ static void make_ocsp_response(BIO *err, OCSP_RESPONSE **resp, OCSP_REQUEST *req
                               int nmin, int ndays, int badsig);
 
 static char **lookup_serial(CA_DB *db, ASN1_INTEGER *ser);
+
+/*
+ * A signed response to a request for the status of one certificate without
+ * a nonce, which can be sent again to anyone asking the same until it expires
+ */
+typedef struct resp_cache_ent_st {
+    unsigned char *id;          /* DER of the OCSP_CERTID asked about */
+    int idlen;
+    unsigned char *der;         /* DER of the OCSP_RESPONSE */
+    int derlen;
+    time_t expires;
+} RESP_CACHE_ENT;
+
+DEFINE_LHASH_OF(RESP_CACHE_ENT);
+
+static unsigned char *resp_cache_key(OCSP_REQUEST *req, int *len);
+static OCSP_RESPONSE *resp_cache_get(LHASH_OF(RESP_CACHE_ENT) *cache,
+                                     const unsigned char *id, int idlen);
+static void resp_cache_put(LHASH_OF(RESP_CACHE_ENT) *cache,
+                           const unsigned char *id, int idlen,
+                           OCSP_RESPONSE *resp, long lifetime);
+static LHASH_OF(RESP_CACHE_ENT) *resp_cache_new(void);
+static void resp_cache_free(LHASH_OF(RESP_CACHE_ENT) *cache);
 static BIO *init_responder(const char *port);
 static int do_responder(OCSP_REQUEST **preq, BIO **pcbio, BIO *acbio, int timeout);
 static int send_ocsp_response(BIO *cbio, OCSP_RESPONSE *resp);
@@ -137,7 +160,7 @@ typedef enum OPTION_choice {
     OPT_RKEY, OPT_ROTHER, OPT_RMD, OPT_RSIGOPT, OPT_HEADER,
     OPT_V_ENUM,
     OPT_MD,
-    OPT_MULTI
+    OPT_MULTI, OPT_RESP_CACHE
 } OPTION_CHOICE;
 
 const OPTIONS ocsp_options[] = {
@@ -210,6 +233,8 @@ const OPTIONS ocsp_options[] = {
     {"nrequest", OPT_REQUEST, 'p',
      "Number of requests to accept (default unlimited)"},
     {"ndays", OPT_NDAYS, 'p', "Number of days before next update"},
+    {"resp_cache", OPT_RESP_CACHE, '-',
+     "Reuse signed responses to requests without a nonce until halfway to the next update"},
     {"rsigner", OPT_RSIGNER, '<',
      "Responder certificate to sign responses with"},
     {"rkey", OPT_RKEY, '<', "Responder key to sign responses with"},
@@ -229,6 +254,10 @@ int ocsp_main(int argc, char **argv)
     STACK_OF(OPENSSL_STRING) *rsign_sigopts = NULL;
     int trailing_md = 0;
     CA_DB *rdb = NULL;
+    LHASH_OF(RESP_CACHE_ENT) *rcache = NULL;
+    unsigned char *cache_id = NULL;
+    int resp_cache = 0, cache_idlen = 0;
+    long cache_life = 0;
     EVP_PKEY *key = NULL, *rkey = NULL;
     OCSP_BASICRESP *bs = NULL;
     OCSP_REQUEST *req = NULL;
@@ -512,6 +541,9 @@ int ocsp_main(int argc, char **argv)
             multi = atoi(opt_arg());
 #endif
             break;
+        case OPT_RESP_CACHE:
+            resp_cache = 1;
+            break;
         }
     }
     if (trailing_md) {
@@ -590,6 +622,16 @@ int ocsp_main(int argc, char **argv)
         }
     }
 
+    if (resp_cache && acbio != NULL && rdb != NULL) {
+        if (ndays == -1) {
+            BIO_printf(bio_err, "-resp_cache requires -nmin or -ndays\n");
+            goto end;
+        }
+        cache_life = ((long)ndays * 24 * 60 + nmin) * 60 / 2;
+        if ((rcache = resp_cache_new()) == NULL)
+            goto end;
+    }
+
 #ifdef OCSP_DAEMON
     if (multi && acbio != NULL)
         spawn_loop();
@@ -610,6 +652,12 @@ redo_accept:
             if (newrdb != NULL && index_index(newrdb) > 0) {
                 free_index(rdb);
                 rdb = newrdb;
+                /* Statuses may have changed, so start the cache afresh */
+                if (rcache != NULL) {
+                    resp_cache_free(rcache);
+                    if ((rcache = resp_cache_new()) == NULL)
+                        goto end;
+                }
             } else {
                 free_index(newrdb);
                 log_message(LOG_ERR, "error reloading updated index: %s",
@@ -629,6 +677,8 @@ redo_accept:
             send_ocsp_response(cbio, resp);
             goto done_resp;
         }
+        if (rcache != NULL)
+            cache_id = resp_cache_key(req, &cache_idlen);
     }
 
     if (req == NULL
@@ -638,7 +688,7 @@ redo_accept:
         goto end;
     }
 
-    if (req != NULL && add_nonce) {
+    if (req != NULL && add_nonce && cache_id == NULL) {
         if (!OCSP_request_add1_nonce(req, NULL, -1))
             goto end;
     }
@@ -680,8 +730,16 @@ redo_accept:
     }
 
     if (rdb != NULL) {
-        make_ocsp_response(bio_err, &resp, req, rdb, rca_cert, rsigner, rkey,
-                               rsign_md, rsign_sigopts, rother, rflags, nmin, ndays, badsig);
+        if (cache_id == NULL
+                || (resp = resp_cache_get(rcache, cache_id,
+                                          cache_idlen)) == NULL) {
+            make_ocsp_response(bio_err, &resp, req, rdb, rca_cert, rsigner,
+                               rkey, rsign_md, rsign_sigopts, rother, rflags,
+                               nmin, ndays, badsig);
+            if (cache_id != NULL)
+                resp_cache_put(rcache, cache_id, cache_idlen, resp,
+                               cache_life);
+        }
         if (cbio != NULL)
             send_ocsp_response(cbio, resp);
     } else if (host != NULL) {
@@ -744,6 +802,8 @@ redo_accept:
         req = NULL;
         OCSP_RESPONSE_free(resp);
         resp = NULL;
+        OPENSSL_free(cache_id);
+        cache_id = NULL;
         goto redo_accept;
     }
     if (ridx_filename != NULL) {
@@ -813,6 +873,8 @@ redo_accept:
     X509_free(rsigner);
     sk_X509_pop_free(rca_cert, X509_free);
     free_index(rdb);
+    resp_cache_free(rcache);
+    OPENSSL_free(cache_id);
     BIO_free_all(cbio);
     BIO_free_all(acbio);
     BIO_free_all(out);
@@ -1284,6 +1346,100 @@ static char **lookup_serial(CA_DB *db, ASN1_INTEGER *ser)
     return rrow;
 }
 
+static unsigned long resp_cache_hash(const RESP_CACHE_ENT *e)
+{
+    unsigned long h = 0;
+    int i;
+
+    for (i = 0; i < e->idlen; i++)
+        h = h * 31 + e->id[i];
+    return h;
+}
+
+static int resp_cache_cmp(const RESP_CACHE_ENT *a, const RESP_CACHE_ENT *b)
+{
+    if (a->idlen != b->idlen)
+        return a->idlen - b->idlen;
+    return memcmp(a->id, b->id, a->idlen);
+}
+
+static void resp_cache_ent_free(RESP_CACHE_ENT *e)
+{
+    OPENSSL_free(e->id);
+    OPENSSL_free(e->der);
+    OPENSSL_free(e);
+}
+
+static LHASH_OF(RESP_CACHE_ENT) *resp_cache_new(void)
+{
+    return lh_RESP_CACHE_ENT_new(resp_cache_hash, resp_cache_cmp);
+}
+
+static void resp_cache_free(LHASH_OF(RESP_CACHE_ENT) *cache)
+{
+    if (cache == NULL)
+        return;
+    lh_RESP_CACHE_ENT_doall(cache, resp_cache_ent_free);
+    lh_RESP_CACHE_ENT_free(cache);
+}
+
+/*
+ * Returns the DER of the certificate id in |req| if a response to it may be
+ * shared, that is if it asks about a single certificate without a nonce.
+ */
+static unsigned char *resp_cache_key(OCSP_REQUEST *req, int *len)
+{
+    unsigned char *id = NULL;
+
+    if (OCSP_request_onereq_count(req) != 1
+            || OCSP_REQUEST_get_ext_by_NID(req, NID_id_pkix_OCSP_Nonce, -1) >= 0)
+        return NULL;
+    *len = i2d_OCSP_CERTID(OCSP_onereq_get0_id(OCSP_request_onereq_get0(req, 0)),
+                           &id);
+    return *len > 0 ? id : NULL;
+}
+
+static OCSP_RESPONSE *resp_cache_get(LHASH_OF(RESP_CACHE_ENT) *cache,
+                                     const unsigned char *id, int idlen)
+{
+    RESP_CACHE_ENT tmp, *e;
+    const unsigned char *p;
+
+    tmp.id = (unsigned char *)id;
+    tmp.idlen = idlen;
+    e = lh_RESP_CACHE_ENT_retrieve(cache, &tmp);
+    if (e == NULL || e->expires <= time(NULL))
+        return NULL;
+    p = e->der;
+    return d2i_OCSP_RESPONSE(NULL, &p, e->derlen);
+}
+
+static void resp_cache_put(LHASH_OF(RESP_CACHE_ENT) *cache,
+                           const unsigned char *id, int idlen,
+                           OCSP_RESPONSE *resp, long lifetime)
+{
+    RESP_CACHE_ENT *e, *old;
+
+    if (resp == NULL
+            || OCSP_response_status(resp) != OCSP_RESPONSE_STATUS_SUCCESSFUL)
+        return;
+    e = app_malloc(sizeof(*e), "response cache entry");
+    e->idlen = idlen;
+    e->id = OPENSSL_memdup(id, idlen);
+    e->der = NULL;
+    e->derlen = i2d_OCSP_RESPONSE(resp, &e->der);
+    e->expires = time(NULL) + lifetime;
+    if (e->id == NULL || e->derlen <= 0) {
+        resp_cache_ent_free(e);
+        return;
+    }
+    old = lh_RESP_CACHE_ENT_insert(cache, e);
+    if (old != NULL)
+        resp_cache_ent_free(old);
+    else if (lh_RESP_CACHE_ENT_error(cache))
+        resp_cache_ent_free(e);
+}
+
 /* Quick and dirty OCSP server: read in and parse input request */
 
 static BIO *init_responder(const char *port)
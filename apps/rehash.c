@@ -41,6 +41,12 @@
 # include <openssl/evp.h>
 # include <openssl/pem.h>
 # include <openssl/x509.h>
+# include <openssl/x509_vfy.h>
+
+# if defined(OPENSSL_THREADS) && !defined(OPENSSL_SYS_WINDOWS)
+#  include <pthread.h>
+#  define REHASH_THREADS
+# endif
 
 
 # ifndef PATH_MAX
@@ -96,11 +102,50 @@ enum Hash {
     HASH_OLD, HASH_NEW, HASH_BOTH
 };
 
+enum Status {
+    FILE_OK, FILE_SKIP, FILE_NOT_ONE, FILE_NO_OPEN, FILE_NO_MEM, FILE_BAD,
+    FILE_PENDING
+};
+
+/*
+ * What is known about a file that may hold a certificate or CRL, from
+ * parsing it or from the manifest of an earlier run.
+ */
+typedef struct file_info_st {
+    char *filename;
+    unsigned long ino;
+    long size, mtime;
+    enum Status status;
+    enum Type type;
+    unsigned long hash, hash_old;
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    /* Only kept when writing a bundle */
+    X509 *x509;
+} FILE_INFO;
+
+DEFINE_LHASH_OF(FILE_INFO);
+
+typedef struct parse_job_st {
+    FILE_INFO *infos;
+    int num, next, buflen;
+    const char *dirname, *pathsep;
+    enum Hash h;
+# ifdef REHASH_THREADS
+    pthread_mutex_t lock;
+# endif
+} PARSE_JOB;
+
+# define MANIFEST_NAME   ".rehash.manifest"
+# define MANIFEST_MAGIC  "# rehash manifest 1"
+# define TMP_NAME        ".rehash.tmp"
 
 static int evpmdsize;
 static const EVP_MD *evpmd;
 static int remove_links = 1;
 static int verbose = 0;
+static int incremental = 0;
+static int threads = 1;
+static const char *bundle = NULL;
 static BUCKET *hash_table[257];
 
 static const char *suffixes[] = { "", "r" };
@@ -227,82 +272,381 @@ static int handle_symlink(const char *filename, const char *fullpath)
 }
 
 /*
- * process a file, return number of errors.
+ * Does |filename| end with a recognized extension?
  */
-static int do_file(const char *filename, const char *fullpath, enum Hash h)
+static int has_extension(const char *filename)
 {
-    STACK_OF (X509_INFO) *inf = NULL;
-    X509_INFO *x;
-    X509_NAME *name = NULL;
-    BIO *b;
     const char *ext;
-    unsigned char digest[EVP_MAX_MD_SIZE];
-    int type, errs = 0;
     size_t i;
 
-    /* Does it end with a recognized extension? */
     if ((ext = strrchr(filename, '.')) == NULL)
-        goto end;
+        return 0;
     for (i = 0; i < OSSL_NELEM(extensions); i++) {
         if (strcasecmp(extensions[i], ext + 1) == 0)
-            break;
+            return 1;
     }
-    if (i >= OSSL_NELEM(extensions))
-        goto end;
+    return 0;
+}
+
+/*
+ * Parse a file and record what it holds in |fi|. This runs in the parsing
+ * threads, so it only touches |fi|; add_file() reports the outcome.
+ */
+static void parse_file(FILE_INFO *fi, const char *fullpath, enum Hash h)
+{
+    STACK_OF (X509_INFO) *inf = NULL;
+    X509_INFO *x;
+    X509_NAME *name;
+    BIO *b;
 
     /* Does it have X.509 data in it? */
     if ((b = BIO_new_file(fullpath, "r")) == NULL) {
-        BIO_printf(bio_err, "%s: error: skipping %s, cannot open file\n",
-                   opt_getprog(), filename);
-        errs++;
-        goto end;
+        fi->status = FILE_NO_OPEN;
+        return;
     }
     inf = PEM_X509_INFO_read_bio(b, NULL, NULL, NULL);
     BIO_free(b);
+    fi->status = FILE_SKIP;
     if (inf == NULL)
         goto end;
 
     if (sk_X509_INFO_num(inf) != 1) {
-        BIO_printf(bio_err,
-                   "%s: warning: skipping %s,"
-                   "it does not contain exactly one certificate or CRL\n",
-                   opt_getprog(), filename);
-        /* This is not an error. */
+        fi->status = FILE_NOT_ONE;
         goto end;
     }
     x = sk_X509_INFO_value(inf, 0);
     if (x->x509 != NULL) {
-        type = TYPE_CERT;
+        fi->type = TYPE_CERT;
         name = X509_get_subject_name(x->x509);
-        if (!X509_digest(x->x509, evpmd, digest, NULL)) {
-            BIO_printf(bio_err, "out of memory\n");
-            ++errs;
+        if (!X509_digest(x->x509, evpmd, fi->digest, NULL)) {
+            fi->status = FILE_NO_MEM;
             goto end;
         }
+        if (bundle != NULL) {
+            fi->x509 = x->x509;
+            x->x509 = NULL;
+        }
     } else if (x->crl != NULL) {
-        type = TYPE_CRL;
+        fi->type = TYPE_CRL;
         name = X509_CRL_get_issuer(x->crl);
-        if (!X509_CRL_digest(x->crl, evpmd, digest, NULL)) {
-            BIO_printf(bio_err, "out of memory\n");
-            ++errs;
+        if (!X509_CRL_digest(x->crl, evpmd, fi->digest, NULL)) {
+            fi->status = FILE_NO_MEM;
             goto end;
         }
     } else {
-        ++errs;
+        fi->status = FILE_BAD;
         goto end;
     }
-    if (name != NULL) {
-        if ((h == HASH_NEW) || (h == HASH_BOTH))
-            errs += add_entry(type, X509_NAME_hash(name), filename, digest, 1, ~0);
-        if ((h == HASH_OLD) || (h == HASH_BOTH))
-            errs += add_entry(type, X509_NAME_hash_old(name), filename, digest, 1, ~0);
-    }
+    fi->hash = h != HASH_OLD ? X509_NAME_hash(name) : 0;
+    fi->hash_old = h != HASH_NEW ? X509_NAME_hash_old(name) : 0;
+    fi->status = FILE_OK;
 
 end:
     sk_X509_INFO_pop_free(inf, X509_INFO_free);
+}
+
+/*
+ * Add the hash entries for a parsed file, return number of errors.
+ */
+static int add_file(const FILE_INFO *fi, enum Hash h)
+{
+    int errs = 0;
+
+    switch (fi->status) {
+    case FILE_OK:
+        break;
+    case FILE_NO_OPEN:
+        BIO_printf(bio_err, "%s: error: skipping %s, cannot open file\n",
+                   opt_getprog(), fi->filename);
+        return 1;
+    case FILE_NOT_ONE:
+        BIO_printf(bio_err,
+                   "%s: warning: skipping %s,"
+                   "it does not contain exactly one certificate or CRL\n",
+                   opt_getprog(), fi->filename);
+        /* This is not an error. */
+        return 0;
+    case FILE_NO_MEM:
+        BIO_printf(bio_err, "out of memory\n");
+        return 1;
+    case FILE_BAD:
+        return 1;
+    default:
+        return 0;
+    }
+    if ((h == HASH_NEW) || (h == HASH_BOTH))
+        errs += add_entry(fi->type, fi->hash, fi->filename, fi->digest, 1, ~0);
+    if ((h == HASH_OLD) || (h == HASH_BOTH))
+        errs += add_entry(fi->type, fi->hash_old, fi->filename, fi->digest, 1,
+                          ~0);
     return errs;
 }
 
+static int parse_next(PARSE_JOB *job)
+{
+    int n;
+
+# ifdef REHASH_THREADS
+    pthread_mutex_lock(&job->lock);
+# endif
+    while (job->next < job->num
+           && job->infos[job->next].status != FILE_PENDING)
+        job->next++;
+    n = job->next < job->num ? job->next++ : -1;
+# ifdef REHASH_THREADS
+    pthread_mutex_unlock(&job->lock);
+# endif
+    return n;
+}
+
+static void *parse_files(void *arg)
+{
+    PARSE_JOB *job = arg;
+    FILE_INFO *fi;
+    char *buf = app_malloc(job->buflen, "filename buffer");
+    int n;
+
+    while ((n = parse_next(job)) >= 0) {
+        fi = &job->infos[n];
+        BIO_snprintf(buf, job->buflen, "%s%s%s",
+                     job->dirname, job->pathsep, fi->filename);
+        parse_file(fi, buf, job->h);
+    }
+    OPENSSL_free(buf);
+    return NULL;
+}
+
+/*
+ * Parse the files that are not known from the manifest, using the
+ * calling thread and up to |threads| - 1 more.
+ */
+static void parse_all(PARSE_JOB *job)
+{
+# ifdef REHASH_THREADS
+    pthread_t *tids;
+    int i, n = threads, started = 0;
+
+    if (n > job->num)
+        n = job->num;
+    if (n < 1)
+        n = 1;
+    tids = app_malloc(n * sizeof(*tids), "parsing threads");
+    pthread_mutex_init(&job->lock, NULL);
+    for (i = 1; i < n; i++)
+        if (pthread_create(&tids[started], NULL, parse_files, job) == 0)
+            started++;
+    parse_files(job);
+    for (i = 0; i < started; i++)
+        pthread_join(tids[i], NULL);
+    pthread_mutex_destroy(&job->lock);
+    OPENSSL_free(tids);
+# else
+    parse_files(job);
+# endif
+}
+
+static unsigned long file_info_hash(const FILE_INFO *fi)
+{
+    return OPENSSL_LH_strhash(fi->filename);
+}
+
+static int file_info_cmp(const FILE_INFO *a, const FILE_INFO *b)
+{
+    return strcmp(a->filename, b->filename);
+}
+
+static void file_info_free(FILE_INFO *fi)
+{
+    OPENSSL_free(fi->filename);
+    OPENSSL_free(fi);
+}
+
+/*
+ * The manifest has a line per file that was seen by the last run:
+ *
+ *   inode size mtime status type hash hash_old digest filename
+ *
+ * Only outcomes that depend on nothing but the file's contents are kept,
+ * so that files failing to parse are looked at again each time.
+ */
+static LHASH_OF(FILE_INFO) *read_manifest(const char *path, enum Hash h)
+{
+    LHASH_OF(FILE_INFO) *manifest = NULL;
+    FILE_INFO *fi = NULL;
+    BIO *in;
+    int damaged = 0;
+    char line[32 + 2 * EVP_MAX_MD_SIZE + 128 + NAME_MAX + 2];
+    char hex[2 * EVP_MAX_MD_SIZE + 1];
+    int status, type, n, i, hi, lo;
+    size_t len;
+
+    if ((in = BIO_new_file(path, "r")) == NULL) {
+        ERR_clear_error();
+        return NULL;
+    }
+    if (BIO_gets(in, line, sizeof(line)) <= 0
+            || strncmp(line, MANIFEST_MAGIC " ", strlen(MANIFEST_MAGIC) + 1)
+               != 0
+            || atoi(line + strlen(MANIFEST_MAGIC) + 1) != (int)h
+            || (manifest = lh_FILE_INFO_new(file_info_hash,
+                                            file_info_cmp)) == NULL)
+        goto end;
+
+    while (BIO_gets(in, line, sizeof(line)) > 0) {
+        len = strlen(line);
+        damaged = 1;
+        if (len == 0 || line[len - 1] != '\n')
+            break;
+        line[len - 1] = '\0';
+        fi = app_malloc(sizeof(*fi), "manifest entry");
+        memset(fi, 0, sizeof(*fi));
+        if (sscanf(line, "%lu %ld %ld %d %d %lx %lx %128s %n", &fi->ino,
+                   &fi->size, &fi->mtime, &status, &type, &fi->hash,
+                   &fi->hash_old, hex, &n) != 8
+                || (status != FILE_OK && status != FILE_SKIP
+                    && status != FILE_NOT_ONE)
+                || (type != TYPE_CERT && type != TYPE_CRL)
+                || strlen(hex) != (size_t)evpmdsize * 2
+                || line[n] == '\0')
+            break;
+        fi->status = status;
+        fi->type = type;
+        for (i = 0; i < evpmdsize; i++) {
+            hi = OPENSSL_hexchar2int(hex[2 * i]);
+            lo = OPENSSL_hexchar2int(hex[2 * i + 1]);
+            if (hi < 0 || lo < 0)
+                break;
+            fi->digest[i] = (unsigned char)(hi << 4 | lo);
+        }
+        if (i < evpmdsize
+                || (fi->filename = OPENSSL_strdup(line + n)) == NULL)
+            break;
+        fi = lh_FILE_INFO_insert(manifest, fi);
+        if (fi != NULL)
+            file_info_free(fi);
+        fi = NULL;
+        damaged = 0;
+    }
+    if (damaged) {
+        /* A damaged manifest is ignored as a whole */
+        BIO_printf(bio_err, "%s: warning: ignoring damaged %s\n",
+                   opt_getprog(), path);
+        if (fi != NULL)
+            file_info_free(fi);
+        lh_FILE_INFO_doall(manifest, file_info_free);
+        lh_FILE_INFO_free(manifest);
+        manifest = NULL;
+    }
+
+ end:
+    BIO_free(in);
+    return manifest;
+}
+
+/*
+ * Write the manifest to |tmppath| and move it in place, return number of
+ * errors.
+ */
+static int write_manifest(const char *path, const char *tmppath,
+                          const FILE_INFO *infos, int num, enum Hash h)
+{
+    const FILE_INFO *fi;
+    BIO *out;
+    int n, i, ok;
+
+    if ((out = BIO_new_file(tmppath, "w")) == NULL) {
+        BIO_printf(bio_err, "%s: Can't write %s\n", opt_getprog(), tmppath);
+        ERR_clear_error();
+        return 1;
+    }
+    ok = BIO_printf(out, "%s %d\n", MANIFEST_MAGIC, (int)h) > 0;
+    for (n = 0; ok && n < num; n++) {
+        fi = &infos[n];
+        if ((fi->status != FILE_OK && fi->status != FILE_SKIP
+                && fi->status != FILE_NOT_ONE)
+                || strchr(fi->filename, '\n') != NULL)
+            continue;
+        ok = BIO_printf(out, "%lu %ld %ld %d %d %08lx %08lx ", fi->ino,
+                        fi->size, fi->mtime, (int)fi->status, (int)fi->type,
+                        fi->hash, fi->hash_old) > 0;
+        for (i = 0; ok && i < evpmdsize; i++)
+            ok = BIO_printf(out, "%02x", fi->digest[i]) > 0;
+        ok = ok && BIO_printf(out, " %s\n", fi->filename) > 0;
+    }
+    ok = BIO_flush(out) > 0 && ok;
+    BIO_free(out);
+    if (!ok || rename(tmppath, path) < 0) {
+        BIO_printf(bio_err, "%s: Can't write %s\n", opt_getprog(), path);
+        unlink(tmppath);
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * Write the certificates as a CA bundle, see X509_LOOKUP_bundle(3),
+ * return number of errors.
+ */
+static int write_bundle(const char *path, const char *tmppath,
+                        const FILE_INFO *infos, int num)
+{
+    STACK_OF(X509) *certs;
+    BIO *out = NULL;
+    int n, ok = 0;
+
+    if ((certs = sk_X509_new_null()) == NULL)
+        goto end;
+    for (n = 0; n < num; n++) {
+        if (infos[n].status == FILE_OK && infos[n].x509 != NULL
+                && !sk_X509_push(certs, infos[n].x509))
+            goto end;
+    }
+    if ((out = BIO_new_file(tmppath, "wb")) == NULL)
+        goto end;
+    ok = X509_write_bundle_bio(out, certs) && BIO_flush(out) > 0;
+    BIO_free(out);
+    out = NULL;
+    if (ok && rename(tmppath, path) < 0)
+        ok = 0;
+    if (!ok)
+        unlink(tmppath);
+
+ end:
+    sk_X509_free(certs);
+    if (!ok) {
+        BIO_printf(bio_err, "%s: Can't write %s\n", opt_getprog(), path);
+        ERR_print_errors(bio_err);
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * Point |linkpath| at |target|, replacing whatever was there in one step,
+ * return number of errors.
+ */
+static int replace_link(const char *target, const char *linkpath,
+                        const char *tmppath)
+{
+    if (unlink(tmppath) < 0 && errno != ENOENT) {
+        BIO_printf(bio_err, "%s: Can't unlink %s, %s\n",
+                   opt_getprog(), tmppath, strerror(errno));
+        return 1;
+    }
+    if (symlink(target, tmppath) < 0) {
+        BIO_printf(bio_err, "%s: Can't symlink %s, %s\n",
+                   opt_getprog(), target, strerror(errno));
+        return 1;
+    }
+    if (rename(tmppath, linkpath) < 0) {
+        BIO_printf(bio_err, "%s: Can't rename %s to %s, %s\n",
+                   opt_getprog(), tmppath, linkpath, strerror(errno));
+        unlink(tmppath);
+        return 1;
+    }
+    return 0;
+}
+
 static void str_free(char *s)
 {
     OPENSSL_free(s);
@@ -330,13 +674,17 @@ static int do_dir(const char *dirname, enum Hash h)
     BUCKET *bp, *nextbp;
     HENTRY *ep, *nextep;
     OPENSSL_DIR_CTX *d = NULL;
+    LHASH_OF(FILE_INFO) *manifest = NULL;
+    FILE_INFO *infos = NULL, *fi, *cached;
+    PARSE_JOB job;
     struct stat st;
     unsigned char idmask[MAX_COLLISIONS / 8];
-    int n, numfiles, nextid, buflen, errs = 0;
+    int n, numfiles, numinfos = 0, nummatched = 0, nextid, buflen, errs = 0;
+    int do_bundle = 0;
     size_t i;
     const char *pathsep;
     const char *filename;
-    char *buf, *copy = NULL;
+    char *buf, *tmpbuf, *copy = NULL;
     STACK_OF(OPENSSL_STRING) *files = NULL;
 
     if (app_access(dirname, W_OK) < 0) {
@@ -347,6 +695,8 @@ static int do_dir(const char *dirname, enum Hash h)
     pathsep = (buflen && !ends_with_dirsep(dirname)) ? "/": "";
     buflen += NAME_MAX + 1 + 1;
     buf = app_malloc(buflen, "filename buffer");
+    tmpbuf = app_malloc(buflen, "filename buffer");
+    BIO_snprintf(tmpbuf, buflen, "%s%s%s", dirname, pathsep, TMP_NAME);
 
     if (verbose)
         BIO_printf(bio_out, "Doing %s\n", dirname);
@@ -368,7 +718,14 @@ static int do_dir(const char *dirname, enum Hash h)
     OPENSSL_DIR_end(&d);
     sk_OPENSSL_STRING_sort(files);
 
+    if (incremental) {
+        BIO_snprintf(buf, buflen, "%s%s%s", dirname, pathsep, MANIFEST_NAME);
+        manifest = read_manifest(buf, h);
+    }
+
     numfiles = sk_OPENSSL_STRING_num(files);
+    infos = app_malloc(sizeof(*infos) * (numfiles + 1), "file information");
+    memset(infos, 0, sizeof(*infos) * (numfiles + 1));
     for (n = 0; n < numfiles; ++n) {
         filename = sk_OPENSSL_STRING_value(files, n);
         if (BIO_snprintf(buf, buflen, "%s%s%s",
@@ -376,9 +733,68 @@ static int do_dir(const char *dirname, enum Hash h)
             continue;
         if (lstat(buf, &st) < 0)
             continue;
-        if (S_ISLNK(st.st_mode) && handle_symlink(filename, buf) == 0)
+        if (S_ISLNK(st.st_mode)) {
+            if (handle_symlink(filename, buf) == 0)
+                continue;
+            /* The manifest keys on the file that is linked to */
+            if (stat(buf, &st) < 0)
+                memset(&st, 0, sizeof(st));
+        }
+        if (!has_extension(filename)
+                || (bundle != NULL && strcmp(filename, bundle) == 0))
             continue;
-        errs += do_file(filename, buf, h);
+
+        fi = &infos[numinfos++];
+        fi->filename = (char *)filename;
+        fi->ino = (unsigned long)st.st_ino;
+        fi->size = (long)st.st_size;
+        fi->mtime = (long)st.st_mtime;
+        fi->status = FILE_PENDING;
+        if (manifest != NULL
+                && (cached = lh_FILE_INFO_retrieve(manifest, fi)) != NULL
+                && cached->ino == fi->ino && cached->size == fi->size
+                && cached->mtime == fi->mtime) {
+            fi->status = cached->status;
+            fi->type = cached->type;
+            fi->hash = cached->hash;
+            fi->hash_old = cached->hash_old;
+            memcpy(fi->digest, cached->digest, evpmdsize);
+            nummatched++;
+        }
+    }
+
+    /*
+     * The bundle is only rewritten when a file was added, changed or
+     * removed since the manifest was written, in which case the
+     * certificates known from the manifest have to be read after all.
+     */
+    if (bundle != NULL) {
+        BIO_snprintf(buf, buflen, "%s%s%s", dirname, pathsep, bundle);
+        do_bundle = manifest == NULL || nummatched != numinfos
+            || (unsigned long)nummatched != lh_FILE_INFO_num_items(manifest)
+            || stat(buf, &st) < 0;
+        for (n = 0; do_bundle && n < numinfos; n++)
+            if (infos[n].status == FILE_OK && infos[n].type == TYPE_CERT)
+                infos[n].status = FILE_PENDING;
+    }
+
+    job.infos = infos;
+    job.num = numinfos;
+    job.next = 0;
+    job.buflen = buflen;
+    job.dirname = dirname;
+    job.pathsep = pathsep;
+    job.h = h;
+    parse_all(&job);
+
+    for (n = 0; n < numinfos; n++)
+        errs += add_file(&infos[n], h);
+
+    if (do_bundle) {
+        if (verbose)
+            BIO_printf(bio_out, "bundle %s\n", bundle);
+        BIO_snprintf(buf, buflen, "%s%s%s", dirname, pathsep, bundle);
+        errs += write_bundle(buf, tmpbuf, infos, numinfos);
     }
 
     for (i = 0; i < OSSL_NELEM(hash_table); i++) {
@@ -410,19 +826,7 @@ static int do_dir(const char *dirname, enum Hash h)
                     if (verbose)
                         BIO_printf(bio_out, "link %s -> %s\n",
                                    ep->filename, &buf[n]);
-                    if (unlink(buf) < 0 && errno != ENOENT) {
-                        BIO_printf(bio_err,
-                                   "%s: Can't unlink %s, %s\n",
-                                   opt_getprog(), buf, strerror(errno));
-                        errs++;
-                    }
-                    if (symlink(ep->filename, buf) < 0) {
-                        BIO_printf(bio_err,
-                                   "%s: Can't symlink %s, %s\n",
-                                   opt_getprog(), ep->filename,
-                                   strerror(errno));
-                        errs++;
-                    }
+                    errs += replace_link(ep->filename, buf, tmpbuf);
                     bit_set(idmask, nextid);
                 } else if (remove_links) {
                     /* Link to be deleted */
@@ -447,15 +851,29 @@ static int do_dir(const char *dirname, enum Hash h)
         hash_table[i] = NULL;
     }
 
+    if (incremental) {
+        BIO_snprintf(buf, buflen, "%s%s%s", dirname, pathsep, MANIFEST_NAME);
+        errs += write_manifest(buf, tmpbuf, infos, numinfos, h);
+    }
+
  err:
+    if (manifest != NULL) {
+        lh_FILE_INFO_doall(manifest, file_info_free);
+        lh_FILE_INFO_free(manifest);
+    }
+    for (n = 0; n < numinfos; n++)
+        X509_free(infos[n].x509);
+    OPENSSL_free(infos);
     sk_OPENSSL_STRING_pop_free(files, str_free);
     OPENSSL_free(buf);
+    OPENSSL_free(tmpbuf);
     return errs;
 }
 
 typedef enum OPTION_choice {
     OPT_ERR = -1, OPT_EOF = 0, OPT_HELP,
-    OPT_COMPAT, OPT_OLD, OPT_N, OPT_VERBOSE
+    OPT_COMPAT, OPT_OLD, OPT_N, OPT_VERBOSE, OPT_INCREMENTAL, OPT_BUNDLE,
+    OPT_THREADS
 } OPTION_CHOICE;
 
 const OPTIONS rehash_options[] = {
@@ -467,6 +885,13 @@ const OPTIONS rehash_options[] = {
     {"old", OPT_OLD, '-', "Use old-style hash to generate links"},
     {"n", OPT_N, '-', "Do not remove existing links"},
     {"v", OPT_VERBOSE, '-', "Verbose output"},
+    {"incremental", OPT_INCREMENTAL, '-',
+     "Only read files changed since the last incremental run"},
+    {"bundle", OPT_BUNDLE, 's',
+     "Also write the certificates to a CA bundle of this name"},
+# ifdef REHASH_THREADS
+    {"threads", OPT_THREADS, 'p', "Number of threads reading files"},
+# endif
     {NULL}
 };
 
@@ -501,6 +926,15 @@ int rehash_main(int argc, char **argv)
         case OPT_VERBOSE:
             verbose = 1;
             break;
+        case OPT_INCREMENTAL:
+            incremental = 1;
+            break;
+        case OPT_BUNDLE:
+            bundle = opt_arg();
+            break;
+        case OPT_THREADS:
+            threads = atoi(opt_arg());
+            break;
         }
     }
     argc = opt_num_rest();
@@ -15,6 +15,8 @@
 #define PROTOCOL        "tcp"
 
 typedef int (*do_server_cb)(int s, int stype, int prot, unsigned char *context);
+int do_listen(int *sock, const char *host, const char *port,
+              int family, int type, int protocol, BIO *bio_s_out);
 int do_server(int *accept_sock, const char *host, const char *port,
               int family, int type, int protocol, do_server_cb cb,
               unsigned char *context, int naccept, BIO *bio_s_out);
@@ -39,6 +41,16 @@ long bio_dump_callback(BIO *bio, int cmd, const char *argp,
 void apps_ssl_info_callback(const SSL *s, int where, int ret);
 void msg_cb(int write_p, int version, int content_type, const void *buf,
             size_t len, SSL *ssl, void *arg);
+
+typedef void (*SSL_msg_cb)(int write_p, int version, int content_type,
+                           const void *buf, size_t len, SSL *ssl, void *arg);
+typedef struct flight_stats_st FLIGHT_STATS;
+FLIGHT_STATS *flight_stats_new(int mss, int initcwnd);
+void flight_stats_free(FLIGHT_STATS *fs);
+void flight_stats_set_next(FLIGHT_STATS *fs, SSL_msg_cb next, void *next_arg);
+void flight_stats_cb(int write_p, int version, int content_type,
+                     const void *buf, size_t len, SSL *ssl, void *arg);
+void flight_stats_print(BIO *bio, SSL *s, FLIGHT_STATS *fs);
 void tlsext_cb(SSL *s, int client_server, int type, const unsigned char *data,
                int len, void *arg);
 
@@ -483,6 +483,16 @@ static const char* OQS_CURVE_ID_NAME_STR(int id) {
    case 0x2F2C: return "p256_hqc128 hybrid";
    case 0x2F2D: return "p384_hqc192 hybrid";
    case 0x2F2E: return "p521_hqc256 hybrid";
+   case 0x2F80: return "x25519_frodo640aes hybrid";
+   case 0x2F81: return "x25519_frodo640shake hybrid";
+   case 0x2F82: return "x448_frodo976aes hybrid";
+   case 0x2F83: return "x448_frodo976shake hybrid";
+   case 0x2F39: return "x25519_kyber512 hybrid";
+   case 0x2F90: return "x448_kyber768 hybrid";
+   case 0x2FAE: return "x25519_bikel1 hybrid";
+   case 0x2FAF: return "x448_bikel3 hybrid";
+   case 0x2FAC: return "x25519_hqc128 hybrid";
+   case 0x2FAD: return "x448_hqc192 hybrid";
   ///// OQS_TEMPLATE_FRAGMENT_OQS_CURVE_ID_NAME_STR_HYBRID_END
   default: return "";
   }
@@ -748,6 +758,179 @@ void msg_cb(int write_p, int version, int content_type, const void *buf,
     (void)BIO_flush(bio);
 }
 
+/*-
+ * Flight statistics: the records of the handshake, seen through the message
+ * callback, grouped into flights, each a run of records sent in the same
+ * direction. A flight of n bytes takes ceil(n / mss) TCP segments, and a
+ * sender in slow start sends initcwnd segments in its first round trip and
+ * twice as many in each next one.
+ */
+#define FLIGHT_MAX          16
+#define FLIGHT_MSGS_LEN     160
+
+typedef struct {
+    int write_p;
+    size_t records;
+    size_t bytes;
+    char msgs[FLIGHT_MSGS_LEN];
+} FLIGHT;
+
+struct flight_stats_st {
+    int mss;
+    int initcwnd;
+    int done;
+    size_t num;
+    FLIGHT flights[FLIGHT_MAX];
+    /* The message callback that was chained to, if any */
+    SSL_msg_cb next;
+    void *next_arg;
+};
+
+FLIGHT_STATS *flight_stats_new(int mss, int initcwnd)
+{
+    FLIGHT_STATS *fs = app_malloc(sizeof(*fs), "flight stats");
+
+    memset(fs, 0, sizeof(*fs));
+    fs->mss = mss;
+    fs->initcwnd = initcwnd;
+    return fs;
+}
+
+void flight_stats_free(FLIGHT_STATS *fs)
+{
+    OPENSSL_free(fs);
+}
+
+void flight_stats_set_next(FLIGHT_STATS *fs, SSL_msg_cb next, void *next_arg)
+{
+    fs->next = next;
+    fs->next_arg = next_arg;
+}
+
+static void flight_add_msg(FLIGHT *f, const char *name)
+{
+    /* The names of the |handshakes| table start with ", " */
+    if (f->msgs[0] == '\0')
+        name += 2;
+    if (strlen(f->msgs) + strlen(name) < sizeof(f->msgs))
+        strcat(f->msgs, name);
+}
+
+void flight_stats_cb(int write_p, int version, int content_type,
+                     const void *buf, size_t len, SSL *ssl, void *arg)
+{
+    FLIGHT_STATS *fs = arg;
+    const unsigned char *bp = buf;
+    FLIGHT *f = fs->num > 0 ? &fs->flights[fs->num - 1] : NULL;
+    size_t i;
+
+    if (fs->next != NULL)
+        fs->next(write_p, version, content_type, buf, len, ssl, fs->next_arg);
+    if (fs->done)
+        return;
+
+    switch (content_type) {
+    case SSL3_RT_HEADER:
+        if (len < 5)
+            break;
+        if (f == NULL || f->write_p != write_p) {
+            if (fs->num == FLIGHT_MAX)
+                break;
+            f = &fs->flights[fs->num++];
+            f->write_p = write_p;
+        }
+        f->records++;
+        /* The length is in the last two bytes, for TLS and DTLS alike */
+        f->bytes += len + ((bp[len - 2] << 8) | bp[len - 1]);
+        break;
+    case SSL3_RT_CHANGE_CIPHER_SPEC:
+    case SSL3_RT_HANDSHAKE:
+        /* The message goes with the last flight sent the same way */
+        for (i = fs->num; i > 0; i--) {
+            f = &fs->flights[i - 1];
+            if (f->write_p == write_p)
+                break;
+        }
+        if (i == 0)
+            break;
+        if (content_type == SSL3_RT_CHANGE_CIPHER_SPEC)
+            flight_add_msg(f, ", ChangeCipherSpec");
+        else if (len > 0)
+            flight_add_msg(f, lookup((int)bp[0], handshakes, ", ???"));
+        break;
+    }
+}
+
+/* The round trips a sender in slow start takes to send |segments| */
+static int flight_rounds(const FLIGHT_STATS *fs, size_t segments)
+{
+    size_t window = fs->initcwnd, sent = window;
+    int rounds = 1;
+
+    while (sent < segments) {
+        window *= 2;
+        sent += window;
+        rounds++;
+    }
+    return rounds;
+}
+
+void flight_stats_print(BIO *bio, SSL *s, FLIGHT_STATS *fs)
+{
+    size_t i, segments, sent = 0, received = 0;
+    int rounds, rtts = 0, oqs_kem_curve_id, nid;
+    const char *group = "unknown", *sig = "none";
+    EVP_PKEY *key = NULL;
+
+    fs->done = 1;
+
+    oqs_kem_curve_id = SSL_get_oqs_kem_curve_id(s);
+    if (oqs_kem_curve_id != 0) {
+        group = OQS_CURVE_ID_NAME_STR(oqs_kem_curve_id);
+    } else if (SSL_get_peer_tmp_key(s, &key)) {
+        nid = EVP_PKEY_id(key);
+#ifndef OPENSSL_NO_EC
+        if (nid == EVP_PKEY_EC) {
+            nid = EC_GROUP_get_curve_name(
+                      EC_KEY_get0_group(EVP_PKEY_get0_EC_KEY(key)));
+            if ((group = EC_curve_nid2nist(nid)) == NULL)
+                group = OBJ_nid2sn(nid);
+        } else
+#endif
+        {
+            group = OBJ_nid2sn(nid);
+        }
+    }
+    if (SSL_get_peer_signature_type_nid(s, &nid))
+        sig = OBJ_nid2sn(nid);
+
+    BIO_printf(bio, "---\nHandshake flights (MSS %d, initial window %d):\n",
+               fs->mss, fs->initcwnd);
+    BIO_printf(bio, "  dir  records   bytes  segments  rounds  messages\n");
+    for (i = 0; i < fs->num; i++) {
+        FLIGHT *f = &fs->flights[i];
+
+        segments = (f->bytes + fs->mss - 1) / fs->mss;
+        rounds = flight_rounds(fs, segments);
+        /*
+         * A flight received costs a round trip from our previous one, and
+         * both ways a flight over the initial window costs extra ones
+         */
+        rtts += f->write_p ? rounds - 1 : rounds;
+        if (f->write_p)
+            sent += f->bytes;
+        else
+            received += f->bytes;
+        BIO_printf(bio, "  %s %7lu %7lu %9lu %7d  %s\n",
+                   f->write_p ? ">>>" : "<<<", (unsigned long)f->records,
+                   (unsigned long)f->bytes, (unsigned long)segments, rounds,
+                   f->msgs);
+    }
+    BIO_printf(bio, "%s, %s: %lu bytes sent, %lu received, %d round trips\n",
+               group, sig, (unsigned long)sent, (unsigned long)received, rtts);
+    EVP_PKEY_free(key);
+}
+
 static STRINT_PAIR tlsext_types[] = {
     {"server name", TLSEXT_TYPE_server_name},
     {"max fragment length", TLSEXT_TYPE_max_fragment_length},
@@ -49,6 +49,16 @@ typedef unsigned int u_int;
 #include "timeouts.h"
 #include "internal/sockets.h"
 
+/* -load runs an event loop per thread on POSIX systems */
+#if defined(OPENSSL_THREADS) && !defined(OPENSSL_SYS_WINDOWS) \
+    && !defined(OPENSSL_SYS_VMS)
+# define S_CLIENT_LOAD
+# include <errno.h>
+# include <poll.h>
+# include <pthread.h>
+# include <time.h>
+#endif
+
 #if defined(__has_feature)
 # if __has_feature(memory_sanitizer)
 #  include <sanitizer/msan_interface.h>
@@ -70,6 +80,16 @@ static char *sess_out = NULL;
 static SSL_SESSION *psksess = NULL;
 
 static void print_stuff(BIO *berr, SSL *con, int full);
+#ifndef OPENSSL_NO_EC
+static void print_group_prefs(BIO *out, SSL_CTX *ctx);
+#endif
+#ifdef S_CLIENT_LOAD
+static int load_run(SSL_CTX *ctx, const char *host, const char *port,
+                    int family, const char *servername, int nthreads,
+                    int nconns, int secs, int resume,
+                    const char *early_data_file, const char *groups,
+                    const char *sigalgs);
+#endif
 #ifndef OPENSSL_NO_OCSP
 static int ocsp_resp_cb(SSL *s, void *arg);
 #endif
@@ -596,8 +616,12 @@ typedef enum OPTION_choice {
     OPT_CT, OPT_NOCT, OPT_CTLOG_FILE,
 #endif
     OPT_DANE_TLSA_RRDATA, OPT_DANE_EE_NO_NAME,
-    OPT_ENABLE_PHA,
+    OPT_ENABLE_PHA, OPT_LOAD, OPT_LOAD_THREADS, OPT_LOAD_TIME, OPT_LOAD_RESUME,
+    OPT_FLIGHTSTATS, OPT_MSS, OPT_INITCWND,
     OPT_SCTP_LABEL_BUG,
+#ifndef OPENSSL_NO_EC
+    OPT_CALIBRATE_GROUPS, OPT_SHOWGROUPS,
+#endif
     OPT_R_ENUM
 } OPTION_CHOICE;
 
@@ -790,6 +814,26 @@ const OPTIONS s_client_options[] = {
     {"keylogfile", OPT_KEYLOG_FILE, '>', "Write TLS secrets to file"},
     {"early_data", OPT_EARLY_DATA, '<', "File to send as early data"},
     {"enable_pha", OPT_ENABLE_PHA, '-', "Enable post-handshake-authentication"},
+    {"load", OPT_LOAD, 'p',
+     "Generate load with #num concurrent connections per thread"},
+    {"load_threads", OPT_LOAD_THREADS, 'p',
+     "Number of threads generating load (default 1)"},
+    {"load_time", OPT_LOAD_TIME, 'p',
+     "Seconds to generate load for (default 10)"},
+    {"load_resume", OPT_LOAD_RESUME, '-',
+     "Resume sessions when generating load"},
+    {"flightstats", OPT_FLIGHTSTATS, '-',
+     "Print the size and round trips of each flight of the handshake"},
+    {"mss", OPT_MSS, 'p',
+     "TCP maximum segment size for -flightstats (default 1460)"},
+    {"initcwnd", OPT_INITCWND, 'p',
+     "TCP initial window in segments for -flightstats (default 10)"},
+#ifndef OPENSSL_NO_EC
+    {"calibrate_groups", OPT_CALIBRATE_GROUPS, 'p',
+     "Order groups by measured cost, keeping those of at least val bits"},
+    {"showgroups", OPT_SHOWGROUPS, '-',
+     "Show the groups offered, in order of preference"},
+#endif
     {NULL, OPT_EOF, 0x00, NULL}
 };
 
@@ -980,6 +1024,12 @@ int s_client_main(int argc, char **argv)
 #endif
     char *psksessf = NULL;
     int enable_pha = 0;
+    int load_conns = 0, load_threads = 1, load_time = 10, load_resume = 0;
+#ifndef OPENSSL_NO_EC
+    int calibrate_bits = 0, showgroups = 0;
+#endif
+    int flightstats = 0, mss = 1460, initcwnd = 10;
+    FLIGHT_STATS *fstats = NULL;
 #ifndef OPENSSL_NO_SCTP
     int sctp_label_bug = 0;
 #endif
@@ -1528,12 +1578,56 @@ int s_client_main(int argc, char **argv)
         case OPT_ENABLE_PHA:
             enable_pha = 1;
             break;
+        case OPT_LOAD:
+            load_conns = atoi(opt_arg());
+            break;
+        case OPT_LOAD_THREADS:
+            load_threads = atoi(opt_arg());
+            break;
+        case OPT_LOAD_TIME:
+            load_time = atoi(opt_arg());
+            break;
+        case OPT_LOAD_RESUME:
+            load_resume = 1;
+            break;
+        case OPT_FLIGHTSTATS:
+            flightstats = 1;
+            break;
+        case OPT_MSS:
+            mss = atoi(opt_arg());
+            break;
+        case OPT_INITCWND:
+            initcwnd = atoi(opt_arg());
+            break;
+#ifndef OPENSSL_NO_EC
+        case OPT_CALIBRATE_GROUPS:
+            calibrate_bits = atoi(opt_arg());
+            break;
+        case OPT_SHOWGROUPS:
+            showgroups = 1;
+            break;
+#endif
         }
     }
     if (count4or6 >= 2) {
         BIO_printf(bio_err, "%s: Can't use both -4 and -6\n", prog);
         goto opthelp;
     }
+    if (load_conns > 0) {
+#ifdef S_CLIENT_LOAD
+        if (socket_type != SOCK_STREAM || starttls_proto != PROTO_OFF
+                || load_threads <= 0 || load_time <= 0) {
+            BIO_printf(bio_err,
+                       "%s: Can't use -load with DTLS or -starttls, or with"
+                       " no -load_threads or -load_time\n", prog);
+            goto opthelp;
+        }
+#else
+        BIO_printf(bio_err, "%s: -load is not supported on this platform\n",
+                   prog);
+        goto end;
+#endif
+    }
     if (noservername) {
         if (servername != NULL) {
             BIO_printf(bio_err,
@@ -1749,6 +1843,18 @@ int s_client_main(int argc, char **argv)
         }
     }
 
+#ifndef OPENSSL_NO_EC
+    if (calibrate_bits > 0) {
+        if (!SSL_CTX_calibrate_groups(ctx, calibrate_bits)) {
+            BIO_printf(bio_err, "%s: Error calibrating groups\n", prog);
+            ERR_print_errors(bio_err);
+            goto end;
+        }
+    }
+    if (showgroups)
+        print_group_prefs(bio_err, ctx);
+#endif
+
 #ifndef OPENSSL_NO_SCTP
     if (protocol == IPPROTO_SCTP && sctp_label_bug == 1)
         SSL_CTX_set_mode(ctx, SSL_MODE_DTLS_SCTP_LABEL_LENGTH_BUG);
@@ -1975,6 +2081,34 @@ int s_client_main(int argc, char **argv)
         }
     }
 
+#ifdef S_CLIENT_LOAD
+    if (load_conns > 0) {
+        const char *groups = NULL, *sigalgs = NULL;
+
+        for (i = 0; i + 1 < sk_OPENSSL_STRING_num(ssl_args); i += 2) {
+            const char *flag = sk_OPENSSL_STRING_value(ssl_args, i);
+
+            if (strcmp(flag, "-groups") == 0 || strcmp(flag, "-curves") == 0)
+                groups = sk_OPENSSL_STRING_value(ssl_args, i + 1);
+            else if (strcmp(flag, "-sigalgs") == 0)
+                sigalgs = sk_OPENSSL_STRING_value(ssl_args, i + 1);
+        }
+        if (!noservername && servername == NULL
+                && (host == NULL || is_dNS_name(host)))
+            servername = host == NULL ? "localhost" : host;
+        /* Keep the sessions for resumption, and print nothing per connection */
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT
+                                            | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_set_verify(ctx, SSL_CTX_get_verify_mode(ctx), NULL);
+        SSL_CTX_set_tlsext_servername_callback(ctx, NULL);
+        if (load_run(ctx, host, port, socket_family, servername, load_threads,
+                     load_conns, load_time, load_resume, early_data_file,
+                     groups, sigalgs))
+            ret = 0;
+        goto end;
+    }
+#endif
+
     /*
      * In TLSv1.3 NewSessionTicket messages arrive after the handshake and can
      * come at any time. Therefore we use a callback to write out the session
@@ -2153,6 +2287,23 @@ int s_client_main(int argc, char **argv)
             SSL_set_msg_callback(con, msg_cb);
         SSL_set_msg_callback_arg(con, bio_c_msg ? bio_c_msg : bio_c_out);
     }
+    if (flightstats) {
+        flight_stats_free(fstats);
+        fstats = flight_stats_new(mss, initcwnd);
+        /* Pass the messages on to the -msg or -trace callback */
+        if (c_msg) {
+#ifndef OPENSSL_NO_SSL_TRACE
+            if (c_msg == 2)
+                flight_stats_set_next(fstats, SSL_trace,
+                                      bio_c_msg ? bio_c_msg : bio_c_out);
+            else
+#endif
+                flight_stats_set_next(fstats, msg_cb,
+                                      bio_c_msg ? bio_c_msg : bio_c_out);
+        }
+        SSL_set_msg_callback(con, flight_stats_cb);
+        SSL_set_msg_callback_arg(con, fstats);
+    }
 
     if (c_tlsextdebug) {
         SSL_set_tlsext_debug_callback(con, tlsext_cb);
@@ -2793,6 +2944,8 @@ int s_client_main(int argc, char **argv)
                 print_stuff(bio_c_out, con, full_log);
                 if (full_log > 0)
                     full_log--;
+                if (fstats != NULL)
+                    flight_stats_print(bio_c_out, con, fstats);
 
                 if (starttls_proto) {
                     BIO_write(bio_err, mbuf, mbuf_len);
@@ -3179,8 +3332,546 @@ int s_client_main(int argc, char **argv)
     bio_c_out = NULL;
     BIO_free(bio_c_msg);
     bio_c_msg = NULL;
+    flight_stats_free(fstats);
+    return ret;
+}
+
+#ifdef S_CLIENT_LOAD
+/*-
+ * -load: a load generator. Each of -load_threads threads keeps -load
+ * connections open at once over non-blocking sockets, starting a new one
+ * whenever one ends, for -load_time seconds. The connections rotate
+ * through each combination of one of the -groups and one of the -sigalgs.
+ * Each connection does a handshake, sends an HTTP request and reads the
+ * response until the server closes the connection. With -load_resume, the
+ * sessions of the connections of a combination are resumed by the next ones,
+ * each session once as TLSv1.3 tickets are meant to be, sending the
+ * -early_data file as early data where the session allows it.
+ */
+
+# define LOAD_POLL_MS       100
+# define LOAD_CONN_TIMEOUT  10000000 /* us */
+# define LOAD_BUCKETS       24
+# define LOAD_SESSIONS      16
+
+typedef struct {
+    uint32_t *us;
+    size_t num;
+    size_t cap;
+    uint64_t sent;
+    uint64_t received;
+} LOAD_SAMPLES;
+
+typedef struct {
+    const char *group;
+    const char *sigalg;
+    /* The sessions to resume with -load_resume, each of them once */
+    SSL_SESSION *sess[LOAD_SESSIONS];
+    int num_sess;
+    LOAD_SAMPLES full;
+    LOAD_SAMPLES resumed;
+    unsigned long early_sent;
+    unsigned long early_accepted;
+    unsigned long failed;
+} LOAD_COMBO;
+
+enum {
+    LOAD_IDLE, LOAD_CONNECT, LOAD_EARLY, LOAD_HANDSHAKE, LOAD_REQUEST,
+    LOAD_RESPONSE
+};
+
+typedef struct {
+    int state;
+    int fd;
+    short events;
+    SSL *ssl;
+    LOAD_COMBO *combo;
+    uint64_t start_us;
+    uint64_t handshake_us;
+    size_t off;
+} LOAD_CONN;
+
+static struct {
+    SSL_CTX *ctx;
+    const char *servername;
+    const BIO_ADDR *addr;
+    int family;
+    int conns;
+    int resume;
+    unsigned char *early_data;
+    size_t early_data_len;
+    uint64_t end_us;
+    pthread_mutex_t lock;
+    LOAD_COMBO *combos;
+    size_t num_combos;
+    size_t next_combo;
+} load;
+
+static const char load_request[] = "GET / HTTP/1.0\r\n\r\n";
+
+static uint64_t load_now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void load_samples_add(LOAD_SAMPLES *ls, uint64_t us, SSL *ssl)
+{
+    uint32_t *p;
+
+    if (ls->num == ls->cap) {
+        p = OPENSSL_realloc(ls->us, sizeof(*p) * (ls->cap == 0 ? 1024
+                                                  : ls->cap * 2));
+        if (p == NULL)
+            return;
+        ls->us = p;
+        ls->cap = ls->cap == 0 ? 1024 : ls->cap * 2;
+    }
+    ls->us[ls->num++] = us > UINT32_MAX ? UINT32_MAX : (uint32_t)us;
+    ls->sent += BIO_number_written(SSL_get_wbio(ssl));
+    ls->received += BIO_number_read(SSL_get_rbio(ssl));
+}
+
+/* Starts a connection in |c|, returns 0 if the connection failed */
+static int load_start(LOAD_CONN *c)
+{
+    LOAD_COMBO *combo;
+    SSL_SESSION *sess = NULL;
+
+    memset(c, 0, sizeof(*c));
+    c->fd = -1;
+    pthread_mutex_lock(&load.lock);
+    combo = &load.combos[load.next_combo++ % load.num_combos];
+    if (combo->num_sess > 0)
+        sess = combo->sess[--combo->num_sess];
+    pthread_mutex_unlock(&load.lock);
+    c->combo = combo;
+    c->start_us = load_now_us();
+
+    if ((c->ssl = SSL_new(load.ctx)) == NULL
+            || (combo->group != NULL
+                && !SSL_set1_groups_list(c->ssl, combo->group))
+            || (combo->sigalg != NULL
+                && !SSL_set1_sigalgs_list(c->ssl, combo->sigalg))
+            || (load.servername != NULL
+                && !SSL_set_tlsext_host_name(c->ssl, load.servername))
+            || (sess != NULL && !SSL_set_session(c->ssl, sess)))
+        goto err;
+    SSL_SESSION_free(sess);
+    sess = NULL;
+
+    c->fd = BIO_socket(load.family, SOCK_STREAM, 0, 0);
+    if (c->fd == INVALID_SOCKET || !SSL_set_fd(c->ssl, c->fd))
+        goto err;
+    if (!BIO_connect(c->fd, load.addr, BIO_SOCK_NONBLOCK
+                     | (load.family != AF_UNIX ? BIO_SOCK_NODELAY : 0))
+            && !BIO_sock_should_retry(-1))
+        goto err;
+    SSL_set_connect_state(c->ssl);
+    c->state = LOAD_CONNECT;
+    c->events = POLLOUT;
+    return 1;
+
+ err:
+    SSL_SESSION_free(sess);
+    return 0;
+}
+
+static void load_end(LOAD_CONN *c, int ok)
+{
+    SSL_SESSION *sess;
+
+    if (c->state == LOAD_IDLE)
+        return;
+    /*
+     * Send our close_notify without waiting for it to go out, as a session
+     * is removed from the cache of an SSL freed without one
+     */
+    if (ok)
+        SSL_shutdown(c->ssl);
+    pthread_mutex_lock(&load.lock);
+    if (!ok && c->state <= LOAD_HANDSHAKE) {
+        c->combo->failed++;
+    } else if (load.resume
+               && (sess = SSL_get1_session(c->ssl)) != NULL) {
+        LOAD_COMBO *combo = c->combo;
+
+        if (!SSL_SESSION_is_resumable(sess)) {
+            SSL_SESSION_free(sess);
+        } else {
+            /* Keep the most recent sessions */
+            if (combo->num_sess == LOAD_SESSIONS) {
+                SSL_SESSION_free(combo->sess[0]);
+                memmove(combo->sess, combo->sess + 1,
+                        sizeof(*combo->sess) * --combo->num_sess);
+            }
+            combo->sess[combo->num_sess++] = sess;
+        }
+    }
+    pthread_mutex_unlock(&load.lock);
+    SSL_free(c->ssl);
+    c->ssl = NULL;
+    if (c->fd != -1)
+        BIO_closesocket(c->fd);
+    c->fd = -1;
+    c->state = LOAD_IDLE;
+}
+
+/* Takes |c| as far as it goes without blocking, returns 0 once it ended */
+static int load_drive(LOAD_CONN *c)
+{
+    static char buf[BUFSIZZ];
+    LOAD_COMBO *combo = c->combo;
+    SSL_SESSION *sess;
+    size_t n;
+    socklen_t len;
+    int ret = 1, err;
+
+    for (;;) {
+        switch (c->state) {
+        case LOAD_CONNECT:
+            len = sizeof(err);
+            if (getsockopt(c->fd, SOL_SOCKET, SO_ERROR, (void *)&err,
+                           &len) != 0 || err != 0) {
+                load_end(c, 0);
+                return 0;
+            }
+            c->handshake_us = load_now_us();
+            sess = SSL_get0_session(c->ssl);
+            c->state = load.early_data != NULL && sess != NULL
+                       && SSL_SESSION_get_max_early_data(sess) > 0
+                       ? LOAD_EARLY : LOAD_HANDSHAKE;
+            continue;
+        case LOAD_EARLY:
+            ret = SSL_write_early_data(c->ssl, load.early_data + c->off,
+                                       load.early_data_len - c->off, &n);
+            if (ret == 1) {
+                c->off += n;
+                if (c->off == load.early_data_len) {
+                    c->state = LOAD_HANDSHAKE;
+                    c->off = 0;
+                }
+                continue;
+            }
+            break;
+        case LOAD_HANDSHAKE:
+            ret = SSL_do_handshake(c->ssl);
+            if (ret == 1) {
+                uint64_t us = load_now_us() - c->handshake_us;
+
+                pthread_mutex_lock(&load.lock);
+                load_samples_add(SSL_session_reused(c->ssl) ? &combo->resumed
+                                 : &combo->full, us, c->ssl);
+                if (SSL_get_early_data_status(c->ssl)
+                        != SSL_EARLY_DATA_NOT_SENT)
+                    combo->early_sent++;
+                if (SSL_get_early_data_status(c->ssl)
+                        == SSL_EARLY_DATA_ACCEPTED)
+                    combo->early_accepted++;
+                pthread_mutex_unlock(&load.lock);
+                c->state = LOAD_REQUEST;
+                continue;
+            }
+            break;
+        case LOAD_REQUEST:
+            ret = SSL_write_ex(c->ssl, load_request + c->off,
+                               sizeof(load_request) - 1 - c->off, &n);
+            if (ret == 1) {
+                c->off += n;
+                if (c->off == sizeof(load_request) - 1)
+                    c->state = LOAD_RESPONSE;
+                continue;
+            }
+            break;
+        case LOAD_RESPONSE:
+            ret = SSL_read_ex(c->ssl, buf, sizeof(buf), &n);
+            if (ret == 1)
+                continue;
+            break;
+        default:
+            return 0;
+        }
+
+        switch (SSL_get_error(c->ssl, ret)) {
+        case SSL_ERROR_WANT_READ:
+            c->events = POLLIN;
+            return 1;
+        case SSL_ERROR_WANT_WRITE:
+            c->events = POLLOUT;
+            return 1;
+        case SSL_ERROR_ZERO_RETURN:
+            load_end(c, 1);
+            return 0;
+        case SSL_ERROR_SYSCALL:
+            /* A server closing without close_notify after its response */
+            load_end(c, c->state == LOAD_RESPONSE);
+            return 0;
+        default:
+            load_end(c, 0);
+            return 0;
+        }
+    }
+}
+
+static void *load_worker(void *arg)
+{
+    LOAD_CONN *conns;
+    struct pollfd *pfds;
+    int *idx;
+    uint64_t now;
+    int i, n, active;
+
+    conns = app_malloc(sizeof(*conns) * load.conns, "load connections");
+    pfds = app_malloc(sizeof(*pfds) * load.conns, "load poll set");
+    idx = app_malloc(sizeof(*idx) * load.conns, "load poll set");
+    for (i = 0; i < load.conns; i++)
+        conns[i].state = LOAD_IDLE;
+
+    for (;;) {
+        now = load_now_us();
+        for (i = 0, n = 0, active = 0; i < load.conns; i++) {
+            LOAD_CONN *c = &conns[i];
+
+            if (c->state != LOAD_IDLE && now - c->start_us > LOAD_CONN_TIMEOUT)
+                load_end(c, 0);
+            if (c->state == LOAD_IDLE && now < load.end_us) {
+                if (!load_start(c)) {
+                    load_end(c, 0);
+                    continue;
+                }
+            }
+            if (c->state == LOAD_IDLE)
+                continue;
+            active++;
+            pfds[n].fd = c->fd;
+            pfds[n].events = c->events;
+            pfds[n].revents = 0;
+            idx[n++] = i;
+        }
+        if (active == 0)
+            break;
+        if (poll(pfds, n, LOAD_POLL_MS) <= 0)
+            continue;
+        for (i = 0; i < n; i++)
+            if (pfds[i].revents != 0)
+                load_drive(&conns[idx[i]]);
+    }
+
+    OPENSSL_free(conns);
+    OPENSSL_free(pfds);
+    OPENSSL_free(idx);
+    return NULL;
+}
+
+static int load_cmp(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static void load_print_samples(BIO *bio, const char *what, LOAD_SAMPLES *ls,
+                               double secs)
+{
+    unsigned long hist[LOAD_BUCKETS];
+    size_t i;
+    int b;
+
+    if (ls->num == 0)
+        return;
+    qsort(ls->us, ls->num, sizeof(*ls->us), load_cmp);
+    BIO_printf(bio, "  %-8s %7lu, %.1f/s, median %lu us, p99 %lu us,"
+               " sent %lu and received %lu bytes per handshake\n", what,
+               (unsigned long)ls->num, ls->num / secs,
+               (unsigned long)ls->us[ls->num / 2],
+               (unsigned long)ls->us[ls->num * 99 / 100],
+               (unsigned long)(ls->sent / ls->num),
+               (unsigned long)(ls->received / ls->num));
+    memset(hist, 0, sizeof(hist));
+    for (i = 0; i < ls->num; i++) {
+        for (b = 0; b < LOAD_BUCKETS - 1 && ls->us[i] >= (1UL << b); b++)
+            continue;
+        hist[b]++;
+    }
+    BIO_printf(bio, "          ");
+    for (b = 0; b < LOAD_BUCKETS; b++)
+        if (hist[b] != 0)
+            BIO_printf(bio, " <%lu:%lu", 1UL << b, hist[b]);
+    BIO_printf(bio, "\n");
+}
+
+/* Splits the colon separated |list| into |sk|, which gets NULL if it is */
+static int load_split(STACK_OF(OPENSSL_STRING) *sk, char *list)
+{
+    char *p;
+
+    if (list == NULL)
+        return sk_OPENSSL_STRING_push(sk, NULL);
+    for (p = list; p != NULL; ) {
+        char *next = strchr(p, ':');
+
+        if (next != NULL)
+            *next++ = '\0';
+        if (!sk_OPENSSL_STRING_push(sk, p))
+            return 0;
+        p = next;
+    }
+    return 1;
+}
+
+static int load_run(SSL_CTX *ctx, const char *host, const char *port,
+                    int family, const char *servername, int nthreads,
+                    int nconns, int secs, int resume,
+                    const char *early_data_file, const char *groups,
+                    const char *sigalgs)
+{
+    STACK_OF(OPENSSL_STRING) *gl = sk_OPENSSL_STRING_new_null();
+    STACK_OF(OPENSSL_STRING) *sl = sk_OPENSSL_STRING_new_null();
+    char *gbuf = NULL, *sbuf = NULL;
+    BIO_ADDRINFO *res = NULL;
+    BIO *in;
+    pthread_t *threads = NULL;
+    int i, j, started = 0, ret = 0;
+    uint64_t start;
+    double elapsed;
+    long len;
+
+    memset(&load, 0, sizeof(load));
+    if (gl == NULL || sl == NULL
+            || (groups != NULL && (gbuf = OPENSSL_strdup(groups)) == NULL)
+            || (sigalgs != NULL && (sbuf = OPENSSL_strdup(sigalgs)) == NULL)
+            || !load_split(gl, gbuf) || !load_split(sl, sbuf))
+        goto end;
+    load.num_combos = sk_OPENSSL_STRING_num(gl) * sk_OPENSSL_STRING_num(sl);
+    load.combos = app_malloc(sizeof(*load.combos) * load.num_combos,
+                             "load combinations");
+    memset(load.combos, 0, sizeof(*load.combos) * load.num_combos);
+    for (i = 0; i < sk_OPENSSL_STRING_num(gl); i++) {
+        for (j = 0; j < sk_OPENSSL_STRING_num(sl); j++) {
+            LOAD_COMBO *lc = &load.combos[i * sk_OPENSSL_STRING_num(sl) + j];
+
+            lc->group = sk_OPENSSL_STRING_value(gl, i);
+            lc->sigalg = sk_OPENSSL_STRING_value(sl, j);
+        }
+    }
+
+    if (early_data_file != NULL) {
+        if ((in = BIO_new_file(early_data_file, "r")) == NULL) {
+            BIO_printf(bio_err, "Cannot open early data file\n");
+            goto end;
+        }
+        len = bio_to_mem(&load.early_data, SSL3_RT_MAX_PLAIN_LENGTH, in);
+        BIO_free(in);
+        if (len <= 0) {
+            BIO_printf(bio_err, "Error reading early data file\n");
+            goto end;
+        }
+        load.early_data_len = len;
+    }
+
+    if (BIO_sock_init() != 1
+            || !BIO_lookup_ex(host, port, BIO_LOOKUP_CLIENT, family,
+                              SOCK_STREAM, 0, &res)) {
+        ERR_print_errors(bio_err);
+        goto end;
+    }
+    load.addr = BIO_ADDRINFO_address(res);
+    load.family = BIO_ADDRINFO_family(res);
+    load.ctx = ctx;
+    load.servername = servername;
+    load.conns = nconns;
+    load.resume = resume;
+    pthread_mutex_init(&load.lock, NULL);
+
+    threads = app_malloc(sizeof(*threads) * nthreads, "load threads");
+    start = load_now_us();
+    load.end_us = start + (uint64_t)secs * 1000000;
+    for (started = 0; started < nthreads; started++)
+        if (pthread_create(&threads[started], NULL, load_worker, NULL) != 0)
+            break;
+    if (started < nthreads) {
+        BIO_printf(bio_err, "Can't start thread %d: %s\n", started,
+                   strerror(errno));
+        load.end_us = start;
+    }
+    for (i = 0; i < started; i++)
+        pthread_join(threads[i], NULL);
+    elapsed = (load_now_us() - start) / 1e6;
+    pthread_mutex_destroy(&load.lock);
+
+    BIO_printf(bio_c_out, "%d threads x %d connections for %.1f s\n",
+               started, nconns, elapsed);
+    for (i = 0; i < (int)load.num_combos; i++) {
+        LOAD_COMBO *lc = &load.combos[i];
+
+        BIO_printf(bio_c_out, "%s, %s:\n",
+                   lc->group != NULL ? lc->group : "default groups",
+                   lc->sigalg != NULL ? lc->sigalg : "default sigalgs");
+        load_print_samples(bio_c_out, "full", &lc->full, elapsed);
+        load_print_samples(bio_c_out, "resumed", &lc->resumed, elapsed);
+        if (lc->early_sent != 0)
+            BIO_printf(bio_c_out, "  early data accepted %lu of %lu times\n",
+                       lc->early_accepted, lc->early_sent);
+        if (lc->failed != 0)
+            BIO_printf(bio_c_out, "  %lu connections failed\n", lc->failed);
+    }
+    ret = started == nthreads;
+
+ end:
+    if (load.combos != NULL) {
+        for (i = 0; i < (int)load.num_combos; i++) {
+            for (j = 0; j < load.combos[i].num_sess; j++)
+                SSL_SESSION_free(load.combos[i].sess[j]);
+            OPENSSL_free(load.combos[i].full.us);
+            OPENSSL_free(load.combos[i].resumed.us);
+        }
+        OPENSSL_free(load.combos);
+    }
+    OPENSSL_free(load.early_data);
+    OPENSSL_free(threads);
+    BIO_ADDRINFO_free(res);
+    sk_OPENSSL_STRING_free(gl);
+    sk_OPENSSL_STRING_free(sl);
+    OPENSSL_free(gbuf);
+    OPENSSL_free(sbuf);
     return ret;
 }
+#endif
+
+#ifndef OPENSSL_NO_EC
+/* Prints the groups |ctx| offers and, where it was measured, their cost */
+static void print_group_prefs(BIO *out, SSL_CTX *ctx)
+{
+    int i, ngroups, *groups;
+    const char *gname;
+    long cost;
+
+    ngroups = SSL_CTX_get1_groups(ctx, NULL);
+    if (ngroups <= 0)
+        return;
+    groups = app_malloc(ngroups * sizeof(int), "groups to print");
+    SSL_CTX_get1_groups(ctx, groups);
+
+    BIO_puts(out, "Groups in order of preference:\n");
+    for (i = 0; i < ngroups; i++) {
+        if (groups[i] & TLSEXT_nid_unknown) {
+            BIO_printf(out, "    0x%04X\n", groups[i] & 0xFFFF);
+            continue;
+        }
+        if ((gname = EC_curve_nid2nist(groups[i])) == NULL)
+            gname = OBJ_nid2sn(groups[i]);
+        cost = SSL_CTX_get_group_cost(ctx, groups[i]);
+        if (cost > 0)
+            BIO_printf(out, "    %-24s %10.1f us per key exchange\n", gname,
+                       cost / 1000.0);
+        else
+            BIO_printf(out, "    %s\n", gname);
+    }
+    OPENSSL_free(groups);
+}
+#endif
 
 static void print_stuff(BIO *bio, SSL *s, int full)
 {
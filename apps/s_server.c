@@ -58,6 +58,22 @@ typedef unsigned int u_int;
 #ifdef CHARSET_EBCDIC
 #include <openssl/ebcdic.h>
 #endif
+
+/* -threads runs an event loop per thread on POSIX systems */
+#if defined(OPENSSL_THREADS) && !defined(OPENSSL_SYS_WINDOWS) \
+    && !defined(OPENSSL_SYS_VMS)
+# define S_SERVER_THREADS
+# include <errno.h>
+# include <fcntl.h>
+# include <pthread.h>
+# include <time.h>
+# ifdef __linux
+#  define S_SERVER_EPOLL
+#  include <sys/epoll.h>
+# else
+#  include <poll.h>
+# endif
+#endif
 #include "internal/sockets.h"
 
 static int not_resumable_sess_cb(SSL *s, int is_forward_secure);
@@ -67,6 +83,7 @@ static int rev_body(int s, int stype, int prot, unsigned char *context);
 static void close_accept_socket(void);
 static int init_ssl_connection(SSL *s);
 static void print_stats(BIO *bp, SSL_CTX *ctx);
+static void print_handshake_stats(BIO *bp, SSL_CTX *ctx);
 static int generate_session_id(SSL *ssl, unsigned char *id,
                                unsigned int *id_len);
 static void init_session_cache_ctx(SSL_CTX *sctx);
@@ -75,6 +92,10 @@ static void free_sessions(void);
 static DH *load_dh_param(const char *dhfile);
 #endif
 static void print_connection_info(SSL *con);
+#ifdef S_SERVER_THREADS
+static int mt_server(int nthreads, int sock, int naccept,
+                     unsigned char *context);
+#endif
 
 static const int bufsize = 16 * 1024;
 static int accept_socket = -1;
@@ -97,6 +118,8 @@ static int s_msg = 0;
 static int s_quiet = 0;
 static int s_ign_eof = 0;
 static int s_brief = 0;
+static int s_hs_stats = 0;
+static int s_threads = 0;
 
 static char *keymatexportlabel = NULL;
 static int keymatexportlen = 20;
@@ -737,12 +760,13 @@ static int not_resumable_sess_cb(SSL *s, int is_forward_secure)
 typedef enum OPTION_choice {
     OPT_ERR = -1, OPT_EOF = 0, OPT_HELP, OPT_ENGINE,
     OPT_4, OPT_6, OPT_ACCEPT, OPT_PORT, OPT_UNIX, OPT_UNLINK, OPT_NACCEPT,
+    OPT_THREADS,
     OPT_VERIFY, OPT_NAMEOPT, OPT_UPPER_V_VERIFY, OPT_CONTEXT, OPT_CERT, OPT_CRL,
     OPT_CRL_DOWNLOAD, OPT_SERVERINFO, OPT_CERTFORM, OPT_KEY, OPT_KEYFORM,
     OPT_PASS, OPT_CERT_CHAIN, OPT_DHPARAM, OPT_DCERTFORM, OPT_DCERT,
     OPT_DKEYFORM, OPT_DPASS, OPT_DKEY, OPT_DCERT_CHAIN, OPT_NOCERT,
     OPT_CAPATH, OPT_NOCAPATH, OPT_CHAINCAPATH, OPT_VERIFYCAPATH, OPT_NO_CACHE,
-    OPT_EXT_CACHE, OPT_CRLFORM, OPT_VERIFY_RET_ERROR, OPT_VERIFY_QUIET,
+    OPT_EXT_CACHE, OPT_HS_STATS, OPT_CRLFORM, OPT_VERIFY_RET_ERROR, OPT_VERIFY_QUIET,
     OPT_BUILD_CHAIN, OPT_CAFILE, OPT_NOCAFILE, OPT_CHAINCAFILE,
     OPT_VERIFYCAFILE, OPT_NBIO, OPT_NBIO_TEST, OPT_IGN_EOF, OPT_NO_IGN_EOF,
     OPT_DEBUG, OPT_TLSEXTDEBUG, OPT_STATUS, OPT_STATUS_VERBOSE,
@@ -787,6 +811,8 @@ const OPTIONS s_server_options[] = {
     {"cert", OPT_CERT, '<', "Certificate file to use; default is " TEST_CERT},
     {"nameopt", OPT_NAMEOPT, 's', "Various certificate name options"},
     {"naccept", OPT_NACCEPT, 'p', "Terminate after #num connections"},
+    {"threads", OPT_THREADS, 'p',
+     "Serve HTTP requests on #num event loop threads"},
     {"serverinfo", OPT_SERVERINFO, 's',
      "PEM serverinfo file for certificate"},
     {"certform", OPT_CERTFORM, 'F',
@@ -857,6 +883,8 @@ const OPTIONS s_server_options[] = {
     {"no_cache", OPT_NO_CACHE, '-', "Disable session cache"},
     {"ext_cache", OPT_EXT_CACHE, '-',
      "Disable internal cache, setup and use external cache"},
+    {"stats", OPT_HS_STATS, '-',
+     "Time handshake phases and print them with the statistics"},
     {"CRLform", OPT_CRLFORM, 'F', "CRL format (PEM or DER) PEM is default"},
     {"verify_return_error", OPT_VERIFY_RET_ERROR, '-',
      "Close connection on verification error"},
@@ -1173,6 +1201,9 @@ int s_server_main(int argc, char *argv[])
         case OPT_NACCEPT:
             naccept = atol(opt_arg());
             break;
+        case OPT_THREADS:
+            s_threads = atoi(opt_arg());
+            break;
         case OPT_VERIFY:
             s_server_verify = SSL_VERIFY_PEER | SSL_VERIFY_CLIENT_ONCE;
             verify_args.depth = atoi(opt_arg());
@@ -1271,6 +1302,9 @@ int s_server_main(int argc, char *argv[])
         case OPT_EXT_CACHE:
             ext_cache = 1;
             break;
+        case OPT_HS_STATS:
+            s_hs_stats = 1;
+            break;
         case OPT_CRLFORM:
             if (!opt_format(opt_arg(), OPT_FMT_PEMDER, &crl_format))
                 goto opthelp;
@@ -1643,6 +1677,18 @@ int s_server_main(int argc, char *argv[])
                    "Can't use -early_data in combination with -www, -WWW, -HTTP, or -rev\n");
         goto end;
     }
+    if (s_threads > 0) {
+#ifdef S_SERVER_THREADS
+        if (socket_type != SOCK_STREAM || www > 0 || rev || ext_cache) {
+            BIO_printf(bio_err,
+                       "Can't use -threads in combination with DTLS, -www, -WWW, -HTTP, -rev or -ext_cache\n");
+            goto end;
+        }
+#else
+        BIO_printf(bio_err, "-threads is not supported on this platform\n");
+        goto end;
+#endif
+    }
 
 #ifndef OPENSSL_NO_SCTP
     if (protocol == IPPROTO_SCTP) {
@@ -1839,6 +1885,10 @@ int s_server_main(int argc, char *argv[])
 
     if (state)
         SSL_CTX_set_info_callback(ctx, apps_ssl_info_callback);
+    if (s_hs_stats && !SSL_CTX_enable_handshake_stats(ctx)) {
+        ERR_print_errors(bio_err);
+        goto end;
+    }
     if (no_cache)
         SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
     else if (ext_cache)
@@ -2162,6 +2212,20 @@ int s_server_main(int argc, char *argv[])
     if (socket_family == AF_UNIX
         && unlink_unix_path)
         unlink(host);
+#endif
+#ifdef S_SERVER_THREADS
+    if (s_threads > 0) {
+        if (do_listen(&accept_socket, host, port, socket_family, socket_type,
+                      protocol, bio_s_out)) {
+            mt_server(s_threads, accept_socket, naccept, context);
+            BIO_closesocket(accept_socket);
+            accept_socket = -1;
+# ifdef AF_UNIX
+            if (socket_family == AF_UNIX)
+                unlink(host);
+# endif
+        }
+    } else
 #endif
     do_server(&accept_socket, host, port, socket_family, socket_type, protocol,
               server_cb, context, naccept, bio_s_out);
@@ -2208,6 +2272,45 @@ int s_server_main(int argc, char *argv[])
     return ret;
 }
 
+static void print_handshake_stats(BIO *bio, SSL_CTX *ssl_ctx)
+{
+    static const char *phases[SSL_HS_PHASE_NUM] = {
+        "handshake", "keygen", "encaps", "decaps", "sign", "verify",
+        "chain verify", "transcript"
+    };
+    uint64_t count, v;
+    int i, j;
+
+    BIO_printf(bio, "%-12s %8s %12s %12s %12s\n", "phase", "count",
+               "avg wall us", "avg cpu us", "max wall us");
+    for (i = 0; i < SSL_HS_PHASE_NUM; i++) {
+        count = SSL_CTX_get_handshake_stats(ssl_ctx, i, SSL_HS_STAT_COUNT);
+        if (count == 0)
+            continue;
+        BIO_printf(bio, "%-12s %8llu %12llu %12llu %12llu\n", phases[i],
+                   (unsigned long long)count,
+                   (unsigned long long)(SSL_CTX_get_handshake_stats(ssl_ctx,
+                                            i, SSL_HS_STAT_WALL_US) / count),
+                   (unsigned long long)(SSL_CTX_get_handshake_stats(ssl_ctx,
+                                            i, SSL_HS_STAT_CPU_US) / count),
+                   (unsigned long long)SSL_CTX_get_handshake_stats(ssl_ctx,
+                                            i, SSL_HS_STAT_MAX_WALL_US));
+        /* The wall time histogram, as "<upper bound in us>:count" */
+        BIO_printf(bio, "%12s", "");
+        for (j = 0; j < SSL_HS_STAT_BUCKETS; j++) {
+            v = SSL_CTX_get_handshake_stats(ssl_ctx, i, SSL_HS_STAT_BUCKET(j));
+            if (v == 0)
+                continue;
+            if (j < SSL_HS_STAT_BUCKETS - 1)
+                BIO_printf(bio, " <%lu:%llu", 1UL << j, (unsigned long long)v);
+            else
+                BIO_printf(bio, " >=%lu:%llu", 1UL << (j - 1),
+                           (unsigned long long)v);
+        }
+        BIO_printf(bio, "\n");
+    }
+}
+
 static void print_stats(BIO *bio, SSL_CTX *ssl_ctx)
 {
     BIO_printf(bio, "%4ld items in the session cache\n",
@@ -2234,8 +2337,593 @@ static void print_stats(BIO *bio, SSL_CTX *ssl_ctx)
     BIO_printf(bio, "%4ld cache full overflows (%ld allowed)\n",
                SSL_CTX_sess_cache_full(ssl_ctx),
                SSL_CTX_sess_get_cache_size(ssl_ctx));
+    if (s_hs_stats)
+        print_handshake_stats(bio, ssl_ctx);
+}
+
+#ifdef S_SERVER_THREADS
+/*-
+ * -threads: a shared SSL_CTX served by several threads, each running an
+ * event loop over non-blocking sockets, epoll on Linux and poll elsewhere.
+ * All threads accept from the same listening socket. A connection is
+ * handshaken, reads one HTTP request and gets one response before it is
+ * closed: the server statistics for "GET /stats", a line naming the
+ * protocol and cipher otherwise.
+ */
+
+# define MT_IN          1
+# define MT_OUT         2
+# define MT_MAX_EVENTS  64
+# define MT_POLL_MS     100
+# define MT_REQ_MAX     4096
+# define MT_BUCKETS     24
+
+enum {
+    MT_HANDSHAKE, MT_REQUEST, MT_RESPONSE, MT_SHUTDOWN, MT_CLOSED
+};
+
+typedef struct mt_conn_st {
+    SSL *ssl;
+    int fd;
+    int state;
+    /* The socket events the connection waits for, MT_IN and MT_OUT */
+    int events;
+    uint64_t accept_us;
+    char req[MT_REQ_MAX];
+    size_t reqlen;
+    char *resp;
+    size_t resplen;
+    size_t respoff;
+    struct mt_conn_st *next;
+} MT_CONN;
+
+typedef struct {
+    pthread_t thread;
+    int started;
+    int listen_fd;
+    unsigned char *context;
+# ifdef S_SERVER_EPOLL
+    int epfd;
+# else
+    struct pollfd *pfds;
+    MT_CONN **pconns;
+    size_t pcap;
+# endif
+    MT_CONN *conns;
+    /* Closed connections, freed at the end of each round of events */
+    MT_CONN *closed;
+} MT_WORKER;
+
+static struct {
+    pthread_mutex_t lock;
+    uint64_t start_us;
+    uint64_t report_us;
+    unsigned long report_handshakes;
+    unsigned long accepted;
+    unsigned long handshakes;
+    unsigned long resumed;
+    unsigned long failed;
+    unsigned long requests;
+    /* Time from accept to the end of the handshake, bucket i < 2^i us */
+    unsigned long latency[MT_BUCKETS];
+    /* Connections left to accept, or -1 */
+    int naccept;
+} mt_stats;
+
+static uint64_t mt_now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int mt_set_nonblock(int fd)
+{
+    int flags = fcntl(fd, F_GETFL);
+
+    return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+/* Whether the last connection has been accepted */
+static int mt_done(void)
+{
+    int done;
+
+    pthread_mutex_lock(&mt_stats.lock);
+    done = mt_stats.naccept == 0;
+    pthread_mutex_unlock(&mt_stats.lock);
+    return done;
+}
+
+static void mt_handshake_done(MT_CONN *c, int ok)
+{
+    uint64_t us = mt_now_us() - c->accept_us;
+    int b = 0;
+
+    while (b < MT_BUCKETS - 1 && us >= ((uint64_t)1 << b))
+        b++;
+    pthread_mutex_lock(&mt_stats.lock);
+    if (ok) {
+        mt_stats.handshakes++;
+        if (SSL_session_reused(c->ssl))
+            mt_stats.resumed++;
+        mt_stats.latency[b]++;
+    } else {
+        mt_stats.failed++;
+    }
+    pthread_mutex_unlock(&mt_stats.lock);
+}
+
+static void mt_print_stats(BIO *bio, int report)
+{
+    uint64_t now = mt_now_us();
+    double secs, since;
+    unsigned long handshakes, since_handshakes;
+    int i;
+
+    pthread_mutex_lock(&mt_stats.lock);
+    secs = (now - mt_stats.start_us) / 1e6;
+    since = (now - mt_stats.report_us) / 1e6;
+    handshakes = mt_stats.handshakes;
+    since_handshakes = handshakes - mt_stats.report_handshakes;
+    if (report) {
+        mt_stats.report_us = now;
+        mt_stats.report_handshakes = handshakes;
+    }
+    BIO_printf(bio, "%4d threads, up %.1f s\n", s_threads, secs);
+    BIO_printf(bio, "%4lu connections accepted\n", mt_stats.accepted);
+    BIO_printf(bio, "%4lu handshakes (%lu resumed), %lu failed\n",
+               handshakes, mt_stats.resumed, mt_stats.failed);
+    BIO_printf(bio, "%4lu requests\n", mt_stats.requests);
+    BIO_printf(bio, "%.1f handshakes/s, %.1f since the last report\n",
+               secs > 0 ? handshakes / secs : 0.0,
+               since > 0 ? since_handshakes / since : 0.0);
+    BIO_printf(bio, "Handshake time from accept:\n");
+    for (i = 0; i < MT_BUCKETS; i++)
+        if (mt_stats.latency[i] != 0)
+            BIO_printf(bio, "  < %8lu us %8lu\n", 1UL << i,
+                       mt_stats.latency[i]);
+    pthread_mutex_unlock(&mt_stats.lock);
+}
+
+/* Prepares the response to the request in |c| */
+static int mt_respond(MT_CONN *c)
+{
+    static const char header[] =
+        "HTTP/1.0 200 ok\r\nContent-type: text/plain\r\n\r\n";
+    BIO *bio;
+    char *data;
+    long len;
+    int ret = 0;
+
+    pthread_mutex_lock(&mt_stats.lock);
+    mt_stats.requests++;
+    pthread_mutex_unlock(&mt_stats.lock);
+
+    if ((bio = BIO_new(BIO_s_mem())) == NULL)
+        return 0;
+    BIO_puts(bio, header);
+    if (strncmp(c->req, "GET /stats", 10) == 0) {
+        mt_print_stats(bio, 1);
+        print_stats(bio, ctx);
+    } else {
+        BIO_printf(bio, "%s %s\n", SSL_get_version(c->ssl),
+                   SSL_get_cipher_name(c->ssl));
+    }
+    len = BIO_get_mem_data(bio, &data);
+    if (len > 0 && (c->resp = OPENSSL_malloc(len)) != NULL) {
+        memcpy(c->resp, data, len);
+        c->resplen = len;
+        ret = 1;
+    }
+    BIO_free(bio);
+    return ret;
 }
 
+/* Makes the event loop of |w| wait for |events| on the socket of |c| */
+static int mt_want(MT_WORKER *w, MT_CONN *c, int events)
+{
+# ifdef S_SERVER_EPOLL
+    struct epoll_event ev;
+
+    if (c->events == events)
+        return 1;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = ((events & MT_IN) ? EPOLLIN : 0)
+                | ((events & MT_OUT) ? EPOLLOUT : 0);
+    ev.data.ptr = c;
+    if (epoll_ctl(w->epfd, EPOLL_CTL_MOD, c->fd, &ev) == -1)
+        return 0;
+# endif
+    c->events = events;
+    return 1;
+}
+
+/*
+ * Makes the event loop of |w| wait for the async job of |c| to finish
+ * instead of for its socket
+ */
+static int mt_want_async(MT_WORKER *w, MT_CONN *c)
+{
+# ifdef S_SERVER_EPOLL
+    OSSL_ASYNC_FD *fds;
+    size_t numadd, numdel, i;
+    struct epoll_event ev;
+
+    if (!mt_want(w, c, 0)
+            || !SSL_get_changed_async_fds(c->ssl, NULL, &numadd, NULL,
+                                          &numdel))
+        return 0;
+    if (numadd + numdel == 0)
+        return 1;
+    fds = app_malloc(sizeof(*fds) * (numadd + numdel), "async fds");
+    if (!SSL_get_changed_async_fds(c->ssl, fds, &numadd, fds + numadd,
+                                   &numdel)) {
+        OPENSSL_free(fds);
+        return 0;
+    }
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = c;
+    for (i = 0; i < numadd; i++)
+        epoll_ctl(w->epfd, EPOLL_CTL_ADD, fds[i], &ev);
+    for (i = numadd; i < numadd + numdel; i++)
+        epoll_ctl(w->epfd, EPOLL_CTL_DEL, fds[i], NULL);
+    OPENSSL_free(fds);
+    return 1;
+# else
+    /* The poll set is rebuilt from SSL_get_all_async_fds() every round */
+    return mt_want(w, c, 0);
+# endif
+}
+
+/*
+ * Takes |c| as far as it goes without blocking. Returns 0 once it is to be
+ * closed.
+ */
+static int mt_drive(MT_WORKER *w, MT_CONN *c)
+{
+    size_t n;
+    int ret;
+
+    for (;;) {
+        switch (c->state) {
+        case MT_HANDSHAKE:
+            ret = SSL_do_handshake(c->ssl);
+            if (ret == 1) {
+                mt_handshake_done(c, 1);
+                c->state = MT_REQUEST;
+                continue;
+            }
+            break;
+        case MT_REQUEST:
+            ret = SSL_read_ex(c->ssl, c->req + c->reqlen,
+                              sizeof(c->req) - 1 - c->reqlen, &n);
+            if (ret == 1) {
+                c->reqlen += n;
+                c->req[c->reqlen] = '\0';
+                if (strstr(c->req, "\r\n\r\n") == NULL
+                        && strstr(c->req, "\n\n") == NULL
+                        && c->reqlen < sizeof(c->req) - 1)
+                    continue;
+                if (!mt_respond(c))
+                    return 0;
+                c->state = MT_RESPONSE;
+                continue;
+            }
+            break;
+        case MT_RESPONSE:
+            ret = SSL_write_ex(c->ssl, c->resp + c->respoff,
+                               c->resplen - c->respoff, &n);
+            if (ret == 1) {
+                c->respoff += n;
+                if (c->respoff == c->resplen)
+                    c->state = MT_SHUTDOWN;
+                continue;
+            }
+            break;
+        case MT_SHUTDOWN:
+            /* Send our close_notify, without waiting for that of the peer */
+            ret = SSL_shutdown(c->ssl);
+            if (ret >= 0)
+                return 0;
+            break;
+        default:
+            return 0;
+        }
+
+        switch (SSL_get_error(c->ssl, ret)) {
+        case SSL_ERROR_WANT_READ:
+            return mt_want(w, c, MT_IN);
+        case SSL_ERROR_WANT_WRITE:
+            return mt_want(w, c, MT_OUT);
+        case SSL_ERROR_WANT_ASYNC:
+            return mt_want_async(w, c);
+        default:
+            if (c->state == MT_HANDSHAKE)
+                mt_handshake_done(c, 0);
+            return 0;
+        }
+    }
+}
+
+static void mt_close(MT_WORKER *w, MT_CONN *c)
+{
+    MT_CONN **pc;
+# ifdef S_SERVER_EPOLL
+    OSSL_ASYNC_FD *fds;
+    size_t numfds, i;
+
+    /* The socket leaves the epoll set when closed, async fds do not */
+    if (SSL_waiting_for_async(c->ssl)
+            && SSL_get_all_async_fds(c->ssl, NULL, &numfds) && numfds > 0) {
+        fds = app_malloc(sizeof(*fds) * numfds, "async fds");
+        if (SSL_get_all_async_fds(c->ssl, fds, &numfds))
+            for (i = 0; i < numfds; i++)
+                epoll_ctl(w->epfd, EPOLL_CTL_DEL, fds[i], NULL);
+        OPENSSL_free(fds);
+    }
+# endif
+    for (pc = &w->conns; *pc != c; pc = &(*pc)->next)
+        continue;
+    *pc = c->next;
+    c->next = w->closed;
+    w->closed = c;
+    c->state = MT_CLOSED;
+    BIO_closesocket(c->fd);
+    c->fd = -1;
+}
+
+static void mt_free_closed(MT_WORKER *w)
+{
+    MT_CONN *c;
+
+    while ((c = w->closed) != NULL) {
+        w->closed = c->next;
+        SSL_free(c->ssl);
+        OPENSSL_free(c->resp);
+        OPENSSL_free(c);
+    }
+}
+
+/* Accepts the connections waiting on the listening socket */
+static void mt_accept(MT_WORKER *w)
+{
+    MT_CONN *c;
+    int fd, i;
+# ifdef S_SERVER_EPOLL
+    struct epoll_event ev;
+# endif
+
+    for (i = 0; i < MT_MAX_EVENTS; i++) {
+        pthread_mutex_lock(&mt_stats.lock);
+        if (mt_stats.naccept == 0) {
+            pthread_mutex_unlock(&mt_stats.lock);
+            return;
+        }
+        fd = accept(w->listen_fd, NULL, NULL);
+        if (fd != -1) {
+            mt_stats.accepted++;
+            if (mt_stats.naccept > 0)
+                mt_stats.naccept--;
+        }
+        pthread_mutex_unlock(&mt_stats.lock);
+        if (fd == -1)
+            return;
+
+        if (!mt_set_nonblock(fd)) {
+            BIO_closesocket(fd);
+            continue;
+        }
+        BIO_set_tcp_ndelay(fd, 1);
+        c = app_malloc(sizeof(*c), "connection");
+        memset(c, 0, sizeof(*c));
+        c->fd = fd;
+        c->state = MT_HANDSHAKE;
+        c->events = MT_IN;
+        c->accept_us = mt_now_us();
+        if ((c->ssl = SSL_new(ctx)) == NULL
+                || (w->context != NULL
+                    && !SSL_set_session_id_context(c->ssl, w->context,
+                                                   strlen((char *)w->context)))
+                || !SSL_set_fd(c->ssl, fd)) {
+            ERR_print_errors(bio_err);
+            SSL_free(c->ssl);
+            OPENSSL_free(c);
+            BIO_closesocket(fd);
+            continue;
+        }
+        SSL_set_accept_state(c->ssl);
+        if (async)
+            SSL_set_mode(c->ssl, SSL_MODE_ASYNC);
+        c->next = w->conns;
+        w->conns = c;
+# ifdef S_SERVER_EPOLL
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.ptr = c;
+        if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+            mt_close(w, c);
+            continue;
+        }
+# endif
+        /* The ClientHello has often arrived already */
+        if (!mt_drive(w, c))
+            mt_close(w, c);
+    }
+}
+
+# ifdef S_SERVER_EPOLL
+static void mt_wait(MT_WORKER *w)
+{
+    struct epoll_event ev[MT_MAX_EVENTS];
+    MT_CONN *c;
+    int i, n;
+
+    n = epoll_wait(w->epfd, ev, MT_MAX_EVENTS, MT_POLL_MS);
+    for (i = 0; i < n; i++) {
+        c = ev[i].data.ptr;
+        if (c == NULL)
+            mt_accept(w);
+        else if (c->state != MT_CLOSED && !mt_drive(w, c))
+            mt_close(w, c);
+    }
+}
+# else
+/* Adds |fd| to the poll set of |w|, for |c| or the listening socket */
+static void mt_poll_add(MT_WORKER *w, size_t *n, int fd, short events,
+                        MT_CONN *c)
+{
+    struct pollfd *pfds;
+    MT_CONN **pconns;
+    size_t cap;
+
+    if (*n == w->pcap) {
+        cap = w->pcap == 0 ? 64 : w->pcap * 2;
+        if ((pfds = OPENSSL_realloc(w->pfds, cap * sizeof(*pfds))) == NULL)
+            return;
+        w->pfds = pfds;
+        if ((pconns = OPENSSL_realloc(w->pconns, cap * sizeof(*pconns)))
+                == NULL)
+            return;
+        w->pconns = pconns;
+        w->pcap = cap;
+    }
+    w->pfds[*n].fd = fd;
+    w->pfds[*n].events = events;
+    w->pfds[*n].revents = 0;
+    w->pconns[(*n)++] = c;
+}
+
+static void mt_wait(MT_WORKER *w)
+{
+    OSSL_ASYNC_FD fds[8];
+    MT_CONN *c;
+    size_t n = 0, i, numfds;
+
+    if (!mt_done())
+        mt_poll_add(w, &n, w->listen_fd, POLLIN, NULL);
+    for (c = w->conns; c != NULL; c = c->next) {
+        if (c->events == 0) {
+            numfds = OSSL_NELEM(fds);
+            if (SSL_get_all_async_fds(c->ssl, NULL, &numfds)
+                    && numfds <= OSSL_NELEM(fds)
+                    && SSL_get_all_async_fds(c->ssl, fds, &numfds))
+                for (i = 0; i < numfds; i++)
+                    mt_poll_add(w, &n, fds[i], POLLIN, c);
+        } else {
+            mt_poll_add(w, &n, c->fd,
+                        ((c->events & MT_IN) ? POLLIN : 0)
+                        | ((c->events & MT_OUT) ? POLLOUT : 0), c);
+        }
+    }
+    if (poll(w->pfds, n, MT_POLL_MS) <= 0)
+        return;
+    for (i = 0; i < n; i++) {
+        if (w->pfds[i].revents == 0)
+            continue;
+        c = w->pconns[i];
+        if (c == NULL)
+            mt_accept(w);
+        else if (c->state != MT_CLOSED && !mt_drive(w, c))
+            mt_close(w, c);
+    }
+}
+# endif
+
+static void *mt_worker(void *arg)
+{
+    MT_WORKER *w = arg;
+
+    /* Serve until the last connection has been accepted and closed */
+    while (w->conns != NULL || !mt_done()) {
+        mt_wait(w);
+        mt_free_closed(w);
+    }
+    return NULL;
+}
+
+static int mt_server(int nthreads, int sock, int naccept,
+                     unsigned char *context)
+{
+    MT_WORKER *workers;
+    int i, ret = 0;
+# ifdef S_SERVER_EPOLL
+    struct epoll_event ev;
+# endif
+
+    if (!mt_set_nonblock(sock)) {
+        BIO_printf(bio_err, "Can't make the listening socket non-blocking\n");
+        return 0;
+    }
+    memset(&mt_stats, 0, sizeof(mt_stats));
+    pthread_mutex_init(&mt_stats.lock, NULL);
+    mt_stats.start_us = mt_stats.report_us = mt_now_us();
+    mt_stats.naccept = naccept;
+
+    workers = app_malloc(sizeof(*workers) * nthreads, "workers");
+    memset(workers, 0, sizeof(*workers) * nthreads);
+    for (i = 0; i < nthreads; i++) {
+        MT_WORKER *w = &workers[i];
+
+        w->listen_fd = sock;
+        w->context = context;
+# ifdef S_SERVER_EPOLL
+        if ((w->epfd = epoll_create1(0)) == -1)
+            break;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+#  ifdef EPOLLEXCLUSIVE
+        /* Wake one thread per incoming connection, not all of them */
+        ev.events |= EPOLLEXCLUSIVE;
+#  endif
+        ev.data.ptr = NULL;
+        if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, sock, &ev) == -1) {
+            close(w->epfd);
+            break;
+        }
+# endif
+        if (pthread_create(&w->thread, NULL, mt_worker, w) != 0) {
+# ifdef S_SERVER_EPOLL
+            close(w->epfd);
+# endif
+            break;
+        }
+        w->started = 1;
+    }
+    if (i < nthreads) {
+        BIO_printf(bio_err, "Can't start thread %d: %s\n", i, strerror(errno));
+        /* Let the threads already started finish their connections */
+        pthread_mutex_lock(&mt_stats.lock);
+        mt_stats.naccept = 0;
+        pthread_mutex_unlock(&mt_stats.lock);
+    } else {
+        BIO_printf(bio_s_out, "Serving on %d threads\n", nthreads);
+        (void)BIO_flush(bio_s_out);
+        ret = 1;
+    }
+
+    for (i = 0; i < nthreads; i++) {
+        MT_WORKER *w = &workers[i];
+
+        if (!w->started)
+            continue;
+        pthread_join(w->thread, NULL);
+# ifdef S_SERVER_EPOLL
+        close(w->epfd);
+# else
+        OPENSSL_free(w->pfds);
+        OPENSSL_free(w->pconns);
+# endif
+    }
+    OPENSSL_free(workers);
+    mt_print_stats(bio_s_out, 0);
+    pthread_mutex_destroy(&mt_stats.lock);
+    return ret;
+}
+#endif
+
 static long int count_reads_callback(BIO *bio, int cmd, const char *argp,
                                      int argi, long int argl, long int ret)
 {
@@ -184,32 +184,18 @@ out:
 }
 
 /*
- * do_server - helper routine to perform a server operation
- * @accept_sock: pointer to storage of resulting socket.
- * @host: the host name or path (for AF_UNIX) to connect to.
- * @port: the port to connect to (ignored for AF_UNIX).
- * @family: desired socket family, may be AF_INET, AF_INET6, AF_UNIX or
- *  AF_UNSPEC
- * @type: socket type, must be SOCK_STREAM or SOCK_DGRAM
- * @cb: pointer to a function that receives the accepted socket and
- *  should perform the communication with the connecting client.
- * @context: pointer to memory that's passed verbatim to the cb function.
- * @naccept: number of times an incoming connect should be accepted.  If -1,
- *  unlimited number.
+ * do_listen - create a socket listening to host:port, or if family ==
+ * AF_UNIX, to the path found in host, and report it on bio_s_out
+ * @sock: pointer to where the listening socket is stored
  *
- * This will create a socket and use it to listen to a host:port, or if
- * family == AF_UNIX, to the path found in host, then start accepting
- * incoming connections and run cb on the resulting socket.
+ * The other arguments are those of do_server().
  *
- * 0 on failure, something other on success.
+ * 0 on failure, 1 on success.
  */
-int do_server(int *accept_sock, const char *host, const char *port,
-              int family, int type, int protocol, do_server_cb cb,
-              unsigned char *context, int naccept, BIO *bio_s_out)
+int do_listen(int *sock, const char *host, const char *port,
+              int family, int type, int protocol, BIO *bio_s_out)
 {
     int asock = 0;
-    int sock;
-    int i;
     BIO_ADDRINFO *res = NULL;
     const BIO_ADDRINFO *next;
     int sock_family, sock_type, sock_protocol, sock_port;
@@ -328,6 +314,48 @@ int do_server(int *accept_sock, const char *host, const char *port,
         (void)BIO_flush(bio_s_out);
     }
 
+    *sock = asock;
+    ret = 1;
+ end:
+# ifdef AF_UNIX
+    if (!ret && family == AF_UNIX)
+        unlink(host);
+# endif
+    return ret;
+}
+
+/*
+ * do_server - helper routine to perform a server operation
+ * @accept_sock: pointer to storage of resulting socket.
+ * @host: the host name or path (for AF_UNIX) to connect to.
+ * @port: the port to connect to (ignored for AF_UNIX).
+ * @family: desired socket family, may be AF_INET, AF_INET6, AF_UNIX or
+ *  AF_UNSPEC
+ * @type: socket type, must be SOCK_STREAM or SOCK_DGRAM
+ * @cb: pointer to a function that receives the accepted socket and
+ *  should perform the communication with the connecting client.
+ * @context: pointer to memory that's passed verbatim to the cb function.
+ * @naccept: number of times an incoming connect should be accepted.  If -1,
+ *  unlimited number.
+ *
+ * This will create a socket and use it to listen to a host:port, or if
+ * family == AF_UNIX, to the path found in host, then start accepting
+ * incoming connections and run cb on the resulting socket.
+ *
+ * 0 on failure, something other on success.
+ */
+int do_server(int *accept_sock, const char *host, const char *port,
+              int family, int type, int protocol, do_server_cb cb,
+              unsigned char *context, int naccept, BIO *bio_s_out)
+{
+    int asock = 0;
+    int sock;
+    int i;
+    int ret = 0;
+
+    if (!do_listen(&asock, host, port, family, type, protocol, bio_s_out))
+        return 0;
+
     if (accept_sock != NULL)
         *accept_sock = asock;
     for (;;) {
@@ -23,14 +23,23 @@
 #include "s_apps.h"
 #include <openssl/err.h>
 #include <internal/sockets.h>
+#include <oqs/oqs.h>
 #if !defined(OPENSSL_SYS_MSDOS)
 # include OPENSSL_UNISTD
 #endif
+#if !defined(_WIN32)
+# include <sys/time.h>
+#endif
 
 #define SSL_CONNECT_NAME        "localhost:4433"
 
 #define SECONDS 30
 #define SECONDSSTR "30"
+/* Seconds per group and signature algorithm in -inproc mode */
+#define INPROC_SECONDS 1
+#define INPROC_SECONDSSTR "1"
+/* Large enough for most PQ flights in one write */
+#define INPROC_BUFSIZE (64 * 1024)
 
 static SSL *doConnection(SSL *scon, const char *host, SSL_CTX *ctx);
 
@@ -47,7 +56,7 @@ typedef enum OPTION_choice {
     OPT_CONNECT, OPT_CIPHER, OPT_CIPHERSUITES, OPT_CERT, OPT_NAMEOPT, OPT_KEY,
     OPT_CAPATH, OPT_CAFILE, OPT_NOCAPATH, OPT_NOCAFILE, OPT_NEW, OPT_REUSE,
     OPT_BUGS, OPT_VERIFY, OPT_TIME, OPT_SSL3, OPT_CURVES,
-    OPT_WWW
+    OPT_WWW, OPT_INPROC
 } OPTION_CHOICE;
 
 const OPTIONS s_time_options[] = {
@@ -72,12 +81,15 @@ const OPTIONS s_time_options[] = {
     {"bugs", OPT_BUGS, '-', "Turn on SSL bug compatibility"},
     {"verify", OPT_VERIFY, 'p',
      "Turn on peer certificate verification, set depth"},
-    {"time", OPT_TIME, 'p', "Seconds to collect data, default " SECONDSSTR},
+    {"time", OPT_TIME, 'p', "Seconds to collect data, default " SECONDSSTR
+     " (" INPROC_SECONDSSTR " per test with -inproc)"},
     {"www", OPT_WWW, 's', "Fetch specified page from the site"},
 #ifndef OPENSSL_NO_SSL3
     {"ssl3", OPT_SSL3, '-', "Just use SSLv3"},
 #endif
     {"curves", OPT_CURVES, 's', "Curves to be announced by client"},
+    {"inproc", OPT_INPROC, '-',
+     "Time in-process handshakes for all groups and signature algorithms"},
     {NULL}
 };
 
@@ -89,6 +101,275 @@ static double tm_Time_F(int s)
     return app_tminterval(s, 1);
 }
 
+/*-
+ * In-process mode: client and server run in this process over a BIO pair,
+ * for every group and signature algorithm.
+ */
+
+static double inproc_now(void)
+{
+#if defined(_WIN32)
+    return GetTickCount() / 1000.0;
+#else
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+#endif
+}
+
+static int inproc_cmp(const void *a, const void *b)
+{
+    double da = *(const double *)a, db = *(const double *)b;
+
+    return da < db ? -1 : da > db;
+}
+
+/* Generates a key of type |nid| and a self-signed certificate for it */
+static int inproc_make_cert(int nid, EVP_PKEY **pkey, X509 **cert)
+{
+    EVP_PKEY_CTX *pctx = EVP_PKEY_CTX_new_id(nid, NULL);
+    const EVP_MD *md = NULL;
+    X509_NAME *name;
+    int mdnid, ok = 0;
+
+    *pkey = NULL;
+    *cert = NULL;
+    if (pctx == NULL || EVP_PKEY_keygen_init(pctx) <= 0)
+        goto end;
+    if (nid == EVP_PKEY_EC
+        && EVP_PKEY_CTX_set_ec_paramgen_curve_nid(pctx,
+                                                  NID_X9_62_prime256v1) <= 0)
+        goto end;
+    if (EVP_PKEY_keygen(pctx, pkey) <= 0)
+        goto end;
+    if (EVP_PKEY_get_default_digest_nid(*pkey, &mdnid) > 0
+        && mdnid != NID_undef)
+        md = EVP_get_digestbynid(mdnid);
+
+    if ((*cert = X509_new()) == NULL
+        || !X509_set_version(*cert, 2)
+        || !ASN1_INTEGER_set(X509_get_serialNumber(*cert), 1)
+        || !set_cert_times(*cert, NULL, NULL, 1)
+        || (name = X509_get_subject_name(*cert)) == NULL
+        || !X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                       (const unsigned char *)"localhost",
+                                       -1, -1, 0)
+        || !X509_set_issuer_name(*cert, name)
+        || !X509_set_pubkey(*cert, *pkey)
+        || !X509_sign(*cert, *pkey, md))
+        goto end;
+    ok = 1;
+
+ end:
+    EVP_PKEY_CTX_free(pctx);
+    if (!ok) {
+        EVP_PKEY_free(*pkey);
+        X509_free(*cert);
+        *pkey = NULL;
+        *cert = NULL;
+    }
+    return ok;
+}
+
+/*
+ * Runs one full handshake between new connections of |cctx| and |sctx| and
+ * adds the bytes sent in both directions to |bytes|.
+ */
+static int inproc_handshake(SSL_CTX *cctx, SSL_CTX *sctx, long *bytes)
+{
+    SSL *clnt = SSL_new(cctx), *srvr = SSL_new(sctx);
+    BIO *cbio = NULL, *sbio = NULL;
+    int cdone = 0, sdone = 0, i, r, ok = 0;
+
+    if (clnt == NULL || srvr == NULL
+        || !BIO_new_bio_pair(&cbio, INPROC_BUFSIZE, &sbio, INPROC_BUFSIZE))
+        goto end;
+    SSL_set_bio(clnt, cbio, cbio);
+    SSL_set_bio(srvr, sbio, sbio);
+
+    /* Each round moves at least one flight, unless the handshake is stuck */
+    for (i = 0; i < 1000 && !(cdone && sdone); i++) {
+        if (!cdone) {
+            if ((r = SSL_connect(clnt)) == 1)
+                cdone = 1;
+            else if (SSL_get_error(clnt, r) != SSL_ERROR_WANT_READ
+                     && SSL_get_error(clnt, r) != SSL_ERROR_WANT_WRITE)
+                goto end;
+        }
+        if (!sdone) {
+            if ((r = SSL_accept(srvr)) == 1)
+                sdone = 1;
+            else if (SSL_get_error(srvr, r) != SSL_ERROR_WANT_READ
+                     && SSL_get_error(srvr, r) != SSL_ERROR_WANT_WRITE)
+                goto end;
+        }
+    }
+    if (cdone && sdone) {
+        *bytes += (long)(BIO_number_written(cbio) + BIO_number_written(sbio));
+        ok = 1;
+    }
+
+ end:
+    SSL_free(clnt);
+    SSL_free(srvr);
+    return ok;
+}
+
+/* Times handshakes using |group| for |seconds| and prints one result line */
+static int inproc_run(SSL_CTX *cctx, SSL_CTX *sctx, const char *signame,
+                      const char *group, int seconds)
+{
+    double *lat = NULL, start, now, finish, total;
+    size_t nlat = 0, maxlat = 0;
+    long bytes = 0;
+    int ok = 0;
+
+    if (!SSL_CTX_set1_groups_list(cctx, group)
+        || !SSL_CTX_set1_groups_list(sctx, group))
+        goto end;
+
+    start = now = inproc_now();
+    finish = start + seconds;
+    while (now < finish) {
+        double before = now;
+
+        if (nlat == maxlat) {
+            double *tmp = OPENSSL_realloc(lat, 2 * (maxlat + 128)
+                                                    * sizeof(*lat));
+
+            if (tmp == NULL)
+                goto end;
+            lat = tmp;
+            maxlat = 2 * (maxlat + 128);
+        }
+        if (!inproc_handshake(cctx, sctx, &bytes))
+            goto end;
+        now = inproc_now();
+        lat[nlat++] = now - before;
+    }
+    total = now - start;
+    qsort(lat, nlat, sizeof(*lat), inproc_cmp);
+    printf("%-28s %-24s %10.1f %10ld %9.3f %9.3f\n", signame, group,
+           nlat / total, bytes / (long)nlat,
+           lat[nlat / 2] * 1e3, lat[(nlat * 99) / 100] * 1e3);
+    ok = 1;
+
+ end:
+    if (!ok) {
+        printf("%-28s %-24s failed\n", signame, group);
+        ERR_print_errors(bio_err);
+    }
+    fflush(stdout);
+    OPENSSL_free(lat);
+    return ok;
+}
+
+/*
+ * Sweeps every TLS 1.3 group, or those in the colon separated |groups|,
+ * against an ECDSA P-256 baseline and every enabled OQS signature
+ * algorithm.
+ */
+static int inproc_sweep(const char *groups, const char *ciphersuites,
+                        int seconds)
+{
+    static const char *classical_groups[] = {
+        "X25519", "P-256", "X448", "P-521", "P-384"
+    };
+    STACK_OF(OPENSSL_STRING) *grouplist = sk_OPENSSL_STRING_new_null();
+    int *kem_nids = get_oqssl_kem_nids(), *sig_nids = get_oqssl_sig_nids();
+    char *groupsdup = NULL, *p, *sep;
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    EVP_PKEY *pkey = NULL;
+    X509 *cert = NULL;
+    int i, j, errors = 0, ret = 0;
+
+    if (grouplist == NULL || kem_nids == NULL || sig_nids == NULL)
+        goto end;
+    if (groups != NULL) {
+        groupsdup = OPENSSL_strdup(groups);
+        for (p = groupsdup; p != NULL; p = sep) {
+            if ((sep = strchr(p, ':')) != NULL)
+                *sep++ = '\0';
+            if (*p != '\0' && !sk_OPENSSL_STRING_push(grouplist, p))
+                goto end;
+        }
+    } else {
+        for (i = 0; i < (int)OSSL_NELEM(classical_groups); i++)
+            if (!sk_OPENSSL_STRING_push(grouplist,
+                                        (char *)classical_groups[i]))
+                goto end;
+        for (i = 0; i < OQS_OPENSSL_KEM_algs_length; i++) {
+            int hybrid = oqs_kem_hybrid_nid(kem_nids[i], NULL);
+
+            if (!OQS_KEM_alg_is_enabled(get_oqs_alg_name(kem_nids[i])))
+                continue;
+            if (!sk_OPENSSL_STRING_push(grouplist,
+                                        (char *)OBJ_nid2sn(kem_nids[i])))
+                goto end;
+            if (hybrid != NID_undef
+                && !sk_OPENSSL_STRING_push(grouplist,
+                                           (char *)OBJ_nid2sn(hybrid)))
+                goto end;
+        }
+    }
+
+    printf("%-28s %-24s %10s %10s %9s %9s\n", "signature", "group",
+           "hs/s", "bytes/hs", "p50 ms", "p99 ms");
+    /* Index -1 is the classical baseline */
+    for (i = -1; i < OQS_OPENSSL_SIG_algs_length; i++) {
+        int nid = i < 0 ? EVP_PKEY_EC : sig_nids[i];
+        const char *signame = i < 0 ? "ecdsap256" : OBJ_nid2sn(nid);
+
+        if (i >= 0 && !OQS_SIG_alg_is_enabled(get_oqs_alg_name(nid)))
+            continue;
+        if (!inproc_make_cert(nid, &pkey, &cert)) {
+            printf("%-28s %-24s failed\n", signame, "-");
+            ERR_print_errors(bio_err);
+            errors++;
+            continue;
+        }
+        if ((cctx = SSL_CTX_new(TLS_client_method())) == NULL
+            || (sctx = SSL_CTX_new(TLS_server_method())) == NULL
+            || !SSL_CTX_set_min_proto_version(cctx, TLS1_3_VERSION)
+            || !SSL_CTX_set_min_proto_version(sctx, TLS1_3_VERSION)
+            || (ciphersuites != NULL
+                && (!SSL_CTX_set_ciphersuites(cctx, ciphersuites)
+                    || !SSL_CTX_set_ciphersuites(sctx, ciphersuites)))
+            || !SSL_CTX_use_certificate(sctx, cert)
+            || !SSL_CTX_use_PrivateKey(sctx, pkey))
+            goto end;
+        /* Every handshake is a full one */
+        SSL_CTX_set_session_cache_mode(cctx, SSL_SESS_CACHE_OFF);
+        SSL_CTX_set_session_cache_mode(sctx, SSL_SESS_CACHE_OFF);
+
+        for (j = 0; j < sk_OPENSSL_STRING_num(grouplist); j++)
+            if (!inproc_run(cctx, sctx, signame,
+                            sk_OPENSSL_STRING_value(grouplist, j), seconds))
+                errors++;
+
+        SSL_CTX_free(cctx);
+        SSL_CTX_free(sctx);
+        EVP_PKEY_free(pkey);
+        X509_free(cert);
+        cctx = sctx = NULL;
+        pkey = NULL;
+        cert = NULL;
+    }
+    ret = errors == 0;
+
+ end:
+    if (!ret)
+        ERR_print_errors(bio_err);
+    SSL_CTX_free(cctx);
+    SSL_CTX_free(sctx);
+    EVP_PKEY_free(pkey);
+    X509_free(cert);
+    sk_OPENSSL_STRING_free(grouplist);
+    OPENSSL_free(groupsdup);
+    return ret;
+}
+
 int s_time_main(int argc, char **argv)
 {
     char buf[1024 * 8];
@@ -101,7 +382,8 @@ int s_time_main(int argc, char **argv)
     char *curves = NULL;
     double totalTime = 0.0;
     int noCApath = 0, noCAfile = 0;
-    int maxtime = SECONDS, nConn = 0, perform = 3, ret = 1, i, st_bugs = 0;
+    int maxtime = 0, nConn = 0, perform = 3, ret = 1, i, st_bugs = 0;
+    int inproc = 0;
     long bytes_read = 0, finishtime = 0;
     OPTION_CHOICE o;
     int max_version = 0, ver, buf_len;
@@ -185,12 +467,23 @@ int s_time_main(int argc, char **argv)
         case OPT_CURVES:
             curves = opt_arg();
             break;
+        case OPT_INPROC:
+            inproc = 1;
+            break;
         }
     }
     argc = opt_num_rest();
     if (argc != 0)
         goto opthelp;
 
+    if (inproc) {
+        ret = inproc_sweep(curves, ciphersuites,
+                           maxtime > 0 ? maxtime : INPROC_SECONDS) ? 0 : 1;
+        goto end;
+    }
+    if (maxtime == 0)
+        maxtime = SECONDS;
+
     if (cipher == NULL)
         cipher = getenv("SSL_CIPHER");
 
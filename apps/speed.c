@@ -17,6 +17,7 @@
 #define EdDSA_SECONDS   10
 #define OQSKEM_SECONDS  10
 #define OQSSIG_SECONDS  10
+#define SCRYPT_SECONDS  3
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -107,9 +108,19 @@ extern const char *OQSKEM_options(void);
 #ifndef OPENSSL_NO_OQSSIG
 # include <oqs/oqs.h>
 extern const char *OQSSIG_options(void);
-extern int oqs_size(const EVP_PKEY *pkey);
 #endif
 #include <openssl/modes.h>
+#if defined(OPENSSL_THREADS) && !defined(OPENSSL_SYS_WINDOWS) \
+    && (!defined(OPENSSL_NO_OQSKEM) || !defined(OPENSSL_NO_OQSSIG))
+# include <pthread.h>
+# define OQS_SPEED_THREADS
+#endif
+#if (defined(__GNUC__) || defined(__clang__)) \
+    && (defined(__x86_64__) || defined(__i386__))
+# include <cpuid.h>
+# include <x86intrin.h>
+# define SPEED_X86
+#endif
 
 #ifndef HAVE_FORK
 # if defined(OPENSSL_SYS_VMS) || defined(OPENSSL_SYS_WINDOWS) || defined(OPENSSL_SYS_VXWORKS)
@@ -138,12 +149,52 @@ typedef struct openssl_speed_sec_st {
     int eddsa;
     int oqskem;
     int oqssig;
+    int scrypt;
 } openssl_speed_sec_t;
 
 static volatile int run = 0;
 
 static int mr = 0;
 static int usertime = 1;
+#ifndef OPENSSL_NO_LOCK_STATS
+/* Lock creation sites listed at the end of the run */
+# define LOCK_STATS_TOP 10
+static int multi_child = -1;
+#endif
+/* Number of threads running each OQS KEM and signature benchmark */
+static int oqs_threads = 1;
+#ifndef OPENSSL_NO_SCRYPT
+/* Number of threads computing the lanes of each scrypt derivation */
+static int kdf_threads = 1;
+#endif
+
+/* Format of the results written to standard output */
+#define OUTPUT_TEXT     0
+#define OUTPUT_JSON     1
+#define OUTPUT_CSV      2
+static int output_format = OUTPUT_TEXT;
+/* Maximum number of strings returned by lib_options() */
+#define LIB_OPTIONS_MAX 8
+
+/* One measured operation, as written by -json and -csv */
+typedef struct {
+    const char *type;
+    const char *name;
+    const char *op;
+    int bytes;                  /* message size, 0 if not applicable */
+    unsigned int bits;          /* key size, 0 if not applicable */
+    double per_sec;             /* operations per second */
+    double cycles;              /* TSC ticks per operation, 0 if unknown */
+    size_t public_key;          /* sizes of the OQS keys and messages */
+    size_t secret_key;
+    size_t ciphertext;
+    size_t shared_secret;
+    size_t signature;
+    const char *impl;           /* the OQS implementation, NULL if none */
+} SPEED_ROW;
+
+/* TSC ticks between the last Time_F(START) and Time_F(STOP), 0 if unknown */
+static uint64_t tsc_ticks = 0;
 
 #ifndef OPENSSL_NO_MD2
 static int EVP_Digest_MD2_loop(void *args);
@@ -203,6 +254,15 @@ static int EdDSA_verify_loop(void *args);
 #endif
 
 static double Time_F(int s);
+static void tsc_interval(int s);
+static void output_begin(void);
+static void output_row(const SPEED_ROW *row);
+static void output_end(void);
+#if !defined(OPENSSL_NO_OQSKEM) || !defined(OPENSSL_NO_OQSSIG)
+static void print_oqs_impl(int nid);
+#endif
+static double tsc_per_op(long count);
+static int lib_options(const char **opts);
 static void print_message(const char *s, long num, int length, int tm);
 static void pkey_print_message(const char *str, const char *str2,
                                long num, unsigned int bits, int sec);
@@ -213,9 +273,6 @@ static int do_multi(int multi, int size_num);
 
 static const int lengths_list[] = {
   16, 64, 256, 1024, 8 * 1024, 16 * 1024
-#ifndef OPENSSL_NO_OQSSIG
-  , 100 * 1024 // OQS note: need larger buffer for OQS signatures
-#endif
 };
 static const int *lengths = lengths_list;
 
@@ -239,6 +296,7 @@ static double Time_F(int s)
     double ret = app_tminterval(s, usertime);
     if (s == STOP)
         alarm(0);
+    tsc_interval(s);
     return ret;
 }
 
@@ -285,12 +343,14 @@ static double Time_F(int s)
             TerminateThread(thr, 0);
         CloseHandle(thr);
     }
+    tsc_interval(s);
 
     return ret;
 }
 #else
 static double Time_F(int s)
 {
+    tsc_interval(s);
     return app_tminterval(s, usertime);
 }
 #endif
@@ -317,7 +377,8 @@ typedef enum OPTION_choice {
     OPT_ERR = -1, OPT_EOF = 0, OPT_HELP,
     OPT_ELAPSED, OPT_EVP, OPT_DECRYPT, OPT_ENGINE, OPT_MULTI,
     OPT_MR, OPT_MB, OPT_MISALIGN, OPT_ASYNCJOBS, OPT_R_ENUM,
-    OPT_PRIMES, OPT_SECONDS, OPT_BYTES, OPT_AEAD
+    OPT_PRIMES, OPT_SECONDS, OPT_BYTES, OPT_AEAD, OPT_THREADS,
+    OPT_KDF_THREADS, OPT_JSON, OPT_CSV
 } OPTION_CHOICE;
 
 const OPTIONS speed_options[] = {
@@ -332,12 +393,22 @@ const OPTIONS speed_options[] = {
     {"mb", OPT_MB, '-',
      "Enable (tls1>=1) multi-block mode on EVP-named cipher"},
     {"mr", OPT_MR, '-', "Produce machine readable output"},
+    {"json", OPT_JSON, '-', "Write the results and the build details as JSON"},
+    {"csv", OPT_CSV, '-', "Write the results as CSV"},
 #ifndef NO_FORK
     {"multi", OPT_MULTI, 'p', "Run benchmarks in parallel"},
 #endif
 #ifndef OPENSSL_NO_ASYNC
     {"async_jobs", OPT_ASYNCJOBS, 'p',
      "Enable async mode and start specified number of jobs"},
+#endif
+#ifdef OQS_SPEED_THREADS
+    {"threads", OPT_THREADS, 'p',
+     "Run OQS KEM and signature benchmarks on specified number of threads"},
+#endif
+#ifndef OPENSSL_NO_SCRYPT
+    {"kdf_threads", OPT_KDF_THREADS, 'p',
+     "Compute the lanes of each scrypt derivation on up to that many threads"},
 #endif
     OPT_R_OPTIONS,
 #ifndef OPENSSL_NO_ENGINE
@@ -611,16 +682,54 @@ static double eddsa_results[EdDSA_NUM][2];    /* 2 ops: sign then verify */
 
 #ifndef OPENSSL_NO_OQSKEM
 # define OQSKEM_NUM      OQS_OPENSSL_KEM_algs_length 
-static OPT_PAIR oqskem_choices[OQSKEM_NUM];
-static double oqskem_results[OQSKEM_NUM][3];
+/* Each KEM is followed by its ECDH hybrids, OQSKEM_NUM entries apart */
+# define OQSKEM_ALL      (2 * OQSKEM_NUM)
+static OPT_PAIR oqskem_choices[OQSKEM_ALL];
+static int oqskem_curves[OQSKEM_ALL];       /* curve of a hybrid KEM */
+static double oqskem_results[OQSKEM_ALL][3];  /* keypair, encaps, decaps */
+static double oqskem_cycles[OQSKEM_ALL][3];
 # endif
 
 #ifndef OPENSSL_NO_OQSSIG
 # define OQSSIG_NUM      OQS_OPENSSL_SIG_algs_length 
 static OPT_PAIR oqssig_choices[OQSSIG_NUM];
-static double oqssig_results[OQSSIG_NUM][3]; // generate,sign,verify
+static double oqssig_results[OQSSIG_NUM][2];  /* sign, verify */
+static double oqssig_cycles[OQSSIG_NUM][2];
 # endif
 
+#ifndef OPENSSL_NO_SCRYPT
+/* N, r and p swept one at a time, around the N = 2^14, r = 8, p = 1 of RFC 7914 */
+static OPT_PAIR scrypt_choices[] = {
+    {"scrypt-N14-r8-p1", 0},
+    {"scrypt-N15-r8-p1", 1},
+    {"scrypt-N16-r8-p1", 2},
+    {"scrypt-N17-r8-p1", 3},
+    {"scrypt-N18-r8-p1", 4},
+    {"scrypt-N14-r4-p1", 5},
+    {"scrypt-N14-r16-p1", 6},
+    {"scrypt-N14-r32-p1", 7},
+    {"scrypt-N14-r8-p2", 8},
+    {"scrypt-N14-r8-p4", 9},
+    {"scrypt-N14-r8-p8", 10},
+    {"scrypt-N14-r8-p16", 11}
+};
+# define SCRYPT_NUM      OSSL_NELEM(scrypt_choices)
+
+static const struct {
+    unsigned int log2_N;
+    uint64_t r, p;
+} scrypt_params[SCRYPT_NUM] = {
+    {14, 8, 1}, {15, 8, 1}, {16, 8, 1}, {17, 8, 1}, {18, 8, 1},
+    {14, 4, 1}, {14, 16, 1}, {14, 32, 1},
+    {14, 8, 2}, {14, 8, 4}, {14, 8, 8}, {14, 8, 16}
+};
+
+/* Enough for the largest of the above with every lane computed at once */
+# define SCRYPT_SPEED_MAXMEM     ((uint64_t)1 << 30)
+
+static double scrypt_results[SCRYPT_NUM][1];  /* 1 op: derivation */
+#endif
+
 #ifndef SIGALRM
 # define COND(d) (count < (d))
 # define COUNT(d) (d)
@@ -653,10 +762,27 @@ typedef struct loopargs_st {
     unsigned char *secret_b;
     size_t outlen[EC_NUM];
 #endif
+#ifndef OPENSSL_NO_OQSKEM
+    const OQS_KEM *oqskem;
+    unsigned char *oqskem_pk;
+    unsigned char *oqskem_sk;
+    unsigned char *oqskem_ct;
+    unsigned char *oqskem_ss_e;
+    unsigned char *oqskem_ss_d;
+# ifndef OPENSSL_NO_EC
+    /* Classical half of a hybrid KEM */
+    EVP_PKEY_CTX *oqskem_ec_gen;
+    EVP_PKEY *oqskem_ec_key;
+    EVP_PKEY *oqskem_ec_peer;
+# endif
+#endif
 #ifndef OPENSSL_NO_OQSSIG
     EC_KEY *oqssig[OQSSIG_NUM];
     EVP_MD_CTX *oqssig_ctx[OQSSIG_NUM];
     size_t oqs_outlen[OQSSIG_NUM];
+    /* Sized for exactly one signature of the algorithm */
+    unsigned char *oqssig_buf[OQSSIG_NUM];
+    size_t oqssig_maxlen[OQSSIG_NUM];
 #endif
     EVP_CIPHER_CTX *ctx;
     HMAC_CTX *hctx;
@@ -1267,6 +1393,174 @@ static int EdDSA_verify_loop(void *args)
 }
 #endif                          /* OPENSSL_NO_EC */
 
+#ifndef OPENSSL_NO_OQSKEM
+static long oqskem_c[OQSKEM_ALL][3];
+
+/* Whether entry |num| of oqskem_choices exists and liboqs supports it */
+static int OQSKEM_enabled(const int *nids, unsigned int num)
+{
+    return oqskem_choices[num].name[0] != '\0'
+           && OQS_KEM_alg_is_enabled(get_oqs_alg_name(nids[num % OQSKEM_NUM]));
+}
+
+# ifndef OPENSSL_NO_EC
+/* ECDH as done by libssl for the classical half of a hybrid key share */
+static int OQSKEM_ecdh(EVP_PKEY *key, EVP_PKEY *peer, unsigned char *secret)
+{
+    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new(key, NULL);
+    size_t secretlen = MAX_ECDH_SIZE;
+    int ret;
+
+    ret = ctx != NULL
+          && EVP_PKEY_derive_init(ctx) > 0
+          && EVP_PKEY_derive_set_peer(ctx, peer) > 0
+          && EVP_PKEY_derive(ctx, secret, &secretlen) > 0;
+    EVP_PKEY_CTX_free(ctx);
+    return ret;
+}
+# endif
+
+static int OQSKEM_keypair_loop(void *args)
+{
+    loopargs_t *tempargs = *(loopargs_t **) args;
+    int count;
+
+    for (count = 0; COND(oqskem_c[testnum][0]); count++) {
+        if (OQS_KEM_keypair(tempargs->oqskem, tempargs->oqskem_pk,
+                            tempargs->oqskem_sk) != OQS_SUCCESS)
+            goto err;
+# ifndef OPENSSL_NO_EC
+        if (tempargs->oqskem_ec_gen != NULL) {
+            EVP_PKEY *key = NULL;
+
+            if (EVP_PKEY_keygen(tempargs->oqskem_ec_gen, &key) <= 0)
+                goto err;
+            EVP_PKEY_free(key);
+        }
+# endif
+    }
+    return count;
+ err:
+    BIO_printf(bio_err, "OQS KEM keypair failure\n");
+    ERR_print_errors(bio_err);
+    return -1;
+}
+
+static int OQSKEM_encaps_loop(void *args)
+{
+    loopargs_t *tempargs = *(loopargs_t **) args;
+    int count;
+
+    for (count = 0; COND(oqskem_c[testnum][1]); count++) {
+        if (OQS_KEM_encaps(tempargs->oqskem, tempargs->oqskem_ct,
+                           tempargs->oqskem_ss_e,
+                           tempargs->oqskem_pk) != OQS_SUCCESS)
+            goto err;
+# ifndef OPENSSL_NO_EC
+        if (tempargs->oqskem_ec_gen != NULL) {
+            EVP_PKEY *key = NULL;
+            int st;
+
+            /* The server generates its share and derives with the client's */
+            if (EVP_PKEY_keygen(tempargs->oqskem_ec_gen, &key) <= 0)
+                goto err;
+            st = OQSKEM_ecdh(key, tempargs->oqskem_ec_key, tempargs->secret_a);
+            EVP_PKEY_free(key);
+            if (!st)
+                goto err;
+        }
+# endif
+    }
+    return count;
+ err:
+    BIO_printf(bio_err, "OQS KEM encaps failure\n");
+    ERR_print_errors(bio_err);
+    return -1;
+}
+
+static int OQSKEM_decaps_loop(void *args)
+{
+    loopargs_t *tempargs = *(loopargs_t **) args;
+    int count;
+
+    for (count = 0; COND(oqskem_c[testnum][2]); count++) {
+        if (OQS_KEM_decaps(tempargs->oqskem, tempargs->oqskem_ss_d,
+                           tempargs->oqskem_ct,
+                           tempargs->oqskem_sk) != OQS_SUCCESS)
+            goto err;
+# ifndef OPENSSL_NO_EC
+        if (tempargs->oqskem_ec_gen != NULL
+            && !OQSKEM_ecdh(tempargs->oqskem_ec_key, tempargs->oqskem_ec_peer,
+                            tempargs->secret_b))
+            goto err;
+# endif
+    }
+    return count;
+ err:
+    BIO_printf(bio_err, "OQS KEM decaps failure\n");
+    ERR_print_errors(bio_err);
+    return -1;
+}
+
+/*
+ * Allocates the buffers of one benchmark thread for |kem|, combined with
+ * ECDH over |curve| for a hybrid, and runs one keypair and encaps so that
+ * each loop has valid input.
+ */
+static int OQSKEM_setup(loopargs_t *tempargs, const OQS_KEM *kem, int curve)
+{
+    tempargs->oqskem = kem;
+    tempargs->oqskem_pk = app_malloc(kem->length_public_key, "OQS public key");
+    tempargs->oqskem_sk = app_malloc(kem->length_secret_key, "OQS secret key");
+    tempargs->oqskem_ct = app_malloc(kem->length_ciphertext, "OQS ciphertext");
+    tempargs->oqskem_ss_e = app_malloc(kem->length_shared_secret,
+                                       "OQS shared secret");
+    tempargs->oqskem_ss_d = app_malloc(kem->length_shared_secret,
+                                       "OQS shared secret");
+# ifndef OPENSSL_NO_EC
+    if (curve != NID_undef) {
+        tempargs->oqskem_ec_gen = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, NULL);
+        if (tempargs->oqskem_ec_gen == NULL
+            || EVP_PKEY_keygen_init(tempargs->oqskem_ec_gen) <= 0
+            || EVP_PKEY_CTX_set_ec_paramgen_curve_nid(tempargs->oqskem_ec_gen,
+                                                      curve) <= 0
+            || EVP_PKEY_keygen(tempargs->oqskem_ec_gen,
+                               &tempargs->oqskem_ec_key) <= 0
+            || EVP_PKEY_keygen(tempargs->oqskem_ec_gen,
+                               &tempargs->oqskem_ec_peer) <= 0)
+            return 0;
+    }
+# endif
+    return OQS_KEM_keypair(kem, tempargs->oqskem_pk,
+                           tempargs->oqskem_sk) == OQS_SUCCESS
+           && OQS_KEM_encaps(kem, tempargs->oqskem_ct, tempargs->oqskem_ss_e,
+                             tempargs->oqskem_pk) == OQS_SUCCESS;
+}
+
+static void OQSKEM_cleanup(loopargs_t *tempargs)
+{
+    const OQS_KEM *kem = tempargs->oqskem;
+
+    if (kem == NULL)
+        return;
+    OPENSSL_free(tempargs->oqskem_pk);
+    OPENSSL_clear_free(tempargs->oqskem_sk, kem->length_secret_key);
+    OPENSSL_free(tempargs->oqskem_ct);
+    OPENSSL_clear_free(tempargs->oqskem_ss_e, kem->length_shared_secret);
+    OPENSSL_clear_free(tempargs->oqskem_ss_d, kem->length_shared_secret);
+    tempargs->oqskem = NULL;
+    tempargs->oqskem_pk = tempargs->oqskem_sk = tempargs->oqskem_ct = NULL;
+    tempargs->oqskem_ss_e = tempargs->oqskem_ss_d = NULL;
+# ifndef OPENSSL_NO_EC
+    EVP_PKEY_CTX_free(tempargs->oqskem_ec_gen);
+    EVP_PKEY_free(tempargs->oqskem_ec_key);
+    EVP_PKEY_free(tempargs->oqskem_ec_peer);
+    tempargs->oqskem_ec_gen = NULL;
+    tempargs->oqskem_ec_key = tempargs->oqskem_ec_peer = NULL;
+# endif
+}
+#endif
+
 #ifndef OPENSSL_NO_OQSSIG
 static long oqssig_c[OQSSIG_NUM][2];
 static int OQS_sign_loop(void *args)
@@ -1274,13 +1568,13 @@ static int OQS_sign_loop(void *args)
     loopargs_t *tempargs = *(loopargs_t **) args;
     unsigned char *buf = tempargs->buf;
     EVP_MD_CTX **oqsctx = tempargs->oqssig_ctx;
-    unsigned char *oqssig = tempargs->buf2;
+    unsigned char *oqssig = tempargs->oqssig_buf[testnum];
     size_t sigsize_store = tempargs->sigsize;
     int ret, count;
 
     for (count = 0; COND(oqssig_c[testnum][0]); count++) {
         /* OQS algs destroy this so we must retain it for repeated runs */
-        sigsize_store = tempargs->sigsize;
+        sigsize_store = tempargs->oqssig_maxlen[testnum];
 
         ret = EVP_DigestSign(oqsctx[testnum], oqssig, &sigsize_store, buf, 20);
         if (ret == 0) {
@@ -1300,7 +1594,7 @@ static int OQS_verify_loop(void *args)
     loopargs_t *tempargs = *(loopargs_t **) args;
     unsigned char *buf = tempargs->buf;
     EVP_MD_CTX **oqsctx = tempargs->oqssig_ctx;
-    unsigned char *oqssig = tempargs->buf2;
+    unsigned char *oqssig = tempargs->oqssig_buf[testnum];
     size_t oqssigsize = tempargs->sigsize;
     int ret, count;
 
@@ -1317,6 +1611,31 @@ static int OQS_verify_loop(void *args)
 }
 #endif
 
+#ifndef OPENSSL_NO_SCRYPT
+static long scrypt_c[SCRYPT_NUM][1];
+static int scrypt_loop(void *args)
+{
+    loopargs_t *tempargs = *(loopargs_t **) args;
+    unsigned char *salt = tempargs->buf;
+    unsigned char *key = tempargs->buf2;
+    int count;
+
+    for (count = 0; COND(scrypt_c[testnum][0]); count++) {
+        if (!EVP_PBE_scrypt_threads("password", 8, salt, 16,
+                                    (uint64_t)1 << scrypt_params[testnum].log2_N,
+                                    scrypt_params[testnum].r,
+                                    scrypt_params[testnum].p,
+                                    SCRYPT_SPEED_MAXMEM, key, 64,
+                                    kdf_threads)) {
+            BIO_printf(bio_err, "scrypt failure\n");
+            ERR_print_errors(bio_err);
+            count = -1;
+            break;
+        }
+    }
+    return count;
+}
+#endif
 
 static int run_benchmark(int async_jobs,
                          int (*loop_function) (void *), loopargs_t * loopargs)
@@ -1469,6 +1788,66 @@ static int run_benchmark(int async_jobs,
     return error ? -1 : total_op_count;
 }
 
+#ifdef OQS_SPEED_THREADS
+typedef struct oqs_speed_thread_st {
+    pthread_t thread;
+    int (*loop_function) (void *);
+    loopargs_t *loopargs;
+    int count;
+} oqs_speed_thread_t;
+
+static void *oqs_speed_thread(void *arg)
+{
+    oqs_speed_thread_t *t = arg;
+
+    t->count = t->loop_function((void *)&t->loopargs);
+    return NULL;
+}
+#endif
+
+/*
+ * Runs an OQS benchmark on |oqs_threads| threads, each with its own loopargs
+ * entry, and returns the sum of their operation counts. All threads stop
+ * together when the alarm clears |run|.
+ */
+static int run_oqs_benchmark(int async_jobs,
+                             int (*loop_function) (void *),
+                             loopargs_t * loopargs)
+{
+#ifdef OQS_SPEED_THREADS
+    oqs_speed_thread_t *threads;
+    int i, started, total_op_count = 0;
+
+    if (oqs_threads <= 1)
+        return run_benchmark(async_jobs, loop_function, loopargs);
+
+    threads = app_malloc(oqs_threads * sizeof(*threads), "benchmark threads");
+    for (started = 0; started < oqs_threads; started++) {
+        threads[started].loop_function = loop_function;
+        threads[started].loopargs = loopargs + started;
+        threads[started].count = 0;
+        if (pthread_create(&threads[started].thread, NULL, oqs_speed_thread,
+                           &threads[started]) != 0) {
+            BIO_printf(bio_err, "Failure creating benchmark thread\n");
+            total_op_count = -1;
+            run = 0;
+            break;
+        }
+    }
+    for (i = 0; i < started; i++) {
+        pthread_join(threads[i].thread, NULL);
+        if (threads[i].count < 0)
+            total_op_count = -1;
+        else if (total_op_count >= 0)
+            total_op_count += threads[i].count;
+    }
+    OPENSSL_free(threads);
+    return total_op_count;
+#else
+    return run_benchmark(async_jobs, loop_function, loopargs);
+#endif
+}
+
 int speed_main(int argc, char **argv)
 {
     ENGINE *e = NULL;
@@ -1495,7 +1874,8 @@ int speed_main(int argc, char **argv)
 #endif
     openssl_speed_sec_t seconds = { SECONDS, RSA_SECONDS, DSA_SECONDS,
                                     ECDSA_SECONDS, ECDH_SECONDS,
-                                    EdDSA_SECONDS, OQSKEM_SECONDS, OQSSIG_SECONDS };
+                                    EdDSA_SECONDS, OQSKEM_SECONDS, OQSSIG_SECONDS,
+                                    SCRYPT_SECONDS };
 
     /* What follows are the buffers and key material. */
 #ifndef OPENSSL_NO_RC5
@@ -1633,17 +2013,13 @@ int speed_main(int argc, char **argv)
     OPENSSL_assert(OSSL_NELEM(test_curves) >= EC_NUM);
     OPENSSL_assert(OSSL_NELEM(test_ed_curves) >= EdDSA_NUM);
 #endif                          /* ndef OPENSSL_NO_EC */
+#ifndef OPENSSL_NO_SCRYPT
+    int scrypt_doit[SCRYPT_NUM] = { 0 };
+#endif
 
 #ifndef OPENSSL_NO_OQSKEM
-    const char *oqskem_method_names[OQSKEM_NUM];
-    OQS_KEM *oqskem_kem[OQSKEM_NUM];
-    unsigned char *oqskem_secret_key;
-    unsigned char *oqskem_public_key;
-    unsigned char *oqskem_ciphertext;
-    unsigned char *oqskem_shared_secret_e;
-    unsigned char *oqskem_shared_secret_d;
-    long oqskem_c[OQSKEM_NUM][3];
-    int oqskem_doit[OQSKEM_NUM] = { 0 };
+    const char *oqskem_method_names[OQSKEM_ALL];
+    int oqskem_doit[OQSKEM_ALL] = { 0 };
 
     /* populate oqskem_choices */
     int oqskemcnt = 0;
@@ -1651,9 +2027,22 @@ int speed_main(int argc, char **argv)
     for (oqskemcnt = 0; oqskemcnt < OQSKEM_NUM; ++oqskemcnt) {
         oqskem_choices[oqskemcnt].name = OBJ_nid2sn(oqssl_kem_nids_list[oqskemcnt]);
         oqskem_choices[oqskemcnt].retval = oqskemcnt;
-        oqskem_kem[oqskemcnt] = NULL;
+        oqskem_curves[oqskemcnt] = NID_undef;
         oqskem_method_names[oqskemcnt] = oqskem_choices[oqskemcnt].name; 
     }
+    for (oqskemcnt = OQSKEM_NUM; oqskemcnt < OQSKEM_ALL; ++oqskemcnt) {
+        int hybrid_nid = NID_undef;
+
+        oqskem_curves[oqskemcnt] = NID_undef;
+# ifndef OPENSSL_NO_EC
+        hybrid_nid = oqs_kem_hybrid_nid(oqssl_kem_nids_list[oqskemcnt - OQSKEM_NUM],
+                                        &oqskem_curves[oqskemcnt]);
+# endif
+        oqskem_choices[oqskemcnt].name =
+            hybrid_nid == NID_undef ? "" : OBJ_nid2sn(hybrid_nid);
+        oqskem_choices[oqskemcnt].retval = oqskemcnt;
+        oqskem_method_names[oqskemcnt] = oqskem_choices[oqskemcnt].name;
+    }
 #endif /* ndef OPENSSL_NO_OQSKEM */
 
 #ifndef OPENSSL_NO_OQSSIG
@@ -1729,6 +2118,24 @@ int speed_main(int argc, char **argv)
                 BIO_printf(bio_err, "%s: too many async_jobs\n", prog);
                 goto opterr;
             }
+#endif
+            break;
+        case OPT_THREADS:
+#ifdef OQS_SPEED_THREADS
+            oqs_threads = atoi(opt_arg());
+            if (oqs_threads < 1 || oqs_threads > 1024) {
+                BIO_printf(bio_err, "%s: bad number of threads\n", prog);
+                goto opterr;
+            }
+#endif
+            break;
+        case OPT_KDF_THREADS:
+#ifndef OPENSSL_NO_SCRYPT
+            kdf_threads = atoi(opt_arg());
+            if (kdf_threads < 1 || kdf_threads > EVP_PBE_SCRYPT_MAX_THREADS) {
+                BIO_printf(bio_err, "%s: bad number of KDF threads\n", prog);
+                goto opterr;
+            }
 #endif
             break;
         case OPT_MISALIGN:
@@ -1743,6 +2150,12 @@ int speed_main(int argc, char **argv)
         case OPT_MR:
             mr = 1;
             break;
+        case OPT_JSON:
+            output_format = OUTPUT_JSON;
+            break;
+        case OPT_CSV:
+            output_format = OUTPUT_CSV;
+            break;
         case OPT_MB:
             multiblock = 1;
 #ifdef OPENSSL_NO_MULTIBLOCK
@@ -1763,7 +2176,7 @@ int speed_main(int argc, char **argv)
         case OPT_SECONDS:
             seconds.sym = seconds.rsa = seconds.dsa = seconds.ecdsa
                         = seconds.ecdh = seconds.eddsa = seconds.oqskem 
-                        = seconds.oqssig = atoi(opt_arg());
+                        = seconds.oqssig = seconds.scrypt = atoi(opt_arg());
             break;
         case OPT_BYTES:
             lengths_single = atoi(opt_arg());
@@ -1860,11 +2273,11 @@ int speed_main(int argc, char **argv)
 #ifndef OPENSSL_NO_OQSKEM
         if (strcmp(*argv, "oqskem") == 0) {
             for (loop = 0; loop < OSSL_NELEM(oqskem_doit); loop++)
-                oqskem_doit[loop] = OQS_KEM_alg_is_enabled(get_oqs_alg_name(oqssl_kem_nids_list[loop]));
+                oqskem_doit[loop] = OQSKEM_enabled(oqssl_kem_nids_list, loop);
             continue;
         }
         if (found(*argv, oqskem_choices, &i)) {
-            oqskem_doit[i] = 2*OQS_KEM_alg_is_enabled(get_oqs_alg_name(oqssl_kem_nids_list[i]));
+            oqskem_doit[i] = 2*OQSKEM_enabled(oqssl_kem_nids_list, i);
             continue;
         }
 #endif
@@ -1878,6 +2291,17 @@ int speed_main(int argc, char **argv)
             oqssig_doit[i] = 2*OQS_SIG_alg_is_enabled(get_oqs_alg_name(oqssl_sig_nids_list[i]));
             continue;
         }
+#endif
+#ifndef OPENSSL_NO_SCRYPT
+        if (strcmp(*argv, "scrypt") == 0) {
+            for (loop = 0; loop < OSSL_NELEM(scrypt_doit); loop++)
+                scrypt_doit[loop] = 1;
+            continue;
+        }
+        if (found(*argv, scrypt_choices, &i)) {
+            scrypt_doit[i] = 2;
+            continue;
+        }
 #endif
         BIO_printf(bio_err, "%s: Unknown algorithm %s\n", prog, *argv);
 #ifndef OPENSSL_NO_OQSKEM
@@ -1926,7 +2350,16 @@ int speed_main(int argc, char **argv)
         }
     }
 
-    loopargs_len = (async_jobs == 0 ? 1 : async_jobs);
+    if (oqs_threads > 1 && async_jobs > 0) {
+        BIO_printf(bio_err, "%s: -threads cannot be used with -async_jobs\n",
+                   prog);
+        goto end;
+    }
+    /* Each thread needs its own loopargs; wall-clock time is the divisor */
+    if (oqs_threads > 1)
+        usertime = 0;
+
+    loopargs_len = (async_jobs == 0 ? oqs_threads : async_jobs);
     loopargs =
         app_malloc(loopargs_len * sizeof(loopargs_t), "array of loopargs");
     memset(loopargs, 0, loopargs_len * sizeof(loopargs_t));
@@ -1988,8 +2421,8 @@ int speed_main(int argc, char **argv)
             eddsa_doit[loop] = 1;
 #endif
 #ifndef OPENSSL_NO_OQSKEM
-    	for (i = 0; i < OQSKEM_NUM; i++) 
-            oqskem_doit[i] = OQS_KEM_alg_is_enabled(get_oqs_alg_name(oqssl_kem_nids_list[i]));
+    	for (i = 0; i < OQSKEM_ALL; i++) 
+            oqskem_doit[i] = OQSKEM_enabled(oqssl_kem_nids_list, i);
 #endif
 #ifndef OPENSSL_NO_OQSSIG
     	for (i = 0; i < OQSSIG_NUM; i++) 
@@ -2299,22 +2732,23 @@ int speed_main(int argc, char **argv)
 #  endif /* OPENSSL_NO_EC */
 
 #ifndef OPENSSL_NO_OQSKEM
-    for (i = 0; i <= OQSKEM_NUM; i++) {
+    for (i = 0; i < OQSKEM_ALL; i++) {
         oqskem_c[i][0] = count/1000;
         oqskem_c[i][1] = count/1000;
+        oqskem_c[i][2] = count/1000;
     }
-    oqskem_secret_key = NULL;
-    oqskem_public_key = NULL;
-    oqskem_ciphertext = NULL;
-    oqskem_shared_secret_d = NULL;
-    oqskem_shared_secret_e = NULL;
 #endif
 #ifndef OPENSSL_NO_OQSSIG
-    for (i = 0; i <= OQSSIG_NUM; i++) {
+    for (i = 0; i < OQSSIG_NUM; i++) {
         oqssig_c[i][0] = count/1000;
         oqssig_c[i][1] = count/1000;
     }
 #endif
+#ifndef OPENSSL_NO_SCRYPT
+    /* Each derivation takes tens of milliseconds at least */
+    for (i = 0; i < SCRYPT_NUM; i++)
+        scrypt_c[i][0] = 10;
+#endif
 
 # else
 /* not worth fixing */
@@ -2798,6 +3232,9 @@ int speed_main(int argc, char **argv)
                     lengths = aead_lengths_list;
                     size_num = OSSL_NELEM(aead_lengths_list);
                 }
+            } else if (EVP_CIPHER_mode(evp_cipher) == EVP_CIPH_GCM_SIV_MODE) {
+                /* GCM-SIV takes the whole text at once, so no streaming */
+                loopfunc = EVP_Update_loop_aead;
             }
 
             for (testnum = 0; testnum < size_num; testnum++) {
@@ -3375,75 +3812,69 @@ int speed_main(int argc, char **argv)
 
 #ifndef OPENSSL_NO_OQSKEM
     OQS_randombytes_custom_algorithm((void (*)(uint8_t *, size_t)) &RAND_bytes);
-    int j;
-    for (j = 0; j < OQSKEM_NUM; j++) {
-        if (!oqskem_doit[j])
+    for (testnum = 0; testnum < OQSKEM_ALL; testnum++) {
+        const OQS_KEM *kem;
+        int st = 1;
+
+        if (!oqskem_doit[testnum])
             continue;
 
-        oqskem_kem[j] = OQS_KEM_new(get_oqs_alg_name(oqssl_kem_nids_list[j]));
-        if (oqskem_kem[j] == NULL) {
-            BIO_printf(bio_err,"OQSKEM failure - OQS_KEM_new(%s).\n", get_oqs_alg_name(oqssl_kem_nids_list[j]));
+        kem = get_oqs_kem(oqssl_kem_nids_list[testnum % OQSKEM_NUM]);
+        if (kem == NULL)
+            st = 0;
+        for (i = 0; st && i < loopargs_len; i++)
+            st = OQSKEM_setup(&loopargs[i], kem, oqskem_curves[testnum]);
+        if (st == 0) {
+            BIO_printf(bio_err, "OQSKEM failure - %s.\n",
+                       oqskem_method_names[testnum]);
             ERR_print_errors(bio_err);
-            rsa_count=1;
+            rsa_count = 1;
         } else {
-            oqskem_public_key = malloc(oqskem_kem[j]->length_public_key);
-            oqskem_secret_key = malloc(oqskem_kem[j]->length_secret_key);
-            oqskem_ciphertext = malloc(oqskem_kem[j]->length_ciphertext);
-            oqskem_shared_secret_d = malloc(oqskem_kem[j]->length_shared_secret);
-            oqskem_shared_secret_e = malloc(oqskem_kem[j]->length_shared_secret);
+            char lbl[1000];
 
             /* time OQSKEM keypair operation */
-            char lbl[1000];
-            sprintf(lbl, "%s (OQS KEM %s)", oqskem_method_names[j], oqskem_kem[j]->method_name);
-            // XXX TBR TBD oqskem_method_names[j] = strdup(oqskem_kem[j]->method_name);
-            pkey_print_message(lbl, "keypair", oqskem_c[j][0], 0, seconds.oqskem);
+            sprintf(lbl, "%s (OQS KEM %s)", oqskem_method_names[testnum], kem->method_name);
+            pkey_print_message(lbl, "keypair", oqskem_c[testnum][0], 0, seconds.oqskem);
             Time_F(START);
-            for (count = 0, run = 1; COND(oqskem_c[j][0]); count++) {
-                OQS_KEM_keypair(oqskem_kem[j], oqskem_public_key, oqskem_secret_key);
-            }
+            count = run_oqs_benchmark(async_jobs, OQSKEM_keypair_loop, loopargs);
             d = Time_F(STOP);
-            sprintf(lbl, "%%ld %s keypair in %%.2fs\n", oqskem_method_names[j]);
+            sprintf(lbl, "%%ld %s keypair in %%.2fs\n", oqskem_method_names[testnum]);
             BIO_printf(bio_err, mr ? "+R9:%ld:%.2f\n" : lbl, count, d);
-            oqskem_results[j][0] = d / (double)count;
+            oqskem_results[testnum][0] = (double)count / d;
+            oqskem_cycles[testnum][0] = tsc_per_op(count);
             rsa_count = count;
 
             /* time OQSKEM encaps operation */
-            sprintf(lbl, "%s", oqskem_method_names[j]);
-            pkey_print_message(lbl, "encaps", oqskem_c[j][1], 0, seconds.oqskem);
+            sprintf(lbl, "%s", oqskem_method_names[testnum]);
+            pkey_print_message(lbl, "encaps", oqskem_c[testnum][1], 0, seconds.oqskem);
             Time_F(START);
-            for (count = 0, run = 1; COND(oqskem_c[j][1]); count++) {
-                OQS_KEM_encaps(oqskem_kem[j], oqskem_ciphertext, oqskem_shared_secret_e, oqskem_public_key);
-            }
+            count = run_oqs_benchmark(async_jobs, OQSKEM_encaps_loop, loopargs);
             d = Time_F(STOP);
-            sprintf(lbl, "%%ld %s encaps in %%.2fs\n", oqskem_method_names[j]);
+            sprintf(lbl, "%%ld %s encaps in %%.2fs\n", oqskem_method_names[testnum]);
             BIO_printf(bio_err, mr ? "+R10:%ld:%.2f\n" : lbl, count, d);
-            oqskem_results[j][1] = d / (double)count;
+            oqskem_results[testnum][1] = (double)count / d;
+            oqskem_cycles[testnum][1] = tsc_per_op(count);
             rsa_count = count;
 
             /* time OQSKEM decaps operation */
-            sprintf(lbl, "%s", oqskem_method_names[j]);
-            pkey_print_message(lbl, "decaps", oqskem_c[j][2], 0, seconds.oqskem);
+            sprintf(lbl, "%s", oqskem_method_names[testnum]);
+            pkey_print_message(lbl, "decaps", oqskem_c[testnum][2], 0, seconds.oqskem);
             Time_F(START);
-            for (count = 0, run = 1; COND(oqskem_c[j][2]); count++) {
-                OQS_KEM_decaps(oqskem_kem[j], oqskem_shared_secret_d, oqskem_ciphertext, oqskem_secret_key);
-            }
+            count = run_oqs_benchmark(async_jobs, OQSKEM_decaps_loop, loopargs);
             d = Time_F(STOP);
-            sprintf(lbl, "%%ld %s decaps in %%.2fs\n", oqskem_method_names[j]);
+            sprintf(lbl, "%%ld %s decaps in %%.2fs\n", oqskem_method_names[testnum]);
             BIO_printf(bio_err, mr ? "+R11:%ld:%.2f\n" : lbl, count, d);
-            oqskem_results[j][2] = d / (double)count;
+            oqskem_results[testnum][2] = (double)count / d;
+            oqskem_cycles[testnum][2] = tsc_per_op(count);
             rsa_count = count;
-            OQS_MEM_insecure_free(oqskem_public_key);
-            OQS_MEM_insecure_free(oqskem_ciphertext);
-            OQS_MEM_secure_free(oqskem_secret_key, oqskem_kem[j]->length_secret_key);
-            OQS_MEM_secure_free(oqskem_shared_secret_d, oqskem_kem[j]->length_shared_secret);
-            OQS_MEM_secure_free(oqskem_shared_secret_e, oqskem_kem[j]->length_shared_secret);
         }
-        OQS_KEM_free(oqskem_kem[j]);
+        for (i = 0; i < loopargs_len; i++)
+            OQSKEM_cleanup(&loopargs[i]);
 
         if (rsa_count <= 1) {
             /* if longer than 10s, don't do any more */
-            for (j++; j < OQSKEM_NUM; j++)
-                oqskem_doit[j] = 0;
+            for (testnum++; testnum < OQSKEM_ALL; testnum++)
+                oqskem_doit[testnum] = 0;
         }
     }
 #endif /* ndef OPENSSL_NO_OQSKEM */
@@ -3479,6 +3910,9 @@ int speed_main(int argc, char **argv)
                 EVP_PKEY_free(oqssig_pkey);
                 break;
             }
+            loopargs[i].oqssig_maxlen[testnum] = EVP_PKEY_size(oqssig_pkey);
+            loopargs[i].oqssig_buf[testnum] =
+                app_malloc(loopargs[i].oqssig_maxlen[testnum], "OQS signature");
             EVP_PKEY_free(oqssig_pkey);
         }
         if (st == 0) {
@@ -3488,12 +3922,11 @@ int speed_main(int argc, char **argv)
         } else {
             for (i = 0; i < loopargs_len; i++) {
                 /* Perform signature test */
-                loopargs[i].sigsize = oqs_size(oqssig_pkey);
+                loopargs[i].sigsize = loopargs[i].oqssig_maxlen[testnum];
                 st = EVP_DigestSign(loopargs[i].oqssig_ctx[testnum],
-                                    loopargs[i].buf2, &loopargs[i].sigsize,
+                                    loopargs[i].oqssig_buf[testnum],
+                                    &loopargs[i].sigsize,
                                     loopargs[i].buf, 20);
-                // reset size for repeated sign runs as OQS sign may have destroyed value
-                loopargs[i].sigsize = oqs_size(oqssig_pkey);
                 if (st == 0)
                     break;
             }
@@ -3507,7 +3940,7 @@ int speed_main(int argc, char **argv)
                                    oqssig_c[testnum][0],
                                    0, seconds.oqssig);
                 Time_F(START);
-                count = run_benchmark(async_jobs, OQS_sign_loop, loopargs);
+                count = run_oqs_benchmark(async_jobs, OQS_sign_loop, loopargs);
                 d = Time_F(STOP);
 
                 BIO_printf(bio_err,
@@ -3516,13 +3949,15 @@ int speed_main(int argc, char **argv)
                            count,
                            OBJ_nid2sn(oqssl_sig_nids_list[testnum]) , d);
                 oqssig_results[testnum][0] = (double)count / d;
+                oqssig_cycles[testnum][0] = tsc_per_op(count);
                 rsa_count = count;
             }
 
             /* Perform verification test */
             for (i = 0; i < loopargs_len; i++) {
                 st = EVP_DigestVerify(loopargs[i].oqssig_ctx[testnum],
-                                      loopargs[i].buf2, loopargs[i].sigsize,
+                                      loopargs[i].oqssig_buf[testnum],
+                                      loopargs[i].sigsize,
                                       loopargs[i].buf, 20);
                 if (st != 1)
                     break;
@@ -3537,7 +3972,7 @@ int speed_main(int argc, char **argv)
                                    oqssig_c[testnum][1],
                                    0, seconds.oqssig);
                 Time_F(START);
-                count = run_benchmark(async_jobs, OQS_verify_loop, loopargs);
+                count = run_oqs_benchmark(async_jobs, OQS_verify_loop, loopargs);
                 d = Time_F(STOP);
                 BIO_printf(bio_err,
                            mr ? "+R9:%ld:%s:%.2f\n"
@@ -3545,6 +3980,7 @@ int speed_main(int argc, char **argv)
                            count, 
                            OBJ_nid2sn(oqssl_sig_nids_list[testnum]), d);
                 oqssig_results[testnum][1] = (double)count / d;
+                oqssig_cycles[testnum][1] = tsc_per_op(count);
             }
 
             if (rsa_count <= 1) {
@@ -3557,31 +3993,41 @@ int speed_main(int argc, char **argv)
 
 #endif /* ndef OPENSSL_NO_OQSSIG */
 
+#ifndef OPENSSL_NO_SCRYPT
+    for (testnum = 0; testnum < SCRYPT_NUM; testnum++) {
+        if (!scrypt_doit[testnum])
+            continue;
+
+        pkey_print_message(scrypt_choices[testnum].name, "derive",
+                           scrypt_c[testnum][0], 0, seconds.scrypt);
+        Time_F(START);
+        count = run_benchmark(async_jobs, scrypt_loop, loopargs);
+        d = Time_F(STOP);
+        if (count < 0) {
+            scrypt_doit[testnum] = 0;
+            continue;
+        }
+        BIO_printf(bio_err,
+                   mr ? "+R12:%ld:%s:%.2f\n" : "%ld %s derives in %.2fs\n",
+                   count, scrypt_choices[testnum].name, d);
+        scrypt_results[testnum][0] = (double)count / d;
+    }
+#endif
 
 #ifndef NO_FORK
  show_res:
 #endif
-    if (!mr) {
+    if (output_format != OUTPUT_TEXT) {
+        output_begin();
+    } else if (!mr) {
+        const char *opts[LIB_OPTIONS_MAX];
+        int n = lib_options(opts);
+
         printf("%s\n", OpenSSL_version(OPENSSL_VERSION));
         printf("%s\n", OpenSSL_version(OPENSSL_BUILT_ON));
         printf("options:");
-        printf("%s ", BN_options());
-#ifndef OPENSSL_NO_MD2
-        printf("%s ", MD2_options());
-#endif
-#ifndef OPENSSL_NO_RC4
-        printf("%s ", RC4_options());
-#endif
-#ifndef OPENSSL_NO_DES
-        printf("%s ", DES_options());
-#endif
-        printf("%s ", AES_options());
-#ifndef OPENSSL_NO_IDEA
-        printf("%s ", IDEA_options());
-#endif
-#ifndef OPENSSL_NO_BF
-        printf("%s ", BF_options());
-#endif
+        for (i = 0; i < n; i++)
+            printf("%s ", opts[i]);
 #ifndef OPENSSL_NO_OQSKEM
         printf("%s ", OQSKEM_options());
 #endif
@@ -3591,7 +4037,7 @@ int speed_main(int argc, char **argv)
         printf("\n%s\n", OpenSSL_version(OPENSSL_CFLAGS));
     }
 
-    if (pr_header) {
+    if (pr_header && output_format == OUTPUT_TEXT) {
         if (mr)
             printf("+H");
         else {
@@ -3607,6 +4053,17 @@ int speed_main(int argc, char **argv)
     for (k = 0; k < ALGOR_NUM; k++) {
         if (!doit[k])
             continue;
+        if (output_format != OUTPUT_TEXT) {
+            SPEED_ROW row = { "symmetric" };
+
+            row.name = names[k];
+            for (testnum = 0; testnum < size_num; testnum++) {
+                row.bytes = lengths[testnum];
+                row.per_sec = results[k][testnum] / lengths[testnum];
+                output_row(&row);
+            }
+            continue;
+        }
         if (mr)
             printf("+F:%u:%s", k, names[k]);
         else
@@ -3624,6 +4081,18 @@ int speed_main(int argc, char **argv)
     for (k = 0; k < RSA_NUM; k++) {
         if (!rsa_doit[k])
             continue;
+        if (output_format != OUTPUT_TEXT) {
+            SPEED_ROW row = { "rsa", "rsa" };
+
+            row.bits = rsa_bits[k];
+            row.op = "sign";
+            row.per_sec = rsa_results[k][0];
+            output_row(&row);
+            row.op = "verify";
+            row.per_sec = rsa_results[k][1];
+            output_row(&row);
+            continue;
+        }
         if (testnum && !mr) {
             printf("%18ssign    verify    sign/s verify/s\n", " ");
             testnum = 0;
@@ -3642,6 +4111,18 @@ int speed_main(int argc, char **argv)
     for (k = 0; k < DSA_NUM; k++) {
         if (!dsa_doit[k])
             continue;
+        if (output_format != OUTPUT_TEXT) {
+            SPEED_ROW row = { "dsa", "dsa" };
+
+            row.bits = dsa_bits[k];
+            row.op = "sign";
+            row.per_sec = dsa_results[k][0];
+            output_row(&row);
+            row.op = "verify";
+            row.per_sec = dsa_results[k][1];
+            output_row(&row);
+            continue;
+        }
         if (testnum && !mr) {
             printf("%18ssign    verify    sign/s verify/s\n", " ");
             testnum = 0;
@@ -3660,6 +4141,19 @@ int speed_main(int argc, char **argv)
     for (k = 0; k < OSSL_NELEM(ecdsa_doit); k++) {
         if (!ecdsa_doit[k])
             continue;
+        if (output_format != OUTPUT_TEXT) {
+            SPEED_ROW row = { "ecdsa" };
+
+            row.name = test_curves[k].name;
+            row.bits = test_curves[k].bits;
+            row.op = "sign";
+            row.per_sec = ecdsa_results[k][0];
+            output_row(&row);
+            row.op = "verify";
+            row.per_sec = ecdsa_results[k][1];
+            output_row(&row);
+            continue;
+        }
         if (testnum && !mr) {
             printf("%30ssign    verify    sign/s verify/s\n", " ");
             testnum = 0;
@@ -3680,6 +4174,16 @@ int speed_main(int argc, char **argv)
     for (k = 0; k < EC_NUM; k++) {
         if (!ecdh_doit[k])
             continue;
+        if (output_format != OUTPUT_TEXT) {
+            SPEED_ROW row = { "ecdh" };
+
+            row.name = test_curves[k].name;
+            row.bits = test_curves[k].bits;
+            row.op = "derive";
+            row.per_sec = ecdh_results[k][0];
+            output_row(&row);
+            continue;
+        }
         if (testnum && !mr) {
             printf("%30sop      op/s\n", " ");
             testnum = 0;
@@ -3699,6 +4203,19 @@ int speed_main(int argc, char **argv)
     for (k = 0; k < OSSL_NELEM(eddsa_doit); k++) {
         if (!eddsa_doit[k])
             continue;
+        if (output_format != OUTPUT_TEXT) {
+            SPEED_ROW row = { "eddsa" };
+
+            row.name = test_ed_curves[k].name;
+            row.bits = test_ed_curves[k].bits;
+            row.op = "sign";
+            row.per_sec = eddsa_results[k][0];
+            output_row(&row);
+            row.op = "verify";
+            row.per_sec = eddsa_results[k][1];
+            output_row(&row);
+            continue;
+        }
         if (testnum && !mr) {
             printf("%30ssign    verify    sign/s verify/s\n", " ");
             testnum = 0;
@@ -3718,22 +4235,52 @@ int speed_main(int argc, char **argv)
 
 #ifndef OPENSSL_NO_OQSKEM
     testnum = 1;
-    for (k = 0; k < OQSKEM_NUM; k++) {
+    for (k = 0; k < OQSKEM_ALL; k++) {
         if (!oqskem_doit[k])
             continue;
+        if (output_format != OUTPUT_TEXT) {
+            static const char *ops[] = { "keypair", "encaps", "decaps" };
+            const OQS_KEM *kem = get_oqs_kem(oqssl_kem_nids_list[k % OQSKEM_NUM]);
+            SPEED_ROW row = { "kem" };
+
+            row.name = oqskem_method_names[k];
+            row.impl = get_oqs_alg_impl(oqssl_kem_nids_list[k % OQSKEM_NUM]);
+            if (kem != NULL) {
+                row.public_key = kem->length_public_key;
+                row.secret_key = kem->length_secret_key;
+                row.ciphertext = kem->length_ciphertext;
+                row.shared_secret = kem->length_shared_secret;
+            }
+            for (i = 0; i < 3; i++) {
+                row.op = ops[i];
+                row.per_sec = oqskem_results[k][i];
+                row.cycles = oqskem_cycles[k][i];
+                output_row(&row);
+            }
+            continue;
+        }
         if (testnum && !mr) {
-            printf("%30skeygen/s      encap/s      decap/s\n", " ");
+            printf("%30skeygen/s      encap/s      decap/s", " ");
+            if (oqs_threads > 1)
+                printf("   per thread: keygen/s  encap/s  decap/s");
+            printf("\n");
             testnum = 0;
         }
-        if (mr)
-            printf("+F5:%u:%s:%f:%f:%f\n",
-                   k, oqskem_method_names[k], 
+        if (mr) {
+            printf("+F8:%u:%s:%f:%f:%f\n",
+                   k, oqskem_method_names[k],
                    oqskem_results[k][0], oqskem_results[k][1], oqskem_results[k][2]);
-
-        else
-            printf("%29s %8.1f     %8.1f     %8.1f\n",
-                   oqskem_method_names[k],
-                   1.0 / oqskem_results[k][0], 1.0 / oqskem_results[k][1], 1.0 / oqskem_results[k][2]);
+            continue;
+        }
+        printf("%29s %8.1f     %8.1f     %8.1f",
+               oqskem_method_names[k],
+               oqskem_results[k][0], oqskem_results[k][1], oqskem_results[k][2]);
+        if (oqs_threads > 1)
+            printf("               %8.1f %8.1f %8.1f",
+                   oqskem_results[k][0] / oqs_threads,
+                   oqskem_results[k][1] / oqs_threads,
+                   oqskem_results[k][2] / oqs_threads);
+        print_oqs_impl(oqssl_kem_nids_list[k % OQSKEM_NUM]);
     }
 #endif
 
@@ -3742,23 +4289,95 @@ int speed_main(int argc, char **argv)
     for (k = 0; k < OQSSIG_NUM; k++) {
         if (!oqssig_doit[k])
             continue;
+        if (output_format != OUTPUT_TEXT) {
+            const OQS_SIG *sig = get_oqs_sig(oqssl_sig_nids_list[k]);
+            SPEED_ROW row = { "signature" };
+
+            row.name = OBJ_nid2sn(oqssl_sig_nids_list[k]);
+            row.impl = get_oqs_alg_impl(oqssl_sig_nids_list[k]);
+            if (sig != NULL) {
+                row.public_key = sig->length_public_key;
+                row.secret_key = sig->length_secret_key;
+                row.signature = sig->length_signature;
+            }
+            row.bytes = 20;
+            row.op = "sign";
+            row.per_sec = oqssig_results[k][0];
+            row.cycles = oqssig_cycles[k][0];
+            output_row(&row);
+            row.op = "verify";
+            row.per_sec = oqssig_results[k][1];
+            row.cycles = oqssig_cycles[k][1];
+            output_row(&row);
+            continue;
+        }
         if (testnum && !mr) {
-            printf("%30s      sign    verify   sign/s  verify/s\n", " ");
+            printf("%30s      sign    verify   sign/s  verify/s", " ");
+            if (oqs_threads > 1)
+                printf("   per thread: sign/s verify/s");
+            printf("\n");
             testnum = 0;
         }
 
-        if (mr)
-            printf("+F6:%u:%s:%f:%f\n",
+        if (mr) {
+            printf("+F9:%u:%s:%f:%f\n",
                    k, OBJ_nid2sn(oqssl_sig_nids_list[k]),
                    oqssig_results[k][0], oqssig_results[k][1]);
+            continue;
+        }
+        printf("%29s: %8.4fs %8.4fs %8.1f %8.1f",
+               OBJ_nid2sn(oqssl_sig_nids_list[k]),
+               1.0 / oqssig_results[k][0], 1.0 / oqssig_results[k][1],
+               oqssig_results[k][0], oqssig_results[k][1]);
+        if (oqs_threads > 1)
+            printf("               %8.1f %8.1f",
+                   oqssig_results[k][0] / oqs_threads,
+                   oqssig_results[k][1] / oqs_threads);
+        print_oqs_impl(oqssl_sig_nids_list[k]);
+    }
+#endif
+
+#ifndef OPENSSL_NO_SCRYPT
+    testnum = 1;
+    for (k = 0; k < SCRYPT_NUM; k++) {
+        if (!scrypt_doit[k])
+            continue;
+        if (output_format != OUTPUT_TEXT) {
+            SPEED_ROW row = { "kdf" };
+
+            row.name = scrypt_choices[k].name;
+            row.op = "derive";
+            row.per_sec = scrypt_results[k][0];
+            output_row(&row);
+            continue;
+        }
+        if (testnum && !mr) {
+            printf("%30slane MB   derive derive/s\n", " ");
+            testnum = 0;
+        }
+        if (mr)
+            printf("+F7:%u:%s:%f\n",
+                   k, scrypt_choices[k].name, scrypt_results[k][0]);
         else
-            printf("%29s: %8.4fs %8.4fs %8.1f %8.1f\n",
-                   OBJ_nid2sn(oqssl_sig_nids_list[k]),
-                   1.0 / oqssig_results[k][0], 1.0 / oqssig_results[k][1],
-                   oqssig_results[k][0], oqssig_results[k][1]);
+            printf("%29s %8.1f %8.4fs %8.1f\n", scrypt_choices[k].name,
+                   (double)(128 * scrypt_params[k].r
+                            << scrypt_params[k].log2_N) / (1024 * 1024),
+                   1.0 / scrypt_results[k][0], scrypt_results[k][0]);
     }
 #endif
 
+    if (output_format != OUTPUT_TEXT)
+        output_end();
+
+#ifndef OPENSSL_NO_LOCK_STATS
+    fflush(stdout);
+    if (multi_child >= 0)
+        BIO_printf(bio_err, "Most contended locks in child %d:\n", multi_child);
+    else
+        BIO_printf(bio_err, "Most contended locks:\n");
+    CRYPTO_THREAD_lock_stats(bio_err, LOCK_STATS_TOP);
+#endif
+
     ret = 0;
 
  end:
@@ -3786,12 +4405,13 @@ int speed_main(int argc, char **argv)
         OPENSSL_free(loopargs[i].secret_b);
 #endif
 #ifndef OPENSSL_NO_OQSKEM
-        OPENSSL_free(oqssl_kem_nids_list);
+        OQSKEM_cleanup(&loopargs[i]);
 #endif
 #ifndef OPENSSL_NO_OQSSIG
-        for (k = 0; k < OQSSIG_NUM; k++)
+        for (k = 0; k < OQSSIG_NUM; k++) {
             EVP_MD_CTX_free(loopargs[i].oqssig_ctx[k]);
-        OPENSSL_free(oqssl_sig_nids_list);
+            OPENSSL_free(loopargs[i].oqssig_buf[k]);
+        }
 #endif
     }
     if (async_jobs > 0) {
@@ -3852,6 +4472,240 @@ static void pkey_print_message(const char *str, const char *str2, long num,
 #endif
 }
 
+static void tsc_interval(int s)
+{
+#ifdef SPEED_X86
+    static uint64_t start;
+
+    if (s == START)
+        start = __rdtsc();
+    else
+        tsc_ticks = __rdtsc() - start;
+#endif
+}
+
+/* TSC ticks per operation of the last timing, on each thread running it */
+static double tsc_per_op(long count)
+{
+    if (tsc_ticks == 0 || count <= 0)
+        return 0;
+    return (double)tsc_ticks * oqs_threads / count;
+}
+
+/* The build options of the algorithm implementations */
+static int lib_options(const char **opts)
+{
+    int n = 0;
+
+    opts[n++] = BN_options();
+#ifndef OPENSSL_NO_MD2
+    opts[n++] = MD2_options();
+#endif
+#ifndef OPENSSL_NO_RC4
+    opts[n++] = RC4_options();
+#endif
+#ifndef OPENSSL_NO_DES
+    opts[n++] = DES_options();
+#endif
+    opts[n++] = AES_options();
+#ifndef OPENSSL_NO_IDEA
+    opts[n++] = IDEA_options();
+#endif
+#ifndef OPENSSL_NO_BF
+    opts[n++] = BF_options();
+#endif
+    return n;
+}
+
+static void json_string(const char *str)
+{
+    putchar('"');
+    for (; *str != '\0'; str++) {
+        if (*str == '"' || *str == '\\')
+            printf("\\%c", *str);
+        else if ((unsigned char)*str < 0x20)
+            printf("\\u%04x", (unsigned char)*str);
+        else
+            putchar(*str);
+    }
+    putchar('"');
+}
+
+static void csv_string(const char *str)
+{
+    if (strpbrk(str, ",\"\r\n") == NULL) {
+        fputs(str, stdout);
+        return;
+    }
+    putchar('"');
+    for (; *str != '\0'; str++) {
+        if (*str == '"')
+            putchar('"');
+        putchar(*str);
+    }
+    putchar('"');
+}
+
+static int rows_output = 0;
+
+static void output_begin(void)
+{
+    const char *opts[LIB_OPTIONS_MAX];
+    const char *cap;
+    int i, n;
+#ifdef SPEED_X86
+    unsigned int eax, ebx, ecx, edx, ebx7 = 0, ecx7 = 0, edx7;
+#endif
+
+    rows_output = 0;
+    if (output_format == OUTPUT_CSV) {
+        printf("type,name,operation,bytes,bits,per_sec,bytes_per_sec,"
+               "cycles_per_op,public_key,secret_key,ciphertext,"
+               "shared_secret,signature,implementation\n");
+        return;
+    }
+
+    printf("{\n  \"version\": ");
+    json_string(OpenSSL_version(OPENSSL_VERSION));
+    printf(",\n  \"built_on\": ");
+    json_string(OpenSSL_version(OPENSSL_BUILT_ON));
+    printf(",\n  \"platform\": ");
+    json_string(OpenSSL_version(OPENSSL_PLATFORM));
+    printf(",\n  \"compiler\": ");
+    json_string(OpenSSL_version(OPENSSL_CFLAGS));
+#ifdef __VERSION__
+    printf(",\n  \"app_compiler\": ");
+    json_string(__VERSION__);
+#endif
+    printf(",\n  \"options\": [");
+    n = lib_options(opts);
+    for (i = 0; i < n; i++) {
+        printf(i == 0 ? "" : ", ");
+        json_string(opts[i]);
+    }
+    printf("]");
+#ifndef OPENSSL_NO_OQSKEM
+    printf(",\n  \"oqskem_options\": ");
+    json_string(OQSKEM_options());
+#endif
+#ifndef OPENSSL_NO_OQSSIG
+    printf(",\n  \"oqssig_options\": ");
+    json_string(OQSSIG_options());
+#endif
+#ifdef SPEED_X86
+    /* In the format of OPENSSL_ia32cap, before any masking */
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        if (__get_cpuid_max(0, NULL) >= 7)
+            __cpuid_count(7, 0, eax, ebx7, ecx7, edx7);
+        printf(",\n  \"cpuid\": \"0x%08x%08x:0x%08x%08x\"",
+               ecx, edx, ecx7, ebx7);
+    }
+#endif
+    if ((cap = getenv("OPENSSL_ia32cap")) != NULL) {
+        printf(",\n  \"OPENSSL_ia32cap\": ");
+        json_string(cap);
+    }
+    printf(",\n  \"elapsed\": %s", usertime ? "false" : "true");
+    printf(",\n  \"threads\": %d", oqs_threads);
+    printf(",\n  \"results\": [");
+}
+
+static void output_row(const SPEED_ROW *row)
+{
+    if (output_format == OUTPUT_CSV) {
+        csv_string(row->type);
+        putchar(',');
+        csv_string(row->name);
+        putchar(',');
+        if (row->op != NULL)
+            csv_string(row->op);
+        putchar(',');
+        if (row->bytes != 0)
+            printf("%d", row->bytes);
+        putchar(',');
+        if (row->bits != 0)
+            printf("%u", row->bits);
+        printf(",%.2f,", row->per_sec);
+        if (row->bytes != 0)
+            printf("%.2f", row->per_sec * row->bytes);
+        putchar(',');
+        if (row->cycles != 0)
+            printf("%.0f", row->cycles);
+        putchar(',');
+        if (row->public_key != 0)
+            printf("%zu", row->public_key);
+        putchar(',');
+        if (row->secret_key != 0)
+            printf("%zu", row->secret_key);
+        putchar(',');
+        if (row->ciphertext != 0)
+            printf("%zu", row->ciphertext);
+        putchar(',');
+        if (row->shared_secret != 0)
+            printf("%zu", row->shared_secret);
+        putchar(',');
+        if (row->signature != 0)
+            printf("%zu", row->signature);
+        putchar(',');
+        if (row->impl != NULL)
+            csv_string(row->impl);
+        putchar('\n');
+        return;
+    }
+
+    printf(rows_output++ == 0 ? "\n    {" : ",\n    {");
+    printf("\"type\": ");
+    json_string(row->type);
+    printf(", \"name\": ");
+    json_string(row->name);
+    if (row->op != NULL) {
+        printf(", \"operation\": ");
+        json_string(row->op);
+    }
+    if (row->bytes != 0)
+        printf(", \"bytes\": %d", row->bytes);
+    if (row->bits != 0)
+        printf(", \"bits\": %u", row->bits);
+    printf(", \"per_sec\": %.2f", row->per_sec);
+    if (row->bytes != 0)
+        printf(", \"bytes_per_sec\": %.2f", row->per_sec * row->bytes);
+    if (row->cycles != 0)
+        printf(", \"cycles_per_op\": %.0f", row->cycles);
+    if (row->public_key != 0)
+        printf(", \"public_key\": %zu", row->public_key);
+    if (row->secret_key != 0)
+        printf(", \"secret_key\": %zu", row->secret_key);
+    if (row->ciphertext != 0)
+        printf(", \"ciphertext\": %zu", row->ciphertext);
+    if (row->shared_secret != 0)
+        printf(", \"shared_secret\": %zu", row->shared_secret);
+    if (row->signature != 0)
+        printf(", \"signature\": %zu", row->signature);
+    if (row->impl != NULL) {
+        printf(", \"implementation\": ");
+        json_string(row->impl);
+    }
+    putchar('}');
+}
+
+static void output_end(void)
+{
+    if (output_format == OUTPUT_JSON)
+        printf(rows_output == 0 ? "]\n}\n" : "\n  ]\n}\n");
+}
+
+#if !defined(OPENSSL_NO_OQSKEM) || !defined(OPENSSL_NO_OQSSIG)
+/* Ends a table row of the OQS algorithm |nid| with the implementation run */
+static void print_oqs_impl(int nid)
+{
+    const char *impl = get_oqs_alg_impl(nid);
+
+    if (impl != NULL)
+        printf("  %s", impl);
+    printf("\n");
+}
+#endif
+
 static void print_result(int alg, int run_no, int count, double time_used)
 {
     if (count == -1) {
@@ -3921,10 +4775,15 @@ static int do_multi(int multi, int size_num)
             close(fd[1]);
             mr = 1;
             usertime = 0;
+            output_format = OUTPUT_TEXT;
+#ifndef OPENSSL_NO_LOCK_STATS
+            multi_child = n;
+#endif
             OPENSSL_free(fds);
             return 0;
         }
-        printf("Forked child %d\n", n);
+        if (output_format == OUTPUT_TEXT)
+            printf("Forked child %d\n", n);
     }
 
     /* for now, assume the pipe is long enough to take all the output */
@@ -3944,7 +4803,8 @@ static int do_multi(int multi, int size_num)
                            n);
                 continue;
             }
-            printf("Got: %s from %d\n", buf, n);
+            if (output_format == OUTPUT_TEXT)
+                printf("Got: %s from %d\n", buf, n);
             if (strncmp(buf, "+F:", 3) == 0) {
                 int alg;
                 int j;
@@ -4024,6 +4884,44 @@ static int do_multi(int multi, int size_num)
                 eddsa_results[k][1] += d;
             }
 # endif
+# ifndef OPENSSL_NO_SCRYPT
+            else if (strncmp(buf, "+F7:", 4) == 0) {
+                int k;
+                double d;
+
+                p = buf + 4;
+                k = atoi(sstrsep(&p, sep));
+                sstrsep(&p, sep);
+
+                d = atof(sstrsep(&p, sep));
+                scrypt_results[k][0] += d;
+            }
+# endif
+# ifndef OPENSSL_NO_OQSKEM
+            else if (strncmp(buf, "+F8:", 4) == 0) {
+                int k;
+
+                p = buf + 4;
+                k = atoi(sstrsep(&p, sep));
+                sstrsep(&p, sep);
+
+                oqskem_results[k][0] += atof(sstrsep(&p, sep));
+                oqskem_results[k][1] += atof(sstrsep(&p, sep));
+                oqskem_results[k][2] += atof(sstrsep(&p, sep));
+            }
+# endif
+# ifndef OPENSSL_NO_OQSSIG
+            else if (strncmp(buf, "+F9:", 4) == 0) {
+                int k;
+
+                p = buf + 4;
+                k = atoi(sstrsep(&p, sep));
+                sstrsep(&p, sep);
+
+                oqssig_results[k][0] += atof(sstrsep(&p, sep));
+                oqssig_results[k][1] += atof(sstrsep(&p, sep));
+            }
+# endif
 
             else if (strncmp(buf, "+H:", 3) == 0) {
                 ;
@@ -4117,7 +5015,19 @@ static void multiblock_speed(const EVP_CIPHER *evp_cipher, int lengths_single,
         results[D_EVP][j] = ((double)count) / d * mblengths[j];
     }
 
-    if (mr) {
+    if (output_format != OUTPUT_TEXT) {
+        SPEED_ROW row = { "symmetric" };
+
+        row.name = alg_name;
+        row.op = "multiblock";
+        output_begin();
+        for (j = 0; j < num; j++) {
+            row.bytes = mblengths[j];
+            row.per_sec = results[D_EVP][j] / mblengths[j];
+            output_row(&row);
+        }
+        output_end();
+    } else if (mr) {
         fprintf(stdout, "+H");
         for (j = 0; j < num; j++)
             fprintf(stdout, ":%d", mblengths[j]);
@@ -7,6 +7,7 @@
  * https://www.openssl.org/source/license.html
  */
 
+#include <string.h>
 #include <openssl/opensslconf.h>
 
 #include "apps.h"
@@ -16,10 +17,43 @@
 #include <openssl/store.h>
 #include <openssl/x509v3.h>      /* s2i_ASN1_INTEGER */
 
-static int process(const char *uri, const UI_METHOD *uimeth, PW_CB_DATA *uidata,
-                   int expected, int criterion, OSSL_STORE_SEARCH *search,
-                   int text, int noout, int recursive, int indent, BIO *out,
-                   const char *prog);
+#if defined(OPENSSL_THREADS) && !defined(OPENSSL_SYS_WINDOWS)
+# include <pthread.h>
+# define STOREUTL_THREADS
+#endif
+
+DEFINE_STACK_OF(OSSL_STORE_INFO)
+
+/* The objects found at one URI, loaded before any of them is printed */
+typedef struct store_entry_st {
+    const char *uri;
+    STACK_OF(OSSL_STORE_INFO) *infos;
+    /* Where loading reports problems, a memory BIO for prefetched entries */
+    BIO *err;
+    /* Set once the store was opened and the search set up */
+    int opened;
+    int errors;
+    /* Prefetched entries for the names among |infos|, or NULL */
+    struct store_entry_st *subs;
+} STORE_ENTRY;
+
+typedef struct store_job_st {
+    const UI_METHOD *uimeth;
+    PW_CB_DATA *uidata;
+    int expected, criterion;
+    OSSL_STORE_SEARCH *search;
+    int recursive;
+    const char *prog;
+    /* Entries to load by load_entries() */
+    STORE_ENTRY *entries;
+    int nentries, next;
+#ifdef STOREUTL_THREADS
+    pthread_mutex_t lock;
+#endif
+} STORE_JOB;
+
+static int process(const char *uri, STORE_JOB *job, int threads,
+                   int text, int noout, int indent, BIO *out);
 
 typedef enum OPTION_choice {
     OPT_ERR = -1, OPT_EOF = 0, OPT_HELP, OPT_ENGINE, OPT_OUT, OPT_PASSIN,
@@ -27,7 +61,7 @@ typedef enum OPTION_choice {
     OPT_SEARCHFOR_CERTS, OPT_SEARCHFOR_KEYS, OPT_SEARCHFOR_CRLS,
     OPT_CRITERION_SUBJECT, OPT_CRITERION_ISSUER, OPT_CRITERION_SERIAL,
     OPT_CRITERION_FINGERPRINT, OPT_CRITERION_ALIAS,
-    OPT_MD
+    OPT_MD, OPT_THREADS
 } OPTION_CHOICE;
 
 const OPTIONS storeutl_options[] = {
@@ -50,12 +84,16 @@ const OPTIONS storeutl_options[] = {
     {"engine", OPT_ENGINE, 's', "Use engine, possibly a hardware device"},
 #endif
     {"r", OPT_RECURSIVE, '-', "Recurse through names"},
+#ifdef STOREUTL_THREADS
+    {"threads", OPT_THREADS, 'p',
+        "Number of threads loading the names found, with -r"},
+#endif
     {NULL}
 };
 
 int storeutl_main(int argc, char *argv[])
 {
-    int ret = 1, noout = 0, text = 0, recursive = 0;
+    int ret = 1, noout = 0, text = 0, recursive = 0, threads = 1;
     char *outfile = NULL, *passin = NULL, *passinarg = NULL;
     BIO *out = NULL;
     ENGINE *e = NULL;
@@ -71,6 +109,7 @@ int storeutl_main(int argc, char *argv[])
     char *alias = NULL;
     OSSL_STORE_SEARCH *search = NULL;
     const EVP_MD *digest = NULL;
+    STORE_JOB job;
 
     while ((o = opt_next()) != OPT_EOF) {
         switch (o) {
@@ -98,6 +137,9 @@ int storeutl_main(int argc, char *argv[])
         case OPT_RECURSIVE:
             recursive = 1;
             break;
+        case OPT_THREADS:
+            threads = atoi(opt_arg());
+            break;
         case OPT_SEARCHFOR_CERTS:
         case OPT_SEARCHFOR_KEYS:
         case OPT_SEARCHFOR_CRLS:
@@ -303,9 +345,15 @@ int storeutl_main(int argc, char *argv[])
     if (out == NULL)
         goto end;
 
-    ret = process(argv[0], get_ui_method(), &pw_cb_data,
-                  expected, criterion, search,
-                  text, noout, recursive, 0, out, prog);
+    memset(&job, 0, sizeof(job));
+    job.uimeth = get_ui_method();
+    job.uidata = &pw_cb_data;
+    job.expected = expected;
+    job.criterion = criterion;
+    job.search = search;
+    job.recursive = recursive;
+    job.prog = prog;
+    ret = process(argv[0], &job, threads, text, noout, 0, out);
 
  end:
     OPENSSL_free(fingerprint);
@@ -333,73 +381,200 @@ static int indent_printf(int indent, BIO *bio, const char *format, ...)
     return ret;
 }
 
-static int process(const char *uri, const UI_METHOD *uimeth, PW_CB_DATA *uidata,
-                   int expected, int criterion, OSSL_STORE_SEARCH *search,
-                   int text, int noout, int recursive, int indent, BIO *out,
-                   const char *prog)
+/*
+ * Opens the store at |ent->uri| and loads everything in it into |ent|,
+ * reporting problems to |ent->err| and counting them.
+ */
+static void load_entry(STORE_JOB *job, STORE_ENTRY *ent)
 {
     OSSL_STORE_CTX *store_ctx = NULL;
-    int ret = 1, items = 0;
 
-    if ((store_ctx = OSSL_STORE_open(uri, uimeth, uidata, NULL, NULL))
-        == NULL) {
-        BIO_printf(bio_err, "Couldn't open file or uri %s\n", uri);
-        ERR_print_errors(bio_err);
-        return ret;
+    if ((store_ctx = OSSL_STORE_open(ent->uri, job->uimeth, job->uidata,
+                                     NULL, NULL)) == NULL) {
+        BIO_printf(ent->err, "Couldn't open file or uri %s\n", ent->uri);
+        ERR_print_errors(ent->err);
+        ent->errors = 1;
+        return;
     }
 
-    if (expected != 0) {
-        if (!OSSL_STORE_expect(store_ctx, expected)) {
-            ERR_print_errors(bio_err);
+    if (job->expected != 0) {
+        if (!OSSL_STORE_expect(store_ctx, job->expected)) {
+            ERR_print_errors(ent->err);
+            ent->errors = 1;
             goto end2;
         }
     }
 
-    if (criterion != 0) {
-        if (!OSSL_STORE_supports_search(store_ctx, criterion)) {
-            BIO_printf(bio_err,
+    if (job->criterion != 0) {
+        if (!OSSL_STORE_supports_search(store_ctx, job->criterion)) {
+            BIO_printf(ent->err,
                        "%s: the store scheme doesn't support the given search criteria.\n",
-                       prog);
+                       job->prog);
+            ent->errors = 1;
             goto end2;
         }
 
-        if (!OSSL_STORE_find(store_ctx, search)) {
-            ERR_print_errors(bio_err);
+        if (!OSSL_STORE_find(store_ctx, job->search)) {
+            ERR_print_errors(ent->err);
+            ent->errors = 1;
             goto end2;
         }
     }
 
-    /* From here on, we count errors, and we'll return the count at the end */
-    ret = 0;
+    if ((ent->infos = sk_OSSL_STORE_INFO_new_null()) == NULL) {
+        BIO_printf(ent->err, "%s: out of memory\n", job->prog);
+        ent->errors = 1;
+        goto end2;
+    }
+    ent->opened = 1;
 
     for (;;) {
         OSSL_STORE_INFO *info = OSSL_STORE_load(store_ctx);
-        int type = info == NULL ? 0 : OSSL_STORE_INFO_get_type(info);
-        const char *infostr =
-            info == NULL ? NULL : OSSL_STORE_INFO_type_string(type);
 
         if (info == NULL) {
             if (OSSL_STORE_eof(store_ctx))
                 break;
 
             if (OSSL_STORE_error(store_ctx)) {
-                if (recursive)
+                if (job->recursive)
                     ERR_clear_error();
                 else
-                    ERR_print_errors(bio_err);
-                ret++;
+                    ERR_print_errors(ent->err);
+                ent->errors++;
                 continue;
             }
 
-            BIO_printf(bio_err,
+            BIO_printf(ent->err,
                        "ERROR: OSSL_STORE_load() returned NULL without "
                        "eof or error indications\n");
-            BIO_printf(bio_err, "       This is an error in the loader\n");
-            ERR_print_errors(bio_err);
-            ret++;
+            BIO_printf(ent->err, "       This is an error in the loader\n");
+            ERR_print_errors(ent->err);
+            ent->errors++;
             break;
         }
 
+        if (!sk_OSSL_STORE_INFO_push(ent->infos, info)) {
+            OSSL_STORE_INFO_free(info);
+            BIO_printf(ent->err, "%s: out of memory\n", job->prog);
+            ent->errors++;
+            break;
+        }
+    }
+
+ end2:
+    if (!OSSL_STORE_close(store_ctx)) {
+        ERR_print_errors(ent->err);
+        ent->errors++;
+    }
+}
+
+static void free_entry(STORE_ENTRY *ent)
+{
+    int i;
+
+    if (ent->subs != NULL) {
+        for (i = 0; i < sk_OSSL_STORE_INFO_num(ent->infos); i++) {
+            free_entry(&ent->subs[i]);
+            BIO_free(ent->subs[i].err);
+        }
+        OPENSSL_free(ent->subs);
+    }
+    sk_OSSL_STORE_INFO_pop_free(ent->infos, OSSL_STORE_INFO_free);
+}
+
+static STORE_ENTRY *next_entry(STORE_JOB *job)
+{
+    STORE_ENTRY *ent = NULL;
+
+#ifdef STOREUTL_THREADS
+    pthread_mutex_lock(&job->lock);
+#endif
+    while (ent == NULL && job->next < job->nentries) {
+        ent = &job->entries[job->next++];
+        if (ent->uri == NULL)
+            ent = NULL;
+    }
+#ifdef STOREUTL_THREADS
+    pthread_mutex_unlock(&job->lock);
+#endif
+    return ent;
+}
+
+static void *load_entries(void *arg)
+{
+    STORE_JOB *job = arg;
+    STORE_ENTRY *ent;
+
+    while ((ent = next_entry(job)) != NULL)
+        load_entry(job, ent);
+    return NULL;
+}
+
+/*
+ * Loads the stores named in |ent| with the calling thread and up to
+ * |threads| - 1 more, into |ent->subs|.  The entries are printed later in
+ * their original order, so the output is the same as without threads.
+ */
+static void prefetch_entries(STORE_JOB *job, STORE_ENTRY *ent, int threads)
+{
+#ifdef STOREUTL_THREADS
+    pthread_t *tids;
+    int started = 0;
+#endif
+    STORE_JOB sub = *job;
+    int i, n = sk_OSSL_STORE_INFO_num(ent->infos);
+
+    if (n <= 0)
+        return;
+    ent->subs = app_malloc(n * sizeof(*ent->subs), "store entries");
+    memset(ent->subs, 0, n * sizeof(*ent->subs));
+    for (i = 0; i < n; i++) {
+        OSSL_STORE_INFO *info = sk_OSSL_STORE_INFO_value(ent->infos, i);
+
+        if (OSSL_STORE_INFO_get_type(info) != OSSL_STORE_INFO_NAME)
+            continue;
+        ent->subs[i].uri = OSSL_STORE_INFO_get0_NAME(info);
+        ent->subs[i].err = BIO_new(BIO_s_mem());
+        if (ent->subs[i].err == NULL)
+            ent->subs[i].uri = NULL;
+    }
+    sub.entries = ent->subs;
+    sub.nentries = n;
+    sub.next = 0;
+
+#ifdef STOREUTL_THREADS
+    tids = app_malloc(threads * sizeof(*tids), "loading threads");
+    pthread_mutex_init(&sub.lock, NULL);
+    for (i = 1; i < threads; i++)
+        if (pthread_create(&tids[started], NULL, load_entries, &sub) == 0)
+            started++;
+    load_entries(&sub);
+    for (i = 0; i < started; i++)
+        pthread_join(tids[i], NULL);
+    pthread_mutex_destroy(&sub.lock);
+    OPENSSL_free(tids);
+#else
+    load_entries(&sub);
+#endif
+}
+
+/*
+ * Prints the objects of a loaded |ent|, recursing into names if asked to.
+ * Returns the number of errors.
+ */
+static int print_entry(STORE_ENTRY *ent, STORE_JOB *job, int threads,
+                       int text, int noout, int indent, BIO *out)
+{
+    int ret = ent->errors, items;
+
+    if (!ent->opened)
+        return ret;
+
+    for (items = 0; items < sk_OSSL_STORE_INFO_num(ent->infos); items++) {
+        OSSL_STORE_INFO *info = sk_OSSL_STORE_INFO_value(ent->infos, items);
+        int type = OSSL_STORE_INFO_get_type(info);
+        const char *infostr = OSSL_STORE_INFO_type_string(type);
+
         if (type == OSSL_STORE_INFO_NAME) {
             const char *name = OSSL_STORE_INFO_get0_NAME(info);
             const char *desc = OSSL_STORE_INFO_get0_NAME_description(info);
@@ -418,11 +593,23 @@ static int process(const char *uri, const UI_METHOD *uimeth, PW_CB_DATA *uidata,
          */
         switch (type) {
         case OSSL_STORE_INFO_NAME:
-            if (recursive) {
+            if (job->recursive) {
                 const char *suburi = OSSL_STORE_INFO_get0_NAME(info);
-                ret += process(suburi, uimeth, uidata,
-                               expected, criterion, search,
-                               text, noout, recursive, indent + 2, out, prog);
+                STORE_ENTRY *sub = ent->subs == NULL ? NULL
+                                                     : &ent->subs[items];
+
+                if (sub != NULL && sub->uri != NULL) {
+                    char *msgs;
+                    long len = BIO_get_mem_data(sub->err, &msgs);
+
+                    if (len > 0)
+                        BIO_write(bio_err, msgs, (int)len);
+                    ret += print_entry(sub, job, threads, text, noout,
+                                       indent + 2, out);
+                } else {
+                    ret += process(suburi, job, threads, text, noout,
+                                   indent + 2, out);
+                }
             }
             break;
         case OSSL_STORE_INFO_PARAMS:
@@ -458,16 +645,30 @@ static int process(const char *uri, const UI_METHOD *uimeth, PW_CB_DATA *uidata,
             ret++;
             break;
         }
-        items++;
-        OSSL_STORE_INFO_free(info);
     }
     indent_printf(indent, out, "Total found: %d\n", items);
 
- end2:
-    if (!OSSL_STORE_close(store_ctx)) {
-        ERR_print_errors(bio_err);
-        ret++;
-    }
+    return ret;
+}
+
+/*
+ * Loads and prints the objects at |uri|.  With -r and more than one
+ * thread, the stores named at |uri| are all loaded in parallel before
+ * printing.  Returns the number of errors.
+ */
+static int process(const char *uri, STORE_JOB *job, int threads,
+                   int text, int noout, int indent, BIO *out)
+{
+    STORE_ENTRY ent;
+    int ret;
 
+    memset(&ent, 0, sizeof(ent));
+    ent.uri = uri;
+    ent.err = bio_err;
+    load_entry(job, &ent);
+    if (ent.opened && job->recursive && threads > 1)
+        prefetch_entries(job, &ent, threads);
+    ret = print_entry(&ent, job, threads, text, noout, indent, out);
+    free_entry(&ent);
     return ret;
 }
@@ -18,10 +18,31 @@
 #include <openssl/x509v3.h>
 #include <openssl/pem.h>
 
+#if defined(OPENSSL_THREADS) && !defined(OPENSSL_SYS_WINDOWS)
+# include <pthread.h>
+# define VERIFY_THREADS
+#endif
+
+typedef struct verify_job_st {
+    X509_STORE *store;
+    STACK_OF(X509) *untrusted;
+    char **files;
+    int nfiles, next;
+    /* Names of further certificate files, one per line */
+    BIO *list;
+    int failed;
+#ifdef VERIFY_THREADS
+    pthread_mutex_t lock;
+#endif
+} VERIFY_JOB;
+
 static int cb(int ok, X509_STORE_CTX *ctx);
 static int check(X509_STORE *ctx, const char *file,
                  STACK_OF(X509) *uchain, STACK_OF(X509) *tchain,
                  STACK_OF(X509_CRL) *crls, int show_chain);
+static int check_batch(X509_STORE *ctx, char **files, int nfiles,
+                       STACK_OF(X509) *uchain);
+static int check_bulk(VERIFY_JOB *job, int threads);
 static int v_verbose = 0, vflags = 0;
 
 typedef enum OPTION_choice {
@@ -29,7 +50,7 @@ typedef enum OPTION_choice {
     OPT_ENGINE, OPT_CAPATH, OPT_CAFILE, OPT_NOCAPATH, OPT_NOCAFILE,
     OPT_UNTRUSTED, OPT_TRUSTED, OPT_CRLFILE, OPT_CRL_DOWNLOAD, OPT_SHOW_CHAIN,
     OPT_V_ENUM, OPT_NAMEOPT,
-    OPT_VERBOSE
+    OPT_VERBOSE, OPT_BATCH, OPT_LIST, OPT_THREADS
 } OPTION_CHOICE;
 
 const OPTIONS verify_options[] = {
@@ -53,6 +74,14 @@ const OPTIONS verify_options[] = {
     {"show_chain", OPT_SHOW_CHAIN, '-',
         "Display information about the certificate chain"},
     {"nameopt", OPT_NAMEOPT, 's', "Various certificate name options"},
+    {"batch", OPT_BATCH, '-',
+        "Verify all certificates in one batch, sharing signature checks"},
+    {"list", OPT_LIST, '<',
+        "File with the names of more certificate files, one per line"},
+#ifdef VERIFY_THREADS
+    {"threads", OPT_THREADS, 'p',
+        "Number of threads verifying certificates"},
+#endif
     OPT_V_OPTIONS,
 #ifndef OPENSSL_NO_ENGINE
     {"engine", OPT_ENGINE, 's', "Use engine, possibly a hardware device"},
@@ -67,9 +96,11 @@ int verify_main(int argc, char **argv)
     STACK_OF(X509_CRL) *crls = NULL;
     X509_STORE *store = NULL;
     X509_VERIFY_PARAM *vpm = NULL;
-    const char *prog, *CApath = NULL, *CAfile = NULL;
+    const char *prog, *CApath = NULL, *CAfile = NULL, *listfile = NULL;
+    VERIFY_JOB job;
     int noCApath = 0, noCAfile = 0;
     int vpmtouched = 0, crl_download = 0, show_chain = 0, i = 0, ret = 1;
+    int batch = 0, threads = 0;
     OPTION_CHOICE o;
 
     if ((vpm = X509_VERIFY_PARAM_new()) == NULL)
@@ -158,6 +189,15 @@ int verify_main(int argc, char **argv)
         case OPT_VERBOSE:
             v_verbose = 1;
             break;
+        case OPT_BATCH:
+            batch = 1;
+            break;
+        case OPT_LIST:
+            listfile = opt_arg();
+            break;
+        case OPT_THREADS:
+            threads = atoi(opt_arg());
+            break;
         }
     }
     argc = opt_num_rest();
@@ -168,10 +208,31 @@ int verify_main(int argc, char **argv)
                    prog);
         goto end;
     }
+    if (batch && (argc < 1 || show_chain)) {
+        BIO_printf(bio_err,
+                   "%s: -batch needs certificate files and cannot be used"
+                   " with -show_chain\n", prog);
+        goto end;
+    }
+    memset(&job, 0, sizeof(job));
+    if (listfile != NULL || threads > 0) {
+        if (batch || show_chain) {
+            BIO_printf(bio_err,
+                       "%s: -list and -threads cannot be used with -batch"
+                       " or -show_chain\n", prog);
+            goto end;
+        }
+        if (listfile != NULL
+                && (job.list = bio_open_default(listfile, 'r',
+                                                FORMAT_TEXT)) == NULL)
+            goto end;
+    }
 
     if ((store = setup_verify(CAfile, CApath, noCAfile, noCApath)) == NULL)
         goto end;
-    X509_STORE_set_verify_cb(store, cb);
+    /* Results are reported per certificate in bulk mode */
+    if (threads == 0 && listfile == NULL)
+        X509_STORE_set_verify_cb(store, cb);
 
     if (vpmtouched)
         X509_STORE_set1_param(store, vpm);
@@ -181,8 +242,28 @@ int verify_main(int argc, char **argv)
     if (crl_download)
         store_setup_crl_download(store);
 
+    if (batch || threads > 0 || listfile != NULL) {
+        /* The batch shares the store, so that is where these go */
+        for (i = 0; i < sk_X509_num(trusted); i++)
+            if (!X509_STORE_add_cert(store, sk_X509_value(trusted, i)))
+                goto end;
+        for (i = 0; i < sk_X509_CRL_num(crls); i++)
+            if (!X509_STORE_add_crl(store, sk_X509_CRL_value(crls, i)))
+                goto end;
+    }
+
     ret = 0;
-    if (argc < 1) {
+    if (batch) {
+        if (check_batch(store, argv, argc, untrusted) != 1)
+            ret = -1;
+    } else if (threads > 0 || listfile != NULL) {
+        job.store = store;
+        job.untrusted = untrusted;
+        job.files = argv;
+        job.nfiles = argc;
+        if (check_bulk(&job, threads) != 1)
+            ret = -1;
+    } else if (argc < 1) {
         if (check(store, NULL, untrusted, trusted, crls, show_chain) != 1)
             ret = -1;
     } else {
@@ -193,6 +274,7 @@ int verify_main(int argc, char **argv)
     }
 
  end:
+    BIO_free(job.list);
     X509_VERIFY_PARAM_free(vpm);
     X509_STORE_free(store);
     sk_X509_pop_free(untrusted, X509_free);
@@ -269,6 +351,159 @@ static int check(X509_STORE *ctx, const char *file,
     return ret;
 }
 
+static int check_batch(X509_STORE *ctx, char **files, int nfiles,
+                       STACK_OF(X509) *uchain)
+{
+    X509 **certs = app_malloc(nfiles * sizeof(*certs), "certificates");
+    STACK_OF(X509) **uchains = app_malloc(nfiles * sizeof(*uchains),
+                                          "untrusted chains");
+    int *errors = app_malloc(nfiles * sizeof(*errors), "results");
+    int i, n = 0, ret = 0;
+
+    for (i = 0; i < nfiles; i++) {
+        if ((certs[i] = load_cert(files[i], FORMAT_PEM,
+                                  "certificate file")) == NULL) {
+            ERR_print_errors(bio_err);
+            goto end;
+        }
+        uchains[i] = uchain;
+        n++;
+    }
+
+    X509_STORE_set_flags(ctx, vflags);
+    if (X509_verify_cert_batch(ctx, certs, uchains, n, errors) < 0) {
+        ERR_print_errors(bio_err);
+        goto end;
+    }
+    ret = 1;
+    for (i = 0; i < n; i++) {
+        if (errors[i] == X509_V_OK) {
+            printf("%s: OK\n", files[i]);
+        } else {
+            printf("error %s: verification failed\n", files[i]);
+            ret = 0;
+        }
+    }
+
+ end:
+    for (i = 0; i < n; i++)
+        X509_free(certs[i]);
+    OPENSSL_free(certs);
+    OPENSSL_free(uchains);
+    OPENSSL_free(errors);
+    return ret;
+}
+
+static int next_file(VERIFY_JOB *job, char *buf, int len)
+{
+    size_t n;
+    int ret = 0;
+
+#ifdef VERIFY_THREADS
+    pthread_mutex_lock(&job->lock);
+#endif
+    if (job->next < job->nfiles) {
+        OPENSSL_strlcpy(buf, job->files[job->next++], len);
+        ret = 1;
+    }
+    while (!ret && job->list != NULL && BIO_gets(job->list, buf, len) > 0) {
+        n = strcspn(buf, "\r\n");
+        buf[n] = '\0';
+        ret = n > 0;
+    }
+#ifdef VERIFY_THREADS
+    pthread_mutex_unlock(&job->lock);
+#endif
+    return ret;
+}
+
+/*
+ * Verify certificates until there are none left, printing a line per
+ * certificate: its file name, the verification error code, the depth of
+ * the error and the error string, separated by tabs. The code is 0 for
+ * certificates that verified, and -1 for files that could not be loaded.
+ */
+static void *check_files(void *arg)
+{
+    VERIFY_JOB *job = arg;
+    X509_STORE_CTX *csc = X509_STORE_CTX_new();
+    X509 *x;
+    BIO *in;
+    char file[4096];
+    const char *msg;
+    int err, depth;
+
+    while (next_file(job, file, sizeof(file))) {
+        x = NULL;
+        err = -1;
+        depth = -1;
+        msg = "unable to load certificate";
+        if ((in = BIO_new_file(file, "r")) != NULL)
+            x = PEM_read_bio_X509_AUX(in, NULL, NULL, NULL);
+        BIO_free(in);
+        if (x != NULL && csc == NULL) {
+            msg = "X.509 store context allocation failed";
+        } else if (x != NULL) {
+            if (!X509_STORE_CTX_init(csc, job->store, x, job->untrusted)) {
+                msg = "X.509 store context initialization failed";
+            } else {
+                err = X509_verify_cert(csc) > 0 ? X509_V_OK : -1;
+                if (err != X509_V_OK
+                        || X509_STORE_CTX_get_error(csc) != X509_V_OK) {
+                    err = X509_STORE_CTX_get_error(csc);
+                    if (err == X509_V_OK)
+                        err = X509_V_ERR_UNSPECIFIED;
+                    depth = X509_STORE_CTX_get_error_depth(csc);
+                }
+                msg = X509_verify_cert_error_string(err);
+            }
+            X509_STORE_CTX_cleanup(csc);
+        }
+        X509_free(x);
+        ERR_clear_error();
+
+#ifdef VERIFY_THREADS
+        pthread_mutex_lock(&job->lock);
+#endif
+        printf("%s\t%d\t%d\t%s\n", file, err, depth, msg);
+        if (err != X509_V_OK)
+            job->failed = 1;
+#ifdef VERIFY_THREADS
+        pthread_mutex_unlock(&job->lock);
+#endif
+    }
+    X509_STORE_CTX_free(csc);
+    return NULL;
+}
+
+/*
+ * Verify the certificates of |job| with the calling thread and up to
+ * |threads| - 1 more sharing the store, in no particular order.
+ */
+static int check_bulk(VERIFY_JOB *job, int threads)
+{
+#ifdef VERIFY_THREADS
+    pthread_t *tids;
+    int i, started = 0;
+
+    if (threads < 1)
+        threads = 1;
+    tids = app_malloc(threads * sizeof(*tids), "verification threads");
+    pthread_mutex_init(&job->lock, NULL);
+    for (i = 1; i < threads; i++)
+        if (pthread_create(&tids[started], NULL, check_files, job) == 0)
+            started++;
+    check_files(job);
+    for (i = 0; i < started; i++)
+        pthread_join(tids[i], NULL);
+    pthread_mutex_destroy(&job->lock);
+    OPENSSL_free(tids);
+#else
+    check_files(job);
+#endif
+    return !job->failed;
+}
+
 static int cb(int ok, X509_STORE_CTX *ctx)
 {
     int cert_error = X509_STORE_CTX_get_error(ctx);
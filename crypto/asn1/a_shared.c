@@ -0,0 +1,107 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <string.h>
+#include "internal/cryptlib.h"
+#include "internal/refcount.h"
+#include <openssl/asn1.h>
+
+/*
+ * A reference counted buffer of encoded data, that the objects decoded from
+ * it can borrow their content from, see d2i_X509_shared().
+ */
+struct asn1_shared_buf_st {
+    unsigned char *data;
+    size_t length;
+    CRYPTO_REF_COUNT references;
+    CRYPTO_RWLOCK *lock;
+};
+
+ASN1_SHARED_BUF *ASN1_SHARED_BUF_new0(unsigned char *data, size_t len)
+{
+    ASN1_SHARED_BUF *buf;
+
+    if ((buf = OPENSSL_zalloc(sizeof(*buf))) == NULL) {
+        ASN1err(ASN1_F_ASN1_SHARED_BUF_NEW0, ERR_R_MALLOC_FAILURE);
+        return NULL;
+    }
+    if ((buf->lock = CRYPTO_THREAD_lock_new()) == NULL) {
+        ASN1err(ASN1_F_ASN1_SHARED_BUF_NEW0, ERR_R_MALLOC_FAILURE);
+        OPENSSL_free(buf);
+        return NULL;
+    }
+    buf->data = data;
+    buf->length = len;
+    buf->references = 1;
+    return buf;
+}
+
+ASN1_SHARED_BUF *ASN1_SHARED_BUF_new(const unsigned char *data, size_t len)
+{
+    ASN1_SHARED_BUF *buf;
+    unsigned char *copy;
+
+    /* Allocate at least a byte, so that the data is never NULL */
+    if ((copy = OPENSSL_malloc(len > 0 ? len : 1)) == NULL) {
+        ASN1err(ASN1_F_ASN1_SHARED_BUF_NEW, ERR_R_MALLOC_FAILURE);
+        return NULL;
+    }
+    if (len > 0)
+        memcpy(copy, data, len);
+    if ((buf = ASN1_SHARED_BUF_new0(copy, len)) == NULL)
+        OPENSSL_free(copy);
+    return buf;
+}
+
+int ASN1_SHARED_BUF_up_ref(ASN1_SHARED_BUF *buf)
+{
+    int i;
+
+    if (CRYPTO_UP_REF(&buf->references, &i, buf->lock) <= 0)
+        return 0;
+
+    REF_PRINT_COUNT("ASN1_SHARED_BUF", buf);
+    REF_ASSERT_ISNT(i < 2);
+    return ((i > 1) ? 1 : 0);
+}
+
+void ASN1_SHARED_BUF_free(ASN1_SHARED_BUF *buf)
+{
+    int i;
+
+    if (buf == NULL)
+        return;
+    CRYPTO_DOWN_REF(&buf->references, &i, buf->lock);
+    REF_PRINT_COUNT("ASN1_SHARED_BUF", buf);
+    if (i > 0)
+        return;
+    REF_ASSERT_ISNT(i < 0);
+
+    OPENSSL_free(buf->data);
+    CRYPTO_THREAD_lock_free(buf->lock);
+    OPENSSL_free(buf);
+}
+
+const unsigned char *ASN1_SHARED_BUF_get0_data(const ASN1_SHARED_BUF *buf)
+{
+    return buf->data;
+}
+
+size_t ASN1_SHARED_BUF_length(const ASN1_SHARED_BUF *buf)
+{
+    return buf->length;
+}
+
+/* Whether the |len| bytes at |p| are all part of |buf| */
+int asn1_shared_buf_contains(const ASN1_SHARED_BUF *buf,
+                             const unsigned char *p, size_t len)
+{
+    return p >= buf->data && p <= buf->data + buf->length
+           && len <= (size_t)(buf->data + buf->length - p);
+}
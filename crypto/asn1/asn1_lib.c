@@ -247,9 +247,10 @@ int ASN1_STRING_copy(ASN1_STRING *dst, const ASN1_STRING *str)
     dst->type = str->type;
     if (!ASN1_STRING_set(dst, str->data, str->length))
         return 0;
-    /* Copy flags but preserve embed value */
+    /* Copy flags but preserve embed value, the copy owns its content */
     dst->flags &= ASN1_STRING_FLAG_EMBED;
-    dst->flags |= str->flags & ~ASN1_STRING_FLAG_EMBED;
+    dst->flags |= str->flags
+                  & ~(ASN1_STRING_FLAG_EMBED | ASN1_STRING_FLAG_BORROWED);
     return 1;
 }
 
@@ -290,19 +291,24 @@ int ASN1_STRING_set(ASN1_STRING *str, const void *_data, int len_in)
         ASN1err(0, ASN1_R_TOO_LARGE);
         return 0;
     }
-    if ((size_t)str->length <= len || str->data == NULL) {
+    if ((size_t)str->length <= len || str->data == NULL
+            || (str->flags & ASN1_STRING_FLAG_BORROWED) != 0) {
         c = str->data;
+        /* Borrowed content can't be reallocated, it is replaced instead */
+        if ((str->flags & ASN1_STRING_FLAG_BORROWED) != 0)
+            str->data = NULL;
 #ifdef FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
         /* No NUL terminator in fuzzing builds */
-        str->data = OPENSSL_realloc(c, len != 0 ? len : 1);
+        str->data = OPENSSL_realloc(str->data, len != 0 ? len : 1);
 #else
-        str->data = OPENSSL_realloc(c, len + 1);
+        str->data = OPENSSL_realloc(str->data, len + 1);
 #endif
         if (str->data == NULL) {
             ASN1err(ASN1_F_ASN1_STRING_SET, ERR_R_MALLOC_FAILURE);
             str->data = c;
             return 0;
         }
+        str->flags &= ~ASN1_STRING_FLAG_BORROWED;
     }
     str->length = len;
     if (data != NULL) {
@@ -324,7 +330,9 @@ int ASN1_STRING_set(ASN1_STRING *str, const void *_data, int len_in)
 
 void ASN1_STRING_set0(ASN1_STRING *str, void *data, int len)
 {
-    OPENSSL_free(str->data);
+    if ((str->flags & ASN1_STRING_FLAG_BORROWED) == 0)
+        OPENSSL_free(str->data);
+    str->flags &= ~ASN1_STRING_FLAG_BORROWED;
     str->data = data;
     str->length = len;
 }
@@ -351,7 +359,7 @@ void asn1_string_embed_free(ASN1_STRING *a, int embed)
 {
     if (a == NULL)
         return;
-    if (!(a->flags & ASN1_STRING_FLAG_NDEF))
+    if (!(a->flags & (ASN1_STRING_FLAG_NDEF | ASN1_STRING_FLAG_BORROWED)))
         OPENSSL_free(a->data);
     if (embed == 0)
         OPENSSL_free(a);
@@ -368,7 +376,8 @@ void ASN1_STRING_clear_free(ASN1_STRING *a)
 {
     if (a == NULL)
         return;
-    if (a->data && !(a->flags & ASN1_STRING_FLAG_NDEF))
+    if (a->data
+            && !(a->flags & (ASN1_STRING_FLAG_NDEF | ASN1_STRING_FLAG_BORROWED)))
         OPENSSL_cleanse(a->data, a->length);
     ASN1_STRING_free(a);
 }
@@ -59,6 +59,38 @@ static const EVP_PKEY_ASN1_METHOD *standard_methods[] = {
 #ifndef OPENSSL_NO_SM2
     &sm2_asn1_meth,
 #endif
+///// OQS_TEMPLATE_FRAGMENT_KEM_ASN1_METHS_START
+    &frodo640aes_asn1_meth,
+    &frodo640shake_asn1_meth,
+    &frodo976aes_asn1_meth,
+    &frodo976shake_asn1_meth,
+    &frodo1344aes_asn1_meth,
+    &frodo1344shake_asn1_meth,
+    &kyber512_asn1_meth,
+    &kyber768_asn1_meth,
+    &kyber1024_asn1_meth,
+    &bikel1_asn1_meth,
+    &bikel3_asn1_meth,
+    &bikel5_asn1_meth,
+    &hqc128_asn1_meth,
+    &hqc192_asn1_meth,
+    &hqc256_asn1_meth,
+    &p256_frodo640aes_asn1_meth,
+    &p256_frodo640shake_asn1_meth,
+    &p384_frodo976aes_asn1_meth,
+    &p384_frodo976shake_asn1_meth,
+    &p521_frodo1344aes_asn1_meth,
+    &p521_frodo1344shake_asn1_meth,
+    &p256_kyber512_asn1_meth,
+    &p384_kyber768_asn1_meth,
+    &p521_kyber1024_asn1_meth,
+    &p256_bikel1_asn1_meth,
+    &p384_bikel3_asn1_meth,
+    &p521_bikel5_asn1_meth,
+    &p256_hqc128_asn1_meth,
+    &p384_hqc192_asn1_meth,
+    &p521_hqc256_asn1_meth,
+///// OQS_TEMPLATE_FRAGMENT_KEM_ASN1_METHS_END
 ///// OQS_TEMPLATE_FRAGMENT_SIG_ASN1_METHS_START
     &dilithium2_asn1_meth,
     &p256_dilithium2_asn1_meth,
@@ -84,4 +116,8 @@ static const EVP_PKEY_ASN1_METHOD *standard_methods[] = {
     &p256_sphincsshake128fsimple_asn1_meth,
     &rsa3072_sphincsshake128fsimple_asn1_meth,
 ///// OQS_TEMPLATE_FRAGMENT_SIG_ASN1_METHS_END
+#ifndef OPENSSL_NO_BLAKE2
+    &blake2b_mac_asn1_meth,
+    &blake2s_mac_asn1_meth,
+#endif
 };
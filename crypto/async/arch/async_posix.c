@@ -14,8 +14,19 @@
 
 # include <stddef.h>
 # include <unistd.h>
+# include <sys/mman.h>
+# if defined(__linux__)
+#  include <sys/syscall.h>
+# endif
 
-#define STACKSIZE       32768
+# if defined(MAP_ANON) && !defined(MAP_ANONYMOUS)
+#  define MAP_ANONYMOUS MAP_ANON
+# endif
+# ifndef MAP_STACK
+#  define MAP_STACK 0
+# endif
+/* From <linux/mempolicy.h>: allocate on the node of the touching CPU */
+# define ASYNC_MPOL_LOCAL 4
 
 int ASYNC_is_capable(void)
 {
@@ -32,13 +43,62 @@ void async_local_cleanup(void)
 {
 }
 
-int async_fibre_makecontext(async_fibre *fibre)
+# ifdef MAP_ANONYMOUS
+/*
+ * Stacks are mapped rather than malloc()ed so that an overflow hits an
+ * inaccessible guard page instead of the neighbouring heap, and so that
+ * their pages are fresh: they are allocated when the job first runs,
+ * on the memory node of the thread owning the pool.  The local policy
+ * is made explicit so that a process-wide interleave or bind policy
+ * does not spread the stacks of one thread over remote nodes.
+ */
+static void *async_stack_alloc(size_t *size)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    unsigned char *base;
+
+    *size = (*size + page - 1) & ~(page - 1);
+    base = mmap(NULL, *size + page, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (base == MAP_FAILED)
+        return NULL;
+    /* Stacks grow down on every platform with <ucontext.h> support */
+    if (mprotect(base, page, PROT_NONE) != 0) {
+        munmap(base, *size + page);
+        return NULL;
+    }
+#  if defined(__linux__) && defined(SYS_mbind)
+    /* Not fatal: older kernels lack MPOL_LOCAL and default to it anyway */
+    syscall(SYS_mbind, base + page, *size, ASYNC_MPOL_LOCAL, NULL, 0, 0);
+#  endif
+    return base + page;
+}
+
+static void async_stack_free(void *stack, size_t size)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+
+    munmap((unsigned char *)stack - page, size + page);
+}
+# else
+static void *async_stack_alloc(size_t *size)
+{
+    return OPENSSL_malloc(*size);
+}
+
+static void async_stack_free(void *stack, size_t size)
+{
+    OPENSSL_free(stack);
+}
+# endif
+
+int async_fibre_makecontext(async_fibre *fibre, size_t stack_size)
 {
     fibre->env_init = 0;
     if (getcontext(&fibre->fibre) == 0) {
-        fibre->fibre.uc_stack.ss_sp = OPENSSL_malloc(STACKSIZE);
+        fibre->fibre.uc_stack.ss_sp = async_stack_alloc(&stack_size);
         if (fibre->fibre.uc_stack.ss_sp != NULL) {
-            fibre->fibre.uc_stack.ss_size = STACKSIZE;
+            fibre->fibre.uc_stack.ss_size = stack_size;
             fibre->fibre.uc_link = NULL;
             makecontext(&fibre->fibre, async_start_func, 0);
             return 1;
@@ -51,7 +111,9 @@ int async_fibre_makecontext(async_fibre *fibre)
 
 void async_fibre_free(async_fibre *fibre)
 {
-    OPENSSL_free(fibre->fibre.uc_stack.ss_sp);
+    if (fibre->fibre.uc_stack.ss_sp != NULL)
+        async_stack_free(fibre->fibre.uc_stack.ss_sp,
+                         fibre->fibre.uc_stack.ss_size);
     fibre->fibre.uc_stack.ss_sp = NULL;
 }
 
@@ -50,7 +50,7 @@ static ossl_inline int async_fibre_swapcontext(async_fibre *o, async_fibre *n, i
 
 #  define async_fibre_init_dispatcher(d)
 
-int async_fibre_makecontext(async_fibre *fibre);
+int async_fibre_makecontext(async_fibre *fibre, size_t stack_size);
 void async_fibre_free(async_fibre *fibre);
 
 # endif
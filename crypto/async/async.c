@@ -20,6 +20,7 @@
 
 #include <openssl/err.h>
 #include "crypto/cryptlib.h"
+#include "internal/metrics.h"
 #include <string.h>
 
 #define ASYNC_JOB_RUNNING   0
@@ -30,6 +31,9 @@
 static CRYPTO_THREAD_LOCAL ctxkey;
 static CRYPTO_THREAD_LOCAL poolkey;
 
+/* Stack size of jobs created from now on, in any thread */
+static size_t async_stack_size = ASYNC_DEFAULT_STACK_SIZE;
+
 static async_ctx *async_ctx_new(void)
 {
     async_ctx *nctx;
@@ -86,6 +90,12 @@ static ASYNC_JOB *async_job_new(void)
     }
 
     job->status = ASYNC_JOB_RUNNING;
+    job->stack_size = async_stack_size;
+    if (!async_fibre_makecontext(&job->fibrectx, job->stack_size)) {
+        OPENSSL_free(job);
+        return NULL;
+    }
+    OSSL_METRIC_INC(OSSL_METRIC_ASYNC_JOBS);
 
     return job;
 }
@@ -96,6 +106,7 @@ static void async_job_free(ASYNC_JOB *job)
         OPENSSL_free(job->funcargs);
         async_fibre_free(&job->fibrectx);
         OPENSSL_free(job);
+        OSSL_METRIC_DEC(OSSL_METRIC_ASYNC_JOBS);
     }
 }
 
@@ -115,19 +126,31 @@ static ASYNC_JOB *async_get_pool_job(void) {
     }
 
     job = sk_ASYNC_JOB_pop(pool->jobs);
-    if (job == NULL) {
-        /* Pool is empty */
-        if ((pool->max_size != 0) && (pool->curr_size >= pool->max_size))
-            return NULL;
+    if (job != NULL && job->stack_size < async_stack_size) {
+        /* The stack size was raised since this job was created */
+        async_job_free(job);
+        pool->curr_size--;
+        pool->stack_reallocs++;
+        job = NULL;
+    } else if (job != NULL) {
+        pool->hits++;
+        OSSL_METRIC_INC(OSSL_METRIC_ASYNC_POOL_HITS);
+        return job;
+    }
 
-        job = async_job_new();
-        if (job != NULL) {
-            if (! async_fibre_makecontext(&job->fibrectx)) {
-                async_job_free(job);
-                return NULL;
-            }
-            pool->curr_size++;
-        }
+    /* Pool is empty */
+    if ((pool->max_size != 0) && (pool->curr_size >= pool->max_size)) {
+        pool->exhausted++;
+        OSSL_METRIC_INC(OSSL_METRIC_ASYNC_POOL_EXHAUSTED);
+        return NULL;
+    }
+
+    job = async_job_new();
+    if (job != NULL) {
+        pool->misses++;
+        OSSL_METRIC_INC(OSSL_METRIC_ASYNC_POOL_MISSES);
+        if (++pool->curr_size > pool->high_water)
+            pool->high_water = pool->curr_size;
     }
     return job;
 }
@@ -138,7 +161,12 @@ static void async_release_job(ASYNC_JOB *job) {
     pool = (async_pool *)CRYPTO_THREAD_get_local(&poolkey);
     OPENSSL_free(job->funcargs);
     job->funcargs = NULL;
-    sk_ASYNC_JOB_push(pool->jobs, job);
+    /* The pool may have been shrunk while the job was running */
+    if ((pool->max_size != 0 && pool->curr_size > pool->max_size)
+            || !sk_ASYNC_JOB_push(pool->jobs, job)) {
+        async_job_free(job);
+        pool->curr_size--;
+    }
 }
 
 void async_start_func(void)
@@ -313,6 +341,37 @@ void async_deinit(void)
     CRYPTO_THREAD_cleanup_local(&poolkey);
 }
 
+/*
+ * Called when ASYNC_init_thread() is repeated: idle jobs beyond |max_size|
+ * are freed now, running ones when they finish, and at least |init_size|
+ * jobs are kept
+ */
+static int async_resize_pool(async_pool *pool, size_t max_size,
+                             size_t init_size)
+{
+    ASYNC_JOB *job;
+
+    pool->max_size = max_size;
+    while (max_size != 0 && pool->curr_size > max_size
+           && (job = sk_ASYNC_JOB_pop(pool->jobs)) != NULL) {
+        async_job_free(job);
+        pool->curr_size--;
+    }
+    while (pool->curr_size < init_size) {
+        if ((job = async_job_new()) == NULL)
+            break;
+        if (!sk_ASYNC_JOB_push(pool->jobs, job)) {
+            async_job_free(job);
+            break;
+        }
+        pool->curr_size++;
+    }
+    if (pool->curr_size > pool->high_water)
+        pool->high_water = pool->curr_size;
+
+    return 1;
+}
+
 int ASYNC_init_thread(size_t max_size, size_t init_size)
 {
     async_pool *pool;
@@ -329,6 +388,10 @@ int ASYNC_init_thread(size_t max_size, size_t init_size)
     if (!ossl_init_thread_start(OPENSSL_INIT_THREAD_ASYNC))
         return 0;
 
+    pool = (async_pool *)CRYPTO_THREAD_get_local(&poolkey);
+    if (pool != NULL)
+        return async_resize_pool(pool, max_size, init_size);
+
     pool = OPENSSL_zalloc(sizeof(*pool));
     if (pool == NULL) {
         ASYNCerr(ASYNC_F_ASYNC_INIT_THREAD, ERR_R_MALLOC_FAILURE);
@@ -348,12 +411,11 @@ int ASYNC_init_thread(size_t max_size, size_t init_size)
     while (init_size--) {
         ASYNC_JOB *job;
         job = async_job_new();
-        if (job == NULL || !async_fibre_makecontext(&job->fibrectx)) {
+        if (job == NULL) {
             /*
              * Not actually fatal because we already created the pool, just
              * skip creation of any more jobs
              */
-            async_job_free(job);
             break;
         }
         job->funcargs = NULL;
@@ -361,6 +423,7 @@ int ASYNC_init_thread(size_t max_size, size_t init_size)
         curr_size++;
     }
     pool->curr_size = curr_size;
+    pool->high_water = curr_size;
     if (!CRYPTO_THREAD_set_local(&poolkey, pool)) {
         ASYNCerr(ASYNC_F_ASYNC_INIT_THREAD, ASYNC_R_FAILED_TO_SET_POOL);
         goto err;
@@ -396,6 +459,55 @@ void ASYNC_cleanup_thread(void)
     async_delete_thread_state();
 }
 
+int ASYNC_set_stack_size(size_t size)
+{
+    if (size == 0) {
+        size = ASYNC_DEFAULT_STACK_SIZE;
+    } else if (size < ASYNC_MIN_STACK_SIZE) {
+        ASYNCerr(ASYNC_F_ASYNC_SET_STACK_SIZE, ASYNC_R_INVALID_STACK_SIZE);
+        return 0;
+    }
+    async_stack_size = size;
+    return 1;
+}
+
+size_t ASYNC_get_stack_size(void)
+{
+    return async_stack_size;
+}
+
+size_t ASYNC_get_pool_stat(int stat)
+{
+    async_pool *pool;
+
+    if (!OPENSSL_init_crypto(OPENSSL_INIT_ASYNC, NULL))
+        return 0;
+
+    pool = (async_pool *)CRYPTO_THREAD_get_local(&poolkey);
+    if (pool == NULL)
+        return 0;
+
+    switch (stat) {
+    case ASYNC_POOL_STAT_SIZE:
+        return pool->curr_size;
+    case ASYNC_POOL_STAT_IDLE:
+        return (size_t)sk_ASYNC_JOB_num(pool->jobs);
+    case ASYNC_POOL_STAT_MAX_SIZE:
+        return pool->max_size;
+    case ASYNC_POOL_STAT_HIGH_WATER:
+        return pool->high_water;
+    case ASYNC_POOL_STAT_HITS:
+        return pool->hits;
+    case ASYNC_POOL_STAT_MISSES:
+        return pool->misses;
+    case ASYNC_POOL_STAT_EXHAUSTED:
+        return pool->exhausted;
+    case ASYNC_POOL_STAT_STACK_REALLOCS:
+        return pool->stack_reallocs;
+    }
+    return 0;
+}
+
 ASYNC_JOB *ASYNC_get_current_job(void)
 {
     async_ctx *ctx;
@@ -0,0 +1,330 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Batch queues: operations of the same kind submitted from different
+ * ASYNC_JOBs, typically one per connection, are held back until enough of
+ * them have been collected or the oldest has waited long enough, and then
+ * run together by a function that can take advantage of having several
+ * independent inputs.  Each job pauses until its result is ready and is
+ * woken up through its ASYNC_WAIT_CTX like with an asynchronous engine.
+ * The batch is run by whichever thread completes it: the job submitting
+ * the last operation, a paused job that finds the delay over when it is
+ * resumed, or the application calling OSSL_BATCH_QUEUE_poll().
+ */
+
+/* This must be the first #include file */
+#include "async_local.h"
+
+#include <string.h>
+#include <openssl/err.h>
+#include "internal/numbers.h"
+
+#ifdef ASYNC_WAKEUP_FDS
+# include <sys/time.h>
+
+typedef struct batch_group_st BATCH_GROUP;
+
+typedef struct batch_op_st {
+    void *op;
+    int result;
+    int done;                   /* protected by the queue lock */
+    int notify_fd;
+    BATCH_GROUP *group;
+    struct batch_op_st *next;
+} BATCH_OP;
+
+/* Operations of one kind collected so far */
+struct batch_group_st {
+    OSSL_BATCH_FN run;
+    const void *kind;
+    BATCH_OP *head;
+    BATCH_OP *tail;
+    size_t num_ops;
+    size_t uncollected;         /* submitters yet to pick up their result */
+    uint64_t deadline;
+    int running;
+    ASYNC_SAVED_ERRS errs;
+    BATCH_GROUP *next;
+};
+
+struct ossl_batch_queue_st {
+    CRYPTO_RWLOCK *lock;
+    size_t max_ops;
+    uint64_t max_delay;
+    BATCH_GROUP *groups;        /* groups that are not running yet */
+};
+
+static uint64_t batch_now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/* Takes |group| off the queue, called with the queue lock held */
+static void batch_group_detach(OSSL_BATCH_QUEUE *queue, BATCH_GROUP *group)
+{
+    BATCH_GROUP **p;
+
+    for (p = &queue->groups; *p != group; p = &(*p)->next)
+        continue;
+    *p = group->next;
+    group->next = NULL;
+    group->running = 1;
+}
+
+/*
+ * Runs the operations of a detached |group| and wakes up their submitters,
+ * except for |self| which is the caller's own. Errors raised by the batch
+ * are handed to the submitters of the operations that failed, and the
+ * caller's error queue is left as it was.
+ */
+static void batch_group_run(OSSL_BATCH_QUEUE *queue, BATCH_GROUP *group,
+                            const BATCH_OP *self)
+{
+    ASYNC_SAVED_ERRS prior;
+    BATCH_OP *bop;
+    void **ops;
+    int *results;
+    size_t i, num = group->num_ops;
+
+    prior.num = 0;
+    async_errs_save(&prior);
+    ops = OPENSSL_malloc(num * sizeof(*ops));
+    results = OPENSSL_malloc(num * sizeof(*results));
+    if (ops != NULL && results != NULL) {
+        for (i = 0, bop = group->head; bop != NULL; i++, bop = bop->next) {
+            ops[i] = bop->op;
+            results[i] = 0;
+        }
+        group->run(ops, results, num);
+        for (i = 0, bop = group->head; bop != NULL; i++, bop = bop->next)
+            bop->result = results[i];
+    } else {
+        /* Still better than failing all of them */
+        for (bop = group->head; bop != NULL; bop = bop->next)
+            group->run(&bop->op, &bop->result, 1);
+    }
+    OPENSSL_free(ops);
+    OPENSSL_free(results);
+    async_errs_save(&group->errs);
+    async_errs_restore(&prior);
+    async_errs_clear(&prior);
+
+    CRYPTO_THREAD_write_lock(queue->lock);
+    for (bop = group->head; bop != NULL; bop = bop->next) {
+        bop->done = 1;
+        if (bop != self)
+            async_wakeup_notify(bop->notify_fd);
+    }
+    CRYPTO_THREAD_unlock(queue->lock);
+}
+
+/* Runs the groups on |queue| whose delay is over, or all of them */
+static size_t batch_queue_run(OSSL_BATCH_QUEUE *queue, int expired_only)
+{
+    BATCH_GROUP *group;
+    uint64_t now = batch_now();
+    size_t num = 0;
+
+    for (;;) {
+        CRYPTO_THREAD_write_lock(queue->lock);
+        for (group = queue->groups; group != NULL; group = group->next)
+            if (!expired_only || group->deadline <= now)
+                break;
+        if (group == NULL) {
+            CRYPTO_THREAD_unlock(queue->lock);
+            return num;
+        }
+        batch_group_detach(queue, group);
+        CRYPTO_THREAD_unlock(queue->lock);
+
+        num += group->num_ops;
+        batch_group_run(queue, group, NULL);
+    }
+}
+
+OSSL_BATCH_QUEUE *OSSL_BATCH_QUEUE_new(size_t max_ops,
+                                       unsigned long max_delay_usec)
+{
+    OSSL_BATCH_QUEUE *queue;
+
+    if (max_ops == 0) {
+        ASYNCerr(ASYNC_F_OSSL_BATCH_QUEUE_NEW, ASYNC_R_INVALID_BATCH_SIZE);
+        return NULL;
+    }
+    if ((queue = OPENSSL_zalloc(sizeof(*queue))) == NULL) {
+        ASYNCerr(ASYNC_F_OSSL_BATCH_QUEUE_NEW, ERR_R_MALLOC_FAILURE);
+        return NULL;
+    }
+    if ((queue->lock = CRYPTO_THREAD_lock_new()) == NULL) {
+        ASYNCerr(ASYNC_F_OSSL_BATCH_QUEUE_NEW, ERR_R_MALLOC_FAILURE);
+        OPENSSL_free(queue);
+        return NULL;
+    }
+    queue->max_ops = max_ops;
+    queue->max_delay = max_delay_usec;
+    return queue;
+}
+
+void OSSL_BATCH_QUEUE_free(OSSL_BATCH_QUEUE *queue)
+{
+    if (queue == NULL)
+        return;
+    batch_queue_run(queue, 0);
+    CRYPTO_THREAD_lock_free(queue->lock);
+    OPENSSL_free(queue);
+}
+
+int OSSL_BATCH_QUEUE_submit(OSSL_BATCH_QUEUE *queue, OSSL_BATCH_FN run,
+                            const void *kind, void *op)
+{
+    ASYNC_JOB *job = ASYNC_get_current_job();
+    ASYNC_WAIT_CTX *waitctx;
+    ASYNC_WAKEUP *wakeup;
+    BATCH_GROUP *group;
+    BATCH_OP bop;
+    int result;
+
+    if (queue == NULL || job == NULL || async_get_ctx()->blocked != 0
+            || (waitctx = ASYNC_get_wait_ctx(job)) == NULL
+            || (wakeup = async_wait_ctx_get_wakeup(waitctx)) == NULL)
+        goto direct;
+
+    memset(&bop, 0, sizeof(bop));
+    bop.op = op;
+    bop.notify_fd = wakeup->wfd;
+
+    CRYPTO_THREAD_write_lock(queue->lock);
+    for (group = queue->groups; group != NULL; group = group->next)
+        if (group->run == run && group->kind == kind)
+            break;
+    if (group == NULL) {
+        if ((group = OPENSSL_zalloc(sizeof(*group))) == NULL) {
+            CRYPTO_THREAD_unlock(queue->lock);
+            goto direct;
+        }
+        group->run = run;
+        group->kind = kind;
+        group->deadline = batch_now() + queue->max_delay;
+        group->next = queue->groups;
+        queue->groups = group;
+    }
+    if (group->tail != NULL)
+        group->tail->next = &bop;
+    else
+        group->head = &bop;
+    group->tail = &bop;
+    group->num_ops++;
+    group->uncollected++;
+    bop.group = group;
+
+    for (;;) {
+        if (bop.done)
+            break;
+        if (!group->running
+                && (group->num_ops >= queue->max_ops
+                    || group->deadline <= batch_now())) {
+            batch_group_detach(queue, group);
+            CRYPTO_THREAD_unlock(queue->lock);
+            batch_group_run(queue, group, &bop);
+        } else {
+            CRYPTO_THREAD_unlock(queue->lock);
+            ASYNC_pause_job();
+            async_wakeup_drain(wakeup);
+        }
+        CRYPTO_THREAD_write_lock(queue->lock);
+    }
+
+    result = bop.result;
+    if (result <= 0)
+        async_errs_restore(&group->errs);
+    if (--group->uncollected == 0) {
+        async_errs_clear(&group->errs);
+        OPENSSL_free(group);
+    }
+    CRYPTO_THREAD_unlock(queue->lock);
+    return result;
+
+ direct:
+    result = 0;
+    run(&op, &result, 1);
+    return result;
+}
+
+int OSSL_BATCH_QUEUE_get_timeout(OSSL_BATCH_QUEUE *queue,
+                                 unsigned long *usec)
+{
+    BATCH_GROUP *group;
+    uint64_t deadline = UINT64_MAX, now;
+
+    CRYPTO_THREAD_write_lock(queue->lock);
+    for (group = queue->groups; group != NULL; group = group->next)
+        if (group->deadline < deadline)
+            deadline = group->deadline;
+    CRYPTO_THREAD_unlock(queue->lock);
+
+    if (deadline == UINT64_MAX)
+        return 0;
+    now = batch_now();
+    *usec = deadline > now ? (unsigned long)(deadline - now) : 0;
+    return 1;
+}
+
+size_t OSSL_BATCH_QUEUE_poll(OSSL_BATCH_QUEUE *queue)
+{
+    return batch_queue_run(queue, 1);
+}
+
+size_t OSSL_BATCH_QUEUE_flush(OSSL_BATCH_QUEUE *queue)
+{
+    return batch_queue_run(queue, 0);
+}
+
+#else /* ASYNC_WAKEUP_FDS */
+
+OSSL_BATCH_QUEUE *OSSL_BATCH_QUEUE_new(size_t max_ops,
+                                       unsigned long max_delay_usec)
+{
+    ASYNCerr(ASYNC_F_OSSL_BATCH_QUEUE_NEW, ERR_R_DISABLED);
+    return NULL;
+}
+
+void OSSL_BATCH_QUEUE_free(OSSL_BATCH_QUEUE *queue)
+{
+}
+
+int OSSL_BATCH_QUEUE_submit(OSSL_BATCH_QUEUE *queue, OSSL_BATCH_FN run,
+                            const void *kind, void *op)
+{
+    int result = 0;
+
+    run(&op, &result, 1);
+    return result;
+}
+
+int OSSL_BATCH_QUEUE_get_timeout(OSSL_BATCH_QUEUE *queue,
+                                 unsigned long *usec)
+{
+    return 0;
+}
+
+size_t OSSL_BATCH_QUEUE_poll(OSSL_BATCH_QUEUE *queue)
+{
+    return 0;
+}
+
+size_t OSSL_BATCH_QUEUE_flush(OSSL_BATCH_QUEUE *queue)
+{
+    return 0;
+}
+
+#endif /* ASYNC_WAKEUP_FDS */
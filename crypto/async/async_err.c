@@ -19,10 +19,16 @@ static const ERR_STRING_DATA ASYNC_str_functs[] = {
      "ASYNC_init_thread"},
     {ERR_PACK(ERR_LIB_ASYNC, ASYNC_F_ASYNC_JOB_NEW, 0), "async_job_new"},
     {ERR_PACK(ERR_LIB_ASYNC, ASYNC_F_ASYNC_PAUSE_JOB, 0), "ASYNC_pause_job"},
+    {ERR_PACK(ERR_LIB_ASYNC, ASYNC_F_ASYNC_SET_STACK_SIZE, 0),
+     "ASYNC_set_stack_size"},
     {ERR_PACK(ERR_LIB_ASYNC, ASYNC_F_ASYNC_START_FUNC, 0), "async_start_func"},
     {ERR_PACK(ERR_LIB_ASYNC, ASYNC_F_ASYNC_START_JOB, 0), "ASYNC_start_job"},
     {ERR_PACK(ERR_LIB_ASYNC, ASYNC_F_ASYNC_WAIT_CTX_SET_WAIT_FD, 0),
      "ASYNC_WAIT_CTX_set_wait_fd"},
+    {ERR_PACK(ERR_LIB_ASYNC, ASYNC_F_OSSL_BATCH_QUEUE_NEW, 0),
+     "OSSL_BATCH_QUEUE_new"},
+    {ERR_PACK(ERR_LIB_ASYNC, ASYNC_F_OSSL_WORKER_POOL_NEW, 0),
+     "OSSL_WORKER_POOL_new"},
     {0, NULL}
 };
 
@@ -32,8 +38,12 @@ static const ERR_STRING_DATA ASYNC_str_reasons[] = {
     {ERR_PACK(ERR_LIB_ASYNC, 0, ASYNC_R_FAILED_TO_SWAP_CONTEXT),
     "failed to swap context"},
     {ERR_PACK(ERR_LIB_ASYNC, 0, ASYNC_R_INIT_FAILED), "init failed"},
+    {ERR_PACK(ERR_LIB_ASYNC, 0, ASYNC_R_INVALID_BATCH_SIZE),
+    "invalid batch size"},
     {ERR_PACK(ERR_LIB_ASYNC, 0, ASYNC_R_INVALID_POOL_SIZE),
     "invalid pool size"},
+    {ERR_PACK(ERR_LIB_ASYNC, 0, ASYNC_R_INVALID_STACK_SIZE),
+     "invalid stack size"},
     {0, NULL}
 };
 
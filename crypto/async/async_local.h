@@ -36,8 +36,13 @@ struct async_ctx_st {
     unsigned int blocked;
 };
 
+/* Default and smallest stack sizes for new jobs, see ASYNC_set_stack_size() */
+#define ASYNC_DEFAULT_STACK_SIZE    (128 * 1024)
+#define ASYNC_MIN_STACK_SIZE        (16 * 1024)
+
 struct async_job_st {
     async_fibre fibrectx;
+    size_t stack_size;
     int (*func) (void *);
     void *funcargs;
     int ret;
@@ -67,6 +72,12 @@ struct async_pool_st {
     STACK_OF(ASYNC_JOB) *jobs;
     size_t curr_size;
     size_t max_size;
+    /* Statistics, see ASYNC_get_pool_stat() */
+    size_t high_water;
+    size_t hits;
+    size_t misses;
+    size_t exhausted;
+    size_t stack_reallocs;
 };
 
 void async_local_cleanup(void);
@@ -75,3 +86,40 @@ async_ctx *async_get_ctx(void);
 
 void async_wait_ctx_reset_counts(ASYNC_WAIT_CTX *ctx);
 
+#if defined(OPENSSL_SYS_UNIX)
+# define ASYNC_WAKEUP_FDS
+
+/*
+ * A pipe registered with an ASYNC_WAIT_CTX, written to by whoever completes
+ * an operation that a paused job is waiting for.  Shared by the worker pools
+ * and batch queues.
+ */
+typedef struct async_wakeup_st {
+    int rfd;
+    int wfd;
+} ASYNC_WAKEUP;
+
+ASYNC_WAKEUP *async_wait_ctx_get_wakeup(ASYNC_WAIT_CTX *ctx);
+void async_wakeup_notify(int wfd);
+void async_wakeup_drain(const ASYNC_WAKEUP *wakeup);
+#endif
+
+/* Errors raised on one thread and reported on another */
+#define ASYNC_MAX_SAVED_ERRS    4
+
+typedef struct async_saved_err_st {
+    unsigned long code;
+    const char *file;
+    int line;
+    char *data;
+} ASYNC_SAVED_ERR;
+
+typedef struct async_saved_errs_st {
+    size_t num;
+    ASYNC_SAVED_ERR errs[ASYNC_MAX_SAVED_ERRS];
+} ASYNC_SAVED_ERRS;
+
+void async_errs_save(ASYNC_SAVED_ERRS *errs);
+void async_errs_restore(const ASYNC_SAVED_ERRS *errs);
+void async_errs_clear(ASYNC_SAVED_ERRS *errs);
+
@@ -11,6 +11,11 @@
 #include "async_local.h"
 
 #include <openssl/err.h>
+#ifdef ASYNC_WAKEUP_FDS
+# include <errno.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
 
 ASYNC_WAIT_CTX *ASYNC_WAIT_CTX_new(void)
 {
@@ -211,3 +216,67 @@ void async_wait_ctx_reset_counts(ASYNC_WAIT_CTX *ctx)
         curr = curr->next;
     }
 }
+
+#ifdef ASYNC_WAKEUP_FDS
+
+static const char async_wakeup_key[] = "async_wakeup";
+
+static void async_wakeup_cleanup(ASYNC_WAIT_CTX *ctx, const void *key,
+                                 OSSL_ASYNC_FD rfd, void *custom)
+{
+    ASYNC_WAKEUP *wakeup = custom;
+
+    close(wakeup->rfd);
+    close(wakeup->wfd);
+    OPENSSL_free(wakeup);
+}
+
+/*
+ * Returns the wakeup pipe of |ctx|, creating and registering it on first
+ * use, or NULL if that fails.
+ */
+ASYNC_WAKEUP *async_wait_ctx_get_wakeup(ASYNC_WAIT_CTX *ctx)
+{
+    ASYNC_WAKEUP *wakeup = NULL;
+    OSSL_ASYNC_FD rfd;
+    void *custom = NULL;
+    int fds[2];
+
+    if (ASYNC_WAIT_CTX_get_fd(ctx, async_wakeup_key, &rfd, &custom))
+        return custom;
+
+    if (pipe(fds) != 0)
+        return NULL;
+    if (fcntl(fds[0], F_SETFL, O_NONBLOCK) != 0
+            || fcntl(fds[1], F_SETFL, O_NONBLOCK) != 0
+            || (wakeup = OPENSSL_malloc(sizeof(*wakeup))) == NULL) {
+        close(fds[0]);
+        close(fds[1]);
+        return NULL;
+    }
+    wakeup->rfd = fds[0];
+    wakeup->wfd = fds[1];
+    if (!ASYNC_WAIT_CTX_set_wait_fd(ctx, async_wakeup_key, wakeup->rfd,
+                                    wakeup, async_wakeup_cleanup)) {
+        async_wakeup_cleanup(ctx, async_wakeup_key, wakeup->rfd, wakeup);
+        return NULL;
+    }
+    return wakeup;
+}
+
+void async_wakeup_notify(int wfd)
+{
+    /* A full pipe is as good as a byte more */
+    while (write(wfd, "", 1) < 0 && errno == EINTR)
+        continue;
+}
+
+void async_wakeup_drain(const ASYNC_WAKEUP *wakeup)
+{
+    char buf[16];
+
+    while (read(wakeup->rfd, buf, sizeof(buf)) > 0)
+        continue;
+}
+
+#endif /* ASYNC_WAKEUP_FDS */
@@ -0,0 +1,383 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Worker pools: threads that take expensive operations, such as public key
+ * signatures, off the thread that asked for them.  A caller running inside
+ * an ASYNC_JOB queues the operation and pauses its job; a worker writes to
+ * a pipe registered with the job's ASYNC_WAIT_CTX once the operation is
+ * done, so that event driven applications are woken up like they are by an
+ * asynchronous engine.  Outside an ASYNC_JOB a single operation simply runs
+ * on the calling thread.
+ */
+
+/* This must be the first #include file */
+#include "async_local.h"
+
+#include <string.h>
+#include <openssl/err.h>
+
+#if defined(OPENSSL_THREADS) && defined(ASYNC_WAKEUP_FDS)
+# define WORKER_POOL_THREADS
+# include <pthread.h>
+#endif
+
+/* Maximum number of operations a worker takes off the queue at once */
+#define WORKER_POOL_BATCH       16
+
+/* Moves the errors raised on this thread into |errs| */
+void async_errs_save(ASYNC_SAVED_ERRS *errs)
+{
+    unsigned long code;
+    const char *file, *data;
+    int line, flags;
+    ASYNC_SAVED_ERR *e;
+
+    while ((code = ERR_get_error_line_data(&file, &line, &data, &flags))
+           != 0) {
+        if (errs->num == ASYNC_MAX_SAVED_ERRS)
+            continue;
+        e = &errs->errs[errs->num++];
+        e->code = code;
+        e->file = file;
+        e->line = line;
+        e->data = (flags & ERR_TXT_STRING) != 0 ? OPENSSL_strdup(data) : NULL;
+    }
+}
+
+/* Raises the errors saved in |errs| on the calling thread */
+void async_errs_restore(const ASYNC_SAVED_ERRS *errs)
+{
+    size_t i;
+
+    for (i = 0; i < errs->num; i++) {
+        const ASYNC_SAVED_ERR *e = &errs->errs[i];
+
+        ERR_put_error(ERR_GET_LIB(e->code), ERR_GET_FUNC(e->code),
+                      ERR_GET_REASON(e->code), e->file, e->line);
+        if (e->data != NULL)
+            ERR_add_error_data(1, e->data);
+    }
+}
+
+void async_errs_clear(ASYNC_SAVED_ERRS *errs)
+{
+    size_t i;
+
+    for (i = 0; i < errs->num; i++)
+        OPENSSL_free(errs->errs[i].data);
+    errs->num = 0;
+}
+
+#ifdef WORKER_POOL_THREADS
+
+/* Operations queued together, and whoever is waiting for them */
+typedef struct worker_wait_st {
+    size_t pending;             /* protected by the pool lock */
+    int notify_fd;              /* wakeup pipe of a paused job, or -1 */
+} WORKER_WAIT;
+
+typedef struct worker_job_st {
+    int (*run) (void *arg);
+    void (*run_void) (void *arg);
+    void *arg;
+    int ret;
+    WORKER_WAIT *wait;
+    ASYNC_SAVED_ERRS errs;
+    struct worker_job_st *next;
+} WORKER_JOB;
+
+struct ossl_worker_pool_st {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;        /* operations were queued */
+    pthread_cond_t done;        /* a blocking wait may be over */
+    WORKER_JOB *head;
+    WORKER_JOB *tail;
+    size_t queued;
+    int shutdown;
+    size_t num_threads;
+    pthread_t *threads;
+};
+
+static void *worker_pool_thread(void *arg)
+{
+    OSSL_WORKER_POOL *pool = arg;
+    WORKER_JOB *batch[WORKER_POOL_BATCH];
+    size_t i, n, max;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->head == NULL && !pool->shutdown)
+            pthread_cond_wait(&pool->cond, &pool->lock);
+        if (pool->head == NULL) {
+            /* Shutting down and nothing left to do */
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        /*
+         * Leave a share of the queue to the other workers: a signature can
+         * take milliseconds, so a batch must not hold up a whole burst.
+         */
+        max = pool->queued / pool->num_threads;
+        if (max > WORKER_POOL_BATCH)
+            max = WORKER_POOL_BATCH;
+        for (n = 0; n == 0 || (n < max && pool->head != NULL); n++) {
+            batch[n] = pool->head;
+            pool->head = pool->head->next;
+        }
+        pool->queued -= n;
+        if (pool->head == NULL)
+            pool->tail = NULL;
+        pthread_mutex_unlock(&pool->lock);
+
+        for (i = 0; i < n; i++) {
+            if (batch[i]->run != NULL) {
+                batch[i]->ret = batch[i]->run(batch[i]->arg);
+            } else {
+                batch[i]->run_void(batch[i]->arg);
+                batch[i]->ret = 1;
+            }
+            async_errs_save(&batch[i]->errs);
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        for (i = 0; i < n; i++) {
+            WORKER_WAIT *wait = batch[i]->wait;
+
+            if (--wait->pending > 0)
+                continue;
+            /* The waiter may return as soon as it sees this */
+            if (wait->notify_fd < 0)
+                pthread_cond_broadcast(&pool->done);
+            else
+                async_wakeup_notify(wait->notify_fd);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+    OPENSSL_thread_stop();
+    return NULL;
+}
+
+/*
+ * Runs the |num| operations in |jobs| on |pool| and waits for all of them,
+ * pausing the current ASYNC job if there is one.  Returns 0 without queuing
+ * anything if the caller had better run them itself.
+ */
+static int worker_pool_submit(OSSL_WORKER_POOL *pool, WORKER_JOB *jobs,
+                              size_t num)
+{
+    ASYNC_JOB *job = ASYNC_get_current_job();
+    ASYNC_WAIT_CTX *waitctx;
+    ASYNC_WAKEUP *wakeup = NULL;
+    WORKER_WAIT wait;
+    size_t i, pending;
+
+    if (job != NULL && async_get_ctx()->blocked == 0) {
+        if ((waitctx = ASYNC_get_wait_ctx(job)) == NULL
+                || (wakeup = async_wait_ctx_get_wakeup(waitctx)) == NULL)
+            return 0;
+    } else if (num == 1) {
+        /* Nothing else to do on this thread while it waits */
+        return 0;
+    }
+
+    wait.pending = num;
+    wait.notify_fd = wakeup != NULL ? wakeup->wfd : -1;
+    for (i = 0; i < num; i++) {
+        jobs[i].wait = &wait;
+        jobs[i].next = i + 1 < num ? &jobs[i + 1] : NULL;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->tail != NULL)
+        pool->tail->next = &jobs[0];
+    else
+        pool->head = &jobs[0];
+    pool->tail = &jobs[num - 1];
+    pool->queued += num;
+    if (num == 1)
+        pthread_cond_signal(&pool->cond);
+    else
+        pthread_cond_broadcast(&pool->cond);
+    if (wakeup == NULL) {
+        while (wait.pending > 0)
+            pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    if (wakeup != NULL) {
+        do {
+            ASYNC_pause_job();
+            async_wakeup_drain(wakeup);
+            pthread_mutex_lock(&pool->lock);
+            pending = wait.pending;
+            pthread_mutex_unlock(&pool->lock);
+        } while (pending > 0);
+    }
+
+    for (i = 0; i < num; i++) {
+        async_errs_restore(&jobs[i].errs);
+        async_errs_clear(&jobs[i].errs);
+    }
+    return 1;
+}
+
+static void worker_pool_stop(OSSL_WORKER_POOL *pool, size_t num_threads)
+{
+    size_t i;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+    for (i = 0; i < num_threads; i++)
+        pthread_join(pool->threads[i], NULL);
+}
+
+OSSL_WORKER_POOL *OSSL_WORKER_POOL_new(size_t num_threads)
+{
+    OSSL_WORKER_POOL *pool;
+    size_t i;
+
+    if (num_threads == 0) {
+        ASYNCerr(ASYNC_F_OSSL_WORKER_POOL_NEW, ASYNC_R_INVALID_POOL_SIZE);
+        return NULL;
+    }
+    if ((pool = OPENSSL_zalloc(sizeof(*pool))) == NULL
+            || (pool->threads = OPENSSL_zalloc(sizeof(*pool->threads)
+                                               * num_threads)) == NULL) {
+        ASYNCerr(ASYNC_F_OSSL_WORKER_POOL_NEW, ERR_R_MALLOC_FAILURE);
+        OPENSSL_free(pool);
+        return NULL;
+    }
+    if (pthread_mutex_init(&pool->lock, NULL) != 0) {
+        OPENSSL_free(pool->threads);
+        OPENSSL_free(pool);
+        ASYNCerr(ASYNC_F_OSSL_WORKER_POOL_NEW, ASYNC_R_INIT_FAILED);
+        return NULL;
+    }
+    if (pthread_cond_init(&pool->cond, NULL) != 0) {
+        pthread_mutex_destroy(&pool->lock);
+        OPENSSL_free(pool->threads);
+        OPENSSL_free(pool);
+        ASYNCerr(ASYNC_F_OSSL_WORKER_POOL_NEW, ASYNC_R_INIT_FAILED);
+        return NULL;
+    }
+    if (pthread_cond_init(&pool->done, NULL) != 0) {
+        pthread_cond_destroy(&pool->cond);
+        pthread_mutex_destroy(&pool->lock);
+        OPENSSL_free(pool->threads);
+        OPENSSL_free(pool);
+        ASYNCerr(ASYNC_F_OSSL_WORKER_POOL_NEW, ASYNC_R_INIT_FAILED);
+        return NULL;
+    }
+    for (i = 0; i < num_threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker_pool_thread,
+                           pool) != 0) {
+            worker_pool_stop(pool, i);
+            OSSL_WORKER_POOL_free(pool);
+            ASYNCerr(ASYNC_F_OSSL_WORKER_POOL_NEW, ASYNC_R_INIT_FAILED);
+            return NULL;
+        }
+    }
+    pool->num_threads = num_threads;
+    return pool;
+}
+
+void OSSL_WORKER_POOL_free(OSSL_WORKER_POOL *pool)
+{
+    if (pool == NULL)
+        return;
+    /* Workers drain the queue before they exit */
+    if (pool->num_threads > 0)
+        worker_pool_stop(pool, pool->num_threads);
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->lock);
+    OPENSSL_free(pool->threads);
+    OPENSSL_free(pool);
+}
+
+size_t OSSL_WORKER_POOL_get_num_threads(const OSSL_WORKER_POOL *pool)
+{
+    return pool == NULL ? 0 : pool->num_threads;
+}
+
+int OSSL_WORKER_POOL_run(OSSL_WORKER_POOL *pool, int (*run) (void *arg),
+                         void *arg)
+{
+    WORKER_JOB job;
+
+    if (pool != NULL) {
+        memset(&job, 0, sizeof(job));
+        job.run = run;
+        job.arg = arg;
+        if (worker_pool_submit(pool, &job, 1))
+            return job.ret;
+    }
+    return run(arg);
+}
+
+void OSSL_WORKER_POOL_run_all(OSSL_WORKER_POOL *pool,
+                              void (*run) (void *job), void **jobs,
+                              size_t num_jobs)
+{
+    WORKER_JOB *wjobs = NULL;
+    size_t i;
+
+    if (pool != NULL && num_jobs > 0
+            && (wjobs = OPENSSL_zalloc(sizeof(*wjobs) * num_jobs)) != NULL) {
+        for (i = 0; i < num_jobs; i++) {
+            wjobs[i].run_void = run;
+            wjobs[i].arg = jobs[i];
+        }
+        if (worker_pool_submit(pool, wjobs, num_jobs)) {
+            OPENSSL_free(wjobs);
+            return;
+        }
+        OPENSSL_free(wjobs);
+    }
+    for (i = 0; i < num_jobs; i++)
+        run(jobs[i]);
+}
+
+#else /* WORKER_POOL_THREADS */
+
+OSSL_WORKER_POOL *OSSL_WORKER_POOL_new(size_t num_threads)
+{
+    ASYNCerr(ASYNC_F_OSSL_WORKER_POOL_NEW, ERR_R_DISABLED);
+    return NULL;
+}
+
+void OSSL_WORKER_POOL_free(OSSL_WORKER_POOL *pool)
+{
+}
+
+size_t OSSL_WORKER_POOL_get_num_threads(const OSSL_WORKER_POOL *pool)
+{
+    return 0;
+}
+
+int OSSL_WORKER_POOL_run(OSSL_WORKER_POOL *pool, int (*run) (void *arg),
+                         void *arg)
+{
+    return run(arg);
+}
+
+void OSSL_WORKER_POOL_run_all(OSSL_WORKER_POOL *pool,
+                              void (*run) (void *job), void **jobs,
+                              size_t num_jobs)
+{
+    size_t i;
+
+    for (i = 0; i < num_jobs; i++)
+        run(jobs[i]);
+}
+
+#endif /* WORKER_POOL_THREADS */
@@ -42,6 +42,18 @@
          ((a)->s6_addr32[2] == htonl(0x0000ffff)))
 # endif
 
+/*
+ * Batched datagram I/O with recvmmsg()/sendmmsg(), plus UDP generic
+ * segmentation offload where the headers know about it.
+ */
+# if defined(OPENSSL_SYS_LINUX) && defined(MSG_WAITFORONE)
+#  define OPENSSL_DGRAM_MMSG
+#  include <netinet/udp.h>
+#  define DGRAM_MMSG_MAX          1024
+#  define DGRAM_GSO_MAX_SEGS      64
+#  define DGRAM_GSO_MAX_BYTES     65000
+# endif
+
 static int dgram_write(BIO *h, const char *buf, int num);
 static int dgram_read(BIO *h, char *buf, int size);
 static int dgram_puts(BIO *h, const char *str);
@@ -49,6 +61,12 @@ static long dgram_ctrl(BIO *h, int cmd, long arg1, void *arg2);
 static int dgram_new(BIO *h);
 static int dgram_free(BIO *data);
 static int dgram_clear(BIO *bio);
+# ifdef OPENSSL_DGRAM_MMSG
+static void dgram_mmsg_free(BIO *b);
+static int dgram_mmsg_read(BIO *b, char *out, int outl);
+static int dgram_mmsg_write(BIO *b, const char *in, int inl);
+static int dgram_mmsg_flush(BIO *b);
+# endif
 
 # ifndef OPENSSL_NO_SCTP
 static int dgram_sctp_write(BIO *h, const char *buf, int num);
@@ -103,6 +121,25 @@ static const BIO_METHOD methods_dgramp_sctp = {
 };
 # endif
 
+# ifdef OPENSSL_DGRAM_MMSG
+/* A datagram queued by dgram_write() */
+typedef struct bio_dgram_mmsg_pkt_st {
+    size_t off;
+    size_t len;
+    BIO_ADDR peer;
+} bio_dgram_mmsg_pkt;
+
+/* Per message state for sendmmsg(), one message may carry several segments */
+typedef struct bio_dgram_mmsg_out_st {
+    struct iovec iov;
+    unsigned int npkts;
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(uint16_t))];
+    } cmsg;
+} bio_dgram_mmsg_out;
+# endif
+
 typedef struct bio_dgram_data_st {
     BIO_ADDR peer;
     unsigned int connected;
@@ -111,6 +148,26 @@ typedef struct bio_dgram_data_st {
     struct timeval next_timeout;
     struct timeval socket_timeout;
     unsigned int peekmode;
+# ifdef OPENSSL_DGRAM_MMSG
+    /* Number of datagrams moved per system call, 0 if batching is off */
+    unsigned int mmsg;
+    /* Set while UDP_SEGMENT has not been refused by the kernel */
+    int gso;
+    /* Received datagrams that dgram_read() has not returned yet */
+    unsigned char *rbuf;
+    size_t rslot;
+    struct mmsghdr *rhdr;
+    struct iovec *riov;
+    BIO_ADDR *rpeer;
+    unsigned int rnext, rcount;
+    /* Datagrams written but not yet sent, back to back in |wbuf| */
+    unsigned char *wbuf;
+    size_t wsize, wbytes;
+    bio_dgram_mmsg_pkt *wpkt;
+    unsigned int wnext, wcount;
+    struct mmsghdr *whdr;
+    bio_dgram_mmsg_out *wout;
+# endif
 } bio_dgram_data;
 
 # ifndef OPENSSL_NO_SCTP
@@ -174,6 +231,9 @@ static int dgram_free(BIO *a)
         return 0;
 
     data = (bio_dgram_data *)a->ptr;
+# ifdef OPENSSL_DGRAM_MMSG
+    dgram_mmsg_free(a);
+# endif
     OPENSSL_free(data);
 
     return 1;
@@ -307,6 +367,13 @@ static int dgram_read(BIO *b, char *out, int outl)
     BIO_ADDR peer;
     socklen_t len = sizeof(peer);
 
+# ifdef OPENSSL_DGRAM_MMSG
+    /* A peek with nothing queued is left to recvfrom() below */
+    if (data->mmsg > 0 && out != NULL
+            && (data->rnext < data->rcount || !data->peekmode))
+        return dgram_mmsg_read(b, out, outl);
+# endif
+
     if (out != NULL) {
         clear_socket_error();
         memset(&peer, 0, sizeof(peer));
@@ -336,6 +403,12 @@ static int dgram_write(BIO *b, const char *in, int inl)
 {
     int ret;
     bio_dgram_data *data = (bio_dgram_data *)b->ptr;
+
+# ifdef OPENSSL_DGRAM_MMSG
+    if (data->mmsg > 0)
+        return dgram_mmsg_write(b, in, inl);
+# endif
+
     clear_socket_error();
 
     if (data->connected)
@@ -357,6 +430,299 @@ static int dgram_write(BIO *b, const char *in, int inl)
     return ret;
 }
 
+# ifdef OPENSSL_DGRAM_MMSG
+static void dgram_mmsg_free(BIO *b)
+{
+    bio_dgram_data *data = (bio_dgram_data *)b->ptr;
+
+    OPENSSL_free(data->rbuf);
+    OPENSSL_free(data->rhdr);
+    OPENSSL_free(data->riov);
+    OPENSSL_free(data->rpeer);
+    OPENSSL_free(data->wbuf);
+    OPENSSL_free(data->wpkt);
+    OPENSSL_free(data->whdr);
+    OPENSSL_free(data->wout);
+    data->rbuf = data->wbuf = NULL;
+    data->rhdr = data->whdr = NULL;
+    data->riov = NULL;
+    data->rpeer = NULL;
+    data->wpkt = NULL;
+    data->wout = NULL;
+    data->rslot = data->wsize = data->wbytes = 0;
+    data->rnext = data->rcount = data->wnext = data->wcount = 0;
+    data->mmsg = 0;
+}
+
+/*
+ * Change the batch size. Queued datagrams would be lost, so this is refused
+ * until they have been read or flushed.
+ */
+static int dgram_mmsg_set(BIO *b, long num)
+{
+    bio_dgram_data *data = (bio_dgram_data *)b->ptr;
+    unsigned int n;
+
+    if (num < 0 || num > DGRAM_MMSG_MAX)
+        return 0;
+    if (data->rnext < data->rcount || data->wnext < data->wcount)
+        return 0;
+    dgram_mmsg_free(b);
+    if (num == 0)
+        return 1;
+
+    n = (unsigned int)num;
+    data->rhdr = OPENSSL_zalloc(n * sizeof(*data->rhdr));
+    data->riov = OPENSSL_zalloc(n * sizeof(*data->riov));
+    data->rpeer = OPENSSL_zalloc(n * sizeof(*data->rpeer));
+    data->wpkt = OPENSSL_zalloc(n * sizeof(*data->wpkt));
+    data->whdr = OPENSSL_zalloc(n * sizeof(*data->whdr));
+    data->wout = OPENSSL_zalloc(n * sizeof(*data->wout));
+    if (data->rhdr == NULL || data->riov == NULL || data->rpeer == NULL
+            || data->wpkt == NULL || data->whdr == NULL || data->wout == NULL) {
+        BIOerr(BIO_F_DGRAM_CTRL, ERR_R_MALLOC_FAILURE);
+        dgram_mmsg_free(b);
+        return 0;
+    }
+    data->mmsg = n;
+#  ifdef UDP_SEGMENT
+    data->gso = 1;
+#  endif
+    return 1;
+}
+
+/* Receive up to |mmsg| datagrams of at most |len| bytes each */
+static int dgram_mmsg_fill(BIO *b, size_t len)
+{
+    bio_dgram_data *data = (bio_dgram_data *)b->ptr;
+    unsigned int i;
+    int ret;
+
+    if (data->rbuf == NULL || data->rslot < len) {
+        OPENSSL_free(data->rbuf);
+        data->rslot = 0;
+        if ((data->rbuf = OPENSSL_malloc(len * data->mmsg)) == NULL) {
+            BIOerr(BIO_F_DGRAM_READ, ERR_R_MALLOC_FAILURE);
+            return -1;
+        }
+        data->rslot = len;
+    }
+    for (i = 0; i < data->mmsg; i++) {
+        struct msghdr *msg = &data->rhdr[i].msg_hdr;
+
+        memset(msg, 0, sizeof(*msg));
+        data->riov[i].iov_base = data->rbuf + i * data->rslot;
+        data->riov[i].iov_len = data->rslot;
+        msg->msg_iov = &data->riov[i];
+        msg->msg_iovlen = 1;
+        msg->msg_name = BIO_ADDR_sockaddr_noconst(&data->rpeer[i]);
+        msg->msg_namelen = sizeof(data->rpeer[i]);
+    }
+
+    clear_socket_error();
+    dgram_adjust_rcv_timeout(b);
+    /* Block for the first datagram at most, then take what is queued */
+    ret = recvmmsg(b->num, data->rhdr, data->mmsg, MSG_WAITFORONE, NULL);
+    if (ret < 0 && BIO_dgram_should_retry(ret)) {
+        BIO_set_retry_read(b);
+        data->_errno = get_last_socket_error();
+    }
+    dgram_reset_rcv_timeout(b);
+    if (ret <= 0)
+        return ret;
+
+    data->rnext = 0;
+    data->rcount = (unsigned int)ret;
+    return ret;
+}
+
+static int dgram_mmsg_read(BIO *b, char *out, int outl)
+{
+    bio_dgram_data *data = (bio_dgram_data *)b->ptr;
+    unsigned int i;
+    int ret;
+
+    BIO_clear_retry_flags(b);
+    if (outl < 0)
+        return -1;
+    if (data->rnext == data->rcount
+            && (ret = dgram_mmsg_fill(b, (size_t)outl)) <= 0)
+        return ret;
+
+    /* As with recvfrom(), a datagram longer than |outl| is truncated */
+    i = data->rnext;
+    ret = (int)data->rhdr[i].msg_len;
+    if (ret > outl)
+        ret = outl;
+    memcpy(out, data->rbuf + i * data->rslot, ret);
+    if (!data->connected)
+        BIO_ctrl(b, BIO_CTRL_DGRAM_SET_PEER, 0, &data->rpeer[i]);
+    if (!data->peekmode)
+        data->rnext++;
+    return ret;
+}
+
+static int dgram_mmsg_write(BIO *b, const char *in, int inl)
+{
+    bio_dgram_data *data = (bio_dgram_data *)b->ptr;
+    bio_dgram_mmsg_pkt *pkt;
+
+    BIO_clear_retry_flags(b);
+    if (inl < 0)
+        return -1;
+    if (data->wcount == data->mmsg) {
+        /* The queue is full: a retry flag is set if it stays that way */
+        if (dgram_mmsg_flush(b) < 0 || data->wcount == data->mmsg)
+            return -1;
+    }
+
+    if (data->wbytes + inl > data->wsize) {
+        size_t size = data->wsize > 0 ? data->wsize : (size_t)inl * data->mmsg;
+        unsigned char *buf;
+
+        while (size < data->wbytes + inl)
+            size *= 2;
+        if ((buf = OPENSSL_realloc(data->wbuf, size)) == NULL) {
+            BIOerr(BIO_F_DGRAM_WRITE, ERR_R_MALLOC_FAILURE);
+            return -1;
+        }
+        data->wbuf = buf;
+        data->wsize = size;
+    }
+
+    pkt = &data->wpkt[data->wcount++];
+    pkt->off = data->wbytes;
+    pkt->len = inl;
+    if (!data->connected)
+        pkt->peer = data->peer;
+    memcpy(data->wbuf + data->wbytes, in, inl);
+    data->wbytes += inl;
+    return inl;
+}
+
+/* Move the datagrams that are still queued to the front of the queue */
+static void dgram_mmsg_compact(bio_dgram_data *data)
+{
+    unsigned int i;
+    size_t off;
+
+    if (data->wnext == 0)
+        return;
+    off = data->wnext < data->wcount ? data->wpkt[data->wnext].off
+                                     : data->wbytes;
+    memmove(data->wbuf, data->wbuf + off, data->wbytes - off);
+    memmove(data->wpkt, data->wpkt + data->wnext,
+            (data->wcount - data->wnext) * sizeof(*data->wpkt));
+    data->wcount -= data->wnext;
+    data->wbytes -= off;
+    data->wnext = 0;
+    for (i = 0; i < data->wcount; i++)
+        data->wpkt[i].off -= off;
+}
+
+static int dgram_mmsg_same_peer(const BIO_ADDR *a, const BIO_ADDR *b)
+{
+    socklen_t len = BIO_ADDR_sockaddr_size(a);
+
+    return len == BIO_ADDR_sockaddr_size(b)
+        && memcmp(BIO_ADDR_sockaddr(a), BIO_ADDR_sockaddr(b), len) == 0;
+}
+
+/*
+ * Send everything that dgram_write() queued. Returns 1 once the queue is
+ * empty, 0 with the retry flag set if the socket is full and -1 on error.
+ * A datagram the kernel refuses is dropped, as it would have been by
+ * sendto(), so that one bad destination cannot wedge the queue.
+ */
+static int dgram_mmsg_flush(BIO *b)
+{
+    bio_dgram_data *data = (bio_dgram_data *)b->ptr;
+    unsigned int i, j, n;
+    int ret, gso_used;
+
+    BIO_clear_retry_flags(b);
+    while (data->wnext < data->wcount) {
+        gso_used = 0;
+        for (n = 0, i = data->wnext; i < data->wcount && n < data->mmsg; n++) {
+            const bio_dgram_mmsg_pkt *pkt = &data->wpkt[i];
+            bio_dgram_mmsg_out *out = &data->wout[n];
+            struct msghdr *msg = &data->whdr[n].msg_hdr;
+            size_t total = pkt->len;
+
+            /*
+             * Coalesce a run of datagrams of the same size to the same peer
+             * into one GSO message; only the last segment may be shorter.
+             */
+            for (j = i + 1; data->gso && j < data->wcount
+                     && j - i < DGRAM_GSO_MAX_SEGS; j++) {
+                const bio_dgram_mmsg_pkt *next = &data->wpkt[j];
+
+                if (data->wpkt[j - 1].len != pkt->len || next->len > pkt->len
+                        || total + next->len > DGRAM_GSO_MAX_BYTES
+                        || (!data->connected
+                            && !dgram_mmsg_same_peer(&next->peer, &pkt->peer)))
+                    break;
+                total += next->len;
+            }
+
+            memset(msg, 0, sizeof(*msg));
+            out->iov.iov_base = data->wbuf + pkt->off;
+            out->iov.iov_len = total;
+            out->npkts = j - i;
+            msg->msg_iov = &out->iov;
+            msg->msg_iovlen = 1;
+            if (!data->connected) {
+                msg->msg_name = (void *)BIO_ADDR_sockaddr(&pkt->peer);
+                msg->msg_namelen = BIO_ADDR_sockaddr_size(&pkt->peer);
+            }
+#  ifdef UDP_SEGMENT
+            if (out->npkts > 1) {
+                struct cmsghdr *cmsg;
+                uint16_t segsize = (uint16_t)pkt->len;
+
+                msg->msg_control = out->cmsg.buf;
+                msg->msg_controllen = sizeof(out->cmsg.buf);
+                cmsg = CMSG_FIRSTHDR(msg);
+                cmsg->cmsg_level = SOL_UDP;
+                cmsg->cmsg_type = UDP_SEGMENT;
+                cmsg->cmsg_len = CMSG_LEN(sizeof(segsize));
+                memcpy(CMSG_DATA(cmsg), &segsize, sizeof(segsize));
+                gso_used = 1;
+            }
+#  endif
+            i = j;
+        }
+
+        clear_socket_error();
+        ret = sendmmsg(b->num, data->whdr, n, 0);
+        if (ret < 0) {
+            int err = get_last_socket_error();
+
+            if (gso_used && (err == EIO || err == EINVAL || err == ENOPROTOOPT
+                             || err == EOPNOTSUPP)) {
+                /* No segmentation offload on this path: send one by one */
+                data->gso = 0;
+                continue;
+            }
+            data->_errno = err;
+            if (BIO_dgram_should_retry(ret)) {
+                dgram_mmsg_compact(data);
+                BIO_set_retry_write(b);
+                return 0;
+            }
+            data->wnext += data->wout[0].npkts;
+            dgram_mmsg_compact(data);
+            return -1;
+        }
+        for (n = 0; n < (unsigned int)ret; n++)
+            data->wnext += data->wout[n].npkts;
+    }
+    data->wnext = data->wcount = 0;
+    data->wbytes = 0;
+    return 1;
+}
+# endif
+
 static long dgram_get_mtu_overhead(bio_dgram_data *data)
 {
     long ret;
@@ -425,6 +791,12 @@ static long dgram_ctrl(BIO *b, int cmd, long num, void *ptr)
         b->num = *((int *)ptr);
         b->shutdown = (int)num;
         b->init = 1;
+# ifdef OPENSSL_DGRAM_MMSG
+        /* Whatever was queued belongs to the old socket */
+        data->rnext = data->rcount = 0;
+        data->wnext = data->wcount = 0;
+        data->wbytes = 0;
+# endif
         break;
     case BIO_C_GET_FD:
         if (b->init) {
@@ -442,12 +814,30 @@ static long dgram_ctrl(BIO *b, int cmd, long num, void *ptr)
         b->shutdown = (int)num;
         break;
     case BIO_CTRL_PENDING:
+        ret = 0;
+# ifdef OPENSSL_DGRAM_MMSG
+        /* The size of the next datagram dgram_read() will return */
+        if (data->rnext < data->rcount)
+            ret = data->rhdr[data->rnext].msg_len;
+# endif
+        break;
     case BIO_CTRL_WPENDING:
+        /*
+         * Every write is a datagram of its own, so even with datagrams queued
+         * for sendmmsg() no bytes are pending for the next one. DTLS sizes
+         * handshake fragments from this.
+         */
         ret = 0;
         break;
     case BIO_CTRL_DUP:
+        ret = 1;
+        break;
     case BIO_CTRL_FLUSH:
         ret = 1;
+# ifdef OPENSSL_DGRAM_MMSG
+        if (data->wnext < data->wcount)
+            ret = dgram_mmsg_flush(b);
+# endif
         break;
     case BIO_CTRL_DGRAM_CONNECT:
         BIO_ADDR_make(&data->peer, BIO_ADDR_sockaddr((BIO_ADDR *)ptr));
@@ -794,6 +1184,20 @@ static long dgram_ctrl(BIO *b, int cmd, long num, void *ptr)
     case BIO_CTRL_DGRAM_SET_PEEK_MODE:
         data->peekmode = (unsigned int)num;
         break;
+    case BIO_CTRL_DGRAM_SET_MMSG:
+# ifdef OPENSSL_DGRAM_MMSG
+        ret = dgram_mmsg_set(b, num);
+# else
+        ret = num == 0;
+# endif
+        break;
+    case BIO_CTRL_DGRAM_GET_MMSG:
+# ifdef OPENSSL_DGRAM_MMSG
+        ret = data->mmsg;
+# else
+        ret = 0;
+# endif
+        break;
     default:
         ret = 0;
         break;
@@ -0,0 +1,697 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include "bio_local.h"
+#include "internal/cryptlib.h"
+#include "internal/refcount.h"
+
+/*
+ * A segmented memory BIO.  Queued data lives in a chain of fixed size
+ * segments that are never reallocated or shifted, so the non-copying
+ * interface (BIO_nread0(), BIO_nwrite0(), BIO_mem_chain_peek()) can hand
+ * out pointers straight into them.  Segments are reference counted so that
+ * BIO_mem_chain_move() can pass data on to another BIO without copying it:
+ * a node either takes the whole segment along or shares it with a slice.
+ */
+
+#define MEM_CHAIN_SEG_SIZE      (16 * 1024)
+/* Number of unused chain nodes kept per queue */
+#define MEM_CHAIN_FREE_NODES    8
+
+typedef struct bio_mem_chain_seg_st {
+    CRYPTO_REF_COUNT references;
+    CRYPTO_RWLOCK *lock;        /* only needed without atomics */
+    size_t size;
+    unsigned char *data;
+} MEM_CHAIN_SEG;
+
+typedef struct bio_mem_chain_node_st {
+    struct bio_mem_chain_node_st *next;
+    MEM_CHAIN_SEG *seg;
+    size_t off;
+    size_t len;
+    /*
+     * Set on the one node that may append into the rest of its segment;
+     * slices handed out by BIO_mem_chain_move() never are.
+     */
+    int writable;
+} MEM_CHAIN_NODE;
+
+/*
+ * A queue is written by one BIO and read by one BIO: the same one for a
+ * plain BIO_s_mem_chain() and the two halves of BIO_new_mem_chain_pair().
+ */
+typedef struct bio_mem_chain_queue_st {
+    MEM_CHAIN_NODE *head;
+    MEM_CHAIN_NODE *tail;
+    size_t len;
+    /* Node emptied by BIO_nread(), kept until the next call */
+    MEM_CHAIN_NODE *held;
+    MEM_CHAIN_NODE *free_nodes;
+    int num_free;
+    /* A drained segment kept for the next write */
+    MEM_CHAIN_SEG *spare;
+    size_t seg_size;
+    int references;
+    int closed;
+} MEM_CHAIN_QUEUE;
+
+typedef struct bio_mem_chain_st {
+    MEM_CHAIN_QUEUE *rq;
+    MEM_CHAIN_QUEUE *wq;
+} BIO_MEM_CHAIN;
+
+static int mem_chain_write(BIO *b, const char *in, size_t inl,
+                           size_t *written);
+static int mem_chain_read(BIO *b, char *out, size_t outl, size_t *readbytes);
+static int mem_chain_puts(BIO *b, const char *str);
+static int mem_chain_gets(BIO *b, char *buf, int size);
+static long mem_chain_ctrl(BIO *b, int cmd, long num, void *ptr);
+static int mem_chain_new(BIO *b);
+static int mem_chain_free(BIO *b);
+
+static const BIO_METHOD mem_chain_method = {
+    BIO_TYPE_MEM_CHAIN,
+    "segmented memory buffer",
+    mem_chain_write,
+    NULL,                       /* mem_chain_write_old */
+    mem_chain_read,
+    NULL,                       /* mem_chain_read_old */
+    mem_chain_puts,
+    mem_chain_gets,
+    mem_chain_ctrl,
+    mem_chain_new,
+    mem_chain_free,
+    NULL,                       /* mem_chain_callback_ctrl */
+};
+
+const BIO_METHOD *BIO_s_mem_chain(void)
+{
+    return &mem_chain_method;
+}
+
+static MEM_CHAIN_SEG *mem_chain_seg_new(size_t size)
+{
+    MEM_CHAIN_SEG *seg;
+
+    if (size > SIZE_MAX - sizeof(*seg)
+            || (seg = OPENSSL_malloc(sizeof(*seg) + size)) == NULL)
+        return NULL;
+#ifdef HAVE_ATOMICS
+    seg->lock = NULL;
+#else
+    if ((seg->lock = CRYPTO_THREAD_lock_new()) == NULL) {
+        OPENSSL_free(seg);
+        return NULL;
+    }
+#endif
+    seg->references = 1;
+    seg->size = size;
+    seg->data = (unsigned char *)(seg + 1);
+    return seg;
+}
+
+/* Drop a reference; the last one parks the segment as |q|'s spare */
+static void mem_chain_seg_release(MEM_CHAIN_QUEUE *q, MEM_CHAIN_SEG *seg)
+{
+    int i;
+
+    CRYPTO_DOWN_REF(&seg->references, &i, seg->lock);
+    if (i > 0)
+        return;
+    if (q != NULL && q->spare == NULL && seg->size == q->seg_size) {
+        seg->references = 1;
+        q->spare = seg;
+        return;
+    }
+    CRYPTO_THREAD_lock_free(seg->lock);
+    OPENSSL_free(seg);
+}
+
+static MEM_CHAIN_NODE *mem_chain_node_new(MEM_CHAIN_QUEUE *q)
+{
+    MEM_CHAIN_NODE *node = q->free_nodes;
+
+    if (node != NULL) {
+        q->free_nodes = node->next;
+        q->num_free--;
+    } else if ((node = OPENSSL_malloc(sizeof(*node))) == NULL) {
+        return NULL;
+    }
+    node->next = NULL;
+    node->seg = NULL;
+    node->off = 0;
+    node->len = 0;
+    node->writable = 0;
+    return node;
+}
+
+static void mem_chain_node_free(MEM_CHAIN_QUEUE *q, MEM_CHAIN_NODE *node)
+{
+    if (node->seg != NULL)
+        mem_chain_seg_release(q, node->seg);
+    if (q->num_free < MEM_CHAIN_FREE_NODES) {
+        node->next = q->free_nodes;
+        q->free_nodes = node;
+        q->num_free++;
+    } else {
+        OPENSSL_free(node);
+    }
+}
+
+static void mem_chain_push(MEM_CHAIN_QUEUE *q, MEM_CHAIN_NODE *node)
+{
+    node->next = NULL;
+    if (q->tail == NULL)
+        q->head = node;
+    else
+        q->tail->next = node;
+    q->tail = node;
+}
+
+static void mem_chain_release_held(MEM_CHAIN_QUEUE *q)
+{
+    if (q->held != NULL) {
+        mem_chain_node_free(q, q->held);
+        q->held = NULL;
+    }
+}
+
+/*
+ * Consume |num| bytes (at most q->len) from the front of |q| and unlink the
+ * nodes left empty.  A writable tail is kept so that the next write can
+ * carry on in its segment.  With |hold| set the node the bytes came from
+ * survives until the next call, as the pointer returned by BIO_nread()
+ * still points into it.
+ */
+static void mem_chain_advance(MEM_CHAIN_QUEUE *q, size_t num, int hold)
+{
+    MEM_CHAIN_NODE *node;
+    size_t n;
+
+    while ((node = q->head) != NULL) {
+        n = node->len < num ? node->len : num;
+        node->off += n;
+        node->len -= n;
+        q->len -= n;
+        num -= n;
+        if (node->len > 0)
+            break;
+        if (node == q->tail && node->writable
+                && (node->off < node->seg->size
+                    || node->seg->references == 1))
+            break;
+        q->head = node->next;
+        if (q->head == NULL)
+            q->tail = NULL;
+        if (hold && n > 0) {
+            mem_chain_release_held(q);
+            q->held = node;
+        } else {
+            mem_chain_node_free(q, node);
+        }
+    }
+}
+
+static void mem_chain_clear(MEM_CHAIN_QUEUE *q)
+{
+    MEM_CHAIN_NODE *node;
+
+    mem_chain_release_held(q);
+    while ((node = q->head) != NULL) {
+        q->head = node->next;
+        mem_chain_node_free(q, node);
+    }
+    q->tail = NULL;
+    q->len = 0;
+}
+
+static MEM_CHAIN_QUEUE *mem_chain_queue_new(void)
+{
+    MEM_CHAIN_QUEUE *q = OPENSSL_zalloc(sizeof(*q));
+
+    if (q == NULL)
+        return NULL;
+    q->seg_size = MEM_CHAIN_SEG_SIZE;
+    q->references = 1;
+    return q;
+}
+
+static void mem_chain_queue_free(MEM_CHAIN_QUEUE *q)
+{
+    MEM_CHAIN_NODE *node;
+
+    if (--q->references > 0)
+        return;
+    mem_chain_clear(q);
+    while ((node = q->free_nodes) != NULL) {
+        q->free_nodes = node->next;
+        OPENSSL_free(node);
+    }
+    if (q->spare != NULL)
+        mem_chain_seg_release(NULL, q->spare);
+    OPENSSL_free(q);
+}
+
+/*
+ * Return the contiguous space left at the tail of |q| and point |*buf| at
+ * it, starting a new segment if the tail cannot take any more.
+ */
+static size_t mem_chain_reserve(MEM_CHAIN_QUEUE *q, unsigned char **buf)
+{
+    MEM_CHAIN_NODE *node = q->tail;
+
+    if (q->closed) {
+        BIOerr(BIO_F_MEM_CHAIN_RESERVE, BIO_R_BROKEN_PIPE);
+        return 0;
+    }
+    /* A drained segment nobody else refers to is filled from the start */
+    if (node != NULL && node->writable && node->len == 0
+            && node->seg->references == 1)
+        node->off = 0;
+    if (node == NULL || !node->writable
+            || node->off + node->len == node->seg->size) {
+        if ((node = mem_chain_node_new(q)) == NULL) {
+            BIOerr(BIO_F_MEM_CHAIN_RESERVE, ERR_R_MALLOC_FAILURE);
+            return 0;
+        }
+        if (q->spare != NULL) {
+            node->seg = q->spare;
+            q->spare = NULL;
+        } else if ((node->seg = mem_chain_seg_new(q->seg_size)) == NULL) {
+            mem_chain_node_free(q, node);
+            BIOerr(BIO_F_MEM_CHAIN_RESERVE, ERR_R_MALLOC_FAILURE);
+            return 0;
+        }
+        node->writable = 1;
+        mem_chain_push(q, node);
+    }
+    *buf = node->seg->data + node->off + node->len;
+    return node->seg->size - node->off - node->len;
+}
+
+/* What a read finds once the queue is empty */
+static int mem_chain_empty(BIO *b)
+{
+    BIO_MEM_CHAIN *bc = b->ptr;
+
+    /* The other half of a pair has gone or shut down its write side */
+    if (bc->rq != bc->wq && bc->rq->closed)
+        return 0;
+    if (b->num != 0)
+        BIO_set_retry_read(b);
+    return b->num;
+}
+
+static int mem_chain_new(BIO *b)
+{
+    BIO_MEM_CHAIN *bc = OPENSSL_zalloc(sizeof(*bc));
+
+    if (bc == NULL || (bc->rq = mem_chain_queue_new()) == NULL) {
+        OPENSSL_free(bc);
+        BIOerr(BIO_F_MEM_CHAIN_NEW, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    bc->wq = bc->rq;
+    b->ptr = bc;
+    b->num = -1;
+    b->shutdown = 1;
+    b->init = 1;
+    return 1;
+}
+
+static int mem_chain_free(BIO *b)
+{
+    BIO_MEM_CHAIN *bc;
+
+    if (b == NULL || (bc = b->ptr) == NULL)
+        return 0;
+    if (bc->rq != bc->wq) {
+        /* Nobody reads what the other half writes from now on */
+        mem_chain_clear(bc->rq);
+        bc->rq->closed = 1;
+        bc->wq->closed = 1;
+        mem_chain_queue_free(bc->wq);
+    }
+    mem_chain_queue_free(bc->rq);
+    OPENSSL_free(bc);
+    b->ptr = NULL;
+    return 1;
+}
+
+static int mem_chain_write(BIO *b, const char *in, size_t inl,
+                           size_t *written)
+{
+    BIO_MEM_CHAIN *bc = b->ptr;
+    MEM_CHAIN_QUEUE *q = bc->wq;
+    unsigned char *p;
+    size_t n, done = 0;
+
+    BIO_clear_retry_flags(b);
+    mem_chain_release_held(bc->rq);
+    *written = 0;
+    if (in == NULL) {
+        BIOerr(BIO_F_MEM_CHAIN_WRITE, BIO_R_NULL_PARAMETER);
+        return -1;
+    }
+    if (inl == 0)
+        return 0;
+
+    while (done < inl) {
+        if ((n = mem_chain_reserve(q, &p)) == 0)
+            break;
+        if (n > inl - done)
+            n = inl - done;
+        memcpy(p, in + done, n);
+        q->tail->len += n;
+        q->len += n;
+        done += n;
+    }
+    *written = done;
+    return done > 0 ? 1 : -1;
+}
+
+static int mem_chain_read(BIO *b, char *out, size_t outl, size_t *readbytes)
+{
+    MEM_CHAIN_QUEUE *q = ((BIO_MEM_CHAIN *)b->ptr)->rq;
+    MEM_CHAIN_NODE *node;
+    size_t n, done = 0;
+
+    BIO_clear_retry_flags(b);
+    mem_chain_release_held(q);
+    *readbytes = 0;
+    if (q->len == 0)
+        return mem_chain_empty(b);
+
+    for (node = q->head; node != NULL && done < outl; node = node->next) {
+        n = node->len < outl - done ? node->len : outl - done;
+        memcpy(out + done, node->seg->data + node->off, n);
+        done += n;
+    }
+    mem_chain_advance(q, done, 0);
+    *readbytes = done;
+    return 1;
+}
+
+static int mem_chain_puts(BIO *b, const char *str)
+{
+    size_t written;
+    int ret = mem_chain_write(b, str, strlen(str), &written);
+
+    return ret > 0 ? (int)written : ret;
+}
+
+static int mem_chain_gets(BIO *b, char *buf, int size)
+{
+    MEM_CHAIN_QUEUE *q = ((BIO_MEM_CHAIN *)b->ptr)->rq;
+    MEM_CHAIN_NODE *node;
+    const unsigned char *p;
+    size_t j;
+    int i = 0;
+
+    BIO_clear_retry_flags(b);
+    mem_chain_release_held(q);
+    if (size <= 0)
+        return 0;
+    if (q->len == 0) {
+        *buf = '\0';
+        return mem_chain_empty(b);
+    }
+
+    for (node = q->head; node != NULL && i < size - 1; node = node->next) {
+        p = node->seg->data + node->off;
+        for (j = 0; j < node->len && i < size - 1; j++) {
+            if ((buf[i++] = p[j]) == '\n')
+                goto done;
+        }
+    }
+ done:
+    buf[i] = '\0';
+    mem_chain_advance(q, i, 0);
+    return i;
+}
+
+/*-
+ * non-copying interface, as for BIO pairs:
+ *   mem_chain_nread0:  pointer to the first contiguous run of queued data
+ *   mem_chain_nwrite0: pointer to the free space at the tail
+ */
+static long mem_chain_nread0(BIO *b, char **buf)
+{
+    MEM_CHAIN_QUEUE *q = ((BIO_MEM_CHAIN *)b->ptr)->rq;
+    MEM_CHAIN_NODE *node;
+
+    BIO_clear_retry_flags(b);
+    mem_chain_release_held(q);
+    if (q->len == 0)
+        return mem_chain_empty(b);
+
+    for (node = q->head; node->len == 0; node = node->next)
+        continue;
+    if (buf != NULL)
+        *buf = (char *)node->seg->data + node->off;
+    return node->len > LONG_MAX ? LONG_MAX : (long)node->len;
+}
+
+static long mem_chain_nwrite0(BIO *b, char **buf)
+{
+    BIO_MEM_CHAIN *bc = b->ptr;
+    unsigned char *p;
+    size_t n;
+
+    BIO_clear_retry_flags(b);
+    mem_chain_release_held(bc->rq);
+    if ((n = mem_chain_reserve(bc->wq, &p)) == 0)
+        return -1;
+    if (buf != NULL)
+        *buf = (char *)p;
+    return n > LONG_MAX ? LONG_MAX : (long)n;
+}
+
+static long mem_chain_ctrl(BIO *b, int cmd, long num, void *ptr)
+{
+    BIO_MEM_CHAIN *bc = b->ptr;
+    MEM_CHAIN_QUEUE *rq = bc->rq, *wq = bc->wq;
+    long ret = 1;
+
+    switch (cmd) {
+    case BIO_CTRL_RESET:
+        mem_chain_clear(rq);
+        break;
+    case BIO_CTRL_EOF:
+        ret = (long)(rq->len == 0 && (rq == wq || rq->closed));
+        break;
+    case BIO_C_SET_BUF_MEM_EOF_RETURN:
+        b->num = (int)num;
+        break;
+    case BIO_CTRL_PENDING:
+        ret = rq->len > LONG_MAX ? LONG_MAX : (long)rq->len;
+        break;
+    case BIO_CTRL_WPENDING:
+        ret = 0;
+        break;
+    case BIO_CTRL_GET_CLOSE:
+        ret = (long)b->shutdown;
+        break;
+    case BIO_CTRL_SET_CLOSE:
+        b->shutdown = (int)num;
+        break;
+    case BIO_CTRL_DUP:
+    case BIO_CTRL_FLUSH:
+        break;
+
+    case BIO_C_SET_WRITE_BUF_SIZE:
+        /* size of the segments allocated from now on */
+        if (num <= 0) {
+            ret = 0;
+            break;
+        }
+        if ((size_t)num != wq->seg_size) {
+            wq->seg_size = (size_t)num;
+            if (wq->spare != NULL) {
+                mem_chain_seg_release(NULL, wq->spare);
+                wq->spare = NULL;
+            }
+        }
+        break;
+    case BIO_C_GET_WRITE_BUF_SIZE:
+        ret = wq->seg_size > LONG_MAX ? LONG_MAX : (long)wq->seg_size;
+        break;
+
+    case BIO_C_SHUTDOWN_WR:
+        wq->closed = 1;
+        break;
+
+    case BIO_C_NREAD0:
+        ret = mem_chain_nread0(b, ptr);
+        break;
+    case BIO_C_NREAD:
+        ret = mem_chain_nread0(b, ptr);
+        if (ret > 0) {
+            if (num >= 0 && num < ret)
+                ret = num;
+            mem_chain_advance(rq, (size_t)ret, 1);
+        }
+        break;
+    case BIO_C_NWRITE0:
+        ret = mem_chain_nwrite0(b, ptr);
+        break;
+    case BIO_C_NWRITE:
+        ret = mem_chain_nwrite0(b, ptr);
+        if (ret > 0) {
+            if (num >= 0 && num < ret)
+                ret = num;
+            wq->tail->len += (size_t)ret;
+            wq->len += (size_t)ret;
+        }
+        break;
+
+    default:
+        ret = 0;
+        break;
+    }
+    return ret;
+}
+
+int BIO_new_mem_chain_pair(BIO **bio1_p, BIO **bio2_p)
+{
+    BIO *bio1, *bio2 = NULL;
+    BIO_MEM_CHAIN *bc1, *bc2;
+
+    *bio1_p = *bio2_p = NULL;
+    if ((bio1 = BIO_new(BIO_s_mem_chain())) == NULL
+            || (bio2 = BIO_new(BIO_s_mem_chain())) == NULL) {
+        BIO_free(bio1);
+        return 0;
+    }
+
+    /* Each half writes into the queue the other one reads */
+    bc1 = bio1->ptr;
+    bc2 = bio2->ptr;
+    bc1->wq = bc2->rq;
+    bc1->wq->references++;
+    bc2->wq = bc1->rq;
+    bc2->wq->references++;
+
+    *bio1_p = bio1;
+    *bio2_p = bio2;
+    return 1;
+}
+
+int BIO_mem_chain_peek(BIO *b, const unsigned char **data, size_t *len,
+                       int max)
+{
+    MEM_CHAIN_NODE *node;
+    int n = 0;
+
+    if (b == NULL || b->method != &mem_chain_method) {
+        BIOerr(BIO_F_BIO_MEM_CHAIN_PEEK, BIO_R_UNSUPPORTED_METHOD);
+        return -1;
+    }
+
+    node = ((BIO_MEM_CHAIN *)b->ptr)->rq->head;
+    for (; node != NULL && n < max; node = node->next) {
+        if (node->len == 0)
+            continue;
+        data[n] = node->seg->data + node->off;
+        len[n] = node->len;
+        n++;
+    }
+    return n;
+}
+
+int BIO_mem_chain_consume(BIO *b, size_t len)
+{
+    MEM_CHAIN_QUEUE *q;
+
+    if (b == NULL || b->method != &mem_chain_method) {
+        BIOerr(BIO_F_BIO_MEM_CHAIN_CONSUME, BIO_R_UNSUPPORTED_METHOD);
+        return 0;
+    }
+
+    q = ((BIO_MEM_CHAIN *)b->ptr)->rq;
+    mem_chain_release_held(q);
+    if (len > q->len) {
+        BIOerr(BIO_F_BIO_MEM_CHAIN_CONSUME, BIO_R_INVALID_ARGUMENT);
+        return 0;
+    }
+    mem_chain_advance(q, len, 0);
+    b->num_read += len;
+    return 1;
+}
+
+int BIO_mem_chain_move(BIO *to, BIO *from, size_t len, size_t *moved)
+{
+    MEM_CHAIN_QUEUE *src, *dst;
+    MEM_CHAIN_NODE *node, *slice;
+    size_t done = 0;
+    int i, ret = 1;
+
+    if (moved != NULL)
+        *moved = 0;
+    if (to == NULL || from == NULL
+            || to->method != &mem_chain_method
+            || from->method != &mem_chain_method) {
+        BIOerr(BIO_F_BIO_MEM_CHAIN_MOVE, BIO_R_UNSUPPORTED_METHOD);
+        return 0;
+    }
+
+    src = ((BIO_MEM_CHAIN *)from->ptr)->rq;
+    dst = ((BIO_MEM_CHAIN *)to->ptr)->wq;
+    if (src == dst) {
+        BIOerr(BIO_F_BIO_MEM_CHAIN_MOVE, BIO_R_INVALID_ARGUMENT);
+        return 0;
+    }
+    if (dst->closed) {
+        BIOerr(BIO_F_BIO_MEM_CHAIN_MOVE, BIO_R_BROKEN_PIPE);
+        return 0;
+    }
+
+    mem_chain_release_held(src);
+    while (done < len && src->len > 0) {
+        /* drop empty nodes in front of the data */
+        mem_chain_advance(src, 0, 0);
+        node = src->head;
+
+        if (node->len <= len - done) {
+            /* the whole node changes hands, append rights included */
+            src->head = node->next;
+            if (src->head == NULL)
+                src->tail = NULL;
+            src->len -= node->len;
+        } else {
+            /* the first part only: share the segment */
+            if ((slice = mem_chain_node_new(dst)) == NULL) {
+                BIOerr(BIO_F_BIO_MEM_CHAIN_MOVE, ERR_R_MALLOC_FAILURE);
+                ret = 0;
+                break;
+            }
+            CRYPTO_UP_REF(&node->seg->references, &i, node->seg->lock);
+            slice->seg = node->seg;
+            slice->off = node->off;
+            slice->len = len - done;
+            node->off += slice->len;
+            node->len -= slice->len;
+            src->len -= slice->len;
+            node = slice;
+        }
+        mem_chain_push(dst, node);
+        dst->len += node->len;
+        done += node->len;
+    }
+
+    from->num_read += done;
+    to->num_write += done;
+    if (moved != NULL)
+        *moved = done;
+    return ret;
+}
@@ -11,11 +11,21 @@
 #include <errno.h>
 #include "bio_local.h"
 #include "internal/cryptlib.h"
+#include "internal/ktls.h"
 
 #ifndef OPENSSL_NO_SOCK
 
 # include <openssl/bio.h>
 
+# if defined(OPENSSL_SYS_LINUX) && defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY)
+#  include <linux/errqueue.h>
+#  ifdef SO_EE_ORIGIN_ZEROCOPY
+#   define OPENSSL_SOCK_ZEROCOPY
+/* How many zerocopy sends may be in flight before writes are copied again */
+#   define SOCK_ZEROCOPY_WINDOW   256
+#  endif
+# endif
+
 # ifdef WATT32
 /* Watt-32 uses same names */
 #  undef sock_write
@@ -34,6 +44,23 @@ static int sock_new(BIO *h);
 static int sock_free(BIO *data);
 int BIO_sock_should_retry(int s);
 
+typedef struct bio_sock_data_st {
+    /* Record type of the next kTLS control message */
+    unsigned char ktls_record_type;
+# ifdef OPENSSL_SOCK_ZEROCOPY
+    /* Writes of at least this many bytes use MSG_ZEROCOPY */
+    size_t zc_min;
+    /*
+     * Zerocopy sends issued and the oldest one not reported complete yet,
+     * both counting from 0 like the kernel's notification ids
+     */
+    uint32_t zc_sent;
+    uint32_t zc_done;
+    /* Completions reported ahead of |zc_done|, bit id % window */
+    unsigned char zc_ahead[SOCK_ZEROCOPY_WINDOW / 8];
+# endif
+} bio_sock_data;
+
 static const BIO_METHOD methods_sockp = {
     BIO_TYPE_SOCKET,
     "socket",
@@ -69,14 +96,18 @@ BIO *BIO_new_socket(int fd, int close_flag)
 
 static int sock_new(BIO *bi)
 {
+    bio_sock_data *data = OPENSSL_zalloc(sizeof(*data));
+
+    if (data == NULL)
+        return 0;
     bi->init = 0;
     bi->num = 0;
-    bi->ptr = NULL;
+    bi->ptr = data;
     bi->flags = 0;
     return 1;
 }
 
-static int sock_free(BIO *a)
+static int sock_clear(BIO *a)
 {
     if (a == NULL)
         return 0;
@@ -90,6 +121,123 @@ static int sock_free(BIO *a)
     return 1;
 }
 
+static int sock_free(BIO *a)
+{
+    if (!sock_clear(a))
+        return 0;
+    OPENSSL_free(a->ptr);
+    a->ptr = NULL;
+    return 1;
+}
+
+# ifdef OPENSSL_SOCK_ZEROCOPY
+static int sock_zerocopy_enable(BIO *b, long min)
+{
+    bio_sock_data *data = (bio_sock_data *)b->ptr;
+    int on = 1;
+
+    if (min < 0)
+        return 0;
+    if (min == 0) {
+        BIO_clear_flags(b, BIO_FLAGS_ZEROCOPY);
+        return 1;
+    }
+    if (!BIO_test_flags(b, BIO_FLAGS_ZEROCOPY)
+            && setsockopt(b->num, SOL_SOCKET, SO_ZEROCOPY,
+                          (void *)&on, sizeof(on)) < 0)
+        return 0;
+    data->zc_min = (size_t)min;
+    BIO_set_flags(b, BIO_FLAGS_ZEROCOPY);
+    return 1;
+}
+
+static int sock_zerocopy_write(BIO *b, const char *in, int inl)
+{
+    bio_sock_data *data = (bio_sock_data *)b->ptr;
+    int ret;
+
+    /*
+     * The kernel TLS transmit path refuses MSG_ZEROCOPY, and past the window
+     * completions could no longer be told apart.
+     */
+    if ((size_t)inl < data->zc_min
+#  ifndef OPENSSL_NO_KTLS
+            || BIO_should_ktls_flag(b)
+#  endif
+            || data->zc_sent - data->zc_done >= SOCK_ZEROCOPY_WINDOW)
+        return writesocket(b->num, in, inl);
+
+    ret = send(b->num, in, inl, MSG_ZEROCOPY);
+    if (ret > 0)
+        data->zc_sent++;
+    else if (ret < 0 && get_last_socket_error() == ENOBUFS)
+        /* Out of optmem for the notification: copy this one */
+        ret = writesocket(b->num, in, inl);
+    return ret;
+}
+
+/*
+ * Read the zerocopy notifications off the socket error queue. Each one covers
+ * a range of send ids; they normally arrive in order but need not, so
+ * |zc_done| only moves past ids that have all been reported.
+ */
+static void sock_zerocopy_reap(BIO *b)
+{
+    bio_sock_data *data = (bio_sock_data *)b->ptr;
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(struct sock_extended_err)
+                            + sizeof(struct sockaddr_storage))];
+    } control;
+    struct sock_extended_err serr;
+    struct cmsghdr *cmsg;
+    struct msghdr msg;
+    uint32_t i, id, inflight;
+
+    while (data->zc_done != data->zc_sent) {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+        if (recvmsg(b->num, &msg, MSG_ERRQUEUE) < 0)
+            break;
+
+        for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL;
+             cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_len < CMSG_LEN(sizeof(serr)))
+                continue;
+            memcpy(&serr, CMSG_DATA(cmsg), sizeof(serr));
+            if (serr.ee_errno != 0 || serr.ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+                continue;
+            /* [ee_info, ee_data] are done */
+            inflight = data->zc_sent - data->zc_done;
+            for (i = 0; i < inflight; i++) {
+                id = data->zc_done + i;
+                if (id - serr.ee_info <= serr.ee_data - serr.ee_info)
+                    data->zc_ahead[(id % SOCK_ZEROCOPY_WINDOW) / 8] |=
+                        1 << (id % 8);
+            }
+            /*
+             * The kernel had to copy the data anyway, so pinning the
+             * caller's buffers only costs: go back to plain sends.
+             */
+            if ((serr.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0)
+                BIO_clear_flags(b, BIO_FLAGS_ZEROCOPY);
+        }
+
+        while (data->zc_done != data->zc_sent) {
+            unsigned char *ahead =
+                &data->zc_ahead[(data->zc_done % SOCK_ZEROCOPY_WINDOW) / 8];
+            unsigned char bit = 1 << (data->zc_done % 8);
+
+            if ((*ahead & bit) == 0)
+                break;
+            *ahead &= ~bit;
+            data->zc_done++;
+        }
+    }
+}
+# endif
+
 static int sock_read(BIO *b, char *out, int outl)
 {
     int ret = 0;
@@ -113,7 +261,23 @@ static int sock_write(BIO *b, const char *in, int inl)
     int ret;
 
     clear_socket_error();
-    ret = writesocket(b->num, in, inl);
+#ifndef OPENSSL_NO_KTLS
+    if (BIO_should_ktls_ctrl_msg_flag(b)) {
+        bio_sock_data *data = (bio_sock_data *)b->ptr;
+
+        ret = ktls_send_ctrl_message(b->num, data->ktls_record_type, in, inl);
+        if (ret >= 0) {
+            ret = inl;
+            BIO_clear_ktls_ctrl_msg_flag(b);
+        }
+    } else
+#endif
+# ifdef OPENSSL_SOCK_ZEROCOPY
+    if (BIO_test_flags(b, BIO_FLAGS_ZEROCOPY))
+        ret = sock_zerocopy_write(b, in, inl);
+    else
+# endif
+        ret = writesocket(b->num, in, inl);
     BIO_clear_retry_flags(b);
     if (ret <= 0) {
         if (BIO_sock_should_retry(ret))
@@ -124,15 +288,25 @@ static int sock_write(BIO *b, const char *in, int inl)
 
 static long sock_ctrl(BIO *b, int cmd, long num, void *ptr)
 {
+    bio_sock_data *data = (bio_sock_data *)b->ptr;
     long ret = 1;
     int *ip;
 
     switch (cmd) {
     case BIO_C_SET_FD:
-        sock_free(b);
+        sock_clear(b);
         b->num = *((int *)ptr);
         b->shutdown = (int)num;
         b->init = 1;
+#ifndef OPENSSL_NO_KTLS
+        BIO_clear_flags(b, BIO_FLAGS_KTLS_TX | BIO_FLAGS_KTLS_TX_CTRL_MSG);
+#endif
+        BIO_clear_flags(b, BIO_FLAGS_ZEROCOPY);
+        data->ktls_record_type = 0;
+# ifdef OPENSSL_SOCK_ZEROCOPY
+        data->zc_sent = data->zc_done = 0;
+        memset(data->zc_ahead, 0, sizeof(data->zc_ahead));
+# endif
         break;
     case BIO_C_GET_FD:
         if (b->init) {
@@ -156,6 +330,50 @@ static long sock_ctrl(BIO *b, int cmd, long num, void *ptr)
     case BIO_CTRL_EOF:
         ret = (b->flags & BIO_FLAGS_IN_EOF) != 0 ? 1 : 0;
         break;
+#ifndef OPENSSL_NO_KTLS
+    case BIO_CTRL_SET_KTLS:
+        /* Only the send direction is offloaded */
+        if (num != 1 || ptr == NULL) {
+            ret = 0;
+            break;
+        }
+        if (!BIO_should_ktls_flag(b) && !ktls_enable(b->num)) {
+            ret = 0;
+            break;
+        }
+        ret = ktls_start(b->num, (const ktls_crypto_info_t *)ptr);
+        if (ret)
+            BIO_set_ktls_flag(b);
+        break;
+    case BIO_CTRL_GET_KTLS_SEND:
+        ret = BIO_should_ktls_flag(b) != 0;
+        break;
+    case BIO_CTRL_SET_KTLS_TX_SEND_CTRL_MSG:
+        BIO_set_ktls_ctrl_msg_flag(b);
+        data->ktls_record_type = (unsigned char)num;
+        ret = 0;
+        break;
+    case BIO_CTRL_CLEAR_KTLS_TX_CTRL_MSG:
+        BIO_clear_ktls_ctrl_msg_flag(b);
+        ret = 0;
+        break;
+#endif
+# ifdef OPENSSL_SOCK_ZEROCOPY
+    case BIO_CTRL_SET_ZEROCOPY:
+        ret = b->init && sock_zerocopy_enable(b, num);
+        break;
+    case BIO_CTRL_GET_ZEROCOPY_SENT:
+        ret = data->zc_sent;
+        break;
+    case BIO_CTRL_GET_ZEROCOPY_DONE:
+        sock_zerocopy_reap(b);
+        ret = data->zc_done;
+        break;
+# else
+    case BIO_CTRL_SET_ZEROCOPY:
+        ret = num == 0;
+        break;
+# endif
     default:
         ret = 0;
         break;
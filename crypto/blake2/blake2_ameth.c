@@ -0,0 +1,137 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <stdio.h>
+#include "internal/cryptlib.h"
+#include <openssl/evp.h>
+#include "crypto/asn1.h"
+#include "blake2_local.h"
+#include "crypto/evp.h"
+
+/*
+ * BLAKE2 MAC "ASN1" methods. These are just here to indicate the maximum
+ * output length and to set, get and free up a BLAKE2 key.
+ */
+
+static size_t blake2_mac_key_bytes(const EVP_PKEY *pkey)
+{
+    return pkey->ameth->pkey_id == EVP_PKEY_BLAKE2BMAC ? BLAKE2B_KEYBYTES
+                                                       : BLAKE2S_KEYBYTES;
+}
+
+static int blake2_mac_size(const EVP_PKEY *pkey)
+{
+    return pkey->ameth->pkey_id == EVP_PKEY_BLAKE2BMAC ? BLAKE2B_OUTBYTES
+                                                       : BLAKE2S_OUTBYTES;
+}
+
+static void blake2_mac_key_free(EVP_PKEY *pkey)
+{
+    ASN1_OCTET_STRING *os = EVP_PKEY_get0(pkey);
+
+    if (os != NULL) {
+        if (os->data != NULL)
+            OPENSSL_cleanse(os->data, os->length);
+        ASN1_OCTET_STRING_free(os);
+    }
+}
+
+static int blake2_mac_pkey_ctrl(EVP_PKEY *pkey, int op, long arg1, void *arg2)
+{
+    /* nothing (including ASN1_PKEY_CTRL_DEFAULT_MD_NID), is supported */
+    return -2;
+}
+
+static int blake2_mac_pkey_public_cmp(const EVP_PKEY *a, const EVP_PKEY *b)
+{
+    return ASN1_OCTET_STRING_cmp(EVP_PKEY_get0(a), EVP_PKEY_get0(b)) == 0;
+}
+
+static int blake2_mac_set_priv_key(EVP_PKEY *pkey, const unsigned char *priv,
+                                   size_t len)
+{
+    ASN1_OCTET_STRING *os;
+
+    if (pkey->pkey.ptr != NULL || len == 0
+        || len > blake2_mac_key_bytes(pkey))
+        return 0;
+
+    os = ASN1_OCTET_STRING_new();
+    if (os == NULL)
+        return 0;
+
+    if (!ASN1_OCTET_STRING_set(os, priv, len)) {
+        ASN1_OCTET_STRING_free(os);
+        return 0;
+    }
+
+    pkey->pkey.ptr = os;
+    return 1;
+}
+
+static int blake2_mac_get_priv_key(const EVP_PKEY *pkey, unsigned char *priv,
+                                   size_t *len)
+{
+    ASN1_OCTET_STRING *os = (ASN1_OCTET_STRING *)pkey->pkey.ptr;
+
+    if (priv == NULL) {
+        *len = os != NULL ? (size_t)ASN1_STRING_length(os)
+                          : blake2_mac_key_bytes(pkey);
+        return 1;
+    }
+
+    if (os == NULL || *len < (size_t)ASN1_STRING_length(os))
+        return 0;
+
+    *len = ASN1_STRING_length(os);
+    memcpy(priv, ASN1_STRING_get0_data(os), *len);
+
+    return 1;
+}
+
+#define IMPLEMENT_BLAKE2_MAC_ASN1_METH(name, id, pem_str, info)    \
+const EVP_PKEY_ASN1_METHOD name##_asn1_meth = {                     \
+    id,                                                             \
+    id,                                                             \
+    0,                                                              \
+                                                                    \
+    pem_str,                                                        \
+    info,                                                           \
+                                                                    \
+    0, 0, blake2_mac_pkey_public_cmp, 0,                            \
+                                                                    \
+    0, 0, 0,                                                        \
+                                                                    \
+    blake2_mac_size,                                                \
+    0, 0,                                                           \
+    0, 0, 0, 0, 0, 0, 0,                                            \
+                                                                    \
+    blake2_mac_key_free,                                            \
+    blake2_mac_pkey_ctrl,                                           \
+    NULL,                                                           \
+    NULL,                                                           \
+                                                                    \
+    NULL,                                                           \
+    NULL,                                                           \
+    NULL,                                                           \
+                                                                    \
+    NULL,                                                           \
+    NULL,                                                           \
+    NULL,                                                           \
+                                                                    \
+    blake2_mac_set_priv_key,                                        \
+    NULL,                                                           \
+    blake2_mac_get_priv_key,                                        \
+    NULL,                                                           \
+}
+
+IMPLEMENT_BLAKE2_MAC_ASN1_METH(blake2b_mac, EVP_PKEY_BLAKE2BMAC,
+                               "BLAKE2BMAC", "OpenSSL BLAKE2BMAC method");
+IMPLEMENT_BLAKE2_MAC_ASN1_METH(blake2s_mac, EVP_PKEY_BLAKE2SMAC,
+                               "BLAKE2SMAC", "OpenSSL BLAKE2SMAC method");
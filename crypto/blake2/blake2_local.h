@@ -49,6 +49,7 @@ struct blake2s_ctx_st {
     uint32_t f[2];
     uint8_t  buf[BLAKE2S_BLOCKBYTES];
     size_t   buflen;
+    size_t   outlen;
 };
 
 struct blake2b_param_st {
@@ -73,6 +74,7 @@ struct blake2b_ctx_st {
     uint64_t f[2];
     uint8_t  buf[BLAKE2B_BLOCKBYTES];
     size_t   buflen;
+    size_t   outlen;
 };
 
 #define BLAKE2B_DIGEST_LENGTH 64
@@ -82,9 +84,15 @@ typedef struct blake2s_ctx_st BLAKE2S_CTX;
 typedef struct blake2b_ctx_st BLAKE2B_CTX;
 
 int BLAKE2b_Init(BLAKE2B_CTX *c);
+int BLAKE2b_Init_key(BLAKE2B_CTX *c, size_t outlen,
+                     const void *key, size_t keylen,
+                     const uint8_t *salt, const uint8_t *personal);
 int BLAKE2b_Update(BLAKE2B_CTX *c, const void *data, size_t datalen);
 int BLAKE2b_Final(unsigned char *md, BLAKE2B_CTX *c);
 
 int BLAKE2s_Init(BLAKE2S_CTX *c);
+int BLAKE2s_Init_key(BLAKE2S_CTX *c, size_t outlen,
+                     const void *key, size_t keylen,
+                     const uint8_t *salt, const uint8_t *personal);
 int BLAKE2s_Update(BLAKE2S_CTX *c, const void *data, size_t datalen);
 int BLAKE2s_Final(unsigned char *md, BLAKE2S_CTX *c);
@@ -0,0 +1,281 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <stdio.h>
+#include "internal/cryptlib.h"
+#include <openssl/evp.h>
+#include <openssl/err.h>
+#include "blake2_local.h"
+#include "crypto/evp.h"
+
+/*
+ * Keyed BLAKE2b and BLAKE2s (RFC 7693), with optional digest size, salt and
+ * personalization.  Both share this pkey context structure.
+ */
+
+typedef struct blake2_mac_pkey_ctx_st {
+    ASN1_OCTET_STRING ktmp;     /* Temp storage for key */
+    size_t outlen;              /* 0 for the largest digest */
+    uint8_t salt[BLAKE2B_SALTBYTES];
+    uint8_t personal[BLAKE2B_PERSONALBYTES];
+    union {
+        BLAKE2B_CTX b;
+        BLAKE2S_CTX s;
+    } ctx;
+} BLAKE2_MAC_PKEY_CTX;
+
+static int blake2_mac_is_b(EVP_PKEY_CTX *ctx)
+{
+    return ctx->pmeth->pkey_id == EVP_PKEY_BLAKE2BMAC;
+}
+
+/* (Re)starts the MAC with the key and parameters of |ctx| */
+static int blake2_mac_start(EVP_PKEY_CTX *ctx)
+{
+    BLAKE2_MAC_PKEY_CTX *pctx = EVP_PKEY_CTX_get_data(ctx);
+    const unsigned char *key = ASN1_STRING_get0_data(&pctx->ktmp);
+    size_t keylen = ASN1_STRING_length(&pctx->ktmp);
+
+    if (key == NULL || keylen == 0)
+        return 0;
+    if (blake2_mac_is_b(ctx))
+        return BLAKE2b_Init_key(&pctx->ctx.b,
+                                pctx->outlen != 0 ? pctx->outlen
+                                                  : BLAKE2B_OUTBYTES,
+                                key, keylen, pctx->salt, pctx->personal);
+    return BLAKE2s_Init_key(&pctx->ctx.s,
+                            pctx->outlen != 0 ? pctx->outlen
+                                              : BLAKE2S_OUTBYTES,
+                            key, keylen, pctx->salt, pctx->personal);
+}
+
+static int pkey_blake2_mac_init(EVP_PKEY_CTX *ctx)
+{
+    BLAKE2_MAC_PKEY_CTX *pctx;
+
+    if ((pctx = OPENSSL_zalloc(sizeof(*pctx))) == NULL) {
+        CRYPTOerr(CRYPTO_F_PKEY_BLAKE2_MAC_INIT, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    pctx->ktmp.type = V_ASN1_OCTET_STRING;
+
+    EVP_PKEY_CTX_set_data(ctx, pctx);
+    EVP_PKEY_CTX_set0_keygen_info(ctx, NULL, 0);
+    return 1;
+}
+
+static void pkey_blake2_mac_cleanup(EVP_PKEY_CTX *ctx)
+{
+    BLAKE2_MAC_PKEY_CTX *pctx = EVP_PKEY_CTX_get_data(ctx);
+
+    if (pctx != NULL) {
+        OPENSSL_clear_free(pctx->ktmp.data, pctx->ktmp.length);
+        OPENSSL_clear_free(pctx, sizeof(*pctx));
+        EVP_PKEY_CTX_set_data(ctx, NULL);
+    }
+}
+
+static int pkey_blake2_mac_copy(EVP_PKEY_CTX *dst, EVP_PKEY_CTX *src)
+{
+    BLAKE2_MAC_PKEY_CTX *sctx, *dctx;
+    ASN1_OCTET_STRING ktmp;
+
+    if (!pkey_blake2_mac_init(dst))
+        return 0;
+    sctx = EVP_PKEY_CTX_get_data(src);
+    dctx = EVP_PKEY_CTX_get_data(dst);
+    ktmp = dctx->ktmp;
+    *dctx = *sctx;
+    dctx->ktmp = ktmp;
+    if (ASN1_STRING_get0_data(&sctx->ktmp) != NULL &&
+        !ASN1_STRING_copy(&dctx->ktmp, &sctx->ktmp)) {
+        pkey_blake2_mac_cleanup(dst);
+        return 0;
+    }
+    return 1;
+}
+
+static int pkey_blake2_mac_keygen(EVP_PKEY_CTX *ctx, EVP_PKEY *pkey)
+{
+    ASN1_OCTET_STRING *key;
+    BLAKE2_MAC_PKEY_CTX *pctx = EVP_PKEY_CTX_get_data(ctx);
+
+    if (ASN1_STRING_get0_data(&pctx->ktmp) == NULL)
+        return 0;
+    key = ASN1_OCTET_STRING_dup(&pctx->ktmp);
+    if (key == NULL)
+        return 0;
+    if (!EVP_PKEY_assign(pkey, ctx->pmeth->pkey_id, key)) {
+        ASN1_OCTET_STRING_free(key);
+        return 0;
+    }
+    return 1;
+}
+
+static int int_update(EVP_MD_CTX *ctx, const void *data, size_t count)
+{
+    EVP_PKEY_CTX *pkctx = EVP_MD_CTX_pkey_ctx(ctx);
+    BLAKE2_MAC_PKEY_CTX *pctx = EVP_PKEY_CTX_get_data(pkctx);
+
+    if (blake2_mac_is_b(pkctx))
+        return BLAKE2b_Update(&pctx->ctx.b, data, count);
+    return BLAKE2s_Update(&pctx->ctx.s, data, count);
+}
+
+static int blake2_mac_signctx_init(EVP_PKEY_CTX *ctx, EVP_MD_CTX *mctx)
+{
+    BLAKE2_MAC_PKEY_CTX *pctx = EVP_PKEY_CTX_get_data(ctx);
+    ASN1_OCTET_STRING *key = EVP_PKEY_get0(EVP_PKEY_CTX_get0_pkey(ctx));
+
+    if (key == NULL || !ASN1_STRING_copy(&pctx->ktmp, key))
+        return 0;
+    EVP_MD_CTX_set_flags(mctx, EVP_MD_CTX_FLAG_NO_INIT);
+    EVP_MD_CTX_set_update_fn(mctx, int_update);
+    return blake2_mac_start(ctx);
+}
+
+static int blake2_mac_signctx(EVP_PKEY_CTX *ctx, unsigned char *sig,
+                              size_t *siglen, EVP_MD_CTX *mctx)
+{
+    BLAKE2_MAC_PKEY_CTX *pctx = EVP_PKEY_CTX_get_data(ctx);
+
+    if (blake2_mac_is_b(ctx)) {
+        *siglen = pctx->ctx.b.outlen;
+        if (sig != NULL)
+            return BLAKE2b_Final(sig, &pctx->ctx.b);
+    } else {
+        *siglen = pctx->ctx.s.outlen;
+        if (sig != NULL)
+            return BLAKE2s_Final(sig, &pctx->ctx.s);
+    }
+    return 1;
+}
+
+static int pkey_blake2_mac_ctrl(EVP_PKEY_CTX *ctx, int type, int p1, void *p2)
+{
+    BLAKE2_MAC_PKEY_CTX *pctx = EVP_PKEY_CTX_get_data(ctx);
+    int is_b = blake2_mac_is_b(ctx);
+    size_t outbytes = is_b ? BLAKE2B_OUTBYTES : BLAKE2S_OUTBYTES;
+    size_t keybytes = is_b ? BLAKE2B_KEYBYTES : BLAKE2S_KEYBYTES;
+    size_t saltbytes = is_b ? BLAKE2B_SALTBYTES : BLAKE2S_SALTBYTES;
+    size_t personalbytes = is_b ? BLAKE2B_PERSONALBYTES
+                                : BLAKE2S_PERSONALBYTES;
+
+    switch (type) {
+
+    case EVP_PKEY_CTRL_MD:
+    case EVP_PKEY_CTRL_DIGESTINIT:
+        /* ignore */
+        return 1;
+
+    case EVP_PKEY_CTRL_SET_MAC_KEY:
+        if (p1 <= 0 || (size_t)p1 > keybytes
+            || !ASN1_OCTET_STRING_set(&pctx->ktmp, p2, p1))
+            return 0;
+        return 1;
+
+    /*
+     * The parameters are hashed into the initial state, so a MAC already
+     * started is restarted: they must be set before any data.
+     */
+    case EVP_PKEY_CTRL_SET_DIGEST_SIZE:
+        if (p1 <= 0 || (size_t)p1 > outbytes)
+            return 0;
+        pctx->outlen = p1;
+        break;
+
+    case EVP_PKEY_CTRL_BLAKE2_SALT:
+        if (p1 < 0 || (size_t)p1 > saltbytes)
+            return 0;
+        memset(pctx->salt, 0, sizeof(pctx->salt));
+        if (p1 > 0)
+            memcpy(pctx->salt, p2, p1);
+        break;
+
+    case EVP_PKEY_CTRL_BLAKE2_PERSONAL:
+        if (p1 < 0 || (size_t)p1 > personalbytes)
+            return 0;
+        memset(pctx->personal, 0, sizeof(pctx->personal));
+        if (p1 > 0)
+            memcpy(pctx->personal, p2, p1);
+        break;
+
+    default:
+        return -2;
+
+    }
+    if (ctx->operation == EVP_PKEY_OP_SIGNCTX)
+        return blake2_mac_start(ctx);
+    return 1;
+}
+
+static int pkey_blake2_mac_ctrl_str(EVP_PKEY_CTX *ctx,
+                                    const char *type, const char *value)
+{
+    if (value == NULL)
+        return 0;
+    if (strcmp(type, "digestsize") == 0) {
+        int hash_size = atoi(value);
+
+        return pkey_blake2_mac_ctrl(ctx, EVP_PKEY_CTRL_SET_DIGEST_SIZE,
+                                    hash_size, NULL);
+    }
+    if (strcmp(type, "key") == 0)
+        return EVP_PKEY_CTX_str2ctrl(ctx, EVP_PKEY_CTRL_SET_MAC_KEY, value);
+    if (strcmp(type, "hexkey") == 0)
+        return EVP_PKEY_CTX_hex2ctrl(ctx, EVP_PKEY_CTRL_SET_MAC_KEY, value);
+    if (strcmp(type, "salt") == 0)
+        return EVP_PKEY_CTX_str2ctrl(ctx, EVP_PKEY_CTRL_BLAKE2_SALT, value);
+    if (strcmp(type, "hexsalt") == 0)
+        return EVP_PKEY_CTX_hex2ctrl(ctx, EVP_PKEY_CTRL_BLAKE2_SALT, value);
+    if (strcmp(type, "personal") == 0)
+        return EVP_PKEY_CTX_str2ctrl(ctx, EVP_PKEY_CTRL_BLAKE2_PERSONAL,
+                                     value);
+    if (strcmp(type, "hexpersonal") == 0)
+        return EVP_PKEY_CTX_hex2ctrl(ctx, EVP_PKEY_CTRL_BLAKE2_PERSONAL,
+                                     value);
+    return -2;
+}
+
+#define IMPLEMENT_BLAKE2_MAC_PKEY_METH(name, id)        \
+const EVP_PKEY_METHOD name##_pkey_meth = {              \
+    id,                                                 \
+    EVP_PKEY_FLAG_SIGCTX_CUSTOM, /* we don't deal with a separate MD */ \
+    pkey_blake2_mac_init,                               \
+    pkey_blake2_mac_copy,                               \
+    pkey_blake2_mac_cleanup,                            \
+                                                        \
+    0, 0,                                               \
+                                                        \
+    0,                                                  \
+    pkey_blake2_mac_keygen,                             \
+                                                        \
+    0, 0,                                               \
+                                                        \
+    0, 0,                                               \
+                                                        \
+    0, 0,                                               \
+                                                        \
+    blake2_mac_signctx_init,                            \
+    blake2_mac_signctx,                                 \
+                                                        \
+    0, 0,                                               \
+                                                        \
+    0, 0,                                               \
+                                                        \
+    0, 0,                                               \
+                                                        \
+    0, 0,                                               \
+                                                        \
+    pkey_blake2_mac_ctrl,                               \
+    pkey_blake2_mac_ctrl_str                            \
+}
+
+IMPLEMENT_BLAKE2_MAC_PKEY_METH(blake2b_mac, EVP_PKEY_BLAKE2BMAC);
+IMPLEMENT_BLAKE2_MAC_PKEY_METH(blake2s_mac, EVP_PKEY_BLAKE2SMAC);
@@ -80,10 +80,28 @@ static void blake2b_init_param(BLAKE2B_CTX *S, const BLAKE2B_PARAM *P)
 
 /* Initialize the hashing context.  Always returns 1. */
 int BLAKE2b_Init(BLAKE2B_CTX *c)
+{
+    return BLAKE2b_Init_key(c, BLAKE2B_DIGEST_LENGTH, NULL, 0, NULL, NULL);
+}
+
+/*
+ * Initialize the hashing context for a digest of |outlen| bytes, keyed with
+ * the |keylen| bytes at |key| if |keylen| is not zero.  |salt| and |personal|,
+ * if not NULL, are BLAKE2B_SALTBYTES and BLAKE2B_PERSONALBYTES long.
+ * Returns 1 on success, 0 if a length is out of range.
+ */
+int BLAKE2b_Init_key(BLAKE2B_CTX *c, size_t outlen,
+                     const void *key, size_t keylen,
+                     const uint8_t *salt, const uint8_t *personal)
 {
     BLAKE2B_PARAM P[1];
-    P->digest_length = BLAKE2B_DIGEST_LENGTH;
-    P->key_length    = 0;
+
+    if (outlen == 0 || outlen > BLAKE2B_OUTBYTES
+        || keylen > BLAKE2B_KEYBYTES)
+        return 0;
+
+    P->digest_length = (uint8_t)outlen;
+    P->key_length    = (uint8_t)keylen;
     P->fanout        = 1;
     P->depth         = 1;
     store32(P->leaf_length, 0);
@@ -91,9 +109,26 @@ int BLAKE2b_Init(BLAKE2B_CTX *c)
     P->node_depth    = 0;
     P->inner_length  = 0;
     memset(P->reserved, 0, sizeof(P->reserved));
-    memset(P->salt,     0, sizeof(P->salt));
-    memset(P->personal, 0, sizeof(P->personal));
+    if (salt != NULL)
+        memcpy(P->salt, salt, sizeof(P->salt));
+    else
+        memset(P->salt, 0, sizeof(P->salt));
+    if (personal != NULL)
+        memcpy(P->personal, personal, sizeof(P->personal));
+    else
+        memset(P->personal, 0, sizeof(P->personal));
     blake2b_init_param(c, P);
+    c->outlen = outlen;
+
+    /* The key is hashed as a first block of its own, padded with zeros */
+    if (keylen > 0) {
+        uint8_t block[BLAKE2B_BLOCKBYTES];
+
+        memset(block, 0, sizeof(block));
+        memcpy(block, key, keylen);
+        BLAKE2b_Update(c, block, sizeof(block));
+        OPENSSL_cleanse(block, sizeof(block));
+    }
     return 1;
 }
 
@@ -252,6 +287,7 @@ int BLAKE2b_Update(BLAKE2B_CTX *c, const void *data, size_t datalen)
  */
 int BLAKE2b_Final(unsigned char *md, BLAKE2B_CTX *c)
 {
+    uint8_t outbuf[BLAKE2B_OUTBYTES];
     int i;
 
     blake2b_set_lastblock(c);
@@ -259,11 +295,13 @@ int BLAKE2b_Final(unsigned char *md, BLAKE2B_CTX *c)
     memset(c->buf + c->buflen, 0, sizeof(c->buf) - c->buflen);
     blake2b_compress(c, c->buf, c->buflen);
 
-    /* Output full hash to message digest */
+    /* Output full hash to temp buffer */
     for (i = 0; i < 8; ++i) {
-        store64(md + sizeof(c->h[i]) * i, c->h[i]);
+        store64(outbuf + sizeof(c->h[i]) * i, c->h[i]);
     }
+    memcpy(md, outbuf, c->outlen);
 
+    OPENSSL_cleanse(outbuf, sizeof(outbuf));
     OPENSSL_cleanse(c, sizeof(BLAKE2B_CTX));
     return 1;
 }
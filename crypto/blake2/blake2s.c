@@ -76,20 +76,54 @@ static void blake2s_init_param(BLAKE2S_CTX *S, const BLAKE2S_PARAM *P)
 
 /* Initialize the hashing context.  Always returns 1. */
 int BLAKE2s_Init(BLAKE2S_CTX *c)
+{
+    return BLAKE2s_Init_key(c, BLAKE2S_DIGEST_LENGTH, NULL, 0, NULL, NULL);
+}
+
+/*
+ * Initialize the hashing context for a digest of |outlen| bytes, keyed with
+ * the |keylen| bytes at |key| if |keylen| is not zero.  |salt| and |personal|,
+ * if not NULL, are BLAKE2S_SALTBYTES and BLAKE2S_PERSONALBYTES long.
+ * Returns 1 on success, 0 if a length is out of range.
+ */
+int BLAKE2s_Init_key(BLAKE2S_CTX *c, size_t outlen,
+                     const void *key, size_t keylen,
+                     const uint8_t *salt, const uint8_t *personal)
 {
     BLAKE2S_PARAM P[1];
 
-    P->digest_length = BLAKE2S_DIGEST_LENGTH;
-    P->key_length    = 0;
+    if (outlen == 0 || outlen > BLAKE2S_OUTBYTES
+        || keylen > BLAKE2S_KEYBYTES)
+        return 0;
+
+    P->digest_length = (uint8_t)outlen;
+    P->key_length    = (uint8_t)keylen;
     P->fanout        = 1;
     P->depth         = 1;
     store32(P->leaf_length, 0);
     store48(P->node_offset, 0);
     P->node_depth    = 0;
     P->inner_length  = 0;
-    memset(P->salt,     0, sizeof(P->salt));
-    memset(P->personal, 0, sizeof(P->personal));
+    if (salt != NULL)
+        memcpy(P->salt, salt, sizeof(P->salt));
+    else
+        memset(P->salt, 0, sizeof(P->salt));
+    if (personal != NULL)
+        memcpy(P->personal, personal, sizeof(P->personal));
+    else
+        memset(P->personal, 0, sizeof(P->personal));
     blake2s_init_param(c, P);
+    c->outlen = outlen;
+
+    /* The key is hashed as a first block of its own, padded with zeros */
+    if (keylen > 0) {
+        uint8_t block[BLAKE2S_BLOCKBYTES];
+
+        memset(block, 0, sizeof(block));
+        memcpy(block, key, keylen);
+        BLAKE2s_Update(c, block, sizeof(block));
+        OPENSSL_cleanse(block, sizeof(block));
+    }
     return 1;
 }
 
@@ -246,6 +280,7 @@ int BLAKE2s_Update(BLAKE2S_CTX *c, const void *data, size_t datalen)
  */
 int BLAKE2s_Final(unsigned char *md, BLAKE2S_CTX *c)
 {
+    uint8_t outbuf[BLAKE2S_OUTBYTES];
     int i;
 
     blake2s_set_lastblock(c);
@@ -255,9 +290,11 @@ int BLAKE2s_Final(unsigned char *md, BLAKE2S_CTX *c)
 
     /* Output full hash to temp buffer */
     for (i = 0; i < 8; ++i) {
-        store32(md + sizeof(c->h[i]) * i, c->h[i]);
+        store32(outbuf + sizeof(c->h[i]) * i, c->h[i]);
     }
+    memcpy(md, outbuf, c->outlen);
 
+    OPENSSL_cleanse(outbuf, sizeof(outbuf));
     OPENSSL_cleanse(c, sizeof(BLAKE2S_CTX));
     return 1;
 }
@@ -0,0 +1,355 @@
+#! /usr/bin/env perl
+# Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+#
+# Licensed under the OpenSSL license (the "License").  You may not use
+# this file except in compliance with the License.  You can obtain a copy
+# in the file LICENSE in the source distribution or at
+# https://www.openssl.org/source/license.html
+
+#
+# Almost Montgomery multiplication for x86_64 with AVX-512 IFMA, for the
+# 1536- and 2048-bit moduli of the CRT halves of RSA-3072 and RSA-4096.
+#
+# Numbers are in radix 2^52, one digit per 64-bit lane, so that 30 digits
+# in four registers hold a 1536-bit number and 40 in five a 2048-bit one.
+# VPMADD52LUQ and VPMADD52HUQ add the low and high 52 bits of the 104-bit
+# products of a whole register of digits by one digit of the multiplier,
+# and leave the lanes enough headroom that carries are not propagated
+# until the end. The digit that the Montgomery reduction zeroes is kept
+# in a general-purpose register, where MULX computes its product by the
+# multiplier digit and the next quotient digit without waiting for the
+# vector unit.
+#
+# void rsaz_amm52x30_avx512(BN_ULONG res[32], const BN_ULONG a[32],
+#                           const BN_ULONG b[32], const BN_ULONG m[32],
+#                           BN_ULONG k0);
+# void rsaz_amm52x40_avx512(BN_ULONG res[40], const BN_ULONG a[40],
+#                           const BN_ULONG b[40], const BN_ULONG m[40],
+#                           BN_ULONG k0);
+#
+# compute res = a * b / 2^(52*n) mod m, up to a multiple of m, for n = 30
+# or 40 digits; |k0| is -1/m mod 2^52, the digits past n are zero and the
+# result is less than 2*m if a and b are and 4*m < 2^(52*n). |res| may be
+# the same as |a| or |b|.
+#
+# void rsaz_amm52x30_gather5_avx512(BN_ULONG res[32],
+#                                   const BN_ULONG tbl[32*32], int idx);
+# void rsaz_amm52x40_gather5_avx512(BN_ULONG res[40],
+#                                   const BN_ULONG tbl[32*40], int idx);
+#
+# copy entry |idx| of a table of 32 numbers to |res|, reading all of them.
+#
+# int rsaz_avx512ifma_eligible(void);
+#
+# returns non-zero if the processor has AVX-512F, AVX-512 IFMA and BMI2.
+# The module needs binutils 2.26 or clang 7 and is not built for Win64,
+# which would need an SEH handler; rsaz_avx512ifma_eligible returns zero
+# if it is not.
+
+$flavour = shift;
+$output  = shift;
+if ($flavour =~ /\./) { $output = $flavour; undef $flavour; }
+
+$win64=0; $win64=1 if ($flavour =~ /[nm]asm|mingw64/ || $output =~ /\.asm$/);
+
+$0 =~ m/(.*[\/\\])[^\/\\]+$/; $dir=$1;
+( $xlate="${dir}x86_64-xlate.pl" and -f $xlate ) or
+( $xlate="${dir}../../perlasm/x86_64-xlate.pl" and -f $xlate) or
+die "can't locate x86_64-xlate.pl";
+
+if (`$ENV{CC} -Wa,-v -c -o /dev/null -x assembler /dev/null 2>&1`
+		=~ /GNU assembler version ([2-9]\.[0-9]+)/) {
+	$ifma = ($1>=2.26);
+}
+
+if (!$ifma && `$ENV{CC} -v 2>&1` =~ /((?:clang|LLVM) version|.*based on LLVM) ([0-9]+\.[0-9]+)/) {
+	$ifma = ($2>=7.0);
+}
+
+$ifma = 0 if ($win64);
+
+open OUT,"| \"$^X\" \"$xlate\" $flavour \"$output\"";
+*STDOUT=*OUT;
+
+if ($ifma) {
+$code.=<<___;
+.text
+
+.extern	OPENSSL_ia32cap_P
+.globl	rsaz_avx512ifma_eligible
+.type	rsaz_avx512ifma_eligible,\@abi-omnipotent
+.align	32
+rsaz_avx512ifma_eligible:
+	mov	OPENSSL_ia32cap_P+8(%rip),%ecx
+	xor	%eax,%eax
+	and	\$`1<<8|1<<16|1<<21`,%ecx	# BMI2, AVX512F and AVX512IFMA
+	cmp	\$`1<<8|1<<16|1<<21`,%ecx
+	sete	%al
+	ret
+.size	rsaz_avx512ifma_eligible,.-rsaz_avx512ifma_eligible
+___
+
+sub amm52 {
+my $n=shift;				# digits
+my $R=($n+7)>>3;			# registers per number
+my ($res,$a,$b,$m,$k0)=("%rdi","%rsi","%rdx","%rcx","%r8");
+my ($acc,$hi,$bp,$cnt,$mask)=("%r9","%r10","%r11","%ebx","%r12");
+my @ACC=map("%zmm$_",(0..$R-1));
+my @A=map("%zmm$_",($R..2*$R-1));
+my @M=map("%zmm$_",(2*$R..3*$R-1));
+my @T=map("%zmm$_",(3*$R..4*$R-1));
+my ($Bi,$Yi,$MASK,$ZERO)=map("%zmm$_",(4*$R..4*$R+3));
+my ($gen,$prop)=($k0,$hi);
+my $gend="${gen}d";
+
+$code.=<<___;
+.globl	rsaz_amm52x${n}_avx512
+.type	rsaz_amm52x${n}_avx512,\@function,5
+.align	32
+rsaz_amm52x${n}_avx512:
+.cfi_startproc
+	push	%rbx
+.cfi_push	%rbx
+	push	%r12
+.cfi_push	%r12
+	mov	$b,$bp
+	mov	\$0xfffffffffffff,$mask
+	vpbroadcastq	$mask,$MASK
+	vpxord	$ZERO,$ZERO,$ZERO
+___
+for (my $i=0; $i<$R; $i++) {
+$code.=<<___;
+	vmovdqu64	`64*$i`($a),$A[$i]
+	vmovdqu64	`64*$i`($m),$M[$i]
+	vpxord		$ACC[$i],$ACC[$i],$ACC[$i]
+___
+}
+$code.=<<___;
+	xor	$acc,$acc
+	mov	\$$n,$cnt
+
+.align	32
+.Loop_amm52x$n:
+	mov	($bp),%rax			# b[i]
+	vpbroadcastq	%rax,$Bi
+	mov	($a),%rdx
+	mulx	%rax,%rax,$hi			# a[0]*b[i]
+	add	%rax,$acc
+	adc	\$0,$hi
+	mov	$k0,%rdx
+	imul	$acc,%rdx
+	and	$mask,%rdx			# y = acc*k0 mod 2^52
+	vpbroadcastq	%rdx,$Yi
+	mulx	($m),%rax,%rdx			# m[0]*y
+	add	%rax,$acc
+	adc	%rdx,$hi
+	shrd	\$52,$hi,$acc			# acc is divisible by 2^52
+
+___
+for (my $i=0; $i<$R; $i++) {
+$code.=<<___;
+	vpmadd52luq	$A[$i],$Bi,$ACC[$i]
+___
+}
+for (my $i=0; $i<$R; $i++) {
+$code.=<<___;
+	vpmadd52luq	$M[$i],$Yi,$ACC[$i]
+___
+}
+# shift the accumulator down a digit, lane 0 being in $acc
+for (my $i=0; $i<$R-1; $i++) {
+$code.=<<___;
+	valignq		\$1,$ACC[$i],$ACC[$i+1],$ACC[$i]
+___
+}
+$code.=<<___;
+	valignq		\$1,$ACC[$R-1],$ZERO,$ACC[$R-1]
+	vmovq		%xmm0,%rax
+	add		%rax,$acc
+___
+for (my $i=0; $i<$R; $i++) {
+$code.=<<___;
+	vpmadd52huq	$A[$i],$Bi,$ACC[$i]
+___
+}
+for (my $i=0; $i<$R; $i++) {
+$code.=<<___;
+	vpmadd52huq	$M[$i],$Yi,$ACC[$i]
+___
+}
+$code.=<<___;
+	lea	8($bp),$bp
+	dec	$cnt
+	jnz	.Loop_amm52x$n
+
+	mov	\$1,%eax
+	kmovw	%eax,%k1
+	vpbroadcastq	$acc,$ACC[0]\{%k1}
+
+	# normalize to 52-bit digits: carries of up to 12 bits first, ...
+___
+for (my $i=0; $i<$R; $i++) {
+$code.=<<___;
+	vpsrlq	\$52,$ACC[$i],$T[$i]
+	vpandq	$MASK,$ACC[$i],$ACC[$i]
+___
+}
+for (my $i=$R-1; $i>0; $i--) {
+$code.=<<___;
+	valignq	\$7,$T[$i-1],$T[$i],$T[$i]
+___
+}
+$code.=<<___;
+	valignq	\$7,$ZERO,$T[0],$T[0]
+___
+for (my $i=0; $i<$R; $i++) {
+$code.=<<___;
+	vpaddq	$T[$i],$ACC[$i],$ACC[$i]
+___
+}
+$code.=<<___;
+
+	# ... then single-bit ones, which may ripple through digits that
+	# are all ones: lanes that generate a carry are above the mask and
+	# ones that propagate it equal to it, and adding the two masks
+	# shifted as 64-bit integers yields the lanes to increment
+	xor	$gen,$gen
+	xor	$prop,$prop
+___
+for (my $i=$R-1; $i>=0; $i--) {
+$code.=<<___;
+	vpcmpuq	\$6,$MASK,$ACC[$i],%k1
+	vpcmpuq	\$0,$MASK,$ACC[$i],%k2
+	kmovw	%k1,%eax
+	kmovw	%k2,%edx
+	shl	\$8,$gen
+	shl	\$8,$prop
+	or	%rax,$gen
+	or	%rdx,$prop
+___
+}
+$code.=<<___;
+	add	$gen,$gen
+	add	$prop,$gen
+	xor	$prop,$gen
+___
+for (my $i=0; $i<$R; $i++) {
+$code.=<<___;
+	kmovw	$gend,%k1
+	shr	\$8,$gen
+	vpsubq	$MASK,$ACC[$i],$ACC[$i]\{%k1}	# adds 1 mod 2^52
+	vpandq	$MASK,$ACC[$i],$ACC[$i]
+	vmovdqu64	$ACC[$i],`64*$i`($res)
+___
+}
+$code.=<<___;
+
+	vzeroupper
+	pop	%r12
+.cfi_pop	%r12
+	pop	%rbx
+.cfi_pop	%rbx
+	ret
+.cfi_endproc
+.size	rsaz_amm52x${n}_avx512,.-rsaz_amm52x${n}_avx512
+___
+}
+
+sub gather5 {
+my $n=shift;
+my $R=($n+7)>>3;
+my ($res,$tbl,$idx)=("%rdi","%rsi","%edx");
+my @OUT=map("%zmm$_",(0..$R-1));
+my @T=map("%zmm$_",($R..2*$R-1));
+my ($IDX,$CUR,$ONE)=map("%zmm$_",(2*$R..2*$R+2));
+
+$code.=<<___;
+.globl	rsaz_amm52x${n}_gather5_avx512
+.type	rsaz_amm52x${n}_gather5_avx512,\@function,3
+.align	32
+rsaz_amm52x${n}_gather5_avx512:
+.cfi_startproc
+	mov	$idx,%edx
+	vpbroadcastq	%rdx,$IDX
+	mov	\$1,%eax
+	vpbroadcastq	%rax,$ONE
+	vpxord	$CUR,$CUR,$CUR
+___
+for (my $i=0; $i<$R; $i++) {
+$code.=<<___;
+	vpxord	$OUT[$i],$OUT[$i],$OUT[$i]
+___
+}
+$code.=<<___;
+	mov	\$32,%eax
+
+.align	32
+.Loop_gather52x$n:
+	vpcmpuq	\$0,$IDX,$CUR,%k1
+___
+for (my $i=0; $i<$R; $i++) {
+$code.=<<___;
+	vmovdqu64	`64*$i`($tbl),$T[$i]
+___
+}
+for (my $i=0; $i<$R; $i++) {
+$code.=<<___;
+	vmovdqa64	$T[$i],$OUT[$i]\{%k1}
+___
+}
+$code.=<<___;
+	vpaddq	$ONE,$CUR,$CUR
+	lea	`64*$R`($tbl),$tbl
+	dec	%eax
+	jnz	.Loop_gather52x$n
+
+___
+for (my $i=0; $i<$R; $i++) {
+$code.=<<___;
+	vmovdqu64	$OUT[$i],`64*$i`($res)
+___
+}
+$code.=<<___;
+	vzeroupper
+	ret
+.cfi_endproc
+.size	rsaz_amm52x${n}_gather5_avx512,.-rsaz_amm52x${n}_gather5_avx512
+___
+}
+
+amm52(30);
+amm52(40);
+gather5(30);
+gather5(40);
+} else {
+$code.=<<___;
+.text
+
+.globl	rsaz_avx512ifma_eligible
+.type	rsaz_avx512ifma_eligible,\@abi-omnipotent
+rsaz_avx512ifma_eligible:
+	xor	%eax,%eax
+	ret
+.size	rsaz_avx512ifma_eligible,.-rsaz_avx512ifma_eligible
+
+.globl	rsaz_amm52x30_avx512
+.globl	rsaz_amm52x40_avx512
+.globl	rsaz_amm52x30_gather5_avx512
+.globl	rsaz_amm52x40_gather5_avx512
+.type	rsaz_amm52x30_avx512,\@abi-omnipotent
+rsaz_amm52x30_avx512:
+rsaz_amm52x40_avx512:
+rsaz_amm52x30_gather5_avx512:
+rsaz_amm52x40_gather5_avx512:
+	.byte	0x0f,0x0b	# ud2
+	ret
+.size	rsaz_amm52x30_avx512,.-rsaz_amm52x30_avx512
+___
+}
+$code.=<<___;
+.asciz	"Almost Montgomery multiplication for x86_64 with AVX-512 IFMA"
+___
+
+$code =~ s/\`([^\`]*)\`/eval $1/gem;
+print $code;
+close STDOUT or die "error closing STDOUT: $!";
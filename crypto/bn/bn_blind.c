@@ -259,8 +259,13 @@ BN_BLINDING *BN_BLINDING_create_param(BN_BLINDING *b,
         int rv;
         if (!BN_priv_rand_range(ret->A, ret->mod))
             goto err;
-        if (int_bn_mod_inverse(ret->Ai, ret->A, ret->mod, ctx, &rv))
+        if (BN_is_odd(ret->mod)) {
+            /* A is secret whether or not the modulus is flagged */
+            if (bn_mod_inverse_consttime(ret->Ai, ret->A, ret->mod, ctx, &rv))
+                break;
+        } else if (int_bn_mod_inverse(ret->Ai, ret->A, ret->mod, ctx, &rv)) {
             break;
+        }
 
         /*
          * this should almost never happen for good RSA keys
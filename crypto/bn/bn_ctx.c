@@ -7,7 +7,10 @@
  * https://www.openssl.org/source/license.html
  */
 
+#include <openssl/async.h>
 #include "internal/cryptlib.h"
+#include "internal/thread_once.h"
+#include "crypto/cryptlib.h"
 #include "bn_local.h"
 
 /*-
@@ -236,6 +239,129 @@ BIGNUM *BN_CTX_get(BN_CTX *ctx)
     return ret;
 }
 
+/********************/
+/* Per-thread cache */
+/********************/
+
+/*
+ * One plain and one secure BN_CTX per thread, lent by bn_ctx_acquire() to
+ * callers that would otherwise create and free a context for a single
+ * operation. A cached context is lent to one caller at a time: nested
+ * callers, and callers inside an ASYNC job that might be paused while
+ * holding it, get a fresh context instead. Contexts that come back with
+ * unbalanced frames or an oversized pool are freed rather than kept.
+ */
+#define BN_CTX_CACHE_MAX_POOL   (8 * BN_CTX_POOL_SIZE)
+
+typedef struct {
+    BN_CTX *ctx[2];
+    int busy[2];
+} BN_CTX_CACHE;
+
+static CRYPTO_ONCE bn_ctx_cache_once = CRYPTO_ONCE_STATIC_INIT;
+static CRYPTO_THREAD_LOCAL bn_ctx_cache_key;
+static int bn_ctx_cache_inited = 0;
+
+DEFINE_RUN_ONCE_STATIC(do_bn_ctx_cache_init)
+{
+    if (!CRYPTO_THREAD_init_local(&bn_ctx_cache_key, NULL))
+        return 0;
+    bn_ctx_cache_inited = 1;
+    return 1;
+}
+
+/* Wipe the values left behind so that no secret outlives its operation */
+static void bn_ctx_cleanse(BN_CTX *ctx)
+{
+    BN_POOL_ITEM *item;
+    BIGNUM *bn;
+    unsigned int loop;
+
+    for (item = ctx->pool.head; item != NULL; item = item->next) {
+        for (loop = 0, bn = item->vals; loop++ < BN_CTX_POOL_SIZE; bn++) {
+            if (bn->d != NULL)
+                OPENSSL_cleanse(bn->d, bn->dmax * sizeof(bn->d[0]));
+            bn->top = 0;
+            bn->neg = 0;
+        }
+    }
+}
+
+BN_CTX *bn_ctx_acquire(int secure)
+{
+    BN_CTX_CACHE *cache;
+    int i = secure != 0;
+
+    if (ASYNC_get_current_job() == NULL
+            && RUN_ONCE(&bn_ctx_cache_once, do_bn_ctx_cache_init)
+            && bn_ctx_cache_inited) {
+        cache = CRYPTO_THREAD_get_local(&bn_ctx_cache_key);
+        if (cache == NULL && ossl_init_thread_start(OPENSSL_INIT_THREAD_BN_CTX)
+                && (cache = OPENSSL_zalloc(sizeof(*cache))) != NULL
+                && !CRYPTO_THREAD_set_local(&bn_ctx_cache_key, cache)) {
+            OPENSSL_free(cache);
+            cache = NULL;
+        }
+        if (cache != NULL && !cache->busy[i]) {
+            if (cache->ctx[i] == NULL)
+                cache->ctx[i] = secure ? BN_CTX_secure_new() : BN_CTX_new();
+            if (cache->ctx[i] != NULL) {
+                cache->busy[i] = 1;
+                return cache->ctx[i];
+            }
+        }
+    }
+    return secure ? BN_CTX_secure_new() : BN_CTX_new();
+}
+
+void bn_ctx_release(BN_CTX *ctx)
+{
+    BN_CTX_CACHE *cache = NULL;
+    int i;
+
+    if (ctx == NULL)
+        return;
+    if (bn_ctx_cache_inited)
+        cache = CRYPTO_THREAD_get_local(&bn_ctx_cache_key);
+    for (i = 0; cache != NULL && i < 2; i++) {
+        if (cache->ctx[i] != ctx)
+            continue;
+        cache->busy[i] = 0;
+        if (ctx->stack.depth == 0 && ctx->used == 0 && !ctx->too_many
+                && ctx->err_stack == 0
+                && ctx->pool.size <= BN_CTX_CACHE_MAX_POOL) {
+            bn_ctx_cleanse(ctx);
+            return;
+        }
+        cache->ctx[i] = NULL;
+        break;
+    }
+    BN_CTX_free(ctx);
+}
+
+void bn_ctx_delete_thread_state(void)
+{
+    BN_CTX_CACHE *cache;
+
+    if (!bn_ctx_cache_inited)
+        return;
+    cache = CRYPTO_THREAD_get_local(&bn_ctx_cache_key);
+    CRYPTO_THREAD_set_local(&bn_ctx_cache_key, NULL);
+    if (cache == NULL)
+        return;
+    BN_CTX_free(cache->ctx[0]);
+    BN_CTX_free(cache->ctx[1]);
+    OPENSSL_free(cache);
+}
+
+void bn_ctx_cleanup_int(void)
+{
+    if (bn_ctx_cache_inited) {
+        CRYPTO_THREAD_cleanup_local(&bn_ctx_cache_key);
+        bn_ctx_cache_inited = 0;
+    }
+}
+
 /************/
 /* BN_STACK */
 /************/
@@ -700,6 +700,17 @@ int BN_mod_exp_mont_consttime(BIGNUM *rr, const BIGNUM *a, const BIGNUM *p,
         bn_correct_top(rr);
         ret = 1;
         goto err;
+    } else if ((24 == top || 32 == top) && p->top <= top
+               && rsaz_avx512ifma_eligible()) {
+        /* the CRT halves of RSA-3072 and RSA-4096 */
+        if (NULL == bn_wexpand(rr, top)
+            || !RSAZ_mod_exp_avx512(rr->d, a, p, mont))
+            goto err;
+        rr->top = top;
+        rr->neg = 0;
+        bn_correct_top(rr);
+        ret = 1;
+        goto err;
     }
 #endif
 
@@ -1155,6 +1166,44 @@ int BN_mod_exp_mont_consttime(BIGNUM *rr, const BIGNUM *a, const BIGNUM *p,
     return ret;
 }
 
+/*
+ * Two independent constant-time exponentiations, such as the two CRT
+ * halves of an RSA private key operation. When both moduli are 1536 or both
+ * are 2048 bits and AVX-512 IFMA is available, they are run side by side by
+ * RSAZ_mod_exp_avx512_x2(); otherwise they are done one after the other.
+ */
+int bn_mod_exp_mont_consttime_x2(BIGNUM *rr1, const BIGNUM *a1,
+                                 const BIGNUM *p1, const BIGNUM *m1,
+                                 BN_MONT_CTX *in_mont1,
+                                 BIGNUM *rr2, const BIGNUM *a2,
+                                 const BIGNUM *p2, const BIGNUM *m2,
+                                 BN_MONT_CTX *in_mont2, BN_CTX *ctx)
+{
+#ifdef RSAZ_ENABLED
+    int top = m1->top;
+
+    if ((24 == top || 32 == top) && m2->top == top
+        && in_mont1 != NULL && in_mont2 != NULL
+        && BN_is_odd(m1) && BN_is_odd(m2)
+        && p1->top > 0 && p1->top <= top && p2->top > 0 && p2->top <= top
+        && !a1->neg && BN_ucmp(a1, m1) < 0
+        && !a2->neg && BN_ucmp(a2, m2) < 0
+        && rsaz_avx512ifma_eligible()) {
+        if (NULL == bn_wexpand(rr1, top) || NULL == bn_wexpand(rr2, top)
+            || !RSAZ_mod_exp_avx512_x2(rr1->d, a1, p1, in_mont1,
+                                       rr2->d, a2, p2, in_mont2))
+            return 0;
+        rr1->top = rr2->top = top;
+        rr1->neg = rr2->neg = 0;
+        bn_correct_top(rr1);
+        bn_correct_top(rr2);
+        return 1;
+    }
+#endif
+    return BN_mod_exp_mont_consttime(rr1, a1, p1, m1, ctx, in_mont1)
+           && BN_mod_exp_mont_consttime(rr2, a2, p2, m2, ctx, in_mont2);
+}
+
 int BN_mod_exp_mont_word(BIGNUM *rr, BN_ULONG a, const BIGNUM *p,
                          const BIGNUM *m, BN_CTX *ctx, BN_MONT_CTX *in_mont)
 {
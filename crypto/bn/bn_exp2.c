@@ -199,3 +199,151 @@ int BN_mod_exp2_mont(BIGNUM *rr, const BIGNUM *a1, const BIGNUM *p1,
     bn_check_top(rr);
     return ret;
 }
+
+/*-
+ * Fixed-base exponentiation for bases that are reused across many
+ * exponentiations, such as the generator and public key of a long-lived
+ * DSA key (Brickell, Gordon, McCurley and Wilson). The table holds
+ *
+ *      pow[i] = base^(2^(FB_WINDOW * i))  (in Montgomery form)
+ *
+ * for every window of the exponent, so that an exponentiation costs one
+ * multiplication per window plus 2^FB_WINDOW - 2, with no squarings. The
+ * table lookups depend on the exponent, so this is only for public
+ * exponents such as the ones of a signature verification.
+ */
+#define FB_WINDOW       5
+
+struct bn_fixed_base_st {
+    int nwin;
+    BIGNUM **pow;
+};
+
+BN_FIXED_BASE *bn_fixed_base_new(const BIGNUM *base, int exp_bits,
+                                 BN_MONT_CTX *mont, BN_CTX *ctx)
+{
+    BN_FIXED_BASE *fb;
+    int i, j;
+
+    if (exp_bits <= 0 || BN_is_negative(base))
+        return NULL;
+    if ((fb = OPENSSL_zalloc(sizeof(*fb))) == NULL)
+        return NULL;
+    fb->nwin = (exp_bits + FB_WINDOW - 1) / FB_WINDOW;
+    if ((fb->pow = OPENSSL_zalloc(sizeof(*fb->pow) * fb->nwin)) == NULL)
+        goto err;
+    for (i = 0; i < fb->nwin; i++) {
+        if ((fb->pow[i] = BN_new()) == NULL)
+            goto err;
+        if (i == 0) {
+            if (!BN_nnmod(fb->pow[0], base, &mont->N, ctx)
+                    || !BN_to_montgomery(fb->pow[0], fb->pow[0], mont, ctx))
+                goto err;
+            continue;
+        }
+        if (!BN_mod_mul_montgomery(fb->pow[i], fb->pow[i - 1], fb->pow[i - 1],
+                                   mont, ctx))
+            goto err;
+        for (j = 1; j < FB_WINDOW; j++)
+            if (!BN_mod_mul_montgomery(fb->pow[i], fb->pow[i], fb->pow[i],
+                                       mont, ctx))
+                goto err;
+    }
+    return fb;
+ err:
+    bn_fixed_base_free(fb);
+    return NULL;
+}
+
+void bn_fixed_base_free(BN_FIXED_BASE *fb)
+{
+    int i;
+
+    if (fb == NULL)
+        return;
+    if (fb->pow != NULL) {
+        for (i = 0; i < fb->nwin; i++)
+            BN_free(fb->pow[i]);
+        OPENSSL_free(fb->pow);
+    }
+    OPENSSL_free(fb);
+}
+
+static int fb_window(const BIGNUM *p, int i)
+{
+    int j, w = 0;
+
+    for (j = FB_WINDOW - 1; j >= 0; j--)
+        w = (w << 1) | BN_is_bit_set(p, FB_WINDOW * i + j);
+    return w;
+}
+
+/*
+ * rr = base1^p1 * base2^p2 mod m, with both bases taken from tables built
+ * for the Montgomery context |mont| of m. The exponents must be
+ * non-negative and no longer than the tables were built for.
+ */
+int bn_mod_exp2_fixed_base(BIGNUM *rr, const BN_FIXED_BASE *fb1,
+                           const BIGNUM *p1, const BN_FIXED_BASE *fb2,
+                           const BIGNUM *p2, BN_MONT_CTX *mont, BN_CTX *ctx)
+{
+    const BN_FIXED_BASE *fb[2];
+    const BIGNUM *p[2];
+    BIGNUM *a, *b;
+    int a_is_one = 1, b_is_one = 1;
+    int d, i, k, ret = 0;
+
+    fb[0] = fb1;
+    fb[1] = fb2;
+    p[0] = p1;
+    p[1] = p2;
+    for (k = 0; k < 2; k++)
+        if (BN_is_negative(p[k])
+                || BN_num_bits(p[k]) > fb[k]->nwin * FB_WINDOW)
+            return 0;
+
+    BN_CTX_start(ctx);
+    a = BN_CTX_get(ctx);
+    b = BN_CTX_get(ctx);
+    if (b == NULL)
+        goto err;
+
+    /*
+     * b accumulates the powers whose window is at least d, and a the
+     * product of b over all d, so that each power ends up raised to its
+     * own window value.
+     */
+    for (d = (1 << FB_WINDOW) - 1; d > 0; d--) {
+        for (k = 0; k < 2; k++) {
+            for (i = 0; i < fb[k]->nwin; i++) {
+                if (fb_window(p[k], i) != d)
+                    continue;
+                if (b_is_one) {
+                    if (!BN_copy(b, fb[k]->pow[i]))
+                        goto err;
+                    b_is_one = 0;
+                } else if (!BN_mod_mul_montgomery(b, b, fb[k]->pow[i],
+                                                  mont, ctx)) {
+                    goto err;
+                }
+            }
+        }
+        if (b_is_one)
+            continue;
+        if (a_is_one) {
+            if (!BN_copy(a, b))
+                goto err;
+            a_is_one = 0;
+        } else if (!BN_mod_mul_montgomery(a, a, b, mont, ctx)) {
+            goto err;
+        }
+    }
+
+    if (a_is_one)
+        ret = BN_one(rr);
+    else
+        ret = BN_from_montgomery(rr, a, mont, ctx);
+ err:
+    BN_CTX_end(ctx);
+    return ret;
+}
@@ -212,6 +212,17 @@ BIGNUM *int_bn_mod_inverse(BIGNUM *in,
 
     if ((BN_get_flags(a, BN_FLG_CONSTTIME) != 0)
         || (BN_get_flags(n, BN_FLG_CONSTTIME) != 0)) {
+        if (BN_is_odd(n)) {
+            R = in != NULL ? in : BN_new();
+            if (R == NULL)
+                return NULL;
+            if (!bn_mod_inverse_consttime(R, a, n, ctx, pnoinv)) {
+                if (in == NULL)
+                    BN_free(R);
+                return NULL;
+            }
+            return R;
+        }
         return bn_mod_inverse_no_branch(in, a, n, ctx, pnoinv);
     }
 
@@ -9,7 +9,10 @@
 
 #include <stdio.h>
 #include <time.h>
+#include <openssl/async.h>
 #include "internal/cryptlib.h"
+#include "internal/tsan_assist.h"
+#include "crypto/bn.h"
 #include "bn_local.h"
 
 /*
@@ -142,6 +145,203 @@ int BN_generate_prime_ex(BIGNUM *ret, int bits, int safe,
     return found;
 }
 
+/*
+ * Number of candidates bn_generate_prime_pool() tests at a time. It is fixed
+ * rather than taken from the number of threads so that the prime found only
+ * depends on the random numbers drawn.
+ */
+#define BN_PRIME_BATCH  16
+
+/* Outcome of a candidate that was not tested as an earlier one is prime */
+#define BN_PRIME_SKIPPED 2
+
+typedef struct {
+    BIGNUM *cand[BN_PRIME_BATCH];
+    /* |checks| Miller-Rabin bases of each candidate, drawn by the caller */
+    BIGNUM **bases;
+    int checks;
+    /* 1 prime, 0 composite, -1 error, or BN_PRIME_SKIPPED */
+    TSAN_QUALIFIER int result[BN_PRIME_BATCH];
+} BN_PRIME_BATCH_TESTS;
+
+typedef struct {
+    BN_PRIME_BATCH_TESTS *batch;
+    int idx;
+} BN_PRIME_TEST_JOB;
+
+static int bn_prime_batch_earlier_prime(BN_PRIME_BATCH_TESTS *batch, int idx)
+{
+    int i;
+
+    for (i = 0; i < idx; i++)
+        if (tsan_load(&batch->result[i]) == 1)
+            return 1;
+    return 0;
+}
+
+/*
+ * Runs the Miller-Rabin rounds of one candidate of a batch, on a thread of
+ * the pool. It draws no random numbers, and gives up as soon as an earlier
+ * candidate of the batch turns out to be prime.
+ */
+static void bn_prime_test_job(void *arg)
+{
+    BN_PRIME_TEST_JOB *job = arg;
+    BN_PRIME_BATCH_TESTS *batch = job->batch;
+    const BIGNUM *a = batch->cand[job->idx];
+    BIGNUM **bases = batch->bases + job->idx * batch->checks;
+    BIGNUM *A1, *A1_odd, *w;
+    BN_CTX *ctx = NULL;
+    BN_MONT_CTX *mont = NULL;
+    int i, j, k, ret = -1;
+
+    if (bn_prime_batch_earlier_prime(batch, job->idx)) {
+        ret = BN_PRIME_SKIPPED;
+        goto err;
+    }
+
+    if ((ctx = BN_CTX_new()) == NULL)
+        goto err;
+    BN_CTX_start(ctx);
+    A1 = BN_CTX_get(ctx);
+    A1_odd = BN_CTX_get(ctx);
+    w = BN_CTX_get(ctx);
+    if (w == NULL)
+        goto err;
+
+    /* write a - 1 as A1_odd * 2^k */
+    if (!BN_copy(A1, a) || !BN_sub_word(A1, 1))
+        goto err;
+    k = 1;
+    while (!BN_is_bit_set(A1, k))
+        k++;
+    if (!BN_rshift(A1_odd, A1, k))
+        goto err;
+
+    if ((mont = BN_MONT_CTX_new()) == NULL || !BN_MONT_CTX_set(mont, a, ctx))
+        goto err;
+
+    for (i = 0; i < batch->checks; i++) {
+        if (i > 0 && bn_prime_batch_earlier_prime(batch, job->idx)) {
+            ret = BN_PRIME_SKIPPED;
+            goto err;
+        }
+        if (BN_copy(w, bases[i]) == NULL)
+            goto err;
+        j = witness(w, a, A1, A1_odd, k, ctx, mont);
+        if (j == -1)
+            goto err;
+        if (j) {
+            ret = 0;
+            goto err;
+        }
+    }
+    ret = 1;
+ err:
+    BN_MONT_CTX_free(mont);
+    BN_CTX_end(ctx);
+    BN_CTX_free(ctx);
+    tsan_store(&batch->result[job->idx], ret);
+}
+
+/*
+ * Generates a random prime of |bits| bits like BN_generate_prime_ex() does
+ * with no |add| and not |safe|, running the Miller-Rabin tests of
+ * BN_PRIME_BATCH sieved candidates at a time on |pool|. The candidates and
+ * their Miller-Rabin bases are all drawn on the calling thread and the first
+ * candidate of a batch that passes is taken, so the prime found only depends
+ * on the random numbers drawn, whatever the number of threads of |pool|.
+ * |cb| is only called on the calling thread.
+ */
+int bn_generate_prime_pool(BIGNUM *ret, int bits, OSSL_WORKER_POOL *pool,
+                           BN_GENCB *cb)
+{
+    BN_PRIME_BATCH_TESTS batch;
+    BN_PRIME_TEST_JOB jobs[BN_PRIME_BATCH];
+    void *job_ptrs[BN_PRIME_BATCH];
+    BIGNUM *A3;
+    BN_CTX *ctx = NULL;
+    prime_t *mods = NULL;
+    int i, j, c1 = 0, found = 0;
+    int checks = BN_prime_checks_for_size(bits);
+
+    /* not worth a batch, and small candidates need more care */
+    if (bits < 32)
+        return BN_generate_prime_ex(ret, bits, 0, NULL, NULL, cb);
+
+    memset(&batch, 0, sizeof(batch));
+    batch.checks = checks;
+    batch.bases = OPENSSL_zalloc(sizeof(*batch.bases) * BN_PRIME_BATCH
+                                 * checks);
+    mods = OPENSSL_zalloc(sizeof(*mods) * NUMPRIMES);
+    if (batch.bases == NULL || mods == NULL)
+        goto err;
+
+    ctx = BN_CTX_new();
+    if (ctx == NULL)
+        goto err;
+    BN_CTX_start(ctx);
+    if ((A3 = BN_CTX_get(ctx)) == NULL)
+        goto err;
+    for (i = 0; i < BN_PRIME_BATCH; i++) {
+        if ((batch.cand[i] = BN_CTX_get(ctx)) == NULL)
+            goto err;
+        for (j = 0; j < checks; j++)
+            if ((batch.bases[i * checks + j] = BN_CTX_get(ctx)) == NULL)
+                goto err;
+        jobs[i].batch = &batch;
+        jobs[i].idx = i;
+        job_ptrs[i] = &jobs[i];
+    }
+
+    while (!found) {
+        for (i = 0; i < BN_PRIME_BATCH; i++) {
+            if (!probable_prime(batch.cand[i], bits, 0, mods))
+                goto err;
+            if (!BN_GENCB_call(cb, 0, c1++))
+                goto err;
+            /* 1 < base < candidate - 1 */
+            if (!BN_copy(A3, batch.cand[i]) || !BN_sub_word(A3, 3))
+                goto err;
+            for (j = 0; j < checks; j++) {
+                BIGNUM *base = batch.bases[i * checks + j];
+
+                if (!BN_priv_rand_range(base, A3) || !BN_add_word(base, 2))
+                    goto err;
+            }
+            tsan_store(&batch.result[i], -1);
+        }
+
+        OSSL_WORKER_POOL_run_all(pool, bn_prime_test_job, job_ptrs,
+                                 BN_PRIME_BATCH);
+
+        for (i = 0; i < BN_PRIME_BATCH; i++) {
+            int r = tsan_load(&batch.result[i]);
+
+            if (r == -1)
+                goto err;
+            if (r == 1) {
+                if (BN_copy(ret, batch.cand[i]) == NULL)
+                    goto err;
+                found = 1;
+                break;
+            }
+        }
+    }
+    for (j = 0; j < checks; j++)
+        if (!BN_GENCB_call(cb, 1, j)) {
+            found = 0;
+            goto err;
+        }
+ err:
+    OPENSSL_free(batch.bases);
+    OPENSSL_free(mods);
+    BN_CTX_end(ctx);
+    BN_CTX_free(ctx);
+    bn_check_top(ret);
+    return found;
+}
+
 int BN_is_prime_ex(const BIGNUM *a, int checks, BN_CTX *ctx_passed,
                    BN_GENCB *cb)
 {
@@ -0,0 +1,341 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*-
+ * Constant-time modular inversion for odd moduli, after the "safegcd"
+ * divstep algorithm of Bernstein and Yang:
+ * https://eprint.iacr.org/2019/266
+ *
+ * Divsteps are applied SG_BITS at a time to the low limbs of f and g only,
+ * collecting a 2x2 transition matrix that is then applied to the full f
+ * and g and to the cofactors d and e, which are kept reduced modulo n.
+ * Numbers are held as signed radix-2^SG_BITS limbs: every limb but the
+ * top one is in [0, 2^SG_BITS), the top limb carries the sign.
+ *
+ * The number of divsteps, and therefore all of the work, depends only on
+ * the bit length of the modulus.
+ */
+
+#include <string.h>
+#include "internal/cryptlib.h"
+#include "internal/numbers.h"
+#include "bn_local.h"
+
+#if BN_BITS2 == 64 && defined(__SIZEOF_INT128__) && __SIZEOF_INT128__ == 16
+typedef int64_t sg_limb;
+typedef uint64_t sg_ulimb;
+/* nonstandard; implemented by gcc on 64-bit platforms */
+typedef __int128 sg_dlimb;
+# define SG_BITS        62
+#else
+typedef int32_t sg_limb;
+typedef uint32_t sg_ulimb;
+typedef int64_t sg_dlimb;
+# define SG_BITS        30
+#endif
+#define SG_LIMB_BITS    ((int)sizeof(sg_limb) * 8)
+#define SG_MASK         ((sg_ulimb)-1 >> (SG_LIMB_BITS - SG_BITS))
+
+/*
+ * Transition matrix of SG_BITS divsteps, scaled by 2^SG_BITS so that the
+ * entries are integers: 2^SG_BITS * (f', g') = (u*f + v*g, q*f + r*g).
+ * |u| + |v| and |q| + |r| are at most 2^SG_BITS.
+ */
+typedef struct {
+    sg_limb u, v, q, r;
+} SG_TRANS;
+
+/*
+ * Run SG_BITS divsteps on the low bits of f (odd) and g and return the
+ * updated delta.  Each divstep is
+ *
+ *   delta > 0 and g odd:  (delta, f, g) := (1 - delta, g, (g - f) / 2)
+ *   otherwise:            (delta, f, g) := (1 + delta, f, (g + (g & 1) * f) / 2)
+ *
+ * The arithmetic is done on unsigned words and the conditions are turned
+ * into masks.  Only the low SG_BITS - i bits of f and g are meaningful
+ * after i steps, which is all that the next step looks at.
+ */
+static sg_ulimb sg_divsteps(sg_ulimb delta, sg_ulimb f, sg_ulimb g,
+                            SG_TRANS *t)
+{
+    sg_ulimb u = 1, v = 0, q = 0, r = 1, c, x;
+    int i;
+
+    for (i = 0; i < SG_BITS; i++) {
+        /* all ones if delta > 0 and g is odd */
+        c = (0 - ((0 - delta) >> (SG_LIMB_BITS - 1))) & (0 - (g & 1));
+
+        /* (delta, f, g) := (-delta, g, -f), along with the matrix rows */
+        delta = (delta ^ c) - c;
+        x = (f ^ g) & c;
+        f ^= x;
+        g ^= x;
+        g = (g ^ c) - c;
+        x = (u ^ q) & c;
+        u ^= x;
+        q ^= x;
+        q = (q ^ c) - c;
+        x = (v ^ r) & c;
+        v ^= x;
+        r ^= x;
+        r = (r ^ c) - c;
+
+        /* g := (g + (g & 1) * f) / 2, doubling the f row instead */
+        c = 0 - (g & 1);
+        g += f & c;
+        q += u & c;
+        r += v & c;
+        g >>= 1;
+        u <<= 1;
+        v <<= 1;
+        delta++;
+    }
+
+    t->u = (sg_limb)u;
+    t->v = (sg_limb)v;
+    t->q = (sg_limb)q;
+    t->r = (sg_limb)r;
+    return delta;
+}
+
+/* (f, g) := t * (f, g) / 2^SG_BITS, which is exact */
+static void sg_update_fg(sg_limb *f, sg_limb *g, const SG_TRANS *t,
+                         size_t len)
+{
+    const sg_limb u = t->u, v = t->v, q = t->q, r = t->r;
+    sg_dlimb cf, cg;
+    size_t i;
+
+    cf = (sg_dlimb)u * f[0] + (sg_dlimb)v * g[0];
+    cg = (sg_dlimb)q * f[0] + (sg_dlimb)r * g[0];
+    cf >>= SG_BITS;
+    cg >>= SG_BITS;
+    for (i = 1; i < len; i++) {
+        cf += (sg_dlimb)u * f[i] + (sg_dlimb)v * g[i];
+        cg += (sg_dlimb)q * f[i] + (sg_dlimb)r * g[i];
+        f[i - 1] = (sg_limb)((sg_ulimb)cf & SG_MASK);
+        g[i - 1] = (sg_limb)((sg_ulimb)cg & SG_MASK);
+        cf >>= SG_BITS;
+        cg >>= SG_BITS;
+    }
+    f[len - 1] = (sg_limb)cf;
+    g[len - 1] = (sg_limb)cg;
+}
+
+/*
+ * (d, e) := t * (d, e) / 2^SG_BITS mod n.  Multiples of n are added so
+ * that the division is exact and so that d and e stay in (-2n, n), where
+ * they start.  |ninv| is n^-1 mod 2^SG_BITS.
+ */
+static void sg_update_de(sg_limb *d, sg_limb *e, const SG_TRANS *t,
+                         const sg_limb *n, sg_ulimb ninv, size_t len)
+{
+    const sg_limb u = t->u, v = t->v, q = t->q, r = t->r;
+    sg_limb sd, se, md, me;
+    sg_dlimb cd, ce;
+    size_t i;
+
+    /* add u*n or v*n for a negative d or e ... */
+    sd = d[len - 1] >> (SG_LIMB_BITS - 1);
+    se = e[len - 1] >> (SG_LIMB_BITS - 1);
+    md = (u & sd) + (v & se);
+    me = (q & sd) + (r & se);
+
+    cd = (sg_dlimb)u * d[0] + (sg_dlimb)v * e[0];
+    ce = (sg_dlimb)q * d[0] + (sg_dlimb)r * e[0];
+
+    /* ... less what it takes to clear the bottom SG_BITS bits */
+    md -= (sg_limb)((ninv * (sg_ulimb)cd + (sg_ulimb)md) & SG_MASK);
+    me -= (sg_limb)((ninv * (sg_ulimb)ce + (sg_ulimb)me) & SG_MASK);
+    cd += (sg_dlimb)n[0] * md;
+    ce += (sg_dlimb)n[0] * me;
+    cd >>= SG_BITS;
+    ce >>= SG_BITS;
+
+    for (i = 1; i < len; i++) {
+        cd += (sg_dlimb)u * d[i] + (sg_dlimb)v * e[i] + (sg_dlimb)n[i] * md;
+        ce += (sg_dlimb)q * d[i] + (sg_dlimb)r * e[i] + (sg_dlimb)n[i] * me;
+        d[i - 1] = (sg_limb)((sg_ulimb)cd & SG_MASK);
+        e[i - 1] = (sg_limb)((sg_ulimb)ce & SG_MASK);
+        cd >>= SG_BITS;
+        ce >>= SG_BITS;
+    }
+    d[len - 1] = (sg_limb)cd;
+    e[len - 1] = (sg_limb)ce;
+}
+
+static void sg_carry(sg_limb *x, size_t len)
+{
+    size_t i;
+
+    for (i = 0; i < len - 1; i++) {
+        x[i + 1] += x[i] >> SG_BITS;
+        x[i] = (sg_limb)((sg_ulimb)x[i] & SG_MASK);
+    }
+}
+
+/* Bring d from (-2n, n) to [0, n), negating it if |sign| is negative */
+static void sg_normalize(sg_limb *d, sg_limb sign, const sg_limb *n,
+                         size_t len)
+{
+    sg_limb c;
+    size_t i;
+
+    c = d[len - 1] >> (SG_LIMB_BITS - 1);
+    for (i = 0; i < len; i++)
+        d[i] += n[i] & c;
+    c = sign >> (SG_LIMB_BITS - 1);
+    for (i = 0; i < len; i++)
+        d[i] = (d[i] ^ c) - c;
+    sg_carry(d, len);
+
+    c = d[len - 1] >> (SG_LIMB_BITS - 1);
+    for (i = 0; i < len; i++)
+        d[i] += n[i] & c;
+    sg_carry(d, len);
+}
+
+static void sg_from_bytes(sg_limb *x, size_t len,
+                          const unsigned char *buf, size_t nbytes)
+{
+    size_t i, bit, off;
+
+    memset(x, 0, len * sizeof(*x));
+    for (i = 0; i < nbytes; i++) {
+        bit = 8 * i;
+        off = bit % SG_BITS;
+        x[bit / SG_BITS] |= (sg_limb)(((sg_ulimb)buf[i] << off) & SG_MASK);
+        if (off > SG_BITS - 8)
+            x[bit / SG_BITS + 1] |= (sg_limb)(buf[i] >> (SG_BITS - off));
+    }
+}
+
+static void sg_to_bytes(unsigned char *buf, size_t nbytes,
+                        const sg_limb *x)
+{
+    size_t i, bit, off;
+    sg_ulimb b;
+
+    for (i = 0; i < nbytes; i++) {
+        bit = 8 * i;
+        off = bit % SG_BITS;
+        b = (sg_ulimb)x[bit / SG_BITS] >> off;
+        if (off > SG_BITS - 8)
+            b |= (sg_ulimb)x[bit / SG_BITS + 1] << (SG_BITS - off);
+        buf[i] = (unsigned char)b;
+    }
+}
+
+/*
+ * Sets |r| to a^-1 mod n for an odd modulus n > 1.  Returns 1 on success
+ * and 0 on error; if a is not invertible, *pnoinv is set and it is up to
+ * the caller to raise an error.  Only the bit length of n and whether or
+ * not a is in [0, n) can be learnt from the running time.
+ */
+int bn_mod_inverse_consttime(BIGNUM *r, const BIGNUM *a, const BIGNUM *n,
+                             BN_CTX *ctx, int *pnoinv)
+{
+    sg_limb *f, *g, *d, *e, *m, *limbs = NULL;
+    sg_ulimb delta, ninv, fsign, acc;
+    unsigned char *buf;
+    size_t nbytes, len, i, steps;
+    SG_TRANS t;
+    BIGNUM *x;
+    int bits, ret = 0;
+
+    *pnoinv = 0;
+    bits = BN_num_bits(n);
+    if (!BN_is_odd(n) || bits < 2) {
+        *pnoinv = 1;
+        return 0;
+    }
+
+    /*
+     * Leave room for the sign and for values of up to 2n.  At least two
+     * limbs, so that the top limb of +/-1 can be told from the others.
+     */
+    nbytes = BN_num_bytes(n);
+    len = (8 * nbytes + 2 + SG_BITS - 1) / SG_BITS;
+    if (len < 2)
+        len = 2;
+
+    BN_CTX_start(ctx);
+    if (a->neg || BN_ucmp(a, n) >= 0) {
+        if ((x = BN_CTX_get(ctx)) == NULL)
+            goto err;
+        BN_set_flags(x, BN_FLG_CONSTTIME);
+        if (!BN_nnmod(x, a, n, ctx))
+            goto err;
+        a = x;
+    }
+
+    limbs = OPENSSL_malloc(5 * len * sizeof(*limbs) + nbytes);
+    if (limbs == NULL) {
+        BNerr(BN_F_BN_MOD_INVERSE, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+    f = limbs;
+    g = f + len;
+    d = g + len;
+    e = d + len;
+    m = e + len;
+    buf = (unsigned char *)(m + len);
+
+    if (BN_bn2lebinpad(n, buf, (int)nbytes) < 0)
+        goto err;
+    sg_from_bytes(m, len, buf, nbytes);
+    if (BN_bn2lebinpad(a, buf, (int)nbytes) < 0)
+        goto err;
+    sg_from_bytes(g, len, buf, nbytes);
+    memcpy(f, m, len * sizeof(*f));
+    memset(d, 0, len * sizeof(*d));
+    memset(e, 0, len * sizeof(*e));
+    e[0] = 1;
+
+    /* Newton iteration, each step doubles the correct low bits from 3 */
+    ninv = (sg_ulimb)m[0];
+    for (i = 0; i < 5; i++)
+        ninv *= 2 - (sg_ulimb)m[0] * ninv;
+
+    /*
+     * Bernstein and Yang, theorem 11.2: with 0 <= g < f < 2^bits, g is
+     * zero after this many divsteps starting from delta = 1, and f is
+     * then +/-gcd(f, g).  Further divsteps leave f and g alone.
+     */
+    steps = (49 * (size_t)bits + (bits < 46 ? 80 : 57)) / 17 + 1;
+    delta = 1;
+    for (i = 0; i < steps; i += SG_BITS) {
+        delta = sg_divsteps(delta, (sg_ulimb)f[0], (sg_ulimb)g[0], &t);
+        sg_update_de(d, e, &t, m, ninv, len);
+        sg_update_fg(f, g, &t, len);
+    }
+
+    /* invertible if f is 1 or -1, that is all ones in the low limbs */
+    fsign = (sg_ulimb)(f[len - 1] >> (SG_LIMB_BITS - 1));
+    acc = ((sg_ulimb)f[0] ^ (fsign & SG_MASK)) ^ (~fsign & 1);
+    for (i = 1; i < len - 1; i++)
+        acc |= (sg_ulimb)f[i] ^ (fsign & SG_MASK);
+    acc |= (sg_ulimb)f[len - 1] ^ fsign;
+    if (acc != 0) {
+        *pnoinv = 1;
+        goto err;
+    }
+
+    sg_normalize(d, f[len - 1], m, len);
+    sg_to_bytes(buf, nbytes, d);
+    if (BN_lebin2bn(buf, (int)nbytes, r) == NULL)
+        goto err;
+    ret = 1;
+
+ err:
+    OPENSSL_clear_free(limbs, 5 * len * sizeof(*limbs) + nbytes);
+    BN_CTX_end(ctx);
+    return ret;
+}
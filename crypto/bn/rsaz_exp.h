@@ -37,6 +37,14 @@ void RSAZ_512_mod_exp(BN_ULONG result[8],
                       const BN_ULONG m_norm[8], BN_ULONG k0,
                       const BN_ULONG RR[8]);
 
+int RSAZ_mod_exp_avx512(BN_ULONG *rr, const BIGNUM *base, const BIGNUM *exp,
+                        const BN_MONT_CTX *mont);
+int RSAZ_mod_exp_avx512_x2(BN_ULONG *rr1, const BIGNUM *base1,
+                           const BIGNUM *exp1, const BN_MONT_CTX *mont1,
+                           BN_ULONG *rr2, const BIGNUM *base2,
+                           const BIGNUM *exp2, const BN_MONT_CTX *mont2);
+int rsaz_avx512ifma_eligible(void);
+
 static ossl_inline void bn_select_words(BN_ULONG *r, BN_ULONG mask,
                                         const BN_ULONG *a,
                                         const BN_ULONG *b, size_t num)
@@ -0,0 +1,261 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <string.h>
+#include <openssl/opensslconf.h>
+#include <openssl/crypto.h>
+#include "internal/nelem.h"
+#include "crypto/bn.h"
+#include "rsaz_exp.h"
+
+#ifndef RSAZ_ENABLED
+NON_EMPTY_TRANSLATION_UNIT
+#else
+
+/*
+ * See crypto/bn/asm/rsaz-avx512.pl for further details.
+ */
+void rsaz_amm52x30_avx512(BN_ULONG *res, const BN_ULONG *a,
+                          const BN_ULONG *b, const BN_ULONG *m, BN_ULONG k0);
+void rsaz_amm52x40_avx512(BN_ULONG *res, const BN_ULONG *a,
+                          const BN_ULONG *b, const BN_ULONG *m, BN_ULONG k0);
+void rsaz_amm52x30_gather5_avx512(BN_ULONG *res, const BN_ULONG *tbl,
+                                  int idx);
+void rsaz_amm52x40_gather5_avx512(BN_ULONG *res, const BN_ULONG *tbl,
+                                  int idx);
+
+# define DIGIT_BITS     52
+# define DIGIT_MASK     (((BN_ULONG)1 << DIGIT_BITS) - 1)
+# define WINDOW         5
+
+/* Radix 2^64 to 2^52; |in| has a zero word past the last one read. */
+static void to_words52(BN_ULONG *out, int digits, const BN_ULONG *in)
+{
+    int i, w, s;
+
+    for (i = 0; i < digits; i++) {
+        w = i * DIGIT_BITS / BN_BITS2;
+        s = i * DIGIT_BITS % BN_BITS2;
+        out[i] = in[w] >> s;
+        if (s > BN_BITS2 - DIGIT_BITS)
+            out[i] |= in[w + 1] << (BN_BITS2 - s);
+        out[i] &= DIGIT_MASK;
+    }
+}
+
+/* Radix 2^52 to 2^64; |in| has a zero digit past the last one read. */
+static void from_words52(BN_ULONG *out, int num, const BN_ULONG *in)
+{
+    int i, w, s;
+
+    for (i = 0; i < num; i++) {
+        w = i * BN_BITS2 / DIGIT_BITS;
+        s = i * BN_BITS2 % DIGIT_BITS;
+        out[i] = in[w] >> s | in[w + 1] << (DIGIT_BITS - s);
+        if (s > 2 * DIGIT_BITS - BN_BITS2)
+            out[i] |= in[w + 2] << (2 * DIGIT_BITS - s);
+    }
+}
+
+/* The exponent's bits |bit| to |bit| + 4, the position being public. */
+static int get_window(const BN_ULONG *e, int bit)
+{
+    int w = bit / BN_BITS2, s = bit % BN_BITS2;
+    BN_ULONG v = e[w] >> s;
+
+    if (s > BN_BITS2 - WINDOW)
+        v |= e[w + 1] << (BN_BITS2 - s);
+    return (int)(v & ((1 << WINDOW) - 1));
+}
+
+/* The state of one of the exponentiations run side by side */
+typedef struct {
+    const BN_MONT_CTX *mont;
+    BN_ULONG k0;
+    BN_ULONG *table, *base52, *m52, *rr52, *acc, *tmp, *w64, *e64;
+} RSAZ_AVX512_LANE;
+
+/*
+ * rr[l] = base[l]^exp[l] mod m[l] for |lanes| independent exponentiations
+ * with 1536- or 2048-bit moduli of the same size, |num| being 24 or 32
+ * words, in time independent of the bases and exponents. Each step is done
+ * for every lane before the next one, so that the out-of-order core overlaps
+ * the multiplications of one lane with those of another, which don't depend
+ * on each other. Each base must be less than its modulus and each exponent
+ * at most |num| words; all of the |num| words of the exponents are scanned,
+ * in fixed 5-bit windows. Returns 0 on allocation failure.
+ */
+static int rsaz_mod_exp_avx512_lanes(BN_ULONG *rr[], const BIGNUM *base[],
+                                     const BIGNUM *exp[],
+                                     const BN_MONT_CTX *mont[], int lanes)
+{
+    void (*amm)(BN_ULONG *, const BN_ULONG *, const BN_ULONG *,
+                const BN_ULONG *, BN_ULONG);
+    void (*gather)(BN_ULONG *, const BN_ULONG *, int);
+    RSAZ_AVX512_LANE lane[2], *ln;
+    int num = mont[0]->N.top, digits, size, len, bit, rbit, i, l, ret = 0;
+    BN_ULONG *p;
+    unsigned char *storage;
+
+    switch (num) {
+    case 24:
+        digits = 30;
+        size = 32;
+        amm = rsaz_amm52x30_avx512;
+        gather = rsaz_amm52x30_gather5_avx512;
+        break;
+    case 32:
+        digits = 40;
+        size = 40;
+        amm = rsaz_amm52x40_avx512;
+        gather = rsaz_amm52x40_gather5_avx512;
+        break;
+    default:
+        return 0;
+    }
+    if (lanes < 1 || lanes > (int)OSSL_NELEM(lane))
+        return 0;
+
+    len = sizeof(BN_ULONG) * ((32 + 5) * size + 2 * (num + 1)) * lanes + 64;
+    if ((storage = OPENSSL_zalloc(len)) == NULL)
+        return 0;
+    p = (BN_ULONG *)(storage + (64 - ((size_t)storage & 63)));
+    for (l = 0; l < lanes; l++) {
+        ln = &lane[l];
+        if (mont[l]->N.top != num)
+            goto err;
+        ln->mont = mont[l];
+        ln->k0 = mont[l]->n0[0] & DIGIT_MASK;
+        ln->table = p;
+        ln->base52 = ln->table + 32 * size;
+        ln->m52 = ln->base52 + size;
+        ln->rr52 = ln->m52 + size;
+        ln->acc = ln->rr52 + size;
+        ln->tmp = ln->acc + size;
+        ln->w64 = ln->tmp + size;
+        ln->e64 = ln->w64 + num + 1;
+        p = ln->e64 + num + 1;
+
+        if (!bn_copy_words(ln->w64, &ln->mont->N, num + 1))
+            goto err;
+        to_words52(ln->m52, digits, ln->w64);
+        if (!bn_copy_words(ln->w64, base[l], num + 1))
+            goto err;
+        to_words52(ln->base52, digits, ln->w64);
+        if (!bn_copy_words(ln->e64, exp[l], num + 1))
+            goto err;
+
+        /*
+         * R^2 mod m for R = 2^(52*digits) from mont->RR, which is
+         * 2^(128*num) mod m: squaring it divides by R once, and multiplying
+         * that by 2^(4*DIGIT_BITS*digits - 4*BN_BITS2*num) divides by R
+         * again.
+         */
+        if (!bn_copy_words(ln->w64, &ln->mont->RR, num + 1))
+            goto err;
+        to_words52(ln->rr52, digits, ln->w64);
+    }
+
+    rbit = 4 * DIGIT_BITS * digits - 4 * BN_BITS2 * num;
+    for (l = 0; l < lanes; l++)
+        amm(lane[l].rr52, lane[l].rr52, lane[l].rr52, lane[l].m52,
+            lane[l].k0);
+    for (l = 0; l < lanes; l++) {
+        ln = &lane[l];
+        memset(ln->tmp, 0, sizeof(BN_ULONG) * size);
+        ln->tmp[rbit / DIGIT_BITS] = (BN_ULONG)1 << (rbit % DIGIT_BITS);
+        amm(ln->rr52, ln->rr52, ln->tmp, ln->m52, ln->k0);
+    }
+
+    /* table[i] = base^i * R mod m, up to a multiple of m */
+    for (l = 0; l < lanes; l++) {
+        ln = &lane[l];
+        memset(ln->tmp, 0, sizeof(BN_ULONG) * size);
+        ln->tmp[0] = 1;
+        amm(ln->table, ln->rr52, ln->tmp, ln->m52, ln->k0);
+        amm(ln->table + size, ln->base52, ln->rr52, ln->m52, ln->k0);
+    }
+    for (i = 2; i < 32; i++)
+        for (l = 0; l < lanes; l++)
+            amm(lane[l].table + i * size, lane[l].table + (i - 1) * size,
+                lane[l].table + size, lane[l].m52, lane[l].k0);
+
+    bit = num * BN_BITS2 % WINDOW;
+    bit = num * BN_BITS2 - (bit != 0 ? bit : WINDOW);
+    for (l = 0; l < lanes; l++)
+        gather(lane[l].acc, lane[l].table, get_window(lane[l].e64, bit));
+    while (bit > 0) {
+        bit -= WINDOW;
+        for (i = 0; i < WINDOW; i++)
+            for (l = 0; l < lanes; l++)
+                amm(lane[l].acc, lane[l].acc, lane[l].acc, lane[l].m52,
+                    lane[l].k0);
+        for (l = 0; l < lanes; l++) {
+            ln = &lane[l];
+            gather(ln->tmp, ln->table, get_window(ln->e64, bit));
+            amm(ln->acc, ln->acc, ln->tmp, ln->m52, ln->k0);
+        }
+    }
+
+    /* out of Montgomery form, which leaves it at most m */
+    for (l = 0; l < lanes; l++) {
+        ln = &lane[l];
+        memset(ln->tmp, 0, sizeof(BN_ULONG) * size);
+        ln->tmp[0] = 1;
+        amm(ln->acc, ln->acc, ln->tmp, ln->m52, ln->k0);
+        from_words52(rr[l], num, ln->acc);
+        bn_reduce_once_in_place(rr[l], 0, ln->mont->N.d, ln->w64, num);
+    }
+    ret = 1;
+
+ err:
+    OPENSSL_clear_free(storage, len);
+    return ret;
+}
+
+/*
+ * rr = base^exp mod m for a 1536- or 2048-bit modulus, |num| being 24 or 32
+ * words, in time independent of |base| and |exp|. |base| must be less than
+ * m and |exp| at most |num| words; all of the |num| words of the exponent
+ * are scanned, in fixed 5-bit windows. Returns 0 on allocation failure.
+ */
+int RSAZ_mod_exp_avx512(BN_ULONG *rr, const BIGNUM *base, const BIGNUM *exp,
+                        const BN_MONT_CTX *mont)
+{
+    return rsaz_mod_exp_avx512_lanes(&rr, &base, &exp, &mont, 1);
+}
+
+/*
+ * Two exponentiations as RSAZ_mod_exp_avx512() does, such as the two CRT
+ * halves of an RSA private key operation, run side by side. Both moduli
+ * must have the same number of words. The results are only written once
+ * both bases and exponents have been read, so |rr1| and |rr2| may be the
+ * words of |base1| and |base2|.
+ */
+int RSAZ_mod_exp_avx512_x2(BN_ULONG *rr1, const BIGNUM *base1,
+                           const BIGNUM *exp1, const BN_MONT_CTX *mont1,
+                           BN_ULONG *rr2, const BIGNUM *base2,
+                           const BIGNUM *exp2, const BN_MONT_CTX *mont2)
+{
+    BN_ULONG *rr[2];
+    const BIGNUM *base[2], *exp[2];
+    const BN_MONT_CTX *mont[2];
+
+    rr[0] = rr1;
+    rr[1] = rr2;
+    base[0] = base1;
+    base[1] = base2;
+    exp[0] = exp1;
+    exp[1] = exp2;
+    mont[0] = mont1;
+    mont[1] = mont2;
+    return rsaz_mod_exp_avx512_lanes(rr, base, exp, mont, 2);
+}
+
+#endif
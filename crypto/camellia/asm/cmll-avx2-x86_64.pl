@@ -0,0 +1,353 @@
+#! /usr/bin/env perl
+# Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+#
+# Licensed under the OpenSSL license (the "License").  You may not use
+# this file except in compliance with the License.  You can obtain a copy
+# in the file LICENSE in the source distribution or at
+# https://www.openssl.org/source/license.html
+
+#
+# Camellia in counter mode for x86_64 with AVX2 and GFNI, 16 blocks at
+# a time.
+#
+# The Camellia S-box s1 is affine equivalent to inversion in the AES
+# field, s1(x) = B(inv(A(x))) with affine A and B, which makes it one
+# GF2P8AFFINEQB and one GF2P8AFFINEINVQB. s2 and s3 rotate the output of
+# s1 and s4 its input, so they only differ in the matrices. The function
+# F works on 64-bit halves, so a register holds the left or right halves
+# of four blocks, each half as a host-order 64-bit word, which is the
+# form the subkeys are stored in by cmll-x86_64.pl and makes the 32-bit
+# rotations of the FL layers plain shifts. The byte permutation P is the
+# sum of six byte shuffles, one of which only has four bytes.
+#
+# void camellia_avx2_ctr32_encrypt_blocks(const unsigned char *in,
+#                                         unsigned char *out,
+#                                         size_t blocks,
+#                                         const CAMELLIA_KEY *key,
+#                                         const unsigned char ivec[16]);
+#
+# is a ctr128_f: the last 32 bits of |ivec| are a big-endian counter
+# that wraps without carrying, and |ivec| is not updated. It takes the
+# key schedule of Camellia_set_key from cmll-x86_64.pl.
+#
+# int camellia_avx2_capable(void);
+#
+# returns non-zero if the processor has AVX2 and GFNI. The module
+# needs binutils 2.30 or clang 6 and is not built for Win64, which would
+# need an SEH handler; camellia_avx2_capable returns zero if it is not.
+
+$flavour = shift;
+$output  = shift;
+if ($flavour =~ /\./) { $output = $flavour; undef $flavour; }
+
+$win64=0; $win64=1 if ($flavour =~ /[nm]asm|mingw64/ || $output =~ /\.asm$/);
+
+$0 =~ m/(.*[\/\\])[^\/\\]+$/; $dir=$1;
+( $xlate="${dir}x86_64-xlate.pl" and -f $xlate ) or
+( $xlate="${dir}../../perlasm/x86_64-xlate.pl" and -f $xlate) or
+die "can't locate x86_64-xlate.pl";
+
+if (`$ENV{CC} -Wa,-v -c -o /dev/null -x assembler /dev/null 2>&1`
+		=~ /GNU assembler version ([2-9]\.[0-9]+)/) {
+	$gfni = ($1>=2.30);
+}
+
+if (!$gfni && `$ENV{CC} -v 2>&1` =~ /((?:clang|LLVM) version|.*based on LLVM) ([0-9]+\.[0-9]+)/) {
+	$gfni = ($2>=6.0);
+}
+
+$gfni = 0 if ($win64);
+
+open OUT,"| \"$^X\" \"$xlate\" $flavour \"$output\"";
+*STDOUT=*OUT;
+
+if ($gfni) {
+my ($inp,$out,$blocks,$key,$ivp)=("%rdi","%rsi","%rdx","%rcx","%r8");
+my ($rk,$keyend,$i)=("%r9","%r10","%r11");
+my @L=map("%ymm$_",(0..3));		# left halves of 16 blocks
+my @R=map("%ymm$_",(4..7));		# right halves
+my $K="%ymm8";				# subkey in all four lanes
+my ($Ms4,$Ms2,$Ms3)=map("%ymm$_",(9..11));	# where s4, s2 and s3 apply
+my @T=map("%ymm$_",(12..15));
+
+# P as byte shuffles of the S-box outputs, in host byte order: byte 0
+# of a half is the last one of the big-endian specification
+my @perm=(
+	[  3,  0,  1,  2,  4,  5,  6,  7],
+	[  4,  2,  3,  0,  1,  6,  7,  5],
+	[  2,  5,  0,  1,  6,  7,  3,  4],
+	[  1,  3,  6,  7,  5,  0,  4,  2],
+	[  7,  4,  5,  6,  2,  3,  0,  1],
+	[128,128,128,128,  3,  2,  1,  0]);
+
+# @dst ^= F(@src, subkey at $off($rk))
+sub feistel {
+my ($off,$src,$dst)=@_;
+$code.="	vpbroadcastq	$off($rk),$K\n";
+    for (my $j=0;$j<4;$j++) {
+	my ($x,$y)=($$src[$j],$$dst[$j]);
+	$code.=<<___;
+	vpxor		$K,$x,$T[0]
+	vgf2p8affineqb	\$0x08,.Lsbox_pre4(%rip),$T[0],$T[1]
+	vgf2p8affineqb	\$0x08,.Lsbox_pre1(%rip),$T[0],$T[0]
+	vpblendvb	$Ms4,$T[1],$T[0],$T[0]
+	vgf2p8affineinvqb	\$0x6e,.Lsbox_post1(%rip),$T[0],$T[1]
+	vgf2p8affineinvqb	\$0xdc,.Lsbox_post2(%rip),$T[0],$T[2]
+	vgf2p8affineinvqb	\$0x37,.Lsbox_post3(%rip),$T[0],$T[0]
+	vpblendvb	$Ms2,$T[2],$T[1],$T[1]
+	vpblendvb	$Ms3,$T[0],$T[1],$T[1]
+___
+	for (my $p=0;$p<@perm;$p++) {
+	$code.=<<___;
+	vpshufb		.Lperm_p+32*$p(%rip),$T[1],$T[2]
+	vpxor		$T[2],$y,$y
+___
+	}
+    }
+}
+
+# FL on the left halves, FL^-1 on the right ones
+sub fl {
+$code.="	vpbroadcastq	0($rk),$K\n";
+    foreach my $x (@L) {
+	$code.=<<___;
+	vpand		$K,$x,$T[0]		# s0&k0
+	vpslld		\$1,$T[0],$T[1]
+	vpsrld		\$31,$T[0],$T[0]
+	vpor		$T[1],$T[0],$T[0]
+	vpsrlq		\$32,$T[0],$T[0]
+	vpxor		$T[0],$x,$x		# s1^=LeftRotate(s0&k0,1)
+	vpor		$K,$x,$T[0]		# s1|k1
+	vpsllq		\$32,$T[0],$T[0]
+	vpxor		$T[0],$x,$x		# s0^=s1|k1
+___
+    }
+$code.="	vpbroadcastq	8($rk),$K\n";
+    foreach my $x (@R) {
+	$code.=<<___;
+	vpor		$K,$x,$T[0]		# s3|k3
+	vpsllq		\$32,$T[0],$T[0]
+	vpxor		$T[0],$x,$x		# s2^=s3|k3
+	vpand		$K,$x,$T[0]		# s2&k2
+	vpslld		\$1,$T[0],$T[1]
+	vpsrld		\$31,$T[0],$T[0]
+	vpor		$T[1],$T[0],$T[0]
+	vpsrlq		\$32,$T[0],$T[0]
+	vpxor		$T[0],$x,$x		# s3^=LeftRotate(s2&k2,1)
+___
+    }
+}
+
+$code.=<<___;
+.text
+.extern	OPENSSL_ia32cap_P
+
+.globl	camellia_avx2_capable
+.type	camellia_avx2_capable,\@abi-omnipotent
+.align	32
+camellia_avx2_capable:
+.cfi_startproc
+	mov	OPENSSL_ia32cap_P+8(%rip),%rcx
+	xor	%eax,%eax
+	mov	\$`1<<5|1<<(32+8)`,%rdx	# AVX2 and GFNI
+	and	%rdx,%rcx
+	cmp	%rdx,%rcx
+	sete	%al
+	ret
+.cfi_endproc
+.size	camellia_avx2_capable,.-camellia_avx2_capable
+
+.globl	camellia_avx2_ctr32_encrypt_blocks
+.type	camellia_avx2_ctr32_encrypt_blocks,\@function,5
+.align	32
+camellia_avx2_ctr32_encrypt_blocks:
+.cfi_startproc
+	push	%rbp
+.cfi_push	%rbp
+	mov	%rsp,%rbp
+.cfi_def_cfa_register	%rbp
+	sub	\$64+256,%rsp
+	and	\$-32,%rsp		# counter halves and tail buffer
+	test	$blocks,$blocks
+	jz	.Lctr32_done
+
+	vpbroadcastq	0($ivp),$T[0]
+	vpbroadcastq	8($ivp),$T[1]
+	vpshufb		.Lbswap64(%rip),$T[0],$T[0]
+	vpshufb		.Lbswap64(%rip),$T[1],$T[1]
+	vpaddd		.Lctr_init(%rip),$T[1],$T[1]
+	vmovdqa		$T[0],(%rsp)		# left half, the same for all
+	vmovdqa		$T[1],32(%rsp)		# right half with the counter
+	vmovdqa		.Lpos_s4(%rip),$Ms4
+	vmovdqa		.Lpos_s2(%rip),$Ms2
+	vmovdqa		.Lpos_s3(%rip),$Ms3
+	mov		272($key),%eax		# key->grand_rounds
+	shl		\$6,%eax
+	lea		($key,%rax),$keyend
+	jmp		.Lctr32_loop
+
+.align	32
+.Lctr32_loop:
+	vpbroadcastq	0($key),$K
+	vpxor		(%rsp),$K,$L[0]
+	vmovdqa		$L[0],$L[1]
+	vmovdqa		$L[0],$L[2]
+	vmovdqa		$L[0],$L[3]
+	vpbroadcastq	8($key),$K
+	vmovdqa		32(%rsp),$T[0]
+	vmovdqa		.Lctr_four(%rip),$T[1]
+___
+    foreach my $x (@R) {
+	$code.=<<___;
+	vpxor		$K,$T[0],$x
+	vpaddd		$T[1],$T[0],$T[0]
+___
+    }
+$code.=<<___;
+	vmovdqa		$T[0],32(%rsp)
+
+	lea		16($key),$rk
+.Lctr32_rounds:
+___
+	&feistel(0, \@L,\@R);
+	&feistel(8, \@R,\@L);
+	&feistel(16,\@L,\@R);
+	&feistel(24,\@R,\@L);
+	&feistel(32,\@L,\@R);
+	&feistel(40,\@R,\@L);
+$code.=<<___;
+	lea		48($rk),$rk
+	cmp		$keyend,$rk
+	je		.Lctr32_rounds_done
+___
+	&fl();
+$code.=<<___;
+	lea		16($rk),$rk
+	jmp		.Lctr32_rounds
+
+.align	16
+.Lctr32_rounds_done:
+	vpbroadcastq	0($rk),$K
+	vpbroadcastq	8($rk),$T[3]
+	vmovdqa		.Lbswap64(%rip),$T[2]
+___
+    # swap halves, qword lanes 0, 2 of the right halves are blocks 0, 1
+    for (my $j=0;$j<4;$j++) {
+	$code.=<<___;
+	vpxor		$K,$R[$j],$R[$j]
+	vpxor		$T[3],$L[$j],$L[$j]
+	vpunpcklqdq	$L[$j],$R[$j],$T[0]
+	vpunpckhqdq	$L[$j],$R[$j],$T[1]
+	vpshufb		$T[2],$T[0],$L[$j]
+	vpshufb		$T[2],$T[1],$R[$j]
+___
+    }
+$code.=<<___;
+	cmp		\$16,$blocks
+	jb		.Lctr32_tail
+___
+    for (my $j=0;$j<4;$j++) {
+	$code.=<<___;
+	vpxor		64*$j($inp),$L[$j],$L[$j]
+	vpxor		64*$j+32($inp),$R[$j],$R[$j]
+	vmovdqu		$L[$j],64*$j($out)
+	vmovdqu		$R[$j],64*$j+32($out)
+___
+    }
+$code.=<<___;
+	lea		256($inp),$inp
+	lea		256($out),$out
+	sub		\$16,$blocks
+	jnz		.Lctr32_loop
+	jmp		.Lctr32_done
+
+.align	16
+.Lctr32_tail:
+___
+    for (my $j=0;$j<4;$j++) {
+	$code.=<<___;
+	vmovdqa		$L[$j],64+64*$j(%rsp)
+	vmovdqa		$R[$j],64+64*$j+32(%rsp)
+___
+    }
+$code.=<<___;
+	xor		$i,$i
+.Lctr32_tail_loop:
+	vmovdqu		($inp,$i),%xmm0
+	vpxor		64(%rsp,$i),%xmm0,%xmm0
+	vmovdqu		%xmm0,($out,$i)
+	lea		16($i),$i
+	dec		$blocks
+	jnz		.Lctr32_tail_loop
+
+.Lctr32_done:
+	vpxor		$T[0],$T[0],$T[0]
+___
+    for (my $j=0;$j<10;$j++) {
+	$code.="	vmovdqa		$T[0],32*$j(%rsp)\n";
+    }
+$code.=<<___;
+	vzeroall
+	mov		%rbp,%rsp
+	pop		%rbp
+.cfi_def_cfa	%rsp,8
+.cfi_restore	%rbp
+	ret
+.cfi_endproc
+.size	camellia_avx2_ctr32_encrypt_blocks,.-camellia_avx2_ctr32_encrypt_blocks
+
+.align	64
+.Lsbox_pre1:
+	.quad	0xff38108aa65cc0bc,0xff38108aa65cc0bc,0xff38108aa65cc0bc,0xff38108aa65cc0bc
+.Lsbox_pre4:
+	.quad	0xff1c0845532e605e,0xff1c0845532e605e,0xff1c0845532e605e,0xff1c0845532e605e
+.Lsbox_post1:
+	.quad	0xeb36241e33d3b1b7,0xeb36241e33d3b1b7,0xeb36241e33d3b1b7,0xeb36241e33d3b1b7
+.Lsbox_post2:
+	.quad	0xb7eb36241e33d3b1,0xb7eb36241e33d3b1,0xb7eb36241e33d3b1,0xb7eb36241e33d3b1
+.Lsbox_post3:
+	.quad	0x36241e33d3b1b7eb,0x36241e33d3b1b7eb,0x36241e33d3b1b7eb,0x36241e33d3b1b7eb
+.Lpos_s4:
+	.quad	0x000000ff0000ff00,0x000000ff0000ff00,0x000000ff0000ff00,0x000000ff0000ff00
+.Lpos_s2:
+	.quad	0x00ff0000ff000000,0x00ff0000ff000000,0x00ff0000ff000000,0x00ff0000ff000000
+.Lpos_s3:
+	.quad	0x0000ff0000ff0000,0x0000ff0000ff0000,0x0000ff0000ff0000,0x0000ff0000ff0000
+.Lbswap64:
+	.byte	7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8,7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8
+.Lctr_init:
+	.long	0,0,2,0,1,0,3,0
+.Lctr_four:
+	.long	4,0,4,0,4,0,4,0
+.Lperm_p:
+___
+    foreach my $p (@perm) {
+	my @hi=map($_<128 ? $_+8 : $_, @$p);
+	$code.="	.byte	".join(",",@$p,@hi,@$p,@hi)."\n";
+    }
+} else {
+$code.=<<___;
+.text
+
+.globl	camellia_avx2_capable
+.type	camellia_avx2_capable,\@abi-omnipotent
+camellia_avx2_capable:
+	xor	%eax,%eax
+	ret
+.size	camellia_avx2_capable,.-camellia_avx2_capable
+
+.globl	camellia_avx2_ctr32_encrypt_blocks
+.type	camellia_avx2_ctr32_encrypt_blocks,\@abi-omnipotent
+camellia_avx2_ctr32_encrypt_blocks:
+	.byte	0x0f,0x0b	# ud2
+	ret
+.size	camellia_avx2_ctr32_encrypt_blocks,.-camellia_avx2_ctr32_encrypt_blocks
+___
+}
+$code.=<<___;
+.asciz	"Camellia-CTR for x86_64 with AVX2 and GFNI"
+___
+
+$code =~ s/\`([^\`]*)\`/eval $1/gem;
+print $code;
+close STDOUT or die "error closing STDOUT: $!";
@@ -69,6 +69,8 @@ struct CMS_SignedData_st {
     STACK_OF(CMS_CertificateChoices) *certificates;
     STACK_OF(CMS_RevocationInfoChoice) *crls;
     STACK_OF(CMS_SignerInfo) *signerInfos;
+    /* Not encoded: threads the signer operations may use */
+    int num_threads;
 };
 
 struct CMS_EncapsulatedContentInfo_st {
@@ -372,6 +374,8 @@ int cms_DigestedData_do_final(CMS_ContentInfo *cms, BIO *chain, int verify);
 
 BIO *cms_SignedData_init_bio(CMS_ContentInfo *cms);
 int cms_SignedData_final(CMS_ContentInfo *cms, BIO *chain);
+int cms_SignerInfos_run(CMS_ContentInfo *cms,
+                        int (*fn)(CMS_SignerInfo *si, void *arg), void *arg);
 int cms_set1_SignerIdentifier(CMS_SignerIdentifier *sid, X509 *cert,
                               int type);
 int cms_SignerIdentifier_get0_signer_id(CMS_SignerIdentifier *sid,
@@ -18,6 +18,14 @@
 #include "crypto/asn1.h"
 #include "crypto/evp.h"
 
+#if defined(OPENSSL_THREADS) && !defined(OPENSSL_SYS_WINDOWS)
+# define CMS_SIGNER_THREADS
+# include <pthread.h>
+#endif
+
+/* Upper bound for CMS_SignedData_set_num_threads() */
+#define CMS_MAX_THREADS         64
+
 /* CMS SignedData Utilities */
 
 static CMS_SignedData *cms_get0_signed(CMS_ContentInfo *cms)
@@ -58,6 +66,129 @@ int CMS_SignedData_init(CMS_ContentInfo *cms)
         return 0;
 }
 
+int CMS_SignedData_set_num_threads(CMS_ContentInfo *cms, int num_threads)
+{
+    CMS_SignedData *sd = cms_get0_signed(cms);
+
+    if (sd == NULL)
+        return 0;
+    if (num_threads < 1 || num_threads > CMS_MAX_THREADS) {
+        CMSerr(CMS_F_CMS_SIGNEDDATA_SET_NUM_THREADS,
+               ERR_R_PASSED_INVALID_ARGUMENT);
+        return 0;
+    }
+#ifndef CMS_SIGNER_THREADS
+    if (num_threads > 1) {
+        CMSerr(CMS_F_CMS_SIGNEDDATA_SET_NUM_THREADS, ERR_R_DISABLED);
+        return 0;
+    }
+#endif
+    sd->num_threads = num_threads;
+    return 1;
+}
+
+int CMS_SignedData_num_threads(CMS_ContentInfo *cms)
+{
+    CMS_SignedData *sd = cms_get0_signed(cms);
+
+    return sd != NULL && sd->num_threads > 1 ? sd->num_threads : 1;
+}
+
+#ifdef CMS_SIGNER_THREADS
+
+typedef struct {
+    STACK_OF(CMS_SignerInfo) *sinfos;
+    int (*fn)(CMS_SignerInfo *si, void *arg);
+    void *arg;
+    int *ret;
+    int first;
+    int step;
+} CMS_SIGNER_JOB;
+
+static void cms_signer_job_run(CMS_SIGNER_JOB *job)
+{
+    int i;
+
+    for (i = job->first; i < sk_CMS_SignerInfo_num(job->sinfos);
+         i += job->step)
+        job->ret[i] = job->fn(sk_CMS_SignerInfo_value(job->sinfos, i),
+                              job->arg);
+}
+
+static void *cms_signer_worker(void *arg)
+{
+    cms_signer_job_run(arg);
+    /* The caller reports failures, in its own error queue */
+    ERR_clear_error();
+    OPENSSL_thread_stop();
+    return NULL;
+}
+
+#endif
+
+/*
+ * Call |fn| for every SignerInfo, spread over the threads set with
+ * CMS_SignedData_set_num_threads(); the calling thread takes a share too.
+ * Returns 1 if every call succeeded, otherwise what the first failing one
+ * (in SignerInfo order) returned. The errors of a call that failed on
+ * another thread are lost, CMS_R_SIGNER_OPERATION_FAILED stands in for
+ * them.
+ */
+int cms_SignerInfos_run(CMS_ContentInfo *cms,
+                        int (*fn)(CMS_SignerInfo *si, void *arg), void *arg)
+{
+    STACK_OF(CMS_SignerInfo) *sinfos = CMS_get0_SignerInfos(cms);
+    int i, r, num = sk_CMS_SignerInfo_num(sinfos);
+#ifdef CMS_SIGNER_THREADS
+    CMS_SIGNER_JOB job[CMS_MAX_THREADS];
+    pthread_t tid[CMS_MAX_THREADS];
+    int started[CMS_MAX_THREADS];
+    int *ret, t, nthreads = CMS_SignedData_num_threads(cms);
+
+    if (nthreads > num)
+        nthreads = num;
+    if (nthreads > 1
+            && (ret = OPENSSL_malloc(sizeof(*ret) * num)) != NULL) {
+        for (t = 0; t < nthreads; t++) {
+            job[t].sinfos = sinfos;
+            job[t].fn = fn;
+            job[t].arg = arg;
+            job[t].ret = ret;
+            job[t].first = t;
+            job[t].step = nthreads;
+            started[t] = t > 0 && pthread_create(&tid[t], NULL,
+                                                 cms_signer_worker,
+                                                 &job[t]) == 0;
+        }
+        for (t = 0; t < nthreads; t++)
+            if (!started[t])
+                cms_signer_job_run(&job[t]);
+        for (t = 1; t < nthreads; t++)
+            if (started[t])
+                pthread_join(tid[t], NULL);
+
+        r = 1;
+        for (i = 0; i < num; i++) {
+            if (ret[i] <= 0) {
+                r = ret[i];
+                if (started[i % nthreads])
+                    CMSerr(CMS_F_CMS_SIGNERINFOS_RUN,
+                           CMS_R_SIGNER_OPERATION_FAILED);
+                break;
+            }
+        }
+        OPENSSL_free(ret);
+        return r;
+    }
+#endif
+
+    for (i = 0; i < num; i++) {
+        if ((r = fn(sk_CMS_SignerInfo_value(sinfos, i), arg)) <= 0)
+            return r;
+    }
+    return 1;
+}
+
 /* Check structures and fixup version numbers (if necessary) */
 
 static void cms_sd_set_version(CMS_SignedData *sd)
@@ -638,17 +769,26 @@ static int cms_SignerInfo_content_sign(CMS_ContentInfo *cms,
 
 }
 
+typedef struct {
+    CMS_ContentInfo *cms;
+    BIO *chain;
+} CMS_CONTENT_SIGN_ARG;
+
+static int cms_signer_content_sign(CMS_SignerInfo *si, void *arg)
+{
+    CMS_CONTENT_SIGN_ARG *csa = arg;
+
+    return cms_SignerInfo_content_sign(csa->cms, si, csa->chain);
+}
+
 int cms_SignedData_final(CMS_ContentInfo *cms, BIO *chain)
 {
-    STACK_OF(CMS_SignerInfo) *sinfos;
-    CMS_SignerInfo *si;
-    int i;
-    sinfos = CMS_get0_SignerInfos(cms);
-    for (i = 0; i < sk_CMS_SignerInfo_num(sinfos); i++) {
-        si = sk_CMS_SignerInfo_value(sinfos, i);
-        if (!cms_SignerInfo_content_sign(cms, si, chain))
-            return 0;
-    }
+    CMS_CONTENT_SIGN_ARG csa;
+
+    csa.cms = cms;
+    csa.chain = chain;
+    if (cms_SignerInfos_run(cms, cms_signer_content_sign, &csa) <= 0)
+        return 0;
     cms->d.signedData->encapContentInfo->partial = 0;
     return 1;
 }
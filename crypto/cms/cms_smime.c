@@ -262,6 +262,19 @@ static int cms_signerinfo_verify_cert(CMS_SignerInfo *si,
 
 }
 
+/* Per SignerInfo steps of CMS_verify(), see cms_SignerInfos_run() */
+static int cms_signer_verify_attrs(CMS_SignerInfo *si, void *arg)
+{
+    if (CMS_signed_get_attr_count(si) < 0)
+        return 1;
+    return CMS_SignerInfo_verify(si);
+}
+
+static int cms_signer_verify_content(CMS_SignerInfo *si, void *arg)
+{
+    return CMS_SignerInfo_verify_content(si, arg);
+}
+
 int CMS_verify(CMS_ContentInfo *cms, STACK_OF(X509) *certs,
                X509_STORE *store, BIO *dcont, BIO *out, unsigned int flags)
 {
@@ -320,15 +333,9 @@ int CMS_verify(CMS_ContentInfo *cms, STACK_OF(X509) *certs,
 
     /* Attempt to verify all SignerInfo signed attribute signatures */
 
-    if (!(flags & CMS_NO_ATTR_VERIFY)) {
-        for (i = 0; i < sk_CMS_SignerInfo_num(sinfos); i++) {
-            si = sk_CMS_SignerInfo_value(sinfos, i);
-            if (CMS_signed_get_attr_count(si) < 0)
-                continue;
-            if (CMS_SignerInfo_verify(si) <= 0)
-                goto err;
-        }
-    }
+    if (!(flags & CMS_NO_ATTR_VERIFY)
+            && cms_SignerInfos_run(cms, cms_signer_verify_attrs, NULL) <= 0)
+        goto err;
 
     /*
      * Performance optimization: if the content is a memory BIO then store
@@ -386,14 +393,11 @@ int CMS_verify(CMS_ContentInfo *cms, STACK_OF(X509) *certs,
             goto err;
 
     }
-    if (!(flags & CMS_NO_CONTENT_VERIFY)) {
-        for (i = 0; i < sk_CMS_SignerInfo_num(sinfos); i++) {
-            si = sk_CMS_SignerInfo_value(sinfos, i);
-            if (CMS_SignerInfo_verify_content(si, cmsbio) <= 0) {
-                CMSerr(CMS_F_CMS_VERIFY, CMS_R_CONTENT_VERIFY_ERROR);
-                goto err;
-            }
-        }
+    if (!(flags & CMS_NO_CONTENT_VERIFY)
+            && cms_SignerInfos_run(cms, cms_signer_verify_content,
+                                   cmsbio) <= 0) {
+        CMSerr(CMS_F_CMS_VERIFY, CMS_R_CONTENT_VERIFY_ERROR);
+        goto err;
     }
 
     ret = 1;
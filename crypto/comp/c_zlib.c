@@ -18,6 +18,7 @@
 #include "comp_local.h"
 
 COMP_METHOD *COMP_zlib(void);
+COMP_METHOD *COMP_zlib_oneshot(void);
 
 static COMP_METHOD zlib_method_nozlib = {
     NID_undef,
@@ -204,6 +205,67 @@ static int zlib_stateful_expand_block(COMP_CTX *ctx, unsigned char *out,
     return olen - state->istream.avail_out;
 }
 
+/*
+ * A complete zlib stream per block, for data compressed as a whole rather
+ * than as a sequence of records, e.g. TLS certificate compression
+ */
+static int zlib_oneshot_compress_block(COMP_CTX *ctx, unsigned char *out,
+                                       unsigned int olen, unsigned char *in,
+                                       unsigned int ilen)
+{
+    z_stream zs;
+    int err;
+
+    memset(&zs, 0, sizeof(zs));
+    zs.zalloc = zlib_zalloc;
+    zs.zfree = zlib_zfree;
+    if (deflateInit_(&zs, Z_BEST_COMPRESSION, ZLIB_VERSION,
+                     sizeof(z_stream)) != Z_OK)
+        return -1;
+    zs.next_in = in;
+    zs.avail_in = ilen;
+    zs.next_out = out;
+    zs.avail_out = olen;
+    err = deflate(&zs, Z_FINISH);
+    deflateEnd(&zs);
+    if (err != Z_STREAM_END)
+        return -1;
+    return olen - zs.avail_out;
+}
+
+static int zlib_oneshot_expand_block(COMP_CTX *ctx, unsigned char *out,
+                                     unsigned int olen, unsigned char *in,
+                                     unsigned int ilen)
+{
+    z_stream zs;
+    int err;
+
+    memset(&zs, 0, sizeof(zs));
+    zs.zalloc = zlib_zalloc;
+    zs.zfree = zlib_zfree;
+    if (inflateInit_(&zs, ZLIB_VERSION, sizeof(z_stream)) != Z_OK)
+        return -1;
+    zs.next_in = in;
+    zs.avail_in = ilen;
+    zs.next_out = out;
+    zs.avail_out = olen;
+    err = inflate(&zs, Z_FINISH);
+    inflateEnd(&zs);
+    /* The stream must end exactly where the input does */
+    if (err != Z_STREAM_END || zs.avail_in != 0)
+        return -1;
+    return olen - zs.avail_out;
+}
+
+static COMP_METHOD zlib_oneshot_method = {
+    NID_zlib_compression,
+    LN_zlib_compression,
+    NULL,
+    NULL,
+    zlib_oneshot_compress_block,
+    zlib_oneshot_expand_block
+};
+
 #endif
 
 COMP_METHOD *COMP_zlib(void)
@@ -259,6 +321,21 @@ COMP_METHOD *COMP_zlib(void)
     return meth;
 }
 
+COMP_METHOD *COMP_zlib_oneshot(void)
+{
+    COMP_METHOD *meth = &zlib_method_nozlib;
+
+#ifdef ZLIB_SHARED
+    /* Loads the library */
+    if (COMP_zlib() == &zlib_stateful_method && zlib_loaded)
+        meth = &zlib_oneshot_method;
+#elif defined(ZLIB)
+    meth = &zlib_oneshot_method;
+#endif
+
+    return meth;
+}
+
 void comp_zlib_cleanup_int(void)
 {
 #ifdef ZLIB_SHARED
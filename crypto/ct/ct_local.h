@@ -154,6 +154,13 @@ __owur int SCT_CTX_set1_issuer_pubkey(SCT_CTX *sctx, X509_PUBKEY *pubkey);
  */
 __owur int SCT_CTX_set1_pubkey(SCT_CTX *sctx, X509_PUBKEY *pubkey);
 
+/*
+ * Sets the public key of the CT log that the SCT is from, taking a reference
+ * to the key of |log| and its log ID rather than encoding and hashing the key.
+ * Returns 1 on success, 0 on failure.
+ */
+__owur int SCT_CTX_set1_log(SCT_CTX *sctx, const CTLOG *log);
+
 /*
  * Sets the time to evaluate the SCT against, in milliseconds since the Unix
  * epoch. If the SCT's timestamp is after this time, it will be interpreted as
@@ -14,6 +14,7 @@
 #include <openssl/ct.h>
 #include <openssl/err.h>
 #include <openssl/evp.h>
+#include <openssl/lhash.h>
 #include <openssl/safestack.h>
 
 #include "internal/cryptlib.h"
@@ -27,12 +28,16 @@ struct ctlog_st {
     EVP_PKEY *public_key;
 };
 
+DEFINE_LHASH_OF(CTLOG);
+
 /*
  * A store for multiple CTLOG instances.
  * It takes ownership of any CTLOG instances added to it.
+ * Logs are also indexed by log ID, which every SCT lookup uses.
  */
 struct ctlog_store_st {
     STACK_OF(CTLOG) *logs;
+    LHASH_OF(CTLOG) *by_id;
 };
 
 /* The context when loading a CT log list from a CONF file. */
@@ -89,6 +94,20 @@ err:
     return ret;
 }
 
+/* Log IDs are SHA-256 hashes, so any of their bytes make a good hash */
+static unsigned long ctlog_hash(const CTLOG *log)
+{
+    const uint8_t *id = log->log_id;
+
+    return (unsigned long)id[0] << 24 | (unsigned long)id[1] << 16
+        | (unsigned long)id[2] << 8 | id[3];
+}
+
+static int ctlog_cmp(const CTLOG *a, const CTLOG *b)
+{
+    return memcmp(a->log_id, b->log_id, CT_V1_HASHLEN);
+}
+
 CTLOG_STORE *CTLOG_STORE_new(void)
 {
     CTLOG_STORE *ret = OPENSSL_zalloc(sizeof(*ret));
@@ -101,9 +120,13 @@ CTLOG_STORE *CTLOG_STORE_new(void)
     ret->logs = sk_CTLOG_new_null();
     if (ret->logs == NULL)
         goto err;
+    ret->by_id = lh_CTLOG_new(ctlog_hash, ctlog_cmp);
+    if (ret->by_id == NULL)
+        goto err;
 
     return ret;
 err:
+    sk_CTLOG_free(ret->logs);
     OPENSSL_free(ret);
     return NULL;
 }
@@ -111,6 +134,7 @@ err:
 void CTLOG_STORE_free(CTLOG_STORE *store)
 {
     if (store != NULL) {
+        lh_CTLOG_free(store->by_id);
         sk_CTLOG_pop_free(store->logs, CTLOG_free);
         OPENSSL_free(store);
     }
@@ -184,6 +208,14 @@ static int ctlog_store_load_log(const char *log_name, int log_name_len,
     if (!sk_CTLOG_push(load_ctx->log_store->logs, ct_log)) {
         goto mem_err;
     }
+    /* If two logs share a key, lookups keep finding the first one */
+    if (lh_CTLOG_retrieve(load_ctx->log_store->by_id, ct_log) == NULL) {
+        lh_CTLOG_insert(load_ctx->log_store->by_id, ct_log);
+        if (lh_CTLOG_error(load_ctx->log_store->by_id)) {
+            (void)sk_CTLOG_pop(load_ctx->log_store->logs);
+            goto mem_err;
+        }
+    }
     return 1;
 
 mem_err:
@@ -294,13 +326,10 @@ const CTLOG *CTLOG_STORE_get0_log_by_id(const CTLOG_STORE *store,
                                         const uint8_t *log_id,
                                         size_t log_id_len)
 {
-    int i;
+    CTLOG key;
 
-    for (i = 0; i < sk_CTLOG_num(store->logs); ++i) {
-        const CTLOG *log = sk_CTLOG_value(store->logs, i);
-        if (memcmp(log->log_id, log_id, log_id_len) == 0)
-            return log;
-    }
-
-    return NULL;
+    if (log_id_len != CT_V1_HASHLEN)
+        return NULL;
+    memcpy(key.log_id, log_id, CT_V1_HASHLEN);
+    return lh_CTLOG_retrieve(store->by_id, &key);
 }
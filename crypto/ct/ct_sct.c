@@ -287,11 +287,24 @@ sct_validation_status_t SCT_get_validation_status(const SCT *sct)
     return sct->validation_status;
 }
 
-int SCT_validate(SCT *sct, const CT_POLICY_EVAL_CTX *ctx)
+/*
+ * The verification context of the SCTs of one certificate.  The encodings of
+ * the certificate and the hash of its issuer's key are the same for all of
+ * its SCTs, so they are computed once, the first time an SCT needs them.
+ */
+typedef struct {
+    SCT_CTX *sctx;
+    /* 1 once the issuer key hash is set */
+    int issuer_set;
+    /* 1 once the certificate is encoded, -1 if it is not compatible with CT */
+    int cert_set;
+} SCT_VALIDATE_STATE;
+
+static int sct_validate(SCT *sct, const CT_POLICY_EVAL_CTX *ctx,
+                        SCT_VALIDATE_STATE *st)
 {
     int is_sct_valid = -1;
-    SCT_CTX *sctx = NULL;
-    X509_PUBKEY *pub = NULL, *log_pkey = NULL;
+    X509_PUBKEY *pub = NULL;
     const CTLOG *log;
 
     /*
@@ -312,40 +325,34 @@ int SCT_validate(SCT *sct, const CT_POLICY_EVAL_CTX *ctx)
         return 0;
     }
 
-    sctx = SCT_CTX_new();
-    if (sctx == NULL)
-        goto err;
+    if (st->sctx == NULL) {
+        st->sctx = SCT_CTX_new();
+        if (st->sctx == NULL)
+            return -1;
+        SCT_CTX_set_time(st->sctx, ctx->epoch_time_in_ms);
+    }
 
-    if (X509_PUBKEY_set(&log_pkey, CTLOG_get0_public_key(log)) != 1)
-        goto err;
-    if (SCT_CTX_set1_pubkey(sctx, log_pkey) != 1)
-        goto err;
+    if (SCT_CTX_set1_log(st->sctx, log) != 1)
+        return -1;
 
     if (SCT_get_log_entry_type(sct) == CT_LOG_ENTRY_TYPE_PRECERT) {
-        EVP_PKEY *issuer_pkey;
-
         if (ctx->issuer == NULL) {
             sct->validation_status = SCT_VALIDATION_STATUS_UNVERIFIED;
-            goto end;
+            return 0;
         }
 
-        issuer_pkey = X509_get0_pubkey(ctx->issuer);
+        if (!st->issuer_set) {
+            EVP_PKEY *issuer_pkey = X509_get0_pubkey(ctx->issuer);
 
-        if (X509_PUBKEY_set(&pub, issuer_pkey) != 1)
-            goto err;
-        if (SCT_CTX_set1_issuer_pubkey(sctx, pub) != 1)
-            goto err;
+            if (X509_PUBKEY_set(&pub, issuer_pkey) != 1)
+                goto err;
+            if (SCT_CTX_set1_issuer_pubkey(st->sctx, pub) != 1)
+                goto err;
+            st->issuer_set = 1;
+        }
     }
 
-    SCT_CTX_set_time(sctx, ctx->epoch_time_in_ms);
-
     /*
-     * XXX: Potential for optimization.  This repeats some idempotent heavy
-     * lifting on the certificate for each candidate SCT, and appears to not
-     * use any information in the SCT itself, only the certificate is
-     * processed.  So it may make more sense to to do this just once, perhaps
-     * associated with the shared (by all SCTs) policy eval ctx.
-     *
      * XXX: Failure here is global (SCT independent) and represents either an
      * issue with the certificate (e.g. duplicate extensions) or an out of
      * memory condition.  When the certificate is incompatible with CT, we just
@@ -357,24 +364,33 @@ int SCT_validate(SCT *sct, const CT_POLICY_EVAL_CTX *ctx)
      * to do is to report a validation failure and let the callback or
      * application decide what to do.
      */
-    if (SCT_CTX_set1_cert(sctx, ctx->cert, NULL) != 1)
+    if (st->cert_set == 0)
+        st->cert_set = SCT_CTX_set1_cert(st->sctx, ctx->cert, NULL) == 1
+            ? 1 : -1;
+    if (st->cert_set < 0)
         sct->validation_status = SCT_VALIDATION_STATUS_UNVERIFIED;
     else
-        sct->validation_status = SCT_CTX_verify(sctx, sct) == 1 ?
+        sct->validation_status = SCT_CTX_verify(st->sctx, sct) == 1 ?
             SCT_VALIDATION_STATUS_VALID : SCT_VALIDATION_STATUS_INVALID;
 
-end:
     is_sct_valid = sct->validation_status == SCT_VALIDATION_STATUS_VALID;
 err:
     X509_PUBKEY_free(pub);
-    X509_PUBKEY_free(log_pkey);
-    SCT_CTX_free(sctx);
+    return is_sct_valid;
+}
 
+int SCT_validate(SCT *sct, const CT_POLICY_EVAL_CTX *ctx)
+{
+    SCT_VALIDATE_STATE st = { NULL, 0, 0 };
+    int is_sct_valid = sct_validate(sct, ctx, &st);
+
+    SCT_CTX_free(st.sctx);
     return is_sct_valid;
 }
 
 int SCT_LIST_validate(const STACK_OF(SCT) *scts, CT_POLICY_EVAL_CTX *ctx)
 {
+    SCT_VALIDATE_STATE st = { NULL, 0, 0 };
     int are_scts_valid = 1;
     int sct_count = scts != NULL ? sk_SCT_num(scts) : 0;
     int i;
@@ -386,11 +402,14 @@ int SCT_LIST_validate(const STACK_OF(SCT) *scts, CT_POLICY_EVAL_CTX *ctx)
         if (sct == NULL)
             continue;
 
-        is_sct_valid = SCT_validate(sct, ctx);
-        if (is_sct_valid < 0)
-            return is_sct_valid;
+        is_sct_valid = sct_validate(sct, ctx, &st);
+        if (is_sct_valid < 0) {
+            are_scts_valid = is_sct_valid;
+            break;
+        }
         are_scts_valid &= is_sct_valid;
     }
 
+    SCT_CTX_free(st.sctx);
     return are_scts_valid;
 }
@@ -257,6 +257,33 @@ int SCT_CTX_set1_pubkey(SCT_CTX *sctx, X509_PUBKEY *pubkey)
     return 1;
 }
 
+int SCT_CTX_set1_log(SCT_CTX *sctx, const CTLOG *log)
+{
+    EVP_PKEY *pkey = CTLOG_get0_public_key(log);
+    const uint8_t *log_id;
+    size_t log_id_len;
+
+    CTLOG_get0_log_id(log, &log_id, &log_id_len);
+
+    /* Reuse buffer if possible */
+    if (sctx->pkeyhash == NULL || sctx->pkeyhashlen < log_id_len) {
+        unsigned char *hash = OPENSSL_malloc(log_id_len);
+
+        if (hash == NULL)
+            return 0;
+        OPENSSL_free(sctx->pkeyhash);
+        sctx->pkeyhash = hash;
+    }
+    memcpy(sctx->pkeyhash, log_id, log_id_len);
+    sctx->pkeyhashlen = log_id_len;
+
+    if (!EVP_PKEY_up_ref(pkey))
+        return 0;
+    EVP_PKEY_free(sctx->pkey);
+    sctx->pkey = pkey;
+    return 1;
+}
+
 void SCT_CTX_set_time(SCT_CTX *sctx, uint64_t time_in_ms)
 {
     sctx->epoch_time_in_ms = time_in_ms;
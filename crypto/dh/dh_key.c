@@ -114,7 +114,7 @@ static int generate_key(DH *dh)
         return 0;
     }
 
-    ctx = BN_CTX_new();
+    ctx = bn_ctx_acquire(0);
     if (ctx == NULL)
         goto err;
 
@@ -134,8 +134,10 @@ static int generate_key(DH *dh)
         pub_key = dh->pub_key;
 
     if (dh->flags & DH_FLAG_CACHE_MONT_P) {
-        mont = BN_MONT_CTX_set_locked(&dh->method_mont_p,
-                                      dh->lock, dh->p, ctx);
+        mont = dh_named_group_mont(dh->p);
+        if (mont == NULL)
+            mont = BN_MONT_CTX_set_locked(&dh->method_mont_p,
+                                          dh->lock, dh->p, ctx);
         if (!mont)
             goto err;
     }
@@ -190,7 +192,7 @@ static int generate_key(DH *dh)
         BN_free(pub_key);
     if (priv_key != dh->priv_key)
         BN_free(priv_key);
-    BN_CTX_free(ctx);
+    bn_ctx_release(ctx);
     return ok;
 }
 
@@ -207,7 +209,7 @@ static int compute_key(unsigned char *key, const BIGNUM *pub_key, DH *dh)
         goto err;
     }
 
-    ctx = BN_CTX_new();
+    ctx = bn_ctx_acquire(0);
     if (ctx == NULL)
         goto err;
     BN_CTX_start(ctx);
@@ -221,8 +223,10 @@ static int compute_key(unsigned char *key, const BIGNUM *pub_key, DH *dh)
     }
 
     if (dh->flags & DH_FLAG_CACHE_MONT_P) {
-        mont = BN_MONT_CTX_set_locked(&dh->method_mont_p,
-                                      dh->lock, dh->p, ctx);
+        mont = dh_named_group_mont(dh->p);
+        if (mont == NULL)
+            mont = BN_MONT_CTX_set_locked(&dh->method_mont_p,
+                                          dh->lock, dh->p, ctx);
         BN_set_flags(dh->priv_key, BN_FLG_CONSTTIME);
         if (!mont)
             goto err;
@@ -242,7 +246,7 @@ static int compute_key(unsigned char *key, const BIGNUM *pub_key, DH *dh)
     ret = BN_bn2binpad(tmp, key, BN_num_bytes(dh->p));
  err:
     BN_CTX_end(ctx);
-    BN_CTX_free(ctx);
+    bn_ctx_release(ctx);
     return ret;
 }
 
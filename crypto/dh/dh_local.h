@@ -55,3 +55,5 @@ struct dh_method {
     int (*generate_params) (DH *dh, int prime_len, int generator,
                             BN_GENCB *cb);
 };
+
+BN_MONT_CTX *dh_named_group_mont(const BIGNUM *p);
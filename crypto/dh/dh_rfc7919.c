@@ -13,6 +13,8 @@
 #include <openssl/bn.h>
 #include <openssl/objects.h>
 #include "crypto/bn_dh.h"
+#include "crypto/dh.h"
+#include "internal/thread_once.h"
 
 static DH *dh_param_init(const BIGNUM *p, int32_t nbits)
 {
@@ -72,3 +74,104 @@ int DH_get_nid(const DH *dh)
     }
     return nid;
 }
+
+/*
+ * Montgomery contexts for the well-known safe primes of RFC 7919 and
+ * RFC 3526. They are built once and shared read-only by every DH object
+ * using one of these primes, so that ephemeral keys created per handshake
+ * do not each recompute them. The RFC 7919 entries are keyed by their NID;
+ * the RFC 3526 groups have none and are recognised by their prime alone.
+ */
+typedef struct {
+    int nid;
+    const BIGNUM *p;
+    BIGNUM *(*get_prime)(BIGNUM *bn);
+    BIGNUM *prime;
+    BN_MONT_CTX *mont;
+} DH_NAMED_MONT;
+
+static DH_NAMED_MONT named_mont[] = {
+    { NID_ffdhe2048, &_bignum_ffdhe2048_p, NULL, NULL, NULL },
+    { NID_ffdhe3072, &_bignum_ffdhe3072_p, NULL, NULL, NULL },
+    { NID_ffdhe4096, &_bignum_ffdhe4096_p, NULL, NULL, NULL },
+    { NID_ffdhe6144, &_bignum_ffdhe6144_p, NULL, NULL, NULL },
+    { NID_ffdhe8192, &_bignum_ffdhe8192_p, NULL, NULL, NULL },
+    { NID_undef, NULL, BN_get_rfc3526_prime_1536, NULL, NULL },
+    { NID_undef, NULL, BN_get_rfc3526_prime_2048, NULL, NULL },
+    { NID_undef, NULL, BN_get_rfc3526_prime_3072, NULL, NULL },
+    { NID_undef, NULL, BN_get_rfc3526_prime_4096, NULL, NULL },
+    { NID_undef, NULL, BN_get_rfc3526_prime_6144, NULL, NULL },
+    { NID_undef, NULL, BN_get_rfc3526_prime_8192, NULL, NULL },
+};
+
+static CRYPTO_ONCE named_mont_once = CRYPTO_ONCE_STATIC_INIT;
+static int named_mont_inited = 0;
+
+DEFINE_RUN_ONCE_STATIC(do_named_mont_init)
+{
+    BN_CTX *ctx = BN_CTX_new();
+    DH_NAMED_MONT *ent;
+    size_t i;
+
+    if (ctx == NULL)
+        return 0;
+    for (i = 0; i < OSSL_NELEM(named_mont); i++) {
+        ent = &named_mont[i];
+        if (ent->p == NULL) {
+            if ((ent->prime = ent->get_prime(NULL)) == NULL)
+                continue;
+            ent->p = ent->prime;
+        }
+        if ((ent->mont = BN_MONT_CTX_new()) != NULL
+                && !BN_MONT_CTX_set(ent->mont, ent->p, ctx)) {
+            BN_MONT_CTX_free(ent->mont);
+            ent->mont = NULL;
+        }
+    }
+    BN_CTX_free(ctx);
+    named_mont_inited = 1;
+    return 1;
+}
+
+/*
+ * Returns the shared Montgomery context for |p| if it is one of the named
+ * primes, or NULL. The context must not be modified or freed by the caller.
+ */
+BN_MONT_CTX *dh_named_group_mont(const BIGNUM *p)
+{
+    DH_NAMED_MONT *ent;
+    int bits = BN_num_bits(p);
+    size_t i;
+
+    /* Only the sizes of the named groups are worth looking up */
+    if (bits % 512 != 0 || bits < 1536 || bits > 8192 || BN_is_negative(p))
+        return NULL;
+    if (!RUN_ONCE(&named_mont_once, do_named_mont_init))
+        return NULL;
+    for (i = 0; i < OSSL_NELEM(named_mont); i++) {
+        ent = &named_mont[i];
+        if (ent->mont == NULL || BN_num_bits(ent->p) != bits)
+            continue;
+        if (ent->p == p || BN_cmp(ent->p, p) == 0)
+            return ent->mont;
+    }
+    return NULL;
+}
+
+void dh_named_group_cleanup_int(void)
+{
+    size_t i;
+
+    if (!named_mont_inited)
+        return;
+    for (i = 0; i < OSSL_NELEM(named_mont); i++) {
+        BN_MONT_CTX_free(named_mont[i].mont);
+        named_mont[i].mont = NULL;
+        if (named_mont[i].prime != NULL) {
+            BN_free(named_mont[i].prime);
+            named_mont[i].prime = NULL;
+            named_mont[i].p = NULL;
+        }
+    }
+    named_mont_inited = 0;
+}
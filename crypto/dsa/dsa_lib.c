@@ -123,6 +123,7 @@ void DSA_free(DSA *r)
 
     CRYPTO_THREAD_lock_free(r->lock);
 
+    dsa_free_verify_tables(r);
     BN_clear_free(r->p);
     BN_clear_free(r->q);
     BN_clear_free(r->g);
@@ -131,6 +132,14 @@ void DSA_free(DSA *r)
     OPENSSL_free(r);
 }
 
+void dsa_free_verify_tables(DSA *d)
+{
+    bn_fixed_base_free(d->verify_g);
+    bn_fixed_base_free(d->verify_pub_key);
+    d->verify_g = NULL;
+    d->verify_pub_key = NULL;
+}
+
 int DSA_up_ref(DSA *r)
 {
     int i;
@@ -261,6 +270,8 @@ int DSA_set0_pqg(DSA *d, BIGNUM *p, BIGNUM *q, BIGNUM *g)
         || (d->g == NULL && g == NULL))
         return 0;
 
+    if (p != NULL || g != NULL)
+        dsa_free_verify_tables(d);
     if (p != NULL) {
         BN_free(d->p);
         d->p = p;
@@ -296,6 +307,7 @@ int DSA_set0_key(DSA *d, BIGNUM *pub_key, BIGNUM *priv_key)
         return 0;
 
     if (pub_key != NULL) {
+        dsa_free_verify_tables(d);
         BN_free(d->pub_key);
         d->pub_key = pub_key;
     }
@@ -9,6 +9,7 @@
 
 #include <openssl/dsa.h>
 #include "internal/refcount.h"
+#include "crypto/bn.h"
 
 struct dsa_st {
     /*
@@ -25,6 +26,9 @@ struct dsa_st {
     int flags;
     /* Normally used to cache montgomery values */
     BN_MONT_CTX *method_mont_p;
+    /* Fixed-base tables for g and pub_key, see DSA_FLAG_CACHE_VERIFY_TABLES */
+    BN_FIXED_BASE *verify_g;
+    BN_FIXED_BASE *verify_pub_key;
     CRYPTO_REF_COUNT references;
     CRYPTO_EX_DATA ex_data;
     const DSA_METHOD *meth;
@@ -75,3 +79,5 @@ int dsa_builtin_paramgen2(DSA *ret, size_t L, size_t N,
                           size_t seed_len, int idx, unsigned char *seed_out,
                           int *counter_ret, unsigned long *h_ret,
                           BN_GENCB *cb);
+
+void dsa_free_verify_tables(DSA *d);
@@ -296,6 +296,41 @@ static int dsa_sign_setup(DSA *dsa, BN_CTX *ctx_in,
     return ret;
 }
 
+/*
+ * Makes sure the fixed-base tables for g and pub_key are built. The first
+ * verification builds them outside the lock; a thread that loses the race
+ * to publish them discards its own copy.
+ */
+static int dsa_verify_tables(DSA *dsa, BN_MONT_CTX *mont, BN_CTX *ctx)
+{
+    BN_FIXED_BASE *g_tab = NULL, *pub_tab = NULL;
+    int bits = BN_num_bits(dsa->q);
+    int ok;
+
+    if (!CRYPTO_THREAD_read_lock(dsa->lock))
+        return 0;
+    ok = dsa->verify_g != NULL;
+    CRYPTO_THREAD_unlock(dsa->lock);
+    if (ok)
+        return 1;
+
+    if ((g_tab = bn_fixed_base_new(dsa->g, bits, mont, ctx)) != NULL
+            && (pub_tab = bn_fixed_base_new(dsa->pub_key, bits, mont,
+                                            ctx)) != NULL
+            && CRYPTO_THREAD_write_lock(dsa->lock)) {
+        if (dsa->verify_g == NULL) {
+            dsa->verify_g = g_tab;
+            dsa->verify_pub_key = pub_tab;
+            g_tab = pub_tab = NULL;
+        }
+        CRYPTO_THREAD_unlock(dsa->lock);
+        ok = 1;
+    }
+    bn_fixed_base_free(g_tab);
+    bn_fixed_base_free(pub_tab);
+    return ok;
+}
+
 static int dsa_do_verify(const unsigned char *dgst, int dgst_len,
                          DSA_SIG *sig, DSA *dsa)
 {
@@ -376,6 +411,11 @@ static int dsa_do_verify(const unsigned char *dgst, int dgst_len,
         if (!dsa->meth->dsa_mod_exp(dsa, t1, dsa->g, u1, dsa->pub_key, u2,
                                     dsa->p, ctx, mont))
             goto err;
+    } else if ((dsa->flags & DSA_FLAG_CACHE_VERIFY_TABLES) && mont != NULL
+               && dsa_verify_tables(dsa, mont, ctx)) {
+        if (!bn_mod_exp2_fixed_base(t1, dsa->verify_g, u1,
+                                    dsa->verify_pub_key, u2, mont, ctx))
+            goto err;
     } else {
         if (!BN_mod_exp2_mont(t1, dsa->g, u1, dsa->pub_key, u2, dsa->p, ctx,
                               mont))
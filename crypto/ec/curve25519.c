@@ -5595,3 +5595,65 @@ void X25519_public_from_private(uint8_t out_public_value[32],
 
     OPENSSL_cleanse(e, sizeof(e));
 }
+
+/*
+ * Batched X25519_public_from_private() over |num| consecutive 32-byte
+ * private keys. The fixed-base multiplications are still done one key at a
+ * time, but the conversions to the u-coordinate share a single field
+ * inversion per chunk (Montgomery's trick), which would otherwise be close
+ * to a third of the cost of each key.
+ */
+#define X25519_BATCH_CHUNK 8
+
+void X25519_public_from_private_batch(uint8_t *out_public_values,
+                                      const uint8_t *private_keys,
+                                      size_t num)
+{
+    uint8_t e[32];
+    ge_p3 A;
+    fe zplusy[X25519_BATCH_CHUNK], zminusy[X25519_BATCH_CHUNK];
+    fe acc[X25519_BATCH_CHUNK], inv, u;
+    size_t i, n;
+
+    while (num > 0) {
+        n = num < X25519_BATCH_CHUNK ? num : X25519_BATCH_CHUNK;
+        for (i = 0; i < n; i++) {
+            memcpy(e, private_keys + 32 * i, 32);
+            e[0] &= 248;
+            e[31] &= 127;
+            e[31] |= 64;
+
+            ge_scalarmult_base(&A, e);
+            fe_add(zplusy[i], A.Z, A.Y);
+            fe_sub(zminusy[i], A.Z, A.Y);
+        }
+
+        /* acc[i] is the product of zminusy[0..i] */
+        fe_copy(acc[0], zminusy[0]);
+        for (i = 1; i < n; i++)
+            fe_mul(acc[i], acc[i - 1], zminusy[i]);
+        fe_invert(inv, acc[n - 1]);
+
+        /* Peel one factor off the inverse per key, last key first */
+        for (i = n - 1; i > 0; i--) {
+            fe_mul(u, inv, acc[i - 1]);
+            fe_mul(inv, inv, zminusy[i]);
+            fe_mul(u, zplusy[i], u);
+            fe_tobytes(out_public_values + 32 * i, u);
+        }
+        fe_mul(u, zplusy[0], inv);
+        fe_tobytes(out_public_values, u);
+
+        out_public_values += 32 * n;
+        private_keys += 32 * n;
+        num -= n;
+    }
+
+    OPENSSL_cleanse(e, sizeof(e));
+    OPENSSL_cleanse(&A, sizeof(A));
+    OPENSSL_cleanse(zplusy, sizeof(zplusy));
+    OPENSSL_cleanse(zminusy, sizeof(zminusy));
+    OPENSSL_cleanse(acc, sizeof(acc));
+    OPENSSL_cleanse(inv, sizeof(inv));
+    OPENSSL_cleanse(u, sizeof(u));
+}
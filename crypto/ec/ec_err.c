@@ -27,6 +27,8 @@ static const ERR_STRING_DATA EC_str_functs[] = {
      "ecdh_simple_compute_key"},
     {ERR_PACK(ERR_LIB_EC, EC_F_ECDSA_DO_SIGN_EX, 0), "ECDSA_do_sign_ex"},
     {ERR_PACK(ERR_LIB_EC, EC_F_ECDSA_DO_VERIFY, 0), "ECDSA_do_verify"},
+    {ERR_PACK(ERR_LIB_EC, EC_F_ECDSA_DO_VERIFY_BATCH, 0),
+     "ECDSA_do_verify_batch"},
     {ERR_PACK(ERR_LIB_EC, EC_F_ECDSA_SIGN_EX, 0), "ECDSA_sign_ex"},
     {ERR_PACK(ERR_LIB_EC, EC_F_ECDSA_SIGN_SETUP, 0), "ECDSA_sign_setup"},
     {ERR_PACK(ERR_LIB_EC, EC_F_ECDSA_SIG_NEW, 0), "ECDSA_SIG_new"},
@@ -88,6 +90,8 @@ static const ERR_STRING_DATA EC_str_functs[] = {
      "ec_GF2m_simple_point_set_affine_coordinates"},
     {ERR_PACK(ERR_LIB_EC, EC_F_EC_GF2M_SIMPLE_SET_COMPRESSED_COORDINATES, 0),
      "ec_GF2m_simple_set_compressed_coordinates"},
+    {ERR_PACK(ERR_LIB_EC, EC_F_EC_GFP_FIXEDBASE_MUL, 0),
+     "ec_GFp_fixedbase_mul"},
     {ERR_PACK(ERR_LIB_EC, EC_F_EC_GFP_MONT_FIELD_DECODE, 0),
      "ec_GFp_mont_field_decode"},
     {ERR_PACK(ERR_LIB_EC, EC_F_EC_GFP_MONT_FIELD_ENCODE, 0),
@@ -126,6 +130,8 @@ static const ERR_STRING_DATA EC_str_functs[] = {
      "ec_GFp_nist_field_sqr"},
     {ERR_PACK(ERR_LIB_EC, EC_F_EC_GFP_NIST_GROUP_SET_CURVE, 0),
      "ec_GFp_nist_group_set_curve"},
+    {ERR_PACK(ERR_LIB_EC, EC_F_EC_GFP_SECP256K1_MUL, 0),
+     "ec_GFp_secp256k1_mul"},
     {ERR_PACK(ERR_LIB_EC, EC_F_EC_GFP_SIMPLE_BLIND_COORDINATES, 0),
      "ec_GFp_simple_blind_coordinates"},
     {ERR_PACK(ERR_LIB_EC, EC_F_EC_GFP_SIMPLE_FIELD_INV, 0),
@@ -186,6 +192,8 @@ static const ERR_STRING_DATA EC_str_functs[] = {
     {ERR_PACK(ERR_LIB_EC, EC_F_EC_KEY_CHECK_KEY, 0), "EC_KEY_check_key"},
     {ERR_PACK(ERR_LIB_EC, EC_F_EC_KEY_COPY, 0), "EC_KEY_copy"},
     {ERR_PACK(ERR_LIB_EC, EC_F_EC_KEY_GENERATE_KEY, 0), "EC_KEY_generate_key"},
+    {ERR_PACK(ERR_LIB_EC, EC_F_EC_KEY_GENERATE_KEY_BATCH, 0),
+     "EC_KEY_generate_key_batch"},
     {ERR_PACK(ERR_LIB_EC, EC_F_EC_KEY_NEW, 0), "EC_KEY_new"},
     {ERR_PACK(ERR_LIB_EC, EC_F_EC_KEY_NEW_METHOD, 0), "EC_KEY_new_method"},
     {ERR_PACK(ERR_LIB_EC, EC_F_EC_KEY_OCT2PRIV, 0), "EC_KEY_oct2priv"},
@@ -265,6 +273,8 @@ static const ERR_STRING_DATA EC_str_functs[] = {
     {ERR_PACK(ERR_LIB_EC, EC_F_O2I_ECPUBLICKEY, 0), "o2i_ECPublicKey"},
     {ERR_PACK(ERR_LIB_EC, EC_F_OLD_EC_PRIV_DECODE, 0), "old_ec_priv_decode"},
     {ERR_PACK(ERR_LIB_EC, EC_F_OQS_ITEM_VERIFY, 0), "oqs_item_verify"},
+    {ERR_PACK(ERR_LIB_EC, EC_F_OQS_KEM_KEY_NEW, 0), "oqs_kem_key_new"},
+    {ERR_PACK(ERR_LIB_EC, EC_F_OQS_KEM_SET_PUB_KEY, 0), "oqs_kem_set_pub_key"},
     {ERR_PACK(ERR_LIB_EC, EC_F_OQS_KEY_INIT, 0), "oqs_key_init"},
     {ERR_PACK(ERR_LIB_EC, EC_F_OQS_PRIV_DECODE, 0), "oqs_priv_decode"},
     {ERR_PACK(ERR_LIB_EC, EC_F_OQS_PRIV_ENCODE, 0), "oqs_priv_encode"},
@@ -274,6 +284,8 @@ static const ERR_STRING_DATA EC_str_functs[] = {
     {ERR_PACK(ERR_LIB_EC, EC_F_OSSL_ECDH_COMPUTE_KEY, 0),
      "ossl_ecdh_compute_key"},
     {ERR_PACK(ERR_LIB_EC, EC_F_OSSL_ECDSA_SIGN_SIG, 0), "ossl_ecdsa_sign_sig"},
+    {ERR_PACK(ERR_LIB_EC, EC_F_OSSL_ECDSA_VERIFY_BATCH, 0),
+     "ossl_ecdsa_verify_batch"},
     {ERR_PACK(ERR_LIB_EC, EC_F_OSSL_ECDSA_VERIFY_SIG, 0),
      "ossl_ecdsa_verify_sig"},
     {ERR_PACK(ERR_LIB_EC, EC_F_PKEY_ECD_CTRL, 0), "pkey_ecd_ctrl"},
@@ -295,7 +307,18 @@ static const ERR_STRING_DATA EC_str_functs[] = {
     {ERR_PACK(ERR_LIB_EC, EC_F_PKEY_OQS_DIGESTSIGN, 0), "pkey_oqs_digestsign"},
     {ERR_PACK(ERR_LIB_EC, EC_F_PKEY_OQS_DIGESTVERIFY, 0),
      "pkey_oqs_digestverify"},
+    {ERR_PACK(ERR_LIB_EC, EC_F_PKEY_OQS_KEM_CHECK_LENS, 0),
+     "pkey_oqs_kem_check_lens"},
+    {ERR_PACK(ERR_LIB_EC, EC_F_PKEY_OQS_KEM_DECAPSULATE, 0),
+     "pkey_oqs_kem_decapsulate"},
+    {ERR_PACK(ERR_LIB_EC, EC_F_PKEY_OQS_KEM_ENCAPSULATE, 0),
+     "pkey_oqs_kem_encapsulate"},
+    {ERR_PACK(ERR_LIB_EC, EC_F_PKEY_OQS_KEM_ENCAPSULATE_BATCH, 0),
+     "pkey_oqs_kem_encapsulate_batch"},
+    {ERR_PACK(ERR_LIB_EC, EC_F_PKEY_OQS_KEM_KEYGEN, 0), "pkey_oqs_kem_keygen"},
     {ERR_PACK(ERR_LIB_EC, EC_F_PKEY_OQS_KEYGEN, 0), "pkey_oqs_keygen"},
+    {ERR_PACK(ERR_LIB_EC, EC_F_PKEY_OQS_SIGN, 0), "pkey_oqs_sign"},
+    {ERR_PACK(ERR_LIB_EC, EC_F_PKEY_OQS_VERIFY, 0), "pkey_oqs_verify"},
     {ERR_PACK(ERR_LIB_EC, EC_F_VALIDATE_ECX_DERIVE, 0), "validate_ecx_derive"},
     {0, NULL}
 };
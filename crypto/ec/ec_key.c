@@ -39,6 +39,16 @@ EC_KEY *EC_KEY_new_by_curve_name(int nid)
     return ret;
 }
 
+/* Drops the multiples of a public key that is about to change */
+static void ec_key_pub_pre_comp_free(EC_KEY *key)
+{
+    EC_ec_pre_comp_free(key->pub_pre_comp);
+    EC_ec_pre_comp_free(key->gen_pre_comp);
+    key->pub_pre_comp = NULL;
+    key->gen_pre_comp = NULL;
+    key->verify_count = 0;
+}
+
 void EC_KEY_free(EC_KEY *r)
 {
     int i;
@@ -64,6 +74,7 @@ void EC_KEY_free(EC_KEY *r)
 
     CRYPTO_free_ex_data(CRYPTO_EX_INDEX_EC_KEY, r, &r->ex_data);
     CRYPTO_THREAD_lock_free(r->lock);
+    ec_key_pub_pre_comp_free(r);
     EC_GROUP_free(r->group);
     EC_POINT_free(r->pub_key);
     BN_clear_free(r->priv_key);
@@ -88,6 +99,7 @@ EC_KEY *EC_KEY_copy(EC_KEY *dest, const EC_KEY *src)
         dest->engine = NULL;
 #endif
     }
+    ec_key_pub_pre_comp_free(dest);
     /* copy the parameters */
     if (src->group != NULL) {
         const EC_METHOD *meth = EC_GROUP_method_of(src->group);
@@ -129,6 +141,7 @@ EC_KEY *EC_KEY_copy(EC_KEY *dest, const EC_KEY *src)
     dest->conv_form = src->conv_form;
     dest->version = src->version;
     dest->flags = src->flags;
+    dest->verify_precompute = src->verify_precompute;
     if (!CRYPTO_dup_ex_data(CRYPTO_EX_INDEX_EC_KEY,
                             &dest->ex_data, &src->ex_data))
         return NULL;
@@ -204,7 +217,7 @@ int ec_key_simple_generate_key(EC_KEY *eckey)
     const BIGNUM *order = NULL;
     EC_POINT *pub_key = NULL;
 
-    if ((ctx = BN_CTX_new()) == NULL)
+    if ((ctx = bn_ctx_acquire(0)) == NULL)
         goto err;
 
     if (eckey->priv_key == NULL) {
@@ -243,7 +256,102 @@ int ec_key_simple_generate_key(EC_KEY *eckey)
         EC_POINT_free(pub_key);
     if (eckey->priv_key != priv_key)
         BN_free(priv_key);
-    BN_CTX_free(ctx);
+    bn_ctx_release(ctx);
+    return ok;
+}
+
+/*
+ * Generates |num| keys on the same curve. The public keys are computed in
+ * projective coordinates and then all made affine together, so that the
+ * whole batch shares a single field inversion. Keys that use a different
+ * group, or a method other than the built-in one, are generated one by one.
+ */
+int EC_KEY_generate_key_batch(EC_KEY *keys[], size_t num)
+{
+    const EC_GROUP *group;
+    BN_CTX *ctx = NULL;
+    BIGNUM **priv = NULL;
+    EC_POINT **pub = NULL;
+    const BIGNUM *order;
+    size_t i;
+    int ok = 0;
+
+    for (i = 0; i < num; i++) {
+        if (keys[i] == NULL || keys[i]->group == NULL) {
+            ECerr(EC_F_EC_KEY_GENERATE_KEY_BATCH, ERR_R_PASSED_NULL_PARAMETER);
+            return 0;
+        }
+    }
+    if (num == 0)
+        return 1;
+
+    group = keys[0]->group;
+    if ((ctx = bn_ctx_acquire(0)) == NULL)
+        goto err;
+    for (i = 0; i < num; i++) {
+        if (keys[i]->meth->keygen != ossl_ec_key_gen
+                || keys[i]->group->meth->keygen != ec_key_simple_generate_key
+                || (keys[i]->group != group
+                    && (keys[i]->group->meth != group->meth
+                        || keys[i]->group->curve_name != group->curve_name
+                        || EC_GROUP_cmp(keys[i]->group, group, ctx) != 0)))
+            break;
+    }
+    if (i < num || num == 1 || group->meth->points_make_affine == NULL) {
+        for (i = 0; i < num; i++)
+            if (!EC_KEY_generate_key(keys[i]))
+                goto err;
+        ok = 1;
+        goto err;
+    }
+
+    if ((order = EC_GROUP_get0_order(group)) == NULL)
+        goto err;
+    if ((priv = OPENSSL_zalloc(num * sizeof(*priv))) == NULL
+            || (pub = OPENSSL_zalloc(num * sizeof(*pub))) == NULL) {
+        ECerr(EC_F_EC_KEY_GENERATE_KEY_BATCH, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+
+    for (i = 0; i < num; i++) {
+        priv[i] = keys[i]->priv_key != NULL ? keys[i]->priv_key : BN_new();
+        pub[i] = keys[i]->pub_key != NULL ? keys[i]->pub_key
+                                          : EC_POINT_new(keys[i]->group);
+        if (priv[i] == NULL || pub[i] == NULL)
+            goto err;
+
+        do
+            if (!BN_priv_rand_range(priv[i], order))
+                goto err;
+        while (BN_is_zero(priv[i])) ;
+
+        if (!EC_POINT_mul(keys[i]->group, pub[i], priv[i], NULL, NULL, ctx))
+            goto err;
+    }
+
+    if (!EC_POINTs_make_affine(group, num, pub, ctx))
+        goto err;
+
+    for (i = 0; i < num; i++) {
+        keys[i]->priv_key = priv[i];
+        keys[i]->pub_key = pub[i];
+    }
+    ok = 1;
+
+ err:
+    if (priv != NULL) {
+        for (i = 0; i < num; i++)
+            if (keys[i]->priv_key != priv[i])
+                BN_free(priv[i]);
+        OPENSSL_free(priv);
+    }
+    if (pub != NULL) {
+        for (i = 0; i < num; i++)
+            if (keys[i]->pub_key != pub[i])
+                EC_POINT_free(pub[i]);
+        OPENSSL_free(pub);
+    }
+    bn_ctx_release(ctx);
     return ok;
 }
 
@@ -285,7 +393,7 @@ int ec_key_simple_check_key(const EC_KEY *eckey)
         goto err;
     }
 
-    if ((ctx = BN_CTX_new()) == NULL)
+    if ((ctx = bn_ctx_acquire(0)) == NULL)
         goto err;
     if ((point = EC_POINT_new(eckey->group)) == NULL)
         goto err;
@@ -330,7 +438,7 @@ int ec_key_simple_check_key(const EC_KEY *eckey)
     }
     ok = 1;
  err:
-    BN_CTX_free(ctx);
+    bn_ctx_release(ctx);
     EC_POINT_free(point);
     return ok;
 }
@@ -348,7 +456,7 @@ int EC_KEY_set_public_key_affine_coordinates(EC_KEY *key, BIGNUM *x,
               ERR_R_PASSED_NULL_PARAMETER);
         return 0;
     }
-    ctx = BN_CTX_new();
+    ctx = bn_ctx_acquire(0);
     if (ctx == NULL)
         return 0;
 
@@ -390,7 +498,7 @@ int EC_KEY_set_public_key_affine_coordinates(EC_KEY *key, BIGNUM *x,
 
  err:
     BN_CTX_end(ctx);
-    BN_CTX_free(ctx);
+    bn_ctx_release(ctx);
     EC_POINT_free(point);
     return ok;
 
@@ -405,6 +513,7 @@ int EC_KEY_set_group(EC_KEY *key, const EC_GROUP *group)
 {
     if (key->meth->set_group != NULL && key->meth->set_group(key, group) == 0)
         return 0;
+    ec_key_pub_pre_comp_free(key);
     EC_GROUP_free(key->group);
     key->group = EC_GROUP_dup(group);
     return (key->group == NULL) ? 0 : 1;
@@ -519,6 +628,7 @@ int EC_KEY_set_public_key(EC_KEY *key, const EC_POINT *pub_key)
     if (key->meth->set_public != NULL
         && key->meth->set_public(key, pub_key) == 0)
         return 0;
+    ec_key_pub_pre_comp_free(key);
     EC_POINT_free(key->pub_key);
     key->pub_key = EC_POINT_dup(pub_key, key->group);
     return (key->pub_key == NULL) ? 0 : 1;
@@ -559,6 +669,77 @@ int EC_KEY_precompute_mult(EC_KEY *key, BN_CTX *ctx)
     return EC_GROUP_precompute_mult(key->group, ctx);
 }
 
+void EC_KEY_set_verify_precompute(EC_KEY *key, unsigned int verifies)
+{
+    key->verify_precompute = verifies;
+}
+
+/*-
+ * r := g_scalar * generator + p_scalar * pub_key, as EC_POINT_mul() does.
+ * Once this has been called key->verify_precompute times, multiples of the
+ * public key are computed for wNAF splitting and kept with the key, as are
+ * multiples of the generator if the group has none: splitting only one of
+ * the two scalars would not save any doublings. They are never modified
+ * afterwards, only dropped when the key changes.
+ */
+int ec_key_pub_mul(EC_KEY *key, EC_POINT *r, const BIGNUM *g_scalar,
+                   const BIGNUM *p_scalar, BN_CTX *ctx)
+{
+    const EC_GROUP *group = key->group;
+    const EC_POINT *points[2];
+    const BIGNUM *scalars[2];
+    EC_PRE_COMP *pre_comps[2], *gen = NULL, *pub = NULL;
+    int count, ret;
+
+    /* Only methods that multiply with ec_wNAF_mul() can use them */
+    if (key->verify_precompute == 0 || g_scalar == NULL || p_scalar == NULL
+            || ctx == NULL || group->generator == NULL
+            || (group->meth->mul != NULL
+                && group->meth->mul != ec_GFp_fixedbase_mul))
+        return EC_POINT_mul(group, r, g_scalar, key->pub_key, p_scalar, ctx);
+
+    if (!CRYPTO_THREAD_read_lock(key->lock))
+        return 0;
+    pre_comps[0] = EC_ec_pre_comp_dup(key->gen_pre_comp);
+    pre_comps[1] = EC_ec_pre_comp_dup(key->pub_pre_comp);
+    CRYPTO_THREAD_unlock(key->lock);
+
+    if (pre_comps[1] == NULL
+            && CRYPTO_atomic_add(&key->verify_count, 1, &count, key->lock)
+            && (unsigned int)count == key->verify_precompute) {
+        /* Failing to compute them only means doing without */
+        ERR_set_mark();
+        if (!ec_wNAF_have_precompute_mult(group))
+            gen = ec_wNAF_precompute_point(group, group->generator, ctx);
+        if (gen != NULL || ec_wNAF_have_precompute_mult(group))
+            pub = ec_wNAF_precompute_point(group, key->pub_key, ctx);
+        ERR_pop_to_mark();
+        if (pub != NULL && CRYPTO_THREAD_write_lock(key->lock)) {
+            if (key->pub_pre_comp == NULL) {
+                key->gen_pre_comp = EC_ec_pre_comp_dup(gen);
+                key->pub_pre_comp = EC_ec_pre_comp_dup(pub);
+            }
+            CRYPTO_THREAD_unlock(key->lock);
+        }
+        pre_comps[0] = gen;
+        pre_comps[1] = pub;
+    }
+
+    points[0] = group->generator;
+    points[1] = key->pub_key;
+    scalars[0] = g_scalar;
+    scalars[1] = p_scalar;
+    if (pre_comps[0] != NULL)
+        ret = ec_wNAF_mul_pre(group, r, NULL, 2, points, scalars, pre_comps,
+                              ctx);
+    else
+        ret = ec_wNAF_mul_pre(group, r, g_scalar, 1, points + 1, scalars + 1,
+                              pre_comps + 1, ctx);
+    EC_ec_pre_comp_free(pre_comps[0]);
+    EC_ec_pre_comp_free(pre_comps[1]);
+    return ret;
+}
+
 int EC_KEY_get_flags(const EC_KEY *key)
 {
     return key->flags;
@@ -598,6 +779,7 @@ int EC_KEY_oct2key(EC_KEY *key, const unsigned char *buf, size_t len,
         key->pub_key = EC_POINT_new(key->group);
     if (key->pub_key == NULL)
         return 0;
+    ec_key_pub_pre_comp_free(key);
     if (EC_POINT_oct2point(key->group, key->pub_key, buf, len, ctx) == 0)
         return 0;
     /*
@@ -13,6 +13,7 @@
 #include <openssl/err.h>
 #include <openssl/opensslv.h>
 
+#include "crypto/bn.h"
 #include "ec_local.h"
 
 /* functions for EC_GROUP objects */
@@ -1023,7 +1024,7 @@ int EC_POINTs_mul(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
         }
     }
 
-    if (ctx == NULL && (ctx = new_ctx = BN_CTX_secure_new()) == NULL) {
+    if (ctx == NULL && (ctx = new_ctx = bn_ctx_acquire(1)) == NULL) {
         ECerr(EC_F_EC_POINTS_MUL, ERR_R_INTERNAL_ERROR);
         return 0;
     }
@@ -1034,7 +1035,7 @@ int EC_POINTs_mul(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
         /* use default */
         ret = ec_wNAF_mul(group, r, scalar, num, points, scalars, ctx);
 
-    BN_CTX_free(new_ctx);
+    bn_ctx_release(new_ctx);
     return ret;
 }
 
@@ -1132,39 +1133,18 @@ int ec_group_simple_order_bits(const EC_GROUP *group)
 static int ec_field_inverse_mod_ord(const EC_GROUP *group, BIGNUM *r,
                                     const BIGNUM *x, BN_CTX *ctx)
 {
-    BIGNUM *e = NULL;
     BN_CTX *new_ctx = NULL;
-    int ret = 0;
+    int ret, noinv;
 
-    if (group->mont_data == NULL)
+    if (group->order == NULL || !BN_is_odd(group->order))
         return 0;
 
     if (ctx == NULL && (ctx = new_ctx = BN_CTX_secure_new()) == NULL)
         return 0;
 
-    BN_CTX_start(ctx);
-    if ((e = BN_CTX_get(ctx)) == NULL)
-        goto err;
+    /* divstep inversion, which is constant time for any order */
+    ret = bn_mod_inverse_consttime(r, x, group->order, ctx, &noinv);
 
-    /*-
-     * We want inverse in constant time, therefore we utilize the fact
-     * order must be prime and use Fermats Little Theorem instead.
-     */
-    if (!BN_set_word(e, 2))
-        goto err;
-    if (!BN_sub(e, group->order, e))
-        goto err;
-    /*-
-     * Exponent e is public.
-     * No need for scatter-gather or BN_FLG_CONSTTIME.
-     */
-    if (!BN_mod_exp_mont(r, x, e, group->order, ctx, group->mont_data))
-        goto err;
-
-    ret = 1;
-
- err:
-    BN_CTX_end(ctx);
     BN_CTX_free(new_ctx);
     return ret;
 }
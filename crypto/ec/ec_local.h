@@ -290,6 +290,15 @@ struct ec_key_st {
     int flags;
     CRYPTO_EX_DATA ex_data;
     CRYPTO_RWLOCK *lock;
+    /*
+     * Multiples of pub_key, and of the generator if the group has none, for
+     * ECDSA verification. They are computed once verify_count reaches
+     * verify_precompute, which is 0 if disabled
+     */
+    unsigned int verify_precompute;
+    int verify_count;
+    EC_PRE_COMP *pub_pre_comp;
+    EC_PRE_COMP *gen_pre_comp;
 };
 
 struct ec_point_st {
@@ -341,7 +350,13 @@ void EC_ec_pre_comp_free(EC_PRE_COMP *);
 int ec_wNAF_mul(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
                 size_t num, const EC_POINT *points[], const BIGNUM *scalars[],
                 BN_CTX *);
+int ec_wNAF_mul_pre(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
+                    size_t num, const EC_POINT *points[],
+                    const BIGNUM *scalars[], EC_PRE_COMP *const pre_comps[],
+                    BN_CTX *);
 int ec_wNAF_precompute_mult(EC_GROUP *group, BN_CTX *);
+EC_PRE_COMP *ec_wNAF_precompute_point(const EC_GROUP *group,
+                                      const EC_POINT *point, BN_CTX *ctx);
 int ec_wNAF_have_precompute_mult(const EC_GROUP *group);
 
 /* method functions in ecp_smpl.c */
@@ -590,11 +605,33 @@ int ec_group_simple_order_bits(const EC_GROUP *group);
 const EC_METHOD *EC_GFp_nistz256_method(void);
 #endif
 
+/** Returns GFp methods using montgomery multiplication, with a precomputed
+ * fixed-base table for multiplying the P-384 and P-521 generators.
+ *  \return  EC_METHOD object
+ */
+const EC_METHOD *EC_GFp_fixedbase_method(void);
+int ec_GFp_fixedbase_mul(const EC_GROUP *group, EC_POINT *r,
+                         const BIGNUM *scalar, size_t num,
+                         const EC_POINT *points[], const BIGNUM *scalars[],
+                         BN_CTX *ctx);
+
+/** Returns GFp methods using montgomery multiplication, with the GLV
+ * endomorphism of secp256k1 for point multiplication.
+ *  \return  EC_METHOD object
+ */
+const EC_METHOD *EC_GFp_secp256k1_method(void);
+int ec_GFp_secp256k1_mul(const EC_GROUP *group, EC_POINT *r,
+                         const BIGNUM *scalar, size_t num,
+                         const EC_POINT *points[], const BIGNUM *scalars[],
+                         BN_CTX *ctx);
+
 size_t ec_key_simple_priv2oct(const EC_KEY *eckey,
                               unsigned char *buf, size_t len);
 int ec_key_simple_oct2priv(EC_KEY *eckey, const unsigned char *buf, size_t len);
 int ec_key_simple_generate_key(EC_KEY *eckey);
 int ec_key_simple_generate_public_key(EC_KEY *eckey);
+int ec_key_pub_mul(EC_KEY *key, EC_POINT *r, const BIGNUM *g_scalar,
+                   const BIGNUM *p_scalar, BN_CTX *ctx);
 int ec_key_simple_check_key(const EC_KEY *eckey);
 
 int ec_curve_nid_from_params(const EC_GROUP *group, BN_CTX *ctx);
@@ -653,6 +690,10 @@ int ossl_ecdsa_verify(int type, const unsigned char *dgst, int dgst_len,
                       const unsigned char *sigbuf, int sig_len, EC_KEY *eckey);
 int ossl_ecdsa_verify_sig(const unsigned char *dgst, int dgst_len,
                           const ECDSA_SIG *sig, EC_KEY *eckey);
+int ossl_ecdsa_verify_batch(const EC_GROUP *group,
+                            const unsigned char *const dgst[],
+                            const int dgst_len[], const ECDSA_SIG *const sig[],
+                            EC_KEY *const eckey[], size_t num, int ok[]);
 
 int ED25519_sign(uint8_t *out_sig, const uint8_t *message, size_t message_len,
                  const uint8_t public_key[32], const uint8_t private_key[32]);
@@ -665,6 +706,9 @@ int X25519(uint8_t out_shared_key[32], const uint8_t private_key[32],
            const uint8_t peer_public_value[32]);
 void X25519_public_from_private(uint8_t out_public_value[32],
                                 const uint8_t private_key[32]);
+void X25519_public_from_private_batch(uint8_t *out_public_values,
+                                      const uint8_t *private_keys,
+                                      size_t num);
 
 /*-
  * This functions computes a single point multiplication over the EC group,
@@ -403,13 +403,27 @@ int ec_scalar_mul_ladder(const EC_GROUP *group, EC_POINT *r,
 int ec_wNAF_mul(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
                 size_t num, const EC_POINT *points[], const BIGNUM *scalars[],
                 BN_CTX *ctx)
+{
+    return ec_wNAF_mul_pre(group, r, scalar, num, points, scalars, NULL, ctx);
+}
+
+/*-
+ * As ec_wNAF_mul(), where pre_comps[i], if pre_comps and it are not NULL,
+ * holds precomputed multiples of points[i] as created by
+ * ec_wNAF_precompute_point(). Like the generator's, these are used with
+ * wNAF splitting.
+ */
+int ec_wNAF_mul_pre(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
+                    size_t num, const EC_POINT *points[],
+                    const BIGNUM *scalars[], EC_PRE_COMP *const pre_comps[],
+                    BN_CTX *ctx)
 {
     const EC_POINT *generator = NULL;
     EC_POINT *tmp = NULL;
     size_t totalnum;
-    size_t blocksize = 0, numblocks = 0; /* for wNAF splitting */
-    size_t pre_points_per_block = 0;
-    size_t i, j;
+    size_t blocksize, numblocks; /* for wNAF splitting */
+    size_t pre_points_per_block;
+    size_t i, j, l, nterms;
     int k;
     int r_is_inverted = 0;
     int r_is_at_infinity = 1;
@@ -422,10 +436,11 @@ int ec_wNAF_mul(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
     EC_POINT **v;
     EC_POINT ***val_sub = NULL; /* pointers to sub-arrays of 'val' or
                                  * 'pre_comp->points' */
-    const EC_PRE_COMP *pre_comp = NULL;
-    int num_scalar = 0;         /* flag: will be set to 1 if 'scalar' must be
-                                 * treated like other scalars, i.e.
-                                 * precomputation is not available */
+    const EC_PRE_COMP *pre_comp;
+    const EC_PRE_COMP **term_pre = NULL; /* precomputation for each term, if
+                                          * it can be used */
+    const EC_POINT **base = NULL; /* points to precompute multiples of now */
+    size_t num_base = 0;
     int ret = 0;
 
     if (!BN_is_zero(group->order) && !BN_is_zero(group->cofactor)) {
@@ -463,27 +478,31 @@ int ec_wNAF_mul(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
             ECerr(EC_F_EC_WNAF_MUL, EC_R_UNDEFINED_GENERATOR);
             goto err;
         }
+    }
 
-        /* look if we can use precomputed multiples of generator */
-
-        pre_comp = group->pre_comp.ec;
-        if (pre_comp && pre_comp->numblocks
-            && (EC_POINT_cmp(group, generator, pre_comp->points[0], ctx) ==
-                0)) {
-            blocksize = pre_comp->blocksize;
-
-            /*
-             * determine maximum number of blocks that wNAF splitting may
-             * yield (NB: maximum wNAF length is bit length plus one)
-             */
-            numblocks = (BN_num_bits(scalar) / blocksize) + 1;
+    /*
+     * Term i is scalars[i]*points[i] for i < num and scalar*generator for
+     * i == num
+     */
+    nterms = num + (scalar != NULL);
+    term_pre = OPENSSL_zalloc(nterms * sizeof(term_pre[0]));
+    base = OPENSSL_malloc(nterms * sizeof(base[0]));
+    if (nterms > 0 && (term_pre == NULL || base == NULL)) {
+        ECerr(EC_F_EC_WNAF_MUL, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
 
-            /*
-             * we cannot use more blocks than we have precomputation for
-             */
-            if (numblocks > pre_comp->numblocks)
-                numblocks = pre_comp->numblocks;
+    /* look if we can use precomputed multiples, and count the wNAFs */
+    totalnum = 0;
+    for (i = 0; i < nterms; i++) {
+        const EC_POINT *point = i < num ? points[i] : generator;
 
+        if (i < num)
+            pre_comp = pre_comps != NULL ? pre_comps[i] : NULL;
+        else
+            pre_comp = group->pre_comp.ec;
+        if (pre_comp && pre_comp->numblocks
+            && (EC_POINT_cmp(group, point, pre_comp->points[0], ctx) == 0)) {
             pre_points_per_block = (size_t)1 << (pre_comp->w - 1);
 
             /* check that pre_comp looks sane */
@@ -491,17 +510,14 @@ int ec_wNAF_mul(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
                 ECerr(EC_F_EC_WNAF_MUL, ERR_R_INTERNAL_ERROR);
                 goto err;
             }
+            term_pre[i] = pre_comp;
+            totalnum += pre_comp->numblocks;
         } else {
             /* can't use precomputation */
-            pre_comp = NULL;
-            numblocks = 1;
-            num_scalar = 1;     /* treat 'scalar' like 'num'-th element of
-                                 * 'scalars' */
+            totalnum++;
         }
     }
 
-    totalnum = num + numblocks;
-
     wsize = OPENSSL_malloc(totalnum * sizeof(wsize[0]));
     wNAF_len = OPENSSL_malloc(totalnum * sizeof(wNAF_len[0]));
     /* include space for pivot */
@@ -518,133 +534,136 @@ int ec_wNAF_mul(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
     }
 
     /*
-     * num_val will be the total number of temporarily precomputed points
+     * The terms without precomputation come first. num_val will be the
+     * total number of temporarily precomputed points
      */
     num_val = 0;
 
-    for (i = 0; i < num + num_scalar; i++) {
-        size_t bits;
-
-        bits = i < num ? BN_num_bits(scalars[i]) : BN_num_bits(scalar);
-        wsize[i] = EC_window_bits_for_scalar_size(bits);
-        num_val += (size_t)1 << (wsize[i] - 1);
-        wNAF[i + 1] = NULL;     /* make sure we always have a pivot */
-        wNAF[i] =
-            bn_compute_wNAF((i < num ? scalars[i] : scalar), wsize[i],
-                            &wNAF_len[i]);
-        if (wNAF[i] == NULL)
+    for (i = 0; i < nterms; i++) {
+        const BIGNUM *s = i < num ? scalars[i] : scalar;
+
+        if (term_pre[i] != NULL)
+            continue;
+        base[num_base] = i < num ? points[i] : generator;
+        wsize[num_base] = EC_window_bits_for_scalar_size(BN_num_bits(s));
+        num_val += (size_t)1 << (wsize[num_base] - 1);
+        wNAF[num_base + 1] = NULL; /* make sure we always have a pivot */
+        wNAF[num_base] = bn_compute_wNAF(s, wsize[num_base],
+                                         &wNAF_len[num_base]);
+        if (wNAF[num_base] == NULL)
             goto err;
-        if (wNAF_len[i] > max_len)
-            max_len = wNAF_len[i];
+        if (wNAF_len[num_base] > max_len)
+            max_len = wNAF_len[num_base];
+        num_base++;
     }
+    totalnum = num_base;
 
-    if (numblocks) {
-        /* we go here iff scalar != NULL */
+    for (i = 0; i < nterms; i++) {
+        const BIGNUM *s = i < num ? scalars[i] : scalar;
+        signed char *tmp_wNAF = NULL;
+        size_t tmp_len = 0;
+        signed char *pp;
+        EC_POINT **tmp_points;
 
-        if (pre_comp == NULL) {
-            if (num_scalar != 1) {
-                ECerr(EC_F_EC_WNAF_MUL, ERR_R_INTERNAL_ERROR);
-                goto err;
-            }
-            /* we have already generated a wNAF for 'scalar' */
-        } else {
-            signed char *tmp_wNAF = NULL;
-            size_t tmp_len = 0;
+        if ((pre_comp = term_pre[i]) == NULL)
+            continue;
+        blocksize = pre_comp->blocksize;
+        pre_points_per_block = (size_t)1 << (pre_comp->w - 1);
 
-            if (num_scalar != 0) {
-                ECerr(EC_F_EC_WNAF_MUL, ERR_R_INTERNAL_ERROR);
-                goto err;
-            }
+        /*
+         * determine maximum number of blocks that wNAF splitting may
+         * yield (NB: maximum wNAF length is bit length plus one)
+         */
+        numblocks = (BN_num_bits(s) / blocksize) + 1;
+
+        /*
+         * we cannot use more blocks than we have precomputation for
+         */
+        if (numblocks > pre_comp->numblocks)
+            numblocks = pre_comp->numblocks;
+
+        /*
+         * use the window size for which we have precomputation
+         */
+        tmp_wNAF = bn_compute_wNAF(s, pre_comp->w, &tmp_len);
+        if (!tmp_wNAF)
+            goto err;
 
+        if (tmp_len <= max_len) {
             /*
-             * use the window size for which we have precomputation
+             * One of the other wNAFs is at least as long as this one, so
+             * wNAF splitting will not buy us anything.
              */
-            wsize[num] = pre_comp->w;
-            tmp_wNAF = bn_compute_wNAF(scalar, wsize[num], &tmp_len);
-            if (!tmp_wNAF)
-                goto err;
+            wsize[totalnum] = pre_comp->w;
+            wNAF[totalnum] = tmp_wNAF;
+            wNAF[totalnum + 1] = NULL;
+            wNAF_len[totalnum] = tmp_len;
+            /*
+             * pre_comp->points starts with the points that we need here:
+             */
+            val_sub[totalnum] = pre_comp->points;
+            totalnum++;
+            continue;
+        }
 
-            if (tmp_len <= max_len) {
-                /*
-                 * One of the other wNAFs is at least as long as the wNAF
-                 * belonging to the generator, so wNAF splitting will not buy
-                 * us anything.
-                 */
+        /*
+         * don't include tmp_wNAF directly into wNAF array - use wNAF
+         * splitting and include the blocks
+         */
+        if (tmp_len < numblocks * blocksize) {
+            /*
+             * possibly we can do with fewer blocks than estimated
+             */
+            numblocks = (tmp_len + blocksize - 1) / blocksize;
+            if (numblocks > pre_comp->numblocks) {
+                ECerr(EC_F_EC_WNAF_MUL, ERR_R_INTERNAL_ERROR);
+                OPENSSL_free(tmp_wNAF);
+                goto err;
+            }
+        }
 
-                numblocks = 1;
-                totalnum = num + 1; /* don't use wNAF splitting */
-                wNAF[num] = tmp_wNAF;
-                wNAF[num + 1] = NULL;
-                wNAF_len[num] = tmp_len;
-                /*
-                 * pre_comp->points starts with the points that we need here:
-                 */
-                val_sub[num] = pre_comp->points;
-            } else {
+        /* split wNAF in 'numblocks' parts */
+        pp = tmp_wNAF;
+        tmp_points = pre_comp->points;
+
+        for (l = 0; l < numblocks; l++, totalnum++) {
+            wsize[totalnum] = pre_comp->w;
+            if (l < numblocks - 1) {
+                wNAF_len[totalnum] = blocksize;
+                if (tmp_len < blocksize) {
+                    ECerr(EC_F_EC_WNAF_MUL, ERR_R_INTERNAL_ERROR);
+                    OPENSSL_free(tmp_wNAF);
+                    goto err;
+                }
+                tmp_len -= blocksize;
+            } else
                 /*
-                 * don't include tmp_wNAF directly into wNAF array - use wNAF
-                 * splitting and include the blocks
+                 * last block gets whatever is left (this could be
+                 * more or less than 'blocksize'!)
                  */
+                wNAF_len[totalnum] = tmp_len;
 
-                signed char *pp;
-                EC_POINT **tmp_points;
-
-                if (tmp_len < numblocks * blocksize) {
-                    /*
-                     * possibly we can do with fewer blocks than estimated
-                     */
-                    numblocks = (tmp_len + blocksize - 1) / blocksize;
-                    if (numblocks > pre_comp->numblocks) {
-                        ECerr(EC_F_EC_WNAF_MUL, ERR_R_INTERNAL_ERROR);
-                        OPENSSL_free(tmp_wNAF);
-                        goto err;
-                    }
-                    totalnum = num + numblocks;
-                }
-
-                /* split wNAF in 'numblocks' parts */
-                pp = tmp_wNAF;
-                tmp_points = pre_comp->points;
+            wNAF[totalnum + 1] = NULL;
+            wNAF[totalnum] = OPENSSL_malloc(wNAF_len[totalnum]);
+            if (wNAF[totalnum] == NULL) {
+                ECerr(EC_F_EC_WNAF_MUL, ERR_R_MALLOC_FAILURE);
+                OPENSSL_free(tmp_wNAF);
+                goto err;
+            }
+            memcpy(wNAF[totalnum], pp, wNAF_len[totalnum]);
+            if (wNAF_len[totalnum] > max_len)
+                max_len = wNAF_len[totalnum];
 
-                for (i = num; i < totalnum; i++) {
-                    if (i < totalnum - 1) {
-                        wNAF_len[i] = blocksize;
-                        if (tmp_len < blocksize) {
-                            ECerr(EC_F_EC_WNAF_MUL, ERR_R_INTERNAL_ERROR);
-                            OPENSSL_free(tmp_wNAF);
-                            goto err;
-                        }
-                        tmp_len -= blocksize;
-                    } else
-                        /*
-                         * last block gets whatever is left (this could be
-                         * more or less than 'blocksize'!)
-                         */
-                        wNAF_len[i] = tmp_len;
-
-                    wNAF[i + 1] = NULL;
-                    wNAF[i] = OPENSSL_malloc(wNAF_len[i]);
-                    if (wNAF[i] == NULL) {
-                        ECerr(EC_F_EC_WNAF_MUL, ERR_R_MALLOC_FAILURE);
-                        OPENSSL_free(tmp_wNAF);
-                        goto err;
-                    }
-                    memcpy(wNAF[i], pp, wNAF_len[i]);
-                    if (wNAF_len[i] > max_len)
-                        max_len = wNAF_len[i];
-
-                    if (*tmp_points == NULL) {
-                        ECerr(EC_F_EC_WNAF_MUL, ERR_R_INTERNAL_ERROR);
-                        OPENSSL_free(tmp_wNAF);
-                        goto err;
-                    }
-                    val_sub[i] = tmp_points;
-                    tmp_points += pre_points_per_block;
-                    pp += blocksize;
-                }
+            if (*tmp_points == NULL) {
+                ECerr(EC_F_EC_WNAF_MUL, ERR_R_INTERNAL_ERROR);
                 OPENSSL_free(tmp_wNAF);
+                goto err;
             }
+            val_sub[totalnum] = tmp_points;
+            tmp_points += pre_points_per_block;
+            pp += blocksize;
         }
+        OPENSSL_free(tmp_wNAF);
     }
 
     /*
@@ -661,7 +680,7 @@ int ec_wNAF_mul(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
 
     /* allocate points for precomputation */
     v = val;
-    for (i = 0; i < num + num_scalar; i++) {
+    for (i = 0; i < num_base; i++) {
         val_sub[i] = v;
         for (j = 0; j < ((size_t)1 << (wsize[i] - 1)); j++) {
             *v = EC_POINT_new(group);
@@ -680,19 +699,14 @@ int ec_wNAF_mul(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
 
     /*-
      * prepare precomputed values:
-     *    val_sub[i][0] :=     points[i]
-     *    val_sub[i][1] := 3 * points[i]
-     *    val_sub[i][2] := 5 * points[i]
+     *    val_sub[i][0] :=     base[i]
+     *    val_sub[i][1] := 3 * base[i]
+     *    val_sub[i][2] := 5 * base[i]
      *    ...
      */
-    for (i = 0; i < num + num_scalar; i++) {
-        if (i < num) {
-            if (!EC_POINT_copy(val_sub[i][0], points[i]))
-                goto err;
-        } else {
-            if (!EC_POINT_copy(val_sub[i][0], generator))
-                goto err;
-        }
+    for (i = 0; i < num_base; i++) {
+        if (!EC_POINT_copy(val_sub[i][0], base[i]))
+            goto err;
 
         if (wsize[i] > 1) {
             if (!EC_POINT_dbl(group, tmp, val_sub[i][0], ctx))
@@ -795,16 +809,18 @@ int ec_wNAF_mul(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
         OPENSSL_free(val);
     }
     OPENSSL_free(val_sub);
+    OPENSSL_free(term_pre);
+    OPENSSL_free(base);
     return ret;
 }
 
 /*-
- * ec_wNAF_precompute_mult()
- * creates an EC_PRE_COMP object with preprecomputed multiples of the generator
+ * ec_wNAF_precompute_point()
+ * creates an EC_PRE_COMP object with preprecomputed multiples of a point
  * for use with wNAF splitting as implemented in ec_wNAF_mul().
  *
- * 'pre_comp->points' is an array of multiples of the generator
- * of the following form:
+ * 'pre_comp->points' is an array of multiples of the point, called
+ * generator below, of the following form:
  * points[0] =     generator;
  * points[1] = 3 * generator;
  * ...
@@ -818,27 +834,18 @@ int ec_wNAF_mul(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
  * points[2^(w-1)*numblocks-1]     = (2^(w-1)) *  2^(blocksize*(numblocks-1)) * generator
  * points[2^(w-1)*numblocks]       = NULL
  */
-int ec_wNAF_precompute_mult(EC_GROUP *group, BN_CTX *ctx)
+EC_PRE_COMP *ec_wNAF_precompute_point(const EC_GROUP *group,
+                                      const EC_POINT *generator, BN_CTX *ctx)
 {
-    const EC_POINT *generator;
     EC_POINT *tmp_point = NULL, *base = NULL, **var;
     BN_CTX *new_ctx = NULL;
     const BIGNUM *order;
     size_t i, bits, w, pre_points_per_block, blocksize, numblocks, num;
     EC_POINT **points = NULL;
-    EC_PRE_COMP *pre_comp;
-    int ret = 0;
+    EC_PRE_COMP *pre_comp, *ret = NULL;
 
-    /* if there is an old EC_PRE_COMP object, throw it away */
-    EC_pre_comp_free(group);
     if ((pre_comp = ec_pre_comp_new(group)) == NULL)
-        return 0;
-
-    generator = EC_GROUP_get0_generator(group);
-    if (generator == NULL) {
-        ECerr(EC_F_EC_WNAF_PRECOMPUTE_MULT, EC_R_UNDEFINED_GENERATOR);
-        goto err;
-    }
+        return NULL;
 
     if (ctx == NULL) {
         ctx = new_ctx = BN_CTX_new();
@@ -950,9 +957,8 @@ int ec_wNAF_precompute_mult(EC_GROUP *group, BN_CTX *ctx)
     pre_comp->points = points;
     points = NULL;
     pre_comp->num = num;
-    SETPRECOMP(group, ec, pre_comp);
+    ret = pre_comp;
     pre_comp = NULL;
-    ret = 1;
 
  err:
     BN_CTX_end(ctx);
@@ -970,6 +976,26 @@ int ec_wNAF_precompute_mult(EC_GROUP *group, BN_CTX *ctx)
     return ret;
 }
 
+int ec_wNAF_precompute_mult(EC_GROUP *group, BN_CTX *ctx)
+{
+    const EC_POINT *generator;
+    EC_PRE_COMP *pre_comp;
+
+    /* if there is an old EC_PRE_COMP object, throw it away */
+    EC_pre_comp_free(group);
+
+    generator = EC_GROUP_get0_generator(group);
+    if (generator == NULL) {
+        ECerr(EC_F_EC_WNAF_PRECOMPUTE_MULT, EC_R_UNDEFINED_GENERATOR);
+        return 0;
+    }
+
+    if ((pre_comp = ec_wNAF_precompute_point(group, generator, ctx)) == NULL)
+        return 0;
+    SETPRECOMP(group, ec, pre_comp);
+    return 1;
+}
+
 int ec_wNAF_have_precompute_mult(const EC_GROUP *group)
 {
     return HAVEPRECOMP(group, ec);
@@ -17,6 +17,7 @@
 #include <openssl/bn.h>
 #include <openssl/objects.h>
 #include <openssl/ec.h>
+#include "crypto/bn.h"
 #include "ec_local.h"
 
 int ossl_ecdh_compute_key(unsigned char **psec, size_t *pseclen,
@@ -47,7 +48,7 @@ int ecdh_simple_compute_key(unsigned char **pout, size_t *poutlen,
     size_t buflen, len;
     unsigned char *buf = NULL;
 
-    if ((ctx = BN_CTX_new()) == NULL)
+    if ((ctx = bn_ctx_acquire(0)) == NULL)
         goto err;
     BN_CTX_start(ctx);
     x = BN_CTX_get(ctx);
@@ -114,7 +115,7 @@ int ecdh_simple_compute_key(unsigned char **pout, size_t *poutlen,
  err:
     EC_POINT_clear_free(tmp);
     BN_CTX_end(ctx);
-    BN_CTX_free(ctx);
+    bn_ctx_release(ctx);
     OPENSSL_free(buf);
     return ret;
 }
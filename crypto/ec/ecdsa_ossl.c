@@ -58,7 +58,7 @@ static int ecdsa_sign_setup(EC_KEY *eckey, BN_CTX *ctx_in,
     }
 
     if ((ctx = ctx_in) == NULL) {
-        if ((ctx = BN_CTX_new()) == NULL) {
+        if ((ctx = bn_ctx_acquire(0)) == NULL) {
             ECerr(EC_F_ECDSA_SIGN_SETUP, ERR_R_MALLOC_FAILURE);
             return 0;
         }
@@ -139,7 +139,7 @@ static int ecdsa_sign_setup(EC_KEY *eckey, BN_CTX *ctx_in,
         BN_clear_free(r);
     }
     if (ctx != ctx_in)
-        BN_CTX_free(ctx);
+        bn_ctx_release(ctx);
     EC_POINT_free(tmp_point);
     BN_clear_free(X);
     return ret;
@@ -193,7 +193,7 @@ ECDSA_SIG *ossl_ecdsa_sign_sig(const unsigned char *dgst, int dgst_len,
     }
     s = ret->s;
 
-    if ((ctx = BN_CTX_new()) == NULL
+    if ((ctx = bn_ctx_acquire(0)) == NULL
         || (m = BN_new()) == NULL) {
         ECerr(EC_F_OSSL_ECDSA_SIGN_SIG, ERR_R_MALLOC_FAILURE);
         goto err;
@@ -277,7 +277,7 @@ ECDSA_SIG *ossl_ecdsa_sign_sig(const unsigned char *dgst, int dgst_len,
         ECDSA_SIG_free(ret);
         ret = NULL;
     }
-    BN_CTX_free(ctx);
+    bn_ctx_release(ctx);
     BN_clear_free(m);
     BN_clear_free(kinv);
     return ret;
@@ -314,10 +314,29 @@ int ossl_ecdsa_verify(int type, const unsigned char *dgst, int dgst_len,
     return ret;
 }
 
+/* The leftmost bits of |dgst|, as many as |order| has, as a number */
+static int ecdsa_dgst_to_bn(BIGNUM *m, const unsigned char *dgst, int dgst_len,
+                            const BIGNUM *order)
+{
+    int i = BN_num_bits(order);
+
+    /*
+     * Need to truncate digest if it is too long: first truncate whole bytes.
+     */
+    if (8 * dgst_len > i)
+        dgst_len = (i + 7) / 8;
+    if (!BN_bin2bn(dgst, dgst_len, m))
+        return 0;
+    /* If still too long truncate remaining bits with a shift */
+    if ((8 * dgst_len > i) && !BN_rshift(m, m, 8 - (i & 0x7)))
+        return 0;
+    return 1;
+}
+
 int ossl_ecdsa_verify_sig(const unsigned char *dgst, int dgst_len,
                           const ECDSA_SIG *sig, EC_KEY *eckey)
 {
-    int ret = -1, i;
+    int ret = -1;
     BN_CTX *ctx;
     const BIGNUM *order;
     BIGNUM *u1, *u2, *m, *X;
@@ -337,7 +356,7 @@ int ossl_ecdsa_verify_sig(const unsigned char *dgst, int dgst_len,
         return -1;
     }
 
-    ctx = BN_CTX_new();
+    ctx = bn_ctx_acquire(0);
     if (ctx == NULL) {
         ECerr(EC_F_OSSL_ECDSA_VERIFY_SIG, ERR_R_MALLOC_FAILURE);
         return -1;
@@ -371,18 +390,7 @@ int ossl_ecdsa_verify_sig(const unsigned char *dgst, int dgst_len,
         goto err;
     }
     /* digest -> m */
-    i = BN_num_bits(order);
-    /*
-     * Need to truncate digest if it is too long: first truncate whole bytes.
-     */
-    if (8 * dgst_len > i)
-        dgst_len = (i + 7) / 8;
-    if (!BN_bin2bn(dgst, dgst_len, m)) {
-        ECerr(EC_F_OSSL_ECDSA_VERIFY_SIG, ERR_R_BN_LIB);
-        goto err;
-    }
-    /* If still too long truncate remaining bits with a shift */
-    if ((8 * dgst_len > i) && !BN_rshift(m, m, 8 - (i & 0x7))) {
+    if (!ecdsa_dgst_to_bn(m, dgst, dgst_len, order)) {
         ECerr(EC_F_OSSL_ECDSA_VERIFY_SIG, ERR_R_BN_LIB);
         goto err;
     }
@@ -401,7 +409,7 @@ int ossl_ecdsa_verify_sig(const unsigned char *dgst, int dgst_len,
         ECerr(EC_F_OSSL_ECDSA_VERIFY_SIG, ERR_R_MALLOC_FAILURE);
         goto err;
     }
-    if (!EC_POINT_mul(group, point, u1, pub_key, u2, ctx)) {
+    if (!ec_key_pub_mul(eckey, point, u1, u2, ctx)) {
         ECerr(EC_F_OSSL_ECDSA_VERIFY_SIG, ERR_R_EC_LIB);
         goto err;
     }
@@ -419,7 +427,161 @@ int ossl_ecdsa_verify_sig(const unsigned char *dgst, int dgst_len,
     ret = (BN_ucmp(u1, sig->r) == 0);
  err:
     BN_CTX_end(ctx);
-    BN_CTX_free(ctx);
+    bn_ctx_release(ctx);
     EC_POINT_free(point);
     return ret;
 }
+
+/*-
+ * Verifies |num| signatures under keys that share |group|, setting ok[i] to
+ * what ossl_ecdsa_verify_sig() would return for each. The inverses of the s
+ * values come from a single inversion modulo the order (Montgomery's trick)
+ * and the products u1*G + u2*Q are converted to affine coordinates with a
+ * single field inversion. Returns 0 if the batch could not be processed.
+ */
+int ossl_ecdsa_verify_batch(const EC_GROUP *group,
+                            const unsigned char *const dgst[],
+                            const int dgst_len[], const ECDSA_SIG *const sig[],
+                            EC_KEY *const eckey[], size_t num, int ok[])
+{
+    BN_CTX *ctx;
+    const BIGNUM *order;
+    BIGNUM **w = NULL, *inv, *u1, *u2, *m, *X;
+    EC_POINT **points = NULL;
+    size_t i, j, cnt = 0;
+    size_t *idx = NULL;
+    int ret = 0;
+
+    if ((ctx = bn_ctx_acquire(0)) == NULL) {
+        ECerr(EC_F_OSSL_ECDSA_VERIFY_BATCH, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    BN_CTX_start(ctx);
+    inv = BN_CTX_get(ctx);
+    u1 = BN_CTX_get(ctx);
+    u2 = BN_CTX_get(ctx);
+    m = BN_CTX_get(ctx);
+    X = BN_CTX_get(ctx);
+    if (X == NULL) {
+        ECerr(EC_F_OSSL_ECDSA_VERIFY_BATCH, ERR_R_BN_LIB);
+        goto err;
+    }
+
+    if ((order = EC_GROUP_get0_order(group)) == NULL) {
+        ECerr(EC_F_OSSL_ECDSA_VERIFY_BATCH, ERR_R_EC_LIB);
+        goto err;
+    }
+
+    if ((w = OPENSSL_zalloc(num * sizeof(*w))) == NULL
+            || (points = OPENSSL_zalloc(num * sizeof(*points))) == NULL
+            || (idx = OPENSSL_malloc(num * sizeof(*idx))) == NULL) {
+        ECerr(EC_F_OSSL_ECDSA_VERIFY_BATCH, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+
+    /* Signatures that fail the range checks are settled straight away */
+    for (i = 0; i < num; i++) {
+        if (sig[i] == NULL
+                || EC_KEY_get0_public_key(eckey[i]) == NULL) {
+            ECerr(EC_F_OSSL_ECDSA_VERIFY_BATCH, EC_R_MISSING_PARAMETERS);
+            ok[i] = -1;
+        } else if (!EC_KEY_can_sign(eckey[i])) {
+            ECerr(EC_F_OSSL_ECDSA_VERIFY_BATCH,
+                  EC_R_CURVE_DOES_NOT_SUPPORT_SIGNING);
+            ok[i] = -1;
+        } else if (BN_is_zero(sig[i]->r) || BN_is_negative(sig[i]->r)
+                   || BN_ucmp(sig[i]->r, order) >= 0
+                   || BN_is_zero(sig[i]->s) || BN_is_negative(sig[i]->s)
+                   || BN_ucmp(sig[i]->s, order) >= 0) {
+            ECerr(EC_F_OSSL_ECDSA_VERIFY_BATCH, EC_R_BAD_SIGNATURE);
+            ok[i] = 0;
+        } else {
+            idx[cnt++] = i;
+        }
+    }
+    if (cnt == 0) {
+        ret = 1;
+        goto err;
+    }
+
+    /* w[j] = s_0 * ... * s_j, then its inverse times s_(j+1) * ... */
+    for (j = 0; j < cnt; j++) {
+        if ((w[j] = BN_new()) == NULL
+                || (j == 0 && !BN_copy(w[j], sig[idx[j]]->s))
+                || (j > 0 && !BN_mod_mul(w[j], w[j - 1], sig[idx[j]]->s,
+                                         order, ctx))) {
+            ECerr(EC_F_OSSL_ECDSA_VERIFY_BATCH, ERR_R_BN_LIB);
+            goto err;
+        }
+    }
+    if (!ec_group_do_inverse_ord(group, inv, w[cnt - 1], ctx)) {
+        ECerr(EC_F_OSSL_ECDSA_VERIFY_BATCH, ERR_R_BN_LIB);
+        goto err;
+    }
+    for (j = cnt; j-- > 0;) {
+        /* inv is (s_0 * ... * s_j)^-1 here */
+        if ((j > 0 && !BN_mod_mul(w[j], inv, w[j - 1], order, ctx))
+                || (j > 0 && !BN_mod_mul(inv, inv, sig[idx[j]]->s, order,
+                                         ctx))
+                || (j == 0 && !BN_copy(w[j], inv))) {
+            ECerr(EC_F_OSSL_ECDSA_VERIFY_BATCH, ERR_R_BN_LIB);
+            goto err;
+        }
+    }
+
+    for (j = 0; j < cnt; j++) {
+        i = idx[j];
+        if (!ecdsa_dgst_to_bn(m, dgst[i], dgst_len[i], order)
+                || !BN_mod_mul(u1, m, w[j], order, ctx)
+                || !BN_mod_mul(u2, sig[i]->r, w[j], order, ctx)) {
+            ECerr(EC_F_OSSL_ECDSA_VERIFY_BATCH, ERR_R_BN_LIB);
+            goto err;
+        }
+        if ((points[j] = EC_POINT_new(group)) == NULL) {
+            ECerr(EC_F_OSSL_ECDSA_VERIFY_BATCH, ERR_R_MALLOC_FAILURE);
+            goto err;
+        }
+        if (!ec_key_pub_mul(eckey[i], points[j], u1, u2, ctx)) {
+            ECerr(EC_F_OSSL_ECDSA_VERIFY_BATCH, ERR_R_EC_LIB);
+            goto err;
+        }
+    }
+
+    if (!EC_POINTs_make_affine(group, cnt, points, ctx)) {
+        ECerr(EC_F_OSSL_ECDSA_VERIFY_BATCH, ERR_R_EC_LIB);
+        goto err;
+    }
+
+    for (j = 0; j < cnt; j++) {
+        i = idx[j];
+        /* The point at infinity fails here, as in ossl_ecdsa_verify_sig() */
+        if (!EC_POINT_get_affine_coordinates(group, points[j], X, NULL, ctx)) {
+            ECerr(EC_F_OSSL_ECDSA_VERIFY_BATCH, ERR_R_EC_LIB);
+            ok[i] = -1;
+            continue;
+        }
+        if (!BN_nnmod(u1, X, order, ctx)) {
+            ECerr(EC_F_OSSL_ECDSA_VERIFY_BATCH, ERR_R_BN_LIB);
+            goto err;
+        }
+        /*  if the signature is correct u1 is equal to sig->r */
+        ok[i] = (BN_ucmp(u1, sig[i]->r) == 0);
+    }
+    ret = 1;
+
+ err:
+    if (w != NULL) {
+        for (j = 0; j < cnt; j++)
+            BN_free(w[j]);
+        OPENSSL_free(w);
+    }
+    if (points != NULL) {
+        for (j = 0; j < cnt; j++)
+            EC_POINT_free(points[j]);
+        OPENSSL_free(points);
+    }
+    OPENSSL_free(idx);
+    BN_CTX_end(ctx);
+    bn_ctx_release(ctx);
+    return ret;
+}
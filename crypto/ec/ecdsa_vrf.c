@@ -26,6 +26,58 @@ int ECDSA_do_verify(const unsigned char *dgst, int dgst_len,
     return -1;
 }
 
+/*-
+ * Sets ok[i] to ECDSA_do_verify(dgst[i], dgst_len[i], sig[i], eckey[i]).
+ * Keys that share a group and the built-in method are verified together,
+ * otherwise one by one.
+ * returns
+ *      1: all signatures correct
+ *      0: some signature incorrect, none in error
+ *     -1: error
+ */
+int ECDSA_do_verify_batch(const unsigned char *const dgst[],
+                          const int dgst_len[], const ECDSA_SIG *const sig[],
+                          EC_KEY *const eckey[], size_t num, int ok[])
+{
+    const EC_GROUP *group;
+    size_t i;
+    int ret = 1;
+
+    for (i = 0; i < num; i++) {
+        if (eckey[i] == NULL || eckey[i]->group == NULL) {
+            ECerr(EC_F_ECDSA_DO_VERIFY_BATCH, ERR_R_PASSED_NULL_PARAMETER);
+            return -1;
+        }
+    }
+    if (num == 0)
+        return 1;
+
+    group = eckey[0]->group;
+    for (i = 0; i < num; i++) {
+        if (eckey[i]->meth->verify_sig != ossl_ecdsa_verify_sig
+                || (eckey[i]->group != group
+                    && (eckey[i]->group->meth != group->meth
+                        || eckey[i]->group->curve_name != group->curve_name
+                        || EC_GROUP_cmp(eckey[i]->group, group, NULL) != 0)))
+            break;
+    }
+    if (i < num || num == 1) {
+        for (i = 0; i < num; i++)
+            ok[i] = ECDSA_do_verify(dgst[i], dgst_len[i], sig[i], eckey[i]);
+    } else if (!ossl_ecdsa_verify_batch(group, dgst, dgst_len, sig, eckey,
+                                        num, ok)) {
+        return -1;
+    }
+
+    for (i = 0; i < num; i++) {
+        if (ok[i] < 0)
+            return -1;
+        if (ok[i] == 0)
+            ret = 0;
+    }
+    return ret;
+}
+
 /*-
  * returns
  *      1: correct signature
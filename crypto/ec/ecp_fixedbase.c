@@ -0,0 +1,431 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Fixed-base scalar multiplication for NIST P-384 and P-521.
+ *
+ * The generator is multiplied by a fixed window method over a table that
+ * holds, for every 4-bit window of the scalar, the 15 non-zero multiples
+ * of the generator shifted to that window. The table row for each window
+ * is scanned in full to select the entry, and entries are accumulated with
+ * the complete addition formulas for a = -3 from Renes, Costello and
+ * Batina, "Complete addition formulas for prime order elliptic curves"
+ * (https://eprint.iacr.org/2015/1060, algorithm 4). The sequence of field
+ * operations therefore does not depend on the scalar. As with the ladder,
+ * this says nothing about the underlying multiprecision arithmetic.
+ *
+ * The tables are computed on first use. Everything else, including
+ * multiplication of arbitrary points, goes through ec_wNAF_mul().
+ */
+
+#include <string.h>
+#include <openssl/err.h>
+#include "internal/constant_time.h"
+#include "internal/thread_once.h"
+#include "crypto/bn.h"
+#include "ec_local.h"
+
+#define FB_WINDOW_BITS  4
+#define FB_ROW          ((1 << FB_WINDOW_BITS) - 1)
+
+#define FB_WORDS(bits)  (((bits) + BN_BITS2 - 1) / BN_BITS2)
+#define FB_WINDOWS(bits) (((bits) + FB_WINDOW_BITS - 1) / FB_WINDOW_BITS)
+#define FB_MAX_WORDS    FB_WORDS(FB_WINDOWS(521) * FB_WINDOW_BITS)
+
+typedef struct {
+    int nid;
+    int nwords;
+    int nwindows;
+    /* Field, curve and generator the table was computed for, encoded */
+    BN_ULONG *params;
+    /* nwindows rows of FB_ROW affine (x, y) pairs, encoded */
+    BN_ULONG *table;
+} FB_CURVE;
+
+#define FB_PARAMS       6
+
+#define FB_DEFINE_CURVE(name, nid, bits)                                \
+    static BN_ULONG name##_params[FB_PARAMS * FB_WORDS(bits)];          \
+    static BN_ULONG name##_table[FB_WINDOWS(bits) * FB_ROW * 2          \
+                                 * FB_WORDS(bits)];                     \
+    static FB_CURVE name = {                                            \
+        nid, FB_WORDS(bits), FB_WINDOWS(bits),                          \
+        name##_params, name##_table                                     \
+    };                                                                  \
+    static CRYPTO_ONCE name##_once = CRYPTO_ONCE_STATIC_INIT;           \
+    DEFINE_RUN_ONCE_STATIC(name##_init)                                 \
+    {                                                                   \
+        return fb_build(&name);                                         \
+    }
+
+static int fb_params(const EC_GROUP *group, const EC_POINT *generator,
+                     BN_ULONG *out, int nwords)
+{
+    if (generator == NULL || !generator->Z_is_one)
+        return 0;
+    return bn_copy_words(out, group->field, nwords)
+           && bn_copy_words(out + nwords, group->a, nwords)
+           && bn_copy_words(out + 2 * nwords, group->b, nwords)
+           && bn_copy_words(out + 3 * nwords, group->order, nwords)
+           && bn_copy_words(out + 4 * nwords, generator->X, nwords)
+           && bn_copy_words(out + 5 * nwords, generator->Y, nwords);
+}
+
+static int fb_build(FB_CURVE *c)
+{
+    EC_GROUP *group = NULL;
+    EC_POINT **points = NULL, *base = NULL;
+    BN_CTX *ctx = NULL;
+    size_t i, j, n = (size_t)c->nwindows * FB_ROW;
+    int ok = 0;
+
+    if ((group = EC_GROUP_new_by_curve_name(c->nid)) == NULL
+            || (ctx = BN_CTX_new()) == NULL
+            || (base = EC_POINT_dup(group->generator, group)) == NULL
+            || !fb_params(group, group->generator, c->params, c->nwords))
+        goto err;
+    if ((points = OPENSSL_zalloc(n * sizeof(*points))) == NULL)
+        goto err;
+
+    /* Row i holds j * 16^i * G for j = 1..15 */
+    for (i = 0; i < n; i += FB_ROW) {
+        for (j = 0; j < FB_ROW; j++) {
+            if ((points[i + j] = EC_POINT_new(group)) == NULL
+                    || (j == 0 && !EC_POINT_copy(points[i], base))
+                    || (j > 0 && !EC_POINT_add(group, points[i + j],
+                                               points[i + j - 1], base,
+                                               ctx)))
+                goto err;
+        }
+        if (!EC_POINT_add(group, base, points[i + FB_ROW - 1], base, ctx))
+            goto err;
+    }
+    if (!EC_POINTs_make_affine(group, n, points, ctx))
+        goto err;
+    for (i = 0; i < n; i++) {
+        if (!bn_copy_words(c->table + 2 * i * c->nwords, points[i]->X,
+                           c->nwords)
+                || !bn_copy_words(c->table + (2 * i + 1) * c->nwords,
+                                  points[i]->Y, c->nwords))
+            goto err;
+    }
+    ok = 1;
+
+ err:
+    if (points != NULL) {
+        for (i = 0; i < n; i++)
+            EC_POINT_free(points[i]);
+        OPENSSL_free(points);
+    }
+    EC_POINT_free(base);
+    BN_CTX_free(ctx);
+    EC_GROUP_free(group);
+    return ok;
+}
+
+FB_DEFINE_CURVE(fb_p384, NID_secp384r1, 384)
+FB_DEFINE_CURVE(fb_p521, NID_secp521r1, 521)
+
+/*
+ * Returns the table for |group|, or NULL if there is none or the group's
+ * field, curve or generator have been changed from the named curve's.
+ * A table that could not be computed is not an error: the caller falls
+ * back to the generic code, so nothing is left on the error queue.
+ */
+static const FB_CURVE *fb_curve(const EC_GROUP *group)
+{
+    BN_ULONG params[FB_PARAMS * FB_MAX_WORDS];
+    FB_CURVE *c;
+    int ok;
+
+    ERR_set_mark();
+    switch (group->curve_name) {
+    case NID_secp384r1:
+        ok = RUN_ONCE(&fb_p384_once, fb_p384_init);
+        c = &fb_p384;
+        break;
+    case NID_secp521r1:
+        ok = RUN_ONCE(&fb_p521_once, fb_p521_init);
+        c = &fb_p521;
+        break;
+    default:
+        ok = 0;
+        c = NULL;
+        break;
+    }
+    ERR_pop_to_mark();
+
+    if (!ok
+            || !fb_params(group, group->generator, params, c->nwords)
+            || memcmp(params, c->params,
+                      FB_PARAMS * c->nwords * sizeof(BN_ULONG)) != 0)
+        return NULL;
+    return c;
+}
+
+/*-
+ * (X3, Y3, Z3) := (X1, Y1, Z1) + (X2, Y2, Z2) in homogeneous projective
+ * coordinates, for any two points including the point at infinity. The
+ * outputs must not alias the inputs.
+ */
+static int fb_point_add(const EC_GROUP *group,
+                        BIGNUM *X3, BIGNUM *Y3, BIGNUM *Z3,
+                        const BIGNUM *X1, const BIGNUM *Y1, const BIGNUM *Z1,
+                        const BIGNUM *X2, const BIGNUM *Y2, const BIGNUM *Z2,
+                        BN_CTX *ctx)
+{
+    const BIGNUM *p = group->field;
+    BIGNUM *t0, *t1, *t2, *t3, *t4;
+    int ret = 0;
+
+    BN_CTX_start(ctx);
+    t0 = BN_CTX_get(ctx);
+    t1 = BN_CTX_get(ctx);
+    t2 = BN_CTX_get(ctx);
+    t3 = BN_CTX_get(ctx);
+    t4 = BN_CTX_get(ctx);
+
+    if (t4 == NULL
+        || !group->meth->field_mul(group, t0, X1, X2, ctx)
+        || !group->meth->field_mul(group, t1, Y1, Y2, ctx)
+        || !group->meth->field_mul(group, t2, Z1, Z2, ctx)
+        || !BN_mod_add_quick(t3, X1, Y1, p)
+        || !BN_mod_add_quick(t4, X2, Y2, p)
+        || !group->meth->field_mul(group, t3, t3, t4, ctx)
+        || !BN_mod_add_quick(t4, t0, t1, p)
+        || !BN_mod_sub_quick(t3, t3, t4, p)
+        || !BN_mod_add_quick(t4, Y1, Z1, p)
+        || !BN_mod_add_quick(X3, Y2, Z2, p)
+        || !group->meth->field_mul(group, t4, t4, X3, ctx)
+        || !BN_mod_add_quick(X3, t1, t2, p)
+        || !BN_mod_sub_quick(t4, t4, X3, p)
+        || !BN_mod_add_quick(X3, X1, Z1, p)
+        || !BN_mod_add_quick(Y3, X2, Z2, p)
+        || !group->meth->field_mul(group, X3, X3, Y3, ctx)
+        || !BN_mod_add_quick(Y3, t0, t2, p)
+        || !BN_mod_sub_quick(Y3, X3, Y3, p)
+        || !group->meth->field_mul(group, Z3, group->b, t2, ctx)
+        || !BN_mod_sub_quick(X3, Y3, Z3, p)
+        || !BN_mod_lshift1_quick(Z3, X3, p)
+        || !BN_mod_add_quick(X3, X3, Z3, p)
+        || !BN_mod_sub_quick(Z3, t1, X3, p)
+        || !BN_mod_add_quick(X3, t1, X3, p)
+        || !group->meth->field_mul(group, Y3, group->b, Y3, ctx)
+        || !BN_mod_lshift1_quick(t1, t2, p)
+        || !BN_mod_add_quick(t2, t1, t2, p)
+        || !BN_mod_sub_quick(Y3, Y3, t2, p)
+        || !BN_mod_sub_quick(Y3, Y3, t0, p)
+        || !BN_mod_lshift1_quick(t1, Y3, p)
+        || !BN_mod_add_quick(Y3, t1, Y3, p)
+        || !BN_mod_lshift1_quick(t1, t0, p)
+        || !BN_mod_add_quick(t0, t1, t0, p)
+        || !BN_mod_sub_quick(t0, t0, t2, p)
+        || !group->meth->field_mul(group, t1, t4, Y3, ctx)
+        || !group->meth->field_mul(group, t2, t0, Y3, ctx)
+        || !group->meth->field_mul(group, Y3, X3, Z3, ctx)
+        || !BN_mod_add_quick(Y3, Y3, t2, p)
+        || !group->meth->field_mul(group, X3, t3, X3, ctx)
+        || !BN_mod_sub_quick(X3, X3, t1, p)
+        || !group->meth->field_mul(group, Z3, t4, Z3, ctx)
+        || !group->meth->field_mul(group, t1, t3, t0, ctx)
+        || !BN_mod_add_quick(Z3, Z3, t1, p))
+        goto err;
+
+    ret = 1;
+
+ err:
+    BN_CTX_end(ctx);
+    return ret;
+}
+
+/*
+ * Copies the entry for |digit| from |row| into |x|, |y| and |z| without
+ * branching or indexing on |digit|. Digit 0 selects the point at
+ * infinity (0 : 1 : 0).
+ */
+static void fb_select(BN_ULONG *x, BN_ULONG *y, BN_ULONG *z,
+                      const BN_ULONG *row, const BN_ULONG *one,
+                      unsigned int digit, int nwords)
+{
+    BN_ULONG mask;
+    unsigned int j;
+    int l;
+
+    memset(x, 0, nwords * sizeof(*x));
+    memset(y, 0, nwords * sizeof(*y));
+    for (j = 1; j <= FB_ROW; j++, row += 2 * nwords) {
+        mask = (BN_ULONG)0 - (constant_time_eq(digit, j) & 1);
+        for (l = 0; l < nwords; l++) {
+            x[l] |= row[l] & mask;
+            y[l] |= row[nwords + l] & mask;
+        }
+    }
+    mask = (BN_ULONG)0 - (constant_time_is_zero(digit) & 1);
+    for (l = 0; l < nwords; l++) {
+        y[l] |= one[l] & mask;
+        z[l] = one[l] & ~mask;
+    }
+}
+
+static int fb_mul(const EC_GROUP *group, const FB_CURVE *c, EC_POINT *r,
+                  const BIGNUM *scalar, BN_CTX *ctx)
+{
+    BN_ULONG k[FB_MAX_WORDS], one[FB_MAX_WORDS];
+    BN_ULONG x[FB_MAX_WORDS], y[FB_MAX_WORDS], z[FB_MAX_WORDS];
+    BIGNUM *kbn, *X, *Y, *Z, *X2, *Y2, *Z2, *X3, *Y3, *Z3;
+    int i, kwords, nwords = c->nwords, ret = 0;
+    unsigned int digit;
+
+    BN_CTX_start(ctx);
+    kbn = BN_CTX_get(ctx);
+    X = BN_CTX_get(ctx);
+    Y = BN_CTX_get(ctx);
+    Z = BN_CTX_get(ctx);
+    X2 = BN_CTX_get(ctx);
+    Y2 = BN_CTX_get(ctx);
+    Z2 = BN_CTX_get(ctx);
+    X3 = BN_CTX_get(ctx);
+    Y3 = BN_CTX_get(ctx);
+    Z3 = BN_CTX_get(ctx);
+    if (Z3 == NULL || !BN_copy(kbn, scalar)) {
+        ECerr(EC_F_EC_GFP_FIXEDBASE_MUL, ERR_R_BN_LIB);
+        goto err;
+    }
+    BN_set_flags(kbn, BN_FLG_CONSTTIME);
+
+    kwords = FB_WORDS(c->nwindows * FB_WINDOW_BITS);
+    if (BN_is_negative(kbn) || bn_get_top(kbn) > kwords
+            || BN_num_bits(kbn) > c->nwindows * FB_WINDOW_BITS) {
+        /* this is an unusual input, and we don't guarantee constant-timeness */
+        if (!BN_nnmod(kbn, kbn, group->order, ctx)) {
+            ECerr(EC_F_EC_GFP_FIXEDBASE_MUL, ERR_R_BN_LIB);
+            goto err;
+        }
+    }
+    if (!bn_copy_words(k, kbn, kwords)
+            || !group->meth->field_set_to_one(group, X, ctx)
+            || !bn_copy_words(one, X, nwords)) {
+        ECerr(EC_F_EC_GFP_FIXEDBASE_MUL, ERR_R_BN_LIB);
+        goto err;
+    }
+
+    /* Start from the point at infinity */
+    BN_zero(X);
+    BN_zero(Z);
+    if (!group->meth->field_set_to_one(group, Y, ctx))
+        goto err;
+
+    for (i = 0; i < c->nwindows; i++) {
+        int bit = i * FB_WINDOW_BITS;
+
+        digit = (unsigned int)(k[bit / BN_BITS2] >> (bit % BN_BITS2))
+                & FB_ROW;
+        fb_select(x, y, z, c->table + (size_t)i * FB_ROW * 2 * nwords, one,
+                  digit, nwords);
+        if (!bn_set_words(X2, x, nwords)
+                || !bn_set_words(Y2, y, nwords)
+                || !bn_set_words(Z2, z, nwords)
+                || !fb_point_add(group, X3, Y3, Z3, X, Y, Z, X2, Y2, Z2, ctx))
+            goto err;
+        BN_swap(X, X3);
+        BN_swap(Y, Y3);
+        BN_swap(Z, Z3);
+    }
+
+    /* Homogeneous (X : Y : Z) is Jacobian (X * Z, Y * Z^2, Z) */
+    if (!group->meth->field_mul(group, r->X, X, Z, ctx)
+            || !group->meth->field_sqr(group, Z2, Z, ctx)
+            || !group->meth->field_mul(group, r->Y, Y, Z2, ctx)
+            || !BN_copy(r->Z, Z))
+        goto err;
+    r->Z_is_one = 0;
+    ret = 1;
+
+ err:
+    OPENSSL_cleanse(k, sizeof(k));
+    OPENSSL_cleanse(x, sizeof(x));
+    OPENSSL_cleanse(y, sizeof(y));
+    OPENSSL_cleanse(z, sizeof(z));
+    BN_CTX_end(ctx);
+    return ret;
+}
+
+int ec_GFp_fixedbase_mul(const EC_GROUP *group, EC_POINT *r,
+                         const BIGNUM *scalar, size_t num,
+                         const EC_POINT *points[], const BIGNUM *scalars[],
+                         BN_CTX *ctx)
+{
+    const FB_CURVE *c;
+
+    if (scalar != NULL && num == 0 && (c = fb_curve(group)) != NULL)
+        return fb_mul(group, c, r, scalar, ctx);
+
+    return ec_wNAF_mul(group, r, scalar, num, points, scalars, ctx);
+}
+
+const EC_METHOD *EC_GFp_fixedbase_method(void)
+{
+    static const EC_METHOD ret = {
+        EC_FLAGS_DEFAULT_OCT,
+        NID_X9_62_prime_field,
+        ec_GFp_mont_group_init,
+        ec_GFp_mont_group_finish,
+        ec_GFp_mont_group_clear_finish,
+        ec_GFp_mont_group_copy,
+        ec_GFp_mont_group_set_curve,
+        ec_GFp_simple_group_get_curve,
+        ec_GFp_simple_group_get_degree,
+        ec_group_simple_order_bits,
+        ec_GFp_simple_group_check_discriminant,
+        ec_GFp_simple_point_init,
+        ec_GFp_simple_point_finish,
+        ec_GFp_simple_point_clear_finish,
+        ec_GFp_simple_point_copy,
+        ec_GFp_simple_point_set_to_infinity,
+        ec_GFp_simple_set_Jprojective_coordinates_GFp,
+        ec_GFp_simple_get_Jprojective_coordinates_GFp,
+        ec_GFp_simple_point_set_affine_coordinates,
+        ec_GFp_simple_point_get_affine_coordinates,
+        0, 0, 0,
+        ec_GFp_simple_add,
+        ec_GFp_simple_dbl,
+        ec_GFp_simple_invert,
+        ec_GFp_simple_is_at_infinity,
+        ec_GFp_simple_is_on_curve,
+        ec_GFp_simple_cmp,
+        ec_GFp_simple_make_affine,
+        ec_GFp_simple_points_make_affine,
+        ec_GFp_fixedbase_mul,
+        ec_wNAF_precompute_mult,
+        ec_wNAF_have_precompute_mult,
+        ec_GFp_mont_field_mul,
+        ec_GFp_mont_field_sqr,
+        0 /* field_div */ ,
+        ec_GFp_mont_field_inv,
+        ec_GFp_mont_field_encode,
+        ec_GFp_mont_field_decode,
+        ec_GFp_mont_field_set_to_one,
+        ec_key_simple_priv2oct,
+        ec_key_simple_oct2priv,
+        0, /* set private */
+        ec_key_simple_generate_key,
+        ec_key_simple_check_key,
+        ec_key_simple_generate_public_key,
+        0, /* keycopy */
+        0, /* keyfinish */
+        ecdh_simple_compute_key,
+        0, /* field_inverse_mod_ord */
+        ec_GFp_simple_blind_coordinates,
+        ec_GFp_simple_ladder_pre,
+        ec_GFp_simple_ladder_step,
+        ec_GFp_simple_ladder_post
+    };
+
+    return &ret;
+}
@@ -10,6 +10,7 @@
 
 #include <openssl/err.h>
 
+#include "crypto/bn.h"
 #include "ec_local.h"
 
 const EC_METHOD *EC_GFp_mont_method(void)
@@ -210,14 +211,13 @@ int ec_GFp_mont_field_sqr(const EC_GROUP *group, BIGNUM *r, const BIGNUM *a,
 /*-
  * Computes the multiplicative inverse of a in GF(p), storing the result in r.
  * If a is zero (or equivalent), you'll get a EC_R_CANNOT_INVERT error.
- * We have a Mont structure, so SCA hardening is FLT inversion.
+ * The divstep inversion is constant time, so no blinding is needed.
  */
 int ec_GFp_mont_field_inv(const EC_GROUP *group, BIGNUM *r, const BIGNUM *a,
                             BN_CTX *ctx)
 {
-    BIGNUM *e = NULL;
     BN_CTX *new_ctx = NULL;
-    int ret = 0;
+    int ret = 0, noinv;
 
     if (group->field_data1 == NULL)
         return 0;
@@ -225,32 +225,16 @@ int ec_GFp_mont_field_inv(const EC_GROUP *group, BIGNUM *r, const BIGNUM *a,
     if (ctx == NULL && (ctx = new_ctx = BN_CTX_secure_new()) == NULL)
         return 0;
 
-    BN_CTX_start(ctx);
-    if ((e = BN_CTX_get(ctx)) == NULL)
-        goto err;
-
-    /* Inverse in constant time with Fermats Little Theorem */
-    if (!BN_set_word(e, 2))
-        goto err;
-    if (!BN_sub(e, group->field, e))
-        goto err;
-    /*-
-     * Exponent e is public.
-     * No need for scatter-gather or BN_FLG_CONSTTIME.
-     */
-    if (!BN_mod_exp_mont(r, a, e, group->field, ctx, group->field_data1))
-        goto err;
-
-    /* throw an error on zero */
-    if (BN_is_zero(r)) {
-        ECerr(EC_F_EC_GFP_MONT_FIELD_INV, EC_R_CANNOT_INVERT);
+    if (!bn_mod_inverse_consttime(r, a, group->field, ctx, &noinv)) {
+        /* throw an error on zero */
+        if (noinv)
+            ECerr(EC_F_EC_GFP_MONT_FIELD_INV, EC_R_CANNOT_INVERT);
         goto err;
     }
 
     ret = 1;
 
   err:
-    BN_CTX_end(ctx);
     BN_CTX_free(new_ctx);
     return ret;
 }
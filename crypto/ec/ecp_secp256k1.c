@@ -0,0 +1,1048 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Scalar multiplication for secp256k1 with the GLV endomorphism.
+ *
+ * p = 2^256 - 2^32 - 977 is 1 mod 3, and the map phi(x, y) = (beta*x, y)
+ * for a cube root of unity beta modulo p multiplies every point by lambda,
+ * a cube root of unity modulo the order n. A scalar k is split into
+ * k1 + k2*lambda with |k1| and |k2| below 2^128 (Gallant, Lambert and
+ * Vanstone, "Faster point multiplication on elliptic curves with efficient
+ * endomorphisms", CRYPTO 2001), so that k*P = k1*P + k2*phi(P) takes half
+ * as many doublings.
+ *
+ * Multiplications of more than one point, u1*G + u2*Q in ECDSA
+ * verification among them, interleave the wNAFs of all the half-length
+ * scalars in a single chain of doublings (Strauss-Shamir). The odd
+ * multiples of G and phi(G) come from a table computed on first use,
+ * those of the other points are computed and made affine per call. This
+ * is variable time, as ec_wNAF_mul() is for the same inputs.
+ *
+ * A single point or the generator alone, as in ECDH, key generation and
+ * signing, is multiplied by recoding both halves into odd signed 4-bit
+ * digits, which have no zero digits to skip. Table entries are selected
+ * by scanning all of them and accumulated with the complete formulas for
+ * a = 0 from Renes, Costello and Batina, "Complete addition formulas for
+ * prime order elliptic curves" (https://eprint.iacr.org/2015/1060,
+ * algorithms 7 and 9), so the sequence of field operations does not
+ * depend on the scalar. As in ecp_fixedbase.c, this says nothing about
+ * the underlying multiprecision arithmetic.
+ *
+ * Groups whose field, curve or order have been changed from secp256k1's
+ * go through ec_wNAF_mul().
+ */
+
+#include <string.h>
+#include <openssl/err.h>
+#include "internal/constant_time.h"
+#include "internal/thread_once.h"
+#include "crypto/bn.h"
+#include "ec_local.h"
+
+#define SK_WORDS        (256 / BN_BITS2)
+
+#define SK_G_WINDOW     7               /* wNAF width for G and phi(G) */
+#define SK_G_ENTRIES    (1 << (SK_G_WINDOW - 1))
+#define SK_P_WINDOW     5               /* wNAF width for other points */
+#define SK_P_ENTRIES    (1 << (SK_P_WINDOW - 1))
+
+#define SK_CT_DIGITS    33              /* odd signed 4-bit digits */
+#define SK_CT_ENTRIES   8               /* 1, 3, ..., 15 times a point */
+
+/* Field, a, b, order, generator x and y, encoded as in the group */
+#define SK_PARAMS       6
+#define SK_CURVE_PARAMS 4
+
+static const unsigned char sk_beta[32] = {
+    0x7A, 0xE9, 0x6A, 0x2B, 0x65, 0x7C, 0x07, 0x10,
+    0x6E, 0x64, 0x47, 0x9E, 0xAC, 0x34, 0x34, 0xE9,
+    0x9C, 0xF0, 0x49, 0x75, 0x12, 0xF5, 0x89, 0x95,
+    0xC1, 0x39, 0x6C, 0x28, 0x71, 0x95, 0x01, 0xEE
+};
+
+static const unsigned char sk_lambda[32] = {
+    0x53, 0x63, 0xAD, 0x4C, 0xC0, 0x5C, 0x30, 0xE0,
+    0xA5, 0x26, 0x1C, 0x02, 0x88, 0x12, 0x64, 0x5A,
+    0x12, 0x2E, 0x22, 0xEA, 0x20, 0x81, 0x66, 0x78,
+    0xDF, 0x02, 0x96, 0x7C, 0x1B, 0x23, 0xBD, 0x72
+};
+
+/*
+ * The reduced basis (a1, b1), (a2, b2) of the lattice of (x, y) with
+ * x + y*lambda = 0 mod n has b2 = a1. k2 is c1*(-b1) + c2*(-b2) and k1 is
+ * k - k2*lambda, where ci is k*gi / 2^384 rounded, for g1 = 2^384*b2 / n
+ * and g2 = 2^384*(-b1) / n rounded.
+ */
+static const unsigned char sk_g1[32] = {
+    0x30, 0x86, 0xD2, 0x21, 0xA7, 0xD4, 0x6B, 0xCD,
+    0xE8, 0x6C, 0x90, 0xE4, 0x92, 0x84, 0xEB, 0x15,
+    0x3D, 0xAA, 0x8A, 0x14, 0x71, 0xE8, 0xCA, 0x7F,
+    0xE8, 0x93, 0x20, 0x9A, 0x45, 0xDB, 0xB0, 0x31
+};
+
+static const unsigned char sk_g2[32] = {
+    0xE4, 0x43, 0x7E, 0xD6, 0x01, 0x0E, 0x88, 0x28,
+    0x6F, 0x54, 0x7F, 0xA9, 0x0A, 0xBF, 0xE4, 0xC4,
+    0x22, 0x12, 0x08, 0xAC, 0x9D, 0xF5, 0x06, 0xC6,
+    0x15, 0x71, 0xB4, 0xAE, 0x8A, 0xC4, 0x7F, 0x71
+};
+
+static const unsigned char sk_minus_b1[32] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xE4, 0x43, 0x7E, 0xD6, 0x01, 0x0E, 0x88, 0x28,
+    0x6F, 0x54, 0x7F, 0xA9, 0x0A, 0xBF, 0xE4, 0xC3
+};
+
+/* n - a1 */
+static const unsigned char sk_minus_b2[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE,
+    0x8A, 0x28, 0x0A, 0xC5, 0x07, 0x74, 0x34, 0x6D,
+    0xD7, 0x65, 0xCD, 0xA8, 0x3D, 0xB1, 0x56, 0x2C
+};
+
+static struct {
+    BN_ULONG params[SK_PARAMS * SK_WORDS];
+    BN_ULONG beta[SK_WORDS];            /* field-encoded */
+    BN_ULONG b3[SK_WORDS];              /* 3*b, field-encoded */
+    BN_ULONG one[SK_WORDS];             /* field-encoded */
+    BN_ULONG half_n[SK_WORDS];          /* (n - 1) / 2 */
+    BN_ULONG g1[SK_WORDS], g2[SK_WORDS];
+    /* Montgomery form modulo n */
+    BN_ULONG lambda[SK_WORDS], minus_b1[SK_WORDS], minus_b2[SK_WORDS];
+    /* Affine odd multiples of G and phi(G), (x, y) field-encoded */
+    BN_ULONG gtable[2][SK_G_ENTRIES * 2 * SK_WORDS];
+} sk;
+
+static CRYPTO_ONCE sk_once = CRYPTO_ONCE_STATIC_INIT;
+
+static int sk_params(const EC_GROUP *group, BN_ULONG *out)
+{
+    if (group->generator == NULL || !group->generator->Z_is_one)
+        return 0;
+    return bn_copy_words(out, group->field, SK_WORDS)
+           && bn_copy_words(out + SK_WORDS, group->a, SK_WORDS)
+           && bn_copy_words(out + 2 * SK_WORDS, group->b, SK_WORDS)
+           && bn_copy_words(out + 3 * SK_WORDS, group->order, SK_WORDS)
+           && bn_copy_words(out + 4 * SK_WORDS, group->generator->X, SK_WORDS)
+           && bn_copy_words(out + 5 * SK_WORDS, group->generator->Y,
+                            SK_WORDS);
+}
+
+static int sk_words(BN_ULONG *out, const unsigned char *bin, BIGNUM *t)
+{
+    return BN_bin2bn(bin, 32, t) != NULL && bn_copy_words(out, t, SK_WORDS);
+}
+
+static int sk_field_words(const EC_GROUP *group, BN_ULONG *out,
+                          const BIGNUM *a, BIGNUM *t, BN_CTX *ctx)
+{
+    return group->meth->field_encode(group, t, a, ctx)
+           && bn_copy_words(out, t, SK_WORDS);
+}
+
+static int sk_mont_words(const EC_GROUP *group, BN_ULONG *out,
+                         const unsigned char *bin, BIGNUM *t, BN_CTX *ctx)
+{
+    return BN_bin2bn(bin, 32, t) != NULL
+           && BN_to_montgomery(t, t, group->mont_data, ctx)
+           && bn_copy_words(out, t, SK_WORDS);
+}
+
+/*
+ * Copies the affine odd multiples of |points[0]|, which are |points|, and
+ * their images under phi to |table| and |phi|.
+ */
+static int sk_table_words(const EC_GROUP *group, BN_ULONG *table,
+                          BN_ULONG *phi, EC_POINT **points, int entries,
+                          BN_CTX *ctx)
+{
+    BIGNUM *beta, *t;
+    int i, ret = 0;
+
+    BN_CTX_start(ctx);
+    beta = BN_CTX_get(ctx);
+    t = BN_CTX_get(ctx);
+    if (t == NULL
+            || !bn_set_words(beta, sk.beta, SK_WORDS)
+            || !EC_POINTs_make_affine(group, entries, points, ctx))
+        goto err;
+    for (i = 0; i < entries; i++, table += 2 * SK_WORDS, phi += 2 * SK_WORDS) {
+        if (!bn_copy_words(table, points[i]->X, SK_WORDS)
+                || !bn_copy_words(table + SK_WORDS, points[i]->Y, SK_WORDS)
+                || !group->meth->field_mul(group, t, points[i]->X, beta, ctx)
+                || !bn_copy_words(phi, t, SK_WORDS))
+            goto err;
+        memcpy(phi + SK_WORDS, table + SK_WORDS, SK_WORDS * sizeof(*phi));
+    }
+    ret = 1;
+
+ err:
+    BN_CTX_end(ctx);
+    return ret;
+}
+
+/* The odd multiples 1*P, 3*P, ..., (2*entries - 1)*P of |P| */
+static int sk_odd_multiples(const EC_GROUP *group, EC_POINT **points,
+                            const EC_POINT *P, int entries, BN_CTX *ctx)
+{
+    EC_POINT *twice;
+    int i, ret = 0;
+
+    if ((twice = EC_POINT_new(group)) == NULL
+            || !EC_POINT_dbl(group, twice, P, ctx))
+        goto err;
+    for (i = 0; i < entries; i++) {
+        if ((points[i] = EC_POINT_new(group)) == NULL
+                || (i == 0 && !EC_POINT_copy(points[i], P))
+                || (i > 0 && !EC_POINT_add(group, points[i], points[i - 1],
+                                           twice, ctx)))
+            goto err;
+    }
+    ret = 1;
+
+ err:
+    EC_POINT_free(twice);
+    return ret;
+}
+
+DEFINE_RUN_ONCE_STATIC(sk_init)
+{
+    EC_GROUP *group = NULL;
+    EC_POINT *points[SK_G_ENTRIES] = { NULL };
+    BN_CTX *ctx = NULL;
+    BIGNUM *t, *u;
+    int i, ok = 0;
+
+    if ((group = EC_GROUP_new_by_curve_name(NID_secp256k1)) == NULL
+            || (ctx = BN_CTX_new()) == NULL)
+        goto err;
+    BN_CTX_start(ctx);
+    t = BN_CTX_get(ctx);
+    u = BN_CTX_get(ctx);
+    if (u == NULL
+            || !sk_params(group, sk.params)
+            || !BN_bin2bn(sk_beta, sizeof(sk_beta), u)
+            || !sk_field_words(group, sk.beta, u, t, ctx)
+            || !BN_set_word(u, 21)
+            || !sk_field_words(group, sk.b3, u, t, ctx)
+            || !BN_one(u)
+            || !sk_field_words(group, sk.one, u, t, ctx)
+            || !BN_rshift1(t, group->order)
+            || !bn_copy_words(sk.half_n, t, SK_WORDS)
+            || !sk_words(sk.g1, sk_g1, t)
+            || !sk_words(sk.g2, sk_g2, t)
+            || !sk_mont_words(group, sk.lambda, sk_lambda, t, ctx)
+            || !sk_mont_words(group, sk.minus_b1, sk_minus_b1, t, ctx)
+            || !sk_mont_words(group, sk.minus_b2, sk_minus_b2, t, ctx)
+            || !sk_odd_multiples(group, points, group->generator,
+                                 SK_G_ENTRIES, ctx)
+            || !sk_table_words(group, sk.gtable[0], sk.gtable[1], points,
+                               SK_G_ENTRIES, ctx))
+        goto err;
+    ok = 1;
+
+ err:
+    for (i = 0; i < SK_G_ENTRIES; i++)
+        EC_POINT_free(points[i]);
+    BN_CTX_end(ctx);
+    BN_CTX_free(ctx);
+    EC_GROUP_free(group);
+    return ok;
+}
+
+/*
+ * Returns 1 if |group| is secp256k1, setting |*gtable| if its generator
+ * is the standard one, or 0 if the group has been changed. A table that
+ * could not be computed is not an error: the caller falls back to the
+ * generic code, so nothing is left on the error queue.
+ */
+static int sk_check(const EC_GROUP *group, int *gtable)
+{
+    BN_ULONG params[SK_PARAMS * SK_WORDS];
+    int ok;
+
+    ERR_set_mark();
+    ok = RUN_ONCE(&sk_once, sk_init) && sk_params(group, params);
+    ERR_pop_to_mark();
+
+    if (!ok || memcmp(params, sk.params,
+                      SK_CURVE_PARAMS * SK_WORDS * sizeof(BN_ULONG)) != 0)
+        return 0;
+    *gtable = memcmp(params, sk.params, sizeof(params)) == 0;
+    return 1;
+}
+
+/* r = a - b, returning the borrow */
+static BN_ULONG sk_sub(BN_ULONG r[SK_WORDS], const BN_ULONG a[SK_WORDS],
+                       const BN_ULONG b[SK_WORDS])
+{
+    BN_ULONG t, borrow = 0;
+    int i;
+
+    for (i = 0; i < SK_WORDS; i++) {
+        t = a[i] - b[i];
+        r[i] = t - borrow;
+        borrow = (a[i] < b[i]) | (t < borrow);
+    }
+    return borrow;
+}
+
+/*
+ * Splits |k|, 0 <= k < n, into k1 + k2*lambda mod n, returning |k1| and
+ * |k2| in |k1| and |k2| and their signs as all-ones masks in |neg|.
+ */
+static int sk_split(const EC_GROUP *group, BN_ULONG k1[SK_WORDS],
+                    BN_ULONG k2[SK_WORDS], BN_ULONG neg[2], const BIGNUM *k,
+                    BN_CTX *ctx)
+{
+    BN_ULONG prod[2 * SK_WORDS], c[SK_WORDS], t[SK_WORDS], carry;
+    const BN_ULONG *n = sk.params + 3 * SK_WORDS;
+    BIGNUM *c1, *c2, *g, *t1, *t2;
+    BN_ULONG *out;
+    int i, j, ret = 0;
+
+    BN_CTX_start(ctx);
+    c1 = BN_CTX_get(ctx);
+    c2 = BN_CTX_get(ctx);
+    g = BN_CTX_get(ctx);
+    t1 = BN_CTX_get(ctx);
+    t2 = BN_CTX_get(ctx);
+    if (t2 == NULL)
+        goto err;
+    BN_set_flags(c1, BN_FLG_CONSTTIME);
+    BN_set_flags(c2, BN_FLG_CONSTTIME);
+    BN_set_flags(t1, BN_FLG_CONSTTIME);
+    BN_set_flags(t2, BN_FLG_CONSTTIME);
+
+    /* ci = k*gi / 2^384, rounded */
+    for (i = 0; i < 2; i++) {
+        if (!bn_set_words(g, i == 0 ? sk.g1 : sk.g2, SK_WORDS)
+                || !bn_mul_fixed_top(t1, k, g, ctx)
+                || !bn_copy_words(prod, t1, 2 * SK_WORDS))
+            goto err;
+        carry = (prod[383 / BN_BITS2] >> (383 % BN_BITS2)) & 1;
+        memset(c, 0, sizeof(c));
+        for (j = 0; j < 128 / BN_BITS2; j++) {
+            c[j] = prod[384 / BN_BITS2 + j] + carry;
+            carry = c[j] < carry;
+        }
+        c[j] = carry;
+        if (!bn_set_words(i == 0 ? c1 : c2, c, SK_WORDS))
+            goto err;
+    }
+
+    /* k2 = c1*(-b1) + c2*(-b2), k1 = k - k2*lambda */
+    if (!bn_set_words(g, sk.minus_b1, SK_WORDS)
+            || !bn_mul_mont_fixed_top(t1, c1, g, group->mont_data, ctx)
+            || !bn_set_words(g, sk.minus_b2, SK_WORDS)
+            || !bn_mul_mont_fixed_top(t2, c2, g, group->mont_data, ctx)
+            || !bn_mod_add_fixed_top(c2, t1, t2, group->order)
+            || !bn_set_words(g, sk.lambda, SK_WORDS)
+            || !bn_mul_mont_fixed_top(t1, c2, g, group->mont_data, ctx)
+            || !bn_mod_sub_fixed_top(c1, k, t1, group->order)
+            || !bn_copy_words(k1, c1, SK_WORDS)
+            || !bn_copy_words(k2, c2, SK_WORDS))
+        goto err;
+
+    /* Halves above n/2 are negative */
+    for (i = 0; i < 2; i++) {
+        out = i == 0 ? k1 : k2;
+        neg[i] = (BN_ULONG)0 - sk_sub(t, sk.half_n, out);
+        sk_sub(c, n, out);
+        for (j = 0; j < SK_WORDS; j++)
+            out[j] = (c[j] & neg[i]) | (out[j] & ~neg[i]);
+    }
+    ret = 1;
+
+ err:
+    OPENSSL_cleanse(prod, sizeof(prod));
+    OPENSSL_cleanse(c, sizeof(c));
+    BN_CTX_end(ctx);
+    return ret;
+}
+
+/*-
+ * (X, Y, Z) := 2 * (X, Y, Z) in Jacobian coordinates for a = 0, which
+ * is dbl-2009-l of the Explicit-Formulas Database. The point must not be
+ * at infinity.
+ */
+static int sk_dbl(const EC_GROUP *group, BIGNUM *X, BIGNUM *Y, BIGNUM *Z,
+                  BN_CTX *ctx)
+{
+    const BIGNUM *p = group->field;
+    BIGNUM *A, *B, *C, *D;
+    int ret = 0;
+
+    BN_CTX_start(ctx);
+    A = BN_CTX_get(ctx);
+    B = BN_CTX_get(ctx);
+    C = BN_CTX_get(ctx);
+    D = BN_CTX_get(ctx);
+
+    if (D == NULL
+        || !group->meth->field_sqr(group, A, X, ctx)
+        || !group->meth->field_sqr(group, B, Y, ctx)
+        || !group->meth->field_sqr(group, C, B, ctx)
+        || !group->meth->field_mul(group, Z, Y, Z, ctx)
+        || !BN_mod_lshift1_quick(Z, Z, p)
+        || !BN_mod_add_quick(D, X, B, p)
+        || !group->meth->field_sqr(group, D, D, ctx)
+        || !BN_mod_sub_quick(D, D, A, p)
+        || !BN_mod_sub_quick(D, D, C, p)
+        || !BN_mod_lshift1_quick(D, D, p)
+        || !BN_mod_lshift1_quick(B, A, p)
+        || !BN_mod_add_quick(A, A, B, p)
+        || !group->meth->field_sqr(group, B, A, ctx)
+        || !BN_mod_lshift1_quick(X, D, p)
+        || !BN_mod_sub_quick(X, B, X, p)
+        || !BN_mod_sub_quick(D, D, X, p)
+        || !group->meth->field_mul(group, Y, A, D, ctx)
+        || !BN_mod_lshift_quick(C, C, 3, p)
+        || !BN_mod_sub_quick(Y, Y, C, p))
+        goto err;
+    ret = 1;
+
+ err:
+    BN_CTX_end(ctx);
+    return ret;
+}
+
+/*-
+ * (X, Y, Z) := (X, Y, Z) + (x, y, 1) in Jacobian coordinates, which is
+ * madd-2007-bl of the Explicit-Formulas Database. Sets |*infinity| if
+ * the sum is the point at infinity. The first point must not be.
+ */
+static int sk_add_affine(const EC_GROUP *group, BIGNUM *X, BIGNUM *Y,
+                         BIGNUM *Z, const BIGNUM *x, const BIGNUM *y,
+                         int *infinity, BN_CTX *ctx)
+{
+    const BIGNUM *p = group->field;
+    BIGNUM *ZZ, *H, *r, *HH, *I, *J;
+    int ret = 0;
+
+    BN_CTX_start(ctx);
+    ZZ = BN_CTX_get(ctx);
+    H = BN_CTX_get(ctx);
+    r = BN_CTX_get(ctx);
+    HH = BN_CTX_get(ctx);
+    I = BN_CTX_get(ctx);
+    J = BN_CTX_get(ctx);
+
+    if (J == NULL
+        || !group->meth->field_sqr(group, ZZ, Z, ctx)
+        || !group->meth->field_mul(group, H, x, ZZ, ctx)
+        || !BN_mod_sub_quick(H, H, X, p)
+        || !group->meth->field_mul(group, r, Z, ZZ, ctx)
+        || !group->meth->field_mul(group, r, y, r, ctx)
+        || !BN_mod_sub_quick(r, r, Y, p)
+        || !BN_mod_lshift1_quick(r, r, p))
+        goto err;
+
+    if (BN_is_zero(H)) {
+        if (BN_is_zero(r)) {
+            ret = sk_dbl(group, X, Y, Z, ctx);
+        } else {
+            *infinity = 1;
+            ret = 1;
+        }
+        goto err;
+    }
+
+    if (!group->meth->field_sqr(group, HH, H, ctx)
+        || !BN_mod_lshift_quick(I, HH, 2, p)
+        || !group->meth->field_mul(group, J, H, I, ctx)
+        || !group->meth->field_mul(group, I, X, I, ctx)
+        || !group->meth->field_sqr(group, X, r, ctx)
+        || !BN_mod_sub_quick(X, X, J, p)
+        || !BN_mod_sub_quick(X, X, I, p)
+        || !BN_mod_sub_quick(X, X, I, p)
+        || !BN_mod_sub_quick(I, I, X, p)
+        || !group->meth->field_mul(group, I, r, I, ctx)
+        || !group->meth->field_mul(group, J, Y, J, ctx)
+        || !BN_mod_lshift1_quick(J, J, p)
+        || !BN_mod_sub_quick(Y, I, J, p)
+        || !BN_mod_add_quick(Z, Z, H, p)
+        || !group->meth->field_sqr(group, Z, Z, ctx)
+        || !BN_mod_sub_quick(Z, Z, ZZ, p)
+        || !BN_mod_sub_quick(Z, Z, HH, p))
+        goto err;
+    ret = 1;
+
+ err:
+    BN_CTX_end(ctx);
+    return ret;
+}
+
+typedef struct {
+    const BN_ULONG *table;      /* affine odd multiples, (x, y) */
+    signed char *wnaf;
+    size_t len;
+} SK_TERM;
+
+static int sk_mul_strauss(const EC_GROUP *group, EC_POINT *r,
+                          const BIGNUM *scalar, size_t num,
+                          const EC_POINT *points[], const BIGNUM *scalars[],
+                          int gtable, BN_CTX *ctx)
+{
+    BN_ULONG k1[SK_WORDS], k2[SK_WORDS], neg[2];
+    EC_POINT *multiples[SK_P_ENTRIES] = { NULL };
+    const EC_POINT *P;
+    const BIGNUM *k;
+    BIGNUM *kr, *h, *X, *Y, *Z, *x, *y;
+    BN_ULONG *tables = NULL;
+    SK_TERM *terms = NULL;
+    size_t i, j, nterms = 0, ntables = 0, maxlen = 0;
+    int d, w, infinity = 1, ret = 0;
+
+    BN_CTX_start(ctx);
+    kr = BN_CTX_get(ctx);
+    h = BN_CTX_get(ctx);
+    X = BN_CTX_get(ctx);
+    Y = BN_CTX_get(ctx);
+    Z = BN_CTX_get(ctx);
+    x = BN_CTX_get(ctx);
+    y = BN_CTX_get(ctx);
+    if (y == NULL) {
+        ECerr(EC_F_EC_GFP_SECP256K1_MUL, ERR_R_BN_LIB);
+        goto err;
+    }
+
+    terms = OPENSSL_zalloc(2 * (num + 1) * sizeof(*terms));
+    tables = OPENSSL_malloc(2 * (num + 1) * SK_P_ENTRIES * 2 * SK_WORDS
+                            * sizeof(*tables));
+    if (terms == NULL || tables == NULL) {
+        ECerr(EC_F_EC_GFP_SECP256K1_MUL, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+
+    for (i = 0; i <= num; i++) {
+        if (i < num) {
+            P = points[i];
+            k = scalars[i];
+        } else if (scalar != NULL) {
+            P = group->generator;
+            k = scalar;
+        } else {
+            break;
+        }
+        if (EC_POINT_is_at_infinity(group, P))
+            continue;
+
+        if (BN_is_negative(k) || BN_ucmp(k, group->order) >= 0) {
+            if (!BN_nnmod(kr, k, group->order, ctx)) {
+                ECerr(EC_F_EC_GFP_SECP256K1_MUL, ERR_R_BN_LIB);
+                goto err;
+            }
+            k = kr;
+        }
+        if (!sk_split(group, k1, k2, neg, k, ctx)) {
+            ECerr(EC_F_EC_GFP_SECP256K1_MUL, ERR_R_BN_LIB);
+            goto err;
+        }
+
+        if (i == num && gtable) {
+            terms[nterms].table = sk.gtable[0];
+            terms[nterms + 1].table = sk.gtable[1];
+            w = SK_G_WINDOW;
+        } else {
+            BN_ULONG *t = tables + ntables * SK_P_ENTRIES * 2 * SK_WORDS;
+
+            if (!sk_odd_multiples(group, multiples, P, SK_P_ENTRIES, ctx)
+                    || !sk_table_words(group, t,
+                                       t + SK_P_ENTRIES * 2 * SK_WORDS,
+                                       multiples, SK_P_ENTRIES, ctx))
+                goto err;
+            for (j = 0; j < SK_P_ENTRIES; j++) {
+                EC_POINT_free(multiples[j]);
+                multiples[j] = NULL;
+            }
+            terms[nterms].table = t;
+            terms[nterms + 1].table = t + SK_P_ENTRIES * 2 * SK_WORDS;
+            ntables += 2;
+            w = SK_P_WINDOW;
+        }
+
+        for (j = 0; j < 2; j++, nterms++) {
+            if (!bn_set_words(h, j == 0 ? k1 : k2, SK_WORDS))
+                goto err;
+            BN_set_negative(h, neg[j] != 0);
+            if ((terms[nterms].wnaf = bn_compute_wNAF(h, w,
+                                                      &terms[nterms].len))
+                    == NULL)
+                goto err;
+            if (terms[nterms].len > maxlen)
+                maxlen = terms[nterms].len;
+        }
+    }
+
+    for (i = maxlen; i-- > 0;) {
+        if (!infinity && !sk_dbl(group, X, Y, Z, ctx))
+            goto err;
+        for (j = 0; j < nterms; j++) {
+            const BN_ULONG *e;
+
+            if (i >= terms[j].len || (d = terms[j].wnaf[i]) == 0)
+                continue;
+            e = terms[j].table + ((d < 0 ? -d : d) >> 1) * 2 * SK_WORDS;
+            if (!bn_set_words(x, e, SK_WORDS)
+                    || !bn_set_words(y, e + SK_WORDS, SK_WORDS)
+                    || (d < 0 && !BN_usub(y, group->field, y)))
+                goto err;
+            if (infinity) {
+                if (!BN_copy(X, x) || !BN_copy(Y, y)
+                        || !group->meth->field_set_to_one(group, Z, ctx))
+                    goto err;
+                infinity = 0;
+            } else if (!sk_add_affine(group, X, Y, Z, x, y, &infinity,
+                                      ctx)) {
+                goto err;
+            }
+        }
+    }
+
+    if (infinity) {
+        ret = EC_POINT_set_to_infinity(group, r);
+    } else {
+        if (!BN_copy(r->X, X) || !BN_copy(r->Y, Y) || !BN_copy(r->Z, Z))
+            goto err;
+        r->Z_is_one = 0;
+        ret = 1;
+    }
+
+ err:
+    for (j = 0; j < SK_P_ENTRIES; j++)
+        EC_POINT_free(multiples[j]);
+    if (terms != NULL) {
+        for (j = 0; j < nterms; j++)
+            OPENSSL_free(terms[j].wnaf);
+        OPENSSL_free(terms);
+    }
+    OPENSSL_free(tables);
+    BN_CTX_end(ctx);
+    return ret;
+}
+
+/*-
+ * (X3, Y3, Z3) := (X1, Y1, Z1) + (X2, Y2, Z2) in homogeneous projective
+ * coordinates for a = 0, for any two points including the point at
+ * infinity. The outputs must not alias the inputs.
+ */
+static int sk_point_add(const EC_GROUP *group, const BIGNUM *b3,
+                        BIGNUM *X3, BIGNUM *Y3, BIGNUM *Z3,
+                        const BIGNUM *X1, const BIGNUM *Y1, const BIGNUM *Z1,
+                        const BIGNUM *X2, const BIGNUM *Y2, const BIGNUM *Z2,
+                        BN_CTX *ctx)
+{
+    const BIGNUM *p = group->field;
+    BIGNUM *t0, *t1, *t2, *t3, *t4;
+    int ret = 0;
+
+    BN_CTX_start(ctx);
+    t0 = BN_CTX_get(ctx);
+    t1 = BN_CTX_get(ctx);
+    t2 = BN_CTX_get(ctx);
+    t3 = BN_CTX_get(ctx);
+    t4 = BN_CTX_get(ctx);
+
+    if (t4 == NULL
+        || !group->meth->field_mul(group, t0, X1, X2, ctx)
+        || !group->meth->field_mul(group, t1, Y1, Y2, ctx)
+        || !group->meth->field_mul(group, t2, Z1, Z2, ctx)
+        || !BN_mod_add_quick(t3, X1, Y1, p)
+        || !BN_mod_add_quick(t4, X2, Y2, p)
+        || !group->meth->field_mul(group, t3, t3, t4, ctx)
+        || !BN_mod_add_quick(t4, t0, t1, p)
+        || !BN_mod_sub_quick(t3, t3, t4, p)
+        || !BN_mod_add_quick(t4, Y1, Z1, p)
+        || !BN_mod_add_quick(X3, Y2, Z2, p)
+        || !group->meth->field_mul(group, t4, t4, X3, ctx)
+        || !BN_mod_add_quick(X3, t1, t2, p)
+        || !BN_mod_sub_quick(t4, t4, X3, p)
+        || !BN_mod_add_quick(X3, X1, Z1, p)
+        || !BN_mod_add_quick(Y3, X2, Z2, p)
+        || !group->meth->field_mul(group, X3, X3, Y3, ctx)
+        || !BN_mod_add_quick(Y3, t0, t2, p)
+        || !BN_mod_sub_quick(Y3, X3, Y3, p)
+        || !BN_mod_lshift1_quick(X3, t0, p)
+        || !BN_mod_add_quick(t0, X3, t0, p)
+        || !group->meth->field_mul(group, t2, b3, t2, ctx)
+        || !BN_mod_add_quick(Z3, t1, t2, p)
+        || !BN_mod_sub_quick(t1, t1, t2, p)
+        || !group->meth->field_mul(group, Y3, b3, Y3, ctx)
+        || !group->meth->field_mul(group, X3, t4, Y3, ctx)
+        || !group->meth->field_mul(group, t2, t3, t1, ctx)
+        || !BN_mod_sub_quick(X3, t2, X3, p)
+        || !group->meth->field_mul(group, Y3, Y3, t0, ctx)
+        || !group->meth->field_mul(group, t1, t1, Z3, ctx)
+        || !BN_mod_add_quick(Y3, t1, Y3, p)
+        || !group->meth->field_mul(group, t0, t0, t3, ctx)
+        || !group->meth->field_mul(group, Z3, Z3, t4, ctx)
+        || !BN_mod_add_quick(Z3, Z3, t0, p))
+        goto err;
+    ret = 1;
+
+ err:
+    BN_CTX_end(ctx);
+    return ret;
+}
+
+/*-
+ * (X3, Y3, Z3) := 2 * (X, Y, Z) in homogeneous projective coordinates
+ * for a = 0, for any point including the point at infinity. The outputs
+ * must not alias the inputs.
+ */
+static int sk_point_dbl(const EC_GROUP *group, const BIGNUM *b3,
+                        BIGNUM *X3, BIGNUM *Y3, BIGNUM *Z3,
+                        const BIGNUM *X, const BIGNUM *Y, const BIGNUM *Z,
+                        BN_CTX *ctx)
+{
+    const BIGNUM *p = group->field;
+    BIGNUM *t0, *t1, *t2;
+    int ret = 0;
+
+    BN_CTX_start(ctx);
+    t0 = BN_CTX_get(ctx);
+    t1 = BN_CTX_get(ctx);
+    t2 = BN_CTX_get(ctx);
+
+    if (t2 == NULL
+        || !group->meth->field_sqr(group, t0, Y, ctx)
+        || !BN_mod_lshift_quick(Z3, t0, 3, p)
+        || !group->meth->field_mul(group, t1, Y, Z, ctx)
+        || !group->meth->field_sqr(group, t2, Z, ctx)
+        || !group->meth->field_mul(group, t2, b3, t2, ctx)
+        || !group->meth->field_mul(group, X3, t2, Z3, ctx)
+        || !BN_mod_add_quick(Y3, t0, t2, p)
+        || !group->meth->field_mul(group, Z3, t1, Z3, ctx)
+        || !BN_mod_lshift1_quick(t1, t2, p)
+        || !BN_mod_add_quick(t2, t1, t2, p)
+        || !BN_mod_sub_quick(t0, t0, t2, p)
+        || !group->meth->field_mul(group, Y3, t0, Y3, ctx)
+        || !BN_mod_add_quick(Y3, X3, Y3, p)
+        || !group->meth->field_mul(group, t1, X, Y, ctx)
+        || !group->meth->field_mul(group, X3, t0, t1, ctx)
+        || !BN_mod_lshift1_quick(X3, X3, p))
+        goto err;
+    ret = 1;
+
+ err:
+    BN_CTX_end(ctx);
+    return ret;
+}
+
+/* |y| or p - |y| as |neg| is zero or all ones; |y| must not be zero */
+static void sk_cneg(BN_ULONG *out, const BN_ULONG *y, BN_ULONG neg)
+{
+    BN_ULONG t[SK_WORDS];
+    int i;
+
+    sk_sub(t, sk.params, y);
+    for (i = 0; i < SK_WORDS; i++)
+        out[i] = (t[i] & neg) | (y[i] & ~neg);
+}
+
+/*
+ * Copies |digit| times the point of |table|, which holds its homogeneous
+ * odd multiples, into |out| without branching or indexing on |digit|.
+ */
+static void sk_select(BN_ULONG out[3 * SK_WORDS], const BN_ULONG *table,
+                      int digit)
+{
+    unsigned int sign = 0 - ((unsigned int)digit >> (sizeof(int) * 8 - 1));
+    unsigned int idx = (((unsigned int)digit ^ sign) - sign) >> 1;
+    BN_ULONG mask;
+    unsigned int j;
+    int l;
+
+    memset(out, 0, 3 * SK_WORDS * sizeof(*out));
+    for (j = 0; j < SK_CT_ENTRIES; j++, table += 3 * SK_WORDS) {
+        mask = (BN_ULONG)0 - (constant_time_eq(idx, j) & 1);
+        for (l = 0; l < 3 * SK_WORDS; l++)
+            out[l] |= table[l] & mask;
+    }
+    sk_cneg(out + SK_WORDS, out + SK_WORDS, (BN_ULONG)0 - (sign & 1));
+}
+
+/*
+ * Recodes |k|, which must be odd and below 2^132, into SK_CT_DIGITS odd
+ * digits between -15 and 15, least significant first.
+ */
+static void sk_recode(signed char digits[SK_CT_DIGITS],
+                      const BN_ULONG k[SK_WORDS])
+{
+    BN_ULONG s[SK_WORDS];
+    int i, j;
+
+    memcpy(s, k, sizeof(s));
+    for (i = 0; i < SK_CT_DIGITS - 1; i++) {
+        digits[i] = (signed char)((int)(s[0] & 31) - 16);
+        /* (s - digit) / 16, which is odd again */
+        for (j = 0; j < SK_WORDS - 1; j++)
+            s[j] = (s[j] >> 4) | (s[j + 1] << (BN_BITS2 - 4));
+        s[j] >>= 4;
+        s[0] |= 1;
+    }
+    digits[i] = (signed char)s[0];
+    OPENSSL_cleanse(s, sizeof(s));
+}
+
+static int sk_mul_ct(const EC_GROUP *group, EC_POINT *r,
+                     const BIGNUM *scalar, const EC_POINT *point,
+                     BN_CTX *ctx)
+{
+    BN_ULONG k[2][SK_WORDS], neg[2], even[2];
+    BN_ULONG x[SK_WORDS], y[SK_WORDS], yk[2][SK_WORDS];
+    BN_ULONG table[2][SK_CT_ENTRIES * 3 * SK_WORDS], e[3 * SK_WORDS];
+    signed char digits[2][SK_CT_DIGITS];
+    BIGNUM *kbn, *b3, *beta, *X, *Y, *Z, *X2, *Y2, *Z2, *X3, *Y3, *Z3;
+    EC_POINT *affine = NULL;
+    BN_ULONG *t;
+    int i, j, h, ret = 0;
+
+    if (EC_POINT_is_at_infinity(group, point))
+        return EC_POINT_set_to_infinity(group, r);
+
+    BN_CTX_start(ctx);
+    kbn = BN_CTX_get(ctx);
+    b3 = BN_CTX_get(ctx);
+    beta = BN_CTX_get(ctx);
+    X = BN_CTX_get(ctx);
+    Y = BN_CTX_get(ctx);
+    Z = BN_CTX_get(ctx);
+    X2 = BN_CTX_get(ctx);
+    Y2 = BN_CTX_get(ctx);
+    Z2 = BN_CTX_get(ctx);
+    X3 = BN_CTX_get(ctx);
+    Y3 = BN_CTX_get(ctx);
+    Z3 = BN_CTX_get(ctx);
+    if (Z3 == NULL || !BN_copy(kbn, scalar)
+            || !bn_set_words(b3, sk.b3, SK_WORDS)
+            || !bn_set_words(beta, sk.beta, SK_WORDS)) {
+        ECerr(EC_F_EC_GFP_SECP256K1_MUL, ERR_R_BN_LIB);
+        goto err;
+    }
+    BN_set_flags(kbn, BN_FLG_CONSTTIME);
+
+    if (BN_is_negative(kbn) || BN_ucmp(kbn, group->order) >= 0) {
+        /* this is an unusual input, and we don't guarantee constant-timeness */
+        if (!BN_nnmod(kbn, kbn, group->order, ctx)) {
+            ECerr(EC_F_EC_GFP_SECP256K1_MUL, ERR_R_BN_LIB);
+            goto err;
+        }
+    }
+    if (!sk_split(group, k[0], k[1], neg, kbn, ctx)) {
+        ECerr(EC_F_EC_GFP_SECP256K1_MUL, ERR_R_BN_LIB);
+        goto err;
+    }
+
+    /* Make both halves odd, to take the point back off at the end */
+    for (h = 0; h < 2; h++) {
+        even[h] = (BN_ULONG)0 - ((k[h][0] & 1) ^ 1);
+        k[h][0] |= 1;
+        sk_recode(digits[h], k[h]);
+    }
+
+    /* The point is public: its affine coordinates may take variable time */
+    if (point->Z_is_one) {
+        if (!bn_copy_words(x, point->X, SK_WORDS)
+                || !bn_copy_words(y, point->Y, SK_WORDS))
+            goto err;
+    } else {
+        if ((affine = EC_POINT_dup(point, group)) == NULL
+                || !EC_POINT_make_affine(group, affine, ctx)
+                || !bn_copy_words(x, affine->X, SK_WORDS)
+                || !bn_copy_words(y, affine->Y, SK_WORDS))
+            goto err;
+    }
+
+    /* table[0] holds the odd multiples of +-P, table[1] those of +-phi(P) */
+    sk_cneg(yk[0], y, neg[0]);
+    sk_cneg(yk[1], y, neg[1]);
+    if (!bn_set_words(X, x, SK_WORDS)
+            || !bn_set_words(Y, yk[0], SK_WORDS)
+            || !bn_set_words(Z, sk.one, SK_WORDS)
+            || !sk_point_dbl(group, b3, X2, Y2, Z2, X, Y, Z, ctx))
+        goto err;
+    t = table[0];
+    for (i = 0; i < SK_CT_ENTRIES; i++, t += 3 * SK_WORDS) {
+        if (i > 0) {
+            if (!sk_point_add(group, b3, X3, Y3, Z3, X, Y, Z, X2, Y2, Z2,
+                              ctx))
+                goto err;
+            BN_swap(X, X3);
+            BN_swap(Y, Y3);
+            BN_swap(Z, Z3);
+        }
+        if (!bn_copy_words(t, X, SK_WORDS)
+                || !bn_copy_words(t + SK_WORDS, Y, SK_WORDS)
+                || !bn_copy_words(t + 2 * SK_WORDS, Z, SK_WORDS)
+                || !group->meth->field_mul(group, X3, X, beta, ctx)
+                || !bn_copy_words(table[1] + i * 3 * SK_WORDS, X3, SK_WORDS))
+            goto err;
+        sk_cneg(table[1] + i * 3 * SK_WORDS + SK_WORDS, t + SK_WORDS,
+                neg[0] ^ neg[1]);
+        memcpy(table[1] + i * 3 * SK_WORDS + 2 * SK_WORDS, t + 2 * SK_WORDS,
+               SK_WORDS * sizeof(BN_ULONG));
+    }
+
+    /* Start from the point at infinity */
+    BN_zero(X);
+    BN_zero(Z);
+    if (!bn_set_words(Y, sk.one, SK_WORDS))
+        goto err;
+
+    for (i = SK_CT_DIGITS - 1; i >= 0; i--) {
+        for (j = 0; i < SK_CT_DIGITS - 1 && j < 4; j++) {
+            if (!sk_point_dbl(group, b3, X3, Y3, Z3, X, Y, Z, ctx))
+                goto err;
+            BN_swap(X, X3);
+            BN_swap(Y, Y3);
+            BN_swap(Z, Z3);
+        }
+        for (h = 0; h < 2; h++) {
+            sk_select(e, table[h], digits[h][i]);
+            if (!bn_set_words(X2, e, SK_WORDS)
+                    || !bn_set_words(Y2, e + SK_WORDS, SK_WORDS)
+                    || !bn_set_words(Z2, e + 2 * SK_WORDS, SK_WORDS)
+                    || !sk_point_add(group, b3, X3, Y3, Z3, X, Y, Z,
+                                     X2, Y2, Z2, ctx))
+                goto err;
+            BN_swap(X, X3);
+            BN_swap(Y, Y3);
+            BN_swap(Z, Z3);
+        }
+    }
+
+    /* Subtract +-P and +-phi(P) for the halves that were even */
+    for (h = 0; h < 2; h++) {
+        memcpy(e, table[h], 3 * SK_WORDS * sizeof(BN_ULONG));
+        sk_cneg(e + SK_WORDS, e + SK_WORDS, ~(BN_ULONG)0);
+        for (j = 0; j < SK_WORDS; j++) {
+            e[j] &= even[h];
+            e[SK_WORDS + j] = (e[SK_WORDS + j] & even[h])
+                              | (sk.one[j] & ~even[h]);
+            e[2 * SK_WORDS + j] &= even[h];
+        }
+        if (!bn_set_words(X2, e, SK_WORDS)
+                || !bn_set_words(Y2, e + SK_WORDS, SK_WORDS)
+                || !bn_set_words(Z2, e + 2 * SK_WORDS, SK_WORDS)
+                || !sk_point_add(group, b3, X3, Y3, Z3, X, Y, Z, X2, Y2, Z2,
+                                 ctx))
+            goto err;
+        BN_swap(X, X3);
+        BN_swap(Y, Y3);
+        BN_swap(Z, Z3);
+    }
+
+    /* Homogeneous (X : Y : Z) is Jacobian (X * Z, Y * Z^2, Z) */
+    if (!group->meth->field_mul(group, r->X, X, Z, ctx)
+            || !group->meth->field_sqr(group, Z2, Z, ctx)
+            || !group->meth->field_mul(group, r->Y, Y, Z2, ctx)
+            || !BN_copy(r->Z, Z))
+        goto err;
+    r->Z_is_one = 0;
+    ret = 1;
+
+ err:
+    EC_POINT_free(affine);
+    OPENSSL_cleanse(k, sizeof(k));
+    OPENSSL_cleanse(neg, sizeof(neg));
+    OPENSSL_cleanse(even, sizeof(even));
+    OPENSSL_cleanse(yk, sizeof(yk));
+    OPENSSL_cleanse(table, sizeof(table));
+    OPENSSL_cleanse(e, sizeof(e));
+    OPENSSL_cleanse(digits, sizeof(digits));
+    BN_CTX_end(ctx);
+    return ret;
+}
+
+int ec_GFp_secp256k1_mul(const EC_GROUP *group, EC_POINT *r,
+                         const BIGNUM *scalar, size_t num,
+                         const EC_POINT *points[], const BIGNUM *scalars[],
+                         BN_CTX *ctx)
+{
+    int gtable;
+
+    if ((scalar != NULL && group->generator == NULL)
+            || !sk_check(group, &gtable))
+        return ec_wNAF_mul(group, r, scalar, num, points, scalars, ctx);
+
+    /* The single-point cases that ec_wNAF_mul() gives to the ladder */
+    if (scalar != NULL && num == 0)
+        return sk_mul_ct(group, r, scalar, group->generator, ctx);
+    if (scalar == NULL && num == 1)
+        return sk_mul_ct(group, r, scalars[0], points[0], ctx);
+
+    return sk_mul_strauss(group, r, scalar, num, points, scalars, gtable,
+                          ctx);
+}
+
+const EC_METHOD *EC_GFp_secp256k1_method(void)
+{
+    static const EC_METHOD ret = {
+        EC_FLAGS_DEFAULT_OCT,
+        NID_X9_62_prime_field,
+        ec_GFp_mont_group_init,
+        ec_GFp_mont_group_finish,
+        ec_GFp_mont_group_clear_finish,
+        ec_GFp_mont_group_copy,
+        ec_GFp_mont_group_set_curve,
+        ec_GFp_simple_group_get_curve,
+        ec_GFp_simple_group_get_degree,
+        ec_group_simple_order_bits,
+        ec_GFp_simple_group_check_discriminant,
+        ec_GFp_simple_point_init,
+        ec_GFp_simple_point_finish,
+        ec_GFp_simple_point_clear_finish,
+        ec_GFp_simple_point_copy,
+        ec_GFp_simple_point_set_to_infinity,
+        ec_GFp_simple_set_Jprojective_coordinates_GFp,
+        ec_GFp_simple_get_Jprojective_coordinates_GFp,
+        ec_GFp_simple_point_set_affine_coordinates,
+        ec_GFp_simple_point_get_affine_coordinates,
+        0, 0, 0,
+        ec_GFp_simple_add,
+        ec_GFp_simple_dbl,
+        ec_GFp_simple_invert,
+        ec_GFp_simple_is_at_infinity,
+        ec_GFp_simple_is_on_curve,
+        ec_GFp_simple_cmp,
+        ec_GFp_simple_make_affine,
+        ec_GFp_simple_points_make_affine,
+        ec_GFp_secp256k1_mul,
+        0 /* precompute_mult */ ,
+        0 /* have_precompute_mult */ ,
+        ec_GFp_mont_field_mul,
+        ec_GFp_mont_field_sqr,
+        0 /* field_div */ ,
+        ec_GFp_mont_field_inv,
+        ec_GFp_mont_field_encode,
+        ec_GFp_mont_field_decode,
+        ec_GFp_mont_field_set_to_one,
+        ec_key_simple_priv2oct,
+        ec_key_simple_oct2priv,
+        0, /* set private */
+        ec_key_simple_generate_key,
+        ec_key_simple_check_key,
+        ec_key_simple_generate_public_key,
+        0, /* keycopy */
+        0, /* keyfinish */
+        ecdh_simple_compute_key,
+        0, /* field_inverse_mod_ord */
+        ec_GFp_simple_blind_coordinates,
+        ec_GFp_simple_ladder_pre,
+        ec_GFp_simple_ladder_step,
+        ec_GFp_simple_ladder_post
+    };
+
+    return &ret;
+}
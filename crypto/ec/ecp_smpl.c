@@ -11,6 +11,7 @@
 #include <openssl/err.h>
 #include <openssl/symhacks.h>
 
+#include "crypto/bn.h"
 #include "ec_local.h"
 
 const EC_METHOD *EC_GFp_simple_method(void)
@@ -1371,44 +1372,26 @@ int ec_GFp_simple_field_sqr(const EC_GROUP *group, BIGNUM *r, const BIGNUM *a,
 /*-
  * Computes the multiplicative inverse of a in GF(p), storing the result in r.
  * If a is zero (or equivalent), you'll get a EC_R_CANNOT_INVERT error.
- * Since we don't have a Mont structure here, SCA hardening is with blinding.
- * NB: "a" must be in _decoded_ form. (i.e. field_decode must precede.)
+ * The divstep inversion is constant time, so no blinding is needed.
  */
 int ec_GFp_simple_field_inv(const EC_GROUP *group, BIGNUM *r, const BIGNUM *a,
                             BN_CTX *ctx)
 {
-    BIGNUM *e = NULL;
     BN_CTX *new_ctx = NULL;
-    int ret = 0;
+    int ret = 0, noinv;
 
     if (ctx == NULL && (ctx = new_ctx = BN_CTX_secure_new()) == NULL)
         return 0;
 
-    BN_CTX_start(ctx);
-    if ((e = BN_CTX_get(ctx)) == NULL)
-        goto err;
-
-    do {
-        if (!BN_priv_rand_range(e, group->field))
-        goto err;
-    } while (BN_is_zero(e));
-
-    /* r := a * e */
-    if (!group->meth->field_mul(group, r, a, e, ctx))
-        goto err;
-    /* r := 1/(a * e) */
-    if (!BN_mod_inverse(r, r, group->field, ctx)) {
-        ECerr(EC_F_EC_GFP_SIMPLE_FIELD_INV, EC_R_CANNOT_INVERT);
+    if (!bn_mod_inverse_consttime(r, a, group->field, ctx, &noinv)) {
+        if (noinv)
+            ECerr(EC_F_EC_GFP_SIMPLE_FIELD_INV, EC_R_CANNOT_INVERT);
         goto err;
     }
-    /* r := e/(a * e) = 1/a */
-    if (!group->meth->field_mul(group, r, r, e, ctx))
-        goto err;
 
     ret = 1;
 
  err:
-    BN_CTX_end(ctx);
     BN_CTX_free(new_ctx);
     return ret;
 }
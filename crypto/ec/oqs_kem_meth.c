@@ -0,0 +1,566 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * OQS KEM methods.
+ *
+ * These make the OQS KEMs and their ECDH hybrids available through the
+ * EVP_PKEY_encapsulate() and EVP_PKEY_decapsulate() calls, outside of TLS.
+ * A hybrid is encoded as in the TLS key share: its public key and
+ * ciphertext are the uncompressed classical point followed by the PQ public
+ * key or ciphertext, and its shared secret is the ECDH secret followed by
+ * the PQ shared secret.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "internal/cryptlib.h"
+#include <openssl/ec.h>
+#include <openssl/objects.h>
+#include "crypto/asn1.h"
+#include "crypto/evp.h"
+#include "internal/metrics.h"
+
+#include <oqs/oqs.h>
+
+typedef struct {
+    /* OQS KEM, borrowed from the shared descriptor table */
+    const OQS_KEM *kem;
+    /* Classical key pair of a hybrid, public only for a public key */
+    EC_KEY *ec;
+    /* OQS public key */
+    uint8_t *pubkey;
+    /* OQS private key, NULL for a public key */
+    uint8_t *privkey;
+} OQS_KEM_KEY;
+
+/*
+ * Returns the NID of the PQ KEM of |nid|, and sets |*curve| to the curve of
+ * its classical part, or to NID_undef if |nid| is not a hybrid.
+ */
+static int get_oqs_kem_hybrid(int nid, int *curve)
+{
+    *curve = NID_undef;
+    switch (nid) {
+///// OQS_TEMPLATE_FRAGMENT_ASSIGN_KEM_HYBRIDS_START
+    case NID_p256_frodo640aes:
+        *curve = NID_X9_62_prime256v1;
+        return NID_frodo640aes;
+    case NID_p256_frodo640shake:
+        *curve = NID_X9_62_prime256v1;
+        return NID_frodo640shake;
+    case NID_p384_frodo976aes:
+        *curve = NID_secp384r1;
+        return NID_frodo976aes;
+    case NID_p384_frodo976shake:
+        *curve = NID_secp384r1;
+        return NID_frodo976shake;
+    case NID_p521_frodo1344aes:
+        *curve = NID_secp521r1;
+        return NID_frodo1344aes;
+    case NID_p521_frodo1344shake:
+        *curve = NID_secp521r1;
+        return NID_frodo1344shake;
+    case NID_p256_kyber512:
+        *curve = NID_X9_62_prime256v1;
+        return NID_kyber512;
+    case NID_p384_kyber768:
+        *curve = NID_secp384r1;
+        return NID_kyber768;
+    case NID_p521_kyber1024:
+        *curve = NID_secp521r1;
+        return NID_kyber1024;
+    case NID_p256_bikel1:
+        *curve = NID_X9_62_prime256v1;
+        return NID_bikel1;
+    case NID_p384_bikel3:
+        *curve = NID_secp384r1;
+        return NID_bikel3;
+    case NID_p521_bikel5:
+        *curve = NID_secp521r1;
+        return NID_bikel5;
+    case NID_p256_hqc128:
+        *curve = NID_X9_62_prime256v1;
+        return NID_hqc128;
+    case NID_p384_hqc192:
+        *curve = NID_secp384r1;
+        return NID_hqc192;
+    case NID_p521_hqc256:
+        *curve = NID_secp521r1;
+        return NID_hqc256;
+///// OQS_TEMPLATE_FRAGMENT_ASSIGN_KEM_HYBRIDS_END
+    default:
+        return nid;
+    }
+}
+
+/* Length of an uncompressed point of the classical part of |key|, or 0 */
+static size_t oqs_kem_ec_ptlen(const OQS_KEM_KEY *key)
+{
+    if (key->ec == NULL)
+        return 0;
+    return 1 + 2 * (((size_t)EC_GROUP_get_degree(EC_KEY_get0_group(key->ec))
+                     + 7) / 8);
+}
+
+/* Length of the ECDH secret of the classical part of |key|, or 0 */
+static size_t oqs_kem_ec_secretlen(const OQS_KEM_KEY *key)
+{
+    if (key->ec == NULL)
+        return 0;
+    return ((size_t)EC_GROUP_get_degree(EC_KEY_get0_group(key->ec)) + 7) / 8;
+}
+
+static size_t oqs_kem_pubkeylen(const OQS_KEM_KEY *key)
+{
+    return oqs_kem_ec_ptlen(key) + key->kem->length_public_key;
+}
+
+static size_t oqs_kem_ctlen(const OQS_KEM_KEY *key)
+{
+    return oqs_kem_ec_ptlen(key) + key->kem->length_ciphertext;
+}
+
+static size_t oqs_kem_secretlen(const OQS_KEM_KEY *key)
+{
+    return oqs_kem_ec_secretlen(key) + key->kem->length_shared_secret;
+}
+
+static void oqs_kem_key_free(OQS_KEM_KEY *key)
+{
+    if (key == NULL)
+        return;
+    if (key->privkey != NULL)
+        OPENSSL_secure_clear_free(key->privkey, key->kem->length_secret_key);
+    OPENSSL_free(key->pubkey);
+    EC_KEY_free(key->ec);
+    OPENSSL_free(key);
+}
+
+/*
+ * Allocates the key of KEM |nid|, with room for a private key if |private|
+ * is set. The classical key of a hybrid is created without its key pair.
+ */
+static OQS_KEM_KEY *oqs_kem_key_new(int nid, int private)
+{
+    OQS_KEM_KEY *key;
+    int curve;
+
+    if ((key = OPENSSL_zalloc(sizeof(*key))) == NULL) {
+        ECerr(EC_F_OQS_KEM_KEY_NEW, ERR_R_MALLOC_FAILURE);
+        return NULL;
+    }
+    if ((key->kem = get_oqs_kem(get_oqs_kem_hybrid(nid, &curve))) == NULL) {
+        ECerr(EC_F_OQS_KEM_KEY_NEW, EC_R_NO_SUCH_OQS_ALGORITHM);
+        OPENSSL_free(key);
+        return NULL;
+    }
+    if ((curve != NID_undef
+         && (key->ec = EC_KEY_new_by_curve_name(curve)) == NULL)
+            || (key->pubkey = OPENSSL_malloc(key->kem->length_public_key))
+               == NULL
+            || (private
+                && (key->privkey =
+                    OPENSSL_secure_malloc(key->kem->length_secret_key))
+                   == NULL)) {
+        ECerr(EC_F_OQS_KEM_KEY_NEW, ERR_R_MALLOC_FAILURE);
+        oqs_kem_key_free(key);
+        return NULL;
+    }
+    return key;
+}
+
+static int oqs_kem_pub_cmp(const EVP_PKEY *a, const EVP_PKEY *b)
+{
+    const OQS_KEM_KEY *akey = a->pkey.ptr, *bkey = b->pkey.ptr;
+
+    if (akey == NULL || bkey == NULL)
+        return -2;
+    if (akey->ec != NULL
+            && EC_POINT_cmp(EC_KEY_get0_group(akey->ec),
+                            EC_KEY_get0_public_key(akey->ec),
+                            EC_KEY_get0_public_key(bkey->ec), NULL) != 0)
+        return 0;
+    return CRYPTO_memcmp(akey->pubkey, bkey->pubkey,
+                         akey->kem->length_public_key) == 0;
+}
+
+/* The largest output of the key, its ciphertext */
+static int oqs_kem_size(const EVP_PKEY *pkey)
+{
+    return (int)oqs_kem_ctlen(pkey->pkey.ptr);
+}
+
+static int oqs_kem_bits(const EVP_PKEY *pkey)
+{
+    return 8 * (int)oqs_kem_pubkeylen(pkey->pkey.ptr);
+}
+
+static int oqs_kem_security_bits(const EVP_PKEY *pkey)
+{
+    const OQS_KEM_KEY *key = pkey->pkey.ptr;
+
+    switch (key->kem->claimed_nist_level) {
+    case 1:
+    case 2:
+        return 128;
+    case 3:
+    case 4:
+        return 192;
+    default:
+        return 256;
+    }
+}
+
+static void oqs_kem_free(EVP_PKEY *pkey)
+{
+    oqs_kem_key_free(pkey->pkey.ptr);
+}
+
+static int oqs_kem_cmp_parameters(const EVP_PKEY *a, const EVP_PKEY *b)
+{
+    return 1;
+}
+
+static int oqs_kem_set_pub_key(EVP_PKEY *pkey, const unsigned char *pub,
+                               size_t len)
+{
+    OQS_KEM_KEY *key;
+    size_t ptlen;
+
+    if ((key = oqs_kem_key_new(pkey->ameth->pkey_id, 0)) == NULL)
+        return 0;
+    ptlen = oqs_kem_ec_ptlen(key);
+    if (len != oqs_kem_pubkeylen(key)) {
+        ECerr(EC_F_OQS_KEM_SET_PUB_KEY, EC_R_WRONG_LENGTH);
+        goto err;
+    }
+    if (key->ec != NULL && !EC_KEY_oct2key(key->ec, pub, ptlen, NULL)) {
+        ECerr(EC_F_OQS_KEM_SET_PUB_KEY, EC_R_INVALID_ENCODING);
+        goto err;
+    }
+    memcpy(key->pubkey, pub + ptlen, key->kem->length_public_key);
+    pkey->pkey.ptr = key;
+    return 1;
+
+ err:
+    oqs_kem_key_free(key);
+    return 0;
+}
+
+static int oqs_kem_get_pub_key(const EVP_PKEY *pkey, unsigned char *pub,
+                               size_t *len)
+{
+    const OQS_KEM_KEY *key = pkey->pkey.ptr;
+    size_t ptlen;
+
+    if (pub == NULL) {
+        *len = oqs_kem_pubkeylen(key);
+        return 1;
+    }
+    if (*len < oqs_kem_pubkeylen(key))
+        return 0;
+    ptlen = oqs_kem_ec_ptlen(key);
+    if (key->ec != NULL
+            && EC_POINT_point2oct(EC_KEY_get0_group(key->ec),
+                                  EC_KEY_get0_public_key(key->ec),
+                                  POINT_CONVERSION_UNCOMPRESSED, pub, ptlen,
+                                  NULL) != ptlen)
+        return 0;
+    memcpy(pub + ptlen, key->pubkey, key->kem->length_public_key);
+    *len = oqs_kem_pubkeylen(key);
+    return 1;
+}
+
+#define DEFINE_OQS_KEM_ASN1_METHOD(ALG, NID_ALG, SHORT_NAME, LONG_NAME) \
+const EVP_PKEY_ASN1_METHOD ALG##_asn1_meth = {                          \
+    NID_ALG,                                                            \
+    NID_ALG,                                                            \
+    0,                                                                  \
+    SHORT_NAME,                                                         \
+    LONG_NAME,                                                          \
+    0, 0,                                                               \
+    oqs_kem_pub_cmp,                                                    \
+    0, 0, 0, 0,                                                         \
+    oqs_kem_size,                                                       \
+    oqs_kem_bits,                                                       \
+    oqs_kem_security_bits,                                              \
+    0, 0, 0, 0,                                                         \
+    oqs_kem_cmp_parameters,                                             \
+    0, 0,                                                               \
+    oqs_kem_free,                                                       \
+    0, 0, 0, 0, 0, 0, 0, 0, 0,                                          \
+    0,                                                                  \
+    oqs_kem_set_pub_key,                                                \
+    0,                                                                  \
+    oqs_kem_get_pub_key,                                                \
+};
+
+/* Nothing to carry over: all of the state is in the keys */
+static int pkey_oqs_kem_copy(EVP_PKEY_CTX *dst, EVP_PKEY_CTX *src)
+{
+    return 1;
+}
+
+static int pkey_oqs_kem_keygen(EVP_PKEY_CTX *ctx, EVP_PKEY *pkey)
+{
+    int id = ctx->pmeth->pkey_id;
+    OQS_KEM_KEY *key;
+
+    if ((key = oqs_kem_key_new(id, 1)) == NULL)
+        return 0;
+    if ((key->ec != NULL && !EC_KEY_generate_key(key->ec))
+            || ossl_oqs_kem_keypair(key->kem, key->pubkey, key->privkey)
+               != OQS_SUCCESS) {
+        ECerr(EC_F_PKEY_OQS_KEM_KEYGEN, ERR_R_INTERNAL_ERROR);
+        oqs_kem_key_free(key);
+        return 0;
+    }
+    EVP_PKEY_assign(pkey, id, key);
+    return 1;
+}
+
+/*
+ * Encapsulates to |peer| with the classical ephemeral key |eph| of a hybrid,
+ * writing oqs_kem_ctlen() bytes to |ct| and oqs_kem_secretlen() to |secret|.
+ */
+static int oqs_kem_encaps(const OQS_KEM_KEY *peer, const EC_KEY *eph,
+                          unsigned char *ct, unsigned char *secret)
+{
+    size_t ptlen = oqs_kem_ec_ptlen(peer);
+    size_t eclen = oqs_kem_ec_secretlen(peer);
+
+    if (peer->ec != NULL
+            && (EC_POINT_point2oct(EC_KEY_get0_group(eph),
+                                   EC_KEY_get0_public_key(eph),
+                                   POINT_CONVERSION_UNCOMPRESSED, ct, ptlen,
+                                   NULL) != ptlen
+                || ECDH_compute_key(secret, eclen,
+                                    EC_KEY_get0_public_key(peer->ec), eph,
+                                    NULL) != (int)eclen))
+        return 0;
+    return ossl_oqs_kem_encaps(peer->kem, ct + ptlen, secret + eclen,
+                               peer->pubkey) == OQS_SUCCESS;
+}
+
+/* Returns the peer key of |ctx| after checking its output lengths */
+static const OQS_KEM_KEY *pkey_oqs_kem_check_lens(EVP_PKEY_CTX *ctx,
+                                                  size_t ctlen,
+                                                  size_t secretlen)
+{
+    const OQS_KEM_KEY *peer = ctx->pkey->pkey.ptr;
+
+    if (peer == NULL) {
+        ECerr(EC_F_PKEY_OQS_KEM_CHECK_LENS, EC_R_KEYS_NOT_SET);
+        return NULL;
+    }
+    if (ctlen < oqs_kem_ctlen(peer) || secretlen < oqs_kem_secretlen(peer)) {
+        ECerr(EC_F_PKEY_OQS_KEM_CHECK_LENS, EC_R_BUFFER_TOO_SMALL);
+        return NULL;
+    }
+    return peer;
+}
+
+static int pkey_oqs_kem_encapsulate(EVP_PKEY_CTX *ctx, unsigned char *ct,
+                                    size_t *ctlen, unsigned char *secret,
+                                    size_t *secretlen)
+{
+    const OQS_KEM_KEY *peer = ctx->pkey->pkey.ptr;
+    EC_KEY *eph = NULL;
+    int ret = 0;
+
+    if (ct == NULL || secret == NULL) {
+        *ctlen = oqs_kem_ctlen(peer);
+        *secretlen = oqs_kem_secretlen(peer);
+        return 1;
+    }
+    if ((peer = pkey_oqs_kem_check_lens(ctx, *ctlen, *secretlen)) == NULL)
+        return 0;
+    if (peer->ec != NULL
+            && ((eph = EC_KEY_new()) == NULL
+                || !EC_KEY_set_group(eph, EC_KEY_get0_group(peer->ec))
+                || !EC_KEY_generate_key(eph))) {
+        ECerr(EC_F_PKEY_OQS_KEM_ENCAPSULATE, ERR_R_EC_LIB);
+        goto end;
+    }
+    if (!oqs_kem_encaps(peer, eph, ct, secret)) {
+        ECerr(EC_F_PKEY_OQS_KEM_ENCAPSULATE, ERR_R_INTERNAL_ERROR);
+        OPENSSL_cleanse(secret, oqs_kem_secretlen(peer));
+        goto end;
+    }
+    *ctlen = oqs_kem_ctlen(peer);
+    *secretlen = oqs_kem_secretlen(peer);
+    ret = 1;
+
+ end:
+    EC_KEY_free(eph);
+    return ret;
+}
+
+/*
+ * Encapsulates to the keys of |num| contexts of the same KEM. The ephemeral
+ * keys of the classical part of a hybrid are generated together, sharing a
+ * single field inversion.
+ */
+static int pkey_oqs_kem_encapsulate_batch(EVP_PKEY_CTX *ctx[], size_t num,
+                                          unsigned char *ct, size_t *ctlen,
+                                          unsigned char *secret,
+                                          size_t *secretlen)
+{
+    const OQS_KEM_KEY *peer;
+    EC_KEY **eph = NULL;
+    size_t i, clen, slen;
+    int ret = 0;
+
+    if ((peer = pkey_oqs_kem_check_lens(ctx[0], *ctlen, *secretlen)) == NULL)
+        return 0;
+    clen = oqs_kem_ctlen(peer);
+    slen = oqs_kem_secretlen(peer);
+    if (peer->ec != NULL) {
+        if ((eph = OPENSSL_zalloc(num * sizeof(*eph))) == NULL) {
+            ECerr(EC_F_PKEY_OQS_KEM_ENCAPSULATE_BATCH, ERR_R_MALLOC_FAILURE);
+            return 0;
+        }
+        for (i = 0; i < num; i++) {
+            peer = ctx[i]->pkey->pkey.ptr;
+            if ((eph[i] = EC_KEY_new()) == NULL
+                    || !EC_KEY_set_group(eph[i], EC_KEY_get0_group(peer->ec))) {
+                ECerr(EC_F_PKEY_OQS_KEM_ENCAPSULATE_BATCH, ERR_R_EC_LIB);
+                goto end;
+            }
+        }
+        if (!EC_KEY_generate_key_batch(eph, num)) {
+            ECerr(EC_F_PKEY_OQS_KEM_ENCAPSULATE_BATCH, ERR_R_EC_LIB);
+            goto end;
+        }
+    }
+    for (i = 0; i < num; i++) {
+        if (!oqs_kem_encaps(ctx[i]->pkey->pkey.ptr,
+                            eph != NULL ? eph[i] : NULL,
+                            ct + i * *ctlen, secret + i * *secretlen)) {
+            ECerr(EC_F_PKEY_OQS_KEM_ENCAPSULATE_BATCH, ERR_R_INTERNAL_ERROR);
+            OPENSSL_cleanse(secret, i * *secretlen + slen);
+            goto end;
+        }
+    }
+    *ctlen = clen;
+    *secretlen = slen;
+    ret = 1;
+
+ end:
+    if (eph != NULL)
+        for (i = 0; i < num; i++)
+            EC_KEY_free(eph[i]);
+    OPENSSL_free(eph);
+    return ret;
+}
+
+static int pkey_oqs_kem_decapsulate(EVP_PKEY_CTX *ctx, unsigned char *secret,
+                                    size_t *secretlen,
+                                    const unsigned char *ct, size_t ctlen)
+{
+    const OQS_KEM_KEY *key = ctx->pkey->pkey.ptr;
+    const EC_GROUP *group;
+    EC_POINT *pt = NULL;
+    size_t ptlen = oqs_kem_ec_ptlen(key), eclen = oqs_kem_ec_secretlen(key);
+    int ret = 0;
+
+    if (secret == NULL) {
+        *secretlen = oqs_kem_secretlen(key);
+        return 1;
+    }
+    if (key->privkey == NULL) {
+        ECerr(EC_F_PKEY_OQS_KEM_DECAPSULATE, EC_R_MISSING_PRIVATE_KEY);
+        return 0;
+    }
+    if (*secretlen < oqs_kem_secretlen(key)) {
+        ECerr(EC_F_PKEY_OQS_KEM_DECAPSULATE, EC_R_BUFFER_TOO_SMALL);
+        return 0;
+    }
+    if (ctlen != oqs_kem_ctlen(key)) {
+        ECerr(EC_F_PKEY_OQS_KEM_DECAPSULATE, EC_R_WRONG_LENGTH);
+        return 0;
+    }
+    if (key->ec != NULL) {
+        group = EC_KEY_get0_group(key->ec);
+        if ((pt = EC_POINT_new(group)) == NULL
+                || !EC_POINT_oct2point(group, pt, ct, ptlen, NULL)) {
+            ECerr(EC_F_PKEY_OQS_KEM_DECAPSULATE, EC_R_INVALID_ENCODING);
+            goto end;
+        }
+        if (ECDH_compute_key(secret, eclen, pt, key->ec, NULL)
+                != (int)eclen) {
+            ECerr(EC_F_PKEY_OQS_KEM_DECAPSULATE, ERR_R_EC_LIB);
+            goto end;
+        }
+    }
+    if (ossl_oqs_kem_decaps(key->kem, secret + eclen, ct + ptlen,
+                            key->privkey) != OQS_SUCCESS) {
+        ECerr(EC_F_PKEY_OQS_KEM_DECAPSULATE, ERR_R_INTERNAL_ERROR);
+        OPENSSL_cleanse(secret, eclen);
+        goto end;
+    }
+    *secretlen = oqs_kem_secretlen(key);
+    ret = 1;
+
+ end:
+    EC_POINT_free(pt);
+    return ret;
+}
+
+#define DEFINE_OQS_KEM_PKEY_METHOD(ALG, NID_ALG)    \
+const EVP_PKEY_METHOD ALG##_pkey_meth = {           \
+    NID_ALG, 0,                                     \
+    0, pkey_oqs_kem_copy, 0,                        \
+    0, 0, 0,                                        \
+    pkey_oqs_kem_keygen,                            \
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0,                   \
+    0, 0, 0, 0, 0, 0, 0, 0,                         \
+    0, 0, 0, 0, 0, 0,                               \
+    0, pkey_oqs_kem_encapsulate,                    \
+    pkey_oqs_kem_encapsulate_batch,                 \
+    0, pkey_oqs_kem_decapsulate                     \
+};
+
+#define DEFINE_OQS_KEM_EVP_METHODS(ALG, NID_ALG, SHORT_NAME, LONG_NAME) \
+DEFINE_OQS_KEM_PKEY_METHOD(ALG, NID_ALG)                                \
+DEFINE_OQS_KEM_ASN1_METHOD(ALG, NID_ALG, SHORT_NAME, LONG_NAME)
+
+///// OQS_TEMPLATE_FRAGMENT_DEFINE_OQS_KEM_EVP_METHS_START
+DEFINE_OQS_KEM_EVP_METHODS(frodo640aes, NID_frodo640aes, "frodo640aes", "OpenSSL frodo640aes KEM")
+DEFINE_OQS_KEM_EVP_METHODS(frodo640shake, NID_frodo640shake, "frodo640shake", "OpenSSL frodo640shake KEM")
+DEFINE_OQS_KEM_EVP_METHODS(frodo976aes, NID_frodo976aes, "frodo976aes", "OpenSSL frodo976aes KEM")
+DEFINE_OQS_KEM_EVP_METHODS(frodo976shake, NID_frodo976shake, "frodo976shake", "OpenSSL frodo976shake KEM")
+DEFINE_OQS_KEM_EVP_METHODS(frodo1344aes, NID_frodo1344aes, "frodo1344aes", "OpenSSL frodo1344aes KEM")
+DEFINE_OQS_KEM_EVP_METHODS(frodo1344shake, NID_frodo1344shake, "frodo1344shake", "OpenSSL frodo1344shake KEM")
+DEFINE_OQS_KEM_EVP_METHODS(kyber512, NID_kyber512, "kyber512", "OpenSSL kyber512 KEM")
+DEFINE_OQS_KEM_EVP_METHODS(kyber768, NID_kyber768, "kyber768", "OpenSSL kyber768 KEM")
+DEFINE_OQS_KEM_EVP_METHODS(kyber1024, NID_kyber1024, "kyber1024", "OpenSSL kyber1024 KEM")
+DEFINE_OQS_KEM_EVP_METHODS(bikel1, NID_bikel1, "bikel1", "OpenSSL bikel1 KEM")
+DEFINE_OQS_KEM_EVP_METHODS(bikel3, NID_bikel3, "bikel3", "OpenSSL bikel3 KEM")
+DEFINE_OQS_KEM_EVP_METHODS(bikel5, NID_bikel5, "bikel5", "OpenSSL bikel5 KEM")
+DEFINE_OQS_KEM_EVP_METHODS(hqc128, NID_hqc128, "hqc128", "OpenSSL hqc128 KEM")
+DEFINE_OQS_KEM_EVP_METHODS(hqc192, NID_hqc192, "hqc192", "OpenSSL hqc192 KEM")
+DEFINE_OQS_KEM_EVP_METHODS(hqc256, NID_hqc256, "hqc256", "OpenSSL hqc256 KEM")
+DEFINE_OQS_KEM_EVP_METHODS(p256_frodo640aes, NID_p256_frodo640aes, "p256_frodo640aes", "OpenSSL p256 frodo640aes hybrid KEM")
+DEFINE_OQS_KEM_EVP_METHODS(p256_frodo640shake, NID_p256_frodo640shake, "p256_frodo640shake", "OpenSSL p256 frodo640shake hybrid KEM")
+DEFINE_OQS_KEM_EVP_METHODS(p384_frodo976aes, NID_p384_frodo976aes, "p384_frodo976aes", "OpenSSL p384 frodo976aes hybrid KEM")
+DEFINE_OQS_KEM_EVP_METHODS(p384_frodo976shake, NID_p384_frodo976shake, "p384_frodo976shake", "OpenSSL p384 frodo976shake hybrid KEM")
+DEFINE_OQS_KEM_EVP_METHODS(p521_frodo1344aes, NID_p521_frodo1344aes, "p521_frodo1344aes", "OpenSSL p521 frodo1344aes hybrid KEM")
+DEFINE_OQS_KEM_EVP_METHODS(p521_frodo1344shake, NID_p521_frodo1344shake, "p521_frodo1344shake", "OpenSSL p521 frodo1344shake hybrid KEM")
+DEFINE_OQS_KEM_EVP_METHODS(p256_kyber512, NID_p256_kyber512, "p256_kyber512", "OpenSSL p256 kyber512 hybrid KEM")
+DEFINE_OQS_KEM_EVP_METHODS(p384_kyber768, NID_p384_kyber768, "p384_kyber768", "OpenSSL p384 kyber768 hybrid KEM")
+DEFINE_OQS_KEM_EVP_METHODS(p521_kyber1024, NID_p521_kyber1024, "p521_kyber1024", "OpenSSL p521 kyber1024 hybrid KEM")
+DEFINE_OQS_KEM_EVP_METHODS(p256_bikel1, NID_p256_bikel1, "p256_bikel1", "OpenSSL p256 bikel1 hybrid KEM")
+DEFINE_OQS_KEM_EVP_METHODS(p384_bikel3, NID_p384_bikel3, "p384_bikel3", "OpenSSL p384 bikel3 hybrid KEM")
+DEFINE_OQS_KEM_EVP_METHODS(p521_bikel5, NID_p521_bikel5, "p521_bikel5", "OpenSSL p521 bikel5 hybrid KEM")
+DEFINE_OQS_KEM_EVP_METHODS(p256_hqc128, NID_p256_hqc128, "p256_hqc128", "OpenSSL p256 hqc128 hybrid KEM")
+DEFINE_OQS_KEM_EVP_METHODS(p384_hqc192, NID_p384_hqc192, "p384_hqc192", "OpenSSL p384 hqc192 hybrid KEM")
+DEFINE_OQS_KEM_EVP_METHODS(p521_hqc256, NID_p521_hqc256, "p521_hqc256", "OpenSSL p521 hqc256 hybrid KEM")
+///// OQS_TEMPLATE_FRAGMENT_DEFINE_OQS_KEM_EVP_METHS_END
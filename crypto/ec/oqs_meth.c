@@ -25,11 +25,16 @@
 */
 
 #include <stdio.h>
+#include <limits.h>
 #include "internal/cryptlib.h"
 #include <openssl/x509.h>
 #include <openssl/rsa.h>
+#include <openssl/rand.h>
 #include "crypto/asn1.h"
 #include "crypto/evp.h"
+#include "crypto/x509.h"
+#include "internal/thread_once.h"
+#include "internal/metrics.h"
 
 #include <openssl/cms.h>
 
@@ -52,20 +57,42 @@ typedef struct
 {
   /* OpenSSL NID */
   int nid;
-  /* OQS signature context */
-  OQS_SIG *s;
+  /* OQS signature context, borrowed from the shared descriptor table */
+  const OQS_SIG *s;
   /* OQS public key */
   uint8_t *pubkey;
+  /* Buffer |pubkey| points into when borrowed from a shared certificate */
+  ASN1_SHARED_BUF *pubkey_buf;
   /* OQS private key */
   uint8_t *privkey;
   /* Classical key pair for hybrid schemes; either a private or public key depending on context */
   EVP_PKEY *classical_pkey;
-  /* Security bits for the scheme */
-  int security_bits;
-  /* digest engine for CMS: */
-  EVP_MD_CTX * digest;
+  /* What is known about the scheme, from oqs_sig_meta */
+  const struct oqs_sig_meta_st *meta;
+  /* Configured classical signing and verification contexts for hybrid schemes,
+     created on first use and duplicated for each operation */
+  EVP_PKEY_CTX *classical_sign_ctx;
+  EVP_PKEY_CTX *classical_verify_ctx;
+  CRYPTO_RWLOCK *lock;
 } OQS_KEY;
 
+/*
+ * RSA modulus size of the rsa3072_* hybrids; their encodings reserve room
+ * for a 3072-bit key and signature.
+ */
+#define OQS_RSA_KEYGEN_BITS 3072
+
+/*
+ * OQS EVP_PKEY_CTX data
+ */
+typedef struct
+{
+  /* Digest of a streaming operation, created on first use */
+  EVP_MD_CTX *digest;
+  /* Threads verifying the halves of a hybrid signature, 1 or 2 */
+  int verify_threads;
+} OQS_PKEY_CTX;
+
 /*
  * OQS key type
  */
@@ -232,242 +259,515 @@ char* get_oqs_alg_name(int openssl_nid)
   }
 }
 
-static int is_oqs_hybrid_alg(int openssl_nid)
-{
-  switch (openssl_nid)
-  {
-///// OQS_TEMPLATE_FRAGMENT_LIST_HYBRID_NIDS_START
-    case NID_p256_dilithium2:
-    case NID_rsa3072_dilithium2:
-    case NID_p384_dilithium3:
-    case NID_p521_dilithium5:
-    case NID_p256_falcon512:
-    case NID_rsa3072_falcon512:
-    case NID_p521_falcon1024:
-    case NID_p256_sphincssha2128fsimple:
-    case NID_rsa3072_sphincssha2128fsimple:
-    case NID_p256_sphincssha2128ssimple:
-    case NID_rsa3072_sphincssha2128ssimple:
-    case NID_p384_sphincssha2192fsimple:
-    case NID_p256_sphincsshake128fsimple:
-    case NID_rsa3072_sphincsshake128fsimple:
-///// OQS_TEMPLATE_FRAGMENT_LIST_HYBRID_NIDS_END
-      return 1;
-    default:
-      return 0;
-  }
-}
+/*
+ * The classical half of a hybrid signature scheme, with the largest
+ * encodings of its keys and signatures.
+ */
+typedef struct {
+  int nid;
+  int pubkey_len;
+  int privkey_len;
+  int sig_len;
+} OQS_CLASSICAL_META;
 
+static const OQS_CLASSICAL_META oqs_classical_rsa3072 = {
+  NID_rsaEncryption, 398, 1770, 384
+};
+static const OQS_CLASSICAL_META oqs_classical_p256 = {
+  NID_X9_62_prime256v1, 65, 121, 72
+};
+static const OQS_CLASSICAL_META oqs_classical_p384 = {
+  NID_secp384r1, 97, 167, 104
+};
+static const OQS_CLASSICAL_META oqs_classical_p521 = {
+  NID_secp521r1, 133, 223, 141
+};
+
+/*
+ * What is known about a plain or hybrid OQS signature scheme without
+ * asking liboqs. Keys point to the entry of their scheme, so that the
+ * per-operation checks are field loads rather than lookups.
+ */
+typedef struct oqs_sig_meta_st {
+  int nid;
+  /* liboqs algorithm name */
+  const char *oqs_name;
+  /* The plain PQ scheme, |nid| itself unless a hybrid */
+  int oqs_nid;
+  /* The classical half of a hybrid, NULL for a plain scheme */
+  const OQS_CLASSICAL_META *classical;
+  int security_bits;
+} OQS_SIG_META;
+
+static const OQS_SIG_META oqs_sig_meta[] = {
+///// OQS_TEMPLATE_FRAGMENT_LIST_SIG_META_START
+    { NID_dilithium2, OQS_SIG_alg_dilithium_2, NID_dilithium2, NULL, 128 },
+    { NID_p256_dilithium2, OQS_SIG_alg_dilithium_2,
+      NID_dilithium2, &oqs_classical_p256, 128 },
+    { NID_rsa3072_dilithium2, OQS_SIG_alg_dilithium_2,
+      NID_dilithium2, &oqs_classical_rsa3072, 128 },
+    { NID_dilithium3, OQS_SIG_alg_dilithium_3, NID_dilithium3, NULL, 192 },
+    { NID_p384_dilithium3, OQS_SIG_alg_dilithium_3,
+      NID_dilithium3, &oqs_classical_p384, 192 },
+    { NID_dilithium5, OQS_SIG_alg_dilithium_5, NID_dilithium5, NULL, 256 },
+    { NID_p521_dilithium5, OQS_SIG_alg_dilithium_5,
+      NID_dilithium5, &oqs_classical_p521, 256 },
+    { NID_falcon512, OQS_SIG_alg_falcon_512, NID_falcon512, NULL, 128 },
+    { NID_p256_falcon512, OQS_SIG_alg_falcon_512,
+      NID_falcon512, &oqs_classical_p256, 128 },
+    { NID_rsa3072_falcon512, OQS_SIG_alg_falcon_512,
+      NID_falcon512, &oqs_classical_rsa3072, 128 },
+    { NID_falcon1024, OQS_SIG_alg_falcon_1024, NID_falcon1024, NULL, 256 },
+    { NID_p521_falcon1024, OQS_SIG_alg_falcon_1024,
+      NID_falcon1024, &oqs_classical_p521, 256 },
+    { NID_sphincssha2128fsimple, OQS_SIG_alg_sphincs_sha2_128f_simple, NID_sphincssha2128fsimple, NULL, 128 },
+    { NID_p256_sphincssha2128fsimple, OQS_SIG_alg_sphincs_sha2_128f_simple,
+      NID_sphincssha2128fsimple, &oqs_classical_p256, 128 },
+    { NID_rsa3072_sphincssha2128fsimple, OQS_SIG_alg_sphincs_sha2_128f_simple,
+      NID_sphincssha2128fsimple, &oqs_classical_rsa3072, 128 },
+    { NID_sphincssha2128ssimple, OQS_SIG_alg_sphincs_sha2_128s_simple, NID_sphincssha2128ssimple, NULL, 128 },
+    { NID_p256_sphincssha2128ssimple, OQS_SIG_alg_sphincs_sha2_128s_simple,
+      NID_sphincssha2128ssimple, &oqs_classical_p256, 128 },
+    { NID_rsa3072_sphincssha2128ssimple, OQS_SIG_alg_sphincs_sha2_128s_simple,
+      NID_sphincssha2128ssimple, &oqs_classical_rsa3072, 128 },
+    { NID_sphincssha2192fsimple, OQS_SIG_alg_sphincs_sha2_192f_simple, NID_sphincssha2192fsimple, NULL, 192 },
+    { NID_p384_sphincssha2192fsimple, OQS_SIG_alg_sphincs_sha2_192f_simple,
+      NID_sphincssha2192fsimple, &oqs_classical_p384, 192 },
+    { NID_sphincsshake128fsimple, OQS_SIG_alg_sphincs_shake_128f_simple, NID_sphincsshake128fsimple, NULL, 128 },
+    { NID_p256_sphincsshake128fsimple, OQS_SIG_alg_sphincs_shake_128f_simple,
+      NID_sphincsshake128fsimple, &oqs_classical_p256, 128 },
+    { NID_rsa3072_sphincsshake128fsimple, OQS_SIG_alg_sphincs_shake_128f_simple,
+      NID_sphincsshake128fsimple, &oqs_classical_rsa3072, 128 },
+///// OQS_TEMPLATE_FRAGMENT_LIST_SIG_META_END
+};
 
-static int get_classical_nid(int hybrid_id)
+static const OQS_SIG_META *get_oqs_sig_meta(int openssl_nid)
 {
-  switch (hybrid_id)
-  {
-///// OQS_TEMPLATE_FRAGMENT_ASSIGN_CLASSICAL_NIDS_START
-    case NID_rsa3072_dilithium2:
-    case NID_rsa3072_falcon512:
-    case NID_rsa3072_sphincssha2128fsimple:
-    case NID_rsa3072_sphincssha2128ssimple:
-    case NID_rsa3072_sphincsshake128fsimple:
-      return NID_rsaEncryption;
-    case NID_p256_dilithium2:
-    case NID_p256_falcon512:
-    case NID_p256_sphincssha2128fsimple:
-    case NID_p256_sphincssha2128ssimple:
-    case NID_p256_sphincsshake128fsimple:
-      return NID_X9_62_prime256v1;
-    case NID_p384_dilithium3:
-    case NID_p384_sphincssha2192fsimple:
-      return NID_secp384r1;
-    case NID_p521_dilithium5:
-    case NID_p521_falcon1024:
-      return NID_secp521r1;///// OQS_TEMPLATE_FRAGMENT_ASSIGN_CLASSICAL_NIDS_END
-    default:
-      return 0;
-  }
+  size_t i;
+
+  for (i = 0; i < OSSL_NELEM(oqs_sig_meta); i++)
+    if (oqs_sig_meta[i].nid == openssl_nid)
+      return &oqs_sig_meta[i];
+  return NULL;
 }
 
 static int get_oqs_nid(int hybrid_id)
 {
-  switch (hybrid_id)
-  {
-///// OQS_TEMPLATE_FRAGMENT_ASSIGN_OQS_NID_START
-    case NID_p256_dilithium2:
-    case NID_rsa3072_dilithium2:
-      return NID_dilithium2;
-    case NID_p384_dilithium3:
-      return NID_dilithium3;
-    case NID_p521_dilithium5:
-      return NID_dilithium5;
-    case NID_p256_falcon512:
-    case NID_rsa3072_falcon512:
-      return NID_falcon512;
-    case NID_p521_falcon1024:
-      return NID_falcon1024;
-    case NID_p256_sphincssha2128fsimple:
-    case NID_rsa3072_sphincssha2128fsimple:
-      return NID_sphincssha2128fsimple;
-    case NID_p256_sphincssha2128ssimple:
-    case NID_rsa3072_sphincssha2128ssimple:
-      return NID_sphincssha2128ssimple;
-    case NID_p384_sphincssha2192fsimple:
-      return NID_sphincssha2192fsimple;
-    case NID_p256_sphincsshake128fsimple:
-    case NID_rsa3072_sphincsshake128fsimple:
-      return NID_sphincsshake128fsimple;
-///// OQS_TEMPLATE_FRAGMENT_ASSIGN_OQS_NID_END
-    default:
-      return 0;
-  }
+  const OQS_SIG_META *meta = get_oqs_sig_meta(hybrid_id);
+
+  return meta != NULL && meta->classical != NULL ? meta->oqs_nid : 0;
 }
 
-static int get_classical_key_len(oqs_key_type_t keytype, int classical_id) {
- switch (classical_id)
-    {
-    case NID_rsaEncryption:
-      return (keytype == KEY_TYPE_PRIVATE) ? 1770 : 398;
-    case NID_X9_62_prime256v1:
-      return (keytype == KEY_TYPE_PRIVATE) ? 121 : 65;
-    case NID_secp384r1:
-      return (keytype == KEY_TYPE_PRIVATE) ? 167 : 97;
-    case NID_secp521r1:
-      return (keytype == KEY_TYPE_PRIVATE) ? 223 : 133;
-    default:
-      return 0;
+/*
+ * Process-wide table of OQS algorithm descriptors. liboqs descriptors are
+ * read-only once created, so they are built once and shared by every key
+ * and every TLS connection instead of being allocated on each use.
+ */
+static CRYPTO_ONCE oqs_alg_table_once = CRYPTO_ONCE_STATIC_INIT;
+static int oqs_alg_table_inited = 0;
+static OQS_KEM *oqs_kem_table[OQS_OPENSSL_KEM_algs_length];
+static OQS_SIG *oqs_sig_table[OQS_OPENSSL_SIG_algs_length];
+
+/*
+ * liboqs draws its key generation and encapsulation randomness through
+ * OQS_randombytes(); feed it from the per-thread private DRBG (buffered if
+ * RAND_DRBG_FLAG_BUFFERED is set), as it mostly ends up in secret keys.
+ * That DRBG reseeds itself in a forked child and is freed with its thread,
+ * so liboqs needs no fork handling of its own.  liboqs has no way to report
+ * a failure, so don't hand it anything but random bytes.
+ */
+static void oqs_randombytes(uint8_t *out, size_t outlen)
+{
+    while (outlen > 0) {
+        int chunk = outlen > INT_MAX ? INT_MAX : (int)outlen;
+
+        if (RAND_priv_bytes(out, chunk) != 1)
+            OPENSSL_die("RAND_priv_bytes failed in OQS_randombytes",
+                        OPENSSL_FILE, OPENSSL_LINE);
+        out += chunk;
+        outlen -= chunk;
     }
 }
 
-static int get_classical_sig_len(int classical_id)
+/* Called from the libcrypto base initialisation */
+void oqs_rand_init_int(void)
 {
- switch (classical_id)
-    {
-    case NID_rsaEncryption:
-      return 384;
-    case NID_X9_62_prime256v1:
-      return 72;
-    case NID_secp384r1:
-      return 104;
-    case NID_secp521r1:
-      return 141;
-    default:
-      return 0;
+    OQS_randombytes_custom_algorithm(oqs_randombytes);
+}
+
+/* The DRBGs are about to go away, give liboqs its own source back */
+void oqs_rand_cleanup_int(void)
+{
+    OQS_randombytes_switch_algorithm(OQS_RAND_alg_system);
+}
+
+DEFINE_RUN_ONCE_STATIC(do_oqs_alg_table_init)
+{
+    int i;
+
+    for (i = 0; i < OQS_OPENSSL_KEM_algs_length; i++) {
+        const char *name = get_oqs_alg_name(oqssl_kem_nids_list[i]);
+
+        if (OQS_KEM_alg_is_enabled(name))
+            oqs_kem_table[i] = OQS_KEM_new(name);
     }
+    for (i = 0; i < OQS_OPENSSL_SIG_algs_length; i++) {
+        const char *name;
+
+        /* hybrids share the descriptor of their PQ component */
+        if (get_oqs_nid(oqssl_sig_nids_list[i]) != 0)
+            continue;
+        name = get_oqs_alg_name(oqssl_sig_nids_list[i]);
+        if (OQS_SIG_alg_is_enabled(name))
+            oqs_sig_table[i] = OQS_SIG_new(name);
+    }
+    oqs_alg_table_inited = 1;
+    return 1;
 }
 
 /*
- * Returns options when running OQS KEM, e.g., in openssl speed
+ * Returns the shared OQS KEM descriptor for a PQ KEM NID, or NULL if the
+ * algorithm is unknown or not enabled in liboqs. The result must not be freed.
  */
-const char *OQSKEM_options(void)
+const OQS_KEM *get_oqs_kem(int openssl_nid)
 {
-    int offset;
-// TODO: Revisit which OQS_COMPILE_FLAGS to show
-#ifdef OQS_COMPILE_CFLAGS
-    const char* OQSKEMALGS = "OQS KEM build : ";
-    char* result =  OPENSSL_zalloc(strlen(OQS_COMPILE_CFLAGS)+OQS_OPENSSL_KEM_algs_length*40); // OK, a bit pessimistic but this will be removed very soon...
-    memcpy(result, OQSKEMALGS, offset = strlen(OQSKEMALGS));
-    memcpy(result+offset, OQS_COMPILE_CFLAGS, strlen(OQS_COMPILE_CFLAGS));
-    offset += strlen(OQS_COMPILE_CFLAGS);
-#else 
-    const char* OQSKEMALGS = "";
-    char* result =  OPENSSL_zalloc(OQS_OPENSSL_KEM_algs_length*40); // OK, a bit pessimistic but this will be removed very soon...
-    memcpy(result, OQSKEMALGS, offset = strlen(OQSKEMALGS));
-#endif
-
-    result[offset++]='-';
     int i;
-    for (i=0; i<OQS_OPENSSL_KEM_algs_length;i++) {
-       const char* name = OBJ_nid2sn(oqssl_kem_nids_list[i]);
-       if (OQS_KEM_alg_is_enabled(get_oqs_alg_name(oqssl_kem_nids_list[i]))) {
-           int l = strlen(name);
-           memcpy(result+offset, name, l);
-           if (i<OQS_OPENSSL_KEM_algs_length-1) {
-              result[offset+l]=',';
-              offset = offset+l+1;
-           }
-       }
+
+    if (!RUN_ONCE(&oqs_alg_table_once, do_oqs_alg_table_init))
+        return NULL;
+    for (i = 0; i < OQS_OPENSSL_KEM_algs_length; i++) {
+        if (oqssl_kem_nids_list[i] == openssl_nid)
+            return oqs_kem_table[i];
     }
-    return result;
+    return NULL;
 }
 
 /*
- * Returns options when running OQS SIG, e.g., in openssl speed
+ * Returns the shared OQS signature descriptor for a PQ or hybrid signature
+ * NID, or NULL if the algorithm is unknown or not enabled in liboqs. The
+ * result must not be freed.
  */
-const char *OQSSIG_options(void)
+const OQS_SIG *get_oqs_sig(int openssl_nid)
 {
-    int offset;
-// TODO: Revisit which OQS_COMPILE_FLAGS to show
-#ifdef OQS_COMPILE_CFLAGS
-    const char* OQSSIGALGS = "OQS SIG build : ";
-    char* result =  OPENSSL_zalloc(strlen(OQS_COMPILE_CFLAGS)+OQS_OPENSSL_SIG_algs_length*40); // OK, a bit pessimistic but this will be removed very soon...
-    memcpy(result, OQSSIGALGS, offset = strlen(OQSSIGALGS));
-    memcpy(result+offset, OQS_COMPILE_CFLAGS, strlen(OQS_COMPILE_CFLAGS));
-    offset += strlen(OQS_COMPILE_CFLAGS);
-#else
-    const char* OQSSIGALGS = "";
-    char* result =  OPENSSL_zalloc(OQS_OPENSSL_SIG_algs_length*40); // OK, a bit pessimistic but this will be removed very soon...
-    memcpy(result, OQSSIGALGS, offset = strlen(OQSSIGALGS));
-#endif
+    int i, pq_nid = get_oqs_nid(openssl_nid);
+
+    if (pq_nid != 0)
+        openssl_nid = pq_nid;
+    if (!RUN_ONCE(&oqs_alg_table_once, do_oqs_alg_table_init))
+        return NULL;
+    for (i = 0; i < OQS_OPENSSL_SIG_algs_length; i++) {
+        if (oqssl_sig_nids_list[i] == openssl_nid)
+            return oqs_sig_table[i];
+    }
+    return NULL;
+}
 
-    result[offset++]='-';
+void oqs_alg_table_cleanup_int(void)
+{
     int i;
-    for (i=0; i<OQS_OPENSSL_SIG_algs_length;i++) {
-       const char* name = OBJ_nid2sn(oqssl_sig_nids_list[i]);
-       if (OQS_SIG_alg_is_enabled(get_oqs_alg_name(oqssl_sig_nids_list[i]))) {
-           int l = strlen(name);
-           memcpy(result+offset, name, l);
-           if (i<OQS_OPENSSL_SIG_algs_length-1) {
-              result[offset+l]=',';
-              offset = offset+l+1;
-           }
-       }
+
+    if (!oqs_alg_table_inited)
+        return;
+    for (i = 0; i < OQS_OPENSSL_KEM_algs_length; i++) {
+        OQS_KEM_free(oqs_kem_table[i]);
+        oqs_kem_table[i] = NULL;
+    }
+    for (i = 0; i < OQS_OPENSSL_SIG_algs_length; i++) {
+        OQS_SIG_free(oqs_sig_table[i]);
+        oqs_sig_table[i] = NULL;
     }
-    return result;
 }
 
 /*
- * Returns the security level in bits for an OQS alg.
+ * The optimised implementation of the plain OQS algorithm |nid| that liboqs
+ * was built with, as far as its OQS_ENABLE_* macros tell, or NULL if it only
+ * has the portable one.
  */
-static int get_oqs_security_bits(int openssl_nid)
+static const char *oqs_built_impl(int nid)
 {
-  switch (openssl_nid)
-  {
-///// OQS_TEMPLATE_FRAGMENT_GET_SIG_SECURITY_BITS_START
+    switch (nid) {
+///// OQS_TEMPLATE_FRAGMENT_ASSIGN_BUILT_IMPL_START
+#if defined(OQS_ENABLE_KEM_frodokem_640_aes_avx2)
+    case NID_frodo640aes:
+        return "avx2";
+#elif defined(OQS_ENABLE_KEM_frodokem_640_aes_aarch64)
+    case NID_frodo640aes:
+        return "aarch64";
+#endif
+#if defined(OQS_ENABLE_KEM_frodokem_640_shake_avx2)
+    case NID_frodo640shake:
+        return "avx2";
+#elif defined(OQS_ENABLE_KEM_frodokem_640_shake_aarch64)
+    case NID_frodo640shake:
+        return "aarch64";
+#endif
+#if defined(OQS_ENABLE_KEM_frodokem_976_aes_avx2)
+    case NID_frodo976aes:
+        return "avx2";
+#elif defined(OQS_ENABLE_KEM_frodokem_976_aes_aarch64)
+    case NID_frodo976aes:
+        return "aarch64";
+#endif
+#if defined(OQS_ENABLE_KEM_frodokem_976_shake_avx2)
+    case NID_frodo976shake:
+        return "avx2";
+#elif defined(OQS_ENABLE_KEM_frodokem_976_shake_aarch64)
+    case NID_frodo976shake:
+        return "aarch64";
+#endif
+#if defined(OQS_ENABLE_KEM_frodokem_1344_aes_avx2)
+    case NID_frodo1344aes:
+        return "avx2";
+#elif defined(OQS_ENABLE_KEM_frodokem_1344_aes_aarch64)
+    case NID_frodo1344aes:
+        return "aarch64";
+#endif
+#if defined(OQS_ENABLE_KEM_frodokem_1344_shake_avx2)
+    case NID_frodo1344shake:
+        return "avx2";
+#elif defined(OQS_ENABLE_KEM_frodokem_1344_shake_aarch64)
+    case NID_frodo1344shake:
+        return "aarch64";
+#endif
+#if defined(OQS_ENABLE_KEM_kyber_512_avx2)
+    case NID_kyber512:
+        return "avx2";
+#elif defined(OQS_ENABLE_KEM_kyber_512_aarch64)
+    case NID_kyber512:
+        return "aarch64";
+#endif
+#if defined(OQS_ENABLE_KEM_kyber_768_avx2)
+    case NID_kyber768:
+        return "avx2";
+#elif defined(OQS_ENABLE_KEM_kyber_768_aarch64)
+    case NID_kyber768:
+        return "aarch64";
+#endif
+#if defined(OQS_ENABLE_KEM_kyber_1024_avx2)
+    case NID_kyber1024:
+        return "avx2";
+#elif defined(OQS_ENABLE_KEM_kyber_1024_aarch64)
+    case NID_kyber1024:
+        return "aarch64";
+#endif
+#if defined(OQS_ENABLE_KEM_bike_l1_avx2)
+    case NID_bikel1:
+        return "avx2";
+#elif defined(OQS_ENABLE_KEM_bike_l1_aarch64)
+    case NID_bikel1:
+        return "aarch64";
+#endif
+#if defined(OQS_ENABLE_KEM_bike_l3_avx2)
+    case NID_bikel3:
+        return "avx2";
+#elif defined(OQS_ENABLE_KEM_bike_l3_aarch64)
+    case NID_bikel3:
+        return "aarch64";
+#endif
+#if defined(OQS_ENABLE_KEM_bike_l5_avx2)
+    case NID_bikel5:
+        return "avx2";
+#elif defined(OQS_ENABLE_KEM_bike_l5_aarch64)
+    case NID_bikel5:
+        return "aarch64";
+#endif
+#if defined(OQS_ENABLE_KEM_hqc_128_avx2)
+    case NID_hqc128:
+        return "avx2";
+#elif defined(OQS_ENABLE_KEM_hqc_128_aarch64)
+    case NID_hqc128:
+        return "aarch64";
+#endif
+#if defined(OQS_ENABLE_KEM_hqc_192_avx2)
+    case NID_hqc192:
+        return "avx2";
+#elif defined(OQS_ENABLE_KEM_hqc_192_aarch64)
+    case NID_hqc192:
+        return "aarch64";
+#endif
+#if defined(OQS_ENABLE_KEM_hqc_256_avx2)
+    case NID_hqc256:
+        return "avx2";
+#elif defined(OQS_ENABLE_KEM_hqc_256_aarch64)
+    case NID_hqc256:
+        return "aarch64";
+#endif
+#if defined(OQS_ENABLE_SIG_dilithium_2_avx2)
     case NID_dilithium2:
-    case NID_p256_dilithium2:
-    case NID_rsa3072_dilithium2:
-      return 128;
+        return "avx2";
+#elif defined(OQS_ENABLE_SIG_dilithium_2_aarch64)
+    case NID_dilithium2:
+        return "aarch64";
+#endif
+#if defined(OQS_ENABLE_SIG_dilithium_3_avx2)
     case NID_dilithium3:
-    case NID_p384_dilithium3:
-      return 192;
+        return "avx2";
+#elif defined(OQS_ENABLE_SIG_dilithium_3_aarch64)
+    case NID_dilithium3:
+        return "aarch64";
+#endif
+#if defined(OQS_ENABLE_SIG_dilithium_5_avx2)
     case NID_dilithium5:
-    case NID_p521_dilithium5:
-      return 256;
+        return "avx2";
+#elif defined(OQS_ENABLE_SIG_dilithium_5_aarch64)
+    case NID_dilithium5:
+        return "aarch64";
+#endif
+#if defined(OQS_ENABLE_SIG_falcon_512_avx2)
     case NID_falcon512:
-    case NID_p256_falcon512:
-    case NID_rsa3072_falcon512:
-      return 128;
+        return "avx2";
+#elif defined(OQS_ENABLE_SIG_falcon_512_aarch64)
+    case NID_falcon512:
+        return "aarch64";
+#endif
+#if defined(OQS_ENABLE_SIG_falcon_1024_avx2)
     case NID_falcon1024:
-    case NID_p521_falcon1024:
-      return 256;
+        return "avx2";
+#elif defined(OQS_ENABLE_SIG_falcon_1024_aarch64)
+    case NID_falcon1024:
+        return "aarch64";
+#endif
+#if defined(OQS_ENABLE_SIG_sphincs_sha2_128f_simple_avx2)
     case NID_sphincssha2128fsimple:
-    case NID_p256_sphincssha2128fsimple:
-    case NID_rsa3072_sphincssha2128fsimple:
-      return 128;
+        return "avx2";
+#elif defined(OQS_ENABLE_SIG_sphincs_sha2_128f_simple_aarch64)
+    case NID_sphincssha2128fsimple:
+        return "aarch64";
+#endif
+#if defined(OQS_ENABLE_SIG_sphincs_sha2_128s_simple_avx2)
     case NID_sphincssha2128ssimple:
-    case NID_p256_sphincssha2128ssimple:
-    case NID_rsa3072_sphincssha2128ssimple:
-      return 128;
+        return "avx2";
+#elif defined(OQS_ENABLE_SIG_sphincs_sha2_128s_simple_aarch64)
+    case NID_sphincssha2128ssimple:
+        return "aarch64";
+#endif
+#if defined(OQS_ENABLE_SIG_sphincs_sha2_192f_simple_avx2)
     case NID_sphincssha2192fsimple:
-    case NID_p384_sphincssha2192fsimple:
-      return 192;
+        return "avx2";
+#elif defined(OQS_ENABLE_SIG_sphincs_sha2_192f_simple_aarch64)
+    case NID_sphincssha2192fsimple:
+        return "aarch64";
+#endif
+#if defined(OQS_ENABLE_SIG_sphincs_shake_128f_simple_avx2)
     case NID_sphincsshake128fsimple:
-    case NID_p256_sphincsshake128fsimple:
-    case NID_rsa3072_sphincsshake128fsimple:
-      return 128;
-///// OQS_TEMPLATE_FRAGMENT_GET_SIG_SECURITY_BITS_END
+        return "avx2";
+#elif defined(OQS_ENABLE_SIG_sphincs_shake_128f_simple_aarch64)
+    case NID_sphincsshake128fsimple:
+        return "aarch64";
+#endif
+///// OQS_TEMPLATE_FRAGMENT_ASSIGN_BUILT_IMPL_END
     default:
-      return 0;
-  }
+        return NULL;
+    }
+}
+
+/*
+ * Returns the implementation that liboqs runs on this CPU for the OQS KEM or
+ * signature |openssl_nid|, or for the one a hybrid signature is built on:
+ * "avx2", "aarch64" or "portable", or NULL if the algorithm is unknown or
+ * not enabled in liboqs. A liboqs built with OQS_DIST_BUILD picks the
+ * implementation when it runs, any other one always runs the one it was
+ * built with.
+ */
+const char *get_oqs_alg_impl(int openssl_nid)
+{
+    const char *impl;
+    int pq_nid = get_oqs_nid(openssl_nid);
+
+    if (pq_nid != 0)
+        openssl_nid = pq_nid;
+    if (get_oqs_kem(openssl_nid) == NULL && get_oqs_sig(openssl_nid) == NULL)
+        return NULL;
+    if ((impl = oqs_built_impl(openssl_nid)) == NULL)
+        return "portable";
+#ifdef OQS_DIST_BUILD
+    if (strcmp(impl, "avx2") == 0 && !OQS_CPU_has_extension(OQS_CPU_EXT_AVX2))
+        return "portable";
+    if (strcmp(impl, "aarch64") == 0
+            && !OQS_CPU_has_extension(OQS_CPU_EXT_ARM_NEON))
+        return "portable";
+#endif
+    return impl;
+}
+
+/*
+ * liboqs probes the CPU itself, so masking AVX2 out with OPENSSL_ia32cap
+ * does not keep it from running its AVX2 implementations. Returns 1 if
+ * |impl| is one of those while OPENSSL_ia32cap masks AVX2 out.
+ */
+static int oqs_impl_ignores_ia32cap(const char *impl)
+{
+#if defined(OPENSSL_CPUID_OBJ) && (defined(__i386) || defined(__i386__) \
+                                   || defined(_M_IX86) || defined(__x86_64) \
+                                   || defined(_M_AMD64) || defined(_M_X64))
+    return strcmp(impl, "avx2") == 0 && (OPENSSL_ia32cap_P[2] & (1 << 5)) == 0;
+#else
+    return 0;
+#endif
+}
+
+/*
+ * Lists the enabled algorithms among the |num| |nids| with the
+ * implementation liboqs runs for each, after |build|
+ */
+static const char *oqs_options(const char *build, const int *nids, int num)
+{
+    size_t len = strlen(build) + num * 48 + 64, off;
+    char *result = OPENSSL_malloc(len);
+    const char *impl;
+    int i, ignored = 0;
+
+    if (result == NULL)
+        return "";
+    off = BIO_snprintf(result, len, "%s-", build);
+    for (i = 0; i < num; i++) {
+        if ((impl = get_oqs_alg_impl(nids[i])) == NULL)
+            continue;
+        off += BIO_snprintf(result + off, len - off, "%s%s(%s)",
+                            result[off - 1] == '-' ? "" : ",",
+                            OBJ_nid2sn(nids[i]), impl);
+        ignored |= oqs_impl_ignores_ia32cap(impl);
+    }
+    if (ignored)
+        BIO_snprintf(result + off, len - off,
+                     " (liboqs does not honour OPENSSL_ia32cap)");
+    return result;
+}
+
+/*
+ * Returns options when running OQS KEM, e.g., in openssl speed
+ */
+const char *OQSKEM_options(void)
+{
+#ifdef OQS_COMPILE_CFLAGS
+    return oqs_options("OQS KEM build : " OQS_COMPILE_CFLAGS,
+                       oqssl_kem_nids_list, OQS_OPENSSL_KEM_algs_length);
+#else
+    return oqs_options("", oqssl_kem_nids_list, OQS_OPENSSL_KEM_algs_length);
+#endif
+}
+
+/*
+ * Returns options when running OQS SIG, e.g., in openssl speed
+ */
+const char *OQSSIG_options(void)
+{
+#ifdef OQS_COMPILE_CFLAGS
+    return oqs_options("OQS SIG build : " OQS_COMPILE_CFLAGS,
+                       oqssl_sig_nids_list, OQS_OPENSSL_SIG_algs_length);
+#else
+    return oqs_options("", oqssl_sig_nids_list, OQS_OPENSSL_SIG_algs_length);
+#endif
+}
+
+/*
+ * Returns the security level in bits for an OQS alg.
+ */
+static int get_oqs_security_bits(int openssl_nid)
+{
+  const OQS_SIG_META *meta = get_oqs_sig_meta(openssl_nid);
+
+  return meta != NULL ? meta->security_bits : 0;
 }
 
 static int is_EC_nid(int nid) {
@@ -533,17 +833,21 @@ static void oqs_pkey_ctx_free(OQS_KEY* key) {
   }
   if (key->s) {
     privkey_len = key->s->length_secret_key;
-    OQS_SIG_free(key->s);
   }
   if (key->privkey) {
     OPENSSL_secure_clear_free(key->privkey, privkey_len);
   }
-  if (key->pubkey) {
+  if (key->pubkey_buf) {
+    ASN1_SHARED_BUF_free(key->pubkey_buf);
+  } else if (key->pubkey) {
     OPENSSL_free(key->pubkey);
   }
+  EVP_PKEY_CTX_free(key->classical_sign_ctx);
+  EVP_PKEY_CTX_free(key->classical_verify_ctx);
   if (key->classical_pkey) {
     EVP_PKEY_free(key->classical_pkey);
   }
+  CRYPTO_THREAD_lock_free(key->lock);
   OPENSSL_free(key);
 }
 
@@ -554,17 +858,26 @@ static void oqs_pkey_ctx_free(OQS_KEY* key) {
  */
 static int oqs_key_init(OQS_KEY **p_oqs_key, int nid, oqs_key_type_t keytype) {
     OQS_KEY *oqs_key = NULL;
-    const char* oqs_alg_name = get_oqs_alg_name(nid);
+    const OQS_SIG_META *meta = get_oqs_sig_meta(nid);
 
+    if (meta == NULL) {
+      ECerr(EC_F_OQS_KEY_INIT, EC_R_NO_SUCH_OQS_ALGORITHM);
+      return 0;
+    }
     oqs_key = OPENSSL_zalloc(sizeof(*oqs_key));
     if (oqs_key == NULL) {
       ECerr(0, ERR_R_MALLOC_FAILURE);
       goto err;
     }
     oqs_key->nid = nid;
-    if (!OQS_SIG_alg_is_enabled(oqs_alg_name))
-      fprintf(stderr, "Warning: OQS algorithm '%s' not enabled.\n", oqs_alg_name);
-    oqs_key->s = OQS_SIG_new(oqs_alg_name);
+    oqs_key->meta = meta;
+    if ((oqs_key->lock = CRYPTO_THREAD_lock_new()) == NULL) {
+      ECerr(EC_F_OQS_KEY_INIT, ERR_R_MALLOC_FAILURE);
+      goto err;
+    }
+    if (!OQS_SIG_alg_is_enabled(meta->oqs_name))
+      fprintf(stderr, "Warning: OQS algorithm '%s' not enabled.\n", meta->oqs_name);
+    oqs_key->s = get_oqs_sig(nid);
     if (oqs_key->s == NULL) {
       /* TODO: Perhaps even check if the alg is available earlier in the stack. */
       ECerr(EC_F_OQS_KEY_INIT, EC_R_NO_SUCH_OQS_ALGORITHM);
@@ -583,7 +896,6 @@ static int oqs_key_init(OQS_KEY **p_oqs_key, int nid, oqs_key_type_t keytype) {
         goto err;
       }
     }
-    oqs_key->security_bits = get_oqs_security_bits(nid);
     *p_oqs_key = oqs_key;
     return 1;
 
@@ -606,7 +918,7 @@ static int oqs_pub_encode(X509_PUBKEY *pk, const EVP_PKEY *pkey)
     /* determine the length of the key */
     pubkey_len = oqs_key->s->length_public_key;
     if (is_hybrid) {
-      max_classical_pubkey_len = get_classical_key_len(KEY_TYPE_PUBLIC, get_classical_nid(oqs_key->nid));
+      max_classical_pubkey_len = oqs_key->meta->classical->pubkey_len;
       pubkey_len += (SIZE_OF_UINT32 + max_classical_pubkey_len);
     }
     penc = OPENSSL_malloc(pubkey_len);
@@ -651,8 +963,9 @@ static int oqs_pub_decode(EVP_PKEY *pkey, X509_PUBKEY *pubkey)
     int pklen, max_pubkey_len;
     X509_ALGOR *palg;
     OQS_KEY *oqs_key = NULL;
+    ASN1_SHARED_BUF *buf;
     int id = pkey->ameth->pkey_id;
-    int is_hybrid = is_oqs_hybrid_alg(id);
+    const OQS_CLASSICAL_META *classical;
     int index = 0;
 
     if (!X509_PUBKEY_get0_param(NULL, &p, &pklen, &palg, pubkey)) {
@@ -681,9 +994,10 @@ static int oqs_pub_decode(EVP_PKEY *pkey, X509_PUBKEY *pubkey)
       return 0;
     }
 
+    classical = oqs_key->meta->classical;
     max_pubkey_len = oqs_key->s->length_public_key;
-    if (is_hybrid) {
-      max_pubkey_len += (SIZE_OF_UINT32 + get_classical_key_len(KEY_TYPE_PUBLIC, get_classical_nid(id)));
+    if (classical != NULL) {
+      max_pubkey_len += (SIZE_OF_UINT32 + classical->pubkey_len);
     }
 
     if (pklen > max_pubkey_len) {
@@ -692,8 +1006,8 @@ static int oqs_pub_decode(EVP_PKEY *pkey, X509_PUBKEY *pubkey)
     }
 
     /* if hybrid, decode classical public key */
-    if (is_hybrid) {
-      int classical_id = get_classical_nid(id);
+    if (classical != NULL) {
+      int classical_id = classical->nid;
       int actual_classical_pubkey_len;
       DECODE_UINT32(actual_classical_pubkey_len, p);
       if (is_EC_nid(classical_id)) {
@@ -713,7 +1027,19 @@ static int oqs_pub_decode(EVP_PKEY *pkey, X509_PUBKEY *pubkey)
       index += (SIZE_OF_UINT32 + actual_classical_pubkey_len);
     }
     /* decode PQC public key */
-    memcpy(oqs_key->pubkey, p + index, oqs_key->s->length_public_key);
+    if (pklen - index < (int)oqs_key->s->length_public_key) {
+      ECerr(EC_F_OQS_PUB_DECODE, EC_R_WRONG_LENGTH);
+      goto err;
+    }
+    if ((buf = x509_pubkey_get0_shared(pubkey)) != NULL
+        && ASN1_SHARED_BUF_up_ref(buf)) {
+      /* The key lives in a shared certificate encoding: point into it */
+      OPENSSL_free(oqs_key->pubkey);
+      oqs_key->pubkey = (uint8_t *)(p + index);
+      oqs_key->pubkey_buf = buf;
+    } else {
+      memcpy(oqs_key->pubkey, p + index, oqs_key->s->length_public_key);
+    }
 
     EVP_PKEY_assign(pkey, id, oqs_key);
     return 1;
@@ -747,27 +1073,28 @@ static int oqs_pub_cmp(const EVP_PKEY *a, const EVP_PKEY *b)
 static int oqs_priv_decode(EVP_PKEY *pkey, const PKCS8_PRIV_KEY_INFO *p8)
 {
     const unsigned char *p;
-    int plen, max_privkey_len;
-    ASN1_OCTET_STRING *oct = NULL;
+    int plen, tag, xclass, inf;
+    long len;
     const X509_ALGOR *palg;
     OQS_KEY *oqs_key = NULL;
     int id = pkey->ameth->pkey_id;
-    int is_hybrid = is_oqs_hybrid_alg(id);
-    int index = 0;
+    const OQS_CLASSICAL_META *classical;
+    size_t pq_len, index = 0;
 
     if (!PKCS8_pkey_get0(NULL, &p, &plen, &palg, p8))
         return 0;
 
-    oct = d2i_ASN1_OCTET_STRING(NULL, &p, plen);
-    if (oct == NULL) {
-        p = NULL;
-        plen = 0;
-    } else {
-        p = ASN1_STRING_get0_data(oct);
-        plen = ASN1_STRING_length(oct);
+    /*
+     * The OCTET STRING contains first the private key, then the public key;
+     * its content is read in place rather than from a decoded copy, so that
+     * no stray copy of the secret is left behind on the heap.
+     */
+    inf = ASN1_get_object(&p, &len, &tag, &xclass, plen);
+    if (inf != 0 || tag != V_ASN1_OCTET_STRING || xclass != V_ASN1_UNIVERSAL) {
+      ECerr(EC_F_OQS_PRIV_DECODE, EC_R_DECODE_ERROR);
+      return 0;
     }
 
-    /* oct contains first the private key, then the public key */
     if (palg != NULL) {
       int ptype;
 
@@ -784,21 +1111,24 @@ static int oqs_priv_decode(EVP_PKEY *pkey, const PKCS8_PRIV_KEY_INFO *p8)
       return 0;
     }
 
-    max_privkey_len = oqs_key->s->length_secret_key + oqs_key->s->length_public_key;
-    if (is_hybrid) {
-      max_privkey_len += (SIZE_OF_UINT32 + get_classical_key_len(KEY_TYPE_PRIVATE, get_classical_nid(oqs_key->nid)));
-    }
-
-    if (plen > max_privkey_len) {
-      ECerr(EC_F_OQS_PRIV_DECODE, EC_R_KEY_LENGTH_WRONG);
-      goto err;
-    }
+    classical = oqs_key->meta->classical;
+    pq_len = oqs_key->s->length_secret_key + oqs_key->s->length_public_key;
 
     /* if hybrid, decode classical private key */
-    if (is_hybrid) {
-      int classical_id = get_classical_nid(id);
-      int actual_classical_privkey_len;
+    if (classical != NULL) {
+      int classical_id = classical->nid;
+      uint32_t actual_classical_privkey_len;
+
+      if ((size_t)len < SIZE_OF_UINT32) {
+        ECerr(EC_F_OQS_PRIV_DECODE, EC_R_KEY_LENGTH_WRONG);
+        goto err;
+      }
       DECODE_UINT32(actual_classical_privkey_len, p);
+      if (actual_classical_privkey_len > (uint32_t)classical->privkey_len
+          || (size_t)len - SIZE_OF_UINT32 < actual_classical_privkey_len) {
+        ECerr(EC_F_OQS_PRIV_DECODE, EC_R_KEY_LENGTH_WRONG);
+        goto err;
+      }
       if (is_EC_nid(classical_id)) {
 	if (!decode_EC_key(KEY_TYPE_PRIVATE, classical_id, p + SIZE_OF_UINT32, actual_classical_privkey_len, oqs_key)) {
 	  ECerr(EC_F_OQS_PRIV_DECODE, ERR_R_FATAL);
@@ -814,6 +1144,12 @@ static int oqs_priv_decode(EVP_PKEY *pkey, const PKCS8_PRIV_KEY_INFO *p8)
       }
       index += (SIZE_OF_UINT32 + actual_classical_privkey_len);
     }
+
+    if ((size_t)len - index != pq_len) {
+      ECerr(EC_F_OQS_PRIV_DECODE, EC_R_KEY_LENGTH_WRONG);
+      goto err;
+    }
+
     /* decode private key */
     memcpy(oqs_key->privkey, p + index, oqs_key->s->length_secret_key);
     index += oqs_key->s->length_secret_key;
@@ -823,7 +1159,6 @@ static int oqs_priv_decode(EVP_PKEY *pkey, const PKCS8_PRIV_KEY_INFO *p8)
 
     EVP_PKEY_assign(pkey, pkey->ameth->pkey_id, oqs_key);
 
-    ASN1_OCTET_STRING_free(oct);
     return 1;
 
  err:
@@ -834,10 +1169,9 @@ static int oqs_priv_decode(EVP_PKEY *pkey, const PKCS8_PRIV_KEY_INFO *p8)
 static int oqs_priv_encode(PKCS8_PRIV_KEY_INFO *p8, const EVP_PKEY *pkey)
 {
     const OQS_KEY *oqs_key = (OQS_KEY*) pkey->pkey.ptr;
-    ASN1_OCTET_STRING oct;
-    unsigned char *buf = NULL, *penc = NULL;
-    uint32_t max_classical_privkey_len = 0, classical_privkey_len = 0;
-    int buflen, penclen, index = 0;
+    unsigned char *penc = NULL, *content, *p;
+    int max_len, max_hdr_len, alloc_len, len, hdr_len, penclen;
+    int index = 0;
     int rv = 0;
 
     if (!oqs_key || !oqs_key->s || !oqs_key->privkey ) {
@@ -846,64 +1180,66 @@ static int oqs_priv_encode(PKCS8_PRIV_KEY_INFO *p8, const EVP_PKEY *pkey)
     }
     int is_hybrid = (oqs_key->classical_pkey != NULL);
 
-    /* determine the length of key */
-    buflen = oqs_key->s->length_secret_key + oqs_key->s->length_public_key;
-    if (is_hybrid) {
-      max_classical_privkey_len = get_classical_key_len(KEY_TYPE_PRIVATE, get_classical_nid(oqs_key->nid));
-      buflen += (SIZE_OF_UINT32 + max_classical_privkey_len);
-    }
-    buf = OPENSSL_secure_malloc(buflen);
-    if (buf == NULL) {
+    /*
+     * The key is written straight into the DER OCTET STRING handed over to
+     * |p8|, leaving room for the header of the longest possible content; the
+     * content is moved down once the actual classical key length is known.
+     */
+    max_len = oqs_key->s->length_secret_key + oqs_key->s->length_public_key;
+    if (is_hybrid)
+      max_len += (SIZE_OF_UINT32 + oqs_key->meta->classical->privkey_len);
+    max_hdr_len = ASN1_object_size(0, max_len, V_ASN1_OCTET_STRING) - max_len;
+    alloc_len = max_hdr_len + max_len;
+    penc = OPENSSL_malloc(alloc_len);
+    if (penc == NULL) {
       ECerr(EC_F_OQS_PRIV_ENCODE, ERR_R_MALLOC_FAILURE);
       return rv;
     }
+    content = penc + max_hdr_len;
 
     /* if hybrid, encode classical private key */
     if (is_hybrid) {
-      unsigned char *classical_privkey = buf + SIZE_OF_UINT32; /* i2d moves the target pointer, so we copy into a temp var (leaving space for key len) */
-      int actual_classical_privkey_len = i2d_PrivateKey(oqs_key->classical_pkey, &classical_privkey);
-      if (actual_classical_privkey_len < 0 || (uint32_t) actual_classical_privkey_len > max_classical_privkey_len) {
-	/* something went wrong, or we didn't allocate enough space */
-	OPENSSL_free(buf);
+      unsigned char *classical_privkey = content + SIZE_OF_UINT32; /* i2d moves the target pointer, so we copy into a temp var (leaving space for key len) */
+      int actual_classical_privkey_len = i2d_PrivateKey(oqs_key->classical_pkey, NULL);
+
+      /* check the length first: i2d does not bound its output */
+      if (actual_classical_privkey_len <= 0
+          || actual_classical_privkey_len > oqs_key->meta->classical->privkey_len
+          || i2d_PrivateKey(oqs_key->classical_pkey, &classical_privkey) != actual_classical_privkey_len) {
         ECerr(EC_F_OQS_PRIV_ENCODE, ERR_R_FATAL);
         goto end;
       }
-      ENCODE_UINT32(buf, actual_classical_privkey_len);
-      classical_privkey_len = SIZE_OF_UINT32 + actual_classical_privkey_len;
-      index += classical_privkey_len;
+      ENCODE_UINT32(content, actual_classical_privkey_len);
+      index += SIZE_OF_UINT32 + actual_classical_privkey_len;
     }
 
     /* encode the pqc private key */
-    memcpy(buf + index, oqs_key->privkey, oqs_key->s->length_secret_key);
+    memcpy(content + index, oqs_key->privkey, oqs_key->s->length_secret_key);
     index += oqs_key->s->length_secret_key;
 
     /* encode the pqc public key */
-    memcpy(buf + index, oqs_key->pubkey, oqs_key->s->length_public_key);
-
-    /* recalculate pub key len using acutal classical len */
-    buflen = classical_privkey_len + oqs_key->s->length_secret_key + oqs_key->s->length_public_key;
-
-    oct.data = buf;
-    oct.length = buflen;
-    oct.flags = 0;
-
-    penclen = i2d_ASN1_OCTET_STRING(&oct, &penc);
-    if (penclen < 0) {
-        ECerr(EC_F_OQS_PRIV_ENCODE, ERR_R_FATAL);
-        goto end;
-    }
+    memcpy(content + index, oqs_key->pubkey, oqs_key->s->length_public_key);
+    len = index + oqs_key->s->length_public_key;
+
+    /* the header goes in front, it cannot overlap the content */
+    hdr_len = ASN1_object_size(0, len, V_ASN1_OCTET_STRING) - len;
+    p = penc;
+    ASN1_put_object(&p, 0, len, V_ASN1_OCTET_STRING, V_ASN1_UNIVERSAL);
+    if (hdr_len != max_hdr_len)
+      memmove(penc + hdr_len, content, len);
+    penclen = hdr_len + len;
+    OPENSSL_cleanse(penc + penclen, alloc_len - penclen);
 
     if (!PKCS8_pkey_set0(p8, OBJ_nid2obj(pkey->ameth->pkey_id), 0,
                          V_ASN1_UNDEF, NULL, penc, penclen)) {
-        OPENSSL_secure_clear_free(buf, buflen);
-        OPENSSL_clear_free(penc, penclen);
         ECerr(EC_F_OQS_PRIV_ENCODE, EC_R_SETTING_PARAMETERS_FAILED);
         goto end;
     }
+    penc = NULL;
     rv = 1; /* success */
 
  end:
-    OPENSSL_secure_clear_free(buf, buflen);
+    OPENSSL_clear_free(penc, alloc_len);
     return rv;
 }
 
@@ -915,9 +1251,8 @@ int oqs_size(const EVP_PKEY *pkey)
         return 0;
     }
     int sig_len = oqs_key->s->length_signature;
-    if (is_oqs_hybrid_alg(oqs_key->nid)) {
-      int classical_nid = get_classical_nid(oqs_key->nid);
-      sig_len += (SIZE_OF_UINT32 + get_classical_sig_len(classical_nid));
+    if (oqs_key->meta->classical != NULL) {
+      sig_len += (SIZE_OF_UINT32 + oqs_key->meta->classical->sig_len);
     }
     return sig_len;
 }
@@ -926,8 +1261,8 @@ static int oqs_bits(const EVP_PKEY *pkey)
 {
   OQS_KEY* oqs_key = (OQS_KEY*) pkey->pkey.ptr;
   int pubkey_len = oqs_key->s->length_public_key;
-  if (is_oqs_hybrid_alg(oqs_key->nid)) {
-    pubkey_len += (SIZE_OF_UINT32 + get_classical_key_len(KEY_TYPE_PUBLIC, get_classical_nid(oqs_key->nid)));
+  if (oqs_key->meta->classical != NULL) {
+    pubkey_len += (SIZE_OF_UINT32 + oqs_key->meta->classical->pubkey_len);
   }
   /* return size in bits */
   return CHAR_BIT * pubkey_len;
@@ -935,7 +1270,7 @@ static int oqs_bits(const EVP_PKEY *pkey)
 
 static int oqs_security_bits(const EVP_PKEY *pkey)
 {
-    return ((OQS_KEY*) pkey->pkey.ptr)->security_bits; /* already accounts for hybrid */
+    return ((OQS_KEY*) pkey->pkey.ptr)->meta->security_bits; /* already accounts for hybrid */
 }
 
 static void oqs_free(EVP_PKEY *pkey)
@@ -953,13 +1288,13 @@ static int oqs_key_print(BIO *bp, const EVP_PKEY *pkey, int indent,
                          ASN1_PCTX *ctx, oqs_key_type_t keytype)
 {
     const OQS_KEY *oqs_key = (OQS_KEY*) pkey->pkey.ptr;
-    int is_hybrid = is_oqs_hybrid_alg(oqs_key->nid);
+    int is_hybrid = oqs_key->meta->classical != NULL;
     /* alg name to print, just keep the oqs part for hybrid */
-    const char *nm = OBJ_nid2ln(is_hybrid ? get_oqs_nid(oqs_key->nid) : pkey->ameth->pkey_id);
+    const char *nm = OBJ_nid2ln(oqs_key->meta->oqs_nid);
     int classical_id;
 
     if (is_hybrid) {
-      classical_id = get_classical_nid(oqs_key->nid);
+      classical_id = oqs_key->meta->classical->nid;
     }
 
     if (keytype == KEY_TYPE_PRIVATE) {
@@ -1099,6 +1434,21 @@ int oqs_ameth_pkey_ctrl(EVP_PKEY *pkey, int op, long arg1, void *arg2) {
    case ASN1_PKEY_CTRL_DEFAULT_MD_NID:
 	*(int *)arg2 = NID_sha512;
 	return 1;
+   case ASN1_PKEY_CTRL_PKCS7_SIGN:
+      if (arg1 == 0) {
+            int snid, hnid;
+            X509_ALGOR *alg1, *alg2;
+            PKCS7_SIGNER_INFO_get0_algs(arg2, NULL, &alg1, &alg2);
+            if (alg1 == NULL || alg1->algorithm == NULL)
+                return -1;
+            hnid = OBJ_obj2nid(alg1->algorithm);
+            if (hnid == NID_undef)
+                return -1;
+            if (!OBJ_find_sigid_by_algs(&snid, hnid, EVP_PKEY_id(pkey)))
+                return -1;
+            X509_ALGOR_set0(alg2, OBJ_nid2obj(snid), V_ASN1_UNDEF, 0);
+      }
+      return 1;
 #ifndef OPENSSL_NO_CMS
    case ASN1_PKEY_CTRL_CMS_SIGN:
       if (arg1 == 0) {
@@ -1158,21 +1508,21 @@ static int pkey_oqs_keygen(EVP_PKEY_CTX *ctx, EVP_PKEY *pkey)
 {
     OQS_KEY *oqs_key = NULL;
     int id = ctx->pmeth->pkey_id;
-    int is_hybrid = is_oqs_hybrid_alg(id);
+    int is_hybrid;
     int classical_id = 0;
     EVP_PKEY_CTX *param_ctx = NULL, *keygen_ctx = NULL;
     EVP_PKEY *param_pkey = NULL;
-    const int rsa_size = 3072;
     int rv = 0;
 
     if (!oqs_key_init(&oqs_key, id, 1)) {
       ECerr(EC_F_PKEY_OQS_KEYGEN, ERR_R_FATAL);
       goto end;
     }
+    is_hybrid = oqs_key->meta->classical != NULL;
 
     /* generate the classical key pair */
     if (is_hybrid) {
-      classical_id = get_classical_nid(id);
+      classical_id = oqs_key->meta->classical->nid;
       if (is_EC_nid(classical_id)) {
 	if(!(param_ctx = EVP_PKEY_CTX_new_id(NID_X9_62_id_ecPublicKey, NULL)) ||
 	   !EVP_PKEY_paramgen_init(param_ctx) ||
@@ -1196,10 +1546,13 @@ static int pkey_oqs_keygen(EVP_PKEY_CTX *ctx, EVP_PKEY *pkey)
       };
 
       if ( classical_id == EVP_PKEY_RSA ) {
-	if(!EVP_PKEY_CTX_set_rsa_keygen_bits(keygen_ctx, rsa_size)) {
+	if(!EVP_PKEY_CTX_set_rsa_keygen_bits(keygen_ctx, OQS_RSA_KEYGEN_BITS)) {
 	  ECerr(EC_F_PKEY_OQS_KEYGEN, ERR_R_FATAL);
 	  goto end;
 	}
+	/* search for the primes on the pool of the hybrid context, if any */
+	EVP_PKEY_CTX_set0_worker_pool(keygen_ctx,
+				      EVP_PKEY_CTX_get0_worker_pool(ctx));
       }
       if(!EVP_PKEY_keygen(keygen_ctx, &oqs_key->classical_pkey)) {
 	  ECerr(EC_F_PKEY_OQS_KEYGEN, ERR_R_FATAL);
@@ -1224,15 +1577,76 @@ static int pkey_oqs_keygen(EVP_PKEY_CTX *ctx, EVP_PKEY *pkey)
     return rv;
 }
 
-static int pkey_oqs_digestsign(EVP_MD_CTX *ctx, unsigned char *sig,
-                               size_t *siglen, const unsigned char *tbs,
-                               size_t tbslen)
+/*
+ * Returns the digest used to hash the data signed by the classical half of a
+ * hybrid scheme; classical schemes can't sign arbitrarily large data.
+ */
+static const EVP_MD *get_classical_md(const OQS_KEY *oqs_key)
+{
+    switch (oqs_key->s->claimed_nist_level) {
+    case 1:
+      return EVP_sha256();
+    case 2:
+    case 3:
+      return EVP_sha384();
+    case 4:
+    case 5:
+    default:
+      return EVP_sha512();
+    }
+}
+
+/*
+ * Returns a signing (or verification, if |verify| is set) context for the
+ * classical key of |oqs_key|, to be freed by the caller. The first call sets
+ * up a context with the padding and digest of the scheme and caches it in
+ * the key; later calls only duplicate it, so concurrent operations on one key
+ * each get their own copy.
+ */
+static EVP_PKEY_CTX *oqs_classical_ctx(OQS_KEY *oqs_key, int verify)
 {
-    const OQS_KEY *oqs_key = (OQS_KEY*) EVP_MD_CTX_pkey_ctx(ctx)->pkey->pkey.ptr;
+    EVP_PKEY_CTX **cached = verify ? &oqs_key->classical_verify_ctx
+                                   : &oqs_key->classical_sign_ctx;
+    EVP_PKEY_CTX *ctx = NULL;
+
+    if (!CRYPTO_THREAD_read_lock(oqs_key->lock))
+      return NULL;
+    if (*cached != NULL)
+      ctx = EVP_PKEY_CTX_dup(*cached);
+    CRYPTO_THREAD_unlock(oqs_key->lock);
+    if (ctx != NULL)
+      return ctx;
+
+    if ((ctx = EVP_PKEY_CTX_new(oqs_key->classical_pkey, NULL)) == NULL ||
+        (verify ? EVP_PKEY_verify_init(ctx) : EVP_PKEY_sign_init(ctx)) <= 0 ||
+        (oqs_key->meta->classical->nid == EVP_PKEY_RSA &&
+         EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_PADDING) <= 0) ||
+        EVP_PKEY_CTX_set_signature_md(ctx, get_classical_md(oqs_key)) <= 0) {
+      EVP_PKEY_CTX_free(ctx);
+      return NULL;
+    }
+
+    if (!CRYPTO_THREAD_write_lock(oqs_key->lock))
+      return ctx;
+    if (*cached == NULL)
+      *cached = EVP_PKEY_CTX_dup(ctx);
+    CRYPTO_THREAD_unlock(oqs_key->lock);
+    return ctx;
+}
+
+/*
+ * Signs |tbs| with the PQ key and, for hybrids, the classical key. The
+ * one-shot EVP_DigestSign operation passes the message itself; the
+ * streaming and EVP_PKEY_sign operations pass the message digest.
+ */
+static int oqs_sign_tbs(EVP_PKEY_CTX *pctx, unsigned char *sig,
+                        size_t *siglen, const unsigned char *tbs,
+                        size_t tbslen)
+{
+    OQS_KEY *oqs_key = (OQS_KEY*) pctx->pkey->pkey.ptr;
     EVP_PKEY_CTX *classical_ctx_sign = NULL;
 
-    int is_hybrid = is_oqs_hybrid_alg(oqs_key->nid);
-    int classical_id = 0;
+    int is_hybrid = oqs_key->meta->classical != NULL;
     size_t max_sig_len = oqs_key->s->length_signature;
     size_t classical_sig_len = 0, oqs_sig_len = 0;
     size_t actual_classical_sig_len = 0;
@@ -1244,8 +1658,7 @@ static int pkey_oqs_digestsign(EVP_MD_CTX *ctx, unsigned char *sig,
       return rv;
     }
     if (is_hybrid) {
-      classical_id = get_classical_nid(oqs_key->nid);
-      actual_classical_sig_len = get_classical_sig_len(classical_id);
+      actual_classical_sig_len = oqs_key->meta->classical->sig_len;
       max_sig_len += (SIZE_OF_UINT32 + actual_classical_sig_len);
     }
 
@@ -1260,52 +1673,23 @@ static int pkey_oqs_digestsign(EVP_MD_CTX *ctx, unsigned char *sig,
     }
 
     if (is_hybrid) {
-      const EVP_MD *classical_md;
-      int digest_len;
-      unsigned char digest[SHA512_DIGEST_LENGTH]; /* init with max length */
+      unsigned int digest_len;
+      unsigned char digest[EVP_MAX_MD_SIZE];
 
-      if ((classical_ctx_sign = EVP_PKEY_CTX_new(oqs_key->classical_pkey, NULL)) == NULL ||
-	  EVP_PKEY_sign_init(classical_ctx_sign) <= 0) {
+      if ((classical_ctx_sign = oqs_classical_ctx(oqs_key, 0)) == NULL) {
         ECerr(EC_F_PKEY_OQS_DIGESTSIGN, ERR_R_FATAL);
         goto end;
       }
-      if (classical_id == EVP_PKEY_RSA) {
-	if (EVP_PKEY_CTX_set_rsa_padding(classical_ctx_sign, RSA_PKCS1_PADDING) <= 0) {
+      if (!EVP_Digest(tbs, tbslen, digest, &digest_len,
+                      get_classical_md(oqs_key), NULL)) {
         ECerr(EC_F_PKEY_OQS_DIGESTSIGN, ERR_R_FATAL);
         goto end;
-	}
-      }
-
-      /* classical schemes can't sign arbitrarily large data; we hash it first */
-      switch (oqs_key->s->claimed_nist_level) {
-      case 1:
-	classical_md = EVP_sha256();
-	digest_len = SHA256_DIGEST_LENGTH;
-	SHA256(tbs, tbslen, (unsigned char*) &digest);
-	break;
-      case 2:
-      case 3:
-	classical_md = EVP_sha384();
-	digest_len = SHA384_DIGEST_LENGTH;
-	SHA384(tbs, tbslen, (unsigned char*) &digest);
-	break;
-      case 4:
-      case 5:
-      default:
-	classical_md = EVP_sha512();
-	digest_len = SHA512_DIGEST_LENGTH;
-	SHA512(tbs, tbslen, (unsigned char*) &digest);
-	break;
-      }
-      if (EVP_PKEY_CTX_set_signature_md(classical_ctx_sign, classical_md) <= 0) {
-	ECerr(EC_F_PKEY_OQS_DIGESTSIGN, ERR_R_FATAL);
-	goto end;
       }
       if (EVP_PKEY_sign(classical_ctx_sign, sig + SIZE_OF_UINT32, &actual_classical_sig_len, digest, digest_len) <= 0) {
         ECerr(EC_F_PKEY_OQS_DIGESTSIGN, EC_R_SIGNING_FAILED);
         goto end;
       }
-      if (actual_classical_sig_len > (size_t) get_classical_sig_len(classical_id)) {
+      if (actual_classical_sig_len > (size_t) oqs_key->meta->classical->sig_len) {
 	/* sig is bigger than expected! */
         ECerr(EC_F_PKEY_OQS_DIGESTSIGN, EC_R_BUFFER_LENGTH_WRONG);
         goto end;
@@ -1315,9 +1699,9 @@ static int pkey_oqs_digestsign(EVP_MD_CTX *ctx, unsigned char *sig,
       index += classical_sig_len;
     }
 
-    if (OQS_SIG_sign(oqs_key->s, sig + index, &oqs_sig_len, tbs, tbslen, oqs_key->privkey) != OQS_SUCCESS) {
+    if (ossl_oqs_sig_sign(oqs_key->s, sig + index, &oqs_sig_len, tbs, tbslen, oqs_key->privkey) != OQS_SUCCESS) {
       ECerr(EC_F_PKEY_OQS_DIGESTSIGN, EC_R_SIGNING_FAILED);
-      return 0;
+      goto end;
     }
     *siglen = classical_sig_len + oqs_sig_len;
 
@@ -1330,13 +1714,66 @@ static int pkey_oqs_digestsign(EVP_MD_CTX *ctx, unsigned char *sig,
     return rv;
 }
 
-static int pkey_oqs_digestverify(EVP_MD_CTX *ctx, const unsigned char *sig,
-                                 size_t siglen, const unsigned char *tbs,
-                                 size_t tbslen)
+static int pkey_oqs_digestsign(EVP_MD_CTX *ctx, unsigned char *sig,
+                               size_t *siglen, const unsigned char *tbs,
+                               size_t tbslen)
 {
-    const OQS_KEY *oqs_key = (OQS_KEY*) EVP_MD_CTX_pkey_ctx(ctx)->pkey->pkey.ptr;
-    int is_hybrid = is_oqs_hybrid_alg(oqs_key->nid);
-    int classical_id = 0;
+    return oqs_sign_tbs(EVP_MD_CTX_pkey_ctx(ctx), sig, siglen, tbs, tbslen);
+}
+
+/*
+ * The two halves of a hybrid signature verification, which are independent
+ * of each other: index 0 is the PQ half, index 1 the classical one. Neither
+ * half raises errors, as it may run on a thread of its own.
+ */
+typedef struct {
+    const OQS_KEY *oqs_key;
+    EVP_PKEY_CTX *classical_ctx;
+    const unsigned char *tbs;
+    size_t tbslen;
+    const unsigned char *classical_sig;
+    size_t classical_sig_len;
+    const unsigned char *oqs_sig;
+    size_t oqs_sig_len;
+    int ok[2];
+} OQS_VERIFY_JOB;
+
+static void oqs_verify_halves(void *arg, size_t off, size_t len)
+{
+    OQS_VERIFY_JOB *job = arg;
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_len;
+    size_t i;
+
+    for (i = off; i < off + len; i++) {
+        if (i == 0) {
+            job->ok[0] = ossl_oqs_sig_verify(job->oqs_key->s, job->tbs,
+                                             job->tbslen, job->oqs_sig,
+                                             job->oqs_sig_len,
+                                             job->oqs_key->pubkey)
+                         == OQS_SUCCESS;
+        } else if (off == 0 && !job->ok[0]) {
+            /* both halves on this thread: the PQ one already failed */
+            job->ok[1] = 0;
+        } else {
+            job->ok[1] = EVP_Digest(job->tbs, job->tbslen, digest, &digest_len,
+                                    get_classical_md(job->oqs_key), NULL)
+                         && EVP_PKEY_verify(job->classical_ctx,
+                                            job->classical_sig,
+                                            job->classical_sig_len,
+                                            digest, digest_len) > 0;
+        }
+    }
+}
+
+static int oqs_verify_tbs(EVP_PKEY_CTX *pctx, const unsigned char *sig,
+                          size_t siglen, const unsigned char *tbs,
+                          size_t tbslen)
+{
+    OQS_KEY *oqs_key = (OQS_KEY*) pctx->pkey->pkey.ptr;
+    OQS_PKEY_CTX *dctx = EVP_PKEY_CTX_get_data(pctx);
+    int is_hybrid = oqs_key->meta->classical != NULL;
+    OQS_VERIFY_JOB job;
     size_t classical_sig_len = 0;
     size_t index = 0;
 
@@ -1346,66 +1783,59 @@ static int pkey_oqs_digestverify(EVP_MD_CTX *ctx, const unsigned char *sig,
       return 0;
     }
 
+    /*
+     * Reject a malformed signature on its lengths alone, before hashing
+     * anything or touching a key.
+     */
     if (is_hybrid) {
-      classical_id = get_classical_nid(oqs_key->nid);
-    }
-
-    if (is_hybrid) {
-      EVP_PKEY_CTX *ctx_verify = NULL;
-      const EVP_MD *classical_md;
       size_t actual_classical_sig_len = 0;
-      int digest_len;
-      unsigned char digest[SHA512_DIGEST_LENGTH]; /* init with max length */
 
-      if ((ctx_verify = EVP_PKEY_CTX_new(oqs_key->classical_pkey, NULL)) == NULL ||
-	  EVP_PKEY_verify_init(ctx_verify) <= 0) {
-	ECerr(EC_F_PKEY_OQS_DIGESTVERIFY, ERR_R_FATAL);
-	EVP_PKEY_CTX_free(ctx_verify);
+      if (siglen < SIZE_OF_UINT32) {
+	ECerr(EC_F_PKEY_OQS_DIGESTVERIFY, EC_R_WRONG_PARAMETERS);
 	return 0;
       }
-      if (classical_id == EVP_PKEY_RSA) {
-	if (EVP_PKEY_CTX_set_rsa_padding(ctx_verify, RSA_PKCS1_PADDING) <= 0) {
-	  ECerr(EC_F_PKEY_OQS_DIGESTVERIFY, ERR_R_FATAL);
-	  EVP_PKEY_CTX_free(ctx_verify);
-	  return 0;
-	}
-      }
       DECODE_UINT32(actual_classical_sig_len, sig);
-      /* classical schemes can't sign arbitrarily large data; we hash it first */
-      switch (oqs_key->s->claimed_nist_level) {
-      case 1:
-	classical_md = EVP_sha256();
-	digest_len = SHA256_DIGEST_LENGTH;
-	SHA256(tbs, tbslen, (unsigned char*) &digest);
-	break;
-      case 2:
-      case 3:
-	classical_md = EVP_sha384();
-	digest_len = SHA384_DIGEST_LENGTH;
-	SHA384(tbs, tbslen, (unsigned char*) &digest);
-	break;
-      case 4:
-      case 5:
-      default:
-	classical_md = EVP_sha512();
-	digest_len = SHA512_DIGEST_LENGTH;
-	SHA512(tbs, tbslen, (unsigned char*) &digest);
-	break;
+      if (actual_classical_sig_len == 0
+          || actual_classical_sig_len > (size_t)EVP_PKEY_size(oqs_key->classical_pkey)
+          || actual_classical_sig_len > siglen - SIZE_OF_UINT32) {
+	ECerr(EC_F_PKEY_OQS_DIGESTVERIFY, EC_R_WRONG_PARAMETERS);
+	return 0;
       }
-      if (EVP_PKEY_CTX_set_signature_md(ctx_verify, classical_md) <= 0) {
+      classical_sig_len = SIZE_OF_UINT32 + actual_classical_sig_len;
+      index += classical_sig_len;
+    }
+    if (siglen - classical_sig_len == 0
+        || siglen - classical_sig_len > oqs_key->s->length_signature) {
+      ECerr(EC_F_PKEY_OQS_DIGESTVERIFY, EC_R_WRONG_PARAMETERS);
+      return 0;
+    }
+
+    memset(&job, 0, sizeof(job));
+    job.oqs_key = oqs_key;
+    job.tbs = tbs;
+    job.tbslen = tbslen;
+    job.oqs_sig = sig + index;
+    job.oqs_sig_len = siglen - classical_sig_len;
+
+    if (!is_hybrid) {
+      oqs_verify_halves(&job, 0, 1);
+    } else {
+      if ((job.classical_ctx = oqs_classical_ctx(oqs_key, 1)) == NULL) {
 	ECerr(EC_F_PKEY_OQS_DIGESTVERIFY, ERR_R_FATAL);
 	return 0;
       }
-      if (EVP_PKEY_verify(ctx_verify, sig + SIZE_OF_UINT32, actual_classical_sig_len, digest, digest_len) <= 0) {
+      job.classical_sig = sig + SIZE_OF_UINT32;
+      job.classical_sig_len = classical_sig_len - SIZE_OF_UINT32;
+      /* the PQ half runs on this thread, the classical one on another */
+      evp_parallel_run(dctx->verify_threads, 2, oqs_verify_halves, &job);
+      EVP_PKEY_CTX_free(job.classical_ctx);
+      if (!job.ok[1]) {
 	ECerr(EC_F_PKEY_OQS_DIGESTVERIFY, EC_R_VERIFICATION_FAILED);
 	return 0;
       }
-      classical_sig_len = SIZE_OF_UINT32 + actual_classical_sig_len;
-      index += classical_sig_len;
-      EVP_PKEY_CTX_free(ctx_verify);
     }
 
-    if (OQS_SIG_verify(oqs_key->s, tbs, tbslen, sig + index, siglen - classical_sig_len, oqs_key->pubkey) != OQS_SUCCESS) {
+    if (!job.ok[0]) {
       ECerr(EC_F_PKEY_OQS_DIGESTVERIFY, EC_R_VERIFICATION_FAILED);
       return 0;
     }
@@ -1413,73 +1843,141 @@ static int pkey_oqs_digestverify(EVP_MD_CTX *ctx, const unsigned char *sig,
     return 1;
 }
 
-static int pkey_oqs_ctrl(EVP_PKEY_CTX *ctx, int type, int p1, void *p2)
+static int pkey_oqs_digestverify(EVP_MD_CTX *ctx, const unsigned char *sig,
+                                 size_t siglen, const unsigned char *tbs,
+                                 size_t tbslen)
+{
+    return oqs_verify_tbs(EVP_MD_CTX_pkey_ctx(ctx), sig, siglen, tbs, tbslen);
+}
+
+/*
+ * Streaming (EVP_DigestSignUpdate/EVP_DigestVerifyUpdate) operations hash
+ * the message once into a digest context owned by the EVP_PKEY_CTX, and the
+ * resulting digest is what the PQ and classical signers operate on. Keeping
+ * it in the operation rather than in the (shared) key lets several
+ * operations on one key run at the same time.
+ */
+static EVP_MD_CTX *oqs_pkey_ctx_digest(EVP_PKEY_CTX *ctx, const EVP_MD *md)
 {
-    OQS_KEY *oqs_key = (OQS_KEY*) EVP_PKEY_CTX_get0_pkey(ctx)->pkey.ptr;
+    OQS_PKEY_CTX *dctx = EVP_PKEY_CTX_get_data(ctx);
+    EVP_MD_CTX *digest = dctx->digest;
 
+    if (digest == NULL) {
+        if ((digest = EVP_MD_CTX_new()) == NULL)
+            return NULL;
+        dctx->digest = digest;
+    }
+    if (md != NULL && EVP_DigestInit_ex(digest, md, NULL) <= 0)
+        return NULL;
+    return digest;
+}
+
+static int pkey_oqs_ctrl(EVP_PKEY_CTX *ctx, int type, int p1, void *p2)
+{
     switch (type) {
     case EVP_PKEY_CTRL_MD:
         /* NULL allowed as digest */
         if (p2 == NULL) {
             return 1;
 	}
-
-	if (oqs_key->digest == NULL) { // allocate fitting digest engine
-        	if ((oqs_key->digest = EVP_MD_CTX_create()) == NULL) {
-           		return 0;
-		}
-
-	        if (EVP_DigestInit_ex(oqs_key->digest, EVP_get_digestbynid(*(int*)p2), NULL) <= 0) {
-           		return 0;
-        	}
-		
-	}
-	return 1; // accept any digest
-
+	/* accept any digest; it is used for the streaming operations */
+	return oqs_pkey_ctx_digest(ctx, p2) != NULL;
 
     case EVP_PKEY_CTRL_DIGESTINIT:
         return 1;
 
     case EVP_PKEY_CTRL_CMS_SIGN:
+    case EVP_PKEY_CTRL_PKCS7_SIGN:
+        return 1;
+
+    case EVP_PKEY_CTRL_OQS_VERIFY_THREADS:
+        if (p1 < 1 || p1 > 2) {
+            ECerr(EC_F_PKEY_OQS_CTRL, ERR_R_PASSED_INVALID_ARGUMENT);
+            return -2;
+        }
+        ((OQS_PKEY_CTX *)EVP_PKEY_CTX_get_data(ctx))->verify_threads = p1;
         return 1;
     }
     ECerr(EC_F_PKEY_OQS_CTRL, ERR_R_FATAL);
     return -2;
 }
 
+static int pkey_oqs_ctrl_str(EVP_PKEY_CTX *ctx, const char *type,
+                             const char *value)
+{
+    if (strcmp(type, "verify_threads") == 0)
+        return EVP_PKEY_CTX_set_oqs_verify_threads(ctx, atoi(value));
+    return -2;
+}
+
 static int pkey_oqs_sign_init(EVP_PKEY_CTX *ctx) {
    return 1;
 }
 
+/*
+ * A precomputed digest (EVP_SignFinal(), CMS and PKCS#7 without signed
+ * attributes) is signed exactly like the digest a streaming operation
+ * computes, so either way of producing the signature verifies with the
+ * other. Without a signature digest set there is nothing to sign.
+ */
+static int oqs_check_tbs_digest(EVP_PKEY_CTX *ctx, const unsigned char *tbs,
+                                size_t tbslen)
+{
+    EVP_MD_CTX *digest = ((OQS_PKEY_CTX *)EVP_PKEY_CTX_get_data(ctx))->digest;
+    const EVP_MD *md;
+
+    if (digest == NULL || (md = EVP_MD_CTX_md(digest)) == NULL)
+        return 0;
+    return tbs == NULL || tbslen == (size_t)EVP_MD_size(md);
+}
+
 static int pkey_oqs_sign(EVP_PKEY_CTX *ctx, unsigned char *sig,
                                size_t *siglen, const unsigned char *tbs,
                                size_t tbslen)
 {
-   printf("oqs sign without digest auto fail\n");
-   return 0;
+    if (!oqs_check_tbs_digest(ctx, sig == NULL ? NULL : tbs, tbslen)) {
+        ECerr(EC_F_PKEY_OQS_SIGN, EC_R_INVALID_DIGEST);
+        return 0;
+    }
+    return oqs_sign_tbs(ctx, sig, siglen, tbs, tbslen);
 }
 
 static int oqs_int_update(EVP_MD_CTX *ctx, const void *data, size_t count)
 {
-    OQS_KEY *oqs_key = (OQS_KEY*) EVP_MD_CTX_pkey_ctx(ctx)->pkey->pkey.ptr;
+    EVP_PKEY_CTX *pctx = EVP_MD_CTX_pkey_ctx(ctx);
+    EVP_MD_CTX *digest = ((OQS_PKEY_CTX *)EVP_PKEY_CTX_get_data(pctx))->digest;
 
     /* chose SHA512 as default digest if none other explicitly set */
-    if (oqs_key->digest == NULL) {
-       	if ((oqs_key->digest = EVP_MD_CTX_create()) == NULL) {
-       		return 0;
-	}
-
-        if (EVP_DigestInit_ex(oqs_key->digest, EVP_sha512(), NULL) <= 0) {
-       		return 0;
-       	}
+    if (digest == NULL || EVP_MD_CTX_md(digest) == NULL) {
+        if ((digest = oqs_pkey_ctx_digest(pctx, EVP_sha512())) == NULL)
+            return 0;
     }
 
-    if(EVP_DigestUpdate(oqs_key->digest, data, count)<=0) {
+    if (EVP_DigestUpdate(digest, data, count) <= 0) {
 	return 0;
     }
     return 1;
 }
 
+/*
+ * Finalises the digest of a streaming operation into |tbs|, which must hold
+ * EVP_MAX_MD_SIZE bytes. The digest context is left ready for the next
+ * message.
+ */
+static int oqs_int_final(EVP_PKEY_CTX *ctx, unsigned char *tbs,
+                         unsigned int *tbslen)
+{
+    EVP_MD_CTX *digest = ((OQS_PKEY_CTX *)EVP_PKEY_CTX_get_data(ctx))->digest;
+    const EVP_MD *md;
+
+    if (digest == NULL || (md = EVP_MD_CTX_md(digest)) == NULL) {
+        /* nothing was hashed; ctrl or update not called? */
+        return 0;
+    }
+    return EVP_DigestFinal_ex(digest, tbs, tbslen) > 0
+           && EVP_DigestInit_ex(digest, md, NULL) > 0;
+}
+
 static int pkey_oqs_signctx_init (EVP_PKEY_CTX *ctx, EVP_MD_CTX *mctx) {
 
     EVP_MD_CTX_set_flags(mctx, EVP_MD_CTX_FLAG_NO_INIT);
@@ -1489,36 +1987,17 @@ static int pkey_oqs_signctx_init (EVP_PKEY_CTX *ctx, EVP_MD_CTX *mctx) {
 }
 
 static int pkey_oqs_signctx(EVP_PKEY_CTX *ctx, unsigned char *sig, size_t *siglen, EVP_MD_CTX *mctx) {
-    OQS_KEY *oqs_key = (OQS_KEY*) EVP_MD_CTX_pkey_ctx(mctx)->pkey->pkey.ptr;
-    unsigned char* tbs = NULL;
+    unsigned char tbs[EVP_MAX_MD_SIZE];
     unsigned int tbslen = 0;
+    int ret;
 
-    if (sig != NULL) {
-	// support any digest requested:
-	tbslen = EVP_MD_CTX_size(oqs_key->digest);
-
-	if (oqs_key->digest == NULL) { // error; ctrl not called?
-		return 0;
-	}
-
-	if((tbs = (unsigned char *)OPENSSL_malloc(tbslen)) == NULL) {
-		return 0;
-	}
-
-	if(EVP_DigestFinal(oqs_key->digest, tbs, &tbslen) <= 0) {
-		return 0;
-	}
+    /* the empty setup call only needs the signature length */
+    if (sig != NULL && !oqs_int_final(ctx, tbs, &tbslen))
+	return 0;
 
-    }
-    int ret = pkey_oqs_digestsign(mctx, sig, siglen, tbs, tbslen);
-    if (sig != NULL) { // cleanup only if it's not the empty setup call
-       OPENSSL_free(tbs);
-       EVP_MD_CTX_destroy(oqs_key->digest);
-       oqs_key->digest = NULL;
-    }
-    if (ret <= 0) {
-    }
-    else {
+    ret = pkey_oqs_digestsign(mctx, sig, siglen, tbs, tbslen);
+    OPENSSL_cleanse(tbs, sizeof(tbs));
+    if (ret > 0 && sig != NULL) {
        EVP_MD_CTX_set_flags(mctx, EVP_MD_CTX_FLAG_FINALISE); // don't go around again...
     }
 
@@ -1536,8 +2015,11 @@ static int pkey_oqs_verify_init(EVP_PKEY_CTX *ctx) {
 static int pkey_oqs_verify(EVP_PKEY_CTX *ctx,
                    const unsigned char *sig, size_t siglen,
                    const unsigned char *tbs, size_t tbslen) {
-	printf("oqs verify auto fail without digest\n");
-	return 0;
+    if (tbs == NULL || !oqs_check_tbs_digest(ctx, tbs, tbslen)) {
+        ECerr(EC_F_PKEY_OQS_VERIFY, EC_R_INVALID_DIGEST);
+        return 0;
+    }
+    return oqs_verify_tbs(ctx, sig, siglen, tbs, tbslen);
 }
 
 static int pkey_oqs_verifyctx_init(EVP_PKEY_CTX *ctx, EVP_MD_CTX *mctx) {
@@ -1550,54 +2032,62 @@ static int pkey_oqs_verifyctx_init(EVP_PKEY_CTX *ctx, EVP_MD_CTX *mctx) {
 
 static int pkey_oqs_verifyctx(EVP_PKEY_CTX *ctx, const unsigned char *sig, int siglen,
                       EVP_MD_CTX *mctx) {
-    OQS_KEY *oqs_key = (OQS_KEY*) EVP_MD_CTX_pkey_ctx(mctx)->pkey->pkey.ptr;
-    unsigned char* tbs = NULL;
+    unsigned char tbs[EVP_MAX_MD_SIZE];
     unsigned int tbslen = 0;
 
-    if (sig != NULL) {
-        // support any digest requested:
-        tbslen = EVP_MD_CTX_size(oqs_key->digest);
+    if (sig == NULL || !oqs_int_final(ctx, tbs, &tbslen))
+        return 0;
 
-        if (oqs_key->digest == NULL) { // error; ctrl not called?
-                return 0;
-        }
+    return pkey_oqs_digestverify(mctx, sig, siglen, tbs, tbslen);
+}
 
-        if((tbs = (unsigned char *)OPENSSL_malloc(tbslen)) == NULL) {
-                return 0;
-        }
+static int pkey_oqs_init(EVP_PKEY_CTX *ctx)
+{
+    OQS_PKEY_CTX *dctx = OPENSSL_zalloc(sizeof(*dctx));
 
-        if(EVP_DigestFinal(oqs_key->digest, tbs, &tbslen) <= 0) {
-                return 0;
-        }
+    if (dctx == NULL)
+        return 0;
+    dctx->verify_threads = 1;
+    EVP_PKEY_CTX_set_data(ctx, dctx);
+    return 1;
+}
 
-    }
+static int pkey_oqs_copy(EVP_PKEY_CTX *dst, EVP_PKEY_CTX *src)
+{
+    OQS_PKEY_CTX *sctx = EVP_PKEY_CTX_get_data(src), *dctx;
 
-    int ret = pkey_oqs_digestverify(mctx, sig, siglen, tbs, tbslen); 
-    if (sig != NULL) { // cleanup only if it's not the empty setup call
-       OPENSSL_free(tbs);
-       EVP_MD_CTX_destroy(oqs_key->digest);
-       oqs_key->digest = NULL;
-    }
-    if (ret <= 0) {
-    }
-    else {
-       EVP_MD_CTX_set_flags(mctx, EVP_MD_CTX_FLAG_FINALISE); // don't go around again...
-    }
+    if (!pkey_oqs_init(dst))
+        return 0;
+    dctx = EVP_PKEY_CTX_get_data(dst);
+    dctx->verify_threads = sctx->verify_threads;
 
-   return ret;
+    /* carry over the digest state of a streaming operation */
+    if (sctx->digest == NULL)
+        return 1;
+    if ((dctx->digest = EVP_MD_CTX_new()) == NULL)
+        return 0;
+    if (!EVP_MD_CTX_copy_ex(dctx->digest, sctx->digest))
+        return 0;
+    return 1;
 }
 
-static int pkey_oqs_copy(EVP_PKEY_CTX *dst, EVP_PKEY_CTX *src)
+static void pkey_oqs_cleanup(EVP_PKEY_CTX *ctx)
 {
-    // nothing specific needed, but EVP depends on its presence
-    return 1;
+    OQS_PKEY_CTX *dctx = EVP_PKEY_CTX_get_data(ctx);
+
+    if (dctx == NULL)
+        return;
+    EVP_MD_CTX_free(dctx->digest);
+    OPENSSL_free(dctx);
+    EVP_PKEY_CTX_set_data(ctx, NULL);
 }
 
 
 #define DEFINE_OQS_EVP_PKEY_METHOD(ALG, NID_ALG)    \
 const EVP_PKEY_METHOD ALG##_pkey_meth = {           \
     NID_ALG, EVP_PKEY_FLAG_SIGCTX_CUSTOM,           \
-    0, pkey_oqs_copy, 0, 0, 0, 0,                   \
+    pkey_oqs_init, pkey_oqs_copy, pkey_oqs_cleanup, \
+    0, 0, 0,                                        \
     pkey_oqs_keygen,                                \
     pkey_oqs_sign_init, pkey_oqs_sign,              \
     pkey_oqs_verify_init, pkey_oqs_verify,          \
@@ -1606,7 +2096,7 @@ const EVP_PKEY_METHOD ALG##_pkey_meth = {           \
     pkey_oqs_verifyctx_init, pkey_oqs_verifyctx,    \
     0, 0, 0, 0, 0, 0,                               \
     pkey_oqs_ctrl,                                  \
-    0,                                              \
+    pkey_oqs_ctrl_str,                              \
     pkey_oqs_digestsign,                            \
     pkey_oqs_digestverify,                          \
     0, 0, 0,                                        \
@@ -15,11 +15,15 @@
 #include <sys/ioctl.h>
 #include <unistd.h>
 #include <assert.h>
+#include <poll.h>
 
 #include <openssl/evp.h>
 #include <openssl/err.h>
 #include <openssl/engine.h>
 #include <openssl/objects.h>
+#include <openssl/aes.h>
+#include <openssl/modes.h>
+#include <openssl/async.h>
 #include <crypto/cryptodev.h>
 
 #include "crypto/engine.h"
@@ -30,6 +34,48 @@
 # define CHECK_BSD_STYLE_MACROS
 #endif
 
+/*
+ * cryptodev-linux can queue operations and report their completion through
+ * poll() on the device, which lets operations from many ASYNC jobs be in
+ * the driver at once.  See devcrypto_crypt().
+ */
+#if defined(CIOCASYNCCRYPT) && defined(CIOCASYNCFETCH) \
+    && defined(OPENSSL_THREADS)
+# define DEVCRYPTO_ASYNC
+# include <sys/eventfd.h>
+#endif
+
+#if     defined(OPENSSL_CPUID_OBJ) &&                   (  \
+        ((defined(__i386)       || defined(__i386__)    || \
+          defined(_M_IX86)) && defined(OPENSSL_IA32_SSE2))|| \
+        defined(__x86_64)       || defined(__x86_64__)  || \
+        defined(_M_AMD64)       || defined(_M_X64)      )
+/* The AES-NI routines e_aes.c uses, for AES operations kept on the CPU */
+# define DEVCRYPTO_AESNI
+extern unsigned int OPENSSL_ia32cap_P[];
+# define AESNI_CAPABLE   (OPENSSL_ia32cap_P[1]&(1<<(57-32)))
+
+int aesni_set_encrypt_key(const unsigned char *userKey, int bits,
+                          AES_KEY *key);
+int aesni_set_decrypt_key(const unsigned char *userKey, int bits,
+                          AES_KEY *key);
+void aesni_ecb_encrypt(const unsigned char *in, unsigned char *out,
+                       size_t length, const AES_KEY *key, int enc);
+void aesni_cbc_encrypt(const unsigned char *in, unsigned char *out,
+                       size_t length, const AES_KEY *key,
+                       unsigned char *ivec, int enc);
+void aesni_ctr32_encrypt_blocks(const unsigned char *in, unsigned char *out,
+                                size_t blocks, const void *key,
+                                const unsigned char *ivec);
+#endif
+
+/*
+ * AES operations shorter than this are done on the CPU, where they are
+ * cheaper than the round trip to the driver.  Set with OFFLOAD_MIN.
+ */
+#define DEVCRYPTO_DEFAULT_OFFLOAD_MIN   256
+static size_t offload_min = DEVCRYPTO_DEFAULT_OFFLOAD_MIN;
+
 /*
  * ONE global file descriptor for all sessions.  This allows operations
  * such as digest session data copying (see digest_copy()), but is also
@@ -46,6 +92,199 @@ static int clean_devcrypto_session(struct session_op *sess) {
     return 1;
 }
 
+#ifdef DEVCRYPTO_ASYNC
+/******************************************************************************
+ *
+ * Asynchronous operations
+ *
+ * Inside an ASYNC job, operations are queued with CIOCASYNCCRYPT and the
+ * job pauses until the driver has completed them, so that other jobs can
+ * queue theirs meanwhile.  Completions are fetched from the one global
+ * file descriptor in the order the driver finished them, so whichever job
+ * runs first fetches all of them, marks the owners' operations done and
+ * wakes their jobs through an eventfd.  Each ASYNC_WAIT_CTX therefore
+ * waits on both /dev/crypto, readable when any completion is pending, and
+ * its own eventfd.
+ *
+ *****/
+
+/*
+ * The queue entries are allocated, not kept on the stack of the job waiting
+ * for them: a job that is never resumed leaves its entry behind until the
+ * driver completes the operation, see async_fd_cleanup().
+ */
+struct async_op {
+    __u32 ses;                   /* the session, which identifies the op */
+    int done;
+    int err;                     /* errno of a failed operation */
+    int orphaned;                /* its ASYNC_WAIT_CTX has been freed */
+    OSSL_ASYNC_FD efd;           /* to wake the job waiting for it */
+    struct async_op *next;
+};
+
+static const char *engine_devcrypto_id = "devcrypto";
+static int use_async = 1;        /* Set with the ASYNC control */
+static CRYPTO_RWLOCK *async_lock = NULL;
+/* Queued operations, oldest first */
+static struct async_op *async_ops = NULL;
+
+/*
+ * Called when the ASYNC_WAIT_CTX goes away.  An operation still queued for it
+ * belongs to a job that will never be resumed: it is left for async_reap()
+ * to free, as the driver still has to report its completion.
+ */
+static void async_fd_cleanup(ASYNC_WAIT_CTX *ctx, const void *key,
+                             OSSL_ASYNC_FD readfd, void *custom)
+{
+    struct async_op *op;
+
+    if (async_lock != NULL && CRYPTO_THREAD_write_lock(async_lock)) {
+        for (op = async_ops; op != NULL; op = op->next)
+            if (op->efd == readfd)
+                op->orphaned = 1;
+        CRYPTO_THREAD_unlock(async_lock);
+    }
+    close(readfd);
+}
+
+/* Returns the eventfd of |waitctx|, setting up its wait fds if needed */
+static OSSL_ASYNC_FD async_wait_fd(ASYNC_WAIT_CTX *waitctx)
+{
+    OSSL_ASYNC_FD efd;
+    void *custom;
+
+    if (ASYNC_WAIT_CTX_get_fd(waitctx, engine_devcrypto_id, &efd, &custom))
+        return efd;
+
+    if ((efd = eventfd(0, EFD_NONBLOCK)) < 0)
+        return -1;
+    if (!ASYNC_WAIT_CTX_set_wait_fd(waitctx, engine_devcrypto_id, efd, NULL,
+                                    async_fd_cleanup)) {
+        close(efd);
+        return -1;
+    }
+    if (!ASYNC_WAIT_CTX_set_wait_fd(waitctx, &cfd, cfd, NULL, NULL)) {
+        ASYNC_WAIT_CTX_clear_fd(waitctx, engine_devcrypto_id);
+        close(efd);
+        return -1;
+    }
+    return efd;
+}
+
+/* Fetches every pending completion.  Must be called with async_lock held */
+static void async_reap(void)
+{
+    struct pollfd pfd;
+    struct crypt_op res;
+    struct async_op *op, **pop;
+    int err;
+
+    pfd.fd = cfd;
+    pfd.events = POLLIN;
+    while (async_ops != NULL && poll(&pfd, 1, 0) > 0) {
+        memset(&res, 0, sizeof(res));
+        err = ioctl(cfd, CIOCASYNCFETCH, &res) < 0 ? errno : 0;
+        if (err == EAGAIN)
+            break;
+
+        /*
+         * A session has at most one operation in flight, which identifies
+         * it.  A failed one is not copied back, but the driver works
+         * through its queue in order, so it is the oldest.
+         */
+        for (pop = &async_ops; (op = *pop) != NULL; pop = &op->next)
+            if (err != 0 || op->ses == res.ses)
+                break;
+        if (op == NULL)
+            continue;
+        *pop = op->next;
+        if (op->orphaned) {
+            OPENSSL_free(op);
+            continue;
+        }
+        op->err = err;
+        op->done = 1;
+        eventfd_write(op->efd, 1);
+    }
+}
+
+/*
+ * Returns 1 once the operation has completed, 0 if it failed and -1 if it
+ * could not be queued, in which case it must be run synchronously.
+ */
+static int async_crypt(struct crypt_op *cryp)
+{
+    ASYNC_WAIT_CTX *waitctx = ASYNC_get_wait_ctx(ASYNC_get_current_job());
+    struct async_op *op, **pop;
+    OSSL_ASYNC_FD efd;
+    eventfd_t val;
+    int done, err;
+
+    if (waitctx == NULL || (efd = async_wait_fd(waitctx)) < 0
+            || (op = OPENSSL_zalloc(sizeof(*op))) == NULL)
+        return -1;
+    op->ses = cryp->ses;
+    op->efd = efd;
+
+    if (!CRYPTO_THREAD_write_lock(async_lock)) {
+        OPENSSL_free(op);
+        return -1;
+    }
+    for (pop = &async_ops; *pop != NULL; pop = &(*pop)->next)
+        continue;
+    *pop = op;
+    if (ioctl(cfd, CIOCASYNCCRYPT, cryp) < 0) {
+        *pop = NULL;
+        /* The driver was built without support for it */
+        if (errno == ENOTTY || errno == EINVAL)
+            use_async = 0;
+        CRYPTO_THREAD_unlock(async_lock);
+        OPENSSL_free(op);
+        return -1;
+    }
+    CRYPTO_THREAD_unlock(async_lock);
+
+    for (;;) {
+        if (!CRYPTO_THREAD_write_lock(async_lock))
+            continue;
+        async_reap();
+        done = op->done;
+        CRYPTO_THREAD_unlock(async_lock);
+        if (done)
+            break;
+        /* The driver writes to |cryp|'s buffers, so wait whatever happens */
+        ASYNC_pause_job();
+    }
+    eventfd_read(efd, &val);
+
+    /* async_reap() has taken |op| off the queue */
+    err = op->err;
+    OPENSSL_free(op);
+    if (err != 0) {
+        errno = err;
+        return 0;
+    }
+    return 1;
+}
+#endif
+
+/*
+ * Runs |cryp| on the driver.  Like ioctl(), returns -1 and sets errno on
+ * failure.
+ */
+static int devcrypto_crypt(struct crypt_op *cryp)
+{
+#ifdef DEVCRYPTO_ASYNC
+    if (use_async && ASYNC_get_current_job() != NULL) {
+        int ret = async_crypt(cryp);
+
+        if (ret >= 0)
+            return ret ? 0 : -1;
+    }
+#endif
+    return ioctl(cfd, CIOCCRYPT, cryp);
+}
+
 /******************************************************************************
  *
  * Ciphers
@@ -64,8 +303,16 @@ struct cipher_ctx {
     /* to handle ctr mode being a stream cipher */
     unsigned char partial[EVP_MAX_BLOCK_LENGTH];
     unsigned int blocksize, num;
+
+    /* CPU implementation of short AES operations, see offload_min */
+    int sw;                      /* SW_* */
+    AES_KEY sw_key;
 };
 
+#define SW_NONE     0
+#define SW_AES      1
+#define SW_AESNI    2
+
 static const struct cipher_data_st {
     int nid;
     int blocksize;
@@ -141,6 +388,96 @@ static const struct cipher_data_st *get_cipher_data(int nid)
     return &cipher_data[get_cipher_data_index(nid)];
 }
 
+/*
+ * Prepares the CPU implementation for the AES ciphers.  The key schedule
+ * is that of the implementation EVP would pick, AES-NI where available.
+ */
+static void cipher_sw_init(struct cipher_ctx *cipher_ctx,
+                           const struct cipher_data_st *cipher_d,
+                           const unsigned char *key, int enc)
+{
+    int bits = cipher_d->keylen * 8;
+    int dec = !enc && cipher_ctx->mode != EVP_CIPH_CTR_MODE;
+
+    cipher_ctx->sw = SW_NONE;
+    if (cipher_d->devcryptoid != CRYPTO_AES_CBC
+#if !defined(CHECK_BSD_STYLE_MACROS) || defined(CRYPTO_AES_CTR)
+        && cipher_d->devcryptoid != CRYPTO_AES_CTR
+#endif
+#if !defined(CHECK_BSD_STYLE_MACROS) || defined(CRYPTO_AES_ECB)
+        && cipher_d->devcryptoid != CRYPTO_AES_ECB
+#endif
+        )
+        return;
+
+#ifdef DEVCRYPTO_AESNI
+    if (AESNI_CAPABLE) {
+        if ((dec ? aesni_set_decrypt_key(key, bits, &cipher_ctx->sw_key)
+                 : aesni_set_encrypt_key(key, bits, &cipher_ctx->sw_key)) == 0)
+            cipher_ctx->sw = SW_AESNI;
+        return;
+    }
+#endif
+    if ((dec ? AES_set_decrypt_key(key, bits, &cipher_ctx->sw_key)
+             : AES_set_encrypt_key(key, bits, &cipher_ctx->sw_key)) == 0)
+        cipher_ctx->sw = SW_AES;
+}
+
+/*
+ * Processes whole blocks on the CPU, updating |iv| as the driver would so
+ * that operations can alternate between the two.
+ */
+static int cipher_sw_do_cipher(struct cipher_ctx *cipher_ctx,
+                               unsigned char *out, const unsigned char *in,
+                               size_t inl, unsigned char *iv)
+{
+    const AES_KEY *key = &cipher_ctx->sw_key;
+    int enc = cipher_ctx->op == COP_ENCRYPT;
+    unsigned char ecount[AES_BLOCK_SIZE];
+    unsigned int num = 0;
+    size_t i;
+
+    switch (cipher_ctx->mode) {
+    case EVP_CIPH_CBC_MODE:
+#ifdef DEVCRYPTO_AESNI
+        if (cipher_ctx->sw == SW_AESNI) {
+            aesni_cbc_encrypt(in, out, inl, key, iv, enc);
+            break;
+        }
+#endif
+        AES_cbc_encrypt(in, out, inl, key, iv, enc);
+        break;
+
+    case EVP_CIPH_CTR_MODE:
+#ifdef DEVCRYPTO_AESNI
+        if (cipher_ctx->sw == SW_AESNI) {
+            CRYPTO_ctr128_encrypt_ctr32(in, out, inl, key, iv, ecount, &num,
+                                        (ctr128_f)aesni_ctr32_encrypt_blocks);
+            break;
+        }
+#endif
+        CRYPTO_ctr128_encrypt(in, out, inl, key, iv, ecount, &num,
+                              (block128_f)AES_encrypt);
+        break;
+
+    case EVP_CIPH_ECB_MODE:
+#ifdef DEVCRYPTO_AESNI
+        if (cipher_ctx->sw == SW_AESNI) {
+            aesni_ecb_encrypt(in, out, inl, key, enc);
+            break;
+        }
+#endif
+        for (i = 0; i < inl; i += AES_BLOCK_SIZE)
+            AES_ecb_encrypt(in + i, out + i, key, enc);
+        break;
+
+    default: /* should not happen */
+        return 0;
+    }
+
+    return 1;
+}
+
 /*
  * Following are the three necessary functions to map OpenSSL functionality
  * with cryptodev.
@@ -169,6 +506,7 @@ static int cipher_init(EVP_CIPHER_CTX *ctx, const unsigned char *key,
         SYSerr(SYS_F_IOCTL, errno);
         return 0;
     }
+    cipher_sw_init(cipher_ctx, cipher_d, key, enc);
 
     return 1;
 }
@@ -186,6 +524,9 @@ static int cipher_do_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
     size_t nblocks, ivlen;
 #endif
 
+    if (cipher_ctx->sw != SW_NONE && inl < offload_min)
+        return cipher_sw_do_cipher(cipher_ctx, out, in, inl, iv);
+
     memset(&cryp, 0, sizeof(cryp));
     cryp.ses = cipher_ctx->sess.ses;
     cryp.len = inl;
@@ -217,7 +558,7 @@ static int cipher_do_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
     cryp.flags = COP_FLAG_WRITE_IV;
 #endif
 
-    if (ioctl(cfd, CIOCCRYPT, &cryp) < 0) {
+    if (devcrypto_crypt(&cryp) < 0) {
         SYSerr(SYS_F_IOCTL, errno);
         return 0;
     }
@@ -290,6 +631,8 @@ static int ctr_do_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
                                    ^ cipher_ctx->partial[cipher_ctx->num];
             cipher_ctx->num++;
         }
+        /* a final block that is exactly full leaves nothing to carry over */
+        cipher_ctx->num %= cipher_ctx->blocksize;
     }
 
     return 1;
@@ -310,11 +653,17 @@ static int cipher_ctrl(EVP_CIPHER_CTX *ctx, int type, int p1, void* p2)
         to_cipher_ctx =
             (struct cipher_ctx *)EVP_CIPHER_CTX_get_cipher_data(to_ctx);
         memset(&to_cipher_ctx->sess, 0, sizeof(to_cipher_ctx->sess));
-        return cipher_init(to_ctx, cipher_ctx->sess.key, EVP_CIPHER_CTX_iv(ctx),
-                           (cipher_ctx->op == COP_ENCRYPT));
+        if (!cipher_init(to_ctx, cipher_ctx->sess.key, EVP_CIPHER_CTX_iv(ctx),
+                         (cipher_ctx->op == COP_ENCRYPT)))
+            return 0;
+        /* The key schedule was copied along with the context */
+        to_cipher_ctx->sw = cipher_ctx->sw;
+        to_cipher_ctx->sw_key = cipher_ctx->sw_key;
+        return 1;
 
     case EVP_CTRL_INIT:
         memset(&cipher_ctx->sess, 0, sizeof(cipher_ctx->sess));
+        cipher_ctx->sw = SW_NONE;
         return 1;
 
     default:
@@ -329,6 +678,7 @@ static int cipher_cleanup(EVP_CIPHER_CTX *ctx)
     struct cipher_ctx *cipher_ctx =
         (struct cipher_ctx *)EVP_CIPHER_CTX_get_cipher_data(ctx);
 
+    OPENSSL_cleanse(&cipher_ctx->sw_key, sizeof(cipher_ctx->sw_key));
     return clean_devcrypto_session(&cipher_ctx->sess);
 }
 
@@ -550,7 +900,7 @@ static int digest_op(struct digest_ctx *ctx, const void *src, size_t srclen,
     cryp.dst = NULL;
     cryp.mac = res;
     cryp.flags = flags;
-    return ioctl(cfd, CIOCCRYPT, &cryp);
+    return devcrypto_crypt(&cryp);
 }
 
 static int digest_update(EVP_MD_CTX *ctx, const void *data, size_t count)
@@ -734,6 +1084,50 @@ static int devcrypto_digests(ENGINE *e, const EVP_MD **digest,
 
 #endif
 
+/******************************************************************************
+ *
+ * CONTROL COMMANDS
+ *
+ *****/
+
+#define DEVCRYPTO_CMD_OFFLOAD_MIN   ENGINE_CMD_BASE
+#define DEVCRYPTO_CMD_ASYNC         (ENGINE_CMD_BASE + 1)
+
+static const ENGINE_CMD_DEFN devcrypto_cmds[] = {
+    {DEVCRYPTO_CMD_OFFLOAD_MIN,
+     "OFFLOAD_MIN",
+     "AES operations shorter than this many bytes are done on the CPU",
+     ENGINE_CMD_FLAG_NUMERIC},
+#ifdef DEVCRYPTO_ASYNC
+    {DEVCRYPTO_CMD_ASYNC,
+     "ASYNC",
+     "Queue operations asynchronously inside ASYNC jobs (0 = disabled)",
+     ENGINE_CMD_FLAG_NUMERIC},
+#endif
+    {0, NULL, NULL, 0}
+};
+
+static int devcrypto_ctrl(ENGINE *e, int cmd, long i, void *p, void (*f) (void))
+{
+    switch (cmd) {
+    case DEVCRYPTO_CMD_OFFLOAD_MIN:
+        if (i < 0) {
+            ENGINEerr(ENGINE_F_DEVCRYPTO_CTRL, ENGINE_R_INVALID_ARGUMENT);
+            return 0;
+        }
+        offload_min = (size_t)i;
+        return 1;
+#ifdef DEVCRYPTO_ASYNC
+    case DEVCRYPTO_CMD_ASYNC:
+        use_async = i != 0;
+        return 1;
+#endif
+    }
+
+    ENGINEerr(ENGINE_F_DEVCRYPTO_CTRL, ENGINE_R_CTRL_COMMAND_NOT_IMPLEMENTED);
+    return 0;
+}
+
 /******************************************************************************
  *
  * LOAD / UNLOAD
@@ -748,6 +1142,17 @@ static int devcrypto_unload(ENGINE *e)
 #endif
 
     close(cfd);
+#ifdef DEVCRYPTO_ASYNC
+    /* Only orphaned operations can be left, and the driver is gone */
+    while (async_ops != NULL) {
+        struct async_op *op = async_ops;
+
+        async_ops = op->next;
+        OPENSSL_free(op);
+    }
+    CRYPTO_THREAD_lock_free(async_lock);
+    async_lock = NULL;
+#endif
 
     return 1;
 }
@@ -780,6 +1185,13 @@ void engine_load_devcrypto_int()
     cfd = fd;
 #endif
 
+#ifdef DEVCRYPTO_ASYNC
+    if ((async_lock = CRYPTO_THREAD_lock_new()) == NULL) {
+        close(cfd);
+        return;
+    }
+#endif
+
     if ((e = ENGINE_new()) == NULL
         || !ENGINE_set_destroy_function(e, devcrypto_unload)) {
         ENGINE_free(e);
@@ -789,6 +1201,10 @@ void engine_load_devcrypto_int()
          * avoid leaking resources.
          */
         close(cfd);
+#ifdef DEVCRYPTO_ASYNC
+        CRYPTO_THREAD_lock_free(async_lock);
+        async_lock = NULL;
+#endif
         return;
     }
 
@@ -799,6 +1215,8 @@ void engine_load_devcrypto_int()
 
     if (!ENGINE_set_id(e, "devcrypto")
         || !ENGINE_set_name(e, "/dev/crypto engine")
+        || !ENGINE_set_cmd_defns(e, devcrypto_cmds)
+        || !ENGINE_set_ctrl_function(e, devcrypto_ctrl)
 
 /*
  * Asymmetric ciphers aren't well supported with /dev/crypto.  Among the BSD
@@ -26,9 +26,28 @@ struct st_engine_pile {
     int uptodate;
 };
 
+/*
+ * Once any ENGINE has registered for a table, every lookup in it used to
+ * take |global_engine_lock|, even for the nids no ENGINE implements.  Those
+ * misses are remembered per table, tagged with |table_generation|, which
+ * every (un)registration bumps, so repeating one needs no lock.  Without
+ * the compiler atomics the lock is always taken.
+ */
+#if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE) \
+    && __GCC_ATOMIC_POINTER_LOCK_FREE > 0 && __GCC_ATOMIC_LLONG_LOCK_FREE == 2
+# define ENGINE_TABLE_MISS_CACHE
+# define ENGINE_TABLE_MISS_SLOTS 64
+# define ENGINE_TABLE_MISS_SLOT(nid) \
+    ((unsigned int)(nid) % ENGINE_TABLE_MISS_SLOTS)
+#endif
+
 /* The type exposed in eng_local.h */
 struct st_engine_table {
-    LHASH_OF(ENGINE_PILE) piles;
+    LHASH_OF(ENGINE_PILE) *piles;
+#ifdef ENGINE_TABLE_MISS_CACHE
+    /* (generation << 32 | nid) of recent lookups that found no ENGINE */
+    uint64_t miss[ENGINE_TABLE_MISS_SLOTS];
+#endif
 };                              /* ENGINE_TABLE */
 
 typedef struct st_engine_pile_doall {
@@ -39,6 +58,19 @@ typedef struct st_engine_pile_doall {
 /* Global flags (ENGINE_TABLE_FLAG_***). */
 static unsigned int table_flags = 0;
 
+#ifdef ENGINE_TABLE_MISS_CACHE
+static unsigned int table_generation = 0;
+
+/* Forget all cached misses, |global_engine_lock| must be held */
+static void table_touch(void)
+{
+    __atomic_store_n(&table_generation, table_generation + 1,
+                     __ATOMIC_RELEASE);
+}
+#else
+# define table_touch()
+#endif
+
 /* API function manipulating 'table_flags' */
 unsigned int ENGINE_get_table_flags(void)
 {
@@ -63,15 +95,24 @@ static int engine_pile_cmp(const ENGINE_PILE *a, const ENGINE_PILE *b)
 
 static int int_table_check(ENGINE_TABLE **t, int create)
 {
-    LHASH_OF(ENGINE_PILE) *lh;
+    ENGINE_TABLE *table;
 
     if (*t)
         return 1;
     if (!create)
         return 0;
-    if ((lh = lh_ENGINE_PILE_new(engine_pile_hash, engine_pile_cmp)) == NULL)
+    if ((table = OPENSSL_zalloc(sizeof(*table))) == NULL)
+        return 0;
+    if ((table->piles = lh_ENGINE_PILE_new(engine_pile_hash,
+                                           engine_pile_cmp)) == NULL) {
+        OPENSSL_free(table);
         return 0;
-    *t = (ENGINE_TABLE *)lh;
+    }
+#ifdef ENGINE_TABLE_MISS_CACHE
+    __atomic_store_n(t, table, __ATOMIC_RELEASE);
+#else
+    *t = table;
+#endif
     return 1;
 }
 
@@ -93,9 +134,10 @@ int engine_table_register(ENGINE_TABLE **table, ENGINE_CLEANUP_CB *cleanup,
     if (added)
         /* The cleanup callback needs to be added */
         engine_cleanup_add_first(cleanup);
+    table_touch();
     while (num_nids--) {
         tmplate.nid = *nids;
-        fnd = lh_ENGINE_PILE_retrieve(&(*table)->piles, &tmplate);
+        fnd = lh_ENGINE_PILE_retrieve((*table)->piles, &tmplate);
         if (!fnd) {
             fnd = OPENSSL_malloc(sizeof(*fnd));
             if (fnd == NULL)
@@ -108,8 +150,8 @@ int engine_table_register(ENGINE_TABLE **table, ENGINE_CLEANUP_CB *cleanup,
                 goto end;
             }
             fnd->funct = NULL;
-            (void)lh_ENGINE_PILE_insert(&(*table)->piles, fnd);
-            if (lh_ENGINE_PILE_retrieve(&(*table)->piles, &tmplate) != fnd) {
+            (void)lh_ENGINE_PILE_insert((*table)->piles, fnd);
+            if (lh_ENGINE_PILE_retrieve((*table)->piles, &tmplate) != fnd) {
                 sk_ENGINE_free(fnd->sk);
                 OPENSSL_free(fnd);
                 goto end;
@@ -163,7 +205,8 @@ void engine_table_unregister(ENGINE_TABLE **table, ENGINE *e)
 {
     CRYPTO_THREAD_write_lock(global_engine_lock);
     if (int_table_check(table, 0))
-        lh_ENGINE_PILE_doall_ENGINE(&(*table)->piles, int_unregister_cb, e);
+        lh_ENGINE_PILE_doall_ENGINE((*table)->piles, int_unregister_cb, e);
+    table_touch();
     CRYPTO_THREAD_unlock(global_engine_lock);
 }
 
@@ -181,9 +224,11 @@ void engine_table_cleanup(ENGINE_TABLE **table)
 {
     CRYPTO_THREAD_write_lock(global_engine_lock);
     if (*table) {
-        lh_ENGINE_PILE_doall(&(*table)->piles, int_cleanup_cb_doall);
-        lh_ENGINE_PILE_free(&(*table)->piles);
+        lh_ENGINE_PILE_doall((*table)->piles, int_cleanup_cb_doall);
+        lh_ENGINE_PILE_free((*table)->piles);
+        OPENSSL_free(*table);
         *table = NULL;
+        table_touch();
     }
     CRYPTO_THREAD_unlock(global_engine_lock);
 }
@@ -199,8 +244,22 @@ ENGINE *engine_table_select_tmp(ENGINE_TABLE **table, int nid, const char *f,
     ENGINE *ret = NULL;
     ENGINE_PILE tmplate, *fnd = NULL;
     int initres, loop = 0;
+#ifdef ENGINE_TABLE_MISS_CACHE
+    ENGINE_TABLE *t = __atomic_load_n(table, __ATOMIC_ACQUIRE);
+    uint64_t miss;
 
-    if (!(*table)) {
+    if (t != NULL) {
+        miss = (uint64_t)__atomic_load_n(&table_generation, __ATOMIC_ACQUIRE)
+               << 32 | (unsigned int)nid;
+        if (__atomic_load_n(&t->miss[ENGINE_TABLE_MISS_SLOT(nid)],
+                            __ATOMIC_RELAXED) == miss)
+            return NULL;
+    }
+#else
+    ENGINE_TABLE *t = *table;
+#endif
+
+    if (t == NULL) {
 #ifdef ENGINE_TABLE_DEBUG
         fprintf(stderr, "engine_table_dbg: %s:%d, nid=%d, nothing "
                 "registered!\n", f, l, nid);
@@ -216,7 +275,7 @@ ENGINE *engine_table_select_tmp(ENGINE_TABLE **table, int nid, const char *f,
     if (!int_table_check(table, 0))
         goto end;
     tmplate.nid = nid;
-    fnd = lh_ENGINE_PILE_retrieve(&(*table)->piles, &tmplate);
+    fnd = lh_ENGINE_PILE_retrieve((*table)->piles, &tmplate);
     if (!fnd)
         goto end;
     if (fnd->funct && engine_unlocked_init(fnd->funct)) {
@@ -271,6 +330,13 @@ ENGINE *engine_table_select_tmp(ENGINE_TABLE **table, int nid, const char *f,
      */
     if (fnd)
         fnd->uptodate = 1;
+#ifdef ENGINE_TABLE_MISS_CACHE
+    /* Until the next (un)registration this lookup will give NULL again */
+    if (ret == NULL && *table != NULL && (fnd == NULL || fnd->funct == NULL))
+        __atomic_store_n(&(*table)->miss[ENGINE_TABLE_MISS_SLOT(nid)],
+                         (uint64_t)table_generation << 32 | (unsigned int)nid,
+                         __ATOMIC_RELAXED);
+#endif
 #ifdef ENGINE_TABLE_DEBUG
     if (ret)
         fprintf(stderr, "engine_table_dbg: %s:%d, nid=%d, caching "
@@ -304,5 +370,5 @@ void engine_table_doall(ENGINE_TABLE *table, engine_table_doall_cb *cb,
     dall.cb = cb;
     dall.arg = arg;
     if (table)
-        lh_ENGINE_PILE_doall_ENGINE_PILE_DOALL(&table->piles, int_dall, &dall);
+        lh_ENGINE_PILE_doall_ENGINE_PILE_DOALL(table->piles, int_dall, &dall);
 }
@@ -21,6 +21,7 @@
 #include "internal/thread_once.h"
 #include "crypto/ctype.h"
 #include "internal/constant_time.h"
+#include "internal/tsan_assist.h"
 #include "e_os.h"
 
 #ifndef OPENSSL_NO_ERR
@@ -96,6 +97,7 @@ static ERR_STRING_DATA ERR_str_functs[] = {
     {ERR_PACK(0, SYS_F_STAT, 0), "stat"},
     {ERR_PACK(0, SYS_F_FCNTL, 0), "fcntl"},
     {ERR_PACK(0, SYS_F_FSTAT, 0), "fstat"},
+    {ERR_PACK(0, SYS_F_SENDFILE, 0), "sendfile"},
     {0, NULL},
 };
 
@@ -141,10 +143,26 @@ static ERR_STRING_DATA ERR_str_reasons[] = {
 static CRYPTO_ONCE err_init = CRYPTO_ONCE_STATIC_INIT;
 static int set_err_thread_local;
 static CRYPTO_THREAD_LOCAL err_thread_local;
+/* |err_thread_local| is usable without going through the init checks */
+static int err_thread_local_ready;
 
 static CRYPTO_ONCE err_string_init = CRYPTO_ONCE_STATIC_INIT;
 static CRYPTO_RWLOCK *err_string_lock = NULL;
 
+#ifndef OPENSSL_NO_ERR
+static int err_strings_loaded;
+static int err_strings_loading_now;
+static CRYPTO_THREAD_ID err_strings_loader;
+
+/* Loaders handed to ERR_load_strings_deferred(), run on first lookup */
+# define ERR_MAX_DEFERRED_LOADERS 8
+static int (*err_deferred_loaders[ERR_MAX_DEFERRED_LOADERS])(void);
+static int err_num_deferred_loaders;
+/* Set once the loaders above have been taken, guarded by err_string_lock */
+static int err_deferred_loaders_run;
+static CRYPTO_ONCE err_deferred_once = CRYPTO_ONCE_STATIC_INIT;
+#endif
+
 #ifndef OPENSSL_NO_ERR
 static ERR_STRING_DATA *int_err_get_item(const ERR_STRING_DATA *);
 #endif
@@ -319,6 +337,9 @@ DEFINE_RUN_ONCE_STATIC(do_err_strings_init)
 
 void err_cleanup(void)
 {
+#ifdef tsan_st_rel
+    tsan_st_rel((TSAN_QUALIFIER int *)&err_thread_local_ready, 0);
+#endif
     if (set_err_thread_local != 0)
         CRYPTO_THREAD_cleanup_local(&err_thread_local);
     CRYPTO_THREAD_lock_free(err_string_lock);
@@ -326,6 +347,8 @@ void err_cleanup(void)
 #ifndef OPENSSL_NO_ERR
     lh_ERR_STRING_DATA_free(int_error_hash);
     int_error_hash = NULL;
+    err_strings_loaded = 0;
+    err_num_deferred_loaders = 0;
 #endif
 }
 
@@ -653,12 +676,88 @@ char *ERR_error_string(unsigned long e, char *ret)
     return ret;
 }
 
+#ifndef OPENSSL_NO_ERR
+/*
+ * The library's own strings are loaded when a string is first looked up
+ * rather than when a thread raises its first error, so code that only
+ * checks and clears errors never pays for loading them.  Every
+ * ERR_load_*_strings() looks up a string itself, so the thread doing the
+ * loading must not wait for it here.  Failures are ignored: the lookup
+ * then just finds nothing.
+ */
+DEFINE_RUN_ONCE_STATIC(err_do_deferred_loads)
+{
+    int (*loaders[ERR_MAX_DEFERRED_LOADERS])(void);
+    int i, n;
+
+    CRYPTO_THREAD_write_lock(err_string_lock);
+    n = err_num_deferred_loaders;
+    memcpy(loaders, err_deferred_loaders, n * sizeof(loaders[0]));
+    err_deferred_loaders_run = 1;
+    CRYPTO_THREAD_unlock(err_string_lock);
+
+    err_strings_loading(1);
+    for (i = 0; i < n; i++)
+        loaders[i]();
+    err_strings_loading(0);
+    return 1;
+}
+
+static void err_load_strings_on_demand(void)
+{
+    if (err_strings_loaded)
+        return;
+    if (err_strings_loading_now
+            && CRYPTO_THREAD_compare_id(err_strings_loader,
+                                        CRYPTO_THREAD_get_current_id()))
+        return;
+    if (OPENSSL_init_crypto(OPENSSL_INIT_LOAD_CRYPTO_STRINGS, NULL)
+            && RUN_ONCE(&err_string_init, do_err_strings_init)
+            && RUN_ONCE(&err_deferred_once, err_do_deferred_loads))
+        err_strings_loaded = 1;
+}
+#endif
+
+/*
+ * Libraries built on libcrypto use this rather than loading their strings
+ * up front.  Once the first lookup has happened |loader| runs straight away.
+ */
+int ERR_load_strings_deferred(int (*loader)(void))
+{
+#ifndef OPENSSL_NO_ERR
+    if (!RUN_ONCE(&err_string_init, do_err_strings_init))
+        return 0;
+
+    CRYPTO_THREAD_write_lock(err_string_lock);
+    if (!err_deferred_loaders_run
+            && err_num_deferred_loaders < ERR_MAX_DEFERRED_LOADERS) {
+        err_deferred_loaders[err_num_deferred_loaders++] = loader;
+        CRYPTO_THREAD_unlock(err_string_lock);
+        return 1;
+    }
+    CRYPTO_THREAD_unlock(err_string_lock);
+    return loader();
+#else
+    return 1;
+#endif
+}
+
+void err_strings_loading(int on)
+{
+#ifndef OPENSSL_NO_ERR
+    if (on)
+        err_strings_loader = CRYPTO_THREAD_get_current_id();
+    err_strings_loading_now = on;
+#endif
+}
+
 const char *ERR_lib_error_string(unsigned long e)
 {
 #ifndef OPENSSL_NO_ERR
     ERR_STRING_DATA d, *p;
     unsigned long l;
 
+    err_load_strings_on_demand();
     if (!RUN_ONCE(&err_string_init, do_err_strings_init)) {
         return NULL;
     }
@@ -678,6 +777,7 @@ const char *ERR_func_error_string(unsigned long e)
     ERR_STRING_DATA d, *p;
     unsigned long l, f;
 
+    err_load_strings_on_demand();
     if (!RUN_ONCE(&err_string_init, do_err_strings_init)) {
         return NULL;
     }
@@ -698,6 +798,7 @@ const char *ERR_reason_error_string(unsigned long e)
     ERR_STRING_DATA d, *p = NULL;
     unsigned long l, r;
 
+    err_load_strings_on_demand();
     if (!RUN_ONCE(&err_string_init, do_err_strings_init)) {
         return NULL;
     }
@@ -741,7 +842,12 @@ void ERR_remove_state(unsigned long pid)
 DEFINE_RUN_ONCE_STATIC(err_do_init)
 {
     set_err_thread_local = 1;
-    return CRYPTO_THREAD_init_local(&err_thread_local, NULL);
+    if (!CRYPTO_THREAD_init_local(&err_thread_local, NULL))
+        return 0;
+#ifdef tsan_st_rel
+    tsan_st_rel((TSAN_QUALIFIER int *)&err_thread_local_ready, 1);
+#endif
+    return 1;
 }
 
 ERR_STATE *ERR_get_state(void)
@@ -749,6 +855,20 @@ ERR_STATE *ERR_get_state(void)
     ERR_STATE *state;
     int saveerrno = get_last_sys_error();
 
+#ifdef tsan_ld_acq
+    /*
+     * A thread that already has its state needs none of the initialization
+     * checks below; every error raised and every mark set comes through here.
+     */
+    if (tsan_ld_acq((TSAN_QUALIFIER int *)&err_thread_local_ready)) {
+        state = CRYPTO_THREAD_get_local(&err_thread_local);
+        if (state != NULL && state != (ERR_STATE*)-1) {
+            set_sys_error(saveerrno);
+            return state;
+        }
+    }
+#endif
+
     if (!OPENSSL_init_crypto(OPENSSL_INIT_BASE_ONLY, NULL))
         return NULL;
 
@@ -774,9 +894,6 @@ ERR_STATE *ERR_get_state(void)
             CRYPTO_THREAD_set_local(&err_thread_local, NULL);
             return NULL;
         }
-
-        /* Ignore failures from these */
-        OPENSSL_init_crypto(OPENSSL_INIT_LOAD_CRYPTO_STRINGS, NULL);
     }
 
     set_sys_error(saveerrno);
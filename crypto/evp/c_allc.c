@@ -141,6 +141,7 @@ void openssl_add_all_ciphers_int(void)
     EVP_add_cipher(EVP_aes_128_ofb());
     EVP_add_cipher(EVP_aes_128_ctr());
     EVP_add_cipher(EVP_aes_128_gcm());
+    EVP_add_cipher(EVP_aes_128_gcm_siv());
 #ifndef OPENSSL_NO_OCB
     EVP_add_cipher(EVP_aes_128_ocb());
 #endif
@@ -176,6 +177,7 @@ void openssl_add_all_ciphers_int(void)
     EVP_add_cipher(EVP_aes_256_ofb());
     EVP_add_cipher(EVP_aes_256_ctr());
     EVP_add_cipher(EVP_aes_256_gcm());
+    EVP_add_cipher(EVP_aes_256_gcm_siv());
 #ifndef OPENSSL_NO_OCB
     EVP_add_cipher(EVP_aes_256_ocb());
 #endif
@@ -299,6 +299,79 @@ int EVP_Digest(const void *data, size_t count,
     return ret;
 }
 
+/*
+ * Hashes |num| independent messages with one context, so that the digest
+ * state is allocated and the implementation looked up once for the whole
+ * batch rather than once per message. |mdlen| is the output length of an
+ * XOF and must be 0 or the digest size for other digests.
+ */
+int EVP_DigestBatch(const void *const data[], const size_t count[],
+                    unsigned char *const md[], size_t mdlen, size_t num,
+                    const EVP_MD *type, ENGINE *impl)
+{
+    EVP_MD_CTX *ctx;
+    int xof = (EVP_MD_meth_get_flags(type) & EVP_MD_FLAG_XOF) != 0;
+    size_t i;
+    int ret;
+
+    if (xof ? mdlen == 0
+            : mdlen != 0 && mdlen != (size_t)EVP_MD_size(type)) {
+        EVPerr(EVP_F_EVP_DIGESTBATCH, EVP_R_NOT_XOF_OR_INVALID_LENGTH);
+        return 0;
+    }
+    if (num == 0)
+        return 1;
+    if ((ctx = EVP_MD_CTX_new()) == NULL) {
+        EVPerr(EVP_F_EVP_DIGESTBATCH, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    EVP_MD_CTX_set_flags(ctx, EVP_MD_CTX_FLAG_ONESHOT);
+    ret = EVP_DigestInit_ex(ctx, type, impl);
+    if (ret && ctx->engine == NULL && ctx->digest->batch != NULL) {
+        /* multi-buffer implementation, hashes several messages at a time */
+        ret = ctx->digest->batch(data, count, md, num);
+    } else {
+        for (i = 0; ret && i < num; i++) {
+            if (i > 0) {
+                /* same digest and ENGINE, so only the state needs resetting */
+                EVP_MD_CTX_clear_flags(ctx, EVP_MD_CTX_FLAG_CLEANED);
+                ret = ctx->digest->init(ctx);
+            }
+            ret = ret
+                  && EVP_DigestUpdate(ctx, data[i], count[i])
+                  && (xof ? EVP_DigestFinalXOF(ctx, md[i], mdlen)
+                          : EVP_DigestFinal_ex(ctx, md[i], NULL));
+        }
+    }
+    EVP_MD_CTX_free(ctx);
+
+    return ret;
+}
+
+/*
+ * Replaces the digest at |md| with its digest, |iter| times, as iterated
+ * KDFs do. |ctx| must have been set up for the digest by a previous
+ * EVP_DigestInit_ex(), and is only reset between iterations.
+ */
+int evp_md_ctx_iterate(EVP_MD_CTX *ctx, unsigned char *md, size_t iter)
+{
+    size_t mdlen = EVP_MD_size(ctx->digest);
+
+    if (ctx->engine == NULL && ctx->digest->iterate != NULL) {
+        /* built-in digest, iterates on its compression function */
+        ctx->digest->iterate(md, iter);
+        return 1;
+    }
+    for (; iter > 0; iter--) {
+        EVP_MD_CTX_clear_flags(ctx, EVP_MD_CTX_FLAG_CLEANED);
+        if (!ctx->digest->init(ctx)
+                || !EVP_DigestUpdate(ctx, md, mdlen)
+                || !EVP_DigestFinal_ex(ctx, md, NULL))
+            return 0;
+    }
+    return 1;
+}
+
 int EVP_MD_CTX_ctrl(EVP_MD_CTX *ctx, int cmd, int p1, void *p2)
 {
     if (ctx->digest && ctx->digest->md_ctrl) {
@@ -12,6 +12,7 @@
 #include <openssl/evp.h>
 #include <openssl/err.h>
 #include <string.h>
+#include <limits.h>
 #include <assert.h>
 #include <openssl/aes.h>
 #include "crypto/evp.h"
@@ -52,6 +53,10 @@ typedef struct {
         double align;
         AES_KEY ks;
     } ks1, ks2;                 /* AES key schedules to use */
+    union {
+        double align;
+        AES_KEY ks;
+    } ks2dec;                   /* key2 decryption, for parallel tweaks */
     XTS128_CONTEXT xts;
     void (*stream) (const unsigned char *in,
                     unsigned char *out, size_t length,
@@ -406,6 +411,7 @@ static int aesni_xts_init_key(EVP_CIPHER_CTX *ctx, const unsigned char *key,
             EVPerr(EVP_F_AESNI_XTS_INIT_KEY, EVP_R_XTS_DUPLICATED_KEYS);
             return 0;
         }
+        AES_set_decrypt_key(key + bytes, bytes * 8, &xctx->ks2dec.ks);
 
         /* key_len is two AES keys */
         if (enc) {
@@ -826,6 +832,7 @@ static int aes_t4_xts_init_key(EVP_CIPHER_CTX *ctx, const unsigned char *key,
             EVPerr(EVP_F_AES_T4_XTS_INIT_KEY, EVP_R_XTS_DUPLICATED_KEYS);
             return 0;
         }
+        AES_set_decrypt_key(key + bytes, bits, &xctx->ks2dec.ks);
 
         xctx->stream = NULL;
         /* key_len is two AES keys */
@@ -2564,6 +2571,22 @@ const EVP_CIPHER *EVP_aes_##keylen##_##mode(void) \
 #  define HWAES_decrypt aes_v8_decrypt
 #  define HWAES_cbc_encrypt aes_v8_cbc_encrypt
 #  define HWAES_ctr32_encrypt_blocks aes_v8_ctr32_encrypt_blocks
+#  if defined(__aarch64__)
+size_t armv8_aes_gcm_encrypt(const unsigned char *in,
+                             unsigned char *out,
+                             size_t len,
+                             const void *key, unsigned char ivec[16], u64 *Xi);
+#   define AES_gcm_encrypt armv8_aes_gcm_encrypt
+size_t armv8_aes_gcm_decrypt(const unsigned char *in,
+                             unsigned char *out,
+                             size_t len,
+                             const void *key, unsigned char ivec[16], u64 *Xi);
+#   define AES_gcm_decrypt armv8_aes_gcm_decrypt
+void gcm_ghash_v8(u64 Xi[2], const u128 Htable[16], const u8 *in,
+                  size_t len);
+#   define AES_GCM_ASM(gctx)      (gctx->ctr==(ctr128_f)HWAES_ctr32_encrypt_blocks && \
+                                 gctx->gcm.ghash==gcm_ghash_v8)
+#  endif
 # endif
 #endif
 
@@ -2812,12 +2835,102 @@ static int aes_cfb1_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
     return 1;
 }
 
+typedef struct {
+    const EVP_AES_KEY *dat;
+    const unsigned char *in;
+    unsigned char *out;
+    size_t len;
+    unsigned char ctr[AES_BLOCK_SIZE]; /* counter at offset 0 */
+    unsigned char iv[AES_BLOCK_SIZE]; /* counter at the end */
+    unsigned char buf[AES_BLOCK_SIZE]; /* keystream left at the end */
+    unsigned int num;
+} AES_CTR_PARALLEL;
+
+/* 128-bit big-endian counter += blocks */
+static void aes_ctr_add(unsigned char counter[AES_BLOCK_SIZE], size_t blocks)
+{
+    unsigned int carry = 0;
+    int i;
+
+    for (i = AES_BLOCK_SIZE - 1; i >= 0 && (blocks != 0 || carry != 0); i--) {
+        carry += counter[i] + (unsigned int)(blocks & 0xff);
+        counter[i] = (unsigned char)carry;
+        carry >>= 8;
+        blocks >>= 8;
+    }
+}
+
+static void aes_ctr_piece(void *arg, size_t off, size_t len)
+{
+    AES_CTR_PARALLEL *p = arg;
+    const EVP_AES_KEY *dat = p->dat;
+    unsigned char iv[AES_BLOCK_SIZE], buf[AES_BLOCK_SIZE];
+    unsigned int num = 0;
+
+    memcpy(iv, p->ctr, AES_BLOCK_SIZE);
+    aes_ctr_add(iv, off / AES_BLOCK_SIZE);
+    if (dat->stream.ctr)
+        CRYPTO_ctr128_encrypt_ctr32(p->in + off, p->out + off, len, &dat->ks,
+                                    iv, buf, &num, dat->stream.ctr);
+    else
+        CRYPTO_ctr128_encrypt(p->in + off, p->out + off, len, &dat->ks,
+                              iv, buf, &num, dat->block);
+    if (off + len == p->len) {
+        memcpy(p->iv, iv, AES_BLOCK_SIZE);
+        memcpy(p->buf, buf, AES_BLOCK_SIZE);
+        p->num = num;
+    }
+    OPENSSL_cleanse(buf, sizeof(buf));
+}
+
+/*
+ * Split a large update across threads.  Any keystream left over from the
+ * previous call is used up first so that every piece starts on a block
+ * boundary with a counter it can compute from its offset; the state the
+ * last piece ends with becomes the context's.
+ */
+static int aes_ctr_cipher_parallel(EVP_CIPHER_CTX *ctx, unsigned char *out,
+                                   const unsigned char *in, size_t len,
+                                   int pieces)
+{
+    unsigned int num = EVP_CIPHER_CTX_num(ctx);
+    EVP_AES_KEY *dat = EVP_C_DATA(EVP_AES_KEY,ctx);
+    AES_CTR_PARALLEL p;
+
+    if (num != 0) {
+        size_t head = AES_BLOCK_SIZE - num;
+
+        CRYPTO_ctr128_encrypt(in, out, head, &dat->ks,
+                              EVP_CIPHER_CTX_iv_noconst(ctx),
+                              EVP_CIPHER_CTX_buf_noconst(ctx), &num,
+                              dat->block);
+        in += head;
+        out += head;
+        len -= head;
+    }
+
+    p.dat = dat;
+    p.in = in;
+    p.out = out;
+    p.len = len;
+    memcpy(p.ctr, EVP_CIPHER_CTX_iv(ctx), AES_BLOCK_SIZE);
+    evp_cipher_parallel(pieces, len, aes_ctr_piece, &p);
+    memcpy(EVP_CIPHER_CTX_iv_noconst(ctx), p.iv, AES_BLOCK_SIZE);
+    memcpy(EVP_CIPHER_CTX_buf_noconst(ctx), p.buf, AES_BLOCK_SIZE);
+    EVP_CIPHER_CTX_set_num(ctx, p.num);
+    OPENSSL_cleanse(p.buf, sizeof(p.buf));
+    return 1;
+}
+
 static int aes_ctr_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
                           const unsigned char *in, size_t len)
 {
     unsigned int num = EVP_CIPHER_CTX_num(ctx);
     EVP_AES_KEY *dat = EVP_C_DATA(EVP_AES_KEY,ctx);
+    int pieces;
 
+    if ((pieces = evp_cipher_parallel_pieces(ctx, len)) > 1)
+        return aes_ctr_cipher_parallel(ctx, out, in, len, pieces);
     if (dat->stream.ctr)
         CRYPTO_ctr128_encrypt_ctr32(in, out, len, &dat->ks,
                                     EVP_CIPHER_CTX_iv_noconst(ctx),
@@ -3383,6 +3496,8 @@ static int aes_xts_init_key(EVP_CIPHER_CTX *ctx, const unsigned char *key,
                 EVPerr(EVP_F_AES_XTS_INIT_KEY, EVP_R_XTS_DUPLICATED_KEYS);
                 return 0;
             }
+            /* see aes_xts_cipher_parallel() */
+            AES_set_decrypt_key(key + bytes, bytes * 8, &xctx->ks2dec.ks);
 
 #ifdef AES_XTS_ASM
             xctx->stream = enc ? AES_xts_encrypt : AES_xts_decrypt;
@@ -3475,14 +3590,83 @@ static int aes_xts_init_key(EVP_CIPHER_CTX *ctx, const unsigned char *key,
     return 1;
 }
 
+typedef struct {
+    const EVP_AES_XTS_CTX *xctx;
+    const unsigned char *in;
+    unsigned char *out;
+    const unsigned char *iv;
+    unsigned char tweak[AES_BLOCK_SIZE]; /* E(key2, iv) */
+    int enc;
+    int ret;                    /* set by the piece holding the tail */
+} AES_XTS_PARALLEL;
+
+static void aes_xts_piece(void *arg, size_t off, size_t len)
+{
+    AES_XTS_PARALLEL *p = arg;
+    const EVP_AES_XTS_CTX *xctx = p->xctx;
+    unsigned char iv[AES_BLOCK_SIZE];
+    int ret = 0;
+
+    if (off == 0) {
+        memcpy(iv, p->iv, AES_BLOCK_SIZE);
+    } else {
+        /*
+         * The stream routines take the IV rather than the tweak, so hand
+         * them the block that key2 encrypts to this piece's first tweak.
+         */
+        memcpy(iv, p->tweak, AES_BLOCK_SIZE);
+        CRYPTO_xts128_tweak_advance(iv, off / AES_BLOCK_SIZE);
+        AES_decrypt(iv, iv, &xctx->ks2dec.ks);
+    }
+    if (xctx->stream)
+        (*xctx->stream) (p->in + off, p->out + off, len,
+                         xctx->xts.key1, xctx->xts.key2, iv);
+    else
+        ret = CRYPTO_xts128_encrypt(&xctx->xts, iv, p->in + off,
+                                    p->out + off, len, p->enc);
+    /* only the last piece can fail, it is the one with the odd length */
+    if (ret != 0)
+        p->ret = ret;
+    OPENSSL_cleanse(iv, sizeof(iv));
+}
+
+/*
+ * Split one data unit across threads.  Each piece but the first starts
+ * from its own tweak, E(key2, iv) * alpha^j for block j, and the last
+ * piece keeps any ciphertext stealing, so the result is identical to the
+ * serial one.
+ */
+static int aes_xts_cipher_parallel(EVP_CIPHER_CTX *ctx, unsigned char *out,
+                                   const unsigned char *in, size_t len,
+                                   int pieces)
+{
+    EVP_AES_XTS_CTX *xctx = EVP_C_DATA(EVP_AES_XTS_CTX,ctx);
+    AES_XTS_PARALLEL p;
+
+    p.xctx = xctx;
+    p.in = in;
+    p.out = out;
+    p.iv = EVP_CIPHER_CTX_iv(ctx);
+    p.enc = EVP_CIPHER_CTX_encrypting(ctx);
+    p.ret = 0;
+    (*xctx->xts.block2) (p.iv, p.tweak, xctx->xts.key2);
+    evp_cipher_parallel(pieces, len, aes_xts_piece, &p);
+    OPENSSL_cleanse(p.tweak, sizeof(p.tweak));
+    return p.ret == 0;
+}
+
 static int aes_xts_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
                           const unsigned char *in, size_t len)
 {
     EVP_AES_XTS_CTX *xctx = EVP_C_DATA(EVP_AES_XTS_CTX,ctx);
+    int pieces;
+
     if (!xctx->xts.key1 || !xctx->xts.key2)
         return 0;
     if (!out || !in || len < AES_BLOCK_SIZE)
         return 0;
+    if ((pieces = evp_cipher_parallel_pieces(ctx, len)) > 1)
+        return aes_xts_cipher_parallel(ctx, out, in, len, pieces);
     if (xctx->stream)
         (*xctx->stream) (in, out, len,
                          xctx->xts.key1, xctx->xts.key2,
@@ -4286,3 +4470,329 @@ BLOCK_CIPHER_custom(NID_aes, 192, 16, 12, ocb, OCB,
 BLOCK_CIPHER_custom(NID_aes, 256, 16, 12, ocb, OCB,
                     EVP_CIPH_FLAG_AEAD_CIPHER | CUSTOM_FLAGS)
 #endif                         /* OPENSSL_NO_OCB */
+
+/*
+ * AES-GCM-SIV, RFC 8452.  The tag doubles as the CTR IV, so the whole text
+ * has to be passed in a single EVP_CipherUpdate() call; AAD may be passed
+ * in any number of calls before that.  Decryption checks the tag there
+ * too, and releases no plaintext if it does not match.
+ */
+typedef struct {
+    union {
+        double align;
+        AES_KEY ks;
+    } ks;                       /* AES key schedule of the key */
+    union {
+        double align;
+        AES_KEY ks;
+    } ks_enc;                   /* message encryption key for this nonce */
+    int (*set_key) (const unsigned char *userKey, int bits, AES_KEY *key);
+    block128_f block;
+    /* NULL if there is no multi-block ECB routine to use */
+    void (*ecb) (const unsigned char *in, unsigned char *out, size_t len,
+                 const AES_KEY *key, int enc);
+    GCM128_CONTEXT polyval;
+    int key_set;                /* Set if key initialised */
+    int iv_set;                 /* Set if an iv is set */
+    int text_done;              /* Set once the (only) text is processed */
+    int tag_ok;                 /* Set if the decrypted text authenticated */
+    unsigned int aad_buf_len;
+    uint64_t aad_len;
+    unsigned char nonce[12];
+    unsigned char tag[16];
+    unsigned char aad_buf[16];  /* Store partial AAD blocks */
+} EVP_AES_GCM_SIV_CTX;
+
+/* RFC 8452 caps the AAD at 2^36 bytes, the text fits an int anyway */
+#define GCM_SIV_MAX_LEN        ((uint64_t)1 << 36)
+/* counter blocks encrypted per call into the block cipher */
+#define GCM_SIV_CTR_BLOCKS     32
+
+static void aes_gcm_siv_put_le32(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static void aes_gcm_siv_put_le64(unsigned char *p, uint64_t v)
+{
+    aes_gcm_siv_put_le32(p, (uint32_t)v);
+    aes_gcm_siv_put_le32(p + 4, (uint32_t)(v >> 32));
+}
+
+/* derive the per-nonce authentication and encryption keys */
+static void aes_gcm_siv_derive_keys(EVP_AES_GCM_SIV_CTX *sctx, int keylen)
+{
+    unsigned char in[16], out[16], keys[16 + 32];
+    int i;
+
+    memcpy(in + 4, sctx->nonce, sizeof(sctx->nonce));
+    for (i = 0; i < (16 + keylen) / 8; i++) {
+        aes_gcm_siv_put_le32(in, (uint32_t)i);
+        sctx->block(in, out, &sctx->ks.ks);
+        memcpy(keys + 8 * i, out, 8);
+    }
+    CRYPTO_polyval_init(&sctx->polyval, keys);
+    sctx->set_key(keys + 16, keylen * 8, &sctx->ks_enc.ks);
+    sctx->aad_buf_len = 0;
+    sctx->aad_len = 0;
+    sctx->text_done = 0;
+    sctx->tag_ok = 0;
+    OPENSSL_cleanse(keys, sizeof(keys));
+    OPENSSL_cleanse(out, sizeof(out));
+}
+
+/* finish POLYVAL over the padded AAD and text and turn it into the tag */
+static void aes_gcm_siv_tag(EVP_AES_GCM_SIV_CTX *sctx,
+                            const unsigned char *text, size_t len,
+                            unsigned char tag[16])
+{
+    unsigned char blk[16];
+    size_t full = len & ~(size_t)15;
+    int i;
+
+    if (sctx->aad_buf_len != 0) {
+        memset(sctx->aad_buf + sctx->aad_buf_len, 0,
+               sizeof(sctx->aad_buf) - sctx->aad_buf_len);
+        CRYPTO_polyval_update(&sctx->polyval, sctx->aad_buf,
+                              sizeof(sctx->aad_buf));
+        sctx->aad_buf_len = 0;
+    }
+    CRYPTO_polyval_update(&sctx->polyval, text, full);
+    if (len != full) {
+        memset(blk, 0, sizeof(blk));
+        memcpy(blk, text + full, len - full);
+        CRYPTO_polyval_update(&sctx->polyval, blk, sizeof(blk));
+    }
+    aes_gcm_siv_put_le64(blk, sctx->aad_len * 8);
+    aes_gcm_siv_put_le64(blk + 8, (uint64_t)len * 8);
+    CRYPTO_polyval_update(&sctx->polyval, blk, sizeof(blk));
+
+    CRYPTO_polyval_final(&sctx->polyval, blk);
+    for (i = 0; i < 12; i++)
+        blk[i] ^= sctx->nonce[i];
+    blk[15] &= 0x7f;
+    sctx->block(blk, tag, &sctx->ks_enc.ks);
+    OPENSSL_cleanse(blk, sizeof(blk));
+}
+
+/*
+ * CTR mode with a 32-bit little-endian counter in the first word.  The
+ * counter blocks are built up front so that the multi-block ECB routine,
+ * where there is one, keeps several blocks in flight.
+ */
+static void aes_gcm_siv_ctr(EVP_AES_GCM_SIV_CTX *sctx, unsigned char *out,
+                            const unsigned char *in, size_t len,
+                            const unsigned char tag[16])
+{
+    unsigned char ks[GCM_SIV_CTR_BLOCKS * 16];
+    uint32_t ctr = (uint32_t)tag[0] | (uint32_t)tag[1] << 8
+                   | (uint32_t)tag[2] << 16 | (uint32_t)tag[3] << 24;
+    size_t i, n, blocks;
+
+    while (len > 0) {
+        n = len < sizeof(ks) ? len : sizeof(ks);
+        blocks = (n + 15) / 16;
+        for (i = 0; i < blocks; i++) {
+            aes_gcm_siv_put_le32(ks + 16 * i, ctr++);
+            memcpy(ks + 16 * i + 4, tag + 4, 12);
+            ks[16 * i + 15] |= 0x80;
+        }
+        if (sctx->ecb != NULL)
+            sctx->ecb(ks, ks, blocks * 16, &sctx->ks_enc.ks, AES_ENCRYPT);
+        else
+            for (i = 0; i < blocks; i++)
+                sctx->block(ks + 16 * i, ks + 16 * i, &sctx->ks_enc.ks);
+        for (i = 0; i < n; i++)
+            out[i] = in[i] ^ ks[i];
+        in += n;
+        out += n;
+        len -= n;
+    }
+    OPENSSL_cleanse(ks, sizeof(ks));
+}
+
+static int aes_gcm_siv_init_key(EVP_CIPHER_CTX *ctx, const unsigned char *key,
+                                const unsigned char *iv, int enc)
+{
+    EVP_AES_GCM_SIV_CTX *sctx = EVP_C_DATA(EVP_AES_GCM_SIV_CTX,ctx);
+
+    if (!iv && !key)
+        return 1;
+    if (key) {
+        do {
+#ifdef AESNI_CAPABLE
+            if (AESNI_CAPABLE) {
+                sctx->set_key = aesni_set_encrypt_key;
+                sctx->block = (block128_f) aesni_encrypt;
+                sctx->ecb = aesni_ecb_encrypt;
+                break;
+            }
+#endif
+#ifdef HWAES_CAPABLE
+            if (HWAES_CAPABLE) {
+                sctx->set_key = HWAES_set_encrypt_key;
+                sctx->block = (block128_f) HWAES_encrypt;
+                sctx->ecb = NULL;
+                break;
+            }
+#endif
+#ifdef VPAES_CAPABLE
+            if (VPAES_CAPABLE) {
+                sctx->set_key = vpaes_set_encrypt_key;
+                sctx->block = (block128_f) vpaes_encrypt;
+                sctx->ecb = NULL;
+                break;
+            }
+#endif
+            sctx->set_key = AES_set_encrypt_key;
+            sctx->block = (block128_f) AES_encrypt;
+            sctx->ecb = NULL;
+        } while (0);
+        sctx->set_key(key, EVP_CIPHER_CTX_key_length(ctx) * 8, &sctx->ks.ks);
+        sctx->key_set = 1;
+    }
+    if (iv) {
+        memcpy(sctx->nonce, iv, sizeof(sctx->nonce));
+        sctx->iv_set = 1;
+    }
+    if (sctx->key_set && sctx->iv_set)
+        aes_gcm_siv_derive_keys(sctx, EVP_CIPHER_CTX_key_length(ctx));
+    return 1;
+}
+
+static int aes_gcm_siv_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
+                              const unsigned char *in, size_t len)
+{
+    EVP_AES_GCM_SIV_CTX *sctx = EVP_C_DATA(EVP_AES_GCM_SIV_CTX,ctx);
+    unsigned char tag[16];
+    size_t n;
+    int rv;
+
+    if (!sctx->key_set || !sctx->iv_set)
+        return -1;
+
+    if (in == NULL) {
+        /* a text that was never passed in is an empty one */
+        if (!sctx->text_done && aes_gcm_siv_cipher(ctx, tag, tag, 0) < 0)
+            return -1;
+        return EVP_CIPHER_CTX_encrypting(ctx) || sctx->tag_ok ? 0 : -1;
+    }
+
+    if (sctx->text_done || len > INT_MAX)
+        return -1;
+    rv = (int)len;
+
+    if (out == NULL) {
+        if (len > GCM_SIV_MAX_LEN - sctx->aad_len)
+            return -1;
+        sctx->aad_len += len;
+        if (sctx->aad_buf_len != 0) {
+            n = sizeof(sctx->aad_buf) - sctx->aad_buf_len;
+            if (n > len)
+                n = len;
+            memcpy(sctx->aad_buf + sctx->aad_buf_len, in, n);
+            sctx->aad_buf_len += n;
+            in += n;
+            len -= n;
+            if (sctx->aad_buf_len < sizeof(sctx->aad_buf))
+                return rv;
+            CRYPTO_polyval_update(&sctx->polyval, sctx->aad_buf,
+                                  sizeof(sctx->aad_buf));
+            sctx->aad_buf_len = 0;
+        }
+        n = len & ~(size_t)15;
+        CRYPTO_polyval_update(&sctx->polyval, in, n);
+        memcpy(sctx->aad_buf, in + n, len - n);
+        sctx->aad_buf_len = len - n;
+        return rv;
+    }
+
+    sctx->text_done = 1;
+    if (EVP_CIPHER_CTX_encrypting(ctx)) {
+        aes_gcm_siv_tag(sctx, in, len, sctx->tag);
+        aes_gcm_siv_ctr(sctx, out, in, len, sctx->tag);
+        return rv;
+    }
+    aes_gcm_siv_ctr(sctx, out, in, len, sctx->tag);
+    aes_gcm_siv_tag(sctx, out, len, tag);
+    sctx->tag_ok = CRYPTO_memcmp(tag, sctx->tag, sizeof(tag)) == 0;
+    OPENSSL_cleanse(tag, sizeof(tag));
+    if (!sctx->tag_ok) {
+        OPENSSL_cleanse(out, len);
+        return -1;
+    }
+    return rv;
+}
+
+static int aes_gcm_siv_ctrl(EVP_CIPHER_CTX *c, int type, int arg, void *ptr)
+{
+    EVP_AES_GCM_SIV_CTX *sctx = EVP_C_DATA(EVP_AES_GCM_SIV_CTX,c);
+
+    switch (type) {
+    case EVP_CTRL_INIT:
+        sctx->key_set = 0;
+        sctx->iv_set = 0;
+        sctx->text_done = 0;
+        sctx->tag_ok = 0;
+        return 1;
+
+    case EVP_CTRL_AEAD_SET_IVLEN:
+        /* the nonce is always 96 bits */
+        return arg == (int)sizeof(sctx->nonce);
+
+    case EVP_CTRL_AEAD_SET_TAG:
+        if (arg != (int)sizeof(sctx->tag))
+            return 0;
+        if (ptr == NULL)
+            return 1;
+        if (EVP_CIPHER_CTX_encrypting(c))
+            return 0;
+        memcpy(sctx->tag, ptr, arg);
+        return 1;
+
+    case EVP_CTRL_AEAD_GET_TAG:
+        if (arg <= 0 || arg > (int)sizeof(sctx->tag)
+                || !EVP_CIPHER_CTX_encrypting(c) || !sctx->text_done)
+            return 0;
+        memcpy(ptr, sctx->tag, arg);
+        return 1;
+
+    default:
+        return -1;
+    }
+}
+
+#define GCM_SIV_FLAGS  (EVP_CIPH_GCM_SIV_MODE | EVP_CIPH_FLAG_AEAD_CIPHER \
+                | EVP_CIPH_CUSTOM_IV | EVP_CIPH_FLAG_CUSTOM_CIPHER \
+                | EVP_CIPH_ALWAYS_CALL_INIT | EVP_CIPH_CTRL_INIT)
+
+static const EVP_CIPHER aes_128_gcm_siv = {
+    NID_aes_128_gcm_siv,
+    1, 16, 12, GCM_SIV_FLAGS,
+    aes_gcm_siv_init_key, aes_gcm_siv_cipher,
+    NULL,
+    sizeof(EVP_AES_GCM_SIV_CTX),
+    NULL, NULL, aes_gcm_siv_ctrl, NULL
+};
+
+const EVP_CIPHER *EVP_aes_128_gcm_siv(void)
+{
+    return &aes_128_gcm_siv;
+}
+
+static const EVP_CIPHER aes_256_gcm_siv = {
+    NID_aes_256_gcm_siv,
+    1, 32, 12, GCM_SIV_FLAGS,
+    aes_gcm_siv_init_key, aes_gcm_siv_cipher,
+    NULL,
+    sizeof(EVP_AES_GCM_SIV_CTX),
+    NULL, NULL, aes_gcm_siv_ctrl, NULL
+};
+
+const EVP_CIPHER *EVP_aes_256_gcm_siv(void)
+{
+    return &aes_256_gcm_siv;
+}
@@ -22,6 +22,7 @@
 /* ARIA subkey Structure */
 typedef struct {
     ARIA_KEY ks;
+    ctr128_f ctr;               /* counter mode kernel, if any */
 } EVP_ARIA_KEY;
 
 /* ARIA GCM context */
@@ -38,6 +39,7 @@ typedef struct {
     int taglen;
     int iv_gen;                 /* It is OK to generate IVs */
     int tls_aad_len;            /* TLS AAD length */
+    ctr128_f ctr;
 } EVP_ARIA_GCM_CTX;
 
 /* ARIA CCM context */
@@ -56,6 +58,30 @@ typedef struct {
     ccm128_f str;
 } EVP_ARIA_CCM_CTX;
 
+# if defined(ARIA_ASM) && (defined(__x86_64) || defined(_M_AMD64) || \
+                          defined(_M_X64)) && !defined(OPENSSL_SMALL_FOOTPRINT)
+/*
+ * AVX2/GFNI counter mode, 16 blocks at a time. It takes the key schedule
+ * of the table-based aria.c, which OPENSSL_SMALL_FOOTPRINT replaces.
+ */
+int aria_avx2_capable(void);
+void aria_avx2_ctr32_encrypt_blocks(const unsigned char *in,
+                                    unsigned char *out, size_t blocks,
+                                    const ARIA_KEY *key,
+                                    const unsigned char ivec[16]);
+#  define ARIA_AVX2_CAPABLE (aria_avx2_capable())
+# endif
+
+/* Counter mode kernel for the processor, or NULL to go block by block */
+static ctr128_f aria_ctr32_stream(void)
+{
+# ifdef ARIA_AVX2_CAPABLE
+    if (ARIA_AVX2_CAPABLE)
+        return (ctr128_f) aria_avx2_ctr32_encrypt_blocks;
+# endif
+    return NULL;
+}
+
 /* The subkey for ARIA is generated. */
 static int aria_init_key(EVP_CIPHER_CTX *ctx, const unsigned char *key,
                             const unsigned char *iv, int enc)
@@ -73,6 +99,11 @@ static int aria_init_key(EVP_CIPHER_CTX *ctx, const unsigned char *key,
         EVPerr(EVP_F_ARIA_INIT_KEY,EVP_R_ARIA_KEY_SETUP_FAILED);
         return 0;
     }
+    if (mode == EVP_CIPH_CTR_MODE) {
+        EVP_ARIA_KEY *dat = EVP_C_DATA(EVP_ARIA_KEY,ctx);
+
+        dat->ctr = aria_ctr32_stream();
+    }
     return 1;
 }
 
@@ -174,10 +205,16 @@ static int aria_ctr_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
     unsigned int num = EVP_CIPHER_CTX_num(ctx);
     EVP_ARIA_KEY *dat = EVP_C_DATA(EVP_ARIA_KEY,ctx);
 
-    CRYPTO_ctr128_encrypt(in, out, len, &dat->ks,
-                          EVP_CIPHER_CTX_iv_noconst(ctx),
-                          EVP_CIPHER_CTX_buf_noconst(ctx), &num,
-                          (block128_f) aria_encrypt);
+    if (dat->ctr != NULL)
+        CRYPTO_ctr128_encrypt_ctr32(in, out, len, &dat->ks,
+                                    EVP_CIPHER_CTX_iv_noconst(ctx),
+                                    EVP_CIPHER_CTX_buf_noconst(ctx), &num,
+                                    dat->ctr);
+    else
+        CRYPTO_ctr128_encrypt(in, out, len, &dat->ks,
+                              EVP_CIPHER_CTX_iv_noconst(ctx),
+                              EVP_CIPHER_CTX_buf_noconst(ctx), &num,
+                              (block128_f) aria_encrypt);
     EVP_CIPHER_CTX_set_num(ctx, num);
     return 1;
 }
@@ -221,6 +258,7 @@ static int aria_gcm_init_key(EVP_CIPHER_CTX *ctx, const unsigned char *key,
             EVPerr(EVP_F_ARIA_GCM_INIT_KEY,EVP_R_ARIA_KEY_SETUP_FAILED);
             return 0;
         }
+        gctx->ctr = aria_ctr32_stream();
 
         /*
          * If we have an iv can set it directly, otherwise use saved IV.
@@ -418,16 +456,26 @@ static int aria_gcm_tls_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
     len -= EVP_GCM_TLS_EXPLICIT_IV_LEN + EVP_GCM_TLS_TAG_LEN;
     if (EVP_CIPHER_CTX_encrypting(ctx)) {
         /* Encrypt payload */
-        if (CRYPTO_gcm128_encrypt(&gctx->gcm, in, out, len))
+        if (gctx->ctr != NULL) {
+            if (CRYPTO_gcm128_encrypt_ctr32(&gctx->gcm, in, out, len,
+                                            gctx->ctr))
+                goto err;
+        } else if (CRYPTO_gcm128_encrypt(&gctx->gcm, in, out, len)) {
             goto err;
+        }
         out += len;
         /* Finally write tag */
         CRYPTO_gcm128_tag(&gctx->gcm, out, EVP_GCM_TLS_TAG_LEN);
         rv = len + EVP_GCM_TLS_EXPLICIT_IV_LEN + EVP_GCM_TLS_TAG_LEN;
     } else {
         /* Decrypt */
-        if (CRYPTO_gcm128_decrypt(&gctx->gcm, in, out, len))
+        if (gctx->ctr != NULL) {
+            if (CRYPTO_gcm128_decrypt_ctr32(&gctx->gcm, in, out, len,
+                                            gctx->ctr))
+                goto err;
+        } else if (CRYPTO_gcm128_decrypt(&gctx->gcm, in, out, len)) {
             goto err;
+        }
         /* Retrieve tag */
         CRYPTO_gcm128_tag(&gctx->gcm, EVP_CIPHER_CTX_buf_noconst(ctx),
                           EVP_GCM_TLS_TAG_LEN);
@@ -465,11 +513,21 @@ static int aria_gcm_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
             if (CRYPTO_gcm128_aad(&gctx->gcm, in, len))
                 return -1;
         } else if (EVP_CIPHER_CTX_encrypting(ctx)) {
-            if (CRYPTO_gcm128_encrypt(&gctx->gcm, in, out, len))
+            if (gctx->ctr != NULL) {
+                if (CRYPTO_gcm128_encrypt_ctr32(&gctx->gcm, in, out, len,
+                                                gctx->ctr))
+                    return -1;
+            } else if (CRYPTO_gcm128_encrypt(&gctx->gcm, in, out, len)) {
                 return -1;
+            }
         } else {
-            if (CRYPTO_gcm128_decrypt(&gctx->gcm, in, out, len))
+            if (gctx->ctr != NULL) {
+                if (CRYPTO_gcm128_decrypt_ctr32(&gctx->gcm, in, out, len,
+                                                gctx->ctr))
+                    return -1;
+            } else if (CRYPTO_gcm128_decrypt(&gctx->gcm, in, out, len)) {
                 return -1;
+            }
         }
         return len;
     }
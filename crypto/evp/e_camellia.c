@@ -200,6 +200,17 @@ const EVP_CIPHER *EVP_camellia_##keylen##_##mode(void) \
 
 # endif
 
+# if defined(CMLL_ASM) && (defined(__x86_64) || defined(_M_AMD64) || \
+                          defined(_M_X64))
+/* AVX2/GFNI counter mode, 16 blocks at a time */
+int camellia_avx2_capable(void);
+void camellia_avx2_ctr32_encrypt_blocks(const unsigned char *in,
+                                        unsigned char *out, size_t blocks,
+                                        const CAMELLIA_KEY *key,
+                                        const unsigned char ivec[16]);
+#  define CMLL_AVX2_CAPABLE (camellia_avx2_capable())
+# endif
+
 # define BLOCK_CIPHER_generic_pack(nid,keylen,flags)             \
         BLOCK_CIPHER_generic(nid,keylen,16,16,cbc,cbc,CBC,flags|EVP_CIPH_FLAG_DEFAULT_ASN1)     \
         BLOCK_CIPHER_generic(nid,keylen,16,0,ecb,ecb,ECB,flags|EVP_CIPH_FLAG_DEFAULT_ASN1)      \
@@ -233,6 +244,10 @@ static int camellia_init_key(EVP_CIPHER_CTX *ctx, const unsigned char *key,
         dat->stream.cbc = mode == EVP_CIPH_CBC_MODE ?
             (cbc128_f) Camellia_cbc_encrypt : NULL;
     }
+# ifdef CMLL_AVX2_CAPABLE
+    if (mode == EVP_CIPH_CTR_MODE && CMLL_AVX2_CAPABLE)
+        dat->stream.ctr = (ctr128_f) camellia_avx2_ctr32_encrypt_blocks;
+# endif
 
     return 1;
 }
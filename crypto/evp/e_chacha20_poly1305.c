@@ -14,8 +14,8 @@
 
 # include <openssl/evp.h>
 # include <openssl/objects.h>
-# include "evp_local.h"
 # include "crypto/evp.h"
+# include "evp_local.h"
 # include "crypto/chacha.h"
 
 typedef struct {
@@ -162,6 +162,34 @@ typedef struct {
 #  define aead_data(ctx)        ((EVP_CHACHA_AEAD_CTX *)(ctx)->cipher_data)
 #  define POLY1305_ctx(actx)    ((POLY1305 *)(actx + 1))
 
+/*
+ * Cipher and MAC are separate passes over the text, so longer texts are
+ * fed through both a chunk at a time to have Poly1305 read the data while
+ * it is still in L1 rather than refetch it from further out afterwards.
+ */
+#  define CHACHA_POLY1305_CHUNK (32 * CHACHA_BLK_SIZE)
+
+static void chacha20_poly1305_text(EVP_CIPHER_CTX *ctx, unsigned char *out,
+                                   const unsigned char *in, size_t len)
+{
+    EVP_CHACHA_AEAD_CTX *actx = aead_data(ctx);
+    size_t n;
+
+    while (len > 0) {
+        n = len < CHACHA_POLY1305_CHUNK ? len : CHACHA_POLY1305_CHUNK;
+        if (ctx->encrypt) {
+            chacha_cipher(ctx, out, in, n);
+            Poly1305_Update(POLY1305_ctx(actx), out, n);
+        } else {
+            Poly1305_Update(POLY1305_ctx(actx), in, n);
+            chacha_cipher(ctx, out, in, n);
+        }
+        in += n;
+        out += n;
+        len -= n;
+    }
+}
+
 static int chacha20_poly1305_init_key(EVP_CIPHER_CTX *ctx,
                                       const unsigned char *inkey,
                                       const unsigned char *iv, int enc)
@@ -295,13 +323,7 @@ static int chacha20_poly1305_tls_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
         actx->len.aad = EVP_AEAD_TLS1_AAD_LEN;
         actx->len.text = plen;
 
-        if (ctx->encrypt) {
-            ChaCha20_ctr32(out, in, plen, actx->key.key.d, actx->key.counter);
-            Poly1305_Update(POLY1305_ctx(actx), out, plen);
-        } else {
-            Poly1305_Update(POLY1305_ctx(actx), in, plen);
-            ChaCha20_ctr32(out, in, plen, actx->key.key.d, actx->key.counter);
-        }
+        chacha20_poly1305_text(ctx, out, in, plen);
 
         in += plen;
         out += plen;
@@ -409,19 +431,10 @@ static int chacha20_poly1305_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
             else if (len != plen + POLY1305_BLOCK_SIZE)
                 return -1;
 
-            if (ctx->encrypt) {                 /* plaintext */
-                chacha_cipher(ctx, out, in, plen);
-                Poly1305_Update(POLY1305_ctx(actx), out, plen);
-                in += plen;
-                out += plen;
-                actx->len.text += plen;
-            } else {                            /* ciphertext */
-                Poly1305_Update(POLY1305_ctx(actx), in, plen);
-                chacha_cipher(ctx, out, in, plen);
-                in += plen;
-                out += plen;
-                actx->len.text += plen;
-            }
+            chacha20_poly1305_text(ctx, out, in, plen);
+            in += plen;
+            out += plen;
+            actx->len.text += plen;
         }
     }
     if (in == NULL                              /* explicit final */
@@ -34,9 +34,15 @@ static void sm4_cbc_encrypt(const unsigned char *in, unsigned char *out,
     if (enc)
         CRYPTO_cbc128_encrypt(in, out, len, key, ivec,
                               (block128_f)SM4_encrypt);
-    else
-        CRYPTO_cbc128_decrypt(in, out, len, key, ivec,
-                              (block128_f)SM4_decrypt);
+    else {
+        SM4_cbc_decrypt_blocks(in, out, len / SM4_BLOCK_SIZE, key, ivec);
+        in += len & ~(size_t)(SM4_BLOCK_SIZE - 1);
+        out += len & ~(size_t)(SM4_BLOCK_SIZE - 1);
+        len &= SM4_BLOCK_SIZE - 1;
+        if (len > 0)
+            CRYPTO_cbc128_decrypt(in, out, len, key, ivec,
+                                  (block128_f)SM4_decrypt);
+    }
 }
 
 static void sm4_cfb128_encrypt(const unsigned char *in, unsigned char *out,
@@ -74,10 +80,10 @@ static int sm4_ctr_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
     unsigned int num = EVP_CIPHER_CTX_num(ctx);
     EVP_SM4_KEY *dat = EVP_C_DATA(EVP_SM4_KEY, ctx);
 
-    CRYPTO_ctr128_encrypt(in, out, len, &dat->ks,
-                          EVP_CIPHER_CTX_iv_noconst(ctx),
-                          EVP_CIPHER_CTX_buf_noconst(ctx), &num,
-                          (block128_f)SM4_encrypt);
+    CRYPTO_ctr128_encrypt_ctr32(in, out, len, &dat->ks,
+                                EVP_CIPHER_CTX_iv_noconst(ctx),
+                                EVP_CIPHER_CTX_buf_noconst(ctx), &num,
+                                (ctr128_f)SM4_ctr32_encrypt_blocks);
     EVP_CIPHER_CTX_set_num(ctx, num);
     return 1;
 }
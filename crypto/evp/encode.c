@@ -11,8 +11,8 @@
 #include <limits.h>
 #include "internal/cryptlib.h"
 #include <openssl/evp.h>
-#include "evp_local.h"
 #include "crypto/evp.h"
+#include "evp_local.h"
 
 static unsigned char conv_ascii2bin(unsigned char a,
                                     const unsigned char *table);
@@ -20,6 +20,8 @@ static int evp_encodeblock_int(EVP_ENCODE_CTX *ctx, unsigned char *t,
                                const unsigned char *f, int dlen);
 static int evp_decodeblock_int(EVP_ENCODE_CTX *ctx, unsigned char *t,
                                const unsigned char *f, int n);
+static int evp_decode_run(const unsigned char *table, unsigned char *t,
+                          const unsigned char *f, int n);
 
 #ifndef CHARSET_EBCDIC
 # define conv_bin2ascii(a, table)       ((table)[(a)&0x3f])
@@ -328,6 +330,21 @@ int EVP_DecodeUpdate(EVP_ENCODE_CTX *ctx, unsigned char *out, int *outl,
         table = data_ascii2bin;
 
     for (i = 0; i < inl; i++) {
+        /*
+         * At the start of a block, decode whatever plain base64 follows
+         * straight from the input rather than a character at a time.
+         */
+        if (n == 0 && eof == 0 && inl - i >= 4) {
+            int used = evp_decode_run(table, out, in, inl - i);
+
+            in += used;
+            i += used;
+            out += used / 4 * 3;
+            ret += used / 4 * 3;
+            if (i == inl)
+                break;
+        }
+
         tmp = *(in++);
         v = conv_ascii2bin(tmp, table);
         if (v == B64_ERROR) {
@@ -438,7 +455,11 @@ static int evp_decodeblock_int(EVP_ENCODE_CTX *ctx, unsigned char *t,
     if (n % 4 != 0)
         return -1;
 
-    for (i = 0; i < n; i += 4) {
+    i = evp_decode_run(table, t, f, n);
+    ret = i / 4 * 3;
+    f += i;
+    t += ret;
+    for (; i < n; i += 4) {
         a = conv_ascii2bin(*(f++), table);
         b = conv_ascii2bin(*(f++), table);
         c = conv_ascii2bin(*(f++), table);
@@ -456,6 +477,35 @@ static int evp_decodeblock_int(EVP_ENCODE_CTX *ctx, unsigned char *t,
     return ret;
 }
 
+/*
+ * Decode groups of four base64 characters, stopping at the first group
+ * that holds anything else (padding, white space, line ends, the '-' of
+ * a PEM footer, or invalid characters) for the caller to deal with.
+ * Returns the number of characters consumed, a multiple of 4.
+ */
+static int evp_decode_run(const unsigned char *table, unsigned char *t,
+                          const unsigned char *f, int n)
+{
+    int i;
+    unsigned long a, b, c, d, l;
+
+    for (i = 0; i + 4 <= n; i += 4, f += 4, t += 3) {
+        a = conv_ascii2bin(f[0], table);
+        b = conv_ascii2bin(f[1], table);
+        c = conv_ascii2bin(f[2], table);
+        d = conv_ascii2bin(f[3], table);
+        /* '=' is the only other character that looks up as a valid 0 */
+        if (((a | b | c | d) & 0xC0) != 0
+                || f[0] == '=' || f[1] == '=' || f[2] == '=' || f[3] == '=')
+            break;
+        l = (a << 18L) | (b << 12L) | (c << 6L) | d;
+        t[0] = (unsigned char)(l >> 16L);
+        t[1] = (unsigned char)(l >> 8L);
+        t[2] = (unsigned char)l;
+    }
+    return i;
+}
+
 int EVP_DecodeBlock(unsigned char *t, const unsigned char *f, int n)
 {
     return evp_decodeblock_int(NULL, t, f, n);
@@ -91,10 +91,12 @@ int EVP_CipherInit_ex(EVP_CIPHER_CTX *ctx, const EVP_CIPHER *cipher,
 #endif
                 || ctx->cipher_data) {
             unsigned long flags = ctx->flags;
+            int num_threads = ctx->num_threads;
             EVP_CIPHER_CTX_reset(ctx);
-            /* Restore encrypt and flags */
+            /* Restore encrypt, flags and thread count */
             ctx->encrypt = enc;
             ctx->flags = flags;
+            ctx->num_threads = num_threads;
         }
 #ifndef OPENSSL_NO_ENGINE
         if (impl) {
@@ -684,6 +686,8 @@ int EVP_CIPHER_CTX_rand_key(EVP_CIPHER_CTX *ctx, unsigned char *key)
 
 int EVP_CIPHER_CTX_copy(EVP_CIPHER_CTX *out, const EVP_CIPHER_CTX *in)
 {
+    void *tmp_buf = NULL;
+
     if ((in == NULL) || (in->cipher == NULL)) {
         EVPerr(EVP_F_EVP_CIPHER_CTX_COPY, EVP_R_INPUT_NOT_INITIALIZED);
         return 0;
@@ -696,11 +700,30 @@ int EVP_CIPHER_CTX_copy(EVP_CIPHER_CTX *out, const EVP_CIPHER_CTX *in)
     }
 #endif
 
-    EVP_CIPHER_CTX_reset(out);
+    /*
+     * If |out| already holds the same cipher keep its cipher data, so that
+     * cloning a keyed template into a working context costs a cleanup and
+     * two memcpy()s instead of an allocation and a key schedule.
+     */
+    if (out->cipher == in->cipher && out->cipher_data != NULL
+            && in->cipher_data != NULL && in->cipher->ctx_size
+#ifndef OPENSSL_NO_ENGINE
+            && out->engine == NULL && in->engine == NULL
+#endif
+            ) {
+        if (out->cipher->cleanup != NULL)
+            out->cipher->cleanup(out);
+        tmp_buf = out->cipher_data;
+    } else {
+        EVP_CIPHER_CTX_reset(out);
+    }
     memcpy(out, in, sizeof(*out));
 
     if (in->cipher_data && in->cipher->ctx_size) {
-        out->cipher_data = OPENSSL_malloc(in->cipher->ctx_size);
+        if (tmp_buf != NULL)
+            out->cipher_data = tmp_buf;
+        else
+            out->cipher_data = OPENSSL_malloc(in->cipher->ctx_size);
         if (out->cipher_data == NULL) {
             out->cipher = NULL;
             EVPerr(EVP_F_EVP_CIPHER_CTX_COPY, ERR_R_MALLOC_FAILURE);
@@ -47,11 +47,14 @@ static const ERR_STRING_DATA EVP_str_functs[] = {
      "EVP_CIPHER_CTX_ctrl"},
     {ERR_PACK(ERR_LIB_EVP, EVP_F_EVP_CIPHER_CTX_SET_KEY_LENGTH, 0),
      "EVP_CIPHER_CTX_set_key_length"},
+    {ERR_PACK(ERR_LIB_EVP, EVP_F_EVP_CIPHER_CTX_SET_NUM_THREADS, 0),
+     "EVP_CIPHER_CTX_set_num_threads"},
     {ERR_PACK(ERR_LIB_EVP, EVP_F_EVP_CIPHER_PARAM_TO_ASN1, 0),
      "EVP_CIPHER_param_to_asn1"},
     {ERR_PACK(ERR_LIB_EVP, EVP_F_EVP_DECRYPTFINAL_EX, 0),
      "EVP_DecryptFinal_ex"},
     {ERR_PACK(ERR_LIB_EVP, EVP_F_EVP_DECRYPTUPDATE, 0), "EVP_DecryptUpdate"},
+    {ERR_PACK(ERR_LIB_EVP, EVP_F_EVP_DIGESTBATCH, 0), "EVP_DigestBatch"},
     {ERR_PACK(ERR_LIB_EVP, EVP_F_EVP_DIGESTFINALXOF, 0), "EVP_DigestFinalXOF"},
     {ERR_PACK(ERR_LIB_EVP, EVP_F_EVP_DIGESTINIT_EX, 0), "EVP_DigestInit_ex"},
     {ERR_PACK(ERR_LIB_EVP, EVP_F_EVP_ENCRYPTDECRYPTUPDATE, 0),
@@ -78,6 +81,10 @@ static const ERR_STRING_DATA EVP_str_functs[] = {
      "EVP_PKEY_CTX_ctrl_str"},
     {ERR_PACK(ERR_LIB_EVP, EVP_F_EVP_PKEY_CTX_DUP, 0), "EVP_PKEY_CTX_dup"},
     {ERR_PACK(ERR_LIB_EVP, EVP_F_EVP_PKEY_CTX_MD, 0), "EVP_PKEY_CTX_md"},
+    {ERR_PACK(ERR_LIB_EVP, EVP_F_EVP_PKEY_DECAPSULATE, 0),
+     "EVP_PKEY_decapsulate"},
+    {ERR_PACK(ERR_LIB_EVP, EVP_F_EVP_PKEY_DECAPSULATE_INIT, 0),
+     "EVP_PKEY_decapsulate_init"},
     {ERR_PACK(ERR_LIB_EVP, EVP_F_EVP_PKEY_DECRYPT, 0), "EVP_PKEY_decrypt"},
     {ERR_PACK(ERR_LIB_EVP, EVP_F_EVP_PKEY_DECRYPT_INIT, 0),
      "EVP_PKEY_decrypt_init"},
@@ -88,6 +95,12 @@ static const ERR_STRING_DATA EVP_str_functs[] = {
      "EVP_PKEY_derive_init"},
     {ERR_PACK(ERR_LIB_EVP, EVP_F_EVP_PKEY_DERIVE_SET_PEER, 0),
      "EVP_PKEY_derive_set_peer"},
+    {ERR_PACK(ERR_LIB_EVP, EVP_F_EVP_PKEY_ENCAPSULATE, 0),
+     "EVP_PKEY_encapsulate"},
+    {ERR_PACK(ERR_LIB_EVP, EVP_F_EVP_PKEY_ENCAPSULATE_BATCH, 0),
+     "EVP_PKEY_encapsulate_batch"},
+    {ERR_PACK(ERR_LIB_EVP, EVP_F_EVP_PKEY_ENCAPSULATE_INIT, 0),
+     "EVP_PKEY_encapsulate_init"},
     {ERR_PACK(ERR_LIB_EVP, EVP_F_EVP_PKEY_ENCRYPT, 0), "EVP_PKEY_encrypt"},
     {ERR_PACK(ERR_LIB_EVP, EVP_F_EVP_PKEY_ENCRYPT_INIT, 0),
      "EVP_PKEY_encrypt_init"},
@@ -345,8 +345,16 @@ EVP_MD *EVP_MD_meth_dup(const EVP_MD *md)
 {
     EVP_MD *to = EVP_MD_meth_new(md->type, md->pkey_type);
 
-    if (to != NULL)
+    if (to != NULL) {
         memcpy(to, md, sizeof(*to));
+        /*
+         * The shortcuts bypass the methods, which the copy is likely to
+         * have replaced
+         */
+        to->batch = NULL;
+        to->pbkdf2_hmac = NULL;
+        to->iterate = NULL;
+    }
     return to;
 }
 void EVP_MD_meth_free(EVP_MD *md)
@@ -39,8 +39,17 @@ struct evp_cipher_ctx_st {
     int final_used;
     int block_mask;
     unsigned char final[EVP_MAX_BLOCK_LENGTH]; /* possible final block */
+    int num_threads;            /* threads a large update may use */
 } /* EVP_CIPHER_CTX */ ;
 
+#if defined(OPENSSL_THREADS) && !defined(OPENSSL_SYS_WINDOWS)
+# define EVP_PARALLEL_THREADS
+#endif
+
+int evp_cipher_parallel_pieces(const EVP_CIPHER_CTX *ctx, size_t len);
+void evp_cipher_parallel(int pieces, size_t len, evp_parallel_fn fn,
+                         void *arg);
+
 int PKCS5_v2_PBKDF2_keyivgen(EVP_CIPHER_CTX *ctx, const char *pass,
                              int passlen, ASN1_TYPE *param,
                              const EVP_CIPHER *c, const EVP_MD *md,
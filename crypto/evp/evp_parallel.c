@@ -0,0 +1,136 @@
+/*
+ * Copyright 2024 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Splitting of large cipher updates across threads, for the modes whose
+ * state at any block offset can be computed directly (CTR and XTS), and of
+ * other independent pieces of work such as the lanes of scrypt and the
+ * halves of an OQS hybrid signature verification.
+ */
+
+#include "internal/cryptlib.h"
+#include <openssl/evp.h>
+#include <openssl/err.h>
+#include "crypto/evp.h"
+#include "evp_local.h"
+
+#ifdef EVP_PARALLEL_THREADS
+# include <pthread.h>
+#endif
+
+/* Smallest piece worth a thread of its own */
+#define EVP_PARALLEL_MIN_PIECE  (1024 * 1024)
+/* Pieces start on a cipher block boundary */
+#define EVP_PARALLEL_ALIGN      16
+
+int EVP_CIPHER_CTX_set_num_threads(EVP_CIPHER_CTX *ctx, int num_threads)
+{
+    if (num_threads < 1 || num_threads > EVP_CIPHER_MAX_THREADS) {
+        EVPerr(EVP_F_EVP_CIPHER_CTX_SET_NUM_THREADS,
+               ERR_R_PASSED_INVALID_ARGUMENT);
+        return 0;
+    }
+#ifndef EVP_PARALLEL_THREADS
+    if (num_threads > 1) {
+        EVPerr(EVP_F_EVP_CIPHER_CTX_SET_NUM_THREADS, ERR_R_DISABLED);
+        return 0;
+    }
+#endif
+    ctx->num_threads = num_threads;
+    return 1;
+}
+
+int EVP_CIPHER_CTX_num_threads(const EVP_CIPHER_CTX *ctx)
+{
+    return ctx->num_threads > 1 ? ctx->num_threads : 1;
+}
+
+int evp_cipher_parallel_pieces(const EVP_CIPHER_CTX *ctx, size_t len)
+{
+    size_t pieces = len / EVP_PARALLEL_MIN_PIECE;
+
+    if (ctx->num_threads <= 1 || pieces <= 1)
+        return 1;
+    return pieces < (size_t)ctx->num_threads ? (int)pieces : ctx->num_threads;
+}
+
+#ifdef EVP_PARALLEL_THREADS
+
+typedef struct {
+    evp_parallel_fn fn;
+    void *arg;
+    size_t off;
+    size_t len;
+} EVP_PARALLEL_PIECE;
+
+static void *evp_parallel_worker(void *arg)
+{
+    EVP_PARALLEL_PIECE *piece = arg;
+
+    piece->fn(piece->arg, piece->off, piece->len);
+    return NULL;
+}
+
+#endif
+
+/*
+ * Run |fn| over |pieces| ranges covering |len|, each starting on a multiple
+ * of |align|; the last range also takes the remainder.  The first range
+ * runs on the calling thread.  A piece whose thread cannot be started runs
+ * inline, so the whole of |len| is always processed.
+ */
+static void evp_parallel_split(int pieces, size_t len, size_t align,
+                               evp_parallel_fn fn, void *arg)
+{
+#ifdef EVP_PARALLEL_THREADS
+    EVP_PARALLEL_PIECE piece[EVP_CIPHER_MAX_THREADS];
+    pthread_t tid[EVP_CIPHER_MAX_THREADS];
+    int started[EVP_CIPHER_MAX_THREADS];
+    size_t step;
+    int i;
+
+    if (pieces > 1 && pieces <= EVP_CIPHER_MAX_THREADS) {
+        step = (len / pieces) & ~(align - 1);
+        for (i = 0; i < pieces; i++) {
+            piece[i].fn = fn;
+            piece[i].arg = arg;
+            piece[i].off = step * i;
+            piece[i].len = i == pieces - 1 ? len - step * i : step;
+            started[i] = i > 0 && pthread_create(&tid[i], NULL,
+                                                 evp_parallel_worker,
+                                                 &piece[i]) == 0;
+        }
+        for (i = 0; i < pieces; i++)
+            if (!started[i])
+                fn(arg, piece[i].off, piece[i].len);
+        for (i = 1; i < pieces; i++)
+            if (started[i])
+                pthread_join(tid[i], NULL);
+        return;
+    }
+#endif
+    fn(arg, 0, len);
+}
+
+/* Run |fn| over |pieces| cipher block aligned ranges covering |len| bytes */
+void evp_cipher_parallel(int pieces, size_t len, evp_parallel_fn fn,
+                         void *arg)
+{
+    evp_parallel_split(pieces, len, EVP_PARALLEL_ALIGN, fn, arg);
+}
+
+/*
+ * Run |fn| over |pieces| ranges of |count| items, the first |count / pieces|
+ * items making up the first range, and so on.
+ */
+void evp_parallel_run(int pieces, size_t count, evp_parallel_fn fn,
+                      void *arg)
+{
+    evp_parallel_split(pieces, count, 1, fn, arg);
+}
@@ -103,7 +103,14 @@ static const EVP_MD sha1_md = {
     NULL,
     SHA_CBLOCK,
     sizeof(EVP_MD *) + sizeof(SHA_CTX),
-    ctrl
+    ctrl,
+#ifdef SHA_MULTI_BLOCK
+    sha1_digest_batch,
+#else
+    NULL,
+#endif
+    sha1_pbkdf2_hmac,
+    sha1_iterate
 };
 
 const EVP_MD *EVP_sha1(void)
@@ -153,6 +160,14 @@ static const EVP_MD sha224_md = {
     NULL,
     SHA256_CBLOCK,
     sizeof(EVP_MD *) + sizeof(SHA256_CTX),
+    NULL,
+#ifdef SHA_MULTI_BLOCK
+    sha224_digest_batch,
+#else
+    NULL,
+#endif
+    sha224_pbkdf2_hmac,
+    sha224_iterate
 };
 
 const EVP_MD *EVP_sha224(void)
@@ -172,6 +187,14 @@ static const EVP_MD sha256_md = {
     NULL,
     SHA256_CBLOCK,
     sizeof(EVP_MD *) + sizeof(SHA256_CTX),
+    NULL,
+#ifdef SHA_MULTI_BLOCK
+    sha256_digest_batch,
+#else
+    NULL,
+#endif
+    sha256_pbkdf2_hmac,
+    sha256_iterate
 };
 
 const EVP_MD *EVP_sha256(void)
@@ -270,6 +293,10 @@ static const EVP_MD sha384_md = {
     NULL,
     SHA512_CBLOCK,
     sizeof(EVP_MD *) + sizeof(SHA512_CTX),
+    NULL,
+    NULL,
+    sha384_pbkdf2_hmac,
+    sha384_iterate
 };
 
 const EVP_MD *EVP_sha384(void)
@@ -289,6 +316,10 @@ static const EVP_MD sha512_md = {
     NULL,
     SHA512_CBLOCK,
     sizeof(EVP_MD *) + sizeof(SHA512_CTX),
+    NULL,
+    NULL,
+    sha512_pbkdf2_hmac,
+    sha512_iterate
 };
 
 const EVP_MD *EVP_sha512(void)
@@ -163,8 +163,21 @@ int EVP_DigestSignFinal(EVP_MD_CTX *ctx, unsigned char *sigret,
 int EVP_DigestSign(EVP_MD_CTX *ctx, unsigned char *sigret, size_t *siglen,
                    const unsigned char *tbs, size_t tbslen)
 {
-    if (ctx->pctx->pmeth->digestsign != NULL)
+    if (ctx->pctx->pmeth->digestsign != NULL) {
+        if (sigret != NULL && ctx->pctx->worker_pool != NULL) {
+            EVP_PKEY_OFFLOAD off = { EVP_PKEY_OP_SIGNCTX, NULL, NULL, NULL,
+                                     NULL, NULL, NULL, NULL, 0, NULL, 0 };
+
+            off.ctx = ctx->pctx;
+            off.mctx = ctx;
+            off.out = sigret;
+            off.outlen = siglen;
+            off.in = tbs;
+            off.inlen = tbslen;
+            return evp_pkey_offload(&off);
+        }
         return ctx->pctx->pmeth->digestsign(ctx, sigret, siglen, tbs, tbslen);
+    }
     if (sigret != NULL && EVP_DigestSignUpdate(ctx, tbs, tbslen) <= 0)
         return 0;
     return EVP_DigestSignFinal(ctx, sigret, siglen);
@@ -210,8 +223,21 @@ int EVP_DigestVerifyFinal(EVP_MD_CTX *ctx, const unsigned char *sig,
 int EVP_DigestVerify(EVP_MD_CTX *ctx, const unsigned char *sigret,
                      size_t siglen, const unsigned char *tbs, size_t tbslen)
 {
-    if (ctx->pctx->pmeth->digestverify != NULL)
+    if (ctx->pctx->pmeth->digestverify != NULL) {
+        if (ctx->pctx->worker_pool != NULL) {
+            EVP_PKEY_OFFLOAD off = { EVP_PKEY_OP_VERIFYCTX, NULL, NULL, NULL,
+                                     NULL, NULL, NULL, NULL, 0, NULL, 0 };
+
+            off.ctx = ctx->pctx;
+            off.mctx = ctx;
+            off.in = sigret;
+            off.inlen = siglen;
+            off.in2 = tbs;
+            off.in2len = tbslen;
+            return evp_pkey_offload(&off);
+        }
         return ctx->pctx->pmeth->digestverify(ctx, sigret, siglen, tbs, tbslen);
+    }
     if (EVP_DigestVerifyUpdate(ctx, tbs, tbslen) <= 0)
         return -1;
     return EVP_DigestVerifyFinal(ctx, sigret, siglen);
@@ -55,10 +55,19 @@ int EVP_add_digest(const EVP_MD *md)
     return r;
 }
 
+/*
+ * The name tables are only filled in with every built in algorithm when a
+ * lookup misses, so that a library that registered what it needs itself
+ * (libssl does) never pays for the rest.
+ */
 const EVP_CIPHER *EVP_get_cipherbyname(const char *name)
 {
     const EVP_CIPHER *cp;
 
+    cp = (const EVP_CIPHER *)OBJ_NAME_get(name, OBJ_NAME_TYPE_CIPHER_METH);
+    if (cp != NULL)
+        return cp;
+
     if (!OPENSSL_init_crypto(OPENSSL_INIT_ADD_ALL_CIPHERS, NULL))
         return NULL;
 
@@ -70,6 +79,10 @@ const EVP_MD *EVP_get_digestbyname(const char *name)
 {
     const EVP_MD *cp;
 
+    cp = (const EVP_MD *)OBJ_NAME_get(name, OBJ_NAME_TYPE_MD_METH);
+    if (cp != NULL)
+        return cp;
+
     if (!OPENSSL_init_crypto(OPENSSL_INIT_ADD_ALL_DIGESTS, NULL))
         return NULL;
 
@@ -13,6 +13,8 @@
 # include <openssl/x509.h>
 # include <openssl/evp.h>
 # include <openssl/hmac.h>
+# include <openssl/engine.h>
+# include "crypto/evp.h"
 # include "evp_local.h"
 
 /* set this to print out info about the keygen algorithm */
@@ -28,31 +30,21 @@ static void h__dump(const unsigned char *p, int len);
  * posted by Peter Gutmann to the PKCS-TNG mailing list.
  */
 
-int PKCS5_PBKDF2_HMAC(const char *pass, int passlen,
-                      const unsigned char *salt, int saltlen, int iter,
-                      const EVP_MD *digest, int keylen, unsigned char *out)
+static int pbkdf2_hmac_blocks(const char *pass, int passlen,
+                              const unsigned char *salt, int saltlen,
+                              int iter, const EVP_MD *digest, int mdlen,
+                              int keylen, unsigned char *out)
 {
-    const char *empty = "";
     unsigned char digtmp[EVP_MAX_MD_SIZE], *p, itmp[4];
-    int cplen, j, k, tkeylen, mdlen;
+    int cplen, j, k, tkeylen;
     unsigned long i = 1;
     HMAC_CTX *hctx_tpl = NULL, *hctx = NULL;
 
-    mdlen = EVP_MD_size(digest);
-    if (mdlen < 0)
-        return 0;
-
     hctx_tpl = HMAC_CTX_new();
     if (hctx_tpl == NULL)
         return 0;
     p = out;
     tkeylen = keylen;
-    if (pass == NULL) {
-        pass = empty;
-        passlen = 0;
-    } else if (passlen == -1) {
-        passlen = strlen(pass);
-    }
     if (!HMAC_Init_ex(hctx_tpl, pass, passlen, digest, NULL)) {
         HMAC_CTX_free(hctx_tpl);
         return 0;
@@ -109,6 +101,52 @@ int PKCS5_PBKDF2_HMAC(const char *pass, int passlen,
     }
     HMAC_CTX_free(hctx);
     HMAC_CTX_free(hctx_tpl);
+    return 1;
+}
+
+/* Whether HMAC would get |digest| from an ENGINE rather than use it */
+static int pbkdf2_engine_digest(const EVP_MD *digest)
+{
+# ifndef OPENSSL_NO_ENGINE
+    ENGINE *e = ENGINE_get_digest_engine(EVP_MD_type(digest));
+
+    if (e != NULL) {
+        ENGINE_finish(e);
+        return 1;
+    }
+# endif
+    return 0;
+}
+
+int PKCS5_PBKDF2_HMAC(const char *pass, int passlen,
+                      const unsigned char *salt, int saltlen, int iter,
+                      const EVP_MD *digest, int keylen, unsigned char *out)
+{
+    const char *empty = "";
+    int mdlen, ret;
+
+    mdlen = EVP_MD_size(digest);
+    if (mdlen < 0)
+        return 0;
+
+    if (pass == NULL) {
+        pass = empty;
+        passlen = 0;
+    } else if (passlen == -1) {
+        passlen = strlen(pass);
+    }
+    if (digest->pbkdf2_hmac != NULL && passlen >= 0 && saltlen >= 0
+            && keylen > 0 && !pbkdf2_engine_digest(digest)) {
+        /* built-in digest, iterate on its compression function directly */
+        ret = digest->pbkdf2_hmac((const unsigned char *)pass, passlen,
+                                  salt, saltlen, iter > 1 ? iter : 1,
+                                  out, keylen);
+    } else {
+        ret = pbkdf2_hmac_blocks(pass, passlen, salt, saltlen, iter, digest,
+                                 mdlen, keylen, out);
+    }
+    if (!ret)
+        return 0;
 # ifdef OPENSSL_DEBUG_PKCS5V2
     fprintf(stderr, "Password:\n");
     h__dump(pass, passlen);
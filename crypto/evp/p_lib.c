@@ -170,6 +170,12 @@ int EVP_PKEY_up_ref(EVP_PKEY *pkey)
     return ((i > 1) ? 1 : 0);
 }
 
+int EVP_PKEY_freeze(EVP_PKEY *pkey)
+{
+    CRYPTO_REF_FREEZE(&pkey->references);
+    return 1;
+}
+
 /*
  * Setup a public key ASN1 method and ENGINE from a NID or a string. If pkey
  * is NULL just return 1 or 0 if the algorithm exists.
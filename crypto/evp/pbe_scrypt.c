@@ -13,6 +13,8 @@
 #include <openssl/evp.h>
 #include <openssl/err.h>
 #include "internal/numbers.h"
+#include "crypto/evp.h"
+#include "evp_local.h"
 
 #ifndef OPENSSL_NO_SCRYPT
 
@@ -115,6 +117,30 @@ static void scryptROMix(unsigned char *B, uint64_t r, uint64_t N,
     }
 }
 
+/* The lanes of scrypt, shared out between threads by evp_parallel_run() */
+typedef struct {
+    unsigned char *B;
+    uint32_t *XTV;              /* X, T and V of the first thread */
+    uint64_t r;
+    uint64_t N;
+    size_t lanes_per_thread;    /* lanes in each range but the last */
+    size_t words_per_thread;    /* size of X, T and V together */
+} SCRYPT_LANES;
+
+static void scrypt_lanes(void *arg, size_t off, size_t len)
+{
+    SCRYPT_LANES *l = arg;
+    uint32_t *X, *T, *V;
+    size_t i;
+
+    /* Each range of lanes has its own X, T and V, found from its offset */
+    X = l->XTV + l->words_per_thread * (off / l->lanes_per_thread);
+    T = X + 32 * l->r;
+    V = T + 32 * l->r;
+    for (i = off; i < off + len; i++)
+        scryptROMix(l->B + 128 * l->r * i, l->r, l->N, X, T, V);
+}
+
 #ifndef SIZE_MAX
 # define SIZE_MAX    ((size_t)-1)
 #endif
@@ -159,16 +185,30 @@ int EVP_PBE_scrypt(const char *pass, size_t passlen,
                    const unsigned char *salt, size_t saltlen,
                    uint64_t N, uint64_t r, uint64_t p, uint64_t maxmem,
                    unsigned char *key, size_t keylen)
+{
+    return EVP_PBE_scrypt_threads(pass, passlen, salt, saltlen, N, r, p,
+                                  maxmem, key, keylen, 1);
+}
+
+int EVP_PBE_scrypt_threads(const char *pass, size_t passlen,
+                           const unsigned char *salt, size_t saltlen,
+                           uint64_t N, uint64_t r, uint64_t p,
+                           uint64_t maxmem, unsigned char *key,
+                           size_t keylen, int num_threads)
 {
     int rv = 0;
     unsigned char *B;
-    uint32_t *X, *V, *T;
-    uint64_t i, Blen, Vlen;
+    SCRYPT_LANES lanes;
+    uint64_t i, Blen, Vlen, threads;
 
     /* Sanity check parameters */
     /* initial check, r,p must be non zero, N >= 2 and a power of 2 */
     if (r == 0 || p == 0 || N < 2 || (N & (N - 1)))
         return 0;
+    if (num_threads < 1 || num_threads > EVP_PBE_SCRYPT_MAX_THREADS) {
+        EVPerr(EVP_F_EVP_PBE_SCRYPT, ERR_R_PASSED_INVALID_ARGUMENT);
+        return 0;
+    }
     /* Check p * r < SCRYPT_PR_MAX avoiding overflow */
     if (p > SCRYPT_PR_MAX / r) {
         EVPerr(EVP_F_EVP_PBE_SCRYPT, EVP_R_MEMORY_LIMIT_EXCEEDED);
@@ -237,20 +277,36 @@ int EVP_PBE_scrypt(const char *pass, size_t passlen,
     if (key == NULL)
         return 1;
 
-    B = OPENSSL_malloc((size_t)(Blen + Vlen));
+    /*
+     * Each thread needs its own V, X and T: run as many threads as the lanes
+     * and the memory limit allow.
+     */
+#ifdef EVP_PARALLEL_THREADS
+    threads = num_threads;
+#else
+    threads = 1;
+#endif
+    if (threads > p)
+        threads = p;
+    if (threads > (maxmem - Blen) / Vlen)
+        threads = (maxmem - Blen) / Vlen;
+
+    B = OPENSSL_malloc((size_t)(Blen + threads * Vlen));
     if (B == NULL) {
         EVPerr(EVP_F_EVP_PBE_SCRYPT, ERR_R_MALLOC_FAILURE);
         return 0;
     }
-    X = (uint32_t *)(B + Blen);
-    T = X + 32 * r;
-    V = T + 32 * r;
     if (PKCS5_PBKDF2_HMAC(pass, passlen, salt, saltlen, 1, EVP_sha256(),
                           (int)Blen, B) == 0)
         goto err;
 
-    for (i = 0; i < p; i++)
-        scryptROMix(B + 128 * r * i, r, N, X, T, V);
+    lanes.B = B;
+    lanes.XTV = (uint32_t *)(B + Blen);
+    lanes.r = r;
+    lanes.N = N;
+    lanes.lanes_per_thread = (size_t)(p / threads);
+    lanes.words_per_thread = (size_t)(Vlen / sizeof(uint32_t));
+    evp_parallel_run((int)threads, (size_t)p, scrypt_lanes, &lanes);
 
     if (PKCS5_PBKDF2_HMAC(pass, passlen, B, (int)Blen, 1, EVP_sha256(),
                           keylen, key) == 0)
@@ -260,7 +316,7 @@ int EVP_PBE_scrypt(const char *pass, size_t passlen,
     if (rv == 0)
         EVPerr(EVP_F_EVP_PBE_SCRYPT, EVP_R_PBKDF2_ERROR);
 
-    OPENSSL_clear_free(B, (size_t)(Blen + Vlen));
+    OPENSSL_clear_free(B, (size_t)(Blen + threads * Vlen));
     return rv;
 }
 #endif
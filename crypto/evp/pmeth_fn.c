@@ -12,6 +12,7 @@
 #include "internal/cryptlib.h"
 #include <openssl/objects.h>
 #include <openssl/evp.h>
+#include <openssl/async.h>
 #include "crypto/evp.h"
 
 #define M_check_autoarg(ctx, arg, arglen, err) \
@@ -32,6 +33,48 @@
         }                                                         \
     }
 
+static int pkey_offload_run(void *arg)
+{
+    EVP_PKEY_OFFLOAD *off = arg;
+    EVP_PKEY_CTX *ctx = off->ctx;
+
+    switch (off->op) {
+    case EVP_PKEY_OP_SIGN:
+        return ctx->pmeth->sign(ctx, off->out, off->outlen,
+                                off->in, off->inlen);
+    case EVP_PKEY_OP_VERIFY:
+        return ctx->pmeth->verify(ctx, off->in, off->inlen,
+                                  off->in2, off->in2len);
+    case EVP_PKEY_OP_DERIVE:
+        return ctx->pmeth->derive(ctx, off->out, off->outlen);
+    case EVP_PKEY_OP_ENCAPSULATE:
+        return ctx->pmeth->encapsulate(ctx, off->out, off->outlen,
+                                       off->out2, off->out2len);
+    case EVP_PKEY_OP_DECAPSULATE:
+        return ctx->pmeth->decapsulate(ctx, off->out, off->outlen,
+                                       off->in, off->inlen);
+    case EVP_PKEY_OP_SIGNCTX:
+        return ctx->pmeth->digestsign(off->mctx, off->out, off->outlen,
+                                      off->in, off->inlen);
+    case EVP_PKEY_OP_VERIFYCTX:
+        return ctx->pmeth->digestverify(off->mctx, off->in, off->inlen,
+                                        off->in2, off->in2len);
+    }
+    return -2;
+}
+
+/*
+ * Runs |off| on the worker pool attached to its context, or on the calling
+ * thread if there is none. Errors raised by the worker end up on the
+ * caller's error queue.
+ */
+int evp_pkey_offload(EVP_PKEY_OFFLOAD *off)
+{
+    if (off->ctx->worker_pool == NULL)
+        return pkey_offload_run(off);
+    return OSSL_WORKER_POOL_run(off->ctx->worker_pool, pkey_offload_run, off);
+}
+
 int EVP_PKEY_sign_init(EVP_PKEY_CTX *ctx)
 {
     int ret;
@@ -63,7 +106,18 @@ int EVP_PKEY_sign(EVP_PKEY_CTX *ctx,
         return -1;
     }
     M_check_autoarg(ctx, sig, siglen, EVP_F_EVP_PKEY_SIGN)
-        return ctx->pmeth->sign(ctx, sig, siglen, tbs, tbslen);
+    if (sig != NULL && ctx->worker_pool != NULL) {
+        EVP_PKEY_OFFLOAD off = { EVP_PKEY_OP_SIGN, NULL, NULL, NULL, NULL,
+                                 NULL, NULL, NULL, 0, NULL, 0 };
+
+        off.ctx = ctx;
+        off.out = sig;
+        off.outlen = siglen;
+        off.in = tbs;
+        off.inlen = tbslen;
+        return evp_pkey_offload(&off);
+    }
+    return ctx->pmeth->sign(ctx, sig, siglen, tbs, tbslen);
 }
 
 int EVP_PKEY_verify_init(EVP_PKEY_CTX *ctx)
@@ -96,6 +150,17 @@ int EVP_PKEY_verify(EVP_PKEY_CTX *ctx,
         EVPerr(EVP_F_EVP_PKEY_VERIFY, EVP_R_OPERATON_NOT_INITIALIZED);
         return -1;
     }
+    if (ctx->worker_pool != NULL) {
+        EVP_PKEY_OFFLOAD off = { EVP_PKEY_OP_VERIFY, NULL, NULL, NULL, NULL,
+                                 NULL, NULL, NULL, 0, NULL, 0 };
+
+        off.ctx = ctx;
+        off.in = sig;
+        off.inlen = siglen;
+        off.in2 = tbs;
+        off.in2len = tbslen;
+        return evp_pkey_offload(&off);
+    }
     return ctx->pmeth->verify(ctx, sig, siglen, tbs, tbslen);
 }
 
@@ -293,5 +358,224 @@ int EVP_PKEY_derive(EVP_PKEY_CTX *ctx, unsigned char *key, size_t *pkeylen)
         return -1;
     }
     M_check_autoarg(ctx, key, pkeylen, EVP_F_EVP_PKEY_DERIVE)
-        return ctx->pmeth->derive(ctx, key, pkeylen);
+    if (key != NULL && ctx->worker_pool != NULL) {
+        EVP_PKEY_OFFLOAD off = { EVP_PKEY_OP_DERIVE, NULL, NULL, NULL, NULL,
+                                 NULL, NULL, NULL, 0, NULL, 0 };
+
+        off.ctx = ctx;
+        off.out = key;
+        off.outlen = pkeylen;
+        return evp_pkey_offload(&off);
+    }
+    return ctx->pmeth->derive(ctx, key, pkeylen);
+}
+
+int EVP_PKEY_encapsulate_init(EVP_PKEY_CTX *ctx)
+{
+    int ret;
+    if (!ctx || !ctx->pmeth || !ctx->pmeth->encapsulate) {
+        EVPerr(EVP_F_EVP_PKEY_ENCAPSULATE_INIT,
+               EVP_R_OPERATION_NOT_SUPPORTED_FOR_THIS_KEYTYPE);
+        return -2;
+    }
+    if (ctx->pkey == NULL) {
+        EVPerr(EVP_F_EVP_PKEY_ENCAPSULATE_INIT, EVP_R_NO_KEY_SET);
+        return -1;
+    }
+    ctx->operation = EVP_PKEY_OP_ENCAPSULATE;
+    if (!ctx->pmeth->encapsulate_init)
+        return 1;
+    ret = ctx->pmeth->encapsulate_init(ctx);
+    if (ret <= 0)
+        ctx->operation = EVP_PKEY_OP_UNDEFINED;
+    return ret;
+}
+
+/*
+ * Runs encapsulations that a batch queue collected for the same method, in
+ * one go if the method has a batched implementation.
+ */
+static void pkey_encapsulate_batch_run(void *ops[], int results[],
+                                       size_t num)
+{
+    EVP_PKEY_OFFLOAD *off = ops[0];
+    const EVP_PKEY_METHOD *pmeth = off->ctx->pmeth;
+    EVP_PKEY_CTX **ctx = NULL;
+    unsigned char *ct = NULL, *secret = NULL;
+    size_t i, clen = 0, slen = 0;
+    int done = 0;
+
+    ERR_set_mark();
+    if (num > 1 && pmeth->encapsulate_batch != NULL
+            && pmeth->encapsulate(off->ctx, NULL, &clen, NULL, &slen) > 0
+            && (ctx = OPENSSL_malloc(num * sizeof(*ctx))) != NULL
+            && (ct = OPENSSL_malloc(num * clen)) != NULL
+            && (secret = OPENSSL_secure_malloc(num * slen)) != NULL) {
+        for (i = 0; i < num; i++) {
+            off = ops[i];
+            ctx[i] = off->ctx;
+            if (*off->outlen < clen || *off->out2len < slen)
+                break;
+        }
+        if (i == num
+                && pmeth->encapsulate_batch(ctx, num, ct, &clen,
+                                            secret, &slen) > 0) {
+            for (i = 0; i < num; i++) {
+                off = ops[i];
+                memcpy(off->out, ct + i * clen, clen);
+                memcpy(off->out2, secret + i * slen, slen);
+                *off->outlen = clen;
+                *off->out2len = slen;
+                results[i] = 1;
+            }
+            done = 1;
+        }
+    }
+    OPENSSL_free(ctx);
+    OPENSSL_free(ct);
+    OPENSSL_secure_clear_free(secret, num * slen);
+    if (done) {
+        ERR_clear_last_mark();
+        return;
+    }
+    ERR_pop_to_mark();
+
+    for (i = 0; i < num; i++) {
+        off = ops[i];
+        results[i] = pmeth->encapsulate(off->ctx, off->out, off->outlen,
+                                        off->out2, off->out2len);
+    }
+}
+
+int EVP_PKEY_encapsulate(EVP_PKEY_CTX *ctx,
+                         unsigned char *ct, size_t *ctlen,
+                         unsigned char *secret, size_t *secretlen)
+{
+    if (!ctx || !ctx->pmeth || !ctx->pmeth->encapsulate) {
+        EVPerr(EVP_F_EVP_PKEY_ENCAPSULATE,
+               EVP_R_OPERATION_NOT_SUPPORTED_FOR_THIS_KEYTYPE);
+        return -2;
+    }
+    if (ctx->operation != EVP_PKEY_OP_ENCAPSULATE) {
+        EVPerr(EVP_F_EVP_PKEY_ENCAPSULATE, EVP_R_OPERATON_NOT_INITIALIZED);
+        return -1;
+    }
+    if (ct != NULL && secret != NULL
+            && (ctx->worker_pool != NULL || ctx->batch_queue != NULL)) {
+        EVP_PKEY_OFFLOAD off = { EVP_PKEY_OP_ENCAPSULATE, NULL, NULL, NULL,
+                                 NULL, NULL, NULL, NULL, 0, NULL, 0 };
+
+        off.ctx = ctx;
+        off.out = ct;
+        off.outlen = ctlen;
+        off.out2 = secret;
+        off.out2len = secretlen;
+        if (ctx->batch_queue != NULL)
+            return OSSL_BATCH_QUEUE_submit(ctx->batch_queue,
+                                           pkey_encapsulate_batch_run,
+                                           ctx->pmeth, &off);
+        return evp_pkey_offload(&off);
+    }
+    return ctx->pmeth->encapsulate(ctx, ct, ctlen, secret, secretlen);
+}
+
+/*
+ * Encapsulates to the keys of |num| contexts of the same key type, writing
+ * the ciphertexts |*ctlen| bytes apart in |ct| and the shared secrets
+ * |*secretlen| bytes apart in |secret|. Methods without a batched
+ * implementation encapsulate one context at a time.
+ */
+int EVP_PKEY_encapsulate_batch(EVP_PKEY_CTX *ctx[], size_t num,
+                               unsigned char *ct, size_t *ctlen,
+                               unsigned char *secret, size_t *secretlen)
+{
+    const EVP_PKEY_METHOD *pmeth;
+    size_t i, clen = 0, slen = 0;
+
+    if (num == 0 || ctx == NULL || ctx[0] == NULL)
+        return 0;
+    pmeth = ctx[0]->pmeth;
+    if (!pmeth || !pmeth->encapsulate) {
+        EVPerr(EVP_F_EVP_PKEY_ENCAPSULATE_BATCH,
+               EVP_R_OPERATION_NOT_SUPPORTED_FOR_THIS_KEYTYPE);
+        return -2;
+    }
+    for (i = 0; i < num; i++) {
+        if (ctx[i] == NULL || ctx[i]->pmeth != pmeth) {
+            EVPerr(EVP_F_EVP_PKEY_ENCAPSULATE_BATCH,
+                   EVP_R_DIFFERENT_KEY_TYPES);
+            return -1;
+        }
+        if (ctx[i]->operation != EVP_PKEY_OP_ENCAPSULATE) {
+            EVPerr(EVP_F_EVP_PKEY_ENCAPSULATE_BATCH,
+                   EVP_R_OPERATON_NOT_INITIALIZED);
+            return -1;
+        }
+    }
+    if (ct == NULL || secret == NULL)
+        return pmeth->encapsulate(ctx[0], NULL, ctlen, NULL, secretlen);
+    if (pmeth->encapsulate_batch != NULL)
+        return pmeth->encapsulate_batch(ctx, num, ct, ctlen, secret,
+                                        secretlen);
+
+    for (i = 0; i < num; i++) {
+        clen = *ctlen;
+        slen = *secretlen;
+        if (pmeth->encapsulate(ctx[i], ct + i * *ctlen, &clen,
+                               secret + i * *secretlen, &slen) <= 0) {
+            OPENSSL_cleanse(secret, i * *secretlen);
+            return 0;
+        }
+    }
+    *ctlen = clen;
+    *secretlen = slen;
+    return 1;
+}
+
+int EVP_PKEY_decapsulate_init(EVP_PKEY_CTX *ctx)
+{
+    int ret;
+    if (!ctx || !ctx->pmeth || !ctx->pmeth->decapsulate) {
+        EVPerr(EVP_F_EVP_PKEY_DECAPSULATE_INIT,
+               EVP_R_OPERATION_NOT_SUPPORTED_FOR_THIS_KEYTYPE);
+        return -2;
+    }
+    if (ctx->pkey == NULL) {
+        EVPerr(EVP_F_EVP_PKEY_DECAPSULATE_INIT, EVP_R_NO_KEY_SET);
+        return -1;
+    }
+    ctx->operation = EVP_PKEY_OP_DECAPSULATE;
+    if (!ctx->pmeth->decapsulate_init)
+        return 1;
+    ret = ctx->pmeth->decapsulate_init(ctx);
+    if (ret <= 0)
+        ctx->operation = EVP_PKEY_OP_UNDEFINED;
+    return ret;
+}
+
+int EVP_PKEY_decapsulate(EVP_PKEY_CTX *ctx,
+                         unsigned char *secret, size_t *secretlen,
+                         const unsigned char *ct, size_t ctlen)
+{
+    if (!ctx || !ctx->pmeth || !ctx->pmeth->decapsulate) {
+        EVPerr(EVP_F_EVP_PKEY_DECAPSULATE,
+               EVP_R_OPERATION_NOT_SUPPORTED_FOR_THIS_KEYTYPE);
+        return -2;
+    }
+    if (ctx->operation != EVP_PKEY_OP_DECAPSULATE) {
+        EVPerr(EVP_F_EVP_PKEY_DECAPSULATE, EVP_R_OPERATON_NOT_INITIALIZED);
+        return -1;
+    }
+    if (secret != NULL && ctx->worker_pool != NULL) {
+        EVP_PKEY_OFFLOAD off = { EVP_PKEY_OP_DECAPSULATE, NULL, NULL, NULL,
+                                 NULL, NULL, NULL, NULL, 0, NULL, 0 };
+
+        off.ctx = ctx;
+        off.out = secret;
+        off.outlen = secretlen;
+        off.in = ct;
+        off.inlen = ctlen;
+        return evp_pkey_offload(&off);
+    }
+    return ctx->pmeth->decapsulate(ctx, secret, secretlen, ct, ctlen);
 }
@@ -68,6 +68,38 @@ static const EVP_PKEY_METHOD *standard_methods[] = {
 #ifndef OPENSSL_NO_SM2
     &sm2_pkey_meth,
 #endif
+///// OQS_TEMPLATE_FRAGMENT_LIST_KEM_PKEY_METHS_START
+    &frodo640aes_pkey_meth,
+    &frodo640shake_pkey_meth,
+    &frodo976aes_pkey_meth,
+    &frodo976shake_pkey_meth,
+    &frodo1344aes_pkey_meth,
+    &frodo1344shake_pkey_meth,
+    &kyber512_pkey_meth,
+    &kyber768_pkey_meth,
+    &kyber1024_pkey_meth,
+    &bikel1_pkey_meth,
+    &bikel3_pkey_meth,
+    &bikel5_pkey_meth,
+    &hqc128_pkey_meth,
+    &hqc192_pkey_meth,
+    &hqc256_pkey_meth,
+    &p256_frodo640aes_pkey_meth,
+    &p256_frodo640shake_pkey_meth,
+    &p384_frodo976aes_pkey_meth,
+    &p384_frodo976shake_pkey_meth,
+    &p521_frodo1344aes_pkey_meth,
+    &p521_frodo1344shake_pkey_meth,
+    &p256_kyber512_pkey_meth,
+    &p384_kyber768_pkey_meth,
+    &p521_kyber1024_pkey_meth,
+    &p256_bikel1_pkey_meth,
+    &p384_bikel3_pkey_meth,
+    &p521_bikel5_pkey_meth,
+    &p256_hqc128_pkey_meth,
+    &p384_hqc192_pkey_meth,
+    &p521_hqc256_pkey_meth,
+///// OQS_TEMPLATE_FRAGMENT_LIST_KEM_PKEY_METHS_END
 ///// OQS_TEMPLATE_FRAGMENT_LIST_PKEY_METHS_START
     &dilithium2_pkey_meth,
     &p256_dilithium2_pkey_meth,
@@ -93,6 +125,10 @@ static const EVP_PKEY_METHOD *standard_methods[] = {
     &p256_sphincsshake128fsimple_pkey_meth,
     &rsa3072_sphincsshake128fsimple_pkey_meth,
 ///// OQS_TEMPLATE_FRAGMENT_LIST_PKEY_METHS_END
+#ifndef OPENSSL_NO_BLAKE2
+    &blake2b_mac_pkey_meth,
+    &blake2s_mac_pkey_meth,
+#endif
 };
 
 DECLARE_OBJ_BSEARCH_CMP_FN(const EVP_PKEY_METHOD *, const EVP_PKEY_METHOD *,
@@ -258,6 +294,12 @@ void EVP_PKEY_meth_copy(EVP_PKEY_METHOD *dst, const EVP_PKEY_METHOD *src)
     dst->ctrl_str = src->ctrl_str;
 
     dst->check = src->check;
+
+    dst->encapsulate_init = src->encapsulate_init;
+    dst->encapsulate = src->encapsulate;
+    dst->encapsulate_batch = src->encapsulate_batch;
+    dst->decapsulate_init = src->decapsulate_init;
+    dst->decapsulate = src->decapsulate;
 }
 
 void EVP_PKEY_meth_free(EVP_PKEY_METHOD *pmeth)
@@ -311,6 +353,8 @@ EVP_PKEY_CTX *EVP_PKEY_CTX_dup(EVP_PKEY_CTX *pctx)
 
     rctx->data = NULL;
     rctx->app_data = NULL;
+    rctx->worker_pool = pctx->worker_pool;
+    rctx->batch_queue = pctx->batch_queue;
     rctx->operation = pctx->operation;
 
     if (pctx->pmeth->copy(rctx, pctx) > 0)
@@ -523,6 +567,26 @@ void *EVP_PKEY_CTX_get_app_data(EVP_PKEY_CTX *ctx)
     return ctx->app_data;
 }
 
+void EVP_PKEY_CTX_set0_worker_pool(EVP_PKEY_CTX *ctx, OSSL_WORKER_POOL *pool)
+{
+    ctx->worker_pool = pool;
+}
+
+OSSL_WORKER_POOL *EVP_PKEY_CTX_get0_worker_pool(EVP_PKEY_CTX *ctx)
+{
+    return ctx->worker_pool;
+}
+
+void EVP_PKEY_CTX_set0_batch_queue(EVP_PKEY_CTX *ctx, OSSL_BATCH_QUEUE *queue)
+{
+    ctx->batch_queue = queue;
+}
+
+OSSL_BATCH_QUEUE *EVP_PKEY_CTX_get0_batch_queue(EVP_PKEY_CTX *ctx)
+{
+    return ctx->batch_queue;
+}
+
 void EVP_PKEY_meth_set_init(EVP_PKEY_METHOD *pmeth,
                             int (*init) (EVP_PKEY_CTX *ctx))
 {
@@ -708,6 +772,41 @@ void EVP_PKEY_meth_set_digest_custom(EVP_PKEY_METHOD *pmeth,
     pmeth->digest_custom = digest_custom;
 }
 
+void EVP_PKEY_meth_set_encapsulate(EVP_PKEY_METHOD *pmeth,
+                                   int (*encapsulate_init) (EVP_PKEY_CTX *ctx),
+                                   int (*encapsulate) (EVP_PKEY_CTX *ctx,
+                                                       unsigned char *ct,
+                                                       size_t *ctlen,
+                                                       unsigned char *secret,
+                                                       size_t *secretlen))
+{
+    pmeth->encapsulate_init = encapsulate_init;
+    pmeth->encapsulate = encapsulate;
+}
+
+void EVP_PKEY_meth_set_encapsulate_batch(EVP_PKEY_METHOD *pmeth,
+                                         int (*encapsulate_batch)
+                                             (EVP_PKEY_CTX *ctx[], size_t num,
+                                              unsigned char *ct,
+                                              size_t *ctlen,
+                                              unsigned char *secret,
+                                              size_t *secretlen))
+{
+    pmeth->encapsulate_batch = encapsulate_batch;
+}
+
+void EVP_PKEY_meth_set_decapsulate(EVP_PKEY_METHOD *pmeth,
+                                   int (*decapsulate_init) (EVP_PKEY_CTX *ctx),
+                                   int (*decapsulate) (EVP_PKEY_CTX *ctx,
+                                                       unsigned char *secret,
+                                                       size_t *secretlen,
+                                                       const unsigned char *ct,
+                                                       size_t ctlen))
+{
+    pmeth->decapsulate_init = decapsulate_init;
+    pmeth->decapsulate = decapsulate;
+}
+
 void EVP_PKEY_meth_get_init(const EVP_PKEY_METHOD *pmeth,
                             int (**pinit) (EVP_PKEY_CTX *ctx))
 {
@@ -920,3 +1019,43 @@ void EVP_PKEY_meth_get_digest_custom(EVP_PKEY_METHOD *pmeth,
     if (pdigest_custom != NULL)
         *pdigest_custom = pmeth->digest_custom;
 }
+
+void EVP_PKEY_meth_get_encapsulate(const EVP_PKEY_METHOD *pmeth,
+                                   int (**pencapsulate_init) (EVP_PKEY_CTX *ctx),
+                                   int (**pencapsulate) (EVP_PKEY_CTX *ctx,
+                                                         unsigned char *ct,
+                                                         size_t *ctlen,
+                                                         unsigned char *secret,
+                                                         size_t *secretlen))
+{
+    if (pencapsulate_init != NULL)
+        *pencapsulate_init = pmeth->encapsulate_init;
+    if (pencapsulate != NULL)
+        *pencapsulate = pmeth->encapsulate;
+}
+
+void EVP_PKEY_meth_get_encapsulate_batch(const EVP_PKEY_METHOD *pmeth,
+                                         int (**pencapsulate_batch)
+                                             (EVP_PKEY_CTX *ctx[], size_t num,
+                                              unsigned char *ct,
+                                              size_t *ctlen,
+                                              unsigned char *secret,
+                                              size_t *secretlen))
+{
+    if (pencapsulate_batch != NULL)
+        *pencapsulate_batch = pmeth->encapsulate_batch;
+}
+
+void EVP_PKEY_meth_get_decapsulate(const EVP_PKEY_METHOD *pmeth,
+                                   int (**pdecapsulate_init) (EVP_PKEY_CTX *ctx),
+                                   int (**pdecapsulate) (EVP_PKEY_CTX *ctx,
+                                                         unsigned char *secret,
+                                                         size_t *secretlen,
+                                                         const unsigned char *ct,
+                                                         size_t ctlen))
+{
+    if (pdecapsulate_init != NULL)
+        *pdecapsulate_init = pmeth->decapsulate_init;
+    if (pdecapsulate != NULL)
+        *pdecapsulate = pmeth->decapsulate;
+}
@@ -22,12 +22,39 @@ struct ex_callback_st {
     CRYPTO_EX_dup *dup_func;
 };
 
+/*
+ * Every SSL, SSL_SESSION, X509 and so on runs its class's callbacks when it
+ * is created and freed, while indexes are registered once at startup.  So
+ * each class also publishes an immutable array of its callbacks, with
+ * release semantics, that is read without |ex_data_lock|.  Registering an
+ * index unpublishes it and the next reader builds a new one.  An array
+ * that was unpublished may still be in use, so it is only freed by
+ * crypto_cleanup_all_ex_data_int(); after EX_DATA_SNAP_MAX_RETIRED of them
+ * readers go back to copying the callbacks under the lock, as they always
+ * do without the compiler atomics.
+ */
+#if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE) \
+    && __GCC_ATOMIC_POINTER_LOCK_FREE > 0
+# define EX_DATA_SNAPSHOT
+# define EX_DATA_SNAP_MAX_RETIRED       64
+#endif
+
+typedef struct ex_callbacks_snap_st EX_CALLBACKS_SNAP;
+struct ex_callbacks_snap_st {
+    EX_CALLBACKS_SNAP *retired;     /* next older unpublished array */
+    int num;
+    EX_CALLBACK **meth;
+};
+
 /*
  * The state for each class.  This could just be a typedef, but
  * a structure allows future changes.
  */
 typedef struct ex_callbacks_st {
     STACK_OF(EX_CALLBACK) *meth;
+    EX_CALLBACKS_SNAP *snap;        /* published copy of |meth| or NULL */
+    EX_CALLBACKS_SNAP *retired;
+    int num_retired;
 } EX_CALLBACKS;
 
 static EX_CALLBACKS ex_data[CRYPTO_EX_INDEX__COUNT];
@@ -79,6 +106,71 @@ static EX_CALLBACKS *get_and_lock(int class_index)
     return ip;
 }
 
+#ifdef EX_DATA_SNAPSHOT
+/*
+ * The published callbacks of |class_index|, built if there are none yet.
+ * NULL means the caller has to use the stack under the lock.
+ */
+static const EX_CALLBACKS_SNAP *get_snapshot(int class_index)
+{
+    EX_CALLBACKS *ip;
+    EX_CALLBACKS_SNAP *snap;
+    int mx, i;
+
+    if (class_index < 0 || class_index >= CRYPTO_EX_INDEX__COUNT)
+        return NULL;
+    snap = __atomic_load_n(&ex_data[class_index].snap, __ATOMIC_ACQUIRE);
+    if (snap != NULL)
+        return snap;
+
+    if ((ip = get_and_lock(class_index)) == NULL)
+        return NULL;
+    if ((snap = ip->snap) == NULL
+            && ip->num_retired < EX_DATA_SNAP_MAX_RETIRED) {
+        mx = sk_EX_CALLBACK_num(ip->meth);
+        if (mx < 0)
+            mx = 0;
+        snap = OPENSSL_malloc(sizeof(*snap) + sizeof(*snap->meth) * mx);
+        if (snap != NULL) {
+            snap->retired = NULL;
+            snap->num = mx;
+            snap->meth = (EX_CALLBACK **)(snap + 1);
+            for (i = 0; i < mx; i++)
+                snap->meth[i] = sk_EX_CALLBACK_value(ip->meth, i);
+            __atomic_store_n(&ip->snap, snap, __ATOMIC_RELEASE);
+        }
+    }
+    CRYPTO_THREAD_unlock(ex_data_lock);
+    return snap;
+}
+
+/* Must be called with |ex_data_lock| held */
+static void retire_snapshot(EX_CALLBACKS *ip)
+{
+    EX_CALLBACKS_SNAP *snap = ip->snap;
+
+    if (snap == NULL)
+        return;
+    __atomic_store_n(&ip->snap, NULL, __ATOMIC_RELEASE);
+    snap->retired = ip->retired;
+    ip->retired = snap;
+    ip->num_retired++;
+}
+#endif
+
+static void free_snapshots(EX_CALLBACKS *ip)
+{
+    EX_CALLBACKS_SNAP *snap;
+
+    OPENSSL_free(ip->snap);
+    ip->snap = NULL;
+    while ((snap = ip->retired) != NULL) {
+        ip->retired = snap->retired;
+        OPENSSL_free(snap);
+    }
+    ip->num_retired = 0;
+}
+
 static void cleanup_cb(EX_CALLBACK *funcs)
 {
     OPENSSL_free(funcs);
@@ -99,6 +191,7 @@ void crypto_cleanup_all_ex_data_int(void)
 
         sk_EX_CALLBACK_pop_free(ip->meth, cleanup_cb);
         ip->meth = NULL;
+        free_snapshots(ip);
     }
 
     CRYPTO_THREAD_lock_free(ex_data_lock);
@@ -192,6 +285,9 @@ int CRYPTO_get_ex_new_index(int class_index, long argl, void *argp,
     }
     toret = sk_EX_CALLBACK_num(ip->meth) - 1;
     (void)sk_EX_CALLBACK_set(ip->meth, toret, a);
+#ifdef EX_DATA_SNAPSHOT
+    retire_snapshot(ip);
+#endif
 
  err:
     CRYPTO_THREAD_unlock(ex_data_lock);
@@ -209,31 +305,42 @@ int CRYPTO_new_ex_data(int class_index, void *obj, CRYPTO_EX_DATA *ad)
 {
     int mx, i;
     void *ptr;
-    EX_CALLBACK **storage = NULL;
+    EX_CALLBACK **storage = NULL, **to_free = NULL;
     EX_CALLBACK *stack[10];
-    EX_CALLBACKS *ip = get_and_lock(class_index);
-
-    if (ip == NULL)
-        return 0;
+    EX_CALLBACKS *ip;
+#ifdef EX_DATA_SNAPSHOT
+    const EX_CALLBACKS_SNAP *snap = get_snapshot(class_index);
+
+    if (snap != NULL) {
+        mx = snap->num;
+        storage = snap->meth;
+        ad->sk = NULL;
+    } else
+#endif
+    {
+        if ((ip = get_and_lock(class_index)) == NULL)
+            return 0;
 
-    ad->sk = NULL;
+        ad->sk = NULL;
+
+        mx = sk_EX_CALLBACK_num(ip->meth);
+        if (mx > 0) {
+            if (mx < (int)OSSL_NELEM(stack))
+                storage = stack;
+            else
+                storage = to_free = OPENSSL_malloc(sizeof(*storage) * mx);
+            if (storage != NULL)
+                for (i = 0; i < mx; i++)
+                    storage[i] = sk_EX_CALLBACK_value(ip->meth, i);
+        }
+        CRYPTO_THREAD_unlock(ex_data_lock);
 
-    mx = sk_EX_CALLBACK_num(ip->meth);
-    if (mx > 0) {
-        if (mx < (int)OSSL_NELEM(stack))
-            storage = stack;
-        else
-            storage = OPENSSL_malloc(sizeof(*storage) * mx);
-        if (storage != NULL)
-            for (i = 0; i < mx; i++)
-                storage[i] = sk_EX_CALLBACK_value(ip->meth, i);
+        if (mx > 0 && storage == NULL) {
+            CRYPTOerr(CRYPTO_F_CRYPTO_NEW_EX_DATA, ERR_R_MALLOC_FAILURE);
+            return 0;
+        }
     }
-    CRYPTO_THREAD_unlock(ex_data_lock);
 
-    if (mx > 0 && storage == NULL) {
-        CRYPTOerr(CRYPTO_F_CRYPTO_NEW_EX_DATA, ERR_R_MALLOC_FAILURE);
-        return 0;
-    }
     for (i = 0; i < mx; i++) {
         if (storage[i] != NULL && storage[i]->new_func != NULL) {
             ptr = CRYPTO_get_ex_data(ad, i);
@@ -241,8 +348,7 @@ int CRYPTO_new_ex_data(int class_index, void *obj, CRYPTO_EX_DATA *ad)
                                  storage[i]->argl, storage[i]->argp);
         }
     }
-    if (storage != stack)
-        OPENSSL_free(storage);
+    OPENSSL_free(to_free);
     return 1;
 }
 
@@ -256,32 +362,46 @@ int CRYPTO_dup_ex_data(int class_index, CRYPTO_EX_DATA *to,
     int mx, j, i;
     void *ptr;
     EX_CALLBACK *stack[10];
-    EX_CALLBACK **storage = NULL;
+    EX_CALLBACK **storage = NULL, **to_free = NULL;
     EX_CALLBACKS *ip;
     int toret = 0;
+#ifdef EX_DATA_SNAPSHOT
+    const EX_CALLBACKS_SNAP *snap;
+#endif
 
     if (from->sk == NULL)
         /* Nothing to copy over */
         return 1;
-    if ((ip = get_and_lock(class_index)) == NULL)
-        return 0;
 
-    mx = sk_EX_CALLBACK_num(ip->meth);
     j = sk_void_num(from->sk);
-    if (j < mx)
-        mx = j;
-    if (mx > 0) {
-        if (mx < (int)OSSL_NELEM(stack))
-            storage = stack;
-        else
-            storage = OPENSSL_malloc(sizeof(*storage) * mx);
-        if (storage != NULL)
-            for (i = 0; i < mx; i++)
-                storage[i] = sk_EX_CALLBACK_value(ip->meth, i);
+#ifdef EX_DATA_SNAPSHOT
+    if ((snap = get_snapshot(class_index)) != NULL) {
+        mx = snap->num;
+        if (j < mx)
+            mx = j;
+        storage = snap->meth;
+    } else
+#endif
+    {
+        if ((ip = get_and_lock(class_index)) == NULL)
+            return 0;
+
+        mx = sk_EX_CALLBACK_num(ip->meth);
+        if (j < mx)
+            mx = j;
+        if (mx > 0) {
+            if (mx < (int)OSSL_NELEM(stack))
+                storage = stack;
+            else
+                storage = to_free = OPENSSL_malloc(sizeof(*storage) * mx);
+            if (storage != NULL)
+                for (i = 0; i < mx; i++)
+                    storage[i] = sk_EX_CALLBACK_value(ip->meth, i);
+        }
+        CRYPTO_THREAD_unlock(ex_data_lock);
     }
-    CRYPTO_THREAD_unlock(ex_data_lock);
 
-    if (mx == 0)
+    if (mx <= 0)
         return 1;
     if (storage == NULL) {
         CRYPTOerr(CRYPTO_F_CRYPTO_DUP_EX_DATA, ERR_R_MALLOC_FAILURE);
@@ -307,8 +427,7 @@ int CRYPTO_dup_ex_data(int class_index, CRYPTO_EX_DATA *to,
     }
     toret = 1;
  err:
-    if (storage != stack)
-        OPENSSL_free(storage);
+    OPENSSL_free(to_free);
     return toret;
 }
 
@@ -320,26 +439,35 @@ int CRYPTO_dup_ex_data(int class_index, CRYPTO_EX_DATA *to,
 void CRYPTO_free_ex_data(int class_index, void *obj, CRYPTO_EX_DATA *ad)
 {
     int mx, i;
-    EX_CALLBACKS *ip;
+    EX_CALLBACKS *ip = NULL;
     void *ptr;
     EX_CALLBACK *f;
     EX_CALLBACK *stack[10];
-    EX_CALLBACK **storage = NULL;
-
-    if ((ip = get_and_lock(class_index)) == NULL)
-        goto err;
+    EX_CALLBACK **storage = NULL, **to_free = NULL;
+#ifdef EX_DATA_SNAPSHOT
+    const EX_CALLBACKS_SNAP *snap = get_snapshot(class_index);
+
+    if (snap != NULL) {
+        mx = snap->num;
+        storage = snap->meth;
+    } else
+#endif
+    {
+        if ((ip = get_and_lock(class_index)) == NULL)
+            goto err;
 
-    mx = sk_EX_CALLBACK_num(ip->meth);
-    if (mx > 0) {
-        if (mx < (int)OSSL_NELEM(stack))
-            storage = stack;
-        else
-            storage = OPENSSL_malloc(sizeof(*storage) * mx);
-        if (storage != NULL)
-            for (i = 0; i < mx; i++)
-                storage[i] = sk_EX_CALLBACK_value(ip->meth, i);
+        mx = sk_EX_CALLBACK_num(ip->meth);
+        if (mx > 0) {
+            if (mx < (int)OSSL_NELEM(stack))
+                storage = stack;
+            else
+                storage = to_free = OPENSSL_malloc(sizeof(*storage) * mx);
+            if (storage != NULL)
+                for (i = 0; i < mx; i++)
+                    storage[i] = sk_EX_CALLBACK_value(ip->meth, i);
+        }
+        CRYPTO_THREAD_unlock(ex_data_lock);
     }
-    CRYPTO_THREAD_unlock(ex_data_lock);
 
     for (i = 0; i < mx; i++) {
         if (storage != NULL)
@@ -355,8 +483,7 @@ void CRYPTO_free_ex_data(int class_index, void *obj, CRYPTO_EX_DATA *ad)
         }
     }
 
-    if (storage != stack)
-        OPENSSL_free(storage);
+    OPENSSL_free(to_free);
  err:
     sk_void_free(ad->sk);
     ad->sk = NULL;
@@ -15,15 +15,77 @@
 #include <openssl/opensslconf.h>
 #include "hmac_local.h"
 
-int HMAC_Init_ex(HMAC_CTX *ctx, const void *key, int len,
-                 const EVP_MD *md, ENGINE *impl)
+/*
+ * The HMAC construction is not allowed to be used with the extendable-output
+ * functions (XOF) shake128 and shake256.
+ */
+static int hmac_md_ok(const EVP_MD *md)
+{
+    return (EVP_MD_meth_get_flags(md) & EVP_MD_FLAG_XOF) == 0
+           && ossl_assert(EVP_MD_block_size(md) <= HMAC_MAX_MD_CBLOCK_SIZE);
+}
+
+/*
+ * Write the |len| bytes of |key| as a block of |md| to |keytmp|, hashing it
+ * with |tmp| first if it is longer than that.
+ */
+static int hmac_block_key(const EVP_MD *md, ENGINE *impl, const void *key,
+                          int len, EVP_MD_CTX *tmp, unsigned char *keytmp)
 {
-    int rv = 0, reset = 0;
-    int i, j;
-    unsigned char pad[HMAC_MAX_MD_CBLOCK_SIZE];
     unsigned int keytmp_length;
+
+    if (EVP_MD_block_size(md) < len) {
+        if (!EVP_DigestInit_ex(tmp, md, impl)
+                || !EVP_DigestUpdate(tmp, key, len)
+                || !EVP_DigestFinal_ex(tmp, keytmp, &keytmp_length))
+            return 0;
+    } else {
+        if (len < 0 || len > HMAC_MAX_MD_CBLOCK_SIZE)
+            return 0;
+        memcpy(keytmp, key, len);
+        keytmp_length = len;
+    }
+    if (keytmp_length != HMAC_MAX_MD_CBLOCK_SIZE)
+        memset(&keytmp[keytmp_length], 0,
+               HMAC_MAX_MD_CBLOCK_SIZE - keytmp_length);
+    return 1;
+}
+
+/* Start |ctx| on the block key |keytmp| xored with |x| */
+static int hmac_pad_init(EVP_MD_CTX *ctx, const EVP_MD *md, ENGINE *impl,
+                         const unsigned char *keytmp, unsigned char x)
+{
+    unsigned char pad[HMAC_MAX_MD_CBLOCK_SIZE];
+    int i, ret;
+
+    for (i = 0; i < HMAC_MAX_MD_CBLOCK_SIZE; i++)
+        pad[i] = x ^ keytmp[i];
+    ret = EVP_DigestInit_ex(ctx, md, impl)
+          && EVP_DigestUpdate(ctx, pad, EVP_MD_block_size(md));
+    OPENSSL_cleanse(pad, sizeof(pad));
+    return ret;
+}
+
+/*
+ * Compute the states of |md| after the inner and the outer padded key into
+ * |i_ctx| and |o_ctx|. |i_ctx| is also used to hash long keys.
+ */
+static int hmac_set_key(const EVP_MD *md, ENGINE *impl, const void *key,
+                        int len, EVP_MD_CTX *i_ctx, EVP_MD_CTX *o_ctx)
+{
     unsigned char keytmp[HMAC_MAX_MD_CBLOCK_SIZE];
+    int ret;
+
+    ret = hmac_block_key(md, impl, key, len, i_ctx, keytmp)
+          && hmac_pad_init(i_ctx, md, impl, keytmp, 0x36)
+          && hmac_pad_init(o_ctx, md, impl, keytmp, 0x5c);
+    OPENSSL_cleanse(keytmp, sizeof(keytmp));
+    return ret;
+}
 
+int HMAC_Init_ex(HMAC_CTX *ctx, const void *key, int len,
+                 const EVP_MD *md, ENGINE *impl)
+{
     /* If we are changing MD then we must have a key */
     if (md != NULL && md != ctx->md && (key == NULL || len < 0))
         return 0;
@@ -36,56 +98,57 @@ int HMAC_Init_ex(HMAC_CTX *ctx, const void *key, int len,
         return 0;
     }
 
-    /*
-     * The HMAC construction is not allowed  to be used with the
-     * extendable-output functions (XOF) shake128 and shake256.
-     */
-    if ((EVP_MD_meth_get_flags(md) & EVP_MD_FLAG_XOF) != 0)
+    if (!hmac_md_ok(md))
         return 0;
 
-    if (key != NULL) {
-        reset = 1;
+    if (key != NULL
+            && !hmac_set_key(md, impl, key, len, ctx->i_ctx, ctx->o_ctx))
+        return 0;
+    return EVP_MD_CTX_copy_ex(ctx->md_ctx, ctx->i_ctx);
+}
 
-        j = EVP_MD_block_size(md);
-        if (!ossl_assert(j <= (int)sizeof(keytmp)))
-            return 0;
-        if (j < len) {
-            if (!EVP_DigestInit_ex(ctx->md_ctx, md, impl)
-                    || !EVP_DigestUpdate(ctx->md_ctx, key, len)
-                    || !EVP_DigestFinal_ex(ctx->md_ctx, keytmp,
-                                           &keytmp_length))
-                return 0;
-        } else {
-            if (len < 0 || len > (int)sizeof(keytmp))
-                return 0;
-            memcpy(keytmp, key, len);
-            keytmp_length = len;
-        }
-        if (keytmp_length != HMAC_MAX_MD_CBLOCK_SIZE)
-            memset(&keytmp[keytmp_length], 0,
-                   HMAC_MAX_MD_CBLOCK_SIZE - keytmp_length);
-
-        for (i = 0; i < HMAC_MAX_MD_CBLOCK_SIZE; i++)
-            pad[i] = 0x36 ^ keytmp[i];
-        if (!EVP_DigestInit_ex(ctx->i_ctx, md, impl)
-                || !EVP_DigestUpdate(ctx->i_ctx, pad, EVP_MD_block_size(md)))
-            goto err;
-
-        for (i = 0; i < HMAC_MAX_MD_CBLOCK_SIZE; i++)
-            pad[i] = 0x5c ^ keytmp[i];
-        if (!EVP_DigestInit_ex(ctx->o_ctx, md, impl)
-                || !EVP_DigestUpdate(ctx->o_ctx, pad, EVP_MD_block_size(md)))
-            goto err;
+HMAC_KEY *HMAC_KEY_new(void)
+{
+    HMAC_KEY *hkey = OPENSSL_zalloc(sizeof(*hkey));
+
+    if (hkey != NULL
+            && ((hkey->i_ctx = EVP_MD_CTX_new()) == NULL
+                || (hkey->o_ctx = EVP_MD_CTX_new()) == NULL)) {
+        HMAC_KEY_free(hkey);
+        return NULL;
     }
-    if (!EVP_MD_CTX_copy_ex(ctx->md_ctx, ctx->i_ctx))
-        goto err;
-    rv = 1;
- err:
-    if (reset) {
-        OPENSSL_cleanse(keytmp, sizeof(keytmp));
-        OPENSSL_cleanse(pad, sizeof(pad));
+    return hkey;
+}
+
+void HMAC_KEY_free(HMAC_KEY *hkey)
+{
+    if (hkey == NULL)
+        return;
+    EVP_MD_CTX_free(hkey->i_ctx);
+    EVP_MD_CTX_free(hkey->o_ctx);
+    OPENSSL_free(hkey);
+}
+
+int HMAC_KEY_set(HMAC_KEY *hkey, const void *key, int len, const EVP_MD *md)
+{
+    if (key == NULL || md == NULL || !hmac_md_ok(md)
+            || !hmac_set_key(md, NULL, key, len, hkey->i_ctx, hkey->o_ctx)) {
+        hkey->md = NULL;
+        return 0;
     }
-    return rv;
+    hkey->md = md;
+    return 1;
+}
+
+int HMAC_Init_key(HMAC_CTX *ctx, const HMAC_KEY *hkey)
+{
+    if (hkey->md == NULL
+            || !EVP_MD_CTX_copy_ex(ctx->i_ctx, hkey->i_ctx)
+            || !EVP_MD_CTX_copy_ex(ctx->o_ctx, hkey->o_ctx)
+            || !EVP_MD_CTX_copy_ex(ctx->md_ctx, hkey->i_ctx))
+        return 0;
+    ctx->md = hkey->md;
+    return 1;
 }
 
 #if OPENSSL_API_COMPAT < 0x10100000L
@@ -208,35 +271,44 @@ int HMAC_CTX_copy(HMAC_CTX *dctx, HMAC_CTX *sctx)
     return 0;
 }
 
+/*
+ * The one-shot HMAC runs the inner and then the outer hash on a single
+ * digest context, rather than setting up the three of an HMAC_CTX.
+ */
 unsigned char *HMAC(const EVP_MD *evp_md, const void *key, int key_len,
                     const unsigned char *d, size_t n, unsigned char *md,
                     unsigned int *md_len)
 {
-    HMAC_CTX *c = NULL;
+    EVP_MD_CTX *c = NULL;
     static unsigned char m[EVP_MAX_MD_SIZE];
     static const unsigned char dummy_key[1] = {'\0'};
+    unsigned char keytmp[HMAC_MAX_MD_CBLOCK_SIZE];
+    unsigned char buf[EVP_MAX_MD_SIZE];
+    unsigned int buflen;
+    unsigned char *ret = NULL;
 
     if (md == NULL)
         md = m;
-    if ((c = HMAC_CTX_new()) == NULL)
-        goto err;
+    if (evp_md == NULL || !hmac_md_ok(evp_md))
+        return NULL;
+    if ((c = EVP_MD_CTX_new()) == NULL)
+        return NULL;
 
-    /* For HMAC_Init_ex, NULL key signals reuse. */
-    if (key == NULL && key_len == 0) {
+    if (key == NULL && key_len == 0)
         key = dummy_key;
-    }
 
-    if (!HMAC_Init_ex(c, key, key_len, evp_md, NULL))
-        goto err;
-    if (!HMAC_Update(c, d, n))
-        goto err;
-    if (!HMAC_Final(c, md, md_len))
-        goto err;
-    HMAC_CTX_free(c);
-    return md;
- err:
-    HMAC_CTX_free(c);
-    return NULL;
+    if (hmac_block_key(evp_md, NULL, key, key_len, c, keytmp)
+            && hmac_pad_init(c, evp_md, NULL, keytmp, 0x36)
+            && EVP_DigestUpdate(c, d, n)
+            && EVP_DigestFinal_ex(c, buf, &buflen)
+            && hmac_pad_init(c, evp_md, NULL, keytmp, 0x5c)
+            && EVP_DigestUpdate(c, buf, buflen)
+            && EVP_DigestFinal_ex(c, md, md_len))
+        ret = md;
+    OPENSSL_cleanse(keytmp, sizeof(keytmp));
+    OPENSSL_cleanse(buf, sizeof(buf));
+    EVP_MD_CTX_free(c);
+    return ret;
 }
 
 void HMAC_CTX_set_flags(HMAC_CTX *ctx, unsigned long flags)
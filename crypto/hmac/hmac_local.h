@@ -20,4 +20,11 @@ struct hmac_ctx_st {
     EVP_MD_CTX *o_ctx;
 };
 
+/* The states of |md| after the inner and the outer padded key */
+struct hmac_key_st {
+    const EVP_MD *md;
+    EVP_MD_CTX *i_ctx;
+    EVP_MD_CTX *o_ctx;
+};
+
 #endif
@@ -11,6 +11,8 @@
 #include "crypto/cryptlib.h"
 #include <openssl/err.h>
 #include "crypto/rand.h"
+#include "crypto/bn.h"
+#include "crypto/dh.h"
 #include "internal/bio.h"
 #include <openssl/evp.h>
 #include "crypto/evp.h"
@@ -27,6 +29,7 @@
 #include "crypto/dso_conf.h"
 #include "internal/dso.h"
 #include "crypto/store.h"
+#include "crypto/x509.h"
 
 static int stopped = 0;
 
@@ -101,6 +104,7 @@ DEFINE_RUN_ONCE_STATIC(ossl_init_base)
     if ((init_lock = CRYPTO_THREAD_lock_new()) == NULL)
         goto err;
     OPENSSL_cpuid_setup();
+    oqs_rand_init_int();
 
     destructor_key.value = key;
     base_inited = 1;
@@ -224,7 +228,9 @@ DEFINE_RUN_ONCE_STATIC(ossl_init_load_crypto_strings)
     fprintf(stderr, "OPENSSL_INIT: ossl_init_load_crypto_strings: "
                     "err_load_crypto_strings_int()\n");
 # endif
+    err_strings_loading(1);
     ret = err_load_crypto_strings_int();
+    err_strings_loading(0);
 #endif
     return ret;
 }
@@ -445,6 +451,14 @@ static void ossl_init_thread_stop(struct thread_local_inits_st *locals)
         drbg_delete_thread_state();
     }
 
+    if (locals->bn_ctx) {
+#ifdef OPENSSL_INIT_DEBUG
+        fprintf(stderr, "OPENSSL_INIT: ossl_init_thread_stop: "
+                        "bn_ctx_delete_thread_state()\n");
+#endif
+        bn_ctx_delete_thread_state();
+    }
+
     OPENSSL_free(locals);
 }
 
@@ -490,6 +504,14 @@ int ossl_init_thread_start(uint64_t opts)
         locals->rand = 1;
     }
 
+    if (opts & OPENSSL_INIT_THREAD_BN_CTX) {
+#ifdef OPENSSL_INIT_DEBUG
+        fprintf(stderr, "OPENSSL_INIT: ossl_init_thread_start: "
+                        "marking thread for bn_ctx\n");
+#endif
+        locals->bn_ctx = 1;
+    }
+
     return 1;
 }
 
@@ -553,8 +575,18 @@ void OPENSSL_cleanup(void)
     CRYPTO_THREAD_cleanup_local(&key);
 
 #ifdef OPENSSL_INIT_DEBUG
+    fprintf(stderr, "OPENSSL_INIT: OPENSSL_cleanup: "
+                    "x509_intern_cleanup_int()\n");
+    fprintf(stderr, "OPENSSL_INIT: OPENSSL_cleanup: "
+                    "oqs_rand_cleanup_int()\n");
     fprintf(stderr, "OPENSSL_INIT: OPENSSL_cleanup: "
                     "rand_cleanup_int()\n");
+    fprintf(stderr, "OPENSSL_INIT: OPENSSL_cleanup: "
+                    "bn_ctx_cleanup_int()\n");
+#ifndef OPENSSL_NO_DH
+    fprintf(stderr, "OPENSSL_INIT: OPENSSL_cleanup: "
+                    "dh_named_group_cleanup_int()\n");
+#endif
     fprintf(stderr, "OPENSSL_INIT: OPENSSL_cleanup: "
                     "conf_modules_free_int()\n");
 #ifndef OPENSSL_NO_ENGINE
@@ -567,12 +599,18 @@ void OPENSSL_cleanup(void)
                     "bio_sock_cleanup_int()\n");
     fprintf(stderr, "OPENSSL_INIT: OPENSSL_cleanup: "
                     "bio_cleanup()\n");
+    fprintf(stderr, "OPENSSL_INIT: OPENSSL_cleanup: "
+                    "oqs_alg_table_cleanup_int()\n");
     fprintf(stderr, "OPENSSL_INIT: OPENSSL_cleanup: "
                     "evp_cleanup_int()\n");
     fprintf(stderr, "OPENSSL_INIT: OPENSSL_cleanup: "
                     "obj_cleanup_int()\n");
     fprintf(stderr, "OPENSSL_INIT: OPENSSL_cleanup: "
                     "err_cleanup()\n");
+#ifndef OPENSSL_NO_METRICS
+    fprintf(stderr, "OPENSSL_INIT: OPENSSL_cleanup: "
+                    "metrics_cleanup_int()\n");
+#endif
 #endif
     /*
      * Note that cleanup order is important:
@@ -584,9 +622,18 @@ void OPENSSL_cleanup(void)
      * before engine_cleanup_int()
      * - ENGINEs and additional EVP algorithms might use added OIDs names so
      * obj_cleanup_int() must be called last
+     * - liboqs must stop calling into the DRBGs before they are freed
+     * - interned certificates hold keys that may use ENGINEs and ex data
+     * - everything before may still count into the metrics
      */
+    x509_intern_cleanup_int();
+    oqs_rand_cleanup_int();
     rand_cleanup_int();
     rand_drbg_cleanup_int();
+    bn_ctx_cleanup_int();
+#ifndef OPENSSL_NO_DH
+    dh_named_group_cleanup_int();
+#endif
     conf_modules_free_int();
 #ifndef OPENSSL_NO_ENGINE
     engine_cleanup_int();
@@ -594,9 +641,13 @@ void OPENSSL_cleanup(void)
     ossl_store_cleanup_int();
     crypto_cleanup_all_ex_data_int();
     bio_cleanup();
+    oqs_alg_table_cleanup_int();
     evp_cleanup_int();
     obj_cleanup_int();
     err_cleanup();
+#ifndef OPENSSL_NO_METRICS
+    metrics_cleanup_int();
+#endif
 
     CRYPTO_secure_malloc_done();
 
@@ -8,9 +8,11 @@
  */
 
 #include <stdio.h>
+#include <limits.h>
 #include "internal/cryptlib.h"
 #include <openssl/kdf.h>
 #include <openssl/evp.h>
+#include <openssl/hmac.h>
 #include "crypto/evp.h"
 
 static int tls1_prf_alg(const EVP_MD *md,
@@ -177,58 +179,57 @@ static int tls1_prf_P_hash(const EVP_MD *md,
                            const unsigned char *seed, size_t seed_len,
                            unsigned char *out, size_t olen)
 {
+    static const unsigned char dummy_key[1] = {'\0'};
     int chunk;
-    EVP_MD_CTX *ctx = NULL, *ctx_tmp = NULL, *ctx_init = NULL;
-    EVP_PKEY *mac_key = NULL;
+    HMAC_CTX *ctx = NULL, *ctx_tmp = NULL;
     unsigned char A1[EVP_MAX_MD_SIZE];
-    size_t A1_len;
+    unsigned int A1_len;
     int ret = 0;
 
     chunk = EVP_MD_size(md);
-    if (!ossl_assert(chunk > 0))
+    if (!ossl_assert(chunk > 0) || sec_len > INT_MAX)
         goto err;
 
-    ctx = EVP_MD_CTX_new();
-    ctx_tmp = EVP_MD_CTX_new();
-    ctx_init = EVP_MD_CTX_new();
-    if (ctx == NULL || ctx_tmp == NULL || ctx_init == NULL)
+    /*
+     * The secret is only turned into the inner and outer HMAC states once;
+     * each block then starts again from a copy of them.
+     */
+    ctx = HMAC_CTX_new();
+    ctx_tmp = HMAC_CTX_new();
+    if (ctx == NULL || ctx_tmp == NULL)
         goto err;
-    EVP_MD_CTX_set_flags(ctx_init, EVP_MD_CTX_FLAG_NON_FIPS_ALLOW);
-    mac_key = EVP_PKEY_new_raw_private_key(EVP_PKEY_HMAC, NULL, sec, sec_len);
-    if (mac_key == NULL)
+    HMAC_CTX_set_flags(ctx, EVP_MD_CTX_FLAG_NON_FIPS_ALLOW);
+    if (!HMAC_Init_ex(ctx, sec != NULL ? sec : dummy_key, (int)sec_len, md,
+                      NULL))
         goto err;
-    if (!EVP_DigestSignInit(ctx_init, NULL, md, NULL, mac_key))
+    if (seed != NULL && !HMAC_Update(ctx, seed, seed_len))
         goto err;
-    if (!EVP_MD_CTX_copy_ex(ctx, ctx_init))
-        goto err;
-    if (seed != NULL && !EVP_DigestSignUpdate(ctx, seed, seed_len))
-        goto err;
-    if (!EVP_DigestSignFinal(ctx, A1, &A1_len))
+    if (!HMAC_Final(ctx, A1, &A1_len))
         goto err;
 
     for (;;) {
         /* Reinit mac contexts */
-        if (!EVP_MD_CTX_copy_ex(ctx, ctx_init))
+        if (!HMAC_Init_ex(ctx, NULL, 0, NULL, NULL))
             goto err;
-        if (!EVP_DigestSignUpdate(ctx, A1, A1_len))
+        if (!HMAC_Update(ctx, A1, A1_len))
             goto err;
-        if (olen > (size_t)chunk && !EVP_MD_CTX_copy_ex(ctx_tmp, ctx))
+        if (olen > (size_t)chunk && !HMAC_CTX_copy(ctx_tmp, ctx))
             goto err;
-        if (seed && !EVP_DigestSignUpdate(ctx, seed, seed_len))
+        if (seed && !HMAC_Update(ctx, seed, seed_len))
             goto err;
 
         if (olen > (size_t)chunk) {
-            size_t mac_len;
-            if (!EVP_DigestSignFinal(ctx, out, &mac_len))
+            unsigned int mac_len;
+            if (!HMAC_Final(ctx, out, &mac_len))
                 goto err;
             out += mac_len;
             olen -= mac_len;
             /* calc the next A1 value */
-            if (!EVP_DigestSignFinal(ctx_tmp, A1, &A1_len))
+            if (!HMAC_Final(ctx_tmp, A1, &A1_len))
                 goto err;
         } else {                /* last one */
 
-            if (!EVP_DigestSignFinal(ctx, A1, &A1_len))
+            if (!HMAC_Final(ctx, A1, &A1_len))
                 goto err;
             memcpy(out, A1, olen);
             break;
@@ -236,10 +237,8 @@ static int tls1_prf_P_hash(const EVP_MD *md,
     }
     ret = 1;
  err:
-    EVP_PKEY_free(mac_key);
-    EVP_MD_CTX_free(ctx);
-    EVP_MD_CTX_free(ctx_tmp);
-    EVP_MD_CTX_free(ctx_init);
+    HMAC_CTX_free(ctx);
+    HMAC_CTX_free(ctx_tmp);
     OPENSSL_cleanse(A1, sizeof(A1));
     return ret;
 }
@@ -13,8 +13,12 @@
 #include <openssl/crypto.h>
 #include <openssl/lhash.h>
 #include <openssl/err.h>
+#include <openssl/rand.h>
+#include <time.h>
+#include "internal/thread_once.h"
 #include "crypto/ctype.h"
 #include "crypto/lhash.h"
+#include "crypto/siphash.h"
 #include "lhash_local.h"
 
 /*
@@ -89,6 +93,10 @@ void OPENSSL_LH_free(OPENSSL_LHASH *lh)
             n = nn;
         }
     }
+    for (n = lh->free_nodes; n != NULL; n = nn) {
+        nn = n->next;
+        OPENSSL_free(n);
+    }
     OPENSSL_free(lh->b);
     OPENSSL_free(lh);
 }
@@ -106,7 +114,10 @@ void *OPENSSL_LH_insert(OPENSSL_LHASH *lh, void *data)
     rn = getrn(lh, data, &hash);
 
     if (*rn == NULL) {
-        if ((nn = OPENSSL_malloc(sizeof(*nn))) == NULL) {
+        if ((nn = lh->free_nodes) != NULL) {
+            lh->free_nodes = nn->next;
+            lh->num_free_nodes--;
+        } else if ((nn = OPENSSL_malloc(sizeof(*nn))) == NULL) {
             lh->error++;
             return NULL;
         }
@@ -115,12 +126,12 @@ void *OPENSSL_LH_insert(OPENSSL_LHASH *lh, void *data)
         nn->hash = hash;
         *rn = nn;
         ret = NULL;
-        lh->num_insert++;
+        LH_STAT(lh, num_insert);
         lh->num_items++;
     } else {                    /* replace same key */
         ret = (*rn)->data;
         (*rn)->data = data;
-        lh->num_replace++;
+        LH_STAT(lh, num_replace);
     }
     return ret;
 }
@@ -135,14 +146,20 @@ void *OPENSSL_LH_delete(OPENSSL_LHASH *lh, const void *data)
     rn = getrn(lh, data, &hash);
 
     if (*rn == NULL) {
-        lh->num_no_delete++;
+        LH_STAT(lh, num_no_delete);
         return NULL;
     } else {
         nn = *rn;
         *rn = nn->next;
         ret = nn->data;
-        OPENSSL_free(nn);
-        lh->num_delete++;
+        if (lh->num_free_nodes < LH_MAX_FREE_NODES) {
+            nn->next = lh->free_nodes;
+            lh->free_nodes = nn;
+            lh->num_free_nodes++;
+        } else {
+            OPENSSL_free(nn);
+        }
+        LH_STAT(lh, num_delete);
     }
 
     lh->num_items--;
@@ -159,16 +176,18 @@ void *OPENSSL_LH_retrieve(OPENSSL_LHASH *lh, const void *data)
     OPENSSL_LH_NODE **rn;
     void *ret;
 
-    tsan_store((TSAN_QUALIFIER int *)&lh->error, 0);
+    /* only write to the table if needed, readers may share it */
+    if (tsan_load((TSAN_QUALIFIER int *)&lh->error) != 0)
+        tsan_store((TSAN_QUALIFIER int *)&lh->error, 0);
 
     rn = getrn(lh, data, &hash);
 
     if (*rn == NULL) {
-        tsan_counter(&lh->num_retrieve_miss);
+        LH_STAT_TSAN(lh, num_retrieve_miss);
         return NULL;
     } else {
         ret = (*rn)->data;
-        tsan_counter(&lh->num_retrieve);
+        LH_STAT_TSAN(lh, num_retrieve);
     }
 
     return ret;
@@ -245,7 +264,7 @@ static int expand(OPENSSL_LHASH *lh)
 
     for (np = *n1; np != NULL;) {
         hash = np->hash;
-        if ((hash % nni) != p) { /* move it */
+        if ((hash & (nni - 1)) != p) { /* move it */
             *n1 = (*n1)->next;
             np->next = *n2;
             *n2 = np;
@@ -300,22 +319,23 @@ static OPENSSL_LH_NODE **getrn(OPENSSL_LHASH *lh,
     OPENSSL_LH_COMPFUNC cf;
 
     hash = (*(lh->hash)) (data);
-    tsan_counter(&lh->num_hash_calls);
+    LH_STAT_TSAN(lh, num_hash_calls);
     *rhash = hash;
 
-    nn = hash % lh->pmax;
+    /* both are powers of two */
+    nn = hash & (lh->pmax - 1);
     if (nn < lh->p)
-        nn = hash % lh->num_alloc_nodes;
+        nn = hash & (lh->num_alloc_nodes - 1);
 
     cf = lh->comp;
     ret = &(lh->b[(int)nn]);
     for (n1 = *ret; n1 != NULL; n1 = n1->next) {
-        tsan_counter(&lh->num_hash_comps);
+        LH_STAT_TSAN(lh, num_hash_comps);
         if (n1->hash != hash) {
             ret = &(n1->next);
             continue;
         }
-        tsan_counter(&lh->num_comp_calls);
+        LH_STAT_TSAN(lh, num_comp_calls);
         if (cf(n1->data, data) == 0)
             break;
         ret = &(n1->next);
@@ -352,6 +372,53 @@ unsigned long OPENSSL_LH_strhash(const char *c)
     return (ret >> 16) ^ ret;
 }
 
+/*
+ * Tables fed with keys chosen by a peer, such as session IDs or names, are
+ * hashed with a per-process random key so that colliding keys can't be
+ * computed in advance.
+ */
+static unsigned char lh_hash_key[16];
+static CRYPTO_ONCE lh_hash_key_once = CRYPTO_ONCE_STATIC_INIT;
+
+DEFINE_RUN_ONCE_STATIC(do_lh_hash_key_init)
+{
+    ERR_set_mark();
+    if (RAND_priv_bytes(lh_hash_key, sizeof(lh_hash_key)) <= 0) {
+        /* Without randomness, still differ from one process to another */
+        uint64_t t = (uint64_t)time(NULL);
+        size_t a = (size_t)&lh_hash_key;
+
+        memcpy(lh_hash_key, &t, sizeof(t));
+        memcpy(lh_hash_key + 8, &a, sizeof(a) < 8 ? sizeof(a) : 8);
+    }
+    ERR_pop_to_mark();
+    return 1;
+}
+
+unsigned long OPENSSL_LH_keyed_hash(const void *data, size_t len)
+{
+#ifdef OPENSSL_NO_SIPHASH
+    const unsigned char *p = data;
+    uint64_t h;
+    size_t i;
+#endif
+
+    if (!RUN_ONCE(&lh_hash_key_once, do_lh_hash_key_init))
+        return 0;
+#ifndef OPENSSL_NO_SIPHASH
+    return (unsigned long)SipHash_hash13(lh_hash_key, data, len);
+#else
+    /* FNV-1a from a keyed offset basis */
+    memcpy(&h, lh_hash_key, sizeof(h));
+    h ^= 0xcbf29ce484222325ULL;
+    for (i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return (unsigned long)(h ^ (h >> 32));
+#endif
+}
+
 unsigned long openssl_lh_strcasehash(const char *c)
 {
     unsigned long ret = 0;
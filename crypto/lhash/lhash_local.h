@@ -10,6 +10,23 @@
 
 #include "internal/tsan_assist.h"
 
+/*
+ * The per-operation counters reported by OPENSSL_LH_stats() cost a write to
+ * the table on every lookup, which makes readers sharing a table under a read
+ * lock fight over its cache line.  They are only kept when the library is
+ * built with -DOPENSSL_LH_STATS.
+ */
+#ifdef OPENSSL_LH_STATS
+# define LH_STAT(lh, field)      ((lh)->field++)
+# define LH_STAT_TSAN(lh, field) tsan_counter(&(lh)->field)
+#else
+# define LH_STAT(lh, field)
+# define LH_STAT_TSAN(lh, field)
+#endif
+
+/* Deleted nodes kept for reuse by later inserts */
+#define LH_MAX_FREE_NODES       16
+
 struct lhash_node_st {
     void *data;
     struct lhash_node_st *next;
@@ -31,6 +48,9 @@ struct lhash_st {
     unsigned long num_expand_reallocs;
     unsigned long num_contracts;
     unsigned long num_contract_reallocs;
+    OPENSSL_LH_NODE *free_nodes;
+    unsigned int num_free_nodes;
+#ifdef OPENSSL_LH_STATS
     TSAN_QUALIFIER unsigned long num_hash_calls;
     TSAN_QUALIFIER unsigned long num_comp_calls;
     unsigned long num_insert;
@@ -40,5 +60,6 @@ struct lhash_st {
     TSAN_QUALIFIER unsigned long num_retrieve;
     TSAN_QUALIFIER unsigned long num_retrieve_miss;
     TSAN_QUALIFIER unsigned long num_hash_comps;
+#endif
     int error;
 };
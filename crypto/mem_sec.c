@@ -54,12 +54,8 @@
 #endif
 
 #ifdef OPENSSL_SECURE_MEMORY
-static size_t secure_mem_used;
-
 static int secure_mem_initialized;
 
-static CRYPTO_RWLOCK *sec_malloc_lock = NULL;
-
 /*
  * These are the functions that must be implemented by a secure heap (sh).
  */
@@ -69,6 +65,7 @@ static void sh_free(void *ptr);
 static void sh_done(void);
 static size_t sh_actual_size(char *ptr);
 static int sh_allocated(const char *ptr);
+static size_t sh_used(void);
 #endif
 
 int CRYPTO_secure_malloc_init(size_t size, int minsize)
@@ -77,15 +74,8 @@ int CRYPTO_secure_malloc_init(size_t size, int minsize)
     int ret = 0;
 
     if (!secure_mem_initialized) {
-        sec_malloc_lock = CRYPTO_THREAD_lock_new();
-        if (sec_malloc_lock == NULL)
-            return 0;
-        if ((ret = sh_init(size, minsize)) != 0) {
+        if ((ret = sh_init(size, minsize)) != 0)
             secure_mem_initialized = 1;
-        } else {
-            CRYPTO_THREAD_lock_free(sec_malloc_lock);
-            sec_malloc_lock = NULL;
-        }
     }
 
     return ret;
@@ -97,11 +87,9 @@ int CRYPTO_secure_malloc_init(size_t size, int minsize)
 int CRYPTO_secure_malloc_done(void)
 {
 #ifdef OPENSSL_SECURE_MEMORY
-    if (secure_mem_used == 0) {
+    if (sh_used() == 0) {
         sh_done();
         secure_mem_initialized = 0;
-        CRYPTO_THREAD_lock_free(sec_malloc_lock);
-        sec_malloc_lock = NULL;
         return 1;
     }
 #endif /* OPENSSL_SECURE_MEMORY */
@@ -120,18 +108,10 @@ int CRYPTO_secure_malloc_initialized(void)
 void *CRYPTO_secure_malloc(size_t num, const char *file, int line)
 {
 #ifdef OPENSSL_SECURE_MEMORY
-    void *ret;
-    size_t actual_size;
-
     if (!secure_mem_initialized) {
         return CRYPTO_malloc(num, file, line);
     }
-    CRYPTO_THREAD_write_lock(sec_malloc_lock);
-    ret = sh_malloc(num);
-    actual_size = ret ? sh_actual_size(ret) : 0;
-    secure_mem_used += actual_size;
-    CRYPTO_THREAD_unlock(sec_malloc_lock);
-    return ret;
+    return sh_malloc(num);
 #else
     return CRYPTO_malloc(num, file, line);
 #endif /* OPENSSL_SECURE_MEMORY */
@@ -150,20 +130,13 @@ void *CRYPTO_secure_zalloc(size_t num, const char *file, int line)
 void CRYPTO_secure_free(void *ptr, const char *file, int line)
 {
 #ifdef OPENSSL_SECURE_MEMORY
-    size_t actual_size;
-
     if (ptr == NULL)
         return;
     if (!CRYPTO_secure_allocated(ptr)) {
         CRYPTO_free(ptr, file, line);
         return;
     }
-    CRYPTO_THREAD_write_lock(sec_malloc_lock);
-    actual_size = sh_actual_size(ptr);
-    CLEAR(ptr, actual_size);
-    secure_mem_used -= actual_size;
     sh_free(ptr);
-    CRYPTO_THREAD_unlock(sec_malloc_lock);
 #else
     CRYPTO_free(ptr, file, line);
 #endif /* OPENSSL_SECURE_MEMORY */
@@ -173,8 +146,6 @@ void CRYPTO_secure_clear_free(void *ptr, size_t num,
                               const char *file, int line)
 {
 #ifdef OPENSSL_SECURE_MEMORY
-    size_t actual_size;
-
     if (ptr == NULL)
         return;
     if (!CRYPTO_secure_allocated(ptr)) {
@@ -182,12 +153,7 @@ void CRYPTO_secure_clear_free(void *ptr, size_t num,
         CRYPTO_free(ptr, file, line);
         return;
     }
-    CRYPTO_THREAD_write_lock(sec_malloc_lock);
-    actual_size = sh_actual_size(ptr);
-    CLEAR(ptr, actual_size);
-    secure_mem_used -= actual_size;
     sh_free(ptr);
-    CRYPTO_THREAD_unlock(sec_malloc_lock);
 #else
     if (ptr == NULL)
         return;
@@ -199,14 +165,10 @@ void CRYPTO_secure_clear_free(void *ptr, size_t num,
 int CRYPTO_secure_allocated(const void *ptr)
 {
 #ifdef OPENSSL_SECURE_MEMORY
-    int ret;
-
+    /* the heap bounds do not change while it is initialized */
     if (!secure_mem_initialized)
         return 0;
-    CRYPTO_THREAD_write_lock(sec_malloc_lock);
-    ret = sh_allocated(ptr);
-    CRYPTO_THREAD_unlock(sec_malloc_lock);
-    return ret;
+    return sh_allocated(ptr);
 #else
     return 0;
 #endif /* OPENSSL_SECURE_MEMORY */
@@ -215,7 +177,9 @@ int CRYPTO_secure_allocated(const void *ptr)
 size_t CRYPTO_secure_used(void)
 {
 #ifdef OPENSSL_SECURE_MEMORY
-    return secure_mem_used;
+    if (!secure_mem_initialized)
+        return 0;
+    return sh_used();
 #else
     return 0;
 #endif /* OPENSSL_SECURE_MEMORY */
@@ -224,12 +188,7 @@ size_t CRYPTO_secure_used(void)
 size_t CRYPTO_secure_actual_size(void *ptr)
 {
 #ifdef OPENSSL_SECURE_MEMORY
-    size_t actual_size;
-
-    CRYPTO_THREAD_write_lock(sec_malloc_lock);
-    actual_size = sh_actual_size(ptr);
-    CRYPTO_THREAD_unlock(sec_malloc_lock);
-    return actual_size;
+    return sh_actual_size(ptr);
 #else
     return 0;
 #endif
@@ -265,10 +224,24 @@ size_t CRYPTO_secure_actual_size(void *ptr)
 # define SETBIT(t, b)   (t[(b) >> 3] |= (ONE << ((b) & 7)))
 # define CLEARBIT(t, b) (t[(b) >> 3] &= (0xFF & ~(ONE << ((b) & 7))))
 
-#define WITHIN_ARENA(p) \
+#define WITHIN_ARENA(a, p) \
+    ((char*)(p) >= (a)->arena && (char*)(p) < &(a)->arena[(a)->arena_size])
+#define WITHIN_FREELIST(a, p) \
+    ((char*)(p) >= (char*)(a)->freelist && (char*)(p) < (char*)&(a)->freelist[(a)->freelist_size])
+#define WITHIN_HEAP(p) \
     ((char*)(p) >= sh.arena && (char*)(p) < &sh.arena[sh.arena_size])
-#define WITHIN_FREELIST(p) \
-    ((char*)(p) >= (char*)sh.freelist && (char*)(p) < (char*)&sh.freelist[sh.freelist_size])
+
+/*
+ * A heap large enough to be worth splitting is carved into one shared
+ * arena, taking the first half, and up to SH_THREAD_ARENAS equal arenas
+ * in the second half.  Each thread is given one of the latter as its home
+ * and falls back to the shared arena, then to the other threads' arenas,
+ * when that is full; requests larger than a thread arena go to the shared
+ * one.  Every arena is a buddy allocator with its own lock, so threads
+ * only contend when they share a home or fall back.
+ */
+#define SH_THREAD_ARENAS        8
+#define SH_THREAD_ARENA_MIN     (64 * 1024)
 
 
 typedef struct sh_list_st
@@ -277,10 +250,9 @@ typedef struct sh_list_st
     struct sh_list_st **p_next;
 } SH_LIST;
 
-typedef struct sh_st
+typedef struct sh_arena_st
 {
-    char* map_result;
-    size_t map_size;
+    CRYPTO_RWLOCK *lock;
     char *arena;
     size_t arena_size;
     char **freelist;
@@ -289,17 +261,31 @@ typedef struct sh_st
     unsigned char *bittable;
     unsigned char *bitmalloc;
     size_t bittable_size; /* size in bits */
+    size_t used;
+} SH_ARENA;
+
+typedef struct sh_st
+{
+    char* map_result;
+    size_t map_size;
+    char *arena;
+    size_t arena_size;
+    SH_ARENA *arenas;           /* shared arena first, then thread arenas */
+    int narenas;
+    size_t thread_arena_size;
+    CRYPTO_THREAD_LOCAL home;   /* 1 + index of the thread's arena */
+    int next_home;
 } SH;
 
 static SH sh;
 
-static size_t sh_getlist(char *ptr)
+static size_t sh_getlist(SH_ARENA *a, char *ptr)
 {
-    ossl_ssize_t list = sh.freelist_size - 1;
-    size_t bit = (sh.arena_size + ptr - sh.arena) / sh.minsize;
+    ossl_ssize_t list = a->freelist_size - 1;
+    size_t bit = (a->arena_size + ptr - a->arena) / a->minsize;
 
     for (; bit; bit >>= 1, list--) {
-        if (TESTBIT(sh.bittable, bit))
+        if (TESTBIT(a->bittable, bit))
             break;
         OPENSSL_assert((bit & 1) == 0);
     }
@@ -308,51 +294,51 @@ static size_t sh_getlist(char *ptr)
 }
 
 
-static int sh_testbit(char *ptr, int list, unsigned char *table)
+static int sh_testbit(SH_ARENA *a, char *ptr, int list, unsigned char *table)
 {
     size_t bit;
 
-    OPENSSL_assert(list >= 0 && list < sh.freelist_size);
-    OPENSSL_assert(((ptr - sh.arena) & ((sh.arena_size >> list) - 1)) == 0);
-    bit = (ONE << list) + ((ptr - sh.arena) / (sh.arena_size >> list));
-    OPENSSL_assert(bit > 0 && bit < sh.bittable_size);
+    OPENSSL_assert(list >= 0 && list < a->freelist_size);
+    OPENSSL_assert(((ptr - a->arena) & ((a->arena_size >> list) - 1)) == 0);
+    bit = (ONE << list) + ((ptr - a->arena) / (a->arena_size >> list));
+    OPENSSL_assert(bit > 0 && bit < a->bittable_size);
     return TESTBIT(table, bit);
 }
 
-static void sh_clearbit(char *ptr, int list, unsigned char *table)
+static void sh_clearbit(SH_ARENA *a, char *ptr, int list, unsigned char *table)
 {
     size_t bit;
 
-    OPENSSL_assert(list >= 0 && list < sh.freelist_size);
-    OPENSSL_assert(((ptr - sh.arena) & ((sh.arena_size >> list) - 1)) == 0);
-    bit = (ONE << list) + ((ptr - sh.arena) / (sh.arena_size >> list));
-    OPENSSL_assert(bit > 0 && bit < sh.bittable_size);
+    OPENSSL_assert(list >= 0 && list < a->freelist_size);
+    OPENSSL_assert(((ptr - a->arena) & ((a->arena_size >> list) - 1)) == 0);
+    bit = (ONE << list) + ((ptr - a->arena) / (a->arena_size >> list));
+    OPENSSL_assert(bit > 0 && bit < a->bittable_size);
     OPENSSL_assert(TESTBIT(table, bit));
     CLEARBIT(table, bit);
 }
 
-static void sh_setbit(char *ptr, int list, unsigned char *table)
+static void sh_setbit(SH_ARENA *a, char *ptr, int list, unsigned char *table)
 {
     size_t bit;
 
-    OPENSSL_assert(list >= 0 && list < sh.freelist_size);
-    OPENSSL_assert(((ptr - sh.arena) & ((sh.arena_size >> list) - 1)) == 0);
-    bit = (ONE << list) + ((ptr - sh.arena) / (sh.arena_size >> list));
-    OPENSSL_assert(bit > 0 && bit < sh.bittable_size);
+    OPENSSL_assert(list >= 0 && list < a->freelist_size);
+    OPENSSL_assert(((ptr - a->arena) & ((a->arena_size >> list) - 1)) == 0);
+    bit = (ONE << list) + ((ptr - a->arena) / (a->arena_size >> list));
+    OPENSSL_assert(bit > 0 && bit < a->bittable_size);
     OPENSSL_assert(!TESTBIT(table, bit));
     SETBIT(table, bit);
 }
 
-static void sh_add_to_list(char **list, char *ptr)
+static void sh_add_to_list(SH_ARENA *a, char **list, char *ptr)
 {
     SH_LIST *temp;
 
-    OPENSSL_assert(WITHIN_FREELIST(list));
-    OPENSSL_assert(WITHIN_ARENA(ptr));
+    OPENSSL_assert(WITHIN_FREELIST(a, list));
+    OPENSSL_assert(WITHIN_ARENA(a, ptr));
 
     temp = (SH_LIST *)ptr;
     temp->next = *(SH_LIST **)list;
-    OPENSSL_assert(temp->next == NULL || WITHIN_ARENA(temp->next));
+    OPENSSL_assert(temp->next == NULL || WITHIN_ARENA(a, temp->next));
     temp->p_next = (SH_LIST **)list;
 
     if (temp->next != NULL) {
@@ -363,7 +349,7 @@ static void sh_add_to_list(char **list, char *ptr)
     *list = ptr;
 }
 
-static void sh_remove_from_list(char *ptr)
+static void sh_remove_from_list(SH_ARENA *a, char *ptr)
 {
     SH_LIST *temp, *temp2;
 
@@ -375,16 +361,66 @@ static void sh_remove_from_list(char *ptr)
         return;
 
     temp2 = temp->next;
-    OPENSSL_assert(WITHIN_FREELIST(temp2->p_next) || WITHIN_ARENA(temp2->p_next));
+    OPENSSL_assert(WITHIN_FREELIST(a, temp2->p_next) || WITHIN_ARENA(a, temp2->p_next));
+}
+
+
+static int sh_arena_init(SH_ARENA *a, char *arena, size_t size,
+                         size_t minsize)
+{
+    size_t i;
+
+    a->arena = arena;
+    a->arena_size = size;
+    a->minsize = minsize;
+    a->bittable_size = (a->arena_size / a->minsize) * 2;
+
+    /* Prevent allocations of size 0 later on */
+    if (a->bittable_size >> 3 == 0)
+        return 0;
+
+    a->freelist_size = -1;
+    for (i = a->bittable_size; i; i >>= 1)
+        a->freelist_size++;
+
+    a->freelist = OPENSSL_zalloc(a->freelist_size * sizeof(char *));
+    OPENSSL_assert(a->freelist != NULL);
+    if (a->freelist == NULL)
+        return 0;
+
+    a->bittable = OPENSSL_zalloc(a->bittable_size >> 3);
+    OPENSSL_assert(a->bittable != NULL);
+    if (a->bittable == NULL)
+        return 0;
+
+    a->bitmalloc = OPENSSL_zalloc(a->bittable_size >> 3);
+    OPENSSL_assert(a->bitmalloc != NULL);
+    if (a->bitmalloc == NULL)
+        return 0;
+
+    if ((a->lock = CRYPTO_THREAD_lock_new()) == NULL)
+        return 0;
+
+    sh_setbit(a, a->arena, 0, a->bittable);
+    sh_add_to_list(a, &a->freelist[0], a->arena);
+    return 1;
 }
 
+static void sh_arena_done(SH_ARENA *a)
+{
+    OPENSSL_free(a->freelist);
+    OPENSSL_free(a->bittable);
+    OPENSSL_free(a->bitmalloc);
+    CRYPTO_THREAD_lock_free(a->lock);
+}
 
 static int sh_init(size_t size, int minsize)
 {
     int ret;
-    size_t i;
+    int i, threads;
     size_t pgsize;
     size_t aligned;
+    char *arena;
 
     memset(&sh, 0, sizeof(sh));
 
@@ -402,30 +438,27 @@ static int sh_init(size_t size, int minsize)
         minsize *= 2;
 
     sh.arena_size = size;
-    sh.minsize = minsize;
-    sh.bittable_size = (sh.arena_size / sh.minsize) * 2;
 
-    /* Prevent allocations of size 0 later on */
-    if (sh.bittable_size >> 3 == 0)
-        goto err;
-
-    sh.freelist_size = -1;
-    for (i = sh.bittable_size; i; i >>= 1)
-        sh.freelist_size++;
-
-    sh.freelist = OPENSSL_zalloc(sh.freelist_size * sizeof(char *));
-    OPENSSL_assert(sh.freelist != NULL);
-    if (sh.freelist == NULL)
-        goto err;
-
-    sh.bittable = OPENSSL_zalloc(sh.bittable_size >> 3);
-    OPENSSL_assert(sh.bittable != NULL);
-    if (sh.bittable == NULL)
-        goto err;
+    /* split only if every thread arena can still hold a few minsize units */
+    for (threads = SH_THREAD_ARENAS; threads > 1; threads /= 2) {
+        sh.thread_arena_size = size / 2 / threads;
+        if (sh.thread_arena_size >= SH_THREAD_ARENA_MIN
+                && sh.thread_arena_size >= 4 * (size_t)minsize)
+            break;
+    }
+    if (threads < 2) {
+        threads = 0;
+        sh.thread_arena_size = 0;
+    }
+    if (threads > 0 && !CRYPTO_THREAD_init_local(&sh.home, NULL)) {
+        threads = 0;
+        sh.thread_arena_size = 0;
+    }
+    sh.narenas = 1 + threads;
 
-    sh.bitmalloc = OPENSSL_zalloc(sh.bittable_size >> 3);
-    OPENSSL_assert(sh.bitmalloc != NULL);
-    if (sh.bitmalloc == NULL)
+    sh.arenas = OPENSSL_zalloc(sh.narenas * sizeof(*sh.arenas));
+    OPENSSL_assert(sh.arenas != NULL);
+    if (sh.arenas == NULL)
         goto err;
 
     /* Allocate space for heap, and two extra pages as guards */
@@ -463,8 +496,18 @@ static int sh_init(size_t size, int minsize)
     if (sh.map_result == MAP_FAILED)
         goto err;
     sh.arena = (char *)(sh.map_result + pgsize);
-    sh_setbit(sh.arena, 0, sh.bittable);
-    sh_add_to_list(&sh.freelist[0], sh.arena);
+
+    arena = sh.arena;
+    if (!sh_arena_init(&sh.arenas[0], arena,
+                       threads > 0 ? size / 2 : size, minsize))
+        goto err;
+    arena += sh.arenas[0].arena_size;
+    for (i = 1; i < sh.narenas; i++) {
+        if (!sh_arena_init(&sh.arenas[i], arena, sh.thread_arena_size,
+                           minsize))
+            goto err;
+        arena += sh.thread_arena_size;
+    }
 
     /* Now try to add guard pages and lock into memory. */
     ret = 1;
@@ -505,9 +548,13 @@ static int sh_init(size_t size, int minsize)
 
 static void sh_done(void)
 {
-    OPENSSL_free(sh.freelist);
-    OPENSSL_free(sh.bittable);
-    OPENSSL_free(sh.bitmalloc);
+    int i;
+
+    for (i = 0; sh.arenas != NULL && i < sh.narenas; i++)
+        sh_arena_done(&sh.arenas[i]);
+    OPENSSL_free(sh.arenas);
+    if (sh.narenas > 1)
+        CRYPTO_THREAD_cleanup_local(&sh.home);
     if (sh.map_result != MAP_FAILED && sh.map_size)
         munmap(sh.map_result, sh.map_size);
     memset(&sh, 0, sizeof(sh));
@@ -515,81 +562,81 @@ static void sh_done(void)
 
 static int sh_allocated(const char *ptr)
 {
-    return WITHIN_ARENA(ptr) ? 1 : 0;
+    return WITHIN_HEAP(ptr) ? 1 : 0;
 }
 
-static char *sh_find_my_buddy(char *ptr, int list)
+static char *sh_find_my_buddy(SH_ARENA *a, char *ptr, int list)
 {
     size_t bit;
     char *chunk = NULL;
 
-    bit = (ONE << list) + (ptr - sh.arena) / (sh.arena_size >> list);
+    bit = (ONE << list) + (ptr - a->arena) / (a->arena_size >> list);
     bit ^= 1;
 
-    if (TESTBIT(sh.bittable, bit) && !TESTBIT(sh.bitmalloc, bit))
-        chunk = sh.arena + ((bit & ((ONE << list) - 1)) * (sh.arena_size >> list));
+    if (TESTBIT(a->bittable, bit) && !TESTBIT(a->bitmalloc, bit))
+        chunk = a->arena + ((bit & ((ONE << list) - 1)) * (a->arena_size >> list));
 
     return chunk;
 }
 
-static void *sh_malloc(size_t size)
+static void *sh_arena_malloc(SH_ARENA *a, size_t size)
 {
     ossl_ssize_t list, slist;
     size_t i;
     char *chunk;
 
-    if (size > sh.arena_size)
+    if (size > a->arena_size)
         return NULL;
 
-    list = sh.freelist_size - 1;
-    for (i = sh.minsize; i < size; i <<= 1)
+    list = a->freelist_size - 1;
+    for (i = a->minsize; i < size; i <<= 1)
         list--;
     if (list < 0)
         return NULL;
 
     /* try to find a larger entry to split */
     for (slist = list; slist >= 0; slist--)
-        if (sh.freelist[slist] != NULL)
+        if (a->freelist[slist] != NULL)
             break;
     if (slist < 0)
         return NULL;
 
     /* split larger entry */
     while (slist != list) {
-        char *temp = sh.freelist[slist];
+        char *temp = a->freelist[slist];
 
         /* remove from bigger list */
-        OPENSSL_assert(!sh_testbit(temp, slist, sh.bitmalloc));
-        sh_clearbit(temp, slist, sh.bittable);
-        sh_remove_from_list(temp);
-        OPENSSL_assert(temp != sh.freelist[slist]);
+        OPENSSL_assert(!sh_testbit(a, temp, slist, a->bitmalloc));
+        sh_clearbit(a, temp, slist, a->bittable);
+        sh_remove_from_list(a, temp);
+        OPENSSL_assert(temp != a->freelist[slist]);
 
         /* done with bigger list */
         slist++;
 
         /* add to smaller list */
-        OPENSSL_assert(!sh_testbit(temp, slist, sh.bitmalloc));
-        sh_setbit(temp, slist, sh.bittable);
-        sh_add_to_list(&sh.freelist[slist], temp);
-        OPENSSL_assert(sh.freelist[slist] == temp);
+        OPENSSL_assert(!sh_testbit(a, temp, slist, a->bitmalloc));
+        sh_setbit(a, temp, slist, a->bittable);
+        sh_add_to_list(a, &a->freelist[slist], temp);
+        OPENSSL_assert(a->freelist[slist] == temp);
 
         /* split in 2 */
-        temp += sh.arena_size >> slist;
-        OPENSSL_assert(!sh_testbit(temp, slist, sh.bitmalloc));
-        sh_setbit(temp, slist, sh.bittable);
-        sh_add_to_list(&sh.freelist[slist], temp);
-        OPENSSL_assert(sh.freelist[slist] == temp);
+        temp += a->arena_size >> slist;
+        OPENSSL_assert(!sh_testbit(a, temp, slist, a->bitmalloc));
+        sh_setbit(a, temp, slist, a->bittable);
+        sh_add_to_list(a, &a->freelist[slist], temp);
+        OPENSSL_assert(a->freelist[slist] == temp);
 
-        OPENSSL_assert(temp-(sh.arena_size >> slist) == sh_find_my_buddy(temp, slist));
+        OPENSSL_assert(temp-(a->arena_size >> slist) == sh_find_my_buddy(a, temp, slist));
     }
 
     /* peel off memory to hand back */
-    chunk = sh.freelist[list];
-    OPENSSL_assert(sh_testbit(chunk, list, sh.bittable));
-    sh_setbit(chunk, list, sh.bitmalloc);
-    sh_remove_from_list(chunk);
+    chunk = a->freelist[list];
+    OPENSSL_assert(sh_testbit(a, chunk, list, a->bittable));
+    sh_setbit(a, chunk, list, a->bitmalloc);
+    sh_remove_from_list(a, chunk);
 
-    OPENSSL_assert(WITHIN_ARENA(chunk));
+    OPENSSL_assert(WITHIN_ARENA(a, chunk));
 
     /* zero the free list header as a precaution against information leakage */
     memset(chunk, 0, sizeof(SH_LIST));
@@ -597,32 +644,32 @@ static void *sh_malloc(size_t size)
     return chunk;
 }
 
-static void sh_free(void *ptr)
+static void sh_arena_free(SH_ARENA *a, void *ptr)
 {
     size_t list;
     void *buddy;
 
     if (ptr == NULL)
         return;
-    OPENSSL_assert(WITHIN_ARENA(ptr));
-    if (!WITHIN_ARENA(ptr))
+    OPENSSL_assert(WITHIN_ARENA(a, ptr));
+    if (!WITHIN_ARENA(a, ptr))
         return;
 
-    list = sh_getlist(ptr);
-    OPENSSL_assert(sh_testbit(ptr, list, sh.bittable));
-    sh_clearbit(ptr, list, sh.bitmalloc);
-    sh_add_to_list(&sh.freelist[list], ptr);
+    list = sh_getlist(a, ptr);
+    OPENSSL_assert(sh_testbit(a, ptr, list, a->bittable));
+    sh_clearbit(a, ptr, list, a->bitmalloc);
+    sh_add_to_list(a, &a->freelist[list], ptr);
 
     /* Try to coalesce two adjacent free areas. */
-    while ((buddy = sh_find_my_buddy(ptr, list)) != NULL) {
-        OPENSSL_assert(ptr == sh_find_my_buddy(buddy, list));
+    while ((buddy = sh_find_my_buddy(a, ptr, list)) != NULL) {
+        OPENSSL_assert(ptr == sh_find_my_buddy(a, buddy, list));
         OPENSSL_assert(ptr != NULL);
-        OPENSSL_assert(!sh_testbit(ptr, list, sh.bitmalloc));
-        sh_clearbit(ptr, list, sh.bittable);
-        sh_remove_from_list(ptr);
-        OPENSSL_assert(!sh_testbit(ptr, list, sh.bitmalloc));
-        sh_clearbit(buddy, list, sh.bittable);
-        sh_remove_from_list(buddy);
+        OPENSSL_assert(!sh_testbit(a, ptr, list, a->bitmalloc));
+        sh_clearbit(a, ptr, list, a->bittable);
+        sh_remove_from_list(a, ptr);
+        OPENSSL_assert(!sh_testbit(a, ptr, list, a->bitmalloc));
+        sh_clearbit(a, buddy, list, a->bittable);
+        sh_remove_from_list(a, buddy);
 
         list--;
 
@@ -631,22 +678,121 @@ static void sh_free(void *ptr)
         if (ptr > buddy)
             ptr = buddy;
 
-        OPENSSL_assert(!sh_testbit(ptr, list, sh.bitmalloc));
-        sh_setbit(ptr, list, sh.bittable);
-        sh_add_to_list(&sh.freelist[list], ptr);
-        OPENSSL_assert(sh.freelist[list] == ptr);
+        OPENSSL_assert(!sh_testbit(a, ptr, list, a->bitmalloc));
+        sh_setbit(a, ptr, list, a->bittable);
+        sh_add_to_list(a, &a->freelist[list], ptr);
+        OPENSSL_assert(a->freelist[list] == ptr);
     }
 }
 
-static size_t sh_actual_size(char *ptr)
+static size_t sh_arena_actual_size(SH_ARENA *a, char *ptr)
 {
     int list;
 
-    OPENSSL_assert(WITHIN_ARENA(ptr));
-    if (!WITHIN_ARENA(ptr))
+    OPENSSL_assert(WITHIN_ARENA(a, ptr));
+    if (!WITHIN_ARENA(a, ptr))
+        return 0;
+    list = sh_getlist(a, ptr);
+    OPENSSL_assert(sh_testbit(a, ptr, list, a->bittable));
+    return a->arena_size / (ONE << list);
+}
+
+static SH_ARENA *sh_arena_of(const char *ptr)
+{
+    size_t off = ptr - sh.arena;
+
+    if (off < sh.arenas[0].arena_size)
+        return &sh.arenas[0];
+    return &sh.arenas[1 + (off - sh.arenas[0].arena_size)
+                           / sh.thread_arena_size];
+}
+
+/* The calling thread's arena, assigned round-robin on first use */
+static int sh_home(void)
+{
+    int home = (int)(size_t)CRYPTO_THREAD_get_local(&sh.home);
+
+    if (home <= 0 || home >= sh.narenas) {
+        if (!CRYPTO_atomic_add(&sh.next_home, 1, &home, sh.arenas[0].lock))
+            return 0;
+        home = 1 + (int)((unsigned int)home % (sh.narenas - 1));
+        CRYPTO_THREAD_set_local(&sh.home, (void *)(size_t)home);
+    }
+    return home;
+}
+
+static void *sh_arena_try(SH_ARENA *a, size_t size)
+{
+    char *ret;
+
+    CRYPTO_THREAD_write_lock(a->lock);
+    ret = sh_arena_malloc(a, size);
+    if (ret != NULL)
+        a->used += sh_arena_actual_size(a, ret);
+    CRYPTO_THREAD_unlock(a->lock);
+    return ret;
+}
+
+static void *sh_malloc(size_t size)
+{
+    void *ret;
+    int home, i;
+
+    if (sh.narenas == 1 || size > sh.thread_arena_size)
+        return sh_arena_try(&sh.arenas[0], size);
+
+    home = sh_home();
+    if ((ret = sh_arena_try(&sh.arenas[home], size)) != NULL)
+        return ret;
+    for (i = 0; i < sh.narenas; i++)
+        if (i != home && (ret = sh_arena_try(&sh.arenas[i], size)) != NULL)
+            return ret;
+    return NULL;
+}
+
+static void sh_free(void *ptr)
+{
+    SH_ARENA *a;
+    size_t actual_size;
+
+    if (ptr == NULL)
+        return;
+    OPENSSL_assert(WITHIN_HEAP(ptr));
+    if (!WITHIN_HEAP(ptr))
+        return;
+
+    a = sh_arena_of(ptr);
+    CRYPTO_THREAD_write_lock(a->lock);
+    actual_size = sh_arena_actual_size(a, ptr);
+    CLEAR(ptr, actual_size);
+    a->used -= actual_size;
+    sh_arena_free(a, ptr);
+    CRYPTO_THREAD_unlock(a->lock);
+}
+
+static size_t sh_actual_size(char *ptr)
+{
+    SH_ARENA *a;
+    size_t actual_size;
+
+    OPENSSL_assert(WITHIN_HEAP(ptr));
+    if (!WITHIN_HEAP(ptr))
         return 0;
-    list = sh_getlist(ptr);
-    OPENSSL_assert(sh_testbit(ptr, list, sh.bittable));
-    return sh.arena_size / (ONE << list);
+
+    a = sh_arena_of(ptr);
+    CRYPTO_THREAD_write_lock(a->lock);
+    actual_size = sh_arena_actual_size(a, ptr);
+    CRYPTO_THREAD_unlock(a->lock);
+    return actual_size;
+}
+
+static size_t sh_used(void)
+{
+    size_t used = 0;
+    int i;
+
+    for (i = 0; i < sh.narenas; i++)
+        used += sh.arenas[i].used;
+    return used;
 }
 #endif /* OPENSSL_SECURE_MEMORY */
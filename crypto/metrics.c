@@ -0,0 +1,444 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <openssl/e_os2.h>
+
+#ifdef OPENSSL_NO_METRICS
+NON_EMPTY_TRANSLATION_UNIT
+#else
+
+# include <string.h>
+# include <openssl/crypto.h>
+# include <openssl/err.h>
+# include <openssl/bio.h>
+# include "internal/thread_once.h"
+# include "internal/metrics.h"
+# include "crypto/cryptlib.h"
+# include "crypto/ctype.h"
+
+/*-
+ * The metrics registry. A metric is a named counter or gauge, told apart
+ * from the others of the same name by its labels, and known by the id it
+ * was registered with.
+ *
+ * Every thread that counts gets its own block of values, which only that
+ * thread writes, so counting takes no lock. Reading a metric adds up the
+ * blocks of all the threads under the registry lock, plus what the threads
+ * that have since exited had counted. The values of a block are allocated
+ * in chunks of METRICS_CHUNK, the first time the thread counts into one.
+ */
+# define METRICS_MAX     512
+# define METRICS_CHUNK   64
+
+# if defined(__GNUC__) && defined(__ATOMIC_RELAXED) \
+    && __GCC_ATOMIC_LLONG_LOCK_FREE == 2
+#  define METRIC_LOAD(p)        __atomic_load_n((p), __ATOMIC_RELAXED)
+#  define METRIC_STORE(p, v)    __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+# else
+/* A reader may see a torn value where 64-bit stores aren't atomic */
+#  define METRIC_LOAD(p)        (*(p))
+#  define METRIC_STORE(p, v)    (*(p) = (v))
+# endif
+
+typedef struct {
+    char *name;
+    char *labels;
+    char *help;
+    int type;
+} METRIC;
+
+typedef struct metrics_thread_st {
+    int64_t *chunk[METRICS_MAX / METRICS_CHUNK];
+    struct metrics_thread_st *next;
+} METRICS_THREAD;
+
+/* The metrics of include/internal/metrics.h, in the order of their ids */
+static const struct {
+    const char *name;
+    const char *labels;
+    int type;
+    const char *help;
+} builtin_metrics[] = {
+    {"openssl_ssl_session_cache_hits_total", NULL, OPENSSL_METRIC_COUNTER,
+     "Sessions resumed from a session cache"},
+    {"openssl_ssl_session_cache_misses_total", NULL, OPENSSL_METRIC_COUNTER,
+     "Sessions looked up in a session cache and not found there"},
+    {"openssl_ssl_session_cache_evictions_total", NULL,
+     OPENSSL_METRIC_COUNTER,
+     "Sessions removed from a session cache that was full, or as expired"},
+    {"openssl_x509_store_lookup_hits_total", NULL, OPENSSL_METRIC_COUNTER,
+     "X509_STORE lookups answered from the objects in the store"},
+    {"openssl_x509_store_lookup_misses_total", NULL, OPENSSL_METRIC_COUNTER,
+     "X509_STORE lookups passed on to the lookup methods"},
+    {"openssl_rand_drbg_reseeds_total", NULL, OPENSSL_METRIC_COUNTER,
+     "DRBG reseeds"},
+    {"openssl_async_pool_hits_total", NULL, OPENSSL_METRIC_COUNTER,
+     "ASYNC jobs started with a job from the thread's pool"},
+    {"openssl_async_pool_misses_total", NULL, OPENSSL_METRIC_COUNTER,
+     "ASYNC jobs started with a newly created job"},
+    {"openssl_async_pool_exhausted_total", NULL, OPENSSL_METRIC_COUNTER,
+     "ASYNC jobs not started as the thread's pool was at its maximum size"},
+    {"openssl_async_jobs", NULL, OPENSSL_METRIC_GAUGE,
+     "ASYNC jobs in existence, running or pooled"},
+    {"openssl_oqs_operations_total", "op=\"sign\"", OPENSSL_METRIC_COUNTER,
+     "liboqs operations"},
+    {"openssl_oqs_operation_nanoseconds_total", "op=\"sign\"",
+     OPENSSL_METRIC_COUNTER, "Wall time spent in liboqs operations"},
+    {"openssl_oqs_operations_total", "op=\"verify\"", OPENSSL_METRIC_COUNTER,
+     NULL},
+    {"openssl_oqs_operation_nanoseconds_total", "op=\"verify\"",
+     OPENSSL_METRIC_COUNTER, NULL},
+    {"openssl_oqs_operations_total", "op=\"keypair\"",
+     OPENSSL_METRIC_COUNTER, NULL},
+    {"openssl_oqs_operation_nanoseconds_total", "op=\"keypair\"",
+     OPENSSL_METRIC_COUNTER, NULL},
+    {"openssl_oqs_operations_total", "op=\"encaps\"", OPENSSL_METRIC_COUNTER,
+     NULL},
+    {"openssl_oqs_operation_nanoseconds_total", "op=\"encaps\"",
+     OPENSSL_METRIC_COUNTER, NULL},
+    {"openssl_oqs_operations_total", "op=\"decaps\"", OPENSSL_METRIC_COUNTER,
+     NULL},
+    {"openssl_oqs_operation_nanoseconds_total", "op=\"decaps\"",
+     OPENSSL_METRIC_COUNTER, NULL},
+};
+
+typedef char builtin_metrics_complete[OSSL_NELEM(builtin_metrics)
+                                      == OSSL_METRIC_BUILTIN_END - 1 ? 1 : -1];
+
+static CRYPTO_ONCE metrics_once = CRYPTO_ONCE_STATIC_INIT;
+static int metrics_inited = 0;
+static int metrics_stopped = 0;
+static CRYPTO_RWLOCK *metrics_lock;
+static CRYPTO_THREAD_LOCAL metrics_key;
+
+/* The rest is protected by metrics_lock; id 0 is never handed out */
+static METRIC metrics[METRICS_MAX];
+static size_t metrics_num = 1;
+static METRICS_THREAD *metrics_threads;
+/* What the threads that exited had counted */
+static int64_t metrics_retired[METRICS_MAX];
+
+static int metric_name_valid(const char *name)
+{
+    const char *p;
+
+    if (name == NULL || *name == '\0' || ossl_isdigit(*name))
+        return 0;
+    for (p = name; *p != '\0'; p++)
+        if (!ossl_isalnum(*p) && *p != '_' && *p != ':')
+            return 0;
+    return 1;
+}
+
+static int labels_equal(const char *a, const char *b)
+{
+    if (a == NULL || b == NULL)
+        return a == b;
+    return strcmp(a, b) == 0;
+}
+
+/* Requires metrics_lock to be locked for write, unless still initialising */
+static int metric_register(const char *name, const char *labels, int type,
+                           const char *help)
+{
+    METRIC *m;
+    size_t i;
+
+    for (i = 1; i < metrics_num; i++) {
+        if (strcmp(metrics[i].name, name) != 0)
+            continue;
+        if (metrics[i].type != type) {
+            CRYPTOerr(CRYPTO_F_OPENSSL_METRIC_REGISTER,
+                      CRYPTO_R_INVALID_METRIC);
+            return 0;
+        }
+        if (labels_equal(metrics[i].labels, labels))
+            return (int)i;
+    }
+    if (metrics_num == METRICS_MAX) {
+        CRYPTOerr(CRYPTO_F_OPENSSL_METRIC_REGISTER, CRYPTO_R_TOO_MANY_METRICS);
+        return 0;
+    }
+
+    m = &metrics[metrics_num];
+    m->type = type;
+    if ((m->name = OPENSSL_strdup(name)) == NULL
+            || (labels != NULL
+                && (m->labels = OPENSSL_strdup(labels)) == NULL)
+            || (help != NULL && (m->help = OPENSSL_strdup(help)) == NULL)) {
+        CRYPTOerr(CRYPTO_F_OPENSSL_METRIC_REGISTER, ERR_R_MALLOC_FAILURE);
+        OPENSSL_free(m->name);
+        OPENSSL_free(m->labels);
+        memset(m, 0, sizeof(*m));
+        return 0;
+    }
+    return (int)metrics_num++;
+}
+
+static void metrics_thread_free(METRICS_THREAD *t)
+{
+    size_t i;
+
+    for (i = 0; i < OSSL_NELEM(t->chunk); i++)
+        OPENSSL_free(t->chunk[i]);
+    OPENSSL_free(t);
+}
+
+/* Called when a thread exits, to keep what it counted */
+static void metrics_thread_retire(void *arg)
+{
+    METRICS_THREAD *t = arg, **p;
+    size_t i, j;
+
+    if (t == NULL || !CRYPTO_THREAD_write_lock(metrics_lock))
+        return;
+    for (i = 0; i < OSSL_NELEM(t->chunk); i++) {
+        if (t->chunk[i] == NULL)
+            continue;
+        for (j = 0; j < METRICS_CHUNK; j++)
+            metrics_retired[i * METRICS_CHUNK + j] += t->chunk[i][j];
+    }
+    for (p = &metrics_threads; *p != NULL; p = &(*p)->next) {
+        if (*p == t) {
+            *p = t->next;
+            break;
+        }
+    }
+    CRYPTO_THREAD_unlock(metrics_lock);
+    metrics_thread_free(t);
+}
+
+DEFINE_RUN_ONCE_STATIC(do_metrics_init)
+{
+    size_t i;
+
+    if ((metrics_lock = CRYPTO_THREAD_lock_new()) == NULL)
+        return 0;
+    if (!CRYPTO_THREAD_init_local(&metrics_key, metrics_thread_retire)) {
+        CRYPTO_THREAD_lock_free(metrics_lock);
+        metrics_lock = NULL;
+        return 0;
+    }
+    for (i = 0; i < OSSL_NELEM(builtin_metrics); i++) {
+        if (!metric_register(builtin_metrics[i].name,
+                             builtin_metrics[i].labels,
+                             builtin_metrics[i].type,
+                             builtin_metrics[i].help))
+            return 0;
+    }
+    metrics_inited = 1;
+    return 1;
+}
+
+static int metrics_init(void)
+{
+    return !metrics_stopped && RUN_ONCE(&metrics_once, do_metrics_init)
+           && metrics_inited;
+}
+
+int OPENSSL_metric_register(const char *name, const char *labels, int type,
+                            const char *help)
+{
+    int id;
+
+    if (!metrics_init())
+        return 0;
+    if (!metric_name_valid(name)
+            || (type != OPENSSL_METRIC_COUNTER && type != OPENSSL_METRIC_GAUGE)
+            || (help != NULL && strchr(help, '\n') != NULL)) {
+        CRYPTOerr(CRYPTO_F_OPENSSL_METRIC_REGISTER, CRYPTO_R_INVALID_METRIC);
+        return 0;
+    }
+    if (labels != NULL && *labels == '\0')
+        labels = NULL;
+
+    if (!CRYPTO_THREAD_write_lock(metrics_lock))
+        return 0;
+    id = metric_register(name, labels, type, help);
+    CRYPTO_THREAD_unlock(metrics_lock);
+    return id;
+}
+
+static int64_t *metrics_chunk_new(METRICS_THREAD *t, size_t i)
+{
+    int64_t *chunk = OPENSSL_zalloc(METRICS_CHUNK * sizeof(*chunk));
+
+    if (chunk == NULL)
+        return NULL;
+    /* Readers walk the chunks of every thread */
+    if (!CRYPTO_THREAD_write_lock(metrics_lock)) {
+        OPENSSL_free(chunk);
+        return NULL;
+    }
+    t->chunk[i] = chunk;
+    CRYPTO_THREAD_unlock(metrics_lock);
+    return chunk;
+}
+
+static METRICS_THREAD *metrics_thread_new(void)
+{
+    METRICS_THREAD *t = OPENSSL_zalloc(sizeof(*t));
+
+    if (t == NULL)
+        return NULL;
+    if (!CRYPTO_THREAD_set_local(&metrics_key, t)) {
+        OPENSSL_free(t);
+        return NULL;
+    }
+    if (!CRYPTO_THREAD_write_lock(metrics_lock)) {
+        CRYPTO_THREAD_set_local(&metrics_key, NULL);
+        OPENSSL_free(t);
+        return NULL;
+    }
+    t->next = metrics_threads;
+    metrics_threads = t;
+    CRYPTO_THREAD_unlock(metrics_lock);
+    return t;
+}
+
+void OPENSSL_metric_add(int id, int64_t n)
+{
+    METRICS_THREAD *t;
+    int64_t *v;
+
+    if (id <= 0 || id >= METRICS_MAX || !metrics_init())
+        return;
+    if ((t = CRYPTO_THREAD_get_local(&metrics_key)) == NULL
+            && (t = metrics_thread_new()) == NULL)
+        return;
+    if ((v = t->chunk[id / METRICS_CHUNK]) == NULL
+            && (v = metrics_chunk_new(t, id / METRICS_CHUNK)) == NULL)
+        return;
+    v += id % METRICS_CHUNK;
+    /* Only this thread writes to its block */
+    METRIC_STORE(v, *v + n);
+}
+
+/*
+ * Returns the current values of the first |*num| metrics, index 0 unused.
+ * The METRIC entries below |*num| don't change any more, they can be read
+ * without the lock.
+ */
+static int64_t *metrics_snapshot(size_t *num)
+{
+    METRICS_THREAD *t;
+    int64_t *values;
+    size_t i, j;
+
+    if (!metrics_init())
+        return NULL;
+    if ((values = OPENSSL_malloc(METRICS_MAX * sizeof(*values))) == NULL)
+        return NULL;
+    if (!CRYPTO_THREAD_read_lock(metrics_lock)) {
+        OPENSSL_free(values);
+        return NULL;
+    }
+    *num = metrics_num;
+    memcpy(values, metrics_retired, sizeof(metrics_retired));
+    for (t = metrics_threads; t != NULL; t = t->next) {
+        for (i = 0; i < OSSL_NELEM(t->chunk); i++) {
+            if (t->chunk[i] == NULL)
+                continue;
+            for (j = 0; j < METRICS_CHUNK; j++)
+                values[i * METRICS_CHUNK + j] +=
+                    METRIC_LOAD(&t->chunk[i][j]);
+        }
+    }
+    CRYPTO_THREAD_unlock(metrics_lock);
+    return values;
+}
+
+int OPENSSL_metrics_do_all(OPENSSL_METRIC_CB cb, void *arg)
+{
+    int64_t *values;
+    size_t i, num;
+    int ret = 1;
+
+    if ((values = metrics_snapshot(&num)) == NULL)
+        return 0;
+    for (i = 1; i < num; i++) {
+        if (!cb(metrics[i].name, metrics[i].labels, metrics[i].type,
+                metrics[i].help, values[i], arg)) {
+            ret = 0;
+            break;
+        }
+    }
+    OPENSSL_free(values);
+    return ret;
+}
+
+/*
+ * Prints the metrics in the Prometheus text exposition format, the metrics
+ * of the same name together under one HELP and TYPE.
+ */
+int OPENSSL_metrics_print(BIO *bio)
+{
+    int64_t *values;
+    unsigned char done[METRICS_MAX];
+    const char *help;
+    size_t i, j, num;
+    int ret = 0;
+
+    if ((values = metrics_snapshot(&num)) == NULL)
+        return 0;
+    memset(done, 0, sizeof(done));
+    for (i = 1; i < num; i++) {
+        if (done[i])
+            continue;
+        for (help = NULL, j = i; j < num && help == NULL; j++)
+            if (strcmp(metrics[j].name, metrics[i].name) == 0)
+                help = metrics[j].help;
+        if ((help != NULL
+             && BIO_printf(bio, "# HELP %s %s\n", metrics[i].name, help) <= 0)
+                || BIO_printf(bio, "# TYPE %s %s\n", metrics[i].name,
+                              metrics[i].type == OPENSSL_METRIC_GAUGE
+                              ? "gauge" : "counter") <= 0)
+            goto end;
+        for (j = i; j < num; j++) {
+            if (done[j] || strcmp(metrics[j].name, metrics[i].name) != 0)
+                continue;
+            done[j] = 1;
+            if (BIO_printf(bio, "%s%s%s%s %lld\n", metrics[j].name,
+                           metrics[j].labels != NULL ? "{" : "",
+                           metrics[j].labels != NULL ? metrics[j].labels : "",
+                           metrics[j].labels != NULL ? "}" : "",
+                           (long long)values[j]) <= 0)
+                goto end;
+        }
+    }
+    ret = 1;
+ end:
+    OPENSSL_free(values);
+    return ret;
+}
+
+void metrics_cleanup_int(void)
+{
+    METRICS_THREAD *t;
+    size_t i;
+
+    metrics_stopped = 1;
+    if (!metrics_inited)
+        return;
+    CRYPTO_THREAD_cleanup_local(&metrics_key);
+    while ((t = metrics_threads) != NULL) {
+        metrics_threads = t->next;
+        metrics_thread_free(t);
+    }
+    for (i = 1; i < metrics_num; i++) {
+        OPENSSL_free(metrics[i].name);
+        OPENSSL_free(metrics[i].labels);
+        OPENSSL_free(metrics[i].help);
+    }
+    metrics_num = 1;
+    CRYPTO_THREAD_lock_free(metrics_lock);
+    metrics_lock = NULL;
+    metrics_inited = 0;
+}
+#endif
@@ -0,0 +1,321 @@
+#! /usr/bin/env perl
+# Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+#
+# Licensed under the OpenSSL license (the "License").  You may not use
+# this file except in compliance with the License.  You can obtain a copy
+# in the file LICENSE in the source distribution or at
+# https://www.openssl.org/source/license.html
+
+#
+# AES-GCM for ARMv8 with Crypto Extensions, "stitched" counterpart of
+# aesni-gcm-x86_64.pl.
+#
+# CRYPTO_gcm128_[en|de]crypt_ctr32 make two passes over every chunk,
+# aes_v8_ctr32_encrypt_blocks and then gcm_ghash_v8, and neither pass
+# keeps both the AES and the PMULL pipelines busy. Here each iteration
+# runs the AES rounds of four counter blocks interleaved with the
+# 4x-aggregated GHASH of four blocks of cipher text, the ones being
+# decrypted or the ones encrypted by the previous iteration. Four is
+# what the key schedule and powers of H up to H^4 precomputed by
+# gcm_init_v8 leave room for in the register bank: all of it is used,
+# round keys 0-8 and the last two are resident and only the extra
+# rounds of 192- and 256-bit keys reload theirs.
+#
+# The module is endian-neutral: data and Xi are loaded byte-wise and
+# the counter is assembled from general purpose registers, so no
+# __ARMEB__ conditionals are needed.
+#
+# size_t armv8_aes_gcm_[en|de]crypt(const void *inp, void *out,
+#                                   size_t len, const AES_KEY *key,
+#                                   unsigned char ivec[16], u64 Xi[2]);
+#
+# Processes len rounded down to a multiple of 64 bytes and returns the
+# amount processed. |ivec| is the next counter block and is updated,
+# Xi is followed by H and the Htable filled in by gcm_init_v8, as in
+# GCM128_CONTEXT.
+
+$flavour = shift;
+while (($output=shift) && ($output!~/\w[\w\-]*\.\w+$/)) {}
+
+$0 =~ m/(.*[\/\\])[^\/\\]+$/; $dir=$1;
+( $xlate="${dir}arm-xlate.pl" and -f $xlate ) or
+( $xlate="${dir}../../perlasm/arm-xlate.pl" and -f $xlate) or
+die "can't locate arm-xlate.pl";
+
+open OUT,"| \"$^X\" $xlate $flavour $output";
+*STDOUT=*OUT;
+
+my ($inp,$out,$len,$key,$ivp,$Xi)=map("x$_",(0..5));
+my ($Htbl,$rounds,$ctr_lo,$ctr_hi,$ctr,$tctr,$ret,$key_mid,$ptr)=
+	("x6","w7","x8","x9","w10","x11","x12","x13","x14");
+my ($wctr_hi,$xctr,$wtctr)=("w9","x10","w11");
+
+my @S=map("v$_",(0..3));		# AES states
+my @D=map("v$_",(4..7));		# data blocks
+my @rk=map("v$_",(8..16));		# round keys 0-8
+my ($rk_m1,$rk_last,$rk_mid)=map("v$_",(17..19));
+my ($xC2,$H,$Hhl,$H2,$H3,$H34,$H4)=map("v$_",(20..26));
+my ($Xl,$Xm,$Xh,$T,$P)=map("v$_",(27..31));
+
+# Fill the four counter blocks and advance the counter
+sub ctr_blocks {
+my $code="";
+    for (my $i=0; $i<4; $i++) {
+	$code.=<<___;
+	rev	$wtctr,$ctr
+	add	$ctr,$ctr,#1
+	orr	$tctr,$ctr_hi,$tctr,lsl#32
+	fmov	d$i,$ctr_lo
+	mov	$S[$i].d[1],$tctr
+___
+    }
+    return $code;
+}
+
+# AES rounds 0-8 of the four states, as a list of aese/aesmc pairs
+sub aes_rounds_0_8 {
+my @list;
+    for (my $r=0; $r<9; $r++) {
+	for (my $i=0; $i<4; $i++) {
+	    push @list,"aese	$S[$i].16b,$rk[$r].16b\n".
+		       "\taesmc	$S[$i].16b,$S[$i].16b";
+	}
+    }
+    return @list;
+}
+
+# GHASH of the four data blocks into Xi, kept "rotated" in $Xl
+sub ghash_4x {
+my @list=(
+	"rev64	$D[0].16b,$D[0].16b",
+	"rev64	$D[1].16b,$D[1].16b",
+	"rev64	$D[2].16b,$D[2].16b",
+	"rev64	$D[3].16b,$D[3].16b",
+	"eor	$D[0].16b,$D[0].16b,$Xl.16b",
+
+	"ext	$T.16b,$D[0].16b,$D[0].16b,#8",	# H^4·(Xi+Ii)
+	"pmull	$Xl.1q,$H4.1d,$T.1d",
+	"eor	$D[0].16b,$D[0].16b,$T.16b",
+	"pmull2	$Xh.1q,$H4.2d,$T.2d",
+	"pmull2	$Xm.1q,$H34.2d,$D[0].2d");
+
+    foreach (([1,$H3,$H34,"pmull"],[2,$H2,$Hhl,"pmull2"],[3,$H,$Hhl,"pmull"])) {
+	my ($i,$Hn,$Hk,$mul)=@$_;
+	my $lane = $mul eq "pmull" ? "1d" : "2d";
+
+	push @list,
+	"ext	$T.16b,$D[$i].16b,$D[$i].16b,#8",
+	"pmull	$P.1q,$Hn.1d,$T.1d",
+	"eor	$D[$i].16b,$D[$i].16b,$T.16b",
+	"eor	$Xl.16b,$Xl.16b,$P.16b",
+	"pmull2	$P.1q,$Hn.2d,$T.2d",
+	"eor	$Xh.16b,$Xh.16b,$P.16b",
+	"$mul	$P.1q,$Hk.$lane,$D[$i].$lane",
+	"eor	$Xm.16b,$Xm.16b,$P.16b";
+    }
+
+    push @list,
+	"ext	$T.16b,$Xl.16b,$Xh.16b,#8",	# Karatsuba post-processing
+	"eor	$P.16b,$Xl.16b,$Xh.16b",
+	"eor	$Xm.16b,$Xm.16b,$T.16b",
+	"eor	$Xm.16b,$Xm.16b,$P.16b",
+	"pmull	$P.1q,$Xl.1d,$xC2.1d",		# 1st phase of reduction
+	"ins	$Xh.d[0],$Xm.d[1]",
+	"ins	$Xm.d[1],$Xl.d[0]",
+	"eor	$Xl.16b,$Xm.16b,$P.16b",
+	"ext	$P.16b,$Xl.16b,$Xl.16b,#8",	# 2nd phase of reduction
+	"pmull	$Xl.1q,$Xl.1d,$xC2.1d",
+	"eor	$P.16b,$P.16b,$Xh.16b",
+	"eor	$Xl.16b,$Xl.16b,$P.16b",
+	"ext	$Xl.16b,$Xl.16b,$Xl.16b,#8";
+
+    return @list;
+}
+
+# Interleave two instruction lists, spreading the second over the first
+sub stitch {
+my ($aes,$ghash)=@_;
+my ($code,$n,$m)=("",scalar(@$aes),scalar(@$ghash));
+my $j=0;
+
+    for (my $i=0; $i<$n; $i++) {
+	$code.="\t$$aes[$i]\n";
+	while ($j < $m && $j*$n < ($i+1)*$m) {
+	    $code.="\t $$ghash[$j++]\n";
+	}
+    }
+    $code.="\t $$ghash[$j++]\n" while ($j < $m);
+    return $code;
+}
+
+# Remaining rounds, and the cipher text or plain text of |$inp| xored
+# with the key stream to |$out|
+sub aes_final {
+my $sfx=shift;
+my $code="";
+
+    $code.=<<___;
+	cmp	$rounds,#12
+	b.lo	.L${sfx}_last
+	mov	$ptr,$key_mid
+___
+    foreach my $lbl ("", "b.eq	.L${sfx}_last") {
+	$code.="\t$lbl\n" if ($lbl ne "");
+	for (my $r=0; $r<2; $r++) {
+	    $code.="\tld1	{$rk_mid.4s},[$ptr],#16\n";
+	    for (my $i=0; $i<4; $i++) {
+		$code.="\taese	$S[$i].16b,$rk_mid.16b\n".
+		       "\taesmc	$S[$i].16b,$S[$i].16b\n";
+	    }
+	}
+    }
+    $code.=<<___;
+.L${sfx}_last:
+	ld1	{$D[0].16b-$D[3].16b},[$inp],#64
+___
+    for (my $i=0; $i<4; $i++) {
+	$code.=<<___;
+	aese	$S[$i].16b,$rk_m1.16b
+	eor	$D[$i].16b,$D[$i].16b,$rk_last.16b
+___
+    }
+    for (my $i=0; $i<4; $i++) {
+	$code.="\teor	$D[$i].16b,$D[$i].16b,$S[$i].16b\n";
+    }
+    $code.="\tst1	{$D[0].16b-$D[3].16b},[$out],#64\n";
+    return $code;
+}
+
+$code=<<___;
+#include "arm_arch.h"
+
+#if __ARM_MAX_ARCH__>=7
+.text
+.arch	armv8-a+crypto
+___
+
+foreach my $dir ("en", "de") {
+my $pfx = ".L${dir}c";
+
+$code.=<<___;
+.globl	armv8_aes_gcm_${dir}crypt
+.type	armv8_aes_gcm_${dir}crypt,%function
+.align	5
+armv8_aes_gcm_${dir}crypt:
+	ands	$len,$len,#-64
+	b.ne	${pfx}_begin
+	mov	x0,#0
+	ret
+
+.align	4
+${pfx}_begin:
+	stp	x29,x30,[sp,#-80]!
+	add	x29,sp,#0
+	stp	d8,d9,[sp,#16]		// ABI spec says so
+	stp	d10,d11,[sp,#32]
+	stp	d12,d13,[sp,#48]
+	stp	d14,d15,[sp,#64]
+
+	ldr	$rounds,[$key,#240]
+	mov	$ptr,$key
+	ld1	{$rk[0].4s-$rk[3].4s},[$ptr],#64	// load key schedule...
+	ld1	{$rk[4].4s-$rk[7].4s},[$ptr],#64
+	ld1	{$rk[8].4s},[$ptr],#16
+	mov	$key_mid,$ptr
+	add	$ptr,$key,x7,lsl#4
+	sub	$ptr,$ptr,#16
+	ld1	{$rk_m1.4s-$rk_last.4s},[$ptr]
+
+	add	$Htbl,$Xi,#32
+	ld1	{$H.2d-$H2.2d},[$Htbl],#48		// load twisted H, ..., H^2
+	movi	$xC2.16b,#0xe1
+	ld1	{$H3.2d-$H4.2d},[$Htbl]		// load twisted H^3, ..., H^4
+	shl	$xC2.2d,$xC2.2d,#57			// compose 0xc2.0 constant
+	ld1	{$Xl.16b},[$Xi]
+	rev64	$Xl.16b,$Xl.16b			// rotated Xi
+
+	ld1	{$S[0].16b},[$ivp]
+	mov	$ret,$len
+	umov	$ctr_lo,$S[0].d[0]
+	umov	$ctr_hi,$S[0].d[1]
+	lsr	$xctr,$ctr_hi,#32
+	mov	$wctr_hi,$wctr_hi			// fixed part of the counter block
+	rev	$ctr,$ctr
+___
+
+if ($dir eq "en") {
+    # The first four blocks are only encrypted, the GHASH of the
+    # cipher text of each iteration is done during the next one, and
+    # the one of the last blocks after the loop.
+    my @aes = aes_rounds_0_8();
+
+    $code.=ctr_blocks();
+    $code.="\t$_\n" foreach (@aes);
+    $code.=aes_final("enc_first");
+    $code.=<<___;
+	subs	$len,$len,#64
+	b.eq	${pfx}_tail
+
+.align	4
+${pfx}_loop:
+___
+    $code.=ctr_blocks();
+    $code.=stitch(\@aes,[ghash_4x()]);
+    $code.=aes_final("enc");
+    $code.=<<___;
+	subs	$len,$len,#64
+	b.ne	${pfx}_loop
+
+${pfx}_tail:
+___
+    $code.="\t$_\n" foreach (ghash_4x());
+} else {
+    # The cipher text is known up front, it is hashed in the iteration
+    # that decrypts it and loaded again to be xored with the key stream.
+    my @aes = aes_rounds_0_8();
+
+    $code.=<<___;
+
+.align	4
+${pfx}_loop:
+	ld1	{$D[0].16b-$D[3].16b},[$inp]
+___
+    $code.=ctr_blocks();
+    $code.=stitch(\@aes,[ghash_4x()]);
+    $code.=aes_final("dec");
+    $code.=<<___;
+	subs	$len,$len,#64
+	b.ne	${pfx}_loop
+___
+}
+
+$code.=<<___;
+
+	rev64	$Xl.16b,$Xl.16b
+	rev	$wtctr,$ctr
+	st1	{$Xl.16b},[$Xi]			// write out Xi
+	orr	$tctr,$ctr_hi,$tctr,lsl#32
+	fmov	d0,$ctr_lo
+	mov	$S[0].d[1],$tctr
+	st1	{$S[0].16b},[$ivp]			// write out counter
+
+	mov	x0,$ret
+	ldp	d8,d9,[sp,#16]
+	ldp	d10,d11,[sp,#32]
+	ldp	d12,d13,[sp,#48]
+	ldp	d14,d15,[sp,#64]
+	ldp	x29,x30,[sp],#80
+	ret
+.size	armv8_aes_gcm_${dir}crypt,.-armv8_aes_gcm_${dir}crypt
+___
+}
+
+$code.=<<___;
+.asciz	"AES-GCM for ARMv8"
+.align	2
+#endif
+___
+
+print $code;
+
+close STDOUT or die "error closing STDOUT: $!"; # enforce flush
@@ -54,6 +54,7 @@ die "can't locate x86_64-xlate.pl";
 if (`$ENV{CC} -Wa,-v -c -o /dev/null -x assembler /dev/null 2>&1`
 		=~ /GNU assembler version ([2-9]\.[0-9]+)/) {
 	$avx = ($1>=2.20) + ($1>=2.22);
+	$vaes = ($1>=2.30);
 }
 
 if (!$avx && $win64 && ($flavour =~ /nasm/ || $ENV{ASM} =~ /nasm/) &&
@@ -68,8 +69,11 @@ if (!$avx && $win64 && ($flavour =~ /masm/ || $ENV{ASM} =~ /ml64/) &&
 
 if (!$avx && `$ENV{CC} -v 2>&1` =~ /((?:clang|LLVM) version|.*based on LLVM) ([0-9]+\.[0-9]+)/) {
 	$avx = ($2>=3.0) + ($2>3.0);
+	$vaes = ($2>=6.0);
 }
 
+$vaes = 0 if ($win64);	# no SEH handler for the VAES path
+
 open OUT,"| \"$^X\" \"$xlate\" $flavour \"$output\"";
 *STDOUT=*OUT;
 
@@ -86,6 +90,11 @@ if ($avx>1) {{{
 
 $code=<<___;
 .text
+___
+$code.=<<___ if ($vaes);
+.extern	OPENSSL_ia32cap_P
+___
+$code.=<<___;
 
 .type	_aesni_ctr32_ghash_6x,\@abi-omnipotent
 .align	32
@@ -413,6 +422,18 @@ $code.=<<___;
 aesni_gcm_decrypt:
 .cfi_startproc
 	xor	$ret,$ret
+___
+$code.=<<___ if ($vaes);
+	cmp	\$0x100,$len
+	jb	.Lgcm_dec_avx
+	mov	OPENSSL_ia32cap_P+8(%rip),%r11
+	mov	\$`1<<16|1<<30|1<<31|1<<(32+9)|1<<(32+10)`,%rax
+	and	%rax,%r11			# AVX512F+BW+VL+VAES+VPCLMULQDQ
+	cmp	%rax,%r11
+	je	_aesni_gcm_decrypt_vaes
+.Lgcm_dec_avx:
+___
+$code.=<<___;
 	cmp	\$0x60,$len			# minimal accepted length
 	jb	.Lgcm_dec_abort
 
@@ -641,6 +662,18 @@ _aesni_ctr32_6x:
 aesni_gcm_encrypt:
 .cfi_startproc
 	xor	$ret,$ret
+___
+$code.=<<___ if ($vaes);
+	cmp	\$0x100,$len
+	jb	.Lgcm_enc_avx
+	mov	OPENSSL_ia32cap_P+8(%rip),%r11
+	mov	\$`1<<16|1<<30|1<<31|1<<(32+9)|1<<(32+10)`,%rax
+	and	%rax,%r11			# AVX512F+BW+VL+VAES+VPCLMULQDQ
+	cmp	%rax,%r11
+	je	_aesni_gcm_encrypt_vaes
+.Lgcm_enc_avx:
+___
+$code.=<<___;
 	cmp	\$0x60*3,$len			# minimal accepted length
 	jb	.Lgcm_enc_abort
 
@@ -940,6 +973,262 @@ $code.=<<___;
 .size	aesni_gcm_encrypt,.-aesni_gcm_encrypt
 ___
 
+if ($vaes) {{
+######################################################################
+#
+# VAES/VPCLMULQDQ path for Ice Lake and later: 16 blocks per iteration,
+# four per zmm register. CTR is computed in the bit-reflected domain
+# so that a plain vpaddd bumps the 32-bit counter, and the ciphertext
+# of each iteration is hashed with H^16..H^1 derived on entry from the
+# H^1..H^8 laid down by gcm_init_avx. The entry points above divert
+# here for 256 bytes or more; the caller finishes the rest.
+#
+my @S=map("%zmm$_",(0..3));
+my @G=map("%zmm$_",(4..7));
+my ($Lo,$Hi,$Mid,$Tz,$Xz,$Ctr,$Four,$Tz2)=map("%zmm$_",(8..15));
+my @rk=map("%zmm$_",(16..29));
+my ($rklast,$Bswap)=("%zmm30","%zmm31");
+my ($rounds16,$Htbl)=("%r10d","%r10");	# one after the other
+my $lbl=0;
+
+sub xmm { my $r=shift; $r=~s/zmm/xmm/; $r; }
+sub ymm { my $r=shift; $r=~s/zmm/ymm/; $r; }
+my ($xXi,$xCtr,$xBswap)=(xmm($Xz),xmm($Ctr),xmm($Bswap));
+
+# Montgomery-style reduction of 256-bit $hi:$lo in each 128-bit lane
+# (same as reduction_avx in ghash-x86_64.pl), result in $dst.
+sub vaes_reduce {
+my ($hi,$lo,$t1,$t2,$dst)=@_;
+return (
+	"vpsllq	\$57,$lo,$t1",
+	"vpsllq	\$62,$lo,$t2",
+	"vpxorq	$t1,$t2,$t2",
+	"vpsllq	\$63,$lo,$t1",
+	"vpxorq	$t1,$t2,$t2",
+	"vpslldq	\$8,$t2,$t1",
+	"vpsrldq	\$8,$t2,$t2",
+	"vpxorq	$t1,$lo,$lo",
+	"vpxorq	$t2,$hi,$hi",
+	"vpsrlq	\$1,$lo,$t2",
+	"vpxorq	$lo,$hi,$hi",
+	"vpxorq	$t2,$lo,$lo",
+	"vpsrlq	\$5,$t2,$t2",
+	"vpxorq	$t2,$lo,$lo",
+	"vpsrlq	\$1,$lo,$lo",
+	"vpxorq	$hi,$lo,$dst");
+}
+
+# GHASH of the 16 byte-swapped blocks in @G into $Xz
+sub vaes_ghash_16x {
+my @i=("vpxorq	$Xz,$G[0],$G[0]");
+    for my $k (0..3) {
+	my $h=sprintf("0x%02x(%%rsp)",64*$k);
+	if ($k==0) {
+	    push @i,"vpclmulqdq	\$0x00,$h,$G[0],$Lo",
+		    "vpclmulqdq	\$0x11,$h,$G[0],$Hi",
+		    "vpclmulqdq	\$0x01,$h,$G[0],$Mid",
+		    "vpclmulqdq	\$0x10,$h,$G[0],$Tz",
+		    "vpxorq	$Tz,$Mid,$Mid";
+	} else {
+	    push @i,"vpclmulqdq	\$0x00,$h,$G[$k],$Tz",
+		    "vpclmulqdq	\$0x11,$h,$G[$k],$Tz2",
+		    "vpxorq	$Tz,$Lo,$Lo",
+		    "vpxorq	$Tz2,$Hi,$Hi",
+		    "vpclmulqdq	\$0x01,$h,$G[$k],$Tz",
+		    "vpclmulqdq	\$0x10,$h,$G[$k],$Tz2",
+		    "vpternlogq	\$0x96,$Tz2,$Tz,$Mid";
+	}
+    }
+    push @i,"vpslldq	\$8,$Mid,$Tz",
+	    "vpsrldq	\$8,$Mid,$Mid",
+	    "vpxorq	$Tz,$Lo,$Lo",
+	    "vpxorq	$Mid,$Hi,$Hi",
+	    "vextracti64x4	\$1,$Lo,".ymm($Tz),
+	    "vextracti64x4	\$1,$Hi,".ymm($Tz2),
+	    "vpxorq	".ymm($Tz).",".ymm($Lo).",".ymm($Lo),
+	    "vpxorq	".ymm($Tz2).",".ymm($Hi).",".ymm($Hi),
+	    "vextracti32x4	\$1,".ymm($Lo).",".xmm($Tz),
+	    "vextracti32x4	\$1,".ymm($Hi).",".xmm($Tz2),
+	    "vpxorq	".xmm($Tz).",".xmm($Lo).",".xmm($Lo),
+	    "vpxorq	".xmm($Tz2).",".xmm($Hi).",".xmm($Hi),
+	    &vaes_reduce(xmm($Hi),xmm($Lo),xmm($Tz),xmm($Tz2),xmm($Xz));
+    return @i;
+}
+
+# CTR-encrypt the next 16 counter blocks into @S, interleaving @_
+sub vaes_ctr_16x {
+my @gh=@_;
+my $per=int((@gh+8)/9);
+my $last=".Lvaes_last".$lbl++;
+
+    $code.=<<___;
+	vpaddd		$Four,$Ctr,$S[1]
+	vpshufb		$Bswap,$Ctr,$S[0]
+	vpaddd		$Four,$S[1],$S[2]
+	vpshufb		$Bswap,$S[1],$S[1]
+	vpaddd		$Four,$S[2],$S[3]
+	vpshufb		$Bswap,$S[2],$S[2]
+	vpaddd		$Four,$S[3],$Ctr
+	vpshufb		$Bswap,$S[3],$S[3]
+___
+    $code.="\tvpxorq\t\t$rk[0],$_,$_\n" foreach (@S);
+    for my $r (1..9) {
+	$code.="\tvaesenc\t\t$rk[$r],$_,$_\n" foreach (@S);
+	$code.="\t $_\n" foreach (splice(@gh,0,$per));
+    }
+    $code.="\t $_\n" foreach (@gh);
+    $code.="\tcmp\t\t\$0xb0,$rounds16\n\tjb\t\t$last\n";
+    $code.="\tvaesenc\t\t$rk[10],$_,$_\n" foreach (@S);
+    $code.="\tvaesenc\t\t$rk[11],$_,$_\n" foreach (@S);
+    $code.="\tje\t\t$last\n";
+    $code.="\tvaesenc\t\t$rk[12],$_,$_\n" foreach (@S);
+    $code.="\tvaesenc\t\t$rk[13],$_,$_\n" foreach (@S);
+    $code.="$last:\n";
+    $code.="\tvaesenclast\t$rklast,$_,$_\n" foreach (@S);
+}
+
+# $dst <- $a*$b in each lane
+sub vaes_mul_4x {
+my ($a,$b,$dst)=@_;
+    $code.=<<___;
+	vpclmulqdq	\$0x00,$b,$a,$Lo
+	vpclmulqdq	\$0x11,$b,$a,$Hi
+	vpclmulqdq	\$0x01,$b,$a,$Mid
+	vpclmulqdq	\$0x10,$b,$a,$Tz
+	vpxorq		$Tz,$Mid,$Mid
+	vpslldq		\$8,$Mid,$Tz
+	vpsrldq		\$8,$Mid,$Mid
+	vpxorq		$Tz,$Lo,$Lo
+	vpxorq		$Mid,$Hi,$Hi
+___
+    $code.="\t$_\n" foreach (&vaes_reduce($Hi,$Lo,$Tz,$Tz2,$dst));
+}
+
+for my $dir ("encrypt","decrypt") {
+$code.=<<___;
+.type	_aesni_gcm_${dir}_vaes,\@abi-omnipotent
+.align	32
+_aesni_gcm_${dir}_vaes:
+.cfi_startproc
+	mov		%rsp,%r11
+.cfi_def_cfa_register	%r11
+	sub		\$0x100,%rsp
+	and		\$-64,%rsp
+	mov		$len,%rax
+	and		\$-0x100,%rax		# return value
+	shr		\$8,$len		# 16-block iterations
+
+	vbroadcasti32x4	.Lbswap_mask(%rip),$Bswap
+	lea		0x20($Xip),$Htbl
+	vmovdqu		0x40($Htbl),%xmm0	# [H^4,H^3,H^2,H^1]
+	vinserti32x4	\$1,0x30($Htbl),%zmm0,%zmm0
+	vinserti32x4	\$2,0x10($Htbl),%zmm0,%zmm0
+	vinserti32x4	\$3,0x00($Htbl),%zmm0,%zmm0
+	vmovdqu		0xa0($Htbl),%xmm1	# [H^8,H^7,H^6,H^5]
+	vinserti32x4	\$1,0x90($Htbl),%zmm1,%zmm1
+	vinserti32x4	\$2,0x70($Htbl),%zmm1,%zmm1
+	vinserti32x4	\$3,0x60($Htbl),%zmm1,%zmm1
+	vbroadcasti32x4	0xa0($Htbl),%zmm2	# H^8 in every lane
+	vmovdqa64	%zmm0,0xc0(%rsp)
+	vmovdqa64	%zmm1,0x80(%rsp)
+___
+	&vaes_mul_4x("%zmm0","%zmm2","%zmm0");	# [H^12,...,H^9]
+	&vaes_mul_4x("%zmm1","%zmm2","%zmm1");	# [H^16,...,H^13]
+$code.=<<___;
+	vmovdqa64	%zmm0,0x40(%rsp)
+	vmovdqa64	%zmm1,0x00(%rsp)
+
+	vmovdqu		($Xip),$xXi
+	vpshufb		$xBswap,$xXi,$xXi
+	vbroadcasti32x4	($ivp),$Ctr
+	vpshufb		$Bswap,$Ctr,$Ctr
+	vpaddd		.Lvaes_ctr_inc(%rip),$Ctr,$Ctr	# lanes are +0,+1,+2,+3
+	vbroadcasti32x4	.Lvaes_four(%rip),$Four
+
+	mov		240($key),$rounds16
+	shl		\$4,$rounds16		# 0x90, 0xb0 or 0xd0
+___
+    for my $r (0..13) {
+	$code.=sprintf("\tvbroadcasti32x4\t0x%02x(%s),%s\n",16*$r,$key,$rk[$r]);
+    }
+$code.=<<___;
+	vbroadcasti32x4	0x10($key,%r10),$rklast	# last round key
+___
+if ($dir eq "encrypt") {
+	&vaes_ctr_16x();
+	&vaes_enc_store();
+$code.=<<___;
+	dec		$len
+	jz		.Lenc_vaes_tail
+.align	32
+.Lenc_vaes_loop:
+___
+	&vaes_ctr_16x(&vaes_ghash_16x());
+	&vaes_enc_store();
+$code.=<<___;
+	dec		$len
+	jnz		.Lenc_vaes_loop
+.Lenc_vaes_tail:
+___
+	$code.="\t$_\n" foreach (&vaes_ghash_16x());
+} else {
+$code.=<<___;
+.align	32
+.Ldec_vaes_loop:
+___
+    for my $k (0..3) {
+	$code.=sprintf("\tvmovdqu64\t0x%02x(%s),%s\n",64*$k,$inp,$G[$k]);
+	$code.="\tvpshufb\t\t$Bswap,$G[$k],$G[$k]\n";
+    }
+	&vaes_ctr_16x(&vaes_ghash_16x());
+    for my $k (0..3) {
+	$code.=sprintf("\tvpxorq\t\t0x%02x(%s),%s,%s\n",64*$k,$inp,$S[$k],$S[$k]);
+	$code.=sprintf("\tvmovdqu64\t%s,0x%02x(%s)\n",$S[$k],64*$k,$out);
+    }
+$code.=<<___;
+	lea		0x100($inp),$inp
+	lea		0x100($out),$out
+	dec		$len
+	jnz		.Ldec_vaes_loop
+___
+}
+$code.=<<___;
+	vpshufb		$xBswap,$xXi,$xXi
+	vmovdqu		$xXi,($Xip)
+	vpshufb		$xBswap,$xCtr,%xmm0
+	vmovdqu		%xmm0,($ivp)		# next counter value
+
+	vpxor		%xmm0,%xmm0,%xmm0	# wipe H powers and round keys
+	vmovdqa64	%zmm0,0x00(%rsp)
+	vmovdqa64	%zmm0,0x40(%rsp)
+	vmovdqa64	%zmm0,0x80(%rsp)
+	vmovdqa64	%zmm0,0xc0(%rsp)
+___
+    $code.="\tvpxord\t\t".xmm($_).",".xmm($_).",".xmm($_)."\n" foreach (@rk,$rklast);
+$code.=<<___;
+	vzeroupper
+	mov		%r11,%rsp
+.cfi_def_cfa_register	%rsp
+	ret
+.cfi_endproc
+.size	_aesni_gcm_${dir}_vaes,.-_aesni_gcm_${dir}_vaes
+___
+}
+
+# xor keystream in @S with input, store, keep byte-swapped copy in @G
+sub vaes_enc_store {
+    for my $k (0..3) {
+	$code.=sprintf("\tvpxorq\t\t0x%02x(%s),%s,%s\n",64*$k,$inp,$S[$k],$S[$k]);
+	$code.=sprintf("\tvmovdqu64\t%s,0x%02x(%s)\n",$S[$k],64*$k,$out);
+	$code.="\tvpshufb\t\t$Bswap,$S[$k],$G[$k]\n";
+    }
+    $code.=<<___;
+	lea		0x100($inp),$inp
+	lea		0x100($out),$out
+___
+}
+}}
+
 $code.=<<___;
 .align	64
 .Lbswap_mask:
@@ -952,6 +1241,14 @@ $code.=<<___;
 	.byte	2,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
 .Lone_lsb:
 	.byte	1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+___
+$code.=<<___ if ($vaes);
+.Lvaes_ctr_inc:
+	.long	0,0,0,0,1,0,0,0,2,0,0,0,3,0,0,0
+.Lvaes_four:
+	.long	4,0,0,0
+___
+$code.=<<___;
 .asciz	"AES-NI GCM module for x86_64, CRYPTOGAMS by <appro\@openssl.org>"
 .align	64
 ___
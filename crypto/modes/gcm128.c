@@ -1892,3 +1892,99 @@ void CRYPTO_gcm128_release(GCM128_CONTEXT *ctx)
 {
     OPENSSL_clear_free(ctx, sizeof(*ctx));
 }
+
+/*
+ * POLYVAL from RFC 8452 is GHASH with its operands byte-reversed, see
+ * Appendix A there:
+ *
+ *   POLYVAL(H, X_1, ..., X_n) = ByteReverse(GHASH(mulX_GHASH(ByteReverse(H)),
+ *                                   ByteReverse(X_1), ..., ByteReverse(X_n)))
+ *
+ * so it is computed with whichever GHASH implementation CRYPTO_gcm128_init
+ * selects, reversing the input through a small buffer on the way in.  The
+ * context is only good for CRYPTO_polyval_* calls.
+ */
+static void polyval_hash_key(const unsigned char in[16],
+                             unsigned char out[16], const void *key)
+{
+    memcpy(out, key, 16);
+}
+
+static void polyval_reverse(unsigned char *out, const unsigned char *in)
+{
+#ifdef BSWAP8
+    u64 lo, hi;
+
+    memcpy(&lo, in, 8);
+    memcpy(&hi, in + 8, 8);
+    lo = BSWAP8(lo);
+    hi = BSWAP8(hi);
+    memcpy(out, &hi, 8);
+    memcpy(out + 8, &lo, 8);
+#else
+    int i;
+
+    for (i = 0; i < 16; i++)
+        out[i] = in[15 - i];
+#endif
+}
+
+void CRYPTO_polyval_init(GCM128_CONTEXT *ctx, const unsigned char key[16])
+{
+    unsigned char h[16];
+    unsigned int carry;
+    int i;
+
+    /* mulX_GHASH: multiply by x, which is a right shift in GHASH order */
+    polyval_reverse(h, key);
+    carry = h[15] & 1;
+    for (i = 15; i > 0; i--)
+        h[i] = (unsigned char)((h[i] >> 1) | (h[i - 1] << 7));
+    h[0] = (unsigned char)((h[0] >> 1) ^ (carry ? 0xe1 : 0));
+
+    CRYPTO_gcm128_init(ctx, h, polyval_hash_key);
+    ctx->key = NULL;
+    OPENSSL_cleanse(h, sizeof(h));
+}
+
+/* |len| must be a multiple of 16 */
+void CRYPTO_polyval_update(GCM128_CONTEXT *ctx, const unsigned char *in,
+                           size_t len)
+{
+    union {
+        u64 u[128];
+        u8 c[1024];
+    } buf;
+    size_t i, n;
+#ifdef GCM_FUNCREF_4BIT
+# ifdef GHASH
+    void (*gcm_ghash_p) (u64 Xi[2], const u128 Htable[16],
+                         const u8 *inp, size_t len) = ctx->ghash;
+# else
+    void (*gcm_gmult_p) (u64 Xi[2], const u128 Htable[16]) = ctx->gmult;
+# endif
+#endif
+
+    while (len > 0) {
+        n = len < sizeof(buf) ? len : sizeof(buf);
+        for (i = 0; i < n; i += 16)
+            polyval_reverse(buf.c + i, in + i);
+#ifdef GHASH
+        GHASH(ctx, buf.c, n);
+#else
+        for (i = 0; i < n; i += 16) {
+            ctx->Xi.u[0] ^= buf.u[i / 8];
+            ctx->Xi.u[1] ^= buf.u[i / 8 + 1];
+            GCM_MUL(ctx);
+        }
+#endif
+        in += n;
+        len -= n;
+    }
+    OPENSSL_cleanse(&buf, sizeof(buf));
+}
+
+void CRYPTO_polyval_final(GCM128_CONTEXT *ctx, unsigned char out[16])
+{
+    polyval_reverse(out, ctx->Xi.c);
+}
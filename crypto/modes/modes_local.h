@@ -144,11 +144,18 @@ struct gcm128_context {
 #endif
 };
 
+void CRYPTO_polyval_init(GCM128_CONTEXT *ctx, const unsigned char key[16]);
+void CRYPTO_polyval_update(GCM128_CONTEXT *ctx, const unsigned char *in,
+                           size_t len);
+void CRYPTO_polyval_final(GCM128_CONTEXT *ctx, unsigned char out[16]);
+
 struct xts128_context {
     void *key1, *key2;
     block128_f block1, block2;
 };
 
+void CRYPTO_xts128_tweak_advance(unsigned char tweak[16], size_t blocks);
+
 struct ccm128_context {
     union {
         u64 u[2];
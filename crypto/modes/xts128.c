@@ -163,3 +163,45 @@ int CRYPTO_xts128_encrypt(const XTS128_CONTEXT *ctx,
 
     return 0;
 }
+
+/* a = a * b in GF(2^128), XTS (little-endian) bit order */
+static void xts128_gf_mul(u64 a[2], const u64 b[2])
+{
+    u64 x0 = a[0], x1 = a[1], r0 = 0, r1 = 0, carry;
+    int i;
+
+    for (i = 0; i < 128; i++) {
+        if ((b[i / 64] >> (i % 64)) & 1) {
+            r0 ^= x0;
+            r1 ^= x1;
+        }
+        carry = x1 >> 63;
+        x1 = (x1 << 1) | (x0 >> 63);
+        x0 = (x0 << 1) ^ ((0 - carry) & 0x87);
+    }
+    a[0] = r0;
+    a[1] = r1;
+}
+
+/*
+ * Multiply an encrypted tweak by alpha^blocks, giving the tweak used for
+ * the block |blocks| positions further on.  This is what lets a data unit
+ * be processed from the middle.
+ */
+void CRYPTO_xts128_tweak_advance(unsigned char tweak[16], size_t blocks)
+{
+    u64 t[2] = { 0, 0 }, alpha[2] = { 2, 0 }, pow[2] = { 1, 0 };
+    int i;
+
+    for (; blocks != 0; blocks >>= 1) {
+        if (blocks & 1)
+            xts128_gf_mul(pow, alpha);
+        xts128_gf_mul(alpha, alpha);
+    }
+
+    for (i = 15; i >= 0; i--)
+        t[i / 8] = (t[i / 8] << 8) | tweak[i];
+    xts128_gf_mul(t, pow);
+    for (i = 0; i < 16; i++)
+        tweak[i] = (u8)(t[i / 8] >> (8 * (i % 8)));
+}
@@ -63,6 +63,51 @@ static STACK_OF(NAME_FUNCS) *name_funcs_stack;
 static unsigned long obj_name_hash(const OBJ_NAME *a);
 static int obj_name_cmp(const OBJ_NAME *a, const OBJ_NAME *b);
 
+/*
+ * Digest and cipher lookups are far more frequent than changes to those
+ * names, so they are answered from an immutable open addressing table
+ * that is published with release semantics and read without |obj_lock|.
+ * Any change to those types unpublishes the table and the next lookup
+ * builds a new one.  A table that was unpublished may still be in use by
+ * a reader, so it is only freed by OBJ_NAME_cleanup(); after
+ * OBJ_NAME_SNAP_MAX_RETIRED of them, lookups go back to taking the lock.
+ * Without the compiler atomics the lock is always taken.
+ */
+#if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE) \
+    && __GCC_ATOMIC_POINTER_LOCK_FREE > 0
+# define OBJ_NAME_SNAPSHOT
+#endif
+
+#ifdef OBJ_NAME_SNAPSHOT
+
+# define OBJ_NAME_SNAP_MAX_RETIRED      16
+
+typedef struct {
+    const char *name;           /* NULL for an empty slot */
+    const char *data;           /* as added, returned for OBJ_NAME_ALIAS */
+    const char *value;          /* with aliases resolved */
+    unsigned long hash;
+    int type;
+} OBJ_NAME_SLOT;
+
+typedef struct obj_name_snap_st OBJ_NAME_SNAP;
+struct obj_name_snap_st {
+    OBJ_NAME_SNAP *retired;     /* next older unpublished table */
+    size_t mask;                /* number of slots - 1 */
+    OBJ_NAME_SLOT *slots;
+};
+
+static OBJ_NAME_SNAP *names_snap = NULL;
+static OBJ_NAME_SNAP *names_snap_retired = NULL;
+static int names_snap_num_retired = 0;
+
+static ossl_inline int obj_name_snap_type(int type)
+{
+    return type == OBJ_NAME_TYPE_MD_METH || type == OBJ_NAME_TYPE_CIPHER_METH;
+}
+
+#endif
+
 static CRYPTO_ONCE init = CRYPTO_ONCE_STATIC_INIT;
 DEFINE_RUN_ONCE_STATIC(o_names_init)
 {
@@ -175,21 +220,13 @@ static unsigned long obj_name_hash(const OBJ_NAME *a)
     return ret;
 }
 
-const char *OBJ_NAME_get(const char *name, int type)
+/* Must be called with |obj_lock| held */
+static const char *obj_name_lookup(const char *name, int type, int alias)
 {
     OBJ_NAME on, *ret;
-    int num = 0, alias;
+    int num = 0;
     const char *value = NULL;
 
-    if (name == NULL)
-        return NULL;
-    if (!OBJ_NAME_init())
-        return NULL;
-    CRYPTO_THREAD_read_lock(obj_lock);
-
-    alias = type & OBJ_NAME_ALIAS;
-    type &= ~OBJ_NAME_ALIAS;
-
     on.name = name;
     on.type = type;
 
@@ -206,7 +243,154 @@ const char *OBJ_NAME_get(const char *name, int type)
             break;
         }
     }
+    return value;
+}
+
+#ifdef OBJ_NAME_SNAPSHOT
+
+typedef struct {
+    size_t num;                 /* names of the snapshot types */
+    size_t bytes;               /* their lengths including the NULs */
+    OBJ_NAME_SNAP *snap;        /* NULL while counting */
+    char *strings;
+} OBJ_NAME_SNAP_BUILD;
+
+static void obj_name_snap_add(const OBJ_NAME *on, void *arg)
+{
+    OBJ_NAME_SNAP_BUILD *b = arg;
+    OBJ_NAME_SNAP *snap = b->snap;
+    size_t len = strlen(on->name) + 1, i;
+    unsigned long hash;
+
+    if (snap == NULL) {
+        b->num++;
+        b->bytes += len;
+        return;
+    }
+
+    hash = openssl_lh_strcasehash(on->name) ^ on->type;
+    for (i = hash & snap->mask; snap->slots[i].name != NULL;
+         i = (i + 1) & snap->mask)
+        continue;
+    memcpy(b->strings, on->name, len);
+    snap->slots[i].name = b->strings;
+    snap->slots[i].data = on->data;
+    snap->slots[i].value = obj_name_lookup(on->name, on->type, 0);
+    snap->slots[i].hash = hash;
+    snap->slots[i].type = on->type;
+    b->strings += len;
+}
+
+/*
+ * Returns the published table, building it first if there is none.
+ * Returns NULL if lookups have to take the lock.
+ */
+static const OBJ_NAME_SNAP *obj_name_snap_get(void)
+{
+    OBJ_NAME_SNAP_BUILD b;
+    OBJ_NAME_SNAP *snap;
+    size_t slots;
+
+    snap = __atomic_load_n(&names_snap, __ATOMIC_ACQUIRE);
+    if (snap != NULL)
+        return snap;
+
+    CRYPTO_THREAD_write_lock(obj_lock);
+    if ((snap = names_snap) != NULL
+            || names_snap_num_retired >= OBJ_NAME_SNAP_MAX_RETIRED)
+        goto out;
+
+    memset(&b, 0, sizeof(b));
+    OBJ_NAME_do_all(OBJ_NAME_TYPE_MD_METH, obj_name_snap_add, &b);
+    OBJ_NAME_do_all(OBJ_NAME_TYPE_CIPHER_METH, obj_name_snap_add, &b);
+    /* keep the load at or below a half */
+    for (slots = 16; slots < 2 * b.num; slots <<= 1)
+        continue;
+
+    snap = OPENSSL_zalloc(sizeof(*snap) + slots * sizeof(OBJ_NAME_SLOT)
+                          + b.bytes);
+    if (snap == NULL)
+        goto out;
+    snap->mask = slots - 1;
+    snap->slots = (OBJ_NAME_SLOT *)(snap + 1);
+    b.snap = snap;
+    b.strings = (char *)(snap->slots + slots);
+    OBJ_NAME_do_all(OBJ_NAME_TYPE_MD_METH, obj_name_snap_add, &b);
+    OBJ_NAME_do_all(OBJ_NAME_TYPE_CIPHER_METH, obj_name_snap_add, &b);
+    __atomic_store_n(&names_snap, snap, __ATOMIC_RELEASE);
+
+ out:
+    CRYPTO_THREAD_unlock(obj_lock);
+    return snap;
+}
+
+static const char *obj_name_snap_lookup(const OBJ_NAME_SNAP *snap,
+                                        const char *name, int type, int alias)
+{
+    unsigned long hash = openssl_lh_strcasehash(name) ^ type;
+    const OBJ_NAME_SLOT *slot;
+    size_t i;
+
+    for (i = hash & snap->mask; (slot = &snap->slots[i])->name != NULL;
+         i = (i + 1) & snap->mask)
+        if (slot->hash == hash && slot->type == type
+                && obj_strcasecmp(slot->name, name) == 0)
+            return alias ? slot->data : slot->value;
+    return NULL;
+}
+
+/* Must be called with |obj_lock| held for writing */
+static void obj_name_snap_retire(int type)
+{
+    OBJ_NAME_SNAP *snap = names_snap;
+
+    if (snap == NULL || !obj_name_snap_type(type))
+        return;
+    __atomic_store_n(&names_snap, NULL, __ATOMIC_RELEASE);
+    snap->retired = names_snap_retired;
+    names_snap_retired = snap;
+    names_snap_num_retired++;
+}
+
+static void obj_name_snap_free(void)
+{
+    OBJ_NAME_SNAP *snap;
+
+    obj_name_snap_retire(OBJ_NAME_TYPE_MD_METH);
+    while ((snap = names_snap_retired) != NULL) {
+        names_snap_retired = snap->retired;
+        OPENSSL_free(snap);
+    }
+    names_snap_num_retired = 0;
+}
+
+#else
+# define obj_name_snap_retire(type)
+#endif
 
+const char *OBJ_NAME_get(const char *name, int type)
+{
+    int alias;
+    const char *value = NULL;
+#ifdef OBJ_NAME_SNAPSHOT
+    const OBJ_NAME_SNAP *snap;
+#endif
+
+    if (name == NULL)
+        return NULL;
+    if (!OBJ_NAME_init())
+        return NULL;
+
+    alias = type & OBJ_NAME_ALIAS;
+    type &= ~OBJ_NAME_ALIAS;
+
+#ifdef OBJ_NAME_SNAPSHOT
+    if (obj_name_snap_type(type) && (snap = obj_name_snap_get()) != NULL)
+        return obj_name_snap_lookup(snap, name, type, alias);
+#endif
+
+    CRYPTO_THREAD_read_lock(obj_lock);
+    value = obj_name_lookup(name, type, alias);
     CRYPTO_THREAD_unlock(obj_lock);
     return value;
 }
@@ -233,6 +417,7 @@ int OBJ_NAME_add(const char *name, int type, const char *data)
 
     CRYPTO_THREAD_write_lock(obj_lock);
 
+    obj_name_snap_retire(type);
     ret = lh_OBJ_NAME_insert(names_lh, onp);
     if (ret != NULL) {
         /* free things */
@@ -277,6 +462,7 @@ int OBJ_NAME_remove(const char *name, int type)
     on.type = type;
     ret = lh_OBJ_NAME_delete(names_lh, &on);
     if (ret != NULL) {
+        obj_name_snap_retire(type);
         /* free things */
         if ((name_funcs_stack != NULL)
             && (sk_NAME_FUNCS_num(name_funcs_stack) > ret->type)) {
@@ -399,6 +585,9 @@ void OBJ_NAME_cleanup(int type)
 
     lh_OBJ_NAME_doall(names_lh, names_lh_free_doall);
     if (type < 0) {
+#ifdef OBJ_NAME_SNAPSHOT
+        obj_name_snap_free();
+#endif
         lh_OBJ_NAME_free(names_lh);
         sk_NAME_FUNCS_pop_free(name_funcs_stack, name_funcs_free);
         CRYPTO_THREAD_lock_free(obj_lock);
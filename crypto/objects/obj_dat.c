@@ -23,7 +23,6 @@
 
 DECLARE_OBJ_BSEARCH_CMP_FN(const ASN1_OBJECT *, unsigned int, sn);
 DECLARE_OBJ_BSEARCH_CMP_FN(const ASN1_OBJECT *, unsigned int, ln);
-DECLARE_OBJ_BSEARCH_CMP_FN(const ASN1_OBJECT *, unsigned int, obj);
 
 #define ADDED_DATA      0
 #define ADDED_SNAME     1
@@ -299,25 +298,43 @@ const char *OBJ_nid2ln(int n)
     }
 }
 
-static int obj_cmp(const ASN1_OBJECT *const *ap, const unsigned int *bp)
+/*
+ * FNV-1a with a final mix, the hash the perfect hash of the DER encodings in
+ * obj_dat.h was built with: must match obj_hash() in obj_dat.pl.
+ */
+static ossl_inline uint32_t obj_dat_hash(uint32_t seed,
+                                         const unsigned char *p, int len)
 {
-    int j;
-    const ASN1_OBJECT *a = *ap;
-    const ASN1_OBJECT *b = &nid_objs[*bp];
-
-    j = (a->length - b->length);
-    if (j)
-        return j;
-    if (a->length == 0)
-        return 0;
-    return memcmp(a->data, b->data, a->length);
+    uint32_t h = 0x811c9dc5 ^ (seed * 0x9e3779b9);
+
+    while (len-- > 0)
+        h = (h ^ *p++) * 0x01000193;
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
 }
 
-IMPLEMENT_OBJ_BSEARCH_CMP_FN(const ASN1_OBJECT *, unsigned int, obj);
+/* The NID of the built-in object encoded as |a|, or NID_undef */
+static int obj_dat_lookup(const ASN1_OBJECT *a)
+{
+    uint32_t seed;
+    int nid;
+
+    seed = obj_hash_seeds[obj_dat_hash(0, a->data, a->length)
+                          & (OBJ_HASH_BUCKETS - 1)];
+    nid = obj_hash_nids[obj_dat_hash(seed, a->data, a->length)
+                        & (OBJ_HASH_SLOTS - 1)];
+    if (nid == NID_undef || nid_objs[nid].length != a->length
+            || memcmp(nid_objs[nid].data, a->data, a->length) != 0)
+        return NID_undef;
+    return nid;
+}
 
 int OBJ_obj2nid(const ASN1_OBJECT *a)
 {
-    const unsigned int *op;
     ADDED_OBJ ad, *adp;
 
     if (a == NULL)
@@ -335,10 +352,7 @@ int OBJ_obj2nid(const ASN1_OBJECT *a)
         if (adp != NULL)
             return adp->obj->nid;
     }
-    op = OBJ_bsearch_obj(&a, obj_objs, NUM_OBJ);
-    if (op == NULL)
-        return NID_undef;
-    return nid_objs[*op].nid;
+    return obj_dat_lookup(a);
 }
 
 /*
@@ -2,7 +2,7 @@
  * WARNING: do not edit!
  * Generated by crypto/objects/obj_dat.pl
  *
- * Copyright 1995-2022 The OpenSSL Project Authors. All Rights Reserved.
+ * Copyright 1995-2023 The OpenSSL Project Authors. All Rights Reserved.
  * Licensed under the OpenSSL license (the "License").  You may not use
  * this file except in compliance with the License.  You can obtain a copy
  * in the file LICENSE in the source distribution or at
@@ -10,7 +10,7 @@
  */
 
 /* Serialized OID's */
-static const unsigned char so[7910] = {
+static const unsigned char so[7930] = {
     0x2A,0x86,0x48,0x86,0xF7,0x0D,                 /* [    0] OBJ_rsadsi */
     0x2A,0x86,0x48,0x86,0xF7,0x0D,0x01,            /* [    6] OBJ_pkcs */
     0x2A,0x86,0x48,0x86,0xF7,0x0D,0x02,0x02,       /* [   13] OBJ_md2 */
@@ -1099,9 +1099,11 @@ static const unsigned char so[7910] = {
     0x2B,0xCE,0x0F,0x06,0x07,0x0D,                 /* [ 7891] OBJ_sphincsshake128fsimple */
     0x2B,0xCE,0x0F,0x06,0x07,0x0E,                 /* [ 7897] OBJ_p256_sphincsshake128fsimple */
     0x2B,0xCE,0x0F,0x06,0x07,0x0F,                 /* [ 7903] OBJ_rsa3072_sphincsshake128fsimple */
+    0x2B,0x06,0x01,0x04,0x01,0x8D,0x3A,0x0C,0x02,0x01,  /* [ 7909] OBJ_blake2bmac */
+    0x2B,0x06,0x01,0x04,0x01,0x8D,0x3A,0x0C,0x02,0x02,  /* [ 7919] OBJ_blake2smac */
 };
 
-#define NUM_NID 1250
+#define NUM_NID 1264
 static const ASN1_OBJECT nid_objs[NUM_NID] = {
     {"UNDEF", "undefined", NID_undef},
     {"rsadsi", "RSA Data Security, Inc.", NID_rsadsi, 6, &so[0]},
@@ -2353,9 +2355,23 @@ static const ASN1_OBJECT nid_objs[NUM_NID] = {
     {"sphincsshake128fsimple", "sphincsshake128fsimple", NID_sphincsshake128fsimple, 6, &so[7891]},
     {"p256_sphincsshake128fsimple", "p256_sphincsshake128fsimple", NID_p256_sphincsshake128fsimple, 6, &so[7897]},
     {"rsa3072_sphincsshake128fsimple", "rsa3072_sphincsshake128fsimple", NID_rsa3072_sphincsshake128fsimple, 6, &so[7903]},
+    {"AES-128-GCM-SIV", "aes-128-gcm-siv", NID_aes_128_gcm_siv},
+    {"AES-256-GCM-SIV", "aes-256-gcm-siv", NID_aes_256_gcm_siv},
+    {"x25519_frodo640aes", "x25519_frodo640aes", NID_x25519_frodo640aes},
+    {"x25519_frodo640shake", "x25519_frodo640shake", NID_x25519_frodo640shake},
+    {"x448_frodo976aes", "x448_frodo976aes", NID_x448_frodo976aes},
+    {"x448_frodo976shake", "x448_frodo976shake", NID_x448_frodo976shake},
+    {"x25519_kyber512", "x25519_kyber512", NID_x25519_kyber512},
+    {"x448_kyber768", "x448_kyber768", NID_x448_kyber768},
+    {"x25519_bikel1", "x25519_bikel1", NID_x25519_bikel1},
+    {"x448_bikel3", "x448_bikel3", NID_x448_bikel3},
+    {"x25519_hqc128", "x25519_hqc128", NID_x25519_hqc128},
+    {"x448_hqc192", "x448_hqc192", NID_x448_hqc192},
+    {"BLAKE2BMAC", "blake2bmac", NID_blake2bmac, 10, &so[7909]},
+    {"BLAKE2SMAC", "blake2smac", NID_blake2smac, 10, &so[7919]},
 };
 
-#define NUM_SN 1239
+#define NUM_SN 1253
 static const unsigned int sn_objs[NUM_SN] = {
      364,    /* "AD_DVCS" */
      419,    /* "AES-128-CBC" */
@@ -2366,6 +2382,7 @@ static const unsigned int sn_objs[NUM_SN] = {
      653,    /* "AES-128-CFB8" */
      904,    /* "AES-128-CTR" */
      418,    /* "AES-128-ECB" */
+    1250,    /* "AES-128-GCM-SIV" */
      958,    /* "AES-128-OCB" */
      420,    /* "AES-128-OFB" */
      913,    /* "AES-128-XTS" */
@@ -2387,6 +2404,7 @@ static const unsigned int sn_objs[NUM_SN] = {
      655,    /* "AES-256-CFB8" */
      906,    /* "AES-256-CTR" */
      426,    /* "AES-256-ECB" */
+    1251,    /* "AES-256-GCM-SIV" */
      960,    /* "AES-256-OCB" */
      428,    /* "AES-256-OFB" */
      914,    /* "AES-256-XTS" */
@@ -2430,6 +2448,8 @@ static const unsigned int sn_objs[NUM_SN] = {
       93,    /* "BF-CFB" */
       92,    /* "BF-ECB" */
       94,    /* "BF-OFB" */
+    1262,    /* "BLAKE2BMAC" */
+    1263,    /* "BLAKE2SMAC" */
     1056,    /* "BLAKE2b512" */
     1057,    /* "BLAKE2s256" */
       14,    /* "C" */
@@ -3592,13 +3612,23 @@ static const unsigned int sn_objs[NUM_SN] = {
      742,    /* "wap-wsg-idm-ecid-wtls9" */
      804,    /* "whirlpool" */
      868,    /* "x121Address" */
+    1258,    /* "x25519_bikel1" */
+    1252,    /* "x25519_frodo640aes" */
+    1253,    /* "x25519_frodo640shake" */
+    1260,    /* "x25519_hqc128" */
+    1256,    /* "x25519_kyber512" */
+    1259,    /* "x448_bikel3" */
+    1254,    /* "x448_frodo976aes" */
+    1255,    /* "x448_frodo976shake" */
+    1261,    /* "x448_hqc192" */
+    1257,    /* "x448_kyber768" */
      503,    /* "x500UniqueIdentifier" */
      158,    /* "x509Certificate" */
      160,    /* "x509Crl" */
     1093,    /* "x509ExtAdmission" */
 };
 
-#define NUM_LN 1239
+#define NUM_LN 1253
 static const unsigned int ln_objs[NUM_LN] = {
      363,    /* "AD Time Stamping" */
      405,    /* "ANSI X9.62" */
@@ -3823,6 +3853,7 @@ static const unsigned int ln_objs[NUM_LN] = {
      904,    /* "aes-128-ctr" */
      418,    /* "aes-128-ecb" */
      895,    /* "aes-128-gcm" */
+    1250,    /* "aes-128-gcm-siv" */
      958,    /* "aes-128-ocb" */
      420,    /* "aes-128-ofb" */
      913,    /* "aes-128-xts" */
@@ -3848,6 +3879,7 @@ static const unsigned int ln_objs[NUM_LN] = {
      906,    /* "aes-256-ctr" */
      426,    /* "aes-256-ecb" */
      901,    /* "aes-256-gcm" */
+    1251,    /* "aes-256-gcm-siv" */
      960,    /* "aes-256-ocb" */
      428,    /* "aes-256-ofb" */
      914,    /* "aes-256-xts" */
@@ -3900,7 +3932,9 @@ static const unsigned int ln_objs[NUM_LN] = {
     1206,    /* "bikel3" */
     1207,    /* "bikel5" */
     1056,    /* "blake2b512" */
+    1262,    /* "blake2bmac" */
     1057,    /* "blake2s256" */
+    1263,    /* "blake2smac" */
      921,    /* "brainpoolP160r1" */
      922,    /* "brainpoolP160t1" */
      923,    /* "brainpoolP192r1" */
@@ -4835,1106 +4869,2113 @@ static const unsigned int ln_objs[NUM_LN] = {
      742,    /* "wap-wsg-idm-ecid-wtls9" */
      804,    /* "whirlpool" */
      868,    /* "x121Address" */
+    1258,    /* "x25519_bikel1" */
+    1252,    /* "x25519_frodo640aes" */
+    1253,    /* "x25519_frodo640shake" */
+    1260,    /* "x25519_hqc128" */
+    1256,    /* "x25519_kyber512" */
+    1259,    /* "x448_bikel3" */
+    1254,    /* "x448_frodo976aes" */
+    1255,    /* "x448_frodo976shake" */
+    1261,    /* "x448_hqc192" */
+    1257,    /* "x448_kyber768" */
      503,    /* "x500UniqueIdentifier" */
      158,    /* "x509Certificate" */
      160,    /* "x509Crl" */
      125,    /* "zlib compression" */
 };
 
-#define NUM_OBJ 1094
-static const unsigned int obj_objs[NUM_OBJ] = {
-       0,    /* OBJ_undef                        0 */
-     181,    /* OBJ_iso                          1 */
-     393,    /* OBJ_joint_iso_ccitt              OBJ_joint_iso_itu_t */
-     404,    /* OBJ_ccitt                        OBJ_itu_t */
-     645,    /* OBJ_itu_t                        0 */
-     646,    /* OBJ_joint_iso_itu_t              2 */
-     434,    /* OBJ_data                         0 9 */
-     182,    /* OBJ_member_body                  1 2 */
-     379,    /* OBJ_org                          1 3 */
-     676,    /* OBJ_identified_organization      1 3 */
+#define NUM_OBJ 1096
+
+/*
+ * Perfect hash of the DER encodings of the objects: the hash with seed 0
+ * picks the seed in obj_hash_seeds, and the hash with that seed the slot
+ * of obj_hash_nids holding the NID, or NID_undef.
+ */
+#define OBJ_HASH_BUCKETS 256
+static const unsigned short obj_hash_seeds[OBJ_HASH_BUCKETS] = {
+        0,     4,     5,     1,     1,     1,     2,     3,
+        5,     5,     1,     1,     6,     6,     1,     6,
+        5,     2,     1,     2,     2,     8,     1,     1,
+        1,     8,     1,     1,     1,     1,     2,     6,
+        5,     6,     4,     1,    11,     1,    29,     2,
+        6,     8,     2,     1,     2,     4,     4,     2,
+        4,     1,     2,     2,     1,     4,     3,     3,
+        5,     2,     6,     5,     1,     1,     1,     1,
+        8,     1,     5,     3,     2,     1,     1,     5,
+        9,     6,     0,     9,     4,     1,     4,     3,
+        1,    21,     2,     5,     3,     2,     6,    12,
+        1,     1,     7,     3,     7,     1,     7,     1,
+       17,     3,     4,     8,     1,     4,     4,     4,
+        6,     3,     9,     1,     1,    12,     4,     2,
+        1,     3,     7,     5,     8,     6,    11,     8,
+        1,     6,     4,     4,     1,     1,     6,     4,
+        1,    12,     3,     6,     1,     8,     5,     1,
+        7,     5,     1,    11,     3,     3,     1,     1,
+        6,    12,     3,     2,     1,     3,     2,     2,
+        7,     7,     4,     2,     1,     3,     5,     4,
+        7,     5,     1,    17,     6,     3,    16,     2,
+        4,     5,    14,     3,     4,     1,     3,    11,
+        3,     1,     5,     4,     2,     6,     1,     1,
+        3,     3,    13,     4,     5,     1,     3,     6,
+        1,    15,     6,     3,     2,     5,     3,    24,
+        1,     1,     4,     4,    10,     4,     1,     5,
+        1,     2,     2,    18,    11,     3,    13,    12,
+        2,     1,     5,     2,     4,     6,     5,     6,
+        1,     3,     1,     2,     9,     2,     3,    10,
+        5,     2,     8,     1,     6,    12,     3,     2,
+       11,    28,    15,    12,     4,     1,     1,    12,
+        7,     4,    16,     5,    22,     7,     5,     4,
+};
+
+#define OBJ_HASH_SLOTS 2048
+static const unsigned short obj_hash_nids[OBJ_HASH_SLOTS] = {
+     884,    /* OBJ_crossCertificatePair         2 5 4 40 */
+     724,    /* OBJ_sect193r1                    1 3 132 0 24 */
+       0,
+     151,    /* OBJ_pkcs8ShroudedKeyBag          1 2 840 113549 1 12 10 1 2 */
+     321,    /* OBJ_id_regInfo_utf8Pairs         1 3 6 1 5 5 7 5 2 1 */
+     212,    /* OBJ_id_smime_aa_receiptRequest   1 2 840 113549 1 9 16 2 1 */
+       0,
+     943,    /* OBJ_dhSinglePass_cofactorDH_sha256kdf_scheme 1 3 132 1 14 1 */
+     236,    /* OBJ_id_smime_aa_ets_escTimeStamp 1 2 840 113549 1 9 16 2 25 */
+       0,
+     298,    /* OBJ_id_it_caProtEncCert          1 3 6 1 5 5 7 4 1 */
+       0,
+       0,
+       0,
+     641,    /* OBJ_set_brand_MasterCard         2 23 42 8 5 */
+       0,
+       0,
+       0,
+     612,    /* OBJ_setCext_tunneling            2 23 42 7 4 */
+     175,    /* OBJ_id_pe                        1 3 6 1 5 5 7 1 */
+       0,
+       0,
+       0,
       11,    /* OBJ_X500                         2 5 */
-     647,    /* OBJ_international_organizations  2 23 */
-     380,    /* OBJ_dod                          1 3 6 */
-    1170,    /* OBJ_ieee                         1 3 111 */
-      12,    /* OBJ_X509                         2 5 4 */
-     378,    /* OBJ_X500algorithms               2 5 8 */
-      81,    /* OBJ_id_ce                        2 5 29 */
-     512,    /* OBJ_id_set                       2 23 42 */
-     678,    /* OBJ_wap                          2 23 43 */
-     435,    /* OBJ_pss                          0 9 2342 */
-    1140,    /* OBJ_ISO_CN                       1 2 156 */
-    1150,    /* OBJ_ISO_UA                       1 2 804 */
-     183,    /* OBJ_ISO_US                       1 2 840 */
-     381,    /* OBJ_iana                         1 3 6 1 */
-    1034,    /* OBJ_X25519                       1 3 101 110 */
-    1035,    /* OBJ_X448                         1 3 101 111 */
-    1087,    /* OBJ_ED25519                      1 3 101 112 */
-    1088,    /* OBJ_ED448                        1 3 101 113 */
-     677,    /* OBJ_certicom_arc                 1 3 132 */
-     394,    /* OBJ_selected_attribute_types     2 5 1 5 */
-      13,    /* OBJ_commonName                   2 5 4 3 */
-     100,    /* OBJ_surname                      2 5 4 4 */
-     105,    /* OBJ_serialNumber                 2 5 4 5 */
-      14,    /* OBJ_countryName                  2 5 4 6 */
-      15,    /* OBJ_localityName                 2 5 4 7 */
-      16,    /* OBJ_stateOrProvinceName          2 5 4 8 */
-     660,    /* OBJ_streetAddress                2 5 4 9 */
+       0,
+       0,
+     115,    /* OBJ_sha1WithRSA                  1 3 14 3 2 29 */
+    1155,    /* OBJ_dstu28147_wrap               1 2 804 2 1 1 1 1 1 1 5 */
+     292,    /* OBJ_sbgp_routerIdentifier        1 3 6 1 5 5 7 1 9 */
+     204,    /* OBJ_id_smime_ct_receipt          1 2 840 113549 1 9 16 1 1 */
+       0,
+       0,
+     451,    /* OBJ_dNSDomain                    0 9 2342 19200300 100 4 15 */
+       0,
+       0,
+       0,
+     914,    /* OBJ_aes_256_xts                  1 3 111 2 1619 0 1 2 */
+       0,
+     327,    /* OBJ_id_cmc_statusInfo            1 3 6 1 5 5 7 7 1 */
+     264,    /* OBJ_id_on                        1 3 6 1 5 5 7 8 */
+      29,    /* OBJ_des_ecb                      1 3 14 3 2 6 */
+       0,
+       2,    /* OBJ_pkcs                         1 2 840 113549 1 */
+     358,    /* OBJ_id_aca_role                  1 3 6 1 5 5 7 10 5 */
+       0,
+     446,    /* OBJ_account                      0 9 2342 19200300 100 4 5 */
+       0,
+     816,    /* OBJ_id_GostR3411_94_prf          1 2 643 2 2 23 */
+       0,
+     408,    /* OBJ_X9_62_id_ecPublicKey         1 2 840 10045 2 1 */
+     687,    /* OBJ_X9_62_c2pnb176v1             1 2 840 10045 3 0 4 */
+       0,
+    1239,    /* OBJ_sphincssha2128fsimple        1 3 9999 6 4 13 */
+     922,    /* OBJ_brainpoolP160t1              1 3 36 3 3 2 8 1 1 2 */
+       0,
       17,    /* OBJ_organizationName             2 5 4 10 */
-      18,    /* OBJ_organizationalUnitName       2 5 4 11 */
-     106,    /* OBJ_title                        2 5 4 12 */
-     107,    /* OBJ_description                  2 5 4 13 */
-     859,    /* OBJ_searchGuide                  2 5 4 14 */
-     860,    /* OBJ_businessCategory             2 5 4 15 */
-     861,    /* OBJ_postalAddress                2 5 4 16 */
-     661,    /* OBJ_postalCode                   2 5 4 17 */
-     862,    /* OBJ_postOfficeBox                2 5 4 18 */
-     863,    /* OBJ_physicalDeliveryOfficeName   2 5 4 19 */
-     864,    /* OBJ_telephoneNumber              2 5 4 20 */
-     865,    /* OBJ_telexNumber                  2 5 4 21 */
-     866,    /* OBJ_teletexTerminalIdentifier    2 5 4 22 */
-     867,    /* OBJ_facsimileTelephoneNumber     2 5 4 23 */
-     868,    /* OBJ_x121Address                  2 5 4 24 */
+    1097,    /* OBJ_sha3_256                     2 16 840 1 101 3 4 2 8 */
+     672,    /* OBJ_sha256                       2 16 840 1 101 3 4 2 1 */
+     581,    /* OBJ_setct_CapReqTBEX             2 23 42 0 63 */
+     143,    /* OBJ_sxnet                        1 3 101 1 4 1 */
+      57,    /* OBJ_netscape                     2 16 840 1 113730 */
+     420,    /* OBJ_aes_128_ofb128               2 16 840 1 101 3 4 1 3 */
+    1180,    /* OBJ_id_tc26_wrap_gostr3412_2015_magma 1 2 643 7 1 1 7 1 */
+       0,
+     982,    /* OBJ_id_GostR3411_2012_256        1 2 643 7 1 1 2 2 */
+       0,
+     266,    /* OBJ_id_aca                       1 3 6 1 5 5 7 10 */
+     692,    /* OBJ_X9_62_c2onb191v5             1 2 840 10045 3 0 9 */
+     493,    /* OBJ_mailPreferenceOption         0 9 2342 19200300 100 1 47 */
+       0,
+     778,    /* OBJ_seed_ofb128                  1 2 410 200004 1 6 */
+     471,    /* OBJ_documentAuthor               0 9 2342 19200300 100 1 14 */
+    1184,    /* OBJ_id_tc26_gost_3410_2012_256_paramSetB 1 2 643 7 1 2 1 1 2 */
+       0,
+       0,
+     473,    /* OBJ_homeTelephoneNumber          0 9 2342 19200300 100 1 20 */
+       0,
+       0,
+     735,    /* OBJ_wap_wsg_idm_ecid_wtls1       2 23 43 1 4 1 */
+       0,
+       0,
+       0,
+     125,    /* OBJ_zlib_compression             1 2 840 113549 1 9 16 3 8 */
+     494,    /* OBJ_buildingName                 0 9 2342 19200300 100 1 48 */
+    1005,    /* OBJ_OGRN                         1 2 643 100 1 */
+     984,    /* OBJ_id_tc26_signwithdigest       1 2 643 7 1 1 3 */
+       0,
+     660,    /* OBJ_streetAddress                2 5 4 9 */
+       0,
+     701,    /* OBJ_X9_62_c2tnb359v1             1 2 840 10045 3 0 18 */
+     156,    /* OBJ_friendlyName                 1 2 840 113549 1 9 20 */
+       0,
+       0,
+       0,
+       0,
+       0,
+       0,
+     284,    /* OBJ_id_mod_cmp2000               1 3 6 1 5 5 7 0 16 */
+     242,    /* OBJ_id_smime_alg_ESDHwithRC2     1 2 840 113549 1 9 16 3 2 */
+       0,
+     280,    /* OBJ_id_mod_attribute_cert        1 3 6 1 5 5 7 0 12 */
+     434,    /* OBJ_data                         0 9 */
+     423,    /* OBJ_aes_192_cbc                  2 16 840 1 101 3 4 1 22 */
+       0,
+     721,    /* OBJ_sect163k1                    1 3 132 0 1 */
+     589,    /* OBJ_setct_CredRevReqTBE          2 23 42 0 71 */
+       0,
+       0,
+     456,    /* OBJ_pilotDSA                     0 9 2342 19200300 100 4 21 */
+     691,    /* OBJ_X9_62_c2onb191v4             1 2 840 10045 3 0 8 */
+       0,
+     995,    /* OBJ_id_tc26_sign_constants       1 2 643 7 1 2 1 */
+       0,
+     924,    /* OBJ_brainpoolP192t1              1 3 36 3 3 2 8 1 1 4 */
+    1023,    /* OBJ_capwapAC                     1 3 6 1 5 5 7 3 18 */
+    1182,    /* OBJ_id_tc26_wrap_gostr3412_2015_kuznyechik 1 2 643 7 1 1 7 2 */
+     370,    /* OBJ_id_pkix_OCSP_archiveCutoff   1 3 6 1 5 5 7 48 1 6 */
+     416,    /* OBJ_ecdsa_with_SHA1              1 2 840 10045 4 1 */
+     836,    /* OBJ_id_GostR3410_94_CryptoPro_XchA_ParamSet 1 2 643 2 2 33 1 */
+       0,
+    1020,    /* OBJ_tlsfeature                   1 3 6 1 5 5 7 1 24 */
+       0,
+       0,
+       0,
+       0,
+     533,    /* OBJ_setct_PResData               2 23 42 0 14 */
+       0,
+      66,    /* OBJ_dsaWithSHA                   1 3 14 3 2 13 */
+    1245,    /* OBJ_sphincssha2192fsimple        1 3 9999 6 5 10 */
+     921,    /* OBJ_brainpoolP160r1              1 3 36 3 3 2 8 1 1 1 */
+       0,
+     523,    /* OBJ_setct_PI                     2 23 42 0 4 */
+     563,    /* OBJ_setct_CertReqData            2 23 42 0 45 */
+     742,    /* OBJ_wap_wsg_idm_ecid_wtls9       2 23 43 1 4 9 */
+       0,
+       0,
+       0,
+    1029,    /* OBJ_sendOwner                    1 3 6 1 5 5 7 3 25 */
+       0,
+       0,
+       0,
+     202,    /* OBJ_id_smime_mod_ets_eSigPolicy_88 1 2 840 113549 1 9 16 0 7 */
+     444,    /* OBJ_pilotObject                  0 9 2342 19200300 100 4 3 */
+       0,
      869,    /* OBJ_internationaliSDNNumber      2 5 4 25 */
-     870,    /* OBJ_registeredAddress            2 5 4 26 */
-     871,    /* OBJ_destinationIndicator         2 5 4 27 */
-     872,    /* OBJ_preferredDeliveryMethod      2 5 4 28 */
-     873,    /* OBJ_presentationAddress          2 5 4 29 */
-     874,    /* OBJ_supportedApplicationContext  2 5 4 30 */
+     199,    /* OBJ_id_smime_mod_msg_v3          1 2 840 113549 1 9 16 0 4 */
      875,    /* OBJ_member                       2 5 4 31 */
-     876,    /* OBJ_owner                        2 5 4 32 */
-     877,    /* OBJ_roleOccupant                 2 5 4 33 */
-     878,    /* OBJ_seeAlso                      2 5 4 34 */
-     879,    /* OBJ_userPassword                 2 5 4 35 */
-     880,    /* OBJ_userCertificate              2 5 4 36 */
-     881,    /* OBJ_cACertificate                2 5 4 37 */
-     882,    /* OBJ_authorityRevocationList      2 5 4 38 */
-     883,    /* OBJ_certificateRevocationList    2 5 4 39 */
-     884,    /* OBJ_crossCertificatePair         2 5 4 40 */
-     173,    /* OBJ_name                         2 5 4 41 */
-      99,    /* OBJ_givenName                    2 5 4 42 */
-     101,    /* OBJ_initials                     2 5 4 43 */
-     509,    /* OBJ_generationQualifier          2 5 4 44 */
-     503,    /* OBJ_x500UniqueIdentifier         2 5 4 45 */
-     174,    /* OBJ_dnQualifier                  2 5 4 46 */
-     885,    /* OBJ_enhancedSearchGuide          2 5 4 47 */
-     886,    /* OBJ_protocolInformation          2 5 4 48 */
-     887,    /* OBJ_distinguishedName            2 5 4 49 */
-     888,    /* OBJ_uniqueMember                 2 5 4 50 */
-     889,    /* OBJ_houseIdentifier              2 5 4 51 */
-     890,    /* OBJ_supportedAlgorithms          2 5 4 52 */
-     891,    /* OBJ_deltaRevocationList          2 5 4 53 */
-     892,    /* OBJ_dmdName                      2 5 4 54 */
-     510,    /* OBJ_pseudonym                    2 5 4 65 */
-     400,    /* OBJ_role                         2 5 4 72 */
-    1089,    /* OBJ_organizationIdentifier       2 5 4 97 */
-    1090,    /* OBJ_countryCode3c                2 5 4 98 */
-    1091,    /* OBJ_countryCode3n                2 5 4 99 */
-    1092,    /* OBJ_dnsName                      2 5 4 100 */
-     769,    /* OBJ_subject_directory_attributes 2 5 29 9 */
-      82,    /* OBJ_subject_key_identifier       2 5 29 14 */
-      83,    /* OBJ_key_usage                    2 5 29 15 */
-      84,    /* OBJ_private_key_usage_period     2 5 29 16 */
-      85,    /* OBJ_subject_alt_name             2 5 29 17 */
+       0,
+     275,    /* OBJ_id_mod_kea_profile_88        1 3 6 1 5 5 7 0 7 */
+       0,
+       0,
+     644,    /* OBJ_rsaOAEPEncryptionSET         1 2 840 113549 1 1 6 */
+       0,
+       0,
+       0,
+     153,    /* OBJ_crlBag                       1 2 840 113549 1 12 10 1 4 */
+     319,    /* OBJ_id_regCtrl_oldCertID         1 3 6 1 5 5 7 5 1 5 */
+       0,
+       0,
+       0,
       86,    /* OBJ_issuer_alt_name              2 5 29 18 */
-      87,    /* OBJ_basic_constraints            2 5 29 19 */
-      88,    /* OBJ_crl_number                   2 5 29 20 */
-     141,    /* OBJ_crl_reason                   2 5 29 21 */
-     430,    /* OBJ_hold_instruction_code        2 5 29 23 */
-     142,    /* OBJ_invalidity_date              2 5 29 24 */
-     140,    /* OBJ_delta_crl                    2 5 29 27 */
-     770,    /* OBJ_issuing_distribution_point   2 5 29 28 */
-     771,    /* OBJ_certificate_issuer           2 5 29 29 */
-     666,    /* OBJ_name_constraints             2 5 29 30 */
-     103,    /* OBJ_crl_distribution_points      2 5 29 31 */
-      89,    /* OBJ_certificate_policies         2 5 29 32 */
+       0,
+       0,
+       0,
+     843,    /* OBJ_id_GostR3410_2001_CryptoPro_XchA_ParamSet 1 2 643 2 2 36 0 */
+       0,
+       0,
+       0,
+     521,    /* OBJ_setct_PANOnly                2 23 42 0 2 */
+     801,    /* OBJ_hmacWithSHA512               1 2 840 113549 2 11 */
+       0,
+       0,
+       0,
+       0,
+       0,
+       0,
+       0,
+     221,    /* OBJ_id_smime_aa_contentReference 1 2 840 113549 1 9 16 2 10 */
+     357,    /* OBJ_id_aca_group                 1 3 6 1 5 5 7 10 4 */
+       0,
+       0,
+     278,    /* OBJ_id_mod_qualified_cert_88     1 3 6 1 5 5 7 0 10 */
+       0,
+     571,    /* OBJ_setct_AuthResTBE             2 23 42 0 53 */
+     588,    /* OBJ_setct_CredResTBE             2 23 42 0 70 */
+    1161,    /* OBJ_uacurve1                     1 2 804 2 1 1 1 1 3 1 1 2 1 */
+       0,
+      30,    /* OBJ_des_cfb64                    1 3 14 3 2 9 */
+     597,    /* OBJ_setct_CertResTBE             2 23 42 0 79 */
+       0,
+       0,
+       0,
+       0,
+       0,
+       0,
+     569,    /* OBJ_setct_PIUnsignedTBE          2 23 42 0 51 */
+       0,
+     129,    /* OBJ_server_auth                  1 3 6 1 5 5 7 3 1 */
+     799,    /* OBJ_hmacWithSHA256               1 2 840 113549 2 9 */
+     506,    /* OBJ_mime_mhs_bodies              1 3 6 1 7 1 2 */
+     895,    /* OBJ_aes_128_gcm                  2 16 840 1 101 3 4 1 6 */
+     238,    /* OBJ_id_smime_aa_ets_archiveTimeStamp 1 2 840 113549 1 9 16 2 27 */
+     997,    /* OBJ_id_tc26_gost_3410_2012_512_paramSetTest 1 2 643 7 1 2 1 2 0 */
+       0,
+       0,
+       0,
+       0,
+    1089,    /* OBJ_organizationIdentifier       2 5 4 97 */
+     593,    /* OBJ_setct_BatchAdminResTBE       2 23 42 0 75 */
      747,    /* OBJ_policy_mappings              2 5 29 33 */
-      90,    /* OBJ_authority_key_identifier     2 5 29 35 */
-     401,    /* OBJ_policy_constraints           2 5 29 36 */
-     126,    /* OBJ_ext_key_usage                2 5 29 37 */
-     857,    /* OBJ_freshest_crl                 2 5 29 46 */
-     748,    /* OBJ_inhibit_any_policy           2 5 29 54 */
-     402,    /* OBJ_target_information           2 5 29 55 */
-     403,    /* OBJ_no_rev_avail                 2 5 29 56 */
-     513,    /* OBJ_set_ctype                    2 23 42 0 */
-     514,    /* OBJ_set_msgExt                   2 23 42 1 */
+       0,
+     178,    /* OBJ_ad_OCSP                      1 3 6 1 5 5 7 48 1 */
+       0,
+     113,    /* OBJ_dsaWithSHA1                  1 2 840 10040 4 3 */
+       0,
+     603,    /* OBJ_setext_pinSecure             2 23 42 1 4 */
+       0,
+     818,    /* OBJ_id_GostR3410_94DH            1 2 643 2 2 99 */
+     633,    /* OBJ_setAttr_T2cleartxt           2 23 42 3 3 4 2 */
+    1179,    /* OBJ_id_tc26_wrap                 1 2 643 7 1 1 7 */
+       0,
+       0,
+     583,    /* OBJ_setct_CapRevReqTBE           2 23 42 0 65 */
+       0,
+       0,
+       0,
+       0,
+    1170,    /* OBJ_ieee                         1 3 111 */
+     165,    /* OBJ_id_qt_unotice                1 3 6 1 5 5 7 2 2 */
+     740,    /* OBJ_wap_wsg_idm_ecid_wtls7       2 23 43 1 4 7 */
+       0,
+     726,    /* OBJ_sect233k1                    1 3 132 0 26 */
+       0,
+     429,    /* OBJ_aes_256_cfb128               2 16 840 1 101 3 4 1 44 */
+       0,
+     757,    /* OBJ_camellia_128_cfb128          0 3 4401 5 3 1 9 4 */
+       0,
+       0,
+    1110,    /* OBJ_dsa_with_SHA3_384            2 16 840 1 101 3 4 3 7 */
+     337,    /* OBJ_id_cmc_lraPOPWitness         1 3 6 1 5 5 7 7 11 */
+       0,
+     297,    /* OBJ_dvcs                         1 3 6 1 5 5 7 3 10 */
+     796,    /* OBJ_ecdsa_with_SHA512            1 2 840 10045 4 3 4 */
+       0,
+     314,    /* OBJ_id_regInfo                   1 3 6 1 5 5 7 5 2 */
+       0,
+       0,
+       0,
+       0,
+     704,    /* OBJ_secp112r1                    1 3 132 0 6 */
+    1168,    /* OBJ_uacurve8                     1 2 804 2 1 1 1 1 3 1 1 2 8 */
+       0,
+     159,    /* OBJ_sdsiCertificate              1 2 840 113549 1 9 22 2 */
+    1024,    /* OBJ_capwapWTP                    1 3 6 1 5 5 7 3 19 */
+       0,
+       0,
+       0,
+     362,    /* OBJ_id_cct_PKIResponse           1 3 6 1 5 5 7 12 3 */
+       0,
+     340,    /* OBJ_id_cmc_revokeRequest         1 3 6 1 5 5 7 7 17 */
+       0,
+       0,
+     247,    /* OBJ_id_smime_alg_CMSRC2wrap      1 2 840 113549 1 9 16 3 7 */
+       0,
+      22,    /* OBJ_pkcs7_signed                 1 2 840 113549 1 7 2 */
+     783,    /* OBJ_id_DHBasedMac                1 2 840 113533 7 66 30 */
+     707,    /* OBJ_secp128r2                    1 3 132 0 29 */
+     347,    /* OBJ_id_on_personalData           1 3 6 1 5 5 7 8 1 */
+     177,    /* OBJ_info_access                  1 3 6 1 5 5 7 1 1 */
+       0,
+     940,    /* OBJ_dhSinglePass_stdDH_sha512kdf_scheme 1 3 132 1 11 3 */
+       0,
+       0,
+     587,    /* OBJ_setct_CredReqTBEX            2 23 42 0 69 */
+     978,    /* OBJ_id_tc26_sign                 1 2 643 7 1 1 1 */
+     727,    /* OBJ_sect233r1                    1 3 132 0 27 */
+    1233,    /* OBJ_p521_dilithium5              1 3 9999 2 7 4 */
+       0,
+       0,
+     170,    /* OBJ_pbeWithSHA1AndDES_CBC        1 2 840 113549 1 5 10 */
+     274,    /* OBJ_id_mod_cmc                   1 3 6 1 5 5 7 0 6 */
+       0,
+       0,
+       0,
+     881,    /* OBJ_cACertificate                2 5 4 37 */
+       0,
+       0,
+       0,
+     271,    /* OBJ_id_pkix1_explicit_93         1 3 6 1 5 5 7 0 3 */
+       0,
+       0,
+     529,    /* OBJ_setct_AuthRevResBaggage      2 23 42 0 10 */
+     896,    /* OBJ_aes_128_ccm                  2 16 840 1 101 3 4 1 7 */
+     562,    /* OBJ_setct_RegFormResTBS          2 23 42 0 44 */
+       0,
      515,    /* OBJ_set_attr                     2 23 42 3 */
-     516,    /* OBJ_set_policy                   2 23 42 5 */
-     517,    /* OBJ_set_certExt                  2 23 42 7 */
-     518,    /* OBJ_set_brand                    2 23 42 8 */
-     679,    /* OBJ_wap_wsg                      2 23 43 1 */
-     382,    /* OBJ_Directory                    1 3 6 1 1 */
-     383,    /* OBJ_Management                   1 3 6 1 2 */
-     384,    /* OBJ_Experimental                 1 3 6 1 3 */
-     385,    /* OBJ_Private                      1 3 6 1 4 */
-     386,    /* OBJ_Security                     1 3 6 1 5 */
-     387,    /* OBJ_SNMPv2                       1 3 6 1 6 */
-     388,    /* OBJ_Mail                         1 3 6 1 7 */
-     376,    /* OBJ_algorithm                    1 3 14 3 2 */
-     395,    /* OBJ_clearance                    2 5 1 5 55 */
-      19,    /* OBJ_rsa                          2 5 8 1 1 */
-      96,    /* OBJ_mdc2WithRSA                  2 5 8 3 100 */
-      95,    /* OBJ_mdc2                         2 5 8 3 101 */
-     746,    /* OBJ_any_policy                   2 5 29 32 0 */
-     910,    /* OBJ_anyExtendedKeyUsage          2 5 29 37 0 */
-     519,    /* OBJ_setct_PANData                2 23 42 0 0 */
-     520,    /* OBJ_setct_PANToken               2 23 42 0 1 */
-     521,    /* OBJ_setct_PANOnly                2 23 42 0 2 */
-     522,    /* OBJ_setct_OIData                 2 23 42 0 3 */
-     523,    /* OBJ_setct_PI                     2 23 42 0 4 */
-     524,    /* OBJ_setct_PIData                 2 23 42 0 5 */
-     525,    /* OBJ_setct_PIDataUnsigned         2 23 42 0 6 */
-     526,    /* OBJ_setct_HODInput               2 23 42 0 7 */
-     527,    /* OBJ_setct_AuthResBaggage         2 23 42 0 8 */
-     528,    /* OBJ_setct_AuthRevReqBaggage      2 23 42 0 9 */
-     529,    /* OBJ_setct_AuthRevResBaggage      2 23 42 0 10 */
+       0,
+       0,
+       0,
+     427,    /* OBJ_aes_256_cbc                  2 16 840 1 101 3 4 1 42 */
+    1026,    /* OBJ_sshServer                    1 3 6 1 5 5 7 3 22 */
+       0,
+       0,
+       0,
+    1109,    /* OBJ_dsa_with_SHA3_256            2 16 840 1 101 3 4 3 6 */
+     335,    /* OBJ_id_cmc_encryptedPOP          1 3 6 1 5 5 7 7 9 */
+       0,
+       0,
+       0,
+       0,
+       0,
+     495,    /* OBJ_dSAQuality                   0 9 2342 19200300 100 1 49 */
+       0,
      530,    /* OBJ_setct_CapTokenSeq            2 23 42 0 11 */
-     531,    /* OBJ_setct_PInitResData           2 23 42 0 12 */
-     532,    /* OBJ_setct_PI_TBS                 2 23 42 0 13 */
-     533,    /* OBJ_setct_PResData               2 23 42 0 14 */
-     534,    /* OBJ_setct_AuthReqTBS             2 23 42 0 16 */
-     535,    /* OBJ_setct_AuthResTBS             2 23 42 0 17 */
-     536,    /* OBJ_setct_AuthResTBSX            2 23 42 0 18 */
-     537,    /* OBJ_setct_AuthTokenTBS           2 23 42 0 19 */
-     538,    /* OBJ_setct_CapTokenData           2 23 42 0 20 */
-     539,    /* OBJ_setct_CapTokenTBS            2 23 42 0 21 */
-     540,    /* OBJ_setct_AcqCardCodeMsg         2 23 42 0 22 */
-     541,    /* OBJ_setct_AuthRevReqTBS          2 23 42 0 23 */
-     542,    /* OBJ_setct_AuthRevResData         2 23 42 0 24 */
+     307,    /* OBJ_id_it_keyPairParamReq        1 3 6 1 5 5 7 4 10 */
+     484,    /* OBJ_associatedDomain             0 9 2342 19200300 100 1 37 */
+     296,    /* OBJ_ipsecUser                    1 3 6 1 5 5 7 3 7 */
+     582,    /* OBJ_setct_CapResTBE              2 23 42 0 64 */
+     369,    /* OBJ_id_pkix_OCSP_noCheck         1 3 6 1 5 5 7 48 1 5 */
+       0,
+    1237,    /* OBJ_falcon1024                   1 3 9999 3 9 */
+    1022,    /* OBJ_ipsec_IKE                    1 3 6 1 5 5 7 3 17 */
+       0,
+       0,
+       0,
+       0,
+     295,    /* OBJ_ipsecTunnel                  1 3 6 1 5 5 7 3 6 */
+     767,    /* OBJ_camellia_192_ofb128          0 3 4401 5 3 1 9 23 */
+       0,
+       0,
+    1008,    /* OBJ_issuerSignTool               1 2 643 100 112 */
+    1235,    /* OBJ_p256_falcon512               1 3 9999 3 7 */
+     882,    /* OBJ_authorityRevocationList      2 5 4 38 */
+       0,
+       0,
+    1118,    /* OBJ_RSA_SHA3_384                 2 16 840 1 101 3 4 3 15 */
+       0,
+    1173,    /* OBJ_id_tc26_cipher_gostr3412_2015_magma 1 2 643 7 1 1 5 1 */
+     210,    /* OBJ_id_smime_ct_DVCSRequestData  1 2 840 113549 1 9 16 1 7 */
+       0,
+     154,    /* OBJ_secretBag                    1 2 840 113549 1 12 10 1 5 */
+       0,
+    1232,    /* OBJ_dilithium5                   1 3 6 1 4 1 2 267 7 8 7 */
+       0,
+       0,
+     784,    /* OBJ_id_it_suppLangTags           1 3 6 1 5 5 7 4 16 */
+     131,    /* OBJ_code_sign                    1 3 6 1 5 5 7 3 3 */
+     578,    /* OBJ_setct_AuthRevResTBE          2 23 42 0 60 */
+       0,
+     852,    /* OBJ_id_GostR3411_94_with_GostR3410_94_cc 1 2 643 2 9 1 3 3 */
+       0,
+       0,
+       0,
+       0,
+    1160,    /* OBJ_uacurve0                     1 2 804 2 1 1 1 1 3 1 1 2 0 */
+     290,    /* OBJ_sbgp_ipAddrBlock             1 3 6 1 5 5 7 1 7 */
+       0,
+     258,    /* OBJ_id_pkix_mod                  1 3 6 1 5 5 7 0 */
+     923,    /* OBJ_brainpoolP192r1              1 3 36 3 3 2 8 1 1 3 */
+       0,
+     216,    /* OBJ_id_smime_aa_msgSigDigest     1 2 840 113549 1 9 16 2 5 */
+       0,
+       0,
+       0,
+    1068,    /* OBJ_aria_128_ofb128              1 2 410 200046 1 1 4 */
+     224,    /* OBJ_id_smime_aa_smimeEncryptCerts 1 2 840 113549 1 9 16 2 13 */
+     708,    /* OBJ_secp160k1                    1 3 132 0 9 */
+       0,
+     920,    /* OBJ_dhpublicnumber               1 2 840 10046 2 1 */
+       0,
+     697,    /* OBJ_X9_62_c2onb239v4             1 2 840 10045 3 0 14 */
+     777,    /* OBJ_seed_cbc                     1 2 410 200004 1 4 */
+     792,    /* OBJ_ecdsa_with_Specified         1 2 840 10045 4 3 */
+     865,    /* OBJ_telexNumber                  2 5 4 21 */
+      76,    /* OBJ_netscape_ca_policy_url       2 16 840 1 113730 1 8 */
+     273,    /* OBJ_id_mod_crmf                  1 3 6 1 5 5 7 0 5 */
+     436,    /* OBJ_ucl                          0 9 2342 19200300 */
+       0,
+       0,
+       0,
+       0,
+     419,    /* OBJ_aes_128_cbc                  2 16 840 1 101 3 4 1 2 */
+       0,
+       0,
+     580,    /* OBJ_setct_CapReqTBE              2 23 42 0 62 */
+     885,    /* OBJ_enhancedSearchGuide          2 5 4 47 */
+       0,
+       0,
+       0,
+     961,    /* OBJ_camellia_128_gcm             0 3 4401 5 3 1 9 6 */
      543,    /* OBJ_setct_AuthRevResTBS          2 23 42 0 25 */
-     544,    /* OBJ_setct_CapReqTBS              2 23 42 0 26 */
-     545,    /* OBJ_setct_CapReqTBSX             2 23 42 0 27 */
-     546,    /* OBJ_setct_CapResData             2 23 42 0 28 */
-     547,    /* OBJ_setct_CapRevReqTBS           2 23 42 0 29 */
-     548,    /* OBJ_setct_CapRevReqTBSX          2 23 42 0 30 */
-     549,    /* OBJ_setct_CapRevResData          2 23 42 0 31 */
-     550,    /* OBJ_setct_CredReqTBS             2 23 42 0 32 */
-     551,    /* OBJ_setct_CredReqTBSX            2 23 42 0 33 */
-     552,    /* OBJ_setct_CredResData            2 23 42 0 34 */
-     553,    /* OBJ_setct_CredRevReqTBS          2 23 42 0 35 */
-     554,    /* OBJ_setct_CredRevReqTBSX         2 23 42 0 36 */
-     555,    /* OBJ_setct_CredRevResData         2 23 42 0 37 */
-     556,    /* OBJ_setct_PCertReqData           2 23 42 0 38 */
-     557,    /* OBJ_setct_PCertResTBS            2 23 42 0 39 */
-     558,    /* OBJ_setct_BatchAdminReqData      2 23 42 0 40 */
-     559,    /* OBJ_setct_BatchAdminResData      2 23 42 0 41 */
-     560,    /* OBJ_setct_CardCInitResTBS        2 23 42 0 42 */
-     561,    /* OBJ_setct_MeAqCInitResTBS        2 23 42 0 43 */
-     562,    /* OBJ_setct_RegFormResTBS          2 23 42 0 44 */
-     563,    /* OBJ_setct_CertReqData            2 23 42 0 45 */
-     564,    /* OBJ_setct_CertReqTBS             2 23 42 0 46 */
-     565,    /* OBJ_setct_CertResData            2 23 42 0 47 */
-     566,    /* OBJ_setct_CertInqReqTBS          2 23 42 0 48 */
-     567,    /* OBJ_setct_ErrorTBS               2 23 42 0 49 */
-     568,    /* OBJ_setct_PIDualSignedTBE        2 23 42 0 50 */
-     569,    /* OBJ_setct_PIUnsignedTBE          2 23 42 0 51 */
-     570,    /* OBJ_setct_AuthReqTBE             2 23 42 0 52 */
-     571,    /* OBJ_setct_AuthResTBE             2 23 42 0 53 */
+       0,
+     789,    /* OBJ_id_aes192_wrap               2 16 840 1 101 3 4 1 25 */
+     486,    /* OBJ_homePostalAddress            0 9 2342 19200300 100 1 39 */
+       0,
+     245,    /* OBJ_id_smime_alg_ESDH            1 2 840 113549 1 9 16 3 5 */
+       0,
+     144,    /* OBJ_pbe_WithSHA1And128BitRC4     1 2 840 113549 1 12 1 1 */
+       0,
+     598,    /* OBJ_setct_CRLNotificationTBS     2 23 42 0 80 */
+    1151,    /* OBJ_ua_pki                       1 2 804 2 1 1 1 */
+       0,
+     476,    /* OBJ_lastModifiedTime             0 9 2342 19200300 100 1 23 */
+       0,
+    1122,    /* OBJ_aria_256_ccm                 1 2 410 200046 1 1 39 */
+     243,    /* OBJ_id_smime_alg_3DESwrap        1 2 840 113549 1 9 16 3 3 */
+       0,
+       0,
+       0,
+       0,
+    1229,    /* OBJ_rsa3072_dilithium2           1 3 9999 2 7 2 */
+       0,
+     214,    /* OBJ_id_smime_aa_mlExpandHistory  1 2 840 113549 1 9 16 2 3 */
+     424,    /* OBJ_aes_192_ofb128               2 16 840 1 101 3 4 1 23 */
+       0,
+       0,
+       0,
+       0,
+       0,
+     624,    /* OBJ_set_rootKeyThumb             2 23 42 3 0 0 */
+     540,    /* OBJ_setct_AcqCardCodeMsg         2 23 42 0 22 */
+       0,
+     876,    /* OBJ_owner                        2 5 4 32 */
+    1059,    /* OBJ_id_smime_ct_authEnvelopedData 1 2 840 113549 1 9 16 1 23 */
+       0,
+     413,    /* OBJ_X9_62_prime239v2             1 2 840 10045 3 1 5 */
+    1028,    /* OBJ_sendProxiedRouter            1 3 6 1 5 5 7 3 24 */
+       0,
+     348,    /* OBJ_id_pda_dateOfBirth           1 3 6 1 5 5 7 9 1 */
+     359,    /* OBJ_id_qcs_pkixQCSyntax_v1       1 3 6 1 5 5 7 11 1 */
+       0,
+     194,    /* OBJ_id_smime_spq                 1 2 840 113549 1 9 16 5 */
+       0,
+     872,    /* OBJ_preferredDeliveryMethod      2 5 4 28 */
+       0,
+     161,    /* OBJ_pbes2                        1 2 840 113549 1 5 13 */
+     500,    /* OBJ_dITRedirect                  0 9 2342 19200300 100 1 54 */
+       0,
+     398,    /* OBJ_sinfo_access                 1 3 6 1 5 5 7 1 11 */
+       0,
+     304,    /* OBJ_id_it_unsupportedOIDs        1 3 6 1 5 5 7 4 7 */
+       0,
+     809,    /* OBJ_id_GostR3411_94              1 2 643 2 2 9 */
+       0,
+     241,    /* OBJ_id_smime_alg_ESDHwith3DES    1 2 840 113549 1 9 16 3 1 */
+     850,    /* OBJ_id_GostR3410_94_cc           1 2 643 2 9 1 5 3 */
+    1111,    /* OBJ_dsa_with_SHA3_512            2 16 840 1 101 3 4 3 8 */
+       0,
+       0,
+     522,    /* OBJ_setct_OIData                 2 23 42 0 3 */
+       0,
+     634,    /* OBJ_setAttr_TokICCsig            2 23 42 3 3 5 1 */
+       0,
+       0,
+     135,    /* OBJ_ms_code_com                  1 3 6 1 4 1 311 2 1 22 */
+       0,
+     985,    /* OBJ_id_tc26_signwithdigest_gost3410_2012_256 1 2 643 7 1 1 3 2 */
+     919,    /* OBJ_rsaesOaep                    1 2 840 113549 1 1 7 */
+       0,
+       0,
+     642,    /* OBJ_set_brand_Novus              2 23 42 8 6011 */
+       0,
+      84,    /* OBJ_private_key_usage_period     2 5 29 16 */
+    1149,    /* OBJ_id_tc26_gost_3410_2012_512_paramSetC 1 2 643 7 1 2 1 2 3 */
+     448,    /* OBJ_room                         0 9 2342 19200300 100 4 7 */
+       0,
+     888,    /* OBJ_uniqueMember                 2 5 4 50 */
+       0,
+       0,
+    1134,    /* OBJ_sm4_cbc                      1 2 156 10197 1 104 2 */
+     440,    /* OBJ_pilotObjectClass             0 9 2342 19200300 100 4 */
+     901,    /* OBJ_aes_256_gcm                  2 16 840 1 101 3 4 1 46 */
+       3,    /* OBJ_md2                          1 2 840 113549 2 2 */
+       0,
+       0,
+     526,    /* OBJ_setct_HODInput               2 23 42 0 7 */
+       0,
+     577,    /* OBJ_setct_AuthRevReqTBE          2 23 42 0 59 */
+       0,
+      83,    /* OBJ_key_usage                    2 5 29 15 */
+       0,
+     819,    /* OBJ_id_Gost28147_89_CryptoPro_KeyMeshing 1 2 643 2 2 14 1 */
+    1143,    /* OBJ_sm3                          1 2 156 10197 1 401 */
+       0,
+       0,
+     886,    /* OBJ_protocolInformation          2 5 4 48 */
+       0,
+     322,    /* OBJ_id_regInfo_certReq           1 3 6 1 5 5 7 5 2 2 */
+     722,    /* OBJ_sect163r1                    1 3 132 0 2 */
+     443,    /* OBJ_caseIgnoreIA5StringSyntax    0 9 2342 19200300 100 3 5 */
+       0,
+       0,
+      37,    /* OBJ_rc2_cbc                      1 2 840 113549 3 2 */
+     810,    /* OBJ_id_HMACGostR3411_94          1 2 643 2 2 10 */
+    1030,    /* OBJ_sendProxiedOwner             1 3 6 1 5 5 7 3 26 */
+    1262,    /* OBJ_blake2bmac                   1 3 6 1 4 1 1722 12 2 1 */
+       0,
+       6,    /* OBJ_rsaEncryption                1 2 840 113549 1 1 1 */
+       0,
+       0,
+    1158,    /* OBJ_dstu4145le                   1 2 804 2 1 1 1 1 3 1 1 */
+       0,
+     621,    /* OBJ_setAttr_PGWYcap              2 23 42 3 1 */
+       0,
+     361,    /* OBJ_id_cct_PKIData               1 3 6 1 5 5 7 12 2 */
+       0,
      572,    /* OBJ_setct_AuthResTBEX            2 23 42 0 54 */
-     573,    /* OBJ_setct_AuthTokenTBE           2 23 42 0 55 */
-     574,    /* OBJ_setct_CapTokenTBE            2 23 42 0 56 */
+       0,
+       0,
+       0,
+     457,    /* OBJ_qualityLabelledData          0 9 2342 19200300 100 4 22 */
+     386,    /* OBJ_Security                     1 3 6 1 5 */
+       0,
+    1078,    /* OBJ_aria_256_ofb128              1 2 410 200046 1 1 14 */
+     339,    /* OBJ_id_cmc_getCRL                1 3 6 1 5 5 7 7 16 */
+     674,    /* OBJ_sha512                       2 16 840 1 101 3 4 2 3 */
+       0,
+       0,
+       0,
+       0,
+       0,
+       0,
+     376,    /* OBJ_algorithm                    1 3 14 3 2 */
+     790,    /* OBJ_id_aes256_wrap               2 16 840 1 101 3 4 1 45 */
+     415,    /* OBJ_X9_62_prime256v1             1 2 840 10045 3 1 7 */
+    1231,    /* OBJ_p384_dilithium3              1 3 9999 2 7 3 */
+       0,
+     479,    /* OBJ_pilotAttributeType27         0 9 2342 19200300 100 1 27 */
+    1133,    /* OBJ_sm4_ecb                      1 2 156 10197 1 104 1 */
+       0,
+     935,    /* OBJ_pSpecified                   1 2 840 113549 1 1 9 */
+     360,    /* OBJ_id_cct_crs                   1 3 6 1 5 5 7 12 1 */
+       0,
+     315,    /* OBJ_id_regCtrl_regToken          1 3 6 1 5 5 7 5 1 1 */
+       0,
+      51,    /* OBJ_pkcs9_messageDigest          1 2 840 113549 1 9 4 */
+     625,    /* OBJ_set_addPolicy                2 23 42 3 0 1 */
+    1150,    /* OBJ_ISO_UA                       1 2 804 */
+       0,
+      45,    /* OBJ_des_ofb64                    1 3 14 3 2 8 */
+     309,    /* OBJ_id_it_revPassphrase          1 3 6 1 5 5 7 4 12 */
+     856,    /* OBJ_LocalKeySet                  1 3 6 1 4 1 311 17 2 */
+     998,    /* OBJ_id_tc26_gost_3410_2012_512_paramSetA 1 2 643 7 1 2 1 2 1 */
+     756,    /* OBJ_camellia_256_ecb             0 3 4401 5 3 1 9 41 */
+     842,    /* OBJ_id_GostR3410_2001_CryptoPro_C_ParamSet 1 2 643 2 2 35 3 */
+       0,
+     373,    /* OBJ_id_pkix_OCSP_valid           1 3 6 1 5 5 7 48 1 9 */
+       0,
+     628,    /* OBJ_setAttr_IssCap_CVM           2 23 42 3 3 3 */
+       0,
+     268,    /* OBJ_id_cct                       1 3 6 1 5 5 7 12 */
+       0,
+       0,
+     970,    /* OBJ_camellia_256_ccm             0 3 4401 5 3 1 9 47 */
+     293,    /* OBJ_textNotice                   1 3 6 1 5 5 7 2 3 */
+     713,    /* OBJ_secp224r1                    1 3 132 0 33 */
+     565,    /* OBJ_setct_CertResData            2 23 42 0 47 */
+     798,    /* OBJ_hmacWithSHA224               1 2 840 113549 2 8 */
+     452,    /* OBJ_domainRelatedObject          0 9 2342 19200300 100 4 17 */
+    1066,    /* OBJ_aria_128_cbc                 1 2 410 200046 1 1 2 */
+     442,    /* OBJ_iA5StringSyntax              0 9 2342 19200300 100 3 4 */
+     269,    /* OBJ_id_pkix1_explicit_88         1 3 6 1 5 5 7 0 1 */
      575,    /* OBJ_setct_CapTokenTBEX           2 23 42 0 57 */
-     576,    /* OBJ_setct_AcqCardCodeMsgTBE      2 23 42 0 58 */
-     577,    /* OBJ_setct_AuthRevReqTBE          2 23 42 0 59 */
-     578,    /* OBJ_setct_AuthRevResTBE          2 23 42 0 60 */
-     579,    /* OBJ_setct_AuthRevResTBEB         2 23 42 0 61 */
-     580,    /* OBJ_setct_CapReqTBE              2 23 42 0 62 */
-     581,    /* OBJ_setct_CapReqTBEX             2 23 42 0 63 */
-     582,    /* OBJ_setct_CapResTBE              2 23 42 0 64 */
-     583,    /* OBJ_setct_CapRevReqTBE           2 23 42 0 65 */
-     584,    /* OBJ_setct_CapRevReqTBEX          2 23 42 0 66 */
-     585,    /* OBJ_setct_CapRevResTBE           2 23 42 0 67 */
-     586,    /* OBJ_setct_CredReqTBE             2 23 42 0 68 */
-     587,    /* OBJ_setct_CredReqTBEX            2 23 42 0 69 */
-     588,    /* OBJ_setct_CredResTBE             2 23 42 0 70 */
-     589,    /* OBJ_setct_CredRevReqTBE          2 23 42 0 71 */
-     590,    /* OBJ_setct_CredRevReqTBEX         2 23 42 0 72 */
+     741,    /* OBJ_wap_wsg_idm_ecid_wtls8       2 23 43 1 4 8 */
+     381,    /* OBJ_iana                         1 3 6 1 */
+     306,    /* OBJ_id_it_subscriptionResponse   1 3 6 1 5 5 7 4 9 */
+       0,
+       0,
+       0,
+     607,    /* OBJ_set_policy_root              2 23 42 5 0 */
+       0,
+     489,    /* OBJ_pagerTelephoneNumber         0 9 2342 19200300 100 1 42 */
+     200,    /* OBJ_id_smime_mod_ets_eSignature_88 1 2 840 113549 1 9 16 0 5 */
+     341,    /* OBJ_id_cmc_regInfo               1 3 6 1 5 5 7 7 18 */
+       0,
+       0,
+       0,
+     414,    /* OBJ_X9_62_prime239v3             1 2 840 10045 3 1 6 */
+     684,    /* OBJ_X9_62_c2pnb163v1             1 2 840 10045 3 0 1 */
+      41,    /* OBJ_sha                          1 3 14 3 2 18 */
+       0,
+       0,
+    1094,    /* OBJ_sha512_224                   2 16 840 1 101 3 4 2 5 */
+    1074,    /* OBJ_aria_192_ctr                 1 2 410 200046 1 1 10 */
+       0,
+    1166,    /* OBJ_uacurve6                     1 2 804 2 1 1 1 1 3 1 1 2 6 */
+       0,
+      69,    /* OBJ_id_pbkdf2                    1 2 840 113549 1 5 12 */
+     325,    /* OBJ_id_alg_dh_sig_hmac_sha1      1 3 6 1 5 5 7 6 3 */
+       0,
+    1123,    /* OBJ_aria_128_gcm                 1 2 410 200046 1 1 34 */
+       0,
+     979,    /* OBJ_id_GostR3410_2012_256        1 2 643 7 1 1 1 1 */
+       0,
+       0,
+     541,    /* OBJ_setct_AuthRevReqTBS          2 23 42 0 23 */
+       0,
+       0,
+     862,    /* OBJ_postOfficeBox                2 5 4 18 */
+       0,
+     670,    /* OBJ_sha512WithRSAEncryption      1 2 840 113549 1 1 13 */
+       0,
+     797,    /* OBJ_hmacWithMD5                  1 2 840 113549 2 6 */
+       0,
+       0,
+    1102,    /* OBJ_hmac_sha3_224                2 16 840 1 101 3 4 2 13 */
+       0,
+    1185,    /* OBJ_id_tc26_gost_3410_2012_256_paramSetC 1 2 643 7 1 2 1 1 3 */
+       0,
+    1193,    /* OBJ_hmacWithSHA512_224           1 2 840 113549 2 12 */
+     900,    /* OBJ_id_aes192_wrap_pad           2 16 840 1 101 3 4 1 28 */
+       0,
+     630,    /* OBJ_setAttr_IssCap_Sig           2 23 42 3 3 5 */
+       0,
+     103,    /* OBJ_crl_distribution_points      2 5 29 31 */
+       0,
+       0,
+     140,    /* OBJ_delta_crl                    2 5 29 27 */
+     794,    /* OBJ_ecdsa_with_SHA256            1 2 840 10045 4 3 2 */
+     823,    /* OBJ_id_Gost28147_89_TestParamSet 1 2 643 2 2 31 0 */
+       0,
+    1092,    /* OBJ_dnsName                      2 5 4 100 */
+       0,
+       0,
+     748,    /* OBJ_inhibit_any_policy           2 5 29 54 */
+     211,    /* OBJ_id_smime_ct_DVCSResponseData 1 2 840 113549 1 9 16 1 8 */
+       0,
+     180,    /* OBJ_OCSP_sign                    1 3 6 1 5 5 7 3 9 */
+       0,
+     497,    /* OBJ_subtreeMinimumQuality        0 9 2342 19200300 100 1 51 */
+       0,
+     491,    /* OBJ_organizationalStatus         0 9 2342 19200300 100 1 45 */
      591,    /* OBJ_setct_CredRevResTBE          2 23 42 0 73 */
-     592,    /* OBJ_setct_BatchAdminReqTBE       2 23 42 0 74 */
-     593,    /* OBJ_setct_BatchAdminResTBE       2 23 42 0 75 */
+     459,    /* OBJ_textEncodedORAddress         0 9 2342 19200300 100 1 2 */
+       0,
+    1171,    /* OBJ_ieee_siswg                   1 3 111 2 1619 */
+       0,
+       0,
+       0,
+     614,    /* OBJ_setCext_setQualf             2 23 42 7 6 */
+      49,    /* OBJ_pkcs9_unstructuredName       1 2 840 113549 1 9 2 */
+       0,
+     911,    /* OBJ_mgf1                         1 2 840 113549 1 1 8 */
+       0,
+     693,    /* OBJ_X9_62_c2pnb208w1             1 2 840 10045 3 0 10 */
+       0,
+     198,    /* OBJ_id_smime_mod_oid             1 2 840 113549 1 9 16 0 3 */
+     331,    /* OBJ_id_cmc_transactionId         1 3 6 1 5 5 7 7 5 */
+       0,
+       0,
+       0,
+     564,    /* OBJ_setct_CertReqTBS             2 23 42 0 46 */
+     838,    /* OBJ_id_GostR3410_94_CryptoPro_XchC_ParamSet 1 2 643 2 2 33 3 */
+     830,    /* OBJ_id_Gost28147_89_CryptoPro_RIC_1_ParamSet 1 2 643 2 2 31 7 */
+     237,    /* OBJ_id_smime_aa_ets_certCRLTimestamp 1 2 840 113549 1 9 16 2 26 */
+       0,
+       0,
+      54,    /* OBJ_pkcs9_challengePassword      1 2 840 113549 1 9 7 */
+     302,    /* OBJ_id_it_caKeyUpdateInfo        1 3 6 1 5 5 7 4 5 */
      594,    /* OBJ_setct_RegFormReqTBE          2 23 42 0 76 */
-     595,    /* OBJ_setct_CertReqTBE             2 23 42 0 77 */
+     300,    /* OBJ_id_it_encKeyPairTypes        1 3 6 1 5 5 7 4 3 */
+     663,    /* OBJ_proxyCertInfo                1 3 6 1 5 5 7 1 14 */
+       0,
+       0,
+       0,
+       0,
+     897,    /* OBJ_id_aes128_wrap_pad           2 16 840 1 101 3 4 1 8 */
+     100,    /* OBJ_surname                      2 5 4 4 */
+       0,
+     305,    /* OBJ_id_it_subscriptionRequest    1 3 6 1 5 5 7 4 8 */
+       0,
+       0,
+       0,
+    1246,    /* OBJ_p384_sphincssha2192fsimple   1 3 9999 6 5 11 */
+     365,    /* OBJ_id_pkix_OCSP_basic           1 3 6 1 5 5 7 48 1 1 */
+    1027,    /* OBJ_sendRouter                   1 3 6 1 5 5 7 3 23 */
+       0,
+     637,    /* OBJ_set_brand_Diners             2 23 42 8 30 */
+     428,    /* OBJ_aes_256_ofb128               2 16 840 1 101 3 4 1 43 */
+       0,
+       0,
+       0,
+       0,
+     312,    /* OBJ_id_it_origPKIMessage         1 3 6 1 5 5 7 4 15 */
+       0,
+    1070,    /* OBJ_aria_192_ecb                 1 2 410 200046 1 1 6 */
+     776,    /* OBJ_seed_ecb                     1 2 410 200004 1 3 */
+     547,    /* OBJ_setct_CapRevReqTBS           2 23 42 0 29 */
+    1157,    /* OBJ_dstu34311                    1 2 804 2 1 1 1 1 2 1 */
+     811,    /* OBJ_id_GostR3410_2001            1 2 643 2 2 19 */
+       0,
+       0,
+     791,    /* OBJ_ecdsa_with_Recommended       1 2 840 10045 4 2 */
+       0,
+       0,
+       0,
+       0,
+       0,
+       0,
      596,    /* OBJ_setct_CertReqTBEX            2 23 42 0 78 */
-     597,    /* OBJ_setct_CertResTBE             2 23 42 0 79 */
-     598,    /* OBJ_setct_CRLNotificationTBS     2 23 42 0 80 */
-     599,    /* OBJ_setct_CRLNotificationResTBS  2 23 42 0 81 */
-     600,    /* OBJ_setct_BCIDistributionTBS     2 23 42 0 82 */
+      14,    /* OBJ_countryName                  2 5 4 6 */
+       0,
+     710,    /* OBJ_secp160r2                    1 3 132 0 30 */
+    1025,    /* OBJ_sshClient                    1 3 6 1 5 5 7 3 21 */
+    1003,    /* OBJ_id_tc26_gost_28147_param_Z   1 2 643 7 1 2 5 1 1 */
+     887,    /* OBJ_distinguishedName            2 5 4 49 */
+       0,
+       0,
+     184,    /* OBJ_X9_57                        1 2 840 10040 */
+       0,
+       0,
+     535,    /* OBJ_setct_AuthResTBS             2 23 42 0 17 */
+     558,    /* OBJ_setct_BatchAdminReqData      2 23 42 0 40 */
+     232,    /* OBJ_id_smime_aa_ets_CertificateRefs 1 2 840 113549 1 9 16 2 21 */
+     689,    /* OBJ_X9_62_c2tnb191v2             1 2 840 10045 3 0 6 */
+       0,
      601,    /* OBJ_setext_genCrypt              2 23 42 1 1 */
+       0,
+     480,    /* OBJ_mXRecord                     0 9 2342 19200300 100 1 28 */
+       0,
+     366,    /* OBJ_id_pkix_OCSP_Nonce           1 3 6 1 5 5 7 48 1 2 */
+       0,
+       0,
+       0,
+       0,
+     502,    /* OBJ_documentPublisher            0 9 2342 19200300 100 1 56 */
+     840,    /* OBJ_id_GostR3410_2001_CryptoPro_A_ParamSet 1 2 643 2 2 35 1 */
      602,    /* OBJ_setext_miAuth                2 23 42 1 3 */
-     603,    /* OBJ_setext_pinSecure             2 23 42 1 4 */
-     604,    /* OBJ_setext_pinAny                2 23 42 1 5 */
+     261,    /* OBJ_id_pkip                      1 3 6 1 5 5 7 5 */
+       0,
+     631,    /* OBJ_setAttr_GenCryptgrm          2 23 42 3 3 3 1 */
+       0,
+     567,    /* OBJ_setct_ErrorTBS               2 23 42 0 49 */
+    1178,    /* OBJ_id_tc26_cipher_gostr3412_2015_kuznyechik_ctracpkm_omac 1 2 643 7 1 1 5 2 2 */
+     925,    /* OBJ_brainpoolP224r1              1 3 36 3 3 2 8 1 1 5 */
+       0,
+     318,    /* OBJ_id_regCtrl_pkiArchiveOptions 1 3 6 1 5 5 7 5 1 4 */
+     441,    /* OBJ_pilotGroups                  0 9 2342 19200300 100 10 */
+      68,    /* OBJ_pbeWithSHA1AndRC2_CBC        1 2 840 113549 1 5 11 */
+     812,    /* OBJ_id_GostR3410_94              1 2 643 2 2 20 */
+       0,
+     680,    /* OBJ_X9_62_id_characteristic_two_basis 1 2 840 10045 1 2 3 */
+     570,    /* OBJ_setct_AuthReqTBE             2 23 42 0 52 */
+     407,    /* OBJ_X9_62_characteristic_two_field 1 2 840 10045 1 2 */
+       0,
+       0,
+       0,
+     410,    /* OBJ_X9_62_prime192v2             1 2 840 10045 3 1 2 */
+     291,    /* OBJ_sbgp_autonomousSysNum        1 3 6 1 5 5 7 1 8 */
+    1065,    /* OBJ_aria_128_ecb                 1 2 410 200046 1 1 1 */
+       0,
+     617,    /* OBJ_setCext_Track2Data           2 23 42 7 9 */
+     643,    /* OBJ_des_cdmf                     1 2 840 113549 3 10 */
+     550,    /* OBJ_setct_CredReqTBS             2 23 42 0 32 */
+     615,    /* OBJ_setCext_PGWYcapabilities     2 23 42 7 7 */
+    1142,    /* OBJ_sm_scheme                    1 2 156 10197 1 */
+     425,    /* OBJ_aes_192_cfb128               2 16 840 1 101 3 4 1 24 */
+      55,    /* OBJ_pkcs9_unstructuredAddress    1 2 840 113549 1 9 8 */
+     952,    /* OBJ_ct_precert_poison            1 3 6 1 4 1 11129 2 4 3 */
+       0,
+      91,    /* OBJ_bf_cbc                       1 3 6 1 4 1 3029 1 2 */
+       0,
+       0,
+       0,
+       0,
+     174,    /* OBJ_dnQualifier                  2 5 4 46 */
+     205,    /* OBJ_id_smime_ct_authData         1 2 840 113549 1 9 16 1 2 */
+       0,
+     176,    /* OBJ_id_ad                        1 3 6 1 5 5 7 48 */
+    1115,    /* OBJ_ecdsa_with_SHA3_512          2 16 840 1 101 3 4 3 12 */
+       0,
+       0,
+       0,
+     383,    /* OBJ_Management                   1 3 6 1 2 */
+     128,    /* OBJ_id_kp                        1 3 6 1 5 5 7 3 */
+     802,    /* OBJ_dsa_with_SHA224              2 16 840 1 101 3 4 3 1 */
+       0,
+     283,    /* OBJ_id_mod_dvcs                  1 3 6 1 5 5 7 0 15 */
+       0,
+     219,    /* OBJ_id_smime_aa_macValue         1 2 840 113549 1 9 16 2 8 */
+     754,    /* OBJ_camellia_128_ecb             0 3 4401 5 3 1 9 1 */
+     380,    /* OBJ_dod                          1 3 6 */
+      32,    /* OBJ_des_ede_ecb                  1 3 14 3 2 17 */
+       0,
+     934,    /* OBJ_brainpoolP512t1              1 3 36 3 3 2 8 1 1 14 */
+       0,
+       0,
+       0,
+     898,    /* OBJ_aes_192_gcm                  2 16 840 1 101 3 4 1 26 */
      605,    /* OBJ_setext_track2                2 23 42 1 7 */
-     606,    /* OBJ_setext_cv                    2 23 42 1 8 */
-     620,    /* OBJ_setAttr_Cert                 2 23 42 3 0 */
-     621,    /* OBJ_setAttr_PGWYcap              2 23 42 3 1 */
+       0,
+     673,    /* OBJ_sha384                       2 16 840 1 101 3 4 2 2 */
+     696,    /* OBJ_X9_62_c2tnb239v3             1 2 840 10045 3 0 13 */
+       0,
+     389,    /* OBJ_Enterprises                  1 3 6 1 4 1 */
+       0,
+     222,    /* OBJ_id_smime_aa_encrypKeyPref    1 2 840 113549 1 9 16 2 11 */
+     788,    /* OBJ_id_aes128_wrap               2 16 840 1 101 3 4 1 5 */
+     126,    /* OBJ_ext_key_usage                2 5 29 37 */
+     487,    /* OBJ_personalTitle                0 9 2342 19200300 100 1 40 */
+       0,
+     677,    /* OBJ_certicom_arc                 1 3 132 */
+     270,    /* OBJ_id_pkix1_implicit_88         1 3 6 1 5 5 7 0 2 */
+       0,
+       0,
+     445,    /* OBJ_pilotPerson                  0 9 2342 19200300 100 4 4 */
+     992,    /* OBJ_id_tc26_agreement_gost_3410_2012_256 1 2 643 7 1 1 6 1 */
+      47,    /* OBJ_pkcs9                        1 2 840 113549 1 9 */
+       0,
+     246,    /* OBJ_id_smime_alg_CMS3DESwrap     1 2 840 113549 1 9 16 3 6 */
+     566,    /* OBJ_setct_CertInqReqTBS          2 23 42 0 48 */
      622,    /* OBJ_setAttr_TokenType            2 23 42 3 2 */
-     623,    /* OBJ_setAttr_IssCap               2 23 42 3 3 */
-     607,    /* OBJ_set_policy_root              2 23 42 5 0 */
-     608,    /* OBJ_setCext_hashedRoot           2 23 42 7 0 */
-     609,    /* OBJ_setCext_certType             2 23 42 7 1 */
      610,    /* OBJ_setCext_merchData            2 23 42 7 2 */
-     611,    /* OBJ_setCext_cCertRequired        2 23 42 7 3 */
-     612,    /* OBJ_setCext_tunneling            2 23 42 7 4 */
-     613,    /* OBJ_setCext_setExt               2 23 42 7 5 */
-     614,    /* OBJ_setCext_setQualf             2 23 42 7 6 */
-     615,    /* OBJ_setCext_PGWYcapabilities     2 23 42 7 7 */
-     616,    /* OBJ_setCext_TokenIdentifier      2 23 42 7 8 */
-     617,    /* OBJ_setCext_Track2Data           2 23 42 7 9 */
-     618,    /* OBJ_setCext_TokenType            2 23 42 7 10 */
-     619,    /* OBJ_setCext_IssuerCapabilities   2 23 42 7 11 */
-     636,    /* OBJ_set_brand_IATA_ATA           2 23 42 8 1 */
-     640,    /* OBJ_set_brand_Visa               2 23 42 8 4 */
-     641,    /* OBJ_set_brand_MasterCard         2 23 42 8 5 */
-     637,    /* OBJ_set_brand_Diners             2 23 42 8 30 */
-     638,    /* OBJ_set_brand_AmericanExpress    2 23 42 8 34 */
-     639,    /* OBJ_set_brand_JCB                2 23 42 8 35 */
-    1141,    /* OBJ_oscca                        1 2 156 10197 */
-     805,    /* OBJ_cryptopro                    1 2 643 2 2 */
+       0,
+       0,
+       1,    /* OBJ_rsadsi                       1 2 840 113549 */
+     450,    /* OBJ_rFC822localPart              0 9 2342 19200300 100 4 14 */
+     185,    /* OBJ_X9cm                         1 2 840 10040 4 */
+     815,    /* OBJ_id_Gost28147_89_MAC          1 2 643 2 2 22 */
+       0,
+       0,
+     438,    /* OBJ_pilotAttributeType           0 9 2342 19200300 100 1 */
+    1099,    /* OBJ_sha3_512                     2 16 840 1 101 3 4 2 10 */
+     956,    /* OBJ_jurisdictionStateOrProvinceName 1 3 6 1 4 1 311 60 2 1 2 */
+     488,    /* OBJ_mobileTelephoneNumber        0 9 2342 19200300 100 1 41 */
      806,    /* OBJ_cryptocom                    1 2 643 2 9 */
-     974,    /* OBJ_id_tc26                      1 2 643 7 1 */
-    1005,    /* OBJ_OGRN                         1 2 643 100 1 */
-    1006,    /* OBJ_SNILS                        1 2 643 100 3 */
-    1007,    /* OBJ_subjectSignTool              1 2 643 100 111 */
-    1008,    /* OBJ_issuerSignTool               1 2 643 100 112 */
-     184,    /* OBJ_X9_57                        1 2 840 10040 */
-     405,    /* OBJ_ansi_X9_62                   1 2 840 10045 */
-     389,    /* OBJ_Enterprises                  1 3 6 1 4 1 */
-     504,    /* OBJ_mime_mhs                     1 3 6 1 7 1 */
-     104,    /* OBJ_md5WithRSA                   1 3 14 3 2 3 */
-      29,    /* OBJ_des_ecb                      1 3 14 3 2 6 */
-      31,    /* OBJ_des_cbc                      1 3 14 3 2 7 */
-      45,    /* OBJ_des_ofb64                    1 3 14 3 2 8 */
-      30,    /* OBJ_des_cfb64                    1 3 14 3 2 9 */
-     377,    /* OBJ_rsaSignature                 1 3 14 3 2 11 */
-      67,    /* OBJ_dsa_2                        1 3 14 3 2 12 */
-      66,    /* OBJ_dsaWithSHA                   1 3 14 3 2 13 */
-      42,    /* OBJ_shaWithRSAEncryption         1 3 14 3 2 15 */
-      32,    /* OBJ_des_ede_ecb                  1 3 14 3 2 17 */
-      41,    /* OBJ_sha                          1 3 14 3 2 18 */
-      64,    /* OBJ_sha1                         1 3 14 3 2 26 */
-      70,    /* OBJ_dsaWithSHA1_2                1 3 14 3 2 27 */
-     115,    /* OBJ_sha1WithRSA                  1 3 14 3 2 29 */
-     117,    /* OBJ_ripemd160                    1 3 36 3 2 1 */
-    1093,    /* OBJ_x509ExtAdmission             1 3 36 8 3 3 */
-     143,    /* OBJ_sxnet                        1 3 101 1 4 1 */
-    1171,    /* OBJ_ieee_siswg                   1 3 111 2 1619 */
-     721,    /* OBJ_sect163k1                    1 3 132 0 1 */
-     722,    /* OBJ_sect163r1                    1 3 132 0 2 */
-     728,    /* OBJ_sect239k1                    1 3 132 0 3 */
-     717,    /* OBJ_sect113r1                    1 3 132 0 4 */
-     718,    /* OBJ_sect113r2                    1 3 132 0 5 */
-     704,    /* OBJ_secp112r1                    1 3 132 0 6 */
-     705,    /* OBJ_secp112r2                    1 3 132 0 7 */
-     709,    /* OBJ_secp160r1                    1 3 132 0 8 */
-     708,    /* OBJ_secp160k1                    1 3 132 0 9 */
-     714,    /* OBJ_secp256k1                    1 3 132 0 10 */
-     723,    /* OBJ_sect163r2                    1 3 132 0 15 */
+    1172,    /* OBJ_sm2                          1 2 156 10197 1 301 */
+       0,
+       0,
+       0,
+       0,
+      74,    /* OBJ_netscape_ca_revocation_url   2 16 840 1 113730 1 4 */
+    1242,    /* OBJ_sphincssha2128ssimple        1 3 9999 6 4 16 */
+     699,    /* OBJ_X9_62_c2pnb272w1             1 2 840 10045 3 0 16 */
+     391,    /* OBJ_domainComponent              0 9 2342 19200300 100 1 25 */
+       0,
+     532,    /* OBJ_setct_PI_TBS                 2 23 42 0 13 */
      729,    /* OBJ_sect283k1                    1 3 132 0 16 */
-     730,    /* OBJ_sect283r1                    1 3 132 0 17 */
+       0,
      719,    /* OBJ_sect131r1                    1 3 132 0 22 */
-     720,    /* OBJ_sect131r2                    1 3 132 0 23 */
-     724,    /* OBJ_sect193r1                    1 3 132 0 24 */
-     725,    /* OBJ_sect193r2                    1 3 132 0 25 */
-     726,    /* OBJ_sect233k1                    1 3 132 0 26 */
-     727,    /* OBJ_sect233r1                    1 3 132 0 27 */
-     706,    /* OBJ_secp128r1                    1 3 132 0 28 */
-     707,    /* OBJ_secp128r2                    1 3 132 0 29 */
-     710,    /* OBJ_secp160r2                    1 3 132 0 30 */
-     711,    /* OBJ_secp192k1                    1 3 132 0 31 */
-     712,    /* OBJ_secp224k1                    1 3 132 0 32 */
-     713,    /* OBJ_secp224r1                    1 3 132 0 33 */
-     715,    /* OBJ_secp384r1                    1 3 132 0 34 */
-     716,    /* OBJ_secp521r1                    1 3 132 0 35 */
-     731,    /* OBJ_sect409k1                    1 3 132 0 36 */
-     732,    /* OBJ_sect409r1                    1 3 132 0 37 */
-     733,    /* OBJ_sect571k1                    1 3 132 0 38 */
-     734,    /* OBJ_sect571r1                    1 3 132 0 39 */
     1234,    /* OBJ_falcon512                    1 3 9999 3 6 */
-    1235,    /* OBJ_p256_falcon512               1 3 9999 3 7 */
-    1236,    /* OBJ_rsa3072_falcon512            1 3 9999 3 8 */
-    1237,    /* OBJ_falcon1024                   1 3 9999 3 9 */
-    1238,    /* OBJ_p521_falcon1024              1 3 9999 3 10 */
-     624,    /* OBJ_set_rootKeyThumb             2 23 42 3 0 0 */
-     625,    /* OBJ_set_addPolicy                2 23 42 3 0 1 */
-     626,    /* OBJ_setAttr_Token_EMV            2 23 42 3 2 1 */
-     627,    /* OBJ_setAttr_Token_B0Prime        2 23 42 3 2 2 */
-     628,    /* OBJ_setAttr_IssCap_CVM           2 23 42 3 3 3 */
-     629,    /* OBJ_setAttr_IssCap_T2            2 23 42 3 3 4 */
-     630,    /* OBJ_setAttr_IssCap_Sig           2 23 42 3 3 5 */
-     642,    /* OBJ_set_brand_Novus              2 23 42 8 6011 */
-     735,    /* OBJ_wap_wsg_idm_ecid_wtls1       2 23 43 1 4 1 */
-     736,    /* OBJ_wap_wsg_idm_ecid_wtls3       2 23 43 1 4 3 */
-     737,    /* OBJ_wap_wsg_idm_ecid_wtls4       2 23 43 1 4 4 */
-     738,    /* OBJ_wap_wsg_idm_ecid_wtls5       2 23 43 1 4 5 */
-     739,    /* OBJ_wap_wsg_idm_ecid_wtls6       2 23 43 1 4 6 */
-     740,    /* OBJ_wap_wsg_idm_ecid_wtls7       2 23 43 1 4 7 */
-     741,    /* OBJ_wap_wsg_idm_ecid_wtls8       2 23 43 1 4 8 */
-     742,    /* OBJ_wap_wsg_idm_ecid_wtls9       2 23 43 1 4 9 */
-     743,    /* OBJ_wap_wsg_idm_ecid_wtls10      2 23 43 1 4 10 */
-     744,    /* OBJ_wap_wsg_idm_ecid_wtls11      2 23 43 1 4 11 */
-     745,    /* OBJ_wap_wsg_idm_ecid_wtls12      2 23 43 1 4 12 */
-     804,    /* OBJ_whirlpool                    1 0 10118 3 0 55 */
-    1142,    /* OBJ_sm_scheme                    1 2 156 10197 1 */
-     773,    /* OBJ_kisa                         1 2 410 200004 */
-     807,    /* OBJ_id_GostR3411_94_with_GostR3410_2001 1 2 643 2 2 3 */
-     808,    /* OBJ_id_GostR3411_94_with_GostR3410_94 1 2 643 2 2 4 */
-     809,    /* OBJ_id_GostR3411_94              1 2 643 2 2 9 */
-     810,    /* OBJ_id_HMACGostR3411_94          1 2 643 2 2 10 */
-     811,    /* OBJ_id_GostR3410_2001            1 2 643 2 2 19 */
-     812,    /* OBJ_id_GostR3410_94              1 2 643 2 2 20 */
-     813,    /* OBJ_id_Gost28147_89              1 2 643 2 2 21 */
-     815,    /* OBJ_id_Gost28147_89_MAC          1 2 643 2 2 22 */
-     816,    /* OBJ_id_GostR3411_94_prf          1 2 643 2 2 23 */
-     817,    /* OBJ_id_GostR3410_2001DH          1 2 643 2 2 98 */
-     818,    /* OBJ_id_GostR3410_94DH            1 2 643 2 2 99 */
-     977,    /* OBJ_id_tc26_algorithms           1 2 643 7 1 1 */
-     994,    /* OBJ_id_tc26_constants            1 2 643 7 1 2 */
-       1,    /* OBJ_rsadsi                       1 2 840 113549 */
-     185,    /* OBJ_X9cm                         1 2 840 10040 4 */
-    1031,    /* OBJ_id_pkinit                    1 3 6 1 5 2 3 */
-     127,    /* OBJ_id_pkix                      1 3 6 1 5 5 7 */
-     505,    /* OBJ_mime_mhs_headings            1 3 6 1 7 1 1 */
-     506,    /* OBJ_mime_mhs_bodies              1 3 6 1 7 1 2 */
-     119,    /* OBJ_ripemd160WithRSA             1 3 36 3 3 1 2 */
-     937,    /* OBJ_dhSinglePass_stdDH_sha224kdf_scheme 1 3 132 1 11 0 */
-     938,    /* OBJ_dhSinglePass_stdDH_sha256kdf_scheme 1 3 132 1 11 1 */
-     939,    /* OBJ_dhSinglePass_stdDH_sha384kdf_scheme 1 3 132 1 11 2 */
-     940,    /* OBJ_dhSinglePass_stdDH_sha512kdf_scheme 1 3 132 1 11 3 */
-     942,    /* OBJ_dhSinglePass_cofactorDH_sha224kdf_scheme 1 3 132 1 14 0 */
-     943,    /* OBJ_dhSinglePass_cofactorDH_sha256kdf_scheme 1 3 132 1 14 1 */
-     944,    /* OBJ_dhSinglePass_cofactorDH_sha384kdf_scheme 1 3 132 1 14 2 */
-     945,    /* OBJ_dhSinglePass_cofactorDH_sha512kdf_scheme 1 3 132 1 14 3 */
+     162,    /* OBJ_pbmac1                       1 2 840 113549 1 5 14 */
+     866,    /* OBJ_teletexTerminalIdentifier    2 5 4 22 */
+       0,
+       0,
+       0,
+       0,
+     557,    /* OBJ_setct_PCertResTBS            2 23 42 0 39 */
+     832,    /* OBJ_id_GostR3410_94_CryptoPro_A_ParamSet 1 2 643 2 2 32 2 */
+       0,
+       0,
+     686,    /* OBJ_X9_62_c2pnb163v3             1 2 840 10045 3 0 3 */
+     190,    /* OBJ_id_smime_ct                  1 2 840 113549 1 9 16 1 */
+       0,
+     746,    /* OBJ_any_policy                   2 5 29 32 0 */
+      71,    /* OBJ_netscape_cert_type           2 16 840 1 113730 1 1 */
+       0,
+       0,
+     648,    /* OBJ_ms_smartcard_login           1 3 6 1 4 1 311 20 2 2 */
+     518,    /* OBJ_set_brand                    2 23 42 8 */
+     537,    /* OBJ_setct_AuthTokenTBS           2 23 42 0 19 */
+     728,    /* OBJ_sect239k1                    1 3 132 0 3 */
+       0,
+       0,
+     957,    /* OBJ_jurisdictionCountryName      1 3 6 1 4 1 311 60 2 1 3 */
+     864,    /* OBJ_telephoneNumber              2 5 4 20 */
+     759,    /* OBJ_camellia_256_cfb128          0 3 4401 5 3 1 9 44 */
+    1146,    /* OBJ_sha512_256WithRSAEncryption  1 2 840 113549 1 1 16 */
+    1002,    /* OBJ_id_tc26_gost_28147_constants 1 2 643 7 1 2 5 1 */
+    1165,    /* OBJ_uacurve5                     1 2 804 2 1 1 1 1 3 1 1 2 5 */
+       0,
+       0,
+       0,
+     527,    /* OBJ_setct_AuthResBaggage         2 23 42 0 8 */
+       0,
+     301,    /* OBJ_id_it_preferredSymmAlg       1 3 6 1 5 5 7 4 4 */
+     148,    /* OBJ_pbe_WithSHA1And128BitRC2_CBC 1 2 840 113549 1 12 1 5 */
+      44,    /* OBJ_des_ede3_cbc                 1 2 840 113549 3 7 */
+     213,    /* OBJ_id_smime_aa_securityLabel    1 2 840 113549 1 9 16 2 2 */
+     345,    /* OBJ_id_cmc_popLinkWitness        1 3 6 1 5 5 7 7 23 */
+     528,    /* OBJ_setct_AuthRevReqBaggage      2 23 42 0 9 */
+       0,
+     498,    /* OBJ_subtreeMaximumQuality        0 9 2342 19200300 100 1 52 */
+     509,    /* OBJ_generationQualifier          2 5 4 44 */
     1228,    /* OBJ_p256_dilithium2              1 3 9999 2 7 1 */
-    1229,    /* OBJ_rsa3072_dilithium2           1 3 9999 2 7 2 */
-    1231,    /* OBJ_p384_dilithium3              1 3 9999 2 7 3 */
-    1233,    /* OBJ_p521_dilithium5              1 3 9999 2 7 4 */
-    1239,    /* OBJ_sphincssha2128fsimple        1 3 9999 6 4 13 */
-    1240,    /* OBJ_p256_sphincssha2128fsimple   1 3 9999 6 4 14 */
-    1241,    /* OBJ_rsa3072_sphincssha2128fsimple 1 3 9999 6 4 15 */
-    1242,    /* OBJ_sphincssha2128ssimple        1 3 9999 6 4 16 */
-    1243,    /* OBJ_p256_sphincssha2128ssimple   1 3 9999 6 4 17 */
+       0,
+       0,
+       0,
+       0,
+     367,    /* OBJ_id_pkix_OCSP_CrlID           1 3 6 1 5 5 7 48 1 3 */
+       0,
+     342,    /* OBJ_id_cmc_responseInfo          1 3 6 1 5 5 7 7 19 */
+     773,    /* OBJ_kisa                         1 2 410 200004 */
+       0,
+       0,
+     973,    /* OBJ_id_scrypt                    1 3 6 1 4 1 11591 4 11 */
+     902,    /* OBJ_aes_256_ccm                  2 16 840 1 101 3 4 1 47 */
+     941,    /* OBJ_dhSinglePass_cofactorDH_sha1kdf_scheme 1 3 133 16 840 63 0 3 */
+     183,    /* OBJ_ISO_US                       1 2 840 */
+    1103,    /* OBJ_hmac_sha3_256                2 16 840 1 101 3 4 2 14 */
+     433,    /* OBJ_hold_instruction_reject      1 2 840 10040 2 3 */
+       0,
     1244,    /* OBJ_rsa3072_sphincssha2128ssimple 1 3 9999 6 4 18 */
-    1245,    /* OBJ_sphincssha2192fsimple        1 3 9999 6 5 10 */
-    1246,    /* OBJ_p384_sphincssha2192fsimple   1 3 9999 6 5 11 */
-    1247,    /* OBJ_sphincsshake128fsimple       1 3 9999 6 7 13 */
-    1248,    /* OBJ_p256_sphincsshake128fsimple  1 3 9999 6 7 14 */
-    1249,    /* OBJ_rsa3072_sphincsshake128fsimple 1 3 9999 6 7 15 */
-     631,    /* OBJ_setAttr_GenCryptgrm          2 23 42 3 3 3 1 */
-     632,    /* OBJ_setAttr_T2Enc                2 23 42 3 3 4 1 */
-     633,    /* OBJ_setAttr_T2cleartxt           2 23 42 3 3 4 2 */
-     634,    /* OBJ_setAttr_TokICCsig            2 23 42 3 3 5 1 */
-     635,    /* OBJ_setAttr_SecDevSig            2 23 42 3 3 5 2 */
-     436,    /* OBJ_ucl                          0 9 2342 19200300 */
-     820,    /* OBJ_id_Gost28147_89_None_KeyMeshing 1 2 643 2 2 14 0 */
-     819,    /* OBJ_id_Gost28147_89_CryptoPro_KeyMeshing 1 2 643 2 2 14 1 */
-     845,    /* OBJ_id_GostR3410_94_a            1 2 643 2 2 20 1 */
-     846,    /* OBJ_id_GostR3410_94_aBis         1 2 643 2 2 20 2 */
+       0,
+       0,
+     609,    /* OBJ_setCext_certType             2 23 42 7 1 */
+     320,    /* OBJ_id_regCtrl_protocolEncrKey   1 3 6 1 5 5 7 5 1 6 */
+     248,    /* OBJ_id_smime_cd_ldap             1 2 840 113549 1 9 16 4 1 */
+     137,    /* OBJ_ms_sgc                       1 3 6 1 4 1 311 10 3 3 */
+       0,
+     346,    /* OBJ_id_cmc_confirmCertAcceptance 1 3 6 1 5 5 7 7 24 */
+       0,
+     912,    /* OBJ_rsassaPss                    1 2 840 113549 1 1 10 */
+       0,
+       0,
+    1121,    /* OBJ_aria_192_ccm                 1 2 410 200046 1 1 38 */
+     430,    /* OBJ_hold_instruction_code        2 5 29 23 */
+     412,    /* OBJ_X9_62_prime239v1             1 2 840 10045 3 1 4 */
+     267,    /* OBJ_id_qcs                       1 3 6 1 5 5 7 11 */
+       0,
+       0,
+     690,    /* OBJ_X9_62_c2tnb191v3             1 2 840 10045 3 0 7 */
+     208,    /* OBJ_id_smime_ct_TDTInfo          1 2 840 113549 1 9 16 1 5 */
      847,    /* OBJ_id_GostR3410_94_b            1 2 643 2 2 20 3 */
-     848,    /* OBJ_id_GostR3410_94_bBis         1 2 643 2 2 20 4 */
-     821,    /* OBJ_id_GostR3411_94_TestParamSet 1 2 643 2 2 30 0 */
-     822,    /* OBJ_id_GostR3411_94_CryptoProParamSet 1 2 643 2 2 30 1 */
-     823,    /* OBJ_id_Gost28147_89_TestParamSet 1 2 643 2 2 31 0 */
-     824,    /* OBJ_id_Gost28147_89_CryptoPro_A_ParamSet 1 2 643 2 2 31 1 */
-     825,    /* OBJ_id_Gost28147_89_CryptoPro_B_ParamSet 1 2 643 2 2 31 2 */
-     826,    /* OBJ_id_Gost28147_89_CryptoPro_C_ParamSet 1 2 643 2 2 31 3 */
-     827,    /* OBJ_id_Gost28147_89_CryptoPro_D_ParamSet 1 2 643 2 2 31 4 */
-     828,    /* OBJ_id_Gost28147_89_CryptoPro_Oscar_1_1_ParamSet 1 2 643 2 2 31 5 */
-     829,    /* OBJ_id_Gost28147_89_CryptoPro_Oscar_1_0_ParamSet 1 2 643 2 2 31 6 */
-     830,    /* OBJ_id_Gost28147_89_CryptoPro_RIC_1_ParamSet 1 2 643 2 2 31 7 */
-     831,    /* OBJ_id_GostR3410_94_TestParamSet 1 2 643 2 2 32 0 */
-     832,    /* OBJ_id_GostR3410_94_CryptoPro_A_ParamSet 1 2 643 2 2 32 2 */
-     833,    /* OBJ_id_GostR3410_94_CryptoPro_B_ParamSet 1 2 643 2 2 32 3 */
-     834,    /* OBJ_id_GostR3410_94_CryptoPro_C_ParamSet 1 2 643 2 2 32 4 */
-     835,    /* OBJ_id_GostR3410_94_CryptoPro_D_ParamSet 1 2 643 2 2 32 5 */
-     836,    /* OBJ_id_GostR3410_94_CryptoPro_XchA_ParamSet 1 2 643 2 2 33 1 */
-     837,    /* OBJ_id_GostR3410_94_CryptoPro_XchB_ParamSet 1 2 643 2 2 33 2 */
-     838,    /* OBJ_id_GostR3410_94_CryptoPro_XchC_ParamSet 1 2 643 2 2 33 3 */
-     839,    /* OBJ_id_GostR3410_2001_TestParamSet 1 2 643 2 2 35 0 */
-     840,    /* OBJ_id_GostR3410_2001_CryptoPro_A_ParamSet 1 2 643 2 2 35 1 */
-     841,    /* OBJ_id_GostR3410_2001_CryptoPro_B_ParamSet 1 2 643 2 2 35 2 */
-     842,    /* OBJ_id_GostR3410_2001_CryptoPro_C_ParamSet 1 2 643 2 2 35 3 */
-     843,    /* OBJ_id_GostR3410_2001_CryptoPro_XchA_ParamSet 1 2 643 2 2 36 0 */
-     844,    /* OBJ_id_GostR3410_2001_CryptoPro_XchB_ParamSet 1 2 643 2 2 36 1 */
-     978,    /* OBJ_id_tc26_sign                 1 2 643 7 1 1 1 */
-     981,    /* OBJ_id_tc26_digest               1 2 643 7 1 1 2 */
-     984,    /* OBJ_id_tc26_signwithdigest       1 2 643 7 1 1 3 */
-     987,    /* OBJ_id_tc26_mac                  1 2 643 7 1 1 4 */
-     990,    /* OBJ_id_tc26_cipher               1 2 643 7 1 1 5 */
-     991,    /* OBJ_id_tc26_agreement            1 2 643 7 1 1 6 */
-    1179,    /* OBJ_id_tc26_wrap                 1 2 643 7 1 1 7 */
-     995,    /* OBJ_id_tc26_sign_constants       1 2 643 7 1 2 1 */
-    1000,    /* OBJ_id_tc26_digest_constants     1 2 643 7 1 2 2 */
+     986,    /* OBJ_id_tc26_signwithdigest_gost3410_2012_512 1 2 643 7 1 1 3 3 */
+       0,
+       0,
+       0,
+     311,    /* OBJ_id_it_confirmWaitTime        1 3 6 1 5 5 7 4 14 */
+     514,    /* OBJ_set_msgExt                   2 23 42 1 */
+       0,
+       0,
+       0,
     1001,    /* OBJ_id_tc26_cipher_constants     1 2 643 7 1 2 5 */
-    1151,    /* OBJ_ua_pki                       1 2 804 2 1 1 1 */
-       2,    /* OBJ_pkcs                         1 2 840 113549 1 */
-     431,    /* OBJ_hold_instruction_none        1 2 840 10040 2 1 */
-     432,    /* OBJ_hold_instruction_call_issuer 1 2 840 10040 2 2 */
-     433,    /* OBJ_hold_instruction_reject      1 2 840 10040 2 3 */
-     116,    /* OBJ_dsa                          1 2 840 10040 4 1 */
-     113,    /* OBJ_dsaWithSHA1                  1 2 840 10040 4 3 */
-     406,    /* OBJ_X9_62_prime_field            1 2 840 10045 1 1 */
-     407,    /* OBJ_X9_62_characteristic_two_field 1 2 840 10045 1 2 */
-     408,    /* OBJ_X9_62_id_ecPublicKey         1 2 840 10045 2 1 */
-     416,    /* OBJ_ecdsa_with_SHA1              1 2 840 10045 4 1 */
-     791,    /* OBJ_ecdsa_with_Recommended       1 2 840 10045 4 2 */
-     792,    /* OBJ_ecdsa_with_Specified         1 2 840 10045 4 3 */
-     920,    /* OBJ_dhpublicnumber               1 2 840 10046 2 1 */
-    1032,    /* OBJ_pkInitClientAuth             1 3 6 1 5 2 3 4 */
-    1033,    /* OBJ_pkInitKDC                    1 3 6 1 5 2 3 5 */
-     258,    /* OBJ_id_pkix_mod                  1 3 6 1 5 5 7 0 */
-     175,    /* OBJ_id_pe                        1 3 6 1 5 5 7 1 */
-     259,    /* OBJ_id_qt                        1 3 6 1 5 5 7 2 */
-     128,    /* OBJ_id_kp                        1 3 6 1 5 5 7 3 */
-     260,    /* OBJ_id_it                        1 3 6 1 5 5 7 4 */
-     261,    /* OBJ_id_pkip                      1 3 6 1 5 5 7 5 */
-     262,    /* OBJ_id_alg                       1 3 6 1 5 5 7 6 */
-     263,    /* OBJ_id_cmc                       1 3 6 1 5 5 7 7 */
-     264,    /* OBJ_id_on                        1 3 6 1 5 5 7 8 */
-     265,    /* OBJ_id_pda                       1 3 6 1 5 5 7 9 */
-     266,    /* OBJ_id_aca                       1 3 6 1 5 5 7 10 */
-     267,    /* OBJ_id_qcs                       1 3 6 1 5 5 7 11 */
-     268,    /* OBJ_id_cct                       1 3 6 1 5 5 7 12 */
-     662,    /* OBJ_id_ppl                       1 3 6 1 5 5 7 21 */
-     176,    /* OBJ_id_ad                        1 3 6 1 5 5 7 48 */
-     507,    /* OBJ_id_hex_partial_message       1 3 6 1 7 1 1 1 */
+    1119,    /* OBJ_RSA_SHA3_512                 2 16 840 1 101 3 4 3 16 */
+       0,
      508,    /* OBJ_id_hex_multipart_message     1 3 6 1 7 1 1 2 */
-      57,    /* OBJ_netscape                     2 16 840 1 113730 */
-     754,    /* OBJ_camellia_128_ecb             0 3 4401 5 3 1 9 1 */
-     766,    /* OBJ_camellia_128_ofb128          0 3 4401 5 3 1 9 3 */
-     757,    /* OBJ_camellia_128_cfb128          0 3 4401 5 3 1 9 4 */
-     961,    /* OBJ_camellia_128_gcm             0 3 4401 5 3 1 9 6 */
-     962,    /* OBJ_camellia_128_ccm             0 3 4401 5 3 1 9 7 */
-     963,    /* OBJ_camellia_128_ctr             0 3 4401 5 3 1 9 9 */
-     964,    /* OBJ_camellia_128_cmac            0 3 4401 5 3 1 9 10 */
-     755,    /* OBJ_camellia_192_ecb             0 3 4401 5 3 1 9 21 */
-     767,    /* OBJ_camellia_192_ofb128          0 3 4401 5 3 1 9 23 */
-     758,    /* OBJ_camellia_192_cfb128          0 3 4401 5 3 1 9 24 */
-     965,    /* OBJ_camellia_192_gcm             0 3 4401 5 3 1 9 26 */
-     966,    /* OBJ_camellia_192_ccm             0 3 4401 5 3 1 9 27 */
-     967,    /* OBJ_camellia_192_ctr             0 3 4401 5 3 1 9 29 */
-     968,    /* OBJ_camellia_192_cmac            0 3 4401 5 3 1 9 30 */
-     756,    /* OBJ_camellia_256_ecb             0 3 4401 5 3 1 9 41 */
-     768,    /* OBJ_camellia_256_ofb128          0 3 4401 5 3 1 9 43 */
-     759,    /* OBJ_camellia_256_cfb128          0 3 4401 5 3 1 9 44 */
-     969,    /* OBJ_camellia_256_gcm             0 3 4401 5 3 1 9 46 */
-     970,    /* OBJ_camellia_256_ccm             0 3 4401 5 3 1 9 47 */
-     971,    /* OBJ_camellia_256_ctr             0 3 4401 5 3 1 9 49 */
-     972,    /* OBJ_camellia_256_cmac            0 3 4401 5 3 1 9 50 */
-     437,    /* OBJ_pilot                        0 9 2342 19200300 100 */
-    1133,    /* OBJ_sm4_ecb                      1 2 156 10197 1 104 1 */
-    1134,    /* OBJ_sm4_cbc                      1 2 156 10197 1 104 2 */
+       0,
+       0,
+       0,
+     616,    /* OBJ_setCext_TokenIdentifier      2 23 42 7 8 */
+     507,    /* OBJ_id_hex_partial_message       1 3 6 1 7 1 1 1 */
+     534,    /* OBJ_setct_AuthReqTBS             2 23 42 0 16 */
+     338,    /* OBJ_id_cmc_getCert               1 3 6 1 5 5 7 7 15 */
     1135,    /* OBJ_sm4_ofb128                   1 2 156 10197 1 104 3 */
-    1137,    /* OBJ_sm4_cfb128                   1 2 156 10197 1 104 4 */
-    1136,    /* OBJ_sm4_cfb1                     1 2 156 10197 1 104 5 */
-    1138,    /* OBJ_sm4_cfb8                     1 2 156 10197 1 104 6 */
+       0,
+     277,    /* OBJ_id_mod_cmp                   1 3 6 1 5 5 7 0 9 */
+     554,    /* OBJ_setct_CredRevReqTBSX         2 23 42 0 36 */
+     149,    /* OBJ_pbe_WithSHA1And40BitRC2_CBC  1 2 840 113549 1 12 1 6 */
+       0,
+       0,
+       0,
+    1120,    /* OBJ_aria_128_ccm                 1 2 410 200046 1 1 37 */
+       0,
+     447,    /* OBJ_document                     0 9 2342 19200300 100 4 6 */
+     234,    /* OBJ_id_smime_aa_ets_certValues   1 2 840 113549 1 9 16 2 23 */
+     837,    /* OBJ_id_GostR3410_94_CryptoPro_XchB_ParamSet 1 2 643 2 2 33 2 */
+       0,
+     793,    /* OBJ_ecdsa_with_SHA224            1 2 840 10045 4 3 1 */
+       0,
+       0,
+       0,
+       0,
+       0,
+       0,
+     977,    /* OBJ_id_tc26_algorithms           1 2 643 7 1 1 */
+       0,
+     611,    /* OBJ_setCext_cCertRequired        2 23 42 7 3 */
+       0,
+       0,
+      96,    /* OBJ_mdc2WithRSA                  2 5 8 3 100 */
+    1238,    /* OBJ_p521_falcon1024              1 3 9999 3 10 */
+     349,    /* OBJ_id_pda_placeOfBirth          1 3 6 1 5 5 7 9 2 */
+       0,
+       0,
+       0,
+    1131,    /* OBJ_cmcCA                        1 3 6 1 5 5 7 3 27 */
+    1108,    /* OBJ_dsa_with_SHA3_224            2 16 840 1 101 3 4 3 5 */
+       0,
+       0,
+    1247,    /* OBJ_sphincsshake128fsimple       1 3 9999 6 7 13 */
+       0,
+     150,    /* OBJ_keyBag                       1 2 840 113549 1 12 10 1 1 */
+     374,    /* OBJ_id_pkix_OCSP_path            1 3 6 1 5 5 7 48 1 10 */
+     983,    /* OBJ_id_GostR3411_2012_512        1 2 643 7 1 1 2 3 */
+       0,
+       0,
+    1227,    /* OBJ_dilithium2                   1 3 6 1 4 1 2 267 7 4 4 */
+      95,    /* OBJ_mdc2                         2 5 8 3 101 */
+       0,
+      58,    /* OBJ_netscape_cert_extension      2 16 840 1 113730 1 */
+     251,    /* OBJ_id_smime_cti_ets_proofOfOrigin 1 2 840 113549 1 9 16 6 1 */
+     542,    /* OBJ_setct_AuthRevResData         2 23 42 0 24 */
+       0,
+       0,
+    1087,    /* OBJ_ED25519                      1 3 101 112 */
+     437,    /* OBJ_pilot                        0 9 2342 19200300 100 */
+       0,
+     384,    /* OBJ_Experimental                 1 3 6 1 3 */
+       0,
+     688,    /* OBJ_X9_62_c2tnb191v1             1 2 840 10045 3 0 5 */
+     988,    /* OBJ_id_tc26_hmac_gost_3411_2012_256 1 2 643 7 1 1 4 1 */
+     807,    /* OBJ_id_GostR3411_94_with_GostR3410_2001 1 2 643 2 2 3 */
+       0,
+     485,    /* OBJ_associatedName               0 9 2342 19200300 100 1 38 */
+       0,
+       0,
+     263,    /* OBJ_id_cmc                       1 3 6 1 5 5 7 7 */
+     313,    /* OBJ_id_regCtrl                   1 3 6 1 5 5 7 5 1 */
+       0,
+     908,    /* OBJ_id_camellia192_wrap          1 2 392 200011 61 1 1 3 3 */
+     188,    /* OBJ_SMIME                        1 2 840 113549 1 9 16 */
+       0,
+       0,
+       0,
+     709,    /* OBJ_secp160r1                    1 3 132 0 8 */
+     167,    /* OBJ_SMIMECapabilities            1 2 840 113549 1 9 15 */
+     439,    /* OBJ_pilotAttributeSyntax         0 9 2342 19200300 100 3 */
+       0,
+       0,
     1139,    /* OBJ_sm4_ctr                      1 2 156 10197 1 104 7 */
-    1172,    /* OBJ_sm2                          1 2 156 10197 1 301 */
-    1143,    /* OBJ_sm3                          1 2 156 10197 1 401 */
-    1144,    /* OBJ_sm3WithRSAEncryption         1 2 156 10197 1 504 */
-     776,    /* OBJ_seed_ecb                     1 2 410 200004 1 3 */
-     777,    /* OBJ_seed_cbc                     1 2 410 200004 1 4 */
-     779,    /* OBJ_seed_cfb128                  1 2 410 200004 1 5 */
-     778,    /* OBJ_seed_ofb128                  1 2 410 200004 1 6 */
-     852,    /* OBJ_id_GostR3411_94_with_GostR3410_94_cc 1 2 643 2 9 1 3 3 */
-     853,    /* OBJ_id_GostR3411_94_with_GostR3410_2001_cc 1 2 643 2 9 1 3 4 */
-     850,    /* OBJ_id_GostR3410_94_cc           1 2 643 2 9 1 5 3 */
-     851,    /* OBJ_id_GostR3410_2001_cc         1 2 643 2 9 1 5 4 */
-     849,    /* OBJ_id_Gost28147_89_cc           1 2 643 2 9 1 6 1 */
+     132,    /* OBJ_email_protect                1 3 6 1 5 5 7 3 4 */
+     108,    /* OBJ_cast5_cbc                    1 2 840 113533 7 66 10 */
+       0,
+     858,    /* OBJ_id_on_permanentIdentifier    1 3 6 1 5 5 7 8 3 */
+       0,
+       8,    /* OBJ_md5WithRSAEncryption         1 2 840 113549 1 1 4 */
+       0,
+       0,
+       0,
+       0,
+       0,
+     169,    /* OBJ_pbeWithMD5AndRC2_CBC         1 2 840 113549 1 5 6 */
+      24,    /* OBJ_pkcs7_signedAndEnveloped     1 2 840 113549 1 7 4 */
+       0,
+     253,    /* OBJ_id_smime_cti_ets_proofOfDelivery 1 2 840 113549 1 9 16 6 3 */
+     848,    /* OBJ_id_GostR3410_94_bBis         1 2 643 2 2 20 4 */
+     560,    /* OBJ_setct_CardCInitResTBS        2 23 42 0 42 */
+       0,
+     352,    /* OBJ_id_pda_countryOfCitizenship  1 3 6 1 5 5 7 9 4 */
+     717,    /* OBJ_sect113r1                    1 3 132 0 4 */
+       0,
+       0,
+       0,
+      78,    /* OBJ_netscape_comment             2 16 840 1 113730 1 13 */
+     203,    /* OBJ_id_smime_mod_ets_eSigPolicy_97 1 2 840 113549 1 9 16 0 8 */
+      18,    /* OBJ_organizationalUnitName       2 5 4 11 */
+       0,
+       0,
+       0,
+     771,    /* OBJ_certificate_issuer           2 5 29 29 */
+     714,    /* OBJ_secp256k1                    1 3 132 0 10 */
+       0,
+     465,    /* OBJ_userClass                    0 9 2342 19200300 100 1 8 */
+    1106,    /* OBJ_dsa_with_SHA384              2 16 840 1 101 3 4 3 3 */
+     993,    /* OBJ_id_tc26_agreement_gost_3410_2012_512 1 2 643 7 1 1 6 2 */
+       0,
+       0,
+     189,    /* OBJ_id_smime_mod                 1 2 840 113549 1 9 16 0 */
+     883,    /* OBJ_certificateRevocationList    2 5 4 39 */
+     893,    /* OBJ_id_alg_PWRI_KEK              1 2 840 113549 1 9 16 3 9 */
+     431,    /* OBJ_hold_instruction_none        1 2 840 10040 2 1 */
+       0,
+       0,
+     963,    /* OBJ_camellia_128_ctr             0 3 4401 5 3 1 9 9 */
+     259,    /* OBJ_id_qt                        1 3 6 1 5 5 7 2 */
+       0,
+       0,
+     937,    /* OBJ_dhSinglePass_stdDH_sha224kdf_scheme 1 3 132 1 11 0 */
+     870,    /* OBJ_registeredAddress            2 5 4 26 */
+       0,
+     472,    /* OBJ_documentLocation             0 9 2342 19200300 100 1 15 */
+       0,
+       0,
+     397,    /* OBJ_ac_proxying                  1 3 6 1 5 5 7 1 10 */
+       0,
+       0,
+     107,    /* OBJ_description                  2 5 4 13 */
+     516,    /* OBJ_set_policy                   2 23 42 5 */
+      77,    /* OBJ_netscape_ssl_server_name     2 16 840 1 113730 1 12 */
+       0,
+       0,
+       0,
+       0,
+    1138,    /* OBJ_sm4_cfb8                     1 2 156 10197 1 104 6 */
+     715,    /* OBJ_secp384r1                    1 3 132 0 34 */
+     105,    /* OBJ_serialNumber                 2 5 4 5 */
+       0,
+     555,    /* OBJ_setct_CredRevResData         2 23 42 0 37 */
+     743,    /* OBJ_wap_wsg_idm_ecid_wtls10      2 23 43 1 4 10 */
+     260,    /* OBJ_id_it                        1 3 6 1 5 5 7 4 */
+       0,
+       0,
+       0,
+       0,
+      82,    /* OBJ_subject_key_identifier       2 5 29 14 */
+     981,    /* OBJ_id_tc26_digest               1 2 643 7 1 1 2 */
+     539,    /* OBJ_setct_CapTokenTBS            2 23 42 0 21 */
+    1077,    /* OBJ_aria_256_cfb128              1 2 410 200046 1 1 13 */
+       0,
+       0,
+     928,    /* OBJ_brainpoolP256t1              1 3 36 3 3 2 8 1 1 8 */
+       0,
+       0,
+     785,    /* OBJ_caRepository                 1 3 6 1 5 5 7 48 5 */
+     665,    /* OBJ_id_ppl_inheritAll            1 3 6 1 5 5 7 21 1 */
+       0,
+       0,
+     481,    /* OBJ_nSRecord                     0 9 2342 19200300 100 1 29 */
+      16,    /* OBJ_stateOrProvinceName          2 5 4 8 */
+     496,    /* OBJ_singleLevelQuality           0 9 2342 19200300 100 1 50 */
+       0,
+       0,
+       0,
+     163,    /* OBJ_hmacWithSHA1                 1 2 840 113549 2 7 */
+       0,
+       0,
+       0,
+     706,    /* OBJ_secp128r1                    1 3 132 0 28 */
+     201,    /* OBJ_id_smime_mod_ets_eSignature_97 1 2 840 113549 1 9 16 0 6 */
+       0,
+     233,    /* OBJ_id_smime_aa_ets_RevocationRefs 1 2 840 113549 1 9 16 2 22 */
+     829,    /* OBJ_id_Gost28147_89_CryptoPro_Oscar_1_0_ParamSet 1 2 643 2 2 31 6 */
+       0,
+       0,
+    1091,    /* OBJ_countryCode3n                2 5 4 99 */
+       0,
+       0,
+     599,    /* OBJ_setct_CRLNotificationResTBS  2 23 42 0 81 */
+     395,    /* OBJ_clearance                    2 5 1 5 55 */
+       7,    /* OBJ_md2WithRSAEncryption         1 2 840 113549 1 1 2 */
+     351,    /* OBJ_id_pda_gender                1 3 6 1 5 5 7 9 3 */
+       0,
+       0,
+     426,    /* OBJ_aes_256_ecb                  2 16 840 1 101 3 4 1 41 */
+     197,    /* OBJ_id_smime_mod_ess             1 2 840 113549 1 9 16 0 2 */
+     552,    /* OBJ_setct_CredResData            2 23 42 0 34 */
+       0,
+     994,    /* OBJ_id_tc26_constants            1 2 643 7 1 2 */
+     795,    /* OBJ_ecdsa_with_SHA384            1 2 840 10045 4 3 3 */
+       0,
+       0,
      854,    /* OBJ_id_GostR3410_2001_ParamSet_cc 1 2 643 2 9 1 8 1 */
-    1004,    /* OBJ_INN                          1 2 643 3 131 1 1 */
-     979,    /* OBJ_id_GostR3410_2012_256        1 2 643 7 1 1 1 1 */
-     980,    /* OBJ_id_GostR3410_2012_512        1 2 643 7 1 1 1 2 */
-     982,    /* OBJ_id_GostR3411_2012_256        1 2 643 7 1 1 2 2 */
-     983,    /* OBJ_id_GostR3411_2012_512        1 2 643 7 1 1 2 3 */
-     985,    /* OBJ_id_tc26_signwithdigest_gost3410_2012_256 1 2 643 7 1 1 3 2 */
-     986,    /* OBJ_id_tc26_signwithdigest_gost3410_2012_512 1 2 643 7 1 1 3 3 */
-     988,    /* OBJ_id_tc26_hmac_gost_3411_2012_256 1 2 643 7 1 1 4 1 */
-     989,    /* OBJ_id_tc26_hmac_gost_3411_2012_512 1 2 643 7 1 1 4 2 */
-    1173,    /* OBJ_id_tc26_cipher_gostr3412_2015_magma 1 2 643 7 1 1 5 1 */
-    1176,    /* OBJ_id_tc26_cipher_gostr3412_2015_kuznyechik 1 2 643 7 1 1 5 2 */
-     992,    /* OBJ_id_tc26_agreement_gost_3410_2012_256 1 2 643 7 1 1 6 1 */
-     993,    /* OBJ_id_tc26_agreement_gost_3410_2012_512 1 2 643 7 1 1 6 2 */
-    1180,    /* OBJ_id_tc26_wrap_gostr3412_2015_magma 1 2 643 7 1 1 7 1 */
-    1182,    /* OBJ_id_tc26_wrap_gostr3412_2015_kuznyechik 1 2 643 7 1 1 7 2 */
-    1147,    /* OBJ_id_tc26_gost_3410_2012_256_constants 1 2 643 7 1 2 1 1 */
-     996,    /* OBJ_id_tc26_gost_3410_2012_512_constants 1 2 643 7 1 2 1 2 */
-    1002,    /* OBJ_id_tc26_gost_28147_constants 1 2 643 7 1 2 5 1 */
-     186,    /* OBJ_pkcs1                        1 2 840 113549 1 1 */
+       0,
+      13,    /* OBJ_commonName                   2 5 4 3 */
+       0,
+       0,
+       0,
+     136,    /* OBJ_ms_ctl_sign                  1 3 6 1 4 1 311 10 3 1 */
+      67,    /* OBJ_dsa_2                        1 3 14 3 2 12 */
+     463,    /* OBJ_roomNumber                   0 9 2342 19200300 100 1 6 */
       27,    /* OBJ_pkcs3                        1 2 840 113549 1 3 */
-     187,    /* OBJ_pkcs5                        1 2 840 113549 1 5 */
-      20,    /* OBJ_pkcs7                        1 2 840 113549 1 7 */
-      47,    /* OBJ_pkcs9                        1 2 840 113549 1 9 */
-       3,    /* OBJ_md2                          1 2 840 113549 2 2 */
-     257,    /* OBJ_md4                          1 2 840 113549 2 4 */
-       4,    /* OBJ_md5                          1 2 840 113549 2 5 */
-     797,    /* OBJ_hmacWithMD5                  1 2 840 113549 2 6 */
-     163,    /* OBJ_hmacWithSHA1                 1 2 840 113549 2 7 */
-     798,    /* OBJ_hmacWithSHA224               1 2 840 113549 2 8 */
-     799,    /* OBJ_hmacWithSHA256               1 2 840 113549 2 9 */
-     800,    /* OBJ_hmacWithSHA384               1 2 840 113549 2 10 */
-     801,    /* OBJ_hmacWithSHA512               1 2 840 113549 2 11 */
-    1193,    /* OBJ_hmacWithSHA512_224           1 2 840 113549 2 12 */
-    1194,    /* OBJ_hmacWithSHA512_256           1 2 840 113549 2 13 */
-      37,    /* OBJ_rc2_cbc                      1 2 840 113549 3 2 */
-       5,    /* OBJ_rc4                          1 2 840 113549 3 4 */
-      44,    /* OBJ_des_ede3_cbc                 1 2 840 113549 3 7 */
-     120,    /* OBJ_rc5_cbc                      1 2 840 113549 3 8 */
-     643,    /* OBJ_des_cdmf                     1 2 840 113549 3 10 */
-     680,    /* OBJ_X9_62_id_characteristic_two_basis 1 2 840 10045 1 2 3 */
-     684,    /* OBJ_X9_62_c2pnb163v1             1 2 840 10045 3 0 1 */
-     685,    /* OBJ_X9_62_c2pnb163v2             1 2 840 10045 3 0 2 */
-     686,    /* OBJ_X9_62_c2pnb163v3             1 2 840 10045 3 0 3 */
-     687,    /* OBJ_X9_62_c2pnb176v1             1 2 840 10045 3 0 4 */
-     688,    /* OBJ_X9_62_c2tnb191v1             1 2 840 10045 3 0 5 */
-     689,    /* OBJ_X9_62_c2tnb191v2             1 2 840 10045 3 0 6 */
-     690,    /* OBJ_X9_62_c2tnb191v3             1 2 840 10045 3 0 7 */
-     691,    /* OBJ_X9_62_c2onb191v4             1 2 840 10045 3 0 8 */
-     692,    /* OBJ_X9_62_c2onb191v5             1 2 840 10045 3 0 9 */
-     693,    /* OBJ_X9_62_c2pnb208w1             1 2 840 10045 3 0 10 */
+     209,    /* OBJ_id_smime_ct_contentInfo      1 2 840 113549 1 9 16 1 6 */
+     466,    /* OBJ_host                         0 9 2342 19200300 100 1 9 */
+     880,    /* OBJ_userCertificate              2 5 4 36 */
+       0,
+       0,
+       0,
      694,    /* OBJ_X9_62_c2tnb239v1             1 2 840 10045 3 0 11 */
-     695,    /* OBJ_X9_62_c2tnb239v2             1 2 840 10045 3 0 12 */
-     696,    /* OBJ_X9_62_c2tnb239v3             1 2 840 10045 3 0 13 */
-     697,    /* OBJ_X9_62_c2onb239v4             1 2 840 10045 3 0 14 */
-     698,    /* OBJ_X9_62_c2onb239v5             1 2 840 10045 3 0 15 */
-     699,    /* OBJ_X9_62_c2pnb272w1             1 2 840 10045 3 0 16 */
-     700,    /* OBJ_X9_62_c2pnb304w1             1 2 840 10045 3 0 17 */
-     701,    /* OBJ_X9_62_c2tnb359v1             1 2 840 10045 3 0 18 */
-     702,    /* OBJ_X9_62_c2pnb368w1             1 2 840 10045 3 0 19 */
-     703,    /* OBJ_X9_62_c2tnb431r1             1 2 840 10045 3 0 20 */
+       0,
      409,    /* OBJ_X9_62_prime192v1             1 2 840 10045 3 1 1 */
-     410,    /* OBJ_X9_62_prime192v2             1 2 840 10045 3 1 2 */
-     411,    /* OBJ_X9_62_prime192v3             1 2 840 10045 3 1 3 */
-     412,    /* OBJ_X9_62_prime239v1             1 2 840 10045 3 1 4 */
-     413,    /* OBJ_X9_62_prime239v2             1 2 840 10045 3 1 5 */
-     414,    /* OBJ_X9_62_prime239v3             1 2 840 10045 3 1 6 */
-     415,    /* OBJ_X9_62_prime256v1             1 2 840 10045 3 1 7 */
-     793,    /* OBJ_ecdsa_with_SHA224            1 2 840 10045 4 3 1 */
-     794,    /* OBJ_ecdsa_with_SHA256            1 2 840 10045 4 3 2 */
-     795,    /* OBJ_ecdsa_with_SHA384            1 2 840 10045 4 3 3 */
-     796,    /* OBJ_ecdsa_with_SHA512            1 2 840 10045 4 3 4 */
-     269,    /* OBJ_id_pkix1_explicit_88         1 3 6 1 5 5 7 0 1 */
-     270,    /* OBJ_id_pkix1_implicit_88         1 3 6 1 5 5 7 0 2 */
-     271,    /* OBJ_id_pkix1_explicit_93         1 3 6 1 5 5 7 0 3 */
+       0,
+     821,    /* OBJ_id_GostR3411_94_TestParamSet 1 2 643 2 2 30 0 */
+       0,
+    1145,    /* OBJ_sha512_224WithRSAEncryption  1 2 840 113549 1 1 15 */
+     863,    /* OBJ_physicalDeliveryOfficeName   2 5 4 19 */
+       0,
+       0,
      272,    /* OBJ_id_pkix1_implicit_93         1 3 6 1 5 5 7 0 4 */
-     273,    /* OBJ_id_mod_crmf                  1 3 6 1 5 5 7 0 5 */
-     274,    /* OBJ_id_mod_cmc                   1 3 6 1 5 5 7 0 6 */
-     275,    /* OBJ_id_mod_kea_profile_88        1 3 6 1 5 5 7 0 7 */
-     276,    /* OBJ_id_mod_kea_profile_93        1 3 6 1 5 5 7 0 8 */
-     277,    /* OBJ_id_mod_cmp                   1 3 6 1 5 5 7 0 9 */
-     278,    /* OBJ_id_mod_qualified_cert_88     1 3 6 1 5 5 7 0 10 */
-     279,    /* OBJ_id_mod_qualified_cert_93     1 3 6 1 5 5 7 0 11 */
-     280,    /* OBJ_id_mod_attribute_cert        1 3 6 1 5 5 7 0 12 */
-     281,    /* OBJ_id_mod_timestamp_protocol    1 3 6 1 5 5 7 0 13 */
-     282,    /* OBJ_id_mod_ocsp                  1 3 6 1 5 5 7 0 14 */
-     283,    /* OBJ_id_mod_dvcs                  1 3 6 1 5 5 7 0 15 */
-     284,    /* OBJ_id_mod_cmp2000               1 3 6 1 5 5 7 0 16 */
-     177,    /* OBJ_info_access                  1 3 6 1 5 5 7 1 1 */
-     285,    /* OBJ_biometricInfo                1 3 6 1 5 5 7 1 2 */
-     286,    /* OBJ_qcStatements                 1 3 6 1 5 5 7 1 3 */
-     287,    /* OBJ_ac_auditEntity               1 3 6 1 5 5 7 1 4 */
-     288,    /* OBJ_ac_targeting                 1 3 6 1 5 5 7 1 5 */
-     289,    /* OBJ_aaControls                   1 3 6 1 5 5 7 1 6 */
-     290,    /* OBJ_sbgp_ipAddrBlock             1 3 6 1 5 5 7 1 7 */
-     291,    /* OBJ_sbgp_autonomousSysNum        1 3 6 1 5 5 7 1 8 */
-     292,    /* OBJ_sbgp_routerIdentifier        1 3 6 1 5 5 7 1 9 */
-     397,    /* OBJ_ac_proxying                  1 3 6 1 5 5 7 1 10 */
-     398,    /* OBJ_sinfo_access                 1 3 6 1 5 5 7 1 11 */
-     663,    /* OBJ_proxyCertInfo                1 3 6 1 5 5 7 1 14 */
-    1020,    /* OBJ_tlsfeature                   1 3 6 1 5 5 7 1 24 */
-     164,    /* OBJ_id_qt_cps                    1 3 6 1 5 5 7 2 1 */
-     165,    /* OBJ_id_qt_unotice                1 3 6 1 5 5 7 2 2 */
-     293,    /* OBJ_textNotice                   1 3 6 1 5 5 7 2 3 */
-     129,    /* OBJ_server_auth                  1 3 6 1 5 5 7 3 1 */
-     130,    /* OBJ_client_auth                  1 3 6 1 5 5 7 3 2 */
-     131,    /* OBJ_code_sign                    1 3 6 1 5 5 7 3 3 */
-     132,    /* OBJ_email_protect                1 3 6 1 5 5 7 3 4 */
-     294,    /* OBJ_ipsecEndSystem               1 3 6 1 5 5 7 3 5 */
-     295,    /* OBJ_ipsecTunnel                  1 3 6 1 5 5 7 3 6 */
-     296,    /* OBJ_ipsecUser                    1 3 6 1 5 5 7 3 7 */
-     133,    /* OBJ_time_stamp                   1 3 6 1 5 5 7 3 8 */
-     180,    /* OBJ_OCSP_sign                    1 3 6 1 5 5 7 3 9 */
-     297,    /* OBJ_dvcs                         1 3 6 1 5 5 7 3 10 */
-    1022,    /* OBJ_ipsec_IKE                    1 3 6 1 5 5 7 3 17 */
-    1023,    /* OBJ_capwapAC                     1 3 6 1 5 5 7 3 18 */
-    1024,    /* OBJ_capwapWTP                    1 3 6 1 5 5 7 3 19 */
-    1025,    /* OBJ_sshClient                    1 3 6 1 5 5 7 3 21 */
-    1026,    /* OBJ_sshServer                    1 3 6 1 5 5 7 3 22 */
-    1027,    /* OBJ_sendRouter                   1 3 6 1 5 5 7 3 23 */
-    1028,    /* OBJ_sendProxiedRouter            1 3 6 1 5 5 7 3 24 */
-    1029,    /* OBJ_sendOwner                    1 3 6 1 5 5 7 3 25 */
-    1030,    /* OBJ_sendProxiedOwner             1 3 6 1 5 5 7 3 26 */
-    1131,    /* OBJ_cmcCA                        1 3 6 1 5 5 7 3 27 */
-    1132,    /* OBJ_cmcRA                        1 3 6 1 5 5 7 3 28 */
-     298,    /* OBJ_id_it_caProtEncCert          1 3 6 1 5 5 7 4 1 */
-     299,    /* OBJ_id_it_signKeyPairTypes       1 3 6 1 5 5 7 4 2 */
-     300,    /* OBJ_id_it_encKeyPairTypes        1 3 6 1 5 5 7 4 3 */
-     301,    /* OBJ_id_it_preferredSymmAlg       1 3 6 1 5 5 7 4 4 */
-     302,    /* OBJ_id_it_caKeyUpdateInfo        1 3 6 1 5 5 7 4 5 */
-     303,    /* OBJ_id_it_currentCRL             1 3 6 1 5 5 7 4 6 */
-     304,    /* OBJ_id_it_unsupportedOIDs        1 3 6 1 5 5 7 4 7 */
-     305,    /* OBJ_id_it_subscriptionRequest    1 3 6 1 5 5 7 4 8 */
-     306,    /* OBJ_id_it_subscriptionResponse   1 3 6 1 5 5 7 4 9 */
-     307,    /* OBJ_id_it_keyPairParamReq        1 3 6 1 5 5 7 4 10 */
-     308,    /* OBJ_id_it_keyPairParamRep        1 3 6 1 5 5 7 4 11 */
-     309,    /* OBJ_id_it_revPassphrase          1 3 6 1 5 5 7 4 12 */
-     310,    /* OBJ_id_it_implicitConfirm        1 3 6 1 5 5 7 4 13 */
-     311,    /* OBJ_id_it_confirmWaitTime        1 3 6 1 5 5 7 4 14 */
-     312,    /* OBJ_id_it_origPKIMessage         1 3 6 1 5 5 7 4 15 */
-     784,    /* OBJ_id_it_suppLangTags           1 3 6 1 5 5 7 4 16 */
-     313,    /* OBJ_id_regCtrl                   1 3 6 1 5 5 7 5 1 */
-     314,    /* OBJ_id_regInfo                   1 3 6 1 5 5 7 5 2 */
-     323,    /* OBJ_id_alg_des40                 1 3 6 1 5 5 7 6 1 */
-     324,    /* OBJ_id_alg_noSignature           1 3 6 1 5 5 7 6 2 */
-     325,    /* OBJ_id_alg_dh_sig_hmac_sha1      1 3 6 1 5 5 7 6 3 */
-     326,    /* OBJ_id_alg_dh_pop                1 3 6 1 5 5 7 6 4 */
-     327,    /* OBJ_id_cmc_statusInfo            1 3 6 1 5 5 7 7 1 */
-     328,    /* OBJ_id_cmc_identification        1 3 6 1 5 5 7 7 2 */
+     461,    /* OBJ_info                         0 9 2342 19200300 100 1 4 */
+       0,
+    1177,    /* OBJ_id_tc26_cipher_gostr3412_2015_kuznyechik_ctracpkm 1 2 643 7 1 1 5 2 1 */
+     966,    /* OBJ_camellia_192_ccm             0 3 4401 5 3 1 9 27 */
+     592,    /* OBJ_setct_BatchAdminReqTBE       2 23 42 0 74 */
+       0,
+       0,
+     590,    /* OBJ_setct_CredRevReqTBEX         2 23 42 0 72 */
+    1035,    /* OBJ_X448                         1 3 101 111 */
+       0,
+       0,
+     972,    /* OBJ_camellia_256_cmac            0 3 4401 5 3 1 9 50 */
+     403,    /* OBJ_no_rev_avail                 2 5 29 56 */
+     102,    /* OBJ_uniqueIdentifier             0 9 2342 19200300 100 1 44 */
+       0,
+       0,
+     255,    /* OBJ_id_smime_cti_ets_proofOfApproval 1 2 840 113549 1 9 16 6 5 */
+     142,    /* OBJ_invalidity_date              2 5 29 24 */
+      31,    /* OBJ_des_cbc                      1 3 14 3 2 7 */
+     106,    /* OBJ_title                        2 5 4 12 */
      329,    /* OBJ_id_cmc_identityProof         1 3 6 1 5 5 7 7 3 */
-     330,    /* OBJ_id_cmc_dataReturn            1 3 6 1 5 5 7 7 4 */
-     331,    /* OBJ_id_cmc_transactionId         1 3 6 1 5 5 7 7 5 */
-     332,    /* OBJ_id_cmc_senderNonce           1 3 6 1 5 5 7 7 6 */
-     333,    /* OBJ_id_cmc_recipientNonce        1 3 6 1 5 5 7 7 7 */
-     334,    /* OBJ_id_cmc_addExtensions         1 3 6 1 5 5 7 7 8 */
-     335,    /* OBJ_id_cmc_encryptedPOP          1 3 6 1 5 5 7 7 9 */
+    1107,    /* OBJ_dsa_with_SHA512              2 16 840 1 101 3 4 3 4 */
+       0,
+       0,
+     679,    /* OBJ_wap_wsg                      2 23 43 1 */
+     392,    /* OBJ_Domain                       0 9 2342 19200300 100 4 13 */
+    1067,    /* OBJ_aria_128_cfb128              1 2 410 200046 1 1 3 */
+       0,
+     435,    /* OBJ_pss                          0 9 2342 */
+       0,
+       0,
+     372,    /* OBJ_id_pkix_OCSP_extendedStatus  1 3 6 1 5 5 7 48 1 8 */
+       0,
+       0,
+    1230,    /* OBJ_dilithium3                   1 3 6 1 4 1 2 267 7 6 5 */
+       0,
+       0,
+      99,    /* OBJ_givenName                    2 5 4 42 */
+    1241,    /* OBJ_rsa3072_sphincssha2128fsimple 1 3 9999 6 4 15 */
+       0,
+     475,    /* OBJ_otherMailbox                 0 9 2342 19200300 100 1 22 */
+     385,    /* OBJ_Private                      1 3 6 1 4 */
+       0,
+       0,
+     736,    /* OBJ_wap_wsg_idm_ecid_wtls3       2 23 43 1 4 3 */
+     524,    /* OBJ_setct_PIData                 2 23 42 0 5 */
+       0,
+     930,    /* OBJ_brainpoolP320t1              1 3 36 3 3 2 8 1 1 10 */
+     711,    /* OBJ_secp192k1                    1 3 132 0 31 */
+     980,    /* OBJ_id_GostR3410_2012_512        1 2 643 7 1 1 1 2 */
+     636,    /* OBJ_set_brand_IATA_ATA           2 23 42 8 1 */
+       0,
+       0,
+    1249,    /* OBJ_rsa3072_sphincsshake128fsimple 1 3 9999 6 7 15 */
+      75,    /* OBJ_netscape_renewal_url         2 16 840 1 113730 1 7 */
+     187,    /* OBJ_pkcs5                        1 2 840 113549 1 5 */
+     252,    /* OBJ_id_smime_cti_ets_proofOfReceipt 1 2 840 113549 1 9 16 6 2 */
+     639,    /* OBJ_set_brand_JCB                2 23 42 8 35 */
+       0,
+     217,    /* OBJ_id_smime_aa_encapContentType 1 2 840 113549 1 9 16 2 6 */
+     968,    /* OBJ_camellia_192_cmac            0 3 4401 5 3 1 9 30 */
+    1006,    /* OBJ_SNILS                        1 2 643 100 3 */
+       0,
+      85,    /* OBJ_subject_alt_name             2 5 29 17 */
+       0,
+       0,
+     288,    /* OBJ_ac_targeting                 1 3 6 1 5 5 7 1 5 */
+     355,    /* OBJ_id_aca_accessIdentity        1 3 6 1 5 5 7 10 2 */
+     851,    /* OBJ_id_GostR3410_2001_cc         1 2 643 2 9 1 5 4 */
+    1000,    /* OBJ_id_tc26_digest_constants     1 2 643 7 1 2 2 */
+     939,    /* OBJ_dhSinglePass_stdDH_sha384kdf_scheme 1 3 132 1 11 2 */
+     867,    /* OBJ_facsimileTelephoneNumber     2 5 4 23 */
+     845,    /* OBJ_id_GostR3410_94_a            1 2 643 2 2 20 1 */
+       0,
+     576,    /* OBJ_setct_AcqCardCodeMsgTBE      2 23 42 0 58 */
+     933,    /* OBJ_brainpoolP512r1              1 3 36 3 3 2 8 1 1 13 */
+      65,    /* OBJ_sha1WithRSAEncryption        1 2 840 113549 1 1 5 */
+       0,
+       0,
+    1181,    /* OBJ_id_tc26_wrap_gostr3412_2015_magma_kexp15 1 2 643 7 1 1 7 1 1 */
+      72,    /* OBJ_netscape_base_url            2 16 840 1 113730 1 2 */
+       0,
+     833,    /* OBJ_id_GostR3410_94_CryptoPro_B_ParamSet 1 2 643 2 2 32 3 */
+       0,
+     629,    /* OBJ_setAttr_IssCap_T2            2 23 42 3 3 4 */
+       0,
+     364,    /* OBJ_ad_dvcs                      1 3 6 1 5 5 7 48 4 */
+     117,    /* OBJ_ripemd160                    1 3 36 3 2 1 */
+     846,    /* OBJ_id_GostR3410_94_aBis         1 2 643 2 2 20 2 */
+     225,    /* OBJ_id_smime_aa_timeStampToken   1 2 840 113549 1 9 16 2 14 */
+     120,    /* OBJ_rc5_cbc                      1 2 840 113549 3 8 */
+       0,
+     877,    /* OBJ_roleOccupant                 2 5 4 33 */
+    1147,    /* OBJ_id_tc26_gost_3410_2012_256_constants 1 2 643 7 1 2 1 1 */
+       0,
+       0,
+     803,    /* OBJ_dsa_with_SHA256              2 16 840 1 101 3 4 3 2 */
+       0,
+       0,
+       0,
+       0,
+     786,    /* OBJ_id_smime_ct_compressedData   1 2 840 113549 1 9 16 1 9 */
+      23,    /* OBJ_pkcs7_enveloped              1 2 840 113549 1 7 3 */
+     192,    /* OBJ_id_smime_alg                 1 2 840 113549 1 9 16 3 */
+       0,
+    1156,    /* OBJ_hmacWithDstu34311            1 2 804 2 1 1 1 1 1 2 */
+    1236,    /* OBJ_rsa3072_falcon512            1 3 9999 3 8 */
+     739,    /* OBJ_wap_wsg_idm_ecid_wtls6       2 23 43 1 4 6 */
+       0,
+       0,
+     282,    /* OBJ_id_mod_ocsp                  1 3 6 1 5 5 7 0 14 */
+       0,
+       0,
+     853,    /* OBJ_id_GostR3411_94_with_GostR3410_2001_cc 1 2 643 2 9 1 3 4 */
+     257,    /* OBJ_md4                          1 2 840 113549 2 4 */
+     826,    /* OBJ_id_Gost28147_89_CryptoPro_C_ParamSet 1 2 643 2 2 31 3 */
+       0,
+       0,
+       0,
+       0,
+     182,    /* OBJ_member_body                  1 2 */
+     544,    /* OBJ_setct_CapReqTBS              2 23 42 0 26 */
+     731,    /* OBJ_sect409k1                    1 3 132 0 36 */
+       0,
+       0,
+     191,    /* OBJ_id_smime_aa                  1 2 840 113549 1 9 16 2 */
+       0,
+      70,    /* OBJ_dsaWithSHA1_2                1 3 14 3 2 27 */
+     179,    /* OBJ_ad_ca_issuers                1 3 6 1 5 5 7 48 2 */
+    1243,    /* OBJ_p256_sphincssha2128ssimple   1 3 9999 6 4 17 */
+     146,    /* OBJ_pbe_WithSHA1And3_Key_TripleDES_CBC 1 2 840 113549 1 12 1 3 */
+       0,
+     230,    /* OBJ_id_smime_aa_ets_otherSigCert 1 2 840 113549 1 9 16 2 19 */
+       0,
+       0,
+     134,    /* OBJ_ms_code_ind                  1 3 6 1 4 1 311 2 1 21 */
+     720,    /* OBJ_sect131r2                    1 3 132 0 23 */
+       0,
+       0,
+     584,    /* OBJ_setct_CapRevReqTBEX          2 23 42 0 66 */
+     531,    /* OBJ_setct_PInitResData           2 23 42 0 12 */
      336,    /* OBJ_id_cmc_decryptedPOP          1 3 6 1 5 5 7 7 10 */
-     337,    /* OBJ_id_cmc_lraPOPWitness         1 3 6 1 5 5 7 7 11 */
-     338,    /* OBJ_id_cmc_getCert               1 3 6 1 5 5 7 7 15 */
-     339,    /* OBJ_id_cmc_getCRL                1 3 6 1 5 5 7 7 16 */
-     340,    /* OBJ_id_cmc_revokeRequest         1 3 6 1 5 5 7 7 17 */
-     341,    /* OBJ_id_cmc_regInfo               1 3 6 1 5 5 7 7 18 */
-     342,    /* OBJ_id_cmc_responseInfo          1 3 6 1 5 5 7 7 19 */
-     343,    /* OBJ_id_cmc_queryPending          1 3 6 1 5 5 7 7 21 */
-     344,    /* OBJ_id_cmc_popLinkRandom         1 3 6 1 5 5 7 7 22 */
-     345,    /* OBJ_id_cmc_popLinkWitness        1 3 6 1 5 5 7 7 23 */
-     346,    /* OBJ_id_cmc_confirmCertAcceptance 1 3 6 1 5 5 7 7 24 */
-     347,    /* OBJ_id_on_personalData           1 3 6 1 5 5 7 8 1 */
-     858,    /* OBJ_id_on_permanentIdentifier    1 3 6 1 5 5 7 8 3 */
-     348,    /* OBJ_id_pda_dateOfBirth           1 3 6 1 5 5 7 9 1 */
-     349,    /* OBJ_id_pda_placeOfBirth          1 3 6 1 5 5 7 9 2 */
-     351,    /* OBJ_id_pda_gender                1 3 6 1 5 5 7 9 3 */
-     352,    /* OBJ_id_pda_countryOfCitizenship  1 3 6 1 5 5 7 9 4 */
+       0,
+     703,    /* OBJ_X9_62_c2tnb431r1             1 2 840 10045 3 0 20 */
+       0,
+       0,
+     955,    /* OBJ_jurisdictionLocalityName     1 3 6 1 4 1 311 60 2 1 1 */
+     932,    /* OBJ_brainpoolP384t1              1 3 36 3 3 2 8 1 1 12 */
+       0,
+       0,
+       0,
+       0,
+    1096,    /* OBJ_sha3_224                     2 16 840 1 101 3 4 2 7 */
+     903,    /* OBJ_id_aes256_wrap_pad           2 16 840 1 101 3 4 1 48 */
+       0,
+     859,    /* OBJ_searchGuide                  2 5 4 14 */
+     787,    /* OBJ_id_ct_asciiTextWithCRLF      1 2 840 113549 1 9 16 1 27 */
+       0,
+       0,
+       0,
+    1034,    /* OBJ_X25519                       1 3 101 110 */
+    1117,    /* OBJ_RSA_SHA3_256                 2 16 840 1 101 3 4 3 14 */
+     623,    /* OBJ_setAttr_IssCap               2 23 42 3 3 */
+     668,    /* OBJ_sha256WithRSAEncryption      1 2 840 113549 1 1 11 */
+       0,
+       0,
+       0,
+       0,
+     700,    /* OBJ_X9_62_c2pnb304w1             1 2 840 10045 3 0 17 */
+       0,
+     399,    /* OBJ_id_aca_encAttrs              1 3 6 1 5 5 7 10 6 */
+       0,
+       0,
+       0,
+     769,    /* OBJ_subject_directory_attributes 2 5 29 9 */
+     388,    /* OBJ_Mail                         1 3 6 1 7 */
+       0,
+    1112,    /* OBJ_ecdsa_with_SHA3_224          2 16 840 1 101 3 4 3 9 */
+       0,
+     755,    /* OBJ_camellia_192_ecb             0 3 4401 5 3 1 9 21 */
+       0,
+       0,
+       0,
+       0,
+      87,    /* OBJ_basic_constraints            2 5 29 19 */
+       0,
+    1116,    /* OBJ_RSA_SHA3_224                 2 16 840 1 101 3 4 3 13 */
+     662,    /* OBJ_id_ppl                       1 3 6 1 5 5 7 21 */
+       0,
+       0,
+     483,    /* OBJ_cNAMERecord                  0 9 2342 19200300 100 1 31 */
+     324,    /* OBJ_id_alg_noSignature           1 3 6 1 5 5 7 6 2 */
+       0,
+       0,
+    1057,    /* OBJ_blake2s256                   1 3 6 1 4 1 1722 12 2 2 8 */
+       0,
+       0,
+     394,    /* OBJ_selected_attribute_types     2 5 1 5 */
      353,    /* OBJ_id_pda_countryOfResidence    1 3 6 1 5 5 7 9 5 */
-     354,    /* OBJ_id_aca_authenticationInfo    1 3 6 1 5 5 7 10 1 */
-     355,    /* OBJ_id_aca_accessIdentity        1 3 6 1 5 5 7 10 2 */
+       0,
+       0,
+       0,
+     343,    /* OBJ_id_cmc_queryPending          1 3 6 1 5 5 7 7 21 */
+       0,
+       0,
+       0,
+    1169,    /* OBJ_uacurve9                     1 2 804 2 1 1 1 1 3 1 1 2 9 */
+       0,
+       0,
+     326,    /* OBJ_id_alg_dh_pop                1 3 6 1 5 5 7 6 4 */
+     953,    /* OBJ_ct_precert_signer            1 3 6 1 4 1 11129 2 4 4 */
+       0,
+       0,
+       0,
+     834,    /* OBJ_id_GostR3410_94_CryptoPro_C_ParamSet 1 2 643 2 2 32 4 */
+     827,    /* OBJ_id_Gost28147_89_CryptoPro_D_ParamSet 1 2 643 2 2 31 4 */
+       0,
+     844,    /* OBJ_id_GostR3410_2001_CryptoPro_XchB_ParamSet 1 2 643 2 2 36 1 */
+    1141,    /* OBJ_oscca                        1 2 156 10197 */
+    1159,    /* OBJ_dstu4145be                   1 2 804 2 1 1 1 1 3 1 1 1 1 */
+      20,    /* OBJ_pkcs7                        1 2 840 113549 1 7 */
      356,    /* OBJ_id_aca_chargingIdentity      1 3 6 1 5 5 7 10 3 */
-     357,    /* OBJ_id_aca_group                 1 3 6 1 5 5 7 10 4 */
-     358,    /* OBJ_id_aca_role                  1 3 6 1 5 5 7 10 5 */
-     399,    /* OBJ_id_aca_encAttrs              1 3 6 1 5 5 7 10 6 */
-     359,    /* OBJ_id_qcs_pkixQCSyntax_v1       1 3 6 1 5 5 7 11 1 */
-     360,    /* OBJ_id_cct_crs                   1 3 6 1 5 5 7 12 1 */
-     361,    /* OBJ_id_cct_PKIData               1 3 6 1 5 5 7 12 2 */
-     362,    /* OBJ_id_cct_PKIResponse           1 3 6 1 5 5 7 12 3 */
+     831,    /* OBJ_id_GostR3410_94_TestParamSet 1 2 643 2 2 32 0 */
+     682,    /* OBJ_X9_62_tpBasis                1 2 840 10045 1 2 3 2 */
+       0,
+       0,
+       0,
+       0,
+       0,
+     604,    /* OBJ_setext_pinAny                2 23 42 1 5 */
+      88,    /* OBJ_crl_number                   2 5 29 20 */
+       0,
+     627,    /* OBJ_setAttr_Token_B0Prime        2 23 42 3 2 2 */
+       0,
+       0,
+       0,
+      90,    /* OBJ_authority_key_identifier     2 5 29 35 */
+       0,
+     766,    /* OBJ_camellia_128_ofb128          0 3 4401 5 3 1 9 3 */
+       0,
+       0,
+       0,
+       0,
+       0,
+       0,
+     470,    /* OBJ_documentVersion              0 9 2342 19200300 100 1 13 */
+       0,
+     520,    /* OBJ_setct_PANToken               2 23 42 0 1 */
+       0,
      664,    /* OBJ_id_ppl_anyLanguage           1 3 6 1 5 5 7 21 0 */
-     665,    /* OBJ_id_ppl_inheritAll            1 3 6 1 5 5 7 21 1 */
-     667,    /* OBJ_Independent                  1 3 6 1 5 5 7 21 2 */
-     178,    /* OBJ_ad_OCSP                      1 3 6 1 5 5 7 48 1 */
-     179,    /* OBJ_ad_ca_issuers                1 3 6 1 5 5 7 48 2 */
-     363,    /* OBJ_ad_timeStamping              1 3 6 1 5 5 7 48 3 */
-     364,    /* OBJ_ad_dvcs                      1 3 6 1 5 5 7 48 4 */
-     785,    /* OBJ_caRepository                 1 3 6 1 5 5 7 48 5 */
-     780,    /* OBJ_hmac_md5                     1 3 6 1 5 5 8 1 1 */
-     781,    /* OBJ_hmac_sha1                    1 3 6 1 5 5 8 1 2 */
-     913,    /* OBJ_aes_128_xts                  1 3 111 2 1619 0 1 1 */
-     914,    /* OBJ_aes_256_xts                  1 3 111 2 1619 0 1 2 */
-      58,    /* OBJ_netscape_cert_extension      2 16 840 1 113730 1 */
-      59,    /* OBJ_netscape_data_type           2 16 840 1 113730 2 */
-     438,    /* OBJ_pilotAttributeType           0 9 2342 19200300 100 1 */
-     439,    /* OBJ_pilotAttributeSyntax         0 9 2342 19200300 100 3 */
-     440,    /* OBJ_pilotObjectClass             0 9 2342 19200300 100 4 */
-     441,    /* OBJ_pilotGroups                  0 9 2342 19200300 100 10 */
-    1065,    /* OBJ_aria_128_ecb                 1 2 410 200046 1 1 1 */
-    1066,    /* OBJ_aria_128_cbc                 1 2 410 200046 1 1 2 */
-    1067,    /* OBJ_aria_128_cfb128              1 2 410 200046 1 1 3 */
-    1068,    /* OBJ_aria_128_ofb128              1 2 410 200046 1 1 4 */
-    1069,    /* OBJ_aria_128_ctr                 1 2 410 200046 1 1 5 */
-    1070,    /* OBJ_aria_192_ecb                 1 2 410 200046 1 1 6 */
-    1071,    /* OBJ_aria_192_cbc                 1 2 410 200046 1 1 7 */
-    1072,    /* OBJ_aria_192_cfb128              1 2 410 200046 1 1 8 */
+       0,
     1073,    /* OBJ_aria_192_ofb128              1 2 410 200046 1 1 9 */
-    1074,    /* OBJ_aria_192_ctr                 1 2 410 200046 1 1 10 */
-    1075,    /* OBJ_aria_256_ecb                 1 2 410 200046 1 1 11 */
-    1076,    /* OBJ_aria_256_cbc                 1 2 410 200046 1 1 12 */
-    1077,    /* OBJ_aria_256_cfb128              1 2 410 200046 1 1 13 */
-    1078,    /* OBJ_aria_256_ofb128              1 2 410 200046 1 1 14 */
-    1079,    /* OBJ_aria_256_ctr                 1 2 410 200046 1 1 15 */
-    1123,    /* OBJ_aria_128_gcm                 1 2 410 200046 1 1 34 */
-    1124,    /* OBJ_aria_192_gcm                 1 2 410 200046 1 1 35 */
-    1125,    /* OBJ_aria_256_gcm                 1 2 410 200046 1 1 36 */
-    1120,    /* OBJ_aria_128_ccm                 1 2 410 200046 1 1 37 */
-    1121,    /* OBJ_aria_192_ccm                 1 2 410 200046 1 1 38 */
-    1122,    /* OBJ_aria_256_ccm                 1 2 410 200046 1 1 39 */
-    1174,    /* OBJ_id_tc26_cipher_gostr3412_2015_magma_ctracpkm 1 2 643 7 1 1 5 1 1 */
-    1175,    /* OBJ_id_tc26_cipher_gostr3412_2015_magma_ctracpkm_omac 1 2 643 7 1 1 5 1 2 */
-    1177,    /* OBJ_id_tc26_cipher_gostr3412_2015_kuznyechik_ctracpkm 1 2 643 7 1 1 5 2 1 */
-    1178,    /* OBJ_id_tc26_cipher_gostr3412_2015_kuznyechik_ctracpkm_omac 1 2 643 7 1 1 5 2 2 */
-    1181,    /* OBJ_id_tc26_wrap_gostr3412_2015_magma_kexp15 1 2 643 7 1 1 7 1 1 */
-    1183,    /* OBJ_id_tc26_wrap_gostr3412_2015_kuznyechik_kexp15 1 2 643 7 1 1 7 2 1 */
-    1148,    /* OBJ_id_tc26_gost_3410_2012_256_paramSetA 1 2 643 7 1 2 1 1 1 */
-    1184,    /* OBJ_id_tc26_gost_3410_2012_256_paramSetB 1 2 643 7 1 2 1 1 2 */
-    1185,    /* OBJ_id_tc26_gost_3410_2012_256_paramSetC 1 2 643 7 1 2 1 1 3 */
-    1186,    /* OBJ_id_tc26_gost_3410_2012_256_paramSetD 1 2 643 7 1 2 1 1 4 */
-     997,    /* OBJ_id_tc26_gost_3410_2012_512_paramSetTest 1 2 643 7 1 2 1 2 0 */
-     998,    /* OBJ_id_tc26_gost_3410_2012_512_paramSetA 1 2 643 7 1 2 1 2 1 */
-     999,    /* OBJ_id_tc26_gost_3410_2012_512_paramSetB 1 2 643 7 1 2 1 2 2 */
-    1149,    /* OBJ_id_tc26_gost_3410_2012_512_paramSetC 1 2 643 7 1 2 1 2 3 */
-    1003,    /* OBJ_id_tc26_gost_28147_param_Z   1 2 643 7 1 2 5 1 1 */
-     108,    /* OBJ_cast5_cbc                    1 2 840 113533 7 66 10 */
-     112,    /* OBJ_pbeWithMD5AndCast5_CBC       1 2 840 113533 7 66 12 */
-     782,    /* OBJ_id_PasswordBasedMAC          1 2 840 113533 7 66 13 */
-     783,    /* OBJ_id_DHBasedMac                1 2 840 113533 7 66 30 */
-       6,    /* OBJ_rsaEncryption                1 2 840 113549 1 1 1 */
-       7,    /* OBJ_md2WithRSAEncryption         1 2 840 113549 1 1 2 */
-     396,    /* OBJ_md4WithRSAEncryption         1 2 840 113549 1 1 3 */
-       8,    /* OBJ_md5WithRSAEncryption         1 2 840 113549 1 1 4 */
-      65,    /* OBJ_sha1WithRSAEncryption        1 2 840 113549 1 1 5 */
-     644,    /* OBJ_rsaOAEPEncryptionSET         1 2 840 113549 1 1 6 */
-     919,    /* OBJ_rsaesOaep                    1 2 840 113549 1 1 7 */
-     911,    /* OBJ_mgf1                         1 2 840 113549 1 1 8 */
-     935,    /* OBJ_pSpecified                   1 2 840 113549 1 1 9 */
-     912,    /* OBJ_rsassaPss                    1 2 840 113549 1 1 10 */
-     668,    /* OBJ_sha256WithRSAEncryption      1 2 840 113549 1 1 11 */
-     669,    /* OBJ_sha384WithRSAEncryption      1 2 840 113549 1 1 12 */
-     670,    /* OBJ_sha512WithRSAEncryption      1 2 840 113549 1 1 13 */
-     671,    /* OBJ_sha224WithRSAEncryption      1 2 840 113549 1 1 14 */
-    1145,    /* OBJ_sha512_224WithRSAEncryption  1 2 840 113549 1 1 15 */
-    1146,    /* OBJ_sha512_256WithRSAEncryption  1 2 840 113549 1 1 16 */
-      28,    /* OBJ_dhKeyAgreement               1 2 840 113549 1 3 1 */
-       9,    /* OBJ_pbeWithMD2AndDES_CBC         1 2 840 113549 1 5 1 */
-      10,    /* OBJ_pbeWithMD5AndDES_CBC         1 2 840 113549 1 5 3 */
-     168,    /* OBJ_pbeWithMD2AndRC2_CBC         1 2 840 113549 1 5 4 */
-     169,    /* OBJ_pbeWithMD5AndRC2_CBC         1 2 840 113549 1 5 6 */
-     170,    /* OBJ_pbeWithSHA1AndDES_CBC        1 2 840 113549 1 5 10 */
-      68,    /* OBJ_pbeWithSHA1AndRC2_CBC        1 2 840 113549 1 5 11 */
-      69,    /* OBJ_id_pbkdf2                    1 2 840 113549 1 5 12 */
-     161,    /* OBJ_pbes2                        1 2 840 113549 1 5 13 */
-     162,    /* OBJ_pbmac1                       1 2 840 113549 1 5 14 */
-      21,    /* OBJ_pkcs7_data                   1 2 840 113549 1 7 1 */
-      22,    /* OBJ_pkcs7_signed                 1 2 840 113549 1 7 2 */
-      23,    /* OBJ_pkcs7_enveloped              1 2 840 113549 1 7 3 */
-      24,    /* OBJ_pkcs7_signedAndEnveloped     1 2 840 113549 1 7 4 */
-      25,    /* OBJ_pkcs7_digest                 1 2 840 113549 1 7 5 */
-      26,    /* OBJ_pkcs7_encrypted              1 2 840 113549 1 7 6 */
-      48,    /* OBJ_pkcs9_emailAddress           1 2 840 113549 1 9 1 */
-      49,    /* OBJ_pkcs9_unstructuredName       1 2 840 113549 1 9 2 */
-      50,    /* OBJ_pkcs9_contentType            1 2 840 113549 1 9 3 */
-      51,    /* OBJ_pkcs9_messageDigest          1 2 840 113549 1 9 4 */
-      52,    /* OBJ_pkcs9_signingTime            1 2 840 113549 1 9 5 */
-      53,    /* OBJ_pkcs9_countersignature       1 2 840 113549 1 9 6 */
-      54,    /* OBJ_pkcs9_challengePassword      1 2 840 113549 1 9 7 */
-      55,    /* OBJ_pkcs9_unstructuredAddress    1 2 840 113549 1 9 8 */
+     545,    /* OBJ_setct_CapReqTBSX             2 23 42 0 27 */
+       0,
+       0,
+     244,    /* OBJ_id_smime_alg_RC2wrap         1 2 840 113549 1 9 16 3 4 */
+    1144,    /* OBJ_sm3WithRSAEncryption         1 2 156 10197 1 504 */
+       0,
+      81,    /* OBJ_id_ce                        2 5 29 */
+       0,
+       0,
+       0,
+       0,
+     944,    /* OBJ_dhSinglePass_cofactorDH_sha384kdf_scheme 1 3 132 1 14 2 */
+    1105,    /* OBJ_hmac_sha3_512                2 16 840 1 101 3 4 2 16 */
+       0,
+       0,
+       0,
+    1032,    /* OBJ_pkInitClientAuth             1 3 6 1 5 2 3 4 */
+     207,    /* OBJ_id_smime_ct_TSTInfo          1 2 840 113549 1 9 16 1 4 */
+       0,
+       0,
+     632,    /* OBJ_setAttr_T2Enc                2 23 42 3 3 4 1 */
+       0,
+    1167,    /* OBJ_uacurve7                     1 2 804 2 1 1 1 1 3 1 1 2 7 */
+     620,    /* OBJ_setAttr_Cert                 2 23 42 3 0 */
+    1033,    /* OBJ_pkInitKDC                    1 3 6 1 5 2 3 5 */
+       0,
+       0,
+     951,    /* OBJ_ct_precert_scts              1 3 6 1 4 1 11129 2 4 2 */
+     368,    /* OBJ_id_pkix_OCSP_acceptableResponses 1 3 6 1 5 5 7 48 1 4 */
       56,    /* OBJ_pkcs9_extCertAttributes      1 2 840 113549 1 9 9 */
-     172,    /* OBJ_ext_req                      1 2 840 113549 1 9 14 */
-     167,    /* OBJ_SMIMECapabilities            1 2 840 113549 1 9 15 */
-     188,    /* OBJ_SMIME                        1 2 840 113549 1 9 16 */
-     156,    /* OBJ_friendlyName                 1 2 840 113549 1 9 20 */
-     157,    /* OBJ_localKeyID                   1 2 840 113549 1 9 21 */
+    1148,    /* OBJ_id_tc26_gost_3410_2012_256_paramSetA 1 2 643 7 1 2 1 1 1 */
+       0,
+       0,
+       0,
+       0,
      681,    /* OBJ_X9_62_onBasis                1 2 840 10045 1 2 3 1 */
-     682,    /* OBJ_X9_62_tpBasis                1 2 840 10045 1 2 3 2 */
-     683,    /* OBJ_X9_62_ppBasis                1 2 840 10045 1 2 3 3 */
-     417,    /* OBJ_ms_csp_name                  1 3 6 1 4 1 311 17 1 */
-     856,    /* OBJ_LocalKeySet                  1 3 6 1 4 1 311 17 2 */
-     390,    /* OBJ_dcObject                     1 3 6 1 4 1 1466 344 */
-      91,    /* OBJ_bf_cbc                       1 3 6 1 4 1 3029 1 2 */
-     973,    /* OBJ_id_scrypt                    1 3 6 1 4 1 11591 4 11 */
-     315,    /* OBJ_id_regCtrl_regToken          1 3 6 1 5 5 7 5 1 1 */
-     316,    /* OBJ_id_regCtrl_authenticator     1 3 6 1 5 5 7 5 1 2 */
-     317,    /* OBJ_id_regCtrl_pkiPublicationInfo 1 3 6 1 5 5 7 5 1 3 */
-     318,    /* OBJ_id_regCtrl_pkiArchiveOptions 1 3 6 1 5 5 7 5 1 4 */
-     319,    /* OBJ_id_regCtrl_oldCertID         1 3 6 1 5 5 7 5 1 5 */
-     320,    /* OBJ_id_regCtrl_protocolEncrKey   1 3 6 1 5 5 7 5 1 6 */
-     321,    /* OBJ_id_regInfo_utf8Pairs         1 3 6 1 5 5 7 5 2 1 */
-     322,    /* OBJ_id_regInfo_certReq           1 3 6 1 5 5 7 5 2 2 */
-     365,    /* OBJ_id_pkix_OCSP_basic           1 3 6 1 5 5 7 48 1 1 */
-     366,    /* OBJ_id_pkix_OCSP_Nonce           1 3 6 1 5 5 7 48 1 2 */
-     367,    /* OBJ_id_pkix_OCSP_CrlID           1 3 6 1 5 5 7 48 1 3 */
-     368,    /* OBJ_id_pkix_OCSP_acceptableResponses 1 3 6 1 5 5 7 48 1 4 */
-     369,    /* OBJ_id_pkix_OCSP_noCheck         1 3 6 1 5 5 7 48 1 5 */
-     370,    /* OBJ_id_pkix_OCSP_archiveCutoff   1 3 6 1 5 5 7 48 1 6 */
-     371,    /* OBJ_id_pkix_OCSP_serviceLocator  1 3 6 1 5 5 7 48 1 7 */
-     372,    /* OBJ_id_pkix_OCSP_extendedStatus  1 3 6 1 5 5 7 48 1 8 */
-     373,    /* OBJ_id_pkix_OCSP_valid           1 3 6 1 5 5 7 48 1 9 */
-     374,    /* OBJ_id_pkix_OCSP_path            1 3 6 1 5 5 7 48 1 10 */
-     375,    /* OBJ_id_pkix_OCSP_trustRoot       1 3 6 1 5 5 7 48 1 11 */
-     921,    /* OBJ_brainpoolP160r1              1 3 36 3 3 2 8 1 1 1 */
-     922,    /* OBJ_brainpoolP160t1              1 3 36 3 3 2 8 1 1 2 */
-     923,    /* OBJ_brainpoolP192r1              1 3 36 3 3 2 8 1 1 3 */
-     924,    /* OBJ_brainpoolP192t1              1 3 36 3 3 2 8 1 1 4 */
-     925,    /* OBJ_brainpoolP224r1              1 3 36 3 3 2 8 1 1 5 */
-     926,    /* OBJ_brainpoolP224t1              1 3 36 3 3 2 8 1 1 6 */
+     454,    /* OBJ_simpleSecurityObject         0 9 2342 19200300 100 4 19 */
+      64,    /* OBJ_sha1                         1 3 14 3 2 26 */
+       0,
+     467,    /* OBJ_manager                      0 9 2342 19200300 100 1 10 */
+       0,
+     669,    /* OBJ_sha384WithRSAEncryption      1 2 840 113549 1 1 12 */
+       0,
+       0,
      927,    /* OBJ_brainpoolP256r1              1 3 36 3 3 2 8 1 1 7 */
-     928,    /* OBJ_brainpoolP256t1              1 3 36 3 3 2 8 1 1 8 */
-     929,    /* OBJ_brainpoolP320r1              1 3 36 3 3 2 8 1 1 9 */
-     930,    /* OBJ_brainpoolP320t1              1 3 36 3 3 2 8 1 1 10 */
-     931,    /* OBJ_brainpoolP384r1              1 3 36 3 3 2 8 1 1 11 */
-     932,    /* OBJ_brainpoolP384t1              1 3 36 3 3 2 8 1 1 12 */
-     933,    /* OBJ_brainpoolP512r1              1 3 36 3 3 2 8 1 1 13 */
-     934,    /* OBJ_brainpoolP512t1              1 3 36 3 3 2 8 1 1 14 */
-     936,    /* OBJ_dhSinglePass_stdDH_sha1kdf_scheme 1 3 133 16 840 63 0 2 */
-     941,    /* OBJ_dhSinglePass_cofactorDH_sha1kdf_scheme 1 3 133 16 840 63 0 3 */
-     418,    /* OBJ_aes_128_ecb                  2 16 840 1 101 3 4 1 1 */
-     419,    /* OBJ_aes_128_cbc                  2 16 840 1 101 3 4 1 2 */
-     420,    /* OBJ_aes_128_ofb128               2 16 840 1 101 3 4 1 3 */
-     421,    /* OBJ_aes_128_cfb128               2 16 840 1 101 3 4 1 4 */
-     788,    /* OBJ_id_aes128_wrap               2 16 840 1 101 3 4 1 5 */
-     895,    /* OBJ_aes_128_gcm                  2 16 840 1 101 3 4 1 6 */
-     896,    /* OBJ_aes_128_ccm                  2 16 840 1 101 3 4 1 7 */
-     897,    /* OBJ_id_aes128_wrap_pad           2 16 840 1 101 3 4 1 8 */
-     422,    /* OBJ_aes_192_ecb                  2 16 840 1 101 3 4 1 21 */
-     423,    /* OBJ_aes_192_cbc                  2 16 840 1 101 3 4 1 22 */
-     424,    /* OBJ_aes_192_ofb128               2 16 840 1 101 3 4 1 23 */
-     425,    /* OBJ_aes_192_cfb128               2 16 840 1 101 3 4 1 24 */
-     789,    /* OBJ_id_aes192_wrap               2 16 840 1 101 3 4 1 25 */
-     898,    /* OBJ_aes_192_gcm                  2 16 840 1 101 3 4 1 26 */
+     504,    /* OBJ_mime_mhs                     1 3 6 1 7 1 */
+     990,    /* OBJ_id_tc26_cipher               1 2 643 7 1 1 5 */
+     405,    /* OBJ_ansi_X9_62                   1 2 840 10045 */
+       0,
+       0,
+       0,
+       0,
+     227,    /* OBJ_id_smime_aa_ets_commitmentType 1 2 840 113549 1 9 16 2 16 */
+     130,    /* OBJ_client_auth                  1 3 6 1 5 5 7 3 2 */
+       0,
+       0,
+     104,    /* OBJ_md5WithRSA                   1 3 14 3 2 3 */
+       0,
+      12,    /* OBJ_X509                         2 5 4 */
+       0,
+     400,    /* OBJ_role                         2 5 4 72 */
+       0,
+       0,
+     379,    /* OBJ_org                          1 3 */
+       0,
+       0,
+     804,    /* OBJ_whirlpool                    1 0 10118 3 0 55 */
+       0,
+       0,
+       0,
+     938,    /* OBJ_dhSinglePass_stdDH_sha256kdf_scheme 1 3 132 1 11 1 */
+     229,    /* OBJ_id_smime_aa_ets_signerAttr   1 2 840 113549 1 9 16 2 18 */
+       0,
+    1079,    /* OBJ_aria_256_ctr                 1 2 410 200046 1 1 15 */
+       0,
+     913,    /* OBJ_aes_128_xts                  1 3 111 2 1619 0 1 1 */
+       0,
+     432,    /* OBJ_hold_instruction_call_issuer 1 2 840 10040 2 2 */
+       0,
+       0,
+       0,
      899,    /* OBJ_aes_192_ccm                  2 16 840 1 101 3 4 1 27 */
-     900,    /* OBJ_id_aes192_wrap_pad           2 16 840 1 101 3 4 1 28 */
-     426,    /* OBJ_aes_256_ecb                  2 16 840 1 101 3 4 1 41 */
-     427,    /* OBJ_aes_256_cbc                  2 16 840 1 101 3 4 1 42 */
-     428,    /* OBJ_aes_256_ofb128               2 16 840 1 101 3 4 1 43 */
-     429,    /* OBJ_aes_256_cfb128               2 16 840 1 101 3 4 1 44 */
-     790,    /* OBJ_id_aes256_wrap               2 16 840 1 101 3 4 1 45 */
-     901,    /* OBJ_aes_256_gcm                  2 16 840 1 101 3 4 1 46 */
-     902,    /* OBJ_aes_256_ccm                  2 16 840 1 101 3 4 1 47 */
-     903,    /* OBJ_id_aes256_wrap_pad           2 16 840 1 101 3 4 1 48 */
-     672,    /* OBJ_sha256                       2 16 840 1 101 3 4 2 1 */
-     673,    /* OBJ_sha384                       2 16 840 1 101 3 4 2 2 */
-     674,    /* OBJ_sha512                       2 16 840 1 101 3 4 2 3 */
-     675,    /* OBJ_sha224                       2 16 840 1 101 3 4 2 4 */
-    1094,    /* OBJ_sha512_224                   2 16 840 1 101 3 4 2 5 */
-    1095,    /* OBJ_sha512_256                   2 16 840 1 101 3 4 2 6 */
-    1096,    /* OBJ_sha3_224                     2 16 840 1 101 3 4 2 7 */
-    1097,    /* OBJ_sha3_256                     2 16 840 1 101 3 4 2 8 */
-    1098,    /* OBJ_sha3_384                     2 16 840 1 101 3 4 2 9 */
-    1099,    /* OBJ_sha3_512                     2 16 840 1 101 3 4 2 10 */
-    1100,    /* OBJ_shake128                     2 16 840 1 101 3 4 2 11 */
+    1076,    /* OBJ_aria_256_cbc                 1 2 410 200046 1 1 12 */
+       0,
+      28,    /* OBJ_dhKeyAgreement               1 2 840 113549 1 3 1 */
+     635,    /* OBJ_setAttr_SecDevSig            2 23 42 3 3 5 2 */
+     468,    /* OBJ_documentIdentifier           0 9 2342 19200300 100 1 11 */
+       0,
+     421,    /* OBJ_aes_128_cfb128               2 16 840 1 101 3 4 1 4 */
     1101,    /* OBJ_shake256                     2 16 840 1 101 3 4 2 12 */
-    1102,    /* OBJ_hmac_sha3_224                2 16 840 1 101 3 4 2 13 */
-    1103,    /* OBJ_hmac_sha3_256                2 16 840 1 101 3 4 2 14 */
-    1104,    /* OBJ_hmac_sha3_384                2 16 840 1 101 3 4 2 15 */
-    1105,    /* OBJ_hmac_sha3_512                2 16 840 1 101 3 4 2 16 */
-     802,    /* OBJ_dsa_with_SHA224              2 16 840 1 101 3 4 3 1 */
-     803,    /* OBJ_dsa_with_SHA256              2 16 840 1 101 3 4 3 2 */
-    1106,    /* OBJ_dsa_with_SHA384              2 16 840 1 101 3 4 3 3 */
-    1107,    /* OBJ_dsa_with_SHA512              2 16 840 1 101 3 4 3 4 */
-    1108,    /* OBJ_dsa_with_SHA3_224            2 16 840 1 101 3 4 3 5 */
-    1109,    /* OBJ_dsa_with_SHA3_256            2 16 840 1 101 3 4 3 6 */
-    1110,    /* OBJ_dsa_with_SHA3_384            2 16 840 1 101 3 4 3 7 */
-    1111,    /* OBJ_dsa_with_SHA3_512            2 16 840 1 101 3 4 3 8 */
-    1112,    /* OBJ_ecdsa_with_SHA3_224          2 16 840 1 101 3 4 3 9 */
-    1113,    /* OBJ_ecdsa_with_SHA3_256          2 16 840 1 101 3 4 3 10 */
-    1114,    /* OBJ_ecdsa_with_SHA3_384          2 16 840 1 101 3 4 3 11 */
-    1115,    /* OBJ_ecdsa_with_SHA3_512          2 16 840 1 101 3 4 3 12 */
-    1116,    /* OBJ_RSA_SHA3_224                 2 16 840 1 101 3 4 3 13 */
-    1117,    /* OBJ_RSA_SHA3_256                 2 16 840 1 101 3 4 3 14 */
-    1118,    /* OBJ_RSA_SHA3_384                 2 16 840 1 101 3 4 3 15 */
-    1119,    /* OBJ_RSA_SHA3_512                 2 16 840 1 101 3 4 3 16 */
-      71,    /* OBJ_netscape_cert_type           2 16 840 1 113730 1 1 */
-      72,    /* OBJ_netscape_base_url            2 16 840 1 113730 1 2 */
-      73,    /* OBJ_netscape_revocation_url      2 16 840 1 113730 1 3 */
-      74,    /* OBJ_netscape_ca_revocation_url   2 16 840 1 113730 1 4 */
-      75,    /* OBJ_netscape_renewal_url         2 16 840 1 113730 1 7 */
-      76,    /* OBJ_netscape_ca_policy_url       2 16 840 1 113730 1 8 */
-      77,    /* OBJ_netscape_ssl_server_name     2 16 840 1 113730 1 12 */
-      78,    /* OBJ_netscape_comment             2 16 840 1 113730 1 13 */
-      79,    /* OBJ_netscape_cert_sequence       2 16 840 1 113730 2 5 */
+     822,    /* OBJ_id_GostR3411_94_CryptoProParamSet 1 2 643 2 2 30 1 */
+       0,
+     390,    /* OBJ_dcObject                     1 3 6 1 4 1 1466 344 */
+       0,
+       0,
+       0,
+       0,
+       0,
+       0,
+     317,    /* OBJ_id_regCtrl_pkiPublicationInfo 1 3 6 1 5 5 7 5 1 3 */
+       0,
+      25,    /* OBJ_pkcs7_digest                 1 2 840 113549 1 7 5 */
+     226,    /* OBJ_id_smime_aa_ets_sigPolicyId  1 2 840 113549 1 9 16 2 15 */
+     725,    /* OBJ_sect193r2                    1 3 132 0 25 */
+       0,
+       0,
+       0,
+       0,
+       0,
+       0,
+    1072,    /* OBJ_aria_192_cfb128              1 2 410 200046 1 1 8 */
+       0,
+       0,
+       0,
+     926,    /* OBJ_brainpoolP224t1              1 3 36 3 3 2 8 1 1 6 */
+       0,
+     455,    /* OBJ_pilotOrganization            0 9 2342 19200300 100 4 20 */
+      15,    /* OBJ_localityName                 2 5 4 7 */
+     546,    /* OBJ_setct_CapResData             2 23 42 0 28 */
+       0,
+       0,
+      52,    /* OBJ_pkcs9_signingTime            1 2 840 113549 1 9 5 */
+     758,    /* OBJ_camellia_192_cfb128          0 3 4401 5 3 1 9 24 */
+       0,
+     647,    /* OBJ_international_organizations  2 23 */
+     279,    /* OBJ_id_mod_qualified_cert_93     1 3 6 1 5 5 7 0 11 */
+     254,    /* OBJ_id_smime_cti_ets_proofOfSender 1 2 840 113549 1 9 16 6 4 */
+     231,    /* OBJ_id_smime_aa_ets_contentTimestamp 1 2 840 113549 1 9 16 2 20 */
      139,    /* OBJ_ns_sgc                       2 16 840 1 113730 4 1 */
-     458,    /* OBJ_userId                       0 9 2342 19200300 100 1 1 */
-     459,    /* OBJ_textEncodedORAddress         0 9 2342 19200300 100 1 2 */
+       0,
+       0,
+       0,
+     220,    /* OBJ_id_smime_aa_equivalentLabels 1 2 840 113549 1 9 16 2 9 */
+    1098,    /* OBJ_sha3_384                     2 16 840 1 101 3 4 2 9 */
+       0,
+    1194,    /* OBJ_hmacWithSHA512_256           1 2 840 113549 2 13 */
+       0,
+     519,    /* OBJ_setct_PANData                2 23 42 0 0 */
+       0,
+       0,
+     568,    /* OBJ_setct_PIDualSignedTBE        2 23 42 0 50 */
+     779,    /* OBJ_seed_cfb128                  1 2 410 200004 1 5 */
+       0,
+       0,
+     556,    /* OBJ_setct_PCertReqData           2 23 42 0 38 */
+       0,
+     909,    /* OBJ_id_camellia256_wrap          1 2 392 200011 61 1 1 3 4 */
+     705,    /* OBJ_secp112r2                    1 3 132 0 7 */
+       0,
+       0,
+     640,    /* OBJ_set_brand_Visa               2 23 42 8 4 */
+     608,    /* OBJ_setCext_hashedRoot           2 23 42 7 0 */
+     316,    /* OBJ_id_regCtrl_authenticator     1 3 6 1 5 5 7 5 1 2 */
+       0,
+       0,
+     133,    /* OBJ_time_stamp                   1 3 6 1 5 5 7 3 8 */
+     377,    /* OBJ_rsaSignature                 1 3 14 3 2 11 */
+       0,
+       0,
+     196,    /* OBJ_id_smime_mod_cms             1 2 840 113549 1 9 16 0 1 */
+     723,    /* OBJ_sect163r2                    1 3 132 0 15 */
+       0,
+       0,
+       0,
+     649,    /* OBJ_ms_upn                       1 3 6 1 4 1 311 20 2 3 */
+     513,    /* OBJ_set_ctype                    2 23 42 0 */
+       0,
+     171,    /* OBJ_ms_ext_req                   1 3 6 1 4 1 311 2 1 14 */
+     770,    /* OBJ_issuing_distribution_point   2 5 29 28 */
+       0,
+       0,
+       0,
      460,    /* OBJ_rfc822Mailbox                0 9 2342 19200300 100 1 3 */
-     461,    /* OBJ_info                         0 9 2342 19200300 100 1 4 */
-     462,    /* OBJ_favouriteDrink               0 9 2342 19200300 100 1 5 */
-     463,    /* OBJ_roomNumber                   0 9 2342 19200300 100 1 6 */
-     464,    /* OBJ_photo                        0 9 2342 19200300 100 1 7 */
-     465,    /* OBJ_userClass                    0 9 2342 19200300 100 1 8 */
-     466,    /* OBJ_host                         0 9 2342 19200300 100 1 9 */
-     467,    /* OBJ_manager                      0 9 2342 19200300 100 1 10 */
-     468,    /* OBJ_documentIdentifier           0 9 2342 19200300 100 1 11 */
-     469,    /* OBJ_documentTitle                0 9 2342 19200300 100 1 12 */
-     470,    /* OBJ_documentVersion              0 9 2342 19200300 100 1 13 */
-     471,    /* OBJ_documentAuthor               0 9 2342 19200300 100 1 14 */
-     472,    /* OBJ_documentLocation             0 9 2342 19200300 100 1 15 */
-     473,    /* OBJ_homeTelephoneNumber          0 9 2342 19200300 100 1 20 */
+       0,
+       0,
+     857,    /* OBJ_freshest_crl                 2 5 29 46 */
+     160,    /* OBJ_x509Crl                      1 2 840 113549 1 9 23 1 */
+       0,
+     891,    /* OBJ_deltaRevocationList          2 5 4 53 */
+       0,
+       0,
+       0,
+       0,
+     371,    /* OBJ_id_pkix_OCSP_serviceLocator  1 3 6 1 5 5 7 48 1 7 */
+     215,    /* OBJ_id_smime_aa_contentHint      1 2 840 113549 1 9 16 2 4 */
+     387,    /* OBJ_SNMPv2                       1 3 6 1 6 */
      474,    /* OBJ_secretary                    0 9 2342 19200300 100 1 21 */
-     475,    /* OBJ_otherMailbox                 0 9 2342 19200300 100 1 22 */
-     476,    /* OBJ_lastModifiedTime             0 9 2342 19200300 100 1 23 */
+     536,    /* OBJ_setct_AuthResTBSX            2 23 42 0 18 */
+     718,    /* OBJ_sect113r2                    1 3 132 0 5 */
+     168,    /* OBJ_pbeWithMD2AndRC2_CBC         1 2 840 113549 1 5 4 */
+     685,    /* OBJ_X9_62_c2pnb163v2             1 2 840 10045 3 0 2 */
+     235,    /* OBJ_id_smime_aa_ets_revocationValues 1 2 840 113549 1 9 16 2 24 */
+       0,
+     892,    /* OBJ_dmdName                      2 5 4 54 */
+     469,    /* OBJ_documentTitle                0 9 2342 19200300 100 1 12 */
+       0,
+       0,
+      26,    /* OBJ_pkcs7_encrypted              1 2 840 113549 1 7 6 */
+       0,
+     817,    /* OBJ_id_GostR3410_2001DH          1 2 643 2 2 98 */
+       0,
+     606,    /* OBJ_setext_cv                    2 23 42 1 8 */
+    1007,    /* OBJ_subjectSignTool              1 2 643 100 111 */
+     698,    /* OBJ_X9_62_c2onb239v5             1 2 840 10045 3 0 15 */
+       0,
+       0,
+     406,    /* OBJ_X9_62_prime_field            1 2 840 10045 1 1 */
+       0,
+       0,
+       0,
+       0,
+     841,    /* OBJ_id_GostR3410_2001_CryptoPro_B_ParamSet 1 2 643 2 2 35 2 */
+       0,
+    1125,    /* OBJ_aria_256_gcm                 1 2 410 200046 1 1 36 */
+       0,
+       0,
+       0,
+     147,    /* OBJ_pbe_WithSHA1And2_Key_TripleDES_CBC 1 2 840 113549 1 12 1 4 */
+     574,    /* OBJ_setct_CapTokenTBE            2 23 42 0 56 */
+     332,    /* OBJ_id_cmc_senderNonce           1 3 6 1 5 5 7 7 6 */
+     835,    /* OBJ_id_GostR3410_94_CryptoPro_D_ParamSet 1 2 643 2 2 32 5 */
+     873,    /* OBJ_presentationAddress          2 5 4 29 */
+    1060,    /* OBJ_id_ct_xml                    1 2 840 113549 1 9 16 1 28 */
+       0,
+       0,
+    1174,    /* OBJ_id_tc26_cipher_gostr3412_2015_magma_ctracpkm 1 2 643 7 1 1 5 1 1 */
+       0,
+    1114,    /* OBJ_ecdsa_with_SHA3_384          2 16 840 1 101 3 4 3 11 */
+     287,    /* OBJ_ac_auditEntity               1 3 6 1 5 5 7 1 4 */
+     868,    /* OBJ_x121Address                  2 5 4 24 */
+       0,
+       0,
+     879,    /* OBJ_userPassword                 2 5 4 35 */
+       0,
+       0,
+     401,    /* OBJ_policy_constraints           2 5 29 36 */
+     173,    /* OBJ_name                         2 5 4 41 */
+     157,    /* OBJ_localKeyID                   1 2 840 113549 1 9 21 */
+       0,
+       0,
+      42,    /* OBJ_shaWithRSAEncryption         1 3 14 3 2 15 */
+       0,
+     734,    /* OBJ_sect571r1                    1 3 132 0 39 */
+       0,
+      21,    /* OBJ_pkcs7_data                   1 2 840 113549 1 7 1 */
+       0,
+     549,    /* OBJ_setct_CapRevResData          2 23 42 0 31 */
+     626,    /* OBJ_setAttr_Token_EMV            2 23 42 3 2 1 */
+    1140,    /* OBJ_ISO_CN                       1 2 156 */
+       0,
+       0,
+     638,    /* OBJ_set_brand_AmericanExpress    2 23 42 8 34 */
+       0,
+     152,    /* OBJ_certBag                      1 2 840 113549 1 12 10 1 3 */
+      73,    /* OBJ_netscape_revocation_url      2 16 840 1 113730 1 3 */
+     449,    /* OBJ_documentSeries               0 9 2342 19200300 100 4 9 */
+       0,
+       0,
+     768,    /* OBJ_camellia_256_ofb128          0 3 4401 5 3 1 9 43 */
+       0,
+       0,
+       0,
+      34,    /* OBJ_idea_cbc                     1 3 6 1 4 1 188 7 1 1 2 */
+       0,
+     861,    /* OBJ_postalAddress                2 5 4 16 */
+       0,
+       0,
+     695,    /* OBJ_X9_62_c2tnb239v2             1 2 840 10045 3 0 12 */
+    1104,    /* OBJ_hmac_sha3_384                2 16 840 1 101 3 4 2 15 */
+       0,
+       0,
+    1071,    /* OBJ_aria_192_cbc                 1 2 410 200046 1 1 7 */
+    1175,    /* OBJ_id_tc26_cipher_gostr3412_2015_magma_ctracpkm_omac 1 2 643 7 1 1 5 1 2 */
+       0,
+       0,
+       0,
+       0,
+     256,    /* OBJ_id_smime_cti_ets_proofOfCreation 1 2 840 113549 1 9 16 6 6 */
+     462,    /* OBJ_favouriteDrink               0 9 2342 19200300 100 1 5 */
+     308,    /* OBJ_id_it_keyPairParamRep        1 3 6 1 5 5 7 4 11 */
+       0,
+       0,
+       0,
+      59,    /* OBJ_netscape_data_type           2 16 840 1 113730 2 */
+     145,    /* OBJ_pbe_WithSHA1And40BitRC4      1 2 840 113549 1 12 1 2 */
+     999,    /* OBJ_id_tc26_gost_3410_2012_512_paramSetB 1 2 643 7 1 2 1 2 2 */
+       0,
+     155,    /* OBJ_safeContentsBag              1 2 840 113549 1 12 10 1 6 */
+     354,    /* OBJ_id_aca_authenticationInfo    1 3 6 1 5 5 7 10 1 */
+       0,
+     752,    /* OBJ_camellia_192_cbc             1 2 392 200011 61 1 1 1 3 */
+       0,
+     737,    /* OBJ_wap_wsg_idm_ecid_wtls4       2 23 43 1 4 4 */
+     945,    /* OBJ_dhSinglePass_cofactorDH_sha512kdf_scheme 1 3 132 1 14 3 */
+     678,    /* OBJ_wap                          2 23 43 */
+       0,
+       0,
+       0,
+     907,    /* OBJ_id_camellia128_wrap          1 2 392 200011 61 1 1 3 2 */
+     996,    /* OBJ_id_tc26_gost_3410_2012_512_constants 1 2 643 7 1 2 1 2 */
+       0,
+     510,    /* OBJ_pseudonym                    2 5 4 65 */
+     553,    /* OBJ_setct_CredRevReqTBS          2 23 42 0 35 */
+     824,    /* OBJ_id_Gost28147_89_CryptoPro_A_ParamSet 1 2 643 2 2 31 1 */
+     249,    /* OBJ_id_smime_spq_ets_sqt_uri     1 2 840 113549 1 9 16 5 1 */
+       0,
+     716,    /* OBJ_secp521r1                    1 3 132 0 35 */
+     548,    /* OBJ_setct_CapRevReqTBSX          2 23 42 0 30 */
+       0,
+       0,
+       0,
+     218,    /* OBJ_id_smime_aa_contentIdentifier 1 2 840 113549 1 9 16 2 7 */
+       0,
+     929,    /* OBJ_brainpoolP320r1              1 3 36 3 3 2 8 1 1 9 */
+     989,    /* OBJ_id_tc26_hmac_gost_3411_2012_512 1 2 643 7 1 1 4 2 */
+       0,
+       0,
+       0,
+       0,
+     971,    /* OBJ_camellia_256_ctr             0 3 4401 5 3 1 9 49 */
+       0,
+     931,    /* OBJ_brainpoolP384r1              1 3 36 3 3 2 8 1 1 11 */
+     501,    /* OBJ_audio                        0 9 2342 19200300 100 1 55 */
+       0,
+       0,
+     112,    /* OBJ_pbeWithMD5AndCast5_CBC       1 2 840 113533 7 66 12 */
+    1263,    /* OBJ_blake2smac                   1 3 6 1 4 1 1722 12 2 2 */
      477,    /* OBJ_lastModifiedBy               0 9 2342 19200300 100 1 24 */
-     391,    /* OBJ_domainComponent              0 9 2342 19200300 100 1 25 */
+     991,    /* OBJ_id_tc26_agreement            1 2 643 7 1 1 6 */
+       4,    /* OBJ_md5                          1 2 840 113549 2 5 */
+    1004,    /* OBJ_INN                          1 2 643 3 131 1 1 */
+       0,
+      89,    /* OBJ_certificate_policies         2 5 29 32 */
+       0,
+     101,    /* OBJ_initials                     2 5 4 43 */
+       0,
+       0,
+     910,    /* OBJ_anyExtendedKeyUsage          2 5 29 37 0 */
+       0,
+       0,
+     618,    /* OBJ_setCext_TokenType            2 23 42 7 10 */
+       0,
+       0,
+       0,
+    1124,    /* OBJ_aria_192_gcm                 1 2 410 200046 1 1 35 */
+       0,
+     712,    /* OBJ_secp224k1                    1 3 132 0 32 */
+     418,    /* OBJ_aes_128_ecb                  2 16 840 1 101 3 4 1 1 */
+       0,
+    1090,    /* OBJ_countryCode3c                2 5 4 98 */
+     744,    /* OBJ_wap_wsg_idm_ecid_wtls11      2 23 43 1 4 11 */
+    1152,    /* OBJ_dstu28147                    1 2 804 2 1 1 1 1 1 1 */
+       0,
+    1093,    /* OBJ_x509ExtAdmission             1 3 36 8 3 3 */
+       0,
+    1248,    /* OBJ_p256_sphincsshake128fsimple  1 3 9999 6 7 14 */
+       0,
+       0,
+       0,
+       0,
+       0,
+      48,    /* OBJ_pkcs9_emailAddress           1 2 840 113549 1 9 1 */
+       0,
+       0,
+     375,    /* OBJ_id_pkix_OCSP_trustRoot       1 3 6 1 5 5 7 48 1 11 */
+       0,
+     551,    /* OBJ_setct_CredReqTBSX            2 23 42 0 33 */
+       0,
+     228,    /* OBJ_id_smime_aa_ets_signerLocation 1 2 840 113549 1 9 16 2 17 */
+       0,
+       0,
+       0,
+       0,
+     733,    /* OBJ_sect571k1                    1 3 132 0 38 */
+       0,
      478,    /* OBJ_aRecord                      0 9 2342 19200300 100 1 26 */
-     479,    /* OBJ_pilotAttributeType27         0 9 2342 19200300 100 1 27 */
-     480,    /* OBJ_mXRecord                     0 9 2342 19200300 100 1 28 */
-     481,    /* OBJ_nSRecord                     0 9 2342 19200300 100 1 29 */
-     482,    /* OBJ_sOARecord                    0 9 2342 19200300 100 1 30 */
-     483,    /* OBJ_cNAMERecord                  0 9 2342 19200300 100 1 31 */
-     484,    /* OBJ_associatedDomain             0 9 2342 19200300 100 1 37 */
-     485,    /* OBJ_associatedName               0 9 2342 19200300 100 1 38 */
-     486,    /* OBJ_homePostalAddress            0 9 2342 19200300 100 1 39 */
-     487,    /* OBJ_personalTitle                0 9 2342 19200300 100 1 40 */
-     488,    /* OBJ_mobileTelephoneNumber        0 9 2342 19200300 100 1 41 */
-     489,    /* OBJ_pagerTelephoneNumber         0 9 2342 19200300 100 1 42 */
+     878,    /* OBJ_seeAlso                      2 5 4 34 */
+       0,
+     600,    /* OBJ_setct_BCIDistributionTBS     2 23 42 0 82 */
+    1176,    /* OBJ_id_tc26_cipher_gostr3412_2015_kuznyechik 1 2 643 7 1 1 5 2 */
+       0,
+       0,
+     116,    /* OBJ_dsa                          1 2 840 10040 4 1 */
+     781,    /* OBJ_hmac_sha1                    1 3 6 1 5 5 8 1 2 */
+     206,    /* OBJ_id_smime_ct_publishCert      1 2 840 113549 1 9 16 1 3 */
+     805,    /* OBJ_cryptopro                    1 2 643 2 2 */
+     417,    /* OBJ_ms_csp_name                  1 3 6 1 4 1 311 17 1 */
+     889,    /* OBJ_houseIdentifier              2 5 4 51 */
+       0,
+       0,
+    1153,    /* OBJ_dstu28147_ofb                1 2 804 2 1 1 1 1 1 1 2 */
+     613,    /* OBJ_setCext_setExt               2 23 42 7 5 */
+     825,    /* OBJ_id_Gost28147_89_CryptoPro_B_ParamSet 1 2 643 2 2 31 2 */
+       0,
+       0,
+     492,    /* OBJ_janetMailbox                 0 9 2342 19200300 100 1 46 */
+       0,
+       0,
+    1240,    /* OBJ_p256_sphincssha2128fsimple   1 3 9999 6 4 14 */
+       0,
+     303,    /* OBJ_id_it_currentCRL             1 3 6 1 5 5 7 4 6 */
+     751,    /* OBJ_camellia_128_cbc             1 2 392 200011 61 1 1 1 2 */
+       0,
+       0,
+     186,    /* OBJ_pkcs1                        1 2 840 113549 1 1 */
+     820,    /* OBJ_id_Gost28147_89_None_KeyMeshing 1 2 643 2 2 14 0 */
+     119,    /* OBJ_ripemd160WithRSA             1 3 36 3 3 1 2 */
+       0,
+       0,
+     276,    /* OBJ_id_mod_kea_profile_93        1 3 6 1 5 5 7 0 8 */
+     839,    /* OBJ_id_GostR3410_2001_TestParamSet 1 2 643 2 2 35 0 */
+     503,    /* OBJ_x500UniqueIdentifier         2 5 4 45 */
+       0,
+     265,    /* OBJ_id_pda                       1 3 6 1 5 5 7 9 */
+    1100,    /* OBJ_shake128                     2 16 840 1 101 3 4 2 11 */
+       0,
+       0,
+     965,    /* OBJ_camellia_192_gcm             0 3 4401 5 3 1 9 26 */
+       0,
+     813,    /* OBJ_id_Gost28147_89              1 2 643 2 2 21 */
+    1113,    /* OBJ_ecdsa_with_SHA3_256          2 16 840 1 101 3 4 3 10 */
+     344,    /* OBJ_id_cmc_popLinkRandom         1 3 6 1 5 5 7 7 22 */
+       0,
+       0,
+       0,
+    1136,    /* OBJ_sm4_cfb1                     1 2 156 10197 1 104 5 */
+       0,
+     585,    /* OBJ_setct_CapRevResTBE           2 23 42 0 67 */
+     378,    /* OBJ_X500algorithms               2 5 8 */
+     964,    /* OBJ_camellia_128_cmac            0 3 4401 5 3 1 9 10 */
+       0,
+     525,    /* OBJ_setct_PIDataUnsigned         2 23 42 0 6 */
+       0,
+     164,    /* OBJ_id_qt_cps                    1 3 6 1 5 5 7 2 1 */
+     619,    /* OBJ_setCext_IssuerCapabilities   2 23 42 7 11 */
+     559,    /* OBJ_setct_BatchAdminResData      2 23 42 0 41 */
+     422,    /* OBJ_aes_192_ecb                  2 16 840 1 101 3 4 1 21 */
+       0,
+     294,    /* OBJ_ipsecEndSystem               1 3 6 1 5 5 7 3 5 */
+    1162,    /* OBJ_uacurve2                     1 2 804 2 1 1 1 1 3 1 1 2 2 */
+       5,    /* OBJ_rc4                          1 2 840 113549 3 4 */
+       0,
+     942,    /* OBJ_dhSinglePass_cofactorDH_sha224kdf_scheme 1 3 132 1 14 0 */
+       0,
+       0,
+     561,    /* OBJ_setct_MeAqCInitResTBS        2 23 42 0 43 */
+     323,    /* OBJ_id_alg_des40                 1 3 6 1 5 5 7 6 1 */
+       0,
+       0,
+    1132,    /* OBJ_cmcRA                        1 3 6 1 5 5 7 3 28 */
+       0,
+       0,
+    1069,    /* OBJ_aria_128_ctr                 1 2 410 200046 1 1 5 */
+       0,
+     127,    /* OBJ_id_pkix                      1 3 6 1 5 5 7 */
+       0,
+     239,    /* OBJ_id_smime_aa_signatureType    1 2 840 113549 1 9 16 2 28 */
+     262,    /* OBJ_id_alg                       1 3 6 1 5 5 7 6 */
+    1186,    /* OBJ_id_tc26_gost_3410_2012_256_paramSetD 1 2 643 7 1 2 1 1 4 */
+     800,    /* OBJ_hmacWithSHA384               1 2 840 113549 2 10 */
+       0,
+       0,
+     730,    /* OBJ_sect283r1                    1 3 132 0 17 */
+       0,
+       0,
      490,    /* OBJ_friendlyCountryName          0 9 2342 19200300 100 1 43 */
-     102,    /* OBJ_uniqueIdentifier             0 9 2342 19200300 100 1 44 */
-     491,    /* OBJ_organizationalStatus         0 9 2342 19200300 100 1 45 */
-     492,    /* OBJ_janetMailbox                 0 9 2342 19200300 100 1 46 */
-     493,    /* OBJ_mailPreferenceOption         0 9 2342 19200300 100 1 47 */
-     494,    /* OBJ_buildingName                 0 9 2342 19200300 100 1 48 */
-     495,    /* OBJ_dSAQuality                   0 9 2342 19200300 100 1 49 */
-     496,    /* OBJ_singleLevelQuality           0 9 2342 19200300 100 1 50 */
-     497,    /* OBJ_subtreeMinimumQuality        0 9 2342 19200300 100 1 51 */
-     498,    /* OBJ_subtreeMaximumQuality        0 9 2342 19200300 100 1 52 */
-     499,    /* OBJ_personalSignature            0 9 2342 19200300 100 1 53 */
-     500,    /* OBJ_dITRedirect                  0 9 2342 19200300 100 1 54 */
-     501,    /* OBJ_audio                        0 9 2342 19200300 100 1 55 */
-     502,    /* OBJ_documentPublisher            0 9 2342 19200300 100 1 56 */
-     442,    /* OBJ_iA5StringSyntax              0 9 2342 19200300 100 3 4 */
-     443,    /* OBJ_caseIgnoreIA5StringSyntax    0 9 2342 19200300 100 3 5 */
-     444,    /* OBJ_pilotObject                  0 9 2342 19200300 100 4 3 */
-     445,    /* OBJ_pilotPerson                  0 9 2342 19200300 100 4 4 */
-     446,    /* OBJ_account                      0 9 2342 19200300 100 4 5 */
-     447,    /* OBJ_document                     0 9 2342 19200300 100 4 6 */
-     448,    /* OBJ_room                         0 9 2342 19200300 100 4 7 */
-     449,    /* OBJ_documentSeries               0 9 2342 19200300 100 4 9 */
-     392,    /* OBJ_Domain                       0 9 2342 19200300 100 4 13 */
-     450,    /* OBJ_rFC822localPart              0 9 2342 19200300 100 4 14 */
-     451,    /* OBJ_dNSDomain                    0 9 2342 19200300 100 4 15 */
-     452,    /* OBJ_domainRelatedObject          0 9 2342 19200300 100 4 17 */
-     453,    /* OBJ_friendlyCountry              0 9 2342 19200300 100 4 18 */
-     454,    /* OBJ_simpleSecurityObject         0 9 2342 19200300 100 4 19 */
-     455,    /* OBJ_pilotOrganization            0 9 2342 19200300 100 4 20 */
-     456,    /* OBJ_pilotDSA                     0 9 2342 19200300 100 4 21 */
-     457,    /* OBJ_qualityLabelledData          0 9 2342 19200300 100 4 22 */
-    1152,    /* OBJ_dstu28147                    1 2 804 2 1 1 1 1 1 1 */
-    1156,    /* OBJ_hmacWithDstu34311            1 2 804 2 1 1 1 1 1 2 */
-    1157,    /* OBJ_dstu34311                    1 2 804 2 1 1 1 1 2 1 */
-     189,    /* OBJ_id_smime_mod                 1 2 840 113549 1 9 16 0 */
-     190,    /* OBJ_id_smime_ct                  1 2 840 113549 1 9 16 1 */
-     191,    /* OBJ_id_smime_aa                  1 2 840 113549 1 9 16 2 */
-     192,    /* OBJ_id_smime_alg                 1 2 840 113549 1 9 16 3 */
-     193,    /* OBJ_id_smime_cd                  1 2 840 113549 1 9 16 4 */
-     194,    /* OBJ_id_smime_spq                 1 2 840 113549 1 9 16 5 */
+     666,    /* OBJ_name_constraints             2 5 29 30 */
+       0,
+     328,    /* OBJ_id_cmc_identification        1 3 6 1 5 5 7 7 2 */
+     482,    /* OBJ_sOARecord                    0 9 2342 19200300 100 1 30 */
+     464,    /* OBJ_photo                        0 9 2342 19200300 100 1 7 */
+     289,    /* OBJ_aaControls                   1 3 6 1 5 5 7 1 6 */
+     517,    /* OBJ_set_certExt                  2 23 42 7 */
+       0,
+     286,    /* OBJ_qcStatements                 1 3 6 1 5 5 7 1 3 */
+     141,    /* OBJ_crl_reason                   2 5 29 21 */
+      19,    /* OBJ_rsa                          2 5 8 1 1 */
+       0,
+       0,
+       0,
+    1088,    /* OBJ_ED448                        1 3 101 113 */
+       0,
+    1137,    /* OBJ_sm4_cfb128                   1 2 156 10197 1 104 4 */
+       0,
+       0,
+       0,
+       0,
+     745,    /* OBJ_wap_wsg_idm_ecid_wtls12      2 23 43 1 4 12 */
+     962,    /* OBJ_camellia_128_ccm             0 3 4401 5 3 1 9 7 */
+       0,
+       0,
+     969,    /* OBJ_camellia_256_gcm             0 3 4401 5 3 1 9 46 */
+      53,    /* OBJ_pkcs9_countersignature       1 2 840 113549 1 9 6 */
+       0,
+       0,
+     285,    /* OBJ_biometricInfo                1 3 6 1 5 5 7 1 2 */
+     281,    /* OBJ_id_mod_timestamp_protocol    1 3 6 1 5 5 7 0 13 */
      195,    /* OBJ_id_smime_cti                 1 2 840 113549 1 9 16 6 */
-     158,    /* OBJ_x509Certificate              1 2 840 113549 1 9 22 1 */
-     159,    /* OBJ_sdsiCertificate              1 2 840 113549 1 9 22 2 */
-     160,    /* OBJ_x509Crl                      1 2 840 113549 1 9 23 1 */
-     144,    /* OBJ_pbe_WithSHA1And128BitRC4     1 2 840 113549 1 12 1 1 */
-     145,    /* OBJ_pbe_WithSHA1And40BitRC4      1 2 840 113549 1 12 1 2 */
-     146,    /* OBJ_pbe_WithSHA1And3_Key_TripleDES_CBC 1 2 840 113549 1 12 1 3 */
-     147,    /* OBJ_pbe_WithSHA1And2_Key_TripleDES_CBC 1 2 840 113549 1 12 1 4 */
-     148,    /* OBJ_pbe_WithSHA1And128BitRC2_CBC 1 2 840 113549 1 12 1 5 */
-     149,    /* OBJ_pbe_WithSHA1And40BitRC2_CBC  1 2 840 113549 1 12 1 6 */
-     171,    /* OBJ_ms_ext_req                   1 3 6 1 4 1 311 2 1 14 */
-     134,    /* OBJ_ms_code_ind                  1 3 6 1 4 1 311 2 1 21 */
-     135,    /* OBJ_ms_code_com                  1 3 6 1 4 1 311 2 1 22 */
-     136,    /* OBJ_ms_ctl_sign                  1 3 6 1 4 1 311 10 3 1 */
-     137,    /* OBJ_ms_sgc                       1 3 6 1 4 1 311 10 3 3 */
-     138,    /* OBJ_ms_efs                       1 3 6 1 4 1 311 10 3 4 */
-     648,    /* OBJ_ms_smartcard_login           1 3 6 1 4 1 311 20 2 2 */
-     649,    /* OBJ_ms_upn                       1 3 6 1 4 1 311 20 2 3 */
-     951,    /* OBJ_ct_precert_scts              1 3 6 1 4 1 11129 2 4 2 */
-     952,    /* OBJ_ct_precert_poison            1 3 6 1 4 1 11129 2 4 3 */
-     953,    /* OBJ_ct_precert_signer            1 3 6 1 4 1 11129 2 4 4 */
-     954,    /* OBJ_ct_cert_scts                 1 3 6 1 4 1 11129 2 4 5 */
-     751,    /* OBJ_camellia_128_cbc             1 2 392 200011 61 1 1 1 2 */
-     752,    /* OBJ_camellia_192_cbc             1 2 392 200011 61 1 1 1 3 */
-     753,    /* OBJ_camellia_256_cbc             1 2 392 200011 61 1 1 1 4 */
-     907,    /* OBJ_id_camellia128_wrap          1 2 392 200011 61 1 1 3 2 */
-     908,    /* OBJ_id_camellia192_wrap          1 2 392 200011 61 1 1 3 3 */
-     909,    /* OBJ_id_camellia256_wrap          1 2 392 200011 61 1 1 3 4 */
-    1153,    /* OBJ_dstu28147_ofb                1 2 804 2 1 1 1 1 1 1 2 */
+     967,    /* OBJ_camellia_192_ctr             0 3 4401 5 3 1 9 29 */
+       0,
+       0,
+     595,    /* OBJ_setct_CertReqTBE             2 23 42 0 77 */
+       0,
+       0,
+     871,    /* OBJ_destinationIndicator         2 5 4 27 */
     1154,    /* OBJ_dstu28147_cfb                1 2 804 2 1 1 1 1 1 1 3 */
-    1155,    /* OBJ_dstu28147_wrap               1 2 804 2 1 1 1 1 1 1 5 */
-    1158,    /* OBJ_dstu4145le                   1 2 804 2 1 1 1 1 3 1 1 */
-     196,    /* OBJ_id_smime_mod_cms             1 2 840 113549 1 9 16 0 1 */
-     197,    /* OBJ_id_smime_mod_ess             1 2 840 113549 1 9 16 0 2 */
-     198,    /* OBJ_id_smime_mod_oid             1 2 840 113549 1 9 16 0 3 */
-     199,    /* OBJ_id_smime_mod_msg_v3          1 2 840 113549 1 9 16 0 4 */
-     200,    /* OBJ_id_smime_mod_ets_eSignature_88 1 2 840 113549 1 9 16 0 5 */
-     201,    /* OBJ_id_smime_mod_ets_eSignature_97 1 2 840 113549 1 9 16 0 6 */
-     202,    /* OBJ_id_smime_mod_ets_eSigPolicy_88 1 2 840 113549 1 9 16 0 7 */
-     203,    /* OBJ_id_smime_mod_ets_eSigPolicy_97 1 2 840 113549 1 9 16 0 8 */
-     204,    /* OBJ_id_smime_ct_receipt          1 2 840 113549 1 9 16 1 1 */
-     205,    /* OBJ_id_smime_ct_authData         1 2 840 113549 1 9 16 1 2 */
-     206,    /* OBJ_id_smime_ct_publishCert      1 2 840 113549 1 9 16 1 3 */
-     207,    /* OBJ_id_smime_ct_TSTInfo          1 2 840 113549 1 9 16 1 4 */
-     208,    /* OBJ_id_smime_ct_TDTInfo          1 2 840 113549 1 9 16 1 5 */
-     209,    /* OBJ_id_smime_ct_contentInfo      1 2 840 113549 1 9 16 1 6 */
-     210,    /* OBJ_id_smime_ct_DVCSRequestData  1 2 840 113549 1 9 16 1 7 */
-     211,    /* OBJ_id_smime_ct_DVCSResponseData 1 2 840 113549 1 9 16 1 8 */
-     786,    /* OBJ_id_smime_ct_compressedData   1 2 840 113549 1 9 16 1 9 */
+       0,
+       0,
+     458,    /* OBJ_userId                       0 9 2342 19200300 100 1 1 */
+       0,
+       0,
+       0,
+     505,    /* OBJ_mime_mhs_headings            1 3 6 1 7 1 1 */
+       0,
+     333,    /* OBJ_id_cmc_recipientNonce        1 3 6 1 5 5 7 7 7 */
+       0,
+     512,    /* OBJ_id_set                       2 23 42 */
+     702,    /* OBJ_X9_62_c2pnb368w1             1 2 840 10045 3 0 19 */
+     671,    /* OBJ_sha224WithRSAEncryption      1 2 840 113549 1 1 14 */
+       0,
+     661,    /* OBJ_postalCode                   2 5 4 17 */
+     402,    /* OBJ_target_information           2 5 29 55 */
+       0,
+     538,    /* OBJ_setct_CapTokenData           2 23 42 0 20 */
+       0,
+     683,    /* OBJ_X9_62_ppBasis                1 2 840 10045 1 2 3 3 */
+     738,    /* OBJ_wap_wsg_idm_ecid_wtls5       2 23 43 1 4 5 */
+     675,    /* OBJ_sha224                       2 16 840 1 101 3 4 2 4 */
+       0,
+     411,    /* OBJ_X9_62_prime192v3             1 2 840 10045 3 1 3 */
+     780,    /* OBJ_hmac_md5                     1 3 6 1 5 5 8 1 1 */
+     936,    /* OBJ_dhSinglePass_stdDH_sha1kdf_scheme 1 3 133 16 840 63 0 2 */
+       0,
+       0,
+       0,
+    1164,    /* OBJ_uacurve4                     1 2 804 2 1 1 1 1 3 1 1 2 4 */
+       0,
+       0,
+       0,
+       0,
+    1031,    /* OBJ_id_pkinit                    1 3 6 1 5 2 3 */
+     667,    /* OBJ_Independent                  1 3 6 1 5 5 7 21 2 */
+       0,
+       0,
+       0,
+     330,    /* OBJ_id_cmc_dataReturn            1 3 6 1 5 5 7 7 4 */
+       0,
+       0,
+       0,
+       0,
+       0,
+    1183,    /* OBJ_id_tc26_wrap_gostr3412_2015_kuznyechik_kexp15 1 2 643 7 1 1 7 2 1 */
+     382,    /* OBJ_Directory                    1 3 6 1 1 */
+    1163,    /* OBJ_uacurve3                     1 2 804 2 1 1 1 1 3 1 1 2 3 */
+       0,
+       0,
+      79,    /* OBJ_netscape_cert_sequence       2 16 840 1 113730 2 5 */
+    1075,    /* OBJ_aria_256_ecb                 1 2 410 200046 1 1 11 */
+       0,
+       0,
+       0,
+       0,
+       0,
+       0,
+       0,
+     974,    /* OBJ_id_tc26                      1 2 643 7 1 */
+     396,    /* OBJ_md4WithRSAEncryption         1 2 840 113549 1 1 3 */
+     573,    /* OBJ_setct_AuthTokenTBE           2 23 42 0 55 */
+     849,    /* OBJ_id_Gost28147_89_cc           1 2 643 2 9 1 6 1 */
+       0,
+     299,    /* OBJ_id_it_signKeyPairTypes       1 3 6 1 5 5 7 4 2 */
     1058,    /* OBJ_id_smime_ct_contentCollection 1 2 840 113549 1 9 16 1 19 */
-    1059,    /* OBJ_id_smime_ct_authEnvelopedData 1 2 840 113549 1 9 16 1 23 */
-     787,    /* OBJ_id_ct_asciiTextWithCRLF      1 2 840 113549 1 9 16 1 27 */
-    1060,    /* OBJ_id_ct_xml                    1 2 840 113549 1 9 16 1 28 */
-     212,    /* OBJ_id_smime_aa_receiptRequest   1 2 840 113549 1 9 16 2 1 */
-     213,    /* OBJ_id_smime_aa_securityLabel    1 2 840 113549 1 9 16 2 2 */
-     214,    /* OBJ_id_smime_aa_mlExpandHistory  1 2 840 113549 1 9 16 2 3 */
-     215,    /* OBJ_id_smime_aa_contentHint      1 2 840 113549 1 9 16 2 4 */
-     216,    /* OBJ_id_smime_aa_msgSigDigest     1 2 840 113549 1 9 16 2 5 */
-     217,    /* OBJ_id_smime_aa_encapContentType 1 2 840 113549 1 9 16 2 6 */
-     218,    /* OBJ_id_smime_aa_contentIdentifier 1 2 840 113549 1 9 16 2 7 */
-     219,    /* OBJ_id_smime_aa_macValue         1 2 840 113549 1 9 16 2 8 */
-     220,    /* OBJ_id_smime_aa_equivalentLabels 1 2 840 113549 1 9 16 2 9 */
-     221,    /* OBJ_id_smime_aa_contentReference 1 2 840 113549 1 9 16 2 10 */
-     222,    /* OBJ_id_smime_aa_encrypKeyPref    1 2 840 113549 1 9 16 2 11 */
-     223,    /* OBJ_id_smime_aa_signingCertificate 1 2 840 113549 1 9 16 2 12 */
-     224,    /* OBJ_id_smime_aa_smimeEncryptCerts 1 2 840 113549 1 9 16 2 13 */
-     225,    /* OBJ_id_smime_aa_timeStampToken   1 2 840 113549 1 9 16 2 14 */
-     226,    /* OBJ_id_smime_aa_ets_sigPolicyId  1 2 840 113549 1 9 16 2 15 */
-     227,    /* OBJ_id_smime_aa_ets_commitmentType 1 2 840 113549 1 9 16 2 16 */
-     228,    /* OBJ_id_smime_aa_ets_signerLocation 1 2 840 113549 1 9 16 2 17 */
-     229,    /* OBJ_id_smime_aa_ets_signerAttr   1 2 840 113549 1 9 16 2 18 */
-     230,    /* OBJ_id_smime_aa_ets_otherSigCert 1 2 840 113549 1 9 16 2 19 */
-     231,    /* OBJ_id_smime_aa_ets_contentTimestamp 1 2 840 113549 1 9 16 2 20 */
-     232,    /* OBJ_id_smime_aa_ets_CertificateRefs 1 2 840 113549 1 9 16 2 21 */
-     233,    /* OBJ_id_smime_aa_ets_RevocationRefs 1 2 840 113549 1 9 16 2 22 */
-     234,    /* OBJ_id_smime_aa_ets_certValues   1 2 840 113549 1 9 16 2 23 */
-     235,    /* OBJ_id_smime_aa_ets_revocationValues 1 2 840 113549 1 9 16 2 24 */
-     236,    /* OBJ_id_smime_aa_ets_escTimeStamp 1 2 840 113549 1 9 16 2 25 */
-     237,    /* OBJ_id_smime_aa_ets_certCRLTimestamp 1 2 840 113549 1 9 16 2 26 */
-     238,    /* OBJ_id_smime_aa_ets_archiveTimeStamp 1 2 840 113549 1 9 16 2 27 */
-     239,    /* OBJ_id_smime_aa_signatureType    1 2 840 113549 1 9 16 2 28 */
-     240,    /* OBJ_id_smime_aa_dvcs_dvc         1 2 840 113549 1 9 16 2 29 */
+       0,
     1086,    /* OBJ_id_smime_aa_signingCertificateV2 1 2 840 113549 1 9 16 2 47 */
-     241,    /* OBJ_id_smime_alg_ESDHwith3DES    1 2 840 113549 1 9 16 3 1 */
-     242,    /* OBJ_id_smime_alg_ESDHwithRC2     1 2 840 113549 1 9 16 3 2 */
-     243,    /* OBJ_id_smime_alg_3DESwrap        1 2 840 113549 1 9 16 3 3 */
-     244,    /* OBJ_id_smime_alg_RC2wrap         1 2 840 113549 1 9 16 3 4 */
-     245,    /* OBJ_id_smime_alg_ESDH            1 2 840 113549 1 9 16 3 5 */
-     246,    /* OBJ_id_smime_alg_CMS3DESwrap     1 2 840 113549 1 9 16 3 6 */
-     247,    /* OBJ_id_smime_alg_CMSRC2wrap      1 2 840 113549 1 9 16 3 7 */
-     125,    /* OBJ_zlib_compression             1 2 840 113549 1 9 16 3 8 */
-     893,    /* OBJ_id_alg_PWRI_KEK              1 2 840 113549 1 9 16 3 9 */
-     248,    /* OBJ_id_smime_cd_ldap             1 2 840 113549 1 9 16 4 1 */
-     249,    /* OBJ_id_smime_spq_ets_sqt_uri     1 2 840 113549 1 9 16 5 1 */
+       0,
+       0,
+       0,
+     453,    /* OBJ_friendlyCountry              0 9 2342 19200300 100 4 18 */
+       0,
+       0,
+       0,
+       0,
+     158,    /* OBJ_x509Certificate              1 2 840 113549 1 9 22 1 */
+     987,    /* OBJ_id_tc26_mac                  1 2 643 7 1 1 4 */
+     499,    /* OBJ_personalSignature            0 9 2342 19200300 100 1 53 */
+       9,    /* OBJ_pbeWithMD2AndDES_CBC         1 2 840 113549 1 5 1 */
+     874,    /* OBJ_supportedApplicationContext  2 5 4 30 */
+       0,
+     193,    /* OBJ_id_smime_cd                  1 2 840 113549 1 9 16 4 */
+       0,
+       0,
+       0,
+     138,    /* OBJ_ms_efs                       1 3 6 1 4 1 311 10 3 4 */
+     808,    /* OBJ_id_GostR3411_94_with_GostR3410_94 1 2 643 2 2 4 */
      250,    /* OBJ_id_smime_spq_ets_sqt_unotice 1 2 840 113549 1 9 16 5 2 */
-     251,    /* OBJ_id_smime_cti_ets_proofOfOrigin 1 2 840 113549 1 9 16 6 1 */
-     252,    /* OBJ_id_smime_cti_ets_proofOfReceipt 1 2 840 113549 1 9 16 6 2 */
-     253,    /* OBJ_id_smime_cti_ets_proofOfDelivery 1 2 840 113549 1 9 16 6 3 */
-     254,    /* OBJ_id_smime_cti_ets_proofOfSender 1 2 840 113549 1 9 16 6 4 */
-     255,    /* OBJ_id_smime_cti_ets_proofOfApproval 1 2 840 113549 1 9 16 6 5 */
-     256,    /* OBJ_id_smime_cti_ets_proofOfCreation 1 2 840 113549 1 9 16 6 6 */
-     150,    /* OBJ_keyBag                       1 2 840 113549 1 12 10 1 1 */
-     151,    /* OBJ_pkcs8ShroudedKeyBag          1 2 840 113549 1 12 10 1 2 */
-     152,    /* OBJ_certBag                      1 2 840 113549 1 12 10 1 3 */
-     153,    /* OBJ_crlBag                       1 2 840 113549 1 12 10 1 4 */
-     154,    /* OBJ_secretBag                    1 2 840 113549 1 12 10 1 5 */
-     155,    /* OBJ_safeContentsBag              1 2 840 113549 1 12 10 1 6 */
-    1227,    /* OBJ_dilithium2                   1 3 6 1 4 1 2 267 7 4 4 */
-    1230,    /* OBJ_dilithium3                   1 3 6 1 4 1 2 267 7 6 5 */
-    1232,    /* OBJ_dilithium5                   1 3 6 1 4 1 2 267 7 8 7 */
-      34,    /* OBJ_idea_cbc                     1 3 6 1 4 1 188 7 1 1 2 */
-     955,    /* OBJ_jurisdictionLocalityName     1 3 6 1 4 1 311 60 2 1 1 */
-     956,    /* OBJ_jurisdictionStateOrProvinceName 1 3 6 1 4 1 311 60 2 1 2 */
-     957,    /* OBJ_jurisdictionCountryName      1 3 6 1 4 1 311 60 2 1 3 */
+     223,    /* OBJ_id_smime_aa_signingCertificate 1 2 840 113549 1 9 16 2 12 */
+       0,
+     363,    /* OBJ_ad_timeStamping              1 3 6 1 5 5 7 48 3 */
+     954,    /* OBJ_ct_cert_scts                 1 3 6 1 4 1 11129 2 4 5 */
+     586,    /* OBJ_setct_CredReqTBE             2 23 42 0 68 */
+       0,
+       0,
+      10,    /* OBJ_pbeWithMD5AndDES_CBC         1 2 840 113549 1 5 3 */
+       0,
+     310,    /* OBJ_id_it_implicitConfirm        1 3 6 1 5 5 7 4 13 */
+      50,    /* OBJ_pkcs9_contentType            1 2 840 113549 1 9 3 */
+     240,    /* OBJ_id_smime_aa_dvcs_dvc         1 2 840 113549 1 9 16 2 29 */
+     828,    /* OBJ_id_Gost28147_89_CryptoPro_Oscar_1_1_ParamSet 1 2 643 2 2 31 5 */
+     753,    /* OBJ_camellia_256_cbc             1 2 392 200011 61 1 1 1 4 */
+    1095,    /* OBJ_sha512_256                   2 16 840 1 101 3 4 2 6 */
+     860,    /* OBJ_businessCategory             2 5 4 15 */
+       0,
+       0,
+       0,
+       0,
+       0,
+       0,
+     782,    /* OBJ_id_PasswordBasedMAC          1 2 840 113533 7 66 13 */
+       0,
+     172,    /* OBJ_ext_req                      1 2 840 113549 1 9 14 */
     1056,    /* OBJ_blake2b512                   1 3 6 1 4 1 1722 12 2 1 16 */
-    1057,    /* OBJ_blake2s256                   1 3 6 1 4 1 1722 12 2 2 8 */
-    1159,    /* OBJ_dstu4145be                   1 2 804 2 1 1 1 1 3 1 1 1 1 */
-    1160,    /* OBJ_uacurve0                     1 2 804 2 1 1 1 1 3 1 1 2 0 */
-    1161,    /* OBJ_uacurve1                     1 2 804 2 1 1 1 1 3 1 1 2 1 */
-    1162,    /* OBJ_uacurve2                     1 2 804 2 1 1 1 1 3 1 1 2 2 */
-    1163,    /* OBJ_uacurve3                     1 2 804 2 1 1 1 1 3 1 1 2 3 */
-    1164,    /* OBJ_uacurve4                     1 2 804 2 1 1 1 1 3 1 1 2 4 */
-    1165,    /* OBJ_uacurve5                     1 2 804 2 1 1 1 1 3 1 1 2 5 */
-    1166,    /* OBJ_uacurve6                     1 2 804 2 1 1 1 1 3 1 1 2 6 */
-    1167,    /* OBJ_uacurve7                     1 2 804 2 1 1 1 1 3 1 1 2 7 */
-    1168,    /* OBJ_uacurve8                     1 2 804 2 1 1 1 1 3 1 1 2 8 */
-    1169,    /* OBJ_uacurve9                     1 2 804 2 1 1 1 1 3 1 1 2 9 */
+       0,
+     579,    /* OBJ_setct_AuthRevResTBEB         2 23 42 0 61 */
+     890,    /* OBJ_supportedAlgorithms          2 5 4 52 */
+     732,    /* OBJ_sect409r1                    1 3 132 0 37 */
+       0,
+     334,    /* OBJ_id_cmc_addExtensions         1 3 6 1 5 5 7 7 8 */
 };
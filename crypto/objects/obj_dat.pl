@@ -1,5 +1,5 @@
 #! /usr/bin/env perl
-# Copyright 1995-2022 The OpenSSL Project Authors. All Rights Reserved.
+# Copyright 1995-2023 The OpenSSL Project Authors. All Rights Reserved.
 #
 # Licensed under the OpenSSL license (the "License").  You may not use
 # this file except in compliance with the License.  You can obtain a copy
@@ -204,22 +204,90 @@ print  "};\n\n";
     @a = grep(defined $obj{$nid{$_}}, 0 .. $n);
 }
 printf "#define NUM_OBJ %d\n", $#a + 1;
-printf "static const unsigned int obj_objs[NUM_OBJ] = {\n";
 
-# Compare DER; prefer shorter; if some length, use the "smaller" encoding.
-sub obj_cmp
+# The hash of obj_dat_hash() in obj_dat.c, in 32-bit arithmetic
+sub mul32
 {
-    no warnings "uninitialized";
-    my $A = $obj_len{$obj{$nid{$a}}};
-    my $B = $obj_len{$obj{$nid{$b}}};
-    my $r = $A - $B;
-    return $r if $r != 0;
-
-    $A = $obj_der{$obj{$nid{$a}}};
-    $B = $obj_der{$obj{$nid{$b}}};
-    return $A cmp $B;
+    my ($x, $y) = @_;
+    return ($x * ($y & 0xffff) + ((($x * ($y >> 16)) & 0xffff) << 16))
+           & 0xffffffff;
+}
+
+sub obj_hash
+{
+    my ($seed, @der) = @_;
+    my $h = 0x811c9dc5 ^ mul32($seed, 0x9e3779b9);
+
+    foreach (@der) {
+        $h = mul32($h ^ $_, 0x01000193);
+    }
+    $h ^= $h >> 16;
+    $h = mul32($h, 0x85ebca6b);
+    $h ^= $h >> 13;
+    $h = mul32($h, 0xc2b2ae35);
+    $h ^= $h >> 16;
+    return $h;
+}
+
+# Perfect hash of the DER encodings to the NIDs, by hash and displace: the
+# objects are spread over buckets by their hash with seed 0, then for each
+# bucket, the largest first, a seed is searched for that sends all of its
+# objects to free slots.  The same OID under several names resolves to the
+# lowest NID.
+my $slots = 1;
+$slots <<= 1 while $slots < 3 * ($#a + 1) / 2;
+my $buckets = $slots / 8;
+my @bucket = map { [] } 1 .. $buckets;
+my %der_seen;
+foreach (sort { $a <=> $b } @a) {
+    next unless defined $obj_der{$obj{$nid{$_}}};
+    my @der = map { hex } split(/,/, $obj_der{$obj{$nid{$_}}});
+    my $key = join(",", @der);
+    next if defined $der_seen{$key};
+    $der_seen{$key} = 1;
+    push(@{$bucket[obj_hash(0, @der) & ($buckets - 1)]}, [$_, @der]);
 }
-foreach (sort obj_cmp @a) {
+my @seed = (0) x $buckets;
+my @slot = (0) x $slots;
+foreach my $b (sort { scalar(@{$bucket[$b]}) <=> scalar(@{$bucket[$a]})
+                      || $a <=> $b } 0 .. $buckets - 1) {
+    next unless @{$bucket[$b]};
+    SEED: for (my $s = 1; ; $s++) {
+        die "No perfect hash found" if $s > 0xffff;
+        my %taken;
+        foreach (@{$bucket[$b]}) {
+            my ($n, @der) = @$_;
+            my $i = obj_hash($s, @der) & ($slots - 1);
+            next SEED if $slot[$i] != 0 || defined $taken{$i};
+            $taken{$i} = $n;
+        }
+        $slot[$_] = $taken{$_} foreach keys %taken;
+        $seed[$b] = $s;
+        last;
+    }
+}
+
+print  "\n";
+print  "/*\n";
+print  " * Perfect hash of the DER encodings of the objects: the hash with seed 0\n";
+print  " * picks the seed in obj_hash_seeds, and the hash with that seed the slot\n";
+print  " * of obj_hash_nids holding the NID, or NID_undef.\n";
+print  " */\n";
+printf "#define OBJ_HASH_BUCKETS %d\n", $buckets;
+printf "static const unsigned short obj_hash_seeds[OBJ_HASH_BUCKETS] = {\n";
+for (my $i = 0; $i < $buckets; $i += 8) {
+    print  "   ";
+    printf " %5d,", $seed[$_] foreach $i .. $i + 7;
+    print  "\n";
+}
+print  "};\n\n";
+printf "#define OBJ_HASH_SLOTS %d\n", $slots;
+printf "static const unsigned short obj_hash_nids[OBJ_HASH_SLOTS] = {\n";
+foreach (@slot) {
+    if ($_ == 0) {
+        printf "    %4d,\n", 0;
+        next;
+    }
     my $m = $obj{$nid{$_}};
     my $v = $objd{$m};
     $v =~ s/L//g;
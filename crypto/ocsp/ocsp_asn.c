@@ -36,12 +36,12 @@ ASN1_SEQUENCE(OCSP_ONEREQ) = {
 
 IMPLEMENT_ASN1_FUNCTIONS(OCSP_ONEREQ)
 
-ASN1_SEQUENCE(OCSP_REQINFO) = {
+ASN1_SEQUENCE_enc(OCSP_REQINFO, enc, 0) = {
         ASN1_EXP_OPT(OCSP_REQINFO, version, ASN1_INTEGER, 0),
         ASN1_EXP_OPT(OCSP_REQINFO, requestorName, GENERAL_NAME, 1),
         ASN1_SEQUENCE_OF(OCSP_REQINFO, requestList, OCSP_ONEREQ),
         ASN1_EXP_SEQUENCE_OF_OPT(OCSP_REQINFO, requestExtensions, X509_EXTENSION, 2)
-} ASN1_SEQUENCE_END(OCSP_REQINFO)
+} ASN1_SEQUENCE_END_enc(OCSP_REQINFO, OCSP_REQINFO)
 
 IMPLEMENT_ASN1_FUNCTIONS(OCSP_REQINFO)
 
@@ -100,13 +100,13 @@ ASN1_SEQUENCE(OCSP_SINGLERESP) = {
 
 IMPLEMENT_ASN1_FUNCTIONS(OCSP_SINGLERESP)
 
-ASN1_SEQUENCE(OCSP_RESPDATA) = {
+ASN1_SEQUENCE_enc(OCSP_RESPDATA, enc, 0) = {
            ASN1_EXP_OPT(OCSP_RESPDATA, version, ASN1_INTEGER, 0),
            ASN1_EMBED(OCSP_RESPDATA, responderId, OCSP_RESPID),
            ASN1_SIMPLE(OCSP_RESPDATA, producedAt, ASN1_GENERALIZEDTIME),
            ASN1_SEQUENCE_OF(OCSP_RESPDATA, responses, OCSP_SINGLERESP),
            ASN1_EXP_SEQUENCE_OF_OPT(OCSP_RESPDATA, responseExtensions, X509_EXTENSION, 1)
-} ASN1_SEQUENCE_END(OCSP_RESPDATA)
+} ASN1_SEQUENCE_END_enc(OCSP_RESPDATA, OCSP_RESPDATA)
 
 IMPLEMENT_ASN1_FUNCTIONS(OCSP_RESPDATA)
 
@@ -36,9 +36,12 @@ OCSP_ONEREQ *OCSP_request_add0_id(OCSP_REQUEST *req, OCSP_CERTID *cid)
         return NULL;
     OCSP_CERTID_free(one->reqCert);
     one->reqCert = cid;
-    if (req && !sk_OCSP_ONEREQ_push(req->tbsRequest.requestList, one)) {
-        one->reqCert = NULL; /* do not free on error */
-        goto err;
+    if (req) {
+        if (!sk_OCSP_ONEREQ_push(req->tbsRequest.requestList, one)) {
+            one->reqCert = NULL; /* do not free on error */
+            goto err;
+        }
+        req->tbsRequest.enc.modified = 1;
     }
     return one;
  err:
@@ -62,6 +65,7 @@ int OCSP_request_set1_name(OCSP_REQUEST *req, X509_NAME *nm)
     gen->type = GEN_DIRNAME;
     GENERAL_NAME_free(req->tbsRequest.requestorName);
     req->tbsRequest.requestorName = gen;
+    req->tbsRequest.enc.modified = 1;
     return 1;
 }
 
@@ -51,6 +51,7 @@ X509_EXTENSION *OCSP_REQUEST_get_ext(OCSP_REQUEST *x, int loc)
 
 X509_EXTENSION *OCSP_REQUEST_delete_ext(OCSP_REQUEST *x, int loc)
 {
+    x->tbsRequest.enc.modified = 1;
     return X509v3_delete_ext(x->tbsRequest.requestExtensions, loc);
 }
 
@@ -62,12 +63,14 @@ void *OCSP_REQUEST_get1_ext_d2i(OCSP_REQUEST *x, int nid, int *crit, int *idx)
 int OCSP_REQUEST_add1_ext_i2d(OCSP_REQUEST *x, int nid, void *value, int crit,
                               unsigned long flags)
 {
+    x->tbsRequest.enc.modified = 1;
     return X509V3_add1_i2d(&x->tbsRequest.requestExtensions, nid, value,
                            crit, flags);
 }
 
 int OCSP_REQUEST_add_ext(OCSP_REQUEST *x, X509_EXTENSION *ex, int loc)
 {
+    x->tbsRequest.enc.modified = 1;
     return (X509v3_add_ext(&(x->tbsRequest.requestExtensions), ex, loc) !=
             NULL);
 }
@@ -157,6 +160,7 @@ X509_EXTENSION *OCSP_BASICRESP_get_ext(OCSP_BASICRESP *x, int loc)
 
 X509_EXTENSION *OCSP_BASICRESP_delete_ext(OCSP_BASICRESP *x, int loc)
 {
+    x->tbsResponseData.enc.modified = 1;
     return X509v3_delete_ext(x->tbsResponseData.responseExtensions, loc);
 }
 
@@ -170,12 +174,14 @@ void *OCSP_BASICRESP_get1_ext_d2i(OCSP_BASICRESP *x, int nid, int *crit,
 int OCSP_BASICRESP_add1_ext_i2d(OCSP_BASICRESP *x, int nid, void *value,
                                 int crit, unsigned long flags)
 {
+    x->tbsResponseData.enc.modified = 1;
     return X509V3_add1_i2d(&x->tbsResponseData.responseExtensions, nid,
                            value, crit, flags);
 }
 
 int OCSP_BASICRESP_add_ext(OCSP_BASICRESP *x, X509_EXTENSION *ex, int loc)
 {
+    x->tbsResponseData.enc.modified = 1;
     return (X509v3_add_ext(&(x->tbsResponseData.responseExtensions), ex, loc)
             != NULL);
 }
@@ -281,6 +287,7 @@ static int ocsp_add1_nonce(STACK_OF(X509_EXTENSION) **exts,
 
 int OCSP_request_add1_nonce(OCSP_REQUEST *req, unsigned char *val, int len)
 {
+    req->tbsRequest.enc.modified = 1;
     return ocsp_add1_nonce(&req->tbsRequest.requestExtensions, val, len);
 }
 
@@ -288,6 +295,7 @@ int OCSP_request_add1_nonce(OCSP_REQUEST *req, unsigned char *val, int len)
 
 int OCSP_basic_add1_nonce(OCSP_BASICRESP *resp, unsigned char *val, int len)
 {
+    resp->tbsResponseData.enc.modified = 1;
     return ocsp_add1_nonce(&resp->tbsResponseData.responseExtensions, val,
                            len);
 }
@@ -40,6 +40,7 @@ struct ocsp_req_info_st {
     GENERAL_NAME *requestorName;
     STACK_OF(OCSP_ONEREQ) *requestList;
     STACK_OF(X509_EXTENSION) *requestExtensions;
+    ASN1_ENCODING enc;          /* cached encoding of the request info */
 };
 
 /*-  Signature       ::=     SEQUENCE {
@@ -158,6 +159,7 @@ struct ocsp_response_data_st {
     ASN1_GENERALIZEDTIME *producedAt;
     STACK_OF(OCSP_SINGLERESP) *responses;
     STACK_OF(X509_EXTENSION) *responseExtensions;
+    ASN1_ENCODING enc;          /* cached encoding of the response data */
 };
 
 /*-  BasicOCSPResponse       ::= SEQUENCE {
@@ -215,18 +217,26 @@ struct ocsp_service_locator_st {
     STACK_OF(ACCESS_DESCRIPTION) *locator;
 };
 
+/*
+ * The sign macros set the modified flag, so that the cached encodings are
+ * ignored and the current contents signed, whatever was changed since they
+ * were decoded, like X509_sign() does.
+ */
 #  define OCSP_REQUEST_sign(o,pkey,md) \
-        ASN1_item_sign(ASN1_ITEM_rptr(OCSP_REQINFO),\
+        ((o)->tbsRequest.enc.modified = 1, \
+         ASN1_item_sign(ASN1_ITEM_rptr(OCSP_REQINFO),\
                 &(o)->optionalSignature->signatureAlgorithm,NULL,\
-                (o)->optionalSignature->signature,&(o)->tbsRequest,pkey,md)
+                (o)->optionalSignature->signature,&(o)->tbsRequest,pkey,md))
 
 #  define OCSP_BASICRESP_sign(o,pkey,md,d) \
-        ASN1_item_sign(ASN1_ITEM_rptr(OCSP_RESPDATA),&(o)->signatureAlgorithm,\
-                NULL,(o)->signature,&(o)->tbsResponseData,pkey,md)
+        ((o)->tbsResponseData.enc.modified = 1, \
+         ASN1_item_sign(ASN1_ITEM_rptr(OCSP_RESPDATA),&(o)->signatureAlgorithm,\
+                NULL,(o)->signature,&(o)->tbsResponseData,pkey,md))
 
 #  define OCSP_BASICRESP_sign_ctx(o,ctx,d) \
-        ASN1_item_sign_ctx(ASN1_ITEM_rptr(OCSP_RESPDATA),&(o)->signatureAlgorithm,\
-                NULL,(o)->signature,&(o)->tbsResponseData,ctx)
+        ((o)->tbsResponseData.enc.modified = 1, \
+         ASN1_item_sign_ctx(ASN1_ITEM_rptr(OCSP_RESPDATA),&(o)->signatureAlgorithm,\
+                NULL,(o)->signature,&(o)->tbsResponseData,ctx))
 
 #  define OCSP_REQUEST_verify(a,r) ASN1_item_verify(ASN1_ITEM_rptr(OCSP_REQINFO),\
         &(a)->optionalSignature->signatureAlgorithm,\
@@ -148,6 +148,7 @@ OCSP_SINGLERESP *OCSP_basic_add1_status(OCSP_BASICRESP *rsp,
     }
     if (!(sk_OCSP_SINGLERESP_push(rsp->tbsResponseData.responses, single)))
         goto err;
+    rsp->tbsResponseData.enc.modified = 1;
     return single;
  err:
     OCSP_SINGLERESP_free(single);
@@ -223,6 +223,14 @@ static void pem_free(void *p, unsigned int flags, size_t num)
         OPENSSL_free(p);
 }
 
+static void pem_clear_free(void *p, unsigned int flags, size_t num)
+{
+    if (flags & PEM_FLAG_SECURE)
+        OPENSSL_secure_clear_free(p, num);
+    else
+        OPENSSL_clear_free(p, num);
+}
+
 static void *pem_malloc(int num, unsigned int flags)
 {
     return (flags & PEM_FLAG_SECURE) ? OPENSSL_secure_malloc(num)
@@ -890,6 +898,213 @@ err:
     return ret;
 }
 
+/*-
+ * Fast path of PEM_read_bio_ex() for memory BIOs and seekable files. The
+ * whole block is located first, and when its body is nothing but whole
+ * lines of base64, as it is unless it has headers, it is decoded in one go
+ * from where it lies, with no copy line by line. Anything else, or anything
+ * unusual before the block, is left to the line by line parser, which then
+ * finds the input as it was, so behaviour and errors do not change.
+ */
+
+/* First read from a file, doubled until the whole block is in */
+#define PEM_FLAT_BLOCK 4096
+
+typedef struct {
+    char name[LINESIZE + 1];
+    size_t body;                /* offset of the body */
+    size_t bodylen;
+    size_t consumed;            /* up to the end of the END line */
+} PEM_FLAT;
+
+/*
+ * Looks for a block as get_name() and get_header_and_data() would read it
+ * from the |n| bytes at |buf|, with a body of base64 lines only. Returns 1
+ * if found, 0 if more input is needed and -1 if the line by line parser is
+ * needed.
+ */
+static int pem_scan_flat(const char *buf, size_t n, unsigned int flags,
+                         PEM_FLAT *pf)
+{
+    char linebuf[LINESIZE + 1];
+    const char *line, *eol, *end = buf + n;
+    size_t len, i, namelen = 0;
+    int inbody = 0;
+
+    for (line = buf; line < end; line = eol + 1) {
+        if ((eol = memchr(line, '\n', end - line)) == NULL)
+            return 0;
+        len = eol + 1 - line;
+        /* Longer lines are split by BIO_gets() */
+        if (len > LINESIZE - 1)
+            return -1;
+
+        if (!inbody) {
+            if (len < BEGINLEN || memcmp(line, beginstr, BEGINLEN) != 0)
+                continue;
+            if (memchr(line, '\0', len) != NULL)
+                return -1;
+            memcpy(linebuf, line, len);
+            linebuf[len] = '\0';
+            len = sanitize_line(linebuf, len, flags & ~PEM_FLAG_ONLY_B64);
+            if (len < BEGINLEN + TAILLEN)
+                return -1;
+            if (strncmp(linebuf + len - TAILLEN, tailstr, TAILLEN) != 0)
+                continue;
+            namelen = len - BEGINLEN - TAILLEN;
+            memcpy(pf->name, linebuf + BEGINLEN, namelen);
+            pf->name[namelen] = '\0';
+            pf->body = eol + 1 - buf;
+            inbody = 1;
+            continue;
+        }
+
+        if (len >= ENDLEN && memcmp(line, endstr, ENDLEN) == 0) {
+            if (memchr(line, '\0', len) != NULL)
+                return -1;
+            memcpy(linebuf, line, len);
+            linebuf[len] = '\0';
+            sanitize_line(linebuf, len, flags & ~PEM_FLAG_ONLY_B64);
+            if (strncmp(linebuf + ENDLEN, pf->name, namelen) != 0
+                    || strncmp(linebuf + ENDLEN + namelen, tailstr,
+                               TAILLEN) != 0)
+                return -1;
+            pf->bodylen = line - buf - pf->body;
+            pf->consumed = eol + 1 - buf;
+            return pf->bodylen > 0 ? 1 : -1;
+        }
+
+        /*
+         * Base64 and nothing else, what sanitize_line() leaves unchanged;
+         * with PEM_FLAG_ONLY_B64 it cuts lines at the padding
+         */
+        len--;
+        if (len > 0 && line[len - 1] == '\r')
+            len--;
+        /* A blank line ends the headers */
+        if (len == 0)
+            return -1;
+        for (i = 0; i < len; i++)
+            if (!ossl_isbase64(line[i])
+                    && (line[i] != '=' || (flags & PEM_FLAG_ONLY_B64)))
+                return -1;
+    }
+    return 0;
+}
+
+/* Decodes the block found by pem_scan_flat() in |buf| */
+static int pem_decode_flat(const char *buf, const PEM_FLAT *pf,
+                           char **name_out, char **header,
+                           unsigned char **data, long *len_out,
+                           unsigned int flags)
+{
+    EVP_ENCODE_CTX *ctx = NULL;
+    char *name = NULL, *hdr = NULL;
+    unsigned char *out = NULL;
+    int len, taillen, outlen, ret = 0;
+
+    if (pf->bodylen > INT_MAX / 3)
+        return 0;
+    outlen = (int)(pf->bodylen / 4 + 1) * 3;
+    name = pem_malloc(strlen(pf->name) + 1, flags);
+    hdr = pem_malloc(1, flags);
+    out = pem_malloc(outlen, flags);
+    if ((ctx = EVP_ENCODE_CTX_new()) == NULL
+            || name == NULL || hdr == NULL || out == NULL)
+        goto end;
+
+    EVP_DecodeInit(ctx);
+    if (EVP_DecodeUpdate(ctx, out, &len,
+                         (const unsigned char *)buf + pf->body,
+                         (int)pf->bodylen) < 0
+            || EVP_DecodeFinal(ctx, out + len, &taillen) < 0
+            || len + taillen == 0)
+        goto end;
+
+    strcpy(name, pf->name);
+    hdr[0] = '\0';
+    *name_out = name;
+    *header = hdr;
+    *data = out;
+    *len_out = len + taillen;
+    name = hdr = NULL;
+    out = NULL;
+    ret = 1;
+
+ end:
+    EVP_ENCODE_CTX_free(ctx);
+    pem_free(name, flags, 0);
+    pem_free(hdr, flags, 0);
+    pem_clear_free(out, flags, outlen);
+    return ret;
+}
+
+/*
+ * Returns 1 if the next block of |bp| was read, and 0 if it must be read
+ * line by line, in which case |bp| is where it was.
+ */
+static int pem_read_bio_flat(BIO *bp, char **name_out, char **header,
+                             unsigned char **data, long *len_out,
+                             unsigned int flags)
+{
+    PEM_FLAT pf;
+    char *buf = NULL, *tmp, skip[1024];
+    size_t n = 0, size = 0, left;
+    long pos;
+    int r, found = 0;
+
+    switch (BIO_method_type(bp)) {
+    case BIO_TYPE_MEM:
+        /* The unread data, in place */
+        if ((r = BIO_get_mem_data(bp, &buf)) <= 0
+                || pem_scan_flat(buf, r, flags, &pf) != 1
+                || !pem_decode_flat(buf, &pf, name_out, header, data,
+                                    len_out, flags))
+            return 0;
+        for (left = pf.consumed; left > 0; left -= r)
+            if ((r = BIO_read(bp, skip, left < sizeof(skip)
+                                        ? (int)left : (int)sizeof(skip))) <= 0)
+                break;
+        OPENSSL_cleanse(skip, sizeof(skip));
+        return 1;
+
+    case BIO_TYPE_FILE:
+        if ((pos = BIO_tell(bp)) < 0)
+            return 0;
+        do {
+            size = size == 0 ? PEM_FLAT_BLOCK : size * 2;
+            if (size > INT_MAX
+                    || (tmp = pem_malloc((int)size, flags)) == NULL)
+                break;
+            if (n > 0)
+                memcpy(tmp, buf, n);
+            pem_clear_free(buf, flags, n);
+            buf = tmp;
+            while (n < size && (r = BIO_read(bp, buf + n, size - n)) > 0)
+                n += r;
+            found = pem_scan_flat(buf, n, flags, &pf);
+        } while (found == 0 && n == size);
+        if (found == 1
+                && pem_decode_flat(buf, &pf, name_out, header, data, len_out,
+                                   flags)) {
+            if (BIO_seek(bp, pos + pf.consumed) == 0) {
+                pem_clear_free(buf, flags, n);
+                return 1;
+            }
+            pem_free(*name_out, flags, 0);
+            pem_free(*header, flags, 0);
+            pem_clear_free(*data, flags, *len_out);
+            *name_out = *header = NULL;
+            *data = NULL;
+            *len_out = 0;
+        }
+        pem_clear_free(buf, flags, n);
+        (void)BIO_seek(bp, pos);
+        return 0;
+    }
+    return 0;
+}
+
 /**
  * Read in PEM-formatted data from the given BIO.
  *
@@ -914,6 +1129,8 @@ int PEM_read_bio_ex(BIO *bp, char **name_out, char **header,
         PEMerr(PEM_F_PEM_READ_BIO_EX, ERR_R_PASSED_INVALID_ARGUMENT);
         goto end;
     }
+    if (pem_read_bio_flat(bp, name_out, header, data, len_out, flags))
+        return 1;
     bmeth = (flags & PEM_FLAG_SECURE) ? BIO_s_secmem() : BIO_s_mem();
 
     headerB = BIO_new(bmeth);
@@ -11,6 +11,7 @@
 #include "internal/cryptlib.h"
 #include <openssl/pkcs12.h>
 #include <openssl/bn.h>
+#include "crypto/evp.h"
 
 /* Uncomment out this line to get debugging info about key generation */
 /*
@@ -128,12 +129,8 @@ int PKCS12_key_gen_uni(unsigned char *pass, int passlen, unsigned char *salt,
             || !EVP_DigestUpdate(ctx, I, Ilen)
             || !EVP_DigestFinal_ex(ctx, Ai, NULL))
             goto err;
-        for (j = 1; j < iter; j++) {
-            if (!EVP_DigestInit_ex(ctx, md_type, NULL)
-                || !EVP_DigestUpdate(ctx, Ai, u)
-                || !EVP_DigestFinal_ex(ctx, Ai, NULL))
-                goto err;
-        }
+        if (iter > 1 && !evp_md_ctx_iterate(ctx, Ai, iter - 1))
+            goto err;
         memcpy(out, Ai, min(n, u));
         if (u >= n) {
 #ifdef OPENSSL_DEBUG_KEYGEN
@@ -15,6 +15,7 @@
 #include "internal/thread_once.h"
 #include "crypto/rand.h"
 #include "crypto/cryptlib.h"
+#include "internal/metrics.h"
 
 /*
  * Support framework for NIST SP 800-90A DRBG
@@ -82,9 +83,9 @@ static unsigned int slave_reseed_interval  = SLAVE_RESEED_INTERVAL;
 static time_t master_reseed_time_interval = MASTER_RESEED_TIME_INTERVAL;
 static time_t slave_reseed_time_interval  = SLAVE_RESEED_TIME_INTERVAL;
 
-/* A logical OR of all used DRBG flag bits (currently there is only one) */
+/* A logical OR of all used DRBG flag bits */
 static const unsigned int rand_drbg_used_flags =
-    RAND_DRBG_FLAG_CTR_NO_DF;
+    RAND_DRBG_FLAG_CTR_NO_DF | RAND_DRBG_FLAG_BUFFERED;
 
 static RAND_DRBG *drbg_setup(RAND_DRBG *parent);
 
@@ -93,6 +94,16 @@ static RAND_DRBG *rand_drbg_new(int secure,
                                 unsigned int flags,
                                 RAND_DRBG *parent);
 
+/* Wipe whatever is left of the output buffer */
+static void drbg_buffer_clear(RAND_DRBG *drbg)
+{
+    if (drbg->buf_left > 0) {
+        OPENSSL_cleanse(drbg->buf + DRBG_BUFFER_SIZE - drbg->buf_left,
+                        drbg->buf_left);
+        drbg->buf_left = 0;
+    }
+}
+
 /*
  * Set/initialize |drbg| to be of type |type|, with optional |flags|.
  *
@@ -116,6 +127,7 @@ int RAND_DRBG_set(RAND_DRBG *drbg, int type, unsigned int flags)
         drbg->adin_pool = NULL;
     }
 
+    drbg_buffer_clear(drbg);
     drbg->state = DRBG_UNINITIALISED;
     drbg->flags = flags;
     drbg->type = type;
@@ -268,6 +280,10 @@ void RAND_DRBG_free(RAND_DRBG *drbg)
     if (drbg->meth != NULL)
         drbg->meth->uninstantiate(drbg);
     rand_pool_free(drbg->adin_pool);
+    if (drbg->secure)
+        OPENSSL_secure_clear_free(drbg->buf, DRBG_BUFFER_SIZE);
+    else
+        OPENSSL_clear_free(drbg->buf, DRBG_BUFFER_SIZE);
     CRYPTO_THREAD_lock_free(drbg->lock);
     CRYPTO_free_ex_data(CRYPTO_EX_INDEX_DRBG, drbg, &drbg->ex_data);
 
@@ -421,6 +437,7 @@ int RAND_DRBG_reseed(RAND_DRBG *drbg,
         return 0;
     }
 
+    drbg_buffer_clear(drbg);
     drbg->state = DRBG_ERROR;
     if (drbg->get_entropy != NULL)
         entropylen = drbg->get_entropy(drbg, &entropy, drbg->strength,
@@ -441,6 +458,7 @@ int RAND_DRBG_reseed(RAND_DRBG *drbg,
     drbg->reseed_time = time(NULL);
     if (drbg->enable_reseed_propagation && drbg->parent == NULL)
         tsan_counter(&drbg->reseed_counter);
+    OSSL_METRIC_INC(OSSL_METRIC_RAND_DRBG_RESEEDS);
 
  end:
     if (entropy != NULL && drbg->cleanup_entropy != NULL)
@@ -635,15 +653,8 @@ int RAND_DRBG_generate(RAND_DRBG *drbg, unsigned char *out, size_t outlen,
     return 1;
 }
 
-/*
- * Generates |outlen| random bytes and stores them in |out|. It will
- * using the given |drbg| to generate the bytes.
- *
- * Requires that drbg->lock is already locked for write, if non-null.
- *
- * Returns 1 on success 0 on failure.
- */
-int RAND_DRBG_bytes(RAND_DRBG *drbg, unsigned char *out, size_t outlen)
+static int drbg_bytes_unbuffered(RAND_DRBG *drbg, unsigned char *out,
+                                 size_t outlen)
 {
     unsigned char *additional = NULL;
     size_t additional_len;
@@ -678,6 +689,74 @@ int RAND_DRBG_bytes(RAND_DRBG *drbg, unsigned char *out, size_t outlen)
     return ret;
 }
 
+/*
+ * Returns 1 if the buffered output may still be handed out, i.e. if a
+ * request now would not have reseeded the DRBG first.  This mirrors the
+ * checks in RAND_DRBG_generate().
+ */
+static int drbg_buffer_usable(RAND_DRBG *drbg)
+{
+    if (drbg->state != DRBG_READY || drbg->fork_id != openssl_get_fork_id())
+        return 0;
+    if (drbg->reseed_time_interval > 0) {
+        time_t now = time(NULL);
+
+        if (now < drbg->reseed_time
+            || now - drbg->reseed_time >= drbg->reseed_time_interval)
+            return 0;
+    }
+    if (drbg->enable_reseed_propagation && drbg->parent != NULL
+        && drbg->reseed_counter != tsan_load(&drbg->parent->reseed_counter))
+        return 0;
+    return 1;
+}
+
+/*
+ * Serves a small request from the output buffer, refilling it with a single
+ * generate call when it runs short.  Handed out bytes are wiped from the
+ * buffer straight away.
+ */
+static int drbg_bytes_buffered(RAND_DRBG *drbg, unsigned char *out,
+                               size_t outlen)
+{
+    unsigned char *p;
+
+    if (outlen > drbg->buf_left || !drbg_buffer_usable(drbg)) {
+        drbg_buffer_clear(drbg);
+        if (drbg->buf == NULL) {
+            drbg->buf = drbg->secure ? OPENSSL_secure_malloc(DRBG_BUFFER_SIZE)
+                                     : OPENSSL_malloc(DRBG_BUFFER_SIZE);
+            if (drbg->buf == NULL)
+                return drbg_bytes_unbuffered(drbg, out, outlen);
+        }
+        if (!drbg_bytes_unbuffered(drbg, drbg->buf, DRBG_BUFFER_SIZE))
+            return 0;
+        drbg->buf_left = DRBG_BUFFER_SIZE;
+    }
+
+    p = drbg->buf + DRBG_BUFFER_SIZE - drbg->buf_left;
+    memcpy(out, p, outlen);
+    OPENSSL_cleanse(p, outlen);
+    drbg->buf_left -= outlen;
+    return 1;
+}
+
+/*
+ * Generates |outlen| random bytes and stores them in |out|. It will
+ * using the given |drbg| to generate the bytes.
+ *
+ * Requires that drbg->lock is already locked for write, if non-null.
+ *
+ * Returns 1 on success 0 on failure.
+ */
+int RAND_DRBG_bytes(RAND_DRBG *drbg, unsigned char *out, size_t outlen)
+{
+    if ((drbg->flags & RAND_DRBG_FLAG_BUFFERED) != 0
+            && outlen <= DRBG_BUFFER_MAX_REQUEST)
+        return drbg_bytes_buffered(drbg, out, outlen);
+    return drbg_bytes_unbuffered(drbg, out, outlen);
+}
+
 /*
  * Set the RAND_DRBG callbacks for obtaining entropy and nonce.
  *
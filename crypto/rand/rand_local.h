@@ -33,6 +33,10 @@
 # define MASTER_RESEED_TIME_INTERVAL             (60*60)   /* 1 hour */
 # define SLAVE_RESEED_TIME_INTERVAL              (7*60)    /* 7 minutes */
 
+/* Output buffer of RAND_DRBG_FLAG_BUFFERED, and the largest request it serves */
+# define DRBG_BUFFER_SIZE                        4096
+# define DRBG_BUFFER_MAX_REQUEST                 256
+
 
 
 /*
@@ -196,6 +200,14 @@ struct rand_drbg_st {
     int fork_id;
     unsigned short flags; /* various external flags */
 
+    /*
+     * Output generated ahead of time for RAND_DRBG_FLAG_BUFFERED: the
+     * unused bytes are the last |buf_left| of |buf|.  Dropped whenever a
+     * request would have reseeded the DRBG.
+     */
+    unsigned char *buf;
+    size_t buf_left;
+
     /*
      * The random_data is used by RAND_add()/drbg_add() to attach random
      * data to the global drbg, such that the rand_drbg_get_entropy() callback
@@ -17,10 +17,11 @@
 #include <time.h>
 #include "internal/cryptlib.h"
 #include <openssl/bn.h>
+#include "crypto/bn.h"
 #include "rsa_local.h"
 
 static int rsa_builtin_keygen(RSA *rsa, int bits, int primes, BIGNUM *e_value,
-                              BN_GENCB *cb);
+                              BN_GENCB *cb, OSSL_WORKER_POOL *pool);
 
 /*
  * NB: this wrapper would normally be placed in rsa_lib.c and the static
@@ -40,6 +41,16 @@ int RSA_generate_key_ex(RSA *rsa, int bits, BIGNUM *e_value, BN_GENCB *cb)
 
 int RSA_generate_multi_prime_key(RSA *rsa, int bits, int primes,
                                  BIGNUM *e_value, BN_GENCB *cb)
+{
+    return rsa_generate_key_pool(rsa, bits, primes, e_value, cb, NULL);
+}
+
+/*
+ * As RSA_generate_multi_prime_key(), with the Miller-Rabin tests of the prime
+ * search of the builtin key generation run on |pool| if it isn't NULL.
+ */
+int rsa_generate_key_pool(RSA *rsa, int bits, int primes, BIGNUM *e_value,
+                          BN_GENCB *cb, OSSL_WORKER_POOL *pool)
 {
     /* multi-prime is only supported with the builtin key generation */
     if (rsa->meth->rsa_multi_prime_keygen != NULL) {
@@ -58,11 +69,11 @@ int RSA_generate_multi_prime_key(RSA *rsa, int bits, int primes,
             return 0;
     }
 
-    return rsa_builtin_keygen(rsa, bits, primes, e_value, cb);
+    return rsa_builtin_keygen(rsa, bits, primes, e_value, cb, pool);
 }
 
 static int rsa_builtin_keygen(RSA *rsa, int bits, int primes, BIGNUM *e_value,
-                              BN_GENCB *cb)
+                              BN_GENCB *cb, OSSL_WORKER_POOL *pool)
 {
     BIGNUM *r0 = NULL, *r1 = NULL, *r2 = NULL, *tmp, *prime;
     int ok = -1, n = 0, bitsr[RSA_MAX_PRIME_NUM], bitse = 0;
@@ -161,8 +172,13 @@ static int rsa_builtin_keygen(RSA *rsa, int bits, int primes, BIGNUM *e_value,
 
         for (;;) {
  redo:
-            if (!BN_generate_prime_ex(prime, bitsr[i] + adj, 0, NULL, NULL, cb))
+            if (pool != NULL) {
+                if (!bn_generate_prime_pool(prime, bitsr[i] + adj, pool, cb))
+                    goto err;
+            } else if (!BN_generate_prime_ex(prime, bitsr[i] + adj, 0, NULL,
+                                             NULL, cb)) {
                 goto err;
+            }
             /*
              * prime should not be equal to p, q, r_3...
              * (those primes prior to this one)
@@ -105,6 +105,7 @@ RSA *RSA_new_method(ENGINE *engine)
 void RSA_free(RSA *r)
 {
     int i;
+    size_t j;
 
     if (r == NULL)
         return;
@@ -136,7 +137,8 @@ void RSA_free(RSA *r)
     RSA_PSS_PARAMS_free(r->pss);
     sk_RSA_PRIME_INFO_pop_free(r->prime_infos, rsa_multip_info_free);
     BN_BLINDING_free(r->blinding);
-    BN_BLINDING_free(r->mt_blinding);
+    for (j = 0; j < RSA_MT_BLINDING_NUM; j++)
+        BN_BLINDING_free(r->mt_blinding[j]);
     OPENSSL_free(r->bignum_data);
     OPENSSL_free(r);
 }
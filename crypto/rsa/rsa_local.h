@@ -9,10 +9,18 @@
 
 #include <openssl/rsa.h>
 #include "internal/refcount.h"
+#include "internal/tsan_assist.h"
 
 #define RSA_MAX_PRIME_NUM       5
 #define RSA_MIN_MODULUS_BITS    512
 
+/*
+ * Number of shared blinding structures per key. Threads other than the
+ * owner of |blinding| are spread over these so that they rarely contend
+ * on the same BN_BLINDING lock.
+ */
+#define RSA_MT_BLINDING_NUM     16
+
 typedef struct rsa_prime_info_st {
     BIGNUM *r;
     BIGNUM *d;
@@ -55,13 +63,19 @@ struct rsa_st {
     BN_MONT_CTX *_method_mod_n;
     BN_MONT_CTX *_method_mod_p;
     BN_MONT_CTX *_method_mod_q;
+    /*
+     * iqmp in Montgomery form modulo p, published once the three contexts
+     * above are set so that two-prime CRT operations can skip the lock
+     */
+    BIGNUM *_crt_iqmp_mont;
     /*
      * all BIGNUM values are actually in the following data, if it is not
      * NULL
      */
     char *bignum_data;
     BN_BLINDING *blinding;
-    BN_BLINDING *mt_blinding;
+    BN_BLINDING *mt_blinding[RSA_MT_BLINDING_NUM];
+    TSAN_QUALIFIER unsigned int mt_blinding_next;
     CRYPTO_RWLOCK *lock;
 };
 
@@ -130,3 +144,5 @@ void rsa_multip_info_free(RSA_PRIME_INFO *pinfo);
 RSA_PRIME_INFO *rsa_multip_info_new(void);
 int rsa_multip_calc_product(RSA *rsa);
 int rsa_multip_cap(int bits);
+int rsa_generate_key_pool(RSA *rsa, int bits, int primes, BIGNUM *e_value,
+                          BN_GENCB *cb, OSSL_WORKER_POOL *pool);
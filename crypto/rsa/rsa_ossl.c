@@ -91,7 +91,7 @@ static int rsa_ossl_public_encrypt(int flen, const unsigned char *from,
         }
     }
 
-    if ((ctx = BN_CTX_new()) == NULL)
+    if ((ctx = bn_ctx_acquire(0)) == NULL)
         goto err;
     BN_CTX_start(ctx);
     f = BN_CTX_get(ctx);
@@ -149,7 +149,7 @@ static int rsa_ossl_public_encrypt(int flen, const unsigned char *from,
     r = BN_bn2binpad(ret, to, num);
  err:
     BN_CTX_end(ctx);
-    BN_CTX_free(ctx);
+    bn_ctx_release(ctx);
     OPENSSL_clear_free(buf, num);
     return r;
 }
@@ -157,6 +157,26 @@ static int rsa_ossl_public_encrypt(int flen, const unsigned char *from,
 static BN_BLINDING *rsa_get_blinding(RSA *rsa, int *local, BN_CTX *ctx)
 {
     BN_BLINDING *ret;
+    unsigned int slot;
+
+    /*
+     * Threads that don't own rsa->blinding are handed the shared blinding
+     * structures in turn, so that concurrent signers with the same key
+     * mostly take different BN_BLINDING locks. Each one refreshes its own
+     * factors on its own schedule.
+     */
+    slot = tsan_counter(&rsa->mt_blinding_next) % RSA_MT_BLINDING_NUM;
+
+    CRYPTO_THREAD_read_lock(rsa->lock);
+    ret = rsa->blinding;
+    if (ret != NULL) {
+        *local = BN_BLINDING_is_current_thread(ret);
+        if (!*local)
+            ret = rsa->mt_blinding[slot];
+    }
+    CRYPTO_THREAD_unlock(rsa->lock);
+    if (ret != NULL)
+        return ret;
 
     CRYPTO_THREAD_write_lock(rsa->lock);
 
@@ -173,7 +193,7 @@ static BN_BLINDING *rsa_get_blinding(RSA *rsa, int *local, BN_CTX *ctx)
 
         *local = 1;
     } else {
-        /* resort to rsa->mt_blinding instead */
+        /* resort to one of rsa->mt_blinding instead */
 
         /*
          * instructs rsa_blinding_convert(), rsa_blinding_invert() that the
@@ -182,10 +202,10 @@ static BN_BLINDING *rsa_get_blinding(RSA *rsa, int *local, BN_CTX *ctx)
          */
         *local = 0;
 
-        if (rsa->mt_blinding == NULL) {
-            rsa->mt_blinding = RSA_setup_blinding(rsa, ctx);
+        if (rsa->mt_blinding[slot] == NULL) {
+            rsa->mt_blinding[slot] = RSA_setup_blinding(rsa, ctx);
         }
-        ret = rsa->mt_blinding;
+        ret = rsa->mt_blinding[slot];
     }
 
  err:
@@ -247,7 +267,7 @@ static int rsa_ossl_private_encrypt(int flen, const unsigned char *from,
     BIGNUM *unblind = NULL;
     BN_BLINDING *blinding = NULL;
 
-    if ((ctx = BN_CTX_new()) == NULL)
+    if ((ctx = bn_ctx_acquire(0)) == NULL)
         goto err;
     BN_CTX_start(ctx);
     f = BN_CTX_get(ctx);
@@ -360,7 +380,7 @@ static int rsa_ossl_private_encrypt(int flen, const unsigned char *from,
     r = BN_bn2binpad(res, to, num);
  err:
     BN_CTX_end(ctx);
-    BN_CTX_free(ctx);
+    bn_ctx_release(ctx);
     OPENSSL_clear_free(buf, num);
     return r;
 }
@@ -381,7 +401,7 @@ static int rsa_ossl_private_decrypt(int flen, const unsigned char *from,
     BIGNUM *unblind = NULL;
     BN_BLINDING *blinding = NULL;
 
-    if ((ctx = BN_CTX_new()) == NULL)
+    if ((ctx = bn_ctx_acquire(0)) == NULL)
         goto err;
     BN_CTX_start(ctx);
     f = BN_CTX_get(ctx);
@@ -501,7 +521,7 @@ static int rsa_ossl_private_decrypt(int flen, const unsigned char *from,
 
  err:
     BN_CTX_end(ctx);
-    BN_CTX_free(ctx);
+    bn_ctx_release(ctx);
     OPENSSL_clear_free(buf, num);
     return r;
 }
@@ -533,7 +553,7 @@ static int rsa_ossl_public_decrypt(int flen, const unsigned char *from,
         }
     }
 
-    if ((ctx = BN_CTX_new()) == NULL)
+    if ((ctx = bn_ctx_acquire(0)) == NULL)
         goto err;
     BN_CTX_start(ctx);
     f = BN_CTX_get(ctx);
@@ -597,15 +617,70 @@ static int rsa_ossl_public_decrypt(int flen, const unsigned char *from,
 
  err:
     BN_CTX_end(ctx);
-    BN_CTX_free(ctx);
+    bn_ctx_release(ctx);
     OPENSSL_clear_free(buf, num);
     return r;
 }
 
+/*
+ * Once a two-prime key has been used, its Montgomery contexts never change,
+ * and publishing |_crt_iqmp_mont| last with release semantics lets later
+ * operations find all of them without the key's lock. Without the compiler
+ * atomics for that the lock is taken as before.
+ */
+#if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE) \
+    && __GCC_ATOMIC_POINTER_LOCK_FREE > 0
+# define RSA_CRT_LOCK_FREE
+#endif
+
+static const BIGNUM *rsa_crt_iqmp_mont(RSA *rsa)
+{
+    const BIGNUM *ret = NULL;
+
+#ifdef RSA_CRT_LOCK_FREE
+    ret = __atomic_load_n(&rsa->_crt_iqmp_mont, __ATOMIC_ACQUIRE);
+#else
+    if (CRYPTO_THREAD_read_lock(rsa->lock)) {
+        ret = rsa->_crt_iqmp_mont;
+        CRYPTO_THREAD_unlock(rsa->lock);
+    }
+#endif
+    return ret;
+}
+
+/* Must only be called after all three Montgomery contexts are set */
+static const BIGNUM *rsa_crt_publish(RSA *rsa, BN_CTX *ctx)
+{
+    BIGNUM *iqmp_mont = BN_new();
+    const BIGNUM *ret = NULL;
+
+    if (iqmp_mont == NULL)
+        return NULL;
+    BN_set_flags(iqmp_mont, BN_FLG_CONSTTIME);
+    if (bn_to_mont_fixed_top(iqmp_mont, rsa->iqmp, rsa->_method_mod_p, ctx)
+            && CRYPTO_THREAD_write_lock(rsa->lock)) {
+        if (rsa->_crt_iqmp_mont == NULL) {
+#ifdef RSA_CRT_LOCK_FREE
+            __atomic_store_n(&rsa->_crt_iqmp_mont, iqmp_mont,
+                             __ATOMIC_RELEASE);
+#else
+            rsa->_crt_iqmp_mont = iqmp_mont;
+#endif
+            iqmp_mont = NULL;
+        }
+        ret = rsa->_crt_iqmp_mont;
+        CRYPTO_THREAD_unlock(rsa->lock);
+    }
+    BN_clear_free(iqmp_mont);
+    return ret;
+}
+
 static int rsa_ossl_mod_exp(BIGNUM *r0, const BIGNUM *I, RSA *rsa, BN_CTX *ctx)
 {
     BIGNUM *r1, *m1, *vrfy, *r2, *m[RSA_MAX_PRIME_NUM - 2];
+    const BIGNUM *iqmp_mont = NULL;
     int ret = 0, i, ex_primes = 0, smooth = 0;
+    int cache = RSA_FLAG_CACHE_PRIVATE | RSA_FLAG_CACHE_PUBLIC;
     RSA_PRIME_INFO *pinfo;
 
     BN_CTX_start(ctx);
@@ -622,6 +697,13 @@ static int rsa_ossl_mod_exp(BIGNUM *r0, const BIGNUM *I, RSA *rsa, BN_CTX *ctx)
              || ex_primes > RSA_MAX_PRIME_NUM - 2))
         goto err;
 
+    if ((rsa->flags & cache) == cache && ex_primes == 0
+            && rsa->meth->bn_mod_exp == BN_mod_exp_mont
+            && (iqmp_mont = rsa_crt_iqmp_mont(rsa)) != NULL) {
+        smooth = 1;
+        goto crt;
+    }
+
     if (rsa->flags & RSA_FLAG_CACHE_PRIVATE) {
         BIGNUM *factor = BN_new();
 
@@ -664,6 +746,11 @@ static int rsa_ossl_mod_exp(BIGNUM *r0, const BIGNUM *I, RSA *rsa, BN_CTX *ctx)
                                     rsa->n, ctx))
             goto err;
 
+    /* Not fatal if it fails: the next operation takes the long way again */
+    if (smooth && (rsa->flags & cache) == cache)
+        iqmp_mont = rsa_crt_publish(rsa, ctx);
+
+ crt:
     if (smooth) {
         /*
          * Conversion from Montgomery domain, a.k.a. Montgomery reduction,
@@ -675,15 +762,14 @@ static int rsa_ossl_mod_exp(BIGNUM *r0, const BIGNUM *I, RSA *rsa, BN_CTX *ctx)
         if (/* m1 = I moq q */
             !bn_from_mont_fixed_top(m1, I, rsa->_method_mod_q, ctx)
             || !bn_to_mont_fixed_top(m1, m1, rsa->_method_mod_q, ctx)
-            /* m1 = m1^dmq1 mod q */
-            || !BN_mod_exp_mont_consttime(m1, m1, rsa->dmq1, rsa->q, ctx,
-                                          rsa->_method_mod_q)
             /* r1 = I mod p */
             || !bn_from_mont_fixed_top(r1, I, rsa->_method_mod_p, ctx)
             || !bn_to_mont_fixed_top(r1, r1, rsa->_method_mod_p, ctx)
-            /* r1 = r1^dmp1 mod p */
-            || !BN_mod_exp_mont_consttime(r1, r1, rsa->dmp1, rsa->p, ctx,
-                                          rsa->_method_mod_p)
+            /* m1 = m1^dmq1 mod q, r1 = r1^dmp1 mod p */
+            || !bn_mod_exp_mont_consttime_x2(m1, m1, rsa->dmq1, rsa->q,
+                                             rsa->_method_mod_q,
+                                             r1, r1, rsa->dmp1, rsa->p,
+                                             rsa->_method_mod_p, ctx)
             /* r1 = (r1 - m1) mod p */
             /*
              * bn_mod_sub_fixed_top is not regular modular subtraction,
@@ -693,10 +779,16 @@ static int rsa_ossl_mod_exp(BIGNUM *r0, const BIGNUM *I, RSA *rsa, BN_CTX *ctx)
              */
             || !bn_mod_sub_fixed_top(r1, r1, m1, rsa->p)
 
-            /* r1 = r1 * iqmp mod p */
-            || !bn_to_mont_fixed_top(r1, r1, rsa->_method_mod_p, ctx)
-            || !bn_mul_mont_fixed_top(r1, r1, rsa->iqmp, rsa->_method_mod_p,
-                                      ctx)
+            /*
+             * r1 = r1 * iqmp mod p, with iqmp already in Montgomery form
+             * when it is cached
+             */
+            || (iqmp_mont == NULL
+                && !bn_to_mont_fixed_top(r1, r1, rsa->_method_mod_p, ctx))
+            || !bn_mul_mont_fixed_top(r1, r1,
+                                      iqmp_mont != NULL ? iqmp_mont
+                                                        : rsa->iqmp,
+                                      rsa->_method_mod_p, ctx)
             /* r0 = r1 * q + m1 */
             || !bn_mul_fixed_top(r0, r1, rsa->q, ctx)
             || !bn_mod_add_fixed_top(r0, r0, m1, rsa->n))
@@ -973,6 +1065,7 @@ static int rsa_ossl_finish(RSA *rsa)
     int i;
     RSA_PRIME_INFO *pinfo;
 
+    BN_clear_free(rsa->_crt_iqmp_mont);
     BN_MONT_CTX_free(rsa->_method_mod_n);
     BN_MONT_CTX_free(rsa->_method_mod_p);
     BN_MONT_CTX_free(rsa->_method_mod_q);
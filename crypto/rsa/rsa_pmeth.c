@@ -740,8 +740,8 @@ static int pkey_rsa_keygen(EVP_PKEY_CTX *ctx, EVP_PKEY *pkey)
     } else {
         pcb = NULL;
     }
-    ret = RSA_generate_multi_prime_key(rsa, rctx->nbits, rctx->primes,
-                                       rctx->pub_exp, pcb);
+    ret = rsa_generate_key_pool(rsa, rctx->nbits, rctx->primes,
+                                rctx->pub_exp, pcb, ctx->worker_pool);
     BN_GENCB_free(pcb);
     if (ret > 0 && !rsa_set_pss_param(rsa, ctx)) {
         RSA_free(rsa);
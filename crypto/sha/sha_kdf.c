@@ -0,0 +1,426 @@
+/*
+ * Copyright 2024 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * The inner loops of PBKDF2 with HMAC-SHA-x and of the PKCS#12 KDF, for
+ * the built-in SHA digests.  Every iteration hashes a single digest, so
+ * with the HMAC key's ipad and opad states computed once, an iteration
+ * comes down to one or two compression function calls on a block that
+ * only needs padding once.
+ */
+
+#include <string.h>
+
+#include <openssl/crypto.h>
+#include <openssl/sha.h>
+#include "crypto/sha.h"
+
+typedef union {
+    SHA_CTX sha1;
+    SHA256_CTX sha256;
+    SHA512_CTX sha512;
+} SHA_ANY_CTX;
+
+typedef struct {
+    int (*init) (SHA_ANY_CTX *c);
+    int (*update) (SHA_ANY_CTX *c, const void *data, size_t len);
+    int (*final) (unsigned char *md, SHA_ANY_CTX *c);
+    void (*transform) (SHA_ANY_CTX *c, const unsigned char *data);
+    /* the digest the state of |c| stands for, without any padding */
+    void (*get) (const SHA_ANY_CTX *c, unsigned char *md);
+    size_t block_len;
+    size_t md_len;
+#ifdef SHA_MULTI_BLOCK
+    /* the whole state of |c|, for the multi-buffer kernels */
+    void (*words) (const SHA_ANY_CTX *c, unsigned int w[]);
+    /* run the iterations of several PBKDF2 blocks in parallel lanes */
+    void (*lanes) (const unsigned int istate[], const unsigned int ostate[],
+                   unsigned char *const u[], unsigned char *const t[],
+                   unsigned int num, size_t iter);
+#endif
+} SHA_KDF_METHOD;
+
+static void put32(unsigned char *p, unsigned int v)
+{
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+static int sha1_init(SHA_ANY_CTX *c)
+{
+    return SHA1_Init(&c->sha1);
+}
+
+static int sha1_update(SHA_ANY_CTX *c, const void *data, size_t len)
+{
+    return SHA1_Update(&c->sha1, data, len);
+}
+
+static int sha1_final(unsigned char *md, SHA_ANY_CTX *c)
+{
+    return SHA1_Final(md, &c->sha1);
+}
+
+static void sha1_transform(SHA_ANY_CTX *c, const unsigned char *data)
+{
+    SHA1_Transform(&c->sha1, data);
+}
+
+static void sha1_get(const SHA_ANY_CTX *c, unsigned char *md)
+{
+    put32(md, c->sha1.h0);
+    put32(md + 4, c->sha1.h1);
+    put32(md + 8, c->sha1.h2);
+    put32(md + 12, c->sha1.h3);
+    put32(md + 16, c->sha1.h4);
+}
+
+static int sha224_init(SHA_ANY_CTX *c)
+{
+    return SHA224_Init(&c->sha256);
+}
+
+static int sha256_init(SHA_ANY_CTX *c)
+{
+    return SHA256_Init(&c->sha256);
+}
+
+static int sha256_update(SHA_ANY_CTX *c, const void *data, size_t len)
+{
+    return SHA256_Update(&c->sha256, data, len);
+}
+
+static int sha256_final(unsigned char *md, SHA_ANY_CTX *c)
+{
+    return SHA256_Final(md, &c->sha256);
+}
+
+static void sha256_transform(SHA_ANY_CTX *c, const unsigned char *data)
+{
+    SHA256_Transform(&c->sha256, data);
+}
+
+static void sha256_get(const SHA_ANY_CTX *c, unsigned char *md)
+{
+    unsigned int i;
+
+    for (i = 0; i < c->sha256.md_len / 4; i++)
+        put32(md + 4 * i, c->sha256.h[i]);
+}
+
+static int sha384_init(SHA_ANY_CTX *c)
+{
+    return SHA384_Init(&c->sha512);
+}
+
+static int sha512_init(SHA_ANY_CTX *c)
+{
+    return SHA512_Init(&c->sha512);
+}
+
+static int sha512_update(SHA_ANY_CTX *c, const void *data, size_t len)
+{
+    return SHA512_Update(&c->sha512, data, len);
+}
+
+static int sha512_final(unsigned char *md, SHA_ANY_CTX *c)
+{
+    return SHA512_Final(md, &c->sha512);
+}
+
+static void sha512_transform(SHA_ANY_CTX *c, const unsigned char *data)
+{
+    SHA512_Transform(&c->sha512, data);
+}
+
+static void sha512_get(const SHA_ANY_CTX *c, unsigned char *md)
+{
+    unsigned int i;
+
+    for (i = 0; i < c->sha512.md_len / 8; i++) {
+        put32(md + 8 * i, (unsigned int)(c->sha512.h[i] >> 32));
+        put32(md + 8 * i + 4, (unsigned int)c->sha512.h[i]);
+    }
+}
+
+#ifdef SHA_MULTI_BLOCK
+static void sha1_words(const SHA_ANY_CTX *c, unsigned int w[])
+{
+    w[0] = c->sha1.h0;
+    w[1] = c->sha1.h1;
+    w[2] = c->sha1.h2;
+    w[3] = c->sha1.h3;
+    w[4] = c->sha1.h4;
+}
+
+static void sha256_words(const SHA_ANY_CTX *c, unsigned int w[])
+{
+    memcpy(w, c->sha256.h, sizeof(c->sha256.h));
+}
+#endif
+
+static const SHA_KDF_METHOD sha1_kdf = {
+    sha1_init, sha1_update, sha1_final, sha1_transform, sha1_get,
+    SHA_CBLOCK, SHA_DIGEST_LENGTH,
+#ifdef SHA_MULTI_BLOCK
+    sha1_words, sha1_pbkdf2_lanes
+#endif
+};
+
+static const SHA_KDF_METHOD sha224_kdf = {
+    sha224_init, sha256_update, sha256_final, sha256_transform, sha256_get,
+    SHA256_CBLOCK, SHA224_DIGEST_LENGTH,
+#ifdef SHA_MULTI_BLOCK
+    sha256_words, sha224_pbkdf2_lanes
+#endif
+};
+
+static const SHA_KDF_METHOD sha256_kdf = {
+    sha256_init, sha256_update, sha256_final, sha256_transform, sha256_get,
+    SHA256_CBLOCK, SHA256_DIGEST_LENGTH,
+#ifdef SHA_MULTI_BLOCK
+    sha256_words, sha256_pbkdf2_lanes
+#endif
+};
+
+static const SHA_KDF_METHOD sha384_kdf = {
+    sha384_init, sha512_update, sha512_final, sha512_transform, sha512_get,
+    SHA512_CBLOCK, SHA384_DIGEST_LENGTH,
+#ifdef SHA_MULTI_BLOCK
+    NULL, NULL
+#endif
+};
+
+static const SHA_KDF_METHOD sha512_kdf = {
+    sha512_init, sha512_update, sha512_final, sha512_transform, sha512_get,
+    SHA512_CBLOCK, SHA512_DIGEST_LENGTH,
+#ifdef SHA_MULTI_BLOCK
+    NULL, NULL
+#endif
+};
+
+/*
+ * Set up |blk| as the last block of a message of |len| bytes whose last
+ * |md_len| bytes are to be written at its start.  SHA-512 has a 128 bit
+ * length field, but the lengths here all fit in 16 bits.
+ */
+static void sha_kdf_pad(const SHA_KDF_METHOD *m, unsigned char *blk,
+                        size_t len)
+{
+    size_t bits = len * 8;
+
+    memset(blk, 0, m->block_len);
+    blk[m->md_len] = 0x80;
+    blk[m->block_len - 2] = (unsigned char)(bits >> 8);
+    blk[m->block_len - 1] = (unsigned char)bits;
+}
+
+static int sha_pbkdf2_hmac(const SHA_KDF_METHOD *m,
+                           const unsigned char *pass, size_t passlen,
+                           const unsigned char *salt, size_t saltlen,
+                           size_t iter, unsigned char *out, size_t keylen)
+{
+    SHA_ANY_CTX ictx, octx, c;
+    unsigned char key[SHA512_CBLOCK];
+    unsigned char ib[SHA512_CBLOCK], ob[SHA512_CBLOCK];
+    unsigned char t[SHA512_DIGEST_LENGTH], itmp[4];
+    size_t i, j, cplen, md_len = m->md_len;
+    unsigned int blk = 1;
+    int ret = 0;
+
+    memset(key, 0, m->block_len);
+    if (passlen > m->block_len) {
+        if (!m->init(&c) || !m->update(&c, pass, passlen)
+                || !m->final(key, &c))
+            goto err;
+    } else if (passlen > 0) {
+        memcpy(key, pass, passlen);
+    }
+    for (i = 0; i < m->block_len; i++) {
+        ib[i] = key[i] ^ 0x36;
+        ob[i] = key[i] ^ 0x5c;
+    }
+    /* Updates rather than transforms, to count the block for m->final() */
+    if (!m->init(&ictx) || !m->update(&ictx, ib, m->block_len)
+            || !m->init(&octx) || !m->update(&octx, ob, m->block_len))
+        goto err;
+
+    /*
+     * From here on |ib| holds an inner digest and |ob| an outer one, the
+     * U values, each padded as the end of a message that starts with the
+     * ipad or opad block.
+     */
+    sha_kdf_pad(m, ib, m->block_len + md_len);
+    sha_kdf_pad(m, ob, m->block_len + md_len);
+
+    while (keylen > 0) {
+#ifdef SHA_MULTI_BLOCK
+        if (m->lanes != NULL && keylen > md_len) {
+            unsigned int istate[8], ostate[8];
+            unsigned char lu[SHA_MB_LANES][SHA256_CBLOCK];
+            unsigned char lt[SHA_MB_LANES][SHA256_DIGEST_LENGTH];
+            unsigned char *u[SHA_MB_LANES], *tp[SHA_MB_LANES];
+            unsigned int n;
+
+            m->words(&ictx, istate);
+            m->words(&octx, ostate);
+            for (n = 0; n < SHA_MB_LANES && n * md_len < keylen; n++) {
+                put32(itmp, blk + n);
+                c = ictx;
+                if (!m->update(&c, salt, saltlen)
+                        || !m->update(&c, itmp, 4)
+                        || !m->final(ib, &c))
+                    goto err;
+                c = octx;
+                m->transform(&c, ib);
+                memcpy(lu[n], ob, m->block_len);
+                m->get(&c, lu[n]);
+                memcpy(lt[n], lu[n], md_len);
+                u[n] = lu[n];
+                tp[n] = lt[n];
+            }
+            if (iter > 1)
+                m->lanes(istate, ostate, u, tp, n, iter - 1);
+            for (i = 0; i < n; i++) {
+                cplen = keylen < md_len ? keylen : md_len;
+                memcpy(out, lt[i], cplen);
+                out += cplen;
+                keylen -= cplen;
+            }
+            blk += n;
+            OPENSSL_cleanse(lu, sizeof(lu));
+            OPENSSL_cleanse(lt, sizeof(lt));
+            continue;
+        }
+#endif
+        put32(itmp, blk);
+        c = ictx;
+        if (!m->update(&c, salt, saltlen)
+                || !m->update(&c, itmp, 4)
+                || !m->final(ib, &c))
+            goto err;
+        c = octx;
+        m->transform(&c, ib);
+        m->get(&c, ob);
+        memcpy(t, ob, md_len);
+        for (j = 1; j < iter; j++) {
+            c = ictx;
+            m->transform(&c, ob);
+            m->get(&c, ib);
+            c = octx;
+            m->transform(&c, ib);
+            m->get(&c, ob);
+            for (i = 0; i < md_len; i++)
+                t[i] ^= ob[i];
+        }
+        cplen = keylen < md_len ? keylen : md_len;
+        memcpy(out, t, cplen);
+        out += cplen;
+        keylen -= cplen;
+        blk++;
+    }
+    ret = 1;
+
+ err:
+    OPENSSL_cleanse(&ictx, sizeof(ictx));
+    OPENSSL_cleanse(&octx, sizeof(octx));
+    OPENSSL_cleanse(&c, sizeof(c));
+    OPENSSL_cleanse(key, sizeof(key));
+    OPENSSL_cleanse(ib, sizeof(ib));
+    OPENSSL_cleanse(ob, sizeof(ob));
+    OPENSSL_cleanse(t, sizeof(t));
+    return ret;
+}
+
+static void sha_iterate(const SHA_KDF_METHOD *m, unsigned char *md,
+                        size_t iter)
+{
+    SHA_ANY_CTX iv, c;
+    unsigned char blk[SHA512_CBLOCK];
+
+    if (iter == 0 || !m->init(&iv))
+        return;
+    sha_kdf_pad(m, blk, m->md_len);
+    memcpy(blk, md, m->md_len);
+    for (; iter > 0; iter--) {
+        c = iv;
+        m->transform(&c, blk);
+        m->get(&c, blk);
+    }
+    memcpy(md, blk, m->md_len);
+    OPENSSL_cleanse(&c, sizeof(c));
+    OPENSSL_cleanse(blk, sizeof(blk));
+}
+
+int sha1_pbkdf2_hmac(const unsigned char *pass, size_t passlen,
+                     const unsigned char *salt, size_t saltlen,
+                     size_t iter, unsigned char *out, size_t keylen)
+{
+    return sha_pbkdf2_hmac(&sha1_kdf, pass, passlen, salt, saltlen, iter,
+                           out, keylen);
+}
+
+int sha224_pbkdf2_hmac(const unsigned char *pass, size_t passlen,
+                       const unsigned char *salt, size_t saltlen,
+                       size_t iter, unsigned char *out, size_t keylen)
+{
+    return sha_pbkdf2_hmac(&sha224_kdf, pass, passlen, salt, saltlen, iter,
+                           out, keylen);
+}
+
+int sha256_pbkdf2_hmac(const unsigned char *pass, size_t passlen,
+                       const unsigned char *salt, size_t saltlen,
+                       size_t iter, unsigned char *out, size_t keylen)
+{
+    return sha_pbkdf2_hmac(&sha256_kdf, pass, passlen, salt, saltlen, iter,
+                           out, keylen);
+}
+
+int sha384_pbkdf2_hmac(const unsigned char *pass, size_t passlen,
+                       const unsigned char *salt, size_t saltlen,
+                       size_t iter, unsigned char *out, size_t keylen)
+{
+    return sha_pbkdf2_hmac(&sha384_kdf, pass, passlen, salt, saltlen, iter,
+                           out, keylen);
+}
+
+int sha512_pbkdf2_hmac(const unsigned char *pass, size_t passlen,
+                       const unsigned char *salt, size_t saltlen,
+                       size_t iter, unsigned char *out, size_t keylen)
+{
+    return sha_pbkdf2_hmac(&sha512_kdf, pass, passlen, salt, saltlen, iter,
+                           out, keylen);
+}
+
+void sha1_iterate(unsigned char *md, size_t iter)
+{
+    sha_iterate(&sha1_kdf, md, iter);
+}
+
+void sha224_iterate(unsigned char *md, size_t iter)
+{
+    sha_iterate(&sha224_kdf, md, iter);
+}
+
+void sha256_iterate(unsigned char *md, size_t iter)
+{
+    sha_iterate(&sha256_kdf, md, iter);
+}
+
+void sha384_iterate(unsigned char *md, size_t iter)
+{
+    sha_iterate(&sha384_kdf, md, iter);
+}
+
+void sha512_iterate(unsigned char *md, size_t iter)
+{
+    sha_iterate(&sha512_kdf, md, iter);
+}
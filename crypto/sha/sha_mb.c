@@ -0,0 +1,301 @@
+/*
+ * Copyright 2024 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Batch hashing of independent messages on top of the x86_64 multi-buffer
+ * SHA-1 and SHA-256 kernels, which otherwise only serve the TLS 1.1
+ * multi-block CBC-HMAC ciphers.
+ */
+
+#include <string.h>
+
+#include <openssl/crypto.h>
+#include <openssl/sha.h>
+#include "crypto/sha.h"
+
+#ifdef SHA_MULTI_BLOCK
+
+# define MB_LANES       SHA_MB_LANES /* 4 lanes per kernel pass, 2 max */
+# define MB_MAX_BLOCKS  (1 << 20) /* per kernel call, "blocks" is an int */
+
+typedef struct {
+    const unsigned char *ptr;
+    int blocks;
+} HASH_DESC;
+
+/* the kernels keep word w of lane i at h[w][i] */
+typedef struct {
+    unsigned int h[8][MB_LANES];
+} MB_CTX;
+
+void sha1_multi_block(MB_CTX *, const HASH_DESC *, int);
+void sha256_multi_block(MB_CTX *, const HASH_DESC *, int);
+
+typedef struct {
+    const unsigned char *ptr;   /* next block to hash */
+    size_t blocks;              /* blocks left at |ptr| */
+    size_t msg;                 /* index of the message in this lane */
+    int padded;                 /* |ptr| points into |pad| */
+    unsigned char pad[2 * SHA_CBLOCK];
+} MB_LANE;
+
+typedef struct {
+    void (*kernel) (MB_CTX *, const HASH_DESC *, int);
+    unsigned int words;         /* state words */
+    unsigned int md_len;
+    unsigned int iv[8];
+} MB_METHOD;
+
+/* queue whatever is left of the message plus padding as 1 or 2 blocks */
+static void mb_lane_pad(MB_LANE *lane, size_t count)
+{
+    size_t rem = count % SHA_CBLOCK, n;
+    unsigned long long bits = (unsigned long long)count << 3;
+    unsigned char *p;
+
+    lane->blocks = rem < SHA_CBLOCK - 8 ? 1 : 2;
+    n = lane->blocks * SHA_CBLOCK;
+    memset(lane->pad, 0, n);
+    if (rem != 0)
+        memcpy(lane->pad, lane->ptr, rem);
+    lane->pad[rem] = 0x80;
+    for (p = lane->pad + n; bits != 0; bits >>= 8)
+        *--p = (unsigned char)bits;
+    lane->ptr = lane->pad;
+    lane->padded = 1;
+}
+
+static void mb_lane_start(const MB_METHOD *meth, MB_CTX *ctx,
+                          MB_LANE *lane, unsigned int i,
+                          const void *const data[], const size_t count[],
+                          size_t msg)
+{
+    unsigned int w;
+
+    for (w = 0; w < meth->words; w++)
+        ctx->h[w][i] = meth->iv[w];
+    lane->ptr = data[msg];
+    lane->blocks = count[msg] / SHA_CBLOCK;
+    lane->msg = msg;
+    lane->padded = 0;
+    if (lane->blocks == 0)
+        mb_lane_pad(lane, count[msg]);
+}
+
+static void mb_lane_move(const MB_METHOD *meth, MB_CTX *ctx, MB_LANE *lanes,
+                         unsigned int to, unsigned int from)
+{
+    unsigned int w;
+
+    for (w = 0; w < meth->words; w++)
+        ctx->h[w][to] = ctx->h[w][from];
+    lanes[to] = lanes[from];
+    if (lanes[to].padded)
+        lanes[to].ptr = lanes[to].pad + (lanes[from].ptr - lanes[from].pad);
+}
+
+/*
+ * Active lanes are kept packed at the front: the kernels stop at the
+ * first group of lanes that has nothing to do, so a hole would hide the
+ * lanes behind it.  A finished lane is refilled with the next message,
+ * or closed by moving the last active lane into it.
+ */
+static void mb_digest_batch(const MB_METHOD *meth, const void *const data[],
+                            const size_t count[], unsigned char *const md[],
+                            size_t num)
+{
+    unsigned char storage[sizeof(MB_CTX) + 32];
+    MB_CTX *ctx = (MB_CTX *)(storage + 32 - ((size_t)storage % 32));
+    MB_LANE lanes[MB_LANES];
+    HASH_DESC desc[MB_LANES];
+    unsigned int active, i, w;
+    size_t next, steps;
+
+    for (active = 0, next = 0; active < MB_LANES && next < num; active++)
+        mb_lane_start(meth, ctx, &lanes[active], active, data, count, next++);
+
+    while (active > 0) {
+        steps = MB_MAX_BLOCKS;
+        for (i = 0; i < active; i++)
+            if (lanes[i].blocks < steps)
+                steps = lanes[i].blocks;
+        for (i = 0; i < MB_LANES; i++) {
+            desc[i].ptr = i < active ? lanes[i].ptr : NULL;
+            desc[i].blocks = i < active ? (int)steps : 0;
+        }
+        meth->kernel(ctx, desc, (active + 3) / 4);
+
+        for (i = 0; i < active; i++) {
+            lanes[i].ptr += steps * SHA_CBLOCK;
+            lanes[i].blocks -= steps;
+        }
+
+        for (i = 0; i < active; ) {
+            MB_LANE *lane = &lanes[i];
+
+            if (lane->blocks != 0) {
+                i++;
+                continue;
+            }
+            if (!lane->padded) {
+                mb_lane_pad(lane, count[lane->msg]);
+                continue;
+            }
+            for (w = 0; w < meth->md_len / 4; w++) {
+                unsigned int h = ctx->h[w][i];
+                unsigned char *out = md[lane->msg] + 4 * w;
+
+                out[0] = (unsigned char)(h >> 24);
+                out[1] = (unsigned char)(h >> 16);
+                out[2] = (unsigned char)(h >> 8);
+                out[3] = (unsigned char)h;
+            }
+            if (next < num)
+                mb_lane_start(meth, ctx, lane, i, data, count, next++);
+            else if (i != --active)
+                mb_lane_move(meth, ctx, lanes, i, active);
+        }
+    }
+    OPENSSL_cleanse(storage, sizeof(storage));
+    OPENSSL_cleanse(lanes, sizeof(lanes));
+}
+
+static void mb_set_state(const MB_METHOD *meth, MB_CTX *ctx,
+                         const unsigned int state[], unsigned int num)
+{
+    unsigned int i, w;
+
+    for (w = 0; w < meth->words; w++)
+        for (i = 0; i < num; i++)
+            ctx->h[w][i] = state[w];
+}
+
+static void mb_get_digest(const MB_METHOD *meth, const MB_CTX *ctx,
+                          unsigned char *const md[], unsigned int num)
+{
+    unsigned int i, w;
+
+    for (i = 0; i < num; i++) {
+        for (w = 0; w < meth->md_len / 4; w++) {
+            unsigned int h = ctx->h[w][i];
+            unsigned char *out = md[i] + 4 * w;
+
+            out[0] = (unsigned char)(h >> 24);
+            out[1] = (unsigned char)(h >> 16);
+            out[2] = (unsigned char)(h >> 8);
+            out[3] = (unsigned char)h;
+        }
+    }
+}
+
+/*
+ * Every PBKDF2 iteration hashes one padded block from the ipad state and
+ * one from the opad state, in each lane.  |u| and |inner| keep their
+ * padding throughout, only the digests at their start change.
+ */
+static void mb_pbkdf2_lanes(const MB_METHOD *meth,
+                            const unsigned int istate[],
+                            const unsigned int ostate[],
+                            unsigned char *const u[],
+                            unsigned char *const t[],
+                            unsigned int num, size_t iter)
+{
+    unsigned char storage[sizeof(MB_CTX) + 32];
+    MB_CTX *ctx = (MB_CTX *)(storage + 32 - ((size_t)storage % 32));
+    unsigned char inner[MB_LANES][SHA_CBLOCK], *in[MB_LANES];
+    HASH_DESC in_desc[MB_LANES], out_desc[MB_LANES];
+    unsigned int i, k, n4x = (num + 3) / 4;
+
+    for (i = 0; i < MB_LANES; i++) {
+        in[i] = inner[i];
+        if (i < num)
+            memcpy(inner[i], u[i], SHA_CBLOCK);
+        in_desc[i].ptr = i < num ? u[i] : NULL;
+        in_desc[i].blocks = i < num;
+        out_desc[i].ptr = i < num ? inner[i] : NULL;
+        out_desc[i].blocks = i < num;
+    }
+    for (; iter > 0; iter--) {
+        mb_set_state(meth, ctx, istate, num);
+        meth->kernel(ctx, in_desc, n4x);
+        mb_get_digest(meth, ctx, in, num);
+        mb_set_state(meth, ctx, ostate, num);
+        meth->kernel(ctx, out_desc, n4x);
+        mb_get_digest(meth, ctx, u, num);
+        for (i = 0; i < num; i++)
+            for (k = 0; k < meth->md_len; k++)
+                t[i][k] ^= u[i][k];
+    }
+    OPENSSL_cleanse(storage, sizeof(storage));
+    OPENSSL_cleanse(inner, sizeof(inner));
+}
+
+static const MB_METHOD sha1_mb_method = {
+    sha1_multi_block, 5, SHA_DIGEST_LENGTH,
+    { 0x67452301U, 0xefcdab89U, 0x98badcfeU, 0x10325476U, 0xc3d2e1f0U }
+};
+
+static const MB_METHOD sha224_mb_method = {
+    sha256_multi_block, 8, SHA224_DIGEST_LENGTH,
+    { 0xc1059ed8U, 0x367cd507U, 0x3070dd17U, 0xf70e5939U,
+      0xffc00b31U, 0x68581511U, 0x64f98fa7U, 0xbefa4fa4U }
+};
+
+static const MB_METHOD sha256_mb_method = {
+    sha256_multi_block, 8, SHA256_DIGEST_LENGTH,
+    { 0x6a09e667U, 0xbb67ae85U, 0x3c6ef372U, 0xa54ff53aU,
+      0x510e527fU, 0x9b05688cU, 0x1f83d9abU, 0x5be0cd19U }
+};
+
+int sha1_digest_batch(const void *const data[], const size_t count[],
+                      unsigned char *const md[], size_t num)
+{
+    mb_digest_batch(&sha1_mb_method, data, count, md, num);
+    return 1;
+}
+
+int sha224_digest_batch(const void *const data[], const size_t count[],
+                        unsigned char *const md[], size_t num)
+{
+    mb_digest_batch(&sha224_mb_method, data, count, md, num);
+    return 1;
+}
+
+int sha256_digest_batch(const void *const data[], const size_t count[],
+                        unsigned char *const md[], size_t num)
+{
+    mb_digest_batch(&sha256_mb_method, data, count, md, num);
+    return 1;
+}
+
+void sha1_pbkdf2_lanes(const unsigned int istate[],
+                       const unsigned int ostate[],
+                       unsigned char *const u[], unsigned char *const t[],
+                       unsigned int num, size_t iter)
+{
+    mb_pbkdf2_lanes(&sha1_mb_method, istate, ostate, u, t, num, iter);
+}
+
+void sha224_pbkdf2_lanes(const unsigned int istate[],
+                         const unsigned int ostate[],
+                         unsigned char *const u[], unsigned char *const t[],
+                         unsigned int num, size_t iter)
+{
+    mb_pbkdf2_lanes(&sha224_mb_method, istate, ostate, u, t, num, iter);
+}
+
+void sha256_pbkdf2_lanes(const unsigned int istate[],
+                         const unsigned int ostate[],
+                         unsigned char *const u[], unsigned char *const t[],
+                         unsigned int num, size_t iter)
+{
+    mb_pbkdf2_lanes(&sha256_mb_method, istate, ostate, u, t, num, iter);
+}
+
+#endif
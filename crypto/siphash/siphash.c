@@ -258,3 +258,17 @@ int SipHash_Final(SIPHASH *ctx, unsigned char *out, size_t outlen)
     U64TO8_LE(out + 8, b);
     return 1;
 }
+
+uint64_t SipHash_hash13(const unsigned char *k, const unsigned char *in,
+                        size_t inlen)
+{
+    SIPHASH ctx;
+    unsigned char out[SIPHASH_MIN_DIGEST_SIZE];
+
+    ctx.hash_size = SIPHASH_MIN_DIGEST_SIZE;
+    SipHash_Init(&ctx, k, 1, 3);
+    SipHash_Update(&ctx, in, inlen);
+    if (!SipHash_Final(&ctx, out, sizeof(out)))
+        return 0;
+    return U8TO64_LE(out);
+}
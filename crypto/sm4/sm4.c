@@ -9,6 +9,8 @@
  * https://www.openssl.org/source/license.html
  */
 
+#include <string.h>
+#include <openssl/crypto.h>
 #include <openssl/e_os2.h>
 #include "crypto/sm4.h"
 
@@ -231,3 +233,120 @@ void SM4_decrypt(const uint8_t *in, uint8_t *out, const SM4_KEY *ks)
     store_u32_be(B1, out + 8);
     store_u32_be(B0, out + 12);
 }
+
+#define SM4_RNDS4(k0, k1, k2, k3, F)                    \
+      do {                                              \
+         SM4_RND4(B0, B1, B2, B3, ks->rk[k0], F);       \
+         SM4_RND4(B1, B0, B2, B3, ks->rk[k1], F);       \
+         SM4_RND4(B2, B0, B1, B3, ks->rk[k2], F);       \
+         SM4_RND4(B3, B0, B1, B2, ks->rk[k3], F);       \
+      } while(0)
+
+#define SM4_RND4(X, Y, Z, W, rk, F)                     \
+      do {                                              \
+         X[0] ^= F(Y[0] ^ Z[0] ^ W[0] ^ rk);            \
+         X[1] ^= F(Y[1] ^ Z[1] ^ W[1] ^ rk);            \
+         X[2] ^= F(Y[2] ^ Z[2] ^ W[2] ^ rk);            \
+         X[3] ^= F(Y[3] ^ Z[3] ^ W[3] ^ rk);            \
+      } while(0)
+
+/*
+ * Encrypts or decrypts the four blocks at |in|, interleaving their rounds so
+ * that the table lookups of one block overlap those of the others.
+ */
+static void SM4_crypt4(const uint8_t *in, uint8_t *out, const SM4_KEY *ks,
+                       int enc)
+{
+    uint32_t B0[4], B1[4], B2[4], B3[4];
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        B0[i] = load_u32_be(in + 16 * i, 0);
+        B1[i] = load_u32_be(in + 16 * i, 1);
+        B2[i] = load_u32_be(in + 16 * i, 2);
+        B3[i] = load_u32_be(in + 16 * i, 3);
+    }
+
+    if (enc) {
+        SM4_RNDS4( 0,  1,  2,  3, SM4_T_slow);
+        SM4_RNDS4( 4,  5,  6,  7, SM4_T);
+        SM4_RNDS4( 8,  9, 10, 11, SM4_T);
+        SM4_RNDS4(12, 13, 14, 15, SM4_T);
+        SM4_RNDS4(16, 17, 18, 19, SM4_T);
+        SM4_RNDS4(20, 21, 22, 23, SM4_T);
+        SM4_RNDS4(24, 25, 26, 27, SM4_T);
+        SM4_RNDS4(28, 29, 30, 31, SM4_T_slow);
+    } else {
+        SM4_RNDS4(31, 30, 29, 28, SM4_T_slow);
+        SM4_RNDS4(27, 26, 25, 24, SM4_T);
+        SM4_RNDS4(23, 22, 21, 20, SM4_T);
+        SM4_RNDS4(19, 18, 17, 16, SM4_T);
+        SM4_RNDS4(15, 14, 13, 12, SM4_T);
+        SM4_RNDS4(11, 10,  9,  8, SM4_T);
+        SM4_RNDS4( 7,  6,  5,  4, SM4_T);
+        SM4_RNDS4( 3,  2,  1,  0, SM4_T_slow);
+    }
+
+    for (i = 0; i < 4; i++) {
+        store_u32_be(B3[i], out + 16 * i);
+        store_u32_be(B2[i], out + 16 * i + 4);
+        store_u32_be(B1[i], out + 16 * i + 8);
+        store_u32_be(B0[i], out + 16 * i + 12);
+    }
+}
+
+void SM4_ctr32_encrypt_blocks(const uint8_t *in, uint8_t *out, size_t blocks,
+                              const SM4_KEY *ks, const uint8_t ivec[16])
+{
+    uint8_t ctr[4 * SM4_BLOCK_SIZE], ks_out[4 * SM4_BLOCK_SIZE];
+    uint32_t c = load_u32_be(ivec, 3);
+    size_t i, n;
+
+    for (i = 0; i < 4; i++)
+        memcpy(ctr + 16 * i, ivec, 12);
+
+    while (blocks > 0) {
+        n = blocks < 4 ? blocks : 4;
+        for (i = 0; i < 4; i++)
+            store_u32_be(c + (uint32_t)i, ctr + 16 * i + 12);
+        if (n == 4)
+            SM4_crypt4(ctr, ks_out, ks, 1);
+        else
+            for (i = 0; i < n; i++)
+                SM4_encrypt(ctr + 16 * i, ks_out + 16 * i, ks);
+        for (i = 0; i < 16 * n; i++)
+            out[i] = in[i] ^ ks_out[i];
+        c += (uint32_t)n;
+        in += 16 * n;
+        out += 16 * n;
+        blocks -= n;
+    }
+    OPENSSL_cleanse(ks_out, sizeof(ks_out));
+}
+
+void SM4_cbc_decrypt_blocks(const uint8_t *in, uint8_t *out, size_t blocks,
+                            const SM4_KEY *ks, uint8_t ivec[16])
+{
+    /* The IV and up to four ciphertext blocks, kept for in-place use */
+    uint8_t c[5 * SM4_BLOCK_SIZE], p[4 * SM4_BLOCK_SIZE];
+    size_t i, n;
+
+    memcpy(c, ivec, 16);
+    while (blocks > 0) {
+        n = blocks < 4 ? blocks : 4;
+        memcpy(c + 16, in, 16 * n);
+        if (n == 4)
+            SM4_crypt4(c + 16, p, ks, 0);
+        else
+            for (i = 0; i < n; i++)
+                SM4_decrypt(c + 16 * (i + 1), p + 16 * i, ks);
+        for (i = 0; i < 16 * n; i++)
+            out[i] = p[i] ^ c[i];
+        memcpy(c, c + 16 * n, 16);
+        in += 16 * n;
+        out += 16 * n;
+        blocks -= n;
+    }
+    memcpy(ivec, c, 16);
+    OPENSSL_cleanse(p, sizeof(p));
+}
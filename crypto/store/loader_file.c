@@ -723,6 +723,170 @@ static const FILE_HANDLER *file_handlers[] = {
     &PrivateKey_handler,
 };
 
+/*
+ * The handler that a PEM name is meant for, or NULL if no handler knows it.
+ * This must agree with the name checks in the handlers themselves.
+ */
+static const FILE_HANDLER *file_handler_for_pem(const char *pem_name)
+{
+    if (strcmp(pem_name, PEM_STRING_X509) == 0
+        || strcmp(pem_name, PEM_STRING_X509_OLD) == 0
+        || strcmp(pem_name, PEM_STRING_X509_TRUSTED) == 0)
+        return &X509Certificate_handler;
+    if (strcmp(pem_name, PEM_STRING_X509_CRL) == 0)
+        return &X509CRL_handler;
+    if (strcmp(pem_name, PEM_STRING_PKCS8) == 0)
+        return &PKCS8Encrypted_handler;
+    if (strcmp(pem_name, PEM_STRING_PUBLIC) == 0)
+        return &PUBKEY_handler;
+    if (strcmp(pem_name, PEM_STRING_PKCS8INF) == 0
+        || pem_check_suffix(pem_name, "PRIVATE KEY") > 0)
+        return &PrivateKey_handler;
+    if (pem_check_suffix(pem_name, "PARAMETERS") > 0)
+        return &params_handler;
+    return NULL;
+}
+
+#define DER_SEQUENCE    (V_ASN1_SEQUENCE | V_ASN1_CONSTRUCTED)
+
+/*
+ * Reads the DER header of the next element in the |*len| bytes at |*p| and
+ * steps past the element.  Only low tag numbers and definite lengths are
+ * understood.  Nothing is allocated and no error is raised, so this is
+ * safe to use on data of any type.
+ */
+static int der_next(const unsigned char **p, size_t *len, int *tag,
+                    const unsigned char **content, size_t *clen)
+{
+    const unsigned char *q = *p;
+    size_t n = *len, l, i;
+
+    if (n < 2 || (q[0] & 0x1f) == 0x1f)
+        return 0;
+    *tag = q[0];
+    l = q[1];
+    q += 2;
+    n -= 2;
+    if (l & 0x80) {
+        i = l & 0x7f;
+        if (i == 0 || i > sizeof(size_t) || i > n)
+            return 0;
+        for (l = 0; i > 0; i--, n--)
+            l = (l << 8) | *q++;
+    }
+    if (l > n)
+        return 0;
+    *content = q;
+    *clen = l;
+    *p = q + l;
+    *len = n - l;
+    return 1;
+}
+
+/*
+ * Guesses the type of a DER blob from its outer structure, to avoid
+ * trying every handler (and every key type) on it.  Returns the handler
+ * to try first, setting |*pem_name| to the PEM name to hand it, or NULL
+ * if the structure isn't recognised.
+ */
+static const FILE_HANDLER *file_sniff_der(const unsigned char *blob,
+                                          size_t len, const char **pem_name)
+{
+    const unsigned char *c, *tbs = NULL;
+    size_t clen, tbslen = 0;
+    int tag[3] = { 0, 0, 0 };
+    int n, t;
+
+    *pem_name = NULL;
+    if (!der_next(&blob, &len, &t, &c, &clen) || t != DER_SEQUENCE)
+        return NULL;
+    for (n = 0; clen > 0; n++) {
+        const unsigned char *e;
+        size_t elen;
+
+        if (!der_next(&c, &clen, &t, &e, &elen))
+            return NULL;
+        if (n < 3)
+            tag[n] = t;
+        if (n == 0) {
+            tbs = e;
+            tbslen = elen;
+        }
+    }
+
+    /* SubjectPublicKeyInfo */
+    if (n == 2 && tag[0] == DER_SEQUENCE && tag[1] == V_ASN1_BIT_STRING)
+        return &PUBKEY_handler;
+    /* EncryptedPrivateKeyInfo */
+    if (n == 2 && tag[0] == DER_SEQUENCE
+        && tag[1] == V_ASN1_OCTET_STRING)
+        return &PKCS8Encrypted_handler;
+    if (n >= 3 && tag[0] == V_ASN1_INTEGER && tag[1] == DER_SEQUENCE) {
+        /* PrivateKeyInfo */
+        if (tag[2] == V_ASN1_OCTET_STRING) {
+            *pem_name = PEM_STRING_PKCS8INF;
+            return &PrivateKey_handler;
+        }
+        /* PFX, with MacData */
+        if (n == 3 && tag[2] == DER_SEQUENCE)
+            return &PKCS12_handler;
+    }
+    /* PFX without MacData */
+    if (n == 2 && tag[0] == V_ASN1_INTEGER && tag[1] == DER_SEQUENCE)
+        return &PKCS12_handler;
+
+    /*
+     * A signed Certificate or CertificateList.  Past the optional version
+     * and the serial number, both have the signature algorithm and the
+     * issuer, followed by the Validity sequence for a certificate and by
+     * the thisUpdate time for a CRL.
+     */
+    if (n == 3 && tag[0] == DER_SEQUENCE
+        && tag[1] == DER_SEQUENCE && tag[2] == V_ASN1_BIT_STRING) {
+        do {
+            if (!der_next(&tbs, &tbslen, &t, &c, &clen))
+                return NULL;
+        } while (t == (V_ASN1_CONTEXT_SPECIFIC | V_ASN1_CONSTRUCTED)
+                 || t == V_ASN1_INTEGER);
+        if (t != DER_SEQUENCE
+            || !der_next(&tbs, &tbslen, &t, &c, &clen)
+            || t != DER_SEQUENCE
+            || !der_next(&tbs, &tbslen, &t, &c, &clen))
+            return NULL;
+        if (t == DER_SEQUENCE)
+            return &X509Certificate_handler;
+        if (t == V_ASN1_UTCTIME || t == V_ASN1_GENERALIZEDTIME)
+            return &X509CRL_handler;
+    }
+
+    return NULL;
+}
+
+/*
+ * Calls |handler|, dropping the errors it raised if the data turned out not
+ * to be for it.
+ */
+static OSSL_STORE_INFO *file_try_handler(const FILE_HANDLER *handler,
+                                         const char *pem_name,
+                                         const char *pem_header,
+                                         const unsigned char *data,
+                                         size_t len, void **handler_ctx,
+                                         int *matchcount,
+                                         const UI_METHOD *ui_method,
+                                         void *ui_data)
+{
+    OSSL_STORE_INFO *result;
+
+    ERR_set_mark();
+    result = handler->try_decode(pem_name, pem_header, data, len,
+                                 handler_ctx, matchcount, ui_method, ui_data);
+    if (*matchcount == 0)
+        ERR_pop_to_mark();
+    else
+        ERR_clear_last_mark();
+    return result;
+}
+
 
 /*-
  *  The loader itself
@@ -1030,6 +1194,8 @@ static OSSL_STORE_INFO *file_load_try_decode(OSSL_STORE_LOADER_CTX *ctx,
     {
         size_t i = 0;
         void *handler_ctx = NULL;
+        const FILE_HANDLER *handler = NULL;
+        const char *sniffed_pem_name = NULL;
         const FILE_HANDLER **matching_handlers =
             OPENSSL_zalloc(sizeof(*matching_handlers)
                            * OSSL_NELEM(file_handlers));
@@ -1041,14 +1207,37 @@ static OSSL_STORE_INFO *file_load_try_decode(OSSL_STORE_LOADER_CTX *ctx,
         }
 
         *matchcount = 0;
-        for (i = 0; i < OSSL_NELEM(file_handlers); i++) {
-            const FILE_HANDLER *handler = file_handlers[i];
+
+        /*
+         * Go straight to the handler that the PEM name or the DER structure
+         * points at.  Only if that doesn't match are all handlers tried.
+         */
+        if (pem_name != NULL) {
+            handler = file_handler_for_pem(pem_name);
+            sniffed_pem_name = pem_name;
+        } else {
+            handler = file_sniff_der(data, len, &sniffed_pem_name);
+        }
+        if (handler != NULL) {
+            result = file_try_handler(handler, sniffed_pem_name, pem_header,
+                                      data, len, &handler_ctx, matchcount,
+                                      ui_method, ui_data);
+            if (*matchcount > 0) {
+                matching_handlers[0] = handler;
+                i = OSSL_NELEM(file_handlers);
+            }
+        }
+
+        for (; i < OSSL_NELEM(file_handlers); i++) {
             int try_matchcount = 0;
             void *tmp_handler_ctx = NULL;
-            OSSL_STORE_INFO *tmp_result =
-                handler->try_decode(pem_name, pem_header, data, len,
-                                    &tmp_handler_ctx, &try_matchcount,
-                                    ui_method, ui_data);
+            OSSL_STORE_INFO *tmp_result;
+
+            handler = file_handlers[i];
+            tmp_result =
+                file_try_handler(handler, pem_name, pem_header, data, len,
+                                 &tmp_handler_ctx, &try_matchcount,
+                                 ui_method, ui_data);
 
             if (try_matchcount > 0) {
 
@@ -62,6 +62,14 @@ void CRYPTO_THREAD_lock_free(CRYPTO_RWLOCK *lock) {
     return;
 }
 
+# ifndef OPENSSL_NO_LOCK_STATS
+/* Lock statistics are only collected with pthreads */
+int CRYPTO_THREAD_lock_stats(BIO *bio, int top)
+{
+    return 0;
+}
+# endif
+
 int CRYPTO_THREAD_run_once(CRYPTO_ONCE *once, void (*init)(void))
 {
     if (*once != 0)
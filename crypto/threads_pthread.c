@@ -7,6 +7,11 @@
  * https://www.openssl.org/source/license.html
  */
 
+#include <openssl/opensslconf.h>
+#if !defined(OPENSSL_NO_LOCK_STATS) && !defined(_GNU_SOURCE)
+# define _GNU_SOURCE            /* for dladdr(), naming lock creation sites */
+#endif
+
 #include <openssl/crypto.h>
 #include "internal/cryptlib.h"
 
@@ -17,16 +22,417 @@
 #  include <unistd.h>
 #endif
 
-# ifdef PTHREAD_RWLOCK_INITIALIZER
+# if !defined(OPENSSL_NO_BRLOCK) && defined(OPENSSL_NO_LOCK_STATS) \
+     && defined(__GNUC__) && defined(__ATOMIC_SEQ_CST) \
+     && __GCC_ATOMIC_INT_LOCK_FREE > 0
+#  define USE_BRLOCK
+# elif defined(PTHREAD_RWLOCK_INITIALIZER)
 #  define USE_RWLOCK
 # endif
 
+# ifdef USE_BRLOCK
+#  include <limits.h>
+#  include <sched.h>
+#  ifdef __linux__
+#   include <linux/futex.h>
+#   include <sys/syscall.h>
+#  endif
+
+/*
+ * A "big reader" lock.  Each reader only counts itself in the slot picked
+ * by its thread, so read locking from many threads doesn't bounce a single
+ * cache line between them.  A writer raises |writer| and then checks that
+ * every slot is empty, a reader counts itself and then checks |writer|;
+ * with sequentially consistent accesses at least one of them sees the
+ * other and backs off.  A writer that keeps finding readers drops |writer|
+ * again after a while and waits for them, so that a thread that takes the
+ * read lock recursively cannot deadlock against it, as with the reader
+ * preferring pthread rwlocks.
+ */
+#  define BRLOCK_SLOTS          8       /* a power of two */
+#  define BRLOCK_CACHELINE      64
+#  define BRLOCK_SPINS          128
+
+typedef struct {
+    int readers;
+    char pad[BRLOCK_CACHELINE - sizeof(int)];
+} BRLOCK_SLOT;
+
+typedef struct {
+    BRLOCK_SLOT slot[BRLOCK_SLOTS];
+    int writer;                 /* a writer holds or is taking the lock */
+    int owned;                  /* the writer holds the lock */
+    int waiters;                /* readers sleeping on |writer| */
+    int draining;               /* the writer sleeps on a slot */
+    pthread_t owner;
+    pthread_mutex_t wlock;      /* serialises the writers */
+    void *mem;                  /* the allocation, before alignment */
+} BRLOCK;
+
+static ossl_inline void brlock_pause(void)
+{
+#  if defined(__x86_64__) || defined(__i386__)
+    __asm__ __volatile__("pause");
+#  endif
+}
+
+/* Waits until |*addr| is likely to have changed from |val| */
+static void brlock_wait(int *addr, int val)
+{
+    int i;
+
+    for (i = 0; i < BRLOCK_SPINS; i++) {
+        if (__atomic_load_n(addr, __ATOMIC_SEQ_CST) != val)
+            return;
+        brlock_pause();
+    }
+#  ifdef __linux__
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+#  else
+    sched_yield();
+#  endif
+}
+
+static void brlock_wake(int *addr)
+{
+#  ifdef __linux__
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#  endif
+}
+
+static int *brlock_readers(BRLOCK *l)
+{
+    pthread_t self = pthread_self();
+    unsigned long long h = 0;
+
+    memcpy(&h, &self, sizeof(self) < sizeof(h) ? sizeof(self) : sizeof(h));
+    /* thread ids tend to differ only in their middle bits */
+    h *= 0x9e3779b97f4a7c15ULL;
+    return &l->slot[(h >> 32) & (BRLOCK_SLOTS - 1)].readers;
+}
+
+static void brlock_read_release(BRLOCK *l, int *readers)
+{
+    if (__atomic_sub_fetch(readers, 1, __ATOMIC_SEQ_CST) == 0
+            && __atomic_load_n(&l->draining, __ATOMIC_SEQ_CST) != 0)
+        brlock_wake(readers);
+}
+
+static void brlock_write_release(BRLOCK *l)
+{
+    __atomic_store_n(&l->writer, 0, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&l->waiters, __ATOMIC_SEQ_CST) != 0)
+        brlock_wake(&l->writer);
+}
+
+/* Returns a slot that still has readers in it, or NULL */
+static int *brlock_busy_slot(BRLOCK *l)
+{
+    int i;
+
+    for (i = 0; i < BRLOCK_SLOTS; i++)
+        if (__atomic_load_n(&l->slot[i].readers, __ATOMIC_SEQ_CST) != 0)
+            return &l->slot[i].readers;
+    return NULL;
+}
+
+CRYPTO_RWLOCK *CRYPTO_THREAD_lock_new(void)
+{
+    void *mem;
+    BRLOCK *l;
+
+    /* Don't set errors, to avoid recursion blowup. */
+    if ((mem = OPENSSL_zalloc(sizeof(*l) + BRLOCK_CACHELINE)) == NULL)
+        return NULL;
+    l = (BRLOCK *)((char *)mem + BRLOCK_CACHELINE
+                   - ((size_t)mem & (BRLOCK_CACHELINE - 1)));
+    l->mem = mem;
+    if (pthread_mutex_init(&l->wlock, NULL) != 0) {
+        OPENSSL_free(mem);
+        return NULL;
+    }
+    return l;
+}
+
+int CRYPTO_THREAD_read_lock(CRYPTO_RWLOCK *lock)
+{
+    BRLOCK *l = lock;
+    int *readers = brlock_readers(l);
+
+    for (;;) {
+        __atomic_add_fetch(readers, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&l->writer, __ATOMIC_SEQ_CST) == 0)
+            return 1;
+        brlock_read_release(l, readers);
+
+        __atomic_add_fetch(&l->waiters, 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&l->writer, __ATOMIC_SEQ_CST) != 0)
+            brlock_wait(&l->writer, 1);
+        __atomic_sub_fetch(&l->waiters, 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+int CRYPTO_THREAD_write_lock(CRYPTO_RWLOCK *lock)
+{
+    BRLOCK *l = lock;
+    int *readers, i, n;
+
+    if (pthread_mutex_lock(&l->wlock) != 0)
+        return 0;
+
+    for (;;) {
+        __atomic_store_n(&l->writer, 1, __ATOMIC_SEQ_CST);
+        /* new readers are held off while the ones inside finish */
+        for (i = 0; i < BRLOCK_SPINS; i++) {
+            if ((readers = brlock_busy_slot(l)) == NULL)
+                break;
+            brlock_pause();
+        }
+        if (readers == NULL)
+            break;
+
+        /* let them all in, recursive ones included, and sleep on a slot */
+        brlock_write_release(l);
+        __atomic_store_n(&l->draining, 1, __ATOMIC_SEQ_CST);
+        if ((n = __atomic_load_n(readers, __ATOMIC_SEQ_CST)) != 0)
+            brlock_wait(readers, n);
+        __atomic_store_n(&l->draining, 0, __ATOMIC_SEQ_CST);
+    }
+
+    l->owner = pthread_self();
+    __atomic_store_n(&l->owned, 1, __ATOMIC_SEQ_CST);
+    return 1;
+}
+
+int CRYPTO_THREAD_unlock(CRYPTO_RWLOCK *lock)
+{
+    BRLOCK *l = lock;
+
+    /* a reader can't be unlocking while the writer owns the lock */
+    if (__atomic_load_n(&l->owned, __ATOMIC_SEQ_CST)
+            && pthread_equal(l->owner, pthread_self())) {
+        __atomic_store_n(&l->owned, 0, __ATOMIC_SEQ_CST);
+        brlock_write_release(l);
+        if (pthread_mutex_unlock(&l->wlock) != 0)
+            return 0;
+        return 1;
+    }
+
+    brlock_read_release(l, brlock_readers(l));
+    return 1;
+}
+
+void CRYPTO_THREAD_lock_free(CRYPTO_RWLOCK *lock)
+{
+    BRLOCK *l = lock;
+
+    if (l == NULL)
+        return;
+
+    pthread_mutex_destroy(&l->wlock);
+    OPENSSL_free(l->mem);
+}
+
+# else
+
+#  ifdef USE_RWLOCK
+typedef pthread_rwlock_t PTHREAD_LOCK;
+#  else
+typedef pthread_mutex_t PTHREAD_LOCK;
+#  endif
+
+#  ifndef OPENSSL_NO_LOCK_STATS
+#   include <errno.h>
+#   include <time.h>
+#   include <openssl/bio.h>
+#   include "crypto/dso_conf.h"
+#   if defined(DSO_DLFCN) && defined(HAVE_DLFCN_H)
+#    include <dlfcn.h>
+#    define LOCK_STATS_DLADDR
+#   endif
+
+/*
+ * Lock statistics, kept per creation site, i.e. per caller of
+ * CRYPTO_THREAD_lock_new(), so that short-lived locks such as those of keys
+ * and connections add up.  The table is protected by a plain pthread mutex,
+ * which is never a CRYPTO_RWLOCK itself.  Sites that don't fit aren't
+ * tracked.
+ */
+#   define LOCK_STATS_SITES     1024
+
+#   if defined(__GNUC__) && defined(__ATOMIC_RELAXED)
+#    define lock_stat_add(p, n) __atomic_fetch_add((p), (n), __ATOMIC_RELAXED)
+#    define lock_stat_get(p)    __atomic_load_n((p), __ATOMIC_RELAXED)
+#    define LOCK_CALLER         __builtin_return_address(0)
+#   else
+#    define lock_stat_add(p, n) (*(p) += (n))
+#    define lock_stat_get(p)    (*(p))
+#    define LOCK_CALLER         NULL
+#   endif
+
+typedef struct {
+    const void *site;
+    uint64_t locks;             /* locks created here */
+    uint64_t acquired;
+    uint64_t contended;         /* acquisitions that had to wait */
+    uint64_t wait_ns;           /* total time spent waiting */
+} LOCK_SITE;
+
+/* The pthread lock comes first, so that it's also the CRYPTO_RWLOCK */
+typedef struct {
+    PTHREAD_LOCK lock;
+    LOCK_SITE *site;
+} STATS_LOCK;
+
+#   define PTHREAD_LOCK_SIZE    sizeof(STATS_LOCK)
+
+static LOCK_SITE lock_sites[LOCK_STATS_SITES];
+static pthread_mutex_t lock_sites_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static LOCK_SITE *lock_stats_site(const void *site)
+{
+    size_t i, h = ((size_t)site >> 2) % LOCK_STATS_SITES;
+    LOCK_SITE *ret = NULL;
+
+    if (pthread_mutex_lock(&lock_sites_mutex) != 0)
+        return NULL;
+    for (i = 0; i < LOCK_STATS_SITES; i++, h = (h + 1) % LOCK_STATS_SITES) {
+        if (lock_sites[h].locks == 0)
+            lock_sites[h].site = site;
+        if (lock_sites[h].site == site) {
+            ret = &lock_sites[h];
+            ret->locks++;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&lock_sites_mutex);
+    return ret;
+}
+
+static uint64_t lock_stats_now(void)
+{
+#   ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+        return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#   endif
+    return (uint64_t)time(NULL) * 1000000000;
+}
+
+static int lock_stats_acquire(CRYPTO_RWLOCK *lock, int write)
+{
+    STATS_LOCK *l = lock;
+    uint64_t start;
+    int busy;
+
+#   ifdef USE_RWLOCK
+    busy = write ? pthread_rwlock_trywrlock(&l->lock)
+                 : pthread_rwlock_tryrdlock(&l->lock);
+#   else
+    busy = pthread_mutex_trylock(&l->lock);
+#   endif
+    if (busy == 0) {
+        if (l->site != NULL)
+            lock_stat_add(&l->site->acquired, 1);
+        return 1;
+    }
+
+    start = lock_stats_now();
+#   ifdef USE_RWLOCK
+    busy = write ? pthread_rwlock_wrlock(&l->lock)
+                 : pthread_rwlock_rdlock(&l->lock);
+#   else
+    busy = pthread_mutex_lock(&l->lock);
+#   endif
+    if (busy != 0)
+        return 0;
+    if (l->site != NULL) {
+        lock_stat_add(&l->site->acquired, 1);
+        lock_stat_add(&l->site->contended, 1);
+        lock_stat_add(&l->site->wait_ns, lock_stats_now() - start);
+    }
+    return 1;
+}
+
+static int lock_stats_cmp(const void *a, const void *b)
+{
+    const LOCK_SITE *sa = a, *sb = b;
+
+    if (sa->wait_ns != sb->wait_ns)
+        return sa->wait_ns < sb->wait_ns ? 1 : -1;
+    if (sa->contended != sb->contended)
+        return sa->contended < sb->contended ? 1 : -1;
+    return sa->acquired < sb->acquired ? 1 : sa->acquired > sb->acquired ? -1 : 0;
+}
+
+/* Prints |site| as an offset into its module, which addr2line can decode */
+static void lock_stats_print_site(BIO *bio, const void *site)
+{
+#   ifdef LOCK_STATS_DLADDR
+    Dl_info info;
+
+    if (site != NULL && dladdr((void *)site, &info) != 0
+            && info.dli_fname != NULL) {
+        BIO_printf(bio, "%s+0x%lx\n", info.dli_fname,
+                   (unsigned long)((const char *)site
+                                   - (const char *)info.dli_fbase));
+        return;
+    }
+#   endif
+    BIO_printf(bio, "%p\n", site);
+}
+
+int CRYPTO_THREAD_lock_stats(BIO *bio, int top)
+{
+    LOCK_SITE *sites;
+    size_t i, n = 0;
+
+    if ((sites = OPENSSL_malloc(sizeof(lock_sites))) == NULL)
+        return 0;
+    if (pthread_mutex_lock(&lock_sites_mutex) != 0) {
+        OPENSSL_free(sites);
+        return 0;
+    }
+    for (i = 0; i < LOCK_STATS_SITES; i++) {
+        if (lock_sites[i].locks == 0)
+            continue;
+        sites[n].site = lock_sites[i].site;
+        sites[n].locks = lock_sites[i].locks;
+        sites[n].acquired = lock_stat_get(&lock_sites[i].acquired);
+        sites[n].contended = lock_stat_get(&lock_sites[i].contended);
+        sites[n].wait_ns = lock_stat_get(&lock_sites[i].wait_ns);
+        if (sites[n].acquired != 0)
+            n++;
+    }
+    pthread_mutex_unlock(&lock_sites_mutex);
+
+    qsort(sites, n, sizeof(*sites), lock_stats_cmp);
+    if (top > 0 && (size_t)top < n)
+        n = top;
+    BIO_printf(bio, "%8s %14s %12s %14s  %s\n", "locks", "acquired",
+               "contended", "waited (us)", "created at");
+    for (i = 0; i < n; i++) {
+        BIO_printf(bio, "%8llu %14llu %12llu %14llu  ",
+                   (unsigned long long)sites[i].locks,
+                   (unsigned long long)sites[i].acquired,
+                   (unsigned long long)sites[i].contended,
+                   (unsigned long long)(sites[i].wait_ns / 1000));
+        lock_stats_print_site(bio, sites[i].site);
+    }
+    OPENSSL_free(sites);
+    return 1;
+}
+#  else
+#   define PTHREAD_LOCK_SIZE    sizeof(PTHREAD_LOCK)
+#  endif
+
 CRYPTO_RWLOCK *CRYPTO_THREAD_lock_new(void)
 {
 # ifdef USE_RWLOCK
     CRYPTO_RWLOCK *lock;
 
-    if ((lock = OPENSSL_zalloc(sizeof(pthread_rwlock_t))) == NULL) {
+    if ((lock = OPENSSL_zalloc(PTHREAD_LOCK_SIZE)) == NULL) {
         /* Don't set error, to avoid recursion blowup. */
         return NULL;
     }
@@ -39,7 +445,7 @@ CRYPTO_RWLOCK *CRYPTO_THREAD_lock_new(void)
     pthread_mutexattr_t attr;
     CRYPTO_RWLOCK *lock;
 
-    if ((lock = OPENSSL_zalloc(sizeof(pthread_mutex_t))) == NULL) {
+    if ((lock = OPENSSL_zalloc(PTHREAD_LOCK_SIZE)) == NULL) {
         /* Don't set error, to avoid recursion blowup. */
         return NULL;
     }
@@ -55,13 +461,18 @@ CRYPTO_RWLOCK *CRYPTO_THREAD_lock_new(void)
 
     pthread_mutexattr_destroy(&attr);
 # endif
+# ifndef OPENSSL_NO_LOCK_STATS
+    ((STATS_LOCK *)lock)->site = lock_stats_site(LOCK_CALLER);
+# endif
 
     return lock;
 }
 
 int CRYPTO_THREAD_read_lock(CRYPTO_RWLOCK *lock)
 {
-# ifdef USE_RWLOCK
+# ifndef OPENSSL_NO_LOCK_STATS
+    return lock_stats_acquire(lock, 0);
+# elif defined(USE_RWLOCK)
     if (pthread_rwlock_rdlock(lock) != 0)
         return 0;
 # else
@@ -74,7 +485,9 @@ int CRYPTO_THREAD_read_lock(CRYPTO_RWLOCK *lock)
 
 int CRYPTO_THREAD_write_lock(CRYPTO_RWLOCK *lock)
 {
-# ifdef USE_RWLOCK
+# ifndef OPENSSL_NO_LOCK_STATS
+    return lock_stats_acquire(lock, 1);
+# elif defined(USE_RWLOCK)
     if (pthread_rwlock_wrlock(lock) != 0)
         return 0;
 # else
@@ -113,6 +526,8 @@ void CRYPTO_THREAD_lock_free(CRYPTO_RWLOCK *lock)
     return;
 }
 
+# endif
+
 int CRYPTO_THREAD_run_once(CRYPTO_ONCE *once, void (*init)(void))
 {
     if (pthread_once(once, init) != 0)
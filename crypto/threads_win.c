@@ -66,6 +66,14 @@ void CRYPTO_THREAD_lock_free(CRYPTO_RWLOCK *lock)
     return;
 }
 
+# ifndef OPENSSL_NO_LOCK_STATS
+/* Lock statistics are only collected with pthreads */
+int CRYPTO_THREAD_lock_stats(BIO *bio, int top)
+{
+    return 0;
+}
+# endif
+
 #  define ONCE_UNINITED     0
 #  define ONCE_ININIT       1
 #  define ONCE_DONE         2
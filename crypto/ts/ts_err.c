@@ -63,6 +63,8 @@ static const ERR_STRING_DATA TS_str_functs[] = {
      "TS_REQ_set_policy_id"},
     {ERR_PACK(ERR_LIB_TS, TS_F_TS_RESP_CREATE_RESPONSE, 0),
      "TS_RESP_create_response"},
+    {ERR_PACK(ERR_LIB_TS, TS_F_TS_RESP_CREATE_RESPONSE_BATCH, 0),
+     "TS_RESP_create_response_batch"},
     {ERR_PACK(ERR_LIB_TS, TS_F_TS_RESP_CREATE_TST_INFO, 0),
      "ts_RESP_create_tst_info"},
     {ERR_PACK(ERR_LIB_TS, TS_F_TS_RESP_CTX_ADD_FAILURE_INFO, 0),
@@ -77,6 +79,8 @@ static const ERR_STRING_DATA TS_str_functs[] = {
      "TS_RESP_CTX_set_certs"},
     {ERR_PACK(ERR_LIB_TS, TS_F_TS_RESP_CTX_SET_DEF_POLICY, 0),
      "TS_RESP_CTX_set_def_policy"},
+    {ERR_PACK(ERR_LIB_TS, TS_F_TS_RESP_CTX_SET_NUM_THREADS, 0),
+     "TS_RESP_CTX_set_num_threads"},
     {ERR_PACK(ERR_LIB_TS, TS_F_TS_RESP_CTX_SET_SIGNER_CERT, 0),
      "TS_RESP_CTX_set_signer_cert"},
     {ERR_PACK(ERR_LIB_TS, TS_F_TS_RESP_CTX_SET_STATUS_INFO, 0),
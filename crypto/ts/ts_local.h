@@ -181,6 +181,14 @@ struct TS_resp_ctx {
     void *time_cb_data;         /* User data for time_cb. */
     TS_extension_cb extension_cb;
     void *extension_cb_data;    /* User data for extension_cb. */
+    int num_threads;            /* Threads a batch of responses is signed on. */
+    /*
+     * Signer state that is the same for every response, set by the first
+     * response signed and dropped when the signer or its certificates change.
+     */
+    int signer_checked;         /* The key matches the certificate. */
+    int ess_attr_nid;           /* ESS signing certificate attribute, */
+    ASN1_STRING *ess_attr;      /* and its encoding. */
     /* These members are used only while creating the response. */
     TS_REQ *request;
     TS_RESP *response;
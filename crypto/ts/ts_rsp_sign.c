@@ -14,8 +14,17 @@
 #include <openssl/ts.h>
 #include <openssl/pkcs7.h>
 #include <openssl/crypto.h>
+#include "crypto/evp.h"
 #include "ts_local.h"
 
+/* A response of a batch, ready to be signed on any thread. */
+typedef struct {
+    PKCS7 *p7;
+    BIO *p7bio;                 /* The TSTInfo is already written to it. */
+    TS_TST_INFO *tst_info;
+    int signed_ok;
+} TS_RESP_SIGN_JOB;
+
 static ASN1_INTEGER *def_serial_cb(struct TS_resp_ctx *, void *);
 static int def_time_cb(struct TS_resp_ctx *, void *, long *sec, long *usec);
 static int def_extension_cb(struct TS_resp_ctx *, X509_EXTENSION *, void *);
@@ -27,6 +36,8 @@ static ASN1_OBJECT *ts_RESP_get_policy(TS_RESP_CTX *ctx);
 static TS_TST_INFO *ts_RESP_create_tst_info(TS_RESP_CTX *ctx,
                                             ASN1_OBJECT *policy);
 static int ts_RESP_process_extensions(TS_RESP_CTX *ctx);
+static PKCS7 *ts_RESP_sign_init(TS_RESP_CTX *ctx, BIO **p7bio);
+static int ts_RESP_sign_final(TS_RESP_CTX *ctx, PKCS7 *p7, BIO *p7bio);
 static int ts_RESP_sign(TS_RESP_CTX *ctx);
 
 static ESS_SIGNING_CERT *ess_SIGNING_CERT_new_init(X509 *signcert,
@@ -129,6 +140,7 @@ TS_RESP_CTX *TS_RESP_CTX_new(void)
     }
 
     ctx->signer_md = EVP_sha256();
+    ctx->num_threads = 1;
 
     ctx->serial_cb = def_serial_cb;
     ctx->time_cb = def_time_cb;
@@ -151,9 +163,18 @@ void TS_RESP_CTX_free(TS_RESP_CTX *ctx)
     ASN1_INTEGER_free(ctx->seconds);
     ASN1_INTEGER_free(ctx->millis);
     ASN1_INTEGER_free(ctx->micros);
+    ASN1_STRING_free(ctx->ess_attr);
     OPENSSL_free(ctx);
 }
 
+/* Drops the signer state computed by the first response signed. */
+static void ts_RESP_CTX_reset_signer(TS_RESP_CTX *ctx)
+{
+    ctx->signer_checked = 0;
+    ASN1_STRING_free(ctx->ess_attr);
+    ctx->ess_attr = NULL;
+}
+
 int TS_RESP_CTX_set_signer_cert(TS_RESP_CTX *ctx, X509 *signer)
 {
     if (X509_check_purpose(signer, X509_PURPOSE_TIMESTAMP_SIGN, 0) != 1) {
@@ -164,6 +185,7 @@ int TS_RESP_CTX_set_signer_cert(TS_RESP_CTX *ctx, X509 *signer)
     X509_free(ctx->signer_cert);
     ctx->signer_cert = signer;
     X509_up_ref(ctx->signer_cert);
+    ts_RESP_CTX_reset_signer(ctx);
     return 1;
 }
 
@@ -172,6 +194,7 @@ int TS_RESP_CTX_set_signer_key(TS_RESP_CTX *ctx, EVP_PKEY *key)
     EVP_PKEY_free(ctx->signer_key);
     ctx->signer_key = key;
     EVP_PKEY_up_ref(ctx->signer_key);
+    ts_RESP_CTX_reset_signer(ctx);
 
     return 1;
 }
@@ -198,6 +221,7 @@ int TS_RESP_CTX_set_certs(TS_RESP_CTX *ctx, STACK_OF(X509) *certs)
 
     sk_X509_pop_free(ctx->certs, X509_free);
     ctx->certs = NULL;
+    ts_RESP_CTX_reset_signer(ctx);
     if (!certs)
         return 1;
     if ((ctx->certs = X509_chain_up_ref(certs)) == NULL) {
@@ -277,6 +301,7 @@ int TS_RESP_CTX_set_accuracy(TS_RESP_CTX *ctx,
 void TS_RESP_CTX_add_flags(TS_RESP_CTX *ctx, int flags)
 {
     ctx->flags |= flags;
+    ts_RESP_CTX_reset_signer(ctx);
 }
 
 void TS_RESP_CTX_set_serial_cb(TS_RESP_CTX *ctx, TS_serial_cb cb, void *data)
@@ -377,7 +402,13 @@ int TS_RESP_CTX_set_clock_precision_digits(TS_RESP_CTX *ctx,
 }
 
 /* Main entry method of the response generation. */
-TS_RESP *TS_RESP_create_response(TS_RESP_CTX *ctx, BIO *req_bio)
+/*
+ * Creates the response to the request read from |req_bio|.  If |job| is not
+ * NULL and the request is granted, the response is left unsigned: its token
+ * and TSTInfo are handed over to |job|, ready for ts_RESP_sign_final().
+ */
+static TS_RESP *ts_RESP_create_response(TS_RESP_CTX *ctx, BIO *req_bio,
+                                        TS_RESP_SIGN_JOB *job)
 {
     ASN1_OBJECT *policy;
     TS_RESP *response;
@@ -405,8 +436,14 @@ TS_RESP *TS_RESP_create_response(TS_RESP_CTX *ctx, BIO *req_bio)
         goto end;
     if (!ts_RESP_process_extensions(ctx))
         goto end;
-    if (!ts_RESP_sign(ctx))
+    if (job != NULL) {
+        if ((job->p7 = ts_RESP_sign_init(ctx, &job->p7bio)) == NULL)
+            goto end;
+        job->tst_info = ctx->tst_info;
+        ctx->tst_info = NULL;   /* Ownership is passed to the job. */
+    } else if (!ts_RESP_sign(ctx)) {
         goto end;
+    }
     result = 1;
 
  end:
@@ -428,6 +465,74 @@ TS_RESP *TS_RESP_create_response(TS_RESP_CTX *ctx, BIO *req_bio)
     return response;
 }
 
+TS_RESP *TS_RESP_create_response(TS_RESP_CTX *ctx, BIO *req_bio)
+{
+    return ts_RESP_create_response(ctx, req_bio, NULL);
+}
+
+static void ts_RESP_sign_jobs(void *arg, size_t off, size_t len)
+{
+    TS_RESP_SIGN_JOB *job = (TS_RESP_SIGN_JOB *)arg + off;
+
+    for (; len > 0; --len, ++job)
+        if (job->p7 != NULL)
+            job->signed_ok = PKCS7_dataFinal(job->p7, job->p7bio);
+}
+
+int TS_RESP_create_response_batch(TS_RESP_CTX *ctx, BIO *req_bios[],
+                                  TS_RESP *responses[], size_t num)
+{
+    TS_RESP_SIGN_JOB *jobs;
+    int pieces = ctx->num_threads;
+    int ret = 1;
+    size_t i;
+
+    if (num == 0)
+        return 1;
+    if ((jobs = OPENSSL_zalloc(num * sizeof(*jobs))) == NULL) {
+        TSerr(TS_F_TS_RESP_CREATE_RESPONSE_BATCH, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+
+    /* The callbacks of |ctx| are run on this thread, one request at a time */
+    for (i = 0; i < num; ++i)
+        responses[i] = ts_RESP_create_response(ctx, req_bios[i], &jobs[i]);
+
+    if ((size_t)pieces > num)
+        pieces = (int)num;
+    evp_parallel_run(pieces, num, ts_RESP_sign_jobs, jobs);
+
+    for (i = 0; i < num; ++i) {
+        TS_RESP_SIGN_JOB *job = &jobs[i];
+
+        if (job->p7 != NULL) {
+            if (job->signed_ok) {
+                TS_RESP_set_tst_info(responses[i], job->p7, job->tst_info);
+                job->p7 = NULL;         /* Ownership is lost. */
+                job->tst_info = NULL;   /* Ownership is lost. */
+            } else {
+                TSerr(TS_F_TS_RESP_CREATE_RESPONSE_BATCH, TS_R_TS_DATASIGN);
+                ctx->response = responses[i];
+                if (TS_RESP_CTX_set_status_info_cond(ctx, TS_STATUS_REJECTION,
+                                                     "Error during signature "
+                                                     "generation.") == 0) {
+                    TS_RESP_free(responses[i]);
+                    responses[i] = NULL;
+                }
+                ctx->response = NULL;
+            }
+            BIO_free_all(job->p7bio);
+            PKCS7_free(job->p7);
+            TS_TST_INFO_free(job->tst_info);
+        }
+        if (responses[i] == NULL)
+            ret = 0;
+    }
+
+    OPENSSL_free(jobs);
+    return ret;
+}
+
 /* Initializes the variable part of the context. */
 static void ts_RESP_CTX_init(TS_RESP_CTX *ctx)
 {
@@ -631,7 +736,12 @@ static int ts_RESP_process_extensions(TS_RESP_CTX *ctx)
 }
 
 /* Functions for signing the TS_TST_INFO structure of the context. */
-static int ts_RESP_sign(TS_RESP_CTX *ctx)
+/*
+ * Sets up the signed token of the response and writes the TSTInfo to it.
+ * Returns the token and the BIO to finish signing it with, or NULL after
+ * setting the status of the response.
+ */
+static PKCS7 *ts_RESP_sign_init(TS_RESP_CTX *ctx, BIO **p7bio_out)
 {
     int ret = 0;
     PKCS7 *p7 = NULL;
@@ -639,13 +749,19 @@ static int ts_RESP_sign(TS_RESP_CTX *ctx)
     STACK_OF(X509) *certs;      /* Certificates to include in sc. */
     ESS_SIGNING_CERT_V2 *sc2 = NULL;
     ESS_SIGNING_CERT *sc = NULL;
+    ASN1_STRING *ess_attr = NULL;
+    ASN1_TYPE *attr;
     ASN1_OBJECT *oid;
     BIO *p7bio = NULL;
     int i;
 
-    if (!X509_check_private_key(ctx->signer_cert, ctx->signer_key)) {
-        TSerr(TS_F_TS_RESP_SIGN, TS_R_PRIVATE_KEY_DOES_NOT_MATCH_CERTIFICATE);
-        goto err;
+    if (!ctx->signer_checked) {
+        if (!X509_check_private_key(ctx->signer_cert, ctx->signer_key)) {
+            TSerr(TS_F_TS_RESP_SIGN,
+                  TS_R_PRIVATE_KEY_DOES_NOT_MATCH_CERTIFICATE);
+            goto err;
+        }
+        ctx->signer_checked = 1;
     }
 
     if ((p7 = PKCS7_new()) == NULL) {
@@ -680,26 +796,44 @@ static int ts_RESP_sign(TS_RESP_CTX *ctx)
         goto err;
     }
 
-    certs = ctx->flags & TS_ESS_CERT_ID_CHAIN ? ctx->certs : NULL;
-    if (ctx->ess_cert_id_digest == NULL
-        || ctx->ess_cert_id_digest == EVP_sha1()) {
-        if ((sc = ess_SIGNING_CERT_new_init(ctx->signer_cert, certs)) == NULL)
-            goto err;
-
-        if (!ess_add_signing_cert(si, sc)) {
+    /* The signing certificate attribute only depends on the signer. */
+    if (ctx->ess_attr != NULL) {
+        if ((ess_attr = ASN1_STRING_dup(ctx->ess_attr)) == NULL
+            || !PKCS7_add_signed_attribute(si, ctx->ess_attr_nid,
+                                           V_ASN1_SEQUENCE, ess_attr)) {
             TSerr(TS_F_TS_RESP_SIGN, TS_R_ESS_ADD_SIGNING_CERT_ERROR);
             goto err;
         }
+        ess_attr = NULL;        /* Ownership is lost. */
     } else {
-        sc2 = ess_signing_cert_v2_new_init(ctx->ess_cert_id_digest,
-                                           ctx->signer_cert, certs);
-        if (sc2 == NULL)
-            goto err;
-
-        if (!ess_add_signing_cert_v2(si, sc2)) {
-            TSerr(TS_F_TS_RESP_SIGN, TS_R_ESS_ADD_SIGNING_CERT_V2_ERROR);
-            goto err;
+        certs = ctx->flags & TS_ESS_CERT_ID_CHAIN ? ctx->certs : NULL;
+        if (ctx->ess_cert_id_digest == NULL
+            || ctx->ess_cert_id_digest == EVP_sha1()) {
+            if ((sc = ess_SIGNING_CERT_new_init(ctx->signer_cert,
+                                                certs)) == NULL)
+                goto err;
+
+            if (!ess_add_signing_cert(si, sc)) {
+                TSerr(TS_F_TS_RESP_SIGN, TS_R_ESS_ADD_SIGNING_CERT_ERROR);
+                goto err;
+            }
+            ctx->ess_attr_nid = NID_id_smime_aa_signingCertificate;
+        } else {
+            sc2 = ess_signing_cert_v2_new_init(ctx->ess_cert_id_digest,
+                                               ctx->signer_cert, certs);
+            if (sc2 == NULL)
+                goto err;
+
+            if (!ess_add_signing_cert_v2(si, sc2)) {
+                TSerr(TS_F_TS_RESP_SIGN, TS_R_ESS_ADD_SIGNING_CERT_V2_ERROR);
+                goto err;
+            }
+            ctx->ess_attr_nid = NID_id_smime_aa_signingCertificateV2;
         }
+        /* Keep a copy for the next responses, if there is memory for it */
+        attr = PKCS7_get_signed_attribute(si, ctx->ess_attr_nid);
+        if (attr != NULL && attr->type == V_ASN1_SEQUENCE)
+            ctx->ess_attr = ASN1_STRING_dup(attr->value.sequence);
     }
 
     if (!ts_TST_INFO_content_new(p7))
@@ -712,6 +846,29 @@ static int ts_RESP_sign(TS_RESP_CTX *ctx)
         TSerr(TS_F_TS_RESP_SIGN, TS_R_TS_DATASIGN);
         goto err;
     }
+
+    ret = 1;
+ err:
+    ESS_SIGNING_CERT_V2_free(sc2);
+    ESS_SIGNING_CERT_free(sc);
+    ASN1_STRING_free(ess_attr);
+    if (!ret) {
+        TS_RESP_CTX_set_status_info_cond(ctx, TS_STATUS_REJECTION,
+                                         "Error during signature "
+                                         "generation.");
+        BIO_free_all(p7bio);
+        PKCS7_free(p7);
+        return NULL;
+    }
+    *p7bio_out = p7bio;
+    return p7;
+}
+
+/* Signs the token set up by ts_RESP_sign_init() and adds it to the response */
+static int ts_RESP_sign_final(TS_RESP_CTX *ctx, PKCS7 *p7, BIO *p7bio)
+{
+    int ret = 0;
+
     if (!PKCS7_dataFinal(p7, p7bio)) {
         TSerr(TS_F_TS_RESP_SIGN, TS_R_TS_DATASIGN);
         goto err;
@@ -727,12 +884,20 @@ static int ts_RESP_sign(TS_RESP_CTX *ctx)
                                          "Error during signature "
                                          "generation.");
     BIO_free_all(p7bio);
-    ESS_SIGNING_CERT_V2_free(sc2);
-    ESS_SIGNING_CERT_free(sc);
     PKCS7_free(p7);
     return ret;
 }
 
+static int ts_RESP_sign(TS_RESP_CTX *ctx)
+{
+    PKCS7 *p7;
+    BIO *p7bio;
+
+    if ((p7 = ts_RESP_sign_init(ctx, &p7bio)) == NULL)
+        return 0;
+    return ts_RESP_sign_final(ctx, p7, p7bio);
+}
+
 static ESS_SIGNING_CERT *ess_SIGNING_CERT_new_init(X509 *signcert,
                                                    STACK_OF(X509) *certs)
 {
@@ -1056,5 +1221,17 @@ static ASN1_GENERALIZEDTIME *TS_RESP_set_genTime_with_precision(
 int TS_RESP_CTX_set_ess_cert_id_digest(TS_RESP_CTX *ctx, const EVP_MD *md)
 {
     ctx->ess_cert_id_digest = md;
+    ts_RESP_CTX_reset_signer(ctx);
+    return 1;
+}
+
+int TS_RESP_CTX_set_num_threads(TS_RESP_CTX *ctx, int num_threads)
+{
+    if (num_threads < 1 || num_threads > TS_RESP_MAX_THREADS) {
+        TSerr(TS_F_TS_RESP_CTX_SET_NUM_THREADS,
+              ERR_R_PASSED_INVALID_ARGUMENT);
+        return 0;
+    }
+    ctx->num_threads = num_threads;
     return 1;
 }
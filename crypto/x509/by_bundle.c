@@ -0,0 +1,414 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include "e_os.h"
+#include "internal/cryptlib.h"
+#include <string.h>
+#include <openssl/bio.h>
+#include <openssl/buffer.h>
+#include <openssl/x509.h>
+#include "crypto/x509.h"
+#include "x509_local.h"
+
+#if defined(OPENSSL_SYS_UNIX) && !defined(OPENSSL_NO_POSIX_IO)
+# define BY_BUNDLE_MMAP
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <sys/mman.h>
+#endif
+
+/*-
+ * A CA bundle holds certificates in DER form, indexed by subject name hash
+ * so that they can be parsed when they are first looked up rather than
+ * upfront. All numbers are 32-bit big-endian:
+ *
+ *   "OSSLCAB1"
+ *   number of certificates n
+ *   n index entries of subject hash, offset, length, sorted by hash
+ *   the DER of the certificates, with their trust settings
+ *
+ * Offsets are from the start of the file.
+ */
+#define BUNDLE_MAGIC            "OSSLCAB1"
+#define BUNDLE_MAGIC_LEN        8
+#define BUNDLE_HEADER_LEN       (BUNDLE_MAGIC_LEN + 4)
+#define BUNDLE_ENTRY_LEN        12
+
+typedef struct bundle_file_st {
+    const unsigned char *data;
+    size_t len;
+    int mapped;
+    uint32_t num;
+    /* Set for the certificates that have been added to the store */
+    unsigned char *loaded;
+} BUNDLE_FILE;
+
+typedef struct lookup_bundle_st {
+    BUNDLE_FILE *files;
+    size_t num_files;
+    CRYPTO_RWLOCK *lock;
+} BY_BUNDLE;
+
+static int new_bundle(X509_LOOKUP *lu);
+static void free_bundle(X509_LOOKUP *lu);
+static int bundle_ctrl(X509_LOOKUP *ctx, int cmd, const char *argp, long argl,
+                       char **ret);
+static int get_cert_by_subject(X509_LOOKUP *xl, X509_LOOKUP_TYPE type,
+                               X509_NAME *name, X509_OBJECT *ret);
+static X509_LOOKUP_METHOD x509_bundle_lookup = {
+    "Load certs from a CA bundle on demand",
+    new_bundle,                 /* new_item */
+    free_bundle,                /* free */
+    NULL,                       /* init */
+    NULL,                       /* shutdown */
+    bundle_ctrl,                /* ctrl */
+    get_cert_by_subject,        /* get_by_subject */
+    NULL,                       /* get_by_issuer_serial */
+    NULL,                       /* get_by_fingerprint */
+    NULL,                       /* get_by_alias */
+};
+
+X509_LOOKUP_METHOD *X509_LOOKUP_bundle(void)
+{
+    return &x509_bundle_lookup;
+}
+
+static uint32_t get32(const unsigned char *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16)
+        | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static void put32(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+static const unsigned char *bundle_entry(const BUNDLE_FILE *f, uint32_t i)
+{
+    return f->data + BUNDLE_HEADER_LEN + (size_t)i * BUNDLE_ENTRY_LEN;
+}
+
+static int new_bundle(X509_LOOKUP *lu)
+{
+    BY_BUNDLE *a = OPENSSL_zalloc(sizeof(*a));
+
+    if (a == NULL || (a->lock = CRYPTO_THREAD_lock_new()) == NULL) {
+        OPENSSL_free(a);
+        X509err(X509_F_NEW_BUNDLE, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    lu->method_data = a;
+    return 1;
+}
+
+static void bundle_file_release(BUNDLE_FILE *f)
+{
+#ifdef BY_BUNDLE_MMAP
+    if (f->mapped) {
+        munmap((void *)f->data, f->len);
+        f->data = NULL;
+    }
+#endif
+    OPENSSL_free((void *)f->data);
+    OPENSSL_free(f->loaded);
+}
+
+static void free_bundle(X509_LOOKUP *lu)
+{
+    BY_BUNDLE *a = (BY_BUNDLE *)lu->method_data;
+    size_t i;
+
+    for (i = 0; i < a->num_files; i++)
+        bundle_file_release(&a->files[i]);
+    OPENSSL_free(a->files);
+    CRYPTO_THREAD_lock_free(a->lock);
+    OPENSSL_free(a);
+}
+
+/* Map |file| read-only, or failing that read it into memory */
+static int bundle_file_read(BUNDLE_FILE *f, const char *file)
+{
+    BIO *in;
+    BUF_MEM *mem = NULL;
+    char buf[4096];
+    int n;
+
+#ifdef BY_BUNDLE_MMAP
+    {
+        struct stat st;
+        void *p = MAP_FAILED;
+        int fd = open(file, O_RDONLY);
+
+        if (fd >= 0) {
+            if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0
+                    && (uint64_t)st.st_size <= 0xffffffffU)
+                p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED,
+                         fd, 0);
+            close(fd);
+        }
+        if (p != MAP_FAILED) {
+            f->data = p;
+            f->len = (size_t)st.st_size;
+            f->mapped = 1;
+            return 1;
+        }
+    }
+#endif
+
+    if ((in = BIO_new_file(file, "rb")) == NULL) {
+        X509err(X509_F_ADD_BUNDLE, ERR_R_SYS_LIB);
+        return 0;
+    }
+    if ((mem = BUF_MEM_new()) == NULL)
+        goto err;
+    while ((n = BIO_read(in, buf, sizeof(buf))) > 0) {
+        if (mem->length + n > 0xffffffffU
+                || !BUF_MEM_grow(mem, mem->length + n))
+            goto err;
+        memcpy(mem->data + mem->length - n, buf, n);
+    }
+    BIO_free(in);
+    f->len = mem->length;
+    f->data = (unsigned char *)mem->data;
+    mem->data = NULL;
+    BUF_MEM_free(mem);
+    return 1;
+
+ err:
+    X509err(X509_F_ADD_BUNDLE, ERR_R_MALLOC_FAILURE);
+    BUF_MEM_free(mem);
+    BIO_free(in);
+    return 0;
+}
+
+/* Check that the index of |f| is sorted and points into the file */
+static int bundle_file_check(BUNDLE_FILE *f)
+{
+    const unsigned char *e;
+    uint32_t i, off, len, prev = 0;
+    size_t datastart;
+
+    if (f->len < BUNDLE_HEADER_LEN
+            || memcmp(f->data, BUNDLE_MAGIC, BUNDLE_MAGIC_LEN) != 0)
+        return 0;
+    f->num = get32(f->data + BUNDLE_MAGIC_LEN);
+    if ((f->len - BUNDLE_HEADER_LEN) / BUNDLE_ENTRY_LEN < f->num)
+        return 0;
+    datastart = BUNDLE_HEADER_LEN + (size_t)f->num * BUNDLE_ENTRY_LEN;
+    for (i = 0; i < f->num; i++) {
+        e = bundle_entry(f, i);
+        off = get32(e + 4);
+        len = get32(e + 8);
+        if (get32(e) < prev || off < datastart || len == 0
+                || off > f->len || len > f->len - off)
+            return 0;
+        prev = get32(e);
+    }
+    return 1;
+}
+
+static int add_bundle(BY_BUNDLE *ctx, const char *file)
+{
+    BUNDLE_FILE f, *tmp;
+
+    if (file == NULL || *file == '\0') {
+        X509err(X509_F_ADD_BUNDLE, X509_R_INVALID_BUNDLE);
+        return 0;
+    }
+
+    memset(&f, 0, sizeof(f));
+    if (!bundle_file_read(&f, file))
+        return 0;
+    if (!bundle_file_check(&f)) {
+        X509err(X509_F_ADD_BUNDLE, X509_R_INVALID_BUNDLE);
+        goto err;
+    }
+    if ((f.loaded = OPENSSL_zalloc(f.num > 0 ? f.num : 1)) == NULL)
+        goto merr;
+
+    CRYPTO_THREAD_write_lock(ctx->lock);
+    tmp = OPENSSL_realloc(ctx->files, (ctx->num_files + 1) * sizeof(*tmp));
+    if (tmp != NULL) {
+        ctx->files = tmp;
+        ctx->files[ctx->num_files++] = f;
+    }
+    CRYPTO_THREAD_unlock(ctx->lock);
+    if (tmp != NULL)
+        return 1;
+
+ merr:
+    X509err(X509_F_ADD_BUNDLE, ERR_R_MALLOC_FAILURE);
+ err:
+    bundle_file_release(&f);
+    return 0;
+}
+
+static int bundle_ctrl(X509_LOOKUP *ctx, int cmd, const char *argp, long argl,
+                       char **retp)
+{
+    BY_BUNDLE *ld = (BY_BUNDLE *)ctx->method_data;
+
+    switch (cmd) {
+    case X509_L_ADD_BUNDLE:
+        return add_bundle(ld, argp);
+    }
+    return 0;
+}
+
+/*
+ * Add the certificates of |f| with subject |name| to the store of |xl|, if
+ * they have not been added yet. Returns the number added, or -1 on error.
+ */
+static int bundle_file_load(X509_LOOKUP *xl, BUNDLE_FILE *f, X509_NAME *name,
+                            uint32_t h)
+{
+    const unsigned char *e, *p;
+    uint32_t lo = 0, hi = f->num, mid;
+    X509 *x;
+    int count = 0;
+
+    /* Find the first entry for |h| */
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (get32(bundle_entry(f, mid)) < h)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    for (; lo < f->num && get32(e = bundle_entry(f, lo)) == h; lo++) {
+        if (f->loaded[lo])
+            continue;
+        p = f->data + get32(e + 4);
+        if ((x = d2i_X509_AUX(NULL, &p, (long)get32(e + 8))) == NULL)
+            return -1;
+        if (x509_name_equal(X509_get_subject_name(x), name)) {
+            if (!X509_STORE_add_cert(xl->store_ctx, x)) {
+                X509_free(x);
+                return -1;
+            }
+            f->loaded[lo] = 1;
+            count++;
+        }
+        X509_free(x);
+    }
+    return count;
+}
+
+static int get_cert_by_subject(X509_LOOKUP *xl, X509_LOOKUP_TYPE type,
+                               X509_NAME *name, X509_OBJECT *ret)
+{
+    BY_BUNDLE *ctx = (BY_BUNDLE *)xl->method_data;
+    X509_OBJECT *tmp;
+    uint32_t h;
+    size_t i;
+    int count = 0, n;
+
+    if (type != X509_LU_X509 || name == NULL)
+        return 0;
+
+    h = (uint32_t)X509_NAME_hash(name);
+    CRYPTO_THREAD_write_lock(ctx->lock);
+    for (i = 0; i < ctx->num_files; i++) {
+        if ((n = bundle_file_load(xl, &ctx->files[i], name, h)) < 0) {
+            CRYPTO_THREAD_unlock(ctx->lock);
+            return 0;
+        }
+        count += n;
+    }
+    CRYPTO_THREAD_unlock(ctx->lock);
+    if (count == 0)
+        return 0;
+
+    /* We have added them to the cache so now pull one out again */
+    X509_STORE_lock(xl->store_ctx);
+    tmp = X509_OBJECT_retrieve_by_subject(xl->store_ctx->objs, type, name);
+    X509_STORE_unlock(xl->store_ctx);
+    if (tmp == NULL)
+        return 0;
+    ret->type = tmp->type;
+    ret->data.x509 = tmp->data.x509;
+    return 1;
+}
+
+typedef struct {
+    uint32_t hash;
+    int idx;
+    unsigned char *der;
+    int len;
+} BUNDLE_OUT;
+
+static int bundle_out_cmp(const void *a, const void *b)
+{
+    const BUNDLE_OUT *oa = a, *ob = b;
+
+    if (oa->hash != ob->hash)
+        return oa->hash < ob->hash ? -1 : 1;
+    return oa->idx - ob->idx;
+}
+
+int X509_write_bundle_bio(BIO *out, STACK_OF(X509) *certs)
+{
+    BUNDLE_OUT *ents = NULL;
+    unsigned char hdr[BUNDLE_HEADER_LEN], ent[BUNDLE_ENTRY_LEN];
+    int i, num = sk_X509_num(certs), ret = 0;
+    uint64_t off;
+
+    if (num > 0 && (ents = OPENSSL_zalloc(num * sizeof(*ents))) == NULL) {
+        X509err(X509_F_X509_WRITE_BUNDLE_BIO, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    for (i = 0; i < num; i++) {
+        X509 *x = sk_X509_value(certs, i);
+
+        ents[i].hash = (uint32_t)X509_NAME_hash(X509_get_subject_name(x));
+        ents[i].idx = i;
+        if ((ents[i].len = i2d_X509_AUX(x, &ents[i].der)) <= 0) {
+            X509err(X509_F_X509_WRITE_BUNDLE_BIO, ERR_R_ASN1_LIB);
+            goto end;
+        }
+    }
+    if (num > 1)
+        qsort(ents, num, sizeof(*ents), bundle_out_cmp);
+
+    memcpy(hdr, BUNDLE_MAGIC, BUNDLE_MAGIC_LEN);
+    put32(hdr + BUNDLE_MAGIC_LEN, (uint32_t)num);
+    if (BIO_write(out, hdr, sizeof(hdr)) != (int)sizeof(hdr))
+        goto end;
+
+    off = BUNDLE_HEADER_LEN + (uint64_t)num * BUNDLE_ENTRY_LEN;
+    for (i = 0; i < num; i++) {
+        if (off + ents[i].len > 0xffffffffU) {
+            X509err(X509_F_X509_WRITE_BUNDLE_BIO, X509_R_INVALID_BUNDLE);
+            goto end;
+        }
+        put32(ent, ents[i].hash);
+        put32(ent + 4, (uint32_t)off);
+        put32(ent + 8, (uint32_t)ents[i].len);
+        if (BIO_write(out, ent, sizeof(ent)) != (int)sizeof(ent))
+            goto end;
+        off += ents[i].len;
+    }
+    for (i = 0; i < num; i++)
+        if (BIO_write(out, ents[i].der, ents[i].len) != ents[i].len)
+            goto end;
+    ret = 1;
+
+ end:
+    for (i = 0; i < num; i++)
+        OPENSSL_free(ents[i].der);
+    OPENSSL_free(ents);
+    return ret;
+}
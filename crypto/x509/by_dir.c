@@ -16,21 +16,50 @@
 
 #ifndef OPENSSL_NO_POSIX_IO
 # include <sys/stat.h>
+# ifdef _WIN32
+#  define stat _stat
+# endif
 #endif
 
 #include <openssl/x509.h>
+#include "crypto/ctype.h"
 #include "crypto/x509.h"
+#include "internal/o_dir.h"
 #include "x509_local.h"
 
+/*
+ * Without stat() there is no telling whether a directory changed, and VMS
+ * file names do not map onto the index
+ */
+#if !defined(OPENSSL_NO_POSIX_IO) && !defined(OPENSSL_SYS_VMS)
+# define BY_DIR_INDEX_ENABLED
+#endif
+
 struct lookup_dir_hashes_st {
     unsigned long hash;
     int suffix;
 };
 
+/* The hashed file names present in a directory */
+typedef struct lookup_dir_index_st {
+    unsigned long hash;
+    unsigned char certs, crls;
+} BY_DIR_INDEX;
+
 struct lookup_dir_entry_st {
     char *dir;
     int dir_type;
     STACK_OF(BY_DIR_HASH) *hashes;
+#ifdef BY_DIR_INDEX_ENABLED
+    /* Sorted by hash, only used if index_valid is set */
+    BY_DIR_INDEX *index;
+    size_t index_num;
+    int index_valid;
+    /* Modification time of dir when the index was built, and when that was */
+    time_t index_mtime, index_built;
+    /* When dir was last checked for changes */
+    time_t index_checked;
+#endif
 };
 
 typedef struct lookup_dir_st {
@@ -135,6 +164,9 @@ static int by_dir_hash_cmp(const BY_DIR_HASH *const *a,
 
 static void by_dir_entry_free(BY_DIR_ENTRY *ent)
 {
+#ifdef BY_DIR_INDEX_ENABLED
+    OPENSSL_free(ent->index);
+#endif
     OPENSSL_free(ent->dir);
     sk_BY_DIR_HASH_pop_free(ent->hashes, by_dir_hash_free);
     OPENSSL_free(ent);
@@ -186,7 +218,7 @@ static int add_cert_dir(BY_DIR *ctx, const char *dir, int type)
                     return 0;
                 }
             }
-            ent = OPENSSL_malloc(sizeof(*ent));
+            ent = OPENSSL_zalloc(sizeof(*ent));
             if (ent == NULL) {
                 X509err(X509_F_ADD_CERT_DIR, ERR_R_MALLOC_FAILURE);
                 return 0;
@@ -208,6 +240,152 @@ static int add_cert_dir(BY_DIR *ctx, const char *dir, int type)
     return 1;
 }
 
+#ifdef BY_DIR_INDEX_ENABLED
+static int by_dir_index_cmp(const void *a, const void *b)
+{
+    const BY_DIR_INDEX *ia = a, *ib = b;
+
+    if (ia->hash > ib->hash)
+        return 1;
+    if (ia->hash < ib->hash)
+        return -1;
+    return 0;
+}
+
+/*
+ * Parse a file name of the form "hhhhhhhh.N" or "hhhhhhhh.rN", as created by
+ * c_rehash, into the hash and whether it's a CRL.
+ */
+static int by_dir_parse_name(const char *fn, unsigned long *hash, int *crl)
+{
+    unsigned long h = 0;
+    int i, v;
+
+    for (i = 0; i < 8; i++) {
+        if ((v = OPENSSL_hexchar2int(fn[i])) < 0)
+            return 0;
+        h = (h << 4) | (unsigned long)v;
+    }
+    if (fn[i++] != '.')
+        return 0;
+    *crl = fn[i] == 'r';
+    if (*crl)
+        i++;
+    if (!ossl_isdigit(fn[i]))
+        return 0;
+    while (ossl_isdigit(fn[i]))
+        i++;
+    if (fn[i] != '\0')
+        return 0;
+    *hash = h;
+    return 1;
+}
+
+/* Rebuild the index of |ent| from the directory contents */
+static int by_dir_index_build(BY_DIR_ENTRY *ent)
+{
+    OPENSSL_DIR_CTX *d = NULL;
+    BY_DIR_INDEX *index = NULL, *tmp;
+    size_t num = 0, max = 0, i, j;
+    const char *fn;
+    unsigned long h;
+    int crl;
+
+    ent->index_valid = 0;
+    while ((fn = OPENSSL_DIR_read(&d, ent->dir)) != NULL) {
+        if (!by_dir_parse_name(fn, &h, &crl))
+            continue;
+        if (num == max) {
+            max = max == 0 ? 64 : max * 2;
+            if ((tmp = OPENSSL_realloc(index, max * sizeof(*index))) == NULL)
+                goto err;
+            index = tmp;
+        }
+        index[num].hash = h;
+        index[num].certs = !crl;
+        index[num].crls = crl;
+        num++;
+    }
+    if (errno != 0)
+        goto err;
+    OPENSSL_DIR_end(&d);
+
+    /* Merge the entries of the files that share a hash */
+    if (num > 1)
+        qsort(index, num, sizeof(*index), by_dir_index_cmp);
+    for (i = 0, j = 0; i < num; i++) {
+        if (j > 0 && index[j - 1].hash == index[i].hash) {
+            index[j - 1].certs |= index[i].certs;
+            index[j - 1].crls |= index[i].crls;
+        } else {
+            index[j++] = index[i];
+        }
+    }
+
+    OPENSSL_free(ent->index);
+    ent->index = index;
+    ent->index_num = j;
+    ent->index_valid = 1;
+    return 1;
+
+ err:
+    if (d != NULL)
+        OPENSSL_DIR_end(&d);
+    OPENSSL_free(index);
+    return 0;
+}
+
+/*
+ * Check whether |ent| holds a certificate, or a CRL if |crl| is set, for the
+ * name hash |h| without touching the file system. The directory is checked
+ * for changes at most once a second. Returns 1 if there may be such a file,
+ * 0 if there is none, and -1 if the directory could not be indexed.
+ */
+static int by_dir_index_lookup(BY_DIR *ctx, BY_DIR_ENTRY *ent,
+                               unsigned long h, int crl)
+{
+    BY_DIR_INDEX key, *found;
+    struct stat st;
+    time_t now = time(NULL);
+    int ret, refresh;
+
+    CRYPTO_THREAD_read_lock(ctx->lock);
+    refresh = ent->index_checked != now;
+    CRYPTO_THREAD_unlock(ctx->lock);
+
+    if (refresh) {
+        CRYPTO_THREAD_write_lock(ctx->lock);
+        if (ent->index_checked != now) {
+            ent->index_checked = now;
+            if (stat(ent->dir, &st) < 0) {
+                ent->index_valid = 0;
+            } else if (!ent->index_valid
+                       || st.st_mtime != ent->index_mtime
+                       /* Changes in the second the index was built */
+                       || st.st_mtime >= ent->index_built) {
+                if (by_dir_index_build(ent)) {
+                    ent->index_mtime = st.st_mtime;
+                    ent->index_built = now;
+                }
+            }
+        }
+        CRYPTO_THREAD_unlock(ctx->lock);
+    }
+
+    key.hash = h;
+    CRYPTO_THREAD_read_lock(ctx->lock);
+    if (!ent->index_valid) {
+        ret = -1;
+    } else {
+        found = bsearch(&key, ent->index, ent->index_num, sizeof(key),
+                        by_dir_index_cmp);
+        ret = found != NULL && (crl ? found->crls : found->certs);
+    }
+    CRYPTO_THREAD_unlock(ctx->lock);
+    return ret;
+}
+#endif
+
 static int get_cert_by_subject(X509_LOOKUP *xl, X509_LOOKUP_TYPE type,
                                X509_NAME *name, X509_OBJECT *ret)
 {
@@ -254,6 +432,11 @@ static int get_cert_by_subject(X509_LOOKUP *xl, X509_LOOKUP_TYPE type,
         BY_DIR_HASH htmp, *hent;
 
         ent = sk_BY_DIR_ENTRY_value(ctx->dirs, i);
+#ifdef BY_DIR_INDEX_ENABLED
+        /* Nothing to load from this directory */
+        if (by_dir_index_lookup(ctx, ent, h, type == X509_LU_CRL) == 0)
+            continue;
+#endif
         j = strlen(ent->dir) + 1 + 8 + 6 + 1 + 1;
         if (!BUF_MEM_grow(b, j)) {
             X509err(X509_F_GET_CERT_BY_SUBJECT, ERR_R_MALLOC_FAILURE);
@@ -303,9 +486,6 @@ static int get_cert_by_subject(X509_LOOKUP *xl, X509_LOOKUP_TYPE type,
                              "%s%c%08lx.%s%d", ent->dir, c, h, postfix, k);
             }
 #ifndef OPENSSL_NO_POSIX_IO
-# ifdef _WIN32
-#  define stat _stat
-# endif
             {
                 struct stat st;
                 if (stat(b->data, &st) < 0)
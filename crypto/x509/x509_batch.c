@@ -0,0 +1,124 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <string.h>
+#include "internal/cryptlib.h"
+#include <openssl/evp.h>
+#include <openssl/lhash.h>
+#include <openssl/x509.h>
+#include "crypto/x509.h"
+#include "x509_local.h"
+
+/*
+ * The signatures found to be good while verifying a batch of chains, so
+ * that intermediates shared by many chains are only checked once. Entries
+ * are keyed by the SHA-256 digests of the signed certificate and of its
+ * issuer; matching by digest rather than by pointer lets separately parsed
+ * copies of a certificate share an entry, and SHA-256 rather than the
+ * cached SHA-1 hash keeps colliding certificates from doing so.
+ */
+typedef struct {
+    unsigned char key[X509_SIG_MEMO_KEY_LEN];
+} X509_SIG_MEMO_ENTRY;
+
+DEFINE_LHASH_OF(X509_SIG_MEMO_ENTRY);
+
+struct x509_sig_memo_st {
+    LHASH_OF(X509_SIG_MEMO_ENTRY) *entries;
+};
+
+static unsigned long sig_memo_hash(const X509_SIG_MEMO_ENTRY *e)
+{
+    return (unsigned long)e->key[0] | ((unsigned long)e->key[1] << 8)
+        | ((unsigned long)e->key[2] << 16) | ((unsigned long)e->key[3] << 24);
+}
+
+static int sig_memo_cmp(const X509_SIG_MEMO_ENTRY *a,
+                        const X509_SIG_MEMO_ENTRY *b)
+{
+    return memcmp(a->key, b->key, sizeof(a->key));
+}
+
+int x509_sig_memo_key(X509 *subject, X509 *issuer, unsigned char *key)
+{
+    unsigned int len;
+
+    return X509_digest(subject, EVP_sha256(), key, &len)
+        && X509_digest(issuer, EVP_sha256(), key + X509_SIG_MEMO_KEY_LEN / 2,
+                       &len);
+}
+
+int x509_sig_memo_get(X509_SIG_MEMO *memo, const unsigned char *key)
+{
+    X509_SIG_MEMO_ENTRY tmp;
+
+    memcpy(tmp.key, key, sizeof(tmp.key));
+    return lh_X509_SIG_MEMO_ENTRY_retrieve(memo->entries, &tmp) != NULL;
+}
+
+/* Failing to remember a signature only costs checking it again */
+void x509_sig_memo_put(X509_SIG_MEMO *memo, const unsigned char *key)
+{
+    X509_SIG_MEMO_ENTRY *e;
+
+    if (x509_sig_memo_get(memo, key)
+        || (e = OPENSSL_malloc(sizeof(*e))) == NULL)
+        return;
+    memcpy(e->key, key, sizeof(e->key));
+    (void)lh_X509_SIG_MEMO_ENTRY_insert(memo->entries, e);
+    if (lh_X509_SIG_MEMO_ENTRY_error(memo->entries) != 0)
+        OPENSSL_free(e);
+}
+
+static void sig_memo_entry_free(X509_SIG_MEMO_ENTRY *e)
+{
+    OPENSSL_free(e);
+}
+
+int X509_verify_cert_batch(X509_STORE *store, X509 **certs,
+                           STACK_OF(X509) **untrusted, int n, int *errors)
+{
+    X509_SIG_MEMO memo;
+    X509_STORE_CTX *ctx;
+    int i, verified = 0;
+
+    if (store == NULL || certs == NULL || errors == NULL || n < 0) {
+        X509err(X509_F_X509_VERIFY_CERT_BATCH, ERR_R_PASSED_NULL_PARAMETER);
+        return -1;
+    }
+    memo.entries = lh_X509_SIG_MEMO_ENTRY_new(sig_memo_hash, sig_memo_cmp);
+    if (memo.entries == NULL || (ctx = X509_STORE_CTX_new()) == NULL) {
+        lh_X509_SIG_MEMO_ENTRY_free(memo.entries);
+        X509err(X509_F_X509_VERIFY_CERT_BATCH, ERR_R_MALLOC_FAILURE);
+        return -1;
+    }
+
+    for (i = 0; i < n; i++) {
+        int ret;
+
+        if (!X509_STORE_CTX_init(ctx, store, certs[i],
+                                 untrusted != NULL ? untrusted[i] : NULL)) {
+            errors[i] = X509_V_ERR_OUT_OF_MEM;
+            continue;
+        }
+        ctx->sig_memo = &memo;
+        ret = X509_verify_cert(ctx);
+        errors[i] = X509_STORE_CTX_get_error(ctx);
+        if (ret <= 0 && errors[i] == X509_V_OK)
+            errors[i] = X509_V_ERR_UNSPECIFIED;
+        else if (ret > 0 && errors[i] == X509_V_OK)
+            verified++;
+        X509_STORE_CTX_cleanup(ctx);
+    }
+
+    X509_STORE_CTX_free(ctx);
+    lh_X509_SIG_MEMO_ENTRY_doall(memo.entries, sig_memo_entry_free);
+    lh_X509_SIG_MEMO_ENTRY_free(memo.entries);
+    return verified;
+}
@@ -162,23 +162,20 @@ int X509_cmp(const X509 *a, const X509 *b)
     return rv;
 }
 
+/* Ensure canonical encoding is present and up to date */
+static int name_canon_update(const X509_NAME *a)
+{
+    if (!a->canon_enc || a->modified)
+        return i2d_X509_NAME((X509_NAME *)a, NULL) >= 0;
+    return 1;
+}
+
 int X509_NAME_cmp(const X509_NAME *a, const X509_NAME *b)
 {
     int ret;
 
-    /* Ensure canonical encoding is present and up to date */
-
-    if (!a->canon_enc || a->modified) {
-        ret = i2d_X509_NAME((X509_NAME *)a, NULL);
-        if (ret < 0)
-            return -2;
-    }
-
-    if (!b->canon_enc || b->modified) {
-        ret = i2d_X509_NAME((X509_NAME *)b, NULL);
-        if (ret < 0)
-            return -2;
-    }
+    if (!name_canon_update(a) || !name_canon_update(b))
+        return -2;
 
     ret = a->canon_enclen - b->canon_enclen;
 
@@ -189,6 +186,23 @@ int X509_NAME_cmp(const X509_NAME *a, const X509_NAME *b)
 
 }
 
+/*
+ * Equivalent to X509_NAME_cmp(a, b) == 0, for callers that need no ordering.
+ * Names that differ are mostly told apart by their fingerprints, without
+ * looking at the encodings.
+ */
+int x509_name_equal(const X509_NAME *a, const X509_NAME *b)
+{
+    if (!name_canon_update(a) || !name_canon_update(b))
+        return 0;
+
+    if (a->canon_enclen != b->canon_enclen || a->canon_hash != b->canon_hash)
+        return 0;
+
+    return a->canon_enclen == 0
+        || memcmp(a->canon_enc, b->canon_enc, a->canon_enclen) == 0;
+}
+
 unsigned long X509_NAME_hash(X509_NAME *x)
 {
     unsigned long ret = 0;
@@ -206,6 +220,17 @@ unsigned long X509_NAME_hash(X509_NAME *x)
     return ret;
 }
 
+/*
+ * Unlike X509_NAME_hash(), which names files on disk and must not change,
+ * this only has to agree with X509_NAME_cmp() within the running process.
+ */
+unsigned long X509_NAME_hash_keyed(const X509_NAME *x)
+{
+    if (!name_canon_update(x))
+        return 0;
+    return OPENSSL_LH_keyed_hash(x->canon_enc, x->canon_enclen);
+}
+
 #ifndef OPENSSL_NO_MD5
 /*
  * I now DER encode the name and hash it.  Since I cache the DER encoding,
@@ -264,7 +289,7 @@ X509 *X509_find_by_subject(STACK_OF(X509) *sk, X509_NAME *name)
 
     for (i = 0; i < sk_X509_num(sk); i++) {
         x509 = sk_X509_value(sk, i);
-        if (X509_NAME_cmp(X509_get_subject_name(x509), name) == 0)
+        if (x509_name_equal(X509_get_subject_name(x509), name))
             return x509;
     }
     return NULL;
@@ -0,0 +1,257 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <string.h>
+#include "internal/cryptlib.h"
+#include "internal/thread_once.h"
+#include <openssl/evp.h>
+#include <openssl/lhash.h>
+#include <openssl/x509.h>
+#include "crypto/x509.h"
+#include "x509_local.h"
+
+/*
+ * The intern table maps the SHA-256 of the encoding of a certificate to one
+ * shared X509 object, so that the same certificate received or loaded many
+ * times is only kept in memory once. The table holds a reference to each
+ * certificate and drops the ones nobody else refers to any more when it has
+ * doubled in size since it was last pruned. Certificates with trust
+ * settings are never shared, since those belong to whoever set them.
+ */
+typedef struct {
+    unsigned char md[SHA256_DIGEST_LENGTH];
+    X509 *x;
+} X509_INTERN_ENTRY;
+
+DEFINE_LHASH_OF(X509_INTERN_ENTRY);
+
+/* The table is not pruned below this size */
+#define X509_INTERN_MIN_PRUNE   256
+
+static CRYPTO_ONCE intern_once = CRYPTO_ONCE_STATIC_INIT;
+static CRYPTO_RWLOCK *intern_lock = NULL;
+static LHASH_OF(X509_INTERN_ENTRY) *intern_table = NULL;
+static unsigned long intern_prune_at = X509_INTERN_MIN_PRUNE;
+static int intern_enabled = 0;
+
+static unsigned long intern_entry_hash(const X509_INTERN_ENTRY *e)
+{
+    return (unsigned long)e->md[0] | ((unsigned long)e->md[1] << 8)
+        | ((unsigned long)e->md[2] << 16) | ((unsigned long)e->md[3] << 24);
+}
+
+static int intern_entry_cmp(const X509_INTERN_ENTRY *a,
+                            const X509_INTERN_ENTRY *b)
+{
+    return memcmp(a->md, b->md, sizeof(a->md));
+}
+
+static void intern_entry_free(X509_INTERN_ENTRY *e)
+{
+    X509_free(e->x);
+    OPENSSL_free(e);
+}
+
+DEFINE_RUN_ONCE_STATIC(do_intern_init)
+{
+    intern_lock = CRYPTO_THREAD_lock_new();
+    intern_table = lh_X509_INTERN_ENTRY_new(intern_entry_hash,
+                                            intern_entry_cmp);
+    if (intern_lock == NULL || intern_table == NULL) {
+        CRYPTO_THREAD_lock_free(intern_lock);
+        lh_X509_INTERN_ENTRY_free(intern_table);
+        intern_lock = NULL;
+        intern_table = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+void x509_intern_cleanup_int(void)
+{
+    if (intern_table == NULL)
+        return;
+    lh_X509_INTERN_ENTRY_doall(intern_table, intern_entry_free);
+    lh_X509_INTERN_ENTRY_free(intern_table);
+    CRYPTO_THREAD_lock_free(intern_lock);
+    intern_table = NULL;
+    intern_lock = NULL;
+}
+
+/*
+ * Nobody can take a new reference to a certificate only the table refers
+ * to without going through the table, so it is safe to drop it here.
+ */
+static void intern_prune_entry(X509_INTERN_ENTRY *e)
+{
+    if (e->x->references == 1) {
+        (void)lh_X509_INTERN_ENTRY_delete(intern_table, e);
+        intern_entry_free(e);
+    }
+}
+
+static void intern_prune_locked(void)
+{
+    unsigned long down_load = lh_X509_INTERN_ENTRY_get_down_load(intern_table);
+
+    /* Keep the table from being contracted while we walk it */
+    lh_X509_INTERN_ENTRY_set_down_load(intern_table, 0);
+    lh_X509_INTERN_ENTRY_doall(intern_table, intern_prune_entry);
+    lh_X509_INTERN_ENTRY_set_down_load(intern_table, down_load);
+    intern_prune_at = 2 * lh_X509_INTERN_ENTRY_num_items(intern_table);
+    if (intern_prune_at < X509_INTERN_MIN_PRUNE)
+        intern_prune_at = X509_INTERN_MIN_PRUNE;
+}
+
+/* A reference to the certificate |md| is the digest of, if there is one */
+static X509 *intern_get(const unsigned char *md)
+{
+    X509_INTERN_ENTRY key, *e;
+    X509 *x = NULL;
+
+    memcpy(key.md, md, sizeof(key.md));
+    CRYPTO_THREAD_read_lock(intern_lock);
+    e = lh_X509_INTERN_ENTRY_retrieve(intern_table, &key);
+    if (e != NULL && e->x->aux == NULL && X509_up_ref(e->x))
+        x = e->x;
+    CRYPTO_THREAD_unlock(intern_lock);
+    return x;
+}
+
+/*
+ * Make |x| the shared certificate for |md|, unless another thread got there
+ * first. Returns a reference to the shared certificate, which replaces the
+ * caller's reference to |x|.
+ */
+static X509 *intern_put(X509 *x, const unsigned char *md)
+{
+    X509_INTERN_ENTRY *e, *old;
+    X509 *shared;
+
+    if ((e = OPENSSL_malloc(sizeof(*e))) == NULL)
+        return x;
+    memcpy(e->md, md, sizeof(e->md));
+    e->x = x;
+    if (!X509_up_ref(x)) {
+        OPENSSL_free(e);
+        return x;
+    }
+
+    CRYPTO_THREAD_write_lock(intern_lock);
+    old = lh_X509_INTERN_ENTRY_retrieve(intern_table, e);
+    if (old != NULL && old->x->aux == NULL && X509_up_ref(old->x)) {
+        shared = old->x;
+        CRYPTO_THREAD_unlock(intern_lock);
+        intern_entry_free(e);
+        X509_free(x);
+        return shared;
+    }
+    /* Replaces an entry that acquired trust settings since it was added */
+    old = lh_X509_INTERN_ENTRY_insert(intern_table, e);
+    if (old == NULL && lh_X509_INTERN_ENTRY_error(intern_table)) {
+        CRYPTO_THREAD_unlock(intern_lock);
+        intern_entry_free(e);
+        return x;
+    }
+    if (lh_X509_INTERN_ENTRY_num_items(intern_table) >= intern_prune_at)
+        intern_prune_locked();
+    CRYPTO_THREAD_unlock(intern_lock);
+
+    if (old != NULL)
+        intern_entry_free(old);
+    return x;
+}
+
+void X509_intern_enable(int enable)
+{
+    intern_enabled = enable != 0;
+}
+
+int X509_intern_enabled(void)
+{
+    return intern_enabled;
+}
+
+X509 *X509_intern(X509 *x)
+{
+    unsigned char md[EVP_MAX_MD_SIZE];
+    unsigned int len;
+    X509 *ret;
+
+    if (x == NULL || !intern_enabled || x->aux != NULL
+            || !RUN_ONCE(&intern_once, do_intern_init))
+        return x;
+
+    ERR_set_mark();
+    if (!X509_digest(x, EVP_sha256(), md, &len)) {
+        ERR_pop_to_mark();
+        return x;
+    }
+    ERR_clear_last_mark();
+
+    if ((ret = intern_get(md)) != NULL) {
+        X509_free(x);
+        return ret;
+    }
+    return intern_put(x, md);
+}
+
+/*
+ * Decode a certificate, or take another reference to the shared one when
+ * the same encoding was seen before, which saves decoding it again.
+ */
+X509 *d2i_X509_intern(X509 **a, const unsigned char **in, long len)
+{
+    unsigned char md[SHA256_DIGEST_LENGTH];
+    const unsigned char *p = *in;
+    long certlen, tbsoff, tbslen;
+    X509 *ret;
+
+    if (!intern_enabled || len < 0
+            || !x509_der_lengths(*in, len, &certlen, &tbsoff, &tbslen)
+            || !RUN_ONCE(&intern_once, do_intern_init)
+            || !EVP_Digest(*in, certlen, md, NULL, EVP_sha256(), NULL))
+        return d2i_X509(a, in, len);
+
+    if ((ret = intern_get(md)) != NULL) {
+        p += certlen;
+    } else {
+        if ((ret = d2i_X509(NULL, &p, certlen)) == NULL)
+            return NULL;
+        ret = intern_put(ret, md);
+    }
+
+    *in = p;
+    if (a != NULL) {
+        X509_free(*a);
+        *a = ret;
+    }
+    return ret;
+}
+
+X509 *X509_intern_lookup(const unsigned char *md, size_t md_len)
+{
+    if (md == NULL || md_len != SHA256_DIGEST_LENGTH
+            || !RUN_ONCE(&intern_once, do_intern_init))
+        return NULL;
+    return intern_get(md);
+}
+
+size_t X509_intern_flush(void)
+{
+    size_t num;
+
+    if (!RUN_ONCE(&intern_once, do_intern_init))
+        return 0;
+    CRYPTO_THREAD_write_lock(intern_lock);
+    intern_prune_locked();
+    num = lh_X509_INTERN_ENTRY_num_items(intern_table);
+    CRYPTO_THREAD_unlock(intern_lock);
+    return num;
+}
@@ -102,6 +102,9 @@ struct x509_lookup_st {
  * validation.  Once we have a certificate chain, the 'verify' function is
  * then called to actually check the cert chain.
  */
+typedef struct x509_chain_cache_st X509_CHAIN_CACHE;
+typedef struct x509_sig_memo_st X509_SIG_MEMO;
+
 struct x509_store_st {
     /* The following is a cache of trusted certs */
     int cache;                  /* if true, stash any hits */
@@ -134,6 +137,12 @@ struct x509_store_st {
     CRYPTO_EX_DATA ex_data;
     CRYPTO_REF_COUNT references;
     CRYPTO_RWLOCK *lock;
+    /* Verified chains, see X509_STORE_set_chain_cache() */
+    X509_CHAIN_CACHE *chain_cache;
+    /* Bumped whenever cached chains may have become invalid */
+    unsigned long chain_cache_gen;
+    /* Checks chain signatures by default, see X509_STORE_set0_worker_pool() */
+    OSSL_WORKER_POOL *worker_pool;
 };
 
 typedef struct lookup_dir_hashes_st BY_DIR_HASH;
@@ -146,4 +155,19 @@ DEFINE_STACK_OF(STACK_OF_X509_NAME_ENTRY)
 void x509_set_signature_info(X509_SIG_INFO *siginf, const X509_ALGOR *alg,
                              const ASN1_STRING *sig);
 int x509_likely_issued(X509 *issuer, X509 *subject);
+int x509_der_lengths(const unsigned char *in, long len, long *certlen,
+                     long *tbsoff, long *tbslen);
+
+#define X509_CHAIN_CACHE_KEY_LEN 32  /* SHA-256 */
+int x509_chain_cache_get(X509_STORE_CTX *ctx, unsigned char *key,
+                         unsigned long *gen);
+void x509_chain_cache_put(X509_STORE_CTX *ctx, const unsigned char *key,
+                          unsigned long gen);
+void x509_chain_cache_flush_locked(X509_STORE *store);
+void x509_chain_cache_free(X509_CHAIN_CACHE *cache);
+
+#define X509_SIG_MEMO_KEY_LEN 64  /* SHA-256 of subject and issuer */
+int x509_sig_memo_key(X509 *subject, X509 *issuer, unsigned char *key);
+int x509_sig_memo_get(X509_SIG_MEMO *memo, const unsigned char *key);
+void x509_sig_memo_put(X509_SIG_MEMO *memo, const unsigned char *key);
 int x509_signing_allowed(const X509 *issuer, const X509 *subject);
@@ -10,6 +10,7 @@
 #include <stdio.h>
 #include "internal/cryptlib.h"
 #include "internal/refcount.h"
+#include "internal/metrics.h"
 #include <openssl/x509.h>
 #include "crypto/x509.h"
 #include <openssl/x509v3.h>
@@ -51,6 +52,23 @@ int X509_STORE_unlock(X509_STORE *s)
     return CRYPTO_THREAD_unlock(s->lock);
 }
 
+/*
+ * Lookups only read the objects of a store once they are sorted, so they
+ * can share the lock. Objects get added unsorted, the first lookup after
+ * that sorts them under the write lock.
+ */
+static void x509_store_read_lock(X509_STORE *s)
+{
+    CRYPTO_THREAD_read_lock(s->lock);
+    while (!sk_X509_OBJECT_is_sorted(s->objs)) {
+        CRYPTO_THREAD_unlock(s->lock);
+        CRYPTO_THREAD_write_lock(s->lock);
+        sk_X509_OBJECT_sort(s->objs);
+        CRYPTO_THREAD_unlock(s->lock);
+        CRYPTO_THREAD_read_lock(s->lock);
+    }
+}
+
 int X509_LOOKUP_init(X509_LOOKUP *ctx)
 {
     if (ctx->method == NULL)
@@ -226,6 +244,7 @@ void X509_STORE_free(X509_STORE *vfy)
 
     CRYPTO_free_ex_data(CRYPTO_EX_INDEX_X509_STORE, vfy, &vfy->ex_data);
     X509_VERIFY_PARAM_free(vfy->param);
+    x509_chain_cache_free(vfy->chain_cache);
     CRYPTO_THREAD_lock_free(vfy->lock);
     OPENSSL_free(vfy);
 }
@@ -242,6 +261,26 @@ int X509_STORE_up_ref(X509_STORE *vfy)
     return ((i > 1) ? 1 : 0);
 }
 
+int X509_STORE_freeze(X509_STORE *store)
+{
+    X509_OBJECT *obj;
+    int i, ret = 1;
+
+    X509_STORE_lock(store);
+    sk_X509_OBJECT_sort(store->objs);
+    for (i = 0; ret && i < sk_X509_OBJECT_num(store->objs); i++) {
+        obj = sk_X509_OBJECT_value(store->objs, i);
+        if (obj->type == X509_LU_X509)
+            ret = X509_freeze(obj->data.x509);
+        else if (obj->type == X509_LU_CRL)
+            ret = X509_CRL_freeze(obj->data.crl);
+    }
+    X509_STORE_unlock(store);
+    if (ret)
+        CRYPTO_REF_FREEZE(&store->references);
+    return ret;
+}
+
 X509_LOOKUP *X509_STORE_add_lookup(X509_STORE *v, X509_LOOKUP_METHOD *m)
 {
     int i;
@@ -301,11 +340,12 @@ int X509_STORE_CTX_get_by_subject(X509_STORE_CTX *vs, X509_LOOKUP_TYPE type,
     stmp.data.ptr = NULL;
 
 
-    X509_STORE_lock(store);
+    x509_store_read_lock(store);
     tmp = X509_OBJECT_retrieve_by_subject(store->objs, type, name);
     X509_STORE_unlock(store);
 
     if (tmp == NULL || type == X509_LU_CRL) {
+        OSSL_METRIC_INC(OSSL_METRIC_X509_STORE_MISSES);
         for (i = 0; i < sk_X509_LOOKUP_num(store->get_cert_methods); i++) {
             lu = sk_X509_LOOKUP_value(store->get_cert_methods, i);
             j = X509_LOOKUP_by_subject(lu, type, name, &stmp);
@@ -316,6 +356,8 @@ int X509_STORE_CTX_get_by_subject(X509_STORE_CTX *vs, X509_LOOKUP_TYPE type,
         }
         if (tmp == NULL)
             return 0;
+    } else {
+        OSSL_METRIC_INC(OSSL_METRIC_X509_STORE_HITS);
     }
 
     if (!X509_OBJECT_up_ref_count(tmp))
@@ -349,6 +391,8 @@ static int x509_store_add(X509_STORE *store, void *x, int crl) {
         X509_OBJECT_free(obj);
         return 0;
     }
+    if (!crl)
+        obj->data.x509 = X509_intern(obj->data.x509);
 
     X509_STORE_lock(store);
     if (X509_OBJECT_retrieve_match(store->objs, obj)) {
@@ -356,6 +400,9 @@ static int x509_store_add(X509_STORE *store, void *x, int crl) {
     } else {
         added = sk_X509_OBJECT_push(store->objs, obj);
         ret = added != 0;
+        /* Cached chains may not hold up against the new CRL or certificate */
+        if (added)
+            x509_chain_cache_flush_locked(store);
     }
     X509_STORE_unlock(store);
 
@@ -367,6 +414,13 @@ static int x509_store_add(X509_STORE *store, void *x, int crl) {
 
 int X509_STORE_add_cert(X509_STORE *ctx, X509 *x)
 {
+    /*
+     * Cache the extensions while the certificate is likely still private to
+     * the caller, rather than on first use by whichever verifying threads
+     * happen to get there together.
+     */
+    if (x != NULL)
+        (void)X509_check_purpose(x, -1, 0);
     if (!x509_store_add(ctx, x, 0)) {
         X509err(X509_F_X509_STORE_ADD_CERT, ERR_R_MALLOC_FAILURE);
         return 0;
@@ -543,7 +597,7 @@ STACK_OF(X509) *X509_STORE_CTX_get1_certs(X509_STORE_CTX *ctx, X509_NAME *nm)
     if (store == NULL)
         return NULL;
 
-    X509_STORE_lock(store);
+    x509_store_read_lock(store);
     idx = x509_object_idx_cnt(store->objs, X509_LU_X509, nm, &cnt);
     if (idx < 0) {
         /*
@@ -561,7 +615,7 @@ STACK_OF(X509) *X509_STORE_CTX_get1_certs(X509_STORE_CTX *ctx, X509_NAME *nm)
             return NULL;
         }
         X509_OBJECT_free(xobj);
-        X509_STORE_lock(store);
+        x509_store_read_lock(store);
         idx = x509_object_idx_cnt(store->objs, X509_LU_X509, nm, &cnt);
         if (idx < 0) {
             X509_STORE_unlock(store);
@@ -607,7 +661,7 @@ STACK_OF(X509_CRL) *X509_STORE_CTX_get1_crls(X509_STORE_CTX *ctx, X509_NAME *nm)
         return NULL;
     }
     X509_OBJECT_free(xobj);
-    X509_STORE_lock(store);
+    x509_store_read_lock(store);
     idx = x509_object_idx_cnt(store->objs, X509_LU_CRL, nm, &cnt);
     if (idx < 0) {
         X509_STORE_unlock(store);
@@ -709,7 +763,7 @@ int X509_STORE_CTX_get1_issuer(X509 **issuer, X509_STORE_CTX *ctx, X509 *x)
 
     /* Else find index of first cert accepted by 'check_issued' */
     ret = 0;
-    X509_STORE_lock(store);
+    x509_store_read_lock(store);
     idx = X509_OBJECT_idx_by_subject(store->objs, X509_LU_X509, xn);
     if (idx != -1) {            /* should be true as we've had at least one
                                  * match */
@@ -719,7 +773,7 @@ int X509_STORE_CTX_get1_issuer(X509 **issuer, X509_STORE_CTX *ctx, X509 *x)
             /* See if we've run past the matches */
             if (pobj->type != X509_LU_X509)
                 break;
-            if (X509_NAME_cmp(xn, X509_get_subject_name(pobj->data.x509)))
+            if (!x509_name_equal(xn, X509_get_subject_name(pobj->data.x509)))
                 break;
             if (ctx->check_issued(ctx, x, pobj->data.x509)) {
                 *issuer = pobj->data.x509;
@@ -785,6 +839,16 @@ X509_STORE_CTX_verify_fn X509_STORE_get_verify(X509_STORE *ctx)
     return ctx->verify;
 }
 
+void X509_STORE_set0_worker_pool(X509_STORE *ctx, OSSL_WORKER_POOL *pool)
+{
+    ctx->worker_pool = pool;
+}
+
+OSSL_WORKER_POOL *X509_STORE_get0_worker_pool(X509_STORE *ctx)
+{
+    return ctx->worker_pool;
+}
+
 void X509_STORE_set_verify_cb(X509_STORE *ctx,
                               X509_STORE_CTX_verify_cb verify_cb)
 {
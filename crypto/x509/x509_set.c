@@ -108,6 +108,18 @@ int X509_up_ref(X509 *x)
     return ((i > 1) ? 1 : 0);
 }
 
+int X509_freeze(X509 *x)
+{
+    EVP_PKEY *pkey;
+
+    /* Fill in the extension cache, which is otherwise written on first use */
+    X509_check_purpose(x, -1, 0);
+    if ((pkey = X509_get0_pubkey(x)) != NULL && !EVP_PKEY_freeze(pkey))
+        return 0;
+    CRYPTO_REF_FREEZE(&x->references);
+    return 1;
+}
+
 long X509_get_version(const X509 *x)
 {
     return ASN1_INTEGER_get(x->cert_info.version);
@@ -0,0 +1,362 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <string.h>
+#include <time.h>
+#include "internal/cryptlib.h"
+#include <openssl/evp.h>
+#include <openssl/lhash.h>
+#include <openssl/x509.h>
+#include "crypto/x509.h"
+#include "x509_local.h"
+
+/*
+ * A cache of successfully verified chains, keyed by the certificates the
+ * peer presented and the verification parameters. Entries are kept in an
+ * LRU list, most recently used at the head.
+ */
+typedef struct x509_chain_cache_entry_st X509_CHAIN_CACHE_ENTRY;
+
+struct x509_chain_cache_entry_st {
+    unsigned char key[X509_CHAIN_CACHE_KEY_LEN];
+    STACK_OF(X509) *chain;
+    int num_untrusted;
+    time_t expires;
+    X509_CHAIN_CACHE_ENTRY *prev, *next;
+};
+
+DEFINE_LHASH_OF(X509_CHAIN_CACHE_ENTRY);
+
+struct x509_chain_cache_st {
+    LHASH_OF(X509_CHAIN_CACHE_ENTRY) *entries;
+    X509_CHAIN_CACHE_ENTRY *head, *tail;
+    size_t max_entries;
+    long timeout;
+};
+
+static unsigned long chain_entry_hash(const X509_CHAIN_CACHE_ENTRY *e)
+{
+    return (unsigned long)e->key[0] | ((unsigned long)e->key[1] << 8)
+        | ((unsigned long)e->key[2] << 16) | ((unsigned long)e->key[3] << 24);
+}
+
+static int chain_entry_cmp(const X509_CHAIN_CACHE_ENTRY *a,
+                           const X509_CHAIN_CACHE_ENTRY *b)
+{
+    return memcmp(a->key, b->key, sizeof(a->key));
+}
+
+static void chain_entry_free(X509_CHAIN_CACHE_ENTRY *e)
+{
+    sk_X509_pop_free(e->chain, X509_free);
+    OPENSSL_free(e);
+}
+
+static void chain_list_remove(X509_CHAIN_CACHE *cache,
+                              X509_CHAIN_CACHE_ENTRY *e)
+{
+    if (e->prev != NULL)
+        e->prev->next = e->next;
+    else
+        cache->head = e->next;
+    if (e->next != NULL)
+        e->next->prev = e->prev;
+    else
+        cache->tail = e->prev;
+    e->prev = e->next = NULL;
+}
+
+static void chain_list_add_head(X509_CHAIN_CACHE *cache,
+                                X509_CHAIN_CACHE_ENTRY *e)
+{
+    e->prev = NULL;
+    e->next = cache->head;
+    if (cache->head != NULL)
+        cache->head->prev = e;
+    else
+        cache->tail = e;
+    cache->head = e;
+}
+
+static void chain_cache_remove(X509_CHAIN_CACHE *cache,
+                               X509_CHAIN_CACHE_ENTRY *e)
+{
+    (void)lh_X509_CHAIN_CACHE_ENTRY_delete(cache->entries, e);
+    chain_list_remove(cache, e);
+    chain_entry_free(e);
+}
+
+/* Returns a copy of |sk| that holds its own references */
+static STACK_OF(X509) *chain_dup(STACK_OF(X509) *sk)
+{
+    STACK_OF(X509) *ret = sk_X509_dup(sk);
+    int i;
+
+    if (ret == NULL)
+        return NULL;
+    for (i = 0; i < sk_X509_num(ret); i++) {
+        if (!X509_up_ref(sk_X509_value(ret, i))) {
+            while (i-- > 0)
+                X509_free(sk_X509_value(ret, i));
+            sk_X509_free(ret);
+            return NULL;
+        }
+    }
+    return ret;
+}
+
+static int digest_cert(EVP_MD_CTX *mdctx, X509 *x)
+{
+    unsigned char md[EVP_MAX_MD_SIZE];
+    unsigned int len;
+
+    return X509_digest(x, EVP_sha256(), md, &len)
+        && EVP_DigestUpdate(mdctx, md, len);
+}
+
+static int digest_str(EVP_MD_CTX *mdctx, const void *str, size_t len)
+{
+    uint64_t l = (uint64_t)len;
+
+    return EVP_DigestUpdate(mdctx, &l, sizeof(l))
+        && (len == 0 || EVP_DigestUpdate(mdctx, str, len));
+}
+
+/*
+ * Derive the cache key of |ctx| from the DER of the target and the
+ * untrusted certificates, in order, and everything in the verification
+ * parameters that can change the outcome.
+ */
+static int chain_cache_key(X509_STORE_CTX *ctx, unsigned char *key)
+{
+    const X509_VERIFY_PARAM *param = ctx->param;
+    EVP_MD_CTX *mdctx;
+    struct {
+        unsigned long flags;
+        int purpose, trust, depth, auth_level;
+        unsigned int hostflags;
+        int64_t check_time;
+        int num_untrusted, num_hosts;
+    } p;
+    unsigned int len;
+    int i, ret = 0;
+
+    memset(&p, 0, sizeof(p));
+    p.flags = param->flags;
+    p.purpose = param->purpose;
+    p.trust = param->trust;
+    p.depth = param->depth;
+    p.auth_level = param->auth_level;
+    p.hostflags = param->hostflags;
+    if ((param->flags & X509_V_FLAG_USE_CHECK_TIME) != 0)
+        p.check_time = (int64_t)param->check_time;
+    p.num_untrusted = sk_X509_num(ctx->untrusted);
+    p.num_hosts = sk_OPENSSL_STRING_num(param->hosts);
+
+    if ((mdctx = EVP_MD_CTX_new()) == NULL
+            || !EVP_DigestInit_ex(mdctx, EVP_sha256(), NULL)
+            || !EVP_DigestUpdate(mdctx, &p, sizeof(p))
+            || !digest_cert(mdctx, ctx->cert))
+        goto end;
+    for (i = 0; i < p.num_untrusted; i++)
+        if (!digest_cert(mdctx, sk_X509_value(ctx->untrusted, i)))
+            goto end;
+    for (i = 0; i < p.num_hosts; i++) {
+        const char *host = sk_OPENSSL_STRING_value(param->hosts, i);
+
+        if (!digest_str(mdctx, host, strlen(host)))
+            goto end;
+    }
+    if (!digest_str(mdctx, param->email, param->emaillen)
+            || !digest_str(mdctx, param->ip, param->iplen)
+            || !EVP_DigestFinal_ex(mdctx, key, &len)
+            || !ossl_assert(len == X509_CHAIN_CACHE_KEY_LEN))
+        goto end;
+    ret = 1;
+
+ end:
+    EVP_MD_CTX_free(mdctx);
+    return ret;
+}
+
+/*
+ * Look up the chain of |ctx| in the cache of its store. The caller has made
+ * sure that nothing but the certificates and parameters affects the result.
+ * Returns 1 and fills in the chain of |ctx| on a hit. Returns 0 on a miss,
+ * with |key| and |gen| set for a later x509_chain_cache_put(), and -1 if the
+ * result must not be cached.
+ */
+int x509_chain_cache_get(X509_STORE_CTX *ctx, unsigned char *key,
+                         unsigned long *gen)
+{
+    X509_STORE *store = ctx->ctx;
+    X509_CHAIN_CACHE *cache;
+    X509_CHAIN_CACHE_ENTRY tmp, *e;
+    STACK_OF(X509) *chain = NULL;
+    int num_untrusted = 0, i;
+
+    CRYPTO_THREAD_read_lock(store->lock);
+    cache = store->chain_cache;
+    *gen = store->chain_cache_gen;
+    CRYPTO_THREAD_unlock(store->lock);
+    if (cache == NULL || !chain_cache_key(ctx, key))
+        return -1;
+
+    memcpy(tmp.key, key, sizeof(tmp.key));
+    X509_STORE_lock(store);
+    cache = store->chain_cache;
+    if (cache != NULL
+            && (e = lh_X509_CHAIN_CACHE_ENTRY_retrieve(cache->entries,
+                                                       &tmp)) != NULL) {
+        if (e->expires <= time(NULL)) {
+            chain_cache_remove(cache, e);
+        } else {
+            chain_list_remove(cache, e);
+            chain_list_add_head(cache, e);
+            chain = chain_dup(e->chain);
+            num_untrusted = e->num_untrusted;
+        }
+    }
+    X509_STORE_unlock(store);
+    if (chain == NULL)
+        return 0;
+
+    /* The certificates may have expired since they were verified */
+    for (i = 0; i < sk_X509_num(chain); i++)
+        if (!x509_check_cert_time(ctx, sk_X509_value(chain, i), -1))
+            break;
+    /*
+     * The leaf already made it into the chain of |ctx|, the rest of the
+     * cached chain is appended behind it
+     */
+    if (i == sk_X509_num(chain)) {
+        for (i = 1; i < sk_X509_num(chain); i++) {
+            if (!sk_X509_push(ctx->chain, sk_X509_value(chain, i)))
+                break;
+            sk_X509_set(chain, i, NULL);
+        }
+        if (i == sk_X509_num(chain)) {
+            sk_X509_pop_free(chain, X509_free);
+            ctx->num_untrusted = num_untrusted;
+            ctx->error = X509_V_OK;
+            ctx->error_depth = 0;
+            ctx->current_cert = ctx->cert;
+            return 1;
+        }
+        /* Undo the partial append and verify the long way */
+        while (sk_X509_num(ctx->chain) > 1)
+            X509_free(sk_X509_pop(ctx->chain));
+    }
+    sk_X509_pop_free(chain, X509_free);
+    return 0;
+}
+
+/*
+ * Remember the chain |ctx| just verified under |key|, unless the store has
+ * changed since x509_chain_cache_get() read generation |gen|.
+ */
+void x509_chain_cache_put(X509_STORE_CTX *ctx, const unsigned char *key,
+                          unsigned long gen)
+{
+    X509_STORE *store = ctx->ctx;
+    X509_CHAIN_CACHE *cache;
+    X509_CHAIN_CACHE_ENTRY *e, *old;
+
+    if ((e = OPENSSL_zalloc(sizeof(*e))) == NULL)
+        return;
+    if ((e->chain = chain_dup(ctx->chain)) == NULL) {
+        OPENSSL_free(e);
+        return;
+    }
+    memcpy(e->key, key, sizeof(e->key));
+    e->num_untrusted = ctx->num_untrusted;
+
+    X509_STORE_lock(store);
+    cache = store->chain_cache;
+    if (cache == NULL || gen != store->chain_cache_gen)
+        goto end;
+
+    if ((old = lh_X509_CHAIN_CACHE_ENTRY_retrieve(cache->entries, e)) != NULL)
+        chain_cache_remove(cache, old);
+    while (cache->tail != NULL
+           && lh_X509_CHAIN_CACHE_ENTRY_num_items(cache->entries)
+              >= cache->max_entries)
+        chain_cache_remove(cache, cache->tail);
+
+    e->expires = time(NULL) + cache->timeout;
+    (void)lh_X509_CHAIN_CACHE_ENTRY_insert(cache->entries, e);
+    if (lh_X509_CHAIN_CACHE_ENTRY_error(cache->entries) == 0) {
+        chain_list_add_head(cache, e);
+        e = NULL;
+    }
+
+ end:
+    X509_STORE_unlock(store);
+    if (e != NULL)
+        chain_entry_free(e);
+}
+
+/* Drop all cached chains of |store|, which the caller has locked */
+void x509_chain_cache_flush_locked(X509_STORE *store)
+{
+    X509_CHAIN_CACHE *cache = store->chain_cache;
+
+    store->chain_cache_gen++;
+    if (cache == NULL)
+        return;
+    while (cache->head != NULL)
+        chain_cache_remove(cache, cache->head);
+}
+
+void x509_chain_cache_free(X509_CHAIN_CACHE *cache)
+{
+    if (cache == NULL)
+        return;
+    while (cache->head != NULL)
+        chain_cache_remove(cache, cache->head);
+    lh_X509_CHAIN_CACHE_ENTRY_free(cache->entries);
+    OPENSSL_free(cache);
+}
+
+int X509_STORE_set_chain_cache(X509_STORE *store, size_t max_entries,
+                               long timeout)
+{
+    X509_CHAIN_CACHE *cache = NULL, *old;
+
+    if (max_entries > 0) {
+        if (timeout <= 0)
+            return 0;
+        if ((cache = OPENSSL_zalloc(sizeof(*cache))) == NULL
+                || (cache->entries =
+                    lh_X509_CHAIN_CACHE_ENTRY_new(chain_entry_hash,
+                                                  chain_entry_cmp)) == NULL) {
+            OPENSSL_free(cache);
+            X509err(X509_F_X509_STORE_SET_CHAIN_CACHE, ERR_R_MALLOC_FAILURE);
+            return 0;
+        }
+        cache->max_entries = max_entries;
+        cache->timeout = timeout;
+    }
+
+    X509_STORE_lock(store);
+    old = store->chain_cache;
+    store->chain_cache = cache;
+    store->chain_cache_gen++;
+    X509_STORE_unlock(store);
+
+    x509_chain_cache_free(old);
+    return 1;
+}
+
+void X509_STORE_flush_chain_cache(X509_STORE *store)
+{
+    X509_STORE_lock(store);
+    x509_chain_cache_flush_locked(store);
+    X509_STORE_unlock(store);
+}
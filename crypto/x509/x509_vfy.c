@@ -21,6 +21,7 @@
 #include <openssl/x509.h>
 #include <openssl/x509v3.h>
 #include <openssl/objects.h>
+#include <openssl/async.h>
 #include "internal/dane.h"
 #include "crypto/x509.h"
 #include "x509_local.h"
@@ -74,6 +75,8 @@ static int check_name_constraints(X509_STORE_CTX *ctx);
 static int check_id(X509_STORE_CTX *ctx);
 static int check_trust(X509_STORE_CTX *ctx, int num_untrusted);
 static int check_revocation(X509_STORE_CTX *ctx);
+static int check_crl(X509_STORE_CTX *ctx, X509_CRL *crl);
+static int cert_crl(X509_STORE_CTX *ctx, X509_CRL *crl, X509 *x);
 static int check_cert(X509_STORE_CTX *ctx);
 static int check_policy(X509_STORE_CTX *ctx);
 static int get_issuer_sk(X509 **issuer, X509_STORE_CTX *ctx, X509 *x);
@@ -251,10 +254,42 @@ static int verify_chain(X509_STORE_CTX *ctx)
     return ok;
 }
 
+/*
+ * A cached chain stands in for the whole verification, which is only right
+ * if nothing but the certificates and the parameters can change the outcome:
+ * no callbacks, no other sources of trust or CRLs, no DANE and no policy
+ * tree the caller may want to inspect.
+ */
+static int chain_cache_usable(X509_STORE_CTX *ctx)
+{
+    return ctx->ctx != NULL
+        && !DANETLS_ENABLED(ctx->dane)
+        && ctx->other_ctx == NULL
+        && ctx->crls == NULL
+        /* CRLs can expire or turn up in a lookup while a chain is cached */
+        && (ctx->param->flags
+            & (X509_V_FLAG_CRL_CHECK | X509_V_FLAG_CRL_CHECK_ALL)) == 0
+        && ctx->param->policies == NULL
+        && (ctx->param->flags & X509_V_FLAG_POLICY_CHECK) == 0
+        && ctx->verify_cb == null_callback
+        && ctx->verify == internal_verify
+        && ctx->get_issuer == X509_STORE_CTX_get1_issuer
+        && ctx->check_issued == check_issued
+        && ctx->check_revocation == check_revocation
+        && ctx->get_crl == NULL
+        && ctx->check_crl == check_crl
+        && ctx->cert_crl == cert_crl
+        && ctx->check_policy == check_policy
+        && ctx->lookup_certs == X509_STORE_CTX_get1_certs
+        && ctx->lookup_crls == X509_STORE_CTX_get1_crls;
+}
+
 int X509_verify_cert(X509_STORE_CTX *ctx)
 {
     SSL_DANE *dane = ctx->dane;
-    int ret;
+    unsigned char key[X509_CHAIN_CACHE_KEY_LEN];
+    unsigned long gen = 0;
+    int ret, cached = -1;
 
     if (ctx->cert == NULL) {
         X509err(X509_F_X509_VERIFY_CERT, X509_R_NO_CERT_SET_FOR_US_TO_VERIFY);
@@ -297,11 +332,22 @@ int X509_verify_cert(X509_STORE_CTX *ctx)
         !verify_cb_cert(ctx, ctx->cert, 0, X509_V_ERR_EE_KEY_TOO_SMALL))
         return 0;
 
+    /*
+     * A cached chain matched the same names, but they are checked again to
+     * record the name that matched as the peername
+     */
+    if (chain_cache_usable(ctx)
+            && (cached = x509_chain_cache_get(ctx, key, &gen)) == 1)
+        return check_id(ctx);
+
     if (DANETLS_ENABLED(dane))
         ret = dane_verify(ctx);
     else
         ret = verify_chain(ctx);
 
+    if (cached == 0 && ret > 0 && ctx->error == X509_V_OK)
+        x509_chain_cache_put(ctx, key, gen);
+
     /*
      * Safety-net.  If we are returning an error, we must also set ctx->error,
      * so that the chain is not considered verified should the error be ignored
@@ -375,7 +421,7 @@ static STACK_OF(X509) *lookup_certs_sk(X509_STORE_CTX *ctx, X509_NAME *nm)
 
     for (i = 0; i < sk_X509_num(ctx->other_ctx); i++) {
         x = sk_X509_value(ctx->other_ctx, i);
-        if (X509_NAME_cmp(nm, X509_get_subject_name(x)) == 0) {
+        if (x509_name_equal(nm, X509_get_subject_name(x))) {
             if (!X509_up_ref(x)) {
                 sk_X509_pop_free(sk, X509_free);
                 X509err(X509_F_LOOKUP_CERTS_SK, ERR_R_INTERNAL_ERROR);
@@ -1734,8 +1780,84 @@ int x509_check_cert_time(X509_STORE_CTX *ctx, X509 *x, int depth)
     return 1;
 }
 
-/* verify the issuer signatures and cert times of ctx->chain */
-static int internal_verify(X509_STORE_CTX *ctx)
+/* A signature check handed to the application's dispatcher */
+typedef struct {
+    X509 *subject;
+    EVP_PKEY *pkey;
+    int result;
+} SIG_JOB;
+
+static void sig_job_run(void *arg)
+{
+    SIG_JOB *job = arg;
+
+    job->result = X509_verify(job->subject, job->pkey);
+}
+
+/*
+ * Check the signatures of the chain links below the top certificate through
+ * ctx->sig_dispatch, so that they can run concurrently.  The results are
+ * picked up by verify_links(), which reports them in the usual order.  Only
+ * the signature checks are dispatched, everything else, and in particular
+ * every call to the verify callback, happens in verify_links() as before.
+ *
+ * Returns the jobs indexed by subject depth, or NULL if the signatures are
+ * to be checked inline.
+ */
+static SIG_JOB *dispatch_sig_checks(X509_STORE_CTX *ctx)
+{
+    int i, n = sk_X509_num(ctx->chain) - 1, njobs = 0;
+    SIG_JOB *jobs;
+    void **args;
+
+    /* A single signature check has nothing to run alongside */
+    if (ctx->sig_dispatch == NULL || n < 2)
+        return NULL;
+
+    jobs = OPENSSL_zalloc(n * (sizeof(*jobs) + sizeof(*args)));
+    if (jobs == NULL)
+        return NULL;
+    args = (void **)(jobs + n);
+    for (i = 0; i < n; i++) {
+        X509 *xi = sk_X509_value(ctx->chain, i + 1);
+
+        /* A missing key is reported by verify_links() */
+        if ((jobs[i].pkey = X509_get0_pubkey(xi)) == NULL)
+            continue;
+        jobs[i].subject = sk_X509_value(ctx->chain, i);
+        args[njobs++] = &jobs[i];
+    }
+
+    if (njobs < 2
+        || !ctx->sig_dispatch(ctx, sig_job_run, args, njobs,
+                              ctx->sig_dispatch_arg)) {
+        OPENSSL_free(jobs);
+        return NULL;
+    }
+    return jobs;
+}
+
+/* Check the signature of xs, the certificate at depth n, with pkey of xi */
+static int verify_sig(X509_STORE_CTX *ctx, const SIG_JOB *jobs, int n,
+                      X509 *xs, X509 *xi, EVP_PKEY *pkey)
+{
+    unsigned char key[X509_SIG_MEMO_KEY_LEN];
+    int memo = ctx->sig_memo != NULL && x509_sig_memo_key(xs, xi, key);
+    int ret;
+
+    if (memo && x509_sig_memo_get(ctx->sig_memo, key))
+        return 1;
+    if (jobs != NULL && xs != xi && jobs[n].pkey == pkey)
+        ret = jobs[n].result;
+    else
+        ret = X509_verify(xs, pkey);
+    if (ret > 0 && memo)
+        x509_sig_memo_put(ctx->sig_memo, key);
+    return ret;
+}
+
+/* jobs holds the results of dispatch_sig_checks(), if any */
+static int verify_links(X509_STORE_CTX *ctx, const SIG_JOB *jobs)
 {
     int n = sk_X509_num(ctx->chain) - 1;
     X509 *xi = sk_X509_value(ctx->chain, n);
@@ -1819,7 +1941,7 @@ static int internal_verify(X509_STORE_CTX *ctx)
                 ret = X509_V_ERR_UNABLE_TO_DECODE_ISSUER_PUBLIC_KEY;
                 if (!verify_cb_cert(ctx, xi, issuer_depth, ret))
                     return 0;
-            } else if (X509_verify(xs, pkey) <= 0) {
+            } else if (verify_sig(ctx, jobs, n, xs, xi, pkey) <= 0) {
                 ret = X509_V_ERR_CERT_SIGNATURE_FAILURE;
                 if (!verify_cb_cert(ctx, xs, n, ret))
                     return 0;
@@ -1849,6 +1971,16 @@ static int internal_verify(X509_STORE_CTX *ctx)
     return 1;
 }
 
+/* verify the issuer signatures and cert times of ctx->chain */
+static int internal_verify(X509_STORE_CTX *ctx)
+{
+    SIG_JOB *jobs = dispatch_sig_checks(ctx);
+    int ret = verify_links(ctx, jobs);
+
+    OPENSSL_free(jobs);
+    return ret;
+}
+
 int X509_cmp_current_time(const ASN1_TIME *ctm)
 {
     return X509_cmp_time(ctm, NULL);
@@ -2298,6 +2430,11 @@ int X509_STORE_CTX_init(X509_STORE_CTX *ctx, X509_STORE *store, X509 *x509,
     ctx->parent = NULL;
     ctx->dane = NULL;
     ctx->bare_ta_signed = 0;
+    ctx->sig_dispatch = NULL;
+    ctx->sig_dispatch_arg = NULL;
+    if (store != NULL && store->worker_pool != NULL)
+        X509_STORE_CTX_set0_worker_pool(ctx, store->worker_pool);
+    ctx->sig_memo = NULL;
     /* Zero ex_data to make sure we're cleanup-safe */
     memset(&ctx->ex_data, 0, sizeof(ctx->ex_data));
 
@@ -2502,6 +2639,30 @@ void X509_STORE_CTX_set_verify(X509_STORE_CTX *ctx,
     ctx->verify = verify;
 }
 
+void X509_STORE_CTX_set_sig_dispatch(X509_STORE_CTX *ctx,
+                                     X509_STORE_CTX_sig_dispatch_fn dispatch,
+                                     void *arg)
+{
+    ctx->sig_dispatch = dispatch;
+    ctx->sig_dispatch_arg = arg;
+}
+
+static int worker_pool_dispatch(X509_STORE_CTX *ctx, void (*run)(void *job),
+                                void **jobs, int njobs, void *arg)
+{
+    OSSL_WORKER_POOL_run_all(arg, run, jobs, (size_t)njobs);
+    return 1;
+}
+
+void X509_STORE_CTX_set0_worker_pool(X509_STORE_CTX *ctx,
+                                     OSSL_WORKER_POOL *pool)
+{
+    if (pool == NULL)
+        X509_STORE_CTX_set_sig_dispatch(ctx, NULL, NULL);
+    else
+        X509_STORE_CTX_set_sig_dispatch(ctx, worker_pool_dispatch, pool);
+}
+
 X509_STORE_CTX_verify_fn X509_STORE_CTX_get_verify(X509_STORE_CTX *ctx)
 {
     return ctx->verify;
@@ -2638,8 +2799,13 @@ static int dane_match(X509_STORE_CTX *ctx, X509 *cert, int depth)
     unsigned selector = DANETLS_NONE;
     unsigned ordinal = DANETLS_NONE;
     unsigned mtype = DANETLS_NONE;
-    unsigned char *i2dbuf = NULL;
-    unsigned int i2dlen = 0;
+    /* DER forms and standard digests of |cert|, computed on first use */
+    unsigned char *i2dbuf[DANETLS_SELECTOR_LAST + 1] = { NULL };
+    unsigned int i2dlen[DANETLS_SELECTOR_LAST + 1] = { 0 };
+    unsigned char mdcache[DANETLS_SELECTOR_LAST + 1]
+                         [DANETLS_MATCHING_LAST + 1][EVP_MAX_MD_SIZE];
+    unsigned int mdlen[DANETLS_SELECTOR_LAST + 1]
+                      [DANETLS_MATCHING_LAST + 1] = { { 0 } };
     unsigned char mdbuf[EVP_MAX_MD_SIZE];
     unsigned char *cmpbuf = NULL;
     unsigned int cmplen = 0;
@@ -2680,13 +2846,11 @@ static int dane_match(X509_STORE_CTX *ctx, X509 *cert, int depth)
      * usages in SSL_dane_tlsa_add(), and also on descending sorting of digest
      * priorities.  See twin comment in ssl/ssl_lib.c.
      *
-     * We expect that most TLSA RRsets will have just a single usage, so we
-     * don't go out of our way to cache multiple selector-specific i2d buffers
-     * across usages, but if the selector happens to remain the same as switch
-     * usages, that's OK.  Thus, a set of "3 1 1", "3 0 1", "1 1 1", "1 0 1",
-     * records would result in us generating each of the certificate and public
-     * key DER forms twice, but more typically we'd just see multiple "3 1 1"
-     * or multiple "3 0 1" records.
+     * The certificate and public key DER forms, and their digests with the
+     * standard matching types, are each computed at most once per call, so a
+     * set of "3 1 1", "3 0 1", "1 1 1", "1 0 1" records costs no more than a
+     * set of "3 1 1", "3 0 1" records.  Digests with other matching types are
+     * recomputed for every record that uses them.
      *
      * As soon as we find a match at any given depth, we stop, because either
      * we've matched a DANE-?? record and the peer is authenticated, or, after
@@ -2709,10 +2873,13 @@ static int dane_match(X509_STORE_CTX *ctx, X509 *cert, int depth)
             selector = t->selector;
 
             /* Update per-selector state */
-            OPENSSL_free(i2dbuf);
-            i2dbuf = dane_i2d(cert, selector, &i2dlen);
-            if (i2dbuf == NULL)
-                return -1;
+            if (i2dbuf[selector] == NULL) {
+                i2dbuf[selector] = dane_i2d(cert, selector, &i2dlen[selector]);
+                if (i2dbuf[selector] == NULL) {
+                    matched = -1;
+                    break;
+                }
+            }
 
             /* Reset digest agility for each usage/selector pair */
             mtype = DANETLS_NONE;
@@ -2732,19 +2899,30 @@ static int dane_match(X509_STORE_CTX *ctx, X509 *cert, int depth)
         }
 
         /*
-         * Each time we hit a (new selector or) mtype, re-compute the relevant
-         * digest, more complex caching is not worth the code space.
+         * Each time we hit a (new selector or) mtype, look up the relevant
+         * digest, computing it unless it is a standard one computed earlier.
          */
         if (t->mtype != mtype) {
             const EVP_MD *md = dane->dctx->mdevp[mtype = t->mtype];
-            cmpbuf = i2dbuf;
-            cmplen = i2dlen;
+            cmpbuf = i2dbuf[selector];
+            cmplen = i2dlen[selector];
 
             if (md != NULL) {
+                unsigned int *cachedlen = NULL;
+
                 cmpbuf = mdbuf;
-                if (!EVP_Digest(i2dbuf, i2dlen, cmpbuf, &cmplen, md, 0)) {
+                if (mtype <= DANETLS_MATCHING_LAST) {
+                    cmpbuf = mdcache[selector][mtype];
+                    cachedlen = &mdlen[selector][mtype];
+                }
+                if (cachedlen != NULL && *cachedlen != 0) {
+                    cmplen = *cachedlen;
+                } else if (!EVP_Digest(i2dbuf[selector], i2dlen[selector],
+                                       cmpbuf, &cmplen, md, 0)) {
                     matched = -1;
                     break;
+                } else if (cachedlen != NULL) {
+                    *cachedlen = cmplen;
                 }
             }
         }
@@ -2769,8 +2947,9 @@ static int dane_match(X509_STORE_CTX *ctx, X509 *cert, int depth)
         }
     }
 
-    /* Clear the one-element DER cache */
-    OPENSSL_free(i2dbuf);
+    /* Clear the DER cache */
+    for (i = 0; i <= DANETLS_SELECTOR_LAST; ++i)
+        OPENSSL_free(i2dbuf[i]);
     return matched;
 }
 
@@ -76,6 +76,16 @@ int X509_CRL_up_ref(X509_CRL *crl)
     return ((i > 1) ? 1 : 0);
 }
 
+int X509_CRL_freeze(X509_CRL *crl)
+{
+    /* Lookups sort the revoked entries on first use otherwise */
+    CRYPTO_THREAD_write_lock(crl->lock);
+    sk_X509_REVOKED_sort(crl->crl.revoked);
+    CRYPTO_THREAD_unlock(crl->lock);
+    CRYPTO_REF_FREEZE(&crl->references);
+    return 1;
+}
+
 long X509_CRL_get_version(const X509_CRL *crl)
 {
     return ASN1_INTEGER_get(crl->crl.version);
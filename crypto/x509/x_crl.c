@@ -149,6 +149,50 @@ static int crl_set_issuers(X509_CRL *crl)
 
 }
 
+static size_t crl_serial_hash(const ASN1_INTEGER *serial)
+{
+    size_t h = (size_t)serial->type;
+    int i;
+
+    for (i = 0; i < serial->length; i++)
+        h = h * 31 + serial->data[i];
+    return h;
+}
+
+/*
+ * Index the revoked entries of a decoded CRL by serial number, in an open
+ * addressing hash table with a load factor of at most one half. This takes
+ * linear time, where sorting the entries for binary search, as
+ * def_crl_lookup() otherwise does on first use, is O(n log n) and needs the
+ * CRL lock. The index is never modified once built, so it can be read by
+ * any number of threads. Entries with the same serial number stay in load
+ * order. If the index cannot be allocated lookups fall back to the sorted
+ * stack.
+ */
+static void crl_index_build(X509_CRL *crl)
+{
+    int i, num = sk_X509_REVOKED_num(crl->crl.revoked);
+    size_t size = 2, mask;
+
+    if (num <= 0 || crl->meth->crl_lookup != def_crl_lookup)
+        return;
+    while (size < (size_t)num * 2)
+        size <<= 1;
+    if ((crl->serial_index = OPENSSL_zalloc(size * sizeof(X509_REVOKED *)))
+        == NULL)
+        return;
+    mask = crl->serial_index_mask = size - 1;
+
+    for (i = 0; i < num; i++) {
+        X509_REVOKED *rev = sk_X509_REVOKED_value(crl->crl.revoked, i);
+        size_t j = crl_serial_hash(&rev->serialNumber) & mask;
+
+        while (crl->serial_index[j] != NULL)
+            j = (j + 1) & mask;
+        crl->serial_index[j] = rev;
+    }
+}
+
 /*
  * The X509_CRL structure needs a bit of customisation. Cache some extensions
  * and hash of the whole CRL.
@@ -172,6 +216,7 @@ static int crl_cb(int operation, ASN1_VALUE **pval, const ASN1_ITEM *it,
         ASN1_INTEGER_free(crl->crl_number);
         ASN1_INTEGER_free(crl->base_crl_number);
         sk_GENERAL_NAMES_pop_free(crl->issuers, GENERAL_NAMES_free);
+        OPENSSL_free(crl->serial_index);
         /* fall thru */
 
     case ASN1_OP_NEW_POST:
@@ -185,6 +230,8 @@ static int crl_cb(int operation, ASN1_VALUE **pval, const ASN1_ITEM *it,
         crl->issuers = NULL;
         crl->crl_number = NULL;
         crl->base_crl_number = NULL;
+        crl->serial_index = NULL;
+        crl->serial_index_mask = 0;
         break;
 
     case ASN1_OP_D2I_POST:
@@ -250,6 +297,8 @@ static int crl_cb(int operation, ASN1_VALUE **pval, const ASN1_ITEM *it,
         if (!crl_set_issuers(crl))
             return 0;
 
+        crl_index_build(crl);
+
         if (crl->meth->crl_init) {
             if (crl->meth->crl_init(crl) == 0)
                 return 0;
@@ -268,6 +317,7 @@ static int crl_cb(int operation, ASN1_VALUE **pval, const ASN1_ITEM *it,
         ASN1_INTEGER_free(crl->crl_number);
         ASN1_INTEGER_free(crl->base_crl_number);
         sk_GENERAL_NAMES_pop_free(crl->issuers, GENERAL_NAMES_free);
+        OPENSSL_free(crl->serial_index);
         break;
     }
     return 1;
@@ -347,6 +397,9 @@ int X509_CRL_add0_revoked(X509_CRL *crl, X509_REVOKED *rev)
         return 0;
     }
     inf->enc.modified = 1;
+    /* The index no longer covers all entries */
+    OPENSSL_free(crl->serial_index);
+    crl->serial_index = NULL;
     return 1;
 }
 
@@ -388,7 +441,7 @@ static int crl_revoked_issuer_match(X509_CRL *crl, X509_NAME *nm,
     if (!rev->issuer) {
         if (!nm)
             return 1;
-        if (!X509_NAME_cmp(nm, X509_CRL_get_issuer(crl)))
+        if (x509_name_equal(nm, X509_CRL_get_issuer(crl)))
             return 1;
         return 0;
     }
@@ -400,7 +453,7 @@ static int crl_revoked_issuer_match(X509_CRL *crl, X509_NAME *nm,
         GENERAL_NAME *gen = sk_GENERAL_NAME_value(rev->issuer, i);
         if (gen->type != GEN_DIRNAME)
             continue;
-        if (!X509_NAME_cmp(nm, gen->d.directoryName))
+        if (x509_name_equal(nm, gen->d.directoryName))
             return 1;
     }
     return 0;
@@ -417,6 +470,23 @@ static int def_crl_lookup(X509_CRL *crl,
     if (crl->crl.revoked == NULL)
         return 0;
 
+    if (crl->serial_index != NULL) {
+        size_t mask = crl->serial_index_mask;
+        size_t i = crl_serial_hash(serial) & mask;
+
+        for (; (rev = crl->serial_index[i]) != NULL; i = (i + 1) & mask) {
+            if (ASN1_INTEGER_cmp(&rev->serialNumber, serial)
+                || !crl_revoked_issuer_match(crl, issuer, rev))
+                continue;
+            if (ret)
+                *ret = rev;
+            if (rev->reason == CRL_REASON_REMOVE_FROM_CRL)
+                return 2;
+            return 1;
+        }
+        return 0;
+    }
+
     /*
      * Sort revoked into serial number order if not already sorted. Do this
      * under a lock to avoid race condition.
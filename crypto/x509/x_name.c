@@ -297,6 +297,18 @@ static int x509_name_ex_print(BIO *out, ASN1_VALUE **pval,
  * constraints of type dirName can also be checked with a simple memcmp().
  */
 
+/* FNV-1a, to tell most unequal canonical encodings apart in one compare */
+static uint64_t name_fingerprint(const unsigned char *p, int len)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    while (len-- > 0) {
+        h ^= *p++;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
 static int x509_name_canon(X509_NAME *a)
 {
     unsigned char *p;
@@ -310,6 +322,7 @@ static int x509_name_canon(X509_NAME *a)
     /* Special case: empty X509_NAME => null encoding */
     if (sk_X509_NAME_ENTRY_num(a->entries) == 0) {
         a->canon_enclen = 0;
+        a->canon_hash = name_fingerprint(NULL, 0);
         return 1;
     }
     intname = sk_STACK_OF_X509_NAME_ENTRY_new_null();
@@ -364,6 +377,7 @@ static int x509_name_canon(X509_NAME *a)
     a->canon_enc = p;
 
     i2d_name_canon(intname, &p);
+    a->canon_hash = name_fingerprint(a->canon_enc, a->canon_enclen);
 
     ret = 1;
 
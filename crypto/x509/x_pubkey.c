@@ -21,6 +21,10 @@ struct X509_pubkey_st {
     X509_ALGOR *algor;
     ASN1_BIT_STRING *public_key;
     EVP_PKEY *pkey;
+    /* Guards pkey if its decode was deferred, see pubkey_cb() */
+    CRYPTO_RWLOCK *lock;
+    /* Encoding that public_key may borrow from, see d2i_X509_shared() */
+    ASN1_SHARED_BUF *shared;
 };
 
 static int x509_pubkey_decode(EVP_PKEY **pk, X509_PUBKEY *key);
@@ -32,11 +36,26 @@ static int pubkey_cb(int operation, ASN1_VALUE **pval, const ASN1_ITEM *it,
     if (operation == ASN1_OP_FREE_POST) {
         X509_PUBKEY *pubkey = (X509_PUBKEY *)*pval;
         EVP_PKEY_free(pubkey->pkey);
+        CRYPTO_THREAD_lock_free(pubkey->lock);
+        ASN1_SHARED_BUF_free(pubkey->shared);
     } else if (operation == ASN1_OP_D2I_POST) {
         /* Attempt to decode public key and cache in pubkey structure. */
         X509_PUBKEY *pubkey = (X509_PUBKEY *)*pval;
         EVP_PKEY_free(pubkey->pkey);
         pubkey->pkey = NULL;
+        /*
+         * OQS public keys can be very large, while many certificates, e.g.
+         * those of a CA bundle, are parsed without their key ever being
+         * used. Leave decoding these to X509_PUBKEY_get0().
+         */
+        if (IS_OQS_OPENSSL_SIG_NID(OBJ_obj2nid(pubkey->algor->algorithm))) {
+            if (pubkey->lock == NULL
+                    && (pubkey->lock = CRYPTO_THREAD_lock_new()) == NULL) {
+                X509err(X509_F_PUBKEY_CB, ERR_R_MALLOC_FAILURE);
+                return 0;
+            }
+            return 1;
+        }
         /*
          * Opportunistically decode the key but remove any non fatal errors
          * from the queue. Subsequent explicit attempts to decode/use the key
@@ -145,6 +164,24 @@ EVP_PKEY *X509_PUBKEY_get0(X509_PUBKEY *key)
     if (key == NULL || key->public_key == NULL)
         return NULL;
 
+    if (key->lock != NULL) {
+        /* Decode deferred by pubkey_cb(), an X509 may be shared by threads */
+        if (!CRYPTO_THREAD_read_lock(key->lock))
+            return NULL;
+        ret = key->pkey;
+        CRYPTO_THREAD_unlock(key->lock);
+        if (ret != NULL)
+            return ret;
+
+        if (!CRYPTO_THREAD_write_lock(key->lock))
+            return NULL;
+        if (key->pkey == NULL)
+            x509_pubkey_decode(&key->pkey, key);
+        ret = key->pkey;
+        CRYPTO_THREAD_unlock(key->lock);
+        return ret;
+    }
+
     if (key->pkey != NULL)
         return key->pkey;
 
@@ -345,9 +382,7 @@ int X509_PUBKEY_set0_param(X509_PUBKEY *pub, ASN1_OBJECT *aobj,
     if (!X509_ALGOR_set0(pub->algor, aobj, ptype, pval))
         return 0;
     if (penc) {
-        OPENSSL_free(pub->public_key->data);
-        pub->public_key->data = penc;
-        pub->public_key->length = penclen;
+        ASN1_STRING_set0(pub->public_key, penc, penclen);
         /* Set number of unused bits to zero */
         pub->public_key->flags &= ~(ASN1_STRING_FLAG_BITS_LEFT | 0x07);
         pub->public_key->flags |= ASN1_STRING_FLAG_BITS_LEFT;
@@ -370,6 +405,27 @@ int X509_PUBKEY_get0_param(ASN1_OBJECT **ppkalg,
     return 1;
 }
 
+/* Record that |key|'s public key may be borrowed from |buf| */
+int x509_pubkey_set1_shared(X509_PUBKEY *key, ASN1_SHARED_BUF *buf)
+{
+    if (buf != NULL && !ASN1_SHARED_BUF_up_ref(buf))
+        return 0;
+    ASN1_SHARED_BUF_free(key->shared);
+    key->shared = buf;
+    return 1;
+}
+
+/*
+ * Get the buffer that the public key of |key| borrows its content from, so
+ * that a key decoded from it can borrow from it too, or NULL if it owns it.
+ */
+ASN1_SHARED_BUF *x509_pubkey_get0_shared(const X509_PUBKEY *key)
+{
+    if ((key->public_key->flags & ASN1_STRING_FLAG_BORROWED) == 0)
+        return NULL;
+    return key->shared;
+}
+
 ASN1_BIT_STRING *X509_get0_pubkey_bitstr(const X509 *x)
 {
     if (x == NULL)
@@ -13,6 +13,7 @@
 #include <openssl/asn1t.h>
 #include <openssl/x509.h>
 #include <openssl/x509v3.h>
+#include "crypto/asn1.h"
 #include "crypto/x509.h"
 
 ASN1_SEQUENCE_enc(X509_CINF, enc, 0) = {
@@ -33,6 +34,19 @@ IMPLEMENT_ASN1_FUNCTIONS(X509_CINF)
 
 extern void policy_cache_free(X509_POLICY_CACHE *cache);
 
+/* Forget the TBSCertificate encoding if it points into the shared buffer */
+static void x509_shared_drop_enc(X509 *x)
+{
+    ASN1_ENCODING *enc = &x->cert_info.enc;
+
+    if (x->shared != NULL && enc->enc != NULL
+            && asn1_shared_buf_contains(x->shared, enc->enc, enc->len)) {
+        enc->enc = NULL;
+        enc->len = 0;
+        enc->modified = 1;
+    }
+}
+
 static int x509_cb(int operation, ASN1_VALUE **pval, const ASN1_ITEM *it,
                    void *exarg)
 {
@@ -41,6 +55,7 @@ static int x509_cb(int operation, ASN1_VALUE **pval, const ASN1_ITEM *it,
     switch (operation) {
 
     case ASN1_OP_D2I_PRE:
+        x509_shared_drop_enc(ret);
         CRYPTO_free_ex_data(CRYPTO_EX_INDEX_X509, ret, &ret->ex_data);
         X509_CERT_AUX_free(ret->aux);
         ASN1_OCTET_STRING_free(ret->skid);
@@ -79,6 +94,10 @@ static int x509_cb(int operation, ASN1_VALUE **pval, const ASN1_ITEM *it,
             return 0;
         break;
 
+    case ASN1_OP_FREE_PRE:
+        x509_shared_drop_enc(ret);
+        break;
+
     case ASN1_OP_FREE_POST:
         CRYPTO_free_ex_data(CRYPTO_EX_INDEX_X509, ret, &ret->ex_data);
         X509_CERT_AUX_free(ret->aux);
@@ -92,6 +111,8 @@ static int x509_cb(int operation, ASN1_VALUE **pval, const ASN1_ITEM *it,
         sk_IPAddressFamily_pop_free(ret->rfc3779_addr, IPAddressFamily_free);
         ASIdentifiers_free(ret->rfc3779_asid);
 #endif
+        /* Nothing borrows from the shared buffer any more */
+        ASN1_SHARED_BUF_free(ret->shared);
         break;
 
     }
@@ -110,6 +131,98 @@ IMPLEMENT_ASN1_FUNCTIONS(X509)
 
 IMPLEMENT_ASN1_DUP_FUNCTION(X509)
 
+/*
+ * Find out the length of the certificate at |in| and the offset and length
+ * of its TBSCertificate. Returns 0 unless both are of definite length.
+ */
+int x509_der_lengths(const unsigned char *in, long len, long *certlen,
+                     long *tbsoff, long *tbslen)
+{
+    const unsigned char *p = in, *q;
+    long plen, tlen;
+    int tag, xclass;
+
+    if (ASN1_get_object(&p, &plen, &tag, &xclass, len) != V_ASN1_CONSTRUCTED)
+        return 0;
+    q = p;
+    if (ASN1_get_object(&q, &tlen, &tag, &xclass, plen) != V_ASN1_CONSTRUCTED)
+        return 0;
+    *certlen = (p - in) + plen;
+    *tbsoff = p - in;
+    *tbslen = (q - p) + tlen;
+    return 1;
+}
+
+/*
+ * Decode a certificate whose public key, signature and other OCTET and BIT
+ * STRINGs borrow their content from |buf| instead of each having their own
+ * copy. The encoding in |buf| also serves as the saved TBSCertificate
+ * encoding, which would otherwise be yet another copy.
+ */
+X509 *d2i_X509_shared(X509 **a, ASN1_SHARED_BUF *buf,
+                      const unsigned char **in, long len)
+{
+    const unsigned char *p = *in;
+    long certlen, tbsoff, tbslen;
+    X509 *ret;
+
+    if (len < 0 || !asn1_shared_buf_contains(buf, *in, len)) {
+        X509err(X509_F_D2I_X509_SHARED, ERR_R_PASSED_INVALID_ARGUMENT);
+        return NULL;
+    }
+    /*
+     * The TBSCertificate encoding is needed as is, and only a definite
+     * length one can be found without decoding: leave anything else to the
+     * normal decoder.
+     */
+    if (!x509_der_lengths(*in, len, &certlen, &tbsoff, &tbslen))
+        return d2i_X509(a, in, len);
+
+    ret = (X509 *)asn1_item_d2i_borrow(NULL, &p, certlen, ASN1_ITEM_rptr(X509));
+    if (ret == NULL)
+        return NULL;
+    if (!ASN1_SHARED_BUF_up_ref(buf)) {
+        X509_free(ret);
+        return NULL;
+    }
+    ret->shared = buf;
+    ret->cert_info.enc.enc = (unsigned char *)*in + tbsoff;
+    ret->cert_info.enc.len = tbslen;
+    ret->cert_info.enc.modified = 0;
+    /* The public key is decoded when first used, let it borrow too */
+    if (!x509_pubkey_set1_shared(ret->cert_info.key, buf)) {
+        X509_free(ret);
+        return NULL;
+    }
+
+    *in = p;
+    if (a != NULL) {
+        X509_free(*a);
+        *a = ret;
+    }
+    return ret;
+}
+
+/* Decode a certificate from a single copy of its encoding */
+X509 *d2i_X509_flat(X509 **a, const unsigned char **in, long len)
+{
+    const unsigned char *p;
+    long certlen, tbsoff, tbslen;
+    ASN1_SHARED_BUF *buf;
+    X509 *ret;
+
+    if (!x509_der_lengths(*in, len, &certlen, &tbsoff, &tbslen))
+        return d2i_X509(a, in, len);
+    if ((buf = ASN1_SHARED_BUF_new(*in, certlen)) == NULL)
+        return NULL;
+    p = ASN1_SHARED_BUF_get0_data(buf);
+    ret = d2i_X509_shared(a, buf, &p, certlen);
+    ASN1_SHARED_BUF_free(buf);
+    if (ret != NULL)
+        *in += certlen;
+    return ret;
+}
+
 int X509_set_ex_data(X509 *r, int idx, void *arg)
 {
     return CRYPTO_set_ex_data(&r->ex_data, idx, arg);
@@ -385,6 +385,13 @@ static void x509v3_cache_extensions(X509 *x)
     /* fast lock-free check, see end of the function for details. */
     if (tsan_ld_acq((TSAN_QUALIFIER int *)&x->ex_cached))
         return;
+#else
+    /* Once the extensions are cached, readers need not exclude each other */
+    CRYPTO_THREAD_read_lock(x->lock);
+    i = (x->ex_flags & EXFLAG_SET) != 0;
+    CRYPTO_THREAD_unlock(x->lock);
+    if (i)
+        return;
 #endif
 
     CRYPTO_THREAD_write_lock(x->lock);
@@ -515,7 +522,7 @@ static void x509v3_cache_extensions(X509 *x)
     if (x->akid == NULL && i != -1)
         x->ex_flags |= EXFLAG_INVALID;
     /* Does subject name match issuer ? */
-    if (!X509_NAME_cmp(X509_get_subject_name(x), X509_get_issuer_name(x))) {
+    if (x509_name_equal(X509_get_subject_name(x), X509_get_issuer_name(x))) {
         x->ex_flags |= EXFLAG_SI; /* cert is self-issued */
         if (X509_check_akid(x, x->akid) == X509_V_OK /* SKID matches AKID */
                 /* .. and the signature alg matches the PUBKEY alg: */
@@ -855,8 +862,8 @@ int X509_check_issued(X509 *issuer, X509 *subject)
 /* do the checks 1., 2., and 3. as described above for X509_check_issued() */
 int x509_likely_issued(X509 *issuer, X509 *subject)
 {
-    if (X509_NAME_cmp(X509_get_subject_name(issuer),
-                      X509_get_issuer_name(subject)))
+    if (!x509_name_equal(X509_get_subject_name(issuer),
+                         X509_get_issuer_name(subject)))
         return X509_V_ERR_SUBJECT_ISSUER_MISMATCH;
 
     x509v3_cache_extensions(issuer);
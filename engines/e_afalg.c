@@ -11,6 +11,7 @@
 #ifndef _GNU_SOURCE
 # define _GNU_SOURCE
 #endif
+#include <limits.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
@@ -18,6 +19,7 @@
 #include <openssl/engine.h>
 #include <openssl/async.h>
 #include <openssl/err.h>
+#include <openssl/rand.h>
 #include "internal/nelem.h"
 
 #include <sys/socket.h>
@@ -43,8 +45,20 @@ void engine_load_afalg_int(void)
 
 # include <linux/aio_abi.h>
 # include <sys/syscall.h>
+# include <sys/uio.h>
 # include <errno.h>
 
+/*
+ * io_uring needs IORING_REGISTER_PROBE (5.6) to check for SENDMSG/READV
+ * support before we rely on it; older kernels keep using Linux AIO.
+ */
+# if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 6, 0) \
+     && defined(__NR_io_uring_setup) && defined(__ATOMIC_ACQUIRE)
+#  define AFALG_IO_URING
+#  include <linux/io_uring.h>
+#  include <sys/mman.h>
+# endif
+
 # include "e_afalg.h"
 # include "e_afalg_err.c"
 
@@ -56,6 +70,10 @@ void engine_load_afalg_int(void)
 #  ifndef SPLICE_F_GIFT
 #   define SPLICE_F_GIFT    (0x08)
 #  endif
+/* The input has already been spliced into the socket */
+#  define ALG_SEND_PENDING 0
+# else
+#  define ALG_SEND_PENDING 1
 # endif
 
 # define ALG_AES_IV_LEN 16
@@ -69,17 +87,21 @@ void engine_load_afalg_int(void);
 
 /* Local Linkage Functions */
 static int afalg_init_aio(afalg_aio *aio);
-static int afalg_fin_cipher_aio(afalg_aio *ptr, int sfd,
-                                unsigned char *buf, size_t len);
-static int afalg_create_sk(afalg_ctx *actx, const char *ciphertype,
-                                const char *ciphername);
+static int afalg_fin_cipher_aio(afalg_ctx *actx, int send,
+                                struct iovec *iov, int iovcnt, size_t len);
+static int afalg_create_sk(int *bfd, int *sfd, const char *ciphertype,
+                           const char *ciphername);
 static int afalg_destroy(ENGINE *e);
 static int afalg_init(ENGINE *e);
 static int afalg_finish(ENGINE *e);
+static int afalg_ctrl(ENGINE *e, int cmd, long i, void *p, void (*f) (void));
 static const EVP_CIPHER *afalg_aes_cbc(int nid);
+static const EVP_CIPHER *afalg_aes_gcm(int nid);
 static cbc_handles *get_cipher_handle(int nid);
 static int afalg_ciphers(ENGINE *e, const EVP_CIPHER **cipher,
                          const int **nids, int nid);
+static int afalg_digests(ENGINE *e, const EVP_MD **digest,
+                         const int **nids, int nid);
 static int afalg_cipher_init(EVP_CIPHER_CTX *ctx, const unsigned char *key,
                              const unsigned char *iv, int enc);
 static int afalg_do_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
@@ -91,16 +113,73 @@ static int afalg_chk_platform(void);
 static const char *engine_afalg_id = "afalg";
 static const char *engine_afalg_name = "AFALG engine support";
 
+/*
+ * The AES-GCM nids come last: they are only advertised when the kernel
+ * provides gcm(aes), see bind_afalg()
+ */
 static int afalg_cipher_nids[] = {
     NID_aes_128_cbc,
     NID_aes_192_cbc,
     NID_aes_256_cbc,
+    NID_aes_128_gcm,
+    NID_aes_192_gcm,
+    NID_aes_256_gcm,
 };
+static int afalg_cipher_nids_num = AES_CBC_256 + 1;
 
 static cbc_handles cbc_handle[] = {{AES_KEY_SIZE_128, NULL},
                                     {AES_KEY_SIZE_192, NULL},
                                     {AES_KEY_SIZE_256, NULL}};
 
+static cbc_handles gcm_handle[] = {{AES_KEY_SIZE_128, NULL},
+                                    {AES_KEY_SIZE_192, NULL},
+                                    {AES_KEY_SIZE_256, NULL}};
+
+static const struct afalg_digest_data_st {
+    int nid;
+    const char *name;
+    const EVP_MD *(*md)(void);
+} afalg_digest_data[] = {
+    { NID_sha1, "sha1", EVP_sha1 },
+    { NID_sha224, "sha224", EVP_sha224 },
+    { NID_sha256, "sha256", EVP_sha256 },
+    { NID_sha384, "sha384", EVP_sha384 },
+    { NID_sha512, "sha512", EVP_sha512 },
+};
+
+/* Digests the kernel was found to provide when the engine was bound */
+static int afalg_digest_nids[OSSL_NELEM(afalg_digest_data)];
+static int afalg_digest_nids_num = 0;
+static EVP_MD *afalg_digest_methods[OSSL_NELEM(afalg_digest_data)];
+/* Their tfm sockets */
+static int afalg_digest_sk[OSSL_NELEM(afalg_digest_data)] = {
+    -1, -1, -1, -1, -1
+};
+
+/* Kernel version found by afalg_chk_platform() */
+static int afalg_kver = 0;
+
+# ifdef AFALG_IO_URING
+#  define AFALG_CMD_USE_IO_URING     ENGINE_CMD_BASE
+#  define AFALG_CMD_SQPOLL_IDLE      (ENGINE_CMD_BASE + 1)
+
+static const ENGINE_CMD_DEFN afalg_cmd_defns[] = {
+    {AFALG_CMD_USE_IO_URING,
+     "USE_IO_URING",
+     "Use io_uring rather than Linux AIO in async jobs (1=default, 0=AIO)",
+     ENGINE_CMD_FLAG_NUMERIC},
+    {AFALG_CMD_SQPOLL_IDLE,
+     "SQPOLL_IDLE",
+     "Poll the submission queue from a kernel thread that sleeps after "
+     "this many idle milliseconds (0=no polling, default)",
+     ENGINE_CMD_FLAG_NUMERIC},
+    {0, NULL, NULL, 0}
+};
+
+static int afalg_use_io_uring = 1;
+static unsigned int afalg_sqpoll_idle = 0;
+# endif
+
 static ossl_inline int io_setup(unsigned n, aio_context_t *ctx)
 {
     return syscall(__NR_io_setup, n, ctx);
@@ -128,12 +207,258 @@ static ossl_inline int io_getevents(aio_context_t ctx, long min, long max,
     return syscall(__NR_io_getevents, ctx, min, max, events, timeout);
 }
 
+# ifdef AFALG_IO_URING
+static ossl_inline int io_uring_setup(unsigned int entries,
+                                      struct io_uring_params *p)
+{
+    return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static ossl_inline int io_uring_enter(int fd, unsigned int to_submit,
+                                      unsigned int min_complete,
+                                      unsigned int flags)
+{
+    return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                   NULL, 0);
+}
+
+static ossl_inline int io_uring_register(int fd, unsigned int opcode,
+                                         void *arg, unsigned int nr_args)
+{
+    return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+# endif
+
 static void afalg_waitfd_cleanup(ASYNC_WAIT_CTX *ctx, const void *key,
                                  OSSL_ASYNC_FD waitfd, void *custom)
 {
     close(waitfd);
 }
 
+# ifdef AFALG_IO_URING
+#  define AFALG_RING_SEND    0
+#  define AFALG_RING_READ    1
+#  define AFALG_RING_DATA(seq, op) (((__u64)(seq) << 1) | (op))
+
+static void afalg_ring_free(afalg_ring *ring)
+{
+    if (ring->sqes != NULL)
+        munmap(ring->sqes, ring->sqes_sz);
+    if (ring->cq_ring != NULL)
+        munmap(ring->cq_ring, ring->cq_ring_sz);
+    if (ring->sq_ring != NULL)
+        munmap(ring->sq_ring, ring->sq_ring_sz);
+    close(ring->fd);
+    OPENSSL_free(ring);
+}
+
+static void afalg_ring_cleanup(ASYNC_WAIT_CTX *ctx, const void *key,
+                               OSSL_ASYNC_FD waitfd, void *custom)
+{
+    afalg_ring_free(custom);
+}
+
+static void *afalg_ring_map(int fd, size_t len, off_t off)
+{
+    void *p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, off);
+
+    return p == MAP_FAILED ? NULL : p;
+}
+
+/* Check that the kernel can run SENDMSG and READV requests on the ring */
+static int afalg_ring_probe(int fd)
+{
+    struct io_uring_probe *probe;
+    size_t len = sizeof(*probe)
+                 + IORING_OP_LAST * sizeof(struct io_uring_probe_op);
+    int ret = 0;
+
+    if ((probe = OPENSSL_zalloc(len)) == NULL)
+        return 0;
+    if (io_uring_register(fd, IORING_REGISTER_PROBE, probe,
+                          IORING_OP_LAST) == 0
+            && probe->ops_len > IORING_OP_SENDMSG
+            && (probe->ops[IORING_OP_SENDMSG].flags
+                & IO_URING_OP_SUPPORTED) != 0
+            && (probe->ops[IORING_OP_READV].flags
+                & IO_URING_OP_SUPPORTED) != 0)
+        ret = 1;
+    OPENSSL_free(probe);
+    return ret;
+}
+
+static afalg_ring *afalg_ring_new(void)
+{
+    struct io_uring_params p;
+    afalg_ring *ring;
+    unsigned char *sq, *cq;
+
+    if ((ring = OPENSSL_zalloc(sizeof(*ring))) == NULL)
+        return NULL;
+
+    ring->fd = -1;
+    if (afalg_sqpoll_idle > 0) {
+        memset(&p, 0, sizeof(p));
+        p.flags = IORING_SETUP_SQPOLL;
+        p.sq_thread_idle = afalg_sqpoll_idle;
+        ring->fd = io_uring_setup(AFALG_RING_ENTRIES, &p);
+        ring->sqpoll = ring->fd >= 0;
+    }
+    if (ring->fd < 0) {
+        /* SQ polling can need privileges, a plain ring will do */
+        memset(&p, 0, sizeof(p));
+        ring->fd = io_uring_setup(AFALG_RING_ENTRIES, &p);
+    }
+    if (ring->fd < 0) {
+        ALG_WARN("%s(%d): io_uring_setup failed, errno %d\n", __FILE__,
+                 __LINE__, errno);
+        OPENSSL_free(ring);
+        return NULL;
+    }
+    if (!afalg_ring_probe(ring->fd)) {
+        ALG_WARN("%s(%d): io_uring lacks SENDMSG/READV\n", __FILE__,
+                 __LINE__);
+        goto err;
+    }
+
+    ring->sq_ring_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+    ring->cq_ring_sz = p.cq_off.cqes
+                       + p.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqes_sz = p.sq_entries * sizeof(struct io_uring_sqe);
+    if ((ring->sq_ring = afalg_ring_map(ring->fd, ring->sq_ring_sz,
+                                        IORING_OFF_SQ_RING)) == NULL
+            || (ring->cq_ring = afalg_ring_map(ring->fd, ring->cq_ring_sz,
+                                               IORING_OFF_CQ_RING)) == NULL
+            || (ring->sqes = afalg_ring_map(ring->fd, ring->sqes_sz,
+                                            IORING_OFF_SQES)) == NULL)
+        goto err;
+
+    sq = ring->sq_ring;
+    ring->sq_head = (unsigned int *)(sq + p.sq_off.head);
+    ring->sq_tail = (unsigned int *)(sq + p.sq_off.tail);
+    ring->sq_mask = (unsigned int *)(sq + p.sq_off.ring_mask);
+    ring->sq_flags = (unsigned int *)(sq + p.sq_off.flags);
+    ring->sq_array = (unsigned int *)(sq + p.sq_off.array);
+    cq = ring->cq_ring;
+    ring->cq_head = (unsigned int *)(cq + p.cq_off.head);
+    ring->cq_tail = (unsigned int *)(cq + p.cq_off.tail);
+    ring->cq_mask = (unsigned int *)(cq + p.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+    return ring;
+
+ err:
+    afalg_ring_free(ring);
+    return NULL;
+}
+
+static void afalg_ring_prep(afalg_ring *ring, unsigned int tail, int opcode,
+                            int fd, const void *addr, unsigned int len,
+                            int flags, int op)
+{
+    unsigned int idx = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[idx];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->flags = flags;
+    sqe->fd = fd;
+    sqe->addr = (size_t)addr;
+    sqe->len = len;
+    sqe->user_data = AFALG_RING_DATA(ring->seq, op);
+    ring->sq_array[idx] = idx;
+}
+
+/*
+ * Queue the read of an operation's output, preceded by the sendmsg() of its
+ * input when |msg| is set. The two requests are linked so that a single
+ * io_uring_enter() call submits both, and none at all is needed while an SQ
+ * polling thread is awake.
+ */
+static int afalg_ring_submit(afalg_ring *ring, int sfd, struct msghdr *msg,
+                             struct iovec *iov, int iovcnt)
+{
+    unsigned int tail = *ring->sq_tail;
+    unsigned int n = 0;
+    int r;
+
+    ring->seq++;
+    if (msg != NULL) {
+        afalg_ring_prep(ring, tail + n++, IORING_OP_SENDMSG, sfd, msg, 1,
+                        IOSQE_IO_LINK, AFALG_RING_SEND);
+    }
+    afalg_ring_prep(ring, tail + n++, IORING_OP_READV, sfd, iov, iovcnt, 0,
+                    AFALG_RING_READ);
+    __atomic_store_n(ring->sq_tail, tail + n, __ATOMIC_RELEASE);
+
+    if (ring->sqpoll) {
+        /* Order the tail update before looking at the poller's state */
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if ((__atomic_load_n(ring->sq_flags, __ATOMIC_RELAXED)
+             & IORING_SQ_NEED_WAKEUP) == 0)
+            return 1;
+        r = io_uring_enter(ring->fd, n, 0, IORING_ENTER_SQ_WAKEUP);
+        if (r >= 0)
+            return 1;
+    } else {
+        r = io_uring_enter(ring->fd, n, 0, 0);
+        if (r == (int)n)
+            return 1;
+    }
+    ALG_PWARN("%s(%d): io_uring_enter failed : ", __FILE__, __LINE__);
+    /*
+     * Entries left in the queue still point at the caller's buffers: never
+     * enter this ring again.
+     */
+    ring->broken = 1;
+    return 0;
+}
+
+/* Collect the completions of the operation in flight, returns their count */
+static int afalg_ring_reap(afalg_ring *ring, int res[2])
+{
+    unsigned int head = *ring->cq_head;
+    unsigned int tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    struct io_uring_cqe *cqe;
+    int n = 0;
+
+    for (; head != tail; head++) {
+        cqe = &ring->cqes[head & *ring->cq_mask];
+        if ((unsigned int)(cqe->user_data >> 1) != ring->seq)
+            continue;
+        res[cqe->user_data & 1] = cqe->res;
+        n++;
+    }
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    return n;
+}
+
+/*
+ * Make a new io_uring the waitfd of |waitctx|: it is signaled when an
+ * operation of any job using this ASYNC_WAIT_CTX completes. Returns 0 when
+ * no ring is available so the caller falls back to AIO and an eventfd.
+ */
+static int afalg_set_ring_waitfd(ASYNC_WAIT_CTX *waitctx, afalg_aio *aio,
+                                 void **custom)
+{
+    afalg_ring *ring;
+
+    if (!afalg_use_io_uring || (ring = afalg_ring_new()) == NULL)
+        return 0;
+
+    if (!ASYNC_WAIT_CTX_set_wait_fd(waitctx, engine_afalg_id, ring->fd, ring,
+                                    afalg_ring_cleanup)) {
+        ALG_WARN("%s(%d): Failed to set wait fd", __FILE__, __LINE__);
+        afalg_ring_free(ring);
+        return -1;
+    }
+    aio->efd = ring->fd;
+    *custom = ring;
+    return 1;
+}
+# endif
+
 static int afalg_setup_async_event_notification(afalg_aio *aio)
 {
     ASYNC_JOB *job;
@@ -151,6 +476,13 @@ static int afalg_setup_async_event_notification(afalg_aio *aio)
         /* Get waitfd from ASYNC_WAIT_CTX if it is already set */
         ret = ASYNC_WAIT_CTX_get_fd(waitctx, engine_afalg_id,
                                     &aio->efd, &custom);
+# ifdef AFALG_IO_URING
+        if (ret == 0) {
+            ret = afalg_set_ring_waitfd(waitctx, aio, &custom);
+            if (ret < 0)
+                return 0;
+        }
+# endif
         if (ret == 0) {
             /*
              * waitfd is not set in ASYNC_WAIT_CTX, create a new one
@@ -179,15 +511,16 @@ static int afalg_setup_async_event_notification(afalg_aio *aio)
             }
         }
         aio->mode = MODE_ASYNC;
+# ifdef AFALG_IO_URING
+        aio->ring = custom;
+        if (aio->ring != NULL && aio->ring->broken)
+            aio->mode = MODE_SYNC;
+# endif
     } else {
-        /* Sync mode */
-        aio->efd = eventfd(0);
-        if (aio->efd == -1) {
-            ALG_PERR("%s(%d): Failed to get eventfd : ", __FILE__, __LINE__);
-            AFALGerr(AFALG_F_AFALG_SETUP_ASYNC_EVENT_NOTIFICATION,
-                     AFALG_R_EVENTFD_FAILED);
-            return 0;
-        }
+        /*
+         * Sync mode: the read on the AFALG socket blocks until the crypto
+         * operation completes, there is nothing to wait for
+         */
         aio->mode = MODE_SYNC;
     }
     return 1;
@@ -203,19 +536,100 @@ static int afalg_init_aio(afalg_aio *aio)
     if (r < 0) {
         ALG_PERR("%s(%d): io_setup error : ", __FILE__, __LINE__);
         AFALGerr(AFALG_F_AFALG_INIT_AIO, AFALG_R_IO_SETUP_FAILED);
+        aio->aio_ctx = 0;
         return 0;
     }
 
     memset(aio->cbt, 0, sizeof(aio->cbt));
-    aio->efd = -1;
-    aio->mode = MODE_UNINIT;
 
     return 1;
 }
 
-static int afalg_fin_cipher_aio(afalg_aio *aio, int sfd, unsigned char *buf,
-                                size_t len)
+static size_t afalg_msg_len(const struct msghdr *msg)
+{
+    size_t i, len = 0;
+
+    for (i = 0; i < msg->msg_iovlen; i++)
+        len += msg->msg_iov[i].iov_len;
+    return len;
+}
+
+static int afalg_send_msg(afalg_ctx *actx)
+{
+    ssize_t sbytes;
+    size_t len = afalg_msg_len(&actx->msg);
+
+    /* Sendmsg() sends the control data and input data to the kernel */
+    sbytes = sendmsg(actx->sfd, &actx->msg, 0);
+    if (sbytes < 0) {
+        ALG_PERR("%s(%d): sendmsg failed for cipher operation : ", __FILE__,
+                 __LINE__);
+        return 0;
+    }
+
+    if (sbytes != (ssize_t) len) {
+        ALG_WARN("Cipher operation send bytes %zd != inlen %zd\n", sbytes,
+                len);
+        return 0;
+    }
+    return 1;
+}
+
+# ifdef AFALG_IO_URING
+static int afalg_fin_cipher_ring(afalg_ring *ring, afalg_ctx *actx, int send,
+                                 struct iovec *iov, int iovcnt, size_t len)
 {
+    int res[2] = { 0, 0 };
+    int pending;
+    int retry = 0;
+
+    for (;;) {
+        if (!afalg_ring_submit(ring, actx->sfd, send ? &actx->msg : NULL,
+                               iov, iovcnt))
+            return 0;
+
+        /*
+         * Pause only while completions are outstanding: the kernel often
+         * finishes before we get here, in which case no wait fd round trip
+         * is needed at all
+         */
+        pending = send ? 2 : 1;
+        while ((pending -= afalg_ring_reap(ring, res)) > 0)
+            ASYNC_pause_job();
+
+        if (send) {
+            if (res[AFALG_RING_SEND] != (int)afalg_msg_len(&actx->msg)) {
+                ALG_WARN("%s(%d): ring sendmsg returned %d\n", __FILE__,
+                         __LINE__, res[AFALG_RING_SEND]);
+                return 0;
+            }
+            send = 0;
+        }
+
+        /*
+         * As with AIO, -EBUSY means the operation could not be queued yet.
+         * Its input is still held by the socket, so only the read is retried.
+         */
+        if (res[AFALG_RING_READ] == -EBUSY && retry++ < 3)
+            continue;
+        if (res[AFALG_RING_READ] != (int)len) {
+            ALG_WARN("%s(%d): Crypto Operation failed with code %d\n",
+                     __FILE__, __LINE__, res[AFALG_RING_READ]);
+            return 0;
+        }
+        return 1;
+    }
+}
+# endif
+
+/*
+ * Complete an operation on the AFALG socket: send the request prepared in
+ * |actx->msg| if |send| is set, then read |len| bytes of output into |iov|.
+ */
+static int afalg_fin_cipher_aio(afalg_ctx *actx, int send,
+                                struct iovec *iov, int iovcnt, size_t len)
+{
+    afalg_aio *aio = &actx->aio;
     int r;
     int retry = 0;
     unsigned int done = 0;
@@ -227,25 +641,44 @@ static int afalg_fin_cipher_aio(afalg_aio *aio, int sfd, unsigned char *buf,
     timeout.tv_sec = 0;
     timeout.tv_nsec = 0;
 
-    /* if efd has not been initialised yet do it here */
-    if (aio->mode == MODE_UNINIT) {
-        r = afalg_setup_async_event_notification(aio);
-        if (r == 0)
+    /* Async only if called from within a job, decided for each operation */
+    r = afalg_setup_async_event_notification(aio);
+    if (r == 0)
+        return 0;
+
+# ifdef AFALG_IO_URING
+    if (aio->mode == MODE_ASYNC && aio->ring != NULL)
+        return afalg_fin_cipher_ring(aio->ring, actx, send, iov, iovcnt, len);
+# endif
+
+    if (send && !afalg_send_msg(actx))
+        return 0;
+
+    if (aio->mode == MODE_SYNC) {
+        if (readv(actx->sfd, iov, iovcnt) != (ssize_t)len) {
+            ALG_WARN("%s(%d): Crypto Operation failed, errno %d\n",
+                     __FILE__, __LINE__, errno);
             return 0;
+        }
+        return 1;
     }
 
+    /* if the AIO ctx has not been initialised yet do it here */
+    if (aio->aio_ctx == 0 && !afalg_init_aio(aio))
+        return 0;
+
     cb = &(aio->cbt[0 % MAX_INFLIGHTS]);
     memset(cb, '\0', sizeof(*cb));
-    cb->aio_fildes = sfd;
-    cb->aio_lio_opcode = IOCB_CMD_PREAD;
+    cb->aio_fildes = actx->sfd;
+    cb->aio_lio_opcode = IOCB_CMD_PREADV;
     /*
      * The pointer has to be converted to unsigned value first to avoid
      * sign extension on cast to 64 bit value in 32-bit builds
      */
-    cb->aio_buf = (size_t)buf;
+    cb->aio_buf = (size_t)iov;
     cb->aio_offset = 0;
     cb->aio_data = 0;
-    cb->aio_nbytes = len;
+    cb->aio_nbytes = iovcnt;
     cb->aio_flags = IOCB_FLAG_RESFD;
     cb->aio_resfd = aio->efd;
 
@@ -345,6 +778,14 @@ static void afalg_set_iv_sk(struct cmsghdr *cmsg, const unsigned char *iv,
     memcpy(aiv->iv, iv, len);
 }
 
+static void afalg_set_assoclen_sk(struct cmsghdr *cmsg, const unsigned int len)
+{
+    cmsg->cmsg_level = SOL_ALG;
+    cmsg->cmsg_type = ALG_SET_AEAD_ASSOCLEN;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(len));
+    memcpy(CMSG_DATA(cmsg), &len, sizeof(len));
+}
+
 static ossl_inline int afalg_set_key(afalg_ctx *actx, const unsigned char *key,
                                 const int klen)
 {
@@ -358,35 +799,35 @@ static ossl_inline int afalg_set_key(afalg_ctx *actx, const unsigned char *key,
     return 1;
 }
 
-static int afalg_create_sk(afalg_ctx *actx, const char *ciphertype,
-                                const char *ciphername)
+static int afalg_create_sk(int *bfd, int *sfd, const char *ciphertype,
+                           const char *ciphername)
 {
     struct sockaddr_alg sa;
     int r = -1;
 
-    actx->bfd = actx->sfd = -1;
+    *bfd = *sfd = -1;
 
     memset(&sa, 0, sizeof(sa));
     sa.salg_family = AF_ALG;
     OPENSSL_strlcpy((char *) sa.salg_type, ciphertype, sizeof(sa.salg_type));
     OPENSSL_strlcpy((char *) sa.salg_name, ciphername, sizeof(sa.salg_name));
 
-    actx->bfd = socket(AF_ALG, SOCK_SEQPACKET, 0);
-    if (actx->bfd == -1) {
+    *bfd = socket(AF_ALG, SOCK_SEQPACKET, 0);
+    if (*bfd == -1) {
         ALG_PERR("%s(%d): Failed to open socket : ", __FILE__, __LINE__);
         AFALGerr(AFALG_F_AFALG_CREATE_SK, AFALG_R_SOCKET_CREATE_FAILED);
         goto err;
     }
 
-    r = bind(actx->bfd, (struct sockaddr *)&sa, sizeof(sa));
+    r = bind(*bfd, (struct sockaddr *)&sa, sizeof(sa));
     if (r < 0) {
         ALG_PERR("%s(%d): Failed to bind socket : ", __FILE__, __LINE__);
         AFALGerr(AFALG_F_AFALG_CREATE_SK, AFALG_R_SOCKET_BIND_FAILED);
         goto err;
     }
 
-    actx->sfd = accept(actx->bfd, NULL, 0);
-    if (actx->sfd < 0) {
+    *sfd = accept(*bfd, NULL, 0);
+    if (*sfd < 0) {
         ALG_PERR("%s(%d): Socket Accept Failed : ", __FILE__, __LINE__);
         AFALGerr(AFALG_F_AFALG_CREATE_SK, AFALG_R_SOCKET_ACCEPT_FAILED);
         goto err;
@@ -395,45 +836,48 @@ static int afalg_create_sk(afalg_ctx *actx, const char *ciphertype,
     return 1;
 
  err:
-    if (actx->bfd >= 0)
-        close(actx->bfd);
-    if (actx->sfd >= 0)
-        close(actx->sfd);
-    actx->bfd = actx->sfd = -1;
+    if (*bfd >= 0)
+        close(*bfd);
+    if (*sfd >= 0)
+        close(*sfd);
+    *bfd = *sfd = -1;
     return 0;
 }
 
+/*
+ * Prepare the request of a cipher operation in |actx->msg|; it is sent
+ * together with the read of the result by afalg_fin_cipher_aio(). In
+ * ZERO_COPY mode the input is spliced into the socket here instead.
+ */
 static int afalg_start_cipher_sk(afalg_ctx *actx, const unsigned char *in,
                                  size_t inl, const unsigned char *iv,
                                  unsigned int enc)
 {
-    struct msghdr msg = { 0 };
+    struct msghdr *msg = &actx->msg;
     struct cmsghdr *cmsg;
-    struct iovec iov;
-    ssize_t sbytes;
 # ifdef ALG_ZERO_COPY
+    ssize_t sbytes;
     int ret;
 # endif
-    char cbuf[CMSG_SPACE(ALG_IV_LEN(ALG_AES_IV_LEN)) + CMSG_SPACE(ALG_OP_LEN)];
 
-    memset(cbuf, 0, sizeof(cbuf));
-    msg.msg_control = cbuf;
-    msg.msg_controllen = sizeof(cbuf);
+    memset(msg, 0, sizeof(*msg));
+    memset(actx->cbuf, 0, sizeof(actx->cbuf));
+    msg->msg_control = actx->cbuf;
+    msg->msg_controllen = CMSG_SPACE(ALG_IV_LEN(ALG_AES_IV_LEN))
+                          + CMSG_SPACE(ALG_OP_LEN);
 
     /*
      * cipher direction (i.e. encrypt or decrypt) and iv are sent to the
      * kernel as part of sendmsg()'s ancillary data
      */
-    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg = CMSG_FIRSTHDR(msg);
     afalg_set_op_sk(cmsg, enc);
-    cmsg = CMSG_NXTHDR(&msg, cmsg);
+    cmsg = CMSG_NXTHDR(msg, cmsg);
     afalg_set_iv_sk(cmsg, iv, ALG_AES_IV_LEN);
 
     /* iov that describes input data */
-    iov.iov_base = (unsigned char *)in;
-    iov.iov_len = inl;
-
-    msg.msg_flags = MSG_MORE;
+    actx->iov[0].iov_base = (unsigned char *)in;
+    actx->iov[0].iov_len = inl;
 
 # ifdef ALG_ZERO_COPY
     /*
@@ -443,11 +887,11 @@ static int afalg_start_cipher_sk(afalg_ctx *actx, const unsigned char *in,
      */
 
     /* Input data is not sent as part of call to sendmsg() */
-    msg.msg_iovlen = 0;
-    msg.msg_iov = NULL;
+    msg->msg_iovlen = 0;
+    msg->msg_iov = NULL;
 
     /* Sendmsg() sends iv and cipher direction to the kernel */
-    sbytes = sendmsg(actx->sfd, &msg, 0);
+    sbytes = sendmsg(actx->sfd, msg, 0);
     if (sbytes < 0) {
         ALG_PERR("%s(%d): sendmsg failed for zero copy cipher operation : ",
                  __FILE__, __LINE__);
@@ -458,7 +902,7 @@ static int afalg_start_cipher_sk(afalg_ctx *actx, const unsigned char *in,
      * vmsplice and splice are used to pin the user space input buffer for
      * kernel space processing avoiding copies from user to kernel space
      */
-    ret = vmsplice(actx->zc_pipe[1], &iov, 1, SPLICE_F_GIFT);
+    ret = vmsplice(actx->zc_pipe[1], &actx->iov[0], 1, SPLICE_F_GIFT);
     if (ret < 0) {
         ALG_PERR("%s(%d): vmsplice failed : ", __FILE__, __LINE__);
         return 0;
@@ -470,22 +914,8 @@ static int afalg_start_cipher_sk(afalg_ctx *actx, const unsigned char *in,
         return 0;
     }
 # else
-    msg.msg_iovlen = 1;
-    msg.msg_iov = &iov;
-
-    /* Sendmsg() sends iv, cipher direction and input data to the kernel */
-    sbytes = sendmsg(actx->sfd, &msg, 0);
-    if (sbytes < 0) {
-        ALG_PERR("%s(%d): sendmsg failed for cipher operation : ", __FILE__,
-                 __LINE__);
-        return 0;
-    }
-
-    if (sbytes != (ssize_t) inl) {
-        ALG_WARN("Cipher operation send bytes %zd != inlen %zd\n", sbytes,
-                inl);
-        return 0;
-    }
+    msg->msg_iovlen = 1;
+    msg->msg_iov = actx->iov;
 # endif
 
     return 1;
@@ -535,7 +965,7 @@ static int afalg_cipher_init(EVP_CIPHER_CTX *ctx, const unsigned char *key,
     }
 
     /* Setup AFALG socket for crypto processing */
-    ret = afalg_create_sk(actx, "skcipher", ciphername);
+    ret = afalg_create_sk(&actx->bfd, &actx->sfd, "skcipher", ciphername);
     if (ret < 1)
         return 0;
 
@@ -544,9 +974,12 @@ static int afalg_cipher_init(EVP_CIPHER_CTX *ctx, const unsigned char *key,
     if (ret < 1)
         goto err;
 
-    /* Setup AIO ctx to allow async AFALG crypto processing */
-    if (afalg_init_aio(&actx->aio) == 0)
-        goto err;
+    /*
+     * Notification is set up by the first operation, AIO is only initialised
+     * if an async job has to fall back to it
+     */
+    memset(&actx->aio, 0, sizeof(actx->aio));
+    actx->aio.efd = -1;
 
 # ifdef ALG_ZERO_COPY
     pipe(actx->zc_pipe);
@@ -568,6 +1001,7 @@ static int afalg_do_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
     afalg_ctx *actx;
     int ret;
     char nxtiv[ALG_AES_IV_LEN] = { 0 };
+    struct iovec oiov;
 
     if (ctx == NULL || out == NULL || in == NULL) {
         ALG_WARN("NULL parameter passed to function %s(%d)\n", __FILE__,
@@ -599,7 +1033,9 @@ static int afalg_do_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
     }
 
     /* Perform async crypto operation in kernel space */
-    ret = afalg_fin_cipher_aio(&actx->aio, actx->sfd, out, inl);
+    oiov.iov_base = out;
+    oiov.iov_len = inl;
+    ret = afalg_fin_cipher_aio(actx, ALG_SEND_PENDING, &oiov, 1, inl);
     if (ret < 1)
         return 0;
 
@@ -633,14 +1069,618 @@ static int afalg_cipher_cleanup(EVP_CIPHER_CTX *ctx)
     close(actx->zc_pipe[0]);
     close(actx->zc_pipe[1]);
 # endif
-    /* close efd in sync mode, async mode is closed in afalg_waitfd_cleanup() */
-    if (actx->aio.mode == MODE_SYNC)
-        close(actx->aio.efd);
-    io_destroy(actx->aio.aio_ctx);
+    /* the waitfd belongs to the ASYNC_WAIT_CTX, see afalg_waitfd_cleanup() */
+    if (actx->aio.aio_ctx != 0)
+        io_destroy(actx->aio.aio_ctx);
+
+    return 1;
+}
+
+/* increment counter (64-bit int) by 1 */
+static void afalg_ctr64_inc(unsigned char *counter)
+{
+    int n = 8;
+    unsigned char c;
+
+    do {
+        --n;
+        c = counter[n];
+        ++c;
+        counter[n] = c;
+        if (c)
+            return;
+    } while (n);
+}
+
+static int afalg_gcm_reserve_aad(afalg_gcm_ctx *gctx, size_t len)
+{
+    unsigned char *aad;
+
+    if (len <= gctx->aad_alloc)
+        return 1;
+    aad = OPENSSL_realloc(gctx->aad, len);
+    if (aad == NULL) {
+        AFALGerr(AFALG_F_AFALG_GCM_RESERVE_AAD, AFALG_R_MEM_ALLOC_FAILED);
+        return 0;
+    }
+    gctx->aad = aad;
+    gctx->aad_alloc = len;
+    return 1;
+}
+
+static int afalg_gcm_init(EVP_CIPHER_CTX *ctx, const unsigned char *key,
+                          const unsigned char *iv, int enc)
+{
+    afalg_gcm_ctx *gctx;
+    afalg_ctx *actx;
+
+    gctx = EVP_CIPHER_CTX_get_cipher_data(ctx);
+    if (gctx == NULL) {
+        ALG_WARN("%s(%d): Cipher data NULL\n", __FILE__, __LINE__);
+        return 0;
+    }
+    actx = &gctx->actx;
+
+    if (key != NULL) {
+        gctx->key_set = 0;
+        if (actx->init_done == MAGIC_INIT_NUM) {
+            /*
+             * The tfm socket may be shared with copies of this context, and
+             * the kernel refuses new keys once an operation socket uses it:
+             * rekey on a fresh pair of sockets
+             */
+            close(actx->sfd);
+            close(actx->bfd);
+        } else {
+            memset(&actx->aio, 0, sizeof(actx->aio));
+            actx->aio.efd = -1;
+            actx->init_done = MAGIC_INIT_NUM;
+        }
+
+        if (!afalg_create_sk(&actx->bfd, &actx->sfd, "aead", "gcm(aes)"))
+            return 0;
+        if (!afalg_set_key(actx, key, EVP_CIPHER_CTX_key_length(ctx)))
+            goto err;
+        if (setsockopt(actx->bfd, SOL_ALG, ALG_SET_AEAD_AUTHSIZE, NULL,
+                       AES_GCM_TAG_LEN) < 0) {
+            ALG_PERR("%s(%d): Failed to set tag size : ", __FILE__, __LINE__);
+            AFALGerr(AFALG_F_AFALG_GCM_INIT, AFALG_R_SOCKET_SET_KEY_FAILED);
+            goto err;
+        }
+        gctx->key_set = 1;
+    }
+
+    if (iv != NULL) {
+        memcpy(gctx->iv, iv, AES_GCM_IV_LEN);
+        gctx->iv_set = 1;
+        gctx->iv_gen = 0;
+        gctx->aad_len = 0;
+        gctx->text_len = 0;
+    }
+    return 1;
+
+ err:
+    close(actx->sfd);
+    close(actx->bfd);
+    actx->sfd = actx->bfd = -1;
+    return 0;
+}
+
+/*
+ * Run one GCM operation over the AAD collected so far and |len| bytes of
+ * payload. The kernel takes AAD || input [|| tag] and returns
+ * AAD || output [|| tag]; |tag| is read for decryption and written for
+ * encryption.
+ */
+static int afalg_gcm_op(EVP_CIPHER_CTX *ctx, afalg_gcm_ctx *gctx,
+                        unsigned char *out, const unsigned char *in,
+                        size_t len, unsigned char *tag)
+{
+    afalg_ctx *actx = &gctx->actx;
+    struct msghdr *msg = &actx->msg;
+    struct cmsghdr *cmsg;
+    struct iovec oiov[3];
+    int enc = EVP_CIPHER_CTX_encrypting(ctx);
+
+    memset(msg, 0, sizeof(*msg));
+    memset(actx->cbuf, 0, sizeof(actx->cbuf));
+    msg->msg_control = actx->cbuf;
+    msg->msg_controllen = CMSG_SPACE(ALG_OP_LEN)
+                          + CMSG_SPACE(ALG_IV_LEN(AES_GCM_IV_LEN))
+                          + CMSG_SPACE(sizeof(unsigned int));
+
+    cmsg = CMSG_FIRSTHDR(msg);
+    afalg_set_op_sk(cmsg, enc ? ALG_OP_ENCRYPT : ALG_OP_DECRYPT);
+    cmsg = CMSG_NXTHDR(msg, cmsg);
+    afalg_set_iv_sk(cmsg, gctx->iv, AES_GCM_IV_LEN);
+    cmsg = CMSG_NXTHDR(msg, cmsg);
+    afalg_set_assoclen_sk(cmsg, gctx->aad_len);
+
+    actx->iov[0].iov_base = gctx->aad;
+    actx->iov[0].iov_len = gctx->aad_len;
+    actx->iov[1].iov_base = (unsigned char *)in;
+    actx->iov[1].iov_len = len;
+    actx->iov[2].iov_base = tag;
+    actx->iov[2].iov_len = AES_GCM_TAG_LEN;
+    msg->msg_iov = actx->iov;
+    msg->msg_iovlen = enc ? 2 : 3;
+
+    /* The AAD copied back by the kernel is received in place */
+    oiov[0] = actx->iov[0];
+    oiov[1].iov_base = out;
+    oiov[1].iov_len = len;
+    oiov[2] = actx->iov[2];
+
+    return afalg_fin_cipher_aio(actx, 1, oiov, enc ? 3 : 2,
+                                gctx->aad_len + len
+                                + (enc ? AES_GCM_TAG_LEN : 0));
+}
+
+/*
+ * Handle the TLS GCM record format: explicit IV, payload and tag, processed
+ * in place with the AAD saved by EVP_CTRL_AEAD_TLS1_AAD.
+ */
+static int afalg_gcm_tls_cipher(EVP_CIPHER_CTX *ctx, afalg_gcm_ctx *gctx,
+                                unsigned char *out, const unsigned char *in,
+                                size_t len)
+{
+    int enc = EVP_CIPHER_CTX_encrypting(ctx);
+    int rv = -1;
+
+    if (out != in
+        || len < (EVP_GCM_TLS_EXPLICIT_IV_LEN + EVP_GCM_TLS_TAG_LEN))
+        return -1;
+    if (EVP_CIPHER_CTX_ctrl(ctx, enc ? EVP_CTRL_GCM_IV_GEN
+                                     : EVP_CTRL_GCM_SET_IV_INV,
+                            EVP_GCM_TLS_EXPLICIT_IV_LEN, out) <= 0)
+        goto err;
+
+    out += EVP_GCM_TLS_EXPLICIT_IV_LEN;
+    len -= EVP_GCM_TLS_EXPLICIT_IV_LEN + EVP_GCM_TLS_TAG_LEN;
+    gctx->aad_len = gctx->tls_aad_len;
+    if (afalg_gcm_op(ctx, gctx, out, out, len, out + len))
+        rv = enc ? len + EVP_GCM_TLS_EXPLICIT_IV_LEN + EVP_GCM_TLS_TAG_LEN
+                 : len;
+    else if (!enc)
+        OPENSSL_cleanse(out, len);
+
+ err:
+    gctx->iv_set = 0;
+    gctx->tls_aad_len = -1;
+    gctx->aad_len = 0;
+    return rv;
+}
+
+/*
+ * Outside TLS records the text of each update is only collected: the
+ * operation runs on the final call, which writes all of the output and
+ * produces or checks the tag, so callers get the whole text from
+ * EVP_CipherFinal_ex() and no plaintext is released before the tag has been
+ * checked.
+ */
+static int afalg_gcm_do_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
+                               const unsigned char *in, size_t len)
+{
+    afalg_gcm_ctx *gctx = EVP_CIPHER_CTX_get_cipher_data(ctx);
+    int enc = EVP_CIPHER_CTX_encrypting(ctx);
+    size_t total;
+    int rv = -1;
+
+    if (gctx == NULL || !gctx->key_set)
+        return -1;
+    if (gctx->tls_aad_len >= 0)
+        return afalg_gcm_tls_cipher(ctx, gctx, out, in, len);
+    if (!gctx->iv_set)
+        return -1;
+
+    if (in != NULL) {
+        if (len == 0)
+            return 0;
+        /* The AAD has to come before the text */
+        if (out == NULL && gctx->text_len > 0)
+            return -1;
+        total = gctx->aad_len + gctx->text_len;
+        if (len > INT_MAX - gctx->text_len || total + len < total
+            || !afalg_gcm_reserve_aad(gctx, total + len))
+            return -1;
+        memcpy(gctx->aad + total, in, len);
+        if (out == NULL) {
+            gctx->aad_len += len;
+            return len;
+        }
+        gctx->text_len += len;
+        return 0;
+    }
+
+    if (!enc && gctx->taglen != AES_GCM_TAG_LEN)
+        goto err;
+    if (out == NULL && gctx->text_len > 0)
+        goto err;
+    if (afalg_gcm_op(ctx, gctx, out, gctx->aad + gctx->aad_len,
+                     gctx->text_len, gctx->tag)) {
+        rv = gctx->text_len;
+        if (enc)
+            gctx->taglen = AES_GCM_TAG_LEN;
+    } else if (!enc && gctx->text_len > 0) {
+        OPENSSL_cleanse(out, gctx->text_len);
+    }
+
+ err:
+    if (gctx->aad != NULL)
+        OPENSSL_cleanse(gctx->aad, gctx->aad_len + gctx->text_len);
+    gctx->iv_set = 0;
+    gctx->aad_len = 0;
+    gctx->text_len = 0;
+    return rv;
+}
+
+static int afalg_gcm_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
+{
+    afalg_gcm_ctx *gctx = EVP_CIPHER_CTX_get_cipher_data(ctx);
+    int enc = EVP_CIPHER_CTX_encrypting(ctx);
+
+    switch (type) {
+    case EVP_CTRL_INIT:
+        gctx->key_set = 0;
+        gctx->iv_set = 0;
+        gctx->iv_gen = 0;
+        gctx->iv_gen_used = 0;
+        gctx->taglen = -1;
+        gctx->tls_aad_len = -1;
+        gctx->aad_len = 0;
+        gctx->text_len = 0;
+        return 1;
+
+    case EVP_CTRL_GET_IVLEN:
+        *(int *)ptr = AES_GCM_IV_LEN;
+        return 1;
+
+    case EVP_CTRL_AEAD_SET_IVLEN:
+        /* gcm(aes) only takes 96 bit IVs */
+        return arg == AES_GCM_IV_LEN;
+
+    case EVP_CTRL_AEAD_SET_TAG:
+        /* The socket is set up for full length tags */
+        if (arg != AES_GCM_TAG_LEN || enc)
+            return 0;
+        memcpy(gctx->tag, ptr, arg);
+        gctx->taglen = arg;
+        return 1;
+
+    case EVP_CTRL_AEAD_GET_TAG:
+        if (arg <= 0 || arg > AES_GCM_TAG_LEN || !enc || gctx->taglen < 0)
+            return 0;
+        memcpy(ptr, gctx->tag, arg);
+        return 1;
+
+    case EVP_CTRL_GCM_SET_IV_FIXED:
+        /* Special case: -1 length restores whole IV */
+        if (arg == -1) {
+            memcpy(gctx->iv, ptr, AES_GCM_IV_LEN);
+            gctx->iv_gen = 1;
+            gctx->iv_gen_used = 0;
+            return 1;
+        }
+        /*
+         * Fixed field must be at least 4 bytes and invocation field at least
+         * 8.
+         */
+        if ((arg < 4) || (AES_GCM_IV_LEN - arg) < 8)
+            return 0;
+        if (arg)
+            memcpy(gctx->iv, ptr, arg);
+        if (enc && RAND_bytes(gctx->iv + arg, AES_GCM_IV_LEN - arg) <= 0)
+            return 0;
+        gctx->iv_gen = 1;
+        gctx->iv_gen_used = 0;
+        return 1;
+
+    case EVP_CTRL_GCM_IV_GEN:
+        if (gctx->iv_gen == 0 || gctx->key_set == 0)
+            return 0;
+        /*
+         * The IV is only read when the operation runs, so the invocation
+         * field of the previous one is incremented now rather than
+         * straight after it was handed out.
+         */
+        if (gctx->iv_gen_used)
+            afalg_ctr64_inc(gctx->iv + AES_GCM_IV_LEN - 8);
+        if (arg <= 0 || arg > AES_GCM_IV_LEN)
+            arg = AES_GCM_IV_LEN;
+        memcpy(ptr, gctx->iv + AES_GCM_IV_LEN - arg, arg);
+        gctx->iv_gen_used = 1;
+        gctx->iv_set = 1;
+        return 1;
+
+    case EVP_CTRL_GCM_SET_IV_INV:
+        if (gctx->iv_gen == 0 || gctx->key_set == 0 || enc)
+            return 0;
+        memcpy(gctx->iv + AES_GCM_IV_LEN - arg, ptr, arg);
+        gctx->iv_set = 1;
+        return 1;
+
+    case EVP_CTRL_AEAD_TLS1_AAD:
+        /* Save the AAD for later use */
+        if (arg != EVP_AEAD_TLS1_AAD_LEN
+            || !afalg_gcm_reserve_aad(gctx, arg))
+            return 0;
+        memcpy(gctx->aad, ptr, arg);
+        gctx->tls_aad_len = arg;
+        {
+            unsigned int len = gctx->aad[arg - 2] << 8 | gctx->aad[arg - 1];
+            /* Correct length for explicit IV */
+            if (len < EVP_GCM_TLS_EXPLICIT_IV_LEN)
+                return 0;
+            len -= EVP_GCM_TLS_EXPLICIT_IV_LEN;
+            /* If decrypting correct for tag too */
+            if (!enc) {
+                if (len < EVP_GCM_TLS_TAG_LEN)
+                    return 0;
+                len -= EVP_GCM_TLS_TAG_LEN;
+            }
+            gctx->aad[arg - 2] = len >> 8;
+            gctx->aad[arg - 1] = len & 0xff;
+        }
+        /* Extra padding: tag appended to record */
+        return EVP_GCM_TLS_TAG_LEN;
+
+    case EVP_CTRL_COPY:
+        {
+            EVP_CIPHER_CTX *out = ptr;
+            afalg_gcm_ctx *gctx_out = EVP_CIPHER_CTX_get_cipher_data(out);
+            afalg_ctx *actx_out = &gctx_out->actx;
+
+            memset(&actx_out->aio, 0, sizeof(actx_out->aio));
+            actx_out->aio.efd = -1;
+            actx_out->sfd = actx_out->bfd = -1;
+            gctx_out->aad = NULL;
+            gctx_out->aad_alloc = 0;
+            if (gctx->aad_len + gctx->text_len > 0) {
+                if (!afalg_gcm_reserve_aad(gctx_out,
+                                           gctx->aad_len + gctx->text_len))
+                    return 0;
+                memcpy(gctx_out->aad, gctx->aad,
+                       gctx->aad_len + gctx->text_len);
+            }
+            if (gctx->actx.init_done != MAGIC_INIT_NUM)
+                return 1;
+
+            /* Share the keyed tfm socket, with an operation socket of its own */
+            if ((actx_out->bfd = dup(gctx->actx.bfd)) < 0
+                || (actx_out->sfd = accept(actx_out->bfd, NULL, 0)) < 0) {
+                ALG_PERR("%s(%d): Socket Accept Failed : ", __FILE__,
+                         __LINE__);
+                AFALGerr(AFALG_F_AFALG_GCM_CTRL, AFALG_R_SOCKET_ACCEPT_FAILED);
+                if (actx_out->bfd >= 0)
+                    close(actx_out->bfd);
+                actx_out->init_done = 0;
+                return 0;
+            }
+            return 1;
+        }
+
+    default:
+        return -1;
+    }
+}
+
+static int afalg_gcm_cleanup(EVP_CIPHER_CTX *ctx)
+{
+    afalg_gcm_ctx *gctx = EVP_CIPHER_CTX_get_cipher_data(ctx);
+
+    if (gctx == NULL)
+        return 1;
+
+    OPENSSL_clear_free(gctx->aad, gctx->aad_alloc);
+    gctx->aad = NULL;
+    gctx->aad_alloc = 0;
+    if (gctx->actx.init_done != MAGIC_INIT_NUM)
+        return 1;
+
+    close(gctx->actx.sfd);
+    close(gctx->actx.bfd);
+    if (gctx->actx.aio.aio_ctx != 0)
+        io_destroy(gctx->actx.aio.aio_ctx);
 
     return 1;
 }
 
+static int afalg_digest_bfd(int nid)
+{
+    size_t i;
+
+    for (i = 0; i < OSSL_NELEM(afalg_digest_data); i++)
+        if (afalg_digest_data[i].nid == nid)
+            return afalg_digest_sk[i];
+    return -1;
+}
+
+static int afalg_digest_init(EVP_MD_CTX *ctx)
+{
+    afalg_digest_ctx *dctx = EVP_MD_CTX_md_data(ctx);
+    int bfd = afalg_digest_bfd(EVP_MD_CTX_type(ctx));
+
+    if (dctx == NULL || bfd < 0)
+        return 0;
+
+    if (dctx->init_done == MAGIC_INIT_NUM) {
+        /* An operation socket is reusable once its digest has been read */
+        if (!dctx->more)
+            return 1;
+        close(dctx->sfd);
+        dctx->init_done = 0;
+    }
+
+    /* Each operation socket on the shared tfm socket hashes independently */
+    dctx->sfd = accept(bfd, NULL, 0);
+    if (dctx->sfd < 0) {
+        ALG_PERR("%s(%d): Socket Accept Failed : ", __FILE__, __LINE__);
+        AFALGerr(AFALG_F_AFALG_DIGEST_INIT, AFALG_R_SOCKET_ACCEPT_FAILED);
+        return 0;
+    }
+    dctx->more = 0;
+    dctx->init_done = MAGIC_INIT_NUM;
+    return 1;
+}
+
+static int afalg_digest_update(EVP_MD_CTX *ctx, const void *data,
+                               size_t count)
+{
+    afalg_digest_ctx *dctx = EVP_MD_CTX_md_data(ctx);
+    const unsigned char *p = data;
+    ssize_t sbytes;
+
+    if (count == 0)
+        return 1;
+    if (dctx == NULL || dctx->init_done != MAGIC_INIT_NUM)
+        return 0;
+
+    while (count > 0) {
+        sbytes = send(dctx->sfd, p, count, MSG_MORE);
+        if (sbytes < 0) {
+            if (errno == EINTR)
+                continue;
+            ALG_PERR("%s(%d): send failed for digest operation : ", __FILE__,
+                     __LINE__);
+            return 0;
+        }
+        p += sbytes;
+        count -= sbytes;
+    }
+    dctx->more = 1;
+    return 1;
+}
+
+static int afalg_digest_final(EVP_MD_CTX *ctx, unsigned char *md)
+{
+    afalg_digest_ctx *dctx = EVP_MD_CTX_md_data(ctx);
+    int len = EVP_MD_CTX_size(ctx);
+
+    if (md == NULL || dctx == NULL || dctx->init_done != MAGIC_INIT_NUM)
+        return 0;
+
+    /* Reading the result completes the hash and resets the socket */
+    if (read(dctx->sfd, md, len) != len) {
+        ALG_PERR("%s(%d): read failed for digest operation : ", __FILE__,
+                 __LINE__);
+        return 0;
+    }
+    dctx->more = 0;
+    return 1;
+}
+
+static int afalg_digest_copy(EVP_MD_CTX *to, const EVP_MD_CTX *from)
+{
+    afalg_digest_ctx *dfrom = EVP_MD_CTX_md_data(from);
+    afalg_digest_ctx *dto = EVP_MD_CTX_md_data(to);
+
+    if (dfrom == NULL || dfrom->init_done != MAGIC_INIT_NUM)
+        return 1;
+
+    /* accept() on an operation socket clones its hash state */
+    dto->sfd = accept(dfrom->sfd, NULL, 0);
+    if (dto->sfd < 0) {
+        ALG_PERR("%s(%d): Socket Accept Failed : ", __FILE__, __LINE__);
+        AFALGerr(AFALG_F_AFALG_DIGEST_COPY, AFALG_R_SOCKET_ACCEPT_FAILED);
+        dto->init_done = 0;
+        return 0;
+    }
+    return 1;
+}
+
+static int afalg_digest_cleanup(EVP_MD_CTX *ctx)
+{
+    afalg_digest_ctx *dctx = EVP_MD_CTX_md_data(ctx);
+
+    if (dctx == NULL || dctx->init_done != MAGIC_INIT_NUM)
+        return 1;
+
+    close(dctx->sfd);
+    dctx->init_done = 0;
+    return 1;
+}
+
+/* Returns a tfm socket bound to |name|, or -1 if the kernel lacks it */
+static int afalg_bind_sk(const char *type, const char *name)
+{
+    struct sockaddr_alg sa;
+    int sock;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.salg_family = AF_ALG;
+    OPENSSL_strlcpy((char *) sa.salg_type, type, sizeof(sa.salg_type));
+    OPENSSL_strlcpy((char *) sa.salg_name, name, sizeof(sa.salg_name));
+
+    sock = socket(AF_ALG, SOCK_SEQPACKET, 0);
+    if (sock == -1)
+        return -1;
+    if (bind(sock, (struct sockaddr *)&sa, sizeof(sa)) < 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+static void prepare_digest_methods(void)
+{
+    size_t i;
+    const EVP_MD *md;
+    EVP_MD *meth;
+
+    for (i = 0, afalg_digest_nids_num = 0;
+         i < OSSL_NELEM(afalg_digest_data); i++) {
+        /*
+         * Unkeyed hashes can share one tfm socket: EVP_DigestFinal_ex()
+         * cleans up after every digest, so contexts only accept() their
+         * operation sockets from it
+         */
+        if ((afalg_digest_sk[i] = afalg_bind_sk("hash",
+                                                afalg_digest_data[i].name)) < 0)
+            continue;
+        /* Sizes and flags are those of the built-in implementation */
+        md = afalg_digest_data[i].md();
+        if ((meth = EVP_MD_meth_new(afalg_digest_data[i].nid,
+                                    EVP_MD_pkey_type(md))) == NULL
+            || !EVP_MD_meth_set_input_blocksize(meth, EVP_MD_block_size(md))
+            || !EVP_MD_meth_set_result_size(meth, EVP_MD_size(md))
+            || !EVP_MD_meth_set_flags(meth, EVP_MD_flags(md))
+            || !EVP_MD_meth_set_init(meth, afalg_digest_init)
+            || !EVP_MD_meth_set_update(meth, afalg_digest_update)
+            || !EVP_MD_meth_set_final(meth, afalg_digest_final)
+            || !EVP_MD_meth_set_copy(meth, afalg_digest_copy)
+            || !EVP_MD_meth_set_cleanup(meth, afalg_digest_cleanup)
+            || !EVP_MD_meth_set_app_datasize(meth,
+                                             sizeof(afalg_digest_ctx))) {
+            EVP_MD_meth_free(meth);
+            close(afalg_digest_sk[i]);
+            afalg_digest_sk[i] = -1;
+            continue;
+        }
+        afalg_digest_methods[i] = meth;
+        afalg_digest_nids[afalg_digest_nids_num++] = afalg_digest_data[i].nid;
+    }
+}
+
+static int afalg_digests(ENGINE *e, const EVP_MD **digest,
+                         const int **nids, int nid)
+{
+    size_t i;
+
+    if (digest == NULL) {
+        *nids = afalg_digest_nids;
+        return afalg_digest_nids_num;
+    }
+
+    for (i = 0; i < OSSL_NELEM(afalg_digest_data); i++) {
+        if (afalg_digest_data[i].nid == nid) {
+            *digest = afalg_digest_methods[i];
+            return *digest != NULL;
+        }
+    }
+    *digest = NULL;
+    return 0;
+}
+
 static cbc_handles *get_cipher_handle(int nid)
 {
     switch (nid) {
@@ -650,6 +1690,12 @@ static cbc_handles *get_cipher_handle(int nid)
         return &cbc_handle[AES_CBC_192];
     case NID_aes_256_cbc:
         return &cbc_handle[AES_CBC_256];
+    case NID_aes_128_gcm:
+        return &gcm_handle[AES_GCM_128];
+    case NID_aes_192_gcm:
+        return &gcm_handle[AES_GCM_192];
+    case NID_aes_256_gcm:
+        return &gcm_handle[AES_GCM_256];
     default:
         return NULL;
     }
@@ -682,6 +1728,39 @@ static const EVP_CIPHER *afalg_aes_cbc(int nid)
     return cipher_handle->_hidden;
 }
 
+static const EVP_CIPHER *afalg_aes_gcm(int nid)
+{
+    cbc_handles *cipher_handle = get_cipher_handle(nid);
+    if (cipher_handle->_hidden == NULL
+        && ((cipher_handle->_hidden =
+         EVP_CIPHER_meth_new(nid, 1, cipher_handle->key_size)) == NULL
+        || !EVP_CIPHER_meth_set_iv_length(cipher_handle->_hidden,
+                                          AES_GCM_IV_LEN)
+        || !EVP_CIPHER_meth_set_flags(cipher_handle->_hidden,
+                                      EVP_CIPH_GCM_MODE |
+                                      EVP_CIPH_FLAG_DEFAULT_ASN1 |
+                                      EVP_CIPH_CUSTOM_IV |
+                                      EVP_CIPH_FLAG_CUSTOM_CIPHER |
+                                      EVP_CIPH_ALWAYS_CALL_INIT |
+                                      EVP_CIPH_CTRL_INIT |
+                                      EVP_CIPH_CUSTOM_COPY |
+                                      EVP_CIPH_FLAG_AEAD_CIPHER)
+        || !EVP_CIPHER_meth_set_init(cipher_handle->_hidden,
+                                     afalg_gcm_init)
+        || !EVP_CIPHER_meth_set_do_cipher(cipher_handle->_hidden,
+                                          afalg_gcm_do_cipher)
+        || !EVP_CIPHER_meth_set_ctrl(cipher_handle->_hidden,
+                                     afalg_gcm_ctrl)
+        || !EVP_CIPHER_meth_set_cleanup(cipher_handle->_hidden,
+                                        afalg_gcm_cleanup)
+        || !EVP_CIPHER_meth_set_impl_ctx_size(cipher_handle->_hidden,
+                                              sizeof(afalg_gcm_ctx)))) {
+        EVP_CIPHER_meth_free(cipher_handle->_hidden);
+        cipher_handle->_hidden= NULL;
+    }
+    return cipher_handle->_hidden;
+}
+
 static int afalg_ciphers(ENGINE *e, const EVP_CIPHER **cipher,
                          const int **nids, int nid)
 {
@@ -689,7 +1768,7 @@ static int afalg_ciphers(ENGINE *e, const EVP_CIPHER **cipher,
 
     if (cipher == NULL) {
         *nids = afalg_cipher_nids;
-        return (sizeof(afalg_cipher_nids) / sizeof(afalg_cipher_nids[0]));
+        return afalg_cipher_nids_num;
     }
 
     switch (nid) {
@@ -698,6 +1777,16 @@ static int afalg_ciphers(ENGINE *e, const EVP_CIPHER **cipher,
     case NID_aes_256_cbc:
         *cipher = afalg_aes_cbc(nid);
         break;
+    case NID_aes_128_gcm:
+    case NID_aes_192_gcm:
+    case NID_aes_256_gcm:
+        if (afalg_cipher_nids_num == (int)OSSL_NELEM(afalg_cipher_nids)) {
+            *cipher = afalg_aes_gcm(nid);
+        } else {
+            *cipher = NULL;
+            r = 0;
+        }
+        break;
     default:
         *cipher = NULL;
         r = 0;
@@ -709,30 +1798,50 @@ static int bind_afalg(ENGINE *e)
 {
     /* Ensure the afalg error handling is set up */
     unsigned short i;
+    int sk;
     ERR_load_AFALG_strings();
 
     if (!ENGINE_set_id(e, engine_afalg_id)
         || !ENGINE_set_name(e, engine_afalg_name)
         || !ENGINE_set_destroy_function(e, afalg_destroy)
         || !ENGINE_set_init_function(e, afalg_init)
-        || !ENGINE_set_finish_function(e, afalg_finish)) {
+        || !ENGINE_set_finish_function(e, afalg_finish)
+        || !ENGINE_set_ctrl_function(e, afalg_ctrl)
+# ifdef AFALG_IO_URING
+        || !ENGINE_set_cmd_defns(e, afalg_cmd_defns)
+# endif
+        ) {
         AFALGerr(AFALG_F_BIND_AFALG, AFALG_R_INIT_FAILED);
         return 0;
     }
 
+    /*
+     * AES-GCM relies on the kernel copying the AAD to the output, which
+     * it does from 4.14 on
+     */
+    if (afalg_kver >= KERNEL_VERSION(4, 14, 0)
+        && (sk = afalg_bind_sk("aead", "gcm(aes)")) >= 0) {
+        close(sk);
+        afalg_cipher_nids_num = OSSL_NELEM(afalg_cipher_nids);
+    }
+
     /*
      * Create _hidden_aes_xxx_cbc by calling afalg_aes_xxx_cbc
      * now, as bind_aflag can only be called by one thread at a
      * time.
      */
-    for(i = 0; i < OSSL_NELEM(afalg_cipher_nids); i++) {
-        if (afalg_aes_cbc(afalg_cipher_nids[i]) == NULL) {
+    for(i = 0; i < afalg_cipher_nids_num; i++) {
+        if ((i <= AES_CBC_256 ? afalg_aes_cbc(afalg_cipher_nids[i])
+                              : afalg_aes_gcm(afalg_cipher_nids[i])) == NULL) {
             AFALGerr(AFALG_F_BIND_AFALG, AFALG_R_INIT_FAILED);
             return 0;
         }
     }
 
-    if (!ENGINE_set_ciphers(e, afalg_ciphers)) {
+    prepare_digest_methods();
+
+    if (!ENGINE_set_ciphers(e, afalg_ciphers)
+        || !ENGINE_set_digests(e, afalg_digests)) {
         AFALGerr(AFALG_F_BIND_AFALG, AFALG_R_INIT_FAILED);
         return 0;
     }
@@ -780,8 +1889,8 @@ static int afalg_chk_platform(void)
         str = strtok(NULL, ".");
     }
 
-    if (KERNEL_VERSION(kver[0], kver[1], kver[2])
-        < KERNEL_VERSION(K_MAJ, K_MIN1, K_MIN2)) {
+    afalg_kver = KERNEL_VERSION(kver[0], kver[1], kver[2]);
+    if (afalg_kver < KERNEL_VERSION(K_MAJ, K_MIN1, K_MIN2)) {
         ALG_ERR("ASYNC AFALG not supported this kernel(%d.%d.%d)\n",
                  kver[0], kver[1], kver[2]);
         ALG_ERR("ASYNC AFALG requires kernel version %d.%d.%d or later\n",
@@ -841,13 +1950,51 @@ static int afalg_finish(ENGINE *e)
     return 1;
 }
 
+static int afalg_ctrl(ENGINE *e, int cmd, long i, void *p, void (*f) (void))
+{
+    switch (cmd) {
+# ifdef AFALG_IO_URING
+    case AFALG_CMD_USE_IO_URING:
+        afalg_use_io_uring = i != 0;
+        return 1;
+    case AFALG_CMD_SQPOLL_IDLE:
+        if (i < 0)
+            break;
+        afalg_sqpoll_idle = (unsigned int)i;
+        return 1;
+# endif
+    default:
+        break;
+    }
+    AFALGerr(AFALG_F_AFALG_CTRL, AFALG_R_UNKNOWN_COMMAND);
+    return 0;
+}
+
 static int free_cbc(void)
 {
     short unsigned int i;
-    for(i = 0; i < OSSL_NELEM(afalg_cipher_nids); i++) {
+    for(i = 0; i < OSSL_NELEM(cbc_handle); i++) {
         EVP_CIPHER_meth_free(cbc_handle[i]._hidden);
         cbc_handle[i]._hidden = NULL;
+        EVP_CIPHER_meth_free(gcm_handle[i]._hidden);
+        gcm_handle[i]._hidden = NULL;
+    }
+    afalg_cipher_nids_num = AES_CBC_256 + 1;
+    return 1;
+}
+
+static int free_digests(void)
+{
+    size_t i;
+
+    for (i = 0; i < OSSL_NELEM(afalg_digest_data); i++) {
+        EVP_MD_meth_free(afalg_digest_methods[i]);
+        afalg_digest_methods[i] = NULL;
+        if (afalg_digest_sk[i] >= 0)
+            close(afalg_digest_sk[i]);
+        afalg_digest_sk[i] = -1;
     }
+    afalg_digest_nids_num = 0;
     return 1;
 }
 
@@ -855,6 +2002,7 @@ static int afalg_destroy(ENGINE *e)
 {
     ERR_unload_AFALG_strings();
     free_cbc();
+    free_digests();
     return 1;
 }
 
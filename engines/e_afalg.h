@@ -44,9 +44,16 @@
 # define AES_KEY_SIZE_192 24
 # define AES_KEY_SIZE_256 32
 # define AES_IV_LEN       16
+# define AES_GCM_IV_LEN   12
+# define AES_GCM_TAG_LEN  16
 
 # define MAX_INFLIGHTS 1
 
+/* Room for the operation, IV and AAD length control messages */
+# define ALG_CMSG_BUFLEN  (CMSG_SPACE(sizeof(unsigned int)) \
+                           + CMSG_SPACE(sizeof(struct af_alg_iv) + AES_IV_LEN) \
+                           + CMSG_SPACE(sizeof(unsigned int)))
+
 typedef enum {
     MODE_UNINIT = 0,
     MODE_SYNC,
@@ -59,6 +66,12 @@ enum {
     AES_CBC_256
 };
 
+enum {
+    AES_GCM_128 = 0,
+    AES_GCM_192,
+    AES_GCM_256
+};
+
 struct cbc_cipher_handles {
     int key_size;
     EVP_CIPHER *_hidden;
@@ -66,12 +79,48 @@ struct cbc_cipher_handles {
 
 typedef struct cbc_cipher_handles cbc_handles;
 
+# ifdef AFALG_IO_URING
+/*
+ * An io_uring shared by all AFALG operations of one ASYNC_WAIT_CTX. The ring
+ * fd is the wait fd handed to the application: it polls readable once a
+ * completion is queued, and the paused job reaps completions straight from
+ * the mapped completion queue.
+ */
+#  define AFALG_RING_ENTRIES 8
+
+struct afalg_ring_st {
+    int fd;
+    int sqpoll;
+    int broken;
+    unsigned int seq;
+    void *sq_ring;
+    size_t sq_ring_sz;
+    void *cq_ring;
+    size_t cq_ring_sz;
+    struct io_uring_sqe *sqes;
+    size_t sqes_sz;
+    unsigned int *sq_head;
+    unsigned int *sq_tail;
+    unsigned int *sq_mask;
+    unsigned int *sq_flags;
+    unsigned int *sq_array;
+    unsigned int *cq_head;
+    unsigned int *cq_tail;
+    unsigned int *cq_mask;
+    struct io_uring_cqe *cqes;
+};
+typedef struct afalg_ring_st afalg_ring;
+# endif
+
 struct afalg_aio_st {
     int efd;
     op_mode mode;
     aio_context_t aio_ctx;
     struct io_event events[MAX_INFLIGHTS];
     struct iocb cbt[MAX_INFLIGHTS];
+# ifdef AFALG_IO_URING
+    afalg_ring *ring;
+# endif
 };
 typedef struct afalg_aio_st afalg_aio;
 
@@ -89,7 +138,43 @@ struct afalg_ctx_st {
     int zc_pipe[2];
 # endif
     afalg_aio aio;
+    /* sendmsg() request of the operation in flight */
+    struct msghdr msg;
+    struct iovec iov[3];
+    unsigned char cbuf[ALG_CMSG_BUFLEN];
 };
 
 typedef struct afalg_ctx_st afalg_ctx;
+
+struct afalg_gcm_ctx_st {
+    afalg_ctx actx;
+    int key_set;
+    int iv_set;
+    int iv_gen;
+    /* the IV has been handed out by EVP_CTRL_GCM_IV_GEN */
+    int iv_gen_used;
+    int taglen;
+    int tls_aad_len;
+    unsigned char iv[AES_GCM_IV_LEN];
+    unsigned char tag[AES_GCM_TAG_LEN];
+    /*
+     * The kernel cannot resume a GCM stream, so the AAD and then the text
+     * are collected here and run as one operation on the final call
+     */
+    unsigned char *aad;
+    size_t aad_len;
+    size_t text_len;
+    size_t aad_alloc;
+};
+
+typedef struct afalg_gcm_ctx_st afalg_gcm_ctx;
+
+struct afalg_digest_ctx_st {
+    int init_done;
+    int sfd;
+    /* data has been sent since the last digest was read */
+    int more;
+};
+
+typedef struct afalg_digest_ctx_st afalg_digest_ctx;
 #endif
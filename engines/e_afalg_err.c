@@ -16,6 +16,12 @@
 static ERR_STRING_DATA AFALG_str_functs[] = {
     {ERR_PACK(0, AFALG_F_AFALG_CHK_PLATFORM, 0), "afalg_chk_platform"},
     {ERR_PACK(0, AFALG_F_AFALG_CREATE_SK, 0), "afalg_create_sk"},
+    {ERR_PACK(0, AFALG_F_AFALG_CTRL, 0), "afalg_ctrl"},
+    {ERR_PACK(0, AFALG_F_AFALG_DIGEST_COPY, 0), "afalg_digest_copy"},
+    {ERR_PACK(0, AFALG_F_AFALG_DIGEST_INIT, 0), "afalg_digest_init"},
+    {ERR_PACK(0, AFALG_F_AFALG_GCM_CTRL, 0), "afalg_gcm_ctrl"},
+    {ERR_PACK(0, AFALG_F_AFALG_GCM_INIT, 0), "afalg_gcm_init"},
+    {ERR_PACK(0, AFALG_F_AFALG_GCM_RESERVE_AAD, 0), "afalg_gcm_reserve_aad"},
     {ERR_PACK(0, AFALG_F_AFALG_INIT_AIO, 0), "afalg_init_aio"},
     {ERR_PACK(0, AFALG_F_AFALG_SETUP_ASYNC_EVENT_NOTIFICATION, 0),
      "afalg_setup_async_event_notification"},
@@ -41,6 +47,7 @@ static ERR_STRING_DATA AFALG_str_reasons[] = {
     {ERR_PACK(0, 0, AFALG_R_SOCKET_OPERATION_FAILED),
     "socket operation failed"},
     {ERR_PACK(0, 0, AFALG_R_SOCKET_SET_KEY_FAILED), "socket set key failed"},
+    {ERR_PACK(0, 0, AFALG_R_UNKNOWN_COMMAND), "unknown command"},
     {0, NULL}
 };
 
@@ -19,6 +19,12 @@
  */
 # define AFALG_F_AFALG_CHK_PLATFORM                       100
 # define AFALG_F_AFALG_CREATE_SK                          101
+# define AFALG_F_AFALG_CTRL                               106
+# define AFALG_F_AFALG_DIGEST_COPY                        107
+# define AFALG_F_AFALG_DIGEST_INIT                        108
+# define AFALG_F_AFALG_GCM_CTRL                           109
+# define AFALG_F_AFALG_GCM_INIT                           110
+# define AFALG_F_AFALG_GCM_RESERVE_AAD                    111
 # define AFALG_F_AFALG_INIT_AIO                           102
 # define AFALG_F_AFALG_SETUP_ASYNC_EVENT_NOTIFICATION     103
 # define AFALG_F_AFALG_SET_KEY                            104
@@ -39,5 +45,6 @@
 # define AFALG_R_SOCKET_CREATE_FAILED                     109
 # define AFALG_R_SOCKET_OPERATION_FAILED                  104
 # define AFALG_R_SOCKET_SET_KEY_FAILED                    106
+# define AFALG_R_UNKNOWN_COMMAND                          112
 
 #endif
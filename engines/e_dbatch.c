@@ -0,0 +1,966 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * A dummy batching engine, showing how a look-aside accelerator with a
+ * request ring and a response ring (as found on QAT-style devices) is
+ * driven from OpenSSL.
+ *
+ * Requests are put on a submission ring and the "device", emulated by a
+ * thread doing the work in software, is told about them through a doorbell.
+ * The device takes up to BATCH_SIZE requests at a time, runs requests of
+ * the same kind together and posts the responses to a completion ring. The
+ * completion ring is drained either by a polling thread started with the
+ * engine (POLL_THREAD=1, the default) or by the application calling the
+ * POLL command from its event loop (POLL_THREAD=0), which is how the
+ * interrupt-free polling modes of real devices are driven.
+ *
+ * A request made from an ASYNC_JOB pauses the job, and the file descriptor
+ * the engine registers with the job's ASYNC_WAIT_CTX becomes readable once
+ * its response has been drained. Requests made outside a job block until
+ * they complete.
+ *
+ * RSA private key operations, ECDH, AES-GCM and the encapsulation and
+ * decapsulation of the KEMs known to libcrypto are offloaded. KEM
+ * encapsulations of the same algorithm found together on the ring are run
+ * with EVP_PKEY_encapsulate_batch(3).
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <openssl/engine.h>
+#include <openssl/async.h>
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/rsa.h>
+#include <openssl/ec.h>
+#include "internal/nelem.h"
+
+#if defined(OPENSSL_SYS_UNIX) && defined(OPENSSL_THREADS)
+# undef DBATCH_DEVICE
+# define DBATCH_DEVICE
+# include <fcntl.h>
+# include <pthread.h>
+# include <unistd.h>
+#endif
+
+#include "e_dbatch_err.c"
+
+/* Engine Id and Name */
+static const char *engine_dbatch_id = "dbatch";
+static const char *engine_dbatch_name = "Dummy batching engine support";
+
+/* Engine Lifetime functions */
+static int dbatch_destroy(ENGINE *e);
+static int dbatch_init(ENGINE *e);
+static int dbatch_finish(ENGINE *e);
+static int dbatch_ctrl(ENGINE *e, int cmd, long i, void *p, void (*f) (void));
+
+#define DBATCH_CMD_POLL_THREAD      ENGINE_CMD_BASE
+#define DBATCH_CMD_POLL             (ENGINE_CMD_BASE + 1)
+#define DBATCH_CMD_BATCH_SIZE       (ENGINE_CMD_BASE + 2)
+#define DBATCH_CMD_GET_NUM_BATCHES  (ENGINE_CMD_BASE + 3)
+
+static const ENGINE_CMD_DEFN dbatch_cmd_defns[] = {
+    {DBATCH_CMD_POLL_THREAD,
+     "POLL_THREAD",
+     "Drain the completion ring from a thread of the engine (1=default) "
+     "or from the POLL command (0), set before the engine is initialised",
+     ENGINE_CMD_FLAG_NUMERIC},
+    {DBATCH_CMD_POLL,
+     "POLL",
+     "Drain the completion ring and wake up the jobs whose requests completed",
+     ENGINE_CMD_FLAG_NO_INPUT},
+    {DBATCH_CMD_BATCH_SIZE,
+     "BATCH_SIZE",
+     "Maximum number of requests the device takes off the ring at once "
+     "(1 to 256, 16=default)",
+     ENGINE_CMD_FLAG_NUMERIC},
+    {DBATCH_CMD_GET_NUM_BATCHES,
+     "GET_NUM_BATCHES",
+     "Store the number of batches and of requests run so far in the two "
+     "unsigned longs pointed to",
+     ENGINE_CMD_FLAG_INTERNAL},
+    {0, NULL, NULL, 0}
+};
+
+#define DBATCH_RING_SIZE        256
+#define DBATCH_DEFAULT_BATCH    16
+
+/* Requests */
+
+typedef struct dbatch_req_st DBATCH_REQ;
+
+struct dbatch_req_st {
+    /* Requests with the same |run| and |kind| may be run together */
+    int (*run) (DBATCH_REQ *req);
+    int (*run_batch) (DBATCH_REQ *reqs[], size_t num);
+    const void *kind;
+    union {
+        struct {
+            int (*op) (int flen, const unsigned char *from,
+                       unsigned char *to, RSA *rsa, int padding);
+            int flen;
+            const unsigned char *from;
+            unsigned char *to;
+            RSA *rsa;
+            int padding;
+        } rsa;
+        struct {
+            unsigned char **psec;
+            size_t *pseclen;
+            const EC_POINT *pub_key;
+            const EC_KEY *ecdh;
+        } ecdh;
+        struct {
+            int (*do_cipher) (EVP_CIPHER_CTX *ctx, unsigned char *out,
+                              const unsigned char *in, size_t inl);
+            EVP_CIPHER_CTX *ctx;
+            unsigned char *out;
+            const unsigned char *in;
+            size_t inl;
+        } cipher;
+        struct {
+            const EVP_PKEY_METHOD *pmeth;
+            EVP_PKEY_CTX *ctx;
+            unsigned char *out;
+            size_t *outlen;
+            unsigned char *out2;
+            size_t *out2len;
+            const unsigned char *in;
+            size_t inlen;
+        } kem;
+    } u;
+    int result;
+    unsigned long err;          /* error raised while running the request */
+    int done;                   /* protected by the device lock */
+    int notify_fd;              /* -1 if the submitter blocks */
+};
+
+static void dbatch_req_run(DBATCH_REQ *req)
+{
+    req->result = req->run(req);
+    if (req->result <= 0) {
+        req->err = ERR_peek_last_error();
+        ERR_clear_error();
+    }
+}
+
+/* Runs |num| requests of the same kind, together if they can be */
+static void dbatch_run_group(DBATCH_REQ *reqs[], size_t num)
+{
+    size_t i;
+
+    if (num > 1 && reqs[0]->run_batch != NULL && reqs[0]->run_batch(reqs, num))
+        return;
+    for (i = 0; i < num; i++)
+        dbatch_req_run(reqs[i]);
+}
+
+/* Runs |num| requests taken off the ring, grouping them by kind */
+static void dbatch_run_all(DBATCH_REQ *reqs[], size_t num)
+{
+    DBATCH_REQ *group[DBATCH_RING_SIZE];
+    unsigned char taken[DBATCH_RING_SIZE];
+    size_t i, j, n;
+
+    memset(taken, 0, num);
+    for (i = 0; i < num; i++) {
+        if (taken[i])
+            continue;
+        for (n = 0, j = i; j < num; j++) {
+            if (!taken[j] && reqs[j]->run == reqs[i]->run
+                    && reqs[j]->kind == reqs[i]->kind) {
+                group[n++] = reqs[j];
+                taken[j] = 1;
+            }
+        }
+        dbatch_run_group(group, n);
+    }
+}
+
+#ifdef DBATCH_DEVICE
+
+/* A ring of request pointers, DBATCH_RING_SIZE is a power of two */
+typedef struct {
+    DBATCH_REQ *slots[DBATCH_RING_SIZE];
+    size_t head;                /* next slot to take */
+    size_t tail;                /* next slot to fill */
+} DBATCH_RING;
+
+# define DBATCH_RING_MASK       (DBATCH_RING_SIZE - 1)
+
+static ossl_inline size_t ring_count(const DBATCH_RING *ring)
+{
+    return ring->tail - ring->head;
+}
+
+static ossl_inline void ring_put(DBATCH_RING *ring, DBATCH_REQ *req)
+{
+    ring->slots[ring->tail++ & DBATCH_RING_MASK] = req;
+}
+
+static ossl_inline DBATCH_REQ *ring_take(DBATCH_RING *ring)
+{
+    return ring->slots[ring->head++ & DBATCH_RING_MASK];
+}
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t doorbell;    /* requests were submitted */
+    pthread_cond_t response;    /* responses were posted or drained */
+    DBATCH_RING sq;
+    DBATCH_RING cq;
+    size_t in_flight;           /* requests on either ring or running */
+    pthread_t device;
+    pthread_t poller;
+    int running;
+    unsigned long batches;
+    unsigned long requests;
+} dbatch_dev = {
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+    PTHREAD_COND_INITIALIZER
+};
+
+#endif /* DBATCH_DEVICE */
+
+static int dbatch_poll_thread = 1;
+static size_t dbatch_batch_size = DBATCH_DEFAULT_BATCH;
+
+#ifdef DBATCH_DEVICE
+
+static void *dbatch_device_main(void *arg)
+{
+    DBATCH_REQ *reqs[DBATCH_RING_SIZE];
+    size_t i, num;
+
+    pthread_mutex_lock(&dbatch_dev.lock);
+    for (;;) {
+        while (dbatch_dev.running && ring_count(&dbatch_dev.sq) == 0)
+            pthread_cond_wait(&dbatch_dev.doorbell, &dbatch_dev.lock);
+        if (ring_count(&dbatch_dev.sq) == 0)
+            break;
+        for (num = 0; num < dbatch_batch_size
+                      && ring_count(&dbatch_dev.sq) > 0; num++)
+            reqs[num] = ring_take(&dbatch_dev.sq);
+        pthread_mutex_unlock(&dbatch_dev.lock);
+
+        dbatch_run_all(reqs, num);
+
+        pthread_mutex_lock(&dbatch_dev.lock);
+        for (i = 0; i < num; i++)
+            ring_put(&dbatch_dev.cq, reqs[i]);
+        dbatch_dev.batches++;
+        dbatch_dev.requests += num;
+        pthread_cond_broadcast(&dbatch_dev.response);
+    }
+    pthread_mutex_unlock(&dbatch_dev.lock);
+    return NULL;
+}
+
+/*
+ * Drains the completion ring and wakes up the submitters, called with the
+ * device lock held. The wake-up is written before |done| is set so that the
+ * wait context of a submitter seeing it cannot have been freed yet.
+ */
+static size_t dbatch_poll_locked(void)
+{
+    DBATCH_REQ *req;
+    size_t num = 0;
+    char c = 'X';
+
+    while (ring_count(&dbatch_dev.cq) > 0) {
+        req = ring_take(&dbatch_dev.cq);
+        if (req->notify_fd >= 0 && write(req->notify_fd, &c, 1) < 0) {
+            /* The pipe being full is as good as a wake-up */
+        }
+        req->done = 1;
+        dbatch_dev.in_flight--;
+        num++;
+    }
+    if (num > 0)
+        pthread_cond_broadcast(&dbatch_dev.response);
+    return num;
+}
+
+static void *dbatch_poller_main(void *arg)
+{
+    pthread_mutex_lock(&dbatch_dev.lock);
+    while (dbatch_dev.running || dbatch_dev.in_flight > 0) {
+        if (dbatch_poll_locked() == 0)
+            pthread_cond_wait(&dbatch_dev.response, &dbatch_dev.lock);
+    }
+    pthread_mutex_unlock(&dbatch_dev.lock);
+    return NULL;
+}
+
+static int dbatch_device_start(void)
+{
+    pthread_mutex_lock(&dbatch_dev.lock);
+    if (dbatch_dev.running) {
+        pthread_mutex_unlock(&dbatch_dev.lock);
+        return 1;
+    }
+    dbatch_dev.running = 1;
+    if (pthread_create(&dbatch_dev.device, NULL, dbatch_device_main,
+                       NULL) != 0) {
+        dbatch_dev.running = 0;
+        pthread_mutex_unlock(&dbatch_dev.lock);
+        return 0;
+    }
+    if (dbatch_poll_thread
+            && pthread_create(&dbatch_dev.poller, NULL, dbatch_poller_main,
+                              NULL) != 0) {
+        dbatch_dev.running = 0;
+        pthread_cond_broadcast(&dbatch_dev.doorbell);
+        pthread_mutex_unlock(&dbatch_dev.lock);
+        pthread_join(dbatch_dev.device, NULL);
+        return 0;
+    }
+    pthread_mutex_unlock(&dbatch_dev.lock);
+    return 1;
+}
+
+/* Completes the requests still in flight and stops the device */
+static void dbatch_device_stop(void)
+{
+    int poll_thread;
+
+    pthread_mutex_lock(&dbatch_dev.lock);
+    if (!dbatch_dev.running) {
+        pthread_mutex_unlock(&dbatch_dev.lock);
+        return;
+    }
+    poll_thread = dbatch_poll_thread;
+    dbatch_dev.running = 0;
+    pthread_cond_broadcast(&dbatch_dev.doorbell);
+    pthread_cond_broadcast(&dbatch_dev.response);
+    pthread_mutex_unlock(&dbatch_dev.lock);
+
+    pthread_join(dbatch_dev.device, NULL);
+    if (poll_thread) {
+        pthread_join(dbatch_dev.poller, NULL);
+    } else {
+        pthread_mutex_lock(&dbatch_dev.lock);
+        dbatch_poll_locked();
+        pthread_mutex_unlock(&dbatch_dev.lock);
+    }
+}
+
+static void wait_cleanup(ASYNC_WAIT_CTX *ctx, const void *key,
+                         OSSL_ASYNC_FD readfd, void *pvwritefd)
+{
+    OSSL_ASYNC_FD *pwritefd = (OSSL_ASYNC_FD *)pvwritefd;
+
+    close(readfd);
+    close(*pwritefd);
+    OPENSSL_free(pwritefd);
+}
+
+/* Returns the write end of the wake-up pipe of |waitctx|, or -1 */
+static int dbatch_wait_fd(ASYNC_WAIT_CTX *waitctx, OSSL_ASYNC_FD *readfd)
+{
+    OSSL_ASYNC_FD pipefds[2];
+    OSSL_ASYNC_FD *writefd;
+
+    if (ASYNC_WAIT_CTX_get_fd(waitctx, engine_dbatch_id, readfd,
+                              (void **)&writefd))
+        return *writefd;
+
+    if ((writefd = OPENSSL_malloc(sizeof(*writefd))) == NULL)
+        return -1;
+    if (pipe(pipefds) != 0) {
+        OPENSSL_free(writefd);
+        return -1;
+    }
+    if (fcntl(pipefds[0], F_SETFL, O_NONBLOCK) != 0
+            || fcntl(pipefds[1], F_SETFL, O_NONBLOCK) != 0) {
+        close(pipefds[0]);
+        close(pipefds[1]);
+        OPENSSL_free(writefd);
+        return -1;
+    }
+    *writefd = pipefds[1];
+    if (!ASYNC_WAIT_CTX_set_wait_fd(waitctx, engine_dbatch_id, pipefds[0],
+                                    writefd, wait_cleanup)) {
+        wait_cleanup(waitctx, engine_dbatch_id, pipefds[0], writefd);
+        return -1;
+    }
+    *readfd = pipefds[0];
+    return *writefd;
+}
+
+static void dbatch_wait_drain(OSSL_ASYNC_FD readfd)
+{
+    char buf[32];
+
+    while (read(readfd, buf, sizeof(buf)) > 0)
+        continue;
+}
+
+/*
+ * Puts |req| on the submission ring and waits for its response. Requests
+ * are run on the calling thread if the device is not running or the rings
+ * are full.
+ */
+static int dbatch_submit(DBATCH_REQ *req)
+{
+    ASYNC_JOB *job = ASYNC_get_current_job();
+    ASYNC_WAIT_CTX *waitctx;
+    OSSL_ASYNC_FD readfd = -1;
+
+    req->result = 0;
+    req->err = 0;
+    req->done = 0;
+    req->notify_fd = -1;
+    if (job != NULL && (waitctx = ASYNC_get_wait_ctx(job)) != NULL)
+        req->notify_fd = dbatch_wait_fd(waitctx, &readfd);
+
+    pthread_mutex_lock(&dbatch_dev.lock);
+    if (!dbatch_dev.running || dbatch_dev.in_flight == DBATCH_RING_SIZE) {
+        pthread_mutex_unlock(&dbatch_dev.lock);
+        dbatch_req_run(req);
+        goto end;
+    }
+    ring_put(&dbatch_dev.sq, req);
+    dbatch_dev.in_flight++;
+    pthread_cond_signal(&dbatch_dev.doorbell);
+
+    while (!req->done) {
+        if (!dbatch_poll_thread && dbatch_poll_locked() > 0 && req->done)
+            break;
+        if (req->notify_fd >= 0) {
+            pthread_mutex_unlock(&dbatch_dev.lock);
+            ASYNC_pause_job();
+            dbatch_wait_drain(readfd);
+            pthread_mutex_lock(&dbatch_dev.lock);
+        } else {
+            pthread_cond_wait(&dbatch_dev.response, &dbatch_dev.lock);
+        }
+    }
+    pthread_mutex_unlock(&dbatch_dev.lock);
+
+ end:
+    if (req->err != 0)
+        ERR_PUT_error(ERR_GET_LIB(req->err), ERR_GET_FUNC(req->err),
+                      ERR_GET_REASON(req->err), OPENSSL_FILE, OPENSSL_LINE);
+    return req->result;
+}
+
+#else /* DBATCH_DEVICE */
+
+static int dbatch_submit(DBATCH_REQ *req)
+{
+    req->err = 0;
+    dbatch_req_run(req);
+    if (req->err != 0)
+        ERR_PUT_error(ERR_GET_LIB(req->err), ERR_GET_FUNC(req->err),
+                      ERR_GET_REASON(req->err), OPENSSL_FILE, OPENSSL_LINE);
+    return req->result;
+}
+
+#endif /* DBATCH_DEVICE */
+
+/* RSA */
+
+static RSA_METHOD *dbatch_rsa_method = NULL;
+
+static int dbatch_rsa_run(DBATCH_REQ *req)
+{
+    return req->u.rsa.op(req->u.rsa.flen, req->u.rsa.from, req->u.rsa.to,
+                         req->u.rsa.rsa, req->u.rsa.padding);
+}
+
+static int dbatch_rsa_submit(int (*op) (int flen, const unsigned char *from,
+                                        unsigned char *to, RSA *rsa,
+                                        int padding),
+                             int flen, const unsigned char *from,
+                             unsigned char *to, RSA *rsa, int padding)
+{
+    DBATCH_REQ req;
+
+    memset(&req, 0, sizeof(req));
+    req.run = dbatch_rsa_run;
+    req.kind = RSA_PKCS1_OpenSSL();
+    req.u.rsa.op = op;
+    req.u.rsa.flen = flen;
+    req.u.rsa.from = from;
+    req.u.rsa.to = to;
+    req.u.rsa.rsa = rsa;
+    req.u.rsa.padding = padding;
+    return dbatch_submit(&req);
+}
+
+static int dbatch_rsa_priv_enc(int flen, const unsigned char *from,
+                               unsigned char *to, RSA *rsa, int padding)
+{
+    return dbatch_rsa_submit(RSA_meth_get_priv_enc(RSA_PKCS1_OpenSSL()),
+                             flen, from, to, rsa, padding);
+}
+
+static int dbatch_rsa_priv_dec(int flen, const unsigned char *from,
+                               unsigned char *to, RSA *rsa, int padding)
+{
+    return dbatch_rsa_submit(RSA_meth_get_priv_dec(RSA_PKCS1_OpenSSL()),
+                             flen, from, to, rsa, padding);
+}
+
+/* ECDH */
+
+static EC_KEY_METHOD *dbatch_ec_method = NULL;
+
+static int dbatch_ecdh_run(DBATCH_REQ *req)
+{
+    int (*ckey) (unsigned char **psec, size_t *pseclen,
+                 const EC_POINT *pub_key, const EC_KEY *ecdh) = NULL;
+
+    EC_KEY_METHOD_get_compute_key(EC_KEY_OpenSSL(), &ckey);
+    return ckey(req->u.ecdh.psec, req->u.ecdh.pseclen, req->u.ecdh.pub_key,
+                req->u.ecdh.ecdh);
+}
+
+static int dbatch_ecdh_compute_key(unsigned char **psec, size_t *pseclen,
+                                   const EC_POINT *pub_key,
+                                   const EC_KEY *ecdh)
+{
+    DBATCH_REQ req;
+
+    memset(&req, 0, sizeof(req));
+    req.run = dbatch_ecdh_run;
+    req.kind = EC_KEY_OpenSSL();
+    req.u.ecdh.psec = psec;
+    req.u.ecdh.pseclen = pseclen;
+    req.u.ecdh.pub_key = pub_key;
+    req.u.ecdh.ecdh = ecdh;
+    return dbatch_submit(&req);
+}
+
+/* AES-GCM */
+
+static EVP_CIPHER *_hidden_aes_128_gcm = NULL;
+static EVP_CIPHER *_hidden_aes_256_gcm = NULL;
+
+static int dbatch_cipher_nids[] = {
+    NID_aes_128_gcm,
+    NID_aes_256_gcm,
+    0
+};
+
+static int dbatch_cipher_run(DBATCH_REQ *req)
+{
+    return req->u.cipher.do_cipher(req->u.cipher.ctx, req->u.cipher.out,
+                                   req->u.cipher.in, req->u.cipher.inl);
+}
+
+/*
+ * Only the calls processing data are offloaded, the ones passing the AAD
+ * or computing the tag are too cheap to be worth a round trip.
+ */
+static int dbatch_gcm_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
+                             const unsigned char *in, size_t inl)
+{
+    const EVP_CIPHER *sw = EVP_CIPHER_CTX_nid(ctx) == NID_aes_128_gcm
+                           ? EVP_aes_128_gcm() : EVP_aes_256_gcm();
+    DBATCH_REQ req;
+
+    memset(&req, 0, sizeof(req));
+    req.u.cipher.do_cipher = EVP_CIPHER_meth_get_do_cipher(sw);
+    if (out == NULL || in == NULL)
+        return req.u.cipher.do_cipher(ctx, out, in, inl);
+    req.run = dbatch_cipher_run;
+    req.kind = sw;
+    req.u.cipher.ctx = ctx;
+    req.u.cipher.out = out;
+    req.u.cipher.in = in;
+    req.u.cipher.inl = inl;
+    return dbatch_submit(&req);
+}
+
+static EVP_CIPHER *dbatch_gcm_new(const EVP_CIPHER *sw)
+{
+    EVP_CIPHER *cipher = EVP_CIPHER_meth_dup(sw);
+
+    if (cipher == NULL
+            || !EVP_CIPHER_meth_set_do_cipher(cipher, dbatch_gcm_cipher)) {
+        EVP_CIPHER_meth_free(cipher);
+        return NULL;
+    }
+    return cipher;
+}
+
+static int dbatch_ciphers(ENGINE *e, const EVP_CIPHER **cipher,
+                          const int **nids, int nid)
+{
+    if (cipher == NULL) {
+        /* We are returning a list of supported nids */
+        *nids = dbatch_cipher_nids;
+        return OSSL_NELEM(dbatch_cipher_nids) - 1;
+    }
+    /* We are being asked for a specific cipher */
+    switch (nid) {
+    case NID_aes_128_gcm:
+        *cipher = _hidden_aes_128_gcm;
+        break;
+    case NID_aes_256_gcm:
+        *cipher = _hidden_aes_256_gcm;
+        break;
+    default:
+        *cipher = NULL;
+        break;
+    }
+    return *cipher != NULL;
+}
+
+/* KEM */
+
+static EVP_PKEY_METHOD **dbatch_pkey_meths = NULL;
+static int *dbatch_pkey_nids = NULL;
+static int dbatch_pkey_num = 0;
+
+/* The built-in method a context of one of our methods stands in for */
+static const EVP_PKEY_METHOD *dbatch_sw_pmeth(EVP_PKEY_CTX *ctx)
+{
+    return EVP_PKEY_meth_find(EVP_PKEY_id(EVP_PKEY_CTX_get0_pkey(ctx)));
+}
+
+static int dbatch_encapsulate_run(DBATCH_REQ *req)
+{
+    int (*encapsulate) (EVP_PKEY_CTX *ctx, unsigned char *ct, size_t *ctlen,
+                        unsigned char *secret, size_t *secretlen) = NULL;
+
+    EVP_PKEY_meth_get_encapsulate(req->u.kem.pmeth, NULL, &encapsulate);
+    return encapsulate(req->u.kem.ctx, req->u.kem.out, req->u.kem.outlen,
+                       req->u.kem.out2, req->u.kem.out2len);
+}
+
+/*
+ * Encapsulates to |num| keys of the same algorithm at once, which for the
+ * hybrid KEMs shares the cost of generating the ephemeral EC keys.
+ */
+static int dbatch_encapsulate_run_batch(DBATCH_REQ *reqs[], size_t num)
+{
+    const EVP_PKEY_METHOD *pmeth = reqs[0]->u.kem.pmeth;
+    int (*encapsulate_batch) (EVP_PKEY_CTX *ctx[], size_t num,
+                              unsigned char *ct, size_t *ctlen,
+                              unsigned char *secret, size_t *secretlen) = NULL;
+    int (*encapsulate) (EVP_PKEY_CTX *ctx, unsigned char *ct, size_t *ctlen,
+                        unsigned char *secret, size_t *secretlen) = NULL;
+    EVP_PKEY_CTX **ctx = NULL;
+    unsigned char *ct = NULL, *secret = NULL;
+    size_t i, clen = 0, slen = 0;
+    int ret = 0;
+
+    EVP_PKEY_meth_get_encapsulate(pmeth, NULL, &encapsulate);
+    EVP_PKEY_meth_get_encapsulate_batch(pmeth, &encapsulate_batch);
+    if (encapsulate_batch == NULL
+            || encapsulate(reqs[0]->u.kem.ctx, NULL, &clen, NULL, &slen) <= 0
+            || (ctx = OPENSSL_malloc(num * sizeof(*ctx))) == NULL
+            || (ct = OPENSSL_malloc(num * clen)) == NULL
+            || (secret = OPENSSL_secure_malloc(num * slen)) == NULL)
+        goto end;
+    for (i = 0; i < num; i++) {
+        ctx[i] = reqs[i]->u.kem.ctx;
+        if (*reqs[i]->u.kem.outlen < clen || *reqs[i]->u.kem.out2len < slen)
+            goto end;
+    }
+    if (encapsulate_batch(ctx, num, ct, &clen, secret, &slen) <= 0)
+        goto end;
+    for (i = 0; i < num; i++) {
+        memcpy(reqs[i]->u.kem.out, ct + i * clen, clen);
+        memcpy(reqs[i]->u.kem.out2, secret + i * slen, slen);
+        *reqs[i]->u.kem.outlen = clen;
+        *reqs[i]->u.kem.out2len = slen;
+        reqs[i]->result = 1;
+    }
+    ret = 1;
+
+ end:
+    /* The requests are run one at a time instead, with errors of their own */
+    ERR_clear_error();
+    OPENSSL_free(ctx);
+    OPENSSL_free(ct);
+    OPENSSL_secure_clear_free(secret, num * slen);
+    return ret;
+}
+
+static int dbatch_encapsulate(EVP_PKEY_CTX *ctx, unsigned char *ct,
+                              size_t *ctlen, unsigned char *secret,
+                              size_t *secretlen)
+{
+    DBATCH_REQ req;
+
+    memset(&req, 0, sizeof(req));
+    req.run = dbatch_encapsulate_run;
+    req.run_batch = dbatch_encapsulate_run_batch;
+    req.kind = req.u.kem.pmeth = dbatch_sw_pmeth(ctx);
+    req.u.kem.ctx = ctx;
+    req.u.kem.out = ct;
+    req.u.kem.outlen = ctlen;
+    req.u.kem.out2 = secret;
+    req.u.kem.out2len = secretlen;
+    if (ct == NULL || secret == NULL)
+        return dbatch_encapsulate_run(&req);
+    return dbatch_submit(&req);
+}
+
+static int dbatch_decapsulate_run(DBATCH_REQ *req)
+{
+    int (*decapsulate) (EVP_PKEY_CTX *ctx, unsigned char *secret,
+                        size_t *secretlen, const unsigned char *ct,
+                        size_t ctlen) = NULL;
+
+    EVP_PKEY_meth_get_decapsulate(req->u.kem.pmeth, NULL, &decapsulate);
+    return decapsulate(req->u.kem.ctx, req->u.kem.out, req->u.kem.outlen,
+                       req->u.kem.in, req->u.kem.inlen);
+}
+
+static int dbatch_decapsulate(EVP_PKEY_CTX *ctx, unsigned char *secret,
+                              size_t *secretlen, const unsigned char *ct,
+                              size_t ctlen)
+{
+    DBATCH_REQ req;
+
+    memset(&req, 0, sizeof(req));
+    req.run = dbatch_decapsulate_run;
+    req.kind = req.u.kem.pmeth = dbatch_sw_pmeth(ctx);
+    req.u.kem.ctx = ctx;
+    req.u.kem.out = secret;
+    req.u.kem.outlen = secretlen;
+    req.u.kem.in = ct;
+    req.u.kem.inlen = ctlen;
+    if (secret == NULL)
+        return dbatch_decapsulate_run(&req);
+    return dbatch_submit(&req);
+}
+
+/*
+ * The methods handed out are freed along with the ENGINE, they only need
+ * freeing here if binding failed.
+ */
+static void destroy_pkey_meths(int free_meths)
+{
+    int i;
+
+    for (i = 0; free_meths && i < dbatch_pkey_num; i++)
+        EVP_PKEY_meth_free(dbatch_pkey_meths[i]);
+    OPENSSL_free(dbatch_pkey_meths);
+    OPENSSL_free(dbatch_pkey_nids);
+    dbatch_pkey_meths = NULL;
+    dbatch_pkey_nids = NULL;
+    dbatch_pkey_num = 0;
+}
+
+/* Wraps the methods of the KEMs known to libcrypto */
+static int setup_pkey_meths(void)
+{
+    size_t i, count = EVP_PKEY_meth_get_count();
+    const EVP_PKEY_METHOD *sw;
+    EVP_PKEY_METHOD *pmeth;
+    int (*encapsulate_init) (EVP_PKEY_CTX *ctx);
+    int (*encapsulate) (EVP_PKEY_CTX *ctx, unsigned char *ct, size_t *ctlen,
+                        unsigned char *secret, size_t *secretlen);
+    int (*decapsulate_init) (EVP_PKEY_CTX *ctx);
+    int (*decapsulate) (EVP_PKEY_CTX *ctx, unsigned char *secret,
+                        size_t *secretlen, const unsigned char *ct,
+                        size_t ctlen);
+    int id, flags;
+
+    dbatch_pkey_meths = OPENSSL_zalloc(count * sizeof(*dbatch_pkey_meths));
+    dbatch_pkey_nids = OPENSSL_zalloc((count + 1) * sizeof(*dbatch_pkey_nids));
+    if (dbatch_pkey_meths == NULL || dbatch_pkey_nids == NULL)
+        return 0;
+    for (i = 0; i < count; i++) {
+        sw = EVP_PKEY_meth_get0(i);
+        EVP_PKEY_meth_get_encapsulate(sw, &encapsulate_init, &encapsulate);
+        EVP_PKEY_meth_get_decapsulate(sw, &decapsulate_init, &decapsulate);
+        if (encapsulate == NULL || decapsulate == NULL)
+            continue;
+        EVP_PKEY_meth_get0_info(&id, &flags, sw);
+        if ((pmeth = EVP_PKEY_meth_new(id, flags)) == NULL)
+            return 0;
+        EVP_PKEY_meth_copy(pmeth, sw);
+        EVP_PKEY_meth_set_encapsulate(pmeth, encapsulate_init,
+                                      dbatch_encapsulate);
+        EVP_PKEY_meth_set_decapsulate(pmeth, decapsulate_init,
+                                      dbatch_decapsulate);
+        dbatch_pkey_meths[dbatch_pkey_num] = pmeth;
+        dbatch_pkey_nids[dbatch_pkey_num++] = id;
+    }
+    return 1;
+}
+
+static int dbatch_pkey(ENGINE *e, EVP_PKEY_METHOD **pmeth,
+                       const int **nids, int nid)
+{
+    int i;
+
+    if (pmeth == NULL) {
+        /* We are returning a list of supported nids */
+        *nids = dbatch_pkey_nids;
+        return dbatch_pkey_num;
+    }
+    /* We are being asked for a specific method */
+    for (i = 0; i < dbatch_pkey_num; i++) {
+        if (dbatch_pkey_nids[i] == nid) {
+            *pmeth = dbatch_pkey_meths[i];
+            return 1;
+        }
+    }
+    *pmeth = NULL;
+    return 0;
+}
+
+static void destroy_methods(int free_pkey_meths)
+{
+    RSA_meth_free(dbatch_rsa_method);
+    dbatch_rsa_method = NULL;
+    EC_KEY_METHOD_free(dbatch_ec_method);
+    dbatch_ec_method = NULL;
+    EVP_CIPHER_meth_free(_hidden_aes_128_gcm);
+    EVP_CIPHER_meth_free(_hidden_aes_256_gcm);
+    _hidden_aes_128_gcm = NULL;
+    _hidden_aes_256_gcm = NULL;
+    destroy_pkey_meths(free_pkey_meths);
+}
+
+static int bind_dbatch(ENGINE *e)
+{
+    /* Ensure the dbatch error handling is set up */
+    ERR_load_DBATCH_strings();
+
+    if ((dbatch_rsa_method = RSA_meth_dup(RSA_PKCS1_OpenSSL())) == NULL
+        || !RSA_meth_set1_name(dbatch_rsa_method, "Dummy batching RSA method")
+        || !RSA_meth_set_priv_enc(dbatch_rsa_method, dbatch_rsa_priv_enc)
+        || !RSA_meth_set_priv_dec(dbatch_rsa_method, dbatch_rsa_priv_dec)
+        || (dbatch_ec_method = EC_KEY_METHOD_new(EC_KEY_OpenSSL())) == NULL
+        || (_hidden_aes_128_gcm = dbatch_gcm_new(EVP_aes_128_gcm())) == NULL
+        || (_hidden_aes_256_gcm = dbatch_gcm_new(EVP_aes_256_gcm())) == NULL
+        || !setup_pkey_meths()) {
+        destroy_methods(1);
+        DBATCHerr(DBATCH_F_BIND_DBATCH, DBATCH_R_INIT_FAILED);
+        return 0;
+    }
+    EC_KEY_METHOD_set_compute_key(dbatch_ec_method, dbatch_ecdh_compute_key);
+
+    /* From here on the methods are freed by dbatch_destroy() */
+    if (!ENGINE_set_destroy_function(e, dbatch_destroy)
+        || !ENGINE_set_id(e, engine_dbatch_id)
+        || !ENGINE_set_name(e, engine_dbatch_name)
+        || !ENGINE_set_RSA(e, dbatch_rsa_method)
+        || !ENGINE_set_EC(e, dbatch_ec_method)
+        || !ENGINE_set_ciphers(e, dbatch_ciphers)
+        || !ENGINE_set_pkey_meths(e, dbatch_pkey)
+        || !ENGINE_set_init_function(e, dbatch_init)
+        || !ENGINE_set_finish_function(e, dbatch_finish)
+        || !ENGINE_set_ctrl_function(e, dbatch_ctrl)
+        || !ENGINE_set_cmd_defns(e, dbatch_cmd_defns)) {
+        DBATCHerr(DBATCH_F_BIND_DBATCH, DBATCH_R_INIT_FAILED);
+        return 0;
+    }
+
+    return 1;
+}
+
+# ifndef OPENSSL_NO_DYNAMIC_ENGINE
+static int bind_helper(ENGINE *e, const char *id)
+{
+    if (id && (strcmp(id, engine_dbatch_id) != 0))
+        return 0;
+    if (!bind_dbatch(e))
+        return 0;
+    return 1;
+}
+
+IMPLEMENT_DYNAMIC_CHECK_FN()
+    IMPLEMENT_DYNAMIC_BIND_FN(bind_helper)
+# endif
+
+static int dbatch_init(ENGINE *e)
+{
+#ifdef DBATCH_DEVICE
+    if (!dbatch_device_start()) {
+        DBATCHerr(DBATCH_F_DBATCH_INIT, DBATCH_R_DEVICE_START_FAILED);
+        return 0;
+    }
+#endif
+    return 1;
+}
+
+static int dbatch_finish(ENGINE *e)
+{
+#ifdef DBATCH_DEVICE
+    dbatch_device_stop();
+#endif
+    return 1;
+}
+
+static int dbatch_destroy(ENGINE *e)
+{
+    destroy_methods(0);
+    ERR_unload_DBATCH_strings();
+    return 1;
+}
+
+static int dbatch_ctrl(ENGINE *e, int cmd, long i, void *p, void (*f) (void))
+{
+    unsigned long *stats = p;
+    int running = 0, ret = 0;
+
+#ifdef DBATCH_DEVICE
+    pthread_mutex_lock(&dbatch_dev.lock);
+    running = dbatch_dev.running;
+#endif
+    switch (cmd) {
+    case DBATCH_CMD_POLL_THREAD:
+        if (running) {
+            DBATCHerr(DBATCH_F_DBATCH_CTRL, DBATCH_R_ALREADY_STARTED);
+            break;
+        }
+        dbatch_poll_thread = i != 0;
+        ret = 1;
+        break;
+    case DBATCH_CMD_POLL:
+#ifdef DBATCH_DEVICE
+        if (running && !dbatch_poll_thread)
+            dbatch_poll_locked();
+#endif
+        ret = 1;
+        break;
+    case DBATCH_CMD_BATCH_SIZE:
+        if (i < 1 || i > DBATCH_RING_SIZE) {
+            DBATCHerr(DBATCH_F_DBATCH_CTRL, DBATCH_R_INVALID_BATCH_SIZE);
+            break;
+        }
+        dbatch_batch_size = (size_t)i;
+        ret = 1;
+        break;
+    case DBATCH_CMD_GET_NUM_BATCHES:
+        if (stats == NULL) {
+            DBATCHerr(DBATCH_F_DBATCH_CTRL, ERR_R_PASSED_NULL_PARAMETER);
+            break;
+        }
+#ifdef DBATCH_DEVICE
+        stats[0] = dbatch_dev.batches;
+        stats[1] = dbatch_dev.requests;
+#else
+        stats[0] = stats[1] = 0;
+#endif
+        ret = 1;
+        break;
+    default:
+        DBATCHerr(DBATCH_F_DBATCH_CTRL, DBATCH_R_UNKNOWN_COMMAND);
+        break;
+    }
+#ifdef DBATCH_DEVICE
+    pthread_mutex_unlock(&dbatch_dev.lock);
+#endif
+    return ret;
+}
@@ -0,0 +1,68 @@
+/*
+ * Generated by util/mkerr.pl DO NOT EDIT
+ * Copyright 1995-2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <openssl/err.h>
+#include "e_dbatch_err.h"
+
+#ifndef OPENSSL_NO_ERR
+
+static ERR_STRING_DATA DBATCH_str_functs[] = {
+    {ERR_PACK(0, DBATCH_F_BIND_DBATCH, 0), "bind_dbatch"},
+    {ERR_PACK(0, DBATCH_F_DBATCH_CTRL, 0), "dbatch_ctrl"},
+    {ERR_PACK(0, DBATCH_F_DBATCH_INIT, 0), "dbatch_init"},
+    {0, NULL}
+};
+
+static ERR_STRING_DATA DBATCH_str_reasons[] = {
+    {ERR_PACK(0, 0, DBATCH_R_ALREADY_STARTED), "already started"},
+    {ERR_PACK(0, 0, DBATCH_R_DEVICE_START_FAILED), "device start failed"},
+    {ERR_PACK(0, 0, DBATCH_R_INIT_FAILED), "init failed"},
+    {ERR_PACK(0, 0, DBATCH_R_INVALID_BATCH_SIZE), "invalid batch size"},
+    {ERR_PACK(0, 0, DBATCH_R_UNKNOWN_COMMAND), "unknown command"},
+    {0, NULL}
+};
+
+#endif
+
+static int lib_code = 0;
+static int error_loaded = 0;
+
+static int ERR_load_DBATCH_strings(void)
+{
+    if (lib_code == 0)
+        lib_code = ERR_get_next_error_library();
+
+    if (!error_loaded) {
+#ifndef OPENSSL_NO_ERR
+        ERR_load_strings(lib_code, DBATCH_str_functs);
+        ERR_load_strings(lib_code, DBATCH_str_reasons);
+#endif
+        error_loaded = 1;
+    }
+    return 1;
+}
+
+static void ERR_unload_DBATCH_strings(void)
+{
+    if (error_loaded) {
+#ifndef OPENSSL_NO_ERR
+        ERR_unload_strings(lib_code, DBATCH_str_functs);
+        ERR_unload_strings(lib_code, DBATCH_str_reasons);
+#endif
+        error_loaded = 0;
+    }
+}
+
+static void ERR_DBATCH_error(int function, int reason, char *file, int line)
+{
+    if (lib_code == 0)
+        lib_code = ERR_get_next_error_library();
+    ERR_PUT_error(lib_code, function, reason, file, line);
+}
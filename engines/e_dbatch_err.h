@@ -0,0 +1,33 @@
+/*
+ * Generated by util/mkerr.pl DO NOT EDIT
+ * Copyright 1995-2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#ifndef OSSL_ENGINES_E_DBATCH_ERR_H
+# define OSSL_ENGINES_E_DBATCH_ERR_H
+
+# define DBATCHerr(f, r) ERR_DBATCH_error((f), (r), OPENSSL_FILE, OPENSSL_LINE)
+
+
+/*
+ * DBATCH function codes.
+ */
+# define DBATCH_F_BIND_DBATCH                             100
+# define DBATCH_F_DBATCH_CTRL                             101
+# define DBATCH_F_DBATCH_INIT                             102
+
+/*
+ * DBATCH reason codes.
+ */
+# define DBATCH_R_ALREADY_STARTED                         100
+# define DBATCH_R_DEVICE_START_FAILED                     101
+# define DBATCH_R_INIT_FAILED                             102
+# define DBATCH_R_INVALID_BATCH_SIZE                      103
+# define DBATCH_R_UNKNOWN_COMMAND                         104
+
+#endif
@@ -12,13 +12,21 @@
  * Given a list of files, run each of them through the fuzzer.  Note that
  * failure will be indicated by some kind of crash. Switching on things like
  * asan improves the test.
+ *
+ * With -bench, each input is instead run repeatedly and timed, and the
+ * throughput and the slowest inputs are reported.  With -pem, each PEM block
+ * of the files is an input, so that collections of certificates can be
+ * replayed through the parsers that take DER.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <sys/stat.h>
 #include <openssl/crypto.h>
+#include <openssl/bio.h>
+#include <openssl/pem.h>
 #include "fuzzer.h"
 #include "internal/o_dir.h"
 
@@ -34,6 +42,154 @@
 #   define S_ISREG(m) ((m) & S_IFREG)
 # endif
 
+/* Inputs that take this many times the median time per byte are outliers */
+#define BENCH_OUTLIER   10
+
+typedef struct {
+    char *name;
+    size_t len;
+    double ns;                  /* per run */
+} BENCH_INPUT;
+
+static int bench = 0;
+static int bench_pem = 0;
+static double bench_min_ns = 5e6;
+static int bench_top = 10;
+static BENCH_INPUT *bench_inputs = NULL;
+static size_t bench_num = 0, bench_alloc = 0;
+
+static double now_ns(void)
+{
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+        return ts.tv_sec * 1e9 + ts.tv_nsec;
+#endif
+    return (double)clock() * (1e9 / CLOCKS_PER_SEC);
+}
+
+/* Runs |buf| through the fuzzer until at least |bench_min_ns| have passed */
+static void bench_input(const char *name, const unsigned char *buf, size_t len)
+{
+    BENCH_INPUT *in;
+    double start, elapsed;
+    long runs = 0;
+
+    if (bench_num == bench_alloc) {
+        size_t n = bench_alloc == 0 ? 256 : bench_alloc * 2;
+
+        in = realloc(bench_inputs, n * sizeof(*in));
+        if (in == NULL)
+            return;
+        bench_inputs = in;
+        bench_alloc = n;
+    }
+
+    /* Once untimed, to warm up the caches and whatever it loads lazily */
+    FuzzerTestOneInput(buf, len);
+    start = now_ns();
+    do {
+        FuzzerTestOneInput(buf, len);
+        runs++;
+    } while ((elapsed = now_ns() - start) < bench_min_ns);
+
+    in = &bench_inputs[bench_num];
+    if ((in->name = OPENSSL_strdup(name)) == NULL)
+        return;
+    bench_num++;
+    in->len = len;
+    in->ns = elapsed / runs;
+}
+
+/* Each PEM block of |buf| is an input */
+static void bench_pem_blocks(const char *pathname, const unsigned char *buf,
+                             size_t len)
+{
+    BIO *bio = BIO_new_mem_buf(buf, (int)len);
+    char *name = NULL, *header = NULL, blockname[PATH_MAX + 16];
+    unsigned char *data = NULL;
+    long datalen;
+    int n = 0;
+
+    if (bio == NULL)
+        return;
+    while (PEM_read_bio(bio, &name, &header, &data, &datalen)) {
+        BIO_snprintf(blockname, sizeof(blockname), "%s#%d", pathname, n++);
+        bench_input(blockname, data, datalen);
+        OPENSSL_free(name);
+        OPENSSL_free(header);
+        OPENSSL_free(data);
+    }
+    BIO_free(bio);
+}
+
+static int ns_per_byte_cmp(const void *a, const void *b)
+{
+    const BENCH_INPUT *x = a, *y = b;
+    double nx = x->ns / (x->len == 0 ? 1 : x->len);
+    double ny = y->ns / (y->len == 0 ? 1 : y->len);
+
+    return nx < ny ? -1 : nx > ny;
+}
+
+static int ns_cmp(const void *a, const void *b)
+{
+    const BENCH_INPUT *x = a, *y = b;
+
+    return x->ns > y->ns ? -1 : x->ns < y->ns;
+}
+
+static void bench_report(void)
+{
+    double total_ns = 0, median;
+    size_t i, total_len = 0;
+    BENCH_INPUT *in;
+
+    if (bench_num == 0) {
+        printf("no inputs\n");
+        return;
+    }
+    for (i = 0; i < bench_num; i++) {
+        total_ns += bench_inputs[i].ns;
+        total_len += bench_inputs[i].len;
+    }
+    qsort(bench_inputs, bench_num, sizeof(*bench_inputs), ns_per_byte_cmp);
+    in = &bench_inputs[bench_num / 2];
+    median = in->ns / (in->len == 0 ? 1 : in->len);
+
+    printf("inputs %lu, bytes %lu, %.3f ms per pass\n",
+           (unsigned long)bench_num, (unsigned long)total_len, total_ns / 1e6);
+    printf("throughput %.2f MB/s, %.0f inputs/s\n",
+           total_len / total_ns * 1e3, bench_num / total_ns * 1e9);
+    printf("median %.2f ns/byte\n", median);
+
+    qsort(bench_inputs, bench_num, sizeof(*bench_inputs), ns_cmp);
+    printf("slowest inputs:\n");
+    for (i = 0; i < bench_num; i++) {
+        double nb;
+
+        in = &bench_inputs[i];
+        nb = in->ns / (in->len == 0 ? 1 : in->len);
+        if ((int)i >= bench_top && nb < median * BENCH_OUTLIER)
+            continue;
+        printf("%c %12.0f ns %8lu bytes %10.2f ns/byte %8.1fx  %s\n",
+               nb >= median * BENCH_OUTLIER ? '!' : ' ', in->ns,
+               (unsigned long)in->len, nb, nb / median, in->name);
+    }
+    printf("(! marks inputs over %dx the median time per byte)\n",
+           BENCH_OUTLIER);
+}
+
+static void bench_free(void)
+{
+    size_t i;
+
+    for (i = 0; i < bench_num; i++)
+        OPENSSL_free(bench_inputs[i].name);
+    free(bench_inputs);
+}
+
 static void testfile(const char *pathname)
 {
     struct stat st;
@@ -43,8 +199,10 @@ static void testfile(const char *pathname)
 
     if (stat(pathname, &st) < 0 || !S_ISREG(st.st_mode))
         return;
-    printf("# %s\n", pathname);
-    fflush(stdout);
+    if (!bench) {
+        printf("# %s\n", pathname);
+        fflush(stdout);
+    }
     f = fopen(pathname, "rb");
     if (f == NULL)
         return;
@@ -52,15 +210,47 @@ static void testfile(const char *pathname)
     if (buf != NULL) {
         s = fread(buf, 1, st.st_size, f);
         OPENSSL_assert(s == (size_t)st.st_size);
-        FuzzerTestOneInput(buf, s);
+        if (!bench)
+            FuzzerTestOneInput(buf, s);
+        else if (bench_pem)
+            bench_pem_blocks(pathname, buf, s);
+        else
+            bench_input(pathname, buf, s);
         free(buf);
     }
     fclose(f);
 }
 
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-bench [-pem] [-time ms] [-top n]] file...\n",
+            prog);
+    exit(1);
+}
+
 int main(int argc, char **argv) {
     int n;
 
+    for (n = 1; n < argc && argv[n][0] == '-'; n++) {
+        if (strcmp(argv[n], "-bench") == 0)
+            bench = 1;
+        else if (strcmp(argv[n], "-pem") == 0)
+            bench_pem = 1;
+        else if (strcmp(argv[n], "-time") == 0 && n + 1 < argc)
+            bench_min_ns = atof(argv[++n]) * 1e6;
+        else if (strcmp(argv[n], "-top") == 0 && n + 1 < argc)
+            bench_top = atoi(argv[++n]);
+        else
+            usage(argv[0]);
+    }
+    if (n > 1) {
+        if (!bench)
+            usage(argv[0]);
+        argv[n - 1] = argv[0];
+        argv += n - 1;
+        argc -= n - 1;
+    }
+
     FuzzerInitialize(&argc, &argv);
 
     for (n = 1; n < argc; ++n) {
@@ -98,6 +288,11 @@ int main(int argc, char **argv) {
         free(pathname);
     }
 
+    if (bench) {
+        bench_report();
+        bench_free();
+    }
+
     FuzzerCleanup();
 
     return 0;
@@ -9,6 +9,7 @@
 
 /* Internal ASN1 structures and functions: not for application use */
 
+#include <openssl/asn1.h>
 #include <oqs/oqs.h>
 
 /* ASN1 public key method structure */
@@ -85,7 +86,41 @@ extern const EVP_PKEY_ASN1_METHOD hmac_asn1_meth;
 extern const EVP_PKEY_ASN1_METHOD rsa_asn1_meths[2];
 extern const EVP_PKEY_ASN1_METHOD rsa_pss_asn1_meth;
 extern const EVP_PKEY_ASN1_METHOD siphash_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD blake2b_mac_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD blake2s_mac_asn1_meth;
 
+///// OQS_TEMPLATE_FRAGMENT_DEFINE_KEM_ASN1_METHS_START
+extern const EVP_PKEY_ASN1_METHOD frodo640aes_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD frodo640shake_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD frodo976aes_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD frodo976shake_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD frodo1344aes_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD frodo1344shake_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD kyber512_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD kyber768_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD kyber1024_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD bikel1_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD bikel3_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD bikel5_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD hqc128_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD hqc192_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD hqc256_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD p256_frodo640aes_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD p256_frodo640shake_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD p384_frodo976aes_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD p384_frodo976shake_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD p521_frodo1344aes_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD p521_frodo1344shake_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD p256_kyber512_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD p384_kyber768_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD p521_kyber1024_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD p256_bikel1_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD p384_bikel3_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD p521_bikel5_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD p256_hqc128_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD p384_hqc192_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD p521_hqc256_asn1_meth;
+///// OQS_TEMPLATE_FRAGMENT_DEFINE_KEM_ASN1_METHS_END
 ///// OQS_TEMPLATE_FRAGMENT_DEFINE_ASN1_METHS_START
 extern const EVP_PKEY_ASN1_METHOD dilithium2_asn1_meth;
 extern const EVP_PKEY_ASN1_METHOD p256_dilithium2_asn1_meth;
@@ -138,3 +173,8 @@ struct asn1_pctx_st {
 } /* ASN1_PCTX */ ;
 
 int asn1_d2i_read_bio(BIO *in, BUF_MEM **pb);
+ASN1_VALUE *asn1_item_d2i_borrow(ASN1_VALUE **pval,
+                                 const unsigned char **in, long len,
+                                 const ASN1_ITEM *it);
+int asn1_shared_buf_contains(const ASN1_SHARED_BUF *buf,
+                             const unsigned char *p, size_t len);
@@ -86,10 +86,41 @@ int bn_lshift_fixed_top(BIGNUM *r, const BIGNUM *a, int n);
 int bn_rshift_fixed_top(BIGNUM *r, const BIGNUM *a, int n);
 int bn_div_fixed_top(BIGNUM *dv, BIGNUM *rem, const BIGNUM *m,
                      const BIGNUM *d, BN_CTX *ctx);
+/*
+ * A per-thread BN_CTX for a single operation, returned with
+ * bn_ctx_release() instead of BN_CTX_free().
+ */
+BN_CTX *bn_ctx_acquire(int secure);
+void bn_ctx_release(BN_CTX *ctx);
+void bn_ctx_delete_thread_state(void);
+void bn_ctx_cleanup_int(void);
+
+int bn_mod_exp_mont_consttime_x2(BIGNUM *rr1, const BIGNUM *a1,
+                                 const BIGNUM *p1, const BIGNUM *m1,
+                                 BN_MONT_CTX *in_mont1,
+                                 BIGNUM *rr2, const BIGNUM *a2,
+                                 const BIGNUM *p2, const BIGNUM *m2,
+                                 BN_MONT_CTX *in_mont2, BN_CTX *ctx);
+/*
+ * Precomputed powers of a base that is used for many variable-time
+ * exponentiations modulo the same modulus.
+ */
+typedef struct bn_fixed_base_st BN_FIXED_BASE;
+
+BN_FIXED_BASE *bn_fixed_base_new(const BIGNUM *base, int exp_bits,
+                                 BN_MONT_CTX *mont, BN_CTX *ctx);
+void bn_fixed_base_free(BN_FIXED_BASE *fb);
+int bn_mod_exp2_fixed_base(BIGNUM *rr, const BN_FIXED_BASE *fb1,
+                           const BIGNUM *p1, const BN_FIXED_BASE *fb2,
+                           const BIGNUM *p2, BN_MONT_CTX *mont, BN_CTX *ctx);
+int bn_mod_inverse_consttime(BIGNUM *r, const BIGNUM *a, const BIGNUM *n,
+                             BN_CTX *ctx, int *pnoinv);
 int ossl_bn_rsa_do_unblind(const BIGNUM *intermediate,
                            const BN_BLINDING *blinding,
                            const BIGNUM *possible_arg2,
                            const BIGNUM *to_mod, BN_CTX *ctx,
                            unsigned char *buf, int num);
+int bn_generate_prime_pool(BIGNUM *ret, int bits, OSSL_WORKER_POOL *pool,
+                           BN_GENCB *cb);
 
 #endif
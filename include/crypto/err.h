@@ -11,6 +11,7 @@
 # define OSSL_CRYPTO_ERR_H
 
 int err_load_crypto_strings_int(void);
+void err_strings_loading(int on);
 void err_cleanup(void);
 void err_delete_thread_state(void);
 int err_shelve_state(void **);
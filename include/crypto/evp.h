@@ -37,8 +37,34 @@ struct evp_pkey_ctx_st {
     /* implementation specific keygen data */
     int *keygen_info;
     int keygen_info_count;
+    /* Threads that operations may be handed to, not owned */
+    OSSL_WORKER_POOL *worker_pool;
+    /* Where operations wait to be run with others of their kind, not owned */
+    OSSL_BATCH_QUEUE *batch_queue;
 } /* EVP_PKEY_CTX */ ;
 
+/*
+ * One public key operation, packed up so that it can be run on the worker
+ * pool of its EVP_PKEY_CTX. |op| is an EVP_PKEY_OP_* value, with SIGNCTX and
+ * VERIFYCTX standing for the one-shot digestsign and digestverify calls on
+ * |mctx|.
+ */
+typedef struct evp_pkey_offload_st {
+    int op;
+    EVP_PKEY_CTX *ctx;
+    EVP_MD_CTX *mctx;
+    unsigned char *out;
+    size_t *outlen;
+    unsigned char *out2;
+    size_t *out2len;
+    const unsigned char *in;
+    size_t inlen;
+    const unsigned char *in2;
+    size_t in2len;
+} EVP_PKEY_OFFLOAD;
+
+int evp_pkey_offload(EVP_PKEY_OFFLOAD *off);
+
 #define EVP_PKEY_FLAG_DYNAMIC   1
 
 struct evp_pkey_method_st {
@@ -88,6 +114,17 @@ struct evp_pkey_method_st {
     int (*param_check) (EVP_PKEY *pkey);
 
     int (*digest_custom) (EVP_PKEY_CTX *ctx, EVP_MD_CTX *mctx);
+
+    int (*encapsulate_init) (EVP_PKEY_CTX *ctx);
+    int (*encapsulate) (EVP_PKEY_CTX *ctx, unsigned char *ct, size_t *ctlen,
+                        unsigned char *secret, size_t *secretlen);
+    int (*encapsulate_batch) (EVP_PKEY_CTX *ctx[], size_t num,
+                              unsigned char *ct, size_t *ctlen,
+                              unsigned char *secret, size_t *secretlen);
+    int (*decapsulate_init) (EVP_PKEY_CTX *ctx);
+    int (*decapsulate) (EVP_PKEY_CTX *ctx, unsigned char *secret,
+                        size_t *secretlen, const unsigned char *ct,
+                        size_t ctlen);
 } /* EVP_PKEY_METHOD */ ;
 
 DEFINE_STACK_OF_CONST(EVP_PKEY_METHOD)
@@ -112,6 +149,40 @@ extern const EVP_PKEY_METHOD tls1_prf_pkey_meth;
 extern const EVP_PKEY_METHOD hkdf_pkey_meth;
 extern const EVP_PKEY_METHOD poly1305_pkey_meth;
 extern const EVP_PKEY_METHOD siphash_pkey_meth;
+extern const EVP_PKEY_METHOD blake2b_mac_pkey_meth;
+extern const EVP_PKEY_METHOD blake2s_mac_pkey_meth;
+///// OQS_TEMPLATE_FRAGMENT_DEFINE_KEM_EVP_METHS_START
+extern const EVP_PKEY_METHOD frodo640aes_pkey_meth;
+extern const EVP_PKEY_METHOD frodo640shake_pkey_meth;
+extern const EVP_PKEY_METHOD frodo976aes_pkey_meth;
+extern const EVP_PKEY_METHOD frodo976shake_pkey_meth;
+extern const EVP_PKEY_METHOD frodo1344aes_pkey_meth;
+extern const EVP_PKEY_METHOD frodo1344shake_pkey_meth;
+extern const EVP_PKEY_METHOD kyber512_pkey_meth;
+extern const EVP_PKEY_METHOD kyber768_pkey_meth;
+extern const EVP_PKEY_METHOD kyber1024_pkey_meth;
+extern const EVP_PKEY_METHOD bikel1_pkey_meth;
+extern const EVP_PKEY_METHOD bikel3_pkey_meth;
+extern const EVP_PKEY_METHOD bikel5_pkey_meth;
+extern const EVP_PKEY_METHOD hqc128_pkey_meth;
+extern const EVP_PKEY_METHOD hqc192_pkey_meth;
+extern const EVP_PKEY_METHOD hqc256_pkey_meth;
+extern const EVP_PKEY_METHOD p256_frodo640aes_pkey_meth;
+extern const EVP_PKEY_METHOD p256_frodo640shake_pkey_meth;
+extern const EVP_PKEY_METHOD p384_frodo976aes_pkey_meth;
+extern const EVP_PKEY_METHOD p384_frodo976shake_pkey_meth;
+extern const EVP_PKEY_METHOD p521_frodo1344aes_pkey_meth;
+extern const EVP_PKEY_METHOD p521_frodo1344shake_pkey_meth;
+extern const EVP_PKEY_METHOD p256_kyber512_pkey_meth;
+extern const EVP_PKEY_METHOD p384_kyber768_pkey_meth;
+extern const EVP_PKEY_METHOD p521_kyber1024_pkey_meth;
+extern const EVP_PKEY_METHOD p256_bikel1_pkey_meth;
+extern const EVP_PKEY_METHOD p384_bikel3_pkey_meth;
+extern const EVP_PKEY_METHOD p521_bikel5_pkey_meth;
+extern const EVP_PKEY_METHOD p256_hqc128_pkey_meth;
+extern const EVP_PKEY_METHOD p384_hqc192_pkey_meth;
+extern const EVP_PKEY_METHOD p521_hqc256_pkey_meth;
+///// OQS_TEMPLATE_FRAGMENT_DEFINE_KEM_EVP_METHS_END
 ///// OQS_TEMPLATE_FRAGMENT_DEFINE_EVP_METHS_START
 extern const EVP_PKEY_METHOD dilithium2_pkey_meth;
 extern const EVP_PKEY_METHOD p256_dilithium2_pkey_meth;
@@ -151,6 +222,15 @@ struct evp_md_st {
     int ctx_size;               /* how big does the ctx->md_data need to be */
     /* control function */
     int (*md_ctrl) (EVP_MD_CTX *ctx, int cmd, int p1, void *p2);
+    /* optional: hash |num| separate messages at once, see EVP_DigestBatch */
+    int (*batch) (const void *const data[], const size_t count[],
+                  unsigned char *const md[], size_t num);
+    /* optional: PBKDF2 with HMAC of this digest, see PKCS5_PBKDF2_HMAC */
+    int (*pbkdf2_hmac) (const unsigned char *pass, size_t passlen,
+                        const unsigned char *salt, size_t saltlen,
+                        size_t iter, unsigned char *out, size_t keylen);
+    /* optional: replace the digest at |md| with its digest, |iter| times */
+    void (*iterate) (unsigned char *md, size_t iter);
 } /* EVP_MD */ ;
 
 struct evp_cipher_st {
@@ -450,6 +530,9 @@ void openssl_add_all_ciphers_int(void);
 void openssl_add_all_digests_int(void);
 void evp_cleanup_int(void);
 void evp_app_cleanup_int(void);
+void oqs_alg_table_cleanup_int(void);
+void oqs_rand_init_int(void);
+void oqs_rand_cleanup_int(void);
 
 /* Pulling defines out of C source files */
 
@@ -459,6 +542,12 @@ void evp_app_cleanup_int(void);
 #endif
 
 void evp_encode_ctx_set_flags(EVP_ENCODE_CTX *ctx, unsigned int flags);
+int evp_md_ctx_iterate(EVP_MD_CTX *ctx, unsigned char *md, size_t iter);
+
+typedef void (*evp_parallel_fn) (void *arg, size_t off, size_t len);
+
+void evp_parallel_run(int pieces, size_t count, evp_parallel_fn fn,
+                      void *arg);
 
 /* EVP_ENCODE_CTX flags */
 /* Don't generate new lines when encoding */
@@ -16,4 +16,60 @@
 int sha512_224_init(SHA512_CTX *);
 int sha512_256_init(SHA512_CTX *);
 
+/* PBKDF2 with HMAC and the PKCS#12 KDF iterations, for EVP_MD */
+int sha1_pbkdf2_hmac(const unsigned char *pass, size_t passlen,
+                     const unsigned char *salt, size_t saltlen,
+                     size_t iter, unsigned char *out, size_t keylen);
+int sha224_pbkdf2_hmac(const unsigned char *pass, size_t passlen,
+                       const unsigned char *salt, size_t saltlen,
+                       size_t iter, unsigned char *out, size_t keylen);
+int sha256_pbkdf2_hmac(const unsigned char *pass, size_t passlen,
+                       const unsigned char *salt, size_t saltlen,
+                       size_t iter, unsigned char *out, size_t keylen);
+int sha384_pbkdf2_hmac(const unsigned char *pass, size_t passlen,
+                       const unsigned char *salt, size_t saltlen,
+                       size_t iter, unsigned char *out, size_t keylen);
+int sha512_pbkdf2_hmac(const unsigned char *pass, size_t passlen,
+                       const unsigned char *salt, size_t saltlen,
+                       size_t iter, unsigned char *out, size_t keylen);
+void sha1_iterate(unsigned char *md, size_t iter);
+void sha224_iterate(unsigned char *md, size_t iter);
+void sha256_iterate(unsigned char *md, size_t iter);
+void sha384_iterate(unsigned char *md, size_t iter);
+void sha512_iterate(unsigned char *md, size_t iter);
+
+/*
+ * The multi-buffer SHA-1/SHA-256 kernels are built along with the other
+ * x86_64 SHA assembler modules.
+ */
+# if defined(SHA1_ASM) && !defined(OPENSSL_NO_MULTIBLOCK) && ( \
+     defined(__x86_64) || defined(__x86_64__) || \
+     defined(_M_AMD64) || defined(_M_X64))
+#  define SHA_MULTI_BLOCK
+int sha1_digest_batch(const void *const data[], const size_t count[],
+                      unsigned char *const md[], size_t num);
+int sha224_digest_batch(const void *const data[], const size_t count[],
+                        unsigned char *const md[], size_t num);
+int sha256_digest_batch(const void *const data[], const size_t count[],
+                        unsigned char *const md[], size_t num);
+
+/*
+ * Run |iter| PBKDF2 iterations for up to SHA_MB_LANES blocks at once. |u|
+ * holds the padded block of each one's last U value, |t| its output.
+ */
+#  define SHA_MB_LANES  8
+void sha1_pbkdf2_lanes(const unsigned int istate[],
+                       const unsigned int ostate[],
+                       unsigned char *const u[], unsigned char *const t[],
+                       unsigned int num, size_t iter);
+void sha224_pbkdf2_lanes(const unsigned int istate[],
+                         const unsigned int ostate[],
+                         unsigned char *const u[], unsigned char *const t[],
+                         unsigned int num, size_t iter);
+void sha256_pbkdf2_lanes(const unsigned int istate[],
+                         const unsigned int ostate[],
+                         unsigned char *const u[], unsigned char *const t[],
+                         unsigned int num, size_t iter);
+# endif
+
 #endif
@@ -23,3 +23,7 @@ int SipHash_Init(SIPHASH *ctx, const unsigned char *k,
                  int crounds, int drounds);
 void SipHash_Update(SIPHASH *ctx, const unsigned char *in, size_t inlen);
 int SipHash_Final(SIPHASH *ctx, unsigned char *out, size_t outlen);
+
+/* One-shot SipHash-1-3 with an 8-byte output, for keyed hash tables */
+uint64_t SipHash_hash13(const unsigned char *k, const unsigned char *in,
+                        size_t inlen);
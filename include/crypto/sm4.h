@@ -34,4 +34,13 @@ void SM4_encrypt(const uint8_t *in, uint8_t *out, const SM4_KEY *ks);
 
 void SM4_decrypt(const uint8_t *in, uint8_t *out, const SM4_KEY *ks);
 
+/*
+ * Multi-block modes, which work on four blocks at a time.  The counter is
+ * the last 32 bits of |ivec|, as for ctr128_f.
+ */
+void SM4_ctr32_encrypt_blocks(const uint8_t *in, uint8_t *out, size_t blocks,
+                              const SM4_KEY *ks, const uint8_t ivec[16]);
+void SM4_cbc_decrypt_blocks(const uint8_t *in, uint8_t *out, size_t blocks,
+                            const SM4_KEY *ks, uint8_t ivec[16]);
+
 #endif
@@ -37,6 +37,8 @@ struct X509_name_st {
     /* canonical encoding used for rapid Name comparison */
     unsigned char *canon_enc;
     int canon_enclen;
+    /* fingerprint of canon_enc, see x509_name_equal() */
+    uint64_t canon_hash;
 } /* X509_NAME */ ;
 
 /* Signature info structure */
@@ -111,6 +113,9 @@ struct X509_crl_st {
     const X509_CRL_METHOD *meth;
     void *meth_data;
     CRYPTO_RWLOCK *lock;
+    /* revoked entries hashed by serial number, NULL if not indexed */
+    X509_REVOKED **serial_index;
+    size_t serial_index_mask;
 };
 
 struct x509_revoked_st {
@@ -185,6 +190,8 @@ struct x509_st {
     X509_CERT_AUX *aux;
     CRYPTO_RWLOCK *lock;
     volatile int ex_cached;
+    /* Encoding that d2i_X509_shared() decoded from */
+    ASN1_SHARED_BUF *shared;
 } /* X509 */ ;
 
 /*
@@ -255,6 +262,11 @@ struct x509_store_ctx_st {      /* X509_STORE_CTX */
     SSL_DANE *dane;
     /* signed via bare TA public key, rather than CA certificate */
     int bare_ta_signed;
+    /* runs the signature checks of the chain, possibly concurrently */
+    X509_STORE_CTX_sig_dispatch_fn sig_dispatch;
+    void *sig_dispatch_arg;
+    /* signatures already found good, see X509_verify_cert_batch() */
+    struct x509_sig_memo_st *sig_memo;
 };
 
 /* PKCS#8 private key info structure */
@@ -286,6 +298,10 @@ int a2i_ipadd(unsigned char *ipout, const char *ipasc);
 int x509_set1_time(ASN1_TIME **ptm, const ASN1_TIME *tm);
 
 void x509_init_sig_info(X509 *x);
+int x509_pubkey_set1_shared(X509_PUBKEY *key, ASN1_SHARED_BUF *buf);
+ASN1_SHARED_BUF *x509_pubkey_get0_shared(const X509_PUBKEY *key);
+int x509_name_equal(const X509_NAME *a, const X509_NAME *b);
+void x509_intern_cleanup_int(void);
 
 int x509v3_add_len_value_uchar(const char *name, const unsigned char *value,
                                size_t vallen, STACK_OF(CONF_VALUE) **extlist);
@@ -24,6 +24,12 @@ struct bio_method_st {
     long (*callback_ctrl) (BIO *, int, BIO_info_cb *);
 };
 
+/*
+ * Set on a socket BIO whose large writes use MSG_ZEROCOPY: the data written
+ * must stay untouched until BIO_get_zerocopy_done() reports the send done.
+ */
+# define BIO_FLAGS_ZEROCOPY      0x2000
+
 void bio_free_ex_data(BIO *bio);
 void bio_cleanup(void);
 
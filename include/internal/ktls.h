@@ -0,0 +1,136 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#ifndef OSSL_INTERNAL_KTLS_H
+# define OSSL_INTERNAL_KTLS_H
+
+# include <openssl/opensslconf.h>
+
+# ifndef OPENSSL_NO_KTLS
+
+/*
+ * Kernel TLS offload of the record layer send direction (Linux only, see
+ * Configure). Once the kernel holds the write keys the socket BIO passes
+ * plaintext to the kernel, which frames and encrypts each record itself.
+ */
+
+#  include <string.h>
+#  include <sys/types.h>
+#  include <sys/socket.h>
+#  include <sys/sendfile.h>
+#  include <netinet/in.h>
+#  include <netinet/tcp.h>
+#  include <linux/tls.h>
+#  include <openssl/bio.h>
+
+#  ifndef TCP_ULP
+#   define TCP_ULP 31
+#  endif
+#  ifndef SOL_TLS
+#   define SOL_TLS 282
+#  endif
+
+/* BIO flags private to the socket BIO */
+#  define BIO_FLAGS_KTLS_TX_CTRL_MSG 0x1000
+#  define BIO_FLAGS_KTLS_TX          0x4000
+
+#  define BIO_set_ktls_flag(b) \
+    BIO_set_flags(b, BIO_FLAGS_KTLS_TX)
+#  define BIO_should_ktls_flag(b) \
+    BIO_test_flags(b, BIO_FLAGS_KTLS_TX)
+#  define BIO_set_ktls_ctrl_msg_flag(b) \
+    BIO_set_flags(b, BIO_FLAGS_KTLS_TX_CTRL_MSG)
+#  define BIO_should_ktls_ctrl_msg_flag(b) \
+    BIO_test_flags(b, BIO_FLAGS_KTLS_TX_CTRL_MSG)
+#  define BIO_clear_ktls_ctrl_msg_flag(b) \
+    BIO_clear_flags(b, BIO_FLAGS_KTLS_TX_CTRL_MSG)
+
+#  define BIO_set_ktls(b, keyblob) \
+    BIO_ctrl(b, BIO_CTRL_SET_KTLS, 1, keyblob)
+#  define BIO_set_ktls_ctrl_msg(b, record_type) \
+    BIO_ctrl(b, BIO_CTRL_SET_KTLS_TX_SEND_CTRL_MSG, record_type, NULL)
+#  define BIO_clear_ktls_ctrl_msg(b) \
+    BIO_ctrl(b, BIO_CTRL_CLEAR_KTLS_TX_CTRL_MSG, 0, NULL)
+
+typedef struct ktls_crypto_info_st {
+    union {
+        struct tls_crypto_info info;
+        struct tls12_crypto_info_aes_gcm_128 gcm128;
+#  ifdef TLS_CIPHER_AES_GCM_256
+        struct tls12_crypto_info_aes_gcm_256 gcm256;
+#  endif
+#  ifdef TLS_CIPHER_CHACHA20_POLY1305
+        struct tls12_crypto_info_chacha20_poly1305 chacha20poly1305;
+#  endif
+    } u;
+    size_t len;
+} ktls_crypto_info_t;
+
+/*
+ * Attach the "tls" upper layer protocol to the TCP socket |fd|. This has to
+ * happen once before any keys can be installed. Returns 1 on success.
+ */
+static ossl_inline int ktls_enable(int fd)
+{
+    return setsockopt(fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) == 0;
+}
+
+/*
+ * Install the send keys in |crypto_info| on |fd|. Calling this again on a
+ * socket already using kTLS re-keys the send direction, which only TLS 1.3
+ * capable kernels accept. Returns 1 on success.
+ */
+static ossl_inline int ktls_start(int fd, const ktls_crypto_info_t *crypto_info)
+{
+    return setsockopt(fd, SOL_TLS, TLS_TX, &crypto_info->u,
+                      crypto_info->len) == 0;
+}
+
+/*
+ * Send |length| bytes from |data| as a single record of type |record_type|.
+ * Anything written to the socket without this goes out as application data.
+ */
+static ossl_inline int ktls_send_ctrl_message(int fd, unsigned char record_type,
+                                              const void *data, size_t length)
+{
+    struct msghdr msg;
+    struct cmsghdr *cmsg;
+    union {
+        struct cmsghdr hdr;
+        char buf[CMSG_SPACE(sizeof(unsigned char))];
+    } cmsgbuf;
+    struct iovec msg_iov;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_control = cmsgbuf.buf;
+    msg.msg_controllen = sizeof(cmsgbuf.buf);
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_TLS;
+    cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(record_type));
+    *((unsigned char *)CMSG_DATA(cmsg)) = record_type;
+    msg.msg_controllen = cmsg->cmsg_len;
+
+    msg_iov.iov_base = (void *)data;
+    msg_iov.iov_len = length;
+    msg.msg_iov = &msg_iov;
+    msg.msg_iovlen = 1;
+
+    return (int)sendmsg(fd, &msg, 0);
+}
+
+/* Send |size| bytes of the file |fd| from |off| on the kTLS socket |s| */
+static ossl_inline ossl_ssize_t ktls_sendfile(int s, int fd, off_t off,
+                                              size_t size, int flags)
+{
+    return sendfile(s, fd, &off, size);
+}
+
+# endif                         /* OPENSSL_NO_KTLS */
+#endif
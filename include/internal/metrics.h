@@ -0,0 +1,126 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#ifndef OSSL_INTERNAL_METRICS_H
+# define OSSL_INTERNAL_METRICS_H
+
+# include <openssl/crypto.h>
+# include <oqs/oqs.h>
+
+# ifndef OPENSSL_NO_METRICS
+#  include <time.h>
+
+/*
+ * The metrics libcrypto registers when the registry is set up, in this
+ * order, so that libcrypto and libssl can count into them without looking
+ * them up. A timed operation takes two ids: the number of operations, then
+ * the nanoseconds they took all together.
+ */
+typedef enum {
+    OSSL_METRIC_SSL_SESS_HITS = 1,
+    OSSL_METRIC_SSL_SESS_MISSES,
+    OSSL_METRIC_SSL_SESS_EVICTIONS,
+    OSSL_METRIC_X509_STORE_HITS,
+    OSSL_METRIC_X509_STORE_MISSES,
+    OSSL_METRIC_RAND_DRBG_RESEEDS,
+    OSSL_METRIC_ASYNC_POOL_HITS,
+    OSSL_METRIC_ASYNC_POOL_MISSES,
+    OSSL_METRIC_ASYNC_POOL_EXHAUSTED,
+    OSSL_METRIC_ASYNC_JOBS,
+    OSSL_METRIC_OQS_SIG_SIGN,
+    OSSL_METRIC_OQS_SIG_SIGN_NS,
+    OSSL_METRIC_OQS_SIG_VERIFY,
+    OSSL_METRIC_OQS_SIG_VERIFY_NS,
+    OSSL_METRIC_OQS_KEM_KEYPAIR,
+    OSSL_METRIC_OQS_KEM_KEYPAIR_NS,
+    OSSL_METRIC_OQS_KEM_ENCAPS,
+    OSSL_METRIC_OQS_KEM_ENCAPS_NS,
+    OSSL_METRIC_OQS_KEM_DECAPS,
+    OSSL_METRIC_OQS_KEM_DECAPS_NS,
+    OSSL_METRIC_BUILTIN_END
+} OSSL_METRIC_ID;
+
+#  define OSSL_METRIC_INC(id)      OPENSSL_metric_add((id), 1)
+#  define OSSL_METRIC_DEC(id)      OPENSSL_metric_add((id), -1)
+
+static ossl_inline uint64_t ossl_metric_now(void)
+{
+#  ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+        return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#  endif
+    return (uint64_t)time(NULL) * 1000000000;
+}
+
+/* Counts one operation of the timed metric |id| that began at |start| */
+static ossl_inline void ossl_metric_time(int id, uint64_t start)
+{
+    OPENSSL_metric_add(id, 1);
+    OPENSSL_metric_add(id + 1, (int64_t)(ossl_metric_now() - start));
+}
+# else
+#  define OSSL_METRIC_INC(id)      ((void)0)
+#  define OSSL_METRIC_DEC(id)      ((void)0)
+# endif
+
+/*
+ * The liboqs operations that libcrypto and libssl run. OSSL_OQS_TIMED() is
+ * the body of a wrapper: it returns the result of |call|, timed into the
+ * metric |id| unless metrics are disabled.
+ */
+# ifndef OPENSSL_NO_METRICS
+#  define OSSL_OQS_TIMED(id, call)                                      \
+    {                                                                   \
+        uint64_t start = ossl_metric_now();                             \
+        OQS_STATUS ret = (call);                                        \
+                                                                        \
+        ossl_metric_time((id), start);                                  \
+        return ret;                                                     \
+    }
+# else
+#  define OSSL_OQS_TIMED(id, call)                                      \
+    {                                                                   \
+        return (call);                                                  \
+    }
+# endif
+
+static ossl_inline OQS_STATUS ossl_oqs_sig_sign(const OQS_SIG *sig,
+                                                uint8_t *s, size_t *slen,
+                                                const uint8_t *m, size_t mlen,
+                                                const uint8_t *sk)
+OSSL_OQS_TIMED(OSSL_METRIC_OQS_SIG_SIGN,
+               OQS_SIG_sign(sig, s, slen, m, mlen, sk))
+
+static ossl_inline OQS_STATUS ossl_oqs_sig_verify(const OQS_SIG *sig,
+                                                  const uint8_t *m,
+                                                  size_t mlen,
+                                                  const uint8_t *s,
+                                                  size_t slen,
+                                                  const uint8_t *pk)
+OSSL_OQS_TIMED(OSSL_METRIC_OQS_SIG_VERIFY,
+               OQS_SIG_verify(sig, m, mlen, s, slen, pk))
+
+static ossl_inline OQS_STATUS ossl_oqs_kem_keypair(const OQS_KEM *kem,
+                                                   uint8_t *pk, uint8_t *sk)
+OSSL_OQS_TIMED(OSSL_METRIC_OQS_KEM_KEYPAIR, OQS_KEM_keypair(kem, pk, sk))
+
+static ossl_inline OQS_STATUS ossl_oqs_kem_encaps(const OQS_KEM *kem,
+                                                  uint8_t *ct, uint8_t *ss,
+                                                  const uint8_t *pk)
+OSSL_OQS_TIMED(OSSL_METRIC_OQS_KEM_ENCAPS, OQS_KEM_encaps(kem, ct, ss, pk))
+
+static ossl_inline OQS_STATUS ossl_oqs_kem_decaps(const OQS_KEM *kem,
+                                                  uint8_t *ss,
+                                                  const uint8_t *ct,
+                                                  const uint8_t *sk)
+OSSL_OQS_TIMED(OSSL_METRIC_OQS_KEM_DECAPS, OQS_KEM_decaps(kem, ss, ct, sk))
+
+#endif
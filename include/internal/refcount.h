@@ -16,6 +16,14 @@
 #  endif
 # endif
 
+/*
+ * A frozen object has this count for good: taking and dropping references
+ * to it leave the count, and the memory it is in, untouched, and it is never
+ * freed. Objects that are shared between processes forked after they are
+ * frozen so stay shared.
+ */
+# define CRYPTO_REF_FROZEN      0x40000000
+
 # if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L \
      && !defined(__STDC_NO_ATOMICS__)
 #  include <stdatomic.h>
@@ -31,6 +39,9 @@ typedef _Atomic int CRYPTO_REF_COUNT;
 
 static inline int CRYPTO_UP_REF(_Atomic int *val, int *ret, void *lock)
 {
+    if ((*ret = atomic_load_explicit(val, memory_order_relaxed))
+            >= CRYPTO_REF_FROZEN)
+        return 1;
     *ret = atomic_fetch_add_explicit(val, 1, memory_order_relaxed) + 1;
     return 1;
 }
@@ -47,12 +58,20 @@ static inline int CRYPTO_UP_REF(_Atomic int *val, int *ret, void *lock)
  */
 static inline int CRYPTO_DOWN_REF(_Atomic int *val, int *ret, void *lock)
 {
+    if ((*ret = atomic_load_explicit(val, memory_order_relaxed))
+            >= CRYPTO_REF_FROZEN)
+        return 1;
     *ret = atomic_fetch_sub_explicit(val, 1, memory_order_relaxed) - 1;
     if (*ret == 0)
         atomic_thread_fence(memory_order_acquire);
     return 1;
 }
 
+static inline void CRYPTO_REF_FREEZE(_Atomic int *val)
+{
+    atomic_store_explicit(val, CRYPTO_REF_FROZEN, memory_order_relaxed);
+}
+
 # elif defined(__GNUC__) && defined(__ATOMIC_RELAXED) && __GCC_ATOMIC_INT_LOCK_FREE > 0
 
 #  define HAVE_ATOMICS 1
@@ -61,18 +80,27 @@ typedef int CRYPTO_REF_COUNT;
 
 static __inline__ int CRYPTO_UP_REF(int *val, int *ret, void *lock)
 {
+    if ((*ret = __atomic_load_n(val, __ATOMIC_RELAXED)) >= CRYPTO_REF_FROZEN)
+        return 1;
     *ret = __atomic_fetch_add(val, 1, __ATOMIC_RELAXED) + 1;
     return 1;
 }
 
 static __inline__ int CRYPTO_DOWN_REF(int *val, int *ret, void *lock)
 {
+    if ((*ret = __atomic_load_n(val, __ATOMIC_RELAXED)) >= CRYPTO_REF_FROZEN)
+        return 1;
     *ret = __atomic_fetch_sub(val, 1, __ATOMIC_RELAXED) - 1;
     if (*ret == 0)
         __atomic_thread_fence(__ATOMIC_ACQUIRE);
     return 1;
 }
 
+static __inline__ void CRYPTO_REF_FREEZE(int *val)
+{
+    __atomic_store_n(val, CRYPTO_REF_FROZEN, __ATOMIC_RELAXED);
+}
+
 # elif defined(_MSC_VER) && _MSC_VER>=1200
 
 #  define HAVE_ATOMICS 1
@@ -87,12 +115,16 @@ typedef volatile int CRYPTO_REF_COUNT;
 
 static __inline int CRYPTO_UP_REF(volatile int *val, int *ret, void *lock)
 {
+    if ((*ret = *val) >= CRYPTO_REF_FROZEN)
+        return 1;
     *ret = _InterlockedExchangeAdd_nf(val, 1) + 1;
     return 1;
 }
 
 static __inline int CRYPTO_DOWN_REF(volatile int *val, int *ret, void *lock)
 {
+    if ((*ret = *val) >= CRYPTO_REF_FROZEN)
+        return 1;
     *ret = _InterlockedExchangeAdd_nf(val, -1) - 1;
     if (*ret == 0)
         __dmb(_ARM_BARRIER_ISH);
@@ -113,23 +145,34 @@ static __inline int CRYPTO_DOWN_REF(volatile int *val, int *ret, void *lock)
 
 static __inline int CRYPTO_UP_REF(volatile int *val, int *ret, void *lock)
 {
+    if ((*ret = *val) >= CRYPTO_REF_FROZEN)
+        return 1;
     *ret = _InterlockedExchangeAdd(val, 1) + 1;
     return 1;
 }
 
 static __inline int CRYPTO_DOWN_REF(volatile int *val, int *ret, void *lock)
 {
+    if ((*ret = *val) >= CRYPTO_REF_FROZEN)
+        return 1;
     *ret = _InterlockedExchangeAdd(val, -1) - 1;
     return 1;
 }
 #  endif
 
+#  define CRYPTO_REF_FREEZE(val) (void)(*(val) = CRYPTO_REF_FROZEN)
+
 # else
 
 typedef int CRYPTO_REF_COUNT;
 
-# define CRYPTO_UP_REF(val, ret, lock) CRYPTO_atomic_add(val, 1, ret, lock)
-# define CRYPTO_DOWN_REF(val, ret, lock) CRYPTO_atomic_add(val, -1, ret, lock)
+# define CRYPTO_UP_REF(val, ret, lock) \
+    ((*(ret) = *(val)) >= CRYPTO_REF_FROZEN \
+     ? 1 : CRYPTO_atomic_add(val, 1, ret, lock))
+# define CRYPTO_DOWN_REF(val, ret, lock) \
+    ((*(ret) = *(val)) >= CRYPTO_REF_FROZEN \
+     ? 1 : CRYPTO_atomic_add(val, -1, ret, lock))
+# define CRYPTO_REF_FREEZE(val) (void)(*(val) = CRYPTO_REF_FROZEN)
 
 # endif
 
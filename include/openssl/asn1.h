@@ -142,6 +142,11 @@ DEFINE_STACK_OF(X509_ALGOR)
 # define ASN1_STRING_FLAG_EMBED 0x080
 /* String should be parsed in RFC 5280's time format */
 # define ASN1_STRING_FLAG_X509_TIME 0x100
+/*
+ * The content is not owned by the string but points into the encoding it was
+ * decoded from, see d2i_X509_shared(). It is copied before being modified.
+ */
+# define ASN1_STRING_FLAG_BORROWED 0x200
 /* This is the base type that holds just about everything :-) */
 struct asn1_string_st {
     int length;
@@ -211,6 +216,8 @@ typedef struct ASN1_TEMPLATE_st ASN1_TEMPLATE;
 typedef struct ASN1_TLC_st ASN1_TLC;
 /* This is just an opaque pointer */
 typedef struct ASN1_VALUE_st ASN1_VALUE;
+/* Reference counted encoding that decoded objects can borrow from */
+typedef struct asn1_shared_buf_st ASN1_SHARED_BUF;
 
 /* Declare ASN1 functions: the implement macro in in asn1t.h */
 
@@ -554,6 +561,13 @@ int ASN1_STRING_type(const ASN1_STRING *x);
 DEPRECATEDIN_1_1_0(unsigned char *ASN1_STRING_data(ASN1_STRING *x))
 const unsigned char *ASN1_STRING_get0_data(const ASN1_STRING *x);
 
+ASN1_SHARED_BUF *ASN1_SHARED_BUF_new(const unsigned char *data, size_t len);
+ASN1_SHARED_BUF *ASN1_SHARED_BUF_new0(unsigned char *data, size_t len);
+int ASN1_SHARED_BUF_up_ref(ASN1_SHARED_BUF *buf);
+void ASN1_SHARED_BUF_free(ASN1_SHARED_BUF *buf);
+const unsigned char *ASN1_SHARED_BUF_get0_data(const ASN1_SHARED_BUF *buf);
+size_t ASN1_SHARED_BUF_length(const ASN1_SHARED_BUF *buf);
+
 DECLARE_ASN1_FUNCTIONS(ASN1_BIT_STRING)
 int ASN1_BIT_STRING_set(ASN1_BIT_STRING *a, unsigned char *d, int length);
 int ASN1_BIT_STRING_set_bit(ASN1_BIT_STRING *a, int n, int value);
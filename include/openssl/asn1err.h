@@ -66,6 +66,8 @@ int ERR_load_ASN1_strings(void);
 # define ASN1_F_ASN1_PCTX_NEW                             205
 # define ASN1_F_ASN1_PRIMITIVE_NEW                        119
 # define ASN1_F_ASN1_SCTX_NEW                             221
+# define ASN1_F_ASN1_SHARED_BUF_NEW                       234
+# define ASN1_F_ASN1_SHARED_BUF_NEW0                      235
 # define ASN1_F_ASN1_SIGN                                 128
 # define ASN1_F_ASN1_STR2TYPE                             179
 # define ASN1_F_ASN1_STRING_GET_INT64                     227
@@ -22,6 +22,7 @@
 #define OSSL_ASYNC_FD       int
 #define OSSL_BAD_ASYNC_FD   -1
 #endif
+# include <openssl/ossl_typ.h>
 # include <openssl/asyncerr.h>
 
 
@@ -37,8 +38,21 @@ typedef struct async_wait_ctx_st ASYNC_WAIT_CTX;
 #define ASYNC_PAUSE    2
 #define ASYNC_FINISH   3
 
+/* Statistics of the calling thread's job pool, see ASYNC_get_pool_stat() */
+#define ASYNC_POOL_STAT_SIZE            0
+#define ASYNC_POOL_STAT_IDLE            1
+#define ASYNC_POOL_STAT_MAX_SIZE        2
+#define ASYNC_POOL_STAT_HIGH_WATER      3
+#define ASYNC_POOL_STAT_HITS            4
+#define ASYNC_POOL_STAT_MISSES          5
+#define ASYNC_POOL_STAT_EXHAUSTED       6
+#define ASYNC_POOL_STAT_STACK_REALLOCS  7
+
 int ASYNC_init_thread(size_t max_size, size_t init_size);
 void ASYNC_cleanup_thread(void);
+int ASYNC_set_stack_size(size_t size);
+size_t ASYNC_get_stack_size(void);
+size_t ASYNC_get_pool_stat(int stat);
 
 #ifdef OSSL_ASYNC_FD
 ASYNC_WAIT_CTX *ASYNC_WAIT_CTX_new(void);
@@ -69,6 +83,26 @@ ASYNC_WAIT_CTX *ASYNC_get_wait_ctx(ASYNC_JOB *job);
 void ASYNC_block_pause(void);
 void ASYNC_unblock_pause(void);
 
+OSSL_WORKER_POOL *OSSL_WORKER_POOL_new(size_t num_threads);
+void OSSL_WORKER_POOL_free(OSSL_WORKER_POOL *pool);
+size_t OSSL_WORKER_POOL_get_num_threads(const OSSL_WORKER_POOL *pool);
+int OSSL_WORKER_POOL_run(OSSL_WORKER_POOL *pool, int (*run) (void *arg),
+                         void *arg);
+void OSSL_WORKER_POOL_run_all(OSSL_WORKER_POOL *pool,
+                              void (*run) (void *job), void **jobs,
+                              size_t num_jobs);
+
+typedef void (*OSSL_BATCH_FN) (void *ops[], int results[], size_t num_ops);
+
+OSSL_BATCH_QUEUE *OSSL_BATCH_QUEUE_new(size_t max_ops,
+                                       unsigned long max_delay_usec);
+void OSSL_BATCH_QUEUE_free(OSSL_BATCH_QUEUE *queue);
+int OSSL_BATCH_QUEUE_submit(OSSL_BATCH_QUEUE *queue, OSSL_BATCH_FN run,
+                            const void *kind, void *op);
+int OSSL_BATCH_QUEUE_get_timeout(OSSL_BATCH_QUEUE *queue,
+                                 unsigned long *usec);
+size_t OSSL_BATCH_QUEUE_poll(OSSL_BATCH_QUEUE *queue);
+size_t OSSL_BATCH_QUEUE_flush(OSSL_BATCH_QUEUE *queue);
 
 # ifdef  __cplusplus
 }
@@ -27,9 +27,12 @@ int ERR_load_ASYNC_strings(void);
 # define ASYNC_F_ASYNC_INIT_THREAD                        101
 # define ASYNC_F_ASYNC_JOB_NEW                            102
 # define ASYNC_F_ASYNC_PAUSE_JOB                          103
+# define ASYNC_F_ASYNC_SET_STACK_SIZE                     107
 # define ASYNC_F_ASYNC_START_FUNC                         104
 # define ASYNC_F_ASYNC_START_JOB                          105
 # define ASYNC_F_ASYNC_WAIT_CTX_SET_WAIT_FD               106
+# define ASYNC_F_OSSL_BATCH_QUEUE_NEW                     109
+# define ASYNC_F_OSSL_WORKER_POOL_NEW                     108
 
 /*
  * ASYNC reason codes.
@@ -37,6 +40,8 @@ int ERR_load_ASYNC_strings(void);
 # define ASYNC_R_FAILED_TO_SET_POOL                       101
 # define ASYNC_R_FAILED_TO_SWAP_CONTEXT                   102
 # define ASYNC_R_INIT_FAILED                              105
+# define ASYNC_R_INVALID_BATCH_SIZE                       107
 # define ASYNC_R_INVALID_POOL_SIZE                        103
+# define ASYNC_R_INVALID_STACK_SIZE                       106
 
 #endif
@@ -55,6 +55,7 @@ extern "C" {
 # ifndef OPENSSL_NO_SCTP
 #  define BIO_TYPE_DGRAM_SCTP    (24|BIO_TYPE_SOURCE_SINK|BIO_TYPE_DESCRIPTOR)
 # endif
+# define BIO_TYPE_MEM_CHAIN      (25|BIO_TYPE_SOURCE_SINK)
 
 #define BIO_TYPE_START           128
 
@@ -141,6 +142,28 @@ extern "C" {
 
 # define BIO_CTRL_DGRAM_SET_PEEK_MODE      71
 
+/* Kernel TLS offload of the send direction, socket BIOs only */
+# define BIO_CTRL_SET_KTLS                      72
+# define BIO_CTRL_GET_KTLS_SEND                 73
+# define BIO_CTRL_SET_KTLS_TX_SEND_CTRL_MSG     74
+# define BIO_CTRL_CLEAR_KTLS_TX_CTRL_MSG        75
+
+/* Batched recvmmsg()/sendmmsg() on datagram BIOs */
+# define BIO_CTRL_DGRAM_SET_MMSG                76
+# define BIO_CTRL_DGRAM_GET_MMSG                77
+
+/* MSG_ZEROCOPY sends on socket BIOs */
+# define BIO_CTRL_SET_ZEROCOPY                  78
+# define BIO_CTRL_GET_ZEROCOPY_SENT             79
+# define BIO_CTRL_GET_ZEROCOPY_DONE             80
+
+# ifndef OPENSSL_NO_KTLS
+#  define BIO_get_ktls_send(b)         \
+     (BIO_ctrl(b, BIO_CTRL_GET_KTLS_SEND, 0, NULL) > 0)
+# else
+#  define BIO_get_ktls_send(b)  (0)
+# endif
+
 /* modifiers */
 # define BIO_FP_READ             0x02
 # define BIO_FP_WRITE            0x04
@@ -523,6 +546,18 @@ int BIO_ctrl_reset_read_request(BIO *b);
          (int)BIO_ctrl(b, BIO_CTRL_DGRAM_SET_PEER, 0, (char *)(peer))
 # define BIO_dgram_get_mtu_overhead(b) \
          (unsigned int)BIO_ctrl((b), BIO_CTRL_DGRAM_GET_MTU_OVERHEAD, 0, NULL)
+# define BIO_dgram_set_mmsg(b,n) \
+         (int)BIO_ctrl(b, BIO_CTRL_DGRAM_SET_MMSG, n, NULL)
+# define BIO_dgram_get_mmsg(b) \
+         (int)BIO_ctrl(b, BIO_CTRL_DGRAM_GET_MMSG, 0, NULL)
+
+/* ctrl macros for MSG_ZEROCOPY socket BIOs */
+# define BIO_set_zerocopy(b,min) \
+         (int)BIO_ctrl(b, BIO_CTRL_SET_ZEROCOPY, min, NULL)
+# define BIO_get_zerocopy_sent(b) \
+         (uint32_t)BIO_ctrl(b, BIO_CTRL_GET_ZEROCOPY_SENT, 0, NULL)
+# define BIO_get_zerocopy_done(b) \
+         (uint32_t)BIO_ctrl(b, BIO_CTRL_GET_ZEROCOPY_DONE, 0, NULL)
 
 #define BIO_get_ex_new_index(l, p, newf, dupf, freef) \
     CRYPTO_get_ex_new_index(CRYPTO_EX_INDEX_BIO, l, p, newf, dupf, freef)
@@ -587,6 +622,7 @@ long BIO_debug_callback(BIO *bio, int cmd, const char *argp, int argi,
                         long argl, long ret);
 
 const BIO_METHOD *BIO_s_mem(void);
+const BIO_METHOD *BIO_s_mem_chain(void);
 const BIO_METHOD *BIO_s_secmem(void);
 BIO *BIO_new_mem_buf(const void *buf, int len);
 # ifndef OPENSSL_NO_SOCK
@@ -726,6 +762,12 @@ int BIO_new_bio_pair(BIO **bio1, size_t writebuf1,
  * value.
  */
 
+int BIO_new_mem_chain_pair(BIO **bio1, BIO **bio2);
+int BIO_mem_chain_peek(BIO *b, const unsigned char **data, size_t *len,
+                       int max);
+int BIO_mem_chain_consume(BIO *b, size_t len);
+int BIO_mem_chain_move(BIO *to, BIO *from, size_t len, size_t *moved);
+
 void BIO_copy_next_retry(BIO *b);
 
 /*
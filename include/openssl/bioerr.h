@@ -43,6 +43,9 @@ int ERR_load_BIO_strings(void);
 # define BIO_F_BIO_LOOKUP                                 135
 # define BIO_F_BIO_LOOKUP_EX                              143
 # define BIO_F_BIO_MAKE_PAIR                              121
+# define BIO_F_BIO_MEM_CHAIN_CONSUME                      163
+# define BIO_F_BIO_MEM_CHAIN_MOVE                         164
+# define BIO_F_BIO_MEM_CHAIN_PEEK                         162
 # define BIO_F_BIO_METH_NEW                               146
 # define BIO_F_BIO_NEW                                    108
 # define BIO_F_BIO_NEW_DGRAM_SCTP                         145
@@ -67,14 +70,20 @@ int ERR_load_BIO_strings(void);
 # define BIO_F_BUFFER_CTRL                                114
 # define BIO_F_CONN_CTRL                                  127
 # define BIO_F_CONN_STATE                                 115
+# define BIO_F_DGRAM_CTRL                                 156
+# define BIO_F_DGRAM_READ                                 157
 # define BIO_F_DGRAM_SCTP_NEW                             149
 # define BIO_F_DGRAM_SCTP_READ                            132
 # define BIO_F_DGRAM_SCTP_WRITE                           133
+# define BIO_F_DGRAM_WRITE                                158
 # define BIO_F_DOAPR_OUTCH                                150
 # define BIO_F_FILE_CTRL                                  116
 # define BIO_F_FILE_READ                                  130
 # define BIO_F_LINEBUFFER_CTRL                            129
 # define BIO_F_LINEBUFFER_NEW                             151
+# define BIO_F_MEM_CHAIN_NEW                              160
+# define BIO_F_MEM_CHAIN_RESERVE                          159
+# define BIO_F_MEM_CHAIN_WRITE                            161
 # define BIO_F_MEM_WRITE                                  117
 # define BIO_F_NBIOF_NEW                                  154
 # define BIO_F_SLG_WRITE                                  155
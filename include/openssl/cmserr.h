@@ -98,7 +98,9 @@ int ERR_load_CMS_strings(void);
 #  define CMS_F_CMS_SET1_SIGNERIDENTIFIER                  146
 #  define CMS_F_CMS_SET_DETACHED                           147
 #  define CMS_F_CMS_SIGN                                   148
+#  define CMS_F_CMS_SIGNEDDATA_SET_NUM_THREADS             184
 #  define CMS_F_CMS_SIGNED_DATA_INIT                       149
+#  define CMS_F_CMS_SIGNERINFOS_RUN                        185
 #  define CMS_F_CMS_SIGNERINFO_CONTENT_SIGN                150
 #  define CMS_F_CMS_SIGNERINFO_SIGN                        151
 #  define CMS_F_CMS_SIGNERINFO_VERIFY                      152
@@ -174,6 +176,7 @@ int ERR_load_CMS_strings(void);
 #  define CMS_R_RECEIPT_DECODE_ERROR                       169
 #  define CMS_R_RECIPIENT_ERROR                            137
 #  define CMS_R_SIGNER_CERTIFICATE_NOT_FOUND               138
+#  define CMS_R_SIGNER_OPERATION_FAILED                    195
 #  define CMS_R_SIGNFINAL_ERROR                            139
 #  define CMS_R_SMIME_TEXT_ERROR                           140
 #  define CMS_R_STORE_INIT_ERROR                           141
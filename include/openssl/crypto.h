@@ -71,6 +71,9 @@ int CRYPTO_THREAD_read_lock(CRYPTO_RWLOCK *lock);
 int CRYPTO_THREAD_write_lock(CRYPTO_RWLOCK *lock);
 int CRYPTO_THREAD_unlock(CRYPTO_RWLOCK *lock);
 void CRYPTO_THREAD_lock_free(CRYPTO_RWLOCK *lock);
+# ifndef OPENSSL_NO_LOCK_STATS
+int CRYPTO_THREAD_lock_stats(BIO *bio, int top);
+# endif
 
 int CRYPTO_atomic_add(int *val, int amount, int *ret, CRYPTO_RWLOCK *lock);
 
@@ -438,6 +441,21 @@ int CRYPTO_THREAD_cleanup_local(CRYPTO_THREAD_LOCAL *key);
 CRYPTO_THREAD_ID CRYPTO_THREAD_get_current_id(void);
 int CRYPTO_THREAD_compare_id(CRYPTO_THREAD_ID a, CRYPTO_THREAD_ID b);
 
+# ifndef OPENSSL_NO_METRICS
+#  define OPENSSL_METRIC_COUNTER   1
+#  define OPENSSL_METRIC_GAUGE     2
+
+typedef int (*OPENSSL_METRIC_CB)(const char *name, const char *labels,
+                                 int type, const char *help, int64_t value,
+                                 void *arg);
+
+int OPENSSL_metric_register(const char *name, const char *labels, int type,
+                            const char *help);
+void OPENSSL_metric_add(int id, int64_t n);
+int OPENSSL_metrics_do_all(OPENSSL_METRIC_CB cb, void *arg);
+int OPENSSL_metrics_print(BIO *bio);
+# endif
+
 # ifdef  __cplusplus
 }
 # endif
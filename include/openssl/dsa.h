@@ -33,6 +33,12 @@ extern "C" {
 # define OPENSSL_DSA_FIPS_MIN_MODULUS_BITS 1024
 
 # define DSA_FLAG_CACHE_MONT_P   0x01
+/*
+ * Build precomputed tables for g and the public key on the first
+ * verification and reuse them for later ones; for long-lived keys that
+ * verify many signatures.
+ */
+# define DSA_FLAG_CACHE_VERIFY_TABLES 0x02
 # if OPENSSL_API_COMPAT < 0x10100000L
 /*
  * Does nothing. Previously this switched off constant time behaviour.
@@ -34,6 +34,13 @@ extern "C" {
 
 # define DTLS1_RT_HEADER_LENGTH                  13
 
+/* Content type and longest connection ID of RFC 9146 */
+# define DTLS1_RT_TLS12_CID                      25
+# define DTLS1_MAX_CID_LENGTH                    255
+
+/* Longest replay window that DTLS_set_replay_window() accepts, in records */
+# define DTLS1_MAX_REPLAY_WINDOW                 4096
+
 # define DTLS1_HM_HEADER_LENGTH                  12
 
 # define DTLS1_HM_BAD_FRAGMENT                   -2
@@ -934,12 +934,29 @@ void EC_KEY_set_asn1_flag(EC_KEY *eckey, int asn1_flag);
  */
 int EC_KEY_precompute_mult(EC_KEY *key, BN_CTX *ctx);
 
+/** Keeps pre-computed multiples of the public key for ECDSA verification,
+ *  computed when the given number of signatures has been verified.
+ *  \param  key       EC_KEY object
+ *  \param  verifies  number of verifications after which to compute them,
+ *                    or 0 not to (the default)
+ */
+void EC_KEY_set_verify_precompute(EC_KEY *key, unsigned int verifies);
+
 /** Creates a new ec private (and optional a new public) key.
  *  \param  key  EC_KEY object
  *  \return 1 on success and 0 if an error occurred.
  */
 int EC_KEY_generate_key(EC_KEY *key);
 
+/** Creates new ec private and public keys for several EC_KEY objects,
+ *  sharing the cost of converting the public keys to affine coordinates
+ *  when all keys use the same curve.
+ *  \param  keys  array of EC_KEY objects
+ *  \param  num   number of elements in the keys array
+ *  \return 1 on success and 0 if an error occurred.
+ */
+int EC_KEY_generate_key_batch(EC_KEY *keys[], size_t num);
+
 /** Verifies that a private and/or public key is valid.
  *  \param  key  the EC_KEY object
  *  \return 1 on success and 0 otherwise.
@@ -1217,6 +1234,22 @@ ECDSA_SIG *ECDSA_do_sign_ex(const unsigned char *dgst, int dgstlen,
 int ECDSA_do_verify(const unsigned char *dgst, int dgst_len,
                     const ECDSA_SIG *sig, EC_KEY *eckey);
 
+/** Verifies several ECDSA signatures, sharing the modular inversions
+ *  between them when all keys use the same curve.
+ *  \param  dgst      array of pointers to the hash values
+ *  \param  dgst_len  array of the lengths of the hash values
+ *  \param  sig       array of ECDSA_SIG structures
+ *  \param  eckey     array of EC_KEY objects containing public EC keys
+ *  \param  num       number of elements in each array
+ *  \param  ok        array receiving what ECDSA_do_verify returns for each
+ *                    signature
+ *  \return 1 if all signatures are valid, 0 if one is invalid and -1 on
+ *          error
+ */
+int ECDSA_do_verify_batch(const unsigned char *const dgst[],
+                          const int dgst_len[], const ECDSA_SIG *const sig[],
+                          EC_KEY *const eckey[], size_t num, int ok[]);
+
 /** Precompute parts of the signing operation
  *  \param  eckey  EC_KEY object containing a private EC key
  *  \param  ctx    BN_CTX object (optional)
@@ -38,6 +38,7 @@ int ERR_load_EC_strings(void);
 #  define EC_F_ECDH_SIMPLE_COMPUTE_KEY                     257
 #  define EC_F_ECDSA_DO_SIGN_EX                            251
 #  define EC_F_ECDSA_DO_VERIFY                             252
+#  define EC_F_ECDSA_DO_VERIFY_BATCH                       408
 #  define EC_F_ECDSA_SIGN_EX                               254
 #  define EC_F_ECDSA_SIGN_SETUP                            248
 #  define EC_F_ECDSA_SIG_NEW                               265
@@ -77,6 +78,7 @@ int ERR_load_EC_strings(void);
 #  define EC_F_EC_GF2M_SIMPLE_POINT_GET_AFFINE_COORDINATES 162
 #  define EC_F_EC_GF2M_SIMPLE_POINT_SET_AFFINE_COORDINATES 163
 #  define EC_F_EC_GF2M_SIMPLE_SET_COMPRESSED_COORDINATES   164
+#  define EC_F_EC_GFP_FIXEDBASE_MUL                        307
 #  define EC_F_EC_GFP_MONT_FIELD_DECODE                    133
 #  define EC_F_EC_GFP_MONT_FIELD_ENCODE                    134
 #  define EC_F_EC_GFP_MONT_FIELD_INV                       297
@@ -96,6 +98,7 @@ int ERR_load_EC_strings(void);
 #  define EC_F_EC_GFP_NIST_FIELD_MUL                       200
 #  define EC_F_EC_GFP_NIST_FIELD_SQR                       201
 #  define EC_F_EC_GFP_NIST_GROUP_SET_CURVE                 202
+#  define EC_F_EC_GFP_SECP256K1_MUL                        407
 #  define EC_F_EC_GFP_SIMPLE_BLIND_COORDINATES             287
 #  define EC_F_EC_GFP_SIMPLE_FIELD_INV                     298
 #  define EC_F_EC_GFP_SIMPLE_GROUP_CHECK_DISCRIMINANT      165
@@ -131,6 +134,7 @@ int ERR_load_EC_strings(void);
 #  define EC_F_EC_KEY_CHECK_KEY                            177
 #  define EC_F_EC_KEY_COPY                                 178
 #  define EC_F_EC_KEY_GENERATE_KEY                         179
+#  define EC_F_EC_KEY_GENERATE_KEY_BATCH                   308
 #  define EC_F_EC_KEY_NEW                                  182
 #  define EC_F_EC_KEY_NEW_METHOD                           245
 #  define EC_F_EC_KEY_OCT2PRIV                             255
@@ -185,6 +189,8 @@ int ERR_load_EC_strings(void);
 #  define EC_F_O2I_ECPUBLICKEY                             152
 #  define EC_F_OLD_EC_PRIV_DECODE                          222
 #  define EC_F_OQS_ITEM_VERIFY                             297
+#  define EC_F_OQS_KEM_KEY_NEW                             400
+#  define EC_F_OQS_KEM_SET_PUB_KEY                         401
 #  define EC_F_OQS_KEY_INIT                                296
 #  define EC_F_OQS_PRIV_DECODE                             298
 #  define EC_F_OQS_PRIV_ENCODE                             299
@@ -193,6 +199,7 @@ int ERR_load_EC_strings(void);
 #  define EC_F_OQS_SIZE                                    302
 #  define EC_F_OSSL_ECDH_COMPUTE_KEY                       247
 #  define EC_F_OSSL_ECDSA_SIGN_SIG                         249
+#  define EC_F_OSSL_ECDSA_VERIFY_BATCH                     409
 #  define EC_F_OSSL_ECDSA_VERIFY_SIG                       250
 #  define EC_F_PKEY_ECD_CTRL                               271
 #  define EC_F_PKEY_ECD_DIGESTSIGN                         272
@@ -210,7 +217,14 @@ int ERR_load_EC_strings(void);
 #  define EC_F_PKEY_OQS_CTRL                               303
 #  define EC_F_PKEY_OQS_DIGESTSIGN                         304
 #  define EC_F_PKEY_OQS_DIGESTVERIFY                       305
+#  define EC_F_PKEY_OQS_KEM_CHECK_LENS                     402
+#  define EC_F_PKEY_OQS_KEM_DECAPSULATE                    403
+#  define EC_F_PKEY_OQS_KEM_ENCAPSULATE                    404
+#  define EC_F_PKEY_OQS_KEM_ENCAPSULATE_BATCH              405
+#  define EC_F_PKEY_OQS_KEM_KEYGEN                         406
 #  define EC_F_PKEY_OQS_KEYGEN                             306
+#  define EC_F_PKEY_OQS_SIGN                               309
+#  define EC_F_PKEY_OQS_VERIFY                             310
 #  define EC_F_VALIDATE_ECX_DERIVE                         278
 
 /*
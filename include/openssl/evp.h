@@ -59,6 +59,8 @@
 # define EVP_PKEY_HKDF   NID_hkdf
 # define EVP_PKEY_POLY1305 NID_poly1305
 # define EVP_PKEY_SIPHASH NID_siphash
+# define EVP_PKEY_BLAKE2BMAC NID_blake2bmac
+# define EVP_PKEY_BLAKE2SMAC NID_blake2smac
 # define EVP_PKEY_X25519 NID_X25519
 # define EVP_PKEY_ED25519 NID_ED25519
 # define EVP_PKEY_X448 NID_X448
@@ -98,6 +100,25 @@ int oqs_size(const EVP_PKEY *pkey);
 int* get_oqssl_sig_nids(void);
 int* get_oqssl_kem_nids(void);
 char* get_oqs_alg_name(int openssl_nid);
+const OQS_KEM *get_oqs_kem(int openssl_nid);
+const OQS_SIG *get_oqs_sig(int openssl_nid);
+const char *get_oqs_alg_impl(int openssl_nid);
+
+/* Threads verifying the two halves of an OQS hybrid signature, 1 or 2 */
+# define EVP_PKEY_CTRL_OQS_VERIFY_THREADS (EVP_PKEY_ALG_CTRL + 0x100)
+# define EVP_PKEY_CTX_set_oqs_verify_threads(ctx, n) \
+        EVP_PKEY_CTX_ctrl(ctx, -1, EVP_PKEY_OP_VERIFY | EVP_PKEY_OP_VERIFYCTX, \
+                          EVP_PKEY_CTRL_OQS_VERIFY_THREADS, n, NULL)
+
+/* Salt and personalization of the BLAKE2 MACs */
+# define EVP_PKEY_CTRL_BLAKE2_SALT        (EVP_PKEY_ALG_CTRL + 0x101)
+# define EVP_PKEY_CTRL_BLAKE2_PERSONAL    (EVP_PKEY_ALG_CTRL + 0x102)
+# define EVP_PKEY_CTX_set1_blake2_salt(ctx, salt, saltlen) \
+        EVP_PKEY_CTX_ctrl(ctx, -1, EVP_PKEY_OP_SIGNCTX, \
+                          EVP_PKEY_CTRL_BLAKE2_SALT, saltlen, (void *)(salt))
+# define EVP_PKEY_CTX_set1_blake2_personal(ctx, pers, perslen) \
+        EVP_PKEY_CTX_ctrl(ctx, -1, EVP_PKEY_OP_SIGNCTX, \
+                          EVP_PKEY_CTRL_BLAKE2_PERSONAL, perslen, (void *)(pers))
 
 
 #ifdef  __cplusplus
@@ -280,6 +301,7 @@ int (*EVP_CIPHER_meth_get_ctrl(const EVP_CIPHER *cipher))(EVP_CIPHER_CTX *,
 # define         EVP_CIPH_XTS_MODE               0x10001
 # define         EVP_CIPH_WRAP_MODE              0x10002
 # define         EVP_CIPH_OCB_MODE               0x10003
+# define         EVP_CIPH_GCM_SIV_MODE           0x10004
 # define         EVP_CIPH_MODE                   0xF0007
 /* Set if variable length cipher */
 # define         EVP_CIPH_VARIABLE_LENGTH        0x8
@@ -591,6 +613,9 @@ __owur int EVP_DigestFinal_ex(EVP_MD_CTX *ctx, unsigned char *md,
 __owur int EVP_Digest(const void *data, size_t count,
                           unsigned char *md, unsigned int *size,
                           const EVP_MD *type, ENGINE *impl);
+__owur int EVP_DigestBatch(const void *const data[], const size_t count[],
+                           unsigned char *const md[], size_t mdlen,
+                           size_t num, const EVP_MD *type, ENGINE *impl);
 
 __owur int EVP_MD_CTX_copy(EVP_MD_CTX *out, const EVP_MD_CTX *in);
 __owur int EVP_DigestInit(EVP_MD_CTX *ctx, const EVP_MD *type);
@@ -718,6 +743,9 @@ int EVP_CIPHER_CTX_reset(EVP_CIPHER_CTX *c);
 void EVP_CIPHER_CTX_free(EVP_CIPHER_CTX *c);
 int EVP_CIPHER_CTX_set_key_length(EVP_CIPHER_CTX *x, int keylen);
 int EVP_CIPHER_CTX_set_padding(EVP_CIPHER_CTX *c, int pad);
+# define EVP_CIPHER_MAX_THREADS 64
+int EVP_CIPHER_CTX_set_num_threads(EVP_CIPHER_CTX *ctx, int num_threads);
+int EVP_CIPHER_CTX_num_threads(const EVP_CIPHER_CTX *ctx);
 int EVP_CIPHER_CTX_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr);
 int EVP_CIPHER_CTX_rand_key(EVP_CIPHER_CTX *ctx, unsigned char *key);
 
@@ -853,6 +881,7 @@ const EVP_CIPHER *EVP_aes_128_ofb(void);
 const EVP_CIPHER *EVP_aes_128_ctr(void);
 const EVP_CIPHER *EVP_aes_128_ccm(void);
 const EVP_CIPHER *EVP_aes_128_gcm(void);
+const EVP_CIPHER *EVP_aes_128_gcm_siv(void);
 const EVP_CIPHER *EVP_aes_128_xts(void);
 const EVP_CIPHER *EVP_aes_128_wrap(void);
 const EVP_CIPHER *EVP_aes_128_wrap_pad(void);
@@ -884,6 +913,7 @@ const EVP_CIPHER *EVP_aes_256_ofb(void);
 const EVP_CIPHER *EVP_aes_256_ctr(void);
 const EVP_CIPHER *EVP_aes_256_ccm(void);
 const EVP_CIPHER *EVP_aes_256_gcm(void);
+const EVP_CIPHER *EVP_aes_256_gcm_siv(void);
 const EVP_CIPHER *EVP_aes_256_xts(void);
 const EVP_CIPHER *EVP_aes_256_wrap(void);
 const EVP_CIPHER *EVP_aes_256_wrap_pad(void);
@@ -1075,6 +1105,7 @@ struct ec_key_st *EVP_PKEY_get1_EC_KEY(EVP_PKEY *pkey);
 
 EVP_PKEY *EVP_PKEY_new(void);
 int EVP_PKEY_up_ref(EVP_PKEY *pkey);
+int EVP_PKEY_freeze(EVP_PKEY *pkey);
 void EVP_PKEY_free(EVP_PKEY *pkey);
 
 EVP_PKEY *d2i_PublicKey(int type, EVP_PKEY **a, const unsigned char **pp,
@@ -1136,6 +1167,12 @@ int EVP_PBE_scrypt(const char *pass, size_t passlen,
                    const unsigned char *salt, size_t saltlen,
                    uint64_t N, uint64_t r, uint64_t p, uint64_t maxmem,
                    unsigned char *key, size_t keylen);
+# define EVP_PBE_SCRYPT_MAX_THREADS EVP_CIPHER_MAX_THREADS
+int EVP_PBE_scrypt_threads(const char *pass, size_t passlen,
+                           const unsigned char *salt, size_t saltlen,
+                           uint64_t N, uint64_t r, uint64_t p,
+                           uint64_t maxmem, unsigned char *key,
+                           size_t keylen, int num_threads);
 
 int PKCS5_v2_scrypt_keyivgen(EVP_CIPHER_CTX *ctx, const char *pass,
                              int passlen, ASN1_TYPE *param,
@@ -1302,6 +1339,8 @@ void EVP_PKEY_asn1_set_security_bits(EVP_PKEY_ASN1_METHOD *ameth,
 # define EVP_PKEY_OP_ENCRYPT             (1<<8)
 # define EVP_PKEY_OP_DECRYPT             (1<<9)
 # define EVP_PKEY_OP_DERIVE              (1<<10)
+# define EVP_PKEY_OP_ENCAPSULATE         (1<<11)
+# define EVP_PKEY_OP_DECAPSULATE         (1<<12)
 
 # define EVP_PKEY_OP_TYPE_SIG    \
         (EVP_PKEY_OP_SIGN | EVP_PKEY_OP_VERIFY | EVP_PKEY_OP_VERIFYRECOVER \
@@ -1310,8 +1349,12 @@ void EVP_PKEY_asn1_set_security_bits(EVP_PKEY_ASN1_METHOD *ameth,
 # define EVP_PKEY_OP_TYPE_CRYPT \
         (EVP_PKEY_OP_ENCRYPT | EVP_PKEY_OP_DECRYPT)
 
+# define EVP_PKEY_OP_TYPE_KEM \
+        (EVP_PKEY_OP_ENCAPSULATE | EVP_PKEY_OP_DECAPSULATE)
+
 # define EVP_PKEY_OP_TYPE_NOGEN \
-        (EVP_PKEY_OP_TYPE_SIG | EVP_PKEY_OP_TYPE_CRYPT | EVP_PKEY_OP_DERIVE)
+        (EVP_PKEY_OP_TYPE_SIG | EVP_PKEY_OP_TYPE_CRYPT | EVP_PKEY_OP_DERIVE \
+                | EVP_PKEY_OP_TYPE_KEM)
 
 # define EVP_PKEY_OP_TYPE_GEN \
                 (EVP_PKEY_OP_PARAMGEN | EVP_PKEY_OP_KEYGEN)
@@ -1416,6 +1459,10 @@ EVP_PKEY *EVP_PKEY_CTX_get0_peerkey(EVP_PKEY_CTX *ctx);
 
 void EVP_PKEY_CTX_set_app_data(EVP_PKEY_CTX *ctx, void *data);
 void *EVP_PKEY_CTX_get_app_data(EVP_PKEY_CTX *ctx);
+void EVP_PKEY_CTX_set0_worker_pool(EVP_PKEY_CTX *ctx, OSSL_WORKER_POOL *pool);
+OSSL_WORKER_POOL *EVP_PKEY_CTX_get0_worker_pool(EVP_PKEY_CTX *ctx);
+void EVP_PKEY_CTX_set0_batch_queue(EVP_PKEY_CTX *ctx, OSSL_BATCH_QUEUE *queue);
+OSSL_BATCH_QUEUE *EVP_PKEY_CTX_get0_batch_queue(EVP_PKEY_CTX *ctx);
 
 int EVP_PKEY_sign_init(EVP_PKEY_CTX *ctx);
 int EVP_PKEY_sign(EVP_PKEY_CTX *ctx,
@@ -1442,6 +1489,18 @@ int EVP_PKEY_derive_init(EVP_PKEY_CTX *ctx);
 int EVP_PKEY_derive_set_peer(EVP_PKEY_CTX *ctx, EVP_PKEY *peer);
 int EVP_PKEY_derive(EVP_PKEY_CTX *ctx, unsigned char *key, size_t *keylen);
 
+int EVP_PKEY_encapsulate_init(EVP_PKEY_CTX *ctx);
+int EVP_PKEY_encapsulate(EVP_PKEY_CTX *ctx,
+                         unsigned char *ct, size_t *ctlen,
+                         unsigned char *secret, size_t *secretlen);
+int EVP_PKEY_encapsulate_batch(EVP_PKEY_CTX *ctx[], size_t num,
+                               unsigned char *ct, size_t *ctlen,
+                               unsigned char *secret, size_t *secretlen);
+int EVP_PKEY_decapsulate_init(EVP_PKEY_CTX *ctx);
+int EVP_PKEY_decapsulate(EVP_PKEY_CTX *ctx,
+                         unsigned char *secret, size_t *secretlen,
+                         const unsigned char *ct, size_t ctlen);
+
 typedef int EVP_PKEY_gen_cb(EVP_PKEY_CTX *ctx);
 
 int EVP_PKEY_paramgen_init(EVP_PKEY_CTX *ctx);
@@ -1576,6 +1635,30 @@ void EVP_PKEY_meth_set_digest_custom(EVP_PKEY_METHOD *pmeth,
                                      int (*digest_custom) (EVP_PKEY_CTX *ctx,
                                                            EVP_MD_CTX *mctx));
 
+void EVP_PKEY_meth_set_encapsulate(EVP_PKEY_METHOD *pmeth,
+                                   int (*encapsulate_init) (EVP_PKEY_CTX *ctx),
+                                   int (*encapsulate) (EVP_PKEY_CTX *ctx,
+                                                       unsigned char *ct,
+                                                       size_t *ctlen,
+                                                       unsigned char *secret,
+                                                       size_t *secretlen));
+
+void EVP_PKEY_meth_set_encapsulate_batch(EVP_PKEY_METHOD *pmeth,
+                                         int (*encapsulate_batch)
+                                             (EVP_PKEY_CTX *ctx[], size_t num,
+                                              unsigned char *ct,
+                                              size_t *ctlen,
+                                              unsigned char *secret,
+                                              size_t *secretlen));
+
+void EVP_PKEY_meth_set_decapsulate(EVP_PKEY_METHOD *pmeth,
+                                   int (*decapsulate_init) (EVP_PKEY_CTX *ctx),
+                                   int (*decapsulate) (EVP_PKEY_CTX *ctx,
+                                                       unsigned char *secret,
+                                                       size_t *secretlen,
+                                                       const unsigned char *ct,
+                                                       size_t ctlen));
+
 void EVP_PKEY_meth_get_init(const EVP_PKEY_METHOD *pmeth,
                             int (**pinit) (EVP_PKEY_CTX *ctx));
 
@@ -1694,6 +1777,30 @@ void EVP_PKEY_meth_get_param_check(const EVP_PKEY_METHOD *pmeth,
 void EVP_PKEY_meth_get_digest_custom(EVP_PKEY_METHOD *pmeth,
                                      int (**pdigest_custom) (EVP_PKEY_CTX *ctx,
                                                              EVP_MD_CTX *mctx));
+
+void EVP_PKEY_meth_get_encapsulate(const EVP_PKEY_METHOD *pmeth,
+                                   int (**pencapsulate_init) (EVP_PKEY_CTX *ctx),
+                                   int (**pencapsulate) (EVP_PKEY_CTX *ctx,
+                                                         unsigned char *ct,
+                                                         size_t *ctlen,
+                                                         unsigned char *secret,
+                                                         size_t *secretlen));
+
+void EVP_PKEY_meth_get_encapsulate_batch(const EVP_PKEY_METHOD *pmeth,
+                                         int (**pencapsulate_batch)
+                                             (EVP_PKEY_CTX *ctx[], size_t num,
+                                              unsigned char *ct,
+                                              size_t *ctlen,
+                                              unsigned char *secret,
+                                              size_t *secretlen));
+
+void EVP_PKEY_meth_get_decapsulate(const EVP_PKEY_METHOD *pmeth,
+                                   int (**pdecapsulate_init) (EVP_PKEY_CTX *ctx),
+                                   int (**pdecapsulate) (EVP_PKEY_CTX *ctx,
+                                                         unsigned char *secret,
+                                                         size_t *secretlen,
+                                                         const unsigned char *ct,
+                                                         size_t ctlen));
 void EVP_add_alg_module(void);
 
 
@@ -41,6 +41,12 @@ unsigned char *HMAC(const EVP_MD *evp_md, const void *key, int key_len,
                     unsigned int *md_len);
 __owur int HMAC_CTX_copy(HMAC_CTX *dctx, HMAC_CTX *sctx);
 
+HMAC_KEY *HMAC_KEY_new(void);
+void HMAC_KEY_free(HMAC_KEY *hkey);
+__owur int HMAC_KEY_set(HMAC_KEY *hkey, const void *key, int len,
+                        const EVP_MD *md);
+__owur int HMAC_Init_key(HMAC_CTX *ctx, const HMAC_KEY *hkey);
+
 void HMAC_CTX_set_flags(HMAC_CTX *ctx, unsigned long flags);
 const EVP_MD *HMAC_CTX_get_md(const HMAC_CTX *ctx);
 
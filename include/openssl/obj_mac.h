@@ -2113,6 +2113,16 @@
 #define NID_ripemd160WithRSA            119
 #define OBJ_ripemd160WithRSA            1L,3L,36L,3L,3L,1L,2L
 
+#define SN_blake2bmac           "BLAKE2BMAC"
+#define LN_blake2bmac           "blake2bmac"
+#define NID_blake2bmac          1262
+#define OBJ_blake2bmac          1L,3L,6L,1L,4L,1L,1722L,12L,2L,1L
+
+#define SN_blake2smac           "BLAKE2SMAC"
+#define LN_blake2smac           "blake2smac"
+#define NID_blake2smac          1263
+#define OBJ_blake2smac          1L,3L,6L,1L,4L,1L,1722L,12L,2L,2L
+
 #define SN_blake2b512           "BLAKE2b512"
 #define LN_blake2b512           "blake2b512"
 #define NID_blake2b512          1056
@@ -4811,6 +4821,14 @@
 #define LN_chacha20             "chacha20"
 #define NID_chacha20            1019
 
+#define SN_aes_128_gcm_siv              "AES-128-GCM-SIV"
+#define LN_aes_128_gcm_siv              "aes-128-gcm-siv"
+#define NID_aes_128_gcm_siv             1250
+
+#define SN_aes_256_gcm_siv              "AES-256-GCM-SIV"
+#define LN_aes_256_gcm_siv              "aes-256-gcm-siv"
+#define NID_aes_256_gcm_siv             1251
+
 #define SN_dhpublicnumber               "dhpublicnumber"
 #define LN_dhpublicnumber               "X9.42 DH"
 #define NID_dhpublicnumber              920
@@ -5205,6 +5223,10 @@
 #define LN_p256_frodo640aes             "p256_frodo640aes"
 #define NID_p256_frodo640aes            1212
 
+#define SN_x25519_frodo640aes           "x25519_frodo640aes"
+#define LN_x25519_frodo640aes           "x25519_frodo640aes"
+#define NID_x25519_frodo640aes          1252
+
 #define SN_frodo640shake                "frodo640shake"
 #define LN_frodo640shake                "frodo640shake"
 #define NID_frodo640shake               1197
@@ -5213,6 +5235,10 @@
 #define LN_p256_frodo640shake           "p256_frodo640shake"
 #define NID_p256_frodo640shake          1213
 
+#define SN_x25519_frodo640shake         "x25519_frodo640shake"
+#define LN_x25519_frodo640shake         "x25519_frodo640shake"
+#define NID_x25519_frodo640shake                1253
+
 #define SN_frodo976aes          "frodo976aes"
 #define LN_frodo976aes          "frodo976aes"
 #define NID_frodo976aes         1198
@@ -5221,6 +5247,10 @@
 #define LN_p384_frodo976aes             "p384_frodo976aes"
 #define NID_p384_frodo976aes            1214
 
+#define SN_x448_frodo976aes             "x448_frodo976aes"
+#define LN_x448_frodo976aes             "x448_frodo976aes"
+#define NID_x448_frodo976aes            1254
+
 #define SN_frodo976shake                "frodo976shake"
 #define LN_frodo976shake                "frodo976shake"
 #define NID_frodo976shake               1199
@@ -5229,6 +5259,10 @@
 #define LN_p384_frodo976shake           "p384_frodo976shake"
 #define NID_p384_frodo976shake          1215
 
+#define SN_x448_frodo976shake           "x448_frodo976shake"
+#define LN_x448_frodo976shake           "x448_frodo976shake"
+#define NID_x448_frodo976shake          1255
+
 #define SN_frodo1344aes         "frodo1344aes"
 #define LN_frodo1344aes         "frodo1344aes"
 #define NID_frodo1344aes                1200
@@ -5253,6 +5287,10 @@
 #define LN_p256_kyber512                "p256_kyber512"
 #define NID_p256_kyber512               1218
 
+#define SN_x25519_kyber512              "x25519_kyber512"
+#define LN_x25519_kyber512              "x25519_kyber512"
+#define NID_x25519_kyber512             1256
+
 #define SN_kyber768             "kyber768"
 #define LN_kyber768             "kyber768"
 #define NID_kyber768            1203
@@ -5261,6 +5299,10 @@
 #define LN_p384_kyber768                "p384_kyber768"
 #define NID_p384_kyber768               1219
 
+#define SN_x448_kyber768                "x448_kyber768"
+#define LN_x448_kyber768                "x448_kyber768"
+#define NID_x448_kyber768               1257
+
 #define SN_kyber1024            "kyber1024"
 #define LN_kyber1024            "kyber1024"
 #define NID_kyber1024           1204
@@ -5277,6 +5319,10 @@
 #define LN_p256_bikel1          "p256_bikel1"
 #define NID_p256_bikel1         1221
 
+#define SN_x25519_bikel1                "x25519_bikel1"
+#define LN_x25519_bikel1                "x25519_bikel1"
+#define NID_x25519_bikel1               1258
+
 #define SN_bikel3               "bikel3"
 #define LN_bikel3               "bikel3"
 #define NID_bikel3              1206
@@ -5285,6 +5331,10 @@
 #define LN_p384_bikel3          "p384_bikel3"
 #define NID_p384_bikel3         1222
 
+#define SN_x448_bikel3          "x448_bikel3"
+#define LN_x448_bikel3          "x448_bikel3"
+#define NID_x448_bikel3         1259
+
 #define SN_bikel5               "bikel5"
 #define LN_bikel5               "bikel5"
 #define NID_bikel5              1207
@@ -5301,6 +5351,10 @@
 #define LN_p256_hqc128          "p256_hqc128"
 #define NID_p256_hqc128         1224
 
+#define SN_x25519_hqc128                "x25519_hqc128"
+#define LN_x25519_hqc128                "x25519_hqc128"
+#define NID_x25519_hqc128               1260
+
 #define SN_hqc192               "hqc192"
 #define LN_hqc192               "hqc192"
 #define NID_hqc192              1209
@@ -5309,6 +5363,10 @@
 #define LN_p384_hqc192          "p384_hqc192"
 #define NID_p384_hqc192         1225
 
+#define SN_x448_hqc192          "x448_hqc192"
+#define LN_x448_hqc192          "x448_hqc192"
+#define NID_x448_hqc192         1261
+
 #define SN_hqc256               "hqc256"
 #define LN_hqc256               "hqc256"
 #define NID_hqc256              1210
@@ -100,6 +100,7 @@ typedef struct evp_pkey_ctx_st EVP_PKEY_CTX;
 typedef struct evp_Encode_Ctx_st EVP_ENCODE_CTX;
 
 typedef struct hmac_ctx_st HMAC_CTX;
+typedef struct hmac_key_st HMAC_KEY;
 
 typedef struct dh_st DH;
 typedef struct dh_method DH_METHOD;
@@ -176,6 +177,9 @@ typedef struct ct_policy_eval_ctx_st CT_POLICY_EVAL_CTX;
 typedef struct ossl_store_info_st OSSL_STORE_INFO;
 typedef struct ossl_store_search_st OSSL_STORE_SEARCH;
 
+typedef struct ossl_worker_pool_st OSSL_WORKER_POOL;
+typedef struct ossl_batch_queue_st OSSL_BATCH_QUEUE;
+
 #if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L && \
     defined(INTMAX_MAX) && defined(UINTMAX_MAX)
 typedef intmax_t ossl_intmax_t;
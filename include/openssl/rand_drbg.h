@@ -23,6 +23,8 @@
 
 /* In CTR mode, disable derivation function ctr_df */
 # define RAND_DRBG_FLAG_CTR_NO_DF            0x1
+/* Serve small RAND_DRBG_bytes() requests from a buffer refilled in bulk */
+# define RAND_DRBG_FLAG_BUFFERED             0x2
 
 
 # if OPENSSL_API_COMPAT < 0x10200000L
@@ -42,6 +42,9 @@ extern "C" {
  */
 # define SSL_SESSION_ASN1_VERSION 0x0001
 
+/* Flags for i2d_SSL_SESSION_compact() */
+# define SSL_SESSION_COMPACT_PEER_DIGEST         0x1U
+
 # define SSL_MAX_SSL_SESSION_ID_LENGTH           32
 # define SSL_MAX_SID_CTX_LENGTH                  32
 
@@ -213,6 +216,11 @@ typedef struct ssl_cipher_st SSL_CIPHER;
 typedef struct ssl_session_st SSL_SESSION;
 typedef struct tls_sigalgs_st TLS_SIGALGS;
 typedef struct ssl_conf_ctx_st SSL_CONF_CTX;
+typedef struct ssl_ticket_key_ring_st SSL_TICKET_KEY_RING;
+typedef struct ssl_replay_filter_st SSL_REPLAY_FILTER;
+typedef struct ssl_sni_map_st SSL_SNI_MAP;
+typedef struct ssl_cipher_prefs_st SSL_CIPHER_PREFS;
+typedef struct ssl_group_prefs_st SSL_GROUP_PREFS;
 typedef struct ssl_comp_st SSL_COMP;
 
 STACK_OF(SSL_CIPHER);
@@ -224,6 +232,12 @@ typedef struct srtp_protection_profile_st {
     unsigned long id;
 } SRTP_PROTECTION_PROFILE;
 
+/* A buffer segment for SSL_writev_ex() and SSL_readv_ex() */
+typedef struct ssl_iovec_st {
+    void *base;
+    size_t len;
+} SSL_IOVEC;
+
 DEFINE_STACK_OF(SRTP_PROTECTION_PROFILE)
 
 typedef int (*tls_session_ticket_ext_cb_fn)(SSL *s, const unsigned char *data,
@@ -303,7 +317,11 @@ typedef int (*SSL_verify_cb)(int preverify_ok, X509_STORE_CTX *x509_ctx);
 /* Allow initial connection to servers that don't support RI */
 # define SSL_OP_LEGACY_SERVER_CONNECT                    0x00000004U
 
-/* Reserved value (until OpenSSL 1.2.0)                  0x00000008U */
+/*
+ * Hand the send direction of TLS 1.2 and TLS 1.3 connections over to the
+ * kernel (kTLS) where the build, the platform and the negotiated cipher allow
+ */
+# define SSL_OP_ENABLE_KTLS                              0x00000008U
 # define SSL_OP_TLSEXT_PADDING                           0x00000010U
 /* Reserved value (until OpenSSL 1.2.0)                  0x00000020U */
 # define SSL_OP_SAFARI_ECDHE_ECDSA_BUG                   0x00000040U
@@ -506,6 +524,18 @@ typedef int (*SSL_verify_cb)(int preverify_ok, X509_STORE_CTX *x509_ctx);
  * - OpenSSL 1.1.1 and 1.1.1a
  */
 # define SSL_MODE_DTLS_SCTP_LABEL_LENGTH_BUG 0x00000400U
+/*
+ * Hold back the application data of small SSL_write() calls and send it in
+ * full records, once enough has been collected, before reading or when
+ * SSL_uncork() is called. Ignored with DTLS.
+ */
+# define SSL_MODE_CORK 0x00000800U
+/*
+ * Free the transcript, the key exchange scratch and the peer's offered lists
+ * once a handshake completes, leaving what application data, KeyUpdate and
+ * post-handshake authentication need.
+ */
+# define SSL_MODE_RELEASE_HANDSHAKE_STATE 0x00001000U
 
 /* Cert related flags */
 /*
@@ -605,6 +635,10 @@ unsigned long SSL_set_options(SSL *s, unsigned long op);
         SSL_ctrl((ssl),DTLS_CTRL_SET_LINK_MTU,(mtu),NULL)
 # define DTLS_get_link_min_mtu(ssl) \
         SSL_ctrl((ssl),DTLS_CTRL_GET_LINK_MIN_MTU,0,NULL)
+# define DTLS_set_replay_window(ssl, records) \
+        SSL_ctrl((ssl),DTLS_CTRL_SET_REPLAY_WINDOW,(records),NULL)
+# define DTLS_get_replay_window(ssl) \
+        SSL_ctrl((ssl),DTLS_CTRL_GET_REPLAY_WINDOW,0,NULL)
 
 # define SSL_get_secure_renegotiation_support(ssl) \
         SSL_ctrl((ssl), SSL_CTRL_GET_RI_SUPPORT, 0, NULL)
@@ -730,6 +764,7 @@ void SSL_CTX_sess_set_get_cb(SSL_CTX *ctx,
 SSL_SESSION *(*SSL_CTX_sess_get_get_cb(SSL_CTX *ctx)) (struct ssl_st *ssl,
                                                        const unsigned char *data,
                                                        int len, int *copy);
+int SSL_sess_cb_pause(SSL *s, OSSL_ASYNC_FD fd);
 void SSL_CTX_set_info_callback(SSL_CTX *ctx,
                                void (*cb) (const SSL *ssl, int type, int val));
 void (*SSL_CTX_get_info_callback(SSL_CTX *ctx)) (const SSL *ssl, int type,
@@ -1312,6 +1347,15 @@ DECLARE_PEM_rw(SSL_SESSION, SSL_SESSION)
 # define SSL_CTRL_GET_OQS_KEM_CURVE_ID           134
 # define SSL_CTRL_GET_VERIFY_CERT_STORE          137
 # define SSL_CTRL_GET_CHAIN_CERT_STORE           138
+# define SSL_CTRL_SET_DYNAMIC_RECORD_SIZE        139
+# define SSL_CTRL_SET_DYNAMIC_RECORD_RAMP        140
+# define SSL_CTRL_SET_DYNAMIC_RECORD_IDLE        141
+# define SSL_CTRL_SET_SESS_CACHE_SHARDS          142
+# define SSL_CTRL_GET_SESS_CACHE_SHARDS          143
+# define DTLS_CTRL_SET_REPLAY_WINDOW             144
+# define DTLS_CTRL_GET_REPLAY_WINDOW             145
+# define SSL_CTRL_GET_CTX_GROUPS                 146
+# define SSL_CTRL_GET_GROUP_COST                 147
 # define SSL_CERT_SET_FIRST                      1
 # define SSL_CERT_SET_NEXT                       2
 # define SSL_CERT_SET_SERVER                     3
@@ -1411,6 +1455,10 @@ DECLARE_PEM_rw(SSL_SESSION, SSL_SESSION)
         SSL_CTX_ctrl(ctx,SSL_CTRL_SET_GROUPS,glistlen,(int *)(glist))
 # define SSL_CTX_set1_groups_list(ctx, s) \
         SSL_CTX_ctrl(ctx,SSL_CTRL_SET_GROUPS_LIST,0,(char *)(s))
+# define SSL_CTX_get1_groups(ctx, glist) \
+        SSL_CTX_ctrl(ctx,SSL_CTRL_GET_CTX_GROUPS,0,(int *)(glist))
+# define SSL_CTX_get_group_cost(ctx, nid) \
+        SSL_CTX_ctrl(ctx,SSL_CTRL_GET_GROUP_COST,nid,NULL)
 # define SSL_set1_groups(s, glist, glistlen) \
         SSL_ctrl(s,SSL_CTRL_SET_GROUPS,glistlen,(char *)(glist))
 # define SSL_set1_groups_list(s, str) \
@@ -1519,6 +1567,7 @@ void BIO_ssl_shutdown(BIO *ssl_bio);
 __owur int SSL_CTX_set_cipher_list(SSL_CTX *, const char *str);
 __owur SSL_CTX *SSL_CTX_new(const SSL_METHOD *meth);
 int SSL_CTX_up_ref(SSL_CTX *ctx);
+int SSL_CTX_freeze(SSL_CTX *ctx);
 void SSL_CTX_free(SSL_CTX *);
 __owur long SSL_CTX_set_timeout(SSL_CTX *ctx, long t);
 __owur long SSL_CTX_get_timeout(const SSL_CTX *ctx);
@@ -1529,6 +1578,8 @@ __owur int SSL_want(const SSL *s);
 __owur int SSL_clear(SSL *s);
 
 void SSL_CTX_flush_sessions(SSL_CTX *ctx, long tm);
+int SSL_CTX_flush_expired_sessions(SSL_CTX *ctx, long tm, size_t max_sessions,
+                                   long max_usec);
 
 __owur const SSL_CIPHER *SSL_get_current_cipher(const SSL *s);
 __owur const SSL_CIPHER *SSL_get_pending_cipher(const SSL *s);
@@ -1690,6 +1741,10 @@ __owur int SSL_has_matching_session_id(const SSL *s,
                                        unsigned int id_len);
 SSL_SESSION *d2i_SSL_SESSION(SSL_SESSION **a, const unsigned char **pp,
                              long length);
+__owur int i2d_SSL_SESSION_compact(SSL_SESSION *in, unsigned char **pp,
+                                   unsigned int flags);
+SSL_SESSION *d2i_SSL_SESSION_compact(SSL_SESSION **a,
+                                     const unsigned char **pp, long length);
 
 # ifdef HEADER_X509_H
 __owur X509 *SSL_get_peer_certificate(const SSL *s);
@@ -1720,6 +1775,7 @@ __owur int SSL_CTX_use_certificate_ASN1(SSL_CTX *ctx, int len,
                                         const unsigned char *d);
 __owur int SSL_CTX_use_cert_and_key(SSL_CTX *ctx, X509 *x509, EVP_PKEY *privatekey,
                                     STACK_OF(X509) *chain, int override);
+__owur int SSL_CTX_swap_cert_bundle(SSL_CTX *ctx, SSL_CTX *src);
 
 void SSL_CTX_set_default_passwd_cb(SSL_CTX *ctx, pem_password_cb *cb);
 void SSL_CTX_set_default_passwd_cb_userdata(SSL_CTX *ctx, void *u);
@@ -1858,6 +1914,14 @@ __owur int SSL_write(SSL *ssl, const void *buf, int num);
 __owur int SSL_write_ex(SSL *s, const void *buf, size_t num, size_t *written);
 __owur int SSL_write_early_data(SSL *s, const void *buf, size_t num,
                                 size_t *written);
+__owur int SSL_writev_ex(SSL *s, const SSL_IOVEC *iov, size_t iovcnt,
+                         size_t *written);
+__owur int SSL_readv_ex(SSL *s, const SSL_IOVEC *iov, size_t iovcnt,
+                        size_t *readbytes);
+# ifndef OPENSSL_NO_KTLS
+__owur ossl_ssize_t SSL_sendfile(SSL *s, int fd, off_t offset, size_t size,
+                                 int flags);
+# endif
 long SSL_ctrl(SSL *ssl, int cmd, long larg, void *parg);
 long SSL_callback_ctrl(SSL *, int, void (*)(void));
 long SSL_CTX_ctrl(SSL_CTX *ctx, int cmd, long larg, void *parg);
@@ -1927,6 +1991,17 @@ __owur const SSL_METHOD *DTLS_client_method(void); /* DTLS 1.0 and 1.2 */
 
 __owur size_t DTLS_get_data_mtu(const SSL *s);
 
+int SSL_CTX_set_dtls_cid_len(SSL_CTX *ctx, int len);
+int SSL_CTX_get_dtls_cid_len(const SSL_CTX *ctx);
+int SSL_set1_dtls_cid(SSL *s, const unsigned char *cid, size_t len);
+int SSL_get0_dtls_cid(const SSL *s, const unsigned char **cid, size_t *len);
+int SSL_get0_peer_dtls_cid(const SSL *s, const unsigned char **cid,
+                           size_t *len);
+int DTLS_get0_record_cid(const unsigned char *pkt, size_t len, size_t cid_len,
+                         const unsigned char **cid);
+SSL *SSL_CTX_get1_ssl_by_dtls_cid(SSL_CTX *ctx, const unsigned char *pkt,
+                                  size_t len);
+
 __owur STACK_OF(SSL_CIPHER) *SSL_get_ciphers(const SSL *s);
 __owur STACK_OF(SSL_CIPHER) *SSL_CTX_get_ciphers(const SSL_CTX *ctx);
 __owur STACK_OF(SSL_CIPHER) *SSL_get_client_ciphers(const SSL *s);
@@ -1965,6 +2040,8 @@ __owur STACK_OF(X509_NAME) *SSL_get_client_CA_list(const SSL *s);
 __owur STACK_OF(X509_NAME) *SSL_CTX_get_client_CA_list(const SSL_CTX *s);
 __owur int SSL_add_client_CA(SSL *ssl, X509 *x);
 __owur int SSL_CTX_add_client_CA(SSL_CTX *ctx, X509 *x);
+void SSL_CTX_set_max_ca_names_len(SSL_CTX *ctx, size_t len);
+size_t SSL_CTX_get_max_ca_names_len(const SSL_CTX *ctx);
 
 void SSL_set_connect_state(SSL *s);
 void SSL_set_accept_state(SSL *s);
@@ -2046,6 +2123,10 @@ __owur int SSL_get_ex_data_X509_STORE_CTX_idx(void);
         SSL_CTX_ctrl(ctx,SSL_CTRL_SET_SESS_CACHE_SIZE,t,NULL)
 # define SSL_CTX_sess_get_cache_size(ctx) \
         SSL_CTX_ctrl(ctx,SSL_CTRL_GET_SESS_CACHE_SIZE,0,NULL)
+# define SSL_CTX_sess_set_cache_shards(ctx,n) \
+        SSL_CTX_ctrl(ctx,SSL_CTRL_SET_SESS_CACHE_SHARDS,n,NULL)
+# define SSL_CTX_sess_get_cache_shards(ctx) \
+        SSL_CTX_ctrl(ctx,SSL_CTRL_GET_SESS_CACHE_SHARDS,0,NULL)
 # define SSL_CTX_set_session_cache_mode(ctx,m) \
         SSL_CTX_ctrl(ctx,SSL_CTRL_SET_SESS_CACHE_MODE,m,NULL)
 # define SSL_CTX_get_session_cache_mode(ctx) \
@@ -2078,6 +2159,18 @@ __owur int SSL_get_ex_data_X509_STORE_CTX_idx(void);
         SSL_CTX_ctrl(ctx,SSL_CTRL_SET_MAX_PIPELINES,m,NULL)
 # define SSL_set_max_pipelines(ssl,m) \
         SSL_ctrl(ssl,SSL_CTRL_SET_MAX_PIPELINES,m,NULL)
+# define SSL_CTX_set_dynamic_record_size(ctx,m) \
+        SSL_CTX_ctrl(ctx,SSL_CTRL_SET_DYNAMIC_RECORD_SIZE,m,NULL)
+# define SSL_set_dynamic_record_size(ssl,m) \
+        SSL_ctrl(ssl,SSL_CTRL_SET_DYNAMIC_RECORD_SIZE,m,NULL)
+# define SSL_CTX_set_dynamic_record_ramp(ctx,m) \
+        SSL_CTX_ctrl(ctx,SSL_CTRL_SET_DYNAMIC_RECORD_RAMP,m,NULL)
+# define SSL_set_dynamic_record_ramp(ssl,m) \
+        SSL_ctrl(ssl,SSL_CTRL_SET_DYNAMIC_RECORD_RAMP,m,NULL)
+# define SSL_CTX_set_dynamic_record_idle(ctx,m) \
+        SSL_CTX_ctrl(ctx,SSL_CTRL_SET_DYNAMIC_RECORD_IDLE,m,NULL)
+# define SSL_set_dynamic_record_idle(ssl,m) \
+        SSL_ctrl(ssl,SSL_CTRL_SET_DYNAMIC_RECORD_IDLE,m,NULL)
 
 void SSL_CTX_set_default_read_buffer_len(SSL_CTX *ctx, size_t len);
 void SSL_set_default_read_buffer_len(SSL *s, size_t len);
@@ -2152,6 +2245,145 @@ size_t SSL_get_num_tickets(const SSL *s);
 int SSL_CTX_set_num_tickets(SSL_CTX *ctx, size_t num_tickets);
 size_t SSL_CTX_get_num_tickets(const SSL_CTX *ctx);
 
+__owur int SSL_CTX_set_oqs_kem_workers(SSL_CTX *ctx, size_t num_workers);
+size_t SSL_CTX_get_oqs_kem_workers(const SSL_CTX *ctx);
+__owur int SSL_CTX_set_oqs_keypair_pool_size(SSL_CTX *ctx, size_t size);
+size_t SSL_CTX_get_oqs_keypair_pool_size(const SSL_CTX *ctx);
+size_t SSL_CTX_get_oqs_keypair_pool_count(const SSL_CTX *ctx);
+uint64_t SSL_CTX_get_oqs_keypair_pool_hits(const SSL_CTX *ctx);
+# ifndef OPENSSL_NO_EC
+__owur int SSL_CTX_calibrate_groups(SSL_CTX *ctx, int min_bits);
+# endif
+__owur int SSL_CTX_set_key_share_cache_size(SSL_CTX *ctx, size_t size);
+size_t SSL_CTX_get_key_share_cache_size(const SSL_CTX *ctx);
+__owur int SSL_CTX_set_cached_info_cache_size(SSL_CTX *ctx, size_t size);
+size_t SSL_CTX_get_cached_info_cache_size(const SSL_CTX *ctx);
+void SSL_CTX_set_record_buffer_pool_size(SSL_CTX *ctx, size_t size);
+size_t SSL_CTX_get_record_buffer_pool_size(const SSL_CTX *ctx);
+__owur int SSL_CTX_set_cork_threshold(SSL_CTX *ctx, size_t threshold);
+size_t SSL_CTX_get_cork_threshold(const SSL_CTX *ctx);
+__owur int SSL_set_cork_threshold(SSL *s, size_t threshold);
+size_t SSL_get_cork_threshold(const SSL *s);
+size_t SSL_get_corked_bytes(const SSL *s);
+int SSL_uncork(SSL *s);
+/* Longest time a server ECDHE key may be reused for */
+# define SSL_ECDHE_REUSE_MAX_SECONDS    3600
+__owur int SSL_CTX_set_ecdhe_reuse(SSL_CTX *ctx, unsigned int max_uses,
+                                   unsigned int max_seconds);
+void SSL_CTX_get_ecdhe_reuse(const SSL_CTX *ctx, unsigned int *max_uses,
+                             unsigned int *max_seconds);
+
+/* Handshake phases timed once SSL_CTX_enable_handshake_stats() is called */
+# define SSL_HS_PHASE_HANDSHAKE         0
+# define SSL_HS_PHASE_KEYGEN            1
+# define SSL_HS_PHASE_ENCAPS            2
+# define SSL_HS_PHASE_DECAPS            3
+# define SSL_HS_PHASE_SIGN              4
+# define SSL_HS_PHASE_VERIFY            5
+# define SSL_HS_PHASE_CHAIN_VERIFY      6
+# define SSL_HS_PHASE_TRANSCRIPT        7
+# define SSL_HS_PHASE_NUM               8
+
+/* Statistics of a phase returned by SSL_CTX_get_handshake_stats() */
+# define SSL_HS_STAT_COUNT              0
+# define SSL_HS_STAT_WALL_US            1
+# define SSL_HS_STAT_CPU_US             2
+# define SSL_HS_STAT_MAX_WALL_US        3
+/* Bucket 0 counts 0us, bucket i > 0 counts [2^(i-1), 2^i) us, the last more */
+# define SSL_HS_STAT_BUCKETS            24
+# define SSL_HS_STAT_BUCKET(i)          (16 + (i))
+
+__owur int SSL_CTX_enable_handshake_stats(SSL_CTX *ctx);
+uint64_t SSL_CTX_get_handshake_stats(const SSL_CTX *ctx, int phase, int stat);
+
+/* Record layer counters kept once SSL_enable_record_stats() is called */
+# define SSL_REC_STAT_RECORDS_IN        0
+# define SSL_REC_STAT_RECORDS_OUT       1
+# define SSL_REC_STAT_BYTES_IN          2
+# define SSL_REC_STAT_BYTES_OUT         3
+# define SSL_REC_STAT_DECRYPTS          4
+# define SSL_REC_STAT_ENCRYPTS          5
+# define SSL_REC_STAT_FLUSHES           6
+# define SSL_REC_STAT_PARTIAL_WRITES    7
+# define SSL_REC_STAT_WANT_READ         8
+# define SSL_REC_STAT_WANT_WRITE        9
+# define SSL_REC_STAT_BUFFER_ALLOCS     10
+# define SSL_REC_STAT_KEY_UPDATES_IN    11
+# define SSL_REC_STAT_KEY_UPDATES_OUT   12
+# define SSL_REC_STAT_NUM               13
+
+__owur int SSL_CTX_enable_record_stats(SSL_CTX *ctx);
+__owur int SSL_enable_record_stats(SSL *s);
+uint64_t SSL_get_record_stats(const SSL *s, int stat);
+uint64_t SSL_CTX_get_record_stats(const SSL_CTX *ctx, int stat);
+
+/* Categories of memory for SSL_get_memory_usage() */
+# define SSL_MEM_ALL                    -1
+# define SSL_MEM_OBJECT                 0
+# define SSL_MEM_RECORD_BUFFERS         1
+# define SSL_MEM_HANDSHAKE              2
+# define SSL_MEM_KEY_SHARE              3
+# define SSL_MEM_SESSION                4
+# define SSL_MEM_CERTIFICATES           5
+# define SSL_MEM_NUM                    6
+
+size_t SSL_get_memory_usage(const SSL *s, int category);
+size_t SSL_CTX_get_memory_usage(const SSL_CTX *ctx, int category);
+
+size_t SSL_TICKET_KEY_RING_mem_size(unsigned int num_keys);
+SSL_TICKET_KEY_RING *SSL_TICKET_KEY_RING_new(unsigned int num_keys,
+                                             long rotate_secs);
+SSL_TICKET_KEY_RING *SSL_TICKET_KEY_RING_new_mem(void *mem, size_t len,
+                                                 unsigned int num_keys,
+                                                 long rotate_secs);
+SSL_TICKET_KEY_RING *SSL_TICKET_KEY_RING_attach(void *mem, size_t len);
+int SSL_TICKET_KEY_RING_up_ref(SSL_TICKET_KEY_RING *ring);
+void SSL_TICKET_KEY_RING_free(SSL_TICKET_KEY_RING *ring);
+__owur int SSL_TICKET_KEY_RING_rotate(SSL_TICKET_KEY_RING *ring);
+__owur int SSL_CTX_set1_ticket_key_ring(SSL_CTX *ctx,
+                                        SSL_TICKET_KEY_RING *ring);
+SSL_TICKET_KEY_RING *SSL_CTX_get0_ticket_key_ring(const SSL_CTX *ctx);
+size_t SSL_REPLAY_FILTER_mem_size(size_t entries);
+SSL_REPLAY_FILTER *SSL_REPLAY_FILTER_new(size_t entries,
+                                         unsigned int window_secs);
+SSL_REPLAY_FILTER *SSL_REPLAY_FILTER_new_mem(void *mem, size_t len,
+                                             size_t entries,
+                                             unsigned int window_secs);
+SSL_REPLAY_FILTER *SSL_REPLAY_FILTER_attach(void *mem, size_t len);
+int SSL_REPLAY_FILTER_up_ref(SSL_REPLAY_FILTER *rf);
+void SSL_REPLAY_FILTER_free(SSL_REPLAY_FILTER *rf);
+__owur int SSL_CTX_set1_replay_filter(SSL_CTX *ctx, SSL_REPLAY_FILTER *rf);
+SSL_REPLAY_FILTER *SSL_CTX_get0_replay_filter(const SSL_CTX *ctx);
+SSL_SNI_MAP *SSL_SNI_MAP_new(void);
+int SSL_SNI_MAP_up_ref(SSL_SNI_MAP *map);
+void SSL_SNI_MAP_free(SSL_SNI_MAP *map);
+__owur int SSL_SNI_MAP_add(SSL_SNI_MAP *map, const char *name, SSL_CTX *ctx);
+int SSL_SNI_MAP_remove(SSL_SNI_MAP *map, const char *name);
+SSL_CTX *SSL_SNI_MAP_get1_ctx(SSL_SNI_MAP *map, const char *name);
+__owur int SSL_CTX_set1_sni_map(SSL_CTX *ctx, SSL_SNI_MAP *map);
+SSL_SNI_MAP *SSL_CTX_get0_sni_map(const SSL_CTX *ctx);
+__owur int SSL_CTX_set_ticket_peer_cert_cache_size(SSL_CTX *ctx, size_t size);
+size_t SSL_CTX_get_ticket_peer_cert_cache_size(const SSL_CTX *ctx);
+__owur int SSL_CTX_set_client_session_cache_size(SSL_CTX *ctx, size_t size);
+size_t SSL_CTX_get_client_session_cache_size(const SSL_CTX *ctx);
+__owur int SSL_set1_client_session_cache_key(SSL *s, const char *host,
+                                             unsigned int port);
+
+__owur SSL_CIPHER_PREFS *SSL_CIPHER_PREFS_new(const SSL_METHOD *meth,
+                                              const char *cipher_list,
+                                              const char *ciphersuites);
+int SSL_CIPHER_PREFS_up_ref(SSL_CIPHER_PREFS *prefs);
+void SSL_CIPHER_PREFS_free(SSL_CIPHER_PREFS *prefs);
+__owur int SSL_CTX_set_cipher_prefs(SSL_CTX *ctx,
+                                    const SSL_CIPHER_PREFS *prefs);
+# ifndef OPENSSL_NO_EC
+__owur SSL_GROUP_PREFS *SSL_GROUP_PREFS_new(const char *groups);
+int SSL_GROUP_PREFS_up_ref(SSL_GROUP_PREFS *prefs);
+void SSL_GROUP_PREFS_free(SSL_GROUP_PREFS *prefs);
+__owur int SSL_CTX_set_group_prefs(SSL_CTX *ctx,
+                                   const SSL_GROUP_PREFS *prefs);
+# endif
+
 # if OPENSSL_API_COMPAT < 0x10100000L
 #  define SSL_cache_hit(s) SSL_session_reused(s)
 # endif
@@ -2374,6 +2606,7 @@ __owur void *SSL_CTX_get0_security_ex_data(const SSL_CTX *ctx);
 /* OPENSSL_INIT flag 0x010000 reserved for internal use */
 # define OPENSSL_INIT_NO_LOAD_SSL_STRINGS    0x00100000L
 # define OPENSSL_INIT_LOAD_SSL_STRINGS       0x00200000L
+# define OPENSSL_INIT_LAZY_ALGORITHMS        0x00400000L
 
 # define OPENSSL_INIT_SSL_DEFAULT \
         (OPENSSL_INIT_LOAD_SSL_STRINGS | OPENSSL_INIT_LOAD_CRYPTO_STRINGS)
@@ -2439,6 +2672,7 @@ extern const char SSL_version_str[];
 typedef unsigned int (*DTLS_timer_cb)(SSL *s, unsigned int timer_us);
 
 void DTLS_set_timer_cb(SSL *s, DTLS_timer_cb cb);
+void DTLS_set_retransmit_pacing(SSL *s, size_t burst, unsigned int interval_us);
 
 
 typedef int (*SSL_allow_early_data_cb_fn)(SSL *s, void *arg);
@@ -2449,6 +2683,14 @@ void SSL_set_allow_early_data_cb(SSL *s,
                                  SSL_allow_early_data_cb_fn cb,
                                  void *arg);
 
+# ifndef OPENSSL_NO_OCSP
+__owur int SSL_CTX_set1_ocsp_staple(SSL_CTX *ctx, const unsigned char *resp,
+                                    size_t len);
+__owur int SSL_CTX_set_ocsp_verify_cache_size(SSL_CTX *ctx, size_t size);
+size_t SSL_CTX_get_ocsp_verify_cache_size(const SSL_CTX *ctx);
+__owur int SSL_check_ocsp_staple(SSL *s);
+# endif
+
 # ifdef  __cplusplus
 }
 # endif
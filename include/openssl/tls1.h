@@ -131,6 +131,12 @@ extern "C" {
 /* ExtensionType value from RFC7627 */
 # define TLSEXT_TYPE_extended_master_secret      23
 
+/* ExtensionType value from RFC7924 */
+# define TLSEXT_TYPE_cached_info                 25
+
+/* ExtensionType value from RFC8879 */
+# define TLSEXT_TYPE_compress_certificate        27
+
 /* ExtensionType value from RFC4507 */
 # define TLSEXT_TYPE_session_ticket              35
 
@@ -145,6 +151,9 @@ extern "C" {
 # define TLSEXT_TYPE_signature_algorithms_cert   50
 # define TLSEXT_TYPE_key_share                   51
 
+/* ExtensionType value from RFC 9146 */
+# define TLSEXT_TYPE_connection_id               54
+
 /* Temporary extension type */
 # define TLSEXT_TYPE_renegotiate                 0xff01
 
@@ -211,6 +220,17 @@ extern "C" {
 int SSL_CTX_set_tlsext_max_fragment_length(SSL_CTX *ctx, uint8_t mode);
 int SSL_set_tlsext_max_fragment_length(SSL *ssl, uint8_t mode);
 
+/* CertificateCompressionAlgorithm values from RFC8879 */
+# define TLSEXT_comp_cert_none                  0
+# define TLSEXT_comp_cert_zlib                  1
+# define TLSEXT_comp_cert_brotli                2
+# define TLSEXT_comp_cert_zstd                  3
+
+__owur int SSL_CTX_set1_cert_comp_preference(SSL_CTX *ctx, const int *algs,
+                                             size_t len);
+__owur int SSL_set1_cert_comp_preference(SSL *ssl, const int *algs,
+                                         size_t len);
+
 # define TLSEXT_MAXLEN_host_name 255
 
 __owur const char *SSL_get_servername(const SSL *s, const int type);
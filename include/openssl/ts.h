@@ -338,6 +338,13 @@ int TS_RESP_CTX_set_signer_digest(TS_RESP_CTX *ctx,
                                   const EVP_MD *signer_digest);
 int TS_RESP_CTX_set_ess_cert_id_digest(TS_RESP_CTX *ctx, const EVP_MD *md);
 
+/*
+ * Sets the number of threads, from 1 (the default) to TS_RESP_MAX_THREADS,
+ * that TS_RESP_create_response_batch() signs on.
+ */
+# define TS_RESP_MAX_THREADS     64
+int TS_RESP_CTX_set_num_threads(TS_RESP_CTX *ctx, int num_threads);
+
 /* This parameter must be set. */
 int TS_RESP_CTX_set_def_policy(TS_RESP_CTX *ctx, const ASN1_OBJECT *def_policy);
 
@@ -411,6 +418,16 @@ TS_TST_INFO *TS_RESP_CTX_get_tst_info(TS_RESP_CTX *ctx);
  */
 TS_RESP *TS_RESP_create_response(TS_RESP_CTX *ctx, BIO *req_bio);
 
+/*
+ * Creates the responses to |num| requests as TS_RESP_create_response()
+ * does, storing them in |responses|.  The callbacks are called on the
+ * calling thread, one request after the other, then the granted responses
+ * are signed together, on the threads set with TS_RESP_CTX_set_num_threads().
+ * Returns 1 if all the responses could be created, 0 if any of them is NULL.
+ */
+int TS_RESP_create_response_batch(TS_RESP_CTX *ctx, BIO *req_bios[],
+                                  TS_RESP *responses[], size_t num);
+
 /*
  * Declarations related to response verification,
  * they are defined in ts/ts_resp_verify.c.
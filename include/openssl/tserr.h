@@ -58,6 +58,7 @@ int ERR_load_TS_strings(void);
 #  define TS_F_TS_REQ_SET_NONCE                            120
 #  define TS_F_TS_REQ_SET_POLICY_ID                        121
 #  define TS_F_TS_RESP_CREATE_RESPONSE                     122
+#  define TS_F_TS_RESP_CREATE_RESPONSE_BATCH               158
 #  define TS_F_TS_RESP_CREATE_TST_INFO                     123
 #  define TS_F_TS_RESP_CTX_ADD_FAILURE_INFO                124
 #  define TS_F_TS_RESP_CTX_ADD_MD                          125
@@ -66,6 +67,7 @@ int ERR_load_TS_strings(void);
 #  define TS_F_TS_RESP_CTX_SET_ACCURACY                    128
 #  define TS_F_TS_RESP_CTX_SET_CERTS                       129
 #  define TS_F_TS_RESP_CTX_SET_DEF_POLICY                  130
+#  define TS_F_TS_RESP_CTX_SET_NUM_THREADS                 159
 #  define TS_F_TS_RESP_CTX_SET_SIGNER_CERT                 131
 #  define TS_F_TS_RESP_CTX_SET_STATUS_INFO                 132
 #  define TS_F_TS_RESP_GET_POLICY                          133
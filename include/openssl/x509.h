@@ -551,6 +551,15 @@ DECLARE_ASN1_FUNCTIONS(X509_CINF)
 
 DECLARE_ASN1_FUNCTIONS(X509)
 DECLARE_ASN1_FUNCTIONS(X509_CERT_AUX)
+X509 *d2i_X509_flat(X509 **a, const unsigned char **in, long len);
+X509 *d2i_X509_shared(X509 **a, ASN1_SHARED_BUF *buf,
+                      const unsigned char **in, long len);
+void X509_intern_enable(int enable);
+int X509_intern_enabled(void);
+X509 *X509_intern(X509 *x);
+X509 *d2i_X509_intern(X509 **a, const unsigned char **in, long len);
+X509 *X509_intern_lookup(const unsigned char *md, size_t md_len);
+size_t X509_intern_flush(void);
 
 #define X509_get_ex_new_index(l, p, newf, dupf, freef) \
     CRYPTO_get_ex_new_index(CRYPTO_EX_INDEX_X509, l, p, newf, dupf, freef)
@@ -649,6 +658,7 @@ ASN1_TIME *X509_getm_notAfter(const X509 *x);
 int X509_set1_notAfter(X509 *x, const ASN1_TIME *tm);
 int X509_set_pubkey(X509 *x, EVP_PKEY *pkey);
 int X509_up_ref(X509 *x);
+int X509_freeze(X509 *x);
 int X509_get_signature_type(const X509 *x);
 
 # if OPENSSL_API_COMPAT < 0x10100000L
@@ -718,6 +728,7 @@ int X509_CRL_set1_lastUpdate(X509_CRL *x, const ASN1_TIME *tm);
 int X509_CRL_set1_nextUpdate(X509_CRL *x, const ASN1_TIME *tm);
 int X509_CRL_sort(X509_CRL *crl);
 int X509_CRL_up_ref(X509_CRL *crl);
+int X509_CRL_freeze(X509_CRL *crl);
 
 # if OPENSSL_API_COMPAT < 0x10100000L
 #  define X509_CRL_set_lastUpdate X509_CRL_set1_lastUpdate
@@ -774,6 +785,7 @@ int X509_cmp(const X509 *a, const X509 *b);
 int X509_NAME_cmp(const X509_NAME *a, const X509_NAME *b);
 unsigned long X509_NAME_hash(X509_NAME *x);
 unsigned long X509_NAME_hash_old(X509_NAME *x);
+unsigned long X509_NAME_hash_keyed(const X509_NAME *x);
 
 int X509_CRL_cmp(const X509_CRL *a, const X509_CRL *b);
 int X509_CRL_match(const X509_CRL *a, const X509_CRL *b);
@@ -973,6 +985,8 @@ int EVP_PKEY_add1_attr_by_txt(EVP_PKEY *key,
                               const unsigned char *bytes, int len);
 
 int X509_verify_cert(X509_STORE_CTX *ctx);
+int X509_verify_cert_batch(X509_STORE *store, X509 **certs,
+                           STACK_OF(X509) **untrusted, int n, int *errors);
 
 /* lookup a cert from a X509 STACK */
 X509 *X509_find_by_issuer_and_serial(STACK_OF(X509) *sk, X509_NAME *name,
@@ -21,11 +21,13 @@ int ERR_load_X509_strings(void);
 /*
  * X509 function codes.
  */
+# define X509_F_ADD_BUNDLE                                164
 # define X509_F_ADD_CERT_DIR                              100
 # define X509_F_BUILD_CHAIN                               106
 # define X509_F_BY_FILE_CTRL                              101
 # define X509_F_CHECK_NAME_CONSTRAINTS                    149
 # define X509_F_CHECK_POLICY                              145
+# define X509_F_D2I_X509_SHARED                           168
 # define X509_F_DANE_I2D                                  107
 # define X509_F_DIR_CTRL                                  102
 # define X509_F_GET_CERT_BY_SUBJECT                       103
@@ -33,7 +35,9 @@ int ERR_load_X509_strings(void);
 # define X509_F_LOOKUP_CERTS_SK                           152
 # define X509_F_NETSCAPE_SPKI_B64_DECODE                  129
 # define X509_F_NETSCAPE_SPKI_B64_ENCODE                  130
+# define X509_F_NEW_BUNDLE                                165
 # define X509_F_NEW_DIR                                   153
+# define X509_F_PUBKEY_CB                                 162
 # define X509_F_X509AT_ADD1_ATTR                          135
 # define X509_F_X509V3_ADD_EXT                            104
 # define X509_F_X509_ATTRIBUTE_CREATE_BY_NID              136
@@ -78,11 +82,14 @@ int ERR_load_X509_strings(void);
 # define X509_F_X509_STORE_CTX_NEW                        142
 # define X509_F_X509_STORE_CTX_PURPOSE_INHERIT            134
 # define X509_F_X509_STORE_NEW                            158
+# define X509_F_X509_STORE_SET_CHAIN_CACHE                163
 # define X509_F_X509_TO_X509_REQ                          126
 # define X509_F_X509_TRUST_ADD                            133
 # define X509_F_X509_TRUST_SET                            141
 # define X509_F_X509_VERIFY_CERT                          127
+# define X509_F_X509_VERIFY_CERT_BATCH                    167
 # define X509_F_X509_VERIFY_PARAM_NEW                     159
+# define X509_F_X509_WRITE_BUNDLE_BIO                     166
 
 /*
  * X509 reason codes.
@@ -97,6 +104,7 @@ int ERR_load_X509_strings(void);
 # define X509_R_CRL_VERIFY_FAILURE                        131
 # define X509_R_IDP_MISMATCH                              128
 # define X509_R_INVALID_ATTRIBUTES                        138
+# define X509_R_INVALID_BUNDLE                            139
 # define X509_R_INVALID_DIRECTORY                         113
 # define X509_R_INVALID_FIELD_NAME                        119
 # define X509_R_INVALID_TRUST                             123
@@ -69,9 +69,34 @@ def load_config(include_disabled_sigs=False):
 
     return config
 
+def select_algs(config, algs):
+    # Keep only the KEMs and signatures named in |algs|, a comma separated
+    # list of KEM group names and signature variant names. Hybrids go with
+    # the algorithm they are built on.
+    names = [name.strip() for name in algs.split(',') if name.strip()]
+    known = [kem['name_group'] for kem in config['kems']]
+    for sig in config['sigs']:
+        known.extend([variant['name'] for variant in sig['variants']])
+    unknown = [name for name in names if name not in known]
+    if unknown:
+        print("Unknown or disabled algorithms in OQS_ALGS: {:s}".format(', '.join(unknown)))
+        exit(1)
+    config = copy.deepcopy(config)
+    config['kems'] = [kem for kem in config['kems'] if kem['name_group'] in names]
+    for sig in config['sigs']:
+        sig['variants'] = [variant for variant in sig['variants'] if variant['name'] in names]
+    config['sigs'] = [sig for sig in config['sigs'] if sig['variants']]
+    return config
+
 config = load_config()
 config = generatehelpers.complete_config(config)
 
+# The objects keep all algorithms, so that the NIDs, which are assigned in
+# sequence, do not depend on the selection
+objects_config = config
+if os.environ.get('OQS_ALGS'):
+    config = select_algs(config, os.environ['OQS_ALGS'])
+
 if len(sys.argv)>2: 
    # short term approach: iterate KEMs looking for OQS alg names: Argument needs to be v040 KEM KATS list
    # long term solution: Embed KEM KATs as arguments to generate.yml and compare against current liboqs KEM KATs
@@ -101,13 +126,14 @@ if len(sys.argv)>2:
 # sigs
 populate('crypto/asn1/standard_methods.h', config, '/////')
 populate('crypto/ec/oqs_meth.c', config, '/////')
+populate('crypto/ec/oqs_kem_meth.c', config, '/////')
 populate('crypto/evp/pmeth_lib.c', config, '/////')
 populate('include/crypto/asn1.h', config, '/////')
 populate('include/crypto/evp.h', config, '/////')
 # We remove the delimiter comments from obj_mac.num
-populate('crypto/objects/obj_mac.num', config, '#####', True)
-populate('crypto/objects/obj_xref.txt', config, '#####')
-populate('crypto/objects/objects.txt', config, '#####')
+populate('crypto/objects/obj_mac.num', objects_config, '#####', True)
+populate('crypto/objects/obj_xref.txt', objects_config, '#####')
+populate('crypto/objects/objects.txt', objects_config, '#####')
 populate('crypto/x509/x509type.c', config, '/////')
 populate('include/openssl/evp.h', config, '/////')
 populate('ssl/ssl_cert_table.h', config, '/////')
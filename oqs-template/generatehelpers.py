@@ -96,6 +96,15 @@ def complete_config(config, oqsdocsdir = None):
              kem['bit_security'] = bits_level
              nkc.append(kem)
    config['kems']=nkc
+   # hybrids with X25519 and X448, taken from the current extra_nids
+   for kem in config['kems']:
+      kem['ecx_hybrids'] = []
+      if 'extra_nids' in kem and 'current' in kem['extra_nids']:
+         for entry in kem['extra_nids']['current']:
+            if entry.get('hybrid_group') == 'x25519':
+               kem['ecx_hybrids'].append({'group': 'x25519', 'nid': entry['nid'], 'curve_id': 29})
+            elif entry.get('hybrid_group') == 'x448':
+               kem['ecx_hybrids'].append({'group': 'x448', 'nid': entry['nid'], 'curve_id': 30})
    for famsig in config['sigs']:
       nsv = []
       for sig in famsig['variants']:
@@ -9,12 +9,17 @@ input_msg = "[OpenSSL](https://openssl.org/) is an open-source implementation of
 def test_sig_speed(ossl, ossl_config, test_artifacts_dir, sig_name):
     common.run_subprocess([ossl, 'speed', '-seconds', '1', sig_name])
 
-# Hybrid KEMs are not integrated to EVP layer yet (issue #59), hence are not
-# speed tested: Thus exclude them from testing. 
-@pytest.mark.parametrize('kem_name', [i for i in common.key_exchanges if not (i.startswith("p256_") or i.startswith("p384_") or i.startswith("p521_"))])
+@pytest.mark.parametrize('kem_name', common.key_exchanges)
 def test_kem_speed(ossl, ossl_config, test_artifacts_dir, kem_name):
     common.run_subprocess([ossl, 'speed', '-seconds', '1', kem_name])
 
+@pytest.mark.parametrize('alg_name', [common.key_exchanges[0], common.signatures[2]])
+def test_threads_speed(ossl, ossl_config, test_artifacts_dir, alg_name):
+    common.run_subprocess([ossl, 'speed', '-seconds', '1', '-threads', '2', alg_name])
+
+def test_s_time_inproc(ossl, ossl_config, test_artifacts_dir):
+    common.run_subprocess([ossl, 's_time', '-inproc', '-time', '1', '-curves', common.key_exchanges[0]])
+
 if __name__ == "__main__":
     import sys
     pytest.main(sys.argv)
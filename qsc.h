@@ -2,32 +2,42 @@
 #define QSC_KEMS \
     { 0x0200, "frodo640aes" }, \
     { 0x2F00, "p256_frodo640aes" }, \
+    { 0x2F80, "x25519_frodo640aes" }, \
     { 0x0201, "frodo640shake" }, \
     { 0x2F01, "p256_frodo640shake" }, \
+    { 0x2F81, "x25519_frodo640shake" }, \
     { 0x0202, "frodo976aes" }, \
     { 0x2F02, "p384_frodo976aes" }, \
+    { 0x2F82, "x448_frodo976aes" }, \
     { 0x0203, "frodo976shake" }, \
     { 0x2F03, "p384_frodo976shake" }, \
+    { 0x2F83, "x448_frodo976shake" }, \
     { 0x0204, "frodo1344aes" }, \
     { 0x2F04, "p521_frodo1344aes" }, \
     { 0x0205, "frodo1344shake" }, \
     { 0x2F05, "p521_frodo1344shake" }, \
     { 0x023A, "kyber512" }, \
     { 0x2F3A, "p256_kyber512" }, \
+    { 0x2F39, "x25519_kyber512" }, \
     { 0x023C, "kyber768" }, \
     { 0x2F3C, "p384_kyber768" }, \
+    { 0x2F90, "x448_kyber768" }, \
     { 0x023D, "kyber1024" }, \
     { 0x2F3D, "p521_kyber1024" }, \
     { 0x0241, "bikel1" }, \
     { 0x2F41, "p256_bikel1" }, \
+    { 0x2FAE, "x25519_bikel1" }, \
     { 0x0242, "bikel3" }, \
     { 0x2F42, "p384_bikel3" }, \
+    { 0x2FAF, "x448_bikel3" }, \
     { 0x0243, "bikel5" }, \
     { 0x2F43, "p521_bikel5" }, \
     { 0x022C, "hqc128" }, \
     { 0x2F2C, "p256_hqc128" }, \
+    { 0x2FAC, "x25519_hqc128" }, \
     { 0x022D, "hqc192" }, \
     { 0x2F2D, "p384_hqc192" }, \
+    { 0x2FAD, "x448_hqc192" }, \
     { 0x022E, "hqc256" }, \
     { 0x2F2E, "p521_hqc256" }, \
 ///// OQS_TEMPLATE_FRAGMENT_OQS_CURVE_ID_NAME_STR_END
@@ -320,6 +320,23 @@ static long ssl_ctrl(BIO *b, int cmd, long num, void *ptr)
         break;
     case BIO_CTRL_FLUSH:
         BIO_clear_retry_flags(b);
+        /* Data held back by SSL_MODE_CORK goes out first */
+        if (SSL_get_corked_bytes(ssl) > 0) {
+            ret = SSL_uncork(ssl);
+            if (ret <= 0) {
+                switch (SSL_get_error(ssl, (int)ret)) {
+                case SSL_ERROR_WANT_WRITE:
+                    BIO_set_retry_write(b);
+                    break;
+                case SSL_ERROR_WANT_READ:
+                    BIO_set_retry_read(b);
+                    break;
+                default:
+                    break;
+                }
+                break;
+            }
+        }
         ret = BIO_ctrl(ssl->wbio, cmd, num, ptr);
         BIO_copy_next_retry(b);
         break;
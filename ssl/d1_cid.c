@@ -0,0 +1,291 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <string.h>
+#include <openssl/rand.h>
+#include "ssl_local.h"
+
+/*
+ * DTLS connection IDs (RFC 9146) let a connection outlive the address it
+ * was made from. Each side says which CID it wants in the records it
+ * receives, and those records carry it in their header, so a server that
+ * reads all its connections from one socket can tell whose a datagram is
+ * whichever address it came from. The CIDs the connections of an SSL_CTX
+ * pick at random are kept in a hash table of the SSL_CTX for that. The
+ * table does not hold references: a connection takes itself out when it
+ * is freed, under the table lock, so that a lookup never finds one that is
+ * going away.
+ */
+
+/* Attempts at picking a CID nobody else has before giving up */
+#define DTLS_CID_PICK_TRIES     8
+
+typedef struct {
+    unsigned char cid[DTLS1_MAX_CID_LENGTH];
+    size_t len;
+    SSL *s;
+} DTLS_CID_ENTRY;
+
+DEFINE_LHASH_OF(DTLS_CID_ENTRY);
+
+struct ssl_dtls_cid_map_st {
+    CRYPTO_RWLOCK *lock;
+    LHASH_OF(DTLS_CID_ENTRY) *entries;
+};
+
+static unsigned long dtls_cid_entry_hash(const DTLS_CID_ENTRY *e)
+{
+    unsigned long h = 5381;
+    size_t i;
+
+    for (i = 0; i < e->len; i++)
+        h = (h << 5) + h + e->cid[i];
+    return h;
+}
+
+static int dtls_cid_entry_cmp(const DTLS_CID_ENTRY *a,
+                              const DTLS_CID_ENTRY *b)
+{
+    if (a->len != b->len)
+        return a->len < b->len ? -1 : 1;
+    return memcmp(a->cid, b->cid, a->len);
+}
+
+static void dtls_cid_entry_free(DTLS_CID_ENTRY *e)
+{
+    OPENSSL_free(e);
+}
+
+void ssl_dtls_cid_map_free(SSL_DTLS_CID_MAP *map)
+{
+    if (map == NULL)
+        return;
+    lh_DTLS_CID_ENTRY_doall(map->entries, dtls_cid_entry_free);
+    lh_DTLS_CID_ENTRY_free(map->entries);
+    CRYPTO_THREAD_lock_free(map->lock);
+    OPENSSL_free(map);
+}
+
+/* The map |s| goes in, if the length of its CID is the one the map is for */
+static SSL_DTLS_CID_MAP *dtls_cid_map(const SSL *s)
+{
+    const SSL_CTX *ctx = s->session_ctx;
+
+    if (ctx == NULL || ctx->ext.dtls_cid_map == NULL
+            || ctx->ext.dtls_cid_len <= 0
+            || s->dtls_cid.cid_len != (size_t)ctx->ext.dtls_cid_len)
+        return NULL;
+    return ctx->ext.dtls_cid_map;
+}
+
+/*
+ * Add |s| to |map|. A CID we picked at random must not be taken already,
+ * one set by the application replaces the connection that had it. Returns
+ * 1 on success, 0 if the CID was taken and -1 on error.
+ */
+static int dtls_cid_register(SSL *s, SSL_DTLS_CID_MAP *map)
+{
+    DTLS_CID_ENTRY *e, *old;
+
+    if ((e = OPENSSL_malloc(sizeof(*e))) == NULL)
+        return -1;
+    memcpy(e->cid, s->dtls_cid.cid, s->dtls_cid.cid_len);
+    e->len = s->dtls_cid.cid_len;
+    e->s = s;
+
+    CRYPTO_THREAD_write_lock(map->lock);
+    if (!s->dtls_cid.cid_set
+            && lh_DTLS_CID_ENTRY_retrieve(map->entries, e) != NULL) {
+        CRYPTO_THREAD_unlock(map->lock);
+        OPENSSL_free(e);
+        return 0;
+    }
+    old = lh_DTLS_CID_ENTRY_insert(map->entries, e);
+    if (old == NULL && lh_DTLS_CID_ENTRY_error(map->entries)) {
+        CRYPTO_THREAD_unlock(map->lock);
+        OPENSSL_free(e);
+        return -1;
+    }
+    if (old != NULL)
+        old->s->dtls_cid.registered = 0;
+    s->dtls_cid.registered = 1;
+    CRYPTO_THREAD_unlock(map->lock);
+    OPENSSL_free(old);
+    return 1;
+}
+
+/* Must be called with the map lock held */
+static void dtls_cid_unregister_locked(SSL *s, SSL_DTLS_CID_MAP *map)
+{
+    DTLS_CID_ENTRY key, *e;
+
+    memcpy(key.cid, s->dtls_cid.cid, s->dtls_cid.cid_len);
+    key.len = s->dtls_cid.cid_len;
+    e = lh_DTLS_CID_ENTRY_retrieve(map->entries, &key);
+    if (e != NULL && e->s == s) {
+        (void)lh_DTLS_CID_ENTRY_delete(map->entries, e);
+        OPENSSL_free(e);
+    }
+    s->dtls_cid.registered = 0;
+}
+
+void ssl_dtls_cid_unregister(SSL *s)
+{
+    SSL_DTLS_CID_MAP *map;
+
+    if (!s->dtls_cid.registered || (map = dtls_cid_map(s)) == NULL)
+        return;
+    CRYPTO_THREAD_write_lock(map->lock);
+    dtls_cid_unregister_locked(s, map);
+    CRYPTO_THREAD_unlock(map->lock);
+}
+
+/*
+ * Drop a reference to |s| for SSL_free() and return how many are left. If
+ * none are, |s| is taken out of the CID map in the same step.
+ */
+int ssl_dtls_cid_down_ref(SSL *s)
+{
+    SSL_DTLS_CID_MAP *map;
+    int i;
+
+    if (!s->dtls_cid.registered || (map = dtls_cid_map(s)) == NULL) {
+        CRYPTO_DOWN_REF(&s->references, &i, s->lock);
+        return i;
+    }
+    CRYPTO_THREAD_write_lock(map->lock);
+    CRYPTO_DOWN_REF(&s->references, &i, s->lock);
+    if (i == 0)
+        dtls_cid_unregister_locked(s, map);
+    CRYPTO_THREAD_unlock(map->lock);
+    return i;
+}
+
+/*
+ * Make sure |s| has a CID of its own, picking one at random if none was
+ * set, and add it to the CID map of its session context.
+ */
+int ssl_dtls_cid_pick(SSL *s)
+{
+    SSL_DTLS_CID_MAP *map;
+    int i, ret;
+
+    if (!s->dtls_cid.cid_set && !s->dtls_cid.cid_picked) {
+        s->dtls_cid.cid_len = s->dtls_cid.gen_len;
+        if (RAND_bytes(s->dtls_cid.cid, s->dtls_cid.gen_len) <= 0)
+            return 0;
+        s->dtls_cid.cid_picked = 1;
+    }
+    if (s->dtls_cid.registered || (map = dtls_cid_map(s)) == NULL)
+        return 1;
+
+    for (i = 0; i < DTLS_CID_PICK_TRIES; i++) {
+        if ((ret = dtls_cid_register(s, map)) != 0)
+            return ret > 0;
+        if (RAND_bytes(s->dtls_cid.cid, s->dtls_cid.cid_len) <= 0)
+            return 0;
+    }
+    return 0;
+}
+
+int SSL_CTX_set_dtls_cid_len(SSL_CTX *ctx, int len)
+{
+    SSL_DTLS_CID_MAP *map = NULL;
+
+    if (len < -1 || len > DTLS1_MAX_CID_LENGTH) {
+        SSLerr(SSL_F_SSL_CTX_SET_DTLS_CID_LEN, SSL_R_INVALID_DTLS_CID_LENGTH);
+        return 0;
+    }
+    if (len > 0 && ctx->ext.dtls_cid_map == NULL) {
+        if ((map = OPENSSL_zalloc(sizeof(*map))) == NULL
+                || (map->entries =
+                        lh_DTLS_CID_ENTRY_new(dtls_cid_entry_hash,
+                                              dtls_cid_entry_cmp)) == NULL
+                || (map->lock = CRYPTO_THREAD_lock_new()) == NULL) {
+            SSLerr(SSL_F_SSL_CTX_SET_DTLS_CID_LEN, ERR_R_MALLOC_FAILURE);
+            ssl_dtls_cid_map_free(map);
+            return 0;
+        }
+        ctx->ext.dtls_cid_map = map;
+    }
+    ctx->ext.dtls_cid_len = len;
+    return 1;
+}
+
+int SSL_CTX_get_dtls_cid_len(const SSL_CTX *ctx)
+{
+    return ctx->ext.dtls_cid_len;
+}
+
+int SSL_set1_dtls_cid(SSL *s, const unsigned char *cid, size_t len)
+{
+    if (len > DTLS1_MAX_CID_LENGTH) {
+        SSLerr(SSL_F_SSL_SET1_DTLS_CID, SSL_R_INVALID_DTLS_CID_LENGTH);
+        return 0;
+    }
+    ssl_dtls_cid_unregister(s);
+    s->dtls_cid.cid_picked = 0;
+    s->dtls_cid.cid_set = cid != NULL;
+    s->dtls_cid.cid_len = cid != NULL ? len : 0;
+    if (len > 0 && cid != NULL)
+        memcpy(s->dtls_cid.cid, cid, len);
+    return 1;
+}
+
+int SSL_get0_dtls_cid(const SSL *s, const unsigned char **cid, size_t *len)
+{
+    if (!s->dtls_cid.negotiated)
+        return 0;
+    *cid = s->dtls_cid.cid;
+    *len = s->dtls_cid.cid_len;
+    return 1;
+}
+
+int SSL_get0_peer_dtls_cid(const SSL *s, const unsigned char **cid,
+                           size_t *len)
+{
+    if (!s->dtls_cid.negotiated)
+        return 0;
+    *cid = s->dtls_cid.peer_cid;
+    *len = s->dtls_cid.peer_cid_len;
+    return 1;
+}
+
+int DTLS_get0_record_cid(const unsigned char *pkt, size_t len, size_t cid_len,
+                         const unsigned char **cid)
+{
+    /* The CID follows the type, version, epoch and sequence number */
+    if (cid_len == 0 || len < DTLS1_RT_HEADER_LENGTH + cid_len
+            || pkt[0] != DTLS1_RT_TLS12_CID)
+        return 0;
+    *cid = pkt + DTLS1_RT_HEADER_LENGTH - 2;
+    return 1;
+}
+
+SSL *SSL_CTX_get1_ssl_by_dtls_cid(SSL_CTX *ctx, const unsigned char *pkt,
+                                  size_t len)
+{
+    SSL_DTLS_CID_MAP *map = ctx->ext.dtls_cid_map;
+    DTLS_CID_ENTRY key, *e;
+    const unsigned char *cid;
+    SSL *s = NULL;
+
+    if (map == NULL || ctx->ext.dtls_cid_len <= 0
+            || !DTLS_get0_record_cid(pkt, len, ctx->ext.dtls_cid_len, &cid))
+        return NULL;
+    key.len = ctx->ext.dtls_cid_len;
+    memcpy(key.cid, cid, key.len);
+
+    CRYPTO_THREAD_read_lock(map->lock);
+    e = lh_DTLS_CID_ENTRY_retrieve(map->entries, &key);
+    if (e != NULL && SSL_up_ref(e->s))
+        s = e->s;
+    CRYPTO_THREAD_unlock(map->lock);
+    return s;
+}
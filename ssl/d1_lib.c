@@ -13,7 +13,6 @@
 #include <openssl/rand.h>
 #include "ssl_local.h"
 
-static void get_current_time(struct timeval *t);
 static int dtls1_handshake_write(SSL *s);
 static size_t dtls1_link_min_mtu(void);
 
@@ -133,6 +132,7 @@ void dtls1_clear_sent_buffer(SSL *s)
         dtls1_hm_fragment_free(frag);
         pitem_free(item);
     }
+    s->d1->pacing_pending = 0;
 }
 
 
@@ -163,6 +163,9 @@ int dtls1_clear(SSL *s)
 
     if (s->d1) {
         DTLS_timer_cb timer_cb = s->d1->timer_cb;
+        size_t pacing_burst = s->d1->pacing_burst;
+        unsigned int pacing_interval_us = s->d1->pacing_interval_us;
+        size_t replay_window = s->d1->replay_window;
 
         buffered_messages = s->d1->buffered_messages;
         sent_messages = s->d1->sent_messages;
@@ -173,8 +176,11 @@ int dtls1_clear(SSL *s)
 
         memset(s->d1, 0, sizeof(*s->d1));
 
-        /* Restore the timer callback from previous state */
+        /* Restore the timer callback, pacing and window from previous state */
         s->d1->timer_cb = timer_cb;
+        s->d1->pacing_burst = pacing_burst;
+        s->d1->pacing_interval_us = pacing_interval_us;
+        s->d1->replay_window = replay_window;
 
         if (s->server) {
             s->d1->cookie_len = sizeof(s->d1->cookie);
@@ -224,6 +230,16 @@ long dtls1_ctrl(SSL *s, int cmd, long larg, void *parg)
         return 1;
     case DTLS_CTRL_GET_LINK_MIN_MTU:
         return (long)dtls1_link_min_mtu();
+    case DTLS_CTRL_SET_REPLAY_WINDOW:
+        if (larg <= 0 || larg > DTLS1_MAX_REPLAY_WINDOW)
+            return 0;
+        /* Whole words of the bitmap */
+        s->d1->replay_window = ((size_t)larg + 63) & ~(size_t)63;
+        return 1;
+    case DTLS_CTRL_GET_REPLAY_WINDOW:
+        if (s->d1->replay_window == 0)
+            return DTLS1_DEFAULT_REPLAY_WINDOW;
+        return (long)s->d1->replay_window;
     case SSL_CTRL_SET_MTU:
         /*
          *  We may not have a BIO set yet so can't call dtls1_min_mtu()
@@ -242,7 +258,7 @@ long dtls1_ctrl(SSL *s, int cmd, long larg, void *parg)
 
 void dtls1_start_timer(SSL *s)
 {
-    unsigned int sec, usec;
+    unsigned int duration_us, sec, usec;
 
 #ifndef OPENSSL_NO_SCTP
     /* Disable timer for SCTP */
@@ -264,13 +280,22 @@ void dtls1_start_timer(SSL *s)
             s->d1->timeout_duration_us = 1000000;
     }
 
+    /*
+     * While a flight is retransmitted in paced bursts, the timer only waits
+     * for the next burst
+     */
+    if (s->d1->pacing_pending)
+        duration_us = s->d1->pacing_interval_us;
+    else
+        duration_us = s->d1->timeout_duration_us;
+
     /* Set timeout to current time */
-    get_current_time(&(s->d1->next_timeout));
+    ssl_get_current_time(&(s->d1->next_timeout));
 
     /* Add duration to current time */
 
-    sec  = s->d1->timeout_duration_us / 1000000;
-    usec = s->d1->timeout_duration_us - (sec * 1000000);
+    sec  = duration_us / 1000000;
+    usec = duration_us - (sec * 1000000);
 
     s->d1->next_timeout.tv_sec  += sec;
     s->d1->next_timeout.tv_usec += usec;
@@ -294,7 +319,7 @@ struct timeval *dtls1_get_timeout(SSL *s, struct timeval *timeleft)
     }
 
     /* Get current time */
-    get_current_time(&timenow);
+    ssl_get_current_time(&timenow);
 
     /* If timer already expired, set remaining time to 0 */
     if (s->d1->next_timeout.tv_sec < timenow.tv_sec ||
@@ -388,32 +413,41 @@ int dtls1_check_timeout_num(SSL *s)
 
 int dtls1_handle_timeout(SSL *s)
 {
+    int ret;
+
     /* if no timer is expired, don't do anything */
     if (!dtls1_is_timer_expired(s)) {
         return 0;
     }
 
-    if (s->d1->timer_cb != NULL)
-        s->d1->timeout_duration_us = s->d1->timer_cb(s, s->d1->timeout_duration_us);
-    else
-        dtls1_double_timeout(s);
+    /*
+     * The end of a pacing interval is not a timeout: the flight just carries
+     * on from where the last burst stopped
+     */
+    if (!s->d1->pacing_pending) {
+        if (s->d1->timer_cb != NULL)
+            s->d1->timeout_duration_us = s->d1->timer_cb(s, s->d1->timeout_duration_us);
+        else
+            dtls1_double_timeout(s);
 
-    if (dtls1_check_timeout_num(s) < 0) {
-        /* SSLfatal() already called */
-        return -1;
-    }
+        if (dtls1_check_timeout_num(s) < 0) {
+            /* SSLfatal() already called */
+            return -1;
+        }
 
-    s->d1->timeout.read_timeouts++;
-    if (s->d1->timeout.read_timeouts > DTLS1_TMO_READ_COUNT) {
-        s->d1->timeout.read_timeouts = 1;
+        s->d1->timeout.read_timeouts++;
+        if (s->d1->timeout.read_timeouts > DTLS1_TMO_READ_COUNT) {
+            s->d1->timeout.read_timeouts = 1;
+        }
     }
 
-    dtls1_start_timer(s);
     /* Calls SSLfatal() if required */
-    return dtls1_retransmit_buffered_messages(s);
+    ret = dtls1_retransmit_buffered_messages(s);
+    dtls1_start_timer(s);
+    return ret;
 }
 
-static void get_current_time(struct timeval *t)
+void ssl_get_current_time(struct timeval *t)
 {
 #if defined(_WIN32)
     SYSTEMTIME st;
@@ -948,6 +982,10 @@ size_t DTLS_get_data_mtu(const SSL *s)
     else
         int_overhead += mac_overhead;
 
+    /* The connection ID and the real content type of each record */
+    if (DTLS_CID_SENDING(s))
+        ext_overhead += s->dtls_cid.peer_cid_len + 1;
+
     /* Subtract external overhead (e.g. IV/nonce, separate MAC) */
     if (ext_overhead + DTLS1_RT_HEADER_LENGTH >= mtu)
         return 0;
@@ -970,3 +1008,9 @@ void DTLS_set_timer_cb(SSL *s, DTLS_timer_cb cb)
 {
     s->d1->timer_cb = cb;
 }
+
+void DTLS_set_retransmit_pacing(SSL *s, size_t burst, unsigned int interval_us)
+{
+    s->d1->pacing_burst = burst;
+    s->d1->pacing_interval_us = interval_us;
+}
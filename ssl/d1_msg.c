@@ -52,6 +52,7 @@ int dtls1_dispatch_alert(SSL *s)
         s->s3->alert_dispatch = 1;
         /* fprintf( stderr, "not done with alert\n" ); */
     } else {
+        ssl_rec_stats_add(s, SSL_REC_STAT_FLUSHES, 1);
         (void)BIO_flush(s->wbio);
 
         if (s->msg_callback)
@@ -0,0 +1,174 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include "ssl_local.h"
+#include "internal/cryptlib.h"
+
+#ifndef OPENSSL_NO_KTLS
+# include "internal/ktls.h"
+
+/*
+ * Fill |crypto_info| with the write keys of |s| in the form the kernel
+ * expects. |key| and |iv| are the key and the (fixed part of the) IV that
+ * were just installed in |ctx|. Returns 0 if the kernel cannot take over
+ * the cipher.
+ */
+static int ktls_configure_crypto(SSL *s, const EVP_CIPHER *c,
+                                 EVP_CIPHER_CTX *ctx,
+                                 const unsigned char *key,
+                                 const unsigned char *iv,
+                                 ktls_crypto_info_t *crypto_info)
+{
+    unsigned char geniv[EVP_GCM_TLS_FIXED_IV_LEN + EVP_GCM_TLS_EXPLICIT_IV_LEN];
+    const unsigned char *rec_seq = s->rlayer.write_sequence;
+    int ret = 0;
+
+    if (s->version == TLS1_2_VERSION
+            && EVP_CIPHER_mode(c) == EVP_CIPH_GCM_MODE) {
+        /*
+         * TLSv1.2 only derives the salt, the explicit part of the nonce
+         * is counted up by the cipher context from a random start
+         */
+        memcpy(geniv, iv, EVP_GCM_TLS_FIXED_IV_LEN);
+        if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_IV_GEN,
+                                EVP_GCM_TLS_EXPLICIT_IV_LEN,
+                                geniv + EVP_GCM_TLS_FIXED_IV_LEN) <= 0)
+            goto end;
+        iv = geniv;
+    }
+
+    memset(crypto_info, 0, sizeof(*crypto_info));
+    switch (EVP_CIPHER_nid(c)) {
+    case NID_aes_128_gcm:
+        if (!ossl_assert(EVP_CIPHER_key_length(c)
+                         == TLS_CIPHER_AES_GCM_128_KEY_SIZE))
+            goto end;
+        crypto_info->u.gcm128.info.cipher_type = TLS_CIPHER_AES_GCM_128;
+        crypto_info->u.gcm128.info.version = s->version;
+        memcpy(crypto_info->u.gcm128.salt, iv,
+               TLS_CIPHER_AES_GCM_128_SALT_SIZE);
+        memcpy(crypto_info->u.gcm128.iv, iv + TLS_CIPHER_AES_GCM_128_SALT_SIZE,
+               TLS_CIPHER_AES_GCM_128_IV_SIZE);
+        memcpy(crypto_info->u.gcm128.key, key,
+               TLS_CIPHER_AES_GCM_128_KEY_SIZE);
+        memcpy(crypto_info->u.gcm128.rec_seq, rec_seq,
+               TLS_CIPHER_AES_GCM_128_REC_SEQ_SIZE);
+        crypto_info->len = sizeof(crypto_info->u.gcm128);
+        ret = 1;
+        break;
+# ifdef TLS_CIPHER_AES_GCM_256
+    case NID_aes_256_gcm:
+        if (!ossl_assert(EVP_CIPHER_key_length(c)
+                         == TLS_CIPHER_AES_GCM_256_KEY_SIZE))
+            goto end;
+        crypto_info->u.gcm256.info.cipher_type = TLS_CIPHER_AES_GCM_256;
+        crypto_info->u.gcm256.info.version = s->version;
+        memcpy(crypto_info->u.gcm256.salt, iv,
+               TLS_CIPHER_AES_GCM_256_SALT_SIZE);
+        memcpy(crypto_info->u.gcm256.iv, iv + TLS_CIPHER_AES_GCM_256_SALT_SIZE,
+               TLS_CIPHER_AES_GCM_256_IV_SIZE);
+        memcpy(crypto_info->u.gcm256.key, key,
+               TLS_CIPHER_AES_GCM_256_KEY_SIZE);
+        memcpy(crypto_info->u.gcm256.rec_seq, rec_seq,
+               TLS_CIPHER_AES_GCM_256_REC_SEQ_SIZE);
+        crypto_info->len = sizeof(crypto_info->u.gcm256);
+        ret = 1;
+        break;
+# endif
+# ifdef TLS_CIPHER_CHACHA20_POLY1305
+    case NID_chacha20_poly1305:
+        if (!ossl_assert(EVP_CIPHER_key_length(c)
+                         == TLS_CIPHER_CHACHA20_POLY1305_KEY_SIZE)
+                || !ossl_assert(EVP_CIPHER_iv_length(c)
+                                == TLS_CIPHER_CHACHA20_POLY1305_IV_SIZE))
+            goto end;
+        crypto_info->u.chacha20poly1305.info.cipher_type =
+            TLS_CIPHER_CHACHA20_POLY1305;
+        crypto_info->u.chacha20poly1305.info.version = s->version;
+        memcpy(crypto_info->u.chacha20poly1305.iv, iv,
+               TLS_CIPHER_CHACHA20_POLY1305_IV_SIZE);
+        memcpy(crypto_info->u.chacha20poly1305.key, key,
+               TLS_CIPHER_CHACHA20_POLY1305_KEY_SIZE);
+        memcpy(crypto_info->u.chacha20poly1305.rec_seq, rec_seq,
+               TLS_CIPHER_CHACHA20_POLY1305_REC_SEQ_SIZE);
+        crypto_info->len = sizeof(crypto_info->u.chacha20poly1305);
+        ret = 1;
+        break;
+# endif
+    default:
+        break;
+    }
+
+ end:
+    OPENSSL_cleanse(geniv, sizeof(geniv));
+    return ret;
+}
+
+/*
+ * Called once new write keys have been installed in |ctx|. If the kernel
+ * already encrypts for |s| it is re-keyed. Otherwise the send direction is
+ * offloaded if SSL_OP_ENABLE_KTLS is set and the kernel supports the
+ * connection parameters; if it does not, |s| keeps encrypting in user space.
+ * Returns 0 after SSLfatal() if the connection cannot continue, 1 otherwise.
+ */
+int ssl_ktls_start_tx(SSL *s, const EVP_CIPHER *c, EVP_CIPHER_CTX *ctx,
+                      const unsigned char *key, const unsigned char *iv)
+{
+    ktls_crypto_info_t crypto_info;
+    int ret = 1;
+
+    if (s->wbio == NULL)
+        return 1;
+
+    if (BIO_get_ktls_send(s->wbio)) {
+        /*
+         * The kernel would carry on with the old keys. Only a TLSv1.3 key
+         * update can get here, renegotiation is off once TLSv1.2 offloads.
+         */
+        if (s->version != TLS1_3_VERSION
+                || !ktls_configure_crypto(s, c, ctx, key, iv, &crypto_info)
+                || !BIO_set_ktls(s->wbio, &crypto_info)) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_KTLS_START_TX,
+                     SSL_R_KTLS_REKEY_FAILED);
+            ret = 0;
+        }
+        goto end;
+    }
+
+    if ((s->options & SSL_OP_ENABLE_KTLS) == 0
+            || SSL_IS_DTLS(s)
+            || (s->version != TLS1_2_VERSION && s->version != TLS1_3_VERSION)
+            || s->compress != NULL
+            /* The kernel always fills records up to the maximum size */
+            || ssl_get_max_send_fragment(s) != SSL3_RT_MAX_PLAIN_LENGTH
+            /* and never pads TLSv1.3 records */
+            || (s->version == TLS1_3_VERSION
+                && (s->record_padding_cb != NULL || s->block_padding > 0)))
+        return 1;
+
+    /* Whatever is still buffered was encrypted by us and has to go first */
+    ssl_rec_stats_add(s, SSL_REC_STAT_FLUSHES, 1);
+    if (BIO_flush(s->wbio) <= 0)
+        return 1;
+
+    if (!ktls_configure_crypto(s, c, ctx, key, iv, &crypto_info))
+        goto end;
+
+    /*
+     * The write buffer is given up by the record layer on the next write,
+     * records are sent straight from the caller's buffer from then on
+     */
+    if (BIO_set_ktls(s->wbio, &crypto_info) && s->version == TLS1_2_VERSION)
+        s->options |= SSL_OP_NO_RENEGOTIATION;
+
+ end:
+    OPENSSL_cleanse(&crypto_info, sizeof(crypto_info));
+    return ret;
+}
+#endif
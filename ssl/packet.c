@@ -87,6 +87,32 @@ static size_t maxmaxsize(size_t lenbytes)
     return ((size_t)1 << (lenbytes * 8)) - 1 + lenbytes;
 }
 
+static int wpacket_sub_pooled(const WPACKET *pkt, const WPACKET_SUB *sub)
+{
+    return sub >= pkt->subpool && sub < pkt->subpool + WPACKET_SUB_POOL;
+}
+
+/* A zeroed sub-packet to go below |parent| */
+static WPACKET_SUB *wpacket_sub_new(WPACKET *pkt, WPACKET_SUB *parent)
+{
+    size_t depth = 0;
+
+    if (parent != NULL)
+        depth = wpacket_sub_pooled(pkt, parent)
+                ? (size_t)(parent - pkt->subpool) + 1 : WPACKET_SUB_POOL;
+    if (depth < WPACKET_SUB_POOL) {
+        memset(&pkt->subpool[depth], 0, sizeof(pkt->subpool[depth]));
+        return &pkt->subpool[depth];
+    }
+    return OPENSSL_zalloc(sizeof(WPACKET_SUB));
+}
+
+static void wpacket_sub_free(WPACKET *pkt, WPACKET_SUB *sub)
+{
+    if (!wpacket_sub_pooled(pkt, sub))
+        OPENSSL_free(sub);
+}
+
 static int wpacket_intern_init_len(WPACKET *pkt, size_t lenbytes)
 {
     unsigned char *lenchars;
@@ -94,7 +120,7 @@ static int wpacket_intern_init_len(WPACKET *pkt, size_t lenbytes)
     pkt->curr = 0;
     pkt->written = 0;
 
-    if ((pkt->subs = OPENSSL_zalloc(sizeof(*pkt->subs))) == NULL) {
+    if ((pkt->subs = wpacket_sub_new(pkt, NULL)) == NULL) {
         SSLerr(SSL_F_WPACKET_INTERN_INIT_LEN, ERR_R_MALLOC_FAILURE);
         return 0;
     }
@@ -106,7 +132,7 @@ static int wpacket_intern_init_len(WPACKET *pkt, size_t lenbytes)
     pkt->subs->lenbytes = lenbytes;
 
     if (!WPACKET_allocate_bytes(pkt, lenbytes, &lenchars)) {
-        OPENSSL_free(pkt->subs);
+        wpacket_sub_free(pkt, pkt->subs);
         pkt->subs = NULL;
         return 0;
     }
@@ -216,7 +242,7 @@ static int wpacket_intern_close(WPACKET *pkt, WPACKET_SUB *sub, int doclose)
 
     if (doclose) {
         pkt->subs = sub->parent;
-        OPENSSL_free(sub);
+        wpacket_sub_free(pkt, sub);
     }
 
     return 1;
@@ -262,7 +288,7 @@ int WPACKET_finish(WPACKET *pkt)
 
     ret = wpacket_intern_close(pkt, pkt->subs, 1);
     if (ret) {
-        OPENSSL_free(pkt->subs);
+        wpacket_sub_free(pkt, pkt->subs);
         pkt->subs = NULL;
     }
 
@@ -278,7 +304,7 @@ int WPACKET_start_sub_packet_len__(WPACKET *pkt, size_t lenbytes)
     if (!ossl_assert(pkt->subs != NULL))
         return 0;
 
-    if ((sub = OPENSSL_zalloc(sizeof(*sub))) == NULL) {
+    if ((sub = wpacket_sub_new(pkt, pkt->subs)) == NULL) {
         SSLerr(SSL_F_WPACKET_START_SUB_PACKET_LEN__, ERR_R_MALLOC_FAILURE);
         return 0;
     }
@@ -418,7 +444,7 @@ void WPACKET_cleanup(WPACKET *pkt)
 
     for (sub = pkt->subs; sub != NULL; sub = parent) {
         parent = sub->parent;
-        OPENSSL_free(sub);
+        wpacket_sub_free(pkt, sub);
     }
     pkt->subs = NULL;
 }
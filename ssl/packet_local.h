@@ -649,6 +649,13 @@ struct wpacket_sub {
     unsigned int flags;
 };
 
+/*
+ * Sub-packets are opened and closed in strict LIFO order, so the first few
+ * levels of nesting live inside the WPACKET itself and only deeper ones
+ * are allocated.
+ */
+#define WPACKET_SUB_POOL    8
+
 typedef struct wpacket_st WPACKET;
 struct wpacket_st {
     /* The buffer where we store the output data */
@@ -671,6 +678,9 @@ struct wpacket_st {
 
     /* Our sub-packets (always at least one if not finished) */
     WPACKET_SUB *subs;
+
+    /* Storage for the outermost WPACKET_SUB_POOL sub-packets */
+    WPACKET_SUB subpool[WPACKET_SUB_POOL];
 };
 
 /* Flags */
@@ -8,13 +8,28 @@
  */
 
 #include "ssl_local.h"
-#include <openssl/bn.h>
+
+/*-
+ * The items of a queue are kept sorted by priority in a ring of pointers,
+ * so that lookups are a binary search and that the usual operations of
+ * DTLS, appending the next message or record and popping the first one,
+ * take constant time. An item inserted out of order only moves the
+ * pointers on the shorter side of its position.
+ *
+ * The items are also chained through their |next| field, in order, for
+ * the benefit of the iterators.
+ */
+#define PQUEUE_MIN_SIZE 16
 
 struct pqueue_st {
-    pitem *items;
-    int count;
+    pitem **items;
+    size_t head;
+    size_t count;
+    size_t size;                /* always 0 or a power of 2 */
 };
 
+#define PQ_ITEM(pq, i) ((pq)->items[((pq)->head + (i)) & ((pq)->size - 1)])
+
 pitem *pitem_new(unsigned char *prio64be, void *data)
 {
     pitem *item = OPENSSL_malloc(sizeof(*item));
@@ -47,83 +62,125 @@ pqueue *pqueue_new(void)
 
 void pqueue_free(pqueue *pq)
 {
+    if (pq == NULL)
+        return;
+    OPENSSL_free(pq->items);
     OPENSSL_free(pq);
 }
 
-pitem *pqueue_insert(pqueue *pq, pitem *item)
+/*
+ * Sets |*idx| to the position of the first item of |pq| whose priority is
+ * not lower than |prio64be|. Returns 1 if that item has priority |prio64be|,
+ * 0 otherwise.
+ */
+static int pqueue_search(pqueue *pq, const unsigned char *prio64be,
+                         size_t *idx)
 {
-    pitem *curr, *next;
-
-    if (pq->items == NULL) {
-        pq->items = item;
-        return item;
-    }
+    size_t lo = 0, hi = pq->count, mid;
+    int cmp;
 
-    for (curr = NULL, next = pq->items;
-         next != NULL; curr = next, next = next->next) {
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
         /*
          * we can compare 64-bit value in big-endian encoding with memcmp:-)
          */
-        int cmp = memcmp(next->priority, item->priority, 8);
-        if (cmp > 0) {          /* next > item */
-            item->next = next;
+        cmp = memcmp(PQ_ITEM(pq, mid)->priority, prio64be, 8);
+        if (cmp == 0) {
+            *idx = mid;
+            return 1;
+        }
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    *idx = lo;
+    return 0;
+}
 
-            if (curr == NULL)
-                pq->items = item;
-            else
-                curr->next = item;
+static int pqueue_grow(pqueue *pq)
+{
+    size_t size = pq->size == 0 ? PQUEUE_MIN_SIZE : pq->size * 2, i;
+    pitem **items;
 
-            return item;
-        }
+    if (size > SIZE_MAX / sizeof(*items)
+            || (items = OPENSSL_malloc(size * sizeof(*items))) == NULL) {
+        SSLerr(SSL_F_PQUEUE_INSERT, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    for (i = 0; i < pq->count; i++)
+        items[i] = PQ_ITEM(pq, i);
+    OPENSSL_free(pq->items);
+    pq->items = items;
+    pq->head = 0;
+    pq->size = size;
+    return 1;
+}
+
+/*
+ * Returns |item|, or NULL if |pq| already holds an item with the same
+ * priority or on allocation failure. The caller keeps ownership of |item|
+ * on failure.
+ */
+pitem *pqueue_insert(pqueue *pq, pitem *item)
+{
+    size_t idx, i;
+
+    if (pq->count == 0
+            || memcmp(PQ_ITEM(pq, pq->count - 1)->priority,
+                      item->priority, 8) < 0)
+        idx = pq->count;
+    else if (pqueue_search(pq, item->priority, &idx))
+        return NULL;            /* duplicates not allowed */
 
-        else if (cmp == 0)      /* duplicates not allowed */
-            return NULL;
+    if (pq->count == pq->size && !pqueue_grow(pq))
+        return NULL;
+
+    if (idx < pq->count / 2) {
+        pq->head = (pq->head - 1) & (pq->size - 1);
+        for (i = 0; i < idx; i++)
+            PQ_ITEM(pq, i) = PQ_ITEM(pq, i + 1);
+    } else {
+        for (i = pq->count; i > idx; i--)
+            PQ_ITEM(pq, i) = PQ_ITEM(pq, i - 1);
     }
+    pq->count++;
 
-    item->next = NULL;
-    curr->next = item;
+    item->next = idx + 1 < pq->count ? PQ_ITEM(pq, idx + 1) : NULL;
+    if (idx > 0)
+        PQ_ITEM(pq, idx - 1)->next = item;
+    PQ_ITEM(pq, idx) = item;
 
     return item;
 }
 
 pitem *pqueue_peek(pqueue *pq)
 {
-    return pq->items;
+    return pq->count == 0 ? NULL : PQ_ITEM(pq, 0);
 }
 
 pitem *pqueue_pop(pqueue *pq)
 {
-    pitem *item = pq->items;
+    pitem *item;
+
+    if (pq->count == 0)
+        return NULL;
 
-    if (pq->items != NULL)
-        pq->items = pq->items->next;
+    item = PQ_ITEM(pq, 0);
+    pq->head = (pq->head + 1) & (pq->size - 1);
+    pq->count--;
 
     return item;
 }
 
 pitem *pqueue_find(pqueue *pq, unsigned char *prio64be)
 {
-    pitem *next;
-    pitem *found = NULL;
+    size_t idx;
 
-    if (pq->items == NULL)
+    if (!pqueue_search(pq, prio64be, &idx))
         return NULL;
 
-    for (next = pq->items; next->next != NULL; next = next->next) {
-        if (memcmp(next->priority, prio64be, 8) == 0) {
-            found = next;
-            break;
-        }
-    }
-
-    /* check the one last node */
-    if (memcmp(next->priority, prio64be, 8) == 0)
-        found = next;
-
-    if (!found)
-        return NULL;
-
-    return found;
+    return PQ_ITEM(pq, idx);
 }
 
 pitem *pqueue_iterator(pqueue *pq)
@@ -147,12 +204,5 @@ pitem *pqueue_next(piterator *item)
 
 size_t pqueue_size(pqueue *pq)
 {
-    pitem *item = pq->items;
-    size_t count = 0;
-
-    while (item != NULL) {
-        count++;
-        item = item->next;
-    }
-    return count;
+    return pq->count;
 }
@@ -10,46 +10,45 @@
 #include "../ssl_local.h"
 #include "record_local.h"
 
-/* mod 128 saturating subtract of two 64-bit values in big-endian order */
-static int satsub64be(const unsigned char *v1, const unsigned char *v2)
-{
-    int64_t ret;
-    uint64_t l1, l2;
-
-    n2l8(v1, l1);
-    n2l8(v2, l2);
+/*
+ * The replay window is a ring of 64-bit words with a bit for each record
+ * number: record n is bit n % 64 of word (n / 64) % words. Moving the window
+ * forward only clears the words it moves over, so checking and marking a
+ * record take constant time however large the window is (see RFC 6479). The
+ * ring has one word more than the window needs, so that the word being
+ * cleared never holds a record that is still in the window.
+ */
 
-    ret = l1 - l2;
+static uint64_t seq_num_value(const unsigned char *seq)
+{
+    uint64_t l;
 
-    /* We do not permit wrap-around */
-    if (l1 > l2 && ret < 0)
-        return 128;
-    else if (l2 > l1 && ret > 0)
-        return -128;
+    n2l8(seq, l);
+    return l;
+}
 
-    if (ret > 128)
-        return 128;
-    else if (ret < -128)
-        return -128;
-    else
-        return (int)ret;
+static size_t bitmap_words(SSL *s, DTLS1_BITMAP *bitmap)
+{
+    /* A new epoch takes the window set at the time */
+    if (bitmap->window == 0)
+        bitmap->window = s->d1->replay_window != 0
+                         ? s->d1->replay_window : DTLS1_DEFAULT_REPLAY_WINDOW;
+    return bitmap->window / 64 + 1;
 }
 
 int dtls1_record_replay_check(SSL *s, DTLS1_BITMAP *bitmap)
 {
-    int cmp;
-    unsigned int shift;
     const unsigned char *seq = s->rlayer.read_sequence;
+    size_t words = bitmap_words(s, bitmap);
+    uint64_t n = seq_num_value(seq), max = seq_num_value(bitmap->max_seq_num);
 
-    cmp = satsub64be(seq, bitmap->max_seq_num);
-    if (cmp > 0) {
+    if (n > max) {
         SSL3_RECORD_set_seq_num(RECORD_LAYER_get_rrec(&s->rlayer), seq);
         return 1;               /* this record in new */
     }
-    shift = -cmp;
-    if (shift >= sizeof(bitmap->map) * 8)
+    if (max - n >= bitmap->window)
         return 0;               /* stale, outside the window */
-    else if (bitmap->map & (1UL << shift))
+    if (bitmap->map[(n / 64) % words] & ((uint64_t)1 << (n % 64)))
         return 0;               /* record previously received */
 
     SSL3_RECORD_set_seq_num(RECORD_LAYER_get_rrec(&s->rlayer), seq);
@@ -58,21 +57,21 @@ int dtls1_record_replay_check(SSL *s, DTLS1_BITMAP *bitmap)
 
 void dtls1_record_bitmap_update(SSL *s, DTLS1_BITMAP *bitmap)
 {
-    int cmp;
-    unsigned int shift;
     const unsigned char *seq = RECORD_LAYER_get_read_sequence(&s->rlayer);
+    size_t words = bitmap_words(s, bitmap);
+    uint64_t n = seq_num_value(seq), max = seq_num_value(bitmap->max_seq_num);
+    uint64_t w;
 
-    cmp = satsub64be(seq, bitmap->max_seq_num);
-    if (cmp > 0) {
-        shift = cmp;
-        if (shift < sizeof(bitmap->map) * 8)
-            bitmap->map <<= shift, bitmap->map |= 1UL;
-        else
-            bitmap->map = 1UL;
+    if (n > max) {
+        if (n / 64 - max / 64 >= words) {
+            memset(bitmap->map, 0, words * sizeof(bitmap->map[0]));
+        } else {
+            for (w = max / 64 + 1; w <= n / 64; w++)
+                bitmap->map[w % words] = 0;
+        }
         memcpy(bitmap->max_seq_num, seq, SEQ_NUM_SIZE);
-    } else {
-        shift = -cmp;
-        if (shift < sizeof(bitmap->map) * 8)
-            bitmap->map |= 1UL << shift;
+    } else if (max - n >= bitmap->window) {
+        return;
     }
+    bitmap->map[(n / 64) % words] |= (uint64_t)1 << (n % 64);
 }
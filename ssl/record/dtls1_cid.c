@@ -0,0 +1,223 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <string.h>
+#include "../ssl_local.h"
+#include <openssl/evp.h>
+#include "record_local.h"
+
+/*
+ * Records with a connection ID (RFC 9146) have the type tls12_cid and the
+ * CID the receiver asked for after the record number. The real content type
+ * is sent encrypted after the content, and the additional data covers the
+ * CID and its length. The TLS mode of the AEAD ciphers only takes the
+ * additional data of an ordinary record, so these records are sealed with
+ * the generic AEAD interface instead, on the same cipher context. Once CIDs
+ * are negotiated, every protected record has one, so the context is never
+ * used in TLS mode again. CIDs are only negotiated with AEAD ciphers.
+ */
+
+/* Epoch and sequence number of a record header */
+#define DTLS1_CID_SEQ_OFFSET    3
+#define DTLS1_CID_SEQ_LEN       8
+#define DTLS1_CID_AAD_MAX       (8 + 3 + 2 + DTLS1_CID_SEQ_LEN \
+                                 + DTLS1_MAX_CID_LENGTH + 2)
+
+void dtls1_cid_set_key(SSL *s, int which, const EVP_CIPHER_CTX *ctx,
+                       const unsigned char *iv, size_t iv_len)
+{
+    DTLS_RECORD_LAYER *d = s->rlayer.d;
+    const SSL_CIPHER *c = s->s3->tmp.new_cipher;
+    DTLS1_CID_AEAD *key;
+    int mode = EVP_CIPHER_CTX_mode(ctx);
+
+    if (which & SSL3_CC_READ) {
+        key = &d->cid_read;
+    } else {
+        d->cid_write[1] = d->cid_write[0];
+        key = &d->cid_write[0];
+    }
+    memset(key, 0, sizeof(*key));
+    if (c->algorithm_mac != SSL_AEAD || iv_len > sizeof(key->iv))
+        return;
+
+    key->ctx = ctx;
+    memcpy(key->iv, iv, iv_len);
+    key->iv_len = iv_len;
+    if (mode == EVP_CIPH_GCM_MODE || mode == EVP_CIPH_CCM_MODE)
+        key->eiv_len = DTLS1_CID_SEQ_LEN;
+    if (mode == EVP_CIPH_CCM_MODE
+            && (c->algorithm_enc & (SSL_AES128CCM8 | SSL_AES256CCM8)) != 0)
+        key->tag_len = EVP_CCM8_TLS_TAG_LEN;
+    else
+        key->tag_len = EVP_GCM_TLS_TAG_LEN;
+}
+
+/*
+ * The nonce is the fixed IV and the explicit nonce for GCM and CCM, and the
+ * IV xored with the record number for ChaCha20-Poly1305, as in TLS.
+ */
+static int dtls1_cid_nonce(const DTLS1_CID_AEAD *key, const unsigned char *seq,
+                           unsigned char *nonce)
+{
+    size_t i;
+
+    if (key->eiv_len != 0) {
+        if (key->iv_len + key->eiv_len > EVP_MAX_IV_LENGTH)
+            return 0;
+        memcpy(nonce, key->iv, key->iv_len);
+        memcpy(nonce + key->iv_len, seq, key->eiv_len);
+        return 1;
+    }
+    if (key->iv_len < DTLS1_CID_SEQ_LEN)
+        return 0;
+    memcpy(nonce, key->iv, key->iv_len);
+    for (i = 0; i < DTLS1_CID_SEQ_LEN; i++)
+        nonce[key->iv_len - DTLS1_CID_SEQ_LEN + i] ^= seq[i];
+    return 1;
+}
+
+/*
+ * The additional data of a record with the header |hdr|, which is followed
+ * by |inner_len| bytes of content and content type.
+ */
+static size_t dtls1_cid_aad(unsigned char *aad, const unsigned char *hdr,
+                            const unsigned char *cid, size_t cid_len,
+                            size_t inner_len)
+{
+    unsigned char *p = aad;
+
+    memset(p, 0xff, 8);
+    p += 8;
+    *p++ = DTLS1_RT_TLS12_CID;
+    *p++ = (unsigned char)cid_len;
+    *p++ = DTLS1_RT_TLS12_CID;
+    memcpy(p, hdr + 1, 2 + DTLS1_CID_SEQ_LEN);
+    p += 2 + DTLS1_CID_SEQ_LEN;
+    memcpy(p, cid, cid_len);
+    p += cid_len;
+    s2n(inner_len, p);
+    return p - aad;
+}
+
+/* Encrypt or decrypt |len| bytes at |data| in place */
+static int dtls1_cid_crypt(const DTLS1_CID_AEAD *key, EVP_CIPHER_CTX *ctx,
+                           const unsigned char *nonce,
+                           const unsigned char *aad, size_t aad_len,
+                           unsigned char *data, size_t len, unsigned char *tag)
+{
+    int enc = EVP_CIPHER_CTX_encrypting(ctx);
+    int ccm = EVP_CIPHER_CTX_mode(ctx) == EVP_CIPH_CCM_MODE;
+    int outl;
+
+    if (EVP_CipherInit_ex(ctx, NULL, NULL, NULL, nonce, -1) <= 0
+            || (!enc && EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG,
+                                            (int)key->tag_len, tag) <= 0)
+            || (ccm && EVP_CipherUpdate(ctx, NULL, &outl, NULL,
+                                        (int)len) <= 0)
+            || EVP_CipherUpdate(ctx, NULL, &outl, aad, (int)aad_len) <= 0
+            || EVP_CipherUpdate(ctx, data, &outl, data, (int)len) <= 0
+            || EVP_CipherFinal_ex(ctx, data + outl, &outl) <= 0
+            || (enc && EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG,
+                                           (int)key->tag_len, tag) <= 0))
+        return 0;
+    return 1;
+}
+
+/*
+ * Write a record of type |type| with the |len| bytes at |buf| to |out|
+ * with the CID of the peer, and its length to |*outlen|.
+ */
+int dtls1_cid_seal(SSL *s, int type, const unsigned char *buf, size_t len,
+                   unsigned char *out, size_t *outlen)
+{
+    DTLS_RECORD_LAYER *d = s->rlayer.d;
+    const DTLS1_CID_AEAD *key = NULL;
+    unsigned char nonce[EVP_MAX_IV_LENGTH], aad[DTLS1_CID_AAD_MAX];
+    unsigned char *p = out, *inner;
+    size_t hdr_len, inner_len = len + 1, aad_len;
+
+    /* Retransmissions use the keys of the previous epoch */
+    if (d->cid_write[0].ctx == s->enc_write_ctx)
+        key = &d->cid_write[0];
+    else if (d->cid_write[1].ctx == s->enc_write_ctx)
+        key = &d->cid_write[1];
+    if (key == NULL || key->ctx == NULL)
+        return 0;
+
+    *p++ = DTLS1_RT_TLS12_CID;
+    *p++ = s->version >> 8;
+    *p++ = s->version & 0xff;
+    s2n(d->w_epoch, p);
+    memcpy(p, &s->rlayer.write_sequence[2], 6);
+    p += 6;
+    memcpy(p, s->dtls_cid.peer_cid, s->dtls_cid.peer_cid_len);
+    p += s->dtls_cid.peer_cid_len;
+    s2n(key->eiv_len + inner_len + key->tag_len, p);
+    hdr_len = p - out;
+
+    if (!dtls1_cid_nonce(key, out + DTLS1_CID_SEQ_OFFSET, nonce))
+        return 0;
+    memcpy(p, out + DTLS1_CID_SEQ_OFFSET, key->eiv_len);
+    p += key->eiv_len;
+
+    inner = p;
+    memcpy(inner, buf, len);
+    inner[len] = (unsigned char)type;
+    aad_len = dtls1_cid_aad(aad, out, s->dtls_cid.peer_cid,
+                            s->dtls_cid.peer_cid_len, inner_len);
+    if (!dtls1_cid_crypt(key, s->enc_write_ctx, nonce, aad, aad_len,
+                         inner, inner_len, inner + inner_len))
+        return 0;
+
+    if (s->msg_callback)
+        s->msg_callback(1, 0, SSL3_RT_HEADER, out, hdr_len, s,
+                        s->msg_callback_arg);
+
+    *outlen = hdr_len + key->eiv_len + inner_len + key->tag_len;
+    return 1;
+}
+
+/*
+ * Decrypt the record |rr| with our CID, whose header is at |hdr|, and set
+ * its real content type. Returns 0 if the record is to be dropped.
+ */
+int dtls1_cid_open(SSL *s, SSL3_RECORD *rr, const unsigned char *hdr)
+{
+    const DTLS1_CID_AEAD *key = &s->rlayer.d->cid_read;
+    unsigned char nonce[EVP_MAX_IV_LENGTH], aad[DTLS1_CID_AAD_MAX];
+    unsigned char *inner;
+    size_t inner_len, aad_len;
+
+    if (key->ctx == NULL || key->ctx != s->enc_read_ctx
+            || rr->length < key->eiv_len + key->tag_len + 1)
+        return 0;
+
+    if (!dtls1_cid_nonce(key, key->eiv_len != 0 ? rr->input
+                                                : hdr + DTLS1_CID_SEQ_OFFSET,
+                         nonce))
+        return 0;
+    inner = rr->input + key->eiv_len;
+    inner_len = rr->length - key->eiv_len - key->tag_len;
+    aad_len = dtls1_cid_aad(aad, hdr, s->dtls_cid.cid, s->dtls_cid.cid_len,
+                            inner_len);
+    if (!dtls1_cid_crypt(key, s->enc_read_ctx, nonce, aad, aad_len,
+                         inner, inner_len, inner + inner_len))
+        return 0;
+
+    /* The content type is the last byte that is not padding */
+    while (inner_len > 0 && inner[inner_len - 1] == 0)
+        inner_len--;
+    if (inner_len == 0)
+        return 0;
+    rr->type = inner[--inner_len];
+    rr->data = rr->input = inner;
+    rr->length = inner_len;
+    return 1;
+}
@@ -189,7 +189,7 @@ int dtls1_buffer_record(SSL *s, record_pqueue *queue, unsigned char *priority)
     }
 
     if (pqueue_insert(queue->q, item) == NULL) {
-        /* Must be a duplicate so ignore it */
+        /* A duplicate, or out of memory: drop the record either way */
         OPENSSL_free(rdata->rbuf.buf);
         OPENSSL_free(rdata);
         pitem_free(item);
@@ -854,6 +854,20 @@ int do_dtls1_write(SSL *s, int type, const unsigned char *buf,
         }
     }
 
+    if (s->enc_write_ctx != NULL && DTLS_CID_SENDING(s)) {
+        if (!dtls1_cid_seal(s, type, buf, len,
+                            SSL3_BUFFER_get_buf(wb) + prefix_len,
+                            &wr.length)) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_DO_DTLS1_WRITE,
+                     ERR_R_INTERNAL_ERROR);
+            return -1;
+        }
+        SSL3_RECORD_set_type(&wr, type);
+        ssl_rec_stats_add(s, SSL_REC_STAT_RECORDS_OUT, 1);
+        ssl_rec_stats_add(s, SSL_REC_STAT_ENCRYPTS, 1);
+        goto sealed;
+    }
+
     p = SSL3_BUFFER_get_buf(wb) + prefix_len;
 
     /* write the header */
@@ -949,6 +963,9 @@ int do_dtls1_write(SSL *s, int type, const unsigned char *buf,
         }
         return -1;
     }
+    ssl_rec_stats_add(s, SSL_REC_STAT_RECORDS_OUT, 1);
+    if (s->enc_write_ctx != NULL)
+        ssl_rec_stats_add(s, SSL_REC_STAT_ENCRYPTS, 1);
 
     if (SSL_WRITE_ETM(s) && mac_size != 0) {
         if (!s->method->ssl3_enc->mac(s, &wr,
@@ -981,6 +998,7 @@ int do_dtls1_write(SSL *s, int type, const unsigned char *buf,
     SSL3_RECORD_set_type(&wr, type); /* not needed but helps for debugging */
     SSL3_RECORD_add_length(&wr, DTLS1_RT_HEADER_LENGTH);
 
+ sealed:
     ssl3_record_sequence_update(&(s->rlayer.write_sequence[0]));
 
     if (create_empty_fragment) {
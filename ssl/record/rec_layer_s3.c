@@ -17,6 +17,8 @@
 #include "record_local.h"
 #include "../packet_local.h"
 #include "internal/cryptlib.h"
+#include "internal/ktls.h"
+#include "internal/bio.h"
 
 #if     defined(OPENSSL_SMALL_FOOTPRINT) || \
         !(      defined(AESNI_ASM) &&   ( \
@@ -53,6 +55,11 @@ void RECORD_LAYER_clear(RECORD_LAYER *rl)
     rl->wpend_type = 0;
     rl->wpend_ret = 0;
     rl->wpend_buf = NULL;
+    rl->wiov = NULL;
+    rl->wiovcnt = 0;
+    OPENSSL_clear_free(rl->cork_buf, SSL3_RT_MAX_PLAIN_LENGTH);
+    rl->cork_buf = NULL;
+    rl->cork_len = 0;
 
     SSL3_BUFFER_clear(&rl->rbuf);
     ssl3_release_write_buffer(rl->s);
@@ -72,6 +79,10 @@ void RECORD_LAYER_release(RECORD_LAYER *rl)
         ssl3_release_read_buffer(rl->s);
     if (rl->numwpipes > 0)
         ssl3_release_write_buffer(rl->s);
+    ssl3_zerocopy_free(rl);
+    OPENSSL_clear_free(rl->cork_buf, SSL3_RT_MAX_PLAIN_LENGTH);
+    rl->cork_buf = NULL;
+    rl->cork_len = 0;
     SSL3_RECORD_release(rl->rrec, SSL_MAX_PIPELINES);
 }
 
@@ -99,6 +110,42 @@ int RECORD_LAYER_write_pending(const RECORD_LAYER *rl)
         && SSL3_BUFFER_get_left(&rl->wbuf[rl->numwpipes - 1]) != 0;
 }
 
+/*
+ * Takes the next |len| bytes of handshake data straight from the read buffer
+ * when the current record holds all of them, instead of having
+ * ssl3_read_bytes() copy them. |*data| stays valid until the next read.
+ * Returns 0 if the data has to be read with ssl3_read_bytes().
+ */
+int RECORD_LAYER_get_handshake_data(RECORD_LAYER *rl, size_t len,
+                                    const unsigned char **data)
+{
+    SSL3_RECORD *rr = rl->rrec;
+    size_t curr_rec = 0, num_recs = RECORD_LAYER_get_numrpipes(rl);
+
+    if (len == 0 || rl->handshake_fragment_len > 0
+            || (rl->s->shutdown & SSL_RECEIVED_SHUTDOWN) != 0)
+        return 0;
+
+    while (curr_rec < num_recs && SSL3_RECORD_is_read(&rr[curr_rec]))
+        curr_rec++;
+    if (curr_rec == num_recs)
+        return 0;
+    rr = &rr[curr_rec];
+    if (SSL3_RECORD_get_type(rr) != SSL3_RT_HANDSHAKE
+            || SSL3_RECORD_get_length(rr) < len)
+        return 0;
+
+    *data = &rr->data[rr->off];
+    SSL3_RECORD_sub_length(rr, len);
+    SSL3_RECORD_add_off(rr, len);
+    if (SSL3_RECORD_get_length(rr) == 0) {
+        rl->rstate = SSL_ST_READ_HEADER;
+        SSL3_RECORD_set_off(rr, 0);
+        SSL3_RECORD_set_read(rr);
+    }
+    return 1;
+}
+
 void RECORD_LAYER_reset_read_sequence(RECORD_LAYER *rl)
 {
     memset(rl->read_sequence, 0, sizeof(rl->read_sequence));
@@ -215,7 +262,7 @@ int ssl3_read_n(SSL *s, size_t n, size_t max, int extend, int clearold,
         /* start with empty packet ... */
         if (left == 0)
             rb->offset = align;
-        else if (align != 0 && left >= SSL3_RT_HEADER_LENGTH) {
+        else if (align != 0 && left >= SSL3_RT_HEADER_LENGTH && clearold) {
             /*
              * check if next packet length is large enough to justify payload
              * alignment...
@@ -316,6 +363,8 @@ int ssl3_read_n(SSL *s, size_t n, size_t max, int extend, int clearold,
         }
 
         if (ret <= 0) {
+            if (s->rbio != NULL && BIO_should_retry(s->rbio))
+                ssl_rec_stats_add(s, SSL_REC_STAT_WANT_READ, 1);
             rb->left = left;
             if (s->mode & SSL_MODE_RELEASE_BUFFERS && !SSL_IS_DTLS(s))
                 if (len + left == 0)
@@ -323,6 +372,7 @@ int ssl3_read_n(SSL *s, size_t n, size_t max, int extend, int clearold,
             return ret;
         }
         left += bioread;
+        ssl_rec_stats_add(s, SSL_REC_STAT_BYTES_IN, bioread);
         /*
          * reads should *never* span multiple packets for DTLS because the
          * underlying transport protocol is message oriented as opposed to
@@ -343,9 +393,101 @@ int ssl3_read_n(SSL *s, size_t n, size_t max, int extend, int clearold,
     return 1;
 }
 
+/*
+ * Position the SSL_writev_ex() cursor at byte |pos| of the data
+ */
+static void ssl3_wiov_seek(RECORD_LAYER *rl, size_t pos)
+{
+    rl->wiov_idx = 0;
+    while (rl->wiov_idx < rl->wiovcnt && pos >= rl->wiov[rl->wiov_idx].len) {
+        pos -= rl->wiov[rl->wiov_idx].len;
+        rl->wiov_idx++;
+    }
+    rl->wiov_off = pos;
+}
+
+/*
+ * Copy the next |len| bytes of the SSL_writev_ex() data to |out| and advance
+ * the cursor. Returns 0 if the segments hold fewer bytes.
+ */
+static int ssl3_wiov_copy(RECORD_LAYER *rl, unsigned char *out, size_t len)
+{
+    while (len > 0) {
+        const SSL_IOVEC *v;
+        size_t n;
+
+        if (rl->wiov_idx >= rl->wiovcnt)
+            return 0;
+        v = &rl->wiov[rl->wiov_idx];
+        n = v->len - rl->wiov_off;
+        if (n > len)
+            n = len;
+        memcpy(out, (const unsigned char *)v->base + rl->wiov_off, n);
+        out += n;
+        len -= n;
+        rl->wiov_off += n;
+        if (rl->wiov_off == v->len) {
+            rl->wiov_idx++;
+            rl->wiov_off = 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Start an application data write with dynamic record sizing. Sizing starts
+ * over with small records if the connection has been idle for too long.
+ */
+static void ssl3_dynrec_start(SSL *s)
+{
+    struct timeval now;
+    long idle;
+
+    /* The kernel decides on the record sizes with kTLS */
+    if (s->dynrec_size == 0 || BIO_get_ktls_send(s->wbio)) {
+        s->dynrec_cur = 0;
+        return;
+    }
+
+    ssl_get_current_time(&now);
+    if (s->dynrec_cur != 0) {
+        idle = (long)(now.tv_sec - s->dynrec_last.tv_sec) * 1000
+               + (long)(now.tv_usec - s->dynrec_last.tv_usec) / 1000;
+        if (idle > 0 && (unsigned long)idle > s->dynrec_idle)
+            s->dynrec_cur = 0;
+    }
+    if (s->dynrec_cur == 0) {
+        s->dynrec_cur = s->dynrec_size;
+        s->dynrec_count = 0;
+    }
+    s->dynrec_last = now;
+}
+
+/*
+ * Account for |numrecs| application data records written at the current
+ * dynamic record size, which doubles every |dynrec_ramp| records
+ */
+static void ssl3_dynrec_written(SSL *s, size_t numrecs)
+{
+    if (s->dynrec_cur == 0 || s->dynrec_cur >= SSL3_RT_MAX_PLAIN_LENGTH)
+        return;
+
+    s->dynrec_count += numrecs;
+    while (s->dynrec_count >= s->dynrec_ramp
+           && s->dynrec_cur < SSL3_RT_MAX_PLAIN_LENGTH) {
+        s->dynrec_count -= s->dynrec_ramp;
+        s->dynrec_cur *= 2;
+        if (s->dynrec_cur > SSL3_RT_MAX_PLAIN_LENGTH)
+            s->dynrec_cur = SSL3_RT_MAX_PLAIN_LENGTH;
+    }
+}
+
 /*
  * Call this to write data in records of type 'type' It will return <= 0 if
  * not all data has been sent or non-blocking IO.
+ *
+ * A NULL |buf_| writes the SSL_writev_ex() segments in s->rlayer.wiov, which
+ * are packed into records without being made contiguous first.
  */
 int ssl3_write_bytes(SSL *s, int type, const void *buf_, size_t len,
                      size_t *written)
@@ -409,14 +551,17 @@ int ssl3_write_bytes(SSL *s, int type, const void *buf_, size_t len,
         }
     }
 
+    if (type == SSL3_RT_APPLICATION_DATA)
+        ssl3_dynrec_start(s);
+
     /*
      * first check if there is a SSL3_BUFFER still being written out.  This
      * will happen with non blocking IO
      */
     if (wb->left != 0) {
         /* SSLfatal() already called if appropriate */
-        i = ssl3_write_pending(s, type, &buf[tot], s->rlayer.wpend_tot,
-                               &tmpwrit);
+        i = ssl3_write_pending(s, type, buf != NULL ? &buf[tot] : NULL,
+                               s->rlayer.wpend_tot, &tmpwrit);
         if (i <= 0) {
             /* XXX should we ssl3_release_write_buffer if i<0? */
             s->rlayer.wnum = tot;
@@ -431,8 +576,9 @@ int ssl3_write_bytes(SSL *s, int type, const void *buf_, size_t len,
      * jumbo buffer to accommodate up to 8 records, but the
      * compromise is considered worthy.
      */
-    if (type == SSL3_RT_APPLICATION_DATA &&
+    if (type == SSL3_RT_APPLICATION_DATA && buf != NULL &&
         len >= 4 * (max_send_fragment = ssl_get_max_send_fragment(s)) &&
+        (s->dynrec_cur == 0 || s->dynrec_cur >= max_send_fragment) &&
         s->compress == NULL && s->msg_callback == NULL &&
         !SSL_WRITE_ETM(s) && SSL_USE_EXPLICIT_IV(s) &&
         EVP_CIPHER_flags(EVP_CIPHER_CTX_cipher(s->enc_write_ctx)) &
@@ -564,6 +710,8 @@ int ssl3_write_bytes(SSL *s, int type, const void *buf_, size_t len,
     }
 
     n = (len - tot);
+    if (buf == NULL)
+        ssl3_wiov_seek(&s->rlayer, tot);
 
     max_send_fragment = ssl_get_max_send_fragment(s);
     split_send_fragment = ssl_get_split_send_fragment(s);
@@ -603,21 +751,30 @@ int ssl3_write_bytes(SSL *s, int type, const void *buf_, size_t len,
     for (;;) {
         size_t pipelens[SSL_MAX_PIPELINES], tmppipelen, remain;
         size_t numpipes, j;
+        size_t frag = max_send_fragment, split = split_send_fragment;
+
+        /* Smaller records while dynamic record sizing ramps up */
+        if (type == SSL3_RT_APPLICATION_DATA && s->dynrec_cur != 0
+                && s->dynrec_cur < frag) {
+            frag = s->dynrec_cur;
+            if (split > frag)
+                split = frag;
+        }
 
         if (n == 0)
             numpipes = 1;
         else
-            numpipes = ((n - 1) / split_send_fragment) + 1;
+            numpipes = ((n - 1) / split) + 1;
         if (numpipes > maxpipes)
             numpipes = maxpipes;
 
-        if (n / numpipes >= max_send_fragment) {
+        if (n / numpipes >= frag) {
             /*
              * We have enough data to completely fill all available
              * pipelines
              */
             for (j = 0; j < numpipes; j++) {
-                pipelens[j] = max_send_fragment;
+                pipelens[j] = frag;
             }
         } else {
             /* We can partially fill all available pipelines */
@@ -630,14 +787,16 @@ int ssl3_write_bytes(SSL *s, int type, const void *buf_, size_t len,
             }
         }
 
-        i = do_ssl3_write(s, type, &(buf[tot]), pipelens, numpipes, 0,
-                          &tmpwrit);
+        i = do_ssl3_write(s, type, buf != NULL ? &(buf[tot]) : NULL,
+                          pipelens, numpipes, 0, &tmpwrit);
         if (i <= 0) {
             /* SSLfatal() already called if appropriate */
             /* XXX should we ssl3_release_write_buffer if i<0? */
             s->rlayer.wnum = tot;
             return i;
         }
+        if (type == SSL3_RT_APPLICATION_DATA)
+            ssl3_dynrec_written(s, numpipes);
 
         if (tmpwrit == n ||
             (type == SSL3_RT_APPLICATION_DATA &&
@@ -662,6 +821,117 @@ int ssl3_write_bytes(SSL *s, int type, const void *buf_, size_t len,
     }
 }
 
+/*
+ * The number of bytes SSL_MODE_CORK collects before writing them out, by
+ * default as many as fit in a record
+ */
+static size_t ssl3_cork_threshold(SSL *s)
+{
+    if (s->cork_threshold != 0)
+        return s->cork_threshold;
+    return ssl_get_max_send_fragment(s);
+}
+
+/*
+ * Whether an application data write of |len| bytes may be held back. Writes
+ * during a handshake, of early data or that a KeyUpdate must precede go out
+ * straight away, as do writes of a full record or more and retries of a
+ * write that did.
+ */
+static int ssl3_corkable(SSL *s, size_t len, size_t threshold)
+{
+    return (s->mode & SSL_MODE_CORK) != 0
+        && !SSL_in_init(s)
+        && s->key_update == SSL_KEY_UPDATE_NONE
+        && s->early_data_state != SSL_EARLY_DATA_WRITING
+        && s->early_data_state != SSL_EARLY_DATA_UNAUTH_WRITING
+        && (s->rlayer.cork_len > 0 || !RECORD_LAYER_write_pending(&s->rlayer))
+        && len < threshold;
+}
+
+/*
+ * Writes application data with SSL_MODE_CORK, which DTLS doesn't use. Small
+ * writes are copied after the data held back so far, which goes out once a
+ * full record's worth has been collected, or before a write that doesn't fit
+ * or can't be held back. A NULL |buf| takes the SSL_writev_ex() segments like
+ * ssl3_write_bytes().
+ */
+int ssl3_write_corked(SSL *s, const void *buf, size_t len, size_t *written)
+{
+    RECORD_LAYER *rl = &s->rlayer;
+    size_t threshold = ssl3_cork_threshold(s);
+    int corkable = ssl3_corkable(s, len, threshold);
+    int ret;
+
+    /* A flush of the held back data that is pending must complete first */
+    if (rl->cork_len > 0
+            && (!corkable || rl->cork_len + len > threshold
+                || RECORD_LAYER_write_pending(rl))) {
+        ret = ssl3_uncork(s);
+        if (ret <= 0)
+            return ret;
+    }
+
+    if (!corkable)
+        return ssl3_write_bytes(s, SSL3_RT_APPLICATION_DATA, buf, len,
+                                written);
+
+    if (rl->cork_buf == NULL
+            && (rl->cork_buf = OPENSSL_malloc(SSL3_RT_MAX_PLAIN_LENGTH))
+               == NULL) {
+        SSLerr(SSL_F_SSL3_WRITE_CORKED, ERR_R_MALLOC_FAILURE);
+        return -1;
+    }
+    if (buf != NULL) {
+        memcpy(rl->cork_buf + rl->cork_len, buf, len);
+    } else {
+        ssl3_wiov_seek(rl, 0);
+        if (!ssl3_wiov_copy(rl, rl->cork_buf + rl->cork_len, len)) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL3_WRITE_CORKED,
+                     ERR_R_INTERNAL_ERROR);
+            return -1;
+        }
+    }
+    rl->cork_len += len;
+    *written = len;
+
+    /*
+     * The data has been taken, so a full record that can't be written right
+     * now is left for the next call to finish rather than written again
+     */
+    if (rl->cork_len >= threshold && ssl3_uncork(s) <= 0
+            && ossl_statem_in_error(s))
+        return -1;
+    return 1;
+}
+
+/*
+ * Writes out the application data held back by SSL_MODE_CORK. Returns 1 once
+ * all of it is gone, and otherwise the result of ssl3_write_bytes(), after
+ * which this must be called again.
+ */
+int ssl3_uncork(SSL *s)
+{
+    RECORD_LAYER *rl = &s->rlayer;
+    size_t written;
+    int ret;
+
+    while (rl->cork_len > 0) {
+        ret = ssl3_write_bytes(s, SSL3_RT_APPLICATION_DATA, rl->cork_buf,
+                               rl->cork_len, &written);
+        if (ret <= 0)
+            return ret;
+        /* SSL_MODE_ENABLE_PARTIAL_WRITE returns after each record */
+        rl->cork_len -= written;
+        memmove(rl->cork_buf, rl->cork_buf + written, rl->cork_len);
+    }
+    if (s->mode & SSL_MODE_RELEASE_BUFFERS) {
+        OPENSSL_clear_free(rl->cork_buf, SSL3_RT_MAX_PLAIN_LENGTH);
+        rl->cork_buf = NULL;
+    }
+    return 1;
+}
+
 int do_ssl3_write(SSL *s, int type, const unsigned char *buf,
                   size_t *pipelens, size_t numpipes,
                   int create_empty_fragment, size_t *written)
@@ -679,6 +949,7 @@ int do_ssl3_write(SSL *s, int type, const unsigned char *buf,
     SSL_SESSION *sess;
     size_t totlen = 0, len, wpinited = 0;
     size_t j;
+    unsigned char *gather = NULL;
 
     for (j = 0; j < numpipes; j++)
         totlen += pipelens[j];
@@ -701,6 +972,57 @@ int do_ssl3_write(SSL *s, int type, const unsigned char *buf,
         /* if it went, fall through and send more stuff */
     }
 
+#ifndef OPENSSL_NO_KTLS
+    if (BIO_get_ktls_send(s->wbio)) {
+        /*
+         * The kernel frames and encrypts the record itself, so the plaintext
+         * is handed over straight from the caller's buffer.
+         */
+        if (numpipes != 1 || create_empty_fragment) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_DO_SSL3_WRITE,
+                     ERR_R_INTERNAL_ERROR);
+            return -1;
+        }
+        if (totlen == 0)
+            return 0;
+
+        wb = &s->rlayer.wbuf[0];
+        if (buf == NULL) {
+            /* Scattered data still has to be gathered into one write */
+            if (SSL3_BUFFER_is_app_buffer(wb))
+                ssl3_release_write_buffer(s);
+            if (s->rlayer.numwpipes < 1
+                    && !ssl3_setup_write_buffer(s, 1, 0)) {
+                /* SSLfatal() already called */
+                return -1;
+            }
+            if (!ossl_assert(totlen <= SSL3_BUFFER_get_len(wb))
+                    || !ssl3_wiov_copy(&s->rlayer, SSL3_BUFFER_get_buf(wb),
+                                       totlen)) {
+                SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_DO_SSL3_WRITE,
+                         ERR_R_INTERNAL_ERROR);
+                return -1;
+            }
+        } else {
+            if (!SSL3_BUFFER_is_app_buffer(wb))
+                ssl3_release_write_buffer(s);
+            s->rlayer.numwpipes = 1;
+            SSL3_BUFFER_set_buf(wb, (unsigned char *)buf);
+            SSL3_BUFFER_set_app_buffer(wb, 1);
+            SSL3_BUFFER_set_len(wb, totlen);
+        }
+        SSL3_BUFFER_set_offset(wb, 0);
+        SSL3_BUFFER_set_left(wb, totlen);
+
+        s->rlayer.wpend_tot = totlen;
+        s->rlayer.wpend_buf = buf;
+        s->rlayer.wpend_type = type;
+        s->rlayer.wpend_ret = totlen;
+
+        return ssl3_write_pending(s, type, buf, totlen, written);
+    }
+#endif
+
     if (s->rlayer.numwpipes < numpipes) {
         if (!ssl3_setup_write_buffer(s, numpipes, 0)) {
             /* SSLfatal() already called */
@@ -891,7 +1213,8 @@ int do_ssl3_write(SSL *s, int type, const unsigned char *buf,
         /* lets setup the record stuff. */
         SSL3_RECORD_set_data(thiswr, compressdata);
         SSL3_RECORD_set_length(thiswr, pipelens[j]);
-        SSL3_RECORD_set_input(thiswr, (unsigned char *)&buf[totlen]);
+        if (buf != NULL)
+            SSL3_RECORD_set_input(thiswr, (unsigned char *)&buf[totlen]);
         totlen += pipelens[j];
 
         /*
@@ -901,12 +1224,41 @@ int do_ssl3_write(SSL *s, int type, const unsigned char *buf,
 
         /* first we compress */
         if (s->compress != NULL) {
+            if (buf == NULL) {
+                /* The compressor needs its input in one piece */
+                gather = OPENSSL_malloc(thiswr->length);
+                if (gather == NULL
+                        || !ssl3_wiov_copy(&s->rlayer, gather,
+                                           thiswr->length)) {
+                    SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_DO_SSL3_WRITE,
+                             ERR_R_MALLOC_FAILURE);
+                    goto err;
+                }
+                SSL3_RECORD_set_input(thiswr, gather);
+            }
             if (!ssl3_do_compress(s, thiswr)
                     || !WPACKET_allocate_bytes(thispkt, thiswr->length, NULL)) {
                 SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_DO_SSL3_WRITE,
                          SSL_R_COMPRESSION_FAILURE);
                 goto err;
             }
+            OPENSSL_free(gather);
+            gather = NULL;
+        } else if (buf == NULL) {
+            /*
+             * Gather the segments straight into the record, this is the only
+             * copy of the plaintext we make
+             */
+            unsigned char *data;
+
+            if (thiswr->length > 0
+                    && (!WPACKET_allocate_bytes(thispkt, thiswr->length, &data)
+                        || !ssl3_wiov_copy(&s->rlayer, data,
+                                           thiswr->length))) {
+                SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_DO_SSL3_WRITE,
+                         ERR_R_INTERNAL_ERROR);
+                goto err;
+            }
         } else {
             if (!WPACKET_memcpy(thispkt, thiswr->input, thiswr->length)) {
                 SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_DO_SSL3_WRITE,
@@ -1032,6 +1384,9 @@ int do_ssl3_write(SSL *s, int type, const unsigned char *buf,
             goto err;
         }
     }
+    ssl_rec_stats_add(s, SSL_REC_STAT_RECORDS_OUT, numpipes);
+    if (s->enc_write_ctx != NULL)
+        ssl_rec_stats_add(s, SSL_REC_STAT_ENCRYPTS, numpipes);
 
     for (j = 0; j < numpipes; j++) {
         size_t origlen;
@@ -1133,6 +1488,7 @@ int do_ssl3_write(SSL *s, int type, const unsigned char *buf,
     /* we now just need to write the buffer */
     return ssl3_write_pending(s, type, buf, totlen, written);
  err:
+    OPENSSL_free(gather);
     for (j = 0; j < wpinited; j++)
         WPACKET_cleanup(&pkt[j]);
     return -1;
@@ -1159,16 +1515,44 @@ int ssl3_write_pending(SSL *s, int type, const unsigned char *buf, size_t len,
         return -1;
     }
 
+    /*
+     * A pending kTLS record still points into the caller's buffer, which may
+     * have moved by now (SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER)
+     */
+    if (SSL3_BUFFER_is_app_buffer(&wb[0]))
+        SSL3_BUFFER_set_buf(&wb[0], (unsigned char *)buf);
+
     for (;;) {
         /* Loop until we find a buffer we haven't written out yet */
-        if (SSL3_BUFFER_get_left(&wb[currbuf]) == 0
-            && currbuf < s->rlayer.numwpipes - 1) {
-            currbuf++;
-            continue;
+        if (SSL3_BUFFER_get_left(&wb[currbuf]) == 0) {
+            if (currbuf < s->rlayer.numwpipes - 1) {
+                currbuf++;
+                continue;
+            }
+            /* This write used fewer pipes than there are buffers */
+            if (currbuf > 0) {
+                s->rwstate = SSL_NOTHING;
+                *written = s->rlayer.wpend_ret;
+                return 1;
+            }
         }
         clear_sys_error();
         if (s->wbio != NULL) {
             s->rwstate = SSL_WRITING;
+#ifndef OPENSSL_NO_KTLS
+            /*
+             * Anything but application data has to be sent as a record of its
+             * own, so nothing buffered may be coalesced with it.
+             */
+            if (type != SSL3_RT_APPLICATION_DATA
+                    && BIO_get_ktls_send(s->wbio)) {
+                ssl_rec_stats_add(s, SSL_REC_STAT_FLUSHES, 1);
+                i = BIO_flush(s->wbio);
+                if (i <= 0)
+                    return i;
+                BIO_set_ktls_ctrl_msg(s->wbio, type);
+            }
+#endif
             /* TODO(size_t): Convert this call */
             i = BIO_write(s->wbio, (char *)
                           &(SSL3_BUFFER_get_buf(&wb[currbuf])
@@ -1176,6 +1560,15 @@ int ssl3_write_pending(SSL *s, int type, const unsigned char *buf, size_t len,
                           (unsigned int)SSL3_BUFFER_get_left(&wb[currbuf]));
             if (i >= 0)
                 tmpwrit = i;
+            if (i > 0) {
+                ssl_rec_stats_add(s, SSL_REC_STAT_BYTES_OUT, tmpwrit);
+                if (tmpwrit < SSL3_BUFFER_get_left(&wb[currbuf]))
+                    ssl_rec_stats_add(s, SSL_REC_STAT_PARTIAL_WRITES, 1);
+            } else if (BIO_should_retry(s->wbio)) {
+                ssl_rec_stats_add(s, SSL_REC_STAT_WANT_WRITE, 1);
+            }
+            if (i > 0 && BIO_test_flags(s->wbio, BIO_FLAGS_ZEROCOPY))
+                ssl3_zerocopy_note_write(s, &wb[currbuf]);
         } else {
             SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL3_WRITE_PENDING,
                      SSL_R_BIO_NOT_SET);
@@ -1184,6 +1577,9 @@ int ssl3_write_pending(SSL *s, int type, const unsigned char *buf, size_t len,
         if (i > 0 && tmpwrit == SSL3_BUFFER_get_left(&wb[currbuf])) {
             SSL3_BUFFER_set_left(&wb[currbuf], 0);
             SSL3_BUFFER_add_offset(&wb[currbuf], tmpwrit);
+            if (wb[currbuf].zerocopy
+                    && !ssl3_zerocopy_retire_write_buffer(s, &wb[currbuf]))
+                return -1;
             if (currbuf + 1 < s->rlayer.numwpipes)
                 continue;
             s->rwstate = SSL_NOTHING;
@@ -1317,7 +1713,17 @@ int ssl3_read_bytes(SSL *s, int type, int *recvd_type, unsigned char *buf,
     do {
         /* get new records if necessary */
         if (num_recs == 0) {
+            /*
+             * Application data that is read, not peeked at, may be
+             * decrypted directly into |buf|
+             */
+            if (type == SSL3_RT_APPLICATION_DATA && !peek) {
+                s->rlayer.rdirect = buf;
+                s->rlayer.rdirect_len = len;
+            }
             ret = ssl3_get_record(s);
+            s->rlayer.rdirect = NULL;
+            s->rlayer.rdirect_len = 0;
             if (ret <= 0) {
                 /* SSLfatal() already called if appropriate */
                 return ret;
@@ -1427,7 +1833,9 @@ int ssl3_read_bytes(SSL *s, int type, int *recvd_type, unsigned char *buf,
             else
                 n = len - totalbytes;
 
-            memcpy(buf, &(rr->data[rr->off]), n);
+            /* Unless it was decrypted in place by ssl3_get_record() */
+            if (&rr->data[rr->off] != buf)
+                memcpy(buf, &(rr->data[rr->off]), n);
             buf += n;
             if (peek) {
                 /* Mark any zero length record as consumed CVE-2016-6305 */
@@ -1449,7 +1857,8 @@ int ssl3_read_bytes(SSL *s, int type, int *recvd_type, unsigned char *buf,
             }
             totalbytes += n;
         } while (type == SSL3_RT_APPLICATION_DATA && curr_rec < num_recs
-                 && totalbytes < len);
+                 && totalbytes < len
+                 && SSL3_RECORD_get_type(rr) == SSL3_RT_APPLICATION_DATA);
         if (totalbytes == 0) {
             /* We must have read empty records. Get more data */
             goto start;
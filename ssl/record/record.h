@@ -25,8 +25,21 @@ typedef struct ssl3_buffer_st {
     size_t offset;
     /* how many bytes left */
     size_t left;
+    /* buf is owned by the caller of SSL_write() and must not be freed */
+    int app_buffer;
+    /* a MSG_ZEROCOPY send may still be reading buf */
+    int zerocopy;
 } SSL3_BUFFER;
 
+/* A write buffer parked until the wbio reports its zerocopy send done */
+typedef struct ssl3_zerocopy_buffer_st {
+    struct ssl3_zerocopy_buffer_st *next;
+    unsigned char *buf;
+    size_t len;
+    /* free once this many zerocopy sends have completed */
+    uint32_t id;
+} SSL3_ZEROCOPY_BUFFER;
+
 #define SEQ_NUM_SIZE                            8
 
 typedef struct ssl3_record_st {
@@ -68,9 +81,14 @@ typedef struct ssl3_record_st {
     unsigned char seq_num[SEQ_NUM_SIZE];
 } SSL3_RECORD;
 
+/* Replay window used unless DTLS_set_replay_window() was called */
+#define DTLS1_DEFAULT_REPLAY_WINDOW     64
+
 typedef struct dtls1_bitmap_st {
-    /* Track 32 packets on 32-bit systems and 64 - on 64-bit systems */
-    unsigned long map;
+    /* Ring of the records received in the window, see dtls1_bitmap.c */
+    uint64_t map[DTLS1_MAX_REPLAY_WINDOW / 64 + 1];
+    /* Size of the window in records, 0 until the first record */
+    size_t window;
     /* Max record number seen so far, 64-bit value in big-endian encoding */
     unsigned char max_seq_num[SEQ_NUM_SIZE];
 } DTLS1_BITMAP;
@@ -90,6 +108,21 @@ typedef struct dtls1_record_data_st {
 #endif
 } DTLS1_RECORD_DATA;
 
+/*
+ * Protection of DTLS records with a connection ID, see dtls1_cid.c. These
+ * are sealed with the generic AEAD interface of |ctx|, which needs the
+ * fixed part of the nonce, so that is kept here.
+ */
+typedef struct dtls1_cid_aead_st {
+    /* The cipher context of the epoch, NULL if it is not an AEAD */
+    const EVP_CIPHER_CTX *ctx;
+    unsigned char iv[EVP_MAX_IV_LENGTH];
+    size_t iv_len;
+    /* Explicit nonce sent in each record, 0 if the record number is used */
+    size_t eiv_len;
+    size_t tag_len;
+} DTLS1_CID_AEAD;
+
 typedef struct dtls_record_layer_st {
     /*
      * The current data and handshake epoch.  This is initially
@@ -114,6 +147,9 @@ typedef struct dtls_record_layer_st {
     /* save last and current sequence numbers for retransmissions */
     unsigned char last_write_sequence[8];
     unsigned char curr_write_sequence[8];
+    DTLS1_CID_AEAD cid_read;
+    /* The current and the previous epoch, which is kept for retransmission */
+    DTLS1_CID_AEAD cid_write[2];
 } DTLS_RECORD_LAYER;
 
 /*****************************************************************************
@@ -160,6 +196,36 @@ typedef struct record_layer_st {
     /* number of bytes submitted */
     size_t wpend_ret;
     const unsigned char *wpend_buf;
+    /*
+     * Data of an SSL_writev_ex() call, written with a NULL buffer. Records
+     * are gathered from the segments, the cursor is the next segment and
+     * the offset within it.
+     */
+    const SSL_IOVEC *wiov;
+    size_t wiovcnt;
+    size_t wiov_idx;
+    size_t wiov_off;
+    /*
+     * Application data held back by SSL_MODE_CORK, and its length. The buffer
+     * holds SSL3_RT_MAX_PLAIN_LENGTH bytes.
+     */
+    unsigned char *cork_buf;
+    size_t cork_len;
+    /*
+     * Buffer of an SSL_read_ex() call that a TLSv1.3 application data record
+     * may be decrypted into directly, and its length
+     */
+    unsigned char *rdirect;
+    size_t rdirect_len;
+    /*
+     * Write buffers that MSG_ZEROCOPY sends on |zerocopy_bio| may still be
+     * reading, oldest first, and that BIO's zerocopy send count as last seen
+     */
+    SSL3_ZEROCOPY_BUFFER *zerocopy_head;
+    SSL3_ZEROCOPY_BUFFER *zerocopy_tail;
+    size_t zerocopy_count;
+    BIO *zerocopy_bio;
+    uint32_t zerocopy_sent;
     unsigned char read_sequence[SEQ_NUM_SIZE];
     unsigned char write_sequence[SEQ_NUM_SIZE];
     /* Set to true if this is the first record in a connection */
@@ -197,6 +263,8 @@ void RECORD_LAYER_release(RECORD_LAYER *rl);
 int RECORD_LAYER_read_pending(const RECORD_LAYER *rl);
 int RECORD_LAYER_processed_read_pending(const RECORD_LAYER *rl);
 int RECORD_LAYER_write_pending(const RECORD_LAYER *rl);
+__owur int RECORD_LAYER_get_handshake_data(RECORD_LAYER *rl, size_t len,
+                                           const unsigned char **data);
 void RECORD_LAYER_reset_read_sequence(RECORD_LAYER *rl);
 void RECORD_LAYER_reset_write_sequence(RECORD_LAYER *rl);
 int RECORD_LAYER_is_sslv2_record(RECORD_LAYER *rl);
@@ -204,6 +272,9 @@ size_t RECORD_LAYER_get_rrec_length(RECORD_LAYER *rl);
 __owur size_t ssl3_pending(const SSL *s);
 __owur int ssl3_write_bytes(SSL *s, int type, const void *buf, size_t len,
                             size_t *written);
+__owur int ssl3_write_corked(SSL *s, const void *buf, size_t len,
+                             size_t *written);
+int ssl3_uncork(SSL *s);
 int do_ssl3_write(SSL *s, int type, const unsigned char *buf,
                   size_t *pipelens, size_t numpipes,
                   int create_empty_fragment, size_t *written);
@@ -232,5 +303,7 @@ __owur int dtls1_write_bytes(SSL *s, int type, const void *buf, size_t len,
 int do_dtls1_write(SSL *s, int type, const unsigned char *buf,
                    size_t len, int create_empty_fragment, size_t *written);
 void dtls1_reset_seq_numbers(SSL *s, int rw);
+void dtls1_cid_set_key(SSL *s, int which, const EVP_CIPHER_CTX *ctx,
+                       const unsigned char *iv, size_t iv_len);
 int dtls_buffer_listen_record(SSL *s, size_t len, unsigned char *seq,
                               size_t off);
@@ -65,6 +65,8 @@ void dtls1_record_bitmap_update(SSL *s, DTLS1_BITMAP *bitmap);
 #define SSL3_BUFFER_add_offset(b, o)        ((b)->offset += (o))
 #define SSL3_BUFFER_is_initialised(b)       ((b)->buf != NULL)
 #define SSL3_BUFFER_set_default_len(b, l)   ((b)->default_len = (l))
+#define SSL3_BUFFER_is_app_buffer(b)        ((b)->app_buffer)
+#define SSL3_BUFFER_set_app_buffer(b, l)    ((b)->app_buffer = (l))
 
 void SSL3_BUFFER_clear(SSL3_BUFFER *b);
 void SSL3_BUFFER_set_data(SSL3_BUFFER *b, const unsigned char *d, size_t n);
@@ -73,6 +75,11 @@ __owur int ssl3_setup_read_buffer(SSL *s);
 __owur int ssl3_setup_write_buffer(SSL *s, size_t numwpipes, size_t len);
 int ssl3_release_read_buffer(SSL *s);
 int ssl3_release_write_buffer(SSL *s);
+void ssl3_zerocopy_note_write(SSL *s, SSL3_BUFFER *wb);
+int ssl3_zerocopy_park(SSL *s, unsigned char *buf, size_t len);
+__owur int ssl3_zerocopy_retire_write_buffer(SSL *s, SSL3_BUFFER *wb);
+void ssl3_zerocopy_reap(SSL *s);
+void ssl3_zerocopy_free(RECORD_LAYER *rl);
 
 /* Macros/functions provided by the SSL3_RECORD component */
 
@@ -112,5 +119,8 @@ __owur int tls1_cbc_remove_padding(const SSL *s,
                                    SSL3_RECORD *rec,
                                    size_t block_size, size_t mac_size);
 int dtls1_process_record(SSL *s, DTLS1_BITMAP *bitmap);
+__owur int dtls1_cid_seal(SSL *s, int type, const unsigned char *buf,
+                          size_t len, unsigned char *out, size_t *outlen);
+__owur int dtls1_cid_open(SSL *s, SSL3_RECORD *rr, const unsigned char *hdr);
 __owur int dtls1_get_record(SSL *s);
 int early_data_count_ok(SSL *s, size_t length, size_t overhead, int send);
@@ -10,6 +10,9 @@
 #include "../ssl_local.h"
 #include "record_local.h"
 
+/* Parked zerocopy buffers to collect before asking the wbio for progress */
+#define SSL3_ZEROCOPY_REAP_MIN  8
+
 void SSL3_BUFFER_set_data(SSL3_BUFFER *b, const unsigned char *d, size_t n)
 {
     if (d != NULL)
@@ -34,6 +37,94 @@ void SSL3_BUFFER_release(SSL3_BUFFER *b)
     b->buf = NULL;
 }
 
+/*
+ * Take a buffer of |len| bytes off the read (|for_read| != 0) or write
+ * freelist of |ctx|, or allocate one if there is none.
+ */
+unsigned char *ssl3_buf_freelist_extract(SSL_CTX *ctx, int for_read,
+                                         size_t len)
+{
+    SSL3_BUF_FREELIST *list;
+    SSL3_BUF_FREELIST_ENTRY *ent = NULL;
+
+    if (ctx != NULL && ctx->freelist_max_len > 0) {
+        list = for_read ? &ctx->rbuf_freelist : &ctx->wbuf_freelist;
+        CRYPTO_THREAD_write_lock(ctx->lock);
+        if (list->chunklen == len && list->head != NULL) {
+            ent = list->head;
+            list->head = ent->next;
+            list->len--;
+        }
+        CRYPTO_THREAD_unlock(ctx->lock);
+        if (ent != NULL)
+            return (unsigned char *)ent;
+    }
+    return OPENSSL_malloc(len);
+}
+
+/*
+ * Give the buffer |mem| of |len| bytes back to |ctx|. It is freed if the
+ * freelist is full or holds buffers of a different size.
+ */
+void ssl3_buf_freelist_insert(SSL_CTX *ctx, int for_read, unsigned char *mem,
+                              size_t len)
+{
+    SSL3_BUF_FREELIST *list;
+    SSL3_BUF_FREELIST_ENTRY *ent;
+
+    if (mem == NULL)
+        return;
+    if (ctx != NULL && ctx->freelist_max_len > 0
+            && len >= sizeof(SSL3_BUF_FREELIST_ENTRY)) {
+        list = for_read ? &ctx->rbuf_freelist : &ctx->wbuf_freelist;
+        CRYPTO_THREAD_write_lock(ctx->lock);
+        if (list->len == 0)
+            list->chunklen = len;
+        if (list->chunklen == len && list->len < ctx->freelist_max_len) {
+            ent = (SSL3_BUF_FREELIST_ENTRY *)mem;
+            ent->next = list->head;
+            list->head = ent;
+            list->len++;
+            mem = NULL;
+        }
+        CRYPTO_THREAD_unlock(ctx->lock);
+    }
+    OPENSSL_free(mem);
+}
+
+/* Free all but |max| buffers of |list|, |lock| must be held */
+static void ssl3_buf_freelist_trim(SSL3_BUF_FREELIST *list, size_t max)
+{
+    SSL3_BUF_FREELIST_ENTRY *ent;
+
+    while (list->len > max) {
+        ent = list->head;
+        list->head = ent->next;
+        list->len--;
+        OPENSSL_free(ent);
+    }
+}
+
+void ssl3_buf_freelists_free(SSL_CTX *ctx)
+{
+    ssl3_buf_freelist_trim(&ctx->rbuf_freelist, 0);
+    ssl3_buf_freelist_trim(&ctx->wbuf_freelist, 0);
+}
+
+void SSL_CTX_set_record_buffer_pool_size(SSL_CTX *ctx, size_t size)
+{
+    CRYPTO_THREAD_write_lock(ctx->lock);
+    ctx->freelist_max_len = size;
+    ssl3_buf_freelist_trim(&ctx->rbuf_freelist, size);
+    ssl3_buf_freelist_trim(&ctx->wbuf_freelist, size);
+    CRYPTO_THREAD_unlock(ctx->lock);
+}
+
+size_t SSL_CTX_get_record_buffer_pool_size(const SSL_CTX *ctx)
+{
+    return ctx->freelist_max_len;
+}
+
 int ssl3_setup_read_buffer(SSL *s)
 {
     unsigned char *p;
@@ -42,8 +133,9 @@ int ssl3_setup_read_buffer(SSL *s)
 
     b = RECORD_LAYER_get_rbuf(&s->rlayer);
 
+    /* Room for a connection ID and the real content type */
     if (SSL_IS_DTLS(s))
-        headerlen = DTLS1_RT_HEADER_LENGTH;
+        headerlen = DTLS1_RT_HEADER_LENGTH + DTLS1_MAX_CID_LENGTH + 1;
     else
         headerlen = SSL3_RT_HEADER_LENGTH;
 
@@ -60,7 +152,7 @@ int ssl3_setup_read_buffer(SSL *s)
 #endif
         if (b->default_len > len)
             len = b->default_len;
-        if ((p = OPENSSL_malloc(len)) == NULL) {
+        if ((p = ssl3_buf_freelist_extract(s->ctx, 1, len)) == NULL) {
             /*
              * We've got a malloc failure, and we're still initialising buffers.
              * We assume we're so doomed that we won't even be able to send an
@@ -72,6 +164,7 @@ int ssl3_setup_read_buffer(SSL *s)
         }
         b->buf = p;
         b->len = len;
+        ssl_rec_stats_add(s, SSL_REC_STAT_BUFFER_ALLOCS, 1);
     }
 
     return 1;
@@ -88,7 +181,7 @@ int ssl3_setup_write_buffer(SSL *s, size_t numwpipes, size_t len)
 
     if (len == 0) {
         if (SSL_IS_DTLS(s))
-            headerlen = DTLS1_RT_HEADER_LENGTH + 1;
+            headerlen = DTLS1_RT_HEADER_LENGTH + 1 + DTLS1_MAX_CID_LENGTH + 1;
         else
             headerlen = SSL3_RT_HEADER_LENGTH;
 
@@ -115,13 +208,15 @@ int ssl3_setup_write_buffer(SSL *s, size_t numwpipes, size_t len)
     for (currpipe = 0; currpipe < numwpipes; currpipe++) {
         SSL3_BUFFER *thiswb = &wb[currpipe];
 
-        if (thiswb->buf != NULL && thiswb->len != len) {
-            OPENSSL_free(thiswb->buf);
+        if (thiswb->buf != NULL && thiswb->app_buffer) {
+            thiswb->buf = NULL;         /* not ours to free */
+        } else if (thiswb->buf != NULL && thiswb->len != len) {
+            ssl3_buf_freelist_insert(s->ctx, 0, thiswb->buf, thiswb->len);
             thiswb->buf = NULL;         /* force reallocation */
         }
 
         if (thiswb->buf == NULL) {
-            p = OPENSSL_malloc(len);
+            p = ssl3_buf_freelist_extract(s->ctx, 0, len);
             if (p == NULL) {
                 s->rlayer.numwpipes = currpipe;
                 /*
@@ -136,6 +231,7 @@ int ssl3_setup_write_buffer(SSL *s, size_t numwpipes, size_t len)
             memset(thiswb, 0, sizeof(SSL3_BUFFER));
             thiswb->buf = p;
             thiswb->len = len;
+            ssl_rec_stats_add(s, SSL_REC_STAT_BUFFER_ALLOCS, 1);
         }
     }
 
@@ -164,20 +260,130 @@ int ssl3_release_write_buffer(SSL *s)
     while (pipes > 0) {
         wb = &RECORD_LAYER_get_wbuf(&s->rlayer)[pipes - 1];
 
-        OPENSSL_free(wb->buf);
+        if (wb->zerocopy)
+            (void)ssl3_zerocopy_park(s, wb->buf, wb->len);
+        else if (!SSL3_BUFFER_is_app_buffer(wb))
+            ssl3_buf_freelist_insert(s->ctx, 0, wb->buf, wb->len);
         wb->buf = NULL;
+        wb->zerocopy = 0;
+        SSL3_BUFFER_set_app_buffer(wb, 0);
         pipes--;
     }
     s->rlayer.numwpipes = 0;
     return 1;
 }
 
+/*
+ * Called after a write from |wb| to a MSG_ZEROCOPY wbio: if the write was
+ * sent zerocopy, the kernel reads the buffer until the send completes.
+ */
+void ssl3_zerocopy_note_write(SSL *s, SSL3_BUFFER *wb)
+{
+    RECORD_LAYER *rl = &s->rlayer;
+    uint32_t sent = BIO_get_zerocopy_sent(s->wbio);
+
+    if (rl->zerocopy_bio != s->wbio) {
+        /* Nothing to compare the count with: assume the worst */
+        ssl3_zerocopy_reap(s);
+        rl->zerocopy_bio = s->wbio;
+        wb->zerocopy = 1;
+    } else if (sent != rl->zerocopy_sent) {
+        wb->zerocopy = 1;
+    }
+    rl->zerocopy_sent = sent;
+}
+
+/*
+ * Keep |buf| away from the freelist until the zerocopy sends issued so far
+ * have completed. Without the memory to track it the buffer is leaked
+ * rather than risk it being rewritten under the send.
+ */
+int ssl3_zerocopy_park(SSL *s, unsigned char *buf, size_t len)
+{
+    RECORD_LAYER *rl = &s->rlayer;
+    SSL3_ZEROCOPY_BUFFER *zb;
+
+    if ((zb = OPENSSL_malloc(sizeof(*zb))) == NULL)
+        return 0;
+    zb->next = NULL;
+    zb->buf = buf;
+    zb->len = len;
+    zb->id = rl->zerocopy_sent;
+    if (rl->zerocopy_tail != NULL)
+        rl->zerocopy_tail->next = zb;
+    else
+        rl->zerocopy_head = zb;
+    rl->zerocopy_tail = zb;
+    rl->zerocopy_count++;
+    return 1;
+}
+
+/*
+ * Swap the buffer of |wb|, which has been written in full but is still
+ * referenced by a zerocopy send, for a fresh one of the same size.
+ */
+int ssl3_zerocopy_retire_write_buffer(SSL *s, SSL3_BUFFER *wb)
+{
+    unsigned char *p = ssl3_buf_freelist_extract(s->ctx, 0, wb->len);
+
+    if (p == NULL || !ssl3_zerocopy_park(s, wb->buf, wb->len)) {
+        ssl3_buf_freelist_insert(s->ctx, 0, p, wb->len);
+        SSLfatal(s, SSL_AD_NO_ALERT, SSL_F_SSL3_WRITE_PENDING,
+                 ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    wb->buf = p;
+    wb->zerocopy = 0;
+    if (s->rlayer.zerocopy_count >= SSL3_ZEROCOPY_REAP_MIN)
+        ssl3_zerocopy_reap(s);
+    return 1;
+}
+
+/*
+ * Give parked buffers whose sends are done back to the freelist. If the wbio
+ * has been replaced the old send counts are meaningless, so all go.
+ */
+void ssl3_zerocopy_reap(SSL *s)
+{
+    RECORD_LAYER *rl = &s->rlayer;
+    SSL3_ZEROCOPY_BUFFER *zb;
+    int all = rl->zerocopy_bio != s->wbio;
+    uint32_t done;
+
+    if (rl->zerocopy_head == NULL)
+        return;
+    done = all ? 0 : BIO_get_zerocopy_done(s->wbio);
+    while ((zb = rl->zerocopy_head) != NULL
+           && (all || (int32_t)(done - zb->id) >= 0)) {
+        rl->zerocopy_head = zb->next;
+        ssl3_buf_freelist_insert(s->ctx, 0, zb->buf, zb->len);
+        OPENSSL_free(zb);
+        rl->zerocopy_count--;
+    }
+    if (rl->zerocopy_head == NULL)
+        rl->zerocopy_tail = NULL;
+}
+
+/* The wbio is gone by the time this runs, see SSL_free() */
+void ssl3_zerocopy_free(RECORD_LAYER *rl)
+{
+    SSL3_ZEROCOPY_BUFFER *zb;
+
+    while ((zb = rl->zerocopy_head) != NULL) {
+        rl->zerocopy_head = zb->next;
+        OPENSSL_free(zb->buf);
+        OPENSSL_free(zb);
+    }
+    rl->zerocopy_tail = NULL;
+    rl->zerocopy_count = 0;
+}
+
 int ssl3_release_read_buffer(SSL *s)
 {
     SSL3_BUFFER *b;
 
     b = RECORD_LAYER_get_rbuf(&s->rlayer);
-    OPENSSL_free(b->buf);
+    ssl3_buf_freelist_insert(s->ctx, 1, b->buf, b->len);
     b->buf = NULL;
     return 1;
 }
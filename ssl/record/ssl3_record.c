@@ -101,6 +101,77 @@ static int ssl3_record_app_data_waiting(SSL *s)
     return 1;
 }
 
+/*
+ * Returns 1 if another record can be read into the batch of |num_recs|
+ * records that ends with |lastrr|, to be decrypted together with them.
+ */
+static int ssl3_record_batch_more(SSL *s, const SSL3_RECORD *lastrr,
+                                  size_t num_recs, size_t max_recs)
+{
+    unsigned long flags;
+
+    if (num_recs >= max_recs
+            || lastrr->type != SSL3_RT_APPLICATION_DATA
+            || s->enc_read_ctx == NULL)
+        return 0;
+
+    flags = EVP_CIPHER_flags(EVP_CIPHER_CTX_cipher(s->enc_read_ctx));
+    if (SSL_USE_EXPLICIT_IV(s) && (flags & EVP_CIPH_FLAG_PIPELINE) != 0)
+        return ssl3_record_app_data_waiting(s);
+
+    /*
+     * Other AEAD ciphers decrypt the records of a batch one after the other,
+     * see ssl3_dec_batch(). Handshake messages may change the keys, so no
+     * batches are read while in a handshake. The headers of records that
+     * ssl3_dec_batch() puts back would be reported twice, so there's no
+     * batching with a message callback either.
+     */
+    if ((flags & EVP_CIPH_FLAG_AEAD_CIPHER) == 0
+            || s->msg_callback != NULL
+            || SSL_in_init(s)
+            || s->statem.enc_read_state != ENC_READ_STATE_VALID)
+        return 0;
+
+    return ssl3_record_app_data_waiting(s);
+}
+
+/*
+ * Decrypt a batch of |*num_recs| records one at a time, for ciphers without
+ * pipeline support. In TLSv1.3 the real record type is only known once a
+ * record has been decrypted. Anything but application data, such as a
+ * KeyUpdate, ends the batch: the records after it are put back into the read
+ * buffer and |*num_recs| is updated. Returns as the |enc| function does.
+ */
+static int ssl3_dec_batch(SSL *s, SSL3_RECORD *rr, size_t *num_recs)
+{
+    SSL3_BUFFER *rbuf = RECORD_LAYER_get_rbuf(&s->rlayer);
+    size_t j, k, end, back;
+    int ret = 1;
+
+    for (j = 0; j < *num_recs; j++) {
+        ret = s->method->ssl3_enc->enc(s, &rr[j], 1, 0);
+        if (ret <= 0)
+            return ret;
+        if (!SSL_IS_TLS13(s))
+            continue;
+
+        /* The record type is the last non-zero byte */
+        for (end = rr[j].length; end > 0 && rr[j].data[end - 1] == 0; end--)
+            continue;
+        if (end > 0 && rr[j].data[end - 1] == SSL3_RT_APPLICATION_DATA)
+            continue;
+
+        for (k = j + 1, back = 0; k < *num_recs; k++)
+            back += SSL3_RT_HEADER_LENGTH + rr[k].orig_len;
+        rbuf->offset -= back;
+        rbuf->left += back;
+        *num_recs = j + 1;
+        break;
+    }
+
+    return ret;
+}
+
 int early_data_count_ok(SSL *s, size_t length, size_t overhead, int send)
 {
     uint32_t max_early_data;
@@ -186,6 +257,7 @@ int ssl3_get_record(SSL *s)
     size_t num_recs = 0, max_recs, j;
     PACKET pkt, sslv2pkt;
     size_t first_rec_len;
+    int direct = 0;
 
     rr = RECORD_LAYER_get_rrec(&s->rlayer);
     rbuf = RECORD_LAYER_get_rbuf(&s->rlayer);
@@ -453,13 +525,7 @@ int ssl3_get_record(SSL *s)
         /* we have pulled in a full packet so zero things */
         RECORD_LAYER_reset_packet_length(&s->rlayer);
         RECORD_LAYER_clear_first_record(&s->rlayer);
-    } while (num_recs < max_recs
-             && thisrr->type == SSL3_RT_APPLICATION_DATA
-             && SSL_USE_EXPLICIT_IV(s)
-             && s->enc_read_ctx != NULL
-             && (EVP_CIPHER_flags(EVP_CIPHER_CTX_cipher(s->enc_read_ctx))
-                 & EVP_CIPH_FLAG_PIPELINE)
-             && ssl3_record_app_data_waiting(s));
+    } while (ssl3_record_batch_more(s, thisrr, num_recs, max_recs));
 
     if (num_recs == 1
             && thisrr->type == SSL3_RT_CHANGE_CIPHER_SPEC
@@ -487,6 +553,7 @@ int ssl3_get_record(SSL *s)
         }
         thisrr->read = 1;
         RECORD_LAYER_set_numrpipes(&s->rlayer, 1);
+        ssl_rec_stats_add(s, SSL_REC_STAT_RECORDS_IN, 1);
 
         return 1;
     }
@@ -526,7 +593,34 @@ int ssl3_get_record(SSL *s)
 
     first_rec_len = rr[0].length;
 
-    enc_err = s->method->ssl3_enc->enc(s, rr, num_recs, 0);
+    /*
+     * A single TLSv1.3 application data record that fits can be decrypted
+     * straight into the buffer of the SSL_read_ex() call, saving the copy
+     * out of the read buffer. The outer type of all protected records is
+     * application data, the real type is only known afterwards.
+     */
+    if (num_recs == 1
+            && s->rlayer.rdirect != NULL
+            && rr[0].type == SSL3_RT_APPLICATION_DATA
+            && rr[0].length <= s->rlayer.rdirect_len
+            && SSL_IS_TLS13(s)
+            && s->enc_read_ctx != NULL
+            && !SSL_in_init(s)
+            && s->statem.enc_read_state == ENC_READ_STATE_VALID) {
+        rr[0].data = s->rlayer.rdirect;
+        direct = 1;
+    }
+
+    if (num_recs > 1
+            && (EVP_CIPHER_flags(EVP_CIPHER_CTX_cipher(s->enc_read_ctx))
+                & EVP_CIPH_FLAG_PIPELINE) == 0)
+        enc_err = ssl3_dec_batch(s, rr, &num_recs);
+    else
+        enc_err = s->method->ssl3_enc->enc(s, rr, num_recs, 0);
+
+    /* Don't leave unauthenticated plaintext in the caller's buffer */
+    if (direct && enc_err != 1)
+        OPENSSL_cleanse(rr[0].data, rr[0].length);
 
     /*-
      * enc_err is:
@@ -785,6 +879,18 @@ int ssl3_get_record(SSL *s)
         }
     }
 
+    /*
+     * Anything but application data may be kept across calls, so it goes
+     * back into the read buffer where the ciphertext was
+     */
+    if (direct && rr[0].type != SSL3_RT_APPLICATION_DATA) {
+        memcpy(rr[0].input, rr[0].data, rr[0].length);
+        rr[0].data = rr[0].input;
+    }
+
+    ssl_rec_stats_add(s, SSL_REC_STAT_RECORDS_IN, num_recs);
+    if (s->enc_read_ctx != NULL)
+        ssl_rec_stats_add(s, SSL_REC_STAT_DECRYPTS, num_recs);
     RECORD_LAYER_set_numrpipes(&s->rlayer, num_recs);
     return 1;
 }
@@ -1619,15 +1725,19 @@ int dtls1_process_record(SSL *s, DTLS1_BITMAP *bitmap)
     size_t mac_size;
     unsigned char md[EVP_MAX_MD_SIZE];
     size_t max_plain_length = SSL3_RT_MAX_PLAIN_LENGTH;
+    size_t hdr_len = DTLS1_RT_HEADER_LENGTH;
 
     rr = RECORD_LAYER_get_rrec(&s->rlayer);
     sess = s->session;
 
+    if (rr->type == DTLS1_RT_TLS12_CID)
+        hdr_len += s->dtls_cid.cid_len;
+
     /*
-     * At this point, s->rlayer.packet_length == SSL3_RT_HEADER_LNGTH + rr->length,
+     * At this point, s->rlayer.packet_length == hdr_len + rr->length,
      * and we have that many bytes in s->rlayer.packet
      */
-    rr->input = &(RECORD_LAYER_get_packet(&s->rlayer)[DTLS1_RT_HEADER_LENGTH]);
+    rr->input = &(RECORD_LAYER_get_packet(&s->rlayer)[hdr_len]);
 
     /*
      * ok, we can now read from 's->rlayer.packet' data into 'rr'. rr->input
@@ -1652,6 +1762,16 @@ int dtls1_process_record(SSL *s, DTLS1_BITMAP *bitmap)
     rr->data = rr->input;
     rr->orig_len = rr->length;
 
+    if (rr->type == DTLS1_RT_TLS12_CID) {
+        if (!dtls1_cid_open(s, rr, RECORD_LAYER_get_packet(&s->rlayer))) {
+            /* For DTLS we simply ignore bad packets. */
+            rr->length = 0;
+            RECORD_LAYER_reset_packet_length(&s->rlayer);
+            return 0;
+        }
+        goto decrypted;
+    }
+
     if (SSL_READ_ETM(s) && s->read_hash) {
         unsigned char *mac;
         mac_size = EVP_MD_CTX_size(s->read_hash);
@@ -1777,6 +1897,7 @@ int dtls1_process_record(SSL *s, DTLS1_BITMAP *bitmap)
         return 0;
     }
 
+ decrypted:
     /* r->length is now just compressed */
     if (s->expand != NULL) {
         if (rr->length > SSL3_RT_MAX_COMPRESSED_LENGTH) {
@@ -1818,6 +1939,9 @@ int dtls1_process_record(SSL *s, DTLS1_BITMAP *bitmap)
     /* Mark receipt of record. */
     dtls1_record_bitmap_update(s, bitmap);
 
+    ssl_rec_stats_add(s, SSL_REC_STAT_RECORDS_IN, 1);
+    if (s->enc_read_ctx != NULL)
+        ssl_rec_stats_add(s, SSL_REC_STAT_DECRYPTS, 1);
     return 1;
 }
 
@@ -1848,6 +1972,7 @@ int dtls1_get_record(SSL *s)
     unsigned short version;
     DTLS1_BITMAP *bitmap;
     unsigned int is_next_epoch;
+    size_t hdr_len;
 
     rr = RECORD_LAYER_get_rrec(&s->rlayer);
 
@@ -1889,10 +2014,6 @@ int dtls1_get_record(SSL *s)
 
         p = RECORD_LAYER_get_packet(&s->rlayer);
 
-        if (s->msg_callback)
-            s->msg_callback(0, 0, SSL3_RT_HEADER, p, DTLS1_RT_HEADER_LENGTH,
-                            s, s->msg_callback_arg);
-
         /* Pull apart the header into the DTLS1_RECORD */
         rr->type = *(p++);
         ssl_major = *(p++);
@@ -1905,6 +2026,41 @@ int dtls1_get_record(SSL *s)
         memcpy(&(RECORD_LAYER_get_read_sequence(&s->rlayer)[2]), p, 6);
         p += 6;
 
+        /*
+         * Once connection IDs are in use, protected records must carry ours
+         * and records that carry one must be protected.
+         */
+        hdr_len = DTLS1_RT_HEADER_LENGTH;
+        if (rr->type == DTLS1_RT_TLS12_CID) {
+            if (!DTLS_CID_RECEIVING(s) || rr->epoch == 0
+                    || ssl3_read_n(s, s->dtls_cid.cid_len,
+                                   s->dtls_cid.cid_len, 1, 1, &n) <= 0
+                    || n != s->dtls_cid.cid_len
+                    || CRYPTO_memcmp(p, s->dtls_cid.cid,
+                                     s->dtls_cid.cid_len) != 0) {
+                if (ossl_statem_in_error(s)) {
+                    /* ssl3_read_n() called SSLfatal() */
+                    return -1;
+                }
+                rr->length = 0;
+                rr->read = 1;
+                RECORD_LAYER_reset_packet_length(&s->rlayer);
+                goto again;
+            }
+            p += s->dtls_cid.cid_len;
+            hdr_len += s->dtls_cid.cid_len;
+        } else if (DTLS_CID_RECEIVING(s) && rr->epoch != 0) {
+            rr->length = 0;
+            rr->read = 1;
+            RECORD_LAYER_reset_packet_length(&s->rlayer);
+            goto again;
+        }
+
+        if (s->msg_callback)
+            s->msg_callback(0, 0, SSL3_RT_HEADER,
+                            RECORD_LAYER_get_packet(&s->rlayer), hdr_len,
+                            s, s->msg_callback_arg);
+
         n2s(p, rr->length);
         rr->read = 0;
 
@@ -1953,9 +2109,11 @@ int dtls1_get_record(SSL *s)
 
     /* s->rlayer.rstate == SSL_ST_READ_BODY, get and decode the data */
 
-    if (rr->length >
-        RECORD_LAYER_get_packet_length(&s->rlayer) - DTLS1_RT_HEADER_LENGTH) {
-        /* now s->rlayer.packet_length == DTLS1_RT_HEADER_LENGTH */
+    hdr_len = DTLS1_RT_HEADER_LENGTH;
+    if (rr->type == DTLS1_RT_TLS12_CID)
+        hdr_len += s->dtls_cid.cid_len;
+    if (rr->length > RECORD_LAYER_get_packet_length(&s->rlayer) - hdr_len) {
+        /* now s->rlayer.packet_length == hdr_len */
         more = rr->length;
         rret = ssl3_read_n(s, more, more, 1, 1, &n);
         /* this packet contained a partial record, dump it */
@@ -1972,7 +2130,7 @@ int dtls1_get_record(SSL *s)
 
         /*
          * now n == rr->length, and s->rlayer.packet_length ==
-         * DTLS1_RT_HEADER_LENGTH + rr->length
+         * hdr_len + rr->length
          */
     }
     /* set state for later operations */
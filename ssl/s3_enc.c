@@ -332,6 +332,73 @@ int ssl3_init_finished_mac(SSL *s)
     return 1;
 }
 
+/*
+ * Get the digests a handshake that can only be TLSv1.3 may use, which a
+ * server limits to those of its own ciphersuites. Returns their number, and
+ * 0 if the handshake may be for an earlier version.
+ */
+static size_t ssl3_handshake_spec_mds(SSL *s, const EVP_MD **mds)
+{
+    STACK_OF(SSL_CIPHER) *ciphers;
+    const EVP_MD *md;
+    const SSL_CIPHER *c;
+    int min_version, max_version, sha256 = 0, sha384 = 0, i;
+    size_t num = 0;
+
+    if (SSL_IS_DTLS(s)
+            || ssl_get_min_max_version(s, &min_version, &max_version,
+                                       NULL) != 0
+            || min_version < TLS1_3_VERSION)
+        return 0;
+
+    if (!s->server) {
+        sha256 = sha384 = 1;
+    } else if ((ciphers = SSL_get_ciphers(s)) != NULL) {
+        for (i = 0; i < sk_SSL_CIPHER_num(ciphers); i++) {
+            c = sk_SSL_CIPHER_value(ciphers, i);
+            if (c->min_tls != TLS1_3_VERSION)
+                continue;
+            if ((c->algorithm2 & SSL_HANDSHAKE_MAC_MASK)
+                    == SSL_HANDSHAKE_MAC_SHA384)
+                sha384 = 1;
+            else if ((c->algorithm2 & SSL_HANDSHAKE_MAC_MASK)
+                     == SSL_HANDSHAKE_MAC_SHA256)
+                sha256 = 1;
+        }
+    }
+    if (sha256 && (md = ssl_md(SSL_HANDSHAKE_MAC_SHA256)) != NULL)
+        mds[num++] = md;
+    if (sha384 && (md = ssl_md(SSL_HANDSHAKE_MAC_SHA384)) != NULL)
+        mds[num++] = md;
+    return num;
+}
+
+/*
+ * Start the transcript of a new handshake. Large ClientHellos, as post-quantum
+ * key shares make them, are not buffered if the digests the handshake may use
+ * can be run on them as they go.
+ */
+int ssl3_init_handshake_mac(SSL *s)
+{
+    const EVP_MD *mds[SSL_HANDSHAKE_SPEC_NUM];
+    size_t num = ssl3_handshake_spec_mds(s, mds), i;
+
+    if (num == 0)
+        return ssl3_init_finished_mac(s);
+
+    ssl3_free_digest_list(s);
+    for (i = 0; i < num; i++) {
+        if ((s->s3->handshake_spec_dgst[i] = EVP_MD_CTX_new()) == NULL
+                || !EVP_DigestInit_ex(s->s3->handshake_spec_dgst[i], mds[i],
+                                      NULL)) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL3_INIT_HANDSHAKE_MAC,
+                     ERR_R_INTERNAL_ERROR);
+            return 0;
+        }
+    }
+    return 1;
+}
+
 /*
  * Free digest list. Also frees handshake buffer since they are always freed
  * together.
@@ -339,17 +406,51 @@ int ssl3_init_finished_mac(SSL *s)
 
 void ssl3_free_digest_list(SSL *s)
 {
+    size_t i;
+
     BIO_free(s->s3->handshake_buffer);
     s->s3->handshake_buffer = NULL;
     EVP_MD_CTX_free(s->s3->handshake_dgst);
     s->s3->handshake_dgst = NULL;
+    for (i = 0; i < SSL_HANDSHAKE_SPEC_NUM; i++) {
+        EVP_MD_CTX_free(s->s3->handshake_spec_dgst[i]);
+        s->s3->handshake_spec_dgst[i] = NULL;
+    }
+}
+
+/* The speculative handshake digest for |md|, if any */
+static EVP_MD_CTX *ssl3_handshake_spec_dgst(SSL *s, const EVP_MD *md)
+{
+    size_t i;
+
+    for (i = 0; md != NULL && i < SSL_HANDSHAKE_SPEC_NUM; i++) {
+        if (s->s3->handshake_spec_dgst[i] != NULL
+                && EVP_MD_CTX_type(s->s3->handshake_spec_dgst[i])
+                   == EVP_MD_type(md))
+            return s->s3->handshake_spec_dgst[i];
+    }
+    return NULL;
 }
 
 int ssl3_finish_mac(SSL *s, const unsigned char *buf, size_t len)
 {
     int ret;
-
-    if (s->s3->handshake_dgst == NULL) {
+    size_t i;
+    SSL_HS_TIMER t;
+
+    ssl_hs_timer_start(s, &t);
+    if (s->s3->handshake_dgst == NULL
+            && s->s3->handshake_spec_dgst[0] != NULL) {
+        for (i = 0; i < SSL_HANDSHAKE_SPEC_NUM; i++) {
+            if (s->s3->handshake_spec_dgst[i] != NULL
+                    && !EVP_DigestUpdate(s->s3->handshake_spec_dgst[i], buf,
+                                         len)) {
+                SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL3_FINISH_MAC,
+                         ERR_R_INTERNAL_ERROR);
+                return 0;
+            }
+        }
+    } else if (s->s3->handshake_dgst == NULL) {
         /* Note: this writes to a memory BIO so a failure is a fatal error */
         if (len > INT_MAX) {
             SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL3_FINISH_MAC,
@@ -370,6 +471,7 @@ int ssl3_finish_mac(SSL *s, const unsigned char *buf, size_t len)
             return 0;
         }
     }
+    ssl_hs_timer_stop(s, SSL_HS_PHASE_TRANSCRIPT, &t);
     return 1;
 }
 
@@ -378,8 +480,27 @@ int ssl3_digest_cached_records(SSL *s, int keep)
     const EVP_MD *md;
     long hdatalen;
     void *hdata;
+    size_t i;
+    SSL_HS_TIMER t;
+
+    ssl_hs_timer_start(s, &t);
+    if (s->s3->handshake_dgst == NULL
+            && s->s3->handshake_spec_dgst[0] != NULL) {
+        EVP_MD_CTX *dgst = ssl3_handshake_spec_dgst(s, ssl_handshake_md(s));
 
-    if (s->s3->handshake_dgst == NULL) {
+        if (dgst == NULL) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL3_DIGEST_CACHED_RECORDS,
+                     SSL_R_NO_REQUIRED_DIGEST);
+            return 0;
+        }
+        /* Keep the digest we need and throw the others away */
+        for (i = 0; i < SSL_HANDSHAKE_SPEC_NUM; i++) {
+            if (s->s3->handshake_spec_dgst[i] != dgst)
+                EVP_MD_CTX_free(s->s3->handshake_spec_dgst[i]);
+            s->s3->handshake_spec_dgst[i] = NULL;
+        }
+        s->s3->handshake_dgst = dgst;
+    } else if (s->s3->handshake_dgst == NULL) {
         hdatalen = BIO_get_mem_data(s->s3->handshake_buffer, &hdata);
         if (hdatalen <= 0) {
             SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL3_DIGEST_CACHED_RECORDS,
@@ -406,7 +527,53 @@ int ssl3_digest_cached_records(SSL *s, int keep)
         BIO_free(s->s3->handshake_buffer);
         s->s3->handshake_buffer = NULL;
     }
+    ssl_hs_timer_stop(s, SSL_HS_PHASE_TRANSCRIPT, &t);
+
+    return 1;
+}
+
+/*
+ * Hash the handshake messages so far with |md| before the handshake digest is
+ * known, into |out| of at least EVP_MAX_MD_SIZE bytes.
+ */
+int ssl3_digest_cached_records_md(SSL *s, const EVP_MD *md,
+                                  unsigned char *out, size_t *outlen)
+{
+    EVP_MD_CTX *spec = ssl3_handshake_spec_dgst(s, md), *mdctx;
+    long hdatalen = 0;
+    void *hdata = NULL;
+    unsigned int len;
+    int ret;
+
+    if (spec == NULL) {
+        if (s->s3->handshake_buffer != NULL)
+            hdatalen = BIO_get_mem_data(s->s3->handshake_buffer, &hdata);
+        if (hdatalen <= 0) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR,
+                     SSL_F_SSL3_DIGEST_CACHED_RECORDS_MD,
+                     SSL_R_BAD_HANDSHAKE_LENGTH);
+            return 0;
+        }
+    }
 
+    if ((mdctx = EVP_MD_CTX_new()) == NULL) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL3_DIGEST_CACHED_RECORDS_MD,
+                 ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    if (spec != NULL)
+        ret = EVP_MD_CTX_copy_ex(mdctx, spec);
+    else
+        ret = md != NULL && EVP_DigestInit_ex(mdctx, md, NULL)
+              && EVP_DigestUpdate(mdctx, hdata, hdatalen);
+    if (!ret || !EVP_DigestFinal_ex(mdctx, out, &len)) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL3_DIGEST_CACHED_RECORDS_MD,
+                 ERR_R_INTERNAL_ERROR);
+        EVP_MD_CTX_free(mdctx);
+        return 0;
+    }
+    EVP_MD_CTX_free(mdctx);
+    *outlen = len;
     return 1;
 }
 
@@ -3311,6 +3311,23 @@ int ssl3_new(SSL *s)
     return 0;
 }
 
+/*
+ * Frees the post-quantum KEM scratch kept between the key_share extensions:
+ * the client's secret key or the server's copy of the client's public key.
+ */
+void ssl3_free_oqs_kem_tmp(SSL *s)
+{
+    if (s->s3->tmp.oqs_kem_client != NULL) {
+        if (s->server || s->s3->tmp.oqs_kem == NULL)
+            OPENSSL_free(s->s3->tmp.oqs_kem_client);
+        else
+            OQS_MEM_secure_free(s->s3->tmp.oqs_kem_client,
+                                s->s3->tmp.oqs_kem->length_secret_key);
+        s->s3->tmp.oqs_kem_client = NULL;
+    }
+    s->s3->tmp.oqs_peer_msg_len = 0;
+}
+
 void ssl3_free(SSL *s)
 {
     if (s == NULL || s->s3 == NULL)
@@ -3331,6 +3348,7 @@ void ssl3_free(SSL *s)
     OPENSSL_clear_free(s->s3->tmp.pms, s->s3->tmp.pmslen);
     OPENSSL_free(s->s3->tmp.peer_sigalgs);
     OPENSSL_free(s->s3->tmp.peer_cert_sigalgs);
+    ssl3_free_oqs_kem_tmp(s);
     ssl3_free_digest_list(s);
     OPENSSL_free(s->s3->alpn_selected);
     OPENSSL_free(s->s3->alpn_proposed);
@@ -3351,6 +3369,7 @@ int ssl3_clear(SSL *s)
     OPENSSL_clear_free(s->s3->tmp.pms, s->s3->tmp.pmslen);
     OPENSSL_free(s->s3->tmp.peer_sigalgs);
     OPENSSL_free(s->s3->tmp.peer_cert_sigalgs);
+    ssl3_free_oqs_kem_tmp(s);
 
 #if !defined(OPENSSL_NO_EC) || !defined(OPENSSL_NO_DH)
     EVP_PKEY_free(s->s3->tmp.pkey);
@@ -3376,8 +3395,7 @@ int ssl3_clear(SSL *s)
     s->ext.npn_len = 0;
 #endif
 
-    /* Clear OQS artefacts */
-    OQS_KEM_free(s->s3->tmp.oqs_kem);
+    /* Clear OQS artefacts; the KEM descriptor is shared and not owned */
     s->s3->tmp.oqs_kem = NULL;
     return 1;
 }
@@ -3862,6 +3880,11 @@ long ssl3_ctx_ctrl(SSL_CTX *ctx, int cmd, long larg, void *parg)
                        keys + sizeof(ctx->ext.tick_key_name) +
                        sizeof(ctx->ext.secure->tick_hmac_key),
                        sizeof(ctx->ext.secure->tick_aes_key));
+                if (!HMAC_KEY_set(ctx->ext.tick_hmac,
+                                  ctx->ext.secure->tick_hmac_key,
+                                  sizeof(ctx->ext.secure->tick_hmac_key),
+                                  EVP_sha256()))
+                    return 0;
             } else {
                 memcpy(keys, ctx->ext.tick_key_name,
                        sizeof(ctx->ext.tick_key_name));
@@ -3941,6 +3964,47 @@ long ssl3_ctx_ctrl(SSL_CTX *ctx, int cmd, long larg, void *parg)
         return tls1_set_groups_list(&ctx->ext.supportedgroups,
                                     &ctx->ext.supportedgroups_len,
                                     parg);
+
+    case SSL_CTRL_GET_CTX_GROUPS:
+        {
+            const uint16_t *clist;
+            size_t clistlen;
+
+            if (ctx->ext.supportedgroups != NULL) {
+                clist = ctx->ext.supportedgroups;
+                clistlen = ctx->ext.supportedgroups_len;
+            } else {
+                tls1_get_default_groups(&clist, &clistlen);
+            }
+            if (parg) {
+                size_t i;
+                int *cptr = parg;
+
+                for (i = 0; i < clistlen; i++) {
+                    const TLS_GROUP_INFO *cinf = tls1_group_id_lookup(clist[i]);
+
+                    if (cinf != NULL)
+                        cptr[i] = cinf->nid;
+                    else
+                        cptr[i] = TLSEXT_nid_unknown | clist[i];
+                }
+            }
+            return (int)clistlen;
+        }
+
+    case SSL_CTRL_GET_GROUP_COST:
+        {
+            size_t i;
+
+            for (i = 0; i < ctx->group_costs_len; i++) {
+                const TLS_GROUP_COST *gc = &ctx->group_costs[i];
+                const TLS_GROUP_INFO *cinf = tls1_group_id_lookup(gc->group_id);
+
+                if (cinf != NULL && cinf->nid == larg)
+                    return gc->cost > LONG_MAX ? LONG_MAX : (long)gc->cost;
+            }
+            return 0;
+        }
 #endif
     case SSL_CTRL_SET_SIGALGS:
         return tls1_set_sigalgs(ctx->cert, parg, larg, 0);
@@ -4428,6 +4492,9 @@ int ssl3_shutdown(SSL *s)
     }
 
     if (!(s->shutdown & SSL_SENT_SHUTDOWN)) {
+        /* Data held back by SSL_MODE_CORK goes before the close_notify */
+        if (s->rlayer.cork_len > 0 && ssl3_uncork(s) <= 0)
+            return -1;
         s->shutdown |= SSL_SENT_SHUTDOWN;
         ssl3_send_alert(s, SSL3_AL_WARNING, SSL_AD_CLOSE_NOTIFY);
         /*
@@ -4471,6 +4538,10 @@ int ssl3_write(SSL *s, const void *buf, size_t len, size_t *written)
     if (s->s3->renegotiate)
         ssl3_renegotiate_check(s, 0);
 
+    if (((s->mode & SSL_MODE_CORK) != 0 && !SSL_IS_DTLS(s))
+            || s->rlayer.cork_len > 0)
+        return ssl3_write_corked(s, buf, len, written);
+
     return s->method->ssl_write_bytes(s, SSL3_RT_APPLICATION_DATA, buf, len,
                                       written);
 }
@@ -4481,6 +4552,9 @@ static int ssl3_read_internal(SSL *s, void *buf, size_t len, int peek,
     int ret;
 
     clear_sys_error();
+    /* The peer may be waiting for data held back by SSL_MODE_CORK */
+    if (s->rlayer.cork_len > 0 && (ret = ssl3_uncork(s)) <= 0)
+        return ret;
     if (s->s3->renegotiate)
         ssl3_renegotiate_check(s, 0);
     s->s3->in_read_app_data = 1;
@@ -4690,13 +4764,15 @@ int ssl_generate_master_secret(SSL *s, unsigned char *pms, size_t pmslen,
 }
 
 /* Generate a private key from parameters */
-EVP_PKEY *ssl_generate_pkey(EVP_PKEY *pm)
+EVP_PKEY *ssl_generate_pkey(SSL *s, EVP_PKEY *pm)
 {
     EVP_PKEY_CTX *pctx = NULL;
     EVP_PKEY *pkey = NULL;
+    SSL_HS_TIMER t;
 
     if (pm == NULL)
         return NULL;
+    ssl_hs_timer_start(s, &t);
     pctx = EVP_PKEY_CTX_new(pm, NULL);
     if (pctx == NULL)
         goto err;
@@ -4706,11 +4782,109 @@ EVP_PKEY *ssl_generate_pkey(EVP_PKEY *pm)
         EVP_PKEY_free(pkey);
         pkey = NULL;
     }
+    ssl_hs_timer_stop(s, SSL_HS_PHASE_KEYGEN, &t);
 
     err:
     EVP_PKEY_CTX_free(pctx);
     return pkey;
 }
+
+/*
+ * ECDHE key reuse: under heavy handshake load a server may answer several
+ * TLSv1.3 key shares for the same group with the same ephemeral key, for a
+ * bounded number of handshakes and seconds. Keys are kept in a small table
+ * in the SSL_CTX, direct mapped by group; a collision replaces the older key.
+ */
+int SSL_CTX_set_ecdhe_reuse(SSL_CTX *ctx, unsigned int max_uses,
+                            unsigned int max_seconds)
+{
+    if (max_uses > 1
+            && (max_seconds == 0 || max_seconds > SSL_ECDHE_REUSE_MAX_SECONDS)) {
+        SSLerr(SSL_F_SSL_CTX_SET_ECDHE_REUSE, ERR_R_PASSED_INVALID_ARGUMENT);
+        return 0;
+    }
+    CRYPTO_THREAD_write_lock(ctx->lock);
+    ctx->ecdhe_reuse_max_uses = max_uses > 1 ? max_uses : 0;
+    ctx->ecdhe_reuse_max_seconds = max_uses > 1 ? max_seconds : 0;
+    CRYPTO_THREAD_unlock(ctx->lock);
+
+    /* Keys made under the old limits must not outlive them */
+    ssl_ecdhe_reuse_flush(ctx);
+    return 1;
+}
+
+void SSL_CTX_get_ecdhe_reuse(const SSL_CTX *ctx, unsigned int *max_uses,
+                             unsigned int *max_seconds)
+{
+    if (max_uses != NULL)
+        *max_uses = ctx->ecdhe_reuse_max_uses;
+    if (max_seconds != NULL)
+        *max_seconds = ctx->ecdhe_reuse_max_seconds;
+}
+
+void ssl_ecdhe_reuse_flush(SSL_CTX *ctx)
+{
+    EVP_PKEY *old[SSL_ECDHE_REUSE_NUM];
+    size_t i;
+
+    CRYPTO_THREAD_write_lock(ctx->lock);
+    for (i = 0; i < SSL_ECDHE_REUSE_NUM; i++) {
+        old[i] = ctx->ecdhe_reuse[i].pkey;
+        ctx->ecdhe_reuse[i].pkey = NULL;
+    }
+    CRYPTO_THREAD_unlock(ctx->lock);
+
+    for (i = 0; i < SSL_ECDHE_REUSE_NUM; i++)
+        EVP_PKEY_free(old[i]);
+}
+
+/*
+ * Like ssl_generate_pkey(), but returns the key last generated for
+ * |group_id| while it is within the reuse limits of the SSL_CTX. The caller
+ * owns a reference to the key either way.
+ */
+EVP_PKEY *ssl_generate_pkey_reuse(SSL *s, EVP_PKEY *pm, uint16_t group_id)
+{
+    SSL_CTX *ctx = s->session_ctx;
+    SSL_ECDHE_REUSE *slot = &ctx->ecdhe_reuse[group_id % SSL_ECDHE_REUSE_NUM];
+    EVP_PKEY *pkey = NULL, *old = NULL;
+    time_t now;
+
+    if (ctx->ecdhe_reuse_max_uses == 0)
+        return ssl_generate_pkey(s, pm);
+
+    now = time(NULL);
+    CRYPTO_THREAD_write_lock(ctx->lock);
+    if (slot->pkey != NULL && slot->group_id == group_id
+            && slot->uses < ctx->ecdhe_reuse_max_uses
+            && now >= slot->created
+            && now - slot->created < (time_t)ctx->ecdhe_reuse_max_seconds
+            && EVP_PKEY_up_ref(slot->pkey)) {
+        slot->uses++;
+        pkey = slot->pkey;
+    }
+    CRYPTO_THREAD_unlock(ctx->lock);
+    if (pkey != NULL)
+        return pkey;
+
+    if ((pkey = ssl_generate_pkey(s, pm)) == NULL)
+        return NULL;
+
+    CRYPTO_THREAD_write_lock(ctx->lock);
+    /* The limits may have been turned off while the key was generated */
+    if (ctx->ecdhe_reuse_max_uses > 0 && EVP_PKEY_up_ref(pkey)) {
+        old = slot->pkey;
+        slot->pkey = pkey;
+        slot->group_id = group_id;
+        slot->uses = 1;
+        slot->created = now;
+    }
+    CRYPTO_THREAD_unlock(ctx->lock);
+    EVP_PKEY_free(old);
+
+    return pkey;
+}
+
 #ifndef OPENSSL_NO_EC
 /* Generate a private key from a group ID */
 EVP_PKEY *ssl_generate_pkey_group(SSL *s, uint16_t id)
@@ -4719,7 +4893,9 @@ EVP_PKEY *ssl_generate_pkey_group(SSL *s, uint16_t id)
     EVP_PKEY *pkey = NULL;
     const TLS_GROUP_INFO *ginf = tls1_group_id_lookup(id);
     uint16_t gtype;
+    SSL_HS_TIMER t;
 
+    ssl_hs_timer_start(s, &t);
     if (ginf == NULL) {
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_GENERATE_PKEY_GROUP,
                  ERR_R_INTERNAL_ERROR);
@@ -4752,6 +4928,7 @@ EVP_PKEY *ssl_generate_pkey_group(SSL *s, uint16_t id)
         EVP_PKEY_free(pkey);
         pkey = NULL;
     }
+    ssl_hs_timer_stop(s, SSL_HS_PHASE_KEYGEN, &t);
 
  err:
     EVP_PKEY_CTX_free(pctx);
@@ -4803,6 +4980,7 @@ int ssl_derive(SSL *s, EVP_PKEY *privkey, EVP_PKEY *pubkey, int gensecret)
     unsigned char *pms = NULL;
     size_t pmslen = 0;
     EVP_PKEY_CTX *pctx;
+    SSL_HS_TIMER t;
 
     if (privkey == NULL || pubkey == NULL) {
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_DERIVE,
@@ -4810,6 +4988,7 @@ int ssl_derive(SSL *s, EVP_PKEY *privkey, EVP_PKEY *pubkey, int gensecret)
         return 0;
     }
 
+    ssl_hs_timer_start(s, &t);
     pctx = EVP_PKEY_CTX_new(privkey, NULL);
 
     if (EVP_PKEY_derive_init(pctx) <= 0
@@ -4832,6 +5011,13 @@ int ssl_derive(SSL *s, EVP_PKEY *privkey, EVP_PKEY *pubkey, int gensecret)
                  ERR_R_INTERNAL_ERROR);
         goto err;
     }
+    /*
+     * The side answering the peer's key share, the TLSv1.3 server or the
+     * TLSv1.2 client, derives the way a KEM encapsulates
+     */
+    ssl_hs_timer_stop(s, !s->server == !SSL_IS_TLS13(s) ? SSL_HS_PHASE_ENCAPS
+                                                         : SSL_HS_PHASE_DECAPS,
+                      &t);
 
     if (gensecret) {
         /* SSLfatal() called as appropriate in the below functions */
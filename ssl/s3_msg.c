@@ -86,6 +86,7 @@ int ssl3_dispatch_alert(SSL *s)
          * Alert sent to BIO - now flush. If the message does not get sent due
          * to non-blocking IO, we will not worry too much.
          */
+        ssl_rec_stats_add(s, SSL_REC_STAT_FLUSHES, 1);
         (void)BIO_flush(s->wbio);
 
         if (s->msg_callback)
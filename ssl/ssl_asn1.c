@@ -43,6 +43,7 @@ typedef struct {
     ASN1_OCTET_STRING *alpn_selected;
     uint32_t tlsext_max_fragment_len_mode;
     ASN1_OCTET_STRING *ticket_appdata;
+    ASN1_OCTET_STRING *peer_digest;
 } SSL_SESSION_ASN1;
 
 ASN1_SEQUENCE(SSL_SESSION_ASN1) = {
@@ -73,7 +74,8 @@ ASN1_SEQUENCE(SSL_SESSION_ASN1) = {
     ASN1_EXP_OPT_EMBED(SSL_SESSION_ASN1, max_early_data, ZUINT32, 15),
     ASN1_EXP_OPT(SSL_SESSION_ASN1, alpn_selected, ASN1_OCTET_STRING, 16),
     ASN1_EXP_OPT_EMBED(SSL_SESSION_ASN1, tlsext_max_fragment_len_mode, ZUINT32, 17),
-    ASN1_EXP_OPT(SSL_SESSION_ASN1, ticket_appdata, ASN1_OCTET_STRING, 18)
+    ASN1_EXP_OPT(SSL_SESSION_ASN1, ticket_appdata, ASN1_OCTET_STRING, 18),
+    ASN1_EXP_OPT(SSL_SESSION_ASN1, peer_digest, ASN1_OCTET_STRING, 19)
 } static_ASN1_SEQUENCE_END(SSL_SESSION_ASN1)
 
 IMPLEMENT_STATIC_ASN1_ENCODE_FUNCTIONS(SSL_SESSION_ASN1)
@@ -102,6 +104,16 @@ static void ssl_session_sinit(ASN1_OCTET_STRING **dest, ASN1_OCTET_STRING *os,
 }
 
 int i2d_SSL_SESSION(SSL_SESSION *in, unsigned char **pp)
+{
+    return ssl_session_i2d(in, NULL, pp);
+}
+
+/*
+ * Encode |in|, with the SHA-256 |peer_digest| of its peer certificate in
+ * place of the certificate itself unless |peer_digest| is NULL.
+ */
+int ssl_session_i2d(SSL_SESSION *in, const unsigned char *peer_digest,
+                    unsigned char **pp)
 {
 
     SSL_SESSION_ASN1 as;
@@ -123,6 +135,7 @@ int i2d_SSL_SESSION(SSL_SESSION *in, unsigned char **pp)
 #endif
     ASN1_OCTET_STRING alpn_selected;
     ASN1_OCTET_STRING ticket_appdata;
+    ASN1_OCTET_STRING peer_digest_os;
 
     long l;
 
@@ -163,7 +176,11 @@ int i2d_SSL_SESSION(SSL_SESSION *in, unsigned char **pp)
     as.timeout = in->timeout;
     as.verify_result = in->verify_result;
 
-    as.peer = in->peer;
+    if (peer_digest != NULL && in->peer != NULL)
+        ssl_session_oinit(&as.peer_digest, &peer_digest_os,
+                          (unsigned char *)peer_digest, SSL_PEER_DIGEST_LENGTH);
+    else
+        as.peer = in->peer;
 
     ssl_session_sinit(&as.tlsext_hostname, &tlsext_hostname,
                       in->ext.hostname);
@@ -236,20 +253,264 @@ static int ssl_session_memcpy(unsigned char *dst, size_t *pdstlen,
     return 1;
 }
 
-SSL_SESSION *d2i_SSL_SESSION(SSL_SESSION **a, const unsigned char **pp,
-                             long length)
+/*
+ * Move the contents of an OCTET STRING to |*pdst|: the data itself if it is
+ * |owned|, a copy of it otherwise.
+ */
+static int ssl_session_take(unsigned char **pdst, size_t *pdstlen,
+                            ASN1_OCTET_STRING *src, int owned)
+{
+    OPENSSL_free(*pdst);
+    *pdst = NULL;
+    *pdstlen = 0;
+    if (src == NULL)
+        return 1;
+    if (owned) {
+        *pdst = src->data;
+        src->data = NULL;
+    } else {
+        /* NUL terminated like the data of any ASN1_STRING */
+        if ((*pdst = OPENSSL_malloc(src->length + 1)) == NULL)
+            return 0;
+        memcpy(*pdst, src->data, src->length);
+        (*pdst)[src->length] = '\0';
+    }
+    *pdstlen = src->length;
+    return 1;
+}
+
+/*-
+ * Fast path of d2i_SSL_SESSION(). Sessions are decoded on every resumption,
+ * and the template decoder spends most of that time interpreting the
+ * template and allocating each field. This decodes the DER that
+ * i2d_SSL_SESSION() writes straight from the table below, which follows
+ * the SSL_SESSION_ASN1 template field by field, with the OCTET STRINGs
+ * pointing into the input.
+ *
+ * Anything else, such as BER lengths, constructed strings or negative
+ * integers, makes it fail and the caller falls back to the template
+ * decoder, so that which encodings are accepted and what they decode to
+ * stays the same.
+ */
+#define SESS_FIELD_UINT32      0
+#define SESS_FIELD_INT32       1
+#define SESS_FIELD_UINT64      2
+#define SESS_FIELD_INT64       3
+#define SESS_FIELD_OCTETS      4
+#define SESS_FIELD_X509        5
+
+#define SESS_TAG_NONE          0
+#define SESS_TAG_IMP(n)        (V_ASN1_CONTEXT_SPECIFIC | (n))
+#define SESS_TAG_EXP(n)        (V_ASN1_CONTEXT_SPECIFIC | V_ASN1_CONSTRUCTED | (n))
+
+typedef struct {
+    unsigned int tag;
+    int type;
+    size_t offset;
+} SSL_SESSION_ASN1_FIELD;
+
+#define SESS_FIELD(tag, type, field) \
+    { tag, SESS_FIELD_##type, offsetof(SSL_SESSION_ASN1, field) }
+
+static const SSL_SESSION_ASN1_FIELD ssl_session_asn1_fields[] = {
+    SESS_FIELD(SESS_TAG_NONE, UINT32, version),
+    SESS_FIELD(SESS_TAG_NONE, INT32, ssl_version),
+    SESS_FIELD(SESS_TAG_NONE, OCTETS, cipher),
+    SESS_FIELD(SESS_TAG_NONE, OCTETS, session_id),
+    SESS_FIELD(SESS_TAG_NONE, OCTETS, master_key),
+    SESS_FIELD(SESS_TAG_IMP(0), OCTETS, key_arg),
+    SESS_FIELD(SESS_TAG_EXP(1), INT64, time),
+    SESS_FIELD(SESS_TAG_EXP(2), INT64, timeout),
+    SESS_FIELD(SESS_TAG_EXP(3), X509, peer),
+    SESS_FIELD(SESS_TAG_EXP(4), OCTETS, session_id_context),
+    SESS_FIELD(SESS_TAG_EXP(5), INT32, verify_result),
+    SESS_FIELD(SESS_TAG_EXP(6), OCTETS, tlsext_hostname),
+#ifndef OPENSSL_NO_PSK
+    SESS_FIELD(SESS_TAG_EXP(7), OCTETS, psk_identity_hint),
+    SESS_FIELD(SESS_TAG_EXP(8), OCTETS, psk_identity),
+#endif
+    SESS_FIELD(SESS_TAG_EXP(9), UINT64, tlsext_tick_lifetime_hint),
+    SESS_FIELD(SESS_TAG_EXP(10), OCTETS, tlsext_tick),
+    SESS_FIELD(SESS_TAG_EXP(11), OCTETS, comp_id),
+#ifndef OPENSSL_NO_SRP
+    SESS_FIELD(SESS_TAG_EXP(12), OCTETS, srp_username),
+#endif
+    SESS_FIELD(SESS_TAG_EXP(13), UINT64, flags),
+    SESS_FIELD(SESS_TAG_EXP(14), UINT32, tlsext_tick_age_add),
+    SESS_FIELD(SESS_TAG_EXP(15), UINT32, max_early_data),
+    SESS_FIELD(SESS_TAG_EXP(16), OCTETS, alpn_selected),
+    SESS_FIELD(SESS_TAG_EXP(17), UINT32, tlsext_max_fragment_len_mode),
+    SESS_FIELD(SESS_TAG_EXP(18), OCTETS, ticket_appdata),
+    SESS_FIELD(SESS_TAG_EXP(19), OCTETS, peer_digest)
+};
+
+#define SSL_SESSION_ASN1_FIELDS OSSL_NELEM(ssl_session_asn1_fields)
+
+/*
+ * Reads a DER TLV with identifier octet |tag| from |pkt| into |content|.
+ * Fails if the next TLV has another tag, without consuming anything.
+ */
+static int ssl_session_asn1_tlv(PACKET *pkt, unsigned int tag,
+                                PACKET *content)
+{
+    PACKET tmp = *pkt;
+    unsigned int id, lenbytes;
+    size_t len;
+
+    if (!PACKET_get_1(&tmp, &id)
+            || id != tag
+            || !PACKET_get_1(&tmp, &lenbytes))
+        return 0;
+    if (lenbytes < 0x80) {
+        len = lenbytes;
+    } else {
+        /* No indefinite lengths, nor any that don't fit in 4 bytes */
+        lenbytes &= 0x7f;
+        if (lenbytes == 0 || lenbytes > 4)
+            return 0;
+        for (len = 0; lenbytes > 0; lenbytes--) {
+            if (!PACKET_get_1(&tmp, &id))
+                return 0;
+            len = (len << 8) | id;
+        }
+    }
+    if (!PACKET_get_sub_packet(&tmp, content, len))
+        return 0;
+    *pkt = tmp;
+    return 1;
+}
+
+/* Reads a non negative INTEGER in minimal encoding, of at most |max| */
+static int ssl_session_asn1_uint(PACKET *pkt, uint64_t max, uint64_t *pval)
+{
+    PACKET content;
+    const unsigned char *p;
+    size_t len;
+    uint64_t val = 0;
+
+    if (!ssl_session_asn1_tlv(pkt, V_ASN1_INTEGER, &content))
+        return 0;
+    p = PACKET_data(&content);
+    len = PACKET_remaining(&content);
+    if (len == 0 || (p[0] & 0x80) != 0)
+        return 0;
+    if (p[0] == 0 && len > 1) {
+        if ((p[1] & 0x80) == 0)
+            return 0;
+        p++;
+        len--;
+    }
+    if (len > sizeof(val))
+        return 0;
+    while (len-- > 0)
+        val = (val << 8) | *p++;
+    if (val > max)
+        return 0;
+    *pval = val;
+    return 1;
+}
+
+/*
+ * Decodes into |as|, the OCTET STRINGs using |os|, one per field. On
+ * failure |as->peer| may still need freeing.
+ */
+static int ssl_session_asn1_decode(SSL_SESSION_ASN1 *as,
+                                   ASN1_OCTET_STRING *os,
+                                   const unsigned char **pp, long length)
+{
+    PACKET pkt, seq, field, value, *in;
+    const SSL_SESSION_ASN1_FIELD *f;
+    const unsigned char *q;
+    unsigned char *dst;
+    uint64_t val;
+    size_t i;
+
+    memset(as, 0, sizeof(*as));
+    if (length < 0
+            || !PACKET_buf_init(&pkt, *pp, (size_t)length)
+            || !ssl_session_asn1_tlv(&pkt, V_ASN1_SEQUENCE | V_ASN1_CONSTRUCTED,
+                                     &seq))
+        return 0;
+
+    for (i = 0; i < SSL_SESSION_ASN1_FIELDS; i++) {
+        f = &ssl_session_asn1_fields[i];
+        dst = (unsigned char *)as + f->offset;
+        in = &seq;
+        if (f->tag == SESS_TAG_IMP(0)) {
+            /* key_arg, whose contents are never used */
+            (void)ssl_session_asn1_tlv(&seq, f->tag, &field);
+            continue;
+        }
+        if (f->tag != SESS_TAG_NONE) {
+            /* Optional: skip to the next field if this one isn't there */
+            if (!ssl_session_asn1_tlv(&seq, f->tag, &field))
+                continue;
+            in = &field;
+        }
+
+        switch (f->type) {
+        case SESS_FIELD_UINT32:
+            if (!ssl_session_asn1_uint(in, UINT32_MAX, &val))
+                return 0;
+            *(uint32_t *)dst = (uint32_t)val;
+            break;
+        case SESS_FIELD_INT32:
+            if (!ssl_session_asn1_uint(in, INT32_MAX, &val))
+                return 0;
+            *(int32_t *)dst = (int32_t)val;
+            break;
+        case SESS_FIELD_UINT64:
+            if (!ssl_session_asn1_uint(in, UINT64_MAX, &val))
+                return 0;
+            *(uint64_t *)dst = val;
+            break;
+        case SESS_FIELD_INT64:
+            if (!ssl_session_asn1_uint(in, INT64_MAX, &val))
+                return 0;
+            *(int64_t *)dst = (int64_t)val;
+            break;
+        case SESS_FIELD_OCTETS:
+            if (!ssl_session_asn1_tlv(in, V_ASN1_OCTET_STRING, &value)
+                    || PACKET_remaining(&value) > INT_MAX)
+                return 0;
+            os[i].type = V_ASN1_OCTET_STRING;
+            os[i].data = (unsigned char *)PACKET_data(&value);
+            os[i].length = (int)PACKET_remaining(&value);
+            os[i].flags = 0;
+            *(ASN1_OCTET_STRING **)dst = &os[i];
+            break;
+        case SESS_FIELD_X509:
+            q = PACKET_data(in);
+            as->peer = d2i_X509_intern(NULL, &q,
+                                       (long)PACKET_remaining(in));
+            if (as->peer == NULL
+                    || !PACKET_forward(in, q - PACKET_data(in)))
+                return 0;
+            break;
+        }
+        /* An explicit tag holds exactly one value */
+        if (in != &seq && PACKET_remaining(in) != 0)
+            return 0;
+    }
+    if (PACKET_remaining(&seq) != 0)
+        return 0;
+
+    *pp = PACKET_data(&pkt);
+    return 1;
+}
+
+/*
+ * Fill in |*a|, or a new session if |a| or |*a| is NULL, from the decoded
+ * |as|. The peer certificate is moved out of |as|, and so are its other
+ * fields if they are |owned| rather than pointing into the input.
+ */
+static SSL_SESSION *ssl_session_from_asn1(SSL_SESSION **a,
+                                          SSL_SESSION_ASN1 *as, int owned)
 {
     long id;
     size_t tmpl;
-    const unsigned char *p = *pp;
-    SSL_SESSION_ASN1 *as = NULL;
     SSL_SESSION *ret = NULL;
 
-    as = d2i_SSL_SESSION_ASN1(NULL, &p, length);
-    /* ASN.1 code returns suitable error */
-    if (as == NULL)
-        goto err;
-
     if (!a || !*a) {
         ret = SSL_SESSION_new();
         if (ret == NULL)
@@ -309,6 +570,19 @@ SSL_SESSION *d2i_SSL_SESSION(SSL_SESSION **a, const unsigned char **pp,
     ret->peer = as->peer;
     as->peer = NULL;
 
+    /* The peer certificate may have been left out for its digest */
+    ret->peer_digest_len = 0;
+    if (as->peer_digest != NULL) {
+        if (ret->peer != NULL
+                || !ssl_session_memcpy(ret->peer_digest, &ret->peer_digest_len,
+                                       as->peer_digest,
+                                       SSL_PEER_DIGEST_LENGTH)
+                || ret->peer_digest_len != SSL_PEER_DIGEST_LENGTH) {
+            SSLerr(SSL_F_D2I_SSL_SESSION, SSL_R_BAD_LENGTH);
+            goto err;
+        }
+    }
+
     if (!ssl_session_memcpy(ret->sid_ctx, &ret->sid_ctx_length,
                             as->session_id_context, SSL_MAX_SID_CTX_LENGTH))
         goto err;
@@ -328,14 +602,9 @@ SSL_SESSION *d2i_SSL_SESSION(SSL_SESSION **a, const unsigned char **pp,
 
     ret->ext.tick_lifetime_hint = (unsigned long)as->tlsext_tick_lifetime_hint;
     ret->ext.tick_age_add = as->tlsext_tick_age_add;
-    OPENSSL_free(ret->ext.tick);
-    if (as->tlsext_tick != NULL) {
-        ret->ext.tick = as->tlsext_tick->data;
-        ret->ext.ticklen = as->tlsext_tick->length;
-        as->tlsext_tick->data = NULL;
-    } else {
-        ret->ext.tick = NULL;
-    }
+    if (!ssl_session_take(&ret->ext.tick, &ret->ext.ticklen,
+                          as->tlsext_tick, owned))
+        goto err;
 #ifndef OPENSSL_NO_COMP
     if (as->comp_id) {
         if (as->comp_id->length != 1) {
@@ -356,38 +625,363 @@ SSL_SESSION *d2i_SSL_SESSION(SSL_SESSION **a, const unsigned char **pp,
     ret->flags = (int32_t)as->flags;
     ret->ext.max_early_data = as->max_early_data;
 
-    OPENSSL_free(ret->ext.alpn_selected);
-    if (as->alpn_selected != NULL) {
-        ret->ext.alpn_selected = as->alpn_selected->data;
-        ret->ext.alpn_selected_len = as->alpn_selected->length;
-        as->alpn_selected->data = NULL;
-    } else {
-        ret->ext.alpn_selected = NULL;
-        ret->ext.alpn_selected_len = 0;
-    }
+    if (!ssl_session_take(&ret->ext.alpn_selected, &ret->ext.alpn_selected_len,
+                          as->alpn_selected, owned))
+        goto err;
 
     ret->ext.max_fragment_len_mode = as->tlsext_max_fragment_len_mode;
 
-    OPENSSL_free(ret->ticket_appdata);
-    if (as->ticket_appdata != NULL) {
-        ret->ticket_appdata = as->ticket_appdata->data;
-        ret->ticket_appdata_len = as->ticket_appdata->length;
-        as->ticket_appdata->data = NULL;
-    } else {
-        ret->ticket_appdata = NULL;
-        ret->ticket_appdata_len = 0;
-    }
-
-    M_ASN1_free_of(as, SSL_SESSION_ASN1);
+    if (!ssl_session_take(&ret->ticket_appdata, &ret->ticket_appdata_len,
+                          as->ticket_appdata, owned))
+        goto err;
 
     if ((a != NULL) && (*a == NULL))
         *a = ret;
-    *pp = p;
     return ret;
 
  err:
-    M_ASN1_free_of(as, SSL_SESSION_ASN1);
     if ((a == NULL) || (*a != ret))
         SSL_SESSION_free(ret);
     return NULL;
 }
+
+SSL_SESSION *d2i_SSL_SESSION(SSL_SESSION **a, const unsigned char **pp,
+                             long length)
+{
+    const unsigned char *p = *pp;
+    SSL_SESSION_ASN1 fast, *as = NULL;
+    ASN1_OCTET_STRING os[SSL_SESSION_ASN1_FIELDS];
+    SSL_SESSION *ret;
+
+    ERR_set_mark();
+    if (ssl_session_asn1_decode(&fast, os, &p, length)) {
+        ERR_clear_last_mark();
+        ret = ssl_session_from_asn1(a, &fast, 0);
+        X509_free(fast.peer);
+    } else {
+        X509_free(fast.peer);
+        ERR_pop_to_mark();
+        p = *pp;
+        as = d2i_SSL_SESSION_ASN1(NULL, &p, length);
+        /* ASN.1 code returns suitable error */
+        if (as == NULL)
+            return NULL;
+        as->peer = X509_intern(as->peer);
+        ret = ssl_session_from_asn1(a, as, 1);
+        M_ASN1_free_of(as, SSL_SESSION_ASN1);
+    }
+
+    if (ret != NULL)
+        *pp = p;
+    return ret;
+}
+
+/*-
+ * The compact session format is meant for external session caches, which
+ * store and decode sessions far more often than anything else does with
+ * them. It has the same contents as the ASN.1 format, written without tags:
+ *
+ *   magic (1), version (1), ssl_version (2), cipher (2), compress_meth (1),
+ *   max_fragment_len_mode (1), peer form (1), verify_result (4), flags (4),
+ *   time (8), timeout (8), tick_lifetime_hint (4), tick_age_add (4),
+ *   max_early_data (4)
+ *
+ * all in network byte order, followed by session_id, sid_ctx and master_key
+ * each with a one byte length, hostname, alpn_selected, tick,
+ * psk_identity_hint, psk_identity and srp_username each with a two byte
+ * length and ticket_appdata and the peer certificate each with a four byte
+ * length. An empty field stands for one that is not set. The peer
+ * certificate is either its DER encoding or, if it is in the intern table,
+ * the SHA-256 digest it is found under there.
+ */
+#define SSL_SESSION_COMPACT_MAGIC       0x53
+#define SSL_SESSION_COMPACT_VERSION     1
+
+#define SESS_COMPACT_PEER_NONE          0
+#define SESS_COMPACT_PEER_DER           1
+#define SESS_COMPACT_PEER_DIGEST        2
+
+static int ssl_session_compact_put_str(WPACKET *pkt, const char *str)
+{
+    return WPACKET_sub_memcpy_u16(pkt, str, str != NULL ? strlen(str) : 0);
+}
+
+/*
+ * Put |peer| in the intern table and write its digest there to |md|.
+ * Returns 0 if it cannot be found in the table afterwards.
+ */
+static int ssl_session_compact_digest(X509 *peer, unsigned char *md)
+{
+    unsigned int len;
+    X509 *x;
+
+    if (!X509_intern_enabled() || !X509_up_ref(peer))
+        return 0;
+    X509_free(X509_intern(peer));
+    if (!X509_digest(peer, EVP_sha256(), md, &len)
+            || (x = X509_intern_lookup(md, len)) == NULL)
+        return 0;
+    X509_free(x);
+    return 1;
+}
+
+static int ssl_session_compact_put(WPACKET *pkt, SSL_SESSION *in,
+                                   unsigned int flags)
+{
+    unsigned char md[EVP_MAX_MD_SIZE];
+    unsigned char *der;
+    unsigned int peer_form = SESS_COMPACT_PEER_NONE;
+    long cipher_id = in->cipher != NULL ? in->cipher->id : in->cipher_id;
+    const char *psk_identity_hint = NULL, *psk_identity = NULL;
+    const char *srp_username = NULL;
+    int derlen = 0;
+
+#ifndef OPENSSL_NO_PSK
+    psk_identity_hint = in->psk_identity_hint;
+    psk_identity = in->psk_identity;
+#endif
+#ifndef OPENSSL_NO_SRP
+    srp_username = in->srp_username;
+#endif
+
+    if (in->peer != NULL) {
+        ERR_set_mark();
+        if ((flags & SSL_SESSION_COMPACT_PEER_DIGEST) != 0
+                && ssl_session_compact_digest(in->peer, md)) {
+            peer_form = SESS_COMPACT_PEER_DIGEST;
+        } else {
+            peer_form = SESS_COMPACT_PEER_DER;
+            if ((derlen = i2d_X509(in->peer, NULL)) <= 0) {
+                ERR_clear_last_mark();
+                return 0;
+            }
+        }
+        ERR_pop_to_mark();
+    }
+
+    if (!WPACKET_put_bytes_u8(pkt, SSL_SESSION_COMPACT_MAGIC)
+            || !WPACKET_put_bytes_u8(pkt, SSL_SESSION_COMPACT_VERSION)
+            || !WPACKET_put_bytes_u16(pkt, in->ssl_version)
+            || !WPACKET_put_bytes_u16(pkt, cipher_id & 0xffff)
+            || !WPACKET_put_bytes_u8(pkt, in->compress_meth)
+            || !WPACKET_put_bytes_u8(pkt, in->ext.max_fragment_len_mode)
+            || !WPACKET_put_bytes_u8(pkt, peer_form)
+            || !WPACKET_put_bytes_u32(pkt, (uint32_t)in->verify_result)
+            || !WPACKET_put_bytes_u32(pkt, in->flags)
+            || !WPACKET_put_bytes_u64(pkt, (uint64_t)in->time)
+            || !WPACKET_put_bytes_u64(pkt, (uint64_t)in->timeout)
+            || !WPACKET_put_bytes_u32(pkt, in->ext.tick_lifetime_hint)
+            || !WPACKET_put_bytes_u32(pkt, in->ext.tick_age_add)
+            || !WPACKET_put_bytes_u32(pkt, in->ext.max_early_data)
+            || !WPACKET_sub_memcpy_u8(pkt, in->session_id,
+                                      in->session_id_length)
+            || !WPACKET_sub_memcpy_u8(pkt, in->sid_ctx, in->sid_ctx_length)
+            || !WPACKET_sub_memcpy_u8(pkt, in->master_key,
+                                      in->master_key_length)
+            || !ssl_session_compact_put_str(pkt, in->ext.hostname)
+            || !WPACKET_sub_memcpy_u16(pkt, in->ext.alpn_selected,
+                                       in->ext.alpn_selected_len)
+            || !WPACKET_sub_memcpy_u16(pkt, in->ext.tick, in->ext.ticklen)
+            || !ssl_session_compact_put_str(pkt, psk_identity_hint)
+            || !ssl_session_compact_put_str(pkt, psk_identity)
+            || !ssl_session_compact_put_str(pkt, srp_username)
+            || !WPACKET_sub_memcpy_u32(pkt, in->ticket_appdata,
+                                       in->ticket_appdata_len))
+        return 0;
+
+    switch (peer_form) {
+    case SESS_COMPACT_PEER_DIGEST:
+        return WPACKET_sub_memcpy_u32(pkt, md, SSL_PEER_DIGEST_LENGTH);
+    case SESS_COMPACT_PEER_DER:
+        return WPACKET_sub_allocate_bytes_u32(pkt, derlen, &der)
+               && i2d_X509(in->peer, &der) == derlen;
+    default:
+        return WPACKET_put_bytes_u32(pkt, 0);
+    }
+}
+
+int i2d_SSL_SESSION_compact(SSL_SESSION *in, unsigned char **pp,
+                            unsigned int flags)
+{
+    BUF_MEM *buf;
+    WPACKET pkt;
+    size_t len;
+
+    if (in == NULL || (in->cipher == NULL && in->cipher_id == 0))
+        return 0;
+
+    if ((buf = BUF_MEM_new()) == NULL || !WPACKET_init(&pkt, buf)) {
+        BUF_MEM_free(buf);
+        SSLerr(SSL_F_I2D_SSL_SESSION_COMPACT, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    if (!ssl_session_compact_put(&pkt, in, flags)
+            || !WPACKET_get_total_written(&pkt, &len)
+            || !WPACKET_finish(&pkt)
+            || len > INT_MAX) {
+        WPACKET_cleanup(&pkt);
+        BUF_MEM_free(buf);
+        SSLerr(SSL_F_I2D_SSL_SESSION_COMPACT, ERR_R_INTERNAL_ERROR);
+        return 0;
+    }
+
+    if (pp != NULL) {
+        if (*pp == NULL) {
+            *pp = (unsigned char *)buf->data;
+            buf->data = NULL;
+        } else {
+            memcpy(*pp, buf->data, len);
+            *pp += len;
+        }
+    }
+    BUF_MEM_free(buf);
+    return (int)len;
+}
+
+/* Like PACKET_get_length_prefixed_2(), with a four byte length */
+static int ssl_session_compact_get_u32_prefixed(PACKET *pkt, PACKET *subpkt)
+{
+    unsigned long len;
+
+    return PACKET_get_net_4(pkt, &len)
+           && PACKET_get_sub_packet(pkt, subpkt, len);
+}
+
+/* Point |os| at the contents of |pkt|, which stand for no field if empty */
+static void ssl_session_pinit(ASN1_OCTET_STRING **dest, ASN1_OCTET_STRING *os,
+                              const PACKET *pkt)
+{
+    if (PACKET_remaining(pkt) == 0)
+        *dest = NULL;
+    else
+        ssl_session_oinit(dest, os, (unsigned char *)PACKET_data(pkt),
+                          PACKET_remaining(pkt));
+}
+
+/*
+ * The fields are decoded into an SSL_SESSION_ASN1 pointing into the input,
+ * so that they are checked and converted exactly as those of the ASN.1
+ * format are. Nothing is allocated apart from the session and the copies of
+ * the fields it owns.
+ */
+SSL_SESSION *d2i_SSL_SESSION_compact(SSL_SESSION **a,
+                                     const unsigned char **pp, long length)
+{
+    SSL_SESSION_ASN1 as;
+    ASN1_OCTET_STRING os[SSL_SESSION_ASN1_FIELDS];
+    PACKET pkt, sid, sid_ctx, master_key, hostname, alpn, tick;
+    PACKET psk_identity_hint, psk_identity, srp_username, appdata, peer;
+    unsigned int magic, version, ssl_version, cipher, comp, mfl, peer_form;
+    unsigned long verify_result, flags, lifetime_hint, age_add, early_data;
+    uint64_t tm, timeout;
+    unsigned char cipher_data[2], comp_id;
+    const unsigned char *der;
+    SSL_SESSION *ret;
+    size_t n = 0;
+
+    if (length < 0 || !PACKET_buf_init(&pkt, *pp, (size_t)length)
+            || !PACKET_get_1(&pkt, &magic)
+            || !PACKET_get_1(&pkt, &version)
+            || magic != SSL_SESSION_COMPACT_MAGIC
+            || version != SSL_SESSION_COMPACT_VERSION) {
+        SSLerr(SSL_F_D2I_SSL_SESSION_COMPACT, SSL_R_UNKNOWN_SSL_VERSION);
+        return NULL;
+    }
+
+    if (!PACKET_get_net_2(&pkt, &ssl_version)
+            || !PACKET_get_net_2(&pkt, &cipher)
+            || !PACKET_get_1(&pkt, &comp)
+            || !PACKET_get_1(&pkt, &mfl)
+            || !PACKET_get_1(&pkt, &peer_form)
+            || !PACKET_get_net_4(&pkt, &verify_result)
+            || !PACKET_get_net_4(&pkt, &flags)
+            || !PACKET_get_net_8(&pkt, &tm)
+            || !PACKET_get_net_8(&pkt, &timeout)
+            || !PACKET_get_net_4(&pkt, &lifetime_hint)
+            || !PACKET_get_net_4(&pkt, &age_add)
+            || !PACKET_get_net_4(&pkt, &early_data)
+            || !PACKET_get_length_prefixed_1(&pkt, &sid)
+            || !PACKET_get_length_prefixed_1(&pkt, &sid_ctx)
+            || !PACKET_get_length_prefixed_1(&pkt, &master_key)
+            || !PACKET_get_length_prefixed_2(&pkt, &hostname)
+            || !PACKET_get_length_prefixed_2(&pkt, &alpn)
+            || !PACKET_get_length_prefixed_2(&pkt, &tick)
+            || !PACKET_get_length_prefixed_2(&pkt, &psk_identity_hint)
+            || !PACKET_get_length_prefixed_2(&pkt, &psk_identity)
+            || !PACKET_get_length_prefixed_2(&pkt, &srp_username)
+            || !ssl_session_compact_get_u32_prefixed(&pkt, &appdata)
+            || !ssl_session_compact_get_u32_prefixed(&pkt, &peer)) {
+        SSLerr(SSL_F_D2I_SSL_SESSION_COMPACT, SSL_R_BAD_LENGTH);
+        return NULL;
+    }
+
+    memset(&as, 0, sizeof(as));
+    as.version = SSL_SESSION_ASN1_VERSION;
+    as.ssl_version = (int32_t)ssl_version;
+    cipher_data[0] = (unsigned char)(cipher >> 8);
+    cipher_data[1] = (unsigned char)cipher;
+    ssl_session_oinit(&as.cipher, &os[n++], cipher_data, 2);
+    if (comp != 0) {
+        comp_id = (unsigned char)comp;
+        ssl_session_oinit(&as.comp_id, &os[n++], &comp_id, 1);
+    }
+    ssl_session_pinit(&as.session_id, &os[n++], &sid);
+    ssl_session_pinit(&as.session_id_context, &os[n++], &sid_ctx);
+    ssl_session_pinit(&as.master_key, &os[n++], &master_key);
+    as.time = (int64_t)tm;
+    as.timeout = (int64_t)timeout;
+    as.verify_result = (int32_t)verify_result;
+    ssl_session_pinit(&as.tlsext_hostname, &os[n++], &hostname);
+    as.tlsext_tick_lifetime_hint = lifetime_hint;
+    as.tlsext_tick_age_add = (uint32_t)age_add;
+    ssl_session_pinit(&as.tlsext_tick, &os[n++], &tick);
+    /* Without PSK or SRP support these cannot be used and are ignored */
+#ifndef OPENSSL_NO_PSK
+    ssl_session_pinit(&as.psk_identity_hint, &os[n++], &psk_identity_hint);
+    ssl_session_pinit(&as.psk_identity, &os[n++], &psk_identity);
+#endif
+#ifndef OPENSSL_NO_SRP
+    ssl_session_pinit(&as.srp_username, &os[n++], &srp_username);
+#endif
+    as.flags = flags;
+    as.max_early_data = (uint32_t)early_data;
+    ssl_session_pinit(&as.alpn_selected, &os[n++], &alpn);
+    as.tlsext_max_fragment_len_mode = mfl;
+    ssl_session_pinit(&as.ticket_appdata, &os[n++], &appdata);
+
+    switch (peer_form) {
+    case SESS_COMPACT_PEER_NONE:
+        if (PACKET_remaining(&peer) != 0) {
+            SSLerr(SSL_F_D2I_SSL_SESSION_COMPACT, SSL_R_BAD_LENGTH);
+            return NULL;
+        }
+        break;
+    case SESS_COMPACT_PEER_DER:
+        der = PACKET_data(&peer);
+        as.peer = d2i_X509_intern(NULL, &der, (long)PACKET_remaining(&peer));
+        if (as.peer == NULL || der != PACKET_end(&peer)) {
+            X509_free(as.peer);
+            SSLerr(SSL_F_D2I_SSL_SESSION_COMPACT, SSL_R_BAD_DATA);
+            return NULL;
+        }
+        break;
+    case SESS_COMPACT_PEER_DIGEST:
+        as.peer = X509_intern_lookup(PACKET_data(&peer),
+                                     PACKET_remaining(&peer));
+        if (as.peer == NULL) {
+            SSLerr(SSL_F_D2I_SSL_SESSION_COMPACT,
+                   SSL_R_UNKNOWN_PEER_CERTIFICATE);
+            return NULL;
+        }
+        break;
+    default:
+        SSLerr(SSL_F_D2I_SSL_SESSION_COMPACT, SSL_R_BAD_DATA);
+        return NULL;
+    }
+
+    ret = ssl_session_from_asn1(a, &as, 0);
+    X509_free(as.peer);
+    if (ret != NULL)
+        *pp = PACKET_data(&pkt);
+    return ret;
+}
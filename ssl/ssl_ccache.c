@@ -0,0 +1,292 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <string.h>
+#include <time.h>
+#include "ssl_local.h"
+
+/*
+ * The client session cache keeps the sessions a client received from each
+ * server, keyed by host name, port and the ALPN protocols offered, and
+ * hands them out to new connections to the same server. A TLSv1.3 server
+ * sends several tickets per connection, each meant to be used once, so up
+ * to SSL_CLIENT_CACHE_TICKETS of them are pooled for each server and each
+ * is taken out of the pool when it is handed out, oldest first. Earlier
+ * protocol versions resume the same session again and again, so those are
+ * left in the pool. Expired sessions are dropped whenever they are found,
+ * and the least recently used server is evicted when the cache is full.
+ */
+#define SSL_CLIENT_CACHE_TICKETS        8
+
+typedef struct {
+    char *host;
+    unsigned int port;
+    unsigned char *alpn;
+    size_t alpn_len;
+    /* Oldest first */
+    SSL_SESSION *sess[SSL_CLIENT_CACHE_TICKETS];
+    size_t num;
+    uint64_t last_used;
+} CLIENT_CACHE_ENTRY;
+
+DEFINE_LHASH_OF(CLIENT_CACHE_ENTRY);
+
+struct ssl_client_cache_st {
+    CRYPTO_RWLOCK *lock;
+    size_t size;
+    LHASH_OF(CLIENT_CACHE_ENTRY) *entries;
+    uint64_t clock;
+};
+
+static unsigned long client_cache_entry_hash(const CLIENT_CACHE_ENTRY *e)
+{
+    unsigned long h = OPENSSL_LH_strhash(e->host) ^ e->port;
+    size_t i;
+
+    for (i = 0; i < e->alpn_len; i++)
+        h = (h << 5) + h + e->alpn[i];
+    return h;
+}
+
+static int client_cache_entry_cmp(const CLIENT_CACHE_ENTRY *a,
+                                  const CLIENT_CACHE_ENTRY *b)
+{
+    if (a->port != b->port)
+        return a->port < b->port ? -1 : 1;
+    if (a->alpn_len != b->alpn_len)
+        return a->alpn_len < b->alpn_len ? -1 : 1;
+    if (a->alpn_len != 0) {
+        int r = memcmp(a->alpn, b->alpn, a->alpn_len);
+
+        if (r != 0)
+            return r;
+    }
+    return strcmp(a->host, b->host);
+}
+
+static void client_cache_entry_free(CLIENT_CACHE_ENTRY *e)
+{
+    size_t i;
+
+    if (e == NULL)
+        return;
+    for (i = 0; i < e->num; i++)
+        SSL_SESSION_free(e->sess[i]);
+    OPENSSL_free(e->host);
+    OPENSSL_free(e->alpn);
+    OPENSSL_free(e);
+}
+
+typedef struct {
+    CLIENT_CACHE_ENTRY *lru;
+} CLIENT_CACHE_LRU;
+
+IMPLEMENT_LHASH_DOALL_ARG(CLIENT_CACHE_ENTRY, CLIENT_CACHE_LRU);
+
+static void client_cache_find_lru(CLIENT_CACHE_ENTRY *e, CLIENT_CACHE_LRU *arg)
+{
+    if (arg->lru == NULL || e->last_used < arg->lru->last_used)
+        arg->lru = e;
+}
+
+void ssl_client_cache_free(SSL_CLIENT_CACHE *cache)
+{
+    if (cache == NULL)
+        return;
+    lh_CLIENT_CACHE_ENTRY_doall(cache->entries, client_cache_entry_free);
+    lh_CLIENT_CACHE_ENTRY_free(cache->entries);
+    CRYPTO_THREAD_lock_free(cache->lock);
+    OPENSSL_free(cache);
+}
+
+/*
+ * Set up |key| to look up the server |s| connects to. The host name is the
+ * one set with SSL_set1_client_session_cache_key(), or failing that the SNI
+ * host name. Returns 0 if there is neither.
+ */
+static int client_cache_key(SSL *s, CLIENT_CACHE_ENTRY *key)
+{
+    if (s->client_cache_host != NULL) {
+        key->host = s->client_cache_host;
+        key->port = s->client_cache_port;
+    } else if (s->ext.hostname != NULL) {
+        key->host = s->ext.hostname;
+        key->port = 0;
+    } else {
+        return 0;
+    }
+    key->alpn = s->ext.alpn;
+    key->alpn_len = s->ext.alpn != NULL ? s->ext.alpn_len : 0;
+    return 1;
+}
+
+static int client_cache_expired(const SSL_SESSION *sess, long now)
+{
+    return now - sess->time >= sess->timeout;
+}
+
+/* Drop the expired sessions at the start of the pool of |e| */
+static void client_cache_expire(CLIENT_CACHE_ENTRY *e, long now)
+{
+    size_t n = 0;
+
+    while (n < e->num && client_cache_expired(e->sess[n], now))
+        SSL_SESSION_free(e->sess[n++]);
+    if (n == 0)
+        return;
+    e->num -= n;
+    memmove(e->sess, e->sess + n, e->num * sizeof(e->sess[0]));
+}
+
+static CLIENT_CACHE_ENTRY *client_cache_entry_new(const CLIENT_CACHE_ENTRY *key)
+{
+    CLIENT_CACHE_ENTRY *e = OPENSSL_zalloc(sizeof(*e));
+
+    if (e == NULL
+            || (e->host = OPENSSL_strdup(key->host)) == NULL
+            || (key->alpn_len != 0
+                && (e->alpn = OPENSSL_memdup(key->alpn,
+                                             key->alpn_len)) == NULL)) {
+        client_cache_entry_free(e);
+        return NULL;
+    }
+    e->port = key->port;
+    e->alpn_len = key->alpn_len;
+    return e;
+}
+
+/*
+ * Add the session of the client |s| to the pool of the server it connected
+ * to.
+ */
+void ssl_client_cache_add(SSL *s)
+{
+    SSL_CLIENT_CACHE *cache = s->session_ctx->ext.client_cache;
+    SSL_SESSION *sess = s->session;
+    CLIENT_CACHE_ENTRY key, *e;
+    CLIENT_CACHE_LRU arg;
+    size_t i;
+
+    if (cache == NULL || !client_cache_key(s, &key)
+            || !SSL_SESSION_is_resumable(sess))
+        return;
+
+    if (!CRYPTO_THREAD_write_lock(cache->lock))
+        return;
+    if ((e = lh_CLIENT_CACHE_ENTRY_retrieve(cache->entries, &key)) == NULL) {
+        if (lh_CLIENT_CACHE_ENTRY_num_items(cache->entries) >= cache->size) {
+            arg.lru = NULL;
+            lh_CLIENT_CACHE_ENTRY_doall_CLIENT_CACHE_LRU(cache->entries,
+                                                         client_cache_find_lru,
+                                                         &arg);
+            (void)lh_CLIENT_CACHE_ENTRY_delete(cache->entries, arg.lru);
+            client_cache_entry_free(arg.lru);
+        }
+        if ((e = client_cache_entry_new(&key)) == NULL
+                || (lh_CLIENT_CACHE_ENTRY_insert(cache->entries, e) == NULL
+                    && lh_CLIENT_CACHE_ENTRY_error(cache->entries))) {
+            CRYPTO_THREAD_unlock(cache->lock);
+            client_cache_entry_free(e);
+            return;
+        }
+    }
+
+    for (i = 0; i < e->num && e->sess[i] != sess; i++)
+        continue;
+    if (i == e->num) {
+        client_cache_expire(e, (long)time(NULL));
+        if (e->num == SSL_CLIENT_CACHE_TICKETS) {
+            SSL_SESSION_free(e->sess[0]);
+            e->num--;
+            memmove(e->sess, e->sess + 1, e->num * sizeof(e->sess[0]));
+        }
+        SSL_SESSION_up_ref(sess);
+        e->sess[e->num++] = sess;
+    }
+    e->last_used = ++cache->clock;
+    CRYPTO_THREAD_unlock(cache->lock);
+}
+
+/*
+ * Returns a reference to a session for the server the client |s| connects
+ * to, or NULL if there is none.
+ */
+SSL_SESSION *ssl_client_cache_get(SSL *s)
+{
+    SSL_CLIENT_CACHE *cache = s->session_ctx->ext.client_cache;
+    CLIENT_CACHE_ENTRY key, *e;
+    SSL_SESSION *sess = NULL;
+
+    if (cache == NULL || !client_cache_key(s, &key))
+        return NULL;
+
+    if (!CRYPTO_THREAD_write_lock(cache->lock))
+        return NULL;
+    if ((e = lh_CLIENT_CACHE_ENTRY_retrieve(cache->entries, &key)) != NULL) {
+        client_cache_expire(e, (long)time(NULL));
+        if (e->num > 0) {
+            sess = e->sess[0];
+            if (sess->ssl_version == TLS1_3_VERSION) {
+                /* Tickets are single use, hand this one over */
+                e->num--;
+                memmove(e->sess, e->sess + 1, e->num * sizeof(e->sess[0]));
+            } else {
+                SSL_SESSION_up_ref(sess);
+            }
+        }
+        e->last_used = ++cache->clock;
+    }
+    CRYPTO_THREAD_unlock(cache->lock);
+    return sess;
+}
+
+int SSL_CTX_set_client_session_cache_size(SSL_CTX *ctx, size_t size)
+{
+    SSL_CLIENT_CACHE *cache = NULL;
+
+    if (size > 0) {
+        if ((cache = OPENSSL_zalloc(sizeof(*cache))) == NULL
+                || (cache->entries =
+                        lh_CLIENT_CACHE_ENTRY_new(client_cache_entry_hash,
+                                                  client_cache_entry_cmp))
+                   == NULL
+                || (cache->lock = CRYPTO_THREAD_lock_new()) == NULL) {
+            SSLerr(SSL_F_SSL_CTX_SET_CLIENT_SESSION_CACHE_SIZE,
+                   ERR_R_MALLOC_FAILURE);
+            if (cache != NULL)
+                lh_CLIENT_CACHE_ENTRY_free(cache->entries);
+            OPENSSL_free(cache);
+            return 0;
+        }
+        cache->size = size;
+    }
+    ssl_client_cache_free(ctx->ext.client_cache);
+    ctx->ext.client_cache = cache;
+    return 1;
+}
+
+size_t SSL_CTX_get_client_session_cache_size(const SSL_CTX *ctx)
+{
+    return ctx->ext.client_cache != NULL ? ctx->ext.client_cache->size : 0;
+}
+
+int SSL_set1_client_session_cache_key(SSL *s, const char *host,
+                                      unsigned int port)
+{
+    char *copy = NULL;
+
+    if (host != NULL && (copy = OPENSSL_strdup(host)) == NULL) {
+        SSLerr(SSL_F_SSL_SET1_CLIENT_SESSION_CACHE_KEY, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    OPENSSL_free(s->client_cache_host);
+    s->client_cache_host = copy;
+    s->client_cache_port = host != NULL ? port : 0;
+    return 1;
+}
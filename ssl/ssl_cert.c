@@ -110,6 +110,10 @@ CERT *ssl_cert_dup(CERT *cert)
             rpk->privatekey = cpk->privatekey;
             EVP_PKEY_up_ref(cpk->privatekey);
         }
+        memcpy(rpk->sigalgs, cpk->sigalgs, sizeof(rpk->sigalgs));
+        memcpy(rpk->cert_sigalgs, cpk->cert_sigalgs,
+               sizeof(rpk->cert_sigalgs));
+        rpk->curve = cpk->curve;
 
         if (cpk->chain) {
             rpk->chain = X509_chain_up_ref(cpk->chain);
@@ -198,6 +202,85 @@ CERT *ssl_cert_dup(CERT *cert)
     return NULL;
 }
 
+/*
+ * Returns a reference to the CERT of |ctx|, which SSL_CTX_swap_cert_bundle()
+ * may replace at any time. Release it with ssl_cert_free().
+ */
+CERT *ssl_ctx_get1_cert(SSL_CTX *ctx)
+{
+    CERT *c;
+    int i;
+
+    CRYPTO_THREAD_read_lock(ctx->lock);
+    c = ctx->cert;
+    CRYPTO_UP_REF(&c->references, &i, c->lock);
+    CRYPTO_THREAD_unlock(ctx->lock);
+    REF_PRINT_COUNT("CERT", c);
+    return c;
+}
+
+int SSL_CTX_swap_cert_bundle(SSL_CTX *ctx, SSL_CTX *src)
+{
+    CERT *new, *old;
+    CERT *sc = src->cert;
+    int i;
+
+    if (ctx == src || sc->key->x509 == NULL || sc->key->privatekey == NULL) {
+        SSLerr(SSL_F_SSL_CTX_SWAP_CERT_BUNDLE, SSL_R_NO_CERTIFICATE_ASSIGNED);
+        return 0;
+    }
+
+    /*
+     * Copying under the write lock keeps settings changed on |ctx| by a
+     * concurrent swap from being lost.
+     */
+    CRYPTO_THREAD_write_lock(ctx->lock);
+    old = ctx->cert;
+    if ((new = ssl_cert_dup(old)) == NULL)
+        goto err;
+    ssl_cert_clear_certs(new);
+    for (i = 0; i < SSL_PKEY_NUM; i++) {
+        CERT_PKEY *spk = &sc->pkeys[i];
+        CERT_PKEY *npk = &new->pkeys[i];
+
+        if (spk->x509 != NULL) {
+            X509_up_ref(spk->x509);
+            npk->x509 = spk->x509;
+        }
+        if (spk->privatekey != NULL) {
+            EVP_PKEY_up_ref(spk->privatekey);
+            npk->privatekey = spk->privatekey;
+        }
+        if (spk->chain != NULL
+                && (npk->chain = X509_chain_up_ref(spk->chain)) == NULL)
+            goto err;
+        if (spk->serverinfo != NULL) {
+            npk->serverinfo = OPENSSL_memdup(spk->serverinfo,
+                                             spk->serverinfo_length);
+            if (npk->serverinfo == NULL)
+                goto err;
+            npk->serverinfo_length = spk->serverinfo_length;
+        }
+        memcpy(npk->sigalgs, spk->sigalgs, sizeof(npk->sigalgs));
+        memcpy(npk->cert_sigalgs, spk->cert_sigalgs,
+               sizeof(npk->cert_sigalgs));
+        npk->curve = spk->curve;
+    }
+    new->key = &new->pkeys[sc->key - sc->pkeys];
+    ctx->cert = new;
+    CRYPTO_THREAD_unlock(ctx->lock);
+
+    /* SSL objects made before the swap still hold their own reference */
+    ssl_cert_free(old);
+    return 1;
+
+ err:
+    CRYPTO_THREAD_unlock(ctx->lock);
+    ssl_cert_free(new);
+    SSLerr(SSL_F_SSL_CTX_SWAP_CERT_BUNDLE, ERR_R_MALLOC_FAILURE);
+    return 0;
+}
+
 /* Free up and clear all certificates and chains */
 
 void ssl_cert_clear_certs(CERT *c)
@@ -216,6 +299,7 @@ void ssl_cert_clear_certs(CERT *c)
         OPENSSL_free(cpk->serverinfo);
         cpk->serverinfo = NULL;
         cpk->serverinfo_length = 0;
+        tls1_set_cert_sigalgs(cpk);
     }
 }
 
@@ -445,6 +529,33 @@ int ssl_verify_cert_chain(SSL *s, STACK_OF(X509) *sk)
     return i;
 }
 
+/*
+ * Drop the encoding of an SSL_CTX CA list. Another list could be allocated
+ * where the old one was, so this must be done whenever the list is replaced.
+ */
+void ssl_ca_names_enc_clear(SSL_CA_NAMES_ENC *enc)
+{
+    OPENSSL_free(enc->der);
+    enc->names = NULL;
+    enc->num = 0;
+    enc->der = NULL;
+    enc->len = 0;
+}
+
+void SSL_CTX_set_max_ca_names_len(SSL_CTX *ctx, size_t len)
+{
+    CRYPTO_THREAD_write_lock(ctx->lock);
+    ssl_ca_names_enc_clear(&ctx->ca_names_enc[0]);
+    ssl_ca_names_enc_clear(&ctx->ca_names_enc[1]);
+    ctx->max_ca_names_len = len;
+    CRYPTO_THREAD_unlock(ctx->lock);
+}
+
+size_t SSL_CTX_get_max_ca_names_len(const SSL_CTX *ctx)
+{
+    return ctx->max_ca_names_len;
+}
+
 static void set0_CA_list(STACK_OF(X509_NAME) **ca_list,
                         STACK_OF(X509_NAME) *name_list)
 {
@@ -483,6 +594,9 @@ void SSL_set0_CA_list(SSL *s, STACK_OF(X509_NAME) *name_list)
 
 void SSL_CTX_set0_CA_list(SSL_CTX *ctx, STACK_OF(X509_NAME) *name_list)
 {
+    CRYPTO_THREAD_write_lock(ctx->lock);
+    ssl_ca_names_enc_clear(&ctx->ca_names_enc[1]);
+    CRYPTO_THREAD_unlock(ctx->lock);
     set0_CA_list(&ctx->ca_names, name_list);
 }
 
@@ -498,6 +612,9 @@ const STACK_OF(X509_NAME) *SSL_get0_CA_list(const SSL *s)
 
 void SSL_CTX_set_client_CA_list(SSL_CTX *ctx, STACK_OF(X509_NAME) *name_list)
 {
+    CRYPTO_THREAD_write_lock(ctx->lock);
+    ssl_ca_names_enc_clear(&ctx->ca_names_enc[0]);
+    CRYPTO_THREAD_unlock(ctx->lock);
     set0_CA_list(&ctx->client_ca_names, name_list);
 }
 
@@ -598,7 +715,7 @@ static int xname_sk_cmp(const X509_NAME *const *a, const X509_NAME *const *b)
 
 static unsigned long xname_hash(const X509_NAME *a)
 {
-    return X509_NAME_hash((X509_NAME *)a);
+    return X509_NAME_hash_keyed(a);
 }
 
 STACK_OF(X509_NAME) *SSL_load_client_CA_file(const char *file)
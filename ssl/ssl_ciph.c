@@ -354,6 +354,24 @@ static uint32_t disabled_mac_mask;
 static uint32_t disabled_mkey_mask;
 static uint32_t disabled_auth_mask;
 
+/*
+ * ossl_init_ssl_base() has added every built in algorithm a cipher suite
+ * can use, and the rest (GOST) only ever come from an engine, so look in
+ * the name tables as they are: a miss through EVP_get_cipherbyname() would
+ * add every cipher and digest in libcrypto to them.
+ */
+static const EVP_CIPHER *ssl_cipher_by_nid(int nid)
+{
+    return (const EVP_CIPHER *)OBJ_NAME_get(OBJ_nid2sn(nid),
+                                            OBJ_NAME_TYPE_CIPHER_METH);
+}
+
+static const EVP_MD *ssl_digest_by_nid(int nid)
+{
+    return (const EVP_MD *)OBJ_NAME_get(OBJ_nid2sn(nid),
+                                        OBJ_NAME_TYPE_MD_METH);
+}
+
 int ssl_load_ciphers(void)
 {
     size_t i;
@@ -365,7 +383,7 @@ int ssl_load_ciphers(void)
         if (t->nid == NID_undef) {
             ssl_cipher_methods[i] = NULL;
         } else {
-            const EVP_CIPHER *cipher = EVP_get_cipherbynid(t->nid);
+            const EVP_CIPHER *cipher = ssl_cipher_by_nid(t->nid);
             ssl_cipher_methods[i] = cipher;
             if (cipher == NULL)
                 disabled_enc_mask |= t->mask;
@@ -373,7 +391,7 @@ int ssl_load_ciphers(void)
     }
     disabled_mac_mask = 0;
     for (i = 0, t = ssl_cipher_table_mac; i < SSL_MD_NUM_IDX; i++, t++) {
-        const EVP_MD *md = EVP_get_digestbynid(t->nid);
+        const EVP_MD *md = ssl_digest_by_nid(t->nid);
         ssl_digest_methods[i] = md;
         if (md == NULL) {
             disabled_mac_mask |= t->mask;
@@ -1633,6 +1651,133 @@ STACK_OF(SSL_CIPHER) *ssl_create_cipher_list(const SSL_METHOD *ssl_method,
     return cipherstack;
 }
 
+/*
+ * A cipher configuration compiled once, which SSL_CTXs copy instead of
+ * parsing the cipher rule string each.
+ */
+struct ssl_cipher_prefs_st {
+    STACK_OF(SSL_CIPHER) *cipher_list;
+    STACK_OF(SSL_CIPHER) *cipher_list_by_id;
+    STACK_OF(SSL_CIPHER) *tls13_ciphersuites;
+    /* Suite B mode the cipher rule string selected, if any */
+    uint32_t suiteb_flags;
+    CRYPTO_REF_COUNT references;
+    CRYPTO_RWLOCK *lock;
+};
+
+SSL_CIPHER_PREFS *SSL_CIPHER_PREFS_new(const SSL_METHOD *meth,
+                                       const char *cipher_list,
+                                       const char *ciphersuites)
+{
+    SSL_CIPHER_PREFS *prefs;
+    STACK_OF(SSL_CIPHER) *sk;
+    CERT *c = NULL;
+    int i, tls12 = 0;
+
+    if (!OPENSSL_init_ssl(0, NULL))
+        return NULL;
+
+    if ((prefs = OPENSSL_zalloc(sizeof(*prefs))) == NULL
+            || (prefs->lock = CRYPTO_THREAD_lock_new()) == NULL
+            || (c = ssl_cert_new()) == NULL) {
+        SSLerr(SSL_F_SSL_CIPHER_PREFS_NEW, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+    prefs->references = 1;
+
+    if (!set_ciphersuites(&prefs->tls13_ciphersuites,
+                          ciphersuites != NULL ? ciphersuites
+                                               : TLS_DEFAULT_CIPHERSUITES))
+        goto err;
+    /* Suite B modes are kept in the CERT: use a scratch one to get them */
+    sk = ssl_create_cipher_list(meth, prefs->tls13_ciphersuites,
+                                &prefs->cipher_list,
+                                &prefs->cipher_list_by_id,
+                                cipher_list != NULL ? cipher_list
+                                                    : SSL_DEFAULT_CIPHER_LIST,
+                                c);
+    if (sk == NULL)
+        goto err;
+    for (i = 0; i < sk_SSL_CIPHER_num(sk); i++) {
+        if (sk_SSL_CIPHER_value(sk, i)->min_tls < TLS1_3_VERSION)
+            tls12++;
+    }
+    if (tls12 == 0) {
+        SSLerr(SSL_F_SSL_CIPHER_PREFS_NEW, SSL_R_NO_CIPHER_MATCH);
+        goto err;
+    }
+    prefs->suiteb_flags = c->cert_flags & SSL_CERT_FLAG_SUITEB_128_LOS;
+    ssl_cert_free(c);
+
+    return prefs;
+ err:
+    ssl_cert_free(c);
+    SSL_CIPHER_PREFS_free(prefs);
+    return NULL;
+}
+
+int SSL_CIPHER_PREFS_up_ref(SSL_CIPHER_PREFS *prefs)
+{
+    int i;
+
+    if (CRYPTO_UP_REF(&prefs->references, &i, prefs->lock) <= 0)
+        return 0;
+
+    REF_PRINT_COUNT("SSL_CIPHER_PREFS", prefs);
+    REF_ASSERT_ISNT(i < 2);
+    return ((i > 1) ? 1 : 0);
+}
+
+void SSL_CIPHER_PREFS_free(SSL_CIPHER_PREFS *prefs)
+{
+    int i;
+
+    if (prefs == NULL)
+        return;
+
+    CRYPTO_DOWN_REF(&prefs->references, &i, prefs->lock);
+    REF_PRINT_COUNT("SSL_CIPHER_PREFS", prefs);
+    if (i > 0)
+        return;
+    REF_ASSERT_ISNT(i < 0);
+
+    sk_SSL_CIPHER_free(prefs->cipher_list);
+    sk_SSL_CIPHER_free(prefs->cipher_list_by_id);
+    sk_SSL_CIPHER_free(prefs->tls13_ciphersuites);
+    CRYPTO_THREAD_lock_free(prefs->lock);
+    OPENSSL_free(prefs);
+}
+
+int SSL_CTX_set_cipher_prefs(SSL_CTX *ctx, const SSL_CIPHER_PREFS *prefs)
+{
+    STACK_OF(SSL_CIPHER) *cipher_list, *cipher_list_by_id, *tls13_ciphersuites;
+
+    /* The stacks are copied so that |ctx| can still be changed on its own */
+    cipher_list = sk_SSL_CIPHER_dup(prefs->cipher_list);
+    cipher_list_by_id = sk_SSL_CIPHER_dup(prefs->cipher_list_by_id);
+    tls13_ciphersuites = sk_SSL_CIPHER_dup(prefs->tls13_ciphersuites);
+    if (cipher_list == NULL || cipher_list_by_id == NULL
+            || tls13_ciphersuites == NULL) {
+        sk_SSL_CIPHER_free(cipher_list);
+        sk_SSL_CIPHER_free(cipher_list_by_id);
+        sk_SSL_CIPHER_free(tls13_ciphersuites);
+        SSLerr(SSL_F_SSL_CTX_SET_CIPHER_PREFS, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+
+    sk_SSL_CIPHER_free(ctx->cipher_list);
+    ctx->cipher_list = cipher_list;
+    sk_SSL_CIPHER_free(ctx->cipher_list_by_id);
+    ctx->cipher_list_by_id = cipher_list_by_id;
+    sk_SSL_CIPHER_free(ctx->tls13_ciphersuites);
+    ctx->tls13_ciphersuites = tls13_ciphersuites;
+    if (prefs->suiteb_flags != 0) {
+        ctx->cert->cert_flags &= ~SSL_CERT_FLAG_SUITEB_128_LOS;
+        ctx->cert->cert_flags |= prefs->suiteb_flags;
+    }
+    return 1;
+}
+
 char *SSL_CIPHER_description(const SSL_CIPHER *cipher, char *buf, int len)
 {
     const char *ver;
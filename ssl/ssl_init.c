@@ -18,6 +18,7 @@
 static int stopped;
 
 static void ssl_library_stop(void);
+static int ssl_load_strings_on_demand(void);
 
 static CRYPTO_ONCE ssl_base = CRYPTO_ONCE_STATIC_INIT;
 static int ssl_base_inited = 0;
@@ -106,6 +107,13 @@ DEFINE_RUN_ONCE_STATIC(ossl_init_ssl_base)
     fprintf(stderr, "OPENSSL_INIT: ossl_init_ssl_base: "
             "SSL_add_ssl_module()\n");
 #endif
+    /*
+     * The SSL error strings are loaded along with the libcrypto ones, when
+     * a string is first looked up.
+     */
+    if (!ERR_load_strings_deferred(ssl_load_strings_on_demand))
+        return 0;
+
     /*
      * We ignore an error return here. Not much we can do - but not that bad
      * either. We can still safely continue.
@@ -133,10 +141,27 @@ DEFINE_RUN_ONCE_STATIC(ossl_init_load_ssl_strings)
     return 1;
 }
 
+static int ssl_strings_disabled = 0;
+
 DEFINE_RUN_ONCE_STATIC_ALT(ossl_init_no_load_ssl_strings,
                            ossl_init_load_ssl_strings)
 {
-    /* Do nothing in this case */
+    ssl_strings_disabled = 1;
+    return 1;
+}
+
+/*
+ * Called by libcrypto on the first error string lookup.  That lookup may
+ * come from ossl_init_load_ssl_strings() itself, so this must not go
+ * through |ssl_strings|; ERR_load_SSL_strings() does nothing the second
+ * time round.
+ */
+static int ssl_load_strings_on_demand(void)
+{
+#if !defined(OPENSSL_NO_ERR) && !defined(OPENSSL_NO_AUTOERRINIT)
+    if (!ssl_strings_disabled)
+        return ERR_load_SSL_strings();
+#endif
     return 1;
 }
 
@@ -166,6 +191,7 @@ static void ssl_library_stop(void)
 int OPENSSL_init_ssl(uint64_t opts, const OPENSSL_INIT_SETTINGS * settings)
 {
     static int stoperrset = 0;
+    static int lazy_algorithms = 0;
 
     if (stopped) {
         if (!stoperrset) {
@@ -180,8 +206,15 @@ int OPENSSL_init_ssl(uint64_t opts, const OPENSSL_INIT_SETTINGS * settings)
         return 0;
     }
 
-    opts |= OPENSSL_INIT_ADD_ALL_CIPHERS
-         |  OPENSSL_INIT_ADD_ALL_DIGESTS;
+    /*
+     * Once asked for, lazy loading sticks: the implicit calls made by
+     * SSL_CTX_new() and friends must not add everything after all.
+     */
+    if ((opts & OPENSSL_INIT_LAZY_ALGORITHMS) != 0)
+        lazy_algorithms = 1;
+    if (!lazy_algorithms)
+        opts |= OPENSSL_INIT_ADD_ALL_CIPHERS
+             |  OPENSSL_INIT_ADD_ALL_DIGESTS;
 #ifndef OPENSSL_NO_AUTOLOAD_CONFIG
     if ((opts & OPENSSL_INIT_NO_LOAD_CONFIG) == 0)
         opts |= OPENSSL_INIT_LOAD_CONFIG;
@@ -22,6 +22,7 @@
 #include <openssl/ct.h>
 #include "internal/cryptlib.h"
 #include "internal/refcount.h"
+#include "internal/ktls.h"
 
 const char SSL_version_str[] = OPENSSL_VERSION_TEXT;
 
@@ -593,6 +594,14 @@ int SSL_clear(SSL *s)
     s->hello_retry_request = 0;
     s->sent_tickets = 0;
 
+    ssl_dtls_cid_unregister(s);
+    if (!s->dtls_cid.cid_set)
+        s->dtls_cid.cid_len = 0;
+    s->dtls_cid.cid_picked = 0;
+    s->dtls_cid.peer_cid_len = 0;
+    s->dtls_cid.peer_offered = 0;
+    s->dtls_cid.negotiated = 0;
+
     s->error = 0;
     s->hit = 0;
     s->shutdown = 0;
@@ -612,6 +621,7 @@ int SSL_clear(SSL *s)
     s->init_buf = NULL;
     clear_ciphers(s);
     s->first_packet = 0;
+    s->dynrec_cur = 0;
 
     s->key_update = SSL_KEY_UPDATE_NONE;
 
@@ -678,6 +688,7 @@ int SSL_CTX_set_ssl_version(SSL_CTX *ctx, const SSL_METHOD *meth)
 SSL *SSL_new(SSL_CTX *ctx)
 {
     SSL *s;
+    CERT *c;
 
     if (ctx == NULL) {
         SSLerr(SSL_F_SSL_NEW, SSL_R_NULL_SSL_CTX);
@@ -711,7 +722,11 @@ SSL *SSL_new(SSL_CTX *ctx)
     s->max_early_data = ctx->max_early_data;
     s->recv_max_early_data = ctx->recv_max_early_data;
     s->num_tickets = ctx->num_tickets;
+    s->cork_threshold = ctx->cork_threshold;
     s->pha_enabled = ctx->pha_enabled;
+    memcpy(s->cert_comp_prefs, ctx->cert_comp_prefs,
+           sizeof(s->cert_comp_prefs));
+    s->cert_comp_prefs_len = ctx->cert_comp_prefs_len;
 
     /* Shallow copy of the ciphersuites stack */
     s->tls13_ciphersuites = sk_SSL_CIPHER_dup(ctx->tls13_ciphersuites);
@@ -727,7 +742,9 @@ SSL *SSL_new(SSL_CTX *ctx)
      * used to be known as s->ctx->default_cert). Now we don't look at the
      * SSL_CTX's CERT after having duplicated it once.
      */
-    s->cert = ssl_cert_dup(ctx->cert);
+    c = ssl_ctx_get1_cert(ctx);
+    s->cert = ssl_cert_dup(c);
+    ssl_cert_free(c);
     if (s->cert == NULL)
         goto err;
 
@@ -753,8 +770,12 @@ SSL *SSL_new(SSL_CTX *ctx)
     s->quiet_shutdown = ctx->quiet_shutdown;
 
     s->ext.max_fragment_len_mode = ctx->ext.max_fragment_len_mode;
+    s->dtls_cid.gen_len = ctx->ext.dtls_cid_len;
     s->max_send_fragment = ctx->max_send_fragment;
     s->split_send_fragment = ctx->split_send_fragment;
+    s->dynrec_size = ctx->dynrec_size;
+    s->dynrec_ramp = ctx->dynrec_ramp;
+    s->dynrec_idle = ctx->dynrec_idle;
     s->max_pipelines = ctx->max_pipelines;
     if (s->max_pipelines > 1)
         RECORD_LAYER_set_read_ahead(&s->rlayer, 1);
@@ -774,6 +795,8 @@ SSL *SSL_new(SSL_CTX *ctx)
     s->ext.ocsp.resp_len = 0;
     SSL_CTX_up_ref(ctx);
     s->session_ctx = ctx;
+    if (ctx->rec_stats != NULL && !SSL_enable_record_stats(s))
+        goto err;
 #ifndef OPENSSL_NO_EC
     if (ctx->ext.ecpointformats) {
         s->ext.ecpointformats =
@@ -930,6 +953,7 @@ int SSL_has_matching_session_id(const SSL *ssl, const unsigned char *id,
      * by this SSL.
      */
     SSL_SESSION r, *p;
+    SSL_SESS_SHARD *shard;
 
     if (id_len > sizeof(r.session_id))
         return 0;
@@ -938,9 +962,10 @@ int SSL_has_matching_session_id(const SSL *ssl, const unsigned char *id,
     r.session_id_length = id_len;
     memcpy(r.session_id, id, id_len);
 
-    CRYPTO_THREAD_read_lock(ssl->session_ctx->lock);
-    p = lh_SSL_SESSION_retrieve(ssl->session_ctx->sessions, &r);
-    CRYPTO_THREAD_unlock(ssl->session_ctx->lock);
+    shard = ssl_session_cache_shard(ssl->session_ctx, &r);
+    CRYPTO_THREAD_read_lock(shard->lock);
+    p = lh_SSL_SESSION_retrieve(shard->sessions, &r);
+    CRYPTO_THREAD_unlock(shard->lock);
     return (p != NULL);
 }
 
@@ -1149,7 +1174,8 @@ void SSL_free(SSL *s)
 
     if (s == NULL)
         return;
-    CRYPTO_DOWN_REF(&s->references, &i, s->lock);
+    /* Takes |s| out of the DTLS CID map before anyone can look it up */
+    i = ssl_dtls_cid_down_ref(s);
     REF_PRINT_COUNT("SSL", s);
     if (i > 0)
         return;
@@ -1188,6 +1214,8 @@ void SSL_free(SSL *s)
     /* Free up if allocated */
 
     OPENSSL_free(s->ext.hostname);
+    OPENSSL_free(s->client_cache_host);
+    ssl_rec_stats_release(s);
     SSL_CTX_free(s->session_ctx);
 #ifndef OPENSSL_NO_EC
     OPENSSL_free(s->ext.ecpointformats);
@@ -1206,11 +1234,14 @@ void SSL_free(SSL *s)
     OPENSSL_free(s->ext.ocsp.resp);
     OPENSSL_free(s->ext.alpn);
     OPENSSL_free(s->ext.tls13_cookie);
+    OPENSSL_free(s->ext.cached_info_msg);
     if (s->clienthello != NULL)
-        OPENSSL_free(s->clienthello->pre_proc_exts);
+        tls_free_raw_extensions(s, s->clienthello->pre_proc_exts);
     OPENSSL_free(s->clienthello);
+    OPENSSL_free(s->ext.raw_exts);
     OPENSSL_free(s->pha_context);
     EVP_MD_CTX_free(s->pha_dgst);
+    HMAC_CTX_free(s->hkdf_hmac);
 
     sk_X509_NAME_pop_free(s->ca_names, X509_NAME_free);
     sk_X509_NAME_pop_free(s->client_ca_names, X509_NAME_free);
@@ -1817,6 +1848,51 @@ int SSL_read_ex(SSL *s, void *buf, size_t num, size_t *readbytes)
     return ret;
 }
 
+int SSL_readv_ex(SSL *s, const SSL_IOVEC *iov, size_t iovcnt,
+                 size_t *readbytes)
+{
+    size_t i, off, n, total = 0;
+    int ret = 0, requested = 0;
+
+    if (iov == NULL && iovcnt > 0) {
+        SSLerr(SSL_F_SSL_READV_EX, ERR_R_PASSED_NULL_PARAMETER);
+        return 0;
+    }
+
+    for (i = 0; i < iovcnt; i++) {
+        if (iov[i].len == 0)
+            continue;
+        if (iov[i].base == NULL) {
+            SSLerr(SSL_F_SSL_READV_EX, ERR_R_PASSED_NULL_PARAMETER);
+            return 0;
+        }
+        requested = 1;
+        for (off = 0; off < iov[i].len; off += n) {
+            /*
+             * Once some data has been read only what is already buffered is
+             * added, so that the call never waits for more
+             */
+            if (total > 0 && SSL_pending(s) == 0)
+                goto end;
+            ret = ssl_read_internal(s, (unsigned char *)iov[i].base + off,
+                                    iov[i].len - off, &n);
+            if (ret <= 0)
+                goto end;
+            total += n;
+        }
+    }
+
+    if (!requested)
+        return SSL_read_ex(s, NULL, 0, readbytes);
+
+ end:
+    if (total > 0) {
+        *readbytes = total;
+        return 1;
+    }
+    return ret < 0 ? 0 : ret;
+}
+
 int SSL_read_early_data(SSL *s, void *buf, size_t num, size_t *readbytes)
 {
     int ret;
@@ -2008,6 +2084,128 @@ int SSL_write_ex(SSL *s, const void *buf, size_t num, size_t *written)
     return ret;
 }
 
+int SSL_writev_ex(SSL *s, const SSL_IOVEC *iov, size_t iovcnt, size_t *written)
+{
+    size_t i, total = 0;
+    int ret;
+
+    if (iov == NULL && iovcnt > 0) {
+        SSLerr(SSL_F_SSL_WRITEV_EX, ERR_R_PASSED_NULL_PARAMETER);
+        return 0;
+    }
+
+    for (i = 0; i < iovcnt; i++) {
+        if (iov[i].base == NULL && iov[i].len > 0) {
+            SSLerr(SSL_F_SSL_WRITEV_EX, ERR_R_PASSED_NULL_PARAMETER);
+            return 0;
+        }
+        if (iov[i].len > SIZE_MAX - total) {
+            SSLerr(SSL_F_SSL_WRITEV_EX, SSL_R_BAD_LENGTH);
+            return 0;
+        }
+        total += iov[i].len;
+    }
+
+    if (SSL_IS_DTLS(s)) {
+        /* Datagrams are small, DTLS simply writes a gathered copy */
+        unsigned char *buf = NULL, *p;
+
+        if (total > 0 && (buf = OPENSSL_malloc(total)) == NULL) {
+            SSLerr(SSL_F_SSL_WRITEV_EX, ERR_R_MALLOC_FAILURE);
+            return 0;
+        }
+        for (i = 0, p = buf; i < iovcnt; i++) {
+            if (iov[i].len > 0) {
+                memcpy(p, iov[i].base, iov[i].len);
+                p += iov[i].len;
+            }
+        }
+        ret = SSL_write_ex(s, buf, total, written);
+        OPENSSL_clear_free(buf, total);
+        return ret;
+    }
+
+    /*
+     * A NULL buffer makes the record layer read the plaintext from the
+     * segments as it fills each record
+     */
+    s->rlayer.wiov = iov;
+    s->rlayer.wiovcnt = iovcnt;
+    ret = ssl_write_internal(s, NULL, total, written);
+    s->rlayer.wiov = NULL;
+    s->rlayer.wiovcnt = 0;
+
+    if (ret < 0)
+        ret = 0;
+    return ret;
+}
+
+#ifndef OPENSSL_NO_KTLS
+ossl_ssize_t SSL_sendfile(SSL *s, int fd, off_t offset, size_t size, int flags)
+{
+    ossl_ssize_t ret;
+    int err;
+
+    if (s->handshake_func == NULL) {
+        SSLerr(SSL_F_SSL_SENDFILE, SSL_R_UNINITIALIZED);
+        return -1;
+    }
+
+    if (s->shutdown & SSL_SENT_SHUTDOWN) {
+        s->rwstate = SSL_NOTHING;
+        SSLerr(SSL_F_SSL_SENDFILE, SSL_R_PROTOCOL_IS_SHUTDOWN);
+        return -1;
+    }
+
+    if (s->wbio == NULL || !BIO_get_ktls_send(s->wbio)) {
+        SSLerr(SSL_F_SSL_SENDFILE, SSL_R_KTLS_NOT_ENABLED);
+        return -1;
+    }
+
+    /* Data held back by SSL_MODE_CORK goes first */
+    if (s->rlayer.cork_len > 0 && ssl3_uncork(s) <= 0)
+        return -1;
+
+    /* A partially written SSL_write() record must be completed first */
+    if (RECORD_LAYER_write_pending(&s->rlayer)) {
+        SSLerr(SSL_F_SSL_SENDFILE, SSL_R_BAD_WRITE_RETRY);
+        return -1;
+    }
+
+    /* If we have an alert to send, lets send it */
+    if (s->s3->alert_dispatch) {
+        if (s->method->ssl_dispatch_alert(s) <= 0) {
+            /* SSLfatal() already called if appropriate */
+            return -1;
+        }
+    }
+
+    ssl_rec_stats_add(s, SSL_REC_STAT_FLUSHES, 1);
+    s->rwstate = SSL_WRITING;
+    if (BIO_flush(s->wbio) <= 0) {
+        if (!BIO_should_retry(s->wbio))
+            s->rwstate = SSL_NOTHING;
+        return -1;
+    }
+
+    clear_sys_error();
+    ret = ktls_sendfile(SSL_get_wfd(s), fd, offset, size, flags);
+    if (ret < 0) {
+        err = get_last_sys_error();
+        if (err == EAGAIN || err == EINTR || err == EWOULDBLOCK) {
+            BIO_set_retry_write(s->wbio);
+        } else {
+            s->rwstate = SSL_NOTHING;
+            SYSerr(SYS_F_SENDFILE, err);
+            SSLerr(SSL_F_SSL_SENDFILE, ERR_R_SYS_LIB);
+        }
+        return -1;
+    }
+    s->rwstate = SSL_NOTHING;
+    return ret;
+}
+#endif
+
 int SSL_write_early_data(SSL *s, const void *buf, size_t num, size_t *written)
 {
     int ret, early_data_state;
@@ -2069,8 +2267,10 @@ int SSL_write_early_data(SSL *s, const void *buf, size_t num, size_t *written)
         s->early_data_state = SSL_EARLY_DATA_UNAUTH_WRITING;
         ret = SSL_write_ex(s, buf, num, written);
         /* The buffering BIO is still in place */
-        if (ret)
+        if (ret) {
+            ssl_rec_stats_add(s, SSL_REC_STAT_FLUSHES, 1);
             (void)BIO_flush(s->wbio);
+        }
         s->early_data_state = early_data_state;
         return ret;
 
@@ -2236,6 +2436,22 @@ long SSL_ctrl(SSL *s, int cmd, long larg, void *parg)
             return 0;
         s->split_send_fragment = larg;
         return 1;
+    case SSL_CTRL_SET_DYNAMIC_RECORD_SIZE:
+        if (larg != 0 && (larg < 512 || larg > SSL3_RT_MAX_PLAIN_LENGTH))
+            return 0;
+        s->dynrec_size = larg;
+        s->dynrec_cur = 0;
+        return 1;
+    case SSL_CTRL_SET_DYNAMIC_RECORD_RAMP:
+        if (larg < 1)
+            return 0;
+        s->dynrec_ramp = larg;
+        return 1;
+    case SSL_CTRL_SET_DYNAMIC_RECORD_IDLE:
+        if (larg < 0)
+            return 0;
+        s->dynrec_idle = larg;
+        return 1;
     case SSL_CTRL_SET_MAX_PIPELINES:
         if (larg < 1 || larg > SSL_MAX_PIPELINES)
             return 0;
@@ -2303,7 +2519,7 @@ long SSL_callback_ctrl(SSL *s, int cmd, void (*fp) (void))
 
 LHASH_OF(SSL_SESSION) *SSL_CTX_sessions(SSL_CTX *ctx)
 {
-    return ctx->sessions;
+    return ctx->sess_shards[0].sessions;
 }
 
 long SSL_CTX_ctrl(SSL_CTX *ctx, int cmd, long larg, void *parg)
@@ -2353,6 +2569,16 @@ long SSL_CTX_ctrl(SSL_CTX *ctx, int cmd, long larg, void *parg)
         return l;
     case SSL_CTRL_GET_SESS_CACHE_SIZE:
         return (long)ctx->session_cache_size;
+    case SSL_CTRL_SET_SESS_CACHE_SHARDS:
+        /* Sessions can only be redistributed while there are none */
+        if (larg < 1 || larg > SSL_SESS_CACHE_MAX_SHARDS
+                || ssl_session_cache_number(ctx) != 0)
+            return 0;
+        if ((size_t)larg == ctx->sess_num_shards)
+            return 1;
+        return ssl_session_cache_new(ctx, (size_t)larg);
+    case SSL_CTRL_GET_SESS_CACHE_SHARDS:
+        return (long)ctx->sess_num_shards;
     case SSL_CTRL_SET_SESS_CACHE_MODE:
         l = ctx->session_cache_mode;
         ctx->session_cache_mode = larg;
@@ -2361,7 +2587,7 @@ long SSL_CTX_ctrl(SSL_CTX *ctx, int cmd, long larg, void *parg)
         return ctx->session_cache_mode;
 
     case SSL_CTRL_SESS_NUMBER:
-        return lh_SSL_SESSION_num_items(ctx->sessions);
+        return (long)ssl_session_cache_number(ctx);
     case SSL_CTRL_SESS_CONNECT:
         return tsan_load(&ctx->stats.sess_connect);
     case SSL_CTRL_SESS_CONNECT_GOOD:
@@ -2400,6 +2626,21 @@ long SSL_CTX_ctrl(SSL_CTX *ctx, int cmd, long larg, void *parg)
             return 0;
         ctx->split_send_fragment = larg;
         return 1;
+    case SSL_CTRL_SET_DYNAMIC_RECORD_SIZE:
+        if (larg != 0 && (larg < 512 || larg > SSL3_RT_MAX_PLAIN_LENGTH))
+            return 0;
+        ctx->dynrec_size = larg;
+        return 1;
+    case SSL_CTRL_SET_DYNAMIC_RECORD_RAMP:
+        if (larg < 1)
+            return 0;
+        ctx->dynrec_ramp = larg;
+        return 1;
+    case SSL_CTRL_SET_DYNAMIC_RECORD_IDLE:
+        if (larg < 0)
+            return 0;
+        ctx->dynrec_idle = larg;
+        return 1;
     case SSL_CTRL_SET_MAX_PIPELINES:
         if (larg < 1 || larg > SSL_MAX_PIPELINES)
             return 0;
@@ -2985,24 +3226,10 @@ int SSL_export_keying_material_early(SSL *s, unsigned char *out, size_t olen,
                                               context, contextlen);
 }
 
-static unsigned long ssl_session_hash(const SSL_SESSION *a)
+unsigned long ssl_session_hash(const SSL_SESSION *a)
 {
-    const unsigned char *session_id = a->session_id;
-    unsigned long l;
-    unsigned char tmp_storage[4];
-
-    if (a->session_id_length < sizeof(tmp_storage)) {
-        memset(tmp_storage, 0, sizeof(tmp_storage));
-        memcpy(tmp_storage, a->session_id, a->session_id_length);
-        session_id = tmp_storage;
-    }
-
-    l = (unsigned long)
-        ((unsigned long)session_id[0]) |
-        ((unsigned long)session_id[1] << 8L) |
-        ((unsigned long)session_id[2] << 16L) |
-        ((unsigned long)session_id[3] << 24L);
-    return l;
+    /* Session IDs can be chosen by the peer, so they are hashed with a key */
+    return OPENSSL_LH_keyed_hash(a->session_id, a->session_id_length);
 }
 
 /*
@@ -3012,7 +3239,7 @@ static unsigned long ssl_session_hash(const SSL_SESSION *a)
  * being able to construct an SSL_SESSION that will collide with any existing
  * session with a matching session ID.
  */
-static int ssl_session_cmp(const SSL_SESSION *a, const SSL_SESSION *b)
+int ssl_session_cmp(const SSL_SESSION *a, const SSL_SESSION *b)
 {
     if (a->ssl_version != b->ssl_version)
         return 1;
@@ -3037,7 +3264,7 @@ SSL_CTX *SSL_CTX_new(const SSL_METHOD *meth)
         return NULL;
     }
 
-    if (!OPENSSL_init_ssl(OPENSSL_INIT_LOAD_SSL_STRINGS, NULL))
+    if (!OPENSSL_init_ssl(0, NULL))
         return NULL;
 
     if (SSL_get_ex_data_X509_STORE_CTX_idx() < 0) {
@@ -3068,8 +3295,7 @@ SSL_CTX *SSL_CTX_new(const SSL_METHOD *meth)
     if ((ret->cert = ssl_cert_new()) == NULL)
         goto err;
 
-    ret->sessions = lh_SSL_SESSION_new(ssl_session_hash, ssl_session_cmp);
-    if (ret->sessions == NULL)
+    if (!ssl_session_cache_new(ret, 1))
         goto err;
     ret->cert_store = X509_STORE_new();
     if (ret->cert_store == NULL)
@@ -3121,8 +3347,11 @@ SSL_CTX *SSL_CTX_new(const SSL_METHOD *meth)
     if (!(meth->ssl3_enc->enc_flags & SSL_ENC_FLAG_DTLS))
         ret->comp_methods = SSL_COMP_get_compression_methods();
 
+    ret->freelist_max_len = SSL_MAX_BUF_FREELIST_LEN_DEFAULT;
     ret->max_send_fragment = SSL3_RT_MAX_PLAIN_LENGTH;
     ret->split_send_fragment = SSL3_RT_MAX_PLAIN_LENGTH;
+    ret->dynrec_ramp = SSL_DYNREC_RAMP_DEFAULT;
+    ret->dynrec_idle = SSL_DYNREC_IDLE_DEFAULT;
 
     /* Setup RFC5077 ticket keys */
     if ((RAND_bytes(ret->ext.tick_key_name,
@@ -3132,6 +3361,12 @@ SSL_CTX *SSL_CTX_new(const SSL_METHOD *meth)
         || (RAND_priv_bytes(ret->ext.secure->tick_aes_key,
                        sizeof(ret->ext.secure->tick_aes_key)) <= 0))
         ret->options |= SSL_OP_NO_TICKET;
+    if ((ret->ext.tick_hmac = HMAC_KEY_new()) == NULL
+            || !HMAC_KEY_set(ret->ext.tick_hmac,
+                             ret->ext.secure->tick_hmac_key,
+                             sizeof(ret->ext.secure->tick_hmac_key),
+                             EVP_sha256()))
+        goto err;
 
     if (RAND_priv_bytes(ret->ext.cookie_hmac_key,
                    sizeof(ret->ext.cookie_hmac_key)) <= 0)
@@ -3175,6 +3410,7 @@ SSL_CTX *SSL_CTX_new(const SSL_METHOD *meth)
     ret->options |= SSL_OP_NO_COMPRESSION | SSL_OP_ENABLE_MIDDLEBOX_COMPAT;
 
     ret->ext.status_type = TLSEXT_STATUSTYPE_nothing;
+    ret->ext.dtls_cid_len = -1;
 
     /*
      * We cannot usefully set a default max_early_data here (which gets
@@ -3229,6 +3465,76 @@ int SSL_CTX_up_ref(SSL_CTX *ctx)
     return ((i > 1) ? 1 : 0);
 }
 
+static int x509_chain_freeze(STACK_OF(X509) *chain)
+{
+    int i;
+
+    for (i = 0; i < sk_X509_num(chain); i++)
+        if (!X509_freeze(sk_X509_value(chain, i)))
+            return 0;
+    return 1;
+}
+
+/*
+ * Freezes the SSL_CTX and the certificates, keys and stores it holds, which
+ * every SSL created from it would otherwise take references to
+ */
+int SSL_CTX_freeze(SSL_CTX *ctx)
+{
+    CERT *c = ctx->cert;
+    int i;
+
+    for (i = 0; i < SSL_PKEY_NUM; i++) {
+        CERT_PKEY *cpk = &c->pkeys[i];
+
+        if ((cpk->x509 != NULL && !X509_freeze(cpk->x509))
+                || (cpk->privatekey != NULL
+                    && !EVP_PKEY_freeze(cpk->privatekey))
+                || !x509_chain_freeze(cpk->chain))
+            return 0;
+    }
+    if (!x509_chain_freeze(ctx->extra_certs)
+            || (ctx->cert_store != NULL
+                && !X509_STORE_freeze(ctx->cert_store))
+            || (c->verify_store != NULL
+                && !X509_STORE_freeze(c->verify_store))
+            || (c->chain_store != NULL && !X509_STORE_freeze(c->chain_store)))
+        return 0;
+    CRYPTO_REF_FREEZE(&ctx->references);
+    return 1;
+}
+
+#ifndef OPENSSL_NO_COMP
+static void cert_comp_free(SSL_CERT_COMP *cc)
+{
+    if (cc == NULL)
+        return;
+    OPENSSL_free(cc->raw);
+    OPENSSL_free(cc->comp);
+    OPENSSL_free(cc);
+}
+#endif
+
+#ifndef OPENSSL_NO_OCSP
+static void ocsp_staple_free(SSL_OCSP_STAPLE *staple)
+{
+    if (staple == NULL)
+        return;
+    X509_free(staple->x509);
+    OPENSSL_free(staple->resp);
+    OPENSSL_free(staple);
+}
+
+static void ocsp_verify_cache_free(SSL_OCSP_VERIFY_CACHE *cache)
+{
+    if (cache == NULL)
+        return;
+    OPENSSL_free(cache->slots);
+    CRYPTO_THREAD_lock_free(cache->lock);
+    OPENSSL_free(cache);
+}
+#endif
+
 void SSL_CTX_free(SSL_CTX *a)
 {
     int i;
@@ -3254,11 +3560,11 @@ void SSL_CTX_free(SSL_CTX *a)
      * free ex_data, then finally free the cache.
      * (See ticket [openssl.org #212].)
      */
-    if (a->sessions != NULL)
+    if (a->sess_shards != NULL)
         SSL_CTX_flush_sessions(a, 0);
 
     CRYPTO_free_ex_data(CRYPTO_EX_INDEX_SSL_CTX, a, &a->ex_data);
-    lh_SSL_SESSION_free(a->sessions);
+    ssl_session_cache_free(a);
     X509_STORE_free(a->cert_store);
 #ifndef OPENSSL_NO_CT
     CTLOG_STORE_free(a->ctlog_store);
@@ -3287,6 +3593,36 @@ void SSL_CTX_free(SSL_CTX *a)
 #endif
     OPENSSL_free(a->ext.alpn);
     OPENSSL_secure_free(a->ext.secure);
+    HMAC_KEY_free(a->ext.tick_hmac);
+    SSL_TICKET_KEY_RING_free(a->ext.tick_key_ring);
+    SSL_REPLAY_FILTER_free(a->replay_filter);
+    SSL_SNI_MAP_free(a->ext.sni_map);
+    ssl_hs_stats_free(a->hs_stats);
+    ssl_rec_stats_ctx_free(a->rec_stats);
+    ssl_peer_cert_cache_free(a->ext.tick_peer_cache);
+    ssl_client_cache_free(a->ext.client_cache);
+    ssl_dtls_cid_map_free(a->ext.dtls_cid_map);
+    ssl_ca_names_enc_clear(&a->ca_names_enc[0]);
+    ssl_ca_names_enc_clear(&a->ca_names_enc[1]);
+
+    OSSL_WORKER_POOL_free(a->oqs_kem_pool);
+    oqs_keypair_pool_free(a->oqs_keypair_pool);
+    OPENSSL_free(a->group_costs);
+    tls13_free_key_share_hints(a);
+    ssl_ecdhe_reuse_flush(a);
+    tls13_free_cached_info(a);
+    ssl3_buf_freelists_free(a);
+#ifndef OPENSSL_NO_OCSP
+    for (i = 0; i < SSL_PKEY_NUM; i++)
+        ocsp_staple_free(a->ext.ocsp_staples[i]);
+    ocsp_verify_cache_free(a->ext.ocsp_verify_cache);
+#endif
+#ifndef OPENSSL_NO_COMP
+    for (i = 0; i < SSL_PKEY_NUM; i++)
+        cert_comp_free(a->cert_comp_cache[i]);
+#endif
+    for (i = 0; i < SSL_PKEY_NUM; i++)
+        ssl_cert_msg_free(a->cert_msgs[i]);
 
     CRYPTO_THREAD_lock_free(a->lock);
 
@@ -3535,6 +3871,10 @@ void ssl_update_cache(SSL *s, int mode)
             && (s->verify_mode & SSL_VERIFY_PEER) != 0)
         return;
 
+    /* The client session cache is independent of the session cache mode */
+    if (!s->server && (!s->hit || SSL_IS_TLS13(s)))
+        ssl_client_cache_add(s);
+
     i = s->session_ctx->session_cache_mode;
     if ((i & mode) != 0
         && (!s->hit || SSL_IS_TLS13(s))) {
@@ -3552,8 +3892,7 @@ void ssl_update_cache(SSL *s, int mode)
         if ((i & SSL_SESS_CACHE_NO_INTERNAL_STORE) == 0
                 && (!SSL_IS_TLS13(s)
                     || !s->server
-                    || (s->max_early_data > 0
-                        && (s->options & SSL_OP_NO_ANTI_REPLAY) == 0)
+                    || SSL_ANTI_REPLAY_BY_CACHE(s)
                     || s->session_ctx->remove_session_cb != NULL
                     || (s->options & SSL_OP_NO_TICKET) != 0))
             SSL_CTX_add_session(s->session_ctx, s->session);
@@ -3578,7 +3917,9 @@ void ssl_update_cache(SSL *s, int mode)
         else
             stat = &s->session_ctx->stats.sess_accept_good;
         if ((tsan_load(stat) & 0xff) == 0xff)
-            SSL_CTX_flush_sessions(s->session_ctx, (unsigned long)time(NULL));
+            (void)SSL_CTX_flush_expired_sessions(s->session_ctx,
+                                                 (unsigned long)time(NULL),
+                                                 SSL_SESS_FLUSH_AUTO_MAX, 0);
     }
 }
 
@@ -4112,12 +4453,14 @@ SSL_CTX *SSL_get_SSL_CTX(const SSL *ssl)
 
 SSL_CTX *SSL_set_SSL_CTX(SSL *ssl, SSL_CTX *ctx)
 {
-    CERT *new_cert;
+    CERT *new_cert, *c;
     if (ssl->ctx == ctx)
         return ssl->ctx;
     if (ctx == NULL)
         ctx = ssl->session_ctx;
-    new_cert = ssl_cert_dup(ctx->cert);
+    c = ssl_ctx_get1_cert(ctx);
+    new_cert = ssl_cert_dup(c);
+    ssl_cert_free(c);
     if (new_cert == NULL) {
         return NULL;
     }
@@ -4540,6 +4883,65 @@ size_t SSL_CTX_get_num_tickets(const SSL_CTX *ctx)
     return ctx->num_tickets;
 }
 
+int SSL_CTX_set_cork_threshold(SSL_CTX *ctx, size_t threshold)
+{
+    if (threshold > SSL3_RT_MAX_PLAIN_LENGTH) {
+        SSLerr(SSL_F_SSL_CTX_SET_CORK_THRESHOLD, SSL_R_BAD_LENGTH);
+        return 0;
+    }
+    ctx->cork_threshold = threshold;
+    return 1;
+}
+
+size_t SSL_CTX_get_cork_threshold(const SSL_CTX *ctx)
+{
+    return ctx->cork_threshold;
+}
+
+int SSL_set_cork_threshold(SSL *s, size_t threshold)
+{
+    if (threshold > SSL3_RT_MAX_PLAIN_LENGTH) {
+        SSLerr(SSL_F_SSL_SET_CORK_THRESHOLD, SSL_R_BAD_LENGTH);
+        return 0;
+    }
+    s->cork_threshold = threshold;
+    return 1;
+}
+
+size_t SSL_get_cork_threshold(const SSL *s)
+{
+    return s->cork_threshold;
+}
+
+size_t SSL_get_corked_bytes(const SSL *s)
+{
+    return s->rlayer.cork_len;
+}
+
+int SSL_uncork(SSL *s)
+{
+    if (s->handshake_func == NULL) {
+        SSLerr(SSL_F_SSL_UNCORK, SSL_R_UNINITIALIZED);
+        return -1;
+    }
+
+    if (s->rlayer.cork_len == 0)
+        return 1;
+
+    if ((s->mode & SSL_MODE_ASYNC) && ASYNC_get_current_job() == NULL) {
+        struct ssl_async_args args;
+
+        memset(&args, 0, sizeof(args));
+        args.s = s;
+        args.type = OTHERFUNC;
+        args.f.func_other = ssl3_uncork;
+
+        return ssl_start_async_job(s, &args, ssl_io_intern);
+    } else {
+        return ssl3_uncork(s);
+    }
+}
+
 /*
  * Allocates new EVP_MD_CTX and sets pointer to it into given pointer
  * variable, freeing EVP_MD_CTX previously stored in that variable, if any.
@@ -4574,7 +4976,9 @@ int ssl_handshake_hash(SSL *s, unsigned char *out, size_t outlen,
     EVP_MD_CTX *hdgst = s->s3->handshake_dgst;
     int hashleni = EVP_MD_CTX_size(hdgst);
     int ret = 0;
+    SSL_HS_TIMER t;
 
+    ssl_hs_timer_start(s, &t);
     if (hashleni < 0 || (size_t)hashleni > outlen) {
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_HANDSHAKE_HASH,
                  ERR_R_INTERNAL_ERROR);
@@ -4596,6 +5000,7 @@ int ssl_handshake_hash(SSL *s, unsigned char *out, size_t outlen,
     }
 
     *hashlen = hashleni;
+    ssl_hs_timer_stop(s, SSL_HS_PHASE_TRANSCRIPT, &t);
 
     ret = 1;
  err:
@@ -5709,3 +6114,442 @@ void SSL_set_allow_early_data_cb(SSL *s,
     s->allow_early_data_cb = cb;
     s->allow_early_data_cb_data = arg;
 }
+
+#ifndef OPENSSL_NO_OCSP
+/*
+ * Find the earliest nextUpdate of the basic response |bs|. Sets |*expires|
+ * to 0 if no nextUpdate is given. Returns 0 if it has expired.
+ */
+static int ocsp_basic_expiry(OCSP_BASICRESP *bs, time_t *expires)
+{
+    time_t now = time(NULL);
+    int i;
+
+    *expires = 0;
+    for (i = 0; i < OCSP_resp_count(bs); i++) {
+        ASN1_GENERALIZEDTIME *nextupd = NULL;
+        int day, sec;
+        time_t t;
+
+        (void)OCSP_single_get0_status(OCSP_resp_get0(bs, i), NULL, NULL,
+                                      NULL, &nextupd);
+        if (nextupd == NULL)
+            continue;
+        if (!ASN1_TIME_diff(&day, &sec, NULL, nextupd)
+            || day < 0 || sec < 0 || (day == 0 && sec == 0))
+            return 0;
+        t = now + (time_t)day * 86400 + sec;
+        if (*expires == 0 || t < *expires)
+            *expires = t;
+    }
+    return 1;
+}
+
+/*
+ * Find when a successful OCSP response stops being usable, i.e. its earliest
+ * nextUpdate. Returns 1 and sets |*expires| to 0 if no nextUpdate is given,
+ * or 0 if the response is not successful or has expired.
+ */
+static int ocsp_staple_expiry(const unsigned char *resp, size_t len,
+                              time_t *expires)
+{
+    const unsigned char *p = resp;
+    OCSP_RESPONSE *rsp;
+    OCSP_BASICRESP *bs = NULL;
+    int ret = 0;
+
+    *expires = 0;
+    if (len > LONG_MAX
+        || (rsp = d2i_OCSP_RESPONSE(NULL, &p, (long)len)) == NULL)
+        return 0;
+    if (OCSP_response_status(rsp) == OCSP_RESPONSE_STATUS_SUCCESSFUL
+        && (bs = OCSP_response_get1_basic(rsp)) != NULL
+        && OCSP_resp_count(bs) > 0)
+        ret = ocsp_basic_expiry(bs, expires);
+
+    OCSP_BASICRESP_free(bs);
+    OCSP_RESPONSE_free(rsp);
+    return ret;
+}
+
+int SSL_CTX_set1_ocsp_staple(SSL_CTX *ctx, const unsigned char *resp,
+                             size_t len)
+{
+    SSL_OCSP_STAPLE *staple = NULL, *old;
+    CERT_PKEY *cpk = ctx->cert->key;
+    time_t expires;
+
+    if (cpk == NULL || cpk->x509 == NULL) {
+        SSLerr(SSL_F_SSL_CTX_SET1_OCSP_STAPLE, SSL_R_NO_CERTIFICATE_ASSIGNED);
+        return 0;
+    }
+    if (resp != NULL && len > 0) {
+        if (!ocsp_staple_expiry(resp, len, &expires)) {
+            SSLerr(SSL_F_SSL_CTX_SET1_OCSP_STAPLE, SSL_R_INVALID_OCSP_RESPONSE);
+            return 0;
+        }
+        if ((staple = OPENSSL_zalloc(sizeof(*staple))) == NULL
+            || (staple->resp = OPENSSL_memdup(resp, len)) == NULL) {
+            OPENSSL_free(staple);
+            SSLerr(SSL_F_SSL_CTX_SET1_OCSP_STAPLE, ERR_R_MALLOC_FAILURE);
+            return 0;
+        }
+        X509_up_ref(cpk->x509);
+        staple->x509 = cpk->x509;
+        staple->resp_len = len;
+        staple->expires = expires;
+    }
+
+    CRYPTO_THREAD_write_lock(ctx->lock);
+    old = ctx->ext.ocsp_staples[cpk - ctx->cert->pkeys];
+    ctx->ext.ocsp_staples[cpk - ctx->cert->pkeys] = staple;
+    CRYPTO_THREAD_unlock(ctx->lock);
+    ocsp_staple_free(old);
+    return 1;
+}
+
+/*
+ * Staple the response set with SSL_CTX_set1_ocsp_staple() for the
+ * certificate that will be sent, if there is one and it is still valid.
+ * Returns 0 on internal error.
+ */
+int ssl_get_ocsp_staple(SSL *s)
+{
+    SSL_CTX *ctx = s->ctx;
+    CERT_PKEY *cpk = s->s3->tmp.cert;
+    const SSL_OCSP_STAPLE *staple;
+    unsigned char *resp = NULL;
+    size_t resp_len = 0;
+
+    CRYPTO_THREAD_read_lock(ctx->lock);
+    staple = ctx->ext.ocsp_staples[cpk - s->cert->pkeys];
+    if (staple != NULL && staple->x509 == cpk->x509
+        && (staple->expires == 0 || time(NULL) < staple->expires)) {
+        resp = OPENSSL_memdup(staple->resp, staple->resp_len);
+        resp_len = staple->resp_len;
+    }
+    CRYPTO_THREAD_unlock(ctx->lock);
+
+    if (resp_len > 0 && resp == NULL) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_GET_OCSP_STAPLE,
+                 ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    if (resp != NULL) {
+        OPENSSL_free(s->ext.ocsp.resp);
+        s->ext.ocsp.resp = resp;
+        s->ext.ocsp.resp_len = resp_len;
+        s->ext.status_expected = 1;
+    }
+    return 1;
+}
+
+/* Upper bound for SSL_CTX_set_ocsp_verify_cache_size() */
+#define SSL_OCSP_VERIFY_CACHE_MAX       65536
+
+static SSL_OCSP_VERIFIED_SLOT *ocsp_verify_cache_slot(
+    SSL_OCSP_VERIFY_CACHE *cache, const unsigned char *digest)
+{
+    size_t idx = ((size_t)digest[0] << 24) | ((size_t)digest[1] << 16)
+                 | ((size_t)digest[2] << 8) | digest[3];
+
+    return &cache->slots[idx % cache->size];
+}
+
+/* Whether the response |digest| is the hash of was verified and is current */
+static int ocsp_verify_cache_hit(SSL_OCSP_VERIFY_CACHE *cache,
+                                 const unsigned char *digest)
+{
+    SSL_OCSP_VERIFIED_SLOT *slot = ocsp_verify_cache_slot(cache, digest);
+    int hit;
+
+    if (!CRYPTO_THREAD_read_lock(cache->lock))
+        return 0;
+    hit = slot->expires > time(NULL)
+          && memcmp(slot->digest, digest, SHA256_DIGEST_LENGTH) == 0;
+    CRYPTO_THREAD_unlock(cache->lock);
+    return hit;
+}
+
+static void ocsp_verify_cache_add(SSL_OCSP_VERIFY_CACHE *cache,
+                                  const unsigned char *digest, time_t expires)
+{
+    SSL_OCSP_VERIFIED_SLOT *slot = ocsp_verify_cache_slot(cache, digest);
+
+    if (!CRYPTO_THREAD_write_lock(cache->lock))
+        return;
+    memcpy(slot->digest, digest, SHA256_DIGEST_LENGTH);
+    slot->expires = expires;
+    CRYPTO_THREAD_unlock(cache->lock);
+}
+
+int SSL_CTX_set_ocsp_verify_cache_size(SSL_CTX *ctx, size_t size)
+{
+    SSL_OCSP_VERIFY_CACHE *cache = NULL;
+
+    if (size > SSL_OCSP_VERIFY_CACHE_MAX) {
+        SSLerr(SSL_F_SSL_CTX_SET_OCSP_VERIFY_CACHE_SIZE,
+               ERR_R_PASSED_INVALID_ARGUMENT);
+        return 0;
+    }
+    if (size > 0) {
+        if ((cache = OPENSSL_zalloc(sizeof(*cache))) == NULL
+                || (cache->slots = OPENSSL_zalloc(sizeof(*cache->slots)
+                                                  * size)) == NULL
+                || (cache->lock = CRYPTO_THREAD_lock_new()) == NULL) {
+            SSLerr(SSL_F_SSL_CTX_SET_OCSP_VERIFY_CACHE_SIZE,
+                   ERR_R_MALLOC_FAILURE);
+            ocsp_verify_cache_free(cache);
+            return 0;
+        }
+        cache->size = size;
+    }
+    ocsp_verify_cache_free(ctx->ext.ocsp_verify_cache);
+    ctx->ext.ocsp_verify_cache = cache;
+    return 1;
+}
+
+size_t SSL_CTX_get_ocsp_verify_cache_size(const SSL_CTX *ctx)
+{
+    return ctx->ext.ocsp_verify_cache != NULL
+           ? ctx->ext.ocsp_verify_cache->size : 0;
+}
+
+/*
+ * Check the OCSP response stapled by the server against its verified chain.
+ * The signature of a response only needs checking once, so when the SSL_CTX
+ * has a verify cache the digests of responses that passed are kept there
+ * until their nextUpdate. Whether the response covers the certificate and
+ * is current is checked every time.
+ */
+int SSL_check_ocsp_staple(SSL *s)
+{
+    const unsigned char *p = s->ext.ocsp.resp;
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SSL_OCSP_VERIFY_CACHE *cache = s->ctx->ext.ocsp_verify_cache;
+    STACK_OF(X509) *chain = s->verified_chain;
+    X509_STORE *store = s->cert->verify_store != NULL ? s->cert->verify_store
+                                                      : s->ctx->cert_store;
+    OCSP_RESPONSE *rsp = NULL;
+    OCSP_BASICRESP *bs = NULL;
+    OCSP_CERTID *id = NULL;
+    ASN1_GENERALIZEDTIME *thisupd, *nextupd;
+    time_t expires;
+    int status, ret = 0;
+
+    if (s->server || p == NULL || s->ext.ocsp.resp_len == 0
+            || s->ext.ocsp.resp_len > LONG_MAX
+            || s->session == NULL || chain == NULL || sk_X509_num(chain) < 2) {
+        SSLerr(SSL_F_SSL_CHECK_OCSP_STAPLE, SSL_R_INVALID_STATUS_RESPONSE);
+        return 0;
+    }
+    if ((rsp = d2i_OCSP_RESPONSE(NULL, &p,
+                                 (long)s->ext.ocsp.resp_len)) == NULL
+            || OCSP_response_status(rsp) != OCSP_RESPONSE_STATUS_SUCCESSFUL
+            || (bs = OCSP_response_get1_basic(rsp)) == NULL) {
+        SSLerr(SSL_F_SSL_CHECK_OCSP_STAPLE, SSL_R_INVALID_STATUS_RESPONSE);
+        goto end;
+    }
+
+    if (cache != NULL
+            && !EVP_Digest(s->ext.ocsp.resp, s->ext.ocsp.resp_len, digest,
+                           NULL, EVP_sha256(), NULL)) {
+        SSLerr(SSL_F_SSL_CHECK_OCSP_STAPLE, ERR_R_EVP_LIB);
+        ret = -1;
+        goto end;
+    }
+    if (cache == NULL || !ocsp_verify_cache_hit(cache, digest)) {
+        if (OCSP_basic_verify(bs, s->session->peer_chain, store, 0) <= 0) {
+            SSLerr(SSL_F_SSL_CHECK_OCSP_STAPLE, SSL_R_INVALID_STATUS_RESPONSE);
+            goto end;
+        }
+        /* Responses without a nextUpdate are not cached */
+        if (cache != NULL && ocsp_basic_expiry(bs, &expires) && expires != 0)
+            ocsp_verify_cache_add(cache, digest, expires);
+    }
+
+    if ((id = OCSP_cert_to_id(NULL, sk_X509_value(chain, 0),
+                              sk_X509_value(chain, 1))) == NULL) {
+        SSLerr(SSL_F_SSL_CHECK_OCSP_STAPLE, ERR_R_INTERNAL_ERROR);
+        ret = -1;
+        goto end;
+    }
+    if (!OCSP_resp_find_status(bs, id, &status, NULL, NULL, &thisupd,
+                               &nextupd)
+            || status != V_OCSP_CERTSTATUS_GOOD
+            || !OCSP_check_validity(thisupd, nextupd, 300, -1)) {
+        SSLerr(SSL_F_SSL_CHECK_OCSP_STAPLE, SSL_R_INVALID_STATUS_RESPONSE);
+        goto end;
+    }
+    ret = 1;
+
+ end:
+    OCSP_CERTID_free(id);
+    OCSP_BASICRESP_free(bs);
+    OCSP_RESPONSE_free(rsp);
+    return ret;
+}
+#endif
+
+#ifndef OPENSSL_NO_COMP
+/*
+ * The compression method for the RFC 8879 algorithm |alg|, or NULL if it is
+ * not available.
+ */
+COMP_METHOD *ssl_cert_comp_method(int alg)
+{
+    COMP_METHOD *meth = NULL;
+
+    switch (alg) {
+    case TLSEXT_comp_cert_zlib:
+        meth = COMP_zlib_oneshot();
+        break;
+    }
+    if (meth == NULL || COMP_get_type(meth) == NID_undef)
+        return NULL;
+    return meth;
+}
+
+static int ssl_set_cert_comp_preference(int *prefs, size_t *prefs_len,
+                                        const int *algs, size_t len)
+{
+    size_t i, j;
+
+    if (len > SSL_CERT_COMP_NUM) {
+        SSLerr(SSL_F_SSL_SET_CERT_COMP_PREFERENCE,
+               SSL_R_BAD_CERT_COMPRESSION_ALGORITHM);
+        return 0;
+    }
+    for (i = 0; i < len; i++) {
+        for (j = 0; j < i; j++)
+            if (algs[j] == algs[i])
+                break;
+        if (j < i || ssl_cert_comp_method(algs[i]) == NULL) {
+            SSLerr(SSL_F_SSL_SET_CERT_COMP_PREFERENCE,
+                   SSL_R_BAD_CERT_COMPRESSION_ALGORITHM);
+            return 0;
+        }
+    }
+    for (i = 0; i < len; i++)
+        prefs[i] = algs[i];
+    *prefs_len = len;
+    return 1;
+}
+#endif
+
+int SSL_CTX_set1_cert_comp_preference(SSL_CTX *ctx, const int *algs,
+                                      size_t len)
+{
+#ifndef OPENSSL_NO_COMP
+    return ssl_set_cert_comp_preference(ctx->cert_comp_prefs,
+                                        &ctx->cert_comp_prefs_len, algs, len);
+#else
+    return len == 0;
+#endif
+}
+
+int SSL_set1_cert_comp_preference(SSL *s, const int *algs, size_t len)
+{
+#ifndef OPENSSL_NO_COMP
+    return ssl_set_cert_comp_preference(s->cert_comp_prefs,
+                                        &s->cert_comp_prefs_len, algs, len);
+#else
+    return len == 0;
+#endif
+}
+
+#ifndef OPENSSL_NO_COMP
+/*
+ * Compress the Certificate message body |raw| with the negotiated algorithm
+ * into a newly allocated |*comp|. The certificates of a server rarely change,
+ * so the last result for each of them is kept in the SSL_CTX and reused as
+ * long as the message is the same. Returns 0 on internal error.
+ */
+int ssl_cert_comp_compress(SSL *s, const unsigned char *raw, size_t raw_len,
+                           unsigned char **comp, size_t *comp_len)
+{
+    SSL_CTX *ctx = s->ctx;
+    size_t idx = s->s3->tmp.cert - s->cert->pkeys;
+    int alg = s->ext.cert_comp;
+    const SSL_CERT_COMP *cached;
+    SSL_CERT_COMP *cc = NULL, *old;
+    COMP_METHOD *meth = ssl_cert_comp_method(alg);
+    COMP_CTX *cctx = NULL;
+    size_t max;
+    int len;
+
+    *comp = NULL;
+    CRYPTO_THREAD_read_lock(ctx->lock);
+    cached = ctx->cert_comp_cache[idx];
+    if (cached != NULL && cached->alg == alg && cached->raw_len == raw_len
+            && memcmp(cached->raw, raw, raw_len) == 0) {
+        *comp = OPENSSL_memdup(cached->comp, cached->comp_len);
+        *comp_len = cached->comp_len;
+    }
+    CRYPTO_THREAD_unlock(ctx->lock);
+    if (*comp != NULL)
+        return 1;
+
+    /* Incompressible data grows by a few bytes per 16k block, plus a header */
+    max = raw_len + (raw_len >> 12) + (raw_len >> 14) + 64;
+    if (meth == NULL || max > INT_MAX) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_CERT_COMP_COMPRESS,
+                 ERR_R_INTERNAL_ERROR);
+        return 0;
+    }
+    if ((cc = OPENSSL_zalloc(sizeof(*cc))) == NULL
+            || (cc->raw = OPENSSL_memdup(raw, raw_len)) == NULL
+            || (cc->comp = OPENSSL_malloc(max)) == NULL
+            || (cctx = COMP_CTX_new(meth)) == NULL) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_CERT_COMP_COMPRESS,
+                 ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+    len = COMP_compress_block(cctx, cc->comp, (int)max, cc->raw, (int)raw_len);
+    COMP_CTX_free(cctx);
+    if (len <= 0) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_CERT_COMP_COMPRESS,
+                 ERR_R_INTERNAL_ERROR);
+        goto err;
+    }
+    cc->alg = alg;
+    cc->raw_len = raw_len;
+    cc->comp_len = len;
+    if ((*comp = OPENSSL_memdup(cc->comp, cc->comp_len)) == NULL) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_CERT_COMP_COMPRESS,
+                 ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+    *comp_len = cc->comp_len;
+
+    CRYPTO_THREAD_write_lock(ctx->lock);
+    old = ctx->cert_comp_cache[idx];
+    ctx->cert_comp_cache[idx] = cc;
+    CRYPTO_THREAD_unlock(ctx->lock);
+    cert_comp_free(old);
+    return 1;
+ err:
+    cert_comp_free(cc);
+    return 0;
+}
+
+/*
+ * Decompress |in| with |alg| into |out|, which it must fill exactly. Returns
+ * 0 if the data is not valid.
+ */
+int ssl_cert_comp_expand(int alg, const unsigned char *in, size_t in_len,
+                         unsigned char *out, size_t out_len)
+{
+    COMP_METHOD *meth = ssl_cert_comp_method(alg);
+    COMP_CTX *cctx;
+    int len;
+
+    if (meth == NULL || in_len > INT_MAX || out_len > INT_MAX
+            || (cctx = COMP_CTX_new(meth)) == NULL)
+        return 0;
+    len = COMP_expand_block(cctx, out, (int)out_len, (unsigned char *)in,
+                            (int)in_len);
+    COMP_CTX_free(cctx);
+    return len >= 0 && (size_t)len == out_len;
+}
+#endif
@@ -34,6 +34,7 @@
 # include "internal/dane.h"
 # include "internal/refcount.h"
 # include "internal/tsan_assist.h"
+# include "internal/metrics.h"
 #include <oqs/oqs.h>
 
 # ifdef OPENSSL_BUILD_SHLIBSSL
@@ -460,6 +461,12 @@
 #define SSL_PKEY_NUM 32
 ///// OQS_TEMPLATE_FRAGMENT_DEFINE_SSL_PKEYS_END
 
+/*
+ * Number of 64-bit words in a bitset over the signature algorithm table in
+ * t1_lib.c, which has one entry for each classical and OQS scheme.
+ */
+# define SSL_SIGALG_WORDS 2
+
 /*-
  * SSL_kRSA <- RSA_ENC
  * SSL_kDH  <- DH_ENC & (RSA_ENC | RSA_SIGN | DSA_SIGN)
@@ -513,27 +520,37 @@
     (nid == NID_p256_hqc128 ? 0x2F2C : \
     (nid == NID_p384_hqc192 ? 0x2F2D : \
     (nid == NID_p521_hqc256 ? 0x2F2E : \
+    (nid == NID_x25519_frodo640aes ? 0x2F80 : \
+    (nid == NID_x25519_frodo640shake ? 0x2F81 : \
+    (nid == NID_x448_frodo976aes ? 0x2F82 : \
+    (nid == NID_x448_frodo976shake ? 0x2F83 : \
+    (nid == NID_x25519_kyber512 ? 0x2F39 : \
+    (nid == NID_x448_kyber768 ? 0x2F90 : \
+    (nid == NID_x25519_bikel1 ? 0x2FAE : \
+    (nid == NID_x448_bikel3 ? 0x2FAF : \
+    (nid == NID_x25519_hqc128 ? 0x2FAC : \
+    (nid == NID_x448_hqc192 ? 0x2FAD : \
   0 \
-  )))))))))))))))
+  )))))))))))))))))))))))))
 ///// OQS_TEMPLATE_FRAGMENT_OQS_KEM_HYBRID_CURVEID_END
 
   /* Returns the non-hybrid OQS KEM NID for a PQ or hybrid curve ID */
 ///// OQS_TEMPLATE_FRAGMENT_OQS_KEM_NID_START
 #define OQS_KEM_NID(curveID) \
-  (curveID == 0x0200 || curveID == 0x2F00 ? NID_frodo640aes : \
-  (curveID == 0x0201 || curveID == 0x2F01 ? NID_frodo640shake : \
-  (curveID == 0x0202 || curveID == 0x2F02 ? NID_frodo976aes : \
-  (curveID == 0x0203 || curveID == 0x2F03 ? NID_frodo976shake : \
+  (curveID == 0x0200 || curveID == 0x2F00 || curveID == 0x2F80 ? NID_frodo640aes : \
+  (curveID == 0x0201 || curveID == 0x2F01 || curveID == 0x2F81 ? NID_frodo640shake : \
+  (curveID == 0x0202 || curveID == 0x2F02 || curveID == 0x2F82 ? NID_frodo976aes : \
+  (curveID == 0x0203 || curveID == 0x2F03 || curveID == 0x2F83 ? NID_frodo976shake : \
   (curveID == 0x0204 || curveID == 0x2F04 ? NID_frodo1344aes : \
   (curveID == 0x0205 || curveID == 0x2F05 ? NID_frodo1344shake : \
-  (curveID == 0x023A || curveID == 0x2F3A ? NID_kyber512 : \
-  (curveID == 0x023C || curveID == 0x2F3C ? NID_kyber768 : \
+  (curveID == 0x023A || curveID == 0x2F3A || curveID == 0x2F39 ? NID_kyber512 : \
+  (curveID == 0x023C || curveID == 0x2F3C || curveID == 0x2F90 ? NID_kyber768 : \
   (curveID == 0x023D || curveID == 0x2F3D ? NID_kyber1024 : \
-  (curveID == 0x0241 || curveID == 0x2F41 ? NID_bikel1 : \
-  (curveID == 0x0242 || curveID == 0x2F42 ? NID_bikel3 : \
+  (curveID == 0x0241 || curveID == 0x2F41 || curveID == 0x2FAE ? NID_bikel1 : \
+  (curveID == 0x0242 || curveID == 0x2F42 || curveID == 0x2FAF ? NID_bikel3 : \
   (curveID == 0x0243 || curveID == 0x2F43 ? NID_bikel5 : \
-  (curveID == 0x022C || curveID == 0x2F2C ? NID_hqc128 : \
-  (curveID == 0x022D || curveID == 0x2F2D ? NID_hqc192 : \
+  (curveID == 0x022C || curveID == 0x2F2C || curveID == 0x2FAC ? NID_hqc128 : \
+  (curveID == 0x022D || curveID == 0x2F2D || curveID == 0x2FAD ? NID_hqc192 : \
   (curveID == 0x022E || curveID == 0x2F2E ? NID_hqc256 : \
   0 \
   )))))))))))))))
@@ -557,8 +574,18 @@
     (curveID == 0x2F2C ? NID_p256_hqc128 : \
     (curveID == 0x2F2D ? NID_p384_hqc192 : \
     (curveID == 0x2F2E ? NID_p521_hqc256 : \
+    (curveID == 0x2F80 ? NID_x25519_frodo640aes : \
+    (curveID == 0x2F81 ? NID_x25519_frodo640shake : \
+    (curveID == 0x2F82 ? NID_x448_frodo976aes : \
+    (curveID == 0x2F83 ? NID_x448_frodo976shake : \
+    (curveID == 0x2F39 ? NID_x25519_kyber512 : \
+    (curveID == 0x2F90 ? NID_x448_kyber768 : \
+    (curveID == 0x2FAE ? NID_x25519_bikel1 : \
+    (curveID == 0x2FAF ? NID_x448_bikel3 : \
+    (curveID == 0x2FAC ? NID_x25519_hqc128 : \
+    (curveID == 0x2FAD ? NID_x448_hqc192 : \
   0 \
-  )))))))))))))))
+  )))))))))))))))))))))))))
 ///// OQS_TEMPLATE_FRAGMENT_OQS_HYBRID_KEM_NID_END
 
 /* Returns true if the curve ID is for an OQS KEM */
@@ -610,8 +637,18 @@
   (cid == 0x2F2C ?23: \
   (cid == 0x2F2D ?24: \
   (cid == 0x2F2E ?25: \
+  (cid == 0x2F80 ?29: \
+  (cid == 0x2F81 ?29: \
+  (cid == 0x2F82 ?30: \
+  (cid == 0x2F83 ?30: \
+  (cid == 0x2F39 ?29: \
+  (cid == 0x2F90 ?30: \
+  (cid == 0x2FAE ?29: \
+  (cid == 0x2FAF ?30: \
+  (cid == 0x2FAC ?29: \
+  (cid == 0x2FAD ?30: \
   23 \
-  ))))))))))))))))
+  ))))))))))))))))))))))))))
 ///// OQS_TEMPLATE_FRAGMENT_OQS_MAP_HYBRID_END
 
 /* Returns the classical nid for an hybrid alg */
@@ -721,6 +758,55 @@ struct ssl_method_st {
  * Look in ssl/ssl_asn1.c for more details
  * I'm using EXPLICIT tags so I can read the damn things using asn1parse :-).
  */
+# define SSL_PEER_DIGEST_LENGTH  32
+
+/*
+ * Peer certificates left out of session tickets, indexed by the low bits
+ * of their SHA-256: a new certificate replaces whatever shared its slot.
+ */
+typedef struct {
+    unsigned char digest[SSL_PEER_DIGEST_LENGTH];
+    X509 *cert;
+} SSL_PEER_CERT_SLOT;
+
+typedef struct {
+    CRYPTO_RWLOCK *lock;
+    size_t size;
+    SSL_PEER_CERT_SLOT *slots;
+} SSL_PEER_CERT_CACHE;
+
+typedef struct ssl_client_cache_st SSL_CLIENT_CACHE;
+
+typedef struct ssl_dtls_cid_map_st SSL_DTLS_CID_MAP;
+
+/* DTLS connection IDs (RFC 9146) of a connection, see d1_cid.c */
+typedef struct {
+    /* Length of the CID to pick at random, -1 to not use CIDs */
+    int gen_len;
+    /* Our CID, which the peer puts in the records it sends us */
+    unsigned char cid[DTLS1_MAX_CID_LENGTH];
+    size_t cid_len;
+    /* |cid| was set with SSL_set1_dtls_cid() */
+    int cid_set;
+    /* |cid| was picked at random for this connection */
+    int cid_picked;
+    /* The CID the peer wants in the records we send */
+    unsigned char peer_cid[DTLS1_MAX_CID_LENGTH];
+    size_t peer_cid_len;
+    /* The client offered CIDs in this handshake */
+    int peer_offered;
+    /* Both sides agreed to use CIDs */
+    int negotiated;
+    /* |cid| is in the CID map of the session context */
+    int registered;
+} SSL_DTLS_CID;
+
+/* Whether the records sent and received carry a connection ID */
+# define DTLS_CID_SENDING(s) \
+    ((s)->dtls_cid.negotiated && (s)->dtls_cid.peer_cid_len > 0)
+# define DTLS_CID_RECEIVING(s) \
+    ((s)->dtls_cid.negotiated && (s)->dtls_cid.cid_len > 0)
+
 struct ssl_session_st {
     int ssl_version;            /* what ssl version session info is being kept
                                  * in here? */
@@ -757,6 +843,12 @@ struct ssl_session_st {
     X509 *peer;
     /* Certificate chain peer sent. */
     STACK_OF(X509) *peer_chain;
+    /*
+     * SHA-256 of the peer certificate when a ticket carried that instead
+     * of the certificate, see SSL_CTX_set_ticket_peer_cert_cache_size()
+     */
+    size_t peer_digest_len;
+    unsigned char peer_digest[SSL_PEER_DIGEST_LENGTH];
     /*
      * when app_verify_callback accepts a session where the peer's
      * certificate is not ok, we must remember the error for session reuse:
@@ -866,6 +958,15 @@ typedef enum {
  */
 # define TICKET_AGE_ALLOWANCE   (10 * 1000)
 
+/*
+ * Whether early data replays are detected by caching every TLSv1.3 ticket
+ * and accepting it only once, as opposed to with an SSL_REPLAY_FILTER
+ */
+# define SSL_ANTI_REPLAY_BY_CACHE(s) \
+    ((s)->max_early_data > 0 \
+     && ((s)->options & SSL_OP_NO_ANTI_REPLAY) == 0 \
+     && (s)->session_ctx->replay_filter == NULL)
+
 #define MAX_COMPRESSIONS_SIZE   255
 
 struct ssl_comp_st {
@@ -932,6 +1033,9 @@ typedef enum tlsext_index_en {
     TLSEXT_IDX_cryptopro_bug,
     TLSEXT_IDX_early_data,
     TLSEXT_IDX_certificate_authorities,
+    TLSEXT_IDX_compress_certificate,
+    TLSEXT_IDX_cached_info,
+    TLSEXT_IDX_connection_id,
     TLSEXT_IDX_padding,
     TLSEXT_IDX_psk,
     /* Dummy index - must always be the last entry */
@@ -942,14 +1046,170 @@ DEFINE_LHASH_OF(SSL_SESSION);
 /* Needed in ssl_cert.c */
 DEFINE_LHASH_OF(X509_NAME);
 
+/*
+ * One part of the internal session cache. A session belongs to the shard
+ * picked by its session ID; the shard lock protects the hash and the list,
+ * which is ordered by expiry time with the session that expires last first.
+ */
+typedef struct ssl_sess_shard_st {
+    CRYPTO_RWLOCK *lock;
+    LHASH_OF(SSL_SESSION) *sessions;
+    struct ssl_session_st *head;
+    struct ssl_session_st *tail;
+} SSL_SESS_SHARD;
+
+# define SSL_SESS_CACHE_MAX_SHARDS 256
+
+/* Most sessions the automatic flush of the session cache expires at once */
+# define SSL_SESS_FLUSH_AUTO_MAX 1024
+
 # define TLSEXT_KEYNAME_LENGTH  16
 # define TLSEXT_TICK_KEY_LENGTH 32
 
+/* Worker pool for offloaded OQS KEM operations, see ssl_oqs.c */
+/* Pre-generated client KEM keypairs, see ssl_oqs.c */
+typedef struct oqs_keypair_pool_st OQS_KEYPAIR_POOL;
+
+/* A group a server asked for, see tls13_get_key_share_hint() */
+typedef struct ssl_key_share_hint_st {
+    char *hostname;
+    uint16_t group_id;
+} SSL_KEY_SHARE_HINT;
+
+/* A server ECDHE key kept for reuse, see ssl_generate_pkey_reuse() */
+typedef struct ssl_ecdhe_reuse_st {
+    uint16_t group_id;
+    EVP_PKEY *pkey;
+    unsigned int uses;
+    time_t created;
+} SSL_ECDHE_REUSE;
+
+/* Slots for reused ECDHE keys, direct mapped by group */
+# define SSL_ECDHE_REUSE_NUM 8
+
+/* RFC 7924 CachedInformationType for the server certificate chain */
+# define TLSEXT_cached_info_cert 1
+
+/* A server Certificate message kept by a client, see tls13_get_cached_info() */
+typedef struct ssl_cached_info_st {
+    char *hostname;
+    unsigned char *cert_msg;
+    size_t cert_msg_len;
+    /* SHA-256 of the certificate_list, as sent in cached_info */
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+} SSL_CACHED_INFO;
+
+/* No cached certificate chain is involved */
+# define SSL_CACHED_INFO_NONE     0
+/* The client offered the hash of a chain it has */
+# define SSL_CACHED_INFO_OFFERED  1
+/* The server Certificate message only carries that hash */
+# define SSL_CACHED_INFO_USED     2
+
+/*
+ * Record buffers released by the SSL objects of a context, kept for reuse.
+ * The link to the next buffer is stored in the free buffer itself.
+ */
+typedef struct ssl3_buf_freelist_entry_st {
+    struct ssl3_buf_freelist_entry_st *next;
+} SSL3_BUF_FREELIST_ENTRY;
+
+typedef struct ssl3_buf_freelist_st {
+    /* size of every buffer on the list */
+    size_t chunklen;
+    /* number of buffers on the list */
+    size_t len;
+    SSL3_BUF_FREELIST_ENTRY *head;
+} SSL3_BUF_FREELIST;
+
+# define SSL_MAX_BUF_FREELIST_LEN_DEFAULT 32
+
+/* Records written at each dynamic record size, and the idle time in ms */
+# define SSL_DYNREC_RAMP_DEFAULT 40
+# define SSL_DYNREC_IDLE_DEFAULT 1000
+
+/* Wall clock and thread CPU time in ns, or time spent in a handshake phase */
+typedef struct {
+    uint64_t wall;
+    uint64_t cpu;
+} SSL_HS_TIMER;
+
+typedef struct {
+    /* When the handshake started, or 0 if it isn't timed */
+    uint64_t start;
+    /* Thread CPU time when the state machine was last entered */
+    uint64_t cpu_entry;
+    /* Time spent in each phase so far, the state machine for the handshake */
+    SSL_HS_TIMER phase[SSL_HS_PHASE_NUM];
+} SSL_HS_TIMES;
+
+typedef struct ssl_hs_stats_st SSL_HS_STATS;
+typedef struct ssl_rec_stats_st SSL_REC_STATS;
+
+/* A session ticket key, as handed out by an SSL_TICKET_KEY_RING */
+typedef struct {
+    unsigned char name[TLSEXT_KEYNAME_LENGTH];
+    unsigned char hmac_key[TLSEXT_TICK_KEY_LENGTH];
+    unsigned char aes_key[TLSEXT_TICK_KEY_LENGTH];
+} SSL_TICKET_KEY;
+
 typedef struct ssl_ctx_ext_secure_st {
     unsigned char tick_hmac_key[TLSEXT_TICK_KEY_LENGTH];
     unsigned char tick_aes_key[TLSEXT_TICK_KEY_LENGTH];
 } SSL_CTX_EXT_SECURE;
 
+/* An OCSP response to staple for one of the certificates of an SSL_CTX */
+typedef struct ssl_ocsp_staple_st {
+    /* The certificate the response is for */
+    X509 *x509;
+    unsigned char *resp;
+    size_t resp_len;
+    /* Earliest nextUpdate of the response, 0 if none */
+    time_t expires;
+} SSL_OCSP_STAPLE;
+
+/*
+ * The SHA-256 of a stapled OCSP response whose signature was verified, and
+ * its earliest nextUpdate. Direct-mapped by digest.
+ */
+typedef struct {
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    time_t expires;
+} SSL_OCSP_VERIFIED_SLOT;
+
+typedef struct {
+    CRYPTO_RWLOCK *lock;
+    size_t size;
+    SSL_OCSP_VERIFIED_SLOT *slots;
+} SSL_OCSP_VERIFY_CACHE;
+
+/*
+ * The encoded certificate_authorities list of an SSL_CTX CA list, without
+ * its length. It is valid while the list is |names| and holds |num| names.
+ */
+typedef struct {
+    const STACK_OF(X509_NAME) *names;
+    int num;
+    unsigned char *der;
+    size_t len;
+} SSL_CA_NAMES_ENC;
+
+/* Number of certificate compression algorithms defined by RFC 8879 */
+# define SSL_CERT_COMP_NUM 3
+
+/* A compressed Certificate message of an SSL_CTX, for reuse */
+typedef struct ssl_cert_comp_st {
+    int alg;
+    /* The Certificate message body it was compressed from */
+    unsigned char *raw;
+    size_t raw_len;
+    unsigned char *comp;
+    size_t comp_len;
+} SSL_CERT_COMP;
+
+/* An encoded certificate_list of an SSL_CTX, for reuse */
+typedef struct ssl_cert_msg_st SSL_CERT_MSG;
+
 struct ssl_ctx_st {
     const SSL_METHOD *method;
     STACK_OF(SSL_CIPHER) *cipher_list;
@@ -958,14 +1218,15 @@ struct ssl_ctx_st {
     /* TLSv1.3 specific ciphersuites */
     STACK_OF(SSL_CIPHER) *tls13_ciphersuites;
     struct x509_store_st /* X509_STORE */ *cert_store;
-    LHASH_OF(SSL_SESSION) *sessions;
+    /* The internal session cache, split into |sess_num_shards| shards */
+    SSL_SESS_SHARD *sess_shards;
+    size_t sess_num_shards;
     /*
      * Most session-ids that will be cached, default is
-     * SSL_SESSION_CACHE_MAX_SIZE_DEFAULT. 0 is unlimited.
+     * SSL_SESSION_CACHE_MAX_SIZE_DEFAULT. 0 is unlimited. Each shard holds
+     * its share of them.
      */
     size_t session_cache_size;
-    struct ssl_session_st *session_cache_head;
-    struct ssl_session_st *session_cache_tail;
     /*
      * This can have one of 2 values, ored together, SSL_SESS_CACHE_CLIENT,
      * SSL_SESS_CACHE_SERVER, Default is SSL_SESSION_CACHE_SERVER, which
@@ -1068,6 +1329,13 @@ struct ssl_ctx_st {
      */
     STACK_OF(X509_NAME) *ca_names;
     STACK_OF(X509_NAME) *client_ca_names;
+    /*
+     * Encodings of client_ca_names and ca_names, see construct_ca_names().
+     * Protected by the SSL_CTX lock.
+     */
+    SSL_CA_NAMES_ENC ca_names_enc[2];
+    /* Upper bound on the encoded CA list, 0 for none */
+    size_t max_ca_names_len;
 
     /*
      * Default values to use in SSL structures follow (these are copied by
@@ -1122,6 +1390,16 @@ struct ssl_ctx_st {
      */
     size_t max_send_fragment;
 
+    /*
+     * Dynamic record sizing: application data starts out in records of
+     * |dynrec_size| bytes (0 disables this), the size doubles after every
+     * |dynrec_ramp| records up to |max_send_fragment| and goes back to the
+     * start once nothing was written for |dynrec_idle| milliseconds
+     */
+    size_t dynrec_size;
+    size_t dynrec_ramp;
+    unsigned long dynrec_idle;
+
     /* Up to how many pipelines should we use? If 0 then 1 is assumed */
     size_t max_pipelines;
 
@@ -1144,9 +1422,23 @@ struct ssl_ctx_st {
         /* TLS extensions servername callback */
         int (*servername_cb) (SSL *, int *, void *);
         void *servername_arg;
+        /* Used before servername_cb to pick the SSL_CTX, see ssl_sni.c */
+        SSL_SNI_MAP *sni_map;
         /* RFC 4507 session ticket keys */
         unsigned char tick_key_name[TLSEXT_KEYNAME_LENGTH];
         SSL_CTX_EXT_SECURE *secure;
+        /* The HMAC states for secure->tick_hmac_key */
+        HMAC_KEY *tick_hmac;
+        /* Used instead of the keys above when set, see ssl_tkring.c */
+        SSL_TICKET_KEY_RING *tick_key_ring;
+        /* Peer certificates replaced by their digest in tickets */
+        SSL_PEER_CERT_CACHE *tick_peer_cache;
+        /* Sessions pooled for new client connections, see ssl_ccache.c */
+        SSL_CLIENT_CACHE *client_cache;
+        /* Length of DTLS connection IDs to pick, -1 for none */
+        int dtls_cid_len;
+        /* Connections by DTLS connection ID, see d1_cid.c */
+        SSL_DTLS_CID_MAP *dtls_cid_map;
         /* Callback to support customisation of ticket key setting */
         int (*ticket_key_cb) (SSL *ssl,
                               unsigned char *name, unsigned char *iv,
@@ -1156,6 +1448,14 @@ struct ssl_ctx_st {
         /* Callback for status request */
         int (*status_cb) (SSL *ssl, void *arg);
         void *status_arg;
+        /*
+         * OCSP responses stapled when there is no status_cb, indexed like
+         * CERT pkeys, see SSL_CTX_set1_ocsp_staple(). Protected by the
+         * SSL_CTX lock.
+         */
+        SSL_OCSP_STAPLE *ocsp_staples[SSL_PKEY_NUM];
+        /* Stapled responses already verified, see SSL_check_ocsp_staple() */
+        SSL_OCSP_VERIFY_CACHE *ocsp_verify_cache;
         /* ext status type used for CSR extension (OCSP Stapling) */
         int status_type;
         /* RFC 4366 Maximum Fragment Length Negotiation */
@@ -1275,12 +1575,63 @@ struct ssl_ctx_st {
     /* The number of TLS1.3 tickets to automatically send */
     size_t num_tickets;
 
+    /* Bytes SSL_MODE_CORK collects before writing, 0 for a full record */
+    size_t cork_threshold;
+
     /* Callback to determine if early_data is acceptable or not */
     SSL_allow_early_data_cb_fn allow_early_data_cb;
     void *allow_early_data_cb_data;
 
+    /* Detects early data replays instead of the session cache, if set */
+    SSL_REPLAY_FILTER *replay_filter;
+
+    /* Handshake phase timings, if enabled */
+    SSL_HS_STATS *hs_stats;
+    /* Record layer counters of the SSL objects freed so far, if enabled */
+    SSL_REC_STATS *rec_stats;
+
     /* Do we advertise Post-handshake auth support? */
     int pha_enabled;
+
+    /* RFC 8879 certificate compression algorithms, most preferred first */
+    int cert_comp_prefs[SSL_CERT_COMP_NUM];
+    size_t cert_comp_prefs_len;
+    /*
+     * Last compressed Certificate message sent for each certificate,
+     * indexed like CERT pkeys. Protected by |lock|.
+     */
+    SSL_CERT_COMP *cert_comp_cache[SSL_PKEY_NUM];
+    /*
+     * Certificate chain last sent for each certificate, indexed like CERT
+     * pkeys. Protected by |lock|.
+     */
+    SSL_CERT_MSG *cert_msgs[SSL_PKEY_NUM];
+
+    /* Workers for server side OQS KEM encapsulation, or NULL */
+    OSSL_WORKER_POOL *oqs_kem_pool;
+    /* Pre-generated keypairs for client OQS key shares, or NULL */
+    OQS_KEYPAIR_POOL *oqs_keypair_pool;
+    /* Cost of each group measured by SSL_CTX_calibrate_groups(), or NULL */
+    struct tls_group_cost_st *group_costs;
+    size_t group_costs_len;
+    /* Per host groups requested in HelloRetryRequests, or NULL */
+    SSL_KEY_SHARE_HINT *key_share_hints;
+    size_t key_share_hints_size;
+    /* Per host server Certificate messages for cached_info, or NULL */
+    SSL_CACHED_INFO *cached_info;
+    size_t cached_info_size;
+    /*
+     * Server TLSv1.3 ECDHE keys reused for up to |ecdhe_reuse_max_uses|
+     * handshakes and |ecdhe_reuse_max_seconds| seconds, protected by |lock|
+     */
+    SSL_ECDHE_REUSE ecdhe_reuse[SSL_ECDHE_REUSE_NUM];
+    unsigned int ecdhe_reuse_max_uses;
+    unsigned int ecdhe_reuse_max_seconds;
+
+    /* Free record buffers, protected by |lock| */
+    SSL3_BUF_FREELIST rbuf_freelist;
+    SSL3_BUF_FREELIST wbuf_freelist;
+    size_t freelist_max_len;
 };
 
 struct ssl_st {
@@ -1372,6 +1723,16 @@ struct ssl_st {
     unsigned char server_app_traffic_secret[EVP_MAX_MD_SIZE];
     unsigned char exporter_master_secret[EVP_MAX_MD_SIZE];
     unsigned char early_exporter_master_secret[EVP_MAX_MD_SIZE];
+    /*
+     * HMAC context used by the TLS1.3 key schedule, keyed with the secret
+     * last expanded or extracted from, and by the PRF of earlier versions.
+     * Allocated on first use.
+     */
+    HMAC_CTX *hkdf_hmac;
+    /* Timings of the current handshake, if its SSL_CTX collects them */
+    SSL_HS_TIMES hs_times;
+    /* SSL_REC_STAT_NUM record layer counters, or NULL if they aren't kept */
+    uint64_t *rec_stats;
     EVP_CIPHER_CTX *enc_read_ctx; /* cryptographic state */
     unsigned char read_iv[EVP_MAX_IV_LENGTH]; /* TLSv1.3 static read IV */
     EVP_MD_CTX *read_hash;      /* used for mac generation */
@@ -1406,6 +1767,10 @@ struct ssl_st {
     SSL_SESSION *session;
     /* TLSv1.3 PSK session */
     SSL_SESSION *psksession;
+    /* Server the client session cache keeps our sessions for */
+    char *client_cache_host;
+    unsigned int client_cache_port;
+    SSL_DTLS_CID dtls_cid;
     unsigned char *psksession_id;
     size_t psksession_id_len;
     /* Default generate session ID callback. */
@@ -1475,6 +1840,17 @@ struct ssl_st {
      * be more than this due to padding and MAC overheads.
      */
     size_t max_send_fragment;
+    /* Dynamic record sizing, see SSL_CTX */
+    size_t dynrec_size;
+    size_t dynrec_ramp;
+    unsigned long dynrec_idle;
+    /*
+     * The current dynamic record size (0 to start again), the records
+     * written at that size and the time of the last application data write
+     */
+    size_t dynrec_cur;
+    size_t dynrec_count;
+    struct timeval dynrec_last;
     /* Up to how many pipelines should we use? If 0 then 1 is assumed */
     size_t max_pipelines;
 
@@ -1565,6 +1941,11 @@ struct ssl_st {
         /* Have we received a cookie from the client? */
         int cookieok;
 
+        /* Kept for tls_collect_extensions(), see tls_free_raw_extensions() */
+        RAW_EXTENSION *raw_exts;
+        size_t raw_exts_len;
+        int raw_exts_inuse;
+
         /*
          * Maximum Fragment Length as per RFC 4366.
          * If this member contains one of the allowed values (1-4)
@@ -1582,6 +1963,23 @@ struct ssl_st {
          * selected.
          */
         int tick_identity;
+
+        /*
+         * On the client side 1 if we offered certificate compression. On the
+         * server side the algorithm we compress our Certificate with, or
+         * TLSEXT_comp_cert_none.
+         */
+        int cert_comp;
+
+        /*
+         * RFC 7924 cached_info state, one of the SSL_CACHED_INFO_* values.
+         * A client keeps the Certificate message it offered the hash of
+         * in |cached_info_msg|.
+         */
+        int cached_info;
+        unsigned char cached_info_hash[SHA256_DIGEST_LENGTH];
+        unsigned char *cached_info_msg;
+        size_t cached_info_msg_len;
     } ext;
 
     /*
@@ -1636,6 +2034,9 @@ struct ssl_st {
     int certreqs_sent;
     EVP_MD_CTX *pha_dgst; /* this is just the digest through ClientFinished */
 
+    int cert_comp_prefs[SSL_CERT_COMP_NUM];
+    size_t cert_comp_prefs_len;
+
 # ifndef OPENSSL_NO_SRP
     /* ctx for SRP authentication */
     SRP_CTX srp_ctx;
@@ -1680,6 +2081,9 @@ struct ssl_st {
 
     CRYPTO_RWLOCK *lock;
 
+    /* Bytes SSL_MODE_CORK collects before writing, 0 for a full record */
+    size_t cork_threshold;
+
     /* The number of TLS1.3 tickets to automatically send */
     size_t num_tickets;
     /* The number of TLS1.3 tickets actually sent so far */
@@ -1726,8 +2130,14 @@ typedef struct tls_group_info_st {
     int nid;                    /* Curve NID */
     int secbits;                /* Bits of security (from SP800-57) */
     uint16_t flags;             /* Flags: currently just group type */
+    uint16_t encodedlen;        /* Length of an uncompressed key share */
 } TLS_GROUP_INFO;
 
+typedef struct tls_group_cost_st {
+    uint16_t group_id;
+    uint64_t cost;              /* CPU nanoseconds for one key exchange */
+} TLS_GROUP_COST;
+
 /* flags values */
 # define TLS_CURVE_TYPE          0x3 /* Mask for group type */
 # define TLS_CURVE_PRIME         0x0
@@ -1745,6 +2155,9 @@ typedef struct {
     uint64_t amask; /* authmask corresponding to key type */
 } SSL_CERT_LOOKUP;
 
+/* Number of digests TLSv1.3 handshakes can use */
+# define SSL_HANDSHAKE_SPEC_NUM 2
+
 typedef struct ssl3_state_st {
     long flags;
     size_t read_mac_secret_size;
@@ -1763,6 +2176,11 @@ typedef struct ssl3_state_st {
      * freed and MD_CTX for the required digest is stored here.
      */
     EVP_MD_CTX *handshake_dgst;
+    /*
+     * Instead of the buffer, a handshake that can only be TLSv1.3 hashes the
+     * messages with each digest it may end up using, until it is known.
+     */
+    EVP_MD_CTX *handshake_spec_dgst[SSL_HANDSHAKE_SPEC_NUM];
     /*
      * Set whenever an expected ChangeCipherSpec message is processed.
      * Unset when the peer's Finished message is received.
@@ -1843,6 +2261,8 @@ typedef struct ssl3_state_st {
         /* Size of above arrays */
         size_t peer_sigalgslen;
         size_t peer_cert_sigalgslen;
+        /* peer_cert_sigalgs as a bitset over the signature algorithm table */
+        uint64_t peer_cert_sigalgs_set[SSL_SIGALG_WORDS];
         /* Sigalg peer actually uses */
         const SIGALG_LOOKUP *peer_sigalg;
         /*
@@ -1865,11 +2285,16 @@ typedef struct ssl3_state_st {
          */
         int min_ver;
         int max_ver;
+        /*
+         * Server: a suitable key share for |group_id| was found, but left
+         * undecoded until the client returns with a stateless cookie
+         */
+        int key_share_deferred;
         /*
          * OQS artefacts.
          */
         int oqs_kem_curve_id; /* curve_id of the kex */
-        OQS_KEM* oqs_kem; /* KEM context */
+        const OQS_KEM* oqs_kem; /* KEM descriptor, shared (see get_oqs_kem) */
         int oqs_peer_msg_len; /* save peer message's len */
         void* oqs_kem_client; /* oqs client private key (in extensions_clnt.c) or message (in extensions_srvr.c) */
     } tmp;
@@ -1970,6 +2395,8 @@ typedef struct hm_fragment_st {
     struct hm_header_st msg_header;
     unsigned char *fragment;
     unsigned char *reassembly;
+    /* Number of bytes of the message still missing, while reassembled */
+    size_t reassembly_left;
 } hm_fragment;
 
 typedef struct pqueue_st pqueue;
@@ -2026,6 +2453,23 @@ typedef struct dtls1_state_st {
 
     DTLS_timer_cb timer_cb;
 
+    /* Replay window of new epochs in records, 0 for the default */
+    size_t replay_window;
+
+    /* Retransmission pacing, see DTLS_set_retransmit_pacing() */
+    size_t pacing_burst;
+    unsigned int pacing_interval_us;
+    /* Bytes left to send in the current burst */
+    size_t pacing_left;
+    /*
+     * Set when the last burst stopped before the end of the flight, at the
+     * fragment offset |pacing_off| of the message with queue priority
+     * |pacing_prio|
+     */
+    int pacing_pending;
+    unsigned short pacing_prio;
+    size_t pacing_off;
+
 } DTLS1_STATE;
 
 # ifndef OPENSSL_NO_EC
@@ -2051,6 +2495,15 @@ struct cert_pkey_st {
      */
     unsigned char *serverinfo;
     size_t serverinfo_length;
+    /*
+     * Signature schemes |privatekey| can be used with and the schemes that
+     * match the signature on |x509|, one bit per entry of the signature
+     * algorithm table, and the curve of an EC key. Set up by
+     * tls1_set_cert_sigalgs() whenever the certificate or key changes.
+     */
+    uint64_t sigalgs[SSL_SIGALG_WORDS];
+    uint64_t cert_sigalgs[SSL_SIGALG_WORDS];
+    int curve;
 };
 /* Retrieve Suite B flags */
 # define tls1_suiteb(s)  (s->cert->cert_flags & SSL_CERT_FLAG_SUITEB_128_LOS)
@@ -2491,6 +2944,13 @@ static ossl_inline int ssl_has_cert(const SSL *s, int idx)
         && s->cert->pkeys[idx].privatekey != NULL;
 }
 
+/* Adds |n| to record layer counter |stat| of |s|, if it keeps them */
+static ossl_inline void ssl_rec_stats_add(SSL *s, int stat, uint64_t n)
+{
+    if (s->rec_stats != NULL)
+        s->rec_stats[stat] += n;
+}
+
 static ossl_inline void tls1_get_peer_groups(SSL *s, const uint16_t **pgroups,
                                              size_t *pgroupslen)
 {
@@ -2506,8 +2966,20 @@ void ssl_clear_cipher_ctx(SSL *s);
 int ssl_clear_bad_session(SSL *s);
 __owur CERT *ssl_cert_new(void);
 __owur CERT *ssl_cert_dup(CERT *cert);
+CERT *ssl_ctx_get1_cert(SSL_CTX *ctx);
 void ssl_cert_clear_certs(CERT *c);
 void ssl_cert_free(CERT *c);
+void ssl_ca_names_enc_clear(SSL_CA_NAMES_ENC *enc);
+__owur int ssl_get_ocsp_staple(SSL *s);
+# ifndef OPENSSL_NO_COMP
+__owur COMP_METHOD *ssl_cert_comp_method(int alg);
+__owur int ssl_cert_comp_compress(SSL *s, const unsigned char *raw,
+                                  size_t raw_len, unsigned char **comp,
+                                  size_t *comp_len);
+__owur int ssl_cert_comp_expand(int alg, const unsigned char *in,
+                                size_t in_len, unsigned char *out,
+                                size_t out_len);
+# endif
 __owur int ssl_generate_session_id(SSL *s, SSL_SESSION *ss);
 __owur int ssl_get_new_session(SSL *s, int session);
 __owur SSL_SESSION *lookup_sess_in_cache(SSL *s, const unsigned char *sess_id,
@@ -2580,12 +3052,23 @@ __owur int ssl_fill_hello_random(SSL *s, int server, unsigned char *field,
                                  size_t len, DOWNGRADE dgrd);
 __owur int ssl_generate_master_secret(SSL *s, unsigned char *pms, size_t pmslen,
                                       int free_pms);
-__owur EVP_PKEY *ssl_generate_pkey(EVP_PKEY *pm);
+__owur EVP_PKEY *ssl_generate_pkey(SSL *s, EVP_PKEY *pm);
+__owur EVP_PKEY *ssl_generate_pkey_reuse(SSL *s, EVP_PKEY *pm,
+                                         uint16_t group_id);
+void ssl_ecdhe_reuse_flush(SSL_CTX *ctx);
 __owur int ssl_derive(SSL *s, EVP_PKEY *privkey, EVP_PKEY *pubkey,
                       int genmaster);
 __owur EVP_PKEY *ssl_dh_to_pkey(DH *dh);
 __owur unsigned int ssl_get_max_send_fragment(const SSL *ssl);
 __owur unsigned int ssl_get_split_send_fragment(const SSL *ssl);
+void ssl_get_current_time(struct timeval *t);
+
+unsigned long ssl_session_hash(const SSL_SESSION *a);
+int ssl_session_cmp(const SSL_SESSION *a, const SSL_SESSION *b);
+__owur int ssl_session_cache_new(SSL_CTX *ctx, size_t num_shards);
+void ssl_session_cache_free(SSL_CTX *ctx);
+SSL_SESS_SHARD *ssl_session_cache_shard(SSL_CTX *ctx, const SSL_SESSION *s);
+size_t ssl_session_cache_number(SSL_CTX *ctx);
 
 __owur const SSL_CIPHER *ssl3_get_cipher_by_id(uint32_t id);
 __owur const SSL_CIPHER *ssl3_get_cipher_by_std_name(const char *stdname);
@@ -2593,6 +3076,7 @@ __owur const SSL_CIPHER *ssl3_get_cipher_by_char(const unsigned char *p);
 __owur int ssl3_put_cipher_by_char(const SSL_CIPHER *c, WPACKET *pkt,
                                    size_t *len);
 int ssl3_init_finished_mac(SSL *s);
+int ssl3_init_handshake_mac(SSL *s);
 __owur int ssl3_setup_key_block(SSL *s);
 __owur int ssl3_change_cipher_state(SSL *s, int which);
 void ssl3_cleanup_key_block(SSL *s);
@@ -2611,14 +3095,20 @@ __owur size_t ssl3_final_finish_mac(SSL *s, const char *sender, size_t slen,
                                     unsigned char *p);
 __owur int ssl3_finish_mac(SSL *s, const unsigned char *buf, size_t len);
 void ssl3_free_digest_list(SSL *s);
+void ssl_cert_msg_free(SSL_CERT_MSG *cm);
+void tls_free_raw_extensions(SSL *s, RAW_EXTENSION *exts);
+size_t ssl_cert_msg_mem_size(const SSL_CERT_MSG *cm);
 __owur unsigned long ssl3_output_cert_chain(SSL *s, WPACKET *pkt,
                                             CERT_PKEY *cpk);
 __owur const SSL_CIPHER *ssl3_choose_cipher(SSL *ssl,
                                             STACK_OF(SSL_CIPHER) *clnt,
                                             STACK_OF(SSL_CIPHER) *srvr);
 __owur int ssl3_digest_cached_records(SSL *s, int keep);
+__owur int ssl3_digest_cached_records_md(SSL *s, const EVP_MD *md,
+                                         unsigned char *out, size_t *outlen);
 __owur int ssl3_new(SSL *s);
 void ssl3_free(SSL *s);
+void ssl3_free_oqs_kem_tmp(SSL *s);
 __owur int ssl3_read(SSL *s, void *buf, size_t len, size_t *readbytes);
 __owur int ssl3_peek(SSL *s, void *buf, size_t len, size_t *readbytes);
 __owur int ssl3_write(SSL *s, const void *buf, size_t len, size_t *written);
@@ -2713,6 +3203,25 @@ __owur size_t tls13_final_finish_mac(SSL *s, const char *str, size_t slen,
                                      unsigned char *p);
 __owur int tls13_change_cipher_state(SSL *s, int which);
 __owur int tls13_update_key(SSL *s, int send);
+# ifndef OPENSSL_NO_KTLS
+__owur int ssl_ktls_start_tx(SSL *s, const EVP_CIPHER *c, EVP_CIPHER_CTX *ctx,
+                             const unsigned char *key,
+                             const unsigned char *iv);
+# endif
+/* One output of tls13_hkdf_expand_multi() */
+typedef struct {
+    const unsigned char *label;
+    size_t labellen;
+    const unsigned char *data;
+    size_t datalen;
+    unsigned char *out;
+    size_t outlen;
+} TLS13_HKDF_LABEL;
+
+__owur int tls13_hkdf_expand_multi(SSL *s, const EVP_MD *md,
+                                   const unsigned char *secret,
+                                   const TLS13_HKDF_LABEL *labels,
+                                   size_t nlabels, int fatal);
 __owur int tls13_hkdf_expand(SSL *s, const EVP_MD *md,
                              const unsigned char *secret,
                              const unsigned char *label, size_t labellen,
@@ -2764,6 +3273,8 @@ SSL_COMP *ssl3_comp_find(STACK_OF(SSL_COMP) *sk, int n);
 #  ifndef OPENSSL_NO_EC
 
 __owur const TLS_GROUP_INFO *tls1_group_id_lookup(uint16_t curve_id);
+size_t tls1_key_share_size(uint16_t group_id, int server);
+void tls1_get_default_groups(const uint16_t **pgroups, size_t *pgroupslen);
 __owur int tls1_check_group_id(SSL *s, uint16_t group_id, int check_own_curves);
 __owur uint16_t tls1_shared_group(SSL *s, int nmatch);
 __owur int tls1_set_groups(uint16_t **pext, size_t *pextlen,
@@ -2792,6 +3303,40 @@ void oqs_tls13_get_server_supported_groups(SSL *s, const uint16_t **pgroups,
                                   size_t *pgroupslen);
 void tls1_get_supported_groups(SSL *s, const uint16_t **pgroups,
                                size_t *pgroupslen);
+uint16_t tls13_get_key_share_hint(SSL *s);
+void tls13_set_key_share_hint(SSL *s, uint16_t group_id);
+void tls13_free_key_share_hints(SSL_CTX *ctx);
+int tls13_get_cached_info(SSL *s);
+void tls13_set_cached_info(SSL *s, const unsigned char *msg, size_t len);
+void tls13_free_cached_info(SSL_CTX *ctx);
+int tls13_cert_list_hash(const unsigned char *msg, size_t len,
+                         unsigned char *hash);
+
+__owur unsigned char *ssl3_buf_freelist_extract(SSL_CTX *ctx, int for_read,
+                                               size_t len);
+void ssl3_buf_freelist_insert(SSL_CTX *ctx, int for_read, unsigned char *mem,
+                              size_t len);
+void ssl3_buf_freelists_free(SSL_CTX *ctx);
+
+__owur int ssl_oqs_kem_encaps(SSL *s, const OQS_KEM *kem, unsigned char *ct,
+                              unsigned char *ss, const unsigned char *pk);
+__owur int ssl_oqs_kem_decaps(SSL *s, const OQS_KEM *kem, unsigned char *ss,
+                              const unsigned char *ct,
+                              const unsigned char *sk);
+__owur int ssl_oqs_digest_sign(SSL *s, EVP_MD_CTX *mctx, unsigned char *sig,
+                               size_t *siglen, const unsigned char *tbs,
+                               size_t tbslen);
+__owur int ssl_oqs_digest_verify(SSL *s, EVP_MD_CTX *mctx,
+                                 const unsigned char *sig, size_t siglen,
+                                 const unsigned char *tbs, size_t tbslen);
+OQS_KEYPAIR_POOL *oqs_keypair_pool_new(size_t size);
+void oqs_keypair_pool_free(OQS_KEYPAIR_POOL *pool);
+size_t oqs_keypair_pool_size(const OQS_KEYPAIR_POOL *pool);
+size_t oqs_keypair_pool_count(OQS_KEYPAIR_POOL *pool);
+uint64_t oqs_keypair_pool_hits(OQS_KEYPAIR_POOL *pool);
+size_t oqs_keypair_pool_mem_size(OQS_KEYPAIR_POOL *pool);
+__owur int ssl_oqs_kem_keypair(SSL *s, const OQS_KEM *kem, unsigned char *pk,
+                               unsigned char **sk);
 
 __owur int tls1_set_server_sigalgs(SSL *s);
 
@@ -2804,6 +3349,44 @@ __owur SSL_TICKET_STATUS tls_decrypt_ticket(SSL *s, const unsigned char *etick,
 
 __owur int tls_use_ticket(SSL *s);
 
+__owur int ssl_session_i2d(SSL_SESSION *in, const unsigned char *peer_digest,
+                           unsigned char **pp);
+void ssl_peer_cert_cache_free(SSL_PEER_CERT_CACHE *cache);
+__owur int ssl_peer_cert_cache_add(SSL_PEER_CERT_CACHE *cache, X509 *x,
+                                   unsigned char *digest);
+X509 *ssl_peer_cert_cache_get(SSL_PEER_CERT_CACHE *cache,
+                              const unsigned char *digest);
+
+__owur int ssl_ticket_key_ring_get_enc(SSL_TICKET_KEY_RING *ring,
+                                       SSL_TICKET_KEY *key);
+__owur int ssl_ticket_key_ring_find(SSL_TICKET_KEY_RING *ring,
+                                    const unsigned char *name,
+                                    SSL_TICKET_KEY *key);
+__owur int ssl_replay_filter_check(SSL_REPLAY_FILTER *rf,
+                                   const unsigned char *data, size_t len);
+__owur int ssl_sni_map_switch(SSL *s);
+void ssl_client_cache_free(SSL_CLIENT_CACHE *cache);
+void ssl_dtls_cid_map_free(SSL_DTLS_CID_MAP *map);
+__owur int ssl_dtls_cid_pick(SSL *s);
+void ssl_dtls_cid_unregister(SSL *s);
+int ssl_dtls_cid_down_ref(SSL *s);
+void ssl_client_cache_add(SSL *s);
+SSL_SESSION *ssl_client_cache_get(SSL *s);
+
+void ssl_hs_stats_free(SSL_HS_STATS *stats);
+void ssl_hs_stats_begin(SSL *s);
+void ssl_hs_stats_enter(SSL *s);
+void ssl_hs_stats_leave(SSL *s);
+void ssl_hs_stats_end(SSL *s);
+void ssl_hs_timer_start(SSL *s, SSL_HS_TIMER *t);
+void ssl_hs_timer_stop(SSL *s, int phase, SSL_HS_TIMER *t);
+uint64_t ssl_cpu_now(void);
+void ssl_rec_stats_ctx_free(SSL_REC_STATS *stats);
+void ssl_rec_stats_release(SSL *s);
+# ifndef OPENSSL_NO_METRICS
+void tls1_handshake_metrics(SSL *s);
+# endif
+
 void ssl_set_sig_mask(uint32_t *pmask_a, SSL *s, int op);
 
 __owur int tls1_set_sigalgs_list(CERT *c, const char *str, int client);
@@ -2814,6 +3397,7 @@ __owur int tls1_set_sigalgs(CERT *c, const int *salg, size_t salglen,
 int tls1_check_chain(SSL *s, X509 *x, EVP_PKEY *pk, STACK_OF(X509) *chain,
                      int idx);
 void tls1_set_cert_validity(SSL *s);
+void tls1_set_cert_sigalgs(CERT_PKEY *cpk);
 
 #  ifndef OPENSSL_NO_CT
 __owur int ssl_validate_ct(SSL *s);
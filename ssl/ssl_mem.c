@@ -0,0 +1,281 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <string.h>
+#include <openssl/x509.h>
+#include "ssl_local.h"
+
+/*-
+ * Memory accounting. The memory held by an SSL or an SSL_CTX is added up by
+ * walking the buffers and objects it owns, by category. Buffers that libssl
+ * allocates itself are counted at their allocated size. Certificates and
+ * keys are counted at the size of their DER encoding, and digest contexts at
+ * the size of their state, which leaves out the overhead of the decoded
+ * structures inside libcrypto. Objects shared with the SSL_CTX, such as its
+ * certificates, only count towards the SSL_CTX.
+ */
+typedef struct {
+    size_t cat[SSL_MEM_NUM];
+} SSL_MEM_USAGE;
+
+static size_t str_mem(const char *str)
+{
+    return str == NULL ? 0 : strlen(str) + 1;
+}
+
+static size_t x509_mem(X509 *x)
+{
+    int len;
+
+    if (x == NULL)
+        return 0;
+    len = i2d_X509(x, NULL);
+    return len > 0 ? (size_t)len : 0;
+}
+
+static size_t x509_chain_mem(STACK_OF(X509) *chain, X509 *skip)
+{
+    size_t len = 0;
+    int i;
+
+    for (i = 0; i < sk_X509_num(chain); i++) {
+        X509 *x = sk_X509_value(chain, i);
+
+        if (x != skip)
+            len += x509_mem(x);
+    }
+    return len;
+}
+
+static size_t pkey_mem(EVP_PKEY *pkey, int private)
+{
+    int len;
+
+    if (pkey == NULL)
+        return 0;
+    len = private ? i2d_PrivateKey(pkey, NULL) : i2d_PUBKEY(pkey, NULL);
+    return len > 0 ? (size_t)len : 0;
+}
+
+static size_t md_ctx_mem(const EVP_MD_CTX *ctx)
+{
+    const EVP_MD *md;
+
+    if (ctx == NULL)
+        return 0;
+    md = EVP_MD_CTX_md(ctx);
+    return md == NULL ? 0 : (size_t)EVP_MD_meth_get_app_datasize(md);
+}
+
+static size_t stack_mem(const OPENSSL_STACK *sk)
+{
+    return sk == NULL ? 0 : sizeof(void *) * OPENSSL_sk_num(sk);
+}
+
+static void session_usage(SSL_SESSION *ss, SSL_MEM_USAGE *mu)
+{
+    if (ss == NULL)
+        return;
+    mu->cat[SSL_MEM_SESSION] += sizeof(*ss)
+        + str_mem(ss->psk_identity_hint) + str_mem(ss->psk_identity)
+        + str_mem(ss->ext.hostname) + ss->ext.ticklen
+        + ss->ext.alpn_selected_len + ss->ticket_appdata_len;
+#ifndef OPENSSL_NO_SRP
+    mu->cat[SSL_MEM_SESSION] += str_mem(ss->srp_username);
+#endif
+    mu->cat[SSL_MEM_CERTIFICATES] += x509_mem(ss->peer)
+        + x509_chain_mem(ss->peer_chain, ss->peer);
+}
+
+static void session_cb(SSL_SESSION *ss, SSL_MEM_USAGE *mu)
+{
+    session_usage(ss, mu);
+}
+
+IMPLEMENT_LHASH_DOALL_ARG(SSL_SESSION, SSL_MEM_USAGE);
+
+/* The certificates and keys of |c| that are not also those of |shared| */
+static size_t cert_mem(const CERT *c, const CERT *shared)
+{
+    size_t len = 0;
+    int i;
+
+    if (c == NULL)
+        return 0;
+    for (i = 0; i < SSL_PKEY_NUM; i++) {
+        const CERT_PKEY *cpk = &c->pkeys[i];
+        const CERT_PKEY *scpk = shared != NULL ? &shared->pkeys[i] : NULL;
+
+        if (scpk == NULL || cpk->x509 != scpk->x509)
+            len += x509_mem(cpk->x509);
+        if (scpk == NULL || cpk->privatekey != scpk->privatekey)
+            len += pkey_mem(cpk->privatekey, 1);
+        if (scpk == NULL || cpk->chain != scpk->chain)
+            len += x509_chain_mem(cpk->chain, NULL);
+        len += cpk->serverinfo_length;
+    }
+    return len;
+}
+
+static void buffer_usage(const SSL3_BUFFER *b, SSL_MEM_USAGE *mu)
+{
+    if (b->buf != NULL && !b->app_buffer)
+        mu->cat[SSL_MEM_RECORD_BUFFERS] += b->len;
+}
+
+static void ssl_usage(const SSL *s, SSL_MEM_USAGE *mu)
+{
+    const SSL3_ZEROCOPY_BUFFER *zb;
+    BUF_MEM *bm;
+    size_t i;
+
+    memset(mu, 0, sizeof(*mu));
+
+    mu->cat[SSL_MEM_OBJECT] = sizeof(*s) + sizeof(*s->cert)
+        + str_mem(s->ext.hostname) + s->ext.alpn_len
+        + stack_mem((const OPENSSL_STACK *)s->cipher_list)
+        + stack_mem((const OPENSSL_STACK *)s->cipher_list_by_id)
+        + stack_mem((const OPENSSL_STACK *)s->tls13_ciphersuites);
+    if (s->s3 != NULL)
+        mu->cat[SSL_MEM_OBJECT] += sizeof(*s->s3);
+    if (s->d1 != NULL)
+        mu->cat[SSL_MEM_OBJECT] += sizeof(*s->d1);
+
+    buffer_usage(&s->rlayer.rbuf, mu);
+    for (i = 0; i < s->rlayer.numwpipes; i++)
+        buffer_usage(&s->rlayer.wbuf[i], mu);
+    for (zb = s->rlayer.zerocopy_head; zb != NULL; zb = zb->next)
+        mu->cat[SSL_MEM_RECORD_BUFFERS] += sizeof(*zb) + zb->len;
+
+    if (s->init_buf != NULL)
+        mu->cat[SSL_MEM_HANDSHAKE] += sizeof(*s->init_buf) + s->init_buf->max;
+    mu->cat[SSL_MEM_HANDSHAKE] += md_ctx_mem(s->pha_dgst)
+        + sizeof(uint16_t) * s->ext.peer_supportedgroups_len
+        + sizeof(RAW_EXTENSION) * s->ext.raw_exts_len;
+    if (s->clienthello != NULL) {
+        mu->cat[SSL_MEM_HANDSHAKE] += sizeof(*s->clienthello);
+        if (s->clienthello->pre_proc_exts != s->ext.raw_exts)
+            mu->cat[SSL_MEM_HANDSHAKE] +=
+                sizeof(RAW_EXTENSION) * s->clienthello->pre_proc_exts_len;
+    }
+    if (s->s3 != NULL) {
+        if (s->s3->handshake_buffer != NULL) {
+            BIO_get_mem_ptr(s->s3->handshake_buffer, &bm);
+            if (bm != NULL)
+                mu->cat[SSL_MEM_HANDSHAKE] += sizeof(*bm) + bm->max;
+        }
+        mu->cat[SSL_MEM_HANDSHAKE] += md_ctx_mem(s->s3->handshake_dgst)
+            + sizeof(uint16_t) * (s->s3->tmp.peer_sigalgslen
+                                  + s->s3->tmp.peer_cert_sigalgslen);
+
+        mu->cat[SSL_MEM_KEY_SHARE] += pkey_mem(s->s3->tmp.pkey, 1)
+            + pkey_mem(s->s3->peer_tmp, 0)
+            + s->s3->tmp.pmslen + s->s3->tmp.psklen;
+        if (s->s3->tmp.oqs_kem_client != NULL)
+            mu->cat[SSL_MEM_KEY_SHARE] += s->server
+                ? (size_t)s->s3->tmp.oqs_peer_msg_len
+                : s->s3->tmp.oqs_kem->length_secret_key;
+    }
+
+    session_usage(s->session, mu);
+    if (s->psksession != NULL && s->psksession != s->session)
+        session_usage(s->psksession, mu);
+
+    mu->cat[SSL_MEM_CERTIFICATES] += cert_mem(s->cert, s->ctx->cert)
+        + s->ext.ocsp.resp_len + s->ext.cached_info_msg_len;
+}
+
+static void ctx_usage(const SSL_CTX *ctx, SSL_MEM_USAGE *mu)
+{
+    STACK_OF(X509_OBJECT) *objs;
+    size_t i;
+    int j;
+
+    memset(mu, 0, sizeof(*mu));
+
+    mu->cat[SSL_MEM_OBJECT] = sizeof(*ctx) + sizeof(*ctx->cert)
+        + sizeof(*ctx->sess_shards) * ctx->sess_num_shards
+        + stack_mem((const OPENSSL_STACK *)ctx->cipher_list)
+        + stack_mem((const OPENSSL_STACK *)ctx->cipher_list_by_id)
+        + stack_mem((const OPENSSL_STACK *)ctx->tls13_ciphersuites);
+
+    for (i = 0; i < ctx->sess_num_shards; i++) {
+        SSL_SESS_SHARD *shard = &ctx->sess_shards[i];
+
+        CRYPTO_THREAD_read_lock(shard->lock);
+        lh_SSL_SESSION_doall_SSL_MEM_USAGE(shard->sessions, session_cb, mu);
+        CRYPTO_THREAD_unlock(shard->lock);
+    }
+
+    mu->cat[SSL_MEM_CERTIFICATES] += cert_mem(ctx->cert, NULL)
+        + x509_chain_mem(ctx->extra_certs, NULL);
+    if (ctx->cert_store != NULL) {
+        X509_STORE_lock(ctx->cert_store);
+        objs = X509_STORE_get0_objects(ctx->cert_store);
+        for (j = 0; j < sk_X509_OBJECT_num(objs); j++)
+            mu->cat[SSL_MEM_CERTIFICATES] +=
+                x509_mem(X509_OBJECT_get0_X509(sk_X509_OBJECT_value(objs, j)));
+        X509_STORE_unlock(ctx->cert_store);
+    }
+    for (i = 0; i < ctx->cached_info_size; i++)
+        mu->cat[SSL_MEM_CERTIFICATES] += sizeof(ctx->cached_info[i])
+            + str_mem(ctx->cached_info[i].hostname)
+            + ctx->cached_info[i].cert_msg_len;
+
+    for (i = 0; i < ctx->key_share_hints_size; i++)
+        mu->cat[SSL_MEM_KEY_SHARE] += sizeof(ctx->key_share_hints[i])
+            + str_mem(ctx->key_share_hints[i].hostname);
+    mu->cat[SSL_MEM_KEY_SHARE] +=
+        oqs_keypair_pool_mem_size(ctx->oqs_keypair_pool);
+
+    CRYPTO_THREAD_read_lock(ctx->lock);
+    mu->cat[SSL_MEM_RECORD_BUFFERS] +=
+        ctx->rbuf_freelist.len * ctx->rbuf_freelist.chunklen
+        + ctx->wbuf_freelist.len * ctx->wbuf_freelist.chunklen;
+    for (j = 0; j < SSL_PKEY_NUM; j++) {
+        const SSL_CERT_COMP *cc = ctx->cert_comp_cache[j];
+
+        if (cc != NULL)
+            mu->cat[SSL_MEM_CERTIFICATES] += sizeof(*cc) + cc->raw_len
+                                             + cc->comp_len;
+        mu->cat[SSL_MEM_CERTIFICATES] +=
+            ssl_cert_msg_mem_size(ctx->cert_msgs[j]);
+    }
+    CRYPTO_THREAD_unlock(ctx->lock);
+}
+
+static size_t usage_get(const SSL_MEM_USAGE *mu, int category)
+{
+    size_t total = 0;
+    int i;
+
+    if (category >= 0 && category < SSL_MEM_NUM)
+        return mu->cat[category];
+    if (category != SSL_MEM_ALL)
+        return 0;
+    for (i = 0; i < SSL_MEM_NUM; i++)
+        total += mu->cat[i];
+    return total;
+}
+
+size_t SSL_get_memory_usage(const SSL *s, int category)
+{
+    SSL_MEM_USAGE mu;
+
+    ssl_usage(s, &mu);
+    return usage_get(&mu, category);
+}
+
+size_t SSL_CTX_get_memory_usage(const SSL_CTX *ctx, int category)
+{
+    SSL_MEM_USAGE mu;
+
+    ctx_usage(ctx, &mu);
+    return usage_get(&mu, category);
+}
@@ -0,0 +1,729 @@
+/*
+ * OQS helpers for libssl.
+ *
+ * Offloaded operations: KEM encapsulation and decapsulation of PQ key
+ * shares, and the handshake signatures made or checked with OQS keys (and
+ * RSA signing, which costs as much), can be handed to an OSSL_WORKER_POOL
+ * owned by the SSL_CTX. Pending operations from many connections are queued
+ * and picked up by the workers in batches. The handshake waiting
+ * for the result pauses its ASYNC job, so non-blocking servers using
+ * SSL_MODE_ASYNC see SSL_ERROR_WANT_ASYNC and get woken up through the
+ * ASYNC_WAIT_CTX file descriptor once the result is ready. Without an async
+ * job the operation runs inline.
+ *
+ * Pre-generated keypairs: clients can keep a bounded number of ephemeral KEM
+ * keypairs per group ready in the SSL_CTX, refilled by a background thread,
+ * so that building the key share does not pay for the key generation.
+ *
+ * Group calibration: clients can order their groups, and with that the key
+ * share they send, by the CPU cost of a key exchange measured at startup.
+ */
+
+#include "ssl_local.h"
+#include <openssl/async.h>
+
+#if defined(OPENSSL_THREADS) && !defined(OPENSSL_SYS_WINDOWS)
+# define OQS_KEM_POOL_THREADS
+# include <pthread.h>
+#endif
+
+#ifdef OQS_KEM_POOL_THREADS
+
+/*
+ * Pre-generated client keypairs: one slot per KEM that clients of the
+ * SSL_CTX have asked for, each holding up to |size| keypairs. A refill thread
+ * tops up the slots, and every keypair is handed out exactly once.
+ */
+typedef struct oqs_keypair_st {
+    unsigned char *pk;
+    unsigned char *sk;
+} OQS_KEYPAIR;
+
+typedef struct oqs_keypair_slot_st {
+    const OQS_KEM *kem;
+    OQS_KEYPAIR *pairs;
+    size_t count;
+    struct oqs_keypair_slot_st *next;
+} OQS_KEYPAIR_SLOT;
+
+struct oqs_keypair_pool_st {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    OQS_KEYPAIR_SLOT *slots;    /* only ever grows while the pool is alive */
+    uint64_t hits;              /* keypairs handed out */
+    int shutdown;
+    int running;
+    size_t size;
+    pthread_t thread;
+};
+
+static void oqs_keypair_free(const OQS_KEM *kem, OQS_KEYPAIR *pair)
+{
+    OQS_MEM_secure_free(pair->sk, kem->length_secret_key);
+    free(pair->pk);
+}
+
+/* Returns the first slot that is not full, called with the pool lock held */
+static OQS_KEYPAIR_SLOT *oqs_keypair_pool_next(OQS_KEYPAIR_POOL *pool)
+{
+    OQS_KEYPAIR_SLOT *slot;
+
+    for (slot = pool->slots; slot != NULL; slot = slot->next)
+        if (slot->count < pool->size)
+            return slot;
+    return NULL;
+}
+
+static void *oqs_keypair_pool_worker(void *arg)
+{
+    OQS_KEYPAIR_POOL *pool = arg;
+    OQS_KEYPAIR_SLOT *slot;
+    OQS_KEYPAIR pair;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->shutdown && (slot = oqs_keypair_pool_next(pool)) == NULL)
+            pthread_cond_wait(&pool->cond, &pool->lock);
+        if (pool->shutdown) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        pthread_mutex_unlock(&pool->lock);
+
+        /*
+         * The secret key is allocated the way add_key_share() does so that
+         * its ownership can be passed on to the connection.
+         */
+        pair.pk = malloc(slot->kem->length_public_key);
+        pair.sk = malloc(slot->kem->length_secret_key);
+        if (pair.pk == NULL || pair.sk == NULL
+                || ossl_oqs_kem_keypair(slot->kem, pair.pk, pair.sk)
+                   != OQS_SUCCESS) {
+            free(pair.pk);
+            free(pair.sk);
+            /* Leave it to the handshakes, they generate inline when empty */
+            pthread_mutex_lock(&pool->lock);
+            if (!pool->shutdown)
+                pthread_cond_wait(&pool->cond, &pool->lock);
+            pthread_mutex_unlock(&pool->lock);
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        if (slot->count < pool->size) {
+            slot->pairs[slot->count++] = pair;
+            pair.pk = pair.sk = NULL;
+        }
+        pthread_mutex_unlock(&pool->lock);
+        if (pair.pk != NULL)
+            oqs_keypair_free(slot->kem, &pair);
+    }
+    return NULL;
+}
+
+OQS_KEYPAIR_POOL *oqs_keypair_pool_new(size_t size)
+{
+    OQS_KEYPAIR_POOL *pool;
+
+    if ((pool = OPENSSL_zalloc(sizeof(*pool))) == NULL)
+        return NULL;
+    if (pthread_mutex_init(&pool->lock, NULL) != 0) {
+        OPENSSL_free(pool);
+        return NULL;
+    }
+    if (pthread_cond_init(&pool->cond, NULL) != 0) {
+        pthread_mutex_destroy(&pool->lock);
+        OPENSSL_free(pool);
+        return NULL;
+    }
+    pool->size = size;
+    if (pthread_create(&pool->thread, NULL, oqs_keypair_pool_worker,
+                       pool) != 0) {
+        oqs_keypair_pool_free(pool);
+        return NULL;
+    }
+    pool->running = 1;
+    return pool;
+}
+
+void oqs_keypair_pool_free(OQS_KEYPAIR_POOL *pool)
+{
+    OQS_KEYPAIR_SLOT *slot, *next;
+    size_t i;
+
+    if (pool == NULL)
+        return;
+    if (pool->running) {
+        pthread_mutex_lock(&pool->lock);
+        pool->shutdown = 1;
+        pthread_cond_broadcast(&pool->cond);
+        pthread_mutex_unlock(&pool->lock);
+        pthread_join(pool->thread, NULL);
+    }
+    for (slot = pool->slots; slot != NULL; slot = next) {
+        next = slot->next;
+        for (i = 0; i < slot->count; i++)
+            oqs_keypair_free(slot->kem, &slot->pairs[i]);
+        OPENSSL_free(slot->pairs);
+        OPENSSL_free(slot);
+    }
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->lock);
+    OPENSSL_free(pool);
+}
+
+size_t oqs_keypair_pool_size(const OQS_KEYPAIR_POOL *pool)
+{
+    return pool == NULL ? 0 : pool->size;
+}
+
+/* Keypairs ready in |pool|, over all KEMs */
+size_t oqs_keypair_pool_count(OQS_KEYPAIR_POOL *pool)
+{
+    const OQS_KEYPAIR_SLOT *slot;
+    size_t count = 0;
+
+    if (pool == NULL)
+        return 0;
+    pthread_mutex_lock(&pool->lock);
+    for (slot = pool->slots; slot != NULL; slot = slot->next)
+        count += slot->count;
+    pthread_mutex_unlock(&pool->lock);
+    return count;
+}
+
+uint64_t oqs_keypair_pool_hits(OQS_KEYPAIR_POOL *pool)
+{
+    uint64_t hits;
+
+    if (pool == NULL)
+        return 0;
+    pthread_mutex_lock(&pool->lock);
+    hits = pool->hits;
+    pthread_mutex_unlock(&pool->lock);
+    return hits;
+}
+
+/* Bytes held by |pool|, its keypairs included */
+size_t oqs_keypair_pool_mem_size(OQS_KEYPAIR_POOL *pool)
+{
+    const OQS_KEYPAIR_SLOT *slot;
+    size_t len;
+
+    if (pool == NULL)
+        return 0;
+    len = sizeof(*pool);
+    pthread_mutex_lock(&pool->lock);
+    for (slot = pool->slots; slot != NULL; slot = slot->next)
+        len += sizeof(*slot) + sizeof(*slot->pairs) * pool->size
+               + slot->count * (slot->kem->length_public_key
+                                + slot->kem->length_secret_key);
+    pthread_mutex_unlock(&pool->lock);
+    return len;
+}
+
+/*
+ * Takes a keypair for |kem| out of |pool|, copying the public key to |pk| and
+ * handing over the secret key in |*sk|. The first request for a KEM adds a
+ * slot for it. Returns 1 if a keypair was available and 0 otherwise.
+ */
+static int oqs_keypair_pool_take(OQS_KEYPAIR_POOL *pool, const OQS_KEM *kem,
+                                 unsigned char *pk, unsigned char **sk)
+{
+    OQS_KEYPAIR_SLOT *slot;
+    OQS_KEYPAIR pair;
+
+    pthread_mutex_lock(&pool->lock);
+    for (slot = pool->slots; slot != NULL; slot = slot->next)
+        if (slot->kem == kem)
+            break;
+    if (slot == NULL) {
+        if ((slot = OPENSSL_zalloc(sizeof(*slot))) == NULL
+                || (slot->pairs = OPENSSL_malloc(sizeof(*slot->pairs)
+                                                 * pool->size)) == NULL) {
+            pthread_mutex_unlock(&pool->lock);
+            OPENSSL_free(slot);
+            return 0;
+        }
+        slot->kem = kem;
+        slot->next = pool->slots;
+        pool->slots = slot;
+    }
+    /* Either way the slot is now below its target */
+    pthread_cond_signal(&pool->cond);
+    if (slot->count == 0) {
+        pthread_mutex_unlock(&pool->lock);
+        return 0;
+    }
+    pair = slot->pairs[--slot->count];
+    pool->hits++;
+    pthread_mutex_unlock(&pool->lock);
+
+    memcpy(pk, pair.pk, kem->length_public_key);
+    free(pair.pk);
+    *sk = pair.sk;
+    return 1;
+}
+
+#else /* OQS_KEM_POOL_THREADS */
+
+OQS_KEYPAIR_POOL *oqs_keypair_pool_new(size_t size)
+{
+    return NULL;
+}
+
+void oqs_keypair_pool_free(OQS_KEYPAIR_POOL *pool)
+{
+}
+
+size_t oqs_keypair_pool_size(const OQS_KEYPAIR_POOL *pool)
+{
+    return 0;
+}
+
+size_t oqs_keypair_pool_count(OQS_KEYPAIR_POOL *pool)
+{
+    return 0;
+}
+
+uint64_t oqs_keypair_pool_hits(OQS_KEYPAIR_POOL *pool)
+{
+    return 0;
+}
+
+size_t oqs_keypair_pool_mem_size(OQS_KEYPAIR_POOL *pool)
+{
+    return 0;
+}
+
+#endif /* OQS_KEM_POOL_THREADS */
+
+/*
+ * Runs |run| on the KEM workers of |s| if it has some and is running inside
+ * an ASYNC job, and inline otherwise.
+ */
+static int ssl_oqs_offload(SSL *s, int (*run) (void *arg), void *arg)
+{
+    return OSSL_WORKER_POOL_run(s->ctx->oqs_kem_pool, run, arg);
+}
+
+typedef struct {
+    const OQS_KEM *kem;
+    unsigned char *ct;
+    unsigned char *ss;
+    const unsigned char *key;   /* public key to encaps, secret to decaps */
+} OQS_KEM_ARGS;
+
+static int oqs_kem_encaps_run(void *arg)
+{
+    OQS_KEM_ARGS *a = arg;
+
+    return ossl_oqs_kem_encaps(a->kem, a->ct, a->ss, a->key) == OQS_SUCCESS;
+}
+
+static int oqs_kem_decaps_run(void *arg)
+{
+    OQS_KEM_ARGS *a = arg;
+
+    return ossl_oqs_kem_decaps(a->kem, a->ss, a->ct, a->key) == OQS_SUCCESS;
+}
+
+/*
+ * Encapsulates against the peer's public key |pk|, on the KEM workers if
+ * possible. Returns 1 on success and 0 on failure.
+ */
+int ssl_oqs_kem_encaps(SSL *s, const OQS_KEM *kem, unsigned char *ct,
+                       unsigned char *ss, const unsigned char *pk)
+{
+    OQS_KEM_ARGS a;
+    SSL_HS_TIMER t;
+    int ret;
+
+    a.kem = kem;
+    a.ct = ct;
+    a.ss = ss;
+    a.key = pk;
+    ssl_hs_timer_start(s, &t);
+    ret = ssl_oqs_offload(s, oqs_kem_encaps_run, &a);
+    ssl_hs_timer_stop(s, SSL_HS_PHASE_ENCAPS, &t);
+    return ret;
+}
+
+/*
+ * Decapsulates the peer's ciphertext |ct| with our secret key |sk|, on the
+ * KEM workers if possible. Returns 1 on success and 0 on failure.
+ */
+int ssl_oqs_kem_decaps(SSL *s, const OQS_KEM *kem, unsigned char *ss,
+                       const unsigned char *ct, const unsigned char *sk)
+{
+    OQS_KEM_ARGS a;
+    SSL_HS_TIMER t;
+    int ret;
+
+    a.kem = kem;
+    a.ct = (unsigned char *)ct;
+    a.ss = ss;
+    a.key = sk;
+    ssl_hs_timer_start(s, &t);
+    ret = ssl_oqs_offload(s, oqs_kem_decaps_run, &a);
+    ssl_hs_timer_stop(s, SSL_HS_PHASE_DECAPS, &t);
+    return ret;
+}
+
+typedef struct {
+    EVP_MD_CTX *mctx;
+    unsigned char *sig;
+    const unsigned char *csig;
+    size_t *siglen;
+    size_t csiglen;
+    const unsigned char *tbs;
+    size_t tbslen;
+} OQS_SIG_ARGS;
+
+static int oqs_digest_sign_run(void *arg)
+{
+    OQS_SIG_ARGS *a = arg;
+
+    return EVP_DigestSign(a->mctx, a->sig, a->siglen, a->tbs, a->tbslen) > 0;
+}
+
+static int oqs_digest_verify_run(void *arg)
+{
+    OQS_SIG_ARGS *a = arg;
+
+    return EVP_DigestVerify(a->mctx, a->csig, a->csiglen, a->tbs,
+                            a->tbslen) > 0;
+}
+
+/*
+ * Only operations that take long enough to be worth a trip to another
+ * thread are offloaded: everything with an OQS or hybrid key, and signing
+ * with an RSA key.
+ */
+static int ssl_oqs_offload_sig(EVP_MD_CTX *mctx, int sign)
+{
+    EVP_PKEY *pkey = EVP_PKEY_CTX_get0_pkey(EVP_MD_CTX_pkey_ctx(mctx));
+    int id;
+
+    if (pkey == NULL)
+        return 0;
+    id = EVP_PKEY_id(pkey);
+    if (IS_OQS_OPENSSL_SIG_NID(id))
+        return 1;
+    return sign && (id == EVP_PKEY_RSA || id == EVP_PKEY_RSA_PSS);
+}
+
+/*
+ * EVP_DigestSign() and EVP_DigestVerify() for handshake signatures, on the
+ * KEM workers if possible. Both return 1 on success and 0 on failure.
+ */
+int ssl_oqs_digest_sign(SSL *s, EVP_MD_CTX *mctx, unsigned char *sig,
+                        size_t *siglen, const unsigned char *tbs,
+                        size_t tbslen)
+{
+    OQS_SIG_ARGS a;
+    SSL_HS_TIMER t;
+    int ret;
+
+    a.mctx = mctx;
+    a.sig = sig;
+    a.siglen = siglen;
+    a.tbs = tbs;
+    a.tbslen = tbslen;
+    ssl_hs_timer_start(s, &t);
+    if (!ssl_oqs_offload_sig(mctx, 1))
+        ret = oqs_digest_sign_run(&a);
+    else
+        ret = ssl_oqs_offload(s, oqs_digest_sign_run, &a);
+    ssl_hs_timer_stop(s, SSL_HS_PHASE_SIGN, &t);
+    return ret;
+}
+
+int ssl_oqs_digest_verify(SSL *s, EVP_MD_CTX *mctx, const unsigned char *sig,
+                          size_t siglen, const unsigned char *tbs,
+                          size_t tbslen)
+{
+    OQS_SIG_ARGS a;
+    SSL_HS_TIMER t;
+    int ret;
+
+    a.mctx = mctx;
+    a.csig = sig;
+    a.csiglen = siglen;
+    a.tbs = tbs;
+    a.tbslen = tbslen;
+    ssl_hs_timer_start(s, &t);
+    if (!ssl_oqs_offload_sig(mctx, 0))
+        ret = oqs_digest_verify_run(&a);
+    else
+        ret = ssl_oqs_offload(s, oqs_digest_verify_run, &a);
+    ssl_hs_timer_stop(s, SSL_HS_PHASE_VERIFY, &t);
+    return ret;
+}
+
+/*
+ * Generates a client keypair for |kem| into |pk|, allocating the secret key
+ * in |*sk|. A pre-generated keypair from the SSL_CTX pool is used if there is
+ * one. Returns 1 on success and 0 on failure.
+ */
+int ssl_oqs_kem_keypair(SSL *s, const OQS_KEM *kem, unsigned char *pk,
+                        unsigned char **sk)
+{
+    SSL_HS_TIMER t;
+
+    ssl_hs_timer_start(s, &t);
+#ifdef OQS_KEM_POOL_THREADS
+    if (s->ctx->oqs_keypair_pool != NULL
+            && oqs_keypair_pool_take(s->ctx->oqs_keypair_pool, kem, pk, sk)) {
+        ssl_hs_timer_stop(s, SSL_HS_PHASE_KEYGEN, &t);
+        return 1;
+    }
+#endif
+    if ((*sk = malloc(kem->length_secret_key)) == NULL)
+        return 0;
+    if (ossl_oqs_kem_keypair(kem, pk, *sk) != OQS_SUCCESS) {
+        OQS_MEM_secure_free(*sk, kem->length_secret_key);
+        *sk = NULL;
+        return 0;
+    }
+    ssl_hs_timer_stop(s, SSL_HS_PHASE_KEYGEN, &t);
+    return 1;
+}
+
+int SSL_CTX_set_oqs_kem_workers(SSL_CTX *ctx, size_t num_workers)
+{
+    OSSL_WORKER_POOL *pool = NULL;
+
+    if (num_workers > 0) {
+#ifndef OQS_KEM_POOL_THREADS
+        SSLerr(SSL_F_SSL_CTX_SET_OQS_KEM_WORKERS, ERR_R_DISABLED);
+        return 0;
+#else
+        if ((pool = OSSL_WORKER_POOL_new(num_workers)) == NULL) {
+            SSLerr(SSL_F_SSL_CTX_SET_OQS_KEM_WORKERS, ERR_R_INIT_FAIL);
+            return 0;
+        }
+#endif
+    }
+    OSSL_WORKER_POOL_free(ctx->oqs_kem_pool);
+    ctx->oqs_kem_pool = pool;
+    return 1;
+}
+
+size_t SSL_CTX_get_oqs_kem_workers(const SSL_CTX *ctx)
+{
+    return OSSL_WORKER_POOL_get_num_threads(ctx->oqs_kem_pool);
+}
+
+int SSL_CTX_set_oqs_keypair_pool_size(SSL_CTX *ctx, size_t size)
+{
+    OQS_KEYPAIR_POOL *pool = NULL;
+
+    if (size > 0) {
+#ifndef OQS_KEM_POOL_THREADS
+        SSLerr(SSL_F_SSL_CTX_SET_OQS_KEYPAIR_POOL_SIZE, ERR_R_DISABLED);
+        return 0;
+#else
+        if ((pool = oqs_keypair_pool_new(size)) == NULL) {
+            SSLerr(SSL_F_SSL_CTX_SET_OQS_KEYPAIR_POOL_SIZE, ERR_R_INIT_FAIL);
+            return 0;
+        }
+#endif
+    }
+    oqs_keypair_pool_free(ctx->oqs_keypair_pool);
+    ctx->oqs_keypair_pool = pool;
+    return 1;
+}
+
+size_t SSL_CTX_get_oqs_keypair_pool_size(const SSL_CTX *ctx)
+{
+    return oqs_keypair_pool_size(ctx->oqs_keypair_pool);
+}
+
+size_t SSL_CTX_get_oqs_keypair_pool_count(const SSL_CTX *ctx)
+{
+    return oqs_keypair_pool_count(ctx->oqs_keypair_pool);
+}
+
+uint64_t SSL_CTX_get_oqs_keypair_pool_hits(const SSL_CTX *ctx)
+{
+    return oqs_keypair_pool_hits(ctx->oqs_keypair_pool);
+}
+
+#ifndef OPENSSL_NO_EC
+/* CPU time to spend measuring each group, and a bound on the exchanges */
+# define GROUP_CALIBRATION_NS           (5 * 1000 * 1000)
+# define GROUP_CALIBRATION_MAX_RUNS     1000
+
+static EVP_PKEY *calibration_keygen(uint16_t group_id)
+{
+    const TLS_GROUP_INFO *ginf = tls1_group_id_lookup(group_id);
+    EVP_PKEY_CTX *pctx;
+    EVP_PKEY *pkey = NULL;
+    int custom;
+
+    if (ginf == NULL)
+        return NULL;
+    custom = (ginf->flags & TLS_CURVE_TYPE) == TLS_CURVE_CUSTOM;
+    pctx = EVP_PKEY_CTX_new_id(custom ? ginf->nid : EVP_PKEY_EC, NULL);
+    if (pctx == NULL
+            || EVP_PKEY_keygen_init(pctx) <= 0
+            || (!custom
+                && EVP_PKEY_CTX_set_ec_paramgen_curve_nid(pctx,
+                                                          ginf->nid) <= 0)
+            || EVP_PKEY_keygen(pctx, &pkey) <= 0) {
+        EVP_PKEY_free(pkey);
+        pkey = NULL;
+    }
+    EVP_PKEY_CTX_free(pctx);
+    return pkey;
+}
+
+static int calibration_derive(EVP_PKEY *privkey, EVP_PKEY *pubkey)
+{
+    EVP_PKEY_CTX *pctx = EVP_PKEY_CTX_new(privkey, NULL);
+    unsigned char secret[EVP_MAX_MD_SIZE * 2];
+    size_t secretlen = sizeof(secret);
+    int ret;
+
+    ret = pctx != NULL
+          && EVP_PKEY_derive_init(pctx) > 0
+          && EVP_PKEY_derive_set_peer(pctx, pubkey) > 0
+          && EVP_PKEY_derive(pctx, secret, &secretlen) > 0;
+    OPENSSL_cleanse(secret, sizeof(secret));
+    EVP_PKEY_CTX_free(pctx);
+    return ret;
+}
+
+/*
+ * Runs the key generation and agreement of one TLSv1.3 key exchange in
+ * |group_id|, for both the client and the server. Returns 1 on success and
+ * 0 if the group can't be used, e.g. because liboqs lacks its KEM.
+ */
+static int calibration_exchange(uint16_t group_id)
+{
+    const OQS_KEM *kem = NULL;
+    EVP_PKEY *ckey = NULL, *skey = NULL;
+    unsigned char *pk = NULL, *sk = NULL, *ct = NULL, *ss = NULL;
+    uint16_t classical_id = group_id;
+    int ret = 0;
+
+    if (IS_OQS_KEM_CURVEID(group_id) || IS_OQS_KEM_HYBRID_CURVEID(group_id)) {
+        if ((kem = get_oqs_kem(OQS_KEM_NID(group_id))) == NULL)
+            return 0;
+        classical_id = OQS_KEM_CLASSICAL_CURVEID(group_id);
+    }
+    if (classical_id != 0
+            && ((ckey = calibration_keygen(classical_id)) == NULL
+                || (skey = calibration_keygen(classical_id)) == NULL
+                || !calibration_derive(skey, ckey)
+                || !calibration_derive(ckey, skey)))
+        goto end;
+    if (kem != NULL) {
+        pk = OPENSSL_malloc(kem->length_public_key);
+        sk = OPENSSL_secure_malloc(kem->length_secret_key);
+        ct = OPENSSL_malloc(kem->length_ciphertext);
+        ss = OPENSSL_secure_malloc(2 * kem->length_shared_secret);
+        if (pk == NULL || sk == NULL || ct == NULL || ss == NULL
+                || OQS_KEM_keypair(kem, pk, sk) != OQS_SUCCESS
+                || OQS_KEM_encaps(kem, ct, ss, pk) != OQS_SUCCESS
+                || OQS_KEM_decaps(kem, ss + kem->length_shared_secret, ct,
+                                  sk) != OQS_SUCCESS)
+            goto end;
+    }
+    ret = 1;
+
+ end:
+    if (kem != NULL) {
+        OPENSSL_free(pk);
+        OPENSSL_secure_clear_free(sk, kem->length_secret_key);
+        OPENSSL_free(ct);
+        OPENSSL_secure_clear_free(ss, 2 * kem->length_shared_secret);
+    }
+    EVP_PKEY_free(ckey);
+    EVP_PKEY_free(skey);
+    return ret;
+}
+
+/* CPU nanoseconds per key exchange in |group_id|, or 0 if it failed */
+static uint64_t calibration_cost(uint16_t group_id)
+{
+    uint64_t start, elapsed;
+    int runs = 0;
+
+    /* The first run sets up tables and warms the caches, so isn't counted */
+    if (!calibration_exchange(group_id))
+        return 0;
+    start = ssl_cpu_now();
+    do {
+        if (!calibration_exchange(group_id))
+            return 0;
+        elapsed = ssl_cpu_now() - start;
+    } while (++runs < GROUP_CALIBRATION_MAX_RUNS
+             && elapsed < GROUP_CALIBRATION_NS);
+    return elapsed / runs + 1;
+}
+
+int SSL_CTX_calibrate_groups(SSL_CTX *ctx, int min_bits)
+{
+    const uint16_t *groups;
+    size_t groupslen, i, j, n = 0;
+    TLS_GROUP_COST *costs = NULL;
+    uint16_t *ordered = NULL;
+
+    if (ctx->ext.supportedgroups != NULL) {
+        groups = ctx->ext.supportedgroups;
+        groupslen = ctx->ext.supportedgroups_len;
+    } else {
+        tls1_get_default_groups(&groups, &groupslen);
+    }
+    if (groupslen == 0) {
+        SSLerr(SSL_F_SSL_CTX_CALIBRATE_GROUPS, SSL_R_NO_SUITABLE_GROUPS);
+        return 0;
+    }
+    if ((costs = OPENSSL_malloc(groupslen * sizeof(*costs))) == NULL
+            || (ordered = OPENSSL_malloc(groupslen
+                                         * sizeof(*ordered))) == NULL) {
+        SSLerr(SSL_F_SSL_CTX_CALIBRATE_GROUPS, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+
+    /*
+     * Insertion sort by cost, keeping the configured order for equal costs.
+     * Groups that fail to run are left out, and so are their errors.
+     */
+    ERR_set_mark();
+    for (i = 0; i < groupslen; i++) {
+        const TLS_GROUP_INFO *ginf = tls1_group_id_lookup(groups[i]);
+        uint64_t cost;
+
+        if (ginf == NULL || ginf->secbits < min_bits
+                || (cost = calibration_cost(groups[i])) == 0)
+            continue;
+        for (j = n++; j > 0 && costs[j - 1].cost > cost; j--)
+            costs[j] = costs[j - 1];
+        costs[j].group_id = groups[i];
+        costs[j].cost = cost;
+    }
+    ERR_pop_to_mark();
+    if (n == 0) {
+        SSLerr(SSL_F_SSL_CTX_CALIBRATE_GROUPS, SSL_R_NO_SUITABLE_GROUPS);
+        goto err;
+    }
+
+    for (i = 0; i < n; i++)
+        ordered[i] = costs[i].group_id;
+    OPENSSL_free(ctx->ext.supportedgroups);
+    ctx->ext.supportedgroups = ordered;
+    ctx->ext.supportedgroups_len = n;
+    OPENSSL_free(ctx->group_costs);
+    ctx->group_costs = costs;
+    ctx->group_costs_len = n;
+    return 1;
+
+ err:
+    OPENSSL_free(costs);
+    OPENSSL_free(ordered);
+    return 0;
+}
+#endif
@@ -0,0 +1,438 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <string.h>
+#include <time.h>
+#include <openssl/rand.h>
+#include "ssl_local.h"
+#include "internal/cryptlib.h"
+#include "internal/refcount.h"
+
+/*-
+ * A replay filter remembers the ClientHellos that were allowed early data
+ * for a limited time, in the manner of RFC 8446 section 8.2, using a fixed
+ * amount of memory:
+ *
+ *   RF_HEADER
+ *   2 x words x uint64_t
+ *
+ * Time is cut into windows of |window| seconds, and each of the two
+ * generations of bits is a Bloom filter for the ClientHellos seen in one
+ * window: the current one and the one before. A generation is cleared and
+ * reused once its window is two windows old, so a ClientHello is remembered
+ * for between one and two windows. This is enough as long as a window is
+ * longer than the ticket age tolerance, since the ticket age checks reject
+ * an older ClientHello in any case.
+ *
+ * The filter is blocked: all the bits of an entry are in one 64-bit word,
+ * so that recording an entry and finding out whether it was already there
+ * is a single atomic OR, and checks take no lock. While a generation is
+ * being cleared its epoch is RF_CLEARING, and ClientHellos that would need
+ * it are treated as replays, which only costs them their early data.
+ *
+ * Without the compiler atomics a filter is private to the process and
+ * checks are serialised by a lock.
+ */
+#if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE) \
+    && __GCC_ATOMIC_INT_LOCK_FREE == 2 && __GCC_ATOMIC_LLONG_LOCK_FREE == 2
+# define RF_ATOMICS
+#endif
+
+#if defined(RF_ATOMICS) && defined(OPENSSL_SYS_UNIX)
+# include <sys/mman.h>
+# if defined(MAP_ANON) && !defined(MAP_ANONYMOUS)
+#  define MAP_ANONYMOUS MAP_ANON
+# endif
+# ifdef MAP_ANONYMOUS
+#  define RF_MMAP
+# endif
+#endif
+
+#define RF_MAGIC                0x52504631 /* "RPF1" */
+/* Epoch of a generation while it is cleared */
+#define RF_CLEARING             UINT64_MAX
+/* About two bytes per entry in each generation */
+#define RF_BITS_PER_ENTRY       16
+#define RF_MIN_WORDS            64
+#define RF_MAX_ENTRIES          ((size_t)1 << 32)
+/* Bits set in a word for each entry */
+#define RF_HASHES               4
+/*
+ * A window must cover the ticket age tolerance, plus the second we add to
+ * our own ticket age and a second for the rounding of time().
+ */
+#define RF_MIN_WINDOW           (TICKET_AGE_ALLOWANCE / 1000 + 2)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t window;
+    uint64_t words;
+    uint64_t key[2];
+    uint64_t epoch[2];
+} RF_HEADER;
+
+struct ssl_replay_filter_st {
+    RF_HEADER *hdr;
+    uint64_t *bits;
+    void *mem;
+    size_t mem_len;
+    /* how |mem| was obtained */
+    enum { RF_MEM_EXTERNAL, RF_MEM_HEAP, RF_MEM_MAPPED } mem_type;
+    CRYPTO_REF_COUNT references;
+    CRYPTO_RWLOCK *lock;
+};
+
+#ifdef RF_ATOMICS
+# define rf_load(p)             __atomic_load_n((p), __ATOMIC_ACQUIRE)
+# define rf_store(p, v)         __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+# define rf_or(p, v)            __atomic_fetch_or((p), (v), __ATOMIC_ACQ_REL)
+#else
+# define rf_load(p)             (*(p))
+# define rf_store(p, v)         (*(p) = (v))
+static ossl_inline uint64_t rf_or(uint64_t *p, uint64_t v)
+{
+    uint64_t old = *p;
+
+    *p |= v;
+    return old;
+}
+#endif
+
+static uint64_t rf_words(size_t entries)
+{
+    uint64_t need = ((uint64_t)entries * RF_BITS_PER_ENTRY + 63) / 64;
+    uint64_t words = RF_MIN_WORDS;
+
+    while (words < need)
+        words <<= 1;
+    return words;
+}
+
+size_t SSL_REPLAY_FILTER_mem_size(size_t entries)
+{
+    uint64_t len;
+
+    if (entries < 1 || entries > RF_MAX_ENTRIES)
+        return 0;
+    len = sizeof(RF_HEADER) + 2 * rf_words(entries) * sizeof(uint64_t);
+    if (len > SIZE_MAX)
+        return 0;
+    return (size_t)len;
+}
+
+static SSL_REPLAY_FILTER *rf_new(void *mem, size_t len)
+{
+    SSL_REPLAY_FILTER *rf = OPENSSL_zalloc(sizeof(*rf));
+
+    if (rf == NULL)
+        return NULL;
+    if ((rf->lock = CRYPTO_THREAD_lock_new()) == NULL) {
+        OPENSSL_free(rf);
+        return NULL;
+    }
+    rf->references = 1;
+    rf->mem = mem;
+    rf->mem_len = len;
+    rf->mem_type = RF_MEM_EXTERNAL;
+    rf->hdr = mem;
+    rf->bits = (uint64_t *)(rf->hdr + 1);
+    return rf;
+}
+
+static int rf_init(SSL_REPLAY_FILTER *rf, size_t entries,
+                   unsigned int window_secs)
+{
+    RF_HEADER *hdr = rf->hdr;
+
+    memset(rf->mem, 0, SSL_REPLAY_FILTER_mem_size(entries));
+    hdr->window = window_secs < RF_MIN_WINDOW ? RF_MIN_WINDOW : window_secs;
+    hdr->words = rf_words(entries);
+    if (RAND_bytes((unsigned char *)hdr->key, sizeof(hdr->key)) <= 0)
+        return 0;
+    /* Both generations are empty and valid for no window yet */
+    hdr->epoch[0] = hdr->epoch[1] = 0;
+    /* Publish the filter only once it is complete */
+    rf_store(&hdr->magic, RF_MAGIC);
+    return 1;
+}
+
+SSL_REPLAY_FILTER *SSL_REPLAY_FILTER_new(size_t entries,
+                                         unsigned int window_secs)
+{
+    SSL_REPLAY_FILTER *rf;
+    size_t len = SSL_REPLAY_FILTER_mem_size(entries);
+    void *mem;
+    int mem_type = RF_MEM_HEAP;
+
+    if (len == 0) {
+        SSLerr(SSL_F_SSL_REPLAY_FILTER_NEW, ERR_R_PASSED_INVALID_ARGUMENT);
+        return NULL;
+    }
+#ifdef RF_MMAP
+    /* Shared with the children forked once the filter exists */
+    mem = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+               -1, 0);
+    if (mem == MAP_FAILED)
+        mem = NULL;
+    else
+        mem_type = RF_MEM_MAPPED;
+#else
+    mem = NULL;
+#endif
+    if (mem == NULL && (mem = OPENSSL_zalloc(len)) == NULL) {
+        SSLerr(SSL_F_SSL_REPLAY_FILTER_NEW, ERR_R_MALLOC_FAILURE);
+        return NULL;
+    }
+    if ((rf = rf_new(mem, len)) == NULL) {
+        SSLerr(SSL_F_SSL_REPLAY_FILTER_NEW, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+    rf->mem_type = mem_type;
+    if (!rf_init(rf, entries, window_secs)) {
+        SSLerr(SSL_F_SSL_REPLAY_FILTER_NEW, ERR_R_INTERNAL_ERROR);
+        SSL_REPLAY_FILTER_free(rf);
+        return NULL;
+    }
+    return rf;
+
+ err:
+#ifdef RF_MMAP
+    if (mem_type == RF_MEM_MAPPED) {
+        munmap(mem, len);
+        return NULL;
+    }
+#endif
+    OPENSSL_free(mem);
+    return NULL;
+}
+
+SSL_REPLAY_FILTER *SSL_REPLAY_FILTER_new_mem(void *mem, size_t len,
+                                             size_t entries,
+                                             unsigned int window_secs)
+{
+    SSL_REPLAY_FILTER *rf;
+    size_t need = SSL_REPLAY_FILTER_mem_size(entries);
+
+#ifndef RF_ATOMICS
+    SSLerr(SSL_F_SSL_REPLAY_FILTER_NEW_MEM, ERR_R_DISABLED);
+    return NULL;
+#endif
+    if (mem == NULL || need == 0 || len < need) {
+        SSLerr(SSL_F_SSL_REPLAY_FILTER_NEW_MEM, ERR_R_PASSED_INVALID_ARGUMENT);
+        return NULL;
+    }
+    if ((rf = rf_new(mem, len)) == NULL) {
+        SSLerr(SSL_F_SSL_REPLAY_FILTER_NEW_MEM, ERR_R_MALLOC_FAILURE);
+        return NULL;
+    }
+    if (!rf_init(rf, entries, window_secs)) {
+        SSLerr(SSL_F_SSL_REPLAY_FILTER_NEW_MEM, ERR_R_INTERNAL_ERROR);
+        SSL_REPLAY_FILTER_free(rf);
+        return NULL;
+    }
+    return rf;
+}
+
+SSL_REPLAY_FILTER *SSL_REPLAY_FILTER_attach(void *mem, size_t len)
+{
+    SSL_REPLAY_FILTER *rf;
+    RF_HEADER *hdr = mem;
+
+#ifndef RF_ATOMICS
+    SSLerr(SSL_F_SSL_REPLAY_FILTER_ATTACH, ERR_R_DISABLED);
+    return NULL;
+#endif
+    if (mem == NULL || len < sizeof(*hdr)) {
+        SSLerr(SSL_F_SSL_REPLAY_FILTER_ATTACH, ERR_R_PASSED_INVALID_ARGUMENT);
+        return NULL;
+    }
+    if (rf_load(&hdr->magic) != RF_MAGIC
+            || hdr->window < RF_MIN_WINDOW
+            || hdr->words < RF_MIN_WORDS
+            || (hdr->words & (hdr->words - 1)) != 0
+            || hdr->words > (len - sizeof(*hdr)) / (2 * sizeof(uint64_t))) {
+        SSLerr(SSL_F_SSL_REPLAY_FILTER_ATTACH, SSL_R_BAD_REPLAY_FILTER);
+        return NULL;
+    }
+    if ((rf = rf_new(mem, len)) == NULL) {
+        SSLerr(SSL_F_SSL_REPLAY_FILTER_ATTACH, ERR_R_MALLOC_FAILURE);
+        return NULL;
+    }
+    return rf;
+}
+
+int SSL_REPLAY_FILTER_up_ref(SSL_REPLAY_FILTER *rf)
+{
+    int i;
+
+    if (CRYPTO_UP_REF(&rf->references, &i, rf->lock) <= 0)
+        return 0;
+
+    REF_PRINT_COUNT("SSL_REPLAY_FILTER", rf);
+    REF_ASSERT_ISNT(i < 2);
+    return ((i > 1) ? 1 : 0);
+}
+
+void SSL_REPLAY_FILTER_free(SSL_REPLAY_FILTER *rf)
+{
+    int i;
+
+    if (rf == NULL)
+        return;
+
+    CRYPTO_DOWN_REF(&rf->references, &i, rf->lock);
+    REF_PRINT_COUNT("SSL_REPLAY_FILTER", rf);
+    if (i > 0)
+        return;
+    REF_ASSERT_ISNT(i < 0);
+
+    switch (rf->mem_type) {
+    case RF_MEM_HEAP:
+        OPENSSL_free(rf->mem);
+        break;
+#ifdef RF_MMAP
+    case RF_MEM_MAPPED:
+        munmap(rf->mem, rf->mem_len);
+        break;
+#endif
+    default:
+        break;
+    }
+    CRYPTO_THREAD_lock_free(rf->lock);
+    OPENSSL_free(rf);
+}
+
+/* The finaliser of SplitMix64 */
+static ossl_inline uint64_t rf_mix(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/*
+ * Hash |data| under the key of the filter into the index of a word and the
+ * bits to test in it. The data are PSK binders, which nobody without the PSK
+ * can choose, so the key only keeps a client from aiming at chosen words.
+ */
+static void rf_hash(const RF_HEADER *hdr, const unsigned char *data,
+                    size_t len, uint64_t *word, uint64_t *mask)
+{
+    uint64_t h = hdr->key[0] ^ len, chunk;
+    size_t i, j;
+    int k;
+
+    for (i = 0; i < len; i += 8) {
+        chunk = 0;
+        for (j = i; j < len && j < i + 8; j++)
+            chunk = (chunk << 8) | data[j];
+        h = rf_mix(h ^ chunk);
+    }
+    *word = h & (hdr->words - 1);
+    h = rf_mix(h ^ hdr->key[1]);
+    for (*mask = 0, k = 0; k < RF_HASHES; k++, h >>= 6)
+        *mask |= (uint64_t)1 << (h & 63);
+}
+
+/*
+ * Make generation |g| the one for window |epoch|, clearing it if it was for
+ * an older window. Returns 0 if it can't be used for |epoch|.
+ */
+static int rf_generation(SSL_REPLAY_FILTER *rf, int g, uint64_t epoch)
+{
+    RF_HEADER *hdr = rf->hdr;
+    uint64_t *bits = rf->bits + g * hdr->words;
+    uint64_t cur = rf_load(&hdr->epoch[g]);
+    uint64_t i;
+
+    if (cur == epoch)
+        return 1;
+    /* Being cleared, or our clock is behind the one of another process */
+    if (cur == RF_CLEARING || cur > epoch)
+        return 0;
+#ifdef RF_ATOMICS
+    if (!__atomic_compare_exchange_n(&hdr->epoch[g], &cur, RF_CLEARING, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        return cur == epoch;
+    for (i = 0; i < hdr->words; i++)
+        __atomic_store_n(&bits[i], 0, __ATOMIC_RELAXED);
+#else
+    for (i = 0; i < hdr->words; i++)
+        bits[i] = 0;
+#endif
+    rf_store(&hdr->epoch[g], epoch);
+    return 1;
+}
+
+/*
+ * Record |data|, which identifies a ClientHello, in |rf|. Returns 1 if it
+ * was not seen before in the last window, or 0 if it may have been, or if
+ * the filter can't tell.
+ */
+static int rf_check(SSL_REPLAY_FILTER *rf, const unsigned char *data,
+                    size_t len)
+{
+    RF_HEADER *hdr = rf->hdr;
+    uint64_t now = (uint64_t)time(NULL), epoch = now / hdr->window;
+    uint64_t word, mask, old, prev;
+    int g = (int)(epoch & 1);
+
+    rf_hash(hdr, data, len, &word, &mask);
+    if (!rf_generation(rf, g, epoch))
+        return 0;
+
+    old = rf_or(&rf->bits[g * hdr->words + word], mask);
+    if ((old & mask) == mask)
+        return 0;
+
+    /*
+     * The previous generation only counts if it is for the previous window,
+     * and is still so after the word was read.
+     */
+    prev = rf_load(&hdr->epoch[g ^ 1]);
+    if (prev != epoch - 1)
+        return 1;
+    old = rf_load(&rf->bits[(g ^ 1) * hdr->words + word]);
+    if (rf_load(&hdr->epoch[g ^ 1]) != prev)
+        return 0;
+    return (old & mask) != mask;
+}
+
+int ssl_replay_filter_check(SSL_REPLAY_FILTER *rf, const unsigned char *data,
+                            size_t len)
+{
+#ifdef RF_ATOMICS
+    return rf_check(rf, data, len);
+#else
+    int ret;
+
+    if (!CRYPTO_THREAD_write_lock(rf->lock))
+        return 0;
+    ret = rf_check(rf, data, len);
+    CRYPTO_THREAD_unlock(rf->lock);
+    return ret;
+#endif
+}
+
+int SSL_CTX_set1_replay_filter(SSL_CTX *ctx, SSL_REPLAY_FILTER *rf)
+{
+    if (rf != NULL && !SSL_REPLAY_FILTER_up_ref(rf))
+        return 0;
+    SSL_REPLAY_FILTER_free(ctx->replay_filter);
+    ctx->replay_filter = rf;
+    return 1;
+}
+
+SSL_REPLAY_FILTER *SSL_CTX_get0_replay_filter(const SSL_CTX *ctx)
+{
+    return ctx->replay_filter;
+}
@@ -151,6 +151,7 @@ static int ssl_set_pkey(CERT *c, EVP_PKEY *pkey)
         if (!X509_check_private_key(c->pkeys[i].x509, pkey)) {
             X509_free(c->pkeys[i].x509);
             c->pkeys[i].x509 = NULL;
+            tls1_set_cert_sigalgs(&c->pkeys[i]);
             return 0;
         }
     }
@@ -158,6 +159,7 @@ static int ssl_set_pkey(CERT *c, EVP_PKEY *pkey)
     EVP_PKEY_free(c->pkeys[i].privatekey);
     EVP_PKEY_up_ref(pkey);
     c->pkeys[i].privatekey = pkey;
+    tls1_set_cert_sigalgs(&c->pkeys[i]);
     c->key = &c->pkeys[i];
     return 1;
 }
@@ -349,6 +351,7 @@ static int ssl_set_cert(CERT *c, X509 *x)
     X509_free(c->pkeys[i].x509);
     X509_up_ref(x);
     c->pkeys[i].x509 = x;
+    tls1_set_cert_sigalgs(&c->pkeys[i]);
     c->key = &(c->pkeys[i]);
 
     return 1;
@@ -1139,6 +1142,7 @@ static int ssl_set_cert_and_key(SSL *ssl, SSL_CTX *ctx, X509 *x509, EVP_PKEY *pr
     EVP_PKEY_free(c->pkeys[i].privatekey);
     EVP_PKEY_up_ref(privatekey);
     c->pkeys[i].privatekey = privatekey;
+    tls1_set_cert_sigalgs(&c->pkeys[i]);
 
     c->key = &(c->pkeys[i]);
 
@@ -16,10 +16,15 @@
 #include "ssl_local.h"
 #include "statem/statem_local.h"
 
-static void SSL_SESSION_list_remove(SSL_CTX *ctx, SSL_SESSION *s);
-static void SSL_SESSION_list_add(SSL_CTX *ctx, SSL_SESSION *s);
+static void SSL_SESSION_list_remove(SSL_SESS_SHARD *shard, SSL_SESSION *s);
+static void SSL_SESSION_list_add(SSL_SESS_SHARD *shard, SSL_SESSION *s);
 static int remove_session_lock(SSL_CTX *ctx, SSL_SESSION *c, int lck);
 
+static ossl_inline long session_expiry(const SSL_SESSION *s)
+{
+    return s->time + s->timeout;
+}
+
 /*
  * SSL_get_session() and SSL_get1_session() are problematic in TLS1.3 because,
  * unlike in earlier protocol versions, the session ticket may not have been
@@ -66,7 +71,7 @@ SSL_SESSION *SSL_SESSION_new(void)
 {
     SSL_SESSION *ss;
 
-    if (!OPENSSL_init_ssl(OPENSSL_INIT_LOAD_SSL_STRINGS, NULL))
+    if (!OPENSSL_init_ssl(0, NULL))
         return NULL;
 
     ss = OPENSSL_zalloc(sizeof(*ss));
@@ -424,6 +429,7 @@ SSL_SESSION *lookup_sess_in_cache(SSL *s, const unsigned char *sess_id,
     if ((s->session_ctx->session_cache_mode
          & SSL_SESS_CACHE_NO_INTERNAL_LOOKUP) == 0) {
         SSL_SESSION data;
+        SSL_SESS_SHARD *shard;
 
         data.ssl_version = s->version;
         if (!ossl_assert(sess_id_len <= SSL_MAX_SSL_SESSION_ID_LENGTH))
@@ -432,15 +438,18 @@ SSL_SESSION *lookup_sess_in_cache(SSL *s, const unsigned char *sess_id,
         memcpy(data.session_id, sess_id, sess_id_len);
         data.session_id_length = sess_id_len;
 
-        CRYPTO_THREAD_read_lock(s->session_ctx->lock);
-        ret = lh_SSL_SESSION_retrieve(s->session_ctx->sessions, &data);
+        shard = ssl_session_cache_shard(s->session_ctx, &data);
+        CRYPTO_THREAD_read_lock(shard->lock);
+        ret = lh_SSL_SESSION_retrieve(shard->sessions, &data);
         if (ret != NULL) {
             /* don't allow other threads to steal it: */
             SSL_SESSION_up_ref(ret);
         }
-        CRYPTO_THREAD_unlock(s->session_ctx->lock);
-        if (ret == NULL)
+        CRYPTO_THREAD_unlock(shard->lock);
+        if (ret == NULL) {
             tsan_counter(&s->session_ctx->stats.sess_miss);
+            OSSL_METRIC_INC(OSSL_METRIC_SSL_SESS_MISSES);
+        }
     }
 
     if (ret == NULL && s->session_ctx->get_session_cb != NULL) {
@@ -584,7 +593,8 @@ int ssl_get_prev_session(SSL *s, CLIENTHELLO_MSG *hello)
         tsan_counter(&s->session_ctx->stats.sess_timeout);
         if (try_session_cache) {
             /* session was from the cache, so remove it */
-            SSL_CTX_remove_session(s->session_ctx, ret);
+            if (SSL_CTX_remove_session(s->session_ctx, ret))
+                OSSL_METRIC_INC(OSSL_METRIC_SSL_SESS_EVICTIONS);
         }
         goto err;
     }
@@ -610,6 +620,7 @@ int ssl_get_prev_session(SSL *s, CLIENTHELLO_MSG *hello)
     }
 
     tsan_counter(&s->session_ctx->stats.sess_hit);
+    OSSL_METRIC_INC(OSSL_METRIC_SSL_SESS_HITS);
     s->verify_result = s->session->verify_result;
     return 1;
 
@@ -638,6 +649,8 @@ int SSL_CTX_add_session(SSL_CTX *ctx, SSL_SESSION *c)
 {
     int ret = 0;
     SSL_SESSION *s;
+    SSL_SESS_SHARD *shard = ssl_session_cache_shard(ctx, c);
+    size_t limit;
 
     /*
      * add just 1 reference count for the SSL_CTX's session cache even though
@@ -649,17 +662,17 @@ int SSL_CTX_add_session(SSL_CTX *ctx, SSL_SESSION *c)
      * if session c is in already in cache, we take back the increment later
      */
 
-    CRYPTO_THREAD_write_lock(ctx->lock);
-    s = lh_SSL_SESSION_insert(ctx->sessions, c);
+    CRYPTO_THREAD_write_lock(shard->lock);
+    s = lh_SSL_SESSION_insert(shard->sessions, c);
 
     /*
      * s != NULL iff we already had a session with the given PID. In this
      * case, s == c should hold (then we did not really modify
-     * ctx->sessions), or we're in trouble.
+     * shard->sessions), or we're in trouble.
      */
     if (s != NULL && s != c) {
         /* We *are* in trouble ... */
-        SSL_SESSION_list_remove(ctx, s);
+        SSL_SESSION_list_remove(shard, s);
         SSL_SESSION_free(s);
         /*
          * ... so pretend the other session did not exist in cache (we cannot
@@ -669,7 +682,7 @@ int SSL_CTX_add_session(SSL_CTX *ctx, SSL_SESSION *c)
          */
         s = NULL;
     } else if (s == NULL &&
-               lh_SSL_SESSION_retrieve(ctx->sessions, c) == NULL) {
+               lh_SSL_SESSION_retrieve(shard->sessions, c) == NULL) {
         /* s == NULL can also mean OOM error in lh_SSL_SESSION_insert ... */
 
         /*
@@ -681,7 +694,7 @@ int SSL_CTX_add_session(SSL_CTX *ctx, SSL_SESSION *c)
 
     /* Put at the head of the queue unless it is already in the cache */
     if (s == NULL)
-        SSL_SESSION_list_add(ctx, c);
+        SSL_SESSION_list_add(shard, c);
 
     if (s != NULL) {
         /*
@@ -693,21 +706,24 @@ int SSL_CTX_add_session(SSL_CTX *ctx, SSL_SESSION *c)
         ret = 0;
     } else {
         /*
-         * new cache entry -- remove old ones if cache has become too large
+         * new cache entry -- remove old ones if the shard has become too
+         * large
          */
 
         ret = 1;
 
-        if (SSL_CTX_sess_get_cache_size(ctx) > 0) {
-            while (SSL_CTX_sess_number(ctx) > SSL_CTX_sess_get_cache_size(ctx)) {
-                if (!remove_session_lock(ctx, ctx->session_cache_tail, 0))
+        if (ctx->session_cache_size > 0) {
+            limit = (ctx->session_cache_size + ctx->sess_num_shards - 1)
+                    / ctx->sess_num_shards;
+            while (lh_SSL_SESSION_num_items(shard->sessions) > limit) {
+                if (!remove_session_lock(ctx, shard->tail, 0))
                     break;
-                else
-                    tsan_counter(&ctx->stats.sess_cache_full);
+                tsan_counter(&ctx->stats.sess_cache_full);
+                OSSL_METRIC_INC(OSSL_METRIC_SSL_SESS_EVICTIONS);
             }
         }
     }
-    CRYPTO_THREAD_unlock(ctx->lock);
+    CRYPTO_THREAD_unlock(shard->lock);
     return ret;
 }
 
@@ -719,20 +735,22 @@ int SSL_CTX_remove_session(SSL_CTX *ctx, SSL_SESSION *c)
 static int remove_session_lock(SSL_CTX *ctx, SSL_SESSION *c, int lck)
 {
     SSL_SESSION *r;
+    SSL_SESS_SHARD *shard;
     int ret = 0;
 
     if ((c != NULL) && (c->session_id_length != 0)) {
+        shard = ssl_session_cache_shard(ctx, c);
         if (lck)
-            CRYPTO_THREAD_write_lock(ctx->lock);
-        if ((r = lh_SSL_SESSION_retrieve(ctx->sessions, c)) != NULL) {
+            CRYPTO_THREAD_write_lock(shard->lock);
+        if ((r = lh_SSL_SESSION_retrieve(shard->sessions, c)) != NULL) {
             ret = 1;
-            r = lh_SSL_SESSION_delete(ctx->sessions, r);
-            SSL_SESSION_list_remove(ctx, r);
+            r = lh_SSL_SESSION_delete(shard->sessions, r);
+            SSL_SESSION_list_remove(shard, r);
         }
         c->not_resumable = 1;
 
         if (lck)
-            CRYPTO_THREAD_unlock(ctx->lock);
+            CRYPTO_THREAD_unlock(shard->lock);
 
         if (ctx->remove_session_cb != NULL)
             ctx->remove_session_cb(ctx, c);
@@ -1045,7 +1063,7 @@ int SSL_set_session_ticket_ext(SSL *s, void *ext_data, int ext_len)
 typedef struct timeout_param_st {
     SSL_CTX *ctx;
     long time;
-    LHASH_OF(SSL_SESSION) *cache;
+    SSL_SESS_SHARD *shard;
 } TIMEOUT_PARAM;
 
 static void timeout_cb(SSL_SESSION *s, TIMEOUT_PARAM *p)
@@ -1055,12 +1073,14 @@ static void timeout_cb(SSL_SESSION *s, TIMEOUT_PARAM *p)
          * The reason we don't call SSL_CTX_remove_session() is to save on
          * locking overhead
          */
-        (void)lh_SSL_SESSION_delete(p->cache, s);
-        SSL_SESSION_list_remove(p->ctx, s);
+        (void)lh_SSL_SESSION_delete(p->shard->sessions, s);
+        SSL_SESSION_list_remove(p->shard, s);
         s->not_resumable = 1;
         if (p->ctx->remove_session_cb != NULL)
             p->ctx->remove_session_cb(p->ctx, s);
         SSL_SESSION_free(s);
+        if (p->time != 0)
+            OSSL_METRIC_INC(OSSL_METRIC_SSL_SESS_EVICTIONS);
     }
 }
 
@@ -1069,19 +1089,96 @@ IMPLEMENT_LHASH_DOALL_ARG(SSL_SESSION, TIMEOUT_PARAM);
 void SSL_CTX_flush_sessions(SSL_CTX *s, long t)
 {
     unsigned long i;
+    size_t j;
     TIMEOUT_PARAM tp;
 
-    tp.ctx = s;
-    tp.cache = s->sessions;
-    if (tp.cache == NULL)
+    if (s->sess_shards == NULL)
         return;
+    tp.ctx = s;
     tp.time = t;
-    CRYPTO_THREAD_write_lock(s->lock);
-    i = lh_SSL_SESSION_get_down_load(s->sessions);
-    lh_SSL_SESSION_set_down_load(s->sessions, 0);
-    lh_SSL_SESSION_doall_TIMEOUT_PARAM(tp.cache, timeout_cb, &tp);
-    lh_SSL_SESSION_set_down_load(s->sessions, i);
-    CRYPTO_THREAD_unlock(s->lock);
+    for (j = 0; j < s->sess_num_shards; j++) {
+        tp.shard = &s->sess_shards[j];
+        CRYPTO_THREAD_write_lock(tp.shard->lock);
+        i = lh_SSL_SESSION_get_down_load(tp.shard->sessions);
+        lh_SSL_SESSION_set_down_load(tp.shard->sessions, 0);
+        lh_SSL_SESSION_doall_TIMEOUT_PARAM(tp.shard->sessions, timeout_cb, &tp);
+        lh_SSL_SESSION_set_down_load(tp.shard->sessions, i);
+        CRYPTO_THREAD_unlock(tp.shard->lock);
+    }
+}
+
+/*
+ * Remove the sessions of |shard| that have expired at time |t| from its tail,
+ * at most |max| (0 for no limit) and until |deadline| if it is not NULL.
+ * Returns 1 if no expired sessions are left.
+ */
+static int flush_shard(SSL_CTX *ctx, SSL_SESS_SHARD *shard, long t,
+                       size_t max, const struct timeval *deadline)
+{
+    SSL_SESSION *s;
+    struct timeval now;
+    size_t n = 0;
+    int done = 1;
+
+    CRYPTO_THREAD_write_lock(shard->lock);
+    while ((s = shard->tail) != NULL && (t == 0 || t > session_expiry(s))) {
+        if (max != 0 && n == max) {
+            done = 0;
+            break;
+        }
+        /* The clock is only read every 16 sessions */
+        if (deadline != NULL && (n & 15) == 15) {
+            ssl_get_current_time(&now);
+            if (now.tv_sec > deadline->tv_sec
+                    || (now.tv_sec == deadline->tv_sec
+                        && now.tv_usec >= deadline->tv_usec)) {
+                done = 0;
+                break;
+            }
+        }
+        (void)lh_SSL_SESSION_delete(shard->sessions, s);
+        SSL_SESSION_list_remove(shard, s);
+        s->not_resumable = 1;
+        if (ctx->remove_session_cb != NULL)
+            ctx->remove_session_cb(ctx, s);
+        SSL_SESSION_free(s);
+        if (t != 0)
+            OSSL_METRIC_INC(OSSL_METRIC_SSL_SESS_EVICTIONS);
+        n++;
+    }
+    CRYPTO_THREAD_unlock(shard->lock);
+    return done;
+}
+
+int SSL_CTX_flush_expired_sessions(SSL_CTX *ctx, long t, size_t max_sessions,
+                                   long max_usec)
+{
+    struct timeval deadline;
+    size_t i, max = 0;
+    int done = 1;
+
+    if (ctx->sess_shards == NULL)
+        return 1;
+
+    if (max_usec > 0) {
+        ssl_get_current_time(&deadline);
+        deadline.tv_sec += max_usec / 1000000;
+        deadline.tv_usec += max_usec % 1000000;
+        if (deadline.tv_usec >= 1000000) {
+            deadline.tv_sec++;
+            deadline.tv_usec -= 1000000;
+        }
+    }
+    /* Every shard gets its share of the sessions */
+    if (max_sessions > 0)
+        max = (max_sessions + ctx->sess_num_shards - 1) / ctx->sess_num_shards;
+
+    for (i = 0; i < ctx->sess_num_shards; i++) {
+        if (!flush_shard(ctx, &ctx->sess_shards[i], t, max,
+                         max_usec > 0 ? &deadline : NULL))
+            done = 0;
+    }
+    return done;
 }
 
 int ssl_clear_bad_session(SSL *s)
@@ -1095,27 +1192,27 @@ int ssl_clear_bad_session(SSL *s)
         return 0;
 }
 
-/* locked by SSL_CTX in the calling function */
-static void SSL_SESSION_list_remove(SSL_CTX *ctx, SSL_SESSION *s)
+/* locked by the shard lock in the calling function */
+static void SSL_SESSION_list_remove(SSL_SESS_SHARD *shard, SSL_SESSION *s)
 {
     if ((s->next == NULL) || (s->prev == NULL))
         return;
 
-    if (s->next == (SSL_SESSION *)&(ctx->session_cache_tail)) {
+    if (s->next == (SSL_SESSION *)&(shard->tail)) {
         /* last element in list */
-        if (s->prev == (SSL_SESSION *)&(ctx->session_cache_head)) {
+        if (s->prev == (SSL_SESSION *)&(shard->head)) {
             /* only one element in list */
-            ctx->session_cache_head = NULL;
-            ctx->session_cache_tail = NULL;
+            shard->head = NULL;
+            shard->tail = NULL;
         } else {
-            ctx->session_cache_tail = s->prev;
-            s->prev->next = (SSL_SESSION *)&(ctx->session_cache_tail);
+            shard->tail = s->prev;
+            s->prev->next = (SSL_SESSION *)&(shard->tail);
         }
     } else {
-        if (s->prev == (SSL_SESSION *)&(ctx->session_cache_head)) {
+        if (s->prev == (SSL_SESSION *)&(shard->head)) {
             /* first element in list */
-            ctx->session_cache_head = s->next;
-            s->next->prev = (SSL_SESSION *)&(ctx->session_cache_head);
+            shard->head = s->next;
+            s->next->prev = (SSL_SESSION *)&(shard->head);
         } else {
             /* middle of list */
             s->next->prev = s->prev;
@@ -1125,22 +1222,124 @@ static void SSL_SESSION_list_remove(SSL_CTX *ctx, SSL_SESSION *s)
     s->prev = s->next = NULL;
 }
 
-static void SSL_SESSION_list_add(SSL_CTX *ctx, SSL_SESSION *s)
+/*
+ * New sessions normally expire last and go to the head of the list, the
+ * list is only walked for sessions with a shorter timeout
+ */
+static void SSL_SESSION_list_add(SSL_SESS_SHARD *shard, SSL_SESSION *s)
 {
-    if ((s->next != NULL) && (s->prev != NULL))
-        SSL_SESSION_list_remove(ctx, s);
+    SSL_SESSION *next;
+    long expiry = session_expiry(s);
 
-    if (ctx->session_cache_head == NULL) {
-        ctx->session_cache_head = s;
-        ctx->session_cache_tail = s;
-        s->prev = (SSL_SESSION *)&(ctx->session_cache_head);
-        s->next = (SSL_SESSION *)&(ctx->session_cache_tail);
-    } else {
-        s->next = ctx->session_cache_head;
+    if ((s->next != NULL) && (s->prev != NULL))
+        SSL_SESSION_list_remove(shard, s);
+
+    if (shard->head == NULL) {
+        shard->head = s;
+        shard->tail = s;
+        s->prev = (SSL_SESSION *)&(shard->head);
+        s->next = (SSL_SESSION *)&(shard->tail);
+    } else if (expiry >= session_expiry(shard->head)) {
+        s->next = shard->head;
         s->next->prev = s;
-        s->prev = (SSL_SESSION *)&(ctx->session_cache_head);
-        ctx->session_cache_head = s;
+        s->prev = (SSL_SESSION *)&(shard->head);
+        shard->head = s;
+    } else if (expiry <= session_expiry(shard->tail)) {
+        s->prev = shard->tail;
+        s->prev->next = s;
+        s->next = (SSL_SESSION *)&(shard->tail);
+        shard->tail = s;
+    } else {
+        /* Somewhere in between, after the head and before the tail */
+        for (next = shard->head->next; session_expiry(next) > expiry;
+             next = next->next)
+            continue;
+        s->next = next;
+        s->prev = next->prev;
+        s->prev->next = s;
+        next->prev = s;
+    }
+}
+
+/*
+ * Replace the internal session cache of |ctx|, which must be empty, by one
+ * with |num_shards| shards. The cache is left alone on failure.
+ */
+int ssl_session_cache_new(SSL_CTX *ctx, size_t num_shards)
+{
+    SSL_SESS_SHARD *shards;
+    size_t i;
+
+    if (num_shards == 0 || num_shards > SSL_SESS_CACHE_MAX_SHARDS)
+        return 0;
+
+    shards = OPENSSL_zalloc(sizeof(*shards) * num_shards);
+    if (shards == NULL)
+        return 0;
+    for (i = 0; i < num_shards; i++) {
+        shards[i].lock = CRYPTO_THREAD_lock_new();
+        shards[i].sessions = lh_SSL_SESSION_new(ssl_session_hash,
+                                                ssl_session_cmp);
+        if (shards[i].lock == NULL || shards[i].sessions == NULL) {
+            num_shards = i + 1;
+            goto err;
+        }
     }
+
+    ssl_session_cache_free(ctx);
+    ctx->sess_shards = shards;
+    ctx->sess_num_shards = num_shards;
+    return 1;
+
+ err:
+    for (i = 0; i < num_shards; i++) {
+        CRYPTO_THREAD_lock_free(shards[i].lock);
+        lh_SSL_SESSION_free(shards[i].sessions);
+    }
+    OPENSSL_free(shards);
+    return 0;
+}
+
+/* Frees the shards of the internal session cache, the sessions are not */
+void ssl_session_cache_free(SSL_CTX *ctx)
+{
+    size_t i;
+
+    if (ctx->sess_shards == NULL)
+        return;
+    for (i = 0; i < ctx->sess_num_shards; i++) {
+        CRYPTO_THREAD_lock_free(ctx->sess_shards[i].lock);
+        lh_SSL_SESSION_free(ctx->sess_shards[i].sessions);
+    }
+    OPENSSL_free(ctx->sess_shards);
+    ctx->sess_shards = NULL;
+    ctx->sess_num_shards = 0;
+}
+
+/*
+ * Returns the shard for sessions with the ID of |s|. All bytes of the ID are
+ * hashed, independently of the hash of the lhash within the shard.
+ */
+SSL_SESS_SHARD *ssl_session_cache_shard(SSL_CTX *ctx, const SSL_SESSION *s)
+{
+    uint32_t h = 2166136261U;
+    size_t i;
+
+    if (ctx->sess_num_shards == 1)
+        return &ctx->sess_shards[0];
+
+    for (i = 0; i < s->session_id_length; i++)
+        h = (h ^ s->session_id[i]) * 16777619U;
+    return &ctx->sess_shards[h % ctx->sess_num_shards];
+}
+
+size_t ssl_session_cache_number(SSL_CTX *ctx)
+{
+    size_t i, num = 0;
+
+    for (i = 0; i < ctx->sess_num_shards; i++)
+        num += lh_SSL_SESSION_num_items(ctx->sess_shards[i].sessions);
+    return num;
 }
 
 void SSL_CTX_sess_set_new_cb(SSL_CTX *ctx,
@@ -1179,6 +1378,40 @@ SSL_SESSION *(*SSL_CTX_sess_get_get_cb(SSL_CTX *ctx)) (SSL *ssl,
     return ctx->get_session_cb;
 }
 
+/*
+ * Any address will do as the key of the wait fd, it only has to differ from
+ * the keys engines use for their own fds.
+ */
+static const char sess_cb_wait_key = 0;
+
+/*
+ * Called from a session cache callback of |s| to suspend the handshake until
+ * |fd| becomes readable. This only works while the handshake of |s| runs in
+ * an ASYNC job, i.e. with SSL_MODE_ASYNC set. The SSL_do_handshake call in
+ * progress returns SSL_ERROR_WANT_ASYNC and the callback continues once the
+ * application calls it again. Returns 1 once resumed, 0 if |s| could not be
+ * suspended; the callback then has to complete synchronously.
+ */
+int SSL_sess_cb_pause(SSL *s, OSSL_ASYNC_FD fd)
+{
+    ASYNC_JOB *job = ASYNC_get_current_job();
+    ASYNC_WAIT_CTX *waitctx;
+    int ret;
+
+    if (job == NULL || (s->mode & SSL_MODE_ASYNC) == 0
+            || (waitctx = ASYNC_get_wait_ctx(job)) == NULL
+            || waitctx != s->waitctx)
+        return 0;
+
+    if (!ASYNC_WAIT_CTX_set_wait_fd(waitctx, &sess_cb_wait_key, fd, NULL,
+                                    NULL))
+        return 0;
+    ret = ASYNC_pause_job();
+    ASYNC_WAIT_CTX_clear_fd(waitctx, &sess_cb_wait_key);
+
+    return ret;
+}
+
 void SSL_CTX_set_info_callback(SSL_CTX *ctx,
                                void (*cb) (const SSL *ssl, int type, int val))
 {
@@ -1259,6 +1492,118 @@ int SSL_SESSION_get0_ticket_appdata(SSL_SESSION *ss, void **data, size_t *len)
     return 1;
 }
 
+/* Upper bound for SSL_CTX_set_ticket_peer_cert_cache_size() */
+#define SSL_PEER_CERT_CACHE_MAX         65536
+
+static SSL_PEER_CERT_SLOT *peer_cert_cache_slot(SSL_PEER_CERT_CACHE *cache,
+                                                const unsigned char *digest)
+{
+    size_t idx = ((size_t)digest[0] << 24) | ((size_t)digest[1] << 16)
+                 | ((size_t)digest[2] << 8) | digest[3];
+
+    return &cache->slots[idx % cache->size];
+}
+
+void ssl_peer_cert_cache_free(SSL_PEER_CERT_CACHE *cache)
+{
+    size_t i;
+
+    if (cache == NULL)
+        return;
+    for (i = 0; i < cache->size; i++)
+        X509_free(cache->slots[i].cert);
+    OPENSSL_free(cache->slots);
+    CRYPTO_THREAD_lock_free(cache->lock);
+    OPENSSL_free(cache);
+}
+
+/*
+ * Remember |x| and store its SHA-256 in |digest|, which a ticket can then
+ * carry instead of |x|.
+ */
+int ssl_peer_cert_cache_add(SSL_PEER_CERT_CACHE *cache, X509 *x,
+                            unsigned char *digest)
+{
+    SSL_PEER_CERT_SLOT *slot;
+    unsigned int len;
+    int present;
+
+    if (!X509_digest(x, EVP_sha256(), digest, &len)
+            || len != SSL_PEER_DIGEST_LENGTH)
+        return 0;
+    slot = peer_cert_cache_slot(cache, digest);
+
+    /* Most certificates are already there, from an earlier ticket */
+    if (!CRYPTO_THREAD_read_lock(cache->lock))
+        return 0;
+    present = slot->cert != NULL
+              && memcmp(slot->digest, digest, SSL_PEER_DIGEST_LENGTH) == 0;
+    CRYPTO_THREAD_unlock(cache->lock);
+    if (present)
+        return 1;
+
+    if (!X509_up_ref(x))
+        return 0;
+    if (!CRYPTO_THREAD_write_lock(cache->lock)) {
+        X509_free(x);
+        return 0;
+    }
+    X509_free(slot->cert);
+    slot->cert = x;
+    memcpy(slot->digest, digest, SSL_PEER_DIGEST_LENGTH);
+    CRYPTO_THREAD_unlock(cache->lock);
+    return 1;
+}
+
+/* Returns a reference to the cached certificate |digest| is the hash of */
+X509 *ssl_peer_cert_cache_get(SSL_PEER_CERT_CACHE *cache,
+                              const unsigned char *digest)
+{
+    SSL_PEER_CERT_SLOT *slot = peer_cert_cache_slot(cache, digest);
+    X509 *x = NULL;
+
+    if (!CRYPTO_THREAD_read_lock(cache->lock))
+        return NULL;
+    if (slot->cert != NULL
+            && memcmp(slot->digest, digest, SSL_PEER_DIGEST_LENGTH) == 0
+            && X509_up_ref(slot->cert))
+        x = slot->cert;
+    CRYPTO_THREAD_unlock(cache->lock);
+    return x;
+}
+
+int SSL_CTX_set_ticket_peer_cert_cache_size(SSL_CTX *ctx, size_t size)
+{
+    SSL_PEER_CERT_CACHE *cache = NULL;
+
+    if (size > SSL_PEER_CERT_CACHE_MAX) {
+        SSLerr(SSL_F_SSL_CTX_SET_TICKET_PEER_CERT_CACHE_SIZE,
+               ERR_R_PASSED_INVALID_ARGUMENT);
+        return 0;
+    }
+    if (size > 0) {
+        if ((cache = OPENSSL_zalloc(sizeof(*cache))) == NULL
+                || (cache->slots = OPENSSL_zalloc(sizeof(*cache->slots)
+                                                  * size)) == NULL
+                || (cache->lock = CRYPTO_THREAD_lock_new()) == NULL) {
+            SSLerr(SSL_F_SSL_CTX_SET_TICKET_PEER_CERT_CACHE_SIZE,
+                   ERR_R_MALLOC_FAILURE);
+            ssl_peer_cert_cache_free(cache);
+            return 0;
+        }
+        cache->size = size;
+    }
+    ssl_peer_cert_cache_free(ctx->ext.tick_peer_cache);
+    ctx->ext.tick_peer_cache = cache;
+    return 1;
+}
+
+size_t SSL_CTX_get_ticket_peer_cert_cache_size(const SSL_CTX *ctx)
+{
+    return ctx->ext.tick_peer_cache != NULL ? ctx->ext.tick_peer_cache->size
+                                            : 0;
+}
+
 void SSL_CTX_set_stateless_cookie_generate_cb(
     SSL_CTX *ctx,
     int (*cb) (SSL *ssl,
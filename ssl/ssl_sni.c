@@ -0,0 +1,252 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <string.h>
+#include "ssl_local.h"
+#include "internal/refcount.h"
+
+/*
+ * An SNI map finds the SSL_CTX to switch a server connection to from the
+ * host name sent by the client. Names are kept in lower case in a single
+ * hash table. A wildcard name "*.example.com" is stored as "example.com"
+ * with the wildcard flag set, and since a wildcard only stands for the
+ * leftmost label, as in RFC 6125, looking up "www.example.com" takes one
+ * probe for the exact name and one for the wildcard on "example.com".
+ */
+typedef struct {
+    char *name;
+    int wildcard;
+    SSL_CTX *ctx;
+} SNI_ENTRY;
+
+DEFINE_LHASH_OF(SNI_ENTRY);
+
+struct ssl_sni_map_st {
+    LHASH_OF(SNI_ENTRY) *entries;
+    CRYPTO_REF_COUNT references;
+    CRYPTO_RWLOCK *lock;
+};
+
+static unsigned long sni_entry_hash(const SNI_ENTRY *e)
+{
+    return OPENSSL_LH_strhash(e->name) ^ (unsigned long)e->wildcard;
+}
+
+static int sni_entry_cmp(const SNI_ENTRY *a, const SNI_ENTRY *b)
+{
+    if (a->wildcard != b->wildcard)
+        return a->wildcard - b->wildcard;
+    return strcmp(a->name, b->name);
+}
+
+static void sni_entry_free(SNI_ENTRY *e)
+{
+    if (e == NULL)
+        return;
+    SSL_CTX_free(e->ctx);
+    OPENSSL_free(e->name);
+    OPENSSL_free(e);
+}
+
+/*
+ * Copies the host name |in| to |out| in lower case and without a trailing
+ * dot. If |wildcard| is not NULL a leading "*." is allowed, removed and
+ * reported there. Returns 0 if |in| is not a valid host name.
+ */
+static int sni_normalise(const char *in, char out[TLSEXT_MAXLEN_host_name + 1],
+                         int *wildcard)
+{
+    size_t len = strlen(in), i;
+
+    if (wildcard != NULL) {
+        *wildcard = len > 2 && in[0] == '*' && in[1] == '.';
+        if (*wildcard) {
+            in += 2;
+            len -= 2;
+        }
+    }
+    if (len > 0 && in[len - 1] == '.')
+        len--;
+    if (len == 0 || len > TLSEXT_MAXLEN_host_name)
+        return 0;
+    for (i = 0; i < len; i++) {
+        if (in[i] == '*' || in[i] == '\0'
+                || (in[i] == '.' && (i == 0 || in[i - 1] == '.')))
+            return 0;
+        out[i] = in[i] >= 'A' && in[i] <= 'Z' ? in[i] - 'A' + 'a' : in[i];
+    }
+    out[len] = '\0';
+    return 1;
+}
+
+SSL_SNI_MAP *SSL_SNI_MAP_new(void)
+{
+    SSL_SNI_MAP *map = OPENSSL_zalloc(sizeof(*map));
+
+    if (map == NULL
+            || (map->entries = lh_SNI_ENTRY_new(sni_entry_hash,
+                                                sni_entry_cmp)) == NULL
+            || (map->lock = CRYPTO_THREAD_lock_new()) == NULL) {
+        SSLerr(SSL_F_SSL_SNI_MAP_NEW, ERR_R_MALLOC_FAILURE);
+        if (map != NULL)
+            lh_SNI_ENTRY_free(map->entries);
+        OPENSSL_free(map);
+        return NULL;
+    }
+    map->references = 1;
+    return map;
+}
+
+int SSL_SNI_MAP_up_ref(SSL_SNI_MAP *map)
+{
+    int i;
+
+    if (CRYPTO_UP_REF(&map->references, &i, map->lock) <= 0)
+        return 0;
+
+    REF_PRINT_COUNT("SSL_SNI_MAP", map);
+    REF_ASSERT_ISNT(i < 2);
+    return ((i > 1) ? 1 : 0);
+}
+
+void SSL_SNI_MAP_free(SSL_SNI_MAP *map)
+{
+    int i;
+
+    if (map == NULL)
+        return;
+
+    CRYPTO_DOWN_REF(&map->references, &i, map->lock);
+    REF_PRINT_COUNT("SSL_SNI_MAP", map);
+    if (i > 0)
+        return;
+    REF_ASSERT_ISNT(i < 0);
+
+    lh_SNI_ENTRY_doall(map->entries, sni_entry_free);
+    lh_SNI_ENTRY_free(map->entries);
+    CRYPTO_THREAD_lock_free(map->lock);
+    OPENSSL_free(map);
+}
+
+int SSL_SNI_MAP_add(SSL_SNI_MAP *map, const char *name, SSL_CTX *ctx)
+{
+    char buf[TLSEXT_MAXLEN_host_name + 1];
+    SNI_ENTRY *e, *old;
+    int wildcard;
+
+    if (!sni_normalise(name, buf, &wildcard)) {
+        SSLerr(SSL_F_SSL_SNI_MAP_ADD, SSL_R_INVALID_HOST_NAME);
+        return 0;
+    }
+    if ((e = OPENSSL_zalloc(sizeof(*e))) == NULL
+            || (e->name = OPENSSL_strdup(buf)) == NULL) {
+        OPENSSL_free(e);
+        SSLerr(SSL_F_SSL_SNI_MAP_ADD, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    e->wildcard = wildcard;
+    if (!SSL_CTX_up_ref(ctx)) {
+        sni_entry_free(e);
+        return 0;
+    }
+    e->ctx = ctx;
+
+    CRYPTO_THREAD_write_lock(map->lock);
+    old = lh_SNI_ENTRY_insert(map->entries, e);
+    if (old == NULL && lh_SNI_ENTRY_error(map->entries)) {
+        CRYPTO_THREAD_unlock(map->lock);
+        sni_entry_free(e);
+        SSLerr(SSL_F_SSL_SNI_MAP_ADD, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    CRYPTO_THREAD_unlock(map->lock);
+    sni_entry_free(old);
+    return 1;
+}
+
+int SSL_SNI_MAP_remove(SSL_SNI_MAP *map, const char *name)
+{
+    char buf[TLSEXT_MAXLEN_host_name + 1];
+    SNI_ENTRY key, *e;
+
+    if (!sni_normalise(name, buf, &key.wildcard))
+        return 0;
+    key.name = buf;
+
+    CRYPTO_THREAD_write_lock(map->lock);
+    e = lh_SNI_ENTRY_delete(map->entries, &key);
+    CRYPTO_THREAD_unlock(map->lock);
+    sni_entry_free(e);
+    return e != NULL;
+}
+
+SSL_CTX *SSL_SNI_MAP_get1_ctx(SSL_SNI_MAP *map, const char *name)
+{
+    char buf[TLSEXT_MAXLEN_host_name + 1];
+    const char *dot;
+    SNI_ENTRY key, *e;
+    SSL_CTX *ctx = NULL;
+
+    if (name == NULL || !sni_normalise(name, buf, NULL))
+        return NULL;
+    key.name = buf;
+    key.wildcard = 0;
+
+    CRYPTO_THREAD_read_lock(map->lock);
+    e = lh_SNI_ENTRY_retrieve(map->entries, &key);
+    if (e == NULL && (dot = strchr(buf, '.')) != NULL) {
+        key.name = (char *)dot + 1;
+        key.wildcard = 1;
+        e = lh_SNI_ENTRY_retrieve(map->entries, &key);
+    }
+    if (e != NULL && SSL_CTX_up_ref(e->ctx))
+        ctx = e->ctx;
+    CRYPTO_THREAD_unlock(map->lock);
+    return ctx;
+}
+
+int SSL_CTX_set1_sni_map(SSL_CTX *ctx, SSL_SNI_MAP *map)
+{
+    if (map != NULL && !SSL_SNI_MAP_up_ref(map))
+        return 0;
+    SSL_SNI_MAP_free(ctx->ext.sni_map);
+    ctx->ext.sni_map = map;
+    return 1;
+}
+
+SSL_SNI_MAP *SSL_CTX_get0_sni_map(const SSL_CTX *ctx)
+{
+    return ctx->ext.sni_map;
+}
+
+/*
+ * Switches the server connection |s| to the SSL_CTX the SNI map of its
+ * session context has for the name sent by the client. Returns 1 if it
+ * did, 0 if there is no such SSL_CTX, or -1 on fatal error.
+ */
+int ssl_sni_map_switch(SSL *s)
+{
+    SSL_CTX *ctx;
+    SSL_SNI_MAP *map = s->session_ctx->ext.sni_map;
+
+    if (map == NULL)
+        return 0;
+    ctx = SSL_SNI_MAP_get1_ctx(map,
+                               SSL_get_servername(s, TLSEXT_NAMETYPE_host_name));
+    if (ctx == NULL)
+        return 0;
+    if (SSL_set_SSL_CTX(s, ctx) != ctx) {
+        SSL_CTX_free(ctx);
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_SNI_MAP_SWITCH,
+                 ERR_R_INTERNAL_ERROR);
+        return -1;
+    }
+    SSL_CTX_free(ctx);
+    return 1;
+}
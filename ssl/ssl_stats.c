@@ -0,0 +1,354 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <string.h>
+#include <time.h>
+#include "ssl_local.h"
+
+/*-
+ * Handshake phase timings. While a handshake is timed, the time spent in
+ * each phase is added up in the SSL, and once the handshake completes every
+ * phase it went through becomes one sample of the histograms of its
+ * SSL_CTX. Samples are added with atomic operations, so that handshakes
+ * running in parallel take no lock.
+ *
+ * The HANDSHAKE phase covers the whole handshake: its wall time runs from
+ * the first entry into the state machine until the handshake completes,
+ * waits for the peer included, and its CPU time is the time spent inside
+ * the state machine.
+ */
+#if defined(__GNUC__) && defined(__ATOMIC_RELAXED) \
+    && __GCC_ATOMIC_LLONG_LOCK_FREE == 2
+# define HS_ATOMICS
+#endif
+
+typedef struct {
+    uint64_t count;
+    uint64_t wall_us;
+    uint64_t cpu_us;
+    uint64_t max_wall_us;
+    uint64_t buckets[SSL_HS_STAT_BUCKETS];
+} HS_PHASE_STATS;
+
+struct ssl_hs_stats_st {
+    HS_PHASE_STATS phase[SSL_HS_PHASE_NUM];
+#ifndef HS_ATOMICS
+    CRYPTO_RWLOCK *lock;
+#endif
+};
+
+static uint64_t hs_wall_now(void)
+{
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+        return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+    return (uint64_t)time(NULL) * 1000000000;
+}
+
+/* CPU time of the calling thread, in nanoseconds */
+uint64_t ssl_cpu_now(void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+        return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+    /* The CPU time of the whole process will have to do */
+    return (uint64_t)clock() * (1000000000 / CLOCKS_PER_SEC);
+}
+
+int SSL_CTX_enable_handshake_stats(SSL_CTX *ctx)
+{
+    SSL_HS_STATS *stats;
+
+    if (ctx->hs_stats != NULL)
+        return 1;
+    if ((stats = OPENSSL_zalloc(sizeof(*stats))) == NULL) {
+        SSLerr(SSL_F_SSL_CTX_ENABLE_HANDSHAKE_STATS, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+#ifndef HS_ATOMICS
+    if ((stats->lock = CRYPTO_THREAD_lock_new()) == NULL) {
+        SSLerr(SSL_F_SSL_CTX_ENABLE_HANDSHAKE_STATS, ERR_R_MALLOC_FAILURE);
+        OPENSSL_free(stats);
+        return 0;
+    }
+#endif
+    ctx->hs_stats = stats;
+    return 1;
+}
+
+void ssl_hs_stats_free(SSL_HS_STATS *stats)
+{
+    if (stats == NULL)
+        return;
+#ifndef HS_ATOMICS
+    CRYPTO_THREAD_lock_free(stats->lock);
+#endif
+    OPENSSL_free(stats);
+}
+
+uint64_t SSL_CTX_get_handshake_stats(const SSL_CTX *ctx, int phase, int stat)
+{
+    const HS_PHASE_STATS *p;
+    const uint64_t *v;
+    uint64_t ret;
+
+    if (ctx->hs_stats == NULL || phase < 0 || phase >= SSL_HS_PHASE_NUM)
+        return 0;
+    p = &ctx->hs_stats->phase[phase];
+    switch (stat) {
+    case SSL_HS_STAT_COUNT:
+        v = &p->count;
+        break;
+    case SSL_HS_STAT_WALL_US:
+        v = &p->wall_us;
+        break;
+    case SSL_HS_STAT_CPU_US:
+        v = &p->cpu_us;
+        break;
+    case SSL_HS_STAT_MAX_WALL_US:
+        v = &p->max_wall_us;
+        break;
+    default:
+        if (stat < SSL_HS_STAT_BUCKET(0)
+                || stat >= SSL_HS_STAT_BUCKET(SSL_HS_STAT_BUCKETS))
+            return 0;
+        v = &p->buckets[stat - SSL_HS_STAT_BUCKET(0)];
+        break;
+    }
+#ifdef HS_ATOMICS
+    ret = __atomic_load_n(v, __ATOMIC_RELAXED);
+#else
+    if (!CRYPTO_THREAD_read_lock(ctx->hs_stats->lock))
+        return 0;
+    ret = *v;
+    CRYPTO_THREAD_unlock(ctx->hs_stats->lock);
+#endif
+    return ret;
+}
+
+static void hs_phase_add(HS_PHASE_STATS *p, uint64_t wall_us, uint64_t cpu_us)
+{
+    int bucket = 0;
+#ifdef HS_ATOMICS
+    uint64_t max;
+#endif
+
+    while (bucket < SSL_HS_STAT_BUCKETS - 1 && (wall_us >> bucket) != 0)
+        bucket++;
+#ifdef HS_ATOMICS
+    __atomic_fetch_add(&p->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&p->wall_us, wall_us, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&p->cpu_us, cpu_us, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&p->buckets[bucket], 1, __ATOMIC_RELAXED);
+    max = __atomic_load_n(&p->max_wall_us, __ATOMIC_RELAXED);
+    while (wall_us > max
+           && !__atomic_compare_exchange_n(&p->max_wall_us, &max, wall_us, 1,
+                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        continue;
+#else
+    p->count++;
+    p->wall_us += wall_us;
+    p->cpu_us += cpu_us;
+    p->buckets[bucket]++;
+    if (wall_us > p->max_wall_us)
+        p->max_wall_us = wall_us;
+#endif
+}
+
+/* Called when |s| starts a handshake, after ssl_hs_stats_enter() */
+void ssl_hs_stats_begin(SSL *s)
+{
+    SSL_HS_TIMES *t = &s->hs_times;
+
+    if (s->session_ctx->hs_stats == NULL) {
+        t->start = 0;
+        return;
+    }
+    memset(t->phase, 0, sizeof(t->phase));
+    t->start = hs_wall_now();
+}
+
+/* Called when the state machine of |s| is entered */
+void ssl_hs_stats_enter(SSL *s)
+{
+    if (s->session_ctx->hs_stats != NULL)
+        s->hs_times.cpu_entry = ssl_cpu_now();
+}
+
+/* Called when the state machine of |s| returns */
+void ssl_hs_stats_leave(SSL *s)
+{
+    SSL_HS_TIMES *t = &s->hs_times;
+    uint64_t now;
+
+    if (t->start == 0)
+        return;
+    now = ssl_cpu_now();
+    t->phase[SSL_HS_PHASE_HANDSHAKE].cpu += now - t->cpu_entry;
+    t->cpu_entry = now;
+}
+
+/* Called when |s| completes a handshake, to record its timings */
+void ssl_hs_stats_end(SSL *s)
+{
+    SSL_HS_TIMES *t = &s->hs_times;
+    SSL_HS_STATS *stats = s->session_ctx->hs_stats;
+    int i;
+
+    if (t->start == 0 || stats == NULL)
+        return;
+    ssl_hs_stats_leave(s);
+    t->phase[SSL_HS_PHASE_HANDSHAKE].wall = hs_wall_now() - t->start;
+    t->start = 0;
+
+#ifndef HS_ATOMICS
+    if (!CRYPTO_THREAD_write_lock(stats->lock))
+        return;
+#endif
+    for (i = 0; i < SSL_HS_PHASE_NUM; i++) {
+        /* Skip the phases this handshake didn't go through */
+        if (i != SSL_HS_PHASE_HANDSHAKE && t->phase[i].wall == 0)
+            continue;
+        hs_phase_add(&stats->phase[i], t->phase[i].wall / 1000,
+                     t->phase[i].cpu / 1000);
+    }
+#ifndef HS_ATOMICS
+    CRYPTO_THREAD_unlock(stats->lock);
+#endif
+}
+
+void ssl_hs_timer_start(SSL *s, SSL_HS_TIMER *t)
+{
+    if (s->hs_times.start == 0) {
+        t->wall = 0;
+        return;
+    }
+    t->wall = hs_wall_now();
+    t->cpu = ssl_cpu_now();
+}
+
+void ssl_hs_timer_stop(SSL *s, int phase, SSL_HS_TIMER *t)
+{
+    SSL_HS_TIMER *p = &s->hs_times.phase[phase];
+
+    if (s->hs_times.start == 0 || t->wall == 0)
+        return;
+    /* Plus 1 so that a phase shows as gone through even if it took no time */
+    p->wall += hs_wall_now() - t->wall + 1;
+    p->cpu += ssl_cpu_now() - t->cpu;
+}
+
+/*-
+ * Record layer counters. An SSL keeping them counts on its own, without
+ * atomics or locks, and adds its counts to its SSL_CTX when it is freed.
+ */
+struct ssl_rec_stats_st {
+    uint64_t total[SSL_REC_STAT_NUM];
+#ifndef HS_ATOMICS
+    CRYPTO_RWLOCK *lock;
+#endif
+};
+
+int SSL_CTX_enable_record_stats(SSL_CTX *ctx)
+{
+    SSL_REC_STATS *stats;
+
+    if (ctx->rec_stats != NULL)
+        return 1;
+    if ((stats = OPENSSL_zalloc(sizeof(*stats))) == NULL) {
+        SSLerr(SSL_F_SSL_CTX_ENABLE_RECORD_STATS, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+#ifndef HS_ATOMICS
+    if ((stats->lock = CRYPTO_THREAD_lock_new()) == NULL) {
+        SSLerr(SSL_F_SSL_CTX_ENABLE_RECORD_STATS, ERR_R_MALLOC_FAILURE);
+        OPENSSL_free(stats);
+        return 0;
+    }
+#endif
+    ctx->rec_stats = stats;
+    return 1;
+}
+
+void ssl_rec_stats_ctx_free(SSL_REC_STATS *stats)
+{
+    if (stats == NULL)
+        return;
+#ifndef HS_ATOMICS
+    CRYPTO_THREAD_lock_free(stats->lock);
+#endif
+    OPENSSL_free(stats);
+}
+
+int SSL_enable_record_stats(SSL *s)
+{
+    if (s->rec_stats != NULL)
+        return 1;
+    s->rec_stats = OPENSSL_zalloc(SSL_REC_STAT_NUM * sizeof(*s->rec_stats));
+    if (s->rec_stats == NULL) {
+        SSLerr(SSL_F_SSL_ENABLE_RECORD_STATS, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    return 1;
+}
+
+uint64_t SSL_get_record_stats(const SSL *s, int stat)
+{
+    if (s->rec_stats == NULL || stat < 0 || stat >= SSL_REC_STAT_NUM)
+        return 0;
+    return s->rec_stats[stat];
+}
+
+uint64_t SSL_CTX_get_record_stats(const SSL_CTX *ctx, int stat)
+{
+    uint64_t ret;
+
+    if (ctx->rec_stats == NULL || stat < 0 || stat >= SSL_REC_STAT_NUM)
+        return 0;
+#ifdef HS_ATOMICS
+    ret = __atomic_load_n(&ctx->rec_stats->total[stat], __ATOMIC_RELAXED);
+#else
+    if (!CRYPTO_THREAD_read_lock(ctx->rec_stats->lock))
+        return 0;
+    ret = ctx->rec_stats->total[stat];
+    CRYPTO_THREAD_unlock(ctx->rec_stats->lock);
+#endif
+    return ret;
+}
+
+/* Called when |s| is freed, to add its counts to its SSL_CTX */
+void ssl_rec_stats_release(SSL *s)
+{
+    SSL_REC_STATS *stats;
+    int i;
+
+    if (s->rec_stats == NULL)
+        return;
+    if ((stats = s->session_ctx->rec_stats) != NULL) {
+#ifdef HS_ATOMICS
+        for (i = 0; i < SSL_REC_STAT_NUM; i++)
+            __atomic_fetch_add(&stats->total[i], s->rec_stats[i],
+                               __ATOMIC_RELAXED);
+#else
+        if (CRYPTO_THREAD_write_lock(stats->lock)) {
+            for (i = 0; i < SSL_REC_STAT_NUM; i++)
+                stats->total[i] += s->rec_stats[i];
+            CRYPTO_THREAD_unlock(stats->lock);
+        }
+#endif
+    }
+    OPENSSL_free(s->rec_stats);
+    s->rec_stats = NULL;
+}
@@ -0,0 +1,469 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <string.h>
+#include <time.h>
+#include <openssl/rand.h>
+#include "ssl_local.h"
+#include "internal/cryptlib.h"
+#include "internal/refcount.h"
+
+/*-
+ * A ticket key ring holds |num_keys| session ticket keys in one flat
+ * block of memory, so that it can live in memory shared by several
+ * processes:
+ *
+ *   TKR_HEADER
+ *   num_keys x TKR_SLOT
+ *
+ * The key in slot |current| encrypts new tickets, the others only
+ * decrypt. Rotating writes a fresh key over the oldest one and makes it
+ * current. Rotations are serialised by |lock|, which holds the time it
+ * was taken so that a lock left behind by a process that died can be
+ * broken. Readers take no lock: every slot is a seqlock, whose |seq| is
+ * odd while the slot is being rewritten, and a reader copies the slot
+ * and starts again if |seq| was odd or changed meanwhile.
+ *
+ * Without the compiler atomics a ring is private to the process and its
+ * readers take a read lock.
+ */
+#if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE) \
+    && __GCC_ATOMIC_INT_LOCK_FREE == 2 && __GCC_ATOMIC_LLONG_LOCK_FREE == 2
+# define TKR_ATOMICS
+#endif
+
+#if defined(TKR_ATOMICS) && defined(OPENSSL_SYS_UNIX)
+# include <sys/mman.h>
+# if defined(MAP_ANON) && !defined(MAP_ANONYMOUS)
+#  define MAP_ANONYMOUS MAP_ANON
+# endif
+# ifdef MAP_ANONYMOUS
+#  define TKR_MMAP
+# endif
+#endif
+
+#define TKR_MAGIC               0x544b5231 /* "TKR1" */
+#define TKR_MAX_KEYS            64
+/* A rotation lock older than this many seconds is considered abandoned */
+#define TKR_LOCK_TIMEOUT        10
+
+typedef struct {
+    uint32_t magic;
+    uint32_t num_keys;
+    uint32_t current;
+    uint32_t lock;
+    int64_t rotate_secs;
+} TKR_HEADER;
+
+typedef struct {
+    uint32_t seq;
+    uint32_t valid;
+    int64_t created;
+    unsigned char name[TLSEXT_KEYNAME_LENGTH];
+    unsigned char hmac_key[TLSEXT_TICK_KEY_LENGTH];
+    unsigned char aes_key[TLSEXT_TICK_KEY_LENGTH];
+} TKR_SLOT;
+
+struct ssl_ticket_key_ring_st {
+    TKR_HEADER *hdr;
+    TKR_SLOT *slots;
+    void *mem;
+    size_t mem_len;
+    /* how |mem| was obtained */
+    enum { TKR_MEM_EXTERNAL, TKR_MEM_HEAP, TKR_MEM_MAPPED } mem_type;
+    CRYPTO_REF_COUNT references;
+    CRYPTO_RWLOCK *lock;
+};
+
+#ifdef TKR_ATOMICS
+# define tkr_load(p)            __atomic_load_n((p), __ATOMIC_ACQUIRE)
+# define tkr_store(p, v)        __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#else
+# define tkr_load(p)            (*(p))
+# define tkr_store(p, v)        (*(p) = (v))
+#endif
+
+size_t SSL_TICKET_KEY_RING_mem_size(unsigned int num_keys)
+{
+    if (num_keys < 1 || num_keys > TKR_MAX_KEYS)
+        return 0;
+    return sizeof(TKR_HEADER) + num_keys * sizeof(TKR_SLOT);
+}
+
+static SSL_TICKET_KEY_RING *tkr_new(void *mem, size_t len)
+{
+    SSL_TICKET_KEY_RING *ring = OPENSSL_zalloc(sizeof(*ring));
+
+    if (ring == NULL)
+        return NULL;
+    if ((ring->lock = CRYPTO_THREAD_lock_new()) == NULL) {
+        OPENSSL_free(ring);
+        return NULL;
+    }
+    ring->references = 1;
+    ring->mem = mem;
+    ring->mem_len = len;
+    ring->mem_type = TKR_MEM_EXTERNAL;
+    ring->hdr = mem;
+    ring->slots = (TKR_SLOT *)(ring->hdr + 1);
+    return ring;
+}
+
+/* Generate a new key into |slot|, which the caller has made odd */
+static int tkr_slot_fill(TKR_SLOT *slot, time_t now)
+{
+    TKR_SLOT tmp;
+
+    if (RAND_bytes(tmp.name, sizeof(tmp.name)) <= 0
+            || RAND_priv_bytes(tmp.hmac_key, sizeof(tmp.hmac_key)) <= 0
+            || RAND_priv_bytes(tmp.aes_key, sizeof(tmp.aes_key)) <= 0) {
+        OPENSSL_cleanse(&tmp, sizeof(tmp));
+        return 0;
+    }
+    memcpy(slot->name, tmp.name, sizeof(tmp.name));
+    memcpy(slot->hmac_key, tmp.hmac_key, sizeof(tmp.hmac_key));
+    memcpy(slot->aes_key, tmp.aes_key, sizeof(tmp.aes_key));
+    slot->created = (int64_t)now;
+    slot->valid = 1;
+    OPENSSL_cleanse(&tmp, sizeof(tmp));
+    return 1;
+}
+
+#ifdef TKR_ATOMICS
+static int tkr_lock(TKR_HEADER *hdr, time_t now, int wait)
+{
+    uint32_t expected, stamp = (uint32_t)now | 1;
+
+    for (;;) {
+        expected = __atomic_load_n(&hdr->lock, __ATOMIC_RELAXED);
+        if (expected != 0
+                && (uint32_t)now - expected > TKR_LOCK_TIMEOUT
+                && __atomic_compare_exchange_n(&hdr->lock, &expected, stamp,
+                                               0, __ATOMIC_ACQUIRE,
+                                               __ATOMIC_RELAXED))
+            return 1;
+        expected = 0;
+        if (__atomic_compare_exchange_n(&hdr->lock, &expected, stamp, 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            return 1;
+        if (!wait)
+            return 0;
+        now = time(NULL);
+    }
+}
+
+static void tkr_unlock(TKR_HEADER *hdr)
+{
+    __atomic_store_n(&hdr->lock, 0, __ATOMIC_RELEASE);
+}
+#endif
+
+/*
+ * Write a new key over the oldest one and make it current. Unless |force|
+ * is set this is only done if the current key is still due for rotation
+ * once the lock is held, and not at all if another rotation is under way.
+ */
+static int tkr_rotate(SSL_TICKET_KEY_RING *ring, int force)
+{
+    TKR_HEADER *hdr = ring->hdr;
+    TKR_SLOT *slot;
+    time_t now = time(NULL);
+    uint32_t cur, next;
+    int ret = 0;
+
+#ifdef TKR_ATOMICS
+    if (!tkr_lock(hdr, now, force))
+        return 1;
+#else
+    if (!CRYPTO_THREAD_write_lock(ring->lock))
+        return 0;
+#endif
+    cur = hdr->current;
+    if (!force && hdr->rotate_secs > 0
+            && (int64_t)now - ring->slots[cur].created < hdr->rotate_secs) {
+        ret = 1;
+        goto end;
+    }
+
+    next = (cur + 1) % hdr->num_keys;
+    slot = &ring->slots[next];
+    tkr_store(&slot->seq, slot->seq + 1);
+#ifdef TKR_ATOMICS
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#endif
+    ret = tkr_slot_fill(slot, now);
+    tkr_store(&slot->seq, slot->seq + 1);
+    if (ret)
+        tkr_store(&hdr->current, next);
+
+ end:
+#ifdef TKR_ATOMICS
+    tkr_unlock(hdr);
+#else
+    CRYPTO_THREAD_unlock(ring->lock);
+#endif
+    return ret;
+}
+
+static int tkr_init(SSL_TICKET_KEY_RING *ring, unsigned int num_keys,
+                    long rotate_secs)
+{
+    TKR_HEADER *hdr = ring->hdr;
+
+    memset(ring->mem, 0, SSL_TICKET_KEY_RING_mem_size(num_keys));
+    hdr->num_keys = num_keys;
+    hdr->rotate_secs = rotate_secs;
+    if (!tkr_slot_fill(&ring->slots[0], time(NULL)))
+        return 0;
+    /* Publish the ring only once it is complete */
+    tkr_store(&hdr->magic, TKR_MAGIC);
+    return 1;
+}
+
+SSL_TICKET_KEY_RING *SSL_TICKET_KEY_RING_new(unsigned int num_keys,
+                                             long rotate_secs)
+{
+    SSL_TICKET_KEY_RING *ring;
+    size_t len = SSL_TICKET_KEY_RING_mem_size(num_keys);
+    void *mem;
+    int mem_type = TKR_MEM_HEAP;
+
+    if (len == 0 || rotate_secs < 0) {
+        SSLerr(SSL_F_SSL_TICKET_KEY_RING_NEW, ERR_R_PASSED_INVALID_ARGUMENT);
+        return NULL;
+    }
+#ifdef TKR_MMAP
+    /* Shared with the children forked once the ring exists */
+    mem = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+               -1, 0);
+    if (mem == MAP_FAILED)
+        mem = NULL;
+    else
+        mem_type = TKR_MEM_MAPPED;
+#else
+    mem = NULL;
+#endif
+    if (mem == NULL && (mem = OPENSSL_zalloc(len)) == NULL) {
+        SSLerr(SSL_F_SSL_TICKET_KEY_RING_NEW, ERR_R_MALLOC_FAILURE);
+        return NULL;
+    }
+    if ((ring = tkr_new(mem, len)) == NULL) {
+        SSLerr(SSL_F_SSL_TICKET_KEY_RING_NEW, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+    ring->mem_type = mem_type;
+    if (!tkr_init(ring, num_keys, rotate_secs)) {
+        SSLerr(SSL_F_SSL_TICKET_KEY_RING_NEW, ERR_R_INTERNAL_ERROR);
+        SSL_TICKET_KEY_RING_free(ring);
+        return NULL;
+    }
+    return ring;
+
+ err:
+#ifdef TKR_MMAP
+    if (mem_type == TKR_MEM_MAPPED) {
+        munmap(mem, len);
+        return NULL;
+    }
+#endif
+    OPENSSL_free(mem);
+    return NULL;
+}
+
+SSL_TICKET_KEY_RING *SSL_TICKET_KEY_RING_new_mem(void *mem, size_t len,
+                                                 unsigned int num_keys,
+                                                 long rotate_secs)
+{
+    SSL_TICKET_KEY_RING *ring;
+    size_t need = SSL_TICKET_KEY_RING_mem_size(num_keys);
+
+#ifndef TKR_ATOMICS
+    SSLerr(SSL_F_SSL_TICKET_KEY_RING_NEW_MEM, ERR_R_DISABLED);
+    return NULL;
+#endif
+    if (mem == NULL || need == 0 || len < need || rotate_secs < 0) {
+        SSLerr(SSL_F_SSL_TICKET_KEY_RING_NEW_MEM,
+               ERR_R_PASSED_INVALID_ARGUMENT);
+        return NULL;
+    }
+    if ((ring = tkr_new(mem, len)) == NULL) {
+        SSLerr(SSL_F_SSL_TICKET_KEY_RING_NEW_MEM, ERR_R_MALLOC_FAILURE);
+        return NULL;
+    }
+    if (!tkr_init(ring, num_keys, rotate_secs)) {
+        SSLerr(SSL_F_SSL_TICKET_KEY_RING_NEW_MEM, ERR_R_INTERNAL_ERROR);
+        SSL_TICKET_KEY_RING_free(ring);
+        return NULL;
+    }
+    return ring;
+}
+
+SSL_TICKET_KEY_RING *SSL_TICKET_KEY_RING_attach(void *mem, size_t len)
+{
+    SSL_TICKET_KEY_RING *ring;
+    TKR_HEADER *hdr = mem;
+
+#ifndef TKR_ATOMICS
+    SSLerr(SSL_F_SSL_TICKET_KEY_RING_ATTACH, ERR_R_DISABLED);
+    return NULL;
+#endif
+    if (mem == NULL || len < sizeof(*hdr)) {
+        SSLerr(SSL_F_SSL_TICKET_KEY_RING_ATTACH,
+               ERR_R_PASSED_INVALID_ARGUMENT);
+        return NULL;
+    }
+    if (tkr_load(&hdr->magic) != TKR_MAGIC
+            || SSL_TICKET_KEY_RING_mem_size(hdr->num_keys) == 0
+            || len < SSL_TICKET_KEY_RING_mem_size(hdr->num_keys)
+            || hdr->current >= hdr->num_keys) {
+        SSLerr(SSL_F_SSL_TICKET_KEY_RING_ATTACH, SSL_R_BAD_TICKET_KEY_RING);
+        return NULL;
+    }
+    if ((ring = tkr_new(mem, len)) == NULL) {
+        SSLerr(SSL_F_SSL_TICKET_KEY_RING_ATTACH, ERR_R_MALLOC_FAILURE);
+        return NULL;
+    }
+    return ring;
+}
+
+int SSL_TICKET_KEY_RING_up_ref(SSL_TICKET_KEY_RING *ring)
+{
+    int i;
+
+    if (CRYPTO_UP_REF(&ring->references, &i, ring->lock) <= 0)
+        return 0;
+
+    REF_PRINT_COUNT("SSL_TICKET_KEY_RING", ring);
+    REF_ASSERT_ISNT(i < 2);
+    return ((i > 1) ? 1 : 0);
+}
+
+void SSL_TICKET_KEY_RING_free(SSL_TICKET_KEY_RING *ring)
+{
+    int i;
+
+    if (ring == NULL)
+        return;
+
+    CRYPTO_DOWN_REF(&ring->references, &i, ring->lock);
+    REF_PRINT_COUNT("SSL_TICKET_KEY_RING", ring);
+    if (i > 0)
+        return;
+    REF_ASSERT_ISNT(i < 0);
+
+    switch (ring->mem_type) {
+    case TKR_MEM_HEAP:
+        OPENSSL_clear_free(ring->mem, ring->mem_len);
+        break;
+#ifdef TKR_MMAP
+    case TKR_MEM_MAPPED:
+        OPENSSL_cleanse(ring->mem, ring->mem_len);
+        munmap(ring->mem, ring->mem_len);
+        break;
+#endif
+    default:
+        break;
+    }
+    CRYPTO_THREAD_lock_free(ring->lock);
+    OPENSSL_free(ring);
+}
+
+int SSL_TICKET_KEY_RING_rotate(SSL_TICKET_KEY_RING *ring)
+{
+    if (!tkr_rotate(ring, 1)) {
+        SSLerr(SSL_F_SSL_TICKET_KEY_RING_ROTATE, ERR_R_INTERNAL_ERROR);
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * Take a consistent copy of slot |i| into |out|. Returns 0 if the slot
+ * does not hold a key.
+ */
+static int tkr_slot_read(SSL_TICKET_KEY_RING *ring, uint32_t i, TKR_SLOT *out)
+{
+    TKR_SLOT *slot = &ring->slots[i];
+#ifdef TKR_ATOMICS
+    uint32_t seq;
+
+    do {
+        while ((seq = tkr_load(&slot->seq)) & 1)
+            continue;
+        memcpy(out, slot, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq);
+#else
+    if (!CRYPTO_THREAD_read_lock(ring->lock))
+        return 0;
+    memcpy(out, slot, sizeof(*out));
+    CRYPTO_THREAD_unlock(ring->lock);
+#endif
+    return out->valid;
+}
+
+int ssl_ticket_key_ring_get_enc(SSL_TICKET_KEY_RING *ring,
+                                SSL_TICKET_KEY *key)
+{
+    TKR_SLOT slot;
+    uint32_t cur = tkr_load(&ring->hdr->current);
+
+    if (ring->hdr->rotate_secs > 0
+            && (int64_t)time(NULL) - ring->slots[cur].created
+               >= ring->hdr->rotate_secs) {
+        /* Another rotation in progress is fine, the old key still works */
+        if (!tkr_rotate(ring, 0))
+            return 0;
+        cur = tkr_load(&ring->hdr->current);
+    }
+    if (!tkr_slot_read(ring, cur, &slot))
+        return 0;
+    memcpy(key->name, slot.name, sizeof(key->name));
+    memcpy(key->hmac_key, slot.hmac_key, sizeof(key->hmac_key));
+    memcpy(key->aes_key, slot.aes_key, sizeof(key->aes_key));
+    OPENSSL_cleanse(&slot, sizeof(slot));
+    return 1;
+}
+
+int ssl_ticket_key_ring_find(SSL_TICKET_KEY_RING *ring,
+                             const unsigned char *name, SSL_TICKET_KEY *key)
+{
+    TKR_SLOT slot;
+    uint32_t i, cur = tkr_load(&ring->hdr->current);
+    int ret = 0;
+
+    /* Newest first: most tickets are under the current key */
+    for (i = 0; i < ring->hdr->num_keys && ret == 0; i++) {
+        uint32_t idx = (cur + ring->hdr->num_keys - i) % ring->hdr->num_keys;
+
+        if (!tkr_slot_read(ring, idx, &slot)
+                || memcmp(slot.name, name, sizeof(slot.name)) != 0)
+            continue;
+        memcpy(key->name, slot.name, sizeof(key->name));
+        memcpy(key->hmac_key, slot.hmac_key, sizeof(key->hmac_key));
+        memcpy(key->aes_key, slot.aes_key, sizeof(key->aes_key));
+        ret = i == 0 ? 1 : 2;
+    }
+    OPENSSL_cleanse(&slot, sizeof(slot));
+    return ret;
+}
+
+int SSL_CTX_set1_ticket_key_ring(SSL_CTX *ctx, SSL_TICKET_KEY_RING *ring)
+{
+    if (ring != NULL && !SSL_TICKET_KEY_RING_up_ref(ring))
+        return 0;
+    SSL_TICKET_KEY_RING_free(ctx->ext.tick_key_ring);
+    ctx->ext.tick_key_ring = ring;
+    return 1;
+}
+
+SSL_TICKET_KEY_RING *SSL_CTX_get0_ticket_key_ring(const SSL_CTX *ctx)
+{
+    return ctx->ext.tick_key_ring;
+}
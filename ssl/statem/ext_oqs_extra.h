@@ -1,78 +1,58 @@
 /* Extras for OQS extension */
 
-/* Encodes two messages (classical and PQC) into one hybrid message:
+/* Writes the head of a hybrid message (classical and PQC) into |pkt|:
    classical_msg || pq_msg
-   hybrid_msg is allocated in this function.
+   The classical message is copied and pq_msg_len bytes are reserved for the
+   PQC message, which the caller generates in place through |pq_msg|. Nothing
+   is written if either length is zero.
    Follows format specified in https://tools.ietf.org/html/draft-ietf-tls-hybrid-design-01#section-3.2
  */
-static int OQS_encode_hybrid_message(const unsigned char* classical_msg,
-                                     const uint16_t classical_msg_len,
-                                     const unsigned char* pq_msg,
-                                     const uint16_t pq_msg_len,
-                                     unsigned char** hybrid_msg,
-                                     uint16_t* hybrid_msg_len) {
-  *hybrid_msg_len = classical_msg_len + pq_msg_len;
-  *hybrid_msg = OPENSSL_malloc(*hybrid_msg_len);
-  if (*hybrid_msg == NULL) {
+static int OQS_encode_hybrid_message(WPACKET *pkt,
+                                     const unsigned char* classical_msg,
+                                     size_t classical_msg_len,
+                                     size_t pq_msg_len,
+                                     unsigned char** pq_msg) {
+  if (!WPACKET_memcpy(pkt, classical_msg, classical_msg_len)) {
+    return 0;
+  }
+  if (pq_msg_len > 0 && !WPACKET_allocate_bytes(pkt, pq_msg_len, pq_msg)) {
     return 0;
   }
-
-  memcpy(*hybrid_msg, classical_msg, classical_msg_len);
-  memcpy(*hybrid_msg + classical_msg_len, pq_msg, pq_msg_len);
 
   return 1;
 }
 
 /* Decodes hybrid message returning the classical and PQC messages:
    classical_msg || pq_msg
-   classical_msg and pq_msg are allocated in this function.
+   classical_msg and pq_msg are views into hybrid_msg, nothing is copied.
+   The classical length comes from the group table, the PQC length from the
+   KEM; the hybrid message must consist of exactly these two parts.
    Follows format specified in https://tools.ietf.org/html/draft-ietf-tls-hybrid-design-01#section-3.2
  */
-static int OQS_decode_hybrid_message(const unsigned char* hybrid_msg,
+static int OQS_decode_hybrid_message(PACKET* hybrid_msg,
                                      const unsigned int group_id,
                                      const int is_server,
-                                     unsigned char** classical_msg,
-                                     uint16_t* classical_msg_len,
-                                     unsigned char** pq_msg,
-                                     uint16_t* pq_msg_len) {
-
-  int ec_curve_id = OQS_KEM_CLASSICAL_CURVEID(group_id);
-  unsigned int pq_kem_id = OQS_KEM_NID(group_id);
-
-  switch (ec_curve_id) {
-      case 23: /* P-256 */
-          *classical_msg_len = 65;
-          break;
-      case 24: /* P-384 */
-          *classical_msg_len = 97;
-          break;
-      case 25: /* P-521 */
-          *classical_msg_len = 133;
-          break;
-      default:
-          return 0;
-  }
-  *classical_msg = OPENSSL_malloc(*classical_msg_len);
-  if (*classical_msg == NULL) {
+                                     PACKET* classical_msg,
+                                     PACKET* pq_msg) {
+  const TLS_GROUP_INFO *ginf =
+      tls1_group_id_lookup(OQS_KEM_CLASSICAL_CURVEID(group_id));
+  const OQS_KEM* oqs_kem = get_oqs_kem(OQS_KEM_NID(group_id));
+  size_t pq_msg_len;
+
+  if (ginf == NULL || ginf->encodedlen == 0 || oqs_kem == NULL) {
     return 0;
   }
-  memcpy(*classical_msg, hybrid_msg, *classical_msg_len);
-
-  OQS_KEM* oqs_kem = OQS_KEM_new(OQS_ALG_NAME(pq_kem_id));
-  if (oqs_kem == NULL) {
-      return 0;
-  }
   if (is_server) {
-      *pq_msg_len = oqs_kem->length_public_key;
+    pq_msg_len = oqs_kem->length_public_key;
   } else {
-      *pq_msg_len = oqs_kem->length_ciphertext;
+    pq_msg_len = oqs_kem->length_ciphertext;
   }
 
-  *pq_msg = OPENSSL_malloc(*pq_msg_len);
-  if (*pq_msg == NULL) {
+  if (!PACKET_get_sub_packet(hybrid_msg, classical_msg, ginf->encodedlen)
+      || !PACKET_get_sub_packet(hybrid_msg, pq_msg, pq_msg_len)
+      || PACKET_remaining(hybrid_msg) != 0) {
     return 0;
   }
-  memcpy(*pq_msg, hybrid_msg + *classical_msg_len, *pq_msg_len);
 
   return 1;
 }
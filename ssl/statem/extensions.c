@@ -13,6 +13,7 @@
 #include "../ssl_local.h"
 #include "statem_local.h"
 #include "internal/cryptlib.h"
+#include "internal/thread_once.h"
 
 static int final_renegotiate(SSL *s, unsigned int context, int sent);
 static int init_server_name(SSL *s, unsigned int context);
@@ -57,6 +58,11 @@ static int final_sig_algs(SSL *s, unsigned int context, int sent);
 static int final_early_data(SSL *s, unsigned int context, int sent);
 static int final_maxfragmentlen(SSL *s, unsigned int context, int sent);
 static int init_post_handshake_auth(SSL *s, unsigned int context);
+#ifndef OPENSSL_NO_COMP
+static int init_compress_certificate(SSL *s, unsigned int context);
+#endif
+static int init_cached_info(SSL *s, unsigned int context);
+static int init_connection_id(SSL *s, unsigned int context);
 static int final_psk(SSL *s, unsigned int context, int sent);
 
 /* Structure to define a built-in extension */
@@ -377,6 +383,37 @@ static const EXTENSION_DEFINITION ext_defs[] = {
         tls_construct_certificate_authorities,
         tls_construct_certificate_authorities, NULL,
     },
+#ifndef OPENSSL_NO_COMP
+    {
+        /*
+         * We do not ask for compressed client certificates, so one requested
+         * in a CertificateRequest is ignored.
+         */
+        TLSEXT_TYPE_compress_certificate,
+        SSL_EXT_CLIENT_HELLO | SSL_EXT_TLS1_3_CERTIFICATE_REQUEST
+        | SSL_EXT_TLS1_3_ONLY,
+        init_compress_certificate, tls_parse_ctos_compress_certificate, NULL,
+        NULL, tls_construct_ctos_compress_certificate, NULL
+    },
+#else
+    INVALID_EXTENSION,
+#endif
+    {
+        TLSEXT_TYPE_cached_info,
+        SSL_EXT_CLIENT_HELLO | SSL_EXT_TLS1_3_ENCRYPTED_EXTENSIONS
+        | SSL_EXT_TLS1_3_ONLY,
+        init_cached_info, tls_parse_ctos_cached_info,
+        tls_parse_stoc_cached_info, tls_construct_stoc_cached_info,
+        tls_construct_ctos_cached_info, NULL
+    },
+    {
+        TLSEXT_TYPE_connection_id,
+        SSL_EXT_CLIENT_HELLO | SSL_EXT_TLS1_2_SERVER_HELLO
+        | SSL_EXT_DTLS_ONLY | SSL_EXT_TLS1_2_AND_BELOW_ONLY,
+        init_connection_id, tls_parse_ctos_connection_id,
+        tls_parse_stoc_connection_id, tls_construct_stoc_connection_id,
+        tls_construct_ctos_connection_id, NULL
+    },
     {
         /* Must be immediately before pre_shared_key */
         TLSEXT_TYPE_padding,
@@ -395,6 +432,67 @@ static const EXTENSION_DEFINITION ext_defs[] = {
     }
 };
 
+/*
+ * The index in ext_defs of the built-in extension of each type, so that a
+ * received extension is found without going through the whole table. Open
+ * addressing on a hash of the type, built on first use.
+ */
+#define EXT_INDEX_SLOTS     128
+#define EXT_INDEX_SLOT(t)   (((t) ^ ((t) >> 7)) & (EXT_INDEX_SLOTS - 1))
+#define EXT_INDEX_EMPTY     0xff
+
+static unsigned int ext_index_types[EXT_INDEX_SLOTS];
+static unsigned char ext_index[EXT_INDEX_SLOTS];
+static CRYPTO_ONCE ext_index_once = CRYPTO_ONCE_STATIC_INIT;
+
+DEFINE_RUN_ONCE_STATIC(ext_index_init)
+{
+    size_t i, slot;
+
+    if (OSSL_NELEM(ext_defs) >= EXT_INDEX_EMPTY
+            || OSSL_NELEM(ext_defs) > EXT_INDEX_SLOTS / 2)
+        return 0;
+
+    memset(ext_index, EXT_INDEX_EMPTY, sizeof(ext_index));
+    for (i = 0; i < OSSL_NELEM(ext_defs); i++) {
+        unsigned int type = ext_defs[i].type;
+
+        /* Skip the placeholders of disabled extensions */
+        if (type > 0xffff)
+            continue;
+        for (slot = EXT_INDEX_SLOT(type);
+             ext_index[slot] != EXT_INDEX_EMPTY && ext_index_types[slot] != type;
+             slot = (slot + 1) & (EXT_INDEX_SLOTS - 1))
+            continue;
+        if (ext_index[slot] == EXT_INDEX_EMPTY) {
+            ext_index_types[slot] = type;
+            ext_index[slot] = (unsigned char)i;
+        }
+    }
+    return 1;
+}
+
+/* The index in ext_defs of extension |type|, or OSSL_NELEM(ext_defs) */
+static size_t ext_def_index(unsigned int type)
+{
+    size_t i, slot;
+
+    if (!RUN_ONCE(&ext_index_once, ext_index_init)) {
+        for (i = 0; i < OSSL_NELEM(ext_defs); i++) {
+            if (ext_defs[i].type == type)
+                return i;
+        }
+        return i;
+    }
+
+    for (slot = EXT_INDEX_SLOT(type); ext_index[slot] != EXT_INDEX_EMPTY;
+         slot = (slot + 1) & (EXT_INDEX_SLOTS - 1)) {
+        if (ext_index_types[slot] == type)
+            return ext_index[slot];
+    }
+    return OSSL_NELEM(ext_defs);
+}
+
 /* Check whether an extension's context matches the current context */
 static int validate_context(SSL *s, unsigned int extctx, unsigned int thisctx)
 {
@@ -460,18 +558,15 @@ static int verify_extension(SSL *s, unsigned int context, unsigned int type,
                             custom_ext_methods *meths, RAW_EXTENSION *rawexlist,
                             RAW_EXTENSION **found)
 {
-    size_t i;
     size_t builtin_num = OSSL_NELEM(ext_defs);
-    const EXTENSION_DEFINITION *thisext;
+    size_t i = ext_def_index(type);
 
-    for (i = 0, thisext = ext_defs; i < builtin_num; i++, thisext++) {
-        if (type == thisext->type) {
-            if (!validate_context(s, thisext->context, context))
-                return 0;
+    if (i < builtin_num) {
+        if (!validate_context(s, ext_defs[i].context, context))
+            return 0;
 
-            *found = &rawexlist[i];
-            return 1;
-        }
+        *found = &rawexlist[i];
+        return 1;
     }
 
     /* Check the custom extensions */
@@ -538,6 +633,38 @@ int extension_is_relevant(SSL *s, unsigned int extctx, unsigned int thisctx)
     return 1;
 }
 
+/*
+ * A zeroed array for the |num| extensions of a message: the one kept in |s|,
+ * unless it is in use, rather than a new one for every message.
+ */
+static RAW_EXTENSION *raw_extensions_get(SSL *s, size_t num)
+{
+    RAW_EXTENSION *exts;
+
+    if (s->ext.raw_exts_inuse)
+        return OPENSSL_zalloc(num * sizeof(*exts));
+
+    if (s->ext.raw_exts_len < num) {
+        exts = OPENSSL_realloc(s->ext.raw_exts, num * sizeof(*exts));
+        if (exts == NULL)
+            return NULL;
+        s->ext.raw_exts = exts;
+        s->ext.raw_exts_len = num;
+    }
+    memset(s->ext.raw_exts, 0, num * sizeof(*exts));
+    s->ext.raw_exts_inuse = 1;
+    return s->ext.raw_exts;
+}
+
+/* Frees extensions collected by tls_collect_extensions() */
+void tls_free_raw_extensions(SSL *s, RAW_EXTENSION *exts)
+{
+    if (exts != NULL && exts == s->ext.raw_exts)
+        s->ext.raw_exts_inuse = 0;
+    else
+        OPENSSL_free(exts);
+}
+
 /*
  * Gather a list of all the extensions from the data in |packet]. |context|
  * tells us which message this extension is for. The raw extension data is
@@ -545,7 +672,7 @@ int extension_is_relevant(SSL *s, unsigned int extctx, unsigned int thisctx)
  * extensions yet, except to check their types. This function also runs the
  * initialiser functions for all known extensions if |init| is nonzero (whether
  * we have collected them or not). If successful the caller is responsible for
- * freeing the contents of |*res|.
+ * freeing |*res| with tls_free_raw_extensions().
  *
  * Per http://tools.ietf.org/html/rfc5246#section-7.4.1.4, there may not be
  * more than one extension of the same type in a ClientHello or ServerHello.
@@ -574,8 +701,7 @@ int tls_collect_extensions(SSL *s, PACKET *packet, unsigned int context,
         custom_ext_init(&s->cert->custext);
 
     num_exts = OSSL_NELEM(ext_defs) + (exts != NULL ? exts->meths_count : 0);
-    raw_extensions = OPENSSL_zalloc(num_exts * sizeof(*raw_extensions));
-    if (raw_extensions == NULL) {
+    if ((raw_extensions = raw_extensions_get(s, num_exts)) == NULL) {
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS_COLLECT_EXTENSIONS,
                  ERR_R_MALLOC_FAILURE);
         return 0;
@@ -674,7 +800,7 @@ int tls_collect_extensions(SSL *s, PACKET *packet, unsigned int context,
     return 1;
 
  err:
-    OPENSSL_free(raw_extensions);
+    tls_free_raw_extensions(s, raw_extensions);
     return 0;
 }
 
@@ -929,6 +1055,7 @@ static int final_server_name(SSL *s, unsigned int context, int sent)
 {
     int ret = SSL_TLSEXT_ERR_NOACK;
     int altmp = SSL_AD_UNRECOGNIZED_NAME;
+    int mapped = 0;
     int was_ticket = (SSL_get_options(s) & SSL_OP_NO_TICKET) == 0;
 
     if (!ossl_assert(s->ctx != NULL) || !ossl_assert(s->session_ctx != NULL)) {
@@ -937,7 +1064,14 @@ static int final_server_name(SSL *s, unsigned int context, int sent)
         return 0;
     }
 
-    if (s->ctx->ext.servername_cb != NULL)
+    if (s->server && sent && (mapped = ssl_sni_map_switch(s)) < 0) {
+        /* SSLfatal() already called */
+        return 0;
+    }
+
+    if (mapped)
+        ret = SSL_TLSEXT_ERR_OK;
+    else if (s->ctx->ext.servername_cb != NULL)
         ret = s->ctx->ext.servername_cb(s, &altmp,
                                         s->ctx->ext.servername_arg);
     else if (s->session_ctx->ext.servername_cb != NULL)
@@ -1360,8 +1494,8 @@ static int final_key_share(SSL *s, unsigned int context, int sent)
      *             send a HelloRetryRequest
      */
     if (s->server) {
-        if (s->s3->peer_tmp != NULL) {
-            /* We have a suitable key_share */
+        if (s->s3->peer_tmp != NULL || s->s3->tmp.key_share_deferred) {
+            /* We have a suitable key_share, possibly not decoded yet */
             if ((s->s3->flags & TLS1_FLAGS_STATELESS) != 0
                     && !s->ext.cookieok) {
                 if (!ossl_assert(s->hello_retry_request == SSL_HRR_NONE)) {
@@ -1730,6 +1864,32 @@ static int init_post_handshake_auth(SSL *s, unsigned int context)
     return 1;
 }
 
+#ifndef OPENSSL_NO_COMP
+static int init_compress_certificate(SSL *s, unsigned int context)
+{
+    if ((context & SSL_EXT_CLIENT_HELLO) != 0)
+        s->ext.cert_comp = TLSEXT_comp_cert_none;
+
+    return 1;
+}
+#endif
+
+static int init_cached_info(SSL *s, unsigned int context)
+{
+    if (s->server)
+        s->ext.cached_info = SSL_CACHED_INFO_NONE;
+
+    return 1;
+}
+
+static int init_connection_id(SSL *s, unsigned int context)
+{
+    if (s->server)
+        s->dtls_cid.peer_offered = 0;
+
+    return 1;
+}
+
 /*
  * If clients offer "pre_shared_key" without a "psk_key_exchange_modes"
  * extension, servers MUST abort the handshake.
@@ -608,12 +608,12 @@ EXT_RETURN tls_construct_ctos_psk_kex_modes(SSL *s, WPACKET *pkt,
 #ifndef OPENSSL_NO_TLS1_3
 static int add_key_share(SSL *s, WPACKET *pkt, unsigned int curve_id)
 {
-    unsigned char *encoded_point = NULL, *classical_encoded_point = NULL, *oqs_encoded_point = NULL;
+    unsigned char *encoded_point = NULL, *oqs_encoded_point = NULL;
     EVP_PKEY *key_share_key = NULL;
-    size_t encodedlen = 0;
-    uint16_t classical_encodedlen = 0, oqs_encodedlen = 0;
+    size_t encodedlen = 0, oqs_encodedlen = 0;
     int do_pqc = IS_OQS_KEM_CURVEID(curve_id); /* 1 if post-quantum alg, 0 otherwise */
     int do_hybrid = IS_OQS_KEM_HYBRID_CURVEID(curve_id); /* 1 if post-quantum hybrid alg, 0 otherwise */
+    const OQS_KEM *oqs_kem = NULL;
     if (s->s3->tmp.pkey != NULL) {
         if (!ossl_assert(s->hello_retry_request == SSL_HRR_PENDING)) {
             SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_ADD_KEY_SHARE, ERR_R_INTERNAL_ERROR);
@@ -626,36 +626,16 @@ static int add_key_share(SSL *s, WPACKET *pkt, unsigned int curve_id)
     } else {
       if (do_pqc || do_hybrid) {
         /* This is a group handled by OQS */
-        int has_error = 0;
         int oqs_nid = OQS_KEM_NID(curve_id);
-        const char* oqs_alg_name = OQS_ALG_NAME(oqs_nid);
         /* initialize the kex */
-        if ((s->s3->tmp.oqs_kem = OQS_KEM_new(oqs_alg_name)) == NULL) {
+        if ((oqs_kem = get_oqs_kem(oqs_nid)) == NULL) {
           /* TODO: provide a better error message for non-enabled OQS schemes.
              Perhaps even check if the alg is available earlier in the stack. (FIXMEOQS) */
           SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_ADD_KEY_SHARE, ERR_R_INTERNAL_ERROR);
-          has_error = 1;
-          goto oqs_cleanup;
-        }
-        /* compute the client's key and first message (encoded in encoded_point) */
-        if ((oqs_encoded_point = malloc(s->s3->tmp.oqs_kem->length_public_key)) == NULL ||
-            (s->s3->tmp.oqs_kem_client = malloc(s->s3->tmp.oqs_kem->length_secret_key)) == NULL ||
-            OQS_KEM_keypair(s->s3->tmp.oqs_kem, oqs_encoded_point, s->s3->tmp.oqs_kem_client) != OQS_SUCCESS) {
-          SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_ADD_KEY_SHARE, ERR_R_INTERNAL_ERROR);
-          has_error = 1;
-          goto oqs_cleanup;
-        }
-        oqs_encodedlen = s->s3->tmp.oqs_kem->length_public_key;
-
-      oqs_cleanup:
-        if (has_error) {
-          if (s->s3->tmp.oqs_kem_client) OQS_MEM_secure_free(s->s3->tmp.oqs_kem_client, s->s3->tmp.oqs_kem->length_secret_key);
-          OQS_MEM_insecure_free(oqs_encoded_point);
-          s->s3->tmp.oqs_kem_client = NULL;
-          if (s->s3->tmp.oqs_kem) OQS_KEM_free(s->s3->tmp.oqs_kem);
-          s->s3->tmp.oqs_kem = NULL;
           return 0;
         }
+        s->s3->tmp.oqs_kem = oqs_kem;
+        oqs_encodedlen = oqs_kem->length_public_key;
       }
       if (!do_pqc) {
         /* get the curve_id for the classical alg */
@@ -663,39 +643,42 @@ static int add_key_share(SSL *s, WPACKET *pkt, unsigned int curve_id)
         key_share_key = ssl_generate_pkey_group(s, classical_curve_id);
         if (key_share_key == NULL) {
             /* SSLfatal() already called */
-            return 0;
+            goto err;
         }
       }
     }
 
     if (!do_pqc) {
       /* Encode the public key. */
-      classical_encodedlen = EVP_PKEY_get1_tls_encodedpoint(key_share_key, &classical_encoded_point);
-      if (classical_encodedlen == 0) {
+      encodedlen = EVP_PKEY_get1_tls_encodedpoint(key_share_key, &encoded_point);
+      if (encodedlen == 0) {
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_ADD_KEY_SHARE, ERR_R_EC_LIB);
         goto err;
       }
     }
 
-    if (do_hybrid) {
-      uint16_t encodedlen16;
-      if (!OQS_encode_hybrid_message(classical_encoded_point, classical_encodedlen, oqs_encoded_point, oqs_encodedlen, &encoded_point, &encodedlen16)) {
+    /* Create KeyShareEntry */
+    if (!WPACKET_put_bytes_u16(pkt, curve_id)
+            || !WPACKET_start_sub_packet_u16(pkt)
+            || !OQS_encode_hybrid_message(pkt, encoded_point, encodedlen,
+                                          oqs_encodedlen, &oqs_encoded_point)) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_ADD_KEY_SHARE,
+                 ERR_R_INTERNAL_ERROR);
         goto err;
-      }
-      encodedlen = encodedlen16;
-      OPENSSL_free(classical_encoded_point);
-      OPENSSL_free(oqs_encoded_point);
-    } else if (do_pqc) {
-      encoded_point = oqs_encoded_point;
-      encodedlen = oqs_encodedlen;
-    } else {
-      encoded_point = classical_encoded_point;
-      encodedlen = classical_encodedlen;
     }
+    /* the client's key; the public part goes straight into pkt */
+    if (oqs_kem != NULL) {
+        unsigned char *oqs_secret_key = NULL;
 
-    /* Create KeyShareEntry */
-    if (!WPACKET_put_bytes_u16(pkt, curve_id)
-            || !WPACKET_sub_memcpy_u16(pkt, encoded_point, encodedlen)) {
+        if (!ssl_oqs_kem_keypair(s, oqs_kem, oqs_encoded_point,
+                                 &oqs_secret_key)) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_ADD_KEY_SHARE,
+                     ERR_R_INTERNAL_ERROR);
+            goto err;
+        }
+        s->s3->tmp.oqs_kem_client = oqs_secret_key;
+    }
+    if (!WPACKET_close(pkt)) {
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_ADD_KEY_SHARE,
                  ERR_R_INTERNAL_ERROR);
         goto err;
@@ -715,18 +698,53 @@ static int add_key_share(SSL *s, WPACKET *pkt, unsigned int curve_id)
     if (s->s3->tmp.pkey == NULL)
         EVP_PKEY_free(key_share_key);
     OPENSSL_free(encoded_point);
+    if (oqs_kem != NULL) {
+        OQS_MEM_secure_free(s->s3->tmp.oqs_kem_client, oqs_kem->length_secret_key);
+        s->s3->tmp.oqs_kem_client = NULL;
+        s->s3->tmp.oqs_kem = NULL;
+    }
     return 0;
 }
 #endif
 
+#ifndef OPENSSL_NO_TLS1_3
+/* The group of the key share a ClientHello is to carry, or 0 if none */
+uint16_t tls_ctos_key_share_group(SSL *s)
+{
+    size_t i, num_groups = 0;
+    const uint16_t *pgroups = NULL;
+    uint16_t curve_id = 0, hint;
+
+    /*
+     * TODO(TLS1.3): Make the number of key_shares sent configurable. For
+     * now, just send one
+     */
+    if (s->s3->group_id != 0)
+        return s->s3->group_id;
+
+    tls1_get_supported_groups(s, &pgroups, &num_groups);
+    hint = tls13_get_key_share_hint(s);
+    for (i = 0; i < num_groups; i++) {
+
+        if (!tls_curve_allowed(s, pgroups[i], SSL_SECOP_CURVE_SUPPORTED))
+            continue;
+
+        /* Prefer the group this server asked for last time */
+        if (curve_id == 0 || pgroups[i] == hint)
+            curve_id = pgroups[i];
+        if (hint == 0 || curve_id == hint)
+            break;
+    }
+    return curve_id;
+}
+#endif
+
 EXT_RETURN tls_construct_ctos_key_share(SSL *s, WPACKET *pkt,
                                         unsigned int context, X509 *x,
                                         size_t chainidx)
 {
 #ifndef OPENSSL_NO_TLS1_3
-    size_t i, num_groups = 0;
-    const uint16_t *pgroups = NULL;
-    uint16_t curve_id = 0;
+    uint16_t curve_id;
 
     /* key_share extension */
     if (!WPACKET_put_bytes_u16(pkt, TLSEXT_TYPE_key_share)
@@ -739,25 +757,7 @@ EXT_RETURN tls_construct_ctos_key_share(SSL *s, WPACKET *pkt,
         return EXT_RETURN_FAIL;
     }
 
-    tls1_get_supported_groups(s, &pgroups, &num_groups);
-
-    /*
-     * TODO(TLS1.3): Make the number of key_shares sent configurable. For
-     * now, just send one
-     */
-    if (s->s3->group_id != 0) {
-        curve_id = s->s3->group_id;
-    } else {
-        for (i = 0; i < num_groups; i++) {
-
-            if (!tls_curve_allowed(s, pgroups[i], SSL_SECOP_CURVE_SUPPORTED))
-                continue;
-
-            curve_id = pgroups[i];
-            break;
-        }
-    }
-
+    curve_id = tls_ctos_key_share_group(s);
     if (curve_id == 0) {
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS_CONSTRUCT_CTOS_KEY_SHARE,
                  SSL_R_NO_SUITABLE_KEY_SHARE);
@@ -1876,9 +1876,7 @@ int tls_parse_stoc_key_share(SSL *s, PACKET *pkt, unsigned int context, X509 *x,
 {
 #ifndef OPENSSL_NO_TLS1_3
     unsigned int group_id;
-    PACKET encoded_pt;
-    unsigned char *classical_encoded_pt = NULL, *oqs_encoded_pt = NULL;
-    uint16_t classical_encodedlen, oqs_encodedlen;
+    PACKET encoded_pt, classical_encoded_pt, oqs_encoded_pt;
     unsigned char *shared_secret = NULL, *oqs_shared_secret = NULL;
     size_t shared_secret_len = 0, oqs_shared_secret_len = 0;
     EVP_PKEY *ckey = s->s3->tmp.pkey, *skey = NULL;
@@ -1936,6 +1934,7 @@ int tls_parse_stoc_key_share(SSL *s, PACKET *pkt, unsigned int context, X509 *x,
         }
 
         s->s3->group_id = group_id;
+        tls13_set_key_share_hint(s, group_id);
         EVP_PKEY_free(s->s3->tmp.pkey);
         s->s3->tmp.pkey = NULL;
         return 1;
@@ -1959,21 +1958,21 @@ int tls_parse_stoc_key_share(SSL *s, PACKET *pkt, unsigned int context, X509 *x,
     }
 
     /* parse the encoded_pt, which is either a classical, PQC, or hybrid (both) message. */
+    PACKET_null_init(&classical_encoded_pt);
+    PACKET_null_init(&oqs_encoded_pt);
     if (do_hybrid) {
-      if (!OQS_decode_hybrid_message(PACKET_data(&encoded_pt), group_id, false,
+      if (!OQS_decode_hybrid_message(&encoded_pt, group_id, 0,
                                      &classical_encoded_pt,
-                                     &classical_encodedlen,
-                                     &oqs_encoded_pt,
-                                     &oqs_encodedlen)) {
+                                     &oqs_encoded_pt)) {
+        SSLfatal(s, SSL_AD_DECODE_ERROR, SSL_F_TLS_PARSE_STOC_KEY_SHARE,
+                 SSL_R_LENGTH_MISMATCH);
         has_error = 1;
         goto oqs_cleanup;
       }
     } else if (do_pqc) {
-      oqs_encoded_pt = (unsigned char*) PACKET_data(&encoded_pt);
-      oqs_encodedlen = PACKET_remaining(&encoded_pt);
+      oqs_encoded_pt = encoded_pt;
     } else {
-      classical_encoded_pt = (unsigned char*) PACKET_data(&encoded_pt);
-      classical_encodedlen = PACKET_remaining(&encoded_pt);
+      classical_encoded_pt = encoded_pt;
     }
 
     if (!do_pqc || do_hybrid) {
@@ -1985,7 +1984,9 @@ int tls_parse_stoc_key_share(SSL *s, PACKET *pkt, unsigned int context, X509 *x,
         EVP_PKEY_free(skey);
         goto oqs_cleanup;
       }
-      if (!EVP_PKEY_set1_tls_encodedpoint(skey, classical_encoded_pt, classical_encodedlen)) {
+      if (!EVP_PKEY_set1_tls_encodedpoint(skey,
+              PACKET_data(&classical_encoded_pt),
+              PACKET_remaining(&classical_encoded_pt))) {
 
         SSLfatal(s, SSL_AD_ILLEGAL_PARAMETER, SSL_F_TLS_PARSE_STOC_KEY_SHARE,
                  SSL_R_BAD_ECPOINT);
@@ -2009,9 +2010,15 @@ int tls_parse_stoc_key_share(SSL *s, PACKET *pkt, unsigned int context, X509 *x,
           has_error = 1;
           goto oqs_cleanup;
         }
+        if (PACKET_remaining(&oqs_encoded_pt) != s->s3->tmp.oqs_kem->length_ciphertext) {
+          SSLfatal(s, SSL_AD_DECODE_ERROR, SSL_F_TLS_PARSE_STOC_KEY_SHARE,
+                   SSL_R_LENGTH_MISMATCH);
+          has_error = 1;
+          goto oqs_cleanup;
+        }
         /* compute the shared secret */
         if ((oqs_shared_secret = malloc(s->s3->tmp.oqs_kem->length_shared_secret)) == NULL ||
-            OQS_KEM_decaps(s->s3->tmp.oqs_kem, oqs_shared_secret, oqs_encoded_pt, s->s3->tmp.oqs_kem_client) != OQS_SUCCESS) {
+            !ssl_oqs_kem_decaps(s, s->s3->tmp.oqs_kem, oqs_shared_secret, PACKET_data(&oqs_encoded_pt), s->s3->tmp.oqs_kem_client)) {
           SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS_PARSE_STOC_KEY_SHARE, ERR_R_INTERNAL_ERROR);
           has_error = 1;
           goto oqs_cleanup;
@@ -2058,16 +2065,10 @@ int tls_parse_stoc_key_share(SSL *s, PACKET *pkt, unsigned int context, X509 *x,
     oqs_cleanup:
         /* we free the OQS artefacts on success or error */
         OQS_MEM_secure_free(shared_secret, shared_secret_len);
-        OQS_MEM_secure_free(s->s3->tmp.oqs_kem_client, s->s3->tmp.oqs_kem->length_secret_key);
+        if (s->s3->tmp.oqs_kem != NULL)
+          OQS_MEM_secure_free(s->s3->tmp.oqs_kem_client, s->s3->tmp.oqs_kem->length_secret_key);
         s->s3->tmp.oqs_kem_client = NULL;
-        OQS_KEM_free(s->s3->tmp.oqs_kem);
         s->s3->tmp.oqs_kem = NULL;
-        if (do_hybrid) {
-        /* we allocated these in the hybrid case. in the non-hybrid case, these are
-           just pointers into the packet, and openssl will clean them up */
-          OPENSSL_free(classical_encoded_pt);
-          OPENSSL_free(oqs_encoded_pt);
-        }
         if (has_error) {
           return 0;
         }
@@ -2195,3 +2196,159 @@ int tls_parse_stoc_psk(SSL *s, PACKET *pkt, unsigned int context, X509 *x,
 
     return 1;
 }
+
+/*
+ * Offer the hash of the certificate chain the server sent last time, if we
+ * kept it.
+ */
+EXT_RETURN tls_construct_ctos_cached_info(SSL *s, WPACKET *pkt,
+                                          unsigned int context, X509 *x,
+                                          size_t chainidx)
+{
+    s->ext.cached_info = SSL_CACHED_INFO_NONE;
+    if (!tls13_get_cached_info(s))
+        return EXT_RETURN_NOT_SENT;
+
+    if (!WPACKET_put_bytes_u16(pkt, TLSEXT_TYPE_cached_info)
+            || !WPACKET_start_sub_packet_u16(pkt)
+            || !WPACKET_start_sub_packet_u16(pkt)
+            || !WPACKET_put_bytes_u8(pkt, TLSEXT_cached_info_cert)
+            || !WPACKET_sub_memcpy_u8(pkt, s->ext.cached_info_hash,
+                                      sizeof(s->ext.cached_info_hash))
+            || !WPACKET_close(pkt)
+            || !WPACKET_close(pkt)) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR,
+                 SSL_F_TLS_CONSTRUCT_CTOS_CACHED_INFO, ERR_R_INTERNAL_ERROR);
+        return EXT_RETURN_FAIL;
+    }
+
+    s->ext.cached_info = SSL_CACHED_INFO_OFFERED;
+
+    return EXT_RETURN_SENT;
+}
+
+#ifndef OPENSSL_NO_COMP
+EXT_RETURN tls_construct_ctos_compress_certificate(SSL *s, WPACKET *pkt,
+                                                   unsigned int context,
+                                                   X509 *x, size_t chainidx)
+{
+    size_t i;
+
+    s->ext.cert_comp = 0;
+    if (s->cert_comp_prefs_len == 0)
+        return EXT_RETURN_NOT_SENT;
+
+    if (!WPACKET_put_bytes_u16(pkt, TLSEXT_TYPE_compress_certificate)
+            || !WPACKET_start_sub_packet_u16(pkt)
+            || !WPACKET_start_sub_packet_u8(pkt)) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR,
+                 SSL_F_TLS_CONSTRUCT_CTOS_COMPRESS_CERTIFICATE,
+                 ERR_R_INTERNAL_ERROR);
+        return EXT_RETURN_FAIL;
+    }
+    for (i = 0; i < s->cert_comp_prefs_len; i++) {
+        if (!WPACKET_put_bytes_u16(pkt, s->cert_comp_prefs[i])) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR,
+                     SSL_F_TLS_CONSTRUCT_CTOS_COMPRESS_CERTIFICATE,
+                     ERR_R_INTERNAL_ERROR);
+            return EXT_RETURN_FAIL;
+        }
+    }
+    if (!WPACKET_close(pkt) || !WPACKET_close(pkt)) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR,
+                 SSL_F_TLS_CONSTRUCT_CTOS_COMPRESS_CERTIFICATE,
+                 ERR_R_INTERNAL_ERROR);
+        return EXT_RETURN_FAIL;
+    }
+
+    s->ext.cert_comp = 1;
+
+    return EXT_RETURN_SENT;
+}
+#endif
+
+/* The server lists the cached objects it is going to leave out */
+int tls_parse_stoc_cached_info(SSL *s, PACKET *pkt, unsigned int context,
+                               X509 *x, size_t chainidx)
+{
+    PACKET types;
+    unsigned int type;
+
+    if (!PACKET_as_length_prefixed_2(pkt, &types)
+            || PACKET_remaining(&types) == 0) {
+        SSLfatal(s, SSL_AD_DECODE_ERROR, SSL_F_TLS_PARSE_STOC_CACHED_INFO,
+                 SSL_R_BAD_EXTENSION);
+        return 0;
+    }
+    while (PACKET_get_1(&types, &type)) {
+        /* We only ever offer the certificate chain */
+        if (type != TLSEXT_cached_info_cert
+                || s->ext.cached_info != SSL_CACHED_INFO_OFFERED) {
+            SSLfatal(s, SSL_AD_ILLEGAL_PARAMETER,
+                     SSL_F_TLS_PARSE_STOC_CACHED_INFO, SSL_R_BAD_EXTENSION);
+            return 0;
+        }
+        s->ext.cached_info = SSL_CACHED_INFO_USED;
+    }
+
+    return 1;
+}
+
+/*
+ * Offer DTLS connection IDs with the one we want to receive. They are only
+ * negotiated in the first handshake and renegotiation keeps them.
+ */
+EXT_RETURN tls_construct_ctos_connection_id(SSL *s, WPACKET *pkt,
+                                            unsigned int context, X509 *x,
+                                            size_t chainidx)
+{
+    if ((s->dtls_cid.gen_len < 0 && !s->dtls_cid.cid_set) || s->renegotiate)
+        return EXT_RETURN_NOT_SENT;
+
+    if (!ssl_dtls_cid_pick(s)
+            || !WPACKET_put_bytes_u16(pkt, TLSEXT_TYPE_connection_id)
+            || !WPACKET_start_sub_packet_u16(pkt)
+            || !WPACKET_sub_memcpy_u8(pkt, s->dtls_cid.cid,
+                                      s->dtls_cid.cid_len)
+            || !WPACKET_close(pkt)) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR,
+                 SSL_F_TLS_CONSTRUCT_CTOS_CONNECTION_ID, ERR_R_INTERNAL_ERROR);
+        return EXT_RETURN_FAIL;
+    }
+
+    return EXT_RETURN_SENT;
+}
+
+/*
+ * Records with a connection ID are only protected with AEAD ciphers here,
+ * see dtls1_cid.c.
+ */
+int tls_parse_stoc_connection_id(SSL *s, PACKET *pkt, unsigned int context,
+                                 X509 *x, size_t chainidx)
+{
+    PACKET cid;
+
+    if (!PACKET_as_length_prefixed_1(pkt, &cid)) {
+        SSLfatal(s, SSL_AD_DECODE_ERROR, SSL_F_TLS_PARSE_STOC_CONNECTION_ID,
+                 SSL_R_BAD_EXTENSION);
+        return 0;
+    }
+    if (s->s3->tmp.new_cipher->algorithm_mac != SSL_AEAD
+            || s->s3->tmp.new_compression != NULL) {
+        SSLfatal(s, SSL_AD_HANDSHAKE_FAILURE,
+                 SSL_F_TLS_PARSE_STOC_CONNECTION_ID,
+                 SSL_R_DTLS_CID_WITHOUT_AEAD);
+        return 0;
+    }
+
+    s->dtls_cid.peer_cid_len = PACKET_remaining(&cid);
+    if (!PACKET_copy_bytes(&cid, s->dtls_cid.peer_cid,
+                           s->dtls_cid.peer_cid_len)) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS_PARSE_STOC_CONNECTION_ID,
+                 ERR_R_INTERNAL_ERROR);
+        return 0;
+    }
+    s->dtls_cid.negotiated = 1;
+
+    return 1;
+}
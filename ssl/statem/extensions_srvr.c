@@ -626,19 +626,28 @@ int tls_parse_ctos_key_share(SSL *s, PACKET *pkt, unsigned int context, X509 *x,
 {
 #ifndef OPENSSL_NO_TLS1_3
     unsigned int group_id;
-    PACKET key_share_list, encoded_pt;
+    PACKET key_share_list, encoded_pt, classical_encoded_pt, oqs_encoded_pt;
     const uint16_t *clntgroups, *srvrgroups;
     size_t clnt_num_groups, srvr_num_groups;
     int found = 0;
     int do_pqc = 0; /* 1 if post-quantum alg, 0 otherwise */
     int do_hybrid = 0; /* 1 if post-quantum hybrid alg, 0 otherwise */
-    unsigned char *classical_encoded_pt = NULL, *oqs_encoded_pt = NULL;
-    uint16_t classical_encodedlen = 0, oqs_encodedlen = 0;
-    int has_error = 0;
+    int defer;
 
     if (s->hit && (s->ext.psk_kex_mode & TLSEXT_KEX_MODE_FLAG_KE_DHE) == 0)
         return 1;
 
+    /*
+     * A stateless server answers a ClientHello without a cookie with a
+     * HelloRetryRequest whatever its key shares hold, so all it needs is the
+     * group to pick. Decoding the share, which means copying a PQ public key
+     * and decoding an EC point, waits until the client comes back with a
+     * cookie and so has shown it can receive our messages.
+     */
+    defer = (s->s3->flags & TLS1_FLAGS_STATELESS) != 0
+            && s->clienthello != NULL
+            && !s->clienthello->pre_proc_exts[TLSEXT_IDX_cookie].present;
+
     /* Sanity check */
     if (s->s3->peer_tmp != NULL) { /* in oqs, this will be null; is this ok? FIXMEOQS */
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS_PARSE_CTOS_KEY_SHARE,
@@ -719,36 +728,58 @@ int tls_parse_ctos_key_share(SSL *s, PACKET *pkt, unsigned int context, X509 *x,
             continue;
         }
 
+        if (defer) {
+            s->s3->group_id = group_id;
+            s->s3->tmp.key_share_deferred = 1;
+            found = 1;
+            continue;
+        }
+
         /* check if we are dealing with pqc or hybrid */
         do_pqc = IS_OQS_KEM_CURVEID(group_id);
         do_hybrid = IS_OQS_KEM_HYBRID_CURVEID(group_id);
 
         /* parse the encoded_pt, which is either a classical, PQC, or hybrid (both) message. */
+        PACKET_null_init(&classical_encoded_pt);
+        PACKET_null_init(&oqs_encoded_pt);
         if (do_hybrid) {
-          if (!OQS_decode_hybrid_message(PACKET_data(&encoded_pt),
-                                         group_id,
-                                         true,
+          if (!OQS_decode_hybrid_message(&encoded_pt, group_id, 1,
                                          &classical_encoded_pt,
-                                         &classical_encodedlen,
-                                         &oqs_encoded_pt,
-                                         &oqs_encodedlen)) {
-            has_error = 1;
-            goto oqs_cleanup;
+                                         &oqs_encoded_pt)) {
+            SSLfatal(s, SSL_AD_DECODE_ERROR, SSL_F_TLS_PARSE_CTOS_KEY_SHARE,
+                     SSL_R_LENGTH_MISMATCH);
+            return 0;
           }
         } else if (do_pqc) {
-          oqs_encoded_pt = (unsigned char*) PACKET_data(&encoded_pt);
-          oqs_encodedlen = PACKET_remaining(&encoded_pt);
+          const OQS_KEM *oqs_kem = get_oqs_kem(OQS_KEM_NID(group_id));
+
+          if (oqs_kem == NULL
+                  || PACKET_remaining(&encoded_pt) != oqs_kem->length_public_key) {
+            SSLfatal(s, SSL_AD_DECODE_ERROR, SSL_F_TLS_PARSE_CTOS_KEY_SHARE,
+                     SSL_R_LENGTH_MISMATCH);
+            return 0;
+          }
+          oqs_encoded_pt = encoded_pt;
         } else {
-          classical_encoded_pt = (unsigned char*) PACKET_data(&encoded_pt);
-          classical_encodedlen = PACKET_remaining(&encoded_pt);
+          classical_encoded_pt = encoded_pt;
         }
 
         if (do_pqc || do_hybrid) {
-          const unsigned char* peer_msg = oqs_encoded_pt;
-          s->s3->tmp.oqs_peer_msg_len = oqs_encodedlen;
-          unsigned char* peer_key = OPENSSL_malloc(s->s3->tmp.oqs_peer_msg_len);
-          memcpy(peer_key, peer_msg, s->s3->tmp.oqs_peer_msg_len); /* FIXMEOQS: when should I free that? */
+          unsigned char *peer_key = NULL;
+          size_t peer_msg_len;
+
+          /*
+           * The ClientHello buffer is reused to write the ServerHello, so
+           * the peer's public key is the one part that has to be copied out.
+           */
+          if (!PACKET_memdup(&oqs_encoded_pt, &peer_key, &peer_msg_len)) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS_PARSE_CTOS_KEY_SHARE,
+                     ERR_R_MALLOC_FAILURE);
+            return 0;
+          }
+          OPENSSL_free(s->s3->tmp.oqs_kem_client);
           s->s3->tmp.oqs_kem_client = peer_key;
+          s->s3->tmp.oqs_peer_msg_len = peer_msg_len;
           /* OQS note: we are not using peer_tmp in the oqs case, but the kex fails if this
              value is null, so we instantiate it but we don't assign any value. It will get
              cleaned up later.
@@ -757,8 +788,7 @@ int tls_parse_ctos_key_share(SSL *s, PACKET *pkt, unsigned int context, X509 *x,
           if (!do_hybrid && (s->s3->peer_tmp = EVP_PKEY_new()) == NULL) {
             SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS_PARSE_CTOS_KEY_SHARE,
                      ERR_R_INTERNAL_ERROR);
-            has_error = 1;
-            goto oqs_cleanup;
+            return 0;
           }
           /* ---------- end oqs note */
         }
@@ -768,17 +798,15 @@ int tls_parse_ctos_key_share(SSL *s, PACKET *pkt, unsigned int context, X509 *x,
           if ((s->s3->peer_tmp = ssl_generate_param_group(classical_group_id)) == NULL) {
             SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS_PARSE_CTOS_KEY_SHARE,
                      SSL_R_UNABLE_TO_FIND_ECDH_PARAMETERS);
-            has_error = 1;
-            goto oqs_cleanup;
+            return 0;
           }
 
           if (!EVP_PKEY_set1_tls_encodedpoint(s->s3->peer_tmp,
-                                              classical_encoded_pt,
-                                              classical_encodedlen)) {
+                  PACKET_data(&classical_encoded_pt),
+                  PACKET_remaining(&classical_encoded_pt))) {
             SSLfatal(s, SSL_AD_ILLEGAL_PARAMETER,
                      SSL_F_TLS_PARSE_CTOS_KEY_SHARE, SSL_R_BAD_ECPOINT);
-            has_error = 1;
-            goto oqs_cleanup;
+            return 0;
           }
         }
         s->s3->group_id = group_id;
@@ -786,17 +814,6 @@ int tls_parse_ctos_key_share(SSL *s, PACKET *pkt, unsigned int context, X509 *x,
     }
 #endif
 
-    oqs_cleanup:
-      if (do_hybrid) {
-        /* we allocated these in the hybrid case. in the non-hybrid case, these are
-           just pointers into the packet, and openssl will clean them up */
-        OPENSSL_free(classical_encoded_pt);
-        OPENSSL_free(oqs_encoded_pt);
-      }
-      if (has_error) {
-        return 0;
-      }
-
     return 1;
 }
 
@@ -1248,8 +1265,7 @@ int tls_parse_ctos_psk(SSL *s, PACKET *pkt, unsigned int context, X509 *x,
              * is no point in using full stateless tickets.
              */
             if ((s->options & SSL_OP_NO_TICKET) != 0
-                    || (s->max_early_data > 0
-                        && (s->options & SSL_OP_NO_ANTI_REPLAY) == 0))
+                    || SSL_ANTI_REPLAY_BY_CACHE(s))
                 ret = tls_get_stateful_ticket(s, &identity, &sess);
             else
                 ret = tls_decrypt_ticket(s, PACKET_data(&identity),
@@ -1272,8 +1288,7 @@ int tls_parse_ctos_psk(SSL *s, PACKET *pkt, unsigned int context, X509 *x,
                 continue;
 
             /* Check for replay */
-            if (s->max_early_data > 0
-                    && (s->options & SSL_OP_NO_ANTI_REPLAY) == 0
+            if (SSL_ANTI_REPLAY_BY_CACHE(s)
                     && !SSL_CTX_remove_session(s->session_ctx, sess)) {
                 SSL_SESSION_free(sess);
                 sess = NULL;
@@ -1350,6 +1365,18 @@ int tls_parse_ctos_psk(SSL *s, PACKET *pkt, unsigned int context, X509 *x,
         goto err;
     }
 
+    /*
+     * The binder is a MAC over the ClientHello, so a replayed ClientHello
+     * is seen again as the same binder. It only loses its early data.
+     */
+    if (s->ext.early_data_ok
+            && s->max_early_data > 0
+            && (s->options & SSL_OP_NO_ANTI_REPLAY) == 0
+            && s->session_ctx->replay_filter != NULL
+            && !ssl_replay_filter_check(s->session_ctx->replay_filter,
+                                        PACKET_data(&binder), hashsize))
+        s->ext.early_data_ok = 0;
+
     s->ext.tick_identity = id;
 
     SSL_SESSION_free(s->session);
@@ -1754,9 +1781,8 @@ EXT_RETURN tls_construct_stoc_key_share(SSL *s, WPACKET *pkt,
                                         size_t chainidx)
 {
 #ifndef OPENSSL_NO_TLS1_3
-    unsigned char *encodedPoint = NULL, *classical_encodedPoint = NULL, *oqs_encodedPoint = NULL;
+    unsigned char *encodedPoint = NULL, *oqs_encodedPoint = NULL;
     size_t encoded_pt_len = 0;
-    uint16_t classical_encoded_pt_len = 0, oqs_encoded_pt_len = 0;
     unsigned char* shared_secret = NULL, *oqs_shared_secret = NULL;
     size_t shared_secret_len = 0, oqs_shared_secret_len = 0;
     EVP_PKEY *ckey = s->s3->peer_tmp, *skey = NULL;
@@ -1764,7 +1790,7 @@ EXT_RETURN tls_construct_stoc_key_share(SSL *s, WPACKET *pkt,
     int do_hybrid = 0; /* 1 if post-quantum hybrid alg, 0 otherwise */
 
     if (s->hello_retry_request == SSL_HRR_PENDING) {
-      if (ckey != NULL) { /* this is null in OQS, is this ok? (FIXMEOQS) */
+      if (ckey != NULL || s->s3->tmp.key_share_deferred) { /* this is null in OQS, is this ok? (FIXMEOQS) */
             /* Original key_share was acceptable so don't ask for another one */
             return EXT_RETURN_NOT_SENT;
         }
@@ -1809,7 +1835,9 @@ EXT_RETURN tls_construct_stoc_key_share(SSL *s, WPACKET *pkt,
     do_pqc = IS_OQS_KEM_CURVEID(s->s3->group_id);
     do_hybrid = IS_OQS_KEM_HYBRID_CURVEID(s->s3->group_id);
     if (!do_pqc || do_hybrid) {
-      skey = ssl_generate_pkey(ckey);
+      skey = ssl_generate_pkey_reuse(s, ckey,
+                                     do_hybrid ? OQS_KEM_CLASSICAL_CURVEID(s->s3->group_id)
+                                               : s->s3->group_id);
       if (skey == NULL) {
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS_CONSTRUCT_STOC_KEY_SHARE,
                  ERR_R_MALLOC_FAILURE);
@@ -1817,8 +1845,8 @@ EXT_RETURN tls_construct_stoc_key_share(SSL *s, WPACKET *pkt,
       }
 
       /* Generate encoding of server key */
-      classical_encoded_pt_len = EVP_PKEY_get1_tls_encodedpoint(skey, &classical_encodedPoint);
-      if (classical_encoded_pt_len == 0) {
+      encoded_pt_len = EVP_PKEY_get1_tls_encodedpoint(skey, &encodedPoint);
+      if (encoded_pt_len == 0) {
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS_CONSTRUCT_STOC_KEY_SHARE,
                  ERR_R_EC_LIB);
         EVP_PKEY_free(skey);
@@ -1831,6 +1859,8 @@ EXT_RETURN tls_construct_stoc_key_share(SSL *s, WPACKET *pkt,
          shared key will be store in s->s3->tmp.pms */
       if (ssl_derive(s, skey, ckey, do_hybrid ? 0 : 1) == 0) {
         /* SSLfatal() already called */
+        EVP_PKEY_free(skey);
+        OPENSSL_free(encodedPoint);
         return EXT_RETURN_FAIL;
       }
 
@@ -1839,12 +1869,11 @@ EXT_RETURN tls_construct_stoc_key_share(SSL *s, WPACKET *pkt,
     if (do_pqc || do_hybrid) {
       /* This is a group handled by OQS */
       int oqs_nid = OQS_KEM_NID(s->s3->group_id);
-      OQS_KEM* oqs_kem = NULL;
+      const OQS_KEM* oqs_kem = NULL;
       unsigned char* client_msg = s->s3->tmp.oqs_kem_client;
       int has_error = 0;
-      const char* oqs_alg_name = OQS_ALG_NAME(oqs_nid);
       /* initialize the kex */
-      if ((oqs_kem = OQS_KEM_new(oqs_alg_name)) == NULL) {
+      if ((oqs_kem = get_oqs_kem(oqs_nid)) == NULL) {
         /* TODO: provide a better error message for non-enabled OQS schemes.
            Perhaps even check if the alg is available earlier in the stack. (FIXMEOQS) */
         SSLfatal(s, SSL_AD_INTERNAL_ERROR,
@@ -1852,16 +1881,20 @@ EXT_RETURN tls_construct_stoc_key_share(SSL *s, WPACKET *pkt,
         has_error = 1;
         goto oqs_cleanup;
       }
-      /* compute the servers's shared secret and message (encoded in encoded_point) */
-      if ((oqs_encodedPoint = malloc(oqs_kem->length_ciphertext)) == NULL ||
-          (oqs_shared_secret = malloc(oqs_kem->length_shared_secret)) == NULL ||
-          OQS_KEM_encaps(oqs_kem, oqs_encodedPoint, oqs_shared_secret, client_msg) != OQS_SUCCESS) {
+      /* compute the servers's shared secret and message; the ciphertext is
+         encapsulated straight into pkt after the classical share, if any */
+      if (!WPACKET_start_sub_packet_u16(pkt)
+          || !OQS_encode_hybrid_message(pkt, encodedPoint, encoded_pt_len,
+                                        oqs_kem->length_ciphertext,
+                                        &oqs_encodedPoint)
+          || (oqs_shared_secret = malloc(oqs_kem->length_shared_secret)) == NULL
+          || !ssl_oqs_kem_encaps(s, oqs_kem, oqs_encodedPoint, oqs_shared_secret, client_msg)
+          || !WPACKET_close(pkt)) {
         SSLfatal(s, SSL_AD_INTERNAL_ERROR,
                  SSL_F_TLS_CONSTRUCT_STOC_KEY_SHARE, ERR_R_INTERNAL_ERROR);
         has_error = 1;
         goto oqs_cleanup;
       }
-      oqs_encoded_pt_len = oqs_kem->length_ciphertext;
       oqs_shared_secret_len = oqs_kem->length_shared_secret;
 
         /* derive the ssl secret */
@@ -1900,32 +1933,22 @@ EXT_RETURN tls_construct_stoc_key_share(SSL *s, WPACKET *pkt,
       }
     oqs_cleanup:
       OQS_MEM_secure_free(shared_secret, shared_secret_len);
-      OQS_KEM_free(oqs_kem);
       OPENSSL_free(s->s3->tmp.oqs_kem_client);
+      s->s3->tmp.oqs_kem_client = NULL;
       if (has_error) {
+        EVP_PKEY_free(skey);
+        OPENSSL_free(encodedPoint);
         return EXT_RETURN_FAIL;
       }
-    }
-
-    if (do_hybrid) {
-      uint16_t encoded_pt_len16;
-      int ret = OQS_encode_hybrid_message(classical_encodedPoint, classical_encoded_pt_len, oqs_encodedPoint, oqs_encoded_pt_len, &encodedPoint, &encoded_pt_len16);
-      encoded_pt_len = encoded_pt_len16;
-      OPENSSL_free(classical_encodedPoint);
-      OPENSSL_free(oqs_encodedPoint);
-      if (!ret) {
+    } else if (!WPACKET_sub_memcpy_u16(pkt, encodedPoint, encoded_pt_len)) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS_CONSTRUCT_STOC_KEY_SHARE,
+                 ERR_R_INTERNAL_ERROR);
+        EVP_PKEY_free(skey);
+        OPENSSL_free(encodedPoint);
         return EXT_RETURN_FAIL;
-      }
-    } else if (do_pqc) {
-      encodedPoint = oqs_encodedPoint;
-      encoded_pt_len = oqs_encoded_pt_len;
-    } else {
-      encodedPoint = classical_encodedPoint;
-      encoded_pt_len = classical_encoded_pt_len;
     }
 
-    if (!WPACKET_sub_memcpy_u16(pkt, encodedPoint, encoded_pt_len)
-            || !WPACKET_close(pkt)) {
+    if (!WPACKET_close(pkt)) {
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS_CONSTRUCT_STOC_KEY_SHARE,
                  ERR_R_INTERNAL_ERROR);
         EVP_PKEY_free(skey);
@@ -1981,7 +2004,8 @@ EXT_RETURN tls_construct_stoc_cookie(SSL *s, WPACKET *pkt, unsigned int context,
             || !s->method->put_cipher_by_char(s->s3->tmp.new_cipher, pkt,
                                               &ciphlen)
                /* Is there a key_share extension present in this HRR? */
-            || !WPACKET_put_bytes_u8(pkt, s->s3->peer_tmp == NULL) /* in oqs, this is null; is this ok? (FIXMEOQS) */
+            || !WPACKET_put_bytes_u8(pkt, s->s3->peer_tmp == NULL
+                                          && !s->s3->tmp.key_share_deferred) /* in oqs, this is null; is this ok? (FIXMEOQS) */
             || !WPACKET_put_bytes_u64(pkt, time(NULL))
             || !WPACKET_start_sub_packet_u16(pkt)
             || !WPACKET_reserve_bytes(pkt, EVP_MAX_MD_SIZE, &hashval1)) {
@@ -2144,6 +2168,45 @@ EXT_RETURN tls_construct_stoc_early_data(SSL *s, WPACKET *pkt,
     return EXT_RETURN_SENT;
 }
 
+/*
+ * Tell the client we leave the certificate chain out if it already has the
+ * one we would send.
+ */
+EXT_RETURN tls_construct_stoc_cached_info(SSL *s, WPACKET *pkt,
+                                          unsigned int context, X509 *x,
+                                          size_t chainidx)
+{
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+
+    if (s->ext.cached_info != SSL_CACHED_INFO_OFFERED)
+        return EXT_RETURN_NOT_SENT;
+    s->ext.cached_info = SSL_CACHED_INFO_NONE;
+    if (s->hit)
+        return EXT_RETURN_NOT_SENT;
+
+    if (!tls13_server_cert_list_hash(s, hash)) {
+        /* SSLfatal() already called */
+        return EXT_RETURN_FAIL;
+    }
+    if (memcmp(hash, s->ext.cached_info_hash, sizeof(hash)) != 0)
+        return EXT_RETURN_NOT_SENT;
+
+    if (!WPACKET_put_bytes_u16(pkt, TLSEXT_TYPE_cached_info)
+            || !WPACKET_start_sub_packet_u16(pkt)
+            || !WPACKET_start_sub_packet_u16(pkt)
+            || !WPACKET_put_bytes_u8(pkt, TLSEXT_cached_info_cert)
+            || !WPACKET_close(pkt)
+            || !WPACKET_close(pkt)) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR,
+                 SSL_F_TLS_CONSTRUCT_STOC_CACHED_INFO, ERR_R_INTERNAL_ERROR);
+        return EXT_RETURN_FAIL;
+    }
+
+    s->ext.cached_info = SSL_CACHED_INFO_USED;
+
+    return EXT_RETURN_SENT;
+}
+
 EXT_RETURN tls_construct_stoc_psk(SSL *s, WPACKET *pkt, unsigned int context,
                                   X509 *x, size_t chainidx)
 {
@@ -2161,3 +2224,131 @@ EXT_RETURN tls_construct_stoc_psk(SSL *s, WPACKET *pkt, unsigned int context,
 
     return EXT_RETURN_SENT;
 }
+
+/*
+ * Note the hash of the certificate chain the client has cached, if it
+ * offers one. Other cached objects are ignored.
+ */
+int tls_parse_ctos_cached_info(SSL *s, PACKET *pkt, unsigned int context,
+                               X509 *x, size_t chainidx)
+{
+    PACKET objs, hash;
+    unsigned int type;
+
+    if (!PACKET_as_length_prefixed_2(pkt, &objs)
+            || PACKET_remaining(&objs) == 0) {
+        SSLfatal(s, SSL_AD_DECODE_ERROR, SSL_F_TLS_PARSE_CTOS_CACHED_INFO,
+                 SSL_R_BAD_EXTENSION);
+        return 0;
+    }
+    while (PACKET_remaining(&objs) > 0) {
+        if (!PACKET_get_1(&objs, &type)
+                || !PACKET_get_length_prefixed_1(&objs, &hash)
+                || PACKET_remaining(&hash) == 0) {
+            SSLfatal(s, SSL_AD_DECODE_ERROR, SSL_F_TLS_PARSE_CTOS_CACHED_INFO,
+                     SSL_R_BAD_EXTENSION);
+            return 0;
+        }
+        if (type == TLSEXT_cached_info_cert
+                && PACKET_remaining(&hash) == sizeof(s->ext.cached_info_hash)
+                && PACKET_copy_bytes(&hash, s->ext.cached_info_hash,
+                                     sizeof(s->ext.cached_info_hash)))
+            s->ext.cached_info = SSL_CACHED_INFO_OFFERED;
+    }
+
+    return 1;
+}
+
+#ifndef OPENSSL_NO_COMP
+/*
+ * Pick the algorithm we like best among those the client can decompress,
+ * if we compress certificates at all.
+ */
+int tls_parse_ctos_compress_certificate(SSL *s, PACKET *pkt,
+                                        unsigned int context, X509 *x,
+                                        size_t chainidx)
+{
+    PACKET algs;
+    unsigned int alg;
+    size_t i;
+    int offered[SSL_CERT_COMP_NUM + 1] = { 0 };
+
+    if (!PACKET_as_length_prefixed_1(pkt, &algs)
+            || PACKET_remaining(&algs) == 0
+            || (PACKET_remaining(&algs) & 1) != 0) {
+        SSLfatal(s, SSL_AD_DECODE_ERROR,
+                 SSL_F_TLS_PARSE_CTOS_COMPRESS_CERTIFICATE,
+                 SSL_R_BAD_EXTENSION);
+        return 0;
+    }
+    while (PACKET_get_net_2(&algs, &alg)) {
+        if (alg > TLSEXT_comp_cert_none && alg <= SSL_CERT_COMP_NUM)
+            offered[alg] = 1;
+    }
+
+    s->ext.cert_comp = TLSEXT_comp_cert_none;
+    for (i = 0; i < s->cert_comp_prefs_len; i++) {
+        if (offered[s->cert_comp_prefs[i]]) {
+            s->ext.cert_comp = s->cert_comp_prefs[i];
+            break;
+        }
+    }
+
+    return 1;
+}
+#endif
+
+int tls_parse_ctos_connection_id(SSL *s, PACKET *pkt, unsigned int context,
+                                 X509 *x, size_t chainidx)
+{
+    PACKET cid;
+
+    if (!PACKET_as_length_prefixed_1(pkt, &cid)) {
+        SSLfatal(s, SSL_AD_DECODE_ERROR, SSL_F_TLS_PARSE_CTOS_CONNECTION_ID,
+                 SSL_R_BAD_EXTENSION);
+        return 0;
+    }
+    /* Connection IDs are kept from the first handshake */
+    if ((s->dtls_cid.gen_len < 0 && !s->dtls_cid.cid_set)
+            || s->dtls_cid.negotiated)
+        return 1;
+
+    s->dtls_cid.peer_cid_len = PACKET_remaining(&cid);
+    if (!PACKET_copy_bytes(&cid, s->dtls_cid.peer_cid,
+                           s->dtls_cid.peer_cid_len)) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS_PARSE_CTOS_CONNECTION_ID,
+                 ERR_R_INTERNAL_ERROR);
+        return 0;
+    }
+    s->dtls_cid.peer_offered = 1;
+
+    return 1;
+}
+
+/*
+ * Records with a connection ID are only protected with AEAD ciphers here,
+ * see dtls1_cid.c, so we decline connection IDs for other cipher suites.
+ */
+EXT_RETURN tls_construct_stoc_connection_id(SSL *s, WPACKET *pkt,
+                                            unsigned int context, X509 *x,
+                                            size_t chainidx)
+{
+    if (!s->dtls_cid.peer_offered
+            || s->s3->tmp.new_cipher->algorithm_mac != SSL_AEAD
+            || s->s3->tmp.new_compression != NULL)
+        return EXT_RETURN_NOT_SENT;
+
+    if (!ssl_dtls_cid_pick(s)
+            || !WPACKET_put_bytes_u16(pkt, TLSEXT_TYPE_connection_id)
+            || !WPACKET_start_sub_packet_u16(pkt)
+            || !WPACKET_sub_memcpy_u8(pkt, s->dtls_cid.cid,
+                                      s->dtls_cid.cid_len)
+            || !WPACKET_close(pkt)) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR,
+                 SSL_F_TLS_CONSTRUCT_STOC_CONNECTION_ID, ERR_R_INTERNAL_ERROR);
+        return EXT_RETURN_FAIL;
+    }
+    s->dtls_cid.negotiated = 1;
+
+    return EXT_RETURN_SENT;
+}
@@ -314,6 +314,7 @@ static int state_machine(SSL *s, int server)
     cb = get_callback(s);
 
     st->in_handshake++;
+    ssl_hs_stats_enter(s);
     if (!SSL_in_init(s) || SSL_in_before(s)) {
         /*
          * If we are stateless then we already called SSL_clear() - don't do
@@ -375,12 +376,20 @@ static int state_machine(SSL *s, int server)
         }
 
         if (s->init_buf == NULL) {
+            /*
+             * Post-handshake messages are mostly small, init_buf grows as
+             * needed for the others
+             */
+            size_t init_size = SSL_IS_DTLS(s) || SSL_IS_FIRST_HANDSHAKE(s)
+                               ? SSL3_RT_MAX_PLAIN_LENGTH
+                               : SSL3_HM_HEADER_LENGTH;
+
             if ((buf = BUF_MEM_new()) == NULL) {
                 SSLfatal(s, SSL_AD_NO_ALERT, SSL_F_STATE_MACHINE,
                          ERR_R_INTERNAL_ERROR);
                 goto end;
             }
-            if (!BUF_MEM_grow(buf, SSL3_RT_MAX_PLAIN_LENGTH)) {
+            if (!BUF_MEM_grow(buf, init_size)) {
                 SSLfatal(s, SSL_AD_NO_ALERT, SSL_F_STATE_MACHINE,
                          ERR_R_INTERNAL_ERROR);
                 goto end;
@@ -420,6 +429,7 @@ static int state_machine(SSL *s, int server)
                 /* SSLfatal() already called */
                 goto end;
             }
+            ssl_hs_stats_begin(s);
 
             if (SSL_IS_FIRST_HANDSHAKE(s))
                 st->read_state_first_init = 1;
@@ -462,6 +472,7 @@ static int state_machine(SSL *s, int server)
 
  end:
     st->in_handshake--;
+    ssl_hs_stats_leave(s);
 
 #ifndef OPENSSL_NO_SCTP
     if (SSL_IS_DTLS(s) && BIO_dgram_is_sctp(SSL_get_wbio(s))) {
@@ -607,6 +618,7 @@ static SUB_STATE_RETURN read_state_machine(SSL *s)
             /* dtls_get_message already did this */
             if (!SSL_IS_DTLS(s)
                     && s->s3->tmp.message_size > 0
+                    && !tls_get_message_in_record(s)
                     && !grow_init_buf(s, s->s3->tmp.message_size
                                          + SSL3_HM_HEADER_LENGTH)) {
                 SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_READ_STATE_MACHINE,
@@ -720,6 +732,20 @@ static void init_write_state_machine(SSL *s)
     st->write_state = WRITE_STATE_TRANSITION;
 }
 
+/*
+ * Make room in init_buf for a message with a body of up to |hint| bytes, so
+ * that it is not reallocated and copied while the message is constructed
+ */
+static int presize_init_buf(SSL *s, size_t hint)
+{
+    size_t len = hint + (SSL_IS_DTLS(s) ? DTLS1_HM_HEADER_LENGTH
+                                        : SSL3_HM_HEADER_LENGTH);
+
+    if (hint == 0 || len <= s->init_buf->length)
+        return 1;
+    return BUF_MEM_grow(s->init_buf, len) != 0;
+}
+
 /*
  * This function implements the sub-state machine when the message flow is in
  * MSG_FLOW_WRITING. The valid sub-states and transitions are:
@@ -761,6 +787,7 @@ static SUB_STATE_RETURN write_state_machine(SSL *s)
     int (*get_construct_message_f) (SSL *s, WPACKET *pkt,
                                     int (**confunc) (SSL *s, WPACKET *pkt),
                                     int *mt);
+    size_t (*size_hint) (SSL *s, int mt);
     void (*cb) (const SSL *ssl, int type, int val) = NULL;
     int (*confunc) (SSL *s, WPACKET *pkt);
     int mt;
@@ -773,11 +800,13 @@ static SUB_STATE_RETURN write_state_machine(SSL *s)
         pre_work = ossl_statem_server_pre_work;
         post_work = ossl_statem_server_post_work;
         get_construct_message_f = ossl_statem_server_construct_message;
+        size_hint = ossl_statem_server_message_size_hint;
     } else {
         transition = ossl_statem_client_write_transition;
         pre_work = ossl_statem_client_pre_work;
         post_work = ossl_statem_client_post_work;
         get_construct_message_f = ossl_statem_client_construct_message;
+        size_hint = ossl_statem_client_message_size_hint;
     }
 
     while (1) {
@@ -833,6 +862,11 @@ static SUB_STATE_RETURN write_state_machine(SSL *s)
                 st->write_state_work = WORK_MORE_A;
                 break;
             }
+            if (!presize_init_buf(s, size_hint(s, mt))) {
+                SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_WRITE_STATE_MACHINE,
+                         ERR_R_MALLOC_FAILURE);
+                return SUB_STATE_ERROR;
+            }
             if (!WPACKET_init(&pkt, s->init_buf)
                     || !ssl_set_handshake_header(s, &pkt, mt)) {
                 WPACKET_cleanup(&pkt);
@@ -899,6 +933,7 @@ static SUB_STATE_RETURN write_state_machine(SSL *s)
  */
 int statem_flush(SSL *s)
 {
+    ssl_rec_stats_add(s, SSL_REC_STAT_FLUSHES, 1);
     s->rwstate = SSL_WRITING;
     if (BIO_flush(s->wbio) <= 0) {
         return 0;
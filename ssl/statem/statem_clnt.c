@@ -125,7 +125,9 @@ static int ossl_statem_client13_read_transition(SSL *s, int mt)
                 st->hand_state = TLS_ST_CR_CERT_REQ;
                 return 1;
             }
-            if (mt == SSL3_MT_CERTIFICATE) {
+            if (mt == SSL3_MT_CERTIFICATE
+                    || (mt == SSL3_MT_COMPRESSED_CERTIFICATE
+                        && s->ext.cert_comp)) {
                 st->hand_state = TLS_ST_CR_CERT;
                 return 1;
             }
@@ -133,7 +135,8 @@ static int ossl_statem_client13_read_transition(SSL *s, int mt)
         break;
 
     case TLS_ST_CR_CERT_REQ:
-        if (mt == SSL3_MT_CERTIFICATE) {
+        if (mt == SSL3_MT_CERTIFICATE
+                || (mt == SSL3_MT_COMPRESSED_CERTIFICATE && s->ext.cert_comp)) {
             st->hand_state = TLS_ST_CR_CERT;
             return 1;
         }
@@ -953,6 +956,63 @@ int ossl_statem_client_construct_message(SSL *s, WPACKET *pkt,
     return 1;
 }
 
+/* Room for the ClientHello extensions of fixed size, and for padding */
+#define CLIENT_HELLO_EXTRA_SIZE     512
+
+static size_t client_hello_size_hint(SSL *s)
+{
+    STACK_OF(SSL_CIPHER) *ciphers = SSL_get_ciphers(s);
+    const uint16_t *pgroups, *psigs;
+    size_t num_groups = 0, len;
+
+    /* version, random, session id, compression methods and extensions */
+    len = 2 + SSL3_RANDOM_SIZE + 1 + SSL_MAX_SSL_SESSION_ID_LENGTH + 2 + 2
+          + CLIENT_HELLO_EXTRA_SIZE;
+    if (SSL_IS_DTLS(s))
+        len += 1 + s->d1->cookie_len;
+    /* cipher suites, with room for the signalling values */
+    if (ciphers != NULL)
+        len += 2 + 2 * ((size_t)sk_SSL_CIPHER_num(ciphers) + 2);
+
+    tls1_get_supported_groups(s, &pgroups, &num_groups);
+    len += 2 * num_groups + 4 * tls12_get_psigalgs(s, 1, &psigs);
+    if (s->ext.hostname != NULL)
+        len += strlen(s->ext.hostname);
+    len += s->ext.alpn_len + s->ext.tls13_cookie_len;
+    /* tickets, and a PSK binder for each */
+    if (s->session != NULL)
+        len += s->session->ext.ticklen + EVP_MAX_MD_SIZE;
+    if (s->psksession != NULL)
+        len += s->psksession->ext.ticklen + EVP_MAX_MD_SIZE;
+#ifndef OPENSSL_NO_TLS1_3
+    len += tls1_key_share_size(tls_ctos_key_share_group(s), 0);
+#endif
+    return len;
+}
+
+/*
+ * Returns an upper bound of the length of the body of message |mt| that is
+ * about to be constructed, or 0 if it is unknown or small. init_buf is sized
+ * for it once, rather than grown while large post-quantum key shares,
+ * certificate chains and signatures are written.
+ */
+size_t ossl_statem_client_message_size_hint(SSL *s, int mt)
+{
+    switch (mt) {
+    case SSL3_MT_CLIENT_HELLO:
+        return client_hello_size_hint(s);
+
+    case SSL3_MT_CERTIFICATE:
+        if (s->s3->tmp.cert_req == 2)
+            return 0;
+        return s->pha_context_len + tls_cert_msg_size_hint(s, s->cert->key);
+
+    case SSL3_MT_CERTIFICATE_VERIFY:
+        return tls_cert_verify_size_hint(s);
+    }
+    return 0;
+}
+
 /*
  * Returns the maximum allowed length for the current message that we are
  * reading. Excludes the message header.
@@ -1042,6 +1102,12 @@ MSG_PROCESS_RETURN ossl_statem_client_process_message(SSL *s, PACKET *pkt)
         return dtls_process_hello_verify(s, pkt);
 
     case TLS_ST_CR_CERT:
+        if (s->ext.cached_info == SSL_CACHED_INFO_USED)
+            return tls_process_server_cached_certificate(s, pkt);
+#ifndef OPENSSL_NO_COMP
+        if (s->s3->tmp.message_type == SSL3_MT_COMPRESSED_CERTIFICATE)
+            return tls_process_server_compressed_certificate(s, pkt);
+#endif
         return tls_process_server_certificate(s, pkt);
 
     case TLS_ST_CR_CERT_VRFY:
@@ -1120,6 +1186,13 @@ int tls_construct_client_hello(SSL *s, WPACKET *pkt)
         return 0;
     }
 
+    /* Resume a session from the client session cache if there is one */
+    if (sess == NULL && s->hello_retry_request == SSL_HRR_NONE
+            && (sess = ssl_client_cache_get(s)) != NULL) {
+        s->session = sess;
+        s->verify_result = sess->verify_result;
+    }
+
     if (sess == NULL
             || !ssl_version_supported(s, sess->ssl_version, NULL)
             || !SSL_SESSION_is_resumable(sess)) {
@@ -1620,6 +1693,7 @@ MSG_PROCESS_RETURN tls_process_server_hello(SSL *s, PACKET *pkt)
          */
         if (s->session->session_id_length > 0) {
             tsan_counter(&s->session_ctx->stats.sess_miss);
+            OSSL_METRIC_INC(OSSL_METRIC_SSL_SESS_MISSES);
             if (!ssl_get_new_session(s, 0)) {
                 /* SSLfatal() already called */
                 goto err;
@@ -1750,10 +1824,10 @@ MSG_PROCESS_RETURN tls_process_server_hello(SSL *s, PACKET *pkt)
         goto err;
     }
 
-    OPENSSL_free(extensions);
+    tls_free_raw_extensions(s, extensions);
     return MSG_PROCESS_CONTINUE_READING;
  err:
-    OPENSSL_free(extensions);
+    tls_free_raw_extensions(s, extensions);
     return MSG_PROCESS_ERROR;
 }
 
@@ -1777,7 +1851,7 @@ static MSG_PROCESS_RETURN tls_process_as_hello_retry_request(SSL *s,
         goto err;
     }
 
-    OPENSSL_free(extensions);
+    tls_free_raw_extensions(s, extensions);
     extensions = NULL;
 
     if (s->ext.tls13_cookie_len == 0
@@ -1818,7 +1892,7 @@ static MSG_PROCESS_RETURN tls_process_as_hello_retry_request(SSL *s,
 
     return MSG_PROCESS_FINISHED_READING;
  err:
-    OPENSSL_free(extensions);
+    tls_free_raw_extensions(s, extensions);
     return MSG_PROCESS_ERROR;
 }
 
@@ -1834,6 +1908,9 @@ MSG_PROCESS_RETURN tls_process_server_certificate(SSL *s, PACKET *pkt)
     size_t chainidx, certidx;
     unsigned int context = 0;
     const SSL_CERT_LOOKUP *clu;
+    const unsigned char *msg = PACKET_data(pkt);
+    size_t msg_len = PACKET_remaining(pkt);
+    SSL_HS_TIMER t;
 
     if ((sk = sk_X509_new_null()) == NULL) {
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS_PROCESS_SERVER_CERTIFICATE,
@@ -1860,7 +1937,8 @@ MSG_PROCESS_RETURN tls_process_server_certificate(SSL *s, PACKET *pkt)
         }
 
         certstart = certbytes;
-        x = d2i_X509(NULL, (const unsigned char **)&certbytes, cert_len);
+        x = d2i_X509_intern(NULL, (const unsigned char **)&certbytes,
+                            cert_len);
         if (x == NULL) {
             SSLfatal(s, SSL_AD_BAD_CERTIFICATE,
                      SSL_F_TLS_PROCESS_SERVER_CERTIFICATE, ERR_R_ASN1_LIB);
@@ -1889,11 +1967,11 @@ MSG_PROCESS_RETURN tls_process_server_certificate(SSL *s, PACKET *pkt)
                 || !tls_parse_all_extensions(s, SSL_EXT_TLS1_3_CERTIFICATE,
                                              rawexts, x, chainidx,
                                              PACKET_remaining(pkt) == 0)) {
-                OPENSSL_free(rawexts);
+                tls_free_raw_extensions(s, rawexts);
                 /* SSLfatal already called */
                 goto err;
             }
-            OPENSSL_free(rawexts);
+            tls_free_raw_extensions(s, rawexts);
         }
 
         if (!sk_X509_push(sk, x)) {
@@ -1905,7 +1983,9 @@ MSG_PROCESS_RETURN tls_process_server_certificate(SSL *s, PACKET *pkt)
         x = NULL;
     }
 
+    ssl_hs_timer_start(s, &t);
     i = ssl_verify_cert_chain(s, sk);
+    ssl_hs_timer_stop(s, SSL_HS_PHASE_CHAIN_VERIFY, &t);
     /*
      * The documented interface is that SSL_VERIFY_PEER should be set in order
      * for client side verification of the server certificate to take place.
@@ -1987,6 +2067,10 @@ MSG_PROCESS_RETURN tls_process_server_certificate(SSL *s, PACKET *pkt)
         goto err;
     }
 
+    /* Keep the chain so that the next handshake can offer its hash */
+    if (SSL_IS_TLS13(s) && s->ext.cached_info != SSL_CACHED_INFO_USED)
+        tls13_set_cached_info(s, msg, msg_len);
+
     ret = MSG_PROCESS_CONTINUE_READING;
 
  err:
@@ -1995,6 +2079,106 @@ MSG_PROCESS_RETURN tls_process_server_certificate(SSL *s, PACKET *pkt)
     return ret;
 }
 
+/*
+ * A Certificate message from a server that left out the chain we have
+ * cached: check that the hash is the one we offered, and process the chain
+ * we kept.
+ */
+MSG_PROCESS_RETURN tls_process_server_cached_certificate(SSL *s, PACKET *pkt)
+{
+    PACKET hash, msg;
+
+    if (!PACKET_get_length_prefixed_1(pkt, &hash)
+            || PACKET_remaining(pkt) != 0) {
+        SSLfatal(s, SSL_AD_DECODE_ERROR,
+                 SSL_F_TLS_PROCESS_SERVER_CACHED_CERTIFICATE,
+                 SSL_R_LENGTH_MISMATCH);
+        return MSG_PROCESS_ERROR;
+    }
+    if (!PACKET_equal(&hash, s->ext.cached_info_hash,
+                      sizeof(s->ext.cached_info_hash))) {
+        SSLfatal(s, SSL_AD_ILLEGAL_PARAMETER,
+                 SSL_F_TLS_PROCESS_SERVER_CACHED_CERTIFICATE,
+                 SSL_R_BAD_CACHED_INFO);
+        return MSG_PROCESS_ERROR;
+    }
+    if (!PACKET_buf_init(&msg, s->ext.cached_info_msg,
+                         s->ext.cached_info_msg_len)) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR,
+                 SSL_F_TLS_PROCESS_SERVER_CACHED_CERTIFICATE,
+                 ERR_R_INTERNAL_ERROR);
+        return MSG_PROCESS_ERROR;
+    }
+    return tls_process_server_certificate(s, &msg);
+}
+
+#ifndef OPENSSL_NO_COMP
+/*
+ * An RFC 8879 CompressedCertificate: decompress it and process the
+ * Certificate message it holds.
+ */
+MSG_PROCESS_RETURN tls_process_server_compressed_certificate(SSL *s,
+                                                             PACKET *pkt)
+{
+    unsigned int alg;
+    unsigned long raw_len;
+    PACKET comp, raw;
+    unsigned char *buf = NULL;
+    MSG_PROCESS_RETURN ret = MSG_PROCESS_ERROR;
+    size_t i;
+
+    if (!PACKET_get_net_2(pkt, &alg)
+            || !PACKET_get_net_3(pkt, &raw_len)
+            || !PACKET_get_length_prefixed_3(pkt, &comp)
+            || PACKET_remaining(pkt) != 0
+            || raw_len == 0) {
+        SSLfatal(s, SSL_AD_DECODE_ERROR,
+                 SSL_F_TLS_PROCESS_SERVER_COMPRESSED_CERTIFICATE,
+                 SSL_R_LENGTH_MISMATCH);
+        return MSG_PROCESS_ERROR;
+    }
+    for (i = 0; i < s->cert_comp_prefs_len; i++)
+        if (s->cert_comp_prefs[i] == (int)alg)
+            break;
+    if (i == s->cert_comp_prefs_len) {
+        SSLfatal(s, SSL_AD_ILLEGAL_PARAMETER,
+                 SSL_F_TLS_PROCESS_SERVER_COMPRESSED_CERTIFICATE,
+                 SSL_R_BAD_CERT_COMPRESSION_ALGORITHM);
+        return MSG_PROCESS_ERROR;
+    }
+    /* The limit on the Certificate message applies once decompressed */
+    if (raw_len > s->max_cert_list) {
+        SSLfatal(s, SSL_AD_BAD_CERTIFICATE,
+                 SSL_F_TLS_PROCESS_SERVER_COMPRESSED_CERTIFICATE,
+                 SSL_R_EXCESSIVE_MESSAGE_SIZE);
+        return MSG_PROCESS_ERROR;
+    }
+    if ((buf = OPENSSL_malloc(raw_len)) == NULL) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR,
+                 SSL_F_TLS_PROCESS_SERVER_COMPRESSED_CERTIFICATE,
+                 ERR_R_MALLOC_FAILURE);
+        return MSG_PROCESS_ERROR;
+    }
+    if (!ssl_cert_comp_expand(alg, PACKET_data(&comp),
+                              PACKET_remaining(&comp), buf, raw_len)) {
+        SSLfatal(s, SSL_AD_BAD_CERTIFICATE,
+                 SSL_F_TLS_PROCESS_SERVER_COMPRESSED_CERTIFICATE,
+                 SSL_R_BAD_COMPRESSED_CERTIFICATE);
+        goto err;
+    }
+    if (!PACKET_buf_init(&raw, buf, raw_len)) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR,
+                 SSL_F_TLS_PROCESS_SERVER_COMPRESSED_CERTIFICATE,
+                 ERR_R_INTERNAL_ERROR);
+        goto err;
+    }
+    ret = tls_process_server_certificate(s, &raw);
+ err:
+    OPENSSL_free(buf);
+    return ret;
+}
+#endif
+
 static int tls_process_ske_psk_preamble(SSL *s, PACKET *pkt)
 {
 #ifndef OPENSSL_NO_PSK
@@ -2410,8 +2594,8 @@ MSG_PROCESS_RETURN tls_process_key_exchange(SSL *s, PACKET *pkt)
             goto err;
         }
 
-        rv = EVP_DigestVerify(md_ctx, PACKET_data(&signature),
-                              PACKET_remaining(&signature), tbs, tbslen);
+        rv = ssl_oqs_digest_verify(s, md_ctx, PACKET_data(&signature),
+                                   PACKET_remaining(&signature), tbs, tbslen);
         OPENSSL_free(tbs);
         if (rv <= 0) {
             SSLfatal(s, SSL_AD_DECRYPT_ERROR, SSL_F_TLS_PROCESS_KEY_EXCHANGE,
@@ -2495,10 +2679,10 @@ MSG_PROCESS_RETURN tls_process_certificate_request(SSL *s, PACKET *pkt)
             || !tls_parse_all_extensions(s, SSL_EXT_TLS1_3_CERTIFICATE_REQUEST,
                                          rawexts, NULL, 0, 1)) {
             /* SSLfatal() already called */
-            OPENSSL_free(rawexts);
+            tls_free_raw_extensions(s, rawexts);
             return MSG_PROCESS_ERROR;
         }
-        OPENSSL_free(rawexts);
+        tls_free_raw_extensions(s, rawexts);
         if (!tls1_process_sigalgs(s)) {
             SSLfatal(s, SSL_AD_INTERNAL_ERROR,
                      SSL_F_TLS_PROCESS_CERTIFICATE_REQUEST,
@@ -2749,14 +2933,14 @@ MSG_PROCESS_RETURN tls_process_new_session_ticket(SSL *s, PACKET *pkt)
         }
         s->session->master_key_length = hashlen;
 
-        OPENSSL_free(exts);
+        tls_free_raw_extensions(s, exts);
         ssl_update_cache(s, SSL_SESS_CACHE_CLIENT);
         return MSG_PROCESS_FINISHED_READING;
     }
 
     return MSG_PROCESS_CONTINUE_READING;
  err:
-    OPENSSL_free(exts);
+    tls_free_raw_extensions(s, exts);
     return MSG_PROCESS_ERROR;
 }
 
@@ -3081,7 +3265,7 @@ static int tls_construct_cke_dhe(SSL *s, WPACKET *pkt)
         goto err;
     }
 
-    ckey = ssl_generate_pkey(skey);
+    ckey = ssl_generate_pkey(s, skey);
     if (ckey == NULL) {
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS_CONSTRUCT_CKE_DHE,
                  ERR_R_INTERNAL_ERROR);
@@ -3139,7 +3323,7 @@ static int tls_construct_cke_ecdhe(SSL *s, WPACKET *pkt)
         return 0;
     }
 
-    ckey = ssl_generate_pkey(skey);
+    ckey = ssl_generate_pkey(s, skey);
     if (ckey == NULL) {
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS_CONSTRUCT_CKE_ECDHE,
                  ERR_R_MALLOC_FAILURE);
@@ -3713,11 +3897,11 @@ static MSG_PROCESS_RETURN tls_process_encrypted_extensions(SSL *s, PACKET *pkt)
         goto err;
     }
 
-    OPENSSL_free(rawexts);
+    tls_free_raw_extensions(s, rawexts);
     return MSG_PROCESS_CONTINUE_READING;
 
  err:
-    OPENSSL_free(rawexts);
+    tls_free_raw_extensions(s, rawexts);
     return MSG_PROCESS_ERROR;
 }
 
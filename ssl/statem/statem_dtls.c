@@ -20,29 +20,35 @@
 
 #define RSMBLY_BITMASK_SIZE(msg_len) (((msg_len) + 7) / 8)
 
-#define RSMBLY_BITMASK_MARK(bitmask, start, end) { \
-                        if ((end) - (start) <= 8) { \
-                                long ii; \
-                                for (ii = (start); ii < (end); ii++) bitmask[((ii) >> 3)] |= (1 << ((ii) & 7)); \
-                        } else { \
-                                long ii; \
-                                bitmask[((start) >> 3)] |= bitmask_start_values[((start) & 7)]; \
-                                for (ii = (((start) >> 3) + 1); ii < ((((end) - 1)) >> 3); ii++) bitmask[ii] = 0xff; \
-                                bitmask[(((end) - 1) >> 3)] |= bitmask_end_values[((end) & 7)]; \
-                        } }
-
-#define RSMBLY_BITMASK_IS_COMPLETE(bitmask, msg_len, is_complete) { \
-                        long ii; \
-                        is_complete = 1; \
-                        if (bitmask[(((msg_len) - 1) >> 3)] != bitmask_end_values[((msg_len) & 7)]) is_complete = 0; \
-                        if (is_complete) for (ii = (((msg_len) - 1) >> 3) - 1; ii >= 0 ; ii--) \
-                                if (bitmask[ii] != 0xff) { is_complete = 0; break; } }
-
 static unsigned char bitmask_start_values[] =
     { 0xff, 0xfe, 0xfc, 0xf8, 0xf0, 0xe0, 0xc0, 0x80 };
 static unsigned char bitmask_end_values[] =
     { 0xff, 0x01, 0x03, 0x07, 0x0f, 0x1f, 0x3f, 0x7f };
 
+/*
+ * Marks the bytes |start| to |end| (excluded) of a message as received in
+ * its reassembly |bitmask|, and returns how many of them were not already.
+ */
+static size_t dtls1_reassembly_mark(unsigned char *bitmask, size_t start,
+                                    size_t end)
+{
+    size_t i, last = (end - 1) >> 3, marked = 0;
+    unsigned char mask, bits;
+
+    for (i = start >> 3; i <= last; i++) {
+        mask = 0xff;
+        if (i == start >> 3)
+            mask &= bitmask_start_values[start & 7];
+        if (i == last)
+            mask &= bitmask_end_values[end & 7];
+        bits = mask & ~bitmask[i];
+        bitmask[i] |= bits;
+        for (; bits != 0; bits &= bits - 1)
+            marked++;
+    }
+    return marked;
+}
+
 static void dtls1_fix_message_header(SSL *s, size_t frag_off,
                                      size_t frag_len);
 static unsigned char *dtls1_write_message_header(SSL *s, unsigned char *p);
@@ -87,6 +93,7 @@ static hm_fragment *dtls1_hm_fragment_new(size_t frag_len, int reassembly)
     }
 
     frag->reassembly = bitmask;
+    frag->reassembly_left = frag_len;
 
     return frag;
 }
@@ -115,7 +122,7 @@ int dtls1_do_write(SSL *s, int type)
     size_t written;
     size_t curr_mtu;
     int retry = 1;
-    size_t len, frag_off, mac_size, blocksize, used_len;
+    size_t len, frag_off, mac_size, blocksize, cid_size, used_len;
 
     if (!dtls1_query_mtu(s))
         return -1;
@@ -146,6 +153,12 @@ int dtls1_do_write(SSL *s, int type)
     else
         blocksize = 0;
 
+    /* Records with a connection ID carry it and the real content type */
+    if (s->enc_write_ctx != NULL && DTLS_CID_SENDING(s))
+        cid_size = s->dtls_cid.peer_cid_len + 1;
+    else
+        cid_size = 0;
+
     frag_off = 0;
     s->rwstate = SSL_NOTHING;
 
@@ -185,8 +198,18 @@ int dtls1_do_write(SSL *s, int type)
             }
         }
 
+        /*
+         * A paced retransmission stops once its burst is used up. The caller
+         * resumes it from |w_msg_hdr.frag_off| at the next burst.
+         */
+        if (s->d1->retransmitting && s->d1->pacing_burst != 0
+                && s->d1->pacing_left == 0) {
+            s->d1->w_msg_hdr.frag_off = frag_off;
+            return 1;
+        }
+
         used_len = BIO_wpending(s->wbio) + DTLS1_RT_HEADER_LENGTH
-            + mac_size + blocksize;
+            + mac_size + blocksize + cid_size;
         if (s->d1->mtu > used_len)
             curr_mtu = s->d1->mtu - used_len;
         else
@@ -196,12 +219,14 @@ int dtls1_do_write(SSL *s, int type)
             /*
              * grr.. we could get an error if MTU picked was wrong
              */
+            ssl_rec_stats_add(s, SSL_REC_STAT_FLUSHES, 1);
             ret = BIO_flush(s->wbio);
             if (ret <= 0) {
                 s->rwstate = SSL_WRITING;
                 return ret;
             }
-            used_len = DTLS1_RT_HEADER_LENGTH + mac_size + blocksize;
+            used_len = DTLS1_RT_HEADER_LENGTH + mac_size + blocksize
+                + cid_size;
             if (s->d1->mtu > used_len + DTLS1_HM_HEADER_LENGTH) {
                 curr_mtu = s->d1->mtu - used_len;
             } else {
@@ -269,6 +294,10 @@ int dtls1_do_write(SSL *s, int type)
             if (!ossl_assert(len == written))
                 return -1;
 
+            if (s->d1->retransmitting)
+                s->d1->pacing_left -= written < s->d1->pacing_left
+                                      ? written : s->d1->pacing_left;
+
             if (type == SSL3_RT_HANDSHAKE && !s->d1->retransmitting) {
                 /*
                  * should not be done for 'Hello Request's, but in that case
@@ -532,7 +561,7 @@ dtls1_reassemble_fragment(SSL *s, const struct hm_header_st *msg_hdr)
 {
     hm_fragment *frag = NULL;
     pitem *item = NULL;
-    int i = -1, is_complete;
+    int i = -1;
     unsigned char seq64be[8];
     size_t frag_len = msg_hdr->frag_len;
     size_t readbytes;
@@ -597,15 +626,11 @@ dtls1_reassemble_fragment(SSL *s, const struct hm_header_st *msg_hdr)
     if (i <= 0)
         goto err;
 
-    RSMBLY_BITMASK_MARK(frag->reassembly, (long)msg_hdr->frag_off,
-                        (long)(msg_hdr->frag_off + frag_len));
+    frag->reassembly_left -=
+        dtls1_reassembly_mark(frag->reassembly, msg_hdr->frag_off,
+                              msg_hdr->frag_off + frag_len);
 
-    if (!ossl_assert(msg_hdr->msg_len > 0))
-        goto err;
-    RSMBLY_BITMASK_IS_COMPLETE(frag->reassembly, (long)msg_hdr->msg_len,
-                               is_complete);
-
-    if (is_complete) {
+    if (frag->reassembly_left == 0) {
         OPENSSL_free(frag->reassembly);
         frag->reassembly = NULL;
     }
@@ -617,15 +642,17 @@ dtls1_reassemble_fragment(SSL *s, const struct hm_header_st *msg_hdr)
             goto err;
         }
 
-        item = pqueue_insert(s->d1->buffered_messages, item);
         /*
-         * pqueue_insert fails iff a duplicate item is inserted. However,
          * |item| cannot be a duplicate. If it were, |pqueue_find|, above,
          * would have returned it and control would never have reached this
-         * branch.
+         * branch. So pqueue_insert can only fail to allocate.
          */
-        if (!ossl_assert(item != NULL))
+        if (pqueue_insert(s->d1->buffered_messages, item) == NULL) {
+            pitem_free(item);
+            item = NULL;
+            i = -1;
             goto err;
+        }
     }
 
     return DTLS1_HM_FRAGMENT_RETRY;
@@ -713,17 +740,19 @@ dtls1_process_out_of_seq_message(SSL *s, const struct hm_header_st *msg_hdr)
         if (item == NULL)
             goto err;
 
-        item = pqueue_insert(s->d1->buffered_messages, item);
         /*
-         * pqueue_insert fails iff a duplicate item is inserted. However,
          * |item| cannot be a duplicate. If it were, |pqueue_find|, above,
          * would have returned it. Then, either |frag_len| !=
          * |msg_hdr->msg_len| in which case |item| is set to NULL and it will
          * have been processed with |dtls1_reassemble_fragment|, above, or
-         * the record will have been discarded.
+         * the record will have been discarded. So pqueue_insert can only
+         * fail to allocate.
          */
-        if (!ossl_assert(item != NULL))
+        if (pqueue_insert(s->d1->buffered_messages, item) == NULL) {
+            pitem_free(item);
+            item = NULL;
             goto err;
+        }
     }
 
     return DTLS1_HM_FRAGMENT_RETRY;
@@ -1005,6 +1034,11 @@ int dtls1_get_queue_priority(unsigned short seq, int is_ccs)
     return seq * 2 - is_ccs;
 }
 
+/*
+ * Retransmits the flight in |sent_messages|. When pacing is enabled, only up
+ * to |pacing_burst| bytes of it are sent, starting where the previous burst
+ * stopped, and |pacing_pending| is left set if the flight isn't done.
+ */
 int dtls1_retransmit_buffered_messages(SSL *s)
 {
     pqueue *sent = s->d1->sent_messages;
@@ -1012,16 +1046,23 @@ int dtls1_retransmit_buffered_messages(SSL *s)
     pitem *item;
     hm_fragment *frag;
     int found = 0;
+    unsigned short prio;
+
+    s->d1->pacing_left = s->d1->pacing_burst;
 
     iter = pqueue_iterator(sent);
 
     for (item = pqueue_next(&iter); item != NULL; item = pqueue_next(&iter)) {
         frag = (hm_fragment *)item->data;
-        if (dtls1_retransmit_message(s, (unsigned short)
-                                     dtls1_get_queue_priority
-                                     (frag->msg_header.seq,
-                                      frag->msg_header.is_ccs), &found) <= 0)
+        prio = (unsigned short)dtls1_get_queue_priority(frag->msg_header.seq,
+                                                        frag->msg_header.is_ccs);
+        /* Skip what the previous burst already sent */
+        if (s->d1->pacing_pending && prio < s->d1->pacing_prio)
+            continue;
+        if (dtls1_retransmit_message(s, prio, &found) <= 0)
             return -1;
+        if (s->d1->pacing_pending)
+            return 1;
     }
 
     return 1;
@@ -1090,7 +1131,11 @@ int dtls1_buffer_message(SSL *s, int is_ccs)
         return 0;
     }
 
-    pqueue_insert(s->d1->sent_messages, item);
+    if (pqueue_insert(s->d1->sent_messages, item) == NULL) {
+        pitem_free(item);
+        dtls1_hm_fragment_free(frag);
+        return 0;
+    }
     return 1;
 }
 
@@ -1103,6 +1148,7 @@ int dtls1_retransmit_message(SSL *s, unsigned short seq, int *found)
     unsigned long header_length;
     unsigned char seq64be[8];
     struct dtls1_retransmit_state saved_state;
+    size_t resume_off = 0;
 
     /* XDTLS:  the requested message ought to be found, otherwise error */
     memset(seq64be, 0, sizeof(seq64be));
@@ -1134,6 +1180,20 @@ int dtls1_retransmit_message(SSL *s, unsigned short seq, int *found)
                                  frag->msg_header.seq, 0,
                                  frag->msg_header.frag_len);
 
+    if (s->d1->pacing_pending && seq == s->d1->pacing_prio) {
+        resume_off = s->d1->pacing_off;
+        s->d1->pacing_pending = 0;
+    }
+    if (resume_off > 0) {
+        /*
+         * Carry on with the fragment at |resume_off|, as dtls1_do_write()
+         * would after a retry: its header goes just before its data.
+         */
+        s->init_off = resume_off;
+        s->init_num -= resume_off;
+        s->d1->w_msg_hdr.frag_off = resume_off;
+    }
+
     /* save current state */
     saved_state.enc_write_ctx = s->enc_write_ctx;
     saved_state.write_hash = s->write_hash;
@@ -1164,6 +1224,15 @@ int dtls1_retransmit_message(SSL *s, unsigned short seq, int *found)
 
     s->d1->retransmitting = 0;
 
+    if (ret > 0 && s->init_num != 0) {
+        /* The burst ran out within this message */
+        s->d1->pacing_pending = 1;
+        s->d1->pacing_prio = seq;
+        s->d1->pacing_off = s->d1->w_msg_hdr.frag_off;
+        s->init_off = 0;
+        s->init_num = 0;
+    }
+
     (void)BIO_flush(s->wbio);
     return ret;
 }
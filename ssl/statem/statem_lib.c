@@ -88,7 +88,7 @@ int tls_close_construct_packet(SSL *s, WPACKET *pkt, int htype)
 
 int tls_setup_handshake(SSL *s)
 {
-    if (!ssl3_init_finished_mac(s)) {
+    if (!ssl3_init_handshake_mac(s)) {
         /* SSLfatal() already called */
         return 0;
     }
@@ -235,7 +235,7 @@ int tls_construct_cert_verify(SSL *s, WPACKET *pkt)
     EVP_PKEY_CTX *pctx = NULL;
     size_t hdatalen = 0, siglen = 0;
     void *hdata;
-    unsigned char *sig = NULL;
+    unsigned char *sig = NULL, *sig2 = NULL;
     unsigned char tls13tbs[TLS13_TBS_PREAMBLE_SIZE + EVP_MAX_MD_SIZE];
     const SIGALG_LOOKUP *lu = s->s3->tmp.sigalg;
 
@@ -270,11 +270,15 @@ int tls_construct_cert_verify(SSL *s, WPACKET *pkt)
                  ERR_R_INTERNAL_ERROR);
         goto err;
     }
+    /*
+     * The signature is written straight into the message: the maximum size
+     * is reserved and only the actual size is then allocated, which matters
+     * for post-quantum signatures of many kilobytes.
+     */
     siglen = EVP_PKEY_size(pkey);
-    sig = OPENSSL_malloc(siglen);
-    if (sig == NULL) {
+    if (!WPACKET_sub_reserve_bytes_u16(pkt, siglen, &sig)) {
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS_CONSTRUCT_CERT_VERIFY,
-                 ERR_R_MALLOC_FAILURE);
+                 ERR_R_INTERNAL_ERROR);
         goto err;
     }
 
@@ -304,7 +308,7 @@ int tls_construct_cert_verify(SSL *s, WPACKET *pkt)
                      ERR_R_EVP_LIB);
             goto err;
         }
-    } else if (EVP_DigestSign(mctx, sig, &siglen, hdata, hdatalen) <= 0) {
+    } else if (!ssl_oqs_digest_sign(s, mctx, sig, &siglen, hdata, hdatalen)) {
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS_CONSTRUCT_CERT_VERIFY,
                  ERR_R_EVP_LIB);
         goto err;
@@ -321,7 +325,8 @@ int tls_construct_cert_verify(SSL *s, WPACKET *pkt)
     }
 #endif
 
-    if (!WPACKET_sub_memcpy_u16(pkt, sig, siglen)) {
+    if (!WPACKET_sub_allocate_bytes_u16(pkt, siglen, &sig2)
+            || sig != sig2) {
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS_CONSTRUCT_CERT_VERIFY,
                  ERR_R_INTERNAL_ERROR);
         goto err;
@@ -333,11 +338,9 @@ int tls_construct_cert_verify(SSL *s, WPACKET *pkt)
         goto err;
     }
 
-    OPENSSL_free(sig);
     EVP_MD_CTX_free(mctx);
     return 1;
  err:
-    OPENSSL_free(sig);
     EVP_MD_CTX_free(mctx);
     return 0;
 }
@@ -499,7 +502,7 @@ MSG_PROCESS_RETURN tls_process_cert_verify(SSL *s, PACKET *pkt)
             goto err;
         }
     } else {
-        j = EVP_DigestVerify(mctx, data, len, hdata, hdatalen);
+        j = ssl_oqs_digest_verify(s, mctx, data, len, hdata, hdatalen);
         if (j <= 0) {
             SSLfatal(s, SSL_AD_DECRYPT_ERROR, SSL_F_TLS_PROCESS_CERT_VERIFY,
                      SSL_R_BAD_SIGNATURE);
@@ -617,6 +620,7 @@ int tls_construct_key_update(SSL *s, WPACKET *pkt)
     }
 
     s->key_update = SSL_KEY_UPDATE_NONE;
+    ssl_rec_stats_add(s, SSL_REC_STAT_KEY_UPDATES_OUT, 1);
     return 1;
 }
 
@@ -664,6 +668,7 @@ MSG_PROCESS_RETURN tls_process_key_update(SSL *s, PACKET *pkt)
         /* SSLfatal() already called */
         return MSG_PROCESS_ERROR;
     }
+    ssl_rec_stats_add(s, SSL_REC_STAT_KEY_UPDATES_IN, 1);
 
     return MSG_PROCESS_FINISHED_READING;
 }
@@ -878,8 +883,90 @@ int tls_construct_change_cipher_spec(SSL *s, WPACKET *pkt)
     return 1;
 }
 
+/*
+ * The encoded certificate_list entries of a chain, without the TLSv1.3
+ * per-certificate extensions, so that the chain need not be built and
+ * encoded again for every handshake. If the chain was built automatically,
+ * |store| is the store it was built from and |store_objs| the number of
+ * objects the store held then.
+ */
+struct ssl_cert_msg_st {
+    /* The certificates in the chain, end-entity first */
+    STACK_OF(X509) *certs;
+    X509_STORE *store;
+    int store_objs;
+    unsigned char *der;
+    /* Offset of each entry in |der|, and the total length at the end */
+    size_t *offs;
+    CRYPTO_REF_COUNT references;
+    CRYPTO_RWLOCK *lock;
+};
+
+void ssl_cert_msg_free(SSL_CERT_MSG *cm)
+{
+    int i;
+
+    if (cm == NULL)
+        return;
+
+    CRYPTO_DOWN_REF(&cm->references, &i, cm->lock);
+    REF_ASSERT_ISNT(i < 0);
+    if (i > 0)
+        return;
+
+    sk_X509_pop_free(cm->certs, X509_free);
+    X509_STORE_free(cm->store);
+    OPENSSL_free(cm->der);
+    OPENSSL_free(cm->offs);
+    CRYPTO_THREAD_lock_free(cm->lock);
+    OPENSSL_free(cm);
+}
+
+/* Bytes held by |cm| for the encoded chain, its certificates not included */
+size_t ssl_cert_msg_mem_size(const SSL_CERT_MSG *cm)
+{
+    int num;
+
+    if (cm == NULL)
+        return 0;
+    num = sk_X509_num(cm->certs);
+    return sizeof(*cm) + sizeof(*cm->offs) * (num + 1) + cm->offs[num];
+}
+
+static int cert_store_objects(X509_STORE *store)
+{
+    int num;
+
+    if (store == NULL)
+        return 0;
+    X509_STORE_lock(store);
+    num = sk_X509_OBJECT_num(X509_STORE_get0_objects(store));
+    X509_STORE_unlock(store);
+    return num;
+}
+
+/* Whether |cm| is the chain of |x| with |extra_certs| or |store| */
+static int cert_msg_matches(const SSL_CERT_MSG *cm, X509 *x,
+                            STACK_OF(X509) *extra_certs, X509_STORE *store,
+                            int store_objs)
+{
+    int i, num = extra_certs != NULL ? sk_X509_num(extra_certs) : 0;
+
+    if (cm == NULL || sk_X509_value(cm->certs, 0) != x || cm->store != store)
+        return 0;
+    if (store != NULL)
+        return cm->store_objs == store_objs;
+    if (sk_X509_num(cm->certs) != num + 1)
+        return 0;
+    for (i = 0; i < num; i++) {
+        if (sk_X509_value(cm->certs, i + 1) != sk_X509_value(extra_certs, i))
+            return 0;
+    }
+    return 1;
+}
+
 /* Add a certificate to the WPACKET */
-static int ssl_add_cert_to_wpacket(SSL *s, WPACKET *pkt, X509 *x, int chain)
+static int ssl_add_cert_to_wpacket(SSL *s, WPACKET *pkt, X509 *x)
 {
     int len;
     unsigned char *outbytes;
@@ -897,58 +984,44 @@ static int ssl_add_cert_to_wpacket(SSL *s, WPACKET *pkt, X509 *x, int chain)
         return 0;
     }
 
-    if (SSL_IS_TLS13(s)
-            && !tls_construct_extensions(s, pkt, SSL_EXT_TLS1_3_CERTIFICATE, x,
-                                         chain)) {
-        /* SSLfatal() already called */
-        return 0;
-    }
-
     return 1;
 }
 
-/* Add certificate chain to provided WPACKET */
-static int ssl_add_cert_chain(SSL *s, WPACKET *pkt, CERT_PKEY *cpk)
+/*
+ * Build the chain of |x|, from |store| if it is not NULL and otherwise from
+ * |extra_certs|, and encode it.
+ */
+static SSL_CERT_MSG *ssl_cert_msg_new(SSL *s, X509 *x,
+                                      STACK_OF(X509) *extra_certs,
+                                      X509_STORE *store)
 {
-    int i, chain_count;
-    X509 *x;
-    STACK_OF(X509) *extra_certs;
-    STACK_OF(X509) *chain = NULL;
-    X509_STORE *chain_store;
-
-    if (cpk == NULL || cpk->x509 == NULL)
-        return 1;
-
-    x = cpk->x509;
-
-    /*
-     * If we have a certificate specific chain use it, else use parent ctx.
-     */
-    if (cpk->chain != NULL)
-        extra_certs = cpk->chain;
-    else
-        extra_certs = s->ctx->extra_certs;
-
-    if ((s->mode & SSL_MODE_NO_AUTO_CHAIN) || extra_certs)
-        chain_store = NULL;
-    else if (s->cert->chain_store)
-        chain_store = s->cert->chain_store;
-    else
-        chain_store = s->ctx->cert_store;
+    SSL_CERT_MSG *cm;
+    WPACKET pkt;
+    size_t len = 0;
+    int i, num, der_len;
+
+    if ((cm = OPENSSL_zalloc(sizeof(*cm))) == NULL
+            || (cm->lock = CRYPTO_THREAD_lock_new()) == NULL) {
+        OPENSSL_free(cm);
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_CERT_MSG_NEW,
+                 ERR_R_MALLOC_FAILURE);
+        return NULL;
+    }
+    cm->references = 1;
 
-    if (chain_store != NULL) {
+    if (store != NULL) {
         X509_STORE_CTX *xs_ctx = X509_STORE_CTX_new();
 
         if (xs_ctx == NULL) {
-            SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_ADD_CERT_CHAIN,
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_CERT_MSG_NEW,
                      ERR_R_MALLOC_FAILURE);
-            return 0;
+            goto err;
         }
-        if (!X509_STORE_CTX_init(xs_ctx, chain_store, x, NULL)) {
+        if (!X509_STORE_CTX_init(xs_ctx, store, x, NULL)) {
             X509_STORE_CTX_free(xs_ctx);
-            SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_ADD_CERT_CHAIN,
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_CERT_MSG_NEW,
                      ERR_R_X509_LIB);
-            return 0;
+            goto err;
         }
         /*
          * It is valid for the chain not to be complete (because normally we
@@ -959,49 +1032,186 @@ static int ssl_add_cert_chain(SSL *s, WPACKET *pkt, CERT_PKEY *cpk)
         (void)X509_verify_cert(xs_ctx);
         /* Don't leave errors in the queue */
         ERR_clear_error();
-        chain = X509_STORE_CTX_get0_chain(xs_ctx);
-        i = ssl_security_cert_chain(s, chain, NULL, 0);
-        if (i != 1) {
-#if 0
-            /* Dummy error calls so mkerr generates them */
-            SSLerr(SSL_F_SSL_ADD_CERT_CHAIN, SSL_R_EE_KEY_TOO_SMALL);
-            SSLerr(SSL_F_SSL_ADD_CERT_CHAIN, SSL_R_CA_KEY_TOO_SMALL);
-            SSLerr(SSL_F_SSL_ADD_CERT_CHAIN, SSL_R_CA_MD_TOO_WEAK);
-#endif
-            X509_STORE_CTX_free(xs_ctx);
-            SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_ADD_CERT_CHAIN, i);
-            return 0;
+        cm->certs = X509_chain_up_ref(X509_STORE_CTX_get0_chain(xs_ctx));
+        X509_STORE_CTX_free(xs_ctx);
+        X509_STORE_up_ref(store);
+        cm->store = store;
+        /* Counted after building, which may have looked up more of them */
+        cm->store_objs = cert_store_objects(store);
+    } else {
+        cm->certs = extra_certs != NULL ? X509_chain_up_ref(extra_certs)
+                                        : sk_X509_new_null();
+        if (cm->certs != NULL) {
+            if (!sk_X509_insert(cm->certs, x, 0)) {
+                sk_X509_pop_free(cm->certs, X509_free);
+                cm->certs = NULL;
+            } else {
+                X509_up_ref(x);
+            }
         }
-        chain_count = sk_X509_num(chain);
-        for (i = 0; i < chain_count; i++) {
-            x = sk_X509_value(chain, i);
+    }
+    if (cm->certs == NULL || sk_X509_num(cm->certs) == 0) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_CERT_MSG_NEW,
+                 ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
 
-            if (!ssl_add_cert_to_wpacket(s, pkt, x, i)) {
-                /* SSLfatal() already called */
-                X509_STORE_CTX_free(xs_ctx);
-                return 0;
-            }
+    num = sk_X509_num(cm->certs);
+    for (i = 0; i < num; i++) {
+        der_len = i2d_X509(sk_X509_value(cm->certs, i), NULL);
+        if (der_len < 0) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_CERT_MSG_NEW,
+                     ERR_R_BUF_LIB);
+            goto err;
         }
-        X509_STORE_CTX_free(xs_ctx);
-    } else {
-        i = ssl_security_cert_chain(s, extra_certs, x, 0);
-        if (i != 1) {
-            SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_ADD_CERT_CHAIN, i);
-            return 0;
+        len += 3 + der_len;
+    }
+    if ((cm->der = OPENSSL_malloc(len)) == NULL
+            || (cm->offs = OPENSSL_malloc((num + 1) * sizeof(*cm->offs)))
+               == NULL) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_CERT_MSG_NEW,
+                 ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+    if (!WPACKET_init_static_len(&pkt, cm->der, len, 0)) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_CERT_MSG_NEW,
+                 ERR_R_INTERNAL_ERROR);
+        goto err;
+    }
+    for (i = 0; i < num; i++) {
+        if (!WPACKET_get_total_written(&pkt, &cm->offs[i])) {
+            WPACKET_cleanup(&pkt);
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_CERT_MSG_NEW,
+                     ERR_R_INTERNAL_ERROR);
+            goto err;
         }
-        if (!ssl_add_cert_to_wpacket(s, pkt, x, 0)) {
+        if (!ssl_add_cert_to_wpacket(s, &pkt, sk_X509_value(cm->certs, i))) {
             /* SSLfatal() already called */
-            return 0;
+            WPACKET_cleanup(&pkt);
+            goto err;
         }
-        for (i = 0; i < sk_X509_num(extra_certs); i++) {
-            x = sk_X509_value(extra_certs, i);
-            if (!ssl_add_cert_to_wpacket(s, pkt, x, i + 1)) {
-                /* SSLfatal() already called */
-                return 0;
-            }
+    }
+    cm->offs[num] = len;
+    if (!WPACKET_finish(&pkt)) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_CERT_MSG_NEW,
+                 ERR_R_INTERNAL_ERROR);
+        goto err;
+    }
+
+    return cm;
+ err:
+    ssl_cert_msg_free(cm);
+    return NULL;
+}
+
+/*
+ * Get the encoded chain of |cpk|: the one last sent for it if the chain is
+ * still the same, or else a new one, kept in the SSL_CTX for the next
+ * handshakes.
+ */
+static SSL_CERT_MSG *ssl_get_cert_msg(SSL *s, CERT_PKEY *cpk)
+{
+    SSL_CTX *ctx = s->ctx;
+    size_t idx = cpk - s->cert->pkeys;
+    STACK_OF(X509) *extra_certs;
+    X509_STORE *chain_store;
+    SSL_CERT_MSG *cm, *old;
+    int store_objs, i;
+
+    /*
+     * If we have a certificate specific chain use it, else use parent ctx.
+     */
+    if (cpk->chain != NULL)
+        extra_certs = cpk->chain;
+    else
+        extra_certs = ctx->extra_certs;
+
+    if ((s->mode & SSL_MODE_NO_AUTO_CHAIN) || extra_certs)
+        chain_store = NULL;
+    else if (s->cert->chain_store)
+        chain_store = s->cert->chain_store;
+    else
+        chain_store = ctx->cert_store;
+    store_objs = cert_store_objects(chain_store);
+
+    CRYPTO_THREAD_read_lock(ctx->lock);
+    cm = ctx->cert_msgs[idx];
+    if (cert_msg_matches(cm, cpk->x509, extra_certs, chain_store, store_objs))
+        CRYPTO_UP_REF(&cm->references, &i, cm->lock);
+    else
+        cm = NULL;
+    CRYPTO_THREAD_unlock(ctx->lock);
+    if (cm != NULL)
+        return cm;
+
+    if ((cm = ssl_cert_msg_new(s, cpk->x509, extra_certs,
+                               chain_store)) == NULL) {
+        /* SSLfatal() already called */
+        return NULL;
+    }
+    CRYPTO_UP_REF(&cm->references, &i, cm->lock);
+    CRYPTO_THREAD_write_lock(ctx->lock);
+    old = ctx->cert_msgs[idx];
+    ctx->cert_msgs[idx] = cm;
+    CRYPTO_THREAD_unlock(ctx->lock);
+    ssl_cert_msg_free(old);
+    return cm;
+}
+
+/* Add certificate chain to provided WPACKET */
+static int ssl_add_cert_chain(SSL *s, WPACKET *pkt, CERT_PKEY *cpk)
+{
+    SSL_CERT_MSG *cm;
+    int i, num, ret = 0;
+
+    if (cpk == NULL || cpk->x509 == NULL)
+        return 1;
+
+    if ((cm = ssl_get_cert_msg(s, cpk)) == NULL) {
+        /* SSLfatal() already called */
+        return 0;
+    }
+
+    /* The security level may differ between connections sharing a chain */
+    i = ssl_security_cert_chain(s, cm->certs, NULL, 0);
+    if (i != 1) {
+#if 0
+        /* Dummy error calls so mkerr generates them */
+        SSLerr(SSL_F_SSL_ADD_CERT_CHAIN, SSL_R_EE_KEY_TOO_SMALL);
+        SSLerr(SSL_F_SSL_ADD_CERT_CHAIN, SSL_R_CA_KEY_TOO_SMALL);
+        SSLerr(SSL_F_SSL_ADD_CERT_CHAIN, SSL_R_CA_MD_TOO_WEAK);
+#endif
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_ADD_CERT_CHAIN, i);
+        goto end;
+    }
+
+    num = sk_X509_num(cm->certs);
+    if (!SSL_IS_TLS13(s)) {
+        if (!WPACKET_memcpy(pkt, cm->der, cm->offs[num])) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_ADD_CERT_CHAIN,
+                     ERR_R_INTERNAL_ERROR);
+            goto end;
         }
     }
-    return 1;
+
+    /* In TLSv1.3 each entry is followed by its extensions */
+    for (i = 0; SSL_IS_TLS13(s) && i < num; i++) {
+        if (!WPACKET_memcpy(pkt, cm->der + cm->offs[i],
+                            cm->offs[i + 1] - cm->offs[i])) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_SSL_ADD_CERT_CHAIN,
+                     ERR_R_INTERNAL_ERROR);
+            goto end;
+        }
+        if (!tls_construct_extensions(s, pkt, SSL_EXT_TLS1_3_CERTIFICATE,
+                                      sk_X509_value(cm->certs, i), i)) {
+            /* SSLfatal() already called */
+            goto end;
+        }
+    }
+    ret = 1;
+ end:
+    ssl_cert_msg_free(cm);
+    return ret;
 }
 
 unsigned long ssl3_output_cert_chain(SSL *s, WPACKET *pkt, CERT_PKEY *cpk)
@@ -1024,6 +1234,107 @@ unsigned long ssl3_output_cert_chain(SSL *s, WPACKET *pkt, CERT_PKEY *cpk)
     return 1;
 }
 
+/*
+ * An upper bound of the length of a Certificate message body for |cpk|,
+ * from the chain last encoded for it, or 0 if there is none yet
+ */
+size_t tls_cert_msg_size_hint(SSL *s, CERT_PKEY *cpk)
+{
+    SSL_CERT_MSG *cm;
+    size_t len = 0;
+    int num;
+
+    if (cpk == NULL || cpk->x509 == NULL)
+        return 0;
+
+    CRYPTO_THREAD_read_lock(s->ctx->lock);
+    cm = s->ctx->cert_msgs[cpk - s->cert->pkeys];
+    if (cm != NULL && sk_X509_value(cm->certs, 0) == cpk->x509) {
+        num = sk_X509_num(cm->certs);
+        /* context and list lengths, and TLSv1.3 extensions of each entry */
+        len = 4 + cm->offs[num] + 2 * num
+              + s->ext.ocsp.resp_len + 8;
+    }
+    CRYPTO_THREAD_unlock(s->ctx->lock);
+    return len;
+}
+
+/* An upper bound of the length of a CertificateVerify message body */
+size_t tls_cert_verify_size_hint(SSL *s)
+{
+    int len;
+
+    if (s->s3->tmp.cert == NULL || s->s3->tmp.cert->privatekey == NULL
+            || (len = EVP_PKEY_size(s->s3->tmp.cert->privatekey)) <= 0)
+        return 0;
+    /* signature algorithm and signature length */
+    return 4 + (size_t)len;
+}
+
+/*
+ * Frees what was only needed to negotiate the connection, for
+ * SSL_MODE_RELEASE_HANDSHAKE_STATE. A TLSv1.3 post-handshake authentication
+ * restores its transcript from |pha_dgst| and a renegotiation starts over.
+ */
+static void ssl_release_handshake_state(SSL *s)
+{
+    int pha_possible = s->server
+        ? s->post_handshake_auth == SSL_PHA_EXT_RECEIVED
+          || s->post_handshake_auth == SSL_PHA_REQUEST_PENDING
+        : s->post_handshake_auth == SSL_PHA_EXT_SENT;
+
+    /* A server that sent a CertificateRequest still hashes the response */
+    if (!s->server || s->post_handshake_auth != SSL_PHA_REQUESTED)
+        ssl3_free_digest_list(s);
+    if (!pha_possible) {
+        EVP_MD_CTX_free(s->pha_dgst);
+        s->pha_dgst = NULL;
+    }
+    ssl3_free_oqs_kem_tmp(s);
+#if !defined(OPENSSL_NO_EC) || !defined(OPENSSL_NO_DH)
+    EVP_PKEY_free(s->s3->tmp.pkey);
+    s->s3->tmp.pkey = NULL;
+#endif
+    OPENSSL_clear_free(s->s3->tmp.pms, s->s3->tmp.pmslen);
+    s->s3->tmp.pms = NULL;
+    s->s3->tmp.pmslen = 0;
+    OPENSSL_free(s->s3->tmp.ctype);
+    s->s3->tmp.ctype = NULL;
+    s->s3->tmp.ctype_len = 0;
+    sk_X509_NAME_pop_free(s->s3->tmp.peer_ca_names, X509_NAME_free);
+    s->s3->tmp.peer_ca_names = NULL;
+    OPENSSL_free(s->s3->tmp.ciphers_raw);
+    s->s3->tmp.ciphers_raw = NULL;
+    s->s3->tmp.ciphers_rawlen = 0;
+    OPENSSL_free(s->s3->tmp.peer_sigalgs);
+    s->s3->tmp.peer_sigalgs = NULL;
+    s->s3->tmp.peer_sigalgslen = 0;
+    OPENSSL_free(s->s3->tmp.peer_cert_sigalgs);
+    s->s3->tmp.peer_cert_sigalgs = NULL;
+    s->s3->tmp.peer_cert_sigalgslen = 0;
+    OPENSSL_free(s->shared_sigalgs);
+    s->shared_sigalgs = NULL;
+    s->shared_sigalgslen = 0;
+    OPENSSL_free(s->s3->alpn_proposed);
+    s->s3->alpn_proposed = NULL;
+    s->s3->alpn_proposed_len = 0;
+    sk_SSL_CIPHER_free(s->peer_ciphers);
+    s->peer_ciphers = NULL;
+    OPENSSL_free(s->ext.peer_supportedgroups);
+    s->ext.peer_supportedgroups = NULL;
+    s->ext.peer_supportedgroups_len = 0;
+#ifndef OPENSSL_NO_EC
+    OPENSSL_free(s->ext.peer_ecpointformats);
+    s->ext.peer_ecpointformats = NULL;
+    s->ext.peer_ecpointformats_len = 0;
+#endif
+    if (!s->ext.raw_exts_inuse) {
+        OPENSSL_free(s->ext.raw_exts);
+        s->ext.raw_exts = NULL;
+        s->ext.raw_exts_len = 0;
+    }
+}
+
 /*
  * Tidy up after the end of a handshake. In the case of SCTP this may result
  * in NBIO events. If |clearbufs| is set then init_buf and the wbio buffer is
@@ -1066,6 +1377,9 @@ WORK_STATE tls_finish_handshake(SSL *s, WORK_STATE wst, int clearbufs, int stop)
             && s->post_handshake_auth == SSL_PHA_REQUESTED)
         s->post_handshake_auth = SSL_PHA_EXT_SENT;
 
+    if (clearbufs && (s->mode & SSL_MODE_RELEASE_HANDSHAKE_STATE) != 0)
+        ssl_release_handshake_state(s);
+
     /*
      * Only set if there was a Finished message and this isn't after a TLSv1.3
      * post handshake exchange
@@ -1078,6 +1392,10 @@ WORK_STATE tls_finish_handshake(SSL *s, WORK_STATE wst, int clearbufs, int stop)
         s->ext.ticket_expected = 0;
 
         ssl3_cleanup_key_block(s);
+        ssl_hs_stats_end(s);
+#ifndef OPENSSL_NO_METRICS
+        tls1_handshake_metrics(s);
+#endif
 
         if (s->server) {
             /*
@@ -1106,8 +1424,10 @@ WORK_STATE tls_finish_handshake(SSL *s, WORK_STATE wst, int clearbufs, int stop)
                  */
                 ssl_update_cache(s, SSL_SESS_CACHE_CLIENT);
             }
-            if (s->hit)
+            if (s->hit) {
                 tsan_counter(&s->session_ctx->stats.sess_hit);
+                OSSL_METRIC_INC(OSSL_METRIC_SSL_SESS_HITS);
+            }
 
             s->handshake_func = ossl_statem_connect;
             tsan_counter(&s->session_ctx->stats.sess_connect_good);
@@ -1257,6 +1577,46 @@ int tls_get_message_header(SSL *s, int *mt)
     return 1;
 }
 
+/*
+ * A TLSv1.3 post-handshake message, such as a NewSessionTicket or a
+ * KeyUpdate, whose body the current record holds in full is parsed where it
+ * is in the read buffer, so that init_buf isn't grown to the size of the
+ * message on long-lived connections. Returns 1 if s->init_msg now points at
+ * the whole body, and 0 if it has to be read into init_buf.
+ */
+int tls_get_message_in_record(SSL *s)
+{
+    const unsigned char *body;
+
+    /* The message callback is given the header and the body together */
+    if (!SSL_IS_TLS13(s) || SSL_IS_FIRST_HANDSHAKE(s)
+            || s->msg_callback != NULL
+            || s->s3->tmp.message_type == SSL3_MT_CHANGE_CIPHER_SPEC
+            || s->init_num != 0
+            || !RECORD_LAYER_get_handshake_data(&s->rlayer,
+                                                s->s3->tmp.message_size,
+                                                &body))
+        return 0;
+
+    s->init_msg = (unsigned char *)body;
+    s->init_num = s->s3->tmp.message_size;
+    return 1;
+}
+
+/*
+ * Feeds the current message into the handshake hash. Its body doesn't follow
+ * its header in init_buf if tls_get_message_in_record() found it.
+ */
+static int finish_mac_message(SSL *s)
+{
+    unsigned char *hdr = (unsigned char *)s->init_buf->data;
+
+    if (s->init_msg == hdr + SSL3_HM_HEADER_LENGTH)
+        return ssl3_finish_mac(s, hdr, s->init_num + SSL3_HM_HEADER_LENGTH);
+    return ssl3_finish_mac(s, hdr, SSL3_HM_HEADER_LENGTH)
+           && ssl3_finish_mac(s, s->init_msg, s->init_num);
+}
+
 int tls_get_message_body(SSL *s, size_t *len)
 {
     size_t n, readbytes;
@@ -1320,8 +1680,7 @@ int tls_get_message_body(SSL *s, size_t *len)
                     || memcmp(hrrrandom,
                               s->init_buf->data + SERVER_HELLO_RANDOM_OFFSET,
                               SSL3_RANDOM_SIZE) != 0) {
-                if (!ssl3_finish_mac(s, (unsigned char *)s->init_buf->data,
-                                     s->init_num + SSL3_HM_HEADER_LENGTH)) {
+                if (!finish_mac_message(s)) {
                     /* SSLfatal() already called */
                     *len = 0;
                     return 0;
@@ -2328,8 +2687,59 @@ const STACK_OF(X509_NAME) *get_ca_names(SSL *s)
     return ca_sk;
 }
 
+/*
+ * Encode the names in |ca_sk| as the body of a certificate_authorities list,
+ * leaving out the names that would take it beyond |max| bytes unless |max|
+ * is 0.
+ */
+static int encode_ca_names(const STACK_OF(X509_NAME) *ca_sk, size_t max,
+                           unsigned char **pder, size_t *plen)
+{
+    unsigned char *der, *p;
+    size_t len = 0;
+    int i, n, namelen;
+
+    for (n = 0; n < sk_X509_NAME_num(ca_sk); n++) {
+        X509_NAME *name = sk_X509_NAME_value(ca_sk, n);
+
+        if (name == NULL || (namelen = i2d_X509_NAME(name, NULL)) < 0
+                || namelen > 0xffff)
+            return 0;
+        if (max != 0 && len + 2 + namelen > max)
+            break;
+        len += 2 + namelen;
+    }
+
+    if ((der = OPENSSL_malloc(len > 0 ? len : 1)) == NULL)
+        return 0;
+    for (i = 0, p = der; i < n; i++) {
+        X509_NAME *name = sk_X509_NAME_value(ca_sk, i);
+
+        namelen = i2d_X509_NAME(name, NULL);
+        s2n(namelen, p);
+        if (i2d_X509_NAME(name, &p) != namelen) {
+            OPENSSL_free(der);
+            return 0;
+        }
+    }
+
+    *pder = der;
+    *plen = len;
+    return 1;
+}
+
+/*
+ * The CA lists of the SSL_CTX are encoded once and the encoding is kept
+ * until the list is replaced or names are added to it.
+ */
 int construct_ca_names(SSL *s, const STACK_OF(X509_NAME) *ca_sk, WPACKET *pkt)
 {
+    SSL_CTX *ctx = s->ctx;
+    SSL_CA_NAMES_ENC *enc = NULL;
+    unsigned char *der = NULL;
+    size_t len = 0;
+    int cached = 0;
+
     /* Start sub-packet for client CA list */
     if (!WPACKET_start_sub_packet_u16(pkt)) {
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_CONSTRUCT_CA_NAMES,
@@ -2337,24 +2747,44 @@ int construct_ca_names(SSL *s, const STACK_OF(X509_NAME) *ca_sk, WPACKET *pkt)
         return 0;
     }
 
-    if (ca_sk != NULL) {
-        int i;
+    if (ca_sk != NULL && ca_sk == ctx->client_ca_names)
+        enc = &ctx->ca_names_enc[0];
+    else if (ca_sk != NULL && ca_sk == ctx->ca_names)
+        enc = &ctx->ca_names_enc[1];
 
-        for (i = 0; i < sk_X509_NAME_num(ca_sk); i++) {
-            unsigned char *namebytes;
-            X509_NAME *name = sk_X509_NAME_value(ca_sk, i);
-            int namelen;
-
-            if (name == NULL
-                    || (namelen = i2d_X509_NAME(name, NULL)) < 0
-                    || !WPACKET_sub_allocate_bytes_u16(pkt, namelen,
-                                                       &namebytes)
-                    || i2d_X509_NAME(name, &namebytes) != namelen) {
+    if (enc != NULL) {
+        CRYPTO_THREAD_read_lock(ctx->lock);
+        if (enc->names == ca_sk && enc->num == sk_X509_NAME_num(ca_sk)) {
+            cached = 1;
+            if (!WPACKET_memcpy(pkt, enc->der, enc->len)) {
+                CRYPTO_THREAD_unlock(ctx->lock);
                 SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_CONSTRUCT_CA_NAMES,
                          ERR_R_INTERNAL_ERROR);
                 return 0;
             }
         }
+        CRYPTO_THREAD_unlock(ctx->lock);
+    }
+
+    if (!cached && ca_sk != NULL) {
+        if (!encode_ca_names(ca_sk, ctx->max_ca_names_len, &der, &len)
+                || !WPACKET_memcpy(pkt, der, len)) {
+            OPENSSL_free(der);
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_CONSTRUCT_CA_NAMES,
+                     ERR_R_INTERNAL_ERROR);
+            return 0;
+        }
+        if (enc != NULL) {
+            CRYPTO_THREAD_write_lock(ctx->lock);
+            ssl_ca_names_enc_clear(enc);
+            enc->names = ca_sk;
+            enc->num = sk_X509_NAME_num(ca_sk);
+            enc->der = der;
+            enc->len = len;
+            der = NULL;
+            CRYPTO_THREAD_unlock(ctx->lock);
+        }
+        OPENSSL_free(der);
     }
 
     if (!WPACKET_close(pkt)) {
@@ -2430,6 +2860,14 @@ int tls13_restore_handshake_digest_for_pha(SSL *s)
                  ERR_R_INTERNAL_ERROR);
         return 0;
     }
+    /* Freed after the handshake with SSL_MODE_RELEASE_HANDSHAKE_STATE */
+    if (s->s3->handshake_dgst == NULL
+            && (s->s3->handshake_dgst = EVP_MD_CTX_new()) == NULL) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR,
+                 SSL_F_TLS13_RESTORE_HANDSHAKE_DIGEST_FOR_PHA,
+                 ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
     if (!EVP_MD_CTX_copy_ex(s->s3->handshake_dgst,
                             s->pha_dgst)) {
         SSLfatal(s, SSL_AD_INTERNAL_ERROR,
@@ -510,7 +510,12 @@ static WRITE_TRAN ossl_statem_server13_write_transition(SSL *s)
             st->hand_state = TLS_ST_OK;
             return WRITE_TRAN_CONTINUE;
         }
-        if (s->num_tickets > s->sent_tickets)
+        /*
+         * A client that sent no psk_key_exchange_modes can never resume, so
+         * it gets no tickets (RFC 8446, 4.2.9)
+         */
+        if (s->num_tickets > s->sent_tickets
+                && s->ext.psk_kex_mode != TLSEXT_KEX_MODE_FLAG_NONE)
             st->hand_state = TLS_ST_SW_SESSION_TICKET;
         else
             st->hand_state = TLS_ST_OK;
@@ -1053,6 +1058,18 @@ int ossl_statem_server_construct_message(SSL *s, WPACKET *pkt,
         break;
 
     case TLS_ST_SW_CERT:
+        if (SSL_IS_TLS13(s) && s->ext.cached_info == SSL_CACHED_INFO_USED) {
+            *confunc = tls_construct_server_cached_certificate;
+            *mt = SSL3_MT_CERTIFICATE;
+            break;
+        }
+#ifndef OPENSSL_NO_COMP
+        if (SSL_IS_TLS13(s) && s->ext.cert_comp != TLSEXT_comp_cert_none) {
+            *confunc = tls_construct_server_compressed_certificate;
+            *mt = SSL3_MT_COMPRESSED_CERTIFICATE;
+            break;
+        }
+#endif
         *confunc = tls_construct_server_certificate;
         *mt = SSL3_MT_CERTIFICATE;
         break;
@@ -1112,6 +1129,31 @@ int ossl_statem_server_construct_message(SSL *s, WPACKET *pkt,
     return 1;
 }
 
+/* Room for a ServerHello apart from its key share */
+#define SERVER_HELLO_BASE_SIZE      256
+
+/*
+ * Returns an upper bound of the length of the body of message |mt| that is
+ * about to be constructed, or 0 if it is unknown or small. See
+ * ossl_statem_client_message_size_hint().
+ */
+size_t ossl_statem_server_message_size_hint(SSL *s, int mt)
+{
+    switch (mt) {
+    case SSL3_MT_SERVER_HELLO:
+        return SERVER_HELLO_BASE_SIZE
+               + (SSL_IS_TLS13(s) ? tls1_key_share_size(s->s3->group_id, 1)
+                                  : 0);
+
+    case SSL3_MT_CERTIFICATE:
+        return tls_cert_msg_size_hint(s, s->s3->tmp.cert);
+
+    case SSL3_MT_CERTIFICATE_VERIFY:
+        return tls_cert_verify_size_hint(s);
+    }
+    return 0;
+}
+
 /*
  * Maximum size (excluding the Handshake header) of a ClientHello message,
  * calculated as follows:
@@ -1607,7 +1649,7 @@ MSG_PROCESS_RETURN tls_process_client_hello(SSL *s, PACKET *pkt)
 
  err:
     if (clienthello != NULL)
-        OPENSSL_free(clienthello->pre_proc_exts);
+        tls_free_raw_extensions(s, clienthello->pre_proc_exts);
     OPENSSL_free(clienthello);
 
     return MSG_PROCESS_ERROR;
@@ -2100,14 +2142,14 @@ static int tls_early_post_process_client_hello(SSL *s)
 
     sk_SSL_CIPHER_free(ciphers);
     sk_SSL_CIPHER_free(scsvs);
-    OPENSSL_free(clienthello->pre_proc_exts);
+    tls_free_raw_extensions(s, clienthello->pre_proc_exts);
     OPENSSL_free(s->clienthello);
     s->clienthello = NULL;
     return 1;
  err:
     sk_SSL_CIPHER_free(ciphers);
     sk_SSL_CIPHER_free(scsvs);
-    OPENSSL_free(clienthello->pre_proc_exts);
+    tls_free_raw_extensions(s, clienthello->pre_proc_exts);
     OPENSSL_free(s->clienthello);
     s->clienthello = NULL;
 
@@ -2160,6 +2202,16 @@ static int tls_handle_status_request(SSL *s)
             }
         }
     }
+#ifndef OPENSSL_NO_OCSP
+    else if (s->ext.status_type == TLSEXT_STATUSTYPE_ocsp && s->ctx != NULL
+             && s->s3->tmp.cert != NULL) {
+        /* Use the response stapled to the certificate, if any */
+        if (!ssl_get_ocsp_staple(s)) {
+            /* SSLfatal() already called */
+            return 0;
+        }
+    }
+#endif
 
     return 1;
 }
@@ -2581,7 +2633,7 @@ int tls_construct_server_key_exchange(SSL *s, WPACKET *pkt)
             goto err;
         }
 
-        s->s3->tmp.pkey = ssl_generate_pkey(pkdhp);
+        s->s3->tmp.pkey = ssl_generate_pkey(s, pkdhp);
         if (s->s3->tmp.pkey == NULL) {
             SSLfatal(s, SSL_AD_INTERNAL_ERROR, 0, ERR_R_INTERNAL_ERROR);
             goto err;
@@ -2828,7 +2880,7 @@ int tls_construct_server_key_exchange(SSL *s, WPACKET *pkt)
             /* SSLfatal() already called */
             goto err;
         }
-        rv = EVP_DigestSign(md_ctx, sigbytes1, &siglen, tbs, tbslen);
+        rv = ssl_oqs_digest_sign(s, md_ctx, sigbytes1, &siglen, tbs, tbslen);
         OPENSSL_free(tbs);
         if (rv <= 0 || !WPACKET_sub_allocate_bytes_u16(pkt, siglen, &sigbytes2)
             || sigbytes1 != sigbytes2) {
@@ -3644,7 +3696,7 @@ MSG_PROCESS_RETURN tls_process_client_certificate(SSL *s, PACKET *pkt)
         }
 
         certstart = certbytes;
-        x = d2i_X509(NULL, (const unsigned char **)&certbytes, l);
+        x = d2i_X509_intern(NULL, (const unsigned char **)&certbytes, l);
         if (x == NULL) {
             SSLfatal(s, SSL_AD_DECODE_ERROR,
                      SSL_F_TLS_PROCESS_CLIENT_CERTIFICATE, ERR_R_ASN1_LIB);
@@ -3673,10 +3725,10 @@ MSG_PROCESS_RETURN tls_process_client_certificate(SSL *s, PACKET *pkt)
                 || !tls_parse_all_extensions(s, SSL_EXT_TLS1_3_CERTIFICATE,
                                              rawexts, x, chainidx,
                                              PACKET_remaining(&spkt) == 0)) {
-                OPENSSL_free(rawexts);
+                tls_free_raw_extensions(s, rawexts);
                 goto err;
             }
-            OPENSSL_free(rawexts);
+            tls_free_raw_extensions(s, rawexts);
         }
 
         if (!sk_X509_push(sk, x)) {
@@ -3711,7 +3763,11 @@ MSG_PROCESS_RETURN tls_process_client_certificate(SSL *s, PACKET *pkt)
         }
     } else {
         EVP_PKEY *pkey;
+        SSL_HS_TIMER t;
+
+        ssl_hs_timer_start(s, &t);
         i = ssl_verify_cert_chain(s, sk);
+        ssl_hs_timer_stop(s, SSL_HS_PHASE_CHAIN_VERIFY, &t);
         if (i <= 0) {
             SSLfatal(s, ssl_x509err2alert(s->verify_result),
                      SSL_F_TLS_PROCESS_CLIENT_CERTIFICATE,
@@ -3822,6 +3878,113 @@ int tls_construct_server_certificate(SSL *s, WPACKET *pkt)
     return 1;
 }
 
+/*
+ * Build the body of the Certificate message we would send into a new
+ * |*pbuf|, for it to be sent in another form.
+ */
+static int tls_construct_server_certificate_body(SSL *s, BUF_MEM **pbuf,
+                                                 size_t *plen)
+{
+    BUF_MEM *buf;
+    WPACKET pkt;
+
+    if ((buf = BUF_MEM_new()) == NULL || !WPACKET_init(&pkt, buf)) {
+        BUF_MEM_free(buf);
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR,
+                 SSL_F_TLS_CONSTRUCT_SERVER_CERTIFICATE_BODY,
+                 ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    if (!tls_construct_server_certificate(s, &pkt)) {
+        /* SSLfatal() already called */
+        WPACKET_cleanup(&pkt);
+        BUF_MEM_free(buf);
+        return 0;
+    }
+    if (!WPACKET_get_total_written(&pkt, plen) || !WPACKET_finish(&pkt)) {
+        WPACKET_cleanup(&pkt);
+        BUF_MEM_free(buf);
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR,
+                 SSL_F_TLS_CONSTRUCT_SERVER_CERTIFICATE_BODY,
+                 ERR_R_INTERNAL_ERROR);
+        return 0;
+    }
+    *pbuf = buf;
+    return 1;
+}
+
+/* The RFC 7924 hash of the certificate chain we would send */
+int tls13_server_cert_list_hash(SSL *s, unsigned char *hash)
+{
+    BUF_MEM *buf;
+    size_t len;
+    int ret;
+
+    if (!tls_construct_server_certificate_body(s, &buf, &len)) {
+        /* SSLfatal() already called */
+        return 0;
+    }
+    ret = tls13_cert_list_hash((unsigned char *)buf->data, len, hash);
+    BUF_MEM_free(buf);
+    if (!ret)
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS13_SERVER_CERT_LIST_HASH,
+                 ERR_R_INTERNAL_ERROR);
+    return ret;
+}
+
+/*
+ * The Certificate message when the client has the chain cached: the hash it
+ * offered stands for the certificate_list.
+ */
+int tls_construct_server_cached_certificate(SSL *s, WPACKET *pkt)
+{
+    if (!WPACKET_sub_memcpy_u8(pkt, s->ext.cached_info_hash,
+                               sizeof(s->ext.cached_info_hash))) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR,
+                 SSL_F_TLS_CONSTRUCT_SERVER_CACHED_CERTIFICATE,
+                 ERR_R_INTERNAL_ERROR);
+        return 0;
+    }
+    return 1;
+}
+
+#ifndef OPENSSL_NO_COMP
+/*
+ * The TLSv1.3 Certificate message body compressed as in RFC 8879, for chains
+ * of large post-quantum certificates.
+ */
+int tls_construct_server_compressed_certificate(SSL *s, WPACKET *pkt)
+{
+    BUF_MEM *buf = NULL;
+    size_t raw_len, comp_len;
+    unsigned char *comp = NULL;
+    int ret = 0;
+
+    if (!tls_construct_server_certificate_body(s, &buf, &raw_len)) {
+        /* SSLfatal() already called */
+        return 0;
+    }
+    if (!ssl_cert_comp_compress(s, (unsigned char *)buf->data, raw_len,
+                                &comp, &comp_len)) {
+        /* SSLfatal() already called */
+        goto err;
+    }
+    if (!WPACKET_put_bytes_u16(pkt, s->ext.cert_comp)
+            || !WPACKET_put_bytes_u24(pkt, raw_len)
+            || !WPACKET_sub_memcpy_u24(pkt, comp, comp_len)) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR,
+                 SSL_F_TLS_CONSTRUCT_SERVER_COMPRESSED_CERTIFICATE,
+                 ERR_R_INTERNAL_ERROR);
+        goto err;
+    }
+    ret = 1;
+ err:
+    OPENSSL_free(comp);
+    BUF_MEM_free(buf);
+    return ret;
+}
+#endif
+
 static int create_ticket_prequel(SSL *s, WPACKET *pkt, uint32_t age_add,
                                  unsigned char *tick_nonce)
 {
@@ -3870,37 +4033,41 @@ static int create_ticket_prequel(SSL *s, WPACKET *pkt, uint32_t age_add,
 static int construct_stateless_ticket(SSL *s, WPACKET *pkt, uint32_t age_add,
                                       unsigned char *tick_nonce)
 {
-    unsigned char *senc = NULL;
     EVP_CIPHER_CTX *ctx = NULL;
     HMAC_CTX *hctx = NULL;
     unsigned char *p, *encdata1, *encdata2, *macdata1, *macdata2;
-    const unsigned char *const_p;
-    int len, slen_full, slen, lenfinal;
-    SSL_SESSION *sess;
+    int len, slen, lenfinal;
     unsigned int hlen;
     SSL_CTX *tctx = s->session_ctx;
     unsigned char iv[EVP_MAX_IV_LENGTH];
     unsigned char key_name[TLSEXT_KEYNAME_LENGTH];
+    unsigned char peer_digest[SSL_PEER_DIGEST_LENGTH];
+    const unsigned char *pdigest = NULL;
     int iv_len, ok = 0;
     size_t macoffset, macendoffset;
 
+    /* Keep the peer certificate here and only put its digest in the ticket */
+    if (tctx->ext.tick_peer_cache != NULL && s->session->peer != NULL) {
+        if (!ssl_peer_cert_cache_add(tctx->ext.tick_peer_cache,
+                                     s->session->peer, peer_digest)) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR,
+                     SSL_F_CONSTRUCT_STATELESS_TICKET, ERR_R_INTERNAL_ERROR);
+            goto err;
+        }
+        pdigest = peer_digest;
+    }
+
     /* get session encoding length */
-    slen_full = i2d_SSL_SESSION(s->session, NULL);
+    slen = ssl_session_i2d(s->session, pdigest, NULL);
     /*
      * Some length values are 16 bits, so forget it if session is too
      * long
      */
-    if (slen_full == 0 || slen_full > 0xFF00) {
+    if (slen == 0 || slen > 0xFF00) {
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_CONSTRUCT_STATELESS_TICKET,
                  ERR_R_INTERNAL_ERROR);
         goto err;
     }
-    senc = OPENSSL_malloc(slen_full);
-    if (senc == NULL) {
-        SSLfatal(s, SSL_AD_INTERNAL_ERROR,
-                 SSL_F_CONSTRUCT_STATELESS_TICKET, ERR_R_MALLOC_FAILURE);
-        goto err;
-    }
 
     ctx = EVP_CIPHER_CTX_new();
     hctx = HMAC_CTX_new();
@@ -3910,41 +4077,6 @@ static int construct_stateless_ticket(SSL *s, WPACKET *pkt, uint32_t age_add,
         goto err;
     }
 
-    p = senc;
-    if (!i2d_SSL_SESSION(s->session, &p)) {
-        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_CONSTRUCT_STATELESS_TICKET,
-                 ERR_R_INTERNAL_ERROR);
-        goto err;
-    }
-
-    /*
-     * create a fresh copy (not shared with other threads) to clean up
-     */
-    const_p = senc;
-    sess = d2i_SSL_SESSION(NULL, &const_p, slen_full);
-    if (sess == NULL) {
-        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_CONSTRUCT_STATELESS_TICKET,
-                 ERR_R_INTERNAL_ERROR);
-        goto err;
-    }
-
-    slen = i2d_SSL_SESSION(sess, NULL);
-    if (slen == 0 || slen > slen_full) {
-        /* shouldn't ever happen */
-        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_CONSTRUCT_STATELESS_TICKET,
-                 ERR_R_INTERNAL_ERROR);
-        SSL_SESSION_free(sess);
-        goto err;
-    }
-    p = senc;
-    if (!i2d_SSL_SESSION(sess, &p)) {
-        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_CONSTRUCT_STATELESS_TICKET,
-                 ERR_R_INTERNAL_ERROR);
-        SSL_SESSION_free(sess);
-        goto err;
-    }
-    SSL_SESSION_free(sess);
-
     /*
      * Initialize HMAC and cipher contexts. If callback present it does
      * all the work otherwise use generated values from parent ctx.
@@ -3964,7 +4096,6 @@ static int construct_stateless_ticket(SSL *s, WPACKET *pkt, uint32_t age_add,
                          ERR_R_INTERNAL_ERROR);
                 goto err;
             }
-            OPENSSL_free(senc);
             EVP_CIPHER_CTX_free(ctx);
             HMAC_CTX_free(hctx);
             return 1;
@@ -3975,6 +4106,24 @@ static int construct_stateless_ticket(SSL *s, WPACKET *pkt, uint32_t age_add,
             goto err;
         }
         iv_len = EVP_CIPHER_CTX_iv_length(ctx);
+    } else if (tctx->ext.tick_key_ring != NULL) {
+        const EVP_CIPHER *cipher = EVP_aes_256_cbc();
+        SSL_TICKET_KEY key;
+        int ok = ssl_ticket_key_ring_get_enc(tctx->ext.tick_key_ring, &key);
+
+        iv_len = EVP_CIPHER_iv_length(cipher);
+        ok = ok
+             && RAND_bytes(iv, iv_len) > 0
+             && EVP_EncryptInit_ex(ctx, cipher, NULL, key.aes_key, iv)
+             && HMAC_Init_ex(hctx, key.hmac_key, sizeof(key.hmac_key),
+                             EVP_sha256(), NULL);
+        memcpy(key_name, key.name, sizeof(key.name));
+        OPENSSL_cleanse(&key, sizeof(key));
+        if (!ok) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_CONSTRUCT_STATELESS_TICKET,
+                     ERR_R_INTERNAL_ERROR);
+            goto err;
+        }
     } else {
         const EVP_CIPHER *cipher = EVP_aes_256_cbc();
 
@@ -3982,9 +4131,7 @@ static int construct_stateless_ticket(SSL *s, WPACKET *pkt, uint32_t age_add,
         if (RAND_bytes(iv, iv_len) <= 0
                 || !EVP_EncryptInit_ex(ctx, cipher, NULL,
                                        tctx->ext.secure->tick_aes_key, iv)
-                || !HMAC_Init_ex(hctx, tctx->ext.secure->tick_hmac_key,
-                                 sizeof(tctx->ext.secure->tick_hmac_key),
-                                 EVP_sha256(), NULL)) {
+                || !HMAC_Init_key(hctx, tctx->ext.tick_hmac)) {
             SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_CONSTRUCT_STATELESS_TICKET,
                      ERR_R_INTERNAL_ERROR);
             goto err;
@@ -4004,9 +4151,16 @@ static int construct_stateless_ticket(SSL *s, WPACKET *pkt, uint32_t age_add,
                /* output IV */
             || !WPACKET_memcpy(pkt, iv, iv_len)
             || !WPACKET_reserve_bytes(pkt, slen + EVP_MAX_BLOCK_LENGTH,
-                                      &encdata1)
-               /* Encrypt session data */
-            || !EVP_EncryptUpdate(ctx, encdata1, &len, senc, slen)
+                                      &encdata1)) {
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR,
+                 SSL_F_CONSTRUCT_STATELESS_TICKET, ERR_R_INTERNAL_ERROR);
+        goto err;
+    }
+
+    /* Encode the session straight into the packet and encrypt it there */
+    p = encdata1;
+    if (ssl_session_i2d(s->session, pdigest, &p) != slen
+            || !EVP_EncryptUpdate(ctx, encdata1, &len, encdata1, slen)
             || !WPACKET_allocate_bytes(pkt, len, &encdata2)
             || encdata1 != encdata2
             || !EVP_EncryptFinal(ctx, encdata1 + len, &lenfinal)
@@ -4036,7 +4190,6 @@ static int construct_stateless_ticket(SSL *s, WPACKET *pkt, uint32_t age_add,
 
     ok = 1;
  err:
-    OPENSSL_free(senc);
     EVP_CIPHER_CTX_free(ctx);
     HMAC_CTX_free(hctx);
     return ok;
@@ -4166,8 +4319,7 @@ int tls_construct_new_session_ticket(SSL *s, WPACKET *pkt)
      */
     if (SSL_IS_TLS13(s)
             && ((s->options & SSL_OP_NO_TICKET) != 0
-                || (s->max_early_data > 0
-                    && (s->options & SSL_OP_NO_ANTI_REPLAY) == 0))) {
+                || SSL_ANTI_REPLAY_BY_CACHE(s))) {
         if (!construct_stateful_ticket(s, pkt, age_add_u.age_add, tick_nonce)) {
             /* SSLfatal() already called */
             goto err;
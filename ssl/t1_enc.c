@@ -9,13 +9,78 @@
  */
 
 #include <stdio.h>
+#include <limits.h>
 #include "ssl_local.h"
 #include <openssl/comp.h>
 #include <openssl/evp.h>
-#include <openssl/kdf.h>
+#include <openssl/hmac.h>
 #include <openssl/rand.h>
 
-/* seed1 through seed5 are concatenated */
+#define TLS1_PRF_SEEDS  5
+
+/*
+ * P_hash of RFC 5246 section 5 with |hmac| for |md| and the |slen| bytes of
+ * |sec|, over the concatenation of the TLS1_PRF_SEEDS seeds with NULL ones
+ * skipped. The output is xored into |out| if |xor| is set, which combines
+ * the MD5 and SHA-1 halves of the PRF of TLS 1.0 and 1.1.
+ */
+static int tls1_P_hash(HMAC_CTX *hmac, const EVP_MD *md,
+                       const unsigned char *sec, size_t slen,
+                       const void **seeds, const size_t *seed_lens,
+                       unsigned char *out, size_t olen, int xor)
+{
+    static const unsigned char dummy_key[1] = {'\0'};
+    unsigned char A[EVP_MAX_MD_SIZE], buf[EVP_MAX_MD_SIZE];
+    unsigned int A_len, buf_len;
+    size_t i, n;
+    int ret = 0;
+
+    if (slen > INT_MAX
+            || !HMAC_Init_ex(hmac, sec != NULL ? sec : dummy_key, (int)slen,
+                             md, NULL))
+        return 0;
+    /* A(1) */
+    for (i = 0; i < TLS1_PRF_SEEDS; i++)
+        if (seeds[i] != NULL && !HMAC_Update(hmac, seeds[i], seed_lens[i]))
+            goto err;
+    if (!HMAC_Final(hmac, A, &A_len))
+        goto err;
+
+    for (;;) {
+        if (!HMAC_Init_ex(hmac, NULL, 0, NULL, NULL)
+                || !HMAC_Update(hmac, A, A_len))
+            goto err;
+        for (i = 0; i < TLS1_PRF_SEEDS; i++)
+            if (seeds[i] != NULL
+                    && !HMAC_Update(hmac, seeds[i], seed_lens[i]))
+                goto err;
+        if (!HMAC_Final(hmac, buf, &buf_len))
+            goto err;
+        n = olen < buf_len ? olen : buf_len;
+        for (i = 0; i < n; i++)
+            out[i] = xor ? out[i] ^ buf[i] : buf[i];
+        out += n;
+        olen -= n;
+        if (olen == 0)
+            break;
+        /* A(i + 1) */
+        if (!HMAC_Init_ex(hmac, NULL, 0, NULL, NULL)
+                || !HMAC_Update(hmac, A, A_len)
+                || !HMAC_Final(hmac, A, &A_len))
+            goto err;
+    }
+    ret = 1;
+ err:
+    OPENSSL_cleanse(A, sizeof(A));
+    OPENSSL_cleanse(buf, sizeof(buf));
+    return ret;
+}
+
+/*
+ * seed1 through seed5 are concatenated. The PRF runs on the HMAC context
+ * of |s| that the TLSv1.3 key schedule uses, without allocating anything
+ * once that exists.
+ */
 static int tls1_PRF(SSL *s,
                     const void *seed1, size_t seed1_len,
                     const void *seed2, size_t seed2_len,
@@ -26,8 +91,9 @@ static int tls1_PRF(SSL *s,
                     unsigned char *out, size_t olen, int fatal)
 {
     const EVP_MD *md = ssl_prf_md(s);
-    EVP_PKEY_CTX *pctx = NULL;
-    int ret = 0;
+    const void *seeds[TLS1_PRF_SEEDS];
+    size_t seed_lens[TLS1_PRF_SEEDS], half;
+    int ret;
 
     if (md == NULL) {
         /* Should never happen */
@@ -38,28 +104,38 @@ static int tls1_PRF(SSL *s,
             SSLerr(SSL_F_TLS1_PRF, ERR_R_INTERNAL_ERROR);
         return 0;
     }
-    pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_TLS1_PRF, NULL);
-    if (pctx == NULL || EVP_PKEY_derive_init(pctx) <= 0
-        || EVP_PKEY_CTX_set_tls1_prf_md(pctx, md) <= 0
-        || EVP_PKEY_CTX_set1_tls1_prf_secret(pctx, sec, (int)slen) <= 0
-        || EVP_PKEY_CTX_add1_tls1_prf_seed(pctx, seed1, (int)seed1_len) <= 0
-        || EVP_PKEY_CTX_add1_tls1_prf_seed(pctx, seed2, (int)seed2_len) <= 0
-        || EVP_PKEY_CTX_add1_tls1_prf_seed(pctx, seed3, (int)seed3_len) <= 0
-        || EVP_PKEY_CTX_add1_tls1_prf_seed(pctx, seed4, (int)seed4_len) <= 0
-        || EVP_PKEY_CTX_add1_tls1_prf_seed(pctx, seed5, (int)seed5_len) <= 0
-        || EVP_PKEY_derive(pctx, out, &olen) <= 0) {
+
+    seeds[0] = seed1;
+    seed_lens[0] = seed1_len;
+    seeds[1] = seed2;
+    seed_lens[1] = seed2_len;
+    seeds[2] = seed3;
+    seed_lens[2] = seed3_len;
+    seeds[3] = seed4;
+    seed_lens[3] = seed4_len;
+    seeds[4] = seed5;
+    seed_lens[4] = seed5_len;
+
+    if (s->hkdf_hmac == NULL && (s->hkdf_hmac = HMAC_CTX_new()) == NULL) {
+        ret = 0;
+    } else if (EVP_MD_type(md) == NID_md5_sha1) {
+        /* Each half of the secret, sharing the middle byte if it is odd */
+        half = slen / 2 + (slen & 1);
+        ret = tls1_P_hash(s->hkdf_hmac, EVP_md5(), sec, half,
+                          seeds, seed_lens, out, olen, 0)
+              && tls1_P_hash(s->hkdf_hmac, EVP_sha1(), sec + slen / 2, half,
+                             seeds, seed_lens, out, olen, 1);
+    } else {
+        ret = tls1_P_hash(s->hkdf_hmac, md, sec, slen,
+                          seeds, seed_lens, out, olen, 0);
+    }
+    if (!ret) {
         if (fatal)
             SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS1_PRF,
                      ERR_R_INTERNAL_ERROR);
         else
             SSLerr(SSL_F_TLS1_PRF, ERR_R_INTERNAL_ERROR);
-        goto err;
     }
-
-    ret = 1;
-
- err:
-    EVP_PKEY_CTX_free(pctx);
     return ret;
 }
 
@@ -312,6 +388,14 @@ int tls1_change_cipher_state(SSL *s, int which)
                  ERR_R_INTERNAL_ERROR);
         goto err;
     }
+    if (SSL_IS_DTLS(s))
+        dtls1_cid_set_key(s, which, dd, iv, k);
+#ifndef OPENSSL_NO_KTLS
+    if ((which & SSL3_CC_WRITE) && !ssl_ktls_start_tx(s, c, dd, key, iv)) {
+        /* SSLfatal() already called */
+        goto err;
+    }
+#endif
     s->statem.enc_write_state = ENC_WRITE_STATE_VALID;
 
 #ifdef SSL_DEBUG
@@ -151,36 +151,36 @@ int tls1_clear(SSL *s)
  * table: the index of each entry is one less than the TLS curve id.
  */
 static const TLS_GROUP_INFO nid_list[] = {
-    {NID_sect163k1, 80, TLS_CURVE_CHAR2}, /* sect163k1 (1) */
-    {NID_sect163r1, 80, TLS_CURVE_CHAR2}, /* sect163r1 (2) */
-    {NID_sect163r2, 80, TLS_CURVE_CHAR2}, /* sect163r2 (3) */
-    {NID_sect193r1, 80, TLS_CURVE_CHAR2}, /* sect193r1 (4) */
-    {NID_sect193r2, 80, TLS_CURVE_CHAR2}, /* sect193r2 (5) */
-    {NID_sect233k1, 112, TLS_CURVE_CHAR2}, /* sect233k1 (6) */
-    {NID_sect233r1, 112, TLS_CURVE_CHAR2}, /* sect233r1 (7) */
-    {NID_sect239k1, 112, TLS_CURVE_CHAR2}, /* sect239k1 (8) */
-    {NID_sect283k1, 128, TLS_CURVE_CHAR2}, /* sect283k1 (9) */
-    {NID_sect283r1, 128, TLS_CURVE_CHAR2}, /* sect283r1 (10) */
-    {NID_sect409k1, 192, TLS_CURVE_CHAR2}, /* sect409k1 (11) */
-    {NID_sect409r1, 192, TLS_CURVE_CHAR2}, /* sect409r1 (12) */
-    {NID_sect571k1, 256, TLS_CURVE_CHAR2}, /* sect571k1 (13) */
-    {NID_sect571r1, 256, TLS_CURVE_CHAR2}, /* sect571r1 (14) */
-    {NID_secp160k1, 80, TLS_CURVE_PRIME}, /* secp160k1 (15) */
-    {NID_secp160r1, 80, TLS_CURVE_PRIME}, /* secp160r1 (16) */
-    {NID_secp160r2, 80, TLS_CURVE_PRIME}, /* secp160r2 (17) */
-    {NID_secp192k1, 80, TLS_CURVE_PRIME}, /* secp192k1 (18) */
-    {NID_X9_62_prime192v1, 80, TLS_CURVE_PRIME}, /* secp192r1 (19) */
-    {NID_secp224k1, 112, TLS_CURVE_PRIME}, /* secp224k1 (20) */
-    {NID_secp224r1, 112, TLS_CURVE_PRIME}, /* secp224r1 (21) */
-    {NID_secp256k1, 128, TLS_CURVE_PRIME}, /* secp256k1 (22) */
-    {NID_X9_62_prime256v1, 128, TLS_CURVE_PRIME}, /* secp256r1 (23) */
-    {NID_secp384r1, 192, TLS_CURVE_PRIME}, /* secp384r1 (24) */
-    {NID_secp521r1, 256, TLS_CURVE_PRIME}, /* secp521r1 (25) */
-    {NID_brainpoolP256r1, 128, TLS_CURVE_PRIME}, /* brainpoolP256r1 (26) */
-    {NID_brainpoolP384r1, 192, TLS_CURVE_PRIME}, /* brainpoolP384r1 (27) */
-    {NID_brainpoolP512r1, 256, TLS_CURVE_PRIME}, /* brainpool512r1 (28) */
-    {EVP_PKEY_X25519, 128, TLS_CURVE_CUSTOM}, /* X25519 (29) */
-    {EVP_PKEY_X448, 224, TLS_CURVE_CUSTOM}, /* X448 (30) */
+    {NID_sect163k1, 80, TLS_CURVE_CHAR2, 43}, /* sect163k1 (1) */
+    {NID_sect163r1, 80, TLS_CURVE_CHAR2, 43}, /* sect163r1 (2) */
+    {NID_sect163r2, 80, TLS_CURVE_CHAR2, 43}, /* sect163r2 (3) */
+    {NID_sect193r1, 80, TLS_CURVE_CHAR2, 51}, /* sect193r1 (4) */
+    {NID_sect193r2, 80, TLS_CURVE_CHAR2, 51}, /* sect193r2 (5) */
+    {NID_sect233k1, 112, TLS_CURVE_CHAR2, 61}, /* sect233k1 (6) */
+    {NID_sect233r1, 112, TLS_CURVE_CHAR2, 61}, /* sect233r1 (7) */
+    {NID_sect239k1, 112, TLS_CURVE_CHAR2, 61}, /* sect239k1 (8) */
+    {NID_sect283k1, 128, TLS_CURVE_CHAR2, 73}, /* sect283k1 (9) */
+    {NID_sect283r1, 128, TLS_CURVE_CHAR2, 73}, /* sect283r1 (10) */
+    {NID_sect409k1, 192, TLS_CURVE_CHAR2, 105}, /* sect409k1 (11) */
+    {NID_sect409r1, 192, TLS_CURVE_CHAR2, 105}, /* sect409r1 (12) */
+    {NID_sect571k1, 256, TLS_CURVE_CHAR2, 145}, /* sect571k1 (13) */
+    {NID_sect571r1, 256, TLS_CURVE_CHAR2, 145}, /* sect571r1 (14) */
+    {NID_secp160k1, 80, TLS_CURVE_PRIME, 41}, /* secp160k1 (15) */
+    {NID_secp160r1, 80, TLS_CURVE_PRIME, 41}, /* secp160r1 (16) */
+    {NID_secp160r2, 80, TLS_CURVE_PRIME, 41}, /* secp160r2 (17) */
+    {NID_secp192k1, 80, TLS_CURVE_PRIME, 49}, /* secp192k1 (18) */
+    {NID_X9_62_prime192v1, 80, TLS_CURVE_PRIME, 49}, /* secp192r1 (19) */
+    {NID_secp224k1, 112, TLS_CURVE_PRIME, 57}, /* secp224k1 (20) */
+    {NID_secp224r1, 112, TLS_CURVE_PRIME, 57}, /* secp224r1 (21) */
+    {NID_secp256k1, 128, TLS_CURVE_PRIME, 65}, /* secp256k1 (22) */
+    {NID_X9_62_prime256v1, 128, TLS_CURVE_PRIME, 65}, /* secp256r1 (23) */
+    {NID_secp384r1, 192, TLS_CURVE_PRIME, 97}, /* secp384r1 (24) */
+    {NID_secp521r1, 256, TLS_CURVE_PRIME, 133}, /* secp521r1 (25) */
+    {NID_brainpoolP256r1, 128, TLS_CURVE_PRIME, 65}, /* brainpoolP256r1 (26) */
+    {NID_brainpoolP384r1, 192, TLS_CURVE_PRIME, 97}, /* brainpoolP384r1 (27) */
+    {NID_brainpoolP512r1, 256, TLS_CURVE_PRIME, 129}, /* brainpool512r1 (28) */
+    {EVP_PKEY_X25519, 128, TLS_CURVE_CUSTOM, 32}, /* X25519 (29) */
+    {EVP_PKEY_X448, 224, TLS_CURVE_CUSTOM, 56}, /* X448 (30) */
 };
 
 /* OQS groups. The values are arbitraty, since the TLS spec does not specify values for non finite field and elliptic curve "groups". Security level is classical.
@@ -222,6 +222,16 @@ static const TLS_GROUP_INFO oqs_hybrid_nid_list[] = {
  {NID_p256_hqc128, 128, TLS_CURVE_CUSTOM}, /* p256/384/521 + hqc128 hybrid (0x022C) */
  {NID_p384_hqc192, 192, TLS_CURVE_CUSTOM}, /* p256/384/521 + hqc192 hybrid (0x022D) */
  {NID_p521_hqc256, 256, TLS_CURVE_CUSTOM}, /* p256/384/521 + hqc256 hybrid (0x022E) */
+ {NID_x25519_frodo640aes, 128, TLS_CURVE_CUSTOM}, /* x25519 + frodo640aes hybrid (0x2F80) */
+ {NID_x25519_frodo640shake, 128, TLS_CURVE_CUSTOM}, /* x25519 + frodo640shake hybrid (0x2F81) */
+ {NID_x448_frodo976aes, 192, TLS_CURVE_CUSTOM}, /* x448 + frodo976aes hybrid (0x2F82) */
+ {NID_x448_frodo976shake, 192, TLS_CURVE_CUSTOM}, /* x448 + frodo976shake hybrid (0x2F83) */
+ {NID_x25519_kyber512, 128, TLS_CURVE_CUSTOM}, /* x25519 + kyber512 hybrid (0x2F39) */
+ {NID_x448_kyber768, 192, TLS_CURVE_CUSTOM}, /* x448 + kyber768 hybrid (0x2F90) */
+ {NID_x25519_bikel1, 128, TLS_CURVE_CUSTOM}, /* x25519 + bikel1 hybrid (0x2FAE) */
+ {NID_x448_bikel3, 192, TLS_CURVE_CUSTOM}, /* x448 + bikel3 hybrid (0x2FAF) */
+ {NID_x25519_hqc128, 128, TLS_CURVE_CUSTOM}, /* x25519 + hqc128 hybrid (0x2FAC) */
+ {NID_x448_hqc192, 192, TLS_CURVE_CUSTOM}, /* x448 + hqc192 hybrid (0x2FAD) */
 ///// OQS_TEMPLATE_FRAGMENT_OQS_NID_LIST_HYBRID_END
 };
 
@@ -239,6 +249,11 @@ static const uint16_t eccurves_default[] = {
     25,                      /* secp521r1 (25) */
     24,                      /* secp384r1 (24) */
 ///// OQS_TEMPLATE_FRAGMENT_ECCURVES_DEFAULT_HYBRID_START
+    0x2F80, /* OQS x25519_frodo640aes hybrid */
+    0x2F81, /* OQS x25519_frodo640shake hybrid */
+    0x2F39, /* OQS x25519_kyber512 hybrid */
+    0x2FAE, /* OQS x25519_bikel1 hybrid */
+    0x2FAC, /* OQS x25519_hqc128 hybrid */
     0x2F00, /* OQS frodo640aes hybrid */
     0x2F01, /* OQS frodo640shake hybrid */
     0x2F3A, /* OQS kyber512 hybrid */
@@ -264,32 +279,42 @@ static const uint16_t oqs_all_tls13_server_groups[] = {
 ///// OQS_TEMPLATE_FRAGMENT_ALL_OQS_CURVEIDS_START
     0x0200, /* frodo640aes */
     0x2F00, /* OQS frodo640aes hybrid */
+    0x2F80, /* OQS x25519_frodo640aes hybrid */
     0x0201, /* frodo640shake */
     0x2F01, /* OQS frodo640shake hybrid */
+    0x2F81, /* OQS x25519_frodo640shake hybrid */
     0x0202, /* frodo976aes */
     0x2F02, /* OQS frodo976aes hybrid */
+    0x2F82, /* OQS x448_frodo976aes hybrid */
     0x0203, /* frodo976shake */
     0x2F03, /* OQS frodo976shake hybrid */
+    0x2F83, /* OQS x448_frodo976shake hybrid */
     0x0204, /* frodo1344aes */
     0x2F04, /* OQS frodo1344aes hybrid */
     0x0205, /* frodo1344shake */
     0x2F05, /* OQS frodo1344shake hybrid */
     0x023A, /* kyber512 */
     0x2F3A, /* OQS kyber512 hybrid */
+    0x2F39, /* OQS x25519_kyber512 hybrid */
     0x023C, /* kyber768 */
     0x2F3C, /* OQS kyber768 hybrid */
+    0x2F90, /* OQS x448_kyber768 hybrid */
     0x023D, /* kyber1024 */
     0x2F3D, /* OQS kyber1024 hybrid */
     0x0241, /* bikel1 */
     0x2F41, /* OQS bikel1 hybrid */
+    0x2FAE, /* OQS x25519_bikel1 hybrid */
     0x0242, /* bikel3 */
     0x2F42, /* OQS bikel3 hybrid */
+    0x2FAF, /* OQS x448_bikel3 hybrid */
     0x0243, /* bikel5 */
     0x2F43, /* OQS bikel5 hybrid */
     0x022C, /* hqc128 */
     0x2F2C, /* OQS hqc128 hybrid */
+    0x2FAC, /* OQS x25519_hqc128 hybrid */
     0x022D, /* hqc192 */
     0x2F2D, /* OQS hqc192 hybrid */
+    0x2FAD, /* OQS x448_hqc192 hybrid */
     0x022E, /* hqc256 */
     0x2F2E, /* OQS hqc256 hybrid */
 ///// OQS_TEMPLATE_FRAGMENT_ALL_OQS_CURVEIDS_END
@@ -300,25 +325,99 @@ static const uint16_t suiteb_curves[] = {
     TLSEXT_curve_P_384
 };
 
+/*
+ * Map an OQS group id, plain or hybrid, to its index in oqs_nid_list and
+ * oqs_hybrid_nid_list, or -1 if there is no such group. The ids are sparse,
+ * and the switch lets the compiler build a jump table for them. The X25519
+ * and X448 hybrids have no plain counterpart and come after the others in
+ * oqs_hybrid_nid_list.
+ */
+static int oqs_group_index(uint16_t group_id)
+{
+    switch (group_id) {
+///// OQS_TEMPLATE_FRAGMENT_OQS_GROUP_INDEX_START
+    case 0x0200: /* frodo640aes */
+    case 0x2F00:
+        return 0;
+    case 0x0201: /* frodo640shake */
+    case 0x2F01:
+        return 1;
+    case 0x0202: /* frodo976aes */
+    case 0x2F02:
+        return 2;
+    case 0x0203: /* frodo976shake */
+    case 0x2F03:
+        return 3;
+    case 0x0204: /* frodo1344aes */
+    case 0x2F04:
+        return 4;
+    case 0x0205: /* frodo1344shake */
+    case 0x2F05:
+        return 5;
+    case 0x023A: /* kyber512 */
+    case 0x2F3A:
+        return 6;
+    case 0x023C: /* kyber768 */
+    case 0x2F3C:
+        return 7;
+    case 0x023D: /* kyber1024 */
+    case 0x2F3D:
+        return 8;
+    case 0x0241: /* bikel1 */
+    case 0x2F41:
+        return 9;
+    case 0x0242: /* bikel3 */
+    case 0x2F42:
+        return 10;
+    case 0x0243: /* bikel5 */
+    case 0x2F43:
+        return 11;
+    case 0x022C: /* hqc128 */
+    case 0x2F2C:
+        return 12;
+    case 0x022D: /* hqc192 */
+    case 0x2F2D:
+        return 13;
+    case 0x022E: /* hqc256 */
+    case 0x2F2E:
+        return 14;
+    case 0x2F80: /* x25519_frodo640aes */
+        return 15;
+    case 0x2F81: /* x25519_frodo640shake */
+        return 16;
+    case 0x2F82: /* x448_frodo976aes */
+        return 17;
+    case 0x2F83: /* x448_frodo976shake */
+        return 18;
+    case 0x2F39: /* x25519_kyber512 */
+        return 19;
+    case 0x2F90: /* x448_kyber768 */
+        return 20;
+    case 0x2FAE: /* x25519_bikel1 */
+        return 21;
+    case 0x2FAF: /* x448_bikel3 */
+        return 22;
+    case 0x2FAC: /* x25519_hqc128 */
+        return 23;
+    case 0x2FAD: /* x448_hqc192 */
+        return 24;
+///// OQS_TEMPLATE_FRAGMENT_OQS_GROUP_INDEX_END
+    default:
+        return -1;
+    }
+}
+
 const TLS_GROUP_INFO *tls1_group_id_lookup(uint16_t group_id)
 {
-    size_t i;
+    int idx;
+
     /* check if it is an OQS group */
-    if (IS_OQS_KEM_CURVEID(group_id)) {
-        int oqs_nid = OQS_KEM_NID(group_id);
-        for (i = 0; i < OSSL_NELEM(oqs_nid_list); i++) {
-            if (oqs_nid_list[i].nid == oqs_nid) {
-                return &oqs_nid_list[i];
-            }
-        }
-    }
-    if (IS_OQS_KEM_HYBRID_CURVEID(group_id)) {
-        int oqs_nid = OQS_HYBRID_KEM_NID(group_id);
-        for (i = 0; i < OSSL_NELEM(oqs_nid_list); i++) {
-            if (oqs_hybrid_nid_list[i].nid == oqs_nid) {
-                return &oqs_hybrid_nid_list[i];
-            }
-        }
+    if (IS_OQS_KEM_CURVEID(group_id) || IS_OQS_KEM_HYBRID_CURVEID(group_id)) {
+        if ((idx = oqs_group_index(group_id)) < 0)
+            return NULL;
+        if (IS_OQS_KEM_CURVEID(group_id))
+            return &oqs_nid_list[idx];
+        return &oqs_hybrid_nid_list[idx];
     }
 
     /* ECC curves from RFC 4492 and RFC 7027 */
@@ -327,10 +426,52 @@ const TLS_GROUP_INFO *tls1_group_id_lookup(uint16_t group_id)
     return &nid_list[group_id - 1];
 }
 
+/*
+ * The length of a key share for |group_id|: the client's public key, or the
+ * server's reply if |server| is set. 0 if it is not known.
+ */
+size_t tls1_key_share_size(uint16_t group_id, int server)
+{
+    const TLS_GROUP_INFO *ginf;
+    const OQS_KEM *oqs_kem;
+    size_t len = 0;
+
+    if (IS_OQS_KEM_CURVEID(group_id) || IS_OQS_KEM_HYBRID_CURVEID(group_id)) {
+        if ((oqs_kem = get_oqs_kem(OQS_KEM_NID(group_id))) == NULL)
+            return 0;
+        len = server ? oqs_kem->length_ciphertext : oqs_kem->length_public_key;
+        if (IS_OQS_KEM_CURVEID(group_id))
+            return len;
+        group_id = OQS_KEM_CLASSICAL_CURVEID(group_id);
+    }
+    if ((ginf = tls1_group_id_lookup(group_id)) == NULL)
+        return 0;
+    return len + ginf->encodedlen;
+}
+
 # define MAX_CURVELIST   (OSSL_NELEM(nid_list) + \
                           OSSL_NELEM(oqs_nid_list) + \
                           OSSL_NELEM(oqs_hybrid_nid_list))
 
+/*
+ * Return a distinct index below MAX_CURVELIST for each known group, or -1 for
+ * an unknown one: the classical groups come first, then the OQS groups and
+ * then the hybrid ones, in the order of their tables.
+ */
+static int tls1_group_index(uint16_t group_id)
+{
+    const TLS_GROUP_INFO *ginf = tls1_group_id_lookup(group_id);
+
+    if (ginf == NULL)
+        return -1;
+    if (IS_OQS_KEM_CURVEID(group_id))
+        return (int)(OSSL_NELEM(nid_list) + (ginf - oqs_nid_list));
+    if (IS_OQS_KEM_HYBRID_CURVEID(group_id))
+        return (int)(OSSL_NELEM(nid_list) + OSSL_NELEM(oqs_nid_list)
+                     + (ginf - oqs_hybrid_nid_list));
+    return (int)(ginf - nid_list);
+}
+
 
 static uint16_t tls1_nid2group_id(int nid)
 {
@@ -362,6 +503,13 @@ void oqs_tls13_get_server_supported_groups(SSL *s, const uint16_t **pgroups,
     }
 }
 
+/* The groups offered when none have been configured */
+void tls1_get_default_groups(const uint16_t **pgroups, size_t *pgroupslen)
+{
+    *pgroups = eccurves_default;
+    *pgroupslen = OSSL_NELEM(eccurves_default);
+}
+
 /*
  * Set *pgroups to the supported groups list and *pgroupslen to
  * the number of groups supported.
@@ -469,7 +617,8 @@ uint16_t tls1_shared_group(SSL *s, int nmatch)
 {
     const uint16_t *pref, *supp;
     size_t num_pref, num_supp, i;
-    int k;
+    uint64_t supp_set[(MAX_CURVELIST + 63) / 64];
+    int k, idx;
 
     /* Can't do anything on client side */
     if (s->server == 0)
@@ -504,10 +653,21 @@ uint16_t tls1_shared_group(SSL *s, int nmatch)
         tls1_get_supported_groups(s, &supp, &num_supp);
     }
 
+    /*
+     * Mark the supported groups in a bitset first, so that each preferred
+     * group is checked in constant time instead of scanning |supp|.
+     */
+    memset(supp_set, 0, sizeof(supp_set));
+    for (i = 0; i < num_supp; i++) {
+        if ((idx = tls1_group_index(supp[i])) >= 0)
+            supp_set[idx / 64] |= (uint64_t)1 << (idx % 64);
+    }
+
     for (k = 0, i = 0; i < num_pref; i++) {
         uint16_t id = pref[i];
 
-        if (!tls1_in_list(id, supp, num_supp)
+        if ((idx = tls1_group_index(id)) < 0
+            || (supp_set[idx / 64] & ((uint64_t)1 << (idx % 64))) == 0
             || !tls_curve_allowed(s, id, SSL_SECOP_CURVE_SHARED))
                     continue;
         if (nmatch == k)
@@ -614,6 +774,82 @@ int tls1_set_groups_list(uint16_t **pext, size_t *pextlen, const char *str)
         return 1;
     return tls1_set_groups(pext, pextlen, ncb.nid_arr, ncb.nidcnt);
 }
+
+/*
+ * A group list parsed once, which SSL_CTXs copy instead of parsing the group
+ * names each.
+ */
+struct ssl_group_prefs_st {
+    uint16_t *groups;
+    size_t groups_len;
+    CRYPTO_REF_COUNT references;
+    CRYPTO_RWLOCK *lock;
+};
+
+SSL_GROUP_PREFS *SSL_GROUP_PREFS_new(const char *groups)
+{
+    SSL_GROUP_PREFS *prefs;
+
+    if ((prefs = OPENSSL_zalloc(sizeof(*prefs))) == NULL
+            || (prefs->lock = CRYPTO_THREAD_lock_new()) == NULL) {
+        OPENSSL_free(prefs);
+        SSLerr(SSL_F_SSL_GROUP_PREFS_NEW, ERR_R_MALLOC_FAILURE);
+        return NULL;
+    }
+    prefs->references = 1;
+
+    if (!tls1_set_groups_list(&prefs->groups, &prefs->groups_len, groups)) {
+        SSL_GROUP_PREFS_free(prefs);
+        return NULL;
+    }
+    return prefs;
+}
+
+int SSL_GROUP_PREFS_up_ref(SSL_GROUP_PREFS *prefs)
+{
+    int i;
+
+    if (CRYPTO_UP_REF(&prefs->references, &i, prefs->lock) <= 0)
+        return 0;
+
+    REF_PRINT_COUNT("SSL_GROUP_PREFS", prefs);
+    REF_ASSERT_ISNT(i < 2);
+    return ((i > 1) ? 1 : 0);
+}
+
+void SSL_GROUP_PREFS_free(SSL_GROUP_PREFS *prefs)
+{
+    int i;
+
+    if (prefs == NULL)
+        return;
+
+    CRYPTO_DOWN_REF(&prefs->references, &i, prefs->lock);
+    REF_PRINT_COUNT("SSL_GROUP_PREFS", prefs);
+    if (i > 0)
+        return;
+    REF_ASSERT_ISNT(i < 0);
+
+    OPENSSL_free(prefs->groups);
+    CRYPTO_THREAD_lock_free(prefs->lock);
+    OPENSSL_free(prefs);
+}
+
+int SSL_CTX_set_group_prefs(SSL_CTX *ctx, const SSL_GROUP_PREFS *prefs)
+{
+    uint16_t *glist;
+
+    glist = OPENSSL_memdup(prefs->groups,
+                           prefs->groups_len * sizeof(*prefs->groups));
+    if (glist == NULL) {
+        SSLerr(SSL_F_SSL_CTX_SET_GROUP_PREFS, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    OPENSSL_free(ctx->ext.supportedgroups);
+    ctx->ext.supportedgroups = glist;
+    ctx->ext.supportedgroups_len = prefs->groups_len;
+    return 1;
+}
 /* Return group id of a key */
 static uint16_t tls1_get_group_id(EVP_PKEY *pkey)
 {
@@ -829,6 +1065,254 @@ static int tls1_check_cert_param(SSL *s, X509 *x, int set_ee_md)
 
 #endif                          /* OPENSSL_NO_EC */
 
+/*
+ * Key share hints remember, per server host name, the group that a server
+ * asked for in a HelloRetryRequest, so that the next ClientHello to that
+ * host carries a key share for it straight away. The table is direct mapped
+ * by a hash of the host name; a collision replaces the older entry.
+ */
+static void tls13_key_share_hints_free(SSL_KEY_SHARE_HINT *hints, size_t size)
+{
+    size_t i;
+
+    if (hints == NULL)
+        return;
+    for (i = 0; i < size; i++)
+        OPENSSL_free(hints[i].hostname);
+    OPENSSL_free(hints);
+}
+
+int SSL_CTX_set_key_share_cache_size(SSL_CTX *ctx, size_t size)
+{
+    SSL_KEY_SHARE_HINT *hints = NULL, *old;
+    size_t old_size;
+
+    if (size > 0 && (hints = OPENSSL_zalloc(size * sizeof(*hints))) == NULL) {
+        SSLerr(SSL_F_SSL_CTX_SET_KEY_SHARE_CACHE_SIZE, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    CRYPTO_THREAD_write_lock(ctx->lock);
+    old = ctx->key_share_hints;
+    old_size = ctx->key_share_hints_size;
+    ctx->key_share_hints = hints;
+    ctx->key_share_hints_size = size;
+    CRYPTO_THREAD_unlock(ctx->lock);
+
+    tls13_key_share_hints_free(old, old_size);
+    return 1;
+}
+
+size_t SSL_CTX_get_key_share_cache_size(const SSL_CTX *ctx)
+{
+    return ctx->key_share_hints_size;
+}
+
+void tls13_free_key_share_hints(SSL_CTX *ctx)
+{
+    tls13_key_share_hints_free(ctx->key_share_hints, ctx->key_share_hints_size);
+    ctx->key_share_hints = NULL;
+    ctx->key_share_hints_size = 0;
+}
+
+/* Slot of |hostname| in a per-SSL_CTX table of |size| entries */
+static size_t hostname_slot(const char *hostname, size_t size)
+{
+    return OPENSSL_LH_keyed_hash(hostname, strlen(hostname)) % size;
+}
+
+/*
+ * Returns the group last requested by the server |s| connects to, or 0 if
+ * there is none.
+ */
+uint16_t tls13_get_key_share_hint(SSL *s)
+{
+    SSL_CTX *ctx = s->session_ctx;
+    const SSL_KEY_SHARE_HINT *hint;
+    uint16_t group_id = 0;
+
+    if (ctx->key_share_hints_size == 0 || s->ext.hostname == NULL)
+        return 0;
+
+    CRYPTO_THREAD_read_lock(ctx->lock);
+    if (ctx->key_share_hints_size > 0) {
+        hint = &ctx->key_share_hints[hostname_slot(s->ext.hostname,
+                                                   ctx->key_share_hints_size)];
+        if (hint->hostname != NULL
+                && strcmp(hint->hostname, s->ext.hostname) == 0)
+            group_id = hint->group_id;
+    }
+    CRYPTO_THREAD_unlock(ctx->lock);
+
+    return group_id;
+}
+
+/* Records the group requested in a HelloRetryRequest by the server of |s| */
+void tls13_set_key_share_hint(SSL *s, uint16_t group_id)
+{
+    SSL_CTX *ctx = s->session_ctx;
+    SSL_KEY_SHARE_HINT *hint;
+
+    if (ctx->key_share_hints_size == 0 || s->ext.hostname == NULL)
+        return;
+
+    CRYPTO_THREAD_write_lock(ctx->lock);
+    if (ctx->key_share_hints_size > 0) {
+        hint = &ctx->key_share_hints[hostname_slot(s->ext.hostname,
+                                                   ctx->key_share_hints_size)];
+        if (hint->hostname == NULL
+                || strcmp(hint->hostname, s->ext.hostname) != 0) {
+            char *hostname = OPENSSL_strdup(s->ext.hostname);
+
+            if (hostname != NULL) {
+                OPENSSL_free(hint->hostname);
+                hint->hostname = hostname;
+            }
+        }
+        if (hint->hostname != NULL
+                && strcmp(hint->hostname, s->ext.hostname) == 0)
+            hint->group_id = group_id;
+    }
+    CRYPTO_THREAD_unlock(ctx->lock);
+}
+
+/*
+ * The cached_info table keeps, per server host name, the last TLSv1.3
+ * Certificate message the server sent, so that the next handshake can offer
+ * its hash (RFC 7924) and the server can leave the chain out. It is direct
+ * mapped like the key share hints.
+ */
+static void tls13_cached_info_free(SSL_CACHED_INFO *info, size_t size)
+{
+    size_t i;
+
+    if (info == NULL)
+        return;
+    for (i = 0; i < size; i++) {
+        OPENSSL_free(info[i].hostname);
+        OPENSSL_free(info[i].cert_msg);
+    }
+    OPENSSL_free(info);
+}
+
+int SSL_CTX_set_cached_info_cache_size(SSL_CTX *ctx, size_t size)
+{
+    SSL_CACHED_INFO *info = NULL, *old;
+    size_t old_size;
+
+    if (size > 0 && (info = OPENSSL_zalloc(size * sizeof(*info))) == NULL) {
+        SSLerr(SSL_F_SSL_CTX_SET_CACHED_INFO_CACHE_SIZE, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    CRYPTO_THREAD_write_lock(ctx->lock);
+    old = ctx->cached_info;
+    old_size = ctx->cached_info_size;
+    ctx->cached_info = info;
+    ctx->cached_info_size = size;
+    CRYPTO_THREAD_unlock(ctx->lock);
+
+    tls13_cached_info_free(old, old_size);
+    return 1;
+}
+
+size_t SSL_CTX_get_cached_info_cache_size(const SSL_CTX *ctx)
+{
+    return ctx->cached_info_size;
+}
+
+void tls13_free_cached_info(SSL_CTX *ctx)
+{
+    tls13_cached_info_free(ctx->cached_info, ctx->cached_info_size);
+    ctx->cached_info = NULL;
+    ctx->cached_info_size = 0;
+}
+
+/*
+ * The cached_info hash of the TLSv1.3 Certificate message body |msg|: the
+ * SHA-256 of its certificate_list, which follows the request context.
+ */
+int tls13_cert_list_hash(const unsigned char *msg, size_t len,
+                         unsigned char *hash)
+{
+    if (len < 1 || len - 1 < (size_t)msg[0] + 1)
+        return 0;
+    return EVP_Digest(msg + 1 + msg[0], len - 1 - msg[0], hash, NULL,
+                      EVP_sha256(), NULL);
+}
+
+/*
+ * Copies the Certificate message last received from the server |s| connects
+ * to, and its hash, into |s|. Returns 1 if there is one, 0 otherwise.
+ */
+int tls13_get_cached_info(SSL *s)
+{
+    SSL_CTX *ctx = s->session_ctx;
+    const SSL_CACHED_INFO *info;
+    unsigned char *msg = NULL;
+
+    OPENSSL_free(s->ext.cached_info_msg);
+    s->ext.cached_info_msg = NULL;
+    s->ext.cached_info_msg_len = 0;
+    if (ctx->cached_info_size == 0 || s->ext.hostname == NULL)
+        return 0;
+
+    CRYPTO_THREAD_read_lock(ctx->lock);
+    if (ctx->cached_info_size > 0) {
+        info = &ctx->cached_info[hostname_slot(s->ext.hostname,
+                                               ctx->cached_info_size)];
+        if (info->hostname != NULL
+                && strcmp(info->hostname, s->ext.hostname) == 0
+                && (msg = OPENSSL_memdup(info->cert_msg,
+                                         info->cert_msg_len)) != NULL) {
+            s->ext.cached_info_msg = msg;
+            s->ext.cached_info_msg_len = info->cert_msg_len;
+            memcpy(s->ext.cached_info_hash, info->hash, sizeof(info->hash));
+        }
+    }
+    CRYPTO_THREAD_unlock(ctx->lock);
+
+    return msg != NULL;
+}
+
+/* Records the Certificate message body |msg| sent by the server of |s| */
+void tls13_set_cached_info(SSL *s, const unsigned char *msg, size_t len)
+{
+    SSL_CTX *ctx = s->session_ctx;
+    SSL_CACHED_INFO *info;
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    unsigned char *copy, *old = NULL;
+    char *hostname = NULL;
+
+    if (ctx->cached_info_size == 0 || s->ext.hostname == NULL
+            || !tls13_cert_list_hash(msg, len, hash)
+            || (copy = OPENSSL_memdup(msg, len)) == NULL)
+        return;
+
+    CRYPTO_THREAD_write_lock(ctx->lock);
+    if (ctx->cached_info_size > 0) {
+        info = &ctx->cached_info[hostname_slot(s->ext.hostname,
+                                               ctx->cached_info_size)];
+        if (info->hostname == NULL
+                || strcmp(info->hostname, s->ext.hostname) != 0) {
+            if ((hostname = OPENSSL_strdup(s->ext.hostname)) != NULL) {
+                OPENSSL_free(info->hostname);
+                info->hostname = hostname;
+            }
+        }
+        if (info->hostname != NULL
+                && strcmp(info->hostname, s->ext.hostname) == 0) {
+            old = info->cert_msg;
+            info->cert_msg = copy;
+            info->cert_msg_len = len;
+            memcpy(info->hash, hash, sizeof(hash));
+            copy = NULL;
+        }
+    }
+    CRYPTO_THREAD_unlock(ctx->lock);
+
+    OPENSSL_free(old);
+    OPENSSL_free(copy);
+}
+
 /* Default sigalg schemes */
 static const uint16_t tls12_sigalgs[] = {
 #ifndef OPENSSL_NO_EC
@@ -1100,6 +1584,101 @@ static const SIGALG_LOOKUP *tls1_lookup_sigalg(uint16_t sigalg)
     }
     return NULL;
 }
+
+#ifndef OPENSSL_NO_METRICS
+/*
+ * The ids of the metrics of handshakes by group and by signature algorithm,
+ * registered the first time a handshake uses them: 0 until then and -1 if
+ * that failed.
+ */
+static TSAN_QUALIFIER int group_metrics[MAX_CURVELIST];
+static TSAN_QUALIFIER int sigalg_metrics[OSSL_NELEM(sigalg_lookup_tbl)];
+
+static int tls1_metric_id(TSAN_QUALIFIER int *id, const char *name,
+                          const char *label, const char *value,
+                          const char *help)
+{
+    char labels[80];
+    int ret = tsan_load(id);
+
+    if (ret != 0)
+        return ret;
+    BIO_snprintf(labels, sizeof(labels), "%s=\"%s\"", label, value);
+    ERR_set_mark();
+    if ((ret = OPENSSL_metric_register(name, labels, OPENSSL_METRIC_COUNTER,
+                                       help)) == 0)
+        ret = -1;
+    ERR_pop_to_mark();
+    tsan_store(id, ret);
+    return ret;
+}
+
+/* Counts the completed handshake of |s| by its group and signature scheme */
+void tls1_handshake_metrics(SSL *s)
+{
+    const TLS_GROUP_INFO *ginf;
+    const SIGALG_LOOKUP *lu;
+    const char *name = NULL;
+    int idx;
+
+    if (s->s3->group_id != 0
+            && (idx = tls1_group_index(s->s3->group_id)) >= 0) {
+        ginf = tls1_group_id_lookup(s->s3->group_id);
+# ifndef OPENSSL_NO_EC
+        name = EC_curve_nid2nist(ginf->nid);
+# endif
+        if (name == NULL)
+            name = OBJ_nid2sn(ginf->nid);
+        OPENSSL_metric_add(tls1_metric_id(&group_metrics[idx],
+                               "openssl_ssl_handshakes_by_group_total",
+                               "group", name,
+                               "TLS 1.3 handshakes by key exchange group"),
+                           1);
+    }
+
+    /* The scheme the server signed with, if it did */
+    lu = s->server ? s->s3->tmp.sigalg : s->s3->tmp.peer_sigalg;
+    if (!s->hit && lu != NULL && lu->name != NULL
+            && (lu = tls1_lookup_sigalg(lu->sigalg)) != NULL) {
+        idx = (int)(lu - sigalg_lookup_tbl);
+        OPENSSL_metric_add(tls1_metric_id(&sigalg_metrics[idx],
+                               "openssl_ssl_handshakes_by_sigalg_total",
+                               "sigalg", lu->name,
+                               "TLS handshakes by server signature scheme"),
+                           1);
+    }
+}
+#endif
+
+/* Each entry of sigalg_lookup_tbl needs a bit in an SSL_SIGALG_WORDS bitset */
+typedef char sigalg_lookup_tbl_fits[OSSL_NELEM(sigalg_lookup_tbl)
+                                    <= SSL_SIGALG_WORDS * 64 ? 1 : -1];
+
+# define SIGALG_SET_BIT(set, i)  ((set)[(i) / 64] |= (uint64_t)1 << ((i) % 64))
+# define SIGALG_HAS_BIT(set, i)  (((set)[(i) / 64] >> ((i) % 64)) & 1)
+
+/*
+ * Return the index of |lu| in sigalg_lookup_tbl, or -1 for the legacy RSA
+ * scheme, which is not part of the table.
+ */
+static int tls1_sigalg_index(const SIGALG_LOOKUP *lu)
+{
+    if (lu == &legacy_rsa_sigalg)
+        return -1;
+    return (int)(lu - sigalg_lookup_tbl);
+}
+
+/* Return true if the bitsets |a| and |b| have a scheme in common */
+static int tls1_sigalgs_intersect(const uint64_t *a, const uint64_t *b)
+{
+    size_t i;
+
+    for (i = 0; i < SSL_SIGALG_WORDS; i++) {
+        if ((a[i] & b[i]) != 0)
+            return 1;
+    }
+    return 0;
+}
 /* Lookup hash: return 0 if invalid or not enabled */
 int tls1_lookup_md(const SIGALG_LOOKUP *lu, const EVP_MD **pmd)
 {
@@ -1140,6 +1719,68 @@ static int rsa_pss_check_min_key_size(const RSA *rsa, const SIGALG_LOOKUP *lu)
     return 1;
 }
 
+/*
+ * Work out which signature schemes the key of |cpk| can be used with and
+ * which schemes match the signature on its certificate. This is called
+ * whenever the certificate or key of |cpk| changes, so that choosing a
+ * signature algorithm during a handshake only needs to test bits instead of
+ * looking at the key and certificate for each candidate scheme.
+ */
+void tls1_set_cert_sigalgs(CERT_PKEY *cpk)
+{
+    const SIGALG_LOOKUP *lu;
+    EVP_PKEY *pkey = cpk->privatekey;
+    int mdnid, pknid, default_mdnid, mandatory_md, pkid;
+    size_t i;
+
+    memset(cpk->sigalgs, 0, sizeof(cpk->sigalgs));
+    memset(cpk->cert_sigalgs, 0, sizeof(cpk->cert_sigalgs));
+    cpk->curve = NID_undef;
+
+    /*
+     * TODO this does not differentiate between the rsa_pss_pss_* and
+     * rsa_pss_rsae_* schemes since we do not have a chain here that lets us
+     * look at the key OID in the signing certificate.
+     */
+    if (cpk->x509 != NULL
+            && X509_get_signature_info(cpk->x509, &mdnid, &pknid, NULL, NULL)) {
+        for (i = 0, lu = sigalg_lookup_tbl; i < OSSL_NELEM(sigalg_lookup_tbl);
+             i++, lu++) {
+            if (mdnid == lu->hash && pknid == lu->sig)
+                SIGALG_SET_BIT(cpk->cert_sigalgs, i);
+        }
+    }
+
+    if (pkey == NULL)
+        return;
+
+    /* If the EVP_PKEY reports a mandatory digest, allow nothing else. */
+    ERR_set_mark();
+    mandatory_md = EVP_PKEY_get_default_digest_nid(pkey, &default_mdnid) == 2;
+    ERR_pop_to_mark();
+
+    pkid = EVP_PKEY_id(pkey);
+#ifndef OPENSSL_NO_EC
+    if (pkid == EVP_PKEY_EC) {
+        EC_KEY *ec = EVP_PKEY_get0_EC_KEY(pkey);
+
+        cpk->curve = EC_GROUP_get_curve_name(EC_KEY_get0_group(ec));
+    }
+#endif
+
+    for (i = 0, lu = sigalg_lookup_tbl; i < OSSL_NELEM(sigalg_lookup_tbl);
+         i++, lu++) {
+        if (mandatory_md && lu->hash != default_mdnid)
+            continue;
+        /* validate that key is large enough for the signature algorithm */
+        if (lu->sig == EVP_PKEY_RSA_PSS
+                && ((pkid != EVP_PKEY_RSA && pkid != EVP_PKEY_RSA_PSS)
+                    || !rsa_pss_check_min_key_size(EVP_PKEY_get0(pkey), lu)))
+            continue;
+        SIGALG_SET_BIT(cpk->sigalgs, i);
+    }
+}
+
 /*
  * Returns a signature algorithm when the peer did not send a list of supported
  * signature algorithms. The signature algorithm is fixed for the certificate
@@ -1758,6 +2399,27 @@ SSL_TICKET_STATUS tls_decrypt_ticket(SSL *s, const unsigned char *etick,
         }
         if (rv == 2)
             renew_ticket = 1;
+    } else if (tctx->ext.tick_key_ring != NULL) {
+        SSL_TICKET_KEY key;
+        int rv = ssl_ticket_key_ring_find(tctx->ext.tick_key_ring, etick,
+                                          &key);
+
+        if (rv == 0) {
+            ret = SSL_TICKET_NO_DECRYPT;
+            goto end;
+        }
+        if (HMAC_Init_ex(hctx, key.hmac_key, sizeof(key.hmac_key),
+                         EVP_sha256(), NULL) <= 0
+            || EVP_DecryptInit_ex(ctx, EVP_aes_256_cbc(), NULL, key.aes_key,
+                                  etick + TLSEXT_KEYNAME_LENGTH) <= 0) {
+            OPENSSL_cleanse(&key, sizeof(key));
+            ret = SSL_TICKET_FATAL_ERR_OTHER;
+            goto end;
+        }
+        OPENSSL_cleanse(&key, sizeof(key));
+        /* Tickets under an older key are replaced by ones under the current */
+        if (rv == 2 || SSL_IS_TLS13(s))
+            renew_ticket = 1;
     } else {
         /* Check key name matches */
         if (memcmp(etick, tctx->ext.tick_key_name,
@@ -1765,9 +2427,7 @@ SSL_TICKET_STATUS tls_decrypt_ticket(SSL *s, const unsigned char *etick,
             ret = SSL_TICKET_NO_DECRYPT;
             goto end;
         }
-        if (HMAC_Init_ex(hctx, tctx->ext.secure->tick_hmac_key,
-                         sizeof(tctx->ext.secure->tick_hmac_key),
-                         EVP_sha256(), NULL) <= 0
+        if (HMAC_Init_key(hctx, tctx->ext.tick_hmac) <= 0
             || EVP_DecryptInit_ex(ctx, EVP_aes_256_cbc(), NULL,
                                   tctx->ext.secure->tick_aes_key,
                                   etick + TLSEXT_KEYNAME_LENGTH) <= 0) {
@@ -1835,6 +2495,19 @@ SSL_TICKET_STATUS tls_decrypt_ticket(SSL *s, const unsigned char *etick,
             ret = SSL_TICKET_NO_DECRYPT;
             goto end;
         }
+        /* Put back the peer certificate the ticket only has the digest of */
+        if (sess->peer_digest_len != 0) {
+            if (tctx->ext.tick_peer_cache == NULL
+                    || (sess->peer =
+                        ssl_peer_cert_cache_get(tctx->ext.tick_peer_cache,
+                                                sess->peer_digest)) == NULL) {
+                SSL_SESSION_free(sess);
+                sess = NULL;
+                ret = SSL_TICKET_NO_DECRYPT;
+                goto end;
+            }
+            sess->peer_digest_len = 0;
+        }
         /*
          * The session ID, if non-empty, is used by some clients to detect
          * that the ticket has been accepted. So we copy it to the session
@@ -2175,13 +2848,25 @@ int tls1_save_sigalgs(SSL *s, PACKET *pkt, int cert)
     if (s->cert == NULL)
         return 0;
 
-    if (cert)
-        return tls1_save_u16(pkt, &s->s3->tmp.peer_cert_sigalgs,
-                             &s->s3->tmp.peer_cert_sigalgslen);
-    else
-        return tls1_save_u16(pkt, &s->s3->tmp.peer_sigalgs,
-                             &s->s3->tmp.peer_sigalgslen);
+    if (cert) {
+        uint64_t *set = s->s3->tmp.peer_cert_sigalgs_set;
+        size_t i;
+
+        if (!tls1_save_u16(pkt, &s->s3->tmp.peer_cert_sigalgs,
+                           &s->s3->tmp.peer_cert_sigalgslen))
+            return 0;
+        memset(set, 0, sizeof(s->s3->tmp.peer_cert_sigalgs_set));
+        for (i = 0; i < s->s3->tmp.peer_cert_sigalgslen; i++) {
+            const SIGALG_LOOKUP *lu =
+                tls1_lookup_sigalg(s->s3->tmp.peer_cert_sigalgs[i]);
 
+            if (lu != NULL)
+                SIGALG_SET_BIT(set, lu - sigalg_lookup_tbl);
+        }
+        return 1;
+    }
+    return tls1_save_u16(pkt, &s->s3->tmp.peer_sigalgs,
+                         &s->s3->tmp.peer_sigalgslen);
 }
 
 /* Set preferred digest for each key type */
@@ -3002,20 +3687,31 @@ static int check_cert_usable(SSL *s, const SIGALG_LOOKUP *sig, X509 *x,
 /*
  * Returns true if |s| has a usable certificate configured for use
  * with signature scheme |sig|.
- * "Usable" includes a check for presence as well as applying
- * the signature_algorithm_cert restrictions sent by the peer (if any).
+ * "Usable" includes a check for presence, for RSA-PSS a check of the key
+ * size, as well as applying the signature_algorithm_cert restrictions sent
+ * by the peer (if any). These use the bitsets set up by
+ * tls1_set_cert_sigalgs() when the certificate was configured.
  * Returns false if no usable certificate is found.
  */
 static int has_usable_cert(SSL *s, const SIGALG_LOOKUP *sig, int idx)
 {
+    const CERT_PKEY *cpk;
+    int i;
+
     /* TLS 1.2 callers can override sig->sig_idx, but not TLS 1.3 callers. */
     if (idx == -1)
         idx = sig->sig_idx;
     if (!ssl_has_cert(s, idx))
         return 0;
 
-    return check_cert_usable(s, sig, s->cert->pkeys[idx].x509,
-                             s->cert->pkeys[idx].privatekey);
+    cpk = &s->cert->pkeys[idx];
+    if ((i = tls1_sigalg_index(sig)) == -1)
+        return check_cert_usable(s, sig, cpk->x509, cpk->privatekey);
+    if (!SIGALG_HAS_BIT(cpk->sigalgs, i))
+        return 0;
+    return s->s3->tmp.peer_cert_sigalgs == NULL
+           || tls1_sigalgs_intersect(cpk->cert_sigalgs,
+                                     s->s3->tmp.peer_cert_sigalgs_set);
 }
 
 /*
@@ -3049,7 +3745,6 @@ static const SIGALG_LOOKUP *find_sig_alg(SSL *s, X509 *x, EVP_PKEY *pkey)
 #ifndef OPENSSL_NO_EC
     int curve = -1;
 #endif
-    EVP_PKEY *tmppkey;
 
     /* Look for a shared sigalgs matching possible certificates */
     for (i = 0; i < s->shared_sigalgslen; i++) {
@@ -3064,17 +3759,29 @@ static const SIGALG_LOOKUP *find_sig_alg(SSL *s, X509 *x, EVP_PKEY *pkey)
         /* Check that we have a cert, and signature_algorithms_cert */
         if (!tls1_lookup_md(lu, NULL))
             continue;
-        if ((pkey == NULL && !has_usable_cert(s, lu, -1))
-                || (pkey != NULL && !is_cert_usable(s, lu, x, pkey)))
-            continue;
+        if (pkey == NULL) {
+            /* The key checks are part of has_usable_cert() */
+            if (!has_usable_cert(s, lu, -1))
+                continue;
+            if (lu->sig == EVP_PKEY_EC) {
+#ifndef OPENSSL_NO_EC
+                curve = s->cert->pkeys[lu->sig_idx].curve;
+                if (lu->curve != NID_undef && curve != lu->curve)
+                    continue;
+#else
+                continue;
+#endif
+            }
+            break;
+        }
 
-        tmppkey = (pkey != NULL) ? pkey
-                                 : s->cert->pkeys[lu->sig_idx].privatekey;
+        if (!is_cert_usable(s, lu, x, pkey))
+            continue;
 
         if (lu->sig == EVP_PKEY_EC) {
 #ifndef OPENSSL_NO_EC
             if (curve == -1) {
-                EC_KEY *ec = EVP_PKEY_get0_EC_KEY(tmppkey);
+                EC_KEY *ec = EVP_PKEY_get0_EC_KEY(pkey);
                 curve = EC_GROUP_get_curve_name(EC_KEY_get0_group(ec));
             }
             if (lu->curve != NID_undef && curve != lu->curve)
@@ -3084,7 +3791,7 @@ static const SIGALG_LOOKUP *find_sig_alg(SSL *s, X509 *x, EVP_PKEY *pkey)
 #endif
         } else if (lu->sig == EVP_PKEY_RSA_PSS) {
             /* validate that key is large enough for the signature algorithm */
-            if (!rsa_pss_check_min_key_size(EVP_PKEY_get0(tmppkey), lu))
+            if (!rsa_pss_check_min_key_size(EVP_PKEY_get0(pkey), lu))
                 continue;
         }
         break;
@@ -3139,8 +3846,7 @@ int tls_choose_sigalg(SSL *s, int fatalerrs)
 
                 /* For Suite B need to match signature algorithm to curve */
                 if (tls1_suiteb(s)) {
-                    EC_KEY *ec = EVP_PKEY_get0_EC_KEY(s->cert->pkeys[SSL_PKEY_ECC].privatekey);
-                    curve = EC_GROUP_get_curve_name(EC_KEY_get0_group(ec));
+                    curve = s->cert->pkeys[SSL_PKEY_ECC].curve;
                 } else {
                     curve = -1;
                 }
@@ -3163,16 +3869,12 @@ int tls_choose_sigalg(SSL *s, int fatalerrs)
                         if (cc_idx != sig_idx)
                             continue;
                     }
-                    /* Check that we have a cert, and sig_algs_cert */
+                    /*
+                     * Check that we have a cert, sig_algs_cert and a key
+                     * large enough for RSA-PSS
+                     */
                     if (!has_usable_cert(s, lu, sig_idx))
                         continue;
-                    if (lu->sig == EVP_PKEY_RSA_PSS) {
-                        /* validate that key is large enough for the signature algorithm */
-                        EVP_PKEY *pkey = s->cert->pkeys[sig_idx].privatekey;
-
-                        if (!rsa_pss_check_min_key_size(EVP_PKEY_get0(pkey), lu))
-                            continue;
-                    }
 #ifndef OPENSSL_NO_EC
                     if (curve == -1 || lu->curve == curve)
 #endif
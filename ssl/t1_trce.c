@@ -97,6 +97,7 @@ static const ssl_trace_tbl ssl_handshake_tbl[] = {
     {SSL3_MT_CERTIFICATE_STATUS, "CertificateStatus"},
     {SSL3_MT_SUPPLEMENTAL_DATA, "SupplementalData"},
     {SSL3_MT_KEY_UPDATE, "KeyUpdate"},
+    {SSL3_MT_COMPRESSED_CERTIFICATE, "CompressedCertificate"},
 # ifndef OPENSSL_NO_NEXTPROTONEG
     {SSL3_MT_NEXT_PROTO, "NextProto"},
 # endif
@@ -475,6 +476,8 @@ static const ssl_trace_tbl ssl_exts_tbl[] = {
     {TLSEXT_TYPE_padding, "padding"},
     {TLSEXT_TYPE_encrypt_then_mac, "encrypt_then_mac"},
     {TLSEXT_TYPE_extended_master_secret, "extended_master_secret"},
+    {TLSEXT_TYPE_cached_info, "cached_info"},
+    {TLSEXT_TYPE_compress_certificate, "compress_certificate"},
     {TLSEXT_TYPE_session_ticket, "session_ticket"},
     {TLSEXT_TYPE_psk, "psk"},
     {TLSEXT_TYPE_early_data, "early_data"},
@@ -548,21 +551,31 @@ static const ssl_trace_tbl ssl_groups_tbl[] = {
     {OQS_KEM_CURVEID(NID_hqc256), "hqc256"},
 ///// OQS_TEMPLATE_FRAGMENT_SSL_GROUPS_TBL_END
 ///// OQS_TEMPLATE_FRAGMENT_SSL_GROUPS_TBL_HYBRID_START
-    {OQS_KEM_CURVEID(NID_p256_frodo640aes), "p256 - frodo640aes hybrid"},
-    {OQS_KEM_CURVEID(NID_p256_frodo640shake), "p256 - frodo640shake hybrid"},
-    {OQS_KEM_CURVEID(NID_p384_frodo976aes), "p384 - frodo976aes hybrid"},
-    {OQS_KEM_CURVEID(NID_p384_frodo976shake), "p384 - frodo976shake hybrid"},
-    {OQS_KEM_CURVEID(NID_p521_frodo1344aes), "p521 - frodo1344aes hybrid"},
-    {OQS_KEM_CURVEID(NID_p521_frodo1344shake), "p521 - frodo1344shake hybrid"},
-    {OQS_KEM_CURVEID(NID_p256_kyber512), "p256 - kyber512 hybrid"},
-    {OQS_KEM_CURVEID(NID_p384_kyber768), "p384 - kyber768 hybrid"},
-    {OQS_KEM_CURVEID(NID_p521_kyber1024), "p521 - kyber1024 hybrid"},
-    {OQS_KEM_CURVEID(NID_p256_bikel1), "p256 - bikel1 hybrid"},
-    {OQS_KEM_CURVEID(NID_p384_bikel3), "p384 - bikel3 hybrid"},
-    {OQS_KEM_CURVEID(NID_p521_bikel5), "p521 - bikel5 hybrid"},
-    {OQS_KEM_CURVEID(NID_p256_hqc128), "p256 - hqc128 hybrid"},
-    {OQS_KEM_CURVEID(NID_p384_hqc192), "p384 - hqc192 hybrid"},
-    {OQS_KEM_CURVEID(NID_p521_hqc256), "p521 - hqc256 hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_p256_frodo640aes), "p256 - frodo640aes hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_p256_frodo640shake), "p256 - frodo640shake hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_p384_frodo976aes), "p384 - frodo976aes hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_p384_frodo976shake), "p384 - frodo976shake hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_p521_frodo1344aes), "p521 - frodo1344aes hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_p521_frodo1344shake), "p521 - frodo1344shake hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_p256_kyber512), "p256 - kyber512 hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_p384_kyber768), "p384 - kyber768 hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_p521_kyber1024), "p521 - kyber1024 hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_p256_bikel1), "p256 - bikel1 hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_p384_bikel3), "p384 - bikel3 hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_p521_bikel5), "p521 - bikel5 hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_p256_hqc128), "p256 - hqc128 hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_p384_hqc192), "p384 - hqc192 hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_p521_hqc256), "p521 - hqc256 hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_x25519_frodo640aes), "x25519 - frodo640aes hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_x25519_frodo640shake), "x25519 - frodo640shake hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_x448_frodo976aes), "x448 - frodo976aes hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_x448_frodo976shake), "x448 - frodo976shake hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_x25519_kyber512), "x25519 - kyber512 hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_x448_kyber768), "x448 - kyber768 hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_x25519_bikel1), "x25519 - bikel1 hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_x448_bikel3), "x448 - bikel3 hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_x25519_hqc128), "x25519 - hqc128 hybrid"},
+    {OQS_KEM_HYBRID_CURVEID(NID_x448_hqc192), "x448 - hqc192 hybrid"},
 ///// OQS_TEMPLATE_FRAGMENT_SSL_GROUPS_TBL_HYBRID_END
     {0xFF01, "arbitrary_explicit_prime_curves"},
     {0xFF02, "arbitrary_explicit_char2_curves"}
@@ -11,34 +11,94 @@
 #include "ssl_local.h"
 #include "internal/cryptlib.h"
 #include <openssl/evp.h>
-#include <openssl/kdf.h>
+#include <openssl/hmac.h>
 
 #define TLS13_MAX_LABEL_LEN     249
 
 /* Always filled with zeros */
 static const unsigned char default_zeros[EVP_MAX_MD_SIZE];
 
+#ifdef CHARSET_EBCDIC
+static const unsigned char keylabel[] = { 0x6B, 0x65, 0x79, 0x00 };
+static const unsigned char ivlabel[] = { 0x69, 0x76, 0x00 };
+static const unsigned char finishedlabel[] = { 0x66, 0x69, 0x6E, 0x69, 0x73, 0x68, 0x65, 0x64, 0x00 };
+#else
+static const unsigned char keylabel[] = "key";
+static const unsigned char ivlabel[] = "iv";
+static const unsigned char finishedlabel[] = "finished";
+#endif
+
 /*
- * Given a |secret|; a |label| of length |labellen|; and |data| of length
- * |datalen| (e.g. typically a hash of the handshake messages), derive a new
- * secret |outlen| bytes long and store it in the location pointed to be |out|.
- * The |data| value may be zero length. Any errors will be treated as fatal if
- * |fatal| is set. Returns 1 on success  0 on failure.
+ * Return the HMAC context of |s| keyed with the |keylen| bytes of |key| for
+ * |md|, or NULL on error. The context is kept for the lifetime of |s|, so
+ * the key schedule does not allocate a context for each derivation.
  */
-int tls13_hkdf_expand(SSL *s, const EVP_MD *md, const unsigned char *secret,
-                             const unsigned char *label, size_t labellen,
-                             const unsigned char *data, size_t datalen,
-                             unsigned char *out, size_t outlen, int fatal)
+static HMAC_CTX *tls13_hmac_key(SSL *s, const EVP_MD *md,
+                                const unsigned char *key, size_t keylen)
+{
+    if (s->hkdf_hmac == NULL && (s->hkdf_hmac = HMAC_CTX_new()) == NULL)
+        return NULL;
+    if (!HMAC_Init_ex(s->hkdf_hmac, key, (int)keylen, md, NULL))
+        return NULL;
+    return s->hkdf_hmac;
+}
+
+/*
+ * HKDF-Expand from the pseudorandom key |hmac| is keyed with, |hashlen| being
+ * the size of its digest. Returns 1 on success  0 on failure.
+ */
+static int tls13_hmac_expand(HMAC_CTX *hmac, size_t hashlen,
+                             const unsigned char *info, size_t infolen,
+                             unsigned char *out, size_t outlen)
+{
+    unsigned char prev[EVP_MAX_MD_SIZE];
+    unsigned char ctr;
+    size_t done, todo;
+    int ret = 0;
+
+    if (outlen > 255 * hashlen)
+        return 0;
+
+    for (ctr = 1, done = 0; done < outlen; ctr++, done += todo) {
+        /* Restart from the prepared inner state, without keying again */
+        if (!HMAC_Init_ex(hmac, NULL, 0, NULL, NULL)
+                || (ctr > 1 && !HMAC_Update(hmac, prev, hashlen))
+                || !HMAC_Update(hmac, info, infolen)
+                || !HMAC_Update(hmac, &ctr, 1)
+                || !HMAC_Final(hmac, prev, NULL))
+            goto err;
+        todo = outlen - done < hashlen ? outlen - done : hashlen;
+        memcpy(out + done, prev, todo);
+    }
+    ret = 1;
+ err:
+    OPENSSL_cleanse(prev, sizeof(prev));
+    return ret;
+}
+
+/*
+ * Given a |secret|, derive each of the |nlabels| outputs described by
+ * |labels|: for each one a secret |outlen| bytes long is derived from its
+ * |label| of length |labellen| and |data| of length |datalen| (e.g. typically
+ * a hash of the handshake messages) and stored in |out|. The |data| value may
+ * be zero length. |secret| is only turned into an HMAC key once for all the
+ * outputs. Any errors will be treated as fatal if |fatal| is set. Returns 1
+ * on success  0 on failure.
+ */
+int tls13_hkdf_expand_multi(SSL *s, const EVP_MD *md,
+                            const unsigned char *secret,
+                            const TLS13_HKDF_LABEL *labels, size_t nlabels,
+                            int fatal)
 {
 #ifdef CHARSET_EBCDIC
     static const unsigned char label_prefix[] = { 0x74, 0x6C, 0x73, 0x31, 0x33, 0x20, 0x00 };
 #else
     static const unsigned char label_prefix[] = "tls13 ";
 #endif
-    EVP_PKEY_CTX *pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, NULL);
-    int ret;
+    HMAC_CTX *hmac;
     size_t hkdflabellen;
     size_t hashlen;
+    size_t i;
     /*
      * 2 bytes for length of derived secret + 1 byte for length of combined
      * prefix and label + bytes for the label itself + 1 byte length of hash
@@ -49,64 +109,84 @@ int tls13_hkdf_expand(SSL *s, const EVP_MD *md, const unsigned char *secret,
                             + 1 + EVP_MAX_MD_SIZE];
     WPACKET pkt;
 
-    if (pctx == NULL)
-        return 0;
-
-    if (labellen > TLS13_MAX_LABEL_LEN) {
-        if (fatal) {
-            SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS13_HKDF_EXPAND,
-                     ERR_R_INTERNAL_ERROR);
-        } else {
-            /*
-             * Probably we have been called from SSL_export_keying_material(),
-             * or SSL_export_keying_material_early().
-             */
-            SSLerr(SSL_F_TLS13_HKDF_EXPAND, SSL_R_TLS_ILLEGAL_EXPORTER_LABEL);
+    for (i = 0; i < nlabels; i++) {
+        if (labels[i].labellen > TLS13_MAX_LABEL_LEN) {
+            if (fatal) {
+                SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS13_HKDF_EXPAND,
+                         ERR_R_INTERNAL_ERROR);
+            } else {
+                /*
+                 * Probably we have been called from
+                 * SSL_export_keying_material(), or
+                 * SSL_export_keying_material_early().
+                 */
+                SSLerr(SSL_F_TLS13_HKDF_EXPAND,
+                       SSL_R_TLS_ILLEGAL_EXPORTER_LABEL);
+            }
+            return 0;
         }
-        EVP_PKEY_CTX_free(pctx);
-        return 0;
     }
 
     hashlen = EVP_MD_size(md);
 
-    if (!WPACKET_init_static_len(&pkt, hkdflabel, sizeof(hkdflabel), 0)
-            || !WPACKET_put_bytes_u16(&pkt, outlen)
-            || !WPACKET_start_sub_packet_u8(&pkt)
-            || !WPACKET_memcpy(&pkt, label_prefix, sizeof(label_prefix) - 1)
-            || !WPACKET_memcpy(&pkt, label, labellen)
-            || !WPACKET_close(&pkt)
-            || !WPACKET_sub_memcpy_u8(&pkt, data, (data == NULL) ? 0 : datalen)
-            || !WPACKET_get_total_written(&pkt, &hkdflabellen)
-            || !WPACKET_finish(&pkt)) {
-        EVP_PKEY_CTX_free(pctx);
-        WPACKET_cleanup(&pkt);
-        if (fatal)
-            SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS13_HKDF_EXPAND,
-                     ERR_R_INTERNAL_ERROR);
-        else
-            SSLerr(SSL_F_TLS13_HKDF_EXPAND, ERR_R_INTERNAL_ERROR);
-        return 0;
+    if ((hmac = tls13_hmac_key(s, md, secret, hashlen)) == NULL)
+        goto err;
+
+    for (i = 0; i < nlabels; i++) {
+        const TLS13_HKDF_LABEL *l = &labels[i];
+
+        if (!WPACKET_init_static_len(&pkt, hkdflabel, sizeof(hkdflabel), 0)
+                || !WPACKET_put_bytes_u16(&pkt, l->outlen)
+                || !WPACKET_start_sub_packet_u8(&pkt)
+                || !WPACKET_memcpy(&pkt, label_prefix,
+                                   sizeof(label_prefix) - 1)
+                || !WPACKET_memcpy(&pkt, l->label, l->labellen)
+                || !WPACKET_close(&pkt)
+                || !WPACKET_sub_memcpy_u8(&pkt, l->data,
+                                          (l->data == NULL) ? 0 : l->datalen)
+                || !WPACKET_get_total_written(&pkt, &hkdflabellen)
+                || !WPACKET_finish(&pkt)) {
+            WPACKET_cleanup(&pkt);
+            goto err;
+        }
+
+        if (!tls13_hmac_expand(hmac, hashlen, hkdflabel, hkdflabellen,
+                               l->out, l->outlen))
+            goto err;
     }
 
-    ret = EVP_PKEY_derive_init(pctx) <= 0
-            || EVP_PKEY_CTX_hkdf_mode(pctx, EVP_PKEY_HKDEF_MODE_EXPAND_ONLY)
-               <= 0
-            || EVP_PKEY_CTX_set_hkdf_md(pctx, md) <= 0
-            || EVP_PKEY_CTX_set1_hkdf_key(pctx, secret, hashlen) <= 0
-            || EVP_PKEY_CTX_add1_hkdf_info(pctx, hkdflabel, hkdflabellen) <= 0
-            || EVP_PKEY_derive(pctx, out, &outlen) <= 0;
+    return 1;
+ err:
+    if (fatal)
+        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS13_HKDF_EXPAND,
+                 ERR_R_INTERNAL_ERROR);
+    else
+        SSLerr(SSL_F_TLS13_HKDF_EXPAND, ERR_R_INTERNAL_ERROR);
+    return 0;
+}
 
-    EVP_PKEY_CTX_free(pctx);
+/*
+ * Given a |secret|; a |label| of length |labellen|; and |data| of length
+ * |datalen| (e.g. typically a hash of the handshake messages), derive a new
+ * secret |outlen| bytes long and store it in the location pointed to be |out|.
+ * The |data| value may be zero length. Any errors will be treated as fatal if
+ * |fatal| is set. Returns 1 on success  0 on failure.
+ */
+int tls13_hkdf_expand(SSL *s, const EVP_MD *md, const unsigned char *secret,
+                             const unsigned char *label, size_t labellen,
+                             const unsigned char *data, size_t datalen,
+                             unsigned char *out, size_t outlen, int fatal)
+{
+    TLS13_HKDF_LABEL l;
 
-    if (ret != 0) {
-        if (fatal)
-            SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS13_HKDF_EXPAND,
-                     ERR_R_INTERNAL_ERROR);
-        else
-            SSLerr(SSL_F_TLS13_HKDF_EXPAND, ERR_R_INTERNAL_ERROR);
-    }
+    l.label = label;
+    l.labellen = labellen;
+    l.data = data;
+    l.datalen = datalen;
+    l.out = out;
+    l.outlen = outlen;
 
-    return ret == 0;
+    return tls13_hkdf_expand_multi(s, md, secret, &l, 1, fatal);
 }
 
 /*
@@ -116,12 +196,6 @@ int tls13_hkdf_expand(SSL *s, const EVP_MD *md, const unsigned char *secret,
 int tls13_derive_key(SSL *s, const EVP_MD *md, const unsigned char *secret,
                      unsigned char *key, size_t keylen)
 {
-#ifdef CHARSET_EBCDIC
-  static const unsigned char keylabel[] ={ 0x6B, 0x65, 0x79, 0x00 };
-#else
-  static const unsigned char keylabel[] = "key";
-#endif
-
     return tls13_hkdf_expand(s, md, secret, keylabel, sizeof(keylabel) - 1,
                              NULL, 0, key, keylen, 1);
 }
@@ -133,12 +207,6 @@ int tls13_derive_key(SSL *s, const EVP_MD *md, const unsigned char *secret,
 int tls13_derive_iv(SSL *s, const EVP_MD *md, const unsigned char *secret,
                     unsigned char *iv, size_t ivlen)
 {
-#ifdef CHARSET_EBCDIC
-  static const unsigned char ivlabel[] = { 0x69, 0x76, 0x00 };
-#else
-  static const unsigned char ivlabel[] = "iv";
-#endif
-
     return tls13_hkdf_expand(s, md, secret, ivlabel, sizeof(ivlabel) - 1,
                              NULL, 0, iv, ivlen, 1);
 }
@@ -147,12 +215,6 @@ int tls13_derive_finishedkey(SSL *s, const EVP_MD *md,
                              const unsigned char *secret,
                              unsigned char *fin, size_t finlen)
 {
-#ifdef CHARSET_EBCDIC
-  static const unsigned char finishedlabel[] = { 0x66, 0x69, 0x6E, 0x69, 0x73, 0x68, 0x65, 0x64, 0x00 };
-#else
-  static const unsigned char finishedlabel[] = "finished";
-#endif
-
     return tls13_hkdf_expand(s, md, secret, finishedlabel,
                              sizeof(finishedlabel) - 1, NULL, 0, fin, finlen, 1);
 }
@@ -171,7 +233,7 @@ int tls13_generate_secret(SSL *s, const EVP_MD *md,
     size_t mdlen, prevsecretlen;
     int mdleni;
     int ret;
-    EVP_PKEY_CTX *pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, NULL);
+    HMAC_CTX *hmac;
 #ifdef CHARSET_EBCDIC
     static const char derived_secret_label[] = { 0x64, 0x65, 0x72, 0x69, 0x76, 0x65, 0x64, 0x00 };
 #else
@@ -179,18 +241,11 @@ int tls13_generate_secret(SSL *s, const EVP_MD *md,
 #endif
     unsigned char preextractsec[EVP_MAX_MD_SIZE];
 
-    if (pctx == NULL) {
-        SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS13_GENERATE_SECRET,
-                 ERR_R_INTERNAL_ERROR);
-        return 0;
-    }
-
     mdleni = EVP_MD_size(md);
     /* Ensure cast to size_t is safe */
     if (!ossl_assert(mdleni >= 0)) {
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS13_GENERATE_SECRET,
                  ERR_R_INTERNAL_ERROR);
-        EVP_PKEY_CTX_free(pctx);
         return 0;
     }
     mdlen = (size_t)mdleni;
@@ -213,7 +268,6 @@ int tls13_generate_secret(SSL *s, const EVP_MD *md,
             SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS13_GENERATE_SECRET,
                      ERR_R_INTERNAL_ERROR);
             EVP_MD_CTX_free(mctx);
-            EVP_PKEY_CTX_free(pctx);
             return 0;
         }
         EVP_MD_CTX_free(mctx);
@@ -224,7 +278,6 @@ int tls13_generate_secret(SSL *s, const EVP_MD *md,
                                sizeof(derived_secret_label) - 1, hash, mdlen,
                                preextractsec, mdlen, 1)) {
             /* SSLfatal() already called */
-            EVP_PKEY_CTX_free(pctx);
             return 0;
         }
 
@@ -232,21 +285,15 @@ int tls13_generate_secret(SSL *s, const EVP_MD *md,
         prevsecretlen = mdlen;
     }
 
-    ret = EVP_PKEY_derive_init(pctx) <= 0
-            || EVP_PKEY_CTX_hkdf_mode(pctx, EVP_PKEY_HKDEF_MODE_EXTRACT_ONLY)
-               <= 0
-            || EVP_PKEY_CTX_set_hkdf_md(pctx, md) <= 0
-            || EVP_PKEY_CTX_set1_hkdf_key(pctx, insecret, insecretlen) <= 0
-            || EVP_PKEY_CTX_set1_hkdf_salt(pctx, prevsecret, prevsecretlen)
-               <= 0
-            || EVP_PKEY_derive(pctx, outsecret, &mdlen)
-               <= 0;
+    /* HKDF-Extract is an HMAC of the input secret keyed with the salt */
+    ret = (hmac = tls13_hmac_key(s, md, prevsecret, prevsecretlen)) == NULL
+            || !HMAC_Update(hmac, insecret, insecretlen)
+            || !HMAC_Final(hmac, outsecret, NULL);
 
     if (ret != 0)
         SSLfatal(s, SSL_AD_INTERNAL_ERROR, SSL_F_TLS13_GENERATE_SECRET,
                  ERR_R_INTERNAL_ERROR);
 
-    EVP_PKEY_CTX_free(pctx);
     if (prevsecret == preextractsec)
         OPENSSL_cleanse(preextractsec, mdlen);
     return ret == 0;
@@ -364,9 +411,11 @@ static int derive_secret_key_and_iv(SSL *s, int sending, const EVP_MD *md,
                                     const unsigned char *hash,
                                     const unsigned char *label,
                                     size_t labellen, unsigned char *secret,
-                                    unsigned char *iv, EVP_CIPHER_CTX *ciph_ctx)
+                                    unsigned char *key, unsigned char *iv,
+                                    unsigned char *fin, size_t finlen,
+                                    EVP_CIPHER_CTX *ciph_ctx)
 {
-    unsigned char key[EVP_MAX_KEY_LENGTH];
+    TLS13_HKDF_LABEL labels[3];
     size_t ivlen, keylen, taglen;
     int hashleni = EVP_MD_size(md);
     size_t hashlen;
@@ -413,8 +462,22 @@ static int derive_secret_key_and_iv(SSL *s, int sending, const EVP_MD *md,
         taglen = 0;
     }
 
-    if (!tls13_derive_key(s, md, secret, key, keylen)
-            || !tls13_derive_iv(s, md, secret, iv, ivlen)) {
+    /* The key, the IV and any finished key all come from |secret| */
+    memset(labels, 0, sizeof(labels));
+    labels[0].label = keylabel;
+    labels[0].labellen = sizeof(keylabel) - 1;
+    labels[0].out = key;
+    labels[0].outlen = keylen;
+    labels[1].label = ivlabel;
+    labels[1].labellen = sizeof(ivlabel) - 1;
+    labels[1].out = iv;
+    labels[1].outlen = ivlen;
+    labels[2].label = finishedlabel;
+    labels[2].labellen = sizeof(finishedlabel) - 1;
+    labels[2].out = fin;
+    labels[2].outlen = finlen;
+    if (!tls13_hkdf_expand_multi(s, md, secret, labels, fin != NULL ? 3 : 2,
+                                 1)) {
         /* SSLfatal() already called */
         goto err;
     }
@@ -431,7 +494,7 @@ static int derive_secret_key_and_iv(SSL *s, int sending, const EVP_MD *md,
 
     return 1;
  err:
-    OPENSSL_cleanse(key, sizeof(key));
+    OPENSSL_cleanse(key, EVP_MAX_KEY_LENGTH);
     return 0;
 }
 
@@ -457,6 +520,7 @@ int tls13_change_cipher_state(SSL *s, int which)
     static const unsigned char early_exporter_master_secret[] = "e exp master";
 #endif
     unsigned char *iv;
+    unsigned char key[EVP_MAX_KEY_LENGTH];
     unsigned char secret[EVP_MAX_MD_SIZE];
     unsigned char hashval[EVP_MAX_MD_SIZE];
     unsigned char *hash = hashval;
@@ -507,10 +571,6 @@ int tls13_change_cipher_state(SSL *s, int which)
     if (((which & SSL3_CC_CLIENT) && (which & SSL3_CC_WRITE))
             || ((which & SSL3_CC_SERVER) && (which & SSL3_CC_READ))) {
         if (which & SSL3_CC_EARLY) {
-            EVP_MD_CTX *mdctx = NULL;
-            long handlen;
-            void *hdata;
-            unsigned int hashlenui;
             const SSL_CIPHER *sslcipher = SSL_SESSION_get0_cipher(s->session);
 
             insecret = s->early_secret;
@@ -518,14 +578,6 @@ int tls13_change_cipher_state(SSL *s, int which)
             labellen = sizeof(client_early_traffic) - 1;
             log_label = CLIENT_EARLY_LABEL;
 
-            handlen = BIO_get_mem_data(s->s3->handshake_buffer, &hdata);
-            if (handlen <= 0) {
-                SSLfatal(s, SSL_AD_INTERNAL_ERROR,
-                         SSL_F_TLS13_CHANGE_CIPHER_STATE,
-                         SSL_R_BAD_HANDSHAKE_LENGTH);
-                goto err;
-            }
-
             if (s->early_data_state == SSL_EARLY_DATA_CONNECTING
                     && s->max_early_data > 0
                     && s->session->ext.max_early_data == 0) {
@@ -555,24 +607,12 @@ int tls13_change_cipher_state(SSL *s, int which)
              * the session. We haven't yet selected our ciphersuite so we can't
              * use ssl_handshake_md().
              */
-            mdctx = EVP_MD_CTX_new();
-            if (mdctx == NULL) {
-                SSLfatal(s, SSL_AD_INTERNAL_ERROR,
-                         SSL_F_TLS13_CHANGE_CIPHER_STATE, ERR_R_MALLOC_FAILURE);
-                goto err;
-            }
             cipher = EVP_get_cipherbynid(SSL_CIPHER_get_cipher_nid(sslcipher));
             md = ssl_md(sslcipher->algorithm2);
-            if (md == NULL || !EVP_DigestInit_ex(mdctx, md, NULL)
-                    || !EVP_DigestUpdate(mdctx, hdata, handlen)
-                    || !EVP_DigestFinal_ex(mdctx, hashval, &hashlenui)) {
-                SSLfatal(s, SSL_AD_INTERNAL_ERROR,
-                         SSL_F_TLS13_CHANGE_CIPHER_STATE, ERR_R_INTERNAL_ERROR);
-                EVP_MD_CTX_free(mdctx);
+            if (!ssl3_digest_cached_records_md(s, md, hashval, &hashlen)) {
+                /* SSLfatal() already called */
                 goto err;
             }
-            hashlen = hashlenui;
-            EVP_MD_CTX_free(mdctx);
 
             if (!tls13_hkdf_expand(s, md, insecret,
                                    early_exporter_master_secret,
@@ -673,8 +713,8 @@ int tls13_change_cipher_state(SSL *s, int which)
     }
 
     if (!derive_secret_key_and_iv(s, which & SSL3_CC_WRITE, md, cipher,
-                                  insecret, hash, label, labellen, secret, iv,
-                                  ciph_ctx)) {
+                                  insecret, hash, label, labellen, secret, key,
+                                  iv, finsecret, finsecretlen, ciph_ctx)) {
         /* SSLfatal() already called */
         goto err;
     }
@@ -704,12 +744,14 @@ int tls13_change_cipher_state(SSL *s, int which)
         goto err;
     }
 
-    if (finsecret != NULL
-            && !tls13_derive_finishedkey(s, ssl_handshake_md(s), secret,
-                                         finsecret, finsecretlen)) {
+#ifndef OPENSSL_NO_KTLS
+    /* Only the application traffic keys are ever handed to the kernel */
+    if ((which & SSL3_CC_WRITE) && (which & SSL3_CC_APPLICATION)
+            && !ssl_ktls_start_tx(s, cipher, ciph_ctx, key, iv)) {
         /* SSLfatal() already called */
         goto err;
     }
+#endif
 
     if (!s->server && label == client_early_traffic)
         s->statem.enc_write_state = ENC_WRITE_STATE_WRITE_PLAIN_ALERTS;
@@ -717,6 +759,7 @@ int tls13_change_cipher_state(SSL *s, int which)
         s->statem.enc_write_state = ENC_WRITE_STATE_VALID;
     ret = 1;
  err:
+    OPENSSL_cleanse(key, sizeof(key));
     OPENSSL_cleanse(secret, sizeof(secret));
     return ret;
 }
@@ -731,6 +774,7 @@ int tls13_update_key(SSL *s, int sending)
     const EVP_MD *md = ssl_handshake_md(s);
     size_t hashlen = EVP_MD_size(md);
     unsigned char *insecret, *iv;
+    unsigned char key[EVP_MAX_KEY_LENGTH];
     unsigned char secret[EVP_MAX_MD_SIZE];
     EVP_CIPHER_CTX *ciph_ctx;
     int ret = 0;
@@ -754,17 +798,26 @@ int tls13_update_key(SSL *s, int sending)
     if (!derive_secret_key_and_iv(s, sending, ssl_handshake_md(s),
                                   s->s3->tmp.new_sym_enc, insecret, NULL,
                                   application_traffic,
-                                  sizeof(application_traffic) - 1, secret, iv,
-                                  ciph_ctx)) {
+                                  sizeof(application_traffic) - 1, secret, key,
+                                  iv, NULL, 0, ciph_ctx)) {
         /* SSLfatal() already called */
         goto err;
     }
 
     memcpy(insecret, secret, hashlen);
 
+#ifndef OPENSSL_NO_KTLS
+    if (sending && !ssl_ktls_start_tx(s, s->s3->tmp.new_sym_enc, ciph_ctx,
+                                      key, iv)) {
+        /* SSLfatal() already called */
+        goto err;
+    }
+#endif
+
     s->statem.enc_write_state = ENC_WRITE_STATE_VALID;
     ret = 1;
  err:
+    OPENSSL_cleanse(key, sizeof(key));
     OPENSSL_cleanse(secret, sizeof(secret));
     return ret;
 }
@@ -112,6 +112,155 @@ static int test_pr16743(void)
     return ret;
 }
 
+/*
+ * Compares the engine's AES-GCM with the built-in one, if it provides it,
+ * with the text split across updates and the tag checked by the final call
+ */
+static int test_afalg_aes_gcm(int keysize_idx)
+{
+    EVP_CIPHER_CTX *ctx = NULL;
+    const EVP_CIPHER *cipher;
+    unsigned char key[32], iv[12], aad[20], in[BUFFER_SIZE];
+    unsigned char ebuf[BUFFER_SIZE], dbuf[BUFFER_SIZE], sbuf[BUFFER_SIZE];
+    unsigned char tag[16], stag[16];
+    int encl, encl2, encf, decl, decl2, decf, sl, sf;
+    int ret = 0;
+
+    switch (keysize_idx) {
+        case 0:
+            cipher = EVP_aes_128_gcm();
+            break;
+        case 1:
+            cipher = EVP_aes_192_gcm();
+            break;
+        default:
+            cipher = EVP_aes_256_gcm();
+    }
+    if (!TEST_true(ENGINE_init(e)))
+        return 0;
+    if (ENGINE_get_cipher(e, EVP_CIPHER_nid(cipher)) == NULL) {
+        TEST_info("AFALG engine has no %s", OBJ_nid2sn(EVP_CIPHER_nid(cipher)));
+        ENGINE_finish(e);
+        return 1;
+    }
+    memset(key, 0x5a, sizeof(key));
+    memset(iv, 0xa5, sizeof(iv));
+    memset(aad, 0x3c, sizeof(aad));
+    memset(in, 0xc3, sizeof(in));
+
+    if (!TEST_ptr(ctx = EVP_CIPHER_CTX_new())
+            || !TEST_true(EVP_EncryptInit_ex(ctx, cipher, NULL, key, iv))
+            || !TEST_true(EVP_EncryptUpdate(ctx, NULL, &sl, aad, sizeof(aad)))
+            || !TEST_true(EVP_EncryptUpdate(ctx, sbuf, &sl, in, sizeof(in)))
+            || !TEST_true(EVP_EncryptFinal_ex(ctx, sbuf + sl, &sf))
+            || !TEST_true(EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG,
+                                              sizeof(stag), stag)))
+        goto end;
+
+    if (!TEST_true(EVP_CIPHER_CTX_reset(ctx))
+            || !TEST_true(EVP_EncryptInit_ex(ctx, cipher, e, key, iv))
+            || !TEST_true(EVP_EncryptUpdate(ctx, NULL, &encl, aad, sizeof(aad)))
+            || !TEST_true(EVP_EncryptUpdate(ctx, ebuf, &encl, in, 5))
+            || !TEST_true(EVP_EncryptUpdate(ctx, ebuf + encl, &encl2, in + 5,
+                                            sizeof(in) - 5))
+            || !TEST_true(EVP_EncryptFinal_ex(ctx, ebuf + encl + encl2, &encf))
+            || !TEST_true(EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG,
+                                              sizeof(tag), tag)))
+        goto end;
+    encl += encl2 + encf;
+    if (!TEST_mem_eq(ebuf, encl, sbuf, sl + sf)
+            || !TEST_mem_eq(tag, sizeof(tag), stag, sizeof(stag)))
+        goto end;
+
+    /* The tag may be set once the text has been passed */
+    if (!TEST_true(EVP_CIPHER_CTX_reset(ctx))
+            || !TEST_true(EVP_DecryptInit_ex(ctx, cipher, e, key, iv))
+            || !TEST_true(EVP_DecryptUpdate(ctx, NULL, &decl, aad, sizeof(aad)))
+            || !TEST_true(EVP_DecryptUpdate(ctx, dbuf, &decl, ebuf, 11))
+            || !TEST_true(EVP_DecryptUpdate(ctx, dbuf + decl, &decl2, ebuf + 11,
+                                            encl - 11))
+            || !TEST_true(EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG,
+                                              sizeof(tag), tag))
+            || !TEST_true(EVP_DecryptFinal_ex(ctx, dbuf + decl + decl2, &decf)))
+        goto end;
+    decl += decl2 + decf;
+    if (!TEST_mem_eq(dbuf, decl, in, sizeof(in)))
+        goto end;
+
+    /* A modified tag must be rejected by the final call */
+    tag[0] ^= 1;
+    if (!TEST_true(EVP_CIPHER_CTX_reset(ctx))
+            || !TEST_true(EVP_DecryptInit_ex(ctx, cipher, e, key, iv))
+            || !TEST_true(EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG,
+                                              sizeof(tag), tag))
+            || !TEST_true(EVP_DecryptUpdate(ctx, NULL, &decl, aad, sizeof(aad)))
+            || !TEST_true(EVP_DecryptUpdate(ctx, dbuf, &decl, ebuf, encl))
+            || !TEST_false(EVP_DecryptFinal_ex(ctx, dbuf + decl, &decf)))
+        goto end;
+
+    ret = 1;
+
+ end:
+    EVP_CIPHER_CTX_free(ctx);
+    ENGINE_finish(e);
+    return ret;
+}
+
+/* Compares the engine's digests with the built-in ones, across a copy */
+static int test_afalg_digests(int idx)
+{
+    static const int nids[] = { NID_sha1, NID_sha256, NID_sha512 };
+    const EVP_MD *md = EVP_get_digestbynid(nids[idx]);
+    EVP_MD_CTX *ctx = NULL, *dup = NULL;
+    unsigned char in[3 * BUFFER_SIZE];
+    unsigned char sw[EVP_MAX_MD_SIZE], hw[EVP_MAX_MD_SIZE];
+    unsigned char hwdup[EVP_MAX_MD_SIZE];
+    unsigned int swl, hwl, hwdupl;
+    int ret = 0;
+
+    if (!TEST_true(ENGINE_init(e)))
+        return 0;
+    if (ENGINE_get_digest(e, nids[idx]) == NULL) {
+        TEST_info("AFALG engine has no %s", OBJ_nid2sn(nids[idx]));
+        ENGINE_finish(e);
+        return 1;
+    }
+    memset(in, 0x61, sizeof(in));
+
+    if (!TEST_true(EVP_Digest(in, sizeof(in), sw, &swl, md, NULL))
+            || !TEST_ptr(ctx = EVP_MD_CTX_new())
+            || !TEST_ptr(dup = EVP_MD_CTX_new())
+            || !TEST_true(EVP_DigestInit_ex(ctx, md, e))
+            || !TEST_true(EVP_DigestUpdate(ctx, in, BUFFER_SIZE))
+            || !TEST_true(EVP_MD_CTX_copy_ex(dup, ctx))
+            || !TEST_true(EVP_DigestUpdate(ctx, in + BUFFER_SIZE,
+                                           sizeof(in) - BUFFER_SIZE))
+            || !TEST_true(EVP_DigestFinal_ex(ctx, hw, &hwl))
+            || !TEST_true(EVP_DigestUpdate(dup, in + BUFFER_SIZE,
+                                           sizeof(in) - BUFFER_SIZE))
+            || !TEST_true(EVP_DigestFinal_ex(dup, hwdup, &hwdupl)))
+        goto end;
+
+    if (!TEST_mem_eq(hw, hwl, sw, swl)
+            || !TEST_mem_eq(hwdup, hwdupl, sw, swl))
+        goto end;
+
+    /* The context is reusable once its digest has been read */
+    if (!TEST_true(EVP_DigestInit_ex(ctx, md, e))
+            || !TEST_true(EVP_DigestUpdate(ctx, in, sizeof(in)))
+            || !TEST_true(EVP_DigestFinal_ex(ctx, hw, &hwl))
+            || !TEST_mem_eq(hw, hwl, sw, swl))
+        goto end;
+
+    ret = 1;
+
+ end:
+    EVP_MD_CTX_free(ctx);
+    EVP_MD_CTX_free(dup);
+    ENGINE_finish(e);
+    return ret;
+}
+
 int global_init(void)
 {
     ENGINE_load_builtin_engines();
@@ -131,6 +280,8 @@ int setup_tests(void)
     } else {
         ADD_ALL_TESTS(test_afalg_aes_cbc, 3);
         ADD_TEST(test_pr16743);
+        ADD_ALL_TESTS(test_afalg_aes_gcm, 3);
+        ADD_ALL_TESTS(test_afalg_digests, 3);
     }
 #endif
 
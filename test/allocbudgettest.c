@@ -0,0 +1,322 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Counts the allocations of a few canonical TLS scenarios and checks them
+ * against the budgets in a file, so that work to remove allocations does not
+ * silently regress. Each scenario is run once to warm up the lazily
+ * initialised tables, and counted on its second run.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <openssl/crypto.h>
+#include <openssl/ssl.h>
+#include <oqs/oqs.h>
+
+#include "internal/nelem.h"
+#include "ssltestlib.h"
+#include "testutil.h"
+
+#define TRANSFER_LEN    (1024 * 1024)
+#define TRANSFER_CHUNK  16384
+
+static char *cert = NULL;
+static char *privkey = NULL;
+
+typedef struct {
+    size_t mallocs;
+    size_t reallocs;
+    size_t frees;
+    size_t bytes;
+} ALLOC_COUNTS;
+
+static ALLOC_COUNTS counts;
+static int counting = 0;
+
+static void *count_malloc(size_t num, const char *file, int line)
+{
+    if (counting) {
+        counts.mallocs++;
+        counts.bytes += num;
+    }
+    return malloc(num);
+}
+
+static void *count_realloc(void *ptr, size_t num, const char *file, int line)
+{
+    if (counting) {
+        counts.reallocs++;
+        counts.bytes += num;
+    }
+    return realloc(ptr, num);
+}
+
+static void count_free(void *ptr, const char *file, int line)
+{
+    if (counting && ptr != NULL)
+        counts.frees++;
+    free(ptr);
+}
+
+static void count_start(void)
+{
+    memset(&counts, 0, sizeof(counts));
+    counting = 1;
+}
+
+static void count_stop(void)
+{
+    counting = 0;
+}
+
+/*-
+ * Budgets, read from a file of lines
+ *     name mallocs reallocs bytes
+ * where blank lines and lines starting with '#' are skipped.
+ */
+typedef struct {
+    char name[64];
+    unsigned long mallocs;
+    unsigned long reallocs;
+    unsigned long bytes;
+} BUDGET;
+
+static BUDGET budgets[16];
+static size_t num_budgets = 0;
+
+static int read_budgets(const char *path)
+{
+    FILE *f;
+    char line[256];
+    BUDGET *b;
+    int ret = 0;
+
+    if (!TEST_ptr(f = fopen(path, "r")))
+        return 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (line[0] == '#' || line[0] == '\n')
+            continue;
+        if (!TEST_size_t_lt(num_budgets, OSSL_NELEM(budgets)))
+            goto end;
+        b = &budgets[num_budgets++];
+        if (!TEST_int_eq(sscanf(line, "%63s %lu %lu %lu", b->name,
+                                &b->mallocs, &b->reallocs, &b->bytes), 4))
+            goto end;
+    }
+    ret = 1;
+ end:
+    fclose(f);
+    return ret;
+}
+
+/* Checks |counts| of |name| against its budget */
+static int check_budget(const char *name)
+{
+    const BUDGET *b = NULL;
+    size_t i;
+
+    TEST_info("%s %lu %lu %lu, and %lu frees", name,
+              (unsigned long)counts.mallocs, (unsigned long)counts.reallocs,
+              (unsigned long)counts.bytes, (unsigned long)counts.frees);
+    for (i = 0; i < num_budgets; i++)
+        if (strcmp(budgets[i].name, name) == 0)
+            b = &budgets[i];
+    if (b == NULL) {
+        TEST_note("%s has no budget", name);
+        return 1;
+    }
+    if (!TEST_ulong_le((unsigned long)counts.mallocs, b->mallocs)
+            || !TEST_ulong_le((unsigned long)counts.reallocs, b->reallocs)
+            || !TEST_ulong_le((unsigned long)counts.bytes, b->bytes))
+        return 0;
+    if (counts.mallocs + counts.reallocs < (b->mallocs + b->reallocs) * 9 / 10)
+        TEST_note("%s is well within its budget, which could be lowered",
+                  name);
+    return 1;
+}
+
+static int make_ctx_pair(const char *groups, SSL_CTX **sctx, SSL_CTX **cctx)
+{
+    *sctx = *cctx = NULL;
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(), TLS1_3_VERSION,
+                                       TLS1_3_VERSION, sctx, cctx, cert,
+                                       privkey)))
+        return 0;
+    if (TEST_true(SSL_CTX_set1_groups_list(*sctx, groups))
+            && TEST_true(SSL_CTX_set1_groups_list(*cctx, groups)))
+        return 1;
+    SSL_CTX_free(*sctx);
+    SSL_CTX_free(*cctx);
+    *sctx = *cctx = NULL;
+    return 0;
+}
+
+/* A full handshake, or a resumption of |sess|, from SSL_new() to SSL_free() */
+static int handshake(SSL_CTX *sctx, SSL_CTX *cctx, SSL_SESSION *sess)
+{
+    SSL *serverssl = NULL, *clientssl = NULL;
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || (sess != NULL && !TEST_true(SSL_set_session(clientssl, sess)))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_int_eq(SSL_session_reused(clientssl), sess != NULL)) {
+        SSL_free(serverssl);
+        SSL_free(clientssl);
+        return 0;
+    }
+    shutdown_ssl_connection(serverssl, clientssl);
+    return 1;
+}
+
+static const struct {
+    const char *group;
+    /* The OQS KEM that the group needs, or NULL */
+    const char *kem;
+} handshake_groups[] = {
+    { "X25519", NULL },
+    { "p384_kyber768", OQS_KEM_alg_kyber_768 }
+};
+
+static int test_handshake(int idx)
+{
+    SSL_CTX *sctx, *cctx;
+    char name[64];
+    int ret;
+
+    if (handshake_groups[idx].kem != NULL
+            && !OQS_KEM_alg_is_enabled(handshake_groups[idx].kem)) {
+        TEST_info("Skipping: %s is not enabled", handshake_groups[idx].kem);
+        return 1;
+    }
+    BIO_snprintf(name, sizeof(name), "handshake_%s",
+                 handshake_groups[idx].group);
+    if (!TEST_true(make_ctx_pair(handshake_groups[idx].group, &sctx, &cctx)))
+        return 0;
+    ret = 0;
+    if (!handshake(sctx, cctx, NULL))
+        goto end;
+    count_start();
+    if (!handshake(sctx, cctx, NULL))
+        goto end;
+    count_stop();
+    ret = check_budget(name);
+
+ end:
+    count_stop();
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return ret;
+}
+
+static int test_resumption(void)
+{
+    SSL_CTX *sctx, *cctx;
+    SSL *serverssl = NULL, *clientssl = NULL;
+    SSL_SESSION *sess = NULL;
+    int ret = 0;
+
+    if (!TEST_true(make_ctx_pair("X25519", &sctx, &cctx)))
+        return 0;
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_ptr(sess = SSL_get1_session(clientssl)))
+        goto end;
+    shutdown_ssl_connection(serverssl, clientssl);
+    serverssl = clientssl = NULL;
+
+    if (!handshake(sctx, cctx, sess))
+        goto end;
+    count_start();
+    if (!handshake(sctx, cctx, sess))
+        goto end;
+    count_stop();
+    ret = check_budget("resumption");
+
+ end:
+    count_stop();
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_SESSION_free(sess);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return ret;
+}
+
+/* 1 MB from the client to the server over an established connection */
+static int transfer(SSL *from, SSL *to)
+{
+    static unsigned char buf[TRANSFER_CHUNK];
+    size_t total, written, readbytes;
+
+    for (total = 0; total < TRANSFER_LEN; total += sizeof(buf)) {
+        if (!TEST_true(SSL_write_ex(from, buf, sizeof(buf), &written))
+                || !TEST_size_t_eq(written, sizeof(buf))
+                || !TEST_true(SSL_read_ex(to, buf, sizeof(buf), &readbytes))
+                || !TEST_size_t_eq(readbytes, sizeof(buf)))
+            return 0;
+    }
+    return 1;
+}
+
+static int test_transfer(void)
+{
+    SSL_CTX *sctx, *cctx;
+    SSL *serverssl = NULL, *clientssl = NULL;
+    int ret = 0;
+
+    if (!TEST_true(make_ctx_pair("X25519", &sctx, &cctx)))
+        return 0;
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !transfer(clientssl, serverssl))
+        goto end;
+    count_start();
+    if (!transfer(clientssl, serverssl))
+        goto end;
+    count_stop();
+    ret = check_budget("transfer_1mb");
+
+ end:
+    count_stop();
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return ret;
+}
+
+int global_init(void)
+{
+    return CRYPTO_set_mem_functions(count_malloc, count_realloc, count_free);
+}
+
+int setup_tests(void)
+{
+    const char *budgetfile;
+
+    if (!TEST_ptr(cert = test_get_argument(0))
+            || !TEST_ptr(privkey = test_get_argument(1))
+            || !TEST_ptr(budgetfile = test_get_argument(2))
+            || !read_budgets(budgetfile))
+        return 0;
+
+    ADD_ALL_TESTS(test_handshake, OSSL_NELEM(handshake_groups));
+    ADD_TEST(test_resumption);
+    ADD_TEST(test_transfer);
+    return 1;
+}
@@ -133,10 +133,54 @@ static int test_nid2obj_nonexist(void)
     return 1;
 }
 
+/**********************************************************************
+ *
+ * Test of the perfect hash of the built-in OIDs used by OBJ_obj2nid
+ *
+ ***/
+static int test_obj2nid_all(void)
+{
+    static const unsigned char unknown[] = {
+        0x2B, 0x06, 0x01, 0x04, 0x01, 0x82, 0x37, 0x7F, 0x7F
+    };
+    const ASN1_OBJECT *builtin;
+    ASN1_OBJECT *obj;
+    int nid, num = OBJ_new_nid(0), ok = 1;
+
+    for (nid = 1; nid < num; nid++) {
+        if ((builtin = OBJ_nid2obj(nid)) == NULL || OBJ_length(builtin) == 0)
+            continue;
+        /* A copy of the encoding, with no NID to short-circuit the lookup */
+        if (!TEST_ptr(obj = ASN1_OBJECT_create(NID_undef,
+                                               (unsigned char *)
+                                               OBJ_get0_data(builtin),
+                                               OBJ_length(builtin),
+                                               NULL, NULL)))
+            return 0;
+        /* Several names for the same OID resolve to one of them */
+        if (!TEST_int_eq(OBJ_cmp(OBJ_nid2obj(OBJ_obj2nid(obj)), builtin), 0)) {
+            TEST_info("NID %d", nid);
+            ok = 0;
+        }
+        ASN1_OBJECT_free(obj);
+    }
+    ERR_clear_error();
+
+    if (!TEST_ptr(obj = ASN1_OBJECT_create(NID_undef,
+                                           (unsigned char *)unknown,
+                                           sizeof(unknown), NULL, NULL)))
+        return 0;
+    if (!TEST_int_eq(OBJ_obj2nid(obj), NID_undef))
+        ok = 0;
+    ASN1_OBJECT_free(obj);
+    return ok;
+}
+
 int setup_tests(void)
 {
     ADD_TEST(test_tbl_standard);
     ADD_TEST(test_standard_methods);
     ADD_TEST(test_nid2obj_nonexist);
+    ADD_TEST(test_obj2nid_all);
     return 1;
 }
@@ -15,6 +15,7 @@
 #include <string.h>
 #include <openssl/async.h>
 #include <openssl/crypto.h>
+#include <openssl/err.h>
 
 static int ctr = 0;
 static ASYNC_JOB *currjob = NULL;
@@ -87,6 +88,46 @@ static int blockpause(void *args)
     return 1;
 }
 
+static CRYPTO_THREAD_ID worker_id;
+
+static int on_worker(void *args)
+{
+    worker_id = CRYPTO_THREAD_get_current_id();
+    ASYNCerr(0, ASYNC_R_INIT_FAILED);
+
+    return 3;
+}
+
+static int run_on_pool(void *args)
+{
+    return OSSL_WORKER_POOL_run(*(OSSL_WORKER_POOL **)args, on_worker, NULL);
+}
+
+static void add_one(void *args)
+{
+    (*(int *)args)++;
+}
+
+static size_t batches, batched_ops;
+
+static void double_all(void *ops[], int results[], size_t num_ops)
+{
+    size_t i;
+
+    batches++;
+    batched_ops += num_ops;
+    for (i = 0; i < num_ops; i++)
+        results[i] = 2 * *(int *)ops[i];
+}
+
+static int submit_to_queue(void *args)
+{
+    OSSL_BATCH_QUEUE *queue = *(OSSL_BATCH_QUEUE **)args;
+    int in = 21;
+
+    return OSSL_BATCH_QUEUE_submit(queue, double_all, NULL, &in);
+}
+
 static int test_ASYNC_init_thread(void)
 {
     ASYNC_JOB *job1 = NULL, *job2 = NULL, *job3 = NULL;
@@ -123,6 +164,71 @@ static int test_ASYNC_init_thread(void)
     return 1;
 }
 
+/* Uses more stack than the minimum stack size provides */
+static int deep_stack(void *args)
+{
+    volatile unsigned char buf[64 * 1024];
+    size_t i;
+
+    for (i = 0; i < sizeof(buf); i += 512)
+        buf[i] = (unsigned char)i;
+    ASYNC_pause_job();
+    return buf[512] == (unsigned char)512;
+}
+
+static int test_ASYNC_pool_stats(void)
+{
+    ASYNC_JOB *job1 = NULL, *job2 = NULL;
+    int funcret1, funcret2;
+    ASYNC_WAIT_CTX *waitctx = NULL;
+    size_t stacksize = ASYNC_get_stack_size();
+
+    if (       ASYNC_set_stack_size(1024)
+            || !ASYNC_init_thread(2, 1)
+            || ASYNC_get_pool_stat(ASYNC_POOL_STAT_SIZE) != 1
+            || ASYNC_get_pool_stat(ASYNC_POOL_STAT_IDLE) != 1
+            || (waitctx = ASYNC_WAIT_CTX_new()) == NULL
+            /* A hit on the pre-created job, then a miss */
+            || ASYNC_start_job(&job1, waitctx, &funcret1, only_pause, NULL, 0)
+                != ASYNC_PAUSE
+            || ASYNC_start_job(&job2, waitctx, &funcret2, only_pause, NULL, 0)
+                != ASYNC_PAUSE
+            || ASYNC_get_pool_stat(ASYNC_POOL_STAT_HITS) != 1
+            || ASYNC_get_pool_stat(ASYNC_POOL_STAT_MISSES) != 1
+            || ASYNC_get_pool_stat(ASYNC_POOL_STAT_IDLE) != 0
+            || ASYNC_start_job(&job1, waitctx, &funcret1, only_pause, NULL, 0)
+                != ASYNC_FINISH
+            /* Shrinking frees the idle job and the running one on finish */
+            || !ASYNC_init_thread(1, 0)
+            || ASYNC_get_pool_stat(ASYNC_POOL_STAT_SIZE) != 1
+            || ASYNC_start_job(&job1, waitctx, &funcret1, only_pause, NULL, 0)
+                != ASYNC_NO_JOBS
+            || ASYNC_get_pool_stat(ASYNC_POOL_STAT_EXHAUSTED) != 1
+            || ASYNC_start_job(&job2, waitctx, &funcret2, only_pause, NULL, 0)
+                != ASYNC_FINISH
+            || ASYNC_get_pool_stat(ASYNC_POOL_STAT_HIGH_WATER) != 2
+            /* A larger stack replaces the pooled job */
+            || !ASYNC_set_stack_size(256 * 1024)
+            || ASYNC_start_job(&job1, waitctx, &funcret1, deep_stack, NULL, 0)
+                != ASYNC_PAUSE
+            || ASYNC_get_pool_stat(ASYNC_POOL_STAT_STACK_REALLOCS) != 1
+            || ASYNC_start_job(&job1, waitctx, &funcret1, deep_stack, NULL, 0)
+                != ASYNC_FINISH
+            || funcret1 != 1
+            || funcret2 != 1) {
+        fprintf(stderr, "test_ASYNC_pool_stats() failed\n");
+        ASYNC_WAIT_CTX_free(waitctx);
+        ASYNC_cleanup_thread();
+        ASYNC_set_stack_size(stacksize);
+        return 0;
+    }
+
+    ASYNC_WAIT_CTX_free(waitctx);
+    ASYNC_cleanup_thread();
+    ASYNC_set_stack_size(stacksize);
+    return 1;
+}
+
 static int test_ASYNC_start_job(void)
 {
     ASYNC_JOB *job = NULL;
@@ -269,6 +375,147 @@ static int test_ASYNC_block_pause(void)
     return 1;
 }
 
+static int test_OSSL_WORKER_POOL(void)
+{
+    OSSL_WORKER_POOL *pool;
+    ASYNC_JOB *job = NULL;
+    ASYNC_WAIT_CTX *waitctx = NULL;
+    size_t numfds;
+    int counts[64];
+    void *jobs[64];
+    int funcret, ret, i, ok = 0;
+
+    ERR_set_mark();
+    if ((pool = OSSL_WORKER_POOL_new(2)) == NULL) {
+        ERR_pop_to_mark();
+        fprintf(stderr, "no worker pool support - skipping worker pool test\n");
+        return 1;
+    }
+    ERR_clear_last_mark();
+    ERR_clear_error();
+
+    /* Inside a job: the job pauses until a worker is done */
+    if (       !ASYNC_init_thread(1, 0)
+            || (waitctx = ASYNC_WAIT_CTX_new()) == NULL
+            || ASYNC_start_job(&job, waitctx, &funcret, run_on_pool, &pool,
+                               sizeof(pool)) != ASYNC_PAUSE
+            || !ASYNC_WAIT_CTX_get_all_fds(waitctx, NULL, &numfds)
+            || numfds != 1)
+        goto err;
+    while ((ret = ASYNC_start_job(&job, waitctx, &funcret, run_on_pool,
+                                  NULL, 0)) == ASYNC_PAUSE)
+        continue;
+    if (ret != ASYNC_FINISH
+            || funcret != 3
+            || CRYPTO_THREAD_compare_id(worker_id,
+                                        CRYPTO_THREAD_get_current_id())
+            || ERR_GET_REASON(ERR_get_error()) != ASYNC_R_INIT_FAILED
+            || ERR_get_error() != 0)
+        goto err;
+
+    /* Outside a job a single operation runs on the calling thread */
+    if (OSSL_WORKER_POOL_run(pool, on_worker, NULL) != 3
+            || !CRYPTO_THREAD_compare_id(worker_id,
+                                         CRYPTO_THREAD_get_current_id()))
+        goto err;
+    ERR_clear_error();
+
+    /* Several operations are shared out between the workers */
+    for (i = 0; i < 64; i++) {
+        counts[i] = 0;
+        jobs[i] = &counts[i];
+    }
+    OSSL_WORKER_POOL_run_all(pool, add_one, jobs, 64);
+    for (i = 0; i < 64; i++)
+        if (counts[i] != 1)
+            goto err;
+    if (OSSL_WORKER_POOL_get_num_threads(pool) != 2)
+        goto err;
+
+    ok = 1;
+ err:
+    if (!ok)
+        fprintf(stderr, "test_OSSL_WORKER_POOL() failed\n");
+    OSSL_WORKER_POOL_free(pool);
+    ASYNC_WAIT_CTX_free(waitctx);
+    ASYNC_cleanup_thread();
+    return ok;
+}
+
+static int test_OSSL_BATCH_QUEUE(void)
+{
+    OSSL_BATCH_QUEUE *queue;
+    ASYNC_JOB *job[3] = { NULL, NULL, NULL };
+    ASYNC_WAIT_CTX *waitctx[3] = { NULL, NULL, NULL };
+    unsigned long usec = 0;
+    int funcret[3], in = 5, i, ok = 0;
+
+    ERR_set_mark();
+    if ((queue = OSSL_BATCH_QUEUE_new(3, 10000000)) == NULL) {
+        ERR_pop_to_mark();
+        fprintf(stderr, "no batch queue support - skipping batch queue test\n");
+        return 1;
+    }
+    ERR_clear_last_mark();
+    batches = batched_ops = 0;
+
+    if (!ASYNC_init_thread(3, 0))
+        goto err;
+    for (i = 0; i < 3; i++)
+        if ((waitctx[i] = ASYNC_WAIT_CTX_new()) == NULL)
+            goto err;
+
+    /* Two jobs wait for a third operation of the same kind */
+    for (i = 0; i < 2; i++)
+        if (ASYNC_start_job(&job[i], waitctx[i], &funcret[i], submit_to_queue,
+                            &queue, sizeof(queue)) != ASYNC_PAUSE)
+            goto err;
+    if (batches != 0
+            || !OSSL_BATCH_QUEUE_get_timeout(queue, &usec)
+            || usec == 0
+            || OSSL_BATCH_QUEUE_poll(queue) != 0)
+        goto err;
+
+    /* The third completes the batch and runs it for all of them */
+    if (ASYNC_start_job(&job[2], waitctx[2], &funcret[2], submit_to_queue,
+                        &queue, sizeof(queue)) != ASYNC_FINISH
+            || funcret[2] != 42
+            || batches != 1
+            || batched_ops != 3
+            || OSSL_BATCH_QUEUE_get_timeout(queue, &usec))
+        goto err;
+    for (i = 0; i < 2; i++)
+        if (ASYNC_start_job(&job[i], waitctx[i], &funcret[i], submit_to_queue,
+                            NULL, 0) != ASYNC_FINISH
+                || funcret[i] != 42)
+            goto err;
+
+    /* A lone operation is run by flushing the queue */
+    if (ASYNC_start_job(&job[0], waitctx[0], &funcret[0], submit_to_queue,
+                        &queue, sizeof(queue)) != ASYNC_PAUSE
+            || OSSL_BATCH_QUEUE_flush(queue) != 1
+            || ASYNC_start_job(&job[0], waitctx[0], &funcret[0],
+                               submit_to_queue, NULL, 0) != ASYNC_FINISH
+            || funcret[0] != 42
+            || batches != 2)
+        goto err;
+
+    /* Outside a job the operation is run straight away */
+    if (OSSL_BATCH_QUEUE_submit(queue, double_all, NULL, &in) != 10
+            || batches != 3)
+        goto err;
+
+    ok = 1;
+ err:
+    if (!ok)
+        fprintf(stderr, "test_OSSL_BATCH_QUEUE() failed\n");
+    OSSL_BATCH_QUEUE_free(queue);
+    for (i = 0; i < 3; i++)
+        ASYNC_WAIT_CTX_free(waitctx[i]);
+    ASYNC_cleanup_thread();
+    return ok;
+}
+
 int main(int argc, char **argv)
 {
     if (!ASYNC_is_capable()) {
@@ -279,10 +526,13 @@ int main(int argc, char **argv)
         CRYPTO_mem_ctrl(CRYPTO_MEM_CHECK_ON);
 
         if (       !test_ASYNC_init_thread()
+                || !test_ASYNC_pool_stats()
                 || !test_ASYNC_start_job()
                 || !test_ASYNC_get_current_job()
                 || !test_ASYNC_WAIT_CTX_get_all_fds()
-                || !test_ASYNC_block_pause()) {
+                || !test_ASYNC_block_pause()
+                || !test_OSSL_WORKER_POOL()
+                || !test_OSSL_BATCH_QUEUE()) {
             return 1;
         }
     }
@@ -0,0 +1,640 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Microbenchmarks of single primitives.  Unlike "openssl speed", which
+ * reports the throughput of a loop run for a few seconds, each primitive is
+ * timed over many short samples, and the distribution of the samples is
+ * reported, so that operations that take less than a microsecond can be
+ * timed and two builds can be compared.  See README.md.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+# define _GNU_SOURCE            /* for sched_setaffinity() */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <openssl/evp.h>
+#include <openssl/err.h>
+#include <openssl/rand.h>
+#include <openssl/obj_mac.h>
+#include "internal/nelem.h"
+#ifdef __linux__
+# include <sched.h>
+#endif
+#if (defined(__GNUC__) || defined(__clang__)) \
+    && (defined(__x86_64__) || defined(__i386__))
+# include <x86intrin.h>
+# define BENCH_TSC
+#endif
+
+#define DEFAULT_SAMPLES     200
+#define DEFAULT_WARMUP_MS   200
+#define DEFAULT_RECORD      1024
+#define DEFAULT_THRESHOLD   2.0
+/* Two-sided p < 0.001 */
+#define SIGNIFICANT_Z       3.29
+/* Minimum duration of a sample, in timer units */
+#define SAMPLE_MIN_TSC      50000
+#define SAMPLE_MIN_NS       20000
+#define BATCH_MAX           (1 << 20)
+
+static int use_tsc = 0;
+static size_t record_len = DEFAULT_RECORD;
+
+/* State of one primitive, what each one uses of it */
+typedef struct bench_st BENCH;
+struct bench_st {
+    const char *name;
+    int (*setup)(BENCH *b);
+    int (*run)(BENCH *b);
+    EVP_CIPHER_CTX *cctx;
+    EVP_MD_CTX *mctx;
+    EVP_PKEY_CTX *pctx;
+    EVP_PKEY *pkey;
+    const EVP_MD *md;
+    const OQS_KEM *kem;
+    unsigned char *in, *out, *pk, *sk, *ct, *ss;
+    size_t inlen, outlen;
+};
+
+/*-
+ * The primitives
+ */
+
+static int gcm_setup(BENCH *b)
+{
+    unsigned char key[16] = { 0 }, iv[12] = { 0 };
+
+    b->inlen = record_len;
+    b->in = OPENSSL_zalloc(b->inlen);
+    b->out = OPENSSL_malloc(b->inlen + 16);
+    return b->in != NULL && b->out != NULL
+           && (b->cctx = EVP_CIPHER_CTX_new()) != NULL
+           && EVP_EncryptInit_ex(b->cctx, EVP_aes_128_gcm(), NULL, key, iv);
+}
+
+/* Seals one TLS 1.2 record, as the record layer does */
+static int gcm_run(BENCH *b)
+{
+    static unsigned char iv[12], aad[13];
+    int len, tmplen;
+
+    return EVP_EncryptInit_ex(b->cctx, NULL, NULL, NULL, iv)
+           && EVP_EncryptUpdate(b->cctx, NULL, &len, aad, sizeof(aad))
+           && EVP_EncryptUpdate(b->cctx, b->out, &len, b->in, (int)b->inlen)
+           && EVP_EncryptFinal_ex(b->cctx, b->out + len, &tmplen)
+           && EVP_CIPHER_CTX_ctrl(b->cctx, EVP_CTRL_AEAD_GET_TAG, 16,
+                                  b->out + b->inlen);
+}
+
+static int digest_setup(BENCH *b)
+{
+    b->inlen = 64;
+    b->in = OPENSSL_zalloc(b->inlen);
+    return b->in != NULL && (b->mctx = EVP_MD_CTX_new()) != NULL;
+}
+
+static int sha256_setup(BENCH *b)
+{
+    b->md = EVP_sha256();
+    return digest_setup(b);
+}
+
+static int sha3_setup(BENCH *b)
+{
+    b->md = EVP_sha3_256();
+    return digest_setup(b);
+}
+
+static int digest_run(BENCH *b)
+{
+    unsigned char md[EVP_MAX_MD_SIZE];
+
+    return EVP_DigestInit_ex(b->mctx, b->md, NULL)
+           && EVP_DigestUpdate(b->mctx, b->in, b->inlen)
+           && EVP_DigestFinal_ex(b->mctx, md, NULL);
+}
+
+static EVP_PKEY *keygen(int nid)
+{
+    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_id(nid, NULL);
+    EVP_PKEY *pkey = NULL;
+
+    if (ctx == NULL || EVP_PKEY_keygen_init(ctx) <= 0
+            || EVP_PKEY_keygen(ctx, &pkey) <= 0)
+        pkey = NULL;
+    EVP_PKEY_CTX_free(ctx);
+    return pkey;
+}
+
+static int x25519_setup(BENCH *b)
+{
+    EVP_PKEY *peer = keygen(NID_X25519);
+    int ret;
+
+    ret = peer != NULL
+          && (b->pkey = keygen(NID_X25519)) != NULL
+          && (b->pctx = EVP_PKEY_CTX_new(b->pkey, NULL)) != NULL
+          && EVP_PKEY_derive_init(b->pctx) > 0
+          && EVP_PKEY_derive_set_peer(b->pctx, peer) > 0
+          && (b->out = OPENSSL_malloc(32)) != NULL;
+    EVP_PKEY_free(peer);
+    return ret;
+}
+
+static int x25519_run(BENCH *b)
+{
+    size_t len = 32;
+
+    return EVP_PKEY_derive(b->pctx, b->out, &len) > 0;
+}
+
+static int kyber_setup(BENCH *b)
+{
+    const OQS_KEM *kem = get_oqs_kem(NID_kyber512);
+
+    if (kem == NULL)
+        return 0;
+    b->kem = kem;
+    b->pk = OPENSSL_malloc(kem->length_public_key);
+    b->sk = OPENSSL_malloc(kem->length_secret_key);
+    b->ct = OPENSSL_malloc(kem->length_ciphertext);
+    b->ss = OPENSSL_malloc(kem->length_shared_secret);
+    return b->pk != NULL && b->sk != NULL && b->ct != NULL && b->ss != NULL
+           && OQS_KEM_keypair(kem, b->pk, b->sk) == OQS_SUCCESS
+           && OQS_KEM_encaps(kem, b->ct, b->ss, b->pk) == OQS_SUCCESS;
+}
+
+static int kyber_encaps_run(BENCH *b)
+{
+    return OQS_KEM_encaps(b->kem, b->ct, b->ss, b->pk) == OQS_SUCCESS;
+}
+
+static int kyber_decaps_run(BENCH *b)
+{
+    return OQS_KEM_decaps(b->kem, b->ss, b->ct, b->sk) == OQS_SUCCESS;
+}
+
+static int dilithium_setup(BENCH *b)
+{
+    b->inlen = 64;
+    if ((b->in = OPENSSL_zalloc(b->inlen)) == NULL
+            || (b->pkey = keygen(NID_dilithium2)) == NULL
+            || (b->mctx = EVP_MD_CTX_new()) == NULL
+            || (b->out = OPENSSL_malloc(EVP_PKEY_size(b->pkey))) == NULL)
+        return 0;
+    b->outlen = EVP_PKEY_size(b->pkey);
+    return EVP_DigestSignInit(b->mctx, NULL, NULL, NULL, b->pkey)
+           && EVP_DigestSign(b->mctx, b->out, &b->outlen, b->in, b->inlen);
+}
+
+static int dilithium_sign_run(BENCH *b)
+{
+    size_t len = EVP_PKEY_size(b->pkey);
+
+    return EVP_DigestSign(b->mctx, b->out, &len, b->in, b->inlen);
+}
+
+static int dilithium_verify_setup(BENCH *b)
+{
+    return dilithium_setup(b)
+           && EVP_DigestVerifyInit(b->mctx, NULL, NULL, NULL, b->pkey);
+}
+
+static int dilithium_verify_run(BENCH *b)
+{
+    return EVP_DigestVerify(b->mctx, b->out, b->outlen, b->in, b->inlen) == 1;
+}
+
+static BENCH benches[] = {
+    { "aes-128-gcm-record", gcm_setup, gcm_run },
+    { "sha256", sha256_setup, digest_run },
+    { "sha3-256", sha3_setup, digest_run },
+    { "x25519-derive", x25519_setup, x25519_run },
+    { "kyber512-encaps", kyber_setup, kyber_encaps_run },
+    { "kyber512-decaps", kyber_setup, kyber_decaps_run },
+    { "dilithium2-sign", dilithium_setup, dilithium_sign_run },
+    { "dilithium2-verify", dilithium_verify_setup, dilithium_verify_run },
+};
+
+static void bench_cleanup(BENCH *b)
+{
+    EVP_CIPHER_CTX_free(b->cctx);
+    EVP_MD_CTX_free(b->mctx);
+    EVP_PKEY_CTX_free(b->pctx);
+    EVP_PKEY_free(b->pkey);
+    OPENSSL_free(b->in);
+    OPENSSL_free(b->out);
+    OPENSSL_free(b->pk);
+    if (b->kem != NULL) {
+        OPENSSL_clear_free(b->sk, b->kem->length_secret_key);
+        OPENSSL_clear_free(b->ss, b->kem->length_shared_secret);
+    }
+    OPENSSL_free(b->ct);
+}
+
+/*-
+ * Timing
+ */
+
+static uint64_t now_ns(void)
+{
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+        return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+    return (uint64_t)clock() * (1000000000 / CLOCKS_PER_SEC);
+}
+
+/* The time in the units of the benchmark: TSC ticks, or nanoseconds */
+static uint64_t now(void)
+{
+#ifdef BENCH_TSC
+    if (use_tsc) {
+        _mm_lfence();
+        return __rdtsc();
+    }
+#endif
+    return now_ns();
+}
+
+/*
+ * Fills |samples| with the time per operation of |b|, each sample timing a
+ * batch of operations long enough for the timer to be precise.
+ */
+static int bench_sample(BENCH *b, double *samples, size_t nsamples,
+                        unsigned int warmup_ms, size_t *batchp)
+{
+    uint64_t start, min = use_tsc ? SAMPLE_MIN_TSC : SAMPLE_MIN_NS;
+    size_t batch = 1, i, j;
+
+    start = now_ns();
+    do {
+        if (!b->run(b))
+            return 0;
+    } while (now_ns() - start < (uint64_t)warmup_ms * 1000000);
+
+    for (;;) {
+        start = now();
+        for (j = 0; j < batch; j++)
+            if (!b->run(b))
+                return 0;
+        if (now() - start >= min || batch >= BATCH_MAX)
+            break;
+        batch *= 2;
+    }
+
+    for (i = 0; i < nsamples; i++) {
+        start = now();
+        for (j = 0; j < batch; j++)
+            if (!b->run(b))
+                return 0;
+        samples[i] = (double)(now() - start) / batch;
+    }
+    *batchp = batch;
+    return 1;
+}
+
+/*-
+ * Statistics
+ */
+
+typedef struct {
+    double median;
+    double p99;
+    double mad;                 /* median absolute deviation */
+} STATS;
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+/* The median of the sorted |s| */
+static double median(const double *s, size_t n)
+{
+    return n % 2 != 0 ? s[n / 2] : (s[n / 2 - 1] + s[n / 2]) / 2;
+}
+
+/* Sorts |s| and computes its statistics */
+static int stats_compute(double *s, size_t n, STATS *st)
+{
+    double *dev;
+    size_t i;
+
+    if ((dev = OPENSSL_malloc(n * sizeof(*dev))) == NULL)
+        return 0;
+    qsort(s, n, sizeof(*s), cmp_double);
+    st->median = median(s, n);
+    /* Nearest rank */
+    st->p99 = s[(n * 99 + 99) / 100 - 1];
+    for (i = 0; i < n; i++)
+        dev[i] = s[i] > st->median ? s[i] - st->median : st->median - s[i];
+    qsort(dev, n, sizeof(*dev), cmp_double);
+    st->mad = median(dev, n);
+    OPENSSL_free(dev);
+    return 1;
+}
+
+static double square_root(double x)
+{
+    double r = x > 1 ? x : 1;
+    int i;
+
+    if (x <= 0)
+        return 0;
+    for (i = 0; i < 64; i++)
+        r = (r + x / r) / 2;
+    return r;
+}
+
+/*
+ * The z score of the Mann-Whitney U statistic of the sorted samples |a| and
+ * |b|, positive when |b| tends to be larger than |a|.  Ties take the mean
+ * of their ranks.
+ */
+static double mann_whitney_z(const double *a, size_t na,
+                             const double *b, size_t nb)
+{
+    double rank_b = 0, u, mean, sd;
+    size_t i = 0, j = 0, ta, tb;
+
+    while (i < na || j < nb) {
+        double v = i == na ? b[j] : j == nb ? a[i] : a[i] < b[j] ? a[i] : b[j];
+
+        for (ta = 0; i + ta < na && a[i + ta] == v; ta++)
+            continue;
+        for (tb = 0; j + tb < nb && b[j + tb] == v; tb++)
+            continue;
+        /* Ranks i + j + 1 to i + j + ta + tb, averaged */
+        rank_b += tb * ((double)(i + j + 1) + (double)(i + j + ta + tb)) / 2;
+        i += ta;
+        j += tb;
+    }
+    u = rank_b - (double)nb * (nb + 1) / 2;
+    mean = (double)na * nb / 2;
+    sd = square_root((double)na * nb * (na + nb + 1) / 12);
+    return sd == 0 ? 0 : (u - mean) / sd;
+}
+
+/*-
+ * Baselines, one line per primitive:
+ *     name unit count sample...
+ * with the samples sorted.
+ */
+
+typedef struct {
+    char name[64];
+    char unit[16];
+    size_t n;
+    double *samples;
+} BASELINE;
+
+static BASELINE *baselines = NULL;
+static size_t nbaselines = 0;
+
+static int baseline_load(const char *file)
+{
+    FILE *f = fopen(file, "r");
+    BASELINE bl, *tmp;
+    unsigned long n;
+    size_t i;
+    int ret = 0;
+
+    if (f == NULL) {
+        perror(file);
+        return 0;
+    }
+    while (fscanf(f, "%63s %15s %lu", bl.name, bl.unit, &n) == 3) {
+        bl.n = n;
+        if (bl.n == 0 || bl.n > 10000000
+                || (bl.samples = OPENSSL_malloc(bl.n * sizeof(double))) == NULL)
+            goto err;
+        for (i = 0; i < bl.n; i++)
+            if (fscanf(f, "%lf", &bl.samples[i]) != 1) {
+                OPENSSL_free(bl.samples);
+                goto err;
+            }
+        tmp = OPENSSL_realloc(baselines, (nbaselines + 1) * sizeof(*tmp));
+        if (tmp == NULL) {
+            OPENSSL_free(bl.samples);
+            goto err;
+        }
+        baselines = tmp;
+        baselines[nbaselines++] = bl;
+    }
+    ret = feof(f);
+ err:
+    if (!ret)
+        fprintf(stderr, "%s: invalid baseline\n", file);
+    fclose(f);
+    return ret;
+}
+
+static const BASELINE *baseline_find(const char *name)
+{
+    size_t i;
+
+    for (i = 0; i < nbaselines; i++)
+        if (strcmp(baselines[i].name, name) == 0)
+            return &baselines[i];
+    return NULL;
+}
+
+static void baseline_free(void)
+{
+    size_t i;
+
+    for (i = 0; i < nbaselines; i++)
+        OPENSSL_free(baselines[i].samples);
+    OPENSSL_free(baselines);
+}
+
+/*-
+ * Main
+ */
+
+static int pin_cpu(int cpu)
+{
+#ifdef __linux__
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) == 0)
+        return 1;
+    perror("sched_setaffinity");
+    return 0;
+#else
+    fprintf(stderr, "Pinning to a CPU is not supported on this platform\n");
+    return 0;
+#endif
+}
+
+static void usage(const char *prog)
+{
+    size_t i;
+
+    fprintf(stderr,
+            "Usage: %s [options] [primitive...]\n"
+            "  -samples n     Number of samples of each primitive (default %d)\n"
+            "  -warmup ms     Run each primitive this long before timing it"
+            " (default %d)\n"
+            "  -record n      Size of the AES-GCM records (default %d)\n"
+            "  -cpu n         Pin to CPU n\n"
+            "  -ns            Time in nanoseconds even if a TSC is available\n"
+            "  -save file     Save the samples as a baseline\n"
+            "  -compare file  Compare against a saved baseline\n"
+            "  -threshold pct Smallest difference reported as a regression"
+            " (default %.0f)\n"
+            "Primitives:", prog, DEFAULT_SAMPLES, DEFAULT_WARMUP_MS,
+            DEFAULT_RECORD, DEFAULT_THRESHOLD);
+    for (i = 0; i < OSSL_NELEM(benches); i++)
+        fprintf(stderr, " %s", benches[i].name);
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *prog = argv[0], *save = NULL, *compare = NULL, *unit;
+    size_t nsamples = DEFAULT_SAMPLES, batch, i;
+    unsigned int warmup_ms = DEFAULT_WARMUP_MS;
+    double threshold = DEFAULT_THRESHOLD, *samples = NULL;
+    int selected[OSSL_NELEM(benches)] = { 0 }, any = 0, regressed = 0;
+    int ret = EXIT_FAILURE;
+    FILE *out = NULL;
+    STATS st;
+
+#ifdef BENCH_TSC
+    use_tsc = 1;
+#endif
+    for (argv++; *argv != NULL; argv++) {
+        if (strcmp(*argv, "-samples") == 0 && argv[1] != NULL) {
+            nsamples = strtoul(*++argv, NULL, 10);
+        } else if (strcmp(*argv, "-warmup") == 0 && argv[1] != NULL) {
+            warmup_ms = (unsigned int)strtoul(*++argv, NULL, 10);
+        } else if (strcmp(*argv, "-record") == 0 && argv[1] != NULL) {
+            record_len = strtoul(*++argv, NULL, 10);
+        } else if (strcmp(*argv, "-cpu") == 0 && argv[1] != NULL) {
+            if (!pin_cpu(atoi(*++argv)))
+                return EXIT_FAILURE;
+        } else if (strcmp(*argv, "-ns") == 0) {
+            use_tsc = 0;
+        } else if (strcmp(*argv, "-save") == 0 && argv[1] != NULL) {
+            save = *++argv;
+        } else if (strcmp(*argv, "-compare") == 0 && argv[1] != NULL) {
+            compare = *++argv;
+        } else if (strcmp(*argv, "-threshold") == 0 && argv[1] != NULL) {
+            threshold = atof(*++argv);
+        } else if (**argv != '-') {
+            for (i = 0; i < OSSL_NELEM(benches); i++)
+                if (strcmp(*argv, benches[i].name) == 0)
+                    break;
+            if (i == OSSL_NELEM(benches)) {
+                fprintf(stderr, "%s: unknown primitive %s\n", prog, *argv);
+                usage(prog);
+                return EXIT_FAILURE;
+            }
+            selected[i] = any = 1;
+        } else {
+            usage(prog);
+            return EXIT_FAILURE;
+        }
+    }
+    if (nsamples == 0 || nsamples > 10000000
+            || record_len == 0 || record_len > 1 << 30) {
+        usage(prog);
+        return EXIT_FAILURE;
+    }
+    unit = use_tsc ? "cycles" : "ns";
+
+    if (compare != NULL && !baseline_load(compare))
+        goto end;
+    if (save != NULL && (out = fopen(save, "w")) == NULL) {
+        perror(save);
+        goto end;
+    }
+    if ((samples = OPENSSL_malloc(nsamples * sizeof(*samples))) == NULL)
+        goto end;
+
+    printf("Time per operation in %s, %lu samples\n", unit,
+           (unsigned long)nsamples);
+    printf("%-20s %12s %12s %10s %8s", "primitive", "median", "p99", "MAD",
+           "batch");
+    if (compare != NULL)
+        printf(" %12s %8s %8s", "baseline", "change", "z");
+    printf("\n");
+
+    for (i = 0; i < OSSL_NELEM(benches); i++) {
+        BENCH *b = &benches[i];
+        const BASELINE *bl;
+        size_t k;
+
+        if (any && !selected[i])
+            continue;
+        if (!b->setup(b) || !bench_sample(b, samples, nsamples, warmup_ms,
+                                          &batch)) {
+            /* The OQS algorithms may be disabled */
+            printf("%-20s %12s\n", b->name, "unavailable");
+            ERR_clear_error();
+            bench_cleanup(b);
+            continue;
+        }
+        bench_cleanup(b);
+        if (!stats_compute(samples, nsamples, &st))
+            goto end;
+        printf("%-20s %12.1f %12.1f %10.1f %8lu", b->name, st.median, st.p99,
+               st.mad, (unsigned long)batch);
+
+        if (compare != NULL) {
+            bl = baseline_find(b->name);
+            if (bl == NULL || strcmp(bl->unit, unit) != 0) {
+                printf(" %12s", bl == NULL ? "none" : "other unit");
+            } else {
+                double base = median(bl->samples, bl->n);
+                double change = base == 0 ? 0 : (st.median - base) * 100 / base;
+                double z = mann_whitney_z(bl->samples, bl->n,
+                                          samples, nsamples);
+
+                printf(" %12.1f %+7.1f%% %8.2f", base, change, z);
+                if (z >= SIGNIFICANT_Z && change >= threshold) {
+                    printf(" slower");
+                    regressed = 1;
+                } else if (z <= -SIGNIFICANT_Z && change <= -threshold) {
+                    printf(" faster");
+                }
+            }
+        }
+        printf("\n");
+
+        if (out != NULL) {
+            fprintf(out, "%s %s %lu", b->name, unit, (unsigned long)nsamples);
+            for (k = 0; k < nsamples; k++)
+                fprintf(out, " %.2f", samples[k]);
+            fprintf(out, "\n");
+        }
+    }
+    ret = regressed ? 2 : EXIT_SUCCESS;
+
+ end:
+    if (out != NULL && fclose(out) != 0) {
+        perror(save);
+        ret = EXIT_FAILURE;
+    }
+    OPENSSL_free(samples);
+    baseline_free();
+    return ret;
+}
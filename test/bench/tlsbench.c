@@ -0,0 +1,715 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * End to end TLS benchmarks: bulk throughput, handshakes and resumptions
+ * per second against the number of threads, memory per idle connection and
+ * handshakes with each post-quantum group and signature algorithm.  Both
+ * ends of each connection run in this process, over memory BIOs or over
+ * loopback sockets.  The results are written as JSON.  See README.md.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+#include <openssl/crypto.h>
+#include "internal/nelem.h"
+#include "../ssltestlib.h"
+#include "../testutil/output.h"
+#if defined(OPENSSL_THREADS) && !defined(OPENSSL_SYS_WINDOWS)
+# include <pthread.h>
+# define BENCH_THREADS
+#endif
+#if (!defined(OPENSSL_NO_KTLS) || defined(OPENSSL_SYS_LINUX)) \
+    && !defined(OPENSSL_NO_SOCK)
+# define BENCH_SOCKETS
+#endif
+#if defined(BENCH_SOCKETS) || defined(__linux__)
+# include <unistd.h>
+#endif
+
+#define DEFAULT_TIME_MS     1000
+#define DEFAULT_THREADS     4
+#define DEFAULT_IDLE        10000
+#define MAX_THREADS         256
+#define MAX_RECORD          16384
+
+static unsigned int time_ms = DEFAULT_TIME_MS;
+static int use_sockets = 0;
+
+/* Certificate and key of the classical handshakes */
+static EVP_PKEY *ec_key = NULL;
+static X509 *ec_cert = NULL;
+
+/*-
+ * Heap accounting
+ */
+
+static size_t heap_live = 0;
+
+/* Room for the size of each allocation, keeping the alignment of malloc() */
+#define HEAP_HDR 16
+
+static void heap_add(size_t n)
+{
+#ifdef __GNUC__
+    __atomic_fetch_add(&heap_live, n, __ATOMIC_RELAXED);
+#else
+    heap_live += n;
+#endif
+}
+
+static void heap_sub(size_t n)
+{
+#ifdef __GNUC__
+    __atomic_fetch_sub(&heap_live, n, __ATOMIC_RELAXED);
+#else
+    heap_live -= n;
+#endif
+}
+
+static size_t heap_now(void)
+{
+#ifdef __GNUC__
+    return __atomic_load_n(&heap_live, __ATOMIC_RELAXED);
+#else
+    return heap_live;
+#endif
+}
+
+static void *heap_malloc(size_t n, const char *file, int line)
+{
+    unsigned char *p = malloc(n + HEAP_HDR);
+
+    if (p == NULL)
+        return NULL;
+    memcpy(p, &n, sizeof(n));
+    heap_add(n);
+    return p + HEAP_HDR;
+}
+
+static void heap_free(void *ptr, const char *file, int line)
+{
+    unsigned char *p = ptr;
+    size_t n;
+
+    if (p == NULL)
+        return;
+    p -= HEAP_HDR;
+    memcpy(&n, p, sizeof(n));
+    heap_sub(n);
+    free(p);
+}
+
+static void *heap_realloc(void *ptr, size_t n, const char *file, int line)
+{
+    unsigned char *p = ptr;
+    size_t old;
+
+    if (p == NULL)
+        return heap_malloc(n, file, line);
+    p -= HEAP_HDR;
+    memcpy(&old, p, sizeof(old));
+    if ((p = realloc(p, n + HEAP_HDR)) == NULL)
+        return NULL;
+    memcpy(p, &n, sizeof(n));
+    heap_sub(old);
+    heap_add(n);
+    return p + HEAP_HDR;
+}
+
+/* The resident set size of the process, 0 if unknown */
+static size_t rss_now(void)
+{
+#ifdef __linux__
+    FILE *f = fopen("/proc/self/statm", "r");
+    unsigned long size, resident;
+    int ok;
+
+    if (f == NULL)
+        return 0;
+    ok = fscanf(f, "%lu %lu", &size, &resident) == 2;
+    fclose(f);
+    return ok ? resident * (size_t)sysconf(_SC_PAGESIZE) : 0;
+#else
+    return 0;
+#endif
+}
+
+/*-
+ * Connections
+ */
+
+static uint64_t now_ms(void)
+{
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+        return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif
+    return (uint64_t)time(NULL) * 1000;
+}
+
+/* A self-signed certificate for |pkey| */
+static X509 *make_cert(EVP_PKEY *pkey)
+{
+    X509 *x = X509_new();
+    X509_NAME *name;
+
+    if (x == NULL
+            || !X509_set_version(x, 2)
+            || !ASN1_INTEGER_set(X509_get_serialNumber(x), 1)
+            || X509_gmtime_adj(X509_getm_notBefore(x), 0) == NULL
+            || X509_gmtime_adj(X509_getm_notAfter(x), 86400) == NULL
+            || !X509_set_pubkey(x, pkey)
+            || (name = X509_get_subject_name(x)) == NULL
+            || !X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                           (unsigned char *)"tlsbench", -1,
+                                           -1, 0)
+            || !X509_set_issuer_name(x, name)
+            || !X509_sign(x, pkey, EVP_sha512())) {
+        X509_free(x);
+        return NULL;
+    }
+    return x;
+}
+
+static EVP_PKEY *make_key(int nid)
+{
+    EVP_PKEY_CTX *ctx;
+    EVP_PKEY *pkey = NULL;
+
+    if (nid == EVP_PKEY_EC) {
+        if ((ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, NULL)) == NULL
+                || EVP_PKEY_keygen_init(ctx) <= 0
+                || EVP_PKEY_CTX_set_ec_paramgen_curve_nid(ctx,
+                       NID_X9_62_prime256v1) <= 0
+                || EVP_PKEY_keygen(ctx, &pkey) <= 0)
+            pkey = NULL;
+    } else if ((ctx = EVP_PKEY_CTX_new_id(nid, NULL)) == NULL
+               || EVP_PKEY_keygen_init(ctx) <= 0
+               || (nid == EVP_PKEY_RSA
+                   && EVP_PKEY_CTX_set_rsa_keygen_bits(ctx, 2048) <= 0)
+               || EVP_PKEY_keygen(ctx, &pkey) <= 0) {
+        pkey = NULL;
+    }
+    EVP_PKEY_CTX_free(ctx);
+    return pkey;
+}
+
+/* A server and a client context, the server using |cert| and |key| */
+static int make_ctx_pair(int version, X509 *cert, EVP_PKEY *key,
+                         SSL_CTX **sctx, SSL_CTX **cctx)
+{
+    if (!create_ssl_ctx_pair(TLS_server_method(), TLS_client_method(),
+                             version, version, sctx, cctx, NULL, NULL))
+        return 0;
+    if (SSL_CTX_use_certificate(*sctx, cert) != 1
+            || SSL_CTX_use_PrivateKey(*sctx, key) != 1) {
+        SSL_CTX_free(*sctx);
+        SSL_CTX_free(*cctx);
+        return 0;
+    }
+    return 1;
+}
+
+typedef struct {
+    SSL *server, *client;
+    int sfd, cfd;
+} CONN;
+
+static int conn_new(SSL_CTX *sctx, SSL_CTX *cctx, CONN *conn)
+{
+    conn->server = conn->client = NULL;
+    conn->sfd = conn->cfd = -1;
+#ifdef BENCH_SOCKETS
+    if (use_sockets)
+        return create_test_sockets(&conn->cfd, &conn->sfd)
+               && create_ssl_objects2(sctx, cctx, &conn->server,
+                                      &conn->client, conn->sfd, conn->cfd);
+#endif
+    return create_ssl_objects(sctx, cctx, &conn->server, &conn->client,
+                              NULL, NULL);
+}
+
+static void conn_free(CONN *conn)
+{
+    /* Without a close_notify, the session of the client is not resumable */
+    if (conn->client != NULL && SSL_is_init_finished(conn->client))
+        SSL_shutdown(conn->client);
+    SSL_free(conn->server);
+    SSL_free(conn->client);
+#ifdef BENCH_SOCKETS
+    if (conn->sfd >= 0)
+        close(conn->sfd);
+    if (conn->cfd >= 0)
+        close(conn->cfd);
+#endif
+}
+
+/*-
+ * Bulk transfer
+ */
+
+/* Bytes per second sent from client to server in records of |len| bytes */
+static double bulk(SSL_CTX *sctx, SSL_CTX *cctx, int len)
+{
+    static unsigned char buf[MAX_RECORD];
+    uint64_t start, deadline;
+    double total = 0;
+    CONN conn;
+    int n, got;
+
+    if (!conn_new(sctx, cctx, &conn)
+            || !create_ssl_connection(conn.server, conn.client,
+                                      SSL_ERROR_NONE)) {
+        conn_free(&conn);
+        return -1;
+    }
+    start = now_ms();
+    deadline = start + time_ms;
+    do {
+        if (SSL_write(conn.client, buf, len) != len)
+            goto err;
+        for (got = 0; got < len; ) {
+            if ((n = SSL_read(conn.server, buf, sizeof(buf))) > 0)
+                got += n;
+            else if (SSL_get_error(conn.server, n) != SSL_ERROR_WANT_READ)
+                goto err;
+        }
+        total += len;
+    } while (now_ms() < deadline);
+    conn_free(&conn);
+    return total * 1000 / (now_ms() - start);
+ err:
+    conn_free(&conn);
+    return -1;
+}
+
+/*-
+ * Handshakes
+ */
+
+typedef struct {
+    SSL_CTX *sctx, *cctx;
+    SSL_SESSION *session;       /* to resume, or NULL */
+    uint64_t deadline;
+    long count;
+    size_t client_bytes, server_bytes;
+    int ok;
+} HS_JOB;
+
+static void *hs_loop(void *arg)
+{
+    HS_JOB *job = arg;
+    CONN conn;
+
+    job->count = 0;
+    job->ok = 0;
+    do {
+        if (!conn_new(job->sctx, job->cctx, &conn)
+                || (job->session != NULL
+                    && !SSL_set_session(conn.client, job->session))
+                || !create_ssl_connection(conn.server, conn.client,
+                                          SSL_ERROR_NONE)
+                || (job->session != NULL && !SSL_session_reused(conn.client))) {
+            conn_free(&conn);
+            return NULL;
+        }
+        job->client_bytes = BIO_number_written(SSL_get_wbio(conn.client));
+        job->server_bytes = BIO_number_written(SSL_get_wbio(conn.server));
+        conn_free(&conn);
+        job->count++;
+    } while (now_ms() < job->deadline);
+    job->ok = 1;
+    return NULL;
+}
+
+/* Handshakes per second on |threads| threads, -1 on error */
+static double handshakes(SSL_CTX *sctx, SSL_CTX *cctx, SSL_SESSION *session,
+                         int threads, HS_JOB *last)
+{
+    HS_JOB jobs[MAX_THREADS];
+#ifdef BENCH_THREADS
+    pthread_t tids[MAX_THREADS];
+#endif
+    uint64_t start = now_ms();
+    double total = 0;
+    int i, started, ok = 1;
+
+    for (i = 0; i < threads; i++) {
+        memset(&jobs[i], 0, sizeof(jobs[i]));
+        jobs[i].sctx = sctx;
+        jobs[i].cctx = cctx;
+        jobs[i].session = session;
+        jobs[i].deadline = start + time_ms;
+    }
+    /* The calling thread runs the first job */
+#ifdef BENCH_THREADS
+    for (started = 1; started < threads; started++)
+        if (pthread_create(&tids[started], NULL, hs_loop, &jobs[started]) != 0)
+            break;
+    hs_loop(&jobs[0]);
+    for (i = 1; i < started; i++)
+        pthread_join(tids[i], NULL);
+#else
+    started = 1;
+    hs_loop(&jobs[0]);
+#endif
+    if (started < threads)
+        return -1;
+    for (i = 0; i < threads; i++) {
+        ok &= jobs[i].ok;
+        total += jobs[i].count;
+    }
+    if (last != NULL)
+        *last = jobs[0];
+    return ok ? total * 1000 / (now_ms() - start) : -1;
+}
+
+/*-
+ * Output
+ */
+
+static void json_string(const char *str)
+{
+    putchar('"');
+    for (; *str != '\0'; str++) {
+        if (*str == '"' || *str == '\\')
+            printf("\\%c", *str);
+        else if ((unsigned char)*str < 0x20)
+            printf("\\u%04x", (unsigned char)*str);
+        else
+            putchar(*str);
+    }
+    putchar('"');
+}
+
+/* Separates the entries of a JSON array */
+static const char *sep(int *first)
+{
+    if (*first) {
+        *first = 0;
+        return "\n    ";
+    }
+    return ",\n    ";
+}
+
+/*-
+ * Scenarios
+ */
+
+static const char *bulk_ciphers[] = {
+    "TLS_AES_128_GCM_SHA256",
+    "TLS_AES_256_GCM_SHA384",
+    "TLS_CHACHA20_POLY1305_SHA256",
+    "ECDHE-ECDSA-AES128-GCM-SHA256",
+    "ECDHE-ECDSA-AES256-GCM-SHA384",
+    "ECDHE-ECDSA-CHACHA20-POLY1305",
+};
+
+static const int bulk_records[] = { 1024, 4096, MAX_RECORD };
+
+static int run_bulk(void)
+{
+    SSL_CTX *sctx, *cctx;
+    size_t i, j;
+    int first = 1, tls13, ok, ret = 1;
+    double rate;
+
+    printf(",\n  \"bulk\": [");
+    for (i = 0; i < OSSL_NELEM(bulk_ciphers); i++) {
+        tls13 = strncmp(bulk_ciphers[i], "TLS_", 4) == 0;
+        if (!make_ctx_pair(tls13 ? TLS1_3_VERSION : TLS1_2_VERSION,
+                           ec_cert, ec_key, &sctx, &cctx)) {
+            ret = 0;
+            break;
+        }
+        ok = tls13 ? SSL_CTX_set_ciphersuites(cctx, bulk_ciphers[i])
+                   : SSL_CTX_set_cipher_list(cctx, bulk_ciphers[i]);
+        for (j = 0; ok && j < OSSL_NELEM(bulk_records); j++) {
+            fprintf(stderr, "bulk %s %d\n", bulk_ciphers[i], bulk_records[j]);
+            rate = bulk(sctx, cctx, bulk_records[j]);
+            printf("%s{\"cipher\": ", sep(&first));
+            json_string(bulk_ciphers[i]);
+            printf(", \"record\": %d", bulk_records[j]);
+            if (rate < 0)
+                printf(", \"available\": false}");
+            else
+                printf(", \"bytes_per_sec\": %.0f}", rate);
+            ERR_clear_error();
+        }
+        SSL_CTX_free(sctx);
+        SSL_CTX_free(cctx);
+    }
+    printf("\n  ]");
+    return ret;
+}
+
+/* Handshakes, or resumptions, per second from 1 to |max_threads| threads */
+static int run_scaling(int max_threads, int resume)
+{
+    SSL_CTX *sctx, *cctx;
+    SSL_SESSION *session = NULL;
+    CONN conn;
+    int threads, first = 1, ret = 0;
+    double rate = 0;
+
+    if (!make_ctx_pair(TLS1_3_VERSION, ec_cert, ec_key, &sctx, &cctx))
+        return 0;
+    if (resume) {
+        if (!conn_new(sctx, cctx, &conn)
+                || !create_ssl_connection(conn.server, conn.client,
+                                          SSL_ERROR_NONE)
+                || (session = SSL_get1_session(conn.client)) == NULL) {
+            conn_free(&conn);
+            goto end;
+        }
+        conn_free(&conn);
+    }
+
+    printf(",\n  \"%s\": [", resume ? "resumptions" : "handshakes");
+    for (threads = 1; threads <= max_threads; threads *= 2) {
+        fprintf(stderr, "%s on %d threads\n",
+                resume ? "resumptions" : "handshakes", threads);
+        if ((rate = handshakes(sctx, cctx, session, threads, NULL)) < 0)
+            break;
+        printf("%s{\"threads\": %d, \"per_sec\": %.1f}", sep(&first),
+               threads, rate);
+        if (threads < max_threads && threads * 2 > max_threads)
+            threads = max_threads / 2;
+    }
+    printf("\n  ]");
+    ret = rate >= 0;
+ end:
+    SSL_SESSION_free(session);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return ret;
+}
+
+/*
+ * Memory used by each of |n| idle server connections, over memory BIOs so
+ * as not to run out of file descriptors
+ */
+static int run_idle(int n)
+{
+    SSL_CTX *sctx, *cctx;
+    SSL **servers;
+    size_t heap, rss;
+    CONN conn;
+    int i, made = 0, ret = 0, sockets = use_sockets;
+
+    if (!make_ctx_pair(TLS1_3_VERSION, ec_cert, ec_key, &sctx, &cctx))
+        return 0;
+    SSL_CTX_set_mode(sctx, SSL_MODE_RELEASE_BUFFERS);
+    if ((servers = OPENSSL_zalloc(n * sizeof(*servers))) == NULL)
+        goto end;
+    fprintf(stderr, "%d idle connections\n", n);
+
+    use_sockets = 0;
+    heap = heap_now();
+    rss = rss_now();
+    for (made = 0; made < n; made++) {
+        if (!conn_new(sctx, cctx, &conn)
+                || !create_ssl_connection(conn.server, conn.client,
+                                          SSL_ERROR_NONE)) {
+            conn_free(&conn);
+            goto end;
+        }
+        servers[made] = conn.server;
+        conn.server = NULL;
+        conn_free(&conn);
+    }
+    heap = heap_now() - heap;
+    rss = rss_now() - rss;
+
+    printf(",\n  \"idle\": {\"connections\": %d, \"heap_per_conn\": %lu",
+           n, (unsigned long)(heap / n));
+    if (rss != 0)
+        printf(", \"rss_per_conn\": %lu", (unsigned long)(rss / n));
+    printf("}");
+    ret = 1;
+ end:
+    use_sockets = sockets;
+    for (i = 0; i < made; i++)
+        SSL_free(servers[i]);
+    OPENSSL_free(servers);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return ret;
+}
+
+static const char *matrix_groups[] = {
+    "X25519", "P-256", "kyber512", "p256_kyber512", "kyber768",
+    "p384_kyber768", "kyber1024", "p521_kyber1024",
+};
+
+static const struct {
+    const char *name;
+    int nid;
+} matrix_sigs[] = {
+    { "ecdsa_p256", EVP_PKEY_EC },
+    { "rsa2048", EVP_PKEY_RSA },
+    { "dilithium2", NID_dilithium2 },
+    { "p256_dilithium2", NID_p256_dilithium2 },
+    { "dilithium3", NID_dilithium3 },
+    { "falcon512", NID_falcon512 },
+    { "p256_falcon512", NID_p256_falcon512 },
+};
+
+/* Full TLS 1.3 handshakes with every group and signature algorithm */
+static int run_matrix(void)
+{
+    SSL_CTX *sctx, *cctx;
+    EVP_PKEY *key;
+    X509 *cert;
+    HS_JOB job;
+    size_t i, j;
+    int first = 1;
+    double rate;
+
+    printf(",\n  \"matrix\": [");
+    for (j = 0; j < OSSL_NELEM(matrix_sigs); j++) {
+        cert = NULL;
+        if ((key = make_key(matrix_sigs[j].nid)) != NULL)
+            cert = make_cert(key);
+        for (i = 0; i < OSSL_NELEM(matrix_groups); i++) {
+            fprintf(stderr, "handshakes with %s and %s\n", matrix_groups[i],
+                    matrix_sigs[j].name);
+            rate = -1;
+            if (cert != NULL
+                    && make_ctx_pair(TLS1_3_VERSION, cert, key, &sctx, &cctx)) {
+                if (SSL_CTX_set1_groups_list(sctx, matrix_groups[i])
+                        && SSL_CTX_set1_groups_list(cctx, matrix_groups[i]))
+                    rate = handshakes(sctx, cctx, NULL, 1, &job);
+                SSL_CTX_free(sctx);
+                SSL_CTX_free(cctx);
+            }
+            printf("%s{\"group\": ", sep(&first));
+            json_string(matrix_groups[i]);
+            printf(", \"signature\": ");
+            json_string(matrix_sigs[j].name);
+            if (rate < 0)
+                printf(", \"available\": false}");
+            else
+                printf(", \"per_sec\": %.1f, \"client_bytes\": %lu,"
+                       " \"server_bytes\": %lu}", rate,
+                       (unsigned long)job.client_bytes,
+                       (unsigned long)job.server_bytes);
+            ERR_clear_error();
+        }
+        X509_free(cert);
+        EVP_PKEY_free(key);
+    }
+    printf("\n  ]");
+    return 1;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options] [scenario...]\n"
+            "  -time ms     Duration of each measurement (default %d)\n"
+            "  -threads n   Largest number of handshake threads (default %d)\n"
+            "  -idle n      Number of idle connections (default %d)\n"
+#ifdef BENCH_SOCKETS
+            "  -sockets     Connect over loopback sockets\n"
+#endif
+            "Scenarios: bulk handshakes resumptions idle matrix\n",
+            prog, DEFAULT_TIME_MS, DEFAULT_THREADS, DEFAULT_IDLE);
+}
+
+int main(int argc, char **argv)
+{
+    static const char *scenarios[] = {
+        "bulk", "handshakes", "resumptions", "idle", "matrix"
+    };
+    const char *prog = argv[0];
+    int selected[OSSL_NELEM(scenarios)] = { 0 }, any = 0;
+    int max_threads = DEFAULT_THREADS, idle = DEFAULT_IDLE;
+    int ret = EXIT_FAILURE, ok = 1;
+    size_t i;
+
+    /* Before anything is allocated */
+    CRYPTO_set_mem_functions(heap_malloc, heap_realloc, heap_free);
+    test_open_streams();
+
+    for (argv++; *argv != NULL; argv++) {
+        if (strcmp(*argv, "-time") == 0 && argv[1] != NULL) {
+            time_ms = (unsigned int)strtoul(*++argv, NULL, 10);
+        } else if (strcmp(*argv, "-threads") == 0 && argv[1] != NULL) {
+            max_threads = atoi(*++argv);
+        } else if (strcmp(*argv, "-idle") == 0 && argv[1] != NULL) {
+            idle = atoi(*++argv);
+#ifdef BENCH_SOCKETS
+        } else if (strcmp(*argv, "-sockets") == 0) {
+            use_sockets = 1;
+#endif
+        } else if (**argv != '-') {
+            for (i = 0; i < OSSL_NELEM(scenarios); i++)
+                if (strcmp(*argv, scenarios[i]) == 0)
+                    break;
+            if (i == OSSL_NELEM(scenarios)) {
+                usage(prog);
+                goto end;
+            }
+            selected[i] = any = 1;
+        } else {
+            usage(prog);
+            goto end;
+        }
+    }
+#ifndef BENCH_THREADS
+    max_threads = 1;
+#endif
+    if (time_ms == 0 || max_threads < 1 || max_threads > MAX_THREADS
+            || idle < 1) {
+        usage(prog);
+        goto end;
+    }
+
+    if ((ec_key = make_key(EVP_PKEY_EC)) == NULL
+            || (ec_cert = make_cert(ec_key)) == NULL) {
+        ERR_print_errors_fp(stderr);
+        goto end;
+    }
+
+    printf("{\n  \"version\": ");
+    json_string(OpenSSL_version(OPENSSL_VERSION));
+    printf(",\n  \"sockets\": %s", use_sockets ? "true" : "false");
+    printf(",\n  \"time_ms\": %u", time_ms);
+    if (ok && (!any || selected[0]))
+        ok = run_bulk();
+    if (ok && (!any || selected[1]))
+        ok = run_scaling(max_threads, 0);
+    if (ok && (!any || selected[2]))
+        ok = run_scaling(max_threads, 1);
+    if (ok && (!any || selected[3]))
+        ok = run_idle(idle);
+    if (ok && (!any || selected[4]))
+        ok = run_matrix();
+    printf("\n}\n");
+    if (!ok)
+        ERR_print_errors_fp(stderr);
+    else
+        ret = EXIT_SUCCESS;
+
+ end:
+    X509_free(ec_cert);
+    EVP_PKEY_free(ec_key);
+    test_close_streams();
+    return ret;
+}
@@ -12,6 +12,7 @@
 #include <openssl/bio.h>
 #include <openssl/pkcs7.h>
 #include <openssl/obj_mac.h>
+#include <openssl/err.h>
 
 #include "testutil.h"
 
@@ -284,6 +285,167 @@ static int test_bio_i2d_ASN1_mime(void)
     return ok;
 }
 
+static int test_bio_mem_chain(void)
+{
+    int ok = 0, i, n;
+    BIO *bio;
+    char buf[3000], *p;
+    const unsigned char *data[4];
+    size_t len[4];
+
+    for (i = 0; i < (int)sizeof(buf); i++)
+        buf[i] = (char)i;
+    bio = BIO_new(BIO_s_mem_chain());
+    if (!TEST_ptr(bio)
+            || !TEST_int_eq(BIO_set_write_buf_size(bio, 1024), 1)
+            || !TEST_int_eq(BIO_read(bio, buf, 1), -1)
+            || !TEST_true(BIO_should_retry(bio))
+            || !TEST_true(BIO_eof(bio))
+            || !TEST_int_eq(BIO_write(bio, buf, sizeof(buf)), sizeof(buf))
+            || !TEST_int_eq(BIO_pending(bio), sizeof(buf))
+            || !TEST_int_eq(BIO_mem_chain_peek(bio, data, len, 4), 3)
+            || !TEST_size_t_eq(len[0], 1024)
+            || !TEST_size_t_eq(len[2], sizeof(buf) - 2048)
+            || !TEST_mem_eq(data[1], len[1], buf + 1024, 1024))
+        goto finish;
+
+    /* Pointers handed out point into the segments themselves */
+    if (!TEST_int_eq(BIO_nread0(bio, &p), 1024)
+            || !TEST_ptr_eq(p, data[0])
+            || !TEST_int_eq(BIO_nread(bio, &p, 1000), 1000)
+            || !TEST_mem_eq(p, 1000, buf, 1000)
+            || !TEST_true(BIO_mem_chain_consume(bio, 1048))
+            || !TEST_false(BIO_mem_chain_consume(bio, sizeof(buf)))
+            || !TEST_int_eq(BIO_nread(bio, &p, 2000), sizeof(buf) - 2048)
+            || !TEST_mem_eq(p, sizeof(buf) - 2048, buf + 2048,
+                            sizeof(buf) - 2048)
+            || !TEST_int_eq(BIO_pending(bio), 0))
+        goto finish;
+
+    /* A drained tail segment is written again from its start */
+    if (!TEST_int_eq(BIO_nwrite0(bio, &p), 1024)
+            || !TEST_ptr_eq(p, data[2])
+            || !TEST_int_eq(BIO_nwrite(bio, &p, 10), 10))
+        goto finish;
+    memcpy(p, "0123456789", 10);
+    if (!TEST_int_eq(BIO_puts(bio, "ab\ncd"), 5)
+            || !TEST_int_eq(BIO_gets(bio, buf, sizeof(buf)), 13)
+            || !TEST_str_eq(buf, "0123456789ab\n")
+            || !TEST_int_eq(BIO_read(bio, buf, sizeof(buf)), 2)
+            || !TEST_mem_eq(buf, 2, "cd", 2)
+            || !TEST_int_eq(BIO_write(bio, buf, 2), 2)
+            || !TEST_int_eq(BIO_reset(bio), 1)
+            || !TEST_int_eq(BIO_pending(bio), 0))
+        goto finish;
+
+    n = BIO_mem_chain_peek(bio, data, len, 4);
+    if (!TEST_int_eq(n, 0))
+        goto finish;
+    ok = 1;
+
+ finish:
+    BIO_free(bio);
+    return ok;
+}
+
+static int test_bio_mem_chain_pair(void)
+{
+    int ok = 0;
+    BIO *b1 = NULL, *b2 = NULL;
+    char buf[16];
+
+    if (!TEST_true(BIO_new_mem_chain_pair(&b1, &b2))
+            || !TEST_int_eq(BIO_write(b1, "ping", 4), 4)
+            || !TEST_int_eq(BIO_pending(b1), 0)
+            || !TEST_int_eq(BIO_pending(b2), 4)
+            || !TEST_int_eq(BIO_write(b2, "pong!", 5), 5)
+            || !TEST_int_eq(BIO_read(b2, buf, sizeof(buf)), 4)
+            || !TEST_mem_eq(buf, 4, "ping", 4)
+            || !TEST_int_eq(BIO_read(b2, buf, sizeof(buf)), -1)
+            || !TEST_true(BIO_should_retry(b2))
+            || !TEST_false(BIO_eof(b2))
+            || !TEST_int_eq(BIO_shutdown_wr(b1), 1)
+            || !TEST_int_le(BIO_write(b1, "x", 1), 0)
+            || !TEST_true(BIO_eof(b2))
+            || !TEST_int_eq(BIO_read(b2, buf, sizeof(buf)), 0)
+            || !TEST_false(BIO_should_retry(b2)))
+        goto finish;
+
+    /* Queued data survives the writer; then the reader sees EOF */
+    BIO_free(b2);
+    b2 = NULL;
+    if (!TEST_int_eq(BIO_read(b1, buf, sizeof(buf)), 5)
+            || !TEST_mem_eq(buf, 5, "pong!", 5)
+            || !TEST_int_eq(BIO_read(b1, buf, sizeof(buf)), 0)
+            || !TEST_true(BIO_eof(b1)))
+        goto finish;
+    ok = 1;
+
+ finish:
+    ERR_clear_error();
+    BIO_free(b1);
+    BIO_free(b2);
+    return ok;
+}
+
+static int test_bio_mem_chain_move(void)
+{
+    int ok = 0, i;
+    BIO *from, *to = NULL, *mem = NULL;
+    char buf[5000], out[5000], *p, *q;
+    size_t moved;
+
+    for (i = 0; i < (int)sizeof(buf); i++)
+        buf[i] = (char)(i * 7);
+    from = BIO_new(BIO_s_mem_chain());
+    to = BIO_new(BIO_s_mem_chain());
+    mem = BIO_new(BIO_s_mem());
+    if (!TEST_ptr(from) || !TEST_ptr(to) || !TEST_ptr(mem)
+            || !TEST_int_eq(BIO_set_write_buf_size(from, 2048), 1)
+            || !TEST_int_eq(BIO_write(from, buf, sizeof(buf)), sizeof(buf))
+            || !TEST_false(BIO_mem_chain_move(mem, from, 10, &moved))
+            || !TEST_false(BIO_mem_chain_move(from, from, 10, &moved)))
+        goto finish;
+    ERR_clear_error();
+
+    /* One whole segment plus a slice of the next one */
+    if (!TEST_int_eq(BIO_nread0(from, &p), 2048)
+            || !TEST_true(BIO_mem_chain_move(to, from, 3000, &moved))
+            || !TEST_size_t_eq(moved, 3000)
+            || !TEST_int_eq(BIO_pending(from), sizeof(buf) - 3000)
+            || !TEST_int_eq(BIO_pending(to), 3000)
+            || !TEST_int_eq(BIO_nread0(to, &q), 2048)
+            || !TEST_ptr_eq(p, q))
+        goto finish;
+
+    /* Writes to |to| must not land in the shared segment */
+    if (!TEST_int_eq(BIO_write(to, "tail", 4), 4)
+            || !TEST_int_eq(BIO_read(from, out, sizeof(out)),
+                            sizeof(buf) - 3000)
+            || !TEST_mem_eq(out, sizeof(buf) - 3000, buf + 3000,
+                            sizeof(buf) - 3000)
+            || !TEST_int_eq(BIO_read(to, out, sizeof(out)), 3004)
+            || !TEST_mem_eq(out, 3000, buf, 3000)
+            || !TEST_mem_eq(out + 3000, 4, "tail", 4))
+        goto finish;
+
+    /* Moving more than is queued stops at what there is */
+    if (!TEST_int_eq(BIO_write(from, buf, 100), 100)
+            || !TEST_true(BIO_mem_chain_move(to, from, 1000, &moved))
+            || !TEST_size_t_eq(moved, 100)
+            || !TEST_int_eq(BIO_write(from, buf, 10), 10)
+            || !TEST_int_eq(BIO_read(to, out, sizeof(out)), 100)
+            || !TEST_mem_eq(out, 100, buf, 100))
+        goto finish;
+    ok = 1;
+
+ finish:
+    BIO_free(from);
+    BIO_free(to);
+    BIO_free(mem);
+    return ok;
+}
+
 int global_init(void)
 {
     CRYPTO_set_mem_debug(1);
@@ -300,5 +462,8 @@ int setup_tests(void)
     ADD_TEST(test_bio_rdwr_rdonly);
     ADD_TEST(test_bio_nonclear_rst);
     ADD_TEST(test_bio_i2d_ASN1_mime);
+    ADD_TEST(test_bio_mem_chain);
+    ADD_TEST(test_bio_mem_chain_pair);
+    ADD_TEST(test_bio_mem_chain_move);
     return 1;
 }
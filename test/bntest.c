@@ -2525,6 +2525,83 @@ static int test_gcd_prime(void)
     return st;
 }
 
+/*
+ * BN_mod_inverse() with BN_FLG_CONSTTIME and an odd modulus goes through
+ * the divstep inversion; compare it with the variable-time path.
+ */
+static int test_mod_inverse_consttime(void)
+{
+    static const int bits[] = { 2, 3, 8, 30, 31, 45, 46, 62, 63, 64, 65,
+                                192, 255, 256, 384, 521, 1024, 2048 };
+    BIGNUM *a = NULL, *n = NULL, *nct = NULL, *r = NULL, *rct = NULL;
+    BIGNUM *g = NULL;
+    size_t i;
+    int j, st = 0;
+
+    if (!TEST_ptr(a = BN_new())
+            || !TEST_ptr(n = BN_new())
+            || !TEST_ptr(nct = BN_new())
+            || !TEST_ptr(r = BN_new())
+            || !TEST_ptr(rct = BN_new())
+            || !TEST_ptr(g = BN_new()))
+        goto err;
+
+    for (i = 0; i < OSSL_NELEM(bits); i++) {
+        for (j = 0; j < 20; j++) {
+            if (!TEST_true(BN_rand(n, bits[i], BN_RAND_TOP_ONE,
+                                   BN_RAND_BOTTOM_ODD))
+                    || !TEST_ptr(BN_copy(nct, n)))
+                goto err;
+            BN_set_flags(nct, BN_FLG_CONSTTIME);
+
+            switch (j % 5) {
+            case 0:
+                /* not invertible unless gcd(a, n) happens to be 1 */
+                if (!TEST_true(BN_rand(g, bits[i] / 2 + 1, BN_RAND_TOP_ANY,
+                                       BN_RAND_BOTTOM_ANY))
+                        || !TEST_true(BN_gcd(a, g, n, ctx)))
+                    goto err;
+                break;
+            case 1:
+                /* reduced first */
+                if (!TEST_true(BN_rand(a, bits[i] + 10, BN_RAND_TOP_ANY,
+                                       BN_RAND_BOTTOM_ANY)))
+                    goto err;
+                BN_set_negative(a, j & 1);
+                break;
+            case 2:
+                if (!TEST_true(BN_sub(a, n, BN_value_one())))
+                    goto err;
+                break;
+            default:
+                if (!TEST_true(BN_rand_range(a, n)))
+                    goto err;
+            }
+
+            if (BN_mod_inverse(r, a, n, ctx) == NULL) {
+                ERR_clear_error();
+                if (!TEST_ptr_null(BN_mod_inverse(rct, a, nct, ctx)))
+                    goto err;
+                ERR_clear_error();
+            } else if (!TEST_ptr(BN_mod_inverse(rct, a, nct, ctx))
+                    || !TEST_BN_eq(r, rct)) {
+                TEST_note("bits %d, case %d", bits[i], j);
+                goto err;
+            }
+        }
+    }
+
+    st = 1;
+ err:
+    BN_free(a);
+    BN_free(n);
+    BN_free(nct);
+    BN_free(r);
+    BN_free(rct);
+    BN_free(g);
+    return st;
+}
+
 typedef struct mod_exp_test_st
 {
   const char *base;
@@ -2957,6 +3034,7 @@ int setup_tests(void)
         ADD_ALL_TESTS(test_is_prime, (int)OSSL_NELEM(primes));
         ADD_ALL_TESTS(test_not_prime, (int)OSSL_NELEM(not_primes));
         ADD_TEST(test_gcd_prime);
+        ADD_TEST(test_mod_inverse_consttime);
         ADD_ALL_TESTS(test_mod_exp, (int)OSSL_NELEM(ModExpTests));
         ADD_ALL_TESTS(test_mod_exp_consttime, (int)OSSL_NELEM(ModExpTests));
         ADD_TEST(test_mod_exp2_mont);
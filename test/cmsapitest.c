@@ -49,6 +49,72 @@ static int test_encrypt_decrypt(void)
     return testresult;
 }
 
+static int test_multi_signer_threads(int idx)
+{
+    int testresult = 0, i;
+    const char *msg = "Hello world";
+    const EVP_MD *md[3];
+    unsigned int flags = CMS_BINARY | (idx == 1 ? CMS_NOATTR : 0);
+    BIO *msgbio = BIO_new_mem_buf(msg, strlen(msg));
+    BIO *outmsgbio = BIO_new(BIO_s_mem());
+    CMS_ContentInfo *content = NULL;
+    CMS_SignerInfo *si;
+    ASN1_OCTET_STRING *sig;
+    char buf[80];
+
+    md[0] = EVP_sha256();
+    md[1] = EVP_sha384();
+    md[2] = EVP_sha256();
+
+    if (!TEST_ptr(msgbio) || !TEST_ptr(outmsgbio))
+        goto end;
+
+    content = CMS_sign(NULL, NULL, NULL, NULL, flags | CMS_PARTIAL);
+    if (!TEST_ptr(content))
+        goto end;
+    /* The same certificate can only be included once */
+    for (i = 0; i < 3; i++)
+        if (!TEST_ptr(CMS_add1_signer(content, cert, privkey, md[i],
+                                      flags | (i > 0 ? CMS_NOCERTS : 0))))
+            goto end;
+    if (!TEST_false(CMS_SignedData_set_num_threads(content, 0))
+            || !TEST_int_eq(CMS_SignedData_num_threads(content), 1))
+        goto end;
+#if defined(OPENSSL_THREADS) && !defined(OPENSSL_SYS_WINDOWS)
+    if (!TEST_true(CMS_SignedData_set_num_threads(content, 2))
+            || !TEST_int_eq(CMS_SignedData_num_threads(content), 2))
+        goto end;
+#endif
+    if (!TEST_true(CMS_final(content, msgbio, NULL, flags))
+            || !TEST_int_eq(sk_CMS_SignerInfo_num(CMS_get0_SignerInfos(content)),
+                            3))
+        goto end;
+
+    if (!TEST_true(CMS_verify(content, NULL, NULL, NULL, outmsgbio,
+                              CMS_NO_SIGNER_CERT_VERIFY))
+            || !TEST_int_eq(BIO_gets(outmsgbio, buf, sizeof(buf)), strlen(msg))
+            || !TEST_int_eq(strcmp(buf, msg), 0))
+        goto end;
+
+    /* A bad signature from any of the signers must be noticed */
+    si = sk_CMS_SignerInfo_value(CMS_get0_SignerInfos(content), 2);
+    sig = CMS_SignerInfo_get0_signature(si);
+    if (!TEST_int_gt(ASN1_STRING_length(sig), 0))
+        goto end;
+    sig->data[0] ^= 0x01;
+    if (!TEST_false(CMS_verify(content, NULL, NULL, NULL, NULL,
+                               CMS_NO_SIGNER_CERT_VERIFY)))
+        goto end;
+
+    testresult = 1;
+ end:
+    BIO_free(msgbio);
+    BIO_free(outmsgbio);
+    CMS_ContentInfo_free(content);
+
+    return testresult;
+}
+
 int setup_tests(void)
 {
     char *certin = NULL, *privkeyin = NULL;
@@ -82,6 +148,7 @@ int setup_tests(void)
     BIO_free(privkeybio);
 
     ADD_TEST(test_encrypt_decrypt);
+    ADD_ALL_TESTS(test_multi_signer_threads, 2);
 
     return 1;
 }
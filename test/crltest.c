@@ -371,6 +371,43 @@ static int test_reuse_crl(void)
     return 1;
 }
 
+static int test_crl_lookup(void)
+{
+    X509_CRL *revoked_crl = CRL_from_strings(kRevokedCRL);
+    X509_REVOKED *rev = X509_REVOKED_new(), *found = NULL;
+    ASN1_INTEGER *serial = ASN1_INTEGER_new();
+    int r = 0;
+
+    if (!TEST_ptr(revoked_crl)
+        || !TEST_ptr(rev)
+        || !TEST_ptr(serial)
+        || !TEST_int_eq(X509_CRL_get0_by_cert(revoked_crl, &found,
+                                              test_leaf), 1)
+        || !TEST_ptr(found)
+        || !TEST_int_eq(ASN1_INTEGER_cmp(X509_REVOKED_get0_serialNumber(found),
+                                         X509_get0_serialNumber(test_leaf)),
+                        0)
+        || !TEST_true(ASN1_INTEGER_set(serial, 12345))
+        || !TEST_int_eq(X509_CRL_get0_by_serial(revoked_crl, &found, serial),
+                        0)
+        || !TEST_true(X509_REVOKED_set_serialNumber(rev, serial))
+        || !TEST_true(X509_CRL_add0_revoked(revoked_crl, rev)))
+        goto err;
+    /* Entries added later are found too */
+    rev = NULL;
+    if (!TEST_int_eq(X509_CRL_get0_by_serial(revoked_crl, &found, serial), 1)
+        || !TEST_int_eq(X509_CRL_get0_by_cert(revoked_crl, &found,
+                                              test_leaf), 1))
+        goto err;
+    r = 1;
+
+ err:
+    X509_REVOKED_free(rev);
+    ASN1_INTEGER_free(serial);
+    X509_CRL_free(revoked_crl);
+    return r;
+}
+
 int setup_tests(void)
 {
     if (!TEST_ptr(test_root = X509_from_strings(kCRLTestRoot))
@@ -383,6 +420,7 @@ int setup_tests(void)
     ADD_TEST(test_known_critical_crl);
     ADD_ALL_TESTS(test_unknown_critical_crl, OSSL_NELEM(unknown_critical_crls));
     ADD_TEST(test_reuse_crl);
+    ADD_TEST(test_crl_lookup);
     return 1;
 }
 
@@ -508,6 +508,38 @@ static int test_ctlog_from_base64(void)
         return 0;
     return 1;
 }
+
+static int test_ctlog_store_get0_log_by_id(void)
+{
+    const char pilot_key[] =
+        "MFkwEwYHKoZIzj0CAQYIKoZIzj0DAQcDQgAEfahLEimAoz2t01p3uMziiLOl/fHTDM0Y"
+        "DOhBRuiBARsV4UvxG2LdNgoIGLrtCzWE0J5APC2em4JlvR8EEEFMoA==";
+    CTLOG_STORE *store = NULL;
+    CTLOG *pilot = NULL;
+    const CTLOG *found;
+    const uint8_t *log_id;
+    size_t log_id_len;
+    int ret = 0;
+
+    if (!TEST_ptr(store = CTLOG_STORE_new())
+            || !TEST_int_eq(CTLOG_STORE_load_default_file(store), 1)
+            || !TEST_true(CTLOG_new_from_base64(&pilot, pilot_key, "pilot")))
+        goto end;
+    CTLOG_get0_log_id(pilot, &log_id, &log_id_len);
+
+    if (!TEST_ptr(found = CTLOG_STORE_get0_log_by_id(store, log_id,
+                                                     log_id_len))
+            || !TEST_str_eq(CTLOG_get0_name(found), "Google Pilot Log")
+            /* Only a complete log ID identifies a log */
+            || !TEST_ptr_null(CTLOG_STORE_get0_log_by_id(store, log_id,
+                                                         log_id_len - 1)))
+        goto end;
+    ret = 1;
+end:
+    CTLOG_free(pilot);
+    CTLOG_STORE_free(store);
+    return ret;
+}
 #endif
 
 int setup_tests(void)
@@ -528,6 +560,7 @@ int setup_tests(void)
     ADD_TEST(test_encode_tls_sct);
     ADD_TEST(test_default_ct_policy_eval_ctx_time_is_now);
     ADD_TEST(test_ctlog_from_base64);
+    ADD_TEST(test_ctlog_store_get0_log_by_id);
 #else
     printf("No CT support\n");
 #endif
@@ -0,0 +1,242 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <openssl/opensslconf.h>
+#include <openssl/async.h>
+#include <openssl/engine.h>
+#include <openssl/evp.h>
+#include "testutil.h"
+
+/* Above the engine's default OFFLOAD_MIN, so that the driver is used */
+#define BUFFER_SIZE     4096
+#define NUM_JOBS        4
+
+#ifndef OPENSSL_NO_ENGINE
+static ENGINE *e;
+
+static const unsigned char key[16] = {
+    0x06, 0xa9, 0x21, 0x40, 0x36, 0xb8, 0xa1, 0x5b,
+    0x51, 0x2e, 0x03, 0xd5, 0x34, 0x12, 0x00, 0x06
+};
+static const unsigned char iv[16] = {
+    0x3d, 0xaf, 0xba, 0x42, 0x9d, 0x9e, 0xb4, 0x30,
+    0xb4, 0x22, 0xda, 0x80, 0x2c, 0x9f, 0xac, 0x41
+};
+static unsigned char in[BUFFER_SIZE];
+static unsigned char expected[BUFFER_SIZE];
+
+typedef struct {
+    EVP_CIPHER_CTX *ctx;
+    unsigned char out[BUFFER_SIZE];
+} CBC_JOB;
+
+/* Encrypts |in| with the engine's AES-128-CBC, without padding */
+static int do_aes_cbc(CBC_JOB *cj)
+{
+    int outl;
+
+    return EVP_EncryptInit_ex(cj->ctx, EVP_aes_128_cbc(), e, key, iv)
+           && EVP_CIPHER_CTX_set_padding(cj->ctx, 0)
+           && EVP_EncryptUpdate(cj->ctx, cj->out, &outl, in, sizeof(in))
+           && outl == (int)sizeof(in);
+}
+
+static int aes_cbc_job(void *arg)
+{
+    return do_aes_cbc(*(CBC_JOB **)arg);
+}
+
+static int test_devcrypto_aes_cbc(void)
+{
+    CBC_JOB cj;
+    int ret = 0;
+
+    if (!TEST_ptr(cj.ctx = EVP_CIPHER_CTX_new())
+            || !TEST_true(do_aes_cbc(&cj))
+            || !TEST_mem_eq(cj.out, sizeof(cj.out), expected, sizeof(expected)))
+        goto end;
+    ret = 1;
+ end:
+    EVP_CIPHER_CTX_free(cj.ctx);
+    return ret;
+}
+
+/*
+ * Several jobs have operations queued on the driver at once, and each of
+ * them may pick up the completion of the others'.
+ */
+static int test_devcrypto_aes_cbc_async(void)
+{
+    CBC_JOB cjs[NUM_JOBS], *cj;
+    ASYNC_JOB *jobs[NUM_JOBS] = { NULL };
+    ASYNC_WAIT_CTX *waitctxs[NUM_JOBS] = { NULL };
+    int results[NUM_JOBS], finished[NUM_JOBS] = { 0 };
+    int i, remaining = NUM_JOBS, ret = 0;
+
+    for (i = 0; i < NUM_JOBS; i++)
+        cjs[i].ctx = NULL;
+    for (i = 0; i < NUM_JOBS; i++)
+        if (!TEST_ptr(cjs[i].ctx = EVP_CIPHER_CTX_new())
+                || !TEST_ptr(waitctxs[i] = ASYNC_WAIT_CTX_new()))
+            goto end;
+
+    while (remaining > 0) {
+        for (i = 0; i < NUM_JOBS; i++) {
+            if (finished[i])
+                continue;
+            cj = &cjs[i];
+            switch (ASYNC_start_job(&jobs[i], waitctxs[i], &results[i],
+                                    aes_cbc_job, &cj, sizeof(cj))) {
+            case ASYNC_PAUSE:
+                break;
+            case ASYNC_FINISH:
+                finished[i] = 1;
+                remaining--;
+                if (!TEST_true(results[i])
+                        || !TEST_mem_eq(cjs[i].out, sizeof(cjs[i].out),
+                                        expected, sizeof(expected)))
+                    goto end;
+                break;
+            default:
+                TEST_error("job %d failed to run", i);
+                goto end;
+            }
+        }
+    }
+    ret = 1;
+ end:
+    /* Only reached with jobs still paused on failure: leave them alone */
+    for (i = 0; i < NUM_JOBS; i++) {
+        if (!ret && !finished[i])
+            continue;
+        EVP_CIPHER_CTX_free(cjs[i].ctx);
+        ASYNC_WAIT_CTX_free(waitctxs[i]);
+    }
+    return ret;
+}
+
+/*
+ * A job paused on the driver is abandoned and its wait context freed, as
+ * SSL_free() does for a connection in the middle of an operation.  The next
+ * job must still get its own result, and pick up the abandoned operation's
+ * completion without touching what was freed.
+ */
+static int test_devcrypto_abandoned_job(void)
+{
+    static CBC_JOB abandoned;
+    CBC_JOB cj, *pcj;
+    ASYNC_JOB *job = NULL;
+    ASYNC_WAIT_CTX *waitctx = NULL;
+    int res, ret = 0;
+
+    cj.ctx = NULL;
+    if (!TEST_ptr(abandoned.ctx = EVP_CIPHER_CTX_new())
+            || !TEST_ptr(cj.ctx = EVP_CIPHER_CTX_new())
+            || !TEST_ptr(waitctx = ASYNC_WAIT_CTX_new()))
+        goto end;
+
+    pcj = &abandoned;
+    switch (ASYNC_start_job(&job, waitctx, &res, aes_cbc_job, &pcj,
+                            sizeof(pcj))) {
+    case ASYNC_PAUSE:
+        /*
+         * The job is never resumed, so neither it nor |abandoned|, whose
+         * buffers the driver still writes to, can be freed.
+         */
+        ASYNC_WAIT_CTX_free(waitctx);
+        waitctx = NULL;
+        break;
+    case ASYNC_FINISH:
+        TEST_info("the driver completed the operation before it paused");
+        EVP_CIPHER_CTX_free(abandoned.ctx);
+        abandoned.ctx = NULL;
+        break;
+    default:
+        TEST_error("failed to start the job");
+        goto end;
+    }
+
+    job = NULL;
+    if (!TEST_ptr(waitctx = ASYNC_WAIT_CTX_new()))
+        goto end;
+    pcj = &cj;
+    for (;;) {
+        int status = ASYNC_start_job(&job, waitctx, &res, aes_cbc_job, &pcj,
+                                     sizeof(pcj));
+
+        if (status == ASYNC_FINISH)
+            break;
+        if (!TEST_int_eq(status, ASYNC_PAUSE))
+            goto end;
+    }
+    if (!TEST_true(res)
+            || !TEST_mem_eq(cj.out, sizeof(cj.out), expected, sizeof(expected)))
+        goto end;
+    ret = 1;
+ end:
+    EVP_CIPHER_CTX_free(cj.ctx);
+    ASYNC_WAIT_CTX_free(waitctx);
+    return ret;
+}
+
+int global_init(void)
+{
+    ENGINE_load_builtin_engines();
+# ifndef OPENSSL_NO_STATIC_ENGINE
+    OPENSSL_init_crypto(OPENSSL_INIT_ENGINE_CRYPTODEV, NULL);
+# endif
+    return 1;
+}
+#endif
+
+int setup_tests(void)
+{
+#ifndef OPENSSL_NO_ENGINE
+    EVP_CIPHER_CTX *ctx;
+    size_t i;
+    int outl;
+
+    if ((e = ENGINE_by_id("devcrypto")) == NULL) {
+        /* Probably a platform env issue, not a test failure. */
+        TEST_info("Can't load devcrypto engine");
+        return 1;
+    }
+
+    for (i = 0; i < sizeof(in); i++)
+        in[i] = (unsigned char)i;
+    /* The software implementation gives the expected result */
+    if (!TEST_ptr(ctx = EVP_CIPHER_CTX_new())
+            || !TEST_true(EVP_EncryptInit_ex(ctx, EVP_aes_128_cbc(), NULL,
+                                             key, iv))
+            || !TEST_true(EVP_CIPHER_CTX_set_padding(ctx, 0))
+            || !TEST_true(EVP_EncryptUpdate(ctx, expected, &outl, in,
+                                            sizeof(in)))) {
+        EVP_CIPHER_CTX_free(ctx);
+        return 0;
+    }
+    EVP_CIPHER_CTX_free(ctx);
+
+    ADD_TEST(test_devcrypto_aes_cbc);
+    if (ASYNC_is_capable()) {
+        ADD_TEST(test_devcrypto_aes_cbc_async);
+        ADD_TEST(test_devcrypto_abandoned_job);
+    }
+#endif
+
+    return 1;
+}
+
+#ifndef OPENSSL_NO_ENGINE
+void cleanup_tests(void)
+{
+    ENGINE_free(e);
+}
+#endif
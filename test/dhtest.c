@@ -679,6 +679,74 @@ static int rfc7919_test(void)
     DH_free(b);
     return ret;
 }
+
+/*
+ * The RFC 3526 groups share a process-wide Montgomery context looked up by
+ * prime; check that keys agreed through it match a plain exponentiation.
+ */
+static BIGNUM *(*const rfc3526_primes[])(BIGNUM *) = {
+    BN_get_rfc3526_prime_1536,
+    BN_get_rfc3526_prime_2048,
+};
+
+static int rfc3526_test(int idx)
+{
+    DH *a = NULL, *b = NULL;
+    BIGNUM *p = NULL, *g = NULL, *z = NULL;
+    BN_CTX *ctx = NULL;
+    const BIGNUM *apub_key = NULL, *bpriv_key = NULL, *bpub_key = NULL;
+    unsigned char *abuf = NULL, *zbuf = NULL;
+    int alen, aout, zlen;
+    int ret = 0;
+
+    if (!TEST_ptr(ctx = BN_CTX_new())
+            || !TEST_ptr(a = DH_new())
+            || !TEST_ptr(b = DH_new())
+            || !TEST_ptr(p = rfc3526_primes[idx](NULL))
+            || !TEST_ptr(g = BN_new())
+            || !TEST_true(BN_set_word(g, 2))
+            || !TEST_true(DH_set0_pqg(a, p, NULL, g)))
+        goto err;
+    p = g = NULL;
+    if (!TEST_ptr(p = BN_dup(DH_get0_p(a)))
+            || !TEST_ptr(g = BN_dup(DH_get0_g(a)))
+            || !TEST_true(DH_set0_pqg(b, p, NULL, g)))
+        goto err;
+    p = g = NULL;
+
+    if (!TEST_true(DH_generate_key(a))
+            || !TEST_true(DH_generate_key(b)))
+        goto err;
+    DH_get0_key(a, &apub_key, NULL);
+    DH_get0_key(b, &bpub_key, &bpriv_key);
+
+    alen = DH_size(a);
+    if (!TEST_ptr(abuf = OPENSSL_malloc(alen))
+            || !TEST_int_gt(aout = DH_compute_key(abuf, bpub_key, a), 0))
+        goto err;
+
+    if (!TEST_ptr(z = BN_new())
+            || !TEST_true(BN_mod_exp(z, apub_key, bpriv_key, DH_get0_p(b),
+                                     ctx))
+            || !TEST_ptr(zbuf = OPENSSL_malloc(BN_num_bytes(z))))
+        goto err;
+    zlen = BN_bn2bin(z, zbuf);
+    if (!TEST_mem_eq(abuf, aout, zbuf, zlen))
+        goto err;
+
+    ret = 1;
+
+ err:
+    OPENSSL_free(abuf);
+    OPENSSL_free(zbuf);
+    BN_free(z);
+    BN_free(p);
+    BN_free(g);
+    BN_CTX_free(ctx);
+    DH_free(a);
+    DH_free(b);
+    return ret;
+}
 #endif
 
 
@@ -690,6 +758,7 @@ int setup_tests(void)
     ADD_TEST(dh_test);
     ADD_TEST(rfc5114_test);
     ADD_TEST(rfc7919_test);
+    ADD_ALL_TESTS(rfc3526_test, OSSL_NELEM(rfc3526_primes));
 #endif
     return 1;
 }
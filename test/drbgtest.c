@@ -29,6 +29,8 @@
 # include <unistd.h>
 #endif
 
+#include <oqs/oqs.h>
+
 #include "testutil.h"
 #include "drbgtest.h"
 
@@ -1012,6 +1014,103 @@ static int test_rand_add(void)
     return 1;
 }
 
+/*
+ * Test that RAND_DRBG_FLAG_BUFFERED serves small requests from one bulk
+ * generate call, and drops the buffer whenever the DRBG has to reseed.
+ */
+static int test_drbg_buffered(void)
+{
+    RAND_DRBG *master = NULL, *drbg = NULL;
+    unsigned char a[32], b[32], big[DRBG_BUFFER_MAX_REQUEST + 1];
+    unsigned int counter;
+    int i, fork_id, ret = 0;
+
+    if (!TEST_ptr(master = RAND_DRBG_new(NID_aes_256_ctr, 0, NULL))
+            || !TEST_ptr(drbg = RAND_DRBG_new(NID_aes_256_ctr,
+                                              RAND_DRBG_FLAG_BUFFERED,
+                                              master))
+            || !TEST_true(RAND_DRBG_instantiate(master, NULL, 0))
+            || !TEST_true(RAND_DRBG_instantiate(drbg, NULL, 0)))
+        goto err;
+    drbg->enable_reseed_propagation = 1;
+    master->enable_reseed_propagation = 1;
+    drbg->reseed_counter = master->reseed_counter;
+
+    /* one generate call fills the buffer for many small requests */
+    if (!TEST_true(RAND_DRBG_bytes(drbg, a, sizeof(a))))
+        goto err;
+    counter = drbg->generate_counter;
+    if (!TEST_size_t_eq(drbg->buf_left, DRBG_BUFFER_SIZE - sizeof(a)))
+        goto err;
+    for (i = 0; i < 16; i++) {
+        if (!TEST_true(RAND_DRBG_bytes(drbg, b, sizeof(b)))
+                || !TEST_mem_ne(a, sizeof(a), b, sizeof(b)))
+            goto err;
+        memcpy(a, b, sizeof(a));
+    }
+    if (!TEST_uint_eq(drbg->generate_counter, counter)
+            || !TEST_size_t_eq(drbg->buf_left,
+                               DRBG_BUFFER_SIZE - 17 * sizeof(a)))
+        goto err;
+
+    /* larger requests bypass the buffer */
+    if (!TEST_true(RAND_DRBG_bytes(drbg, big, sizeof(big)))
+            || !TEST_uint_eq(drbg->generate_counter, counter + 1)
+            || !TEST_size_t_eq(drbg->buf_left,
+                               DRBG_BUFFER_SIZE - 17 * sizeof(a)))
+        goto err;
+
+    /* an explicit reseed wipes the buffer */
+    if (!TEST_true(RAND_DRBG_reseed(drbg, NULL, 0, 0))
+            || !TEST_size_t_eq(drbg->buf_left, 0))
+        goto err;
+
+    /* so does a reseed of the parent, or a fork */
+    if (!TEST_true(RAND_DRBG_bytes(drbg, a, sizeof(a)))
+            || !TEST_true(RAND_DRBG_reseed(master, NULL, 0, 0))
+            || !TEST_true(RAND_DRBG_bytes(drbg, a, sizeof(a)))
+            || !TEST_int_eq(drbg->reseed_counter, master->reseed_counter)
+            || !TEST_uint_eq(drbg->generate_counter, 2)
+            || !TEST_size_t_eq(drbg->buf_left, DRBG_BUFFER_SIZE - sizeof(a)))
+        goto err;
+    fork_id = drbg->fork_id;
+    drbg->fork_id = ~fork_id;
+    if (!TEST_true(RAND_DRBG_bytes(drbg, a, sizeof(a)))
+            || !TEST_int_eq(drbg->fork_id, fork_id)
+            || !TEST_uint_eq(drbg->generate_counter, 2)
+            || !TEST_size_t_eq(drbg->buf_left, DRBG_BUFFER_SIZE - sizeof(a)))
+        goto err;
+
+    /* as does uninstantiating */
+    if (!TEST_true(RAND_DRBG_uninstantiate(drbg))
+            || !TEST_size_t_eq(drbg->buf_left, 0))
+        goto err;
+
+    ret = 1;
+err:
+    RAND_DRBG_free(drbg);
+    RAND_DRBG_free(master);
+    return ret;
+}
+
+/* Test that liboqs draws its randomness from the private DRBG */
+static int test_oqs_randombytes(void)
+{
+    RAND_DRBG *private;
+    unsigned char zero[64] = { 0 }, buf[64];
+    unsigned int counter;
+
+    /* settle any reseed left pending by the earlier tests */
+    if (!TEST_ptr(private = RAND_DRBG_get0_private())
+            || !TEST_true(RAND_priv_bytes(buf, sizeof(buf))))
+        return 0;
+    counter = private->generate_counter;
+    memset(buf, 0, sizeof(buf));
+    OQS_randombytes(buf, sizeof(buf));
+    return TEST_uint_gt(private->generate_counter, counter)
+           && TEST_mem_ne(buf, sizeof(buf), zero, sizeof(zero));
+}
+
 int setup_tests(void)
 {
     app_data_index = RAND_DRBG_get_ex_new_index(0L, NULL, NULL, NULL, NULL);
@@ -1021,6 +1120,8 @@ int setup_tests(void)
     ADD_TEST(test_rand_drbg_reseed);
     ADD_TEST(test_rand_seed);
     ADD_TEST(test_rand_add);
+    ADD_TEST(test_drbg_buffered);
+    ADD_TEST(test_oqs_randombytes);
 #if defined(OPENSSL_THREADS)
     ADD_TEST(test_multi_thread);
 #endif
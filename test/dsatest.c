@@ -115,6 +115,77 @@ static int dsa_test(void)
     return ret;
 }
 
+static DSA *dsa_from_out_pqg(void)
+{
+    DSA *dsa = DSA_new();
+    BIGNUM *p = BN_bin2bn(out_p, sizeof(out_p), NULL);
+    BIGNUM *q = BN_bin2bn(out_q, sizeof(out_q), NULL);
+    BIGNUM *g = BN_bin2bn(out_g, sizeof(out_g), NULL);
+
+    if (dsa == NULL || p == NULL || q == NULL || g == NULL
+            || !DSA_set0_pqg(dsa, p, q, g)) {
+        DSA_free(dsa);
+        BN_free(p);
+        BN_free(q);
+        BN_free(g);
+        return NULL;
+    }
+    if (!DSA_generate_key(dsa)) {
+        DSA_free(dsa);
+        return NULL;
+    }
+    return dsa;
+}
+
+/*
+ * Verification through the cached fixed-base tables must agree with the
+ * plain path, and the tables must follow a change of public key.
+ */
+static int dsa_verify_tables_test(void)
+{
+    DSA *a = NULL, *b = NULL;
+    BIGNUM *pub = NULL;
+    unsigned char sig[256], msg[20];
+    unsigned int siglen, bsiglen;
+    unsigned char bsig[256];
+    int i, ret = 0;
+
+    if (!TEST_ptr(a = dsa_from_out_pqg())
+            || !TEST_ptr(b = dsa_from_out_pqg()))
+        goto end;
+    DSA_set_flags(a, DSA_FLAG_CACHE_VERIFY_TABLES);
+
+    for (i = 0; i < 4; i++) {
+        memcpy(msg, str1, sizeof(msg));
+        msg[0] ^= (unsigned char)i;
+        if (!TEST_true(DSA_sign(0, msg, sizeof(msg), sig, &siglen, a))
+                || !TEST_int_eq(DSA_verify(0, msg, sizeof(msg), sig, siglen,
+                                           a), 1))
+            goto end;
+        msg[1] ^= 1;
+        if (!TEST_int_eq(DSA_verify(0, msg, sizeof(msg), sig, siglen, a), 0))
+            goto end;
+    }
+
+    /* switch a over to b's public key */
+    if (!TEST_true(DSA_sign(0, str1, 20, bsig, &bsiglen, b))
+            || !TEST_ptr(pub = BN_dup(DSA_get0_pub_key(b)))
+            || !TEST_true(DSA_set0_key(a, pub, NULL)))
+        goto end;
+    pub = NULL;
+    if (!TEST_int_eq(DSA_verify(0, str1, 20, bsig, bsiglen, a), 1)
+            || !TEST_int_eq(DSA_verify(0, msg, sizeof(msg), sig, siglen, a),
+                            0))
+        goto end;
+    ret = 1;
+
+ end:
+    BN_free(pub);
+    DSA_free(a);
+    DSA_free(b);
+    return ret;
+}
+
 static int dsa_cb(int p, int n, BN_GENCB *arg)
 {
     static int ok = 0, num = 0;
@@ -136,6 +207,7 @@ int setup_tests(void)
 {
 #ifndef OPENSSL_NO_DSA
     ADD_TEST(dsa_test);
+    ADD_TEST(dsa_verify_tables_test);
 #endif
     return 1;
 }
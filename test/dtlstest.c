@@ -15,6 +15,14 @@
 
 #include "ssltestlib.h"
 #include "testutil.h"
+#include "internal/nelem.h"
+
+#if defined(OPENSSL_SYS_LINUX) && !defined(OPENSSL_NO_SOCK)
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/socket.h>
+# include <netinet/in.h>
+#endif
 
 static char *cert = NULL;
 static char *privkey = NULL;
@@ -245,6 +253,53 @@ static int test_dtls_drop_records(int idx)
     return testresult;
 }
 
+/*
+ * Test that a flight retransmitted in paced bursts still gets through. The
+ * bursts are a single byte long, so every burst is one record, and resuming
+ * the flight happens within and across messages.
+ */
+static int test_dtls_paced_retransmit(int idx)
+{
+    SSL_CTX *sctx = NULL, *cctx = NULL;
+    SSL *serverssl = NULL, *clientssl = NULL;
+    BIO *mempackbio;
+    int testresult = 0;
+
+    if (!TEST_true(create_ssl_ctx_pair(DTLS_server_method(),
+                                       DTLS_client_method(),
+                                       DTLS1_VERSION, DTLS_MAX_VERSION,
+                                       &sctx, &cctx, cert, privkey)))
+        return 0;
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL)))
+        goto end;
+
+    DTLS_set_timer_cb(clientssl, timer_cb);
+    DTLS_set_timer_cb(serverssl, timer_cb);
+    DTLS_set_retransmit_pacing(serverssl, 1, 0);
+
+    /* Drop one of the records of the first flight of the server */
+    mempackbio = SSL_get_wbio(serverssl);
+    BIO_ctrl(mempackbio, MEMPACKET_CTRL_SET_DROP_EPOCH, 0, NULL);
+    BIO_ctrl(mempackbio, MEMPACKET_CTRL_SET_DROP_REC, idx, NULL);
+
+    if (!TEST_true(create_ssl_connection(serverssl, clientssl, SSL_ERROR_NONE))
+            || !TEST_int_eq((int)BIO_ctrl(mempackbio,
+                                          MEMPACKET_CTRL_GET_DROP_REC, 0,
+                                          NULL), -1))
+        goto end;
+
+    testresult = 1;
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+
 static const char dummy_cookie[] = "0123456";
 
 static int generate_cookie_cb(SSL *ssl, unsigned char *cookie,
@@ -415,6 +470,156 @@ static int test_swap_app_data(void)
     return testresult;
 }
 
+#if defined(OPENSSL_SYS_LINUX) && !defined(OPENSSL_NO_SOCK)
+# define MMSG_BATCH     8
+# define MMSG_MAX_LOOPS 100000
+
+/* Two non-blocking UDP sockets on the loopback interface, connected */
+static int create_dgram_sockets(int *cfdp, int *sfdp, BIO_ADDR *speer)
+{
+    struct sockaddr_in csin, ssin;
+    socklen_t slen = sizeof(ssin);
+    int fd[2] = { -1, -1 }, i;
+
+    memset(&csin, 0, sizeof(csin));
+    csin.sin_family = AF_INET;
+    csin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ssin = csin;
+
+    for (i = 0; i < 2; i++)
+        if ((fd[i] = socket(AF_INET, SOCK_DGRAM, 0)) < 0
+                || fcntl(fd[i], F_SETFL, O_NONBLOCK) < 0)
+            goto err;
+    if (bind(fd[0], (struct sockaddr *)&csin, sizeof(csin)) < 0
+            || bind(fd[1], (struct sockaddr *)&ssin, sizeof(ssin)) < 0
+            || getsockname(fd[0], (struct sockaddr *)&csin, &slen) < 0
+            || (slen = sizeof(ssin),
+                getsockname(fd[1], (struct sockaddr *)&ssin, &slen) < 0)
+            || connect(fd[0], (struct sockaddr *)&ssin, sizeof(ssin)) < 0
+            || connect(fd[1], (struct sockaddr *)&csin, sizeof(csin)) < 0
+            || !BIO_ADDR_rawmake(speer, AF_INET, &ssin.sin_addr,
+                                 sizeof(ssin.sin_addr), ssin.sin_port))
+        goto err;
+    *cfdp = fd[0];
+    *sfdp = fd[1];
+    return 1;
+
+ err:
+    for (i = 0; i < 2; i++)
+        if (fd[i] != -1)
+            close(fd[i]);
+    return 0;
+}
+
+/*
+ * Test batched datagram I/O: writes are queued until a flush sends them with
+ * sendmmsg(), reads are served from one recvmmsg(), and DTLS runs on top.
+ */
+static int test_dtls_mmsg(void)
+{
+    SSL_CTX *sctx = NULL, *cctx = NULL;
+    SSL *sssl = NULL, *cssl = NULL;
+    BIO *cbio = NULL, *sbio = NULL;
+    BIO_ADDR *speer = NULL;
+    static const int lens[] = { 1000, 1000, 1000, 1000, 300 };
+    unsigned char buf[1200];
+    int cfd = -1, sfd = -1, i, j, ret, testresult = 0;
+
+    if (!TEST_ptr(speer = BIO_ADDR_new())
+            || !TEST_true(create_dgram_sockets(&cfd, &sfd, speer))
+            || !TEST_ptr(cbio = BIO_new_dgram(cfd, BIO_NOCLOSE))
+            || !TEST_ptr(sbio = BIO_new_dgram(sfd, BIO_NOCLOSE)))
+        goto end;
+    if (!BIO_dgram_set_mmsg(cbio, MMSG_BATCH)) {
+        TEST_info("recvmmsg()/sendmmsg() not supported");
+        testresult = 1;
+        goto end;
+    }
+    /* The client BIO is connected, the server one learns its peer */
+    if (!TEST_true(BIO_dgram_set_mmsg(sbio, MMSG_BATCH))
+            || !TEST_int_eq(BIO_dgram_get_mmsg(cbio), MMSG_BATCH)
+            || !TEST_true(BIO_ctrl_set_connected(cbio, speer)))
+        goto end;
+
+    for (i = 0; i < (int)OSSL_NELEM(lens); i++) {
+        memset(buf, 'a' + i, lens[i]);
+        if (!TEST_int_eq(BIO_write(cbio, buf, lens[i]), lens[i]))
+            goto end;
+    }
+    /* Nothing has been sent before the flush */
+    if (!TEST_int_le(BIO_read(sbio, buf, sizeof(buf)), 0)
+            || !TEST_true(BIO_should_retry(sbio))
+            || !TEST_int_eq(BIO_flush(cbio), 1))
+        goto end;
+    for (i = 0; i < (int)OSSL_NELEM(lens); i++) {
+        if (!TEST_int_eq(BIO_read(sbio, buf, sizeof(buf)), lens[i]))
+            goto end;
+        for (j = 0; j < lens[i]; j++)
+            if (!TEST_int_eq(buf[j], 'a' + i))
+                goto end;
+        if (!TEST_int_eq(BIO_pending(sbio),
+                         i + 1 < (int)OSSL_NELEM(lens) ? lens[i + 1] : 0))
+            goto end;
+    }
+    if (!TEST_int_le(BIO_read(sbio, buf, sizeof(buf)), 0)
+            || !TEST_true(BIO_should_retry(sbio)))
+        goto end;
+
+    if (!TEST_true(create_ssl_ctx_pair(DTLS_server_method(),
+                                       DTLS_client_method(),
+                                       DTLS1_VERSION, 0,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_ptr(sssl = SSL_new(sctx))
+            || !TEST_ptr(cssl = SSL_new(cctx)))
+        goto end;
+    SSL_set_bio(sssl, sbio, sbio);
+    sbio = NULL;
+    SSL_set_bio(cssl, cbio, cbio);
+    cbio = NULL;
+    if (!TEST_true(create_ssl_connection(sssl, cssl, SSL_ERROR_NONE)))
+        goto end;
+
+    /* Application data goes out on the flush, several records per call */
+    for (i = 0; i < MMSG_BATCH; i++) {
+        memset(buf, 'A' + i, sizeof(buf));
+        if (!TEST_int_eq(SSL_write(cssl, buf, sizeof(buf)), (int)sizeof(buf)))
+            goto end;
+    }
+    if (!TEST_int_eq(BIO_flush(SSL_get_wbio(cssl)), 1))
+        goto end;
+    for (i = 0, j = 0; i < MMSG_BATCH && j < MMSG_MAX_LOOPS; j++) {
+        ret = SSL_read(sssl, buf, sizeof(buf));
+        if (ret <= 0) {
+            if (!TEST_int_eq(SSL_get_error(sssl, ret), SSL_ERROR_WANT_READ))
+                goto end;
+            continue;
+        }
+        if (!TEST_int_eq(ret, (int)sizeof(buf))
+                || !TEST_int_eq(buf[0], 'A' + i)
+                || !TEST_int_eq(buf[sizeof(buf) - 1], 'A' + i))
+            goto end;
+        i++;
+    }
+    if (!TEST_int_eq(i, MMSG_BATCH))
+        goto end;
+
+    testresult = 1;
+ end:
+    SSL_free(cssl);
+    SSL_free(sssl);
+    SSL_CTX_free(cctx);
+    SSL_CTX_free(sctx);
+    BIO_free(cbio);
+    BIO_free(sbio);
+    BIO_ADDR_free(speer);
+    if (cfd != -1)
+        close(cfd);
+    if (sfd != -1)
+        close(sfd);
+    return testresult;
+}
+#endif
+
 int setup_tests(void)
 {
     if (!TEST_ptr(cert = test_get_argument(0))
@@ -423,9 +628,13 @@ int setup_tests(void)
 
     ADD_ALL_TESTS(test_dtls_unprocessed, NUM_TESTS);
     ADD_ALL_TESTS(test_dtls_drop_records, TOTAL_RECORDS);
+    ADD_ALL_TESTS(test_dtls_paced_retransmit, SRV_TO_CLI_EPOCH_0_RECS);
     ADD_TEST(test_cookie);
     ADD_TEST(test_dtls_duplicate_records);
     ADD_TEST(test_swap_app_data);
+#if defined(OPENSSL_SYS_LINUX) && !defined(OPENSSL_NO_SOCK)
+    ADD_TEST(test_dtls_mmsg);
+#endif
 
     return 1;
 }
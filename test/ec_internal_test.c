@@ -7,6 +7,7 @@
  * https://www.openssl.org/source/license.html
  */
 
+#include <string.h>
 #include "internal/nelem.h"
 #include "testutil.h"
 #include <openssl/ec.h>
@@ -357,6 +358,50 @@ end:
     return testresult;
 }
 
+/* RFC 7748 section 6.1: Alice's private key and public value */
+static const uint8_t x25519_alice_priv[32] = {
+    0x77, 0x07, 0x6d, 0x0a, 0x73, 0x18, 0xa5, 0x7d, 0x3c, 0x16, 0xc1, 0x72,
+    0x51, 0xb2, 0x66, 0x45, 0xdf, 0x4c, 0x2f, 0x87, 0xeb, 0xc0, 0x99, 0x2a,
+    0xb1, 0x77, 0xfb, 0xa5, 0x1d, 0xb9, 0x2c, 0x2a
+};
+static const uint8_t x25519_alice_pub[32] = {
+    0x85, 0x20, 0xf0, 0x09, 0x89, 0x30, 0xa7, 0x54, 0x74, 0x8b, 0x7d, 0xdc,
+    0xb4, 0x3e, 0xf7, 0x5a, 0x0d, 0xbf, 0x3a, 0x0d, 0x26, 0x38, 0x1a, 0xf4,
+    0xeb, 0xa4, 0xa9, 0x8e, 0xaa, 0x9b, 0x4e, 0x6a
+};
+
+static const size_t x25519_batch_sizes[] = { 1, 5, 13 };
+
+/* the batched public values must match the one-at-a-time ones */
+static int x25519_batch_test(int n)
+{
+    size_t num = x25519_batch_sizes[n], i;
+    uint8_t priv[13 * 32], pub[13 * 32], expected[32];
+    int testresult = 0;
+
+    memcpy(priv, x25519_alice_priv, 32);
+    for (i = 1; i < num; i++) {
+        memcpy(priv + 32 * i, priv + 32 * (i - 1), 32);
+        priv[32 * i] ^= (uint8_t)(i * 0x35);
+        priv[32 * i + 17] += (uint8_t)i;
+    }
+
+    X25519_public_from_private_batch(pub, priv, num);
+    if (!TEST_mem_eq(pub, 32, x25519_alice_pub, 32))
+        goto err;
+    for (i = 1; i < num; i++) {
+        X25519_public_from_private(expected, priv + 32 * i);
+        if (!TEST_mem_eq(pub + 32 * i, 32, expected, 32)) {
+            TEST_info("key %zu of %zu", i, num);
+            goto err;
+        }
+    }
+    testresult = 1;
+
+ err:
+    return testresult;
+}
+
 int setup_tests(void)
 {
     crv_len = EC_get_builtin_curves(NULL, 0);
@@ -373,6 +418,7 @@ int setup_tests(void)
     ADD_TEST(set_private_key);
     ADD_TEST(decoded_flag_test);
     ADD_ALL_TESTS(ecpkparams_i2d2i_test, crv_len);
+    ADD_ALL_TESTS(x25519_batch_test, OSSL_NELEM(x25519_batch_sizes));
 
     return 1;
 }
@@ -313,6 +313,138 @@ static int test_builtin(int n)
     OPENSSL_free(sig);
     return ret;
 }
+
+/*
+ * Test 0-2: a batch of signatures under keys on one curve
+ * Test 3: a batch mixing curves, which is verified one by one
+ */
+static const int verify_batch_nids[] = {
+    NID_secp256k1, NID_X9_62_prime256v1, NID_secp384r1, NID_undef
+};
+
+# define VERIFY_BATCH_NUM 6
+
+static int test_verify_batch(int n)
+{
+    EC_KEY *keys[VERIFY_BATCH_NUM] = { NULL };
+    ECDSA_SIG *sigs[VERIFY_BATCH_NUM] = { NULL };
+    unsigned char tbs[VERIFY_BATCH_NUM][32];
+    const unsigned char *dgst[VERIFY_BATCH_NUM];
+    int dgst_len[VERIFY_BATCH_NUM], ok[VERIFY_BATCH_NUM];
+    int i, nid, ret = 0;
+
+    for (i = 0; i < VERIFY_BATCH_NUM; i++) {
+        nid = verify_batch_nids[n];
+        if (nid == NID_undef)
+            nid = verify_batch_nids[i % (OSSL_NELEM(verify_batch_nids) - 1)];
+        dgst[i] = tbs[i];
+        dgst_len[i] = sizeof(tbs[i]);
+        /* two signatures under each key */
+        if (i % 2 == 1 && nid == EC_GROUP_get_curve_name(
+                                      EC_KEY_get0_group(keys[i - 1]))) {
+            if (!TEST_true(EC_KEY_up_ref(keys[i - 1])))
+                goto err;
+            keys[i] = keys[i - 1];
+        } else if (!TEST_ptr(keys[i] = EC_KEY_new_by_curve_name(nid))
+                   || !TEST_true(EC_KEY_generate_key(keys[i]))) {
+            goto err;
+        }
+        if (!TEST_true(RAND_bytes(tbs[i], sizeof(tbs[i])))
+            || !TEST_ptr(sigs[i] = ECDSA_do_sign(tbs[i], sizeof(tbs[i]),
+                                                 keys[i])))
+            goto err;
+    }
+
+    if (!TEST_int_eq(ECDSA_do_verify_batch(dgst, dgst_len,
+                                           (const ECDSA_SIG **)sigs, keys,
+                                           VERIFY_BATCH_NUM, ok), 1))
+        goto err;
+    for (i = 0; i < VERIFY_BATCH_NUM; i++)
+        if (!TEST_int_eq(ok[i], 1))
+            goto err;
+
+    /* Only the signatures whose message changed fail */
+    tbs[1][0] ^= 1;
+    tbs[4][31] ^= 0x80;
+    if (!TEST_int_eq(ECDSA_do_verify_batch(dgst, dgst_len,
+                                           (const ECDSA_SIG **)sigs, keys,
+                                           VERIFY_BATCH_NUM, ok), 0))
+        goto err;
+    for (i = 0; i < VERIFY_BATCH_NUM; i++)
+        if (!TEST_int_eq(ok[i], i == 1 || i == 4 ? 0 : 1)
+            || !TEST_int_eq(ECDSA_do_verify(dgst[i], dgst_len[i], sigs[i],
+                                            keys[i]), ok[i]))
+            goto err;
+
+    ret = 1;
+ err:
+    for (i = 0; i < VERIFY_BATCH_NUM; i++) {
+        EC_KEY_free(keys[i]);
+        ECDSA_SIG_free(sigs[i]);
+    }
+    return ret;
+}
+
+/*
+ * Verification under a key with precomputed multiples of it, on curves with
+ * and without generic point multiplication
+ */
+static const int verify_precompute_nids[] = {
+    NID_secp384r1, NID_brainpoolP256r1, NID_X9_62_prime256v1
+};
+
+static int test_verify_precompute(int n)
+{
+    EC_KEY *key = NULL, *other = NULL;
+    ECDSA_SIG *sigs[8] = { NULL }, *other_sig = NULL;
+    unsigned char tbs[8][32];
+    int i, ret = 0;
+
+    if (!TEST_ptr(key = EC_KEY_new_by_curve_name(verify_precompute_nids[n]))
+        || !TEST_true(EC_KEY_generate_key(key))
+        || !TEST_ptr(other = EC_KEY_new_by_curve_name(verify_precompute_nids[n]))
+        || !TEST_true(EC_KEY_generate_key(other)))
+        goto err;
+    EC_KEY_set_verify_precompute(key, 3);
+
+    for (i = 0; i < (int)OSSL_NELEM(sigs); i++)
+        if (!TEST_true(RAND_bytes(tbs[i], sizeof(tbs[i])))
+            || !TEST_ptr(sigs[i] = ECDSA_do_sign(tbs[i], sizeof(tbs[i]), key)))
+            goto err;
+    if (!TEST_ptr(other_sig = ECDSA_do_sign(tbs[0], sizeof(tbs[0]), other)))
+        goto err;
+
+    /* before, at and after the verification that computes the multiples */
+    for (i = 0; i < (int)OSSL_NELEM(sigs); i++) {
+        if (!TEST_int_eq(ECDSA_do_verify(tbs[i], sizeof(tbs[i]), sigs[i], key),
+                         1))
+            goto err;
+        tbs[i][0] ^= 1;
+        if (!TEST_int_eq(ECDSA_do_verify(tbs[i], sizeof(tbs[i]), sigs[i], key),
+                         0))
+            goto err;
+        tbs[i][0] ^= 1;
+    }
+
+    /* a new public key must not use the old one's multiples */
+    if (!TEST_true(EC_KEY_set_public_key(key, EC_KEY_get0_public_key(other)))
+        || !TEST_int_eq(ECDSA_do_verify(tbs[0], sizeof(tbs[0]), sigs[0], key),
+                        0))
+        goto err;
+    for (i = 0; i < 4; i++)
+        if (!TEST_int_eq(ECDSA_do_verify(tbs[0], sizeof(tbs[0]), other_sig,
+                                         key), 1))
+            goto err;
+
+    ret = 1;
+ err:
+    for (i = 0; i < (int)OSSL_NELEM(sigs); i++)
+        ECDSA_SIG_free(sigs[i]);
+    ECDSA_SIG_free(other_sig);
+    EC_KEY_free(key);
+    EC_KEY_free(other);
+    return ret;
+}
 #endif
 
 int setup_tests(void)
@@ -327,6 +459,8 @@ int setup_tests(void)
         return 0;
     ADD_ALL_TESTS(test_builtin, crv_len);
     ADD_ALL_TESTS(x9_62_tests, OSSL_NELEM(ecdsa_cavs_kats));
+    ADD_ALL_TESTS(test_verify_batch, OSSL_NELEM(verify_batch_nids));
+    ADD_ALL_TESTS(test_verify_precompute, OSSL_NELEM(verify_precompute_nids));
 #endif
     return 1;
 }
@@ -2229,6 +2229,249 @@ static int custom_generator_test(int id)
     return ret;
 }
 
+/*
+ * Multiplying the generator of P-384 and P-521 uses a precomputed table:
+ * check it against multiplying the generator as an arbitrary point.
+ */
+static const int fixed_base_nids[] = { NID_secp384r1, NID_secp521r1 };
+
+static int fixed_base_test(int id)
+{
+    int ret = 0, i;
+    EC_GROUP *group = NULL;
+    EC_POINT *P = NULL, *Q = NULL;
+    const EC_POINT *G;
+    BN_CTX *ctx = NULL;
+    BIGNUM *k = NULL;
+    const BIGNUM *order;
+
+    TEST_note("Curve %s", OBJ_nid2sn(fixed_base_nids[id]));
+    if (!TEST_ptr(ctx = BN_CTX_new())
+        || !TEST_ptr(group = EC_GROUP_new_by_curve_name(fixed_base_nids[id]))
+        || !TEST_ptr(P = EC_POINT_new(group))
+        || !TEST_ptr(Q = EC_POINT_new(group))
+        || !TEST_ptr(k = BN_new()))
+        goto err;
+    G = EC_GROUP_get0_generator(group);
+    order = EC_GROUP_get0_order(group);
+
+    for (i = 0; i < 24; i++) {
+        switch (i) {
+        case 0:
+        case 1:
+        case 2:
+        case 3:
+            /* 0, 1, 15 and 16: single window edge cases */
+            if (!TEST_true(BN_set_word(k, i < 2 ? i : 13 + i)))
+                goto err;
+            break;
+        case 4:
+        case 5:
+        case 6:
+            /* order - 1, order and order + 1 */
+            if (!TEST_ptr(BN_copy(k, order))
+                || !TEST_true(BN_add_word(k, 1))
+                || !TEST_true(BN_sub_word(k, 6 - i)))
+                goto err;
+            break;
+        case 7:
+            /* wider than the table: must be reduced first */
+            if (!TEST_true(BN_lshift(k, order, 8)))
+                goto err;
+            break;
+        default:
+            if (!TEST_true(BN_rand_range(k, order)))
+                goto err;
+            if (i == 8)
+                BN_set_negative(k, 1);
+            break;
+        }
+        if (!TEST_true(EC_POINT_mul(group, P, k, NULL, NULL, ctx))
+            || !TEST_true(EC_POINT_mul(group, Q, NULL, G, k, ctx))
+            || !TEST_int_eq(EC_POINT_cmp(group, P, Q, ctx), 0)
+            || !TEST_true(EC_POINT_is_on_curve(group, P, ctx)))
+            goto err;
+    }
+    ret = 1;
+
+ err:
+    EC_POINT_free(P);
+    EC_POINT_free(Q);
+    EC_GROUP_free(group);
+    BN_free(k);
+    BN_CTX_free(ctx);
+    return ret;
+}
+
+/*
+ * Test 0-2: a batch of keys on one curve
+ * Test 3: a batch mixing curves, which is generated key by key
+ */
+static const int keygen_batch_nids[] = {
+    NID_X9_62_prime256v1, NID_secp384r1, NID_secp256k1
+};
+
+static int keygen_batch_test(int id)
+{
+    EC_KEY *keys[5] = { NULL };
+    size_t i;
+    int ret = 0, nid;
+
+    for (i = 0; i < OSSL_NELEM(keys); i++) {
+        nid = keygen_batch_nids[id < 3 ? id : i % 3];
+        if (!TEST_ptr(keys[i] = EC_KEY_new_by_curve_name(nid)))
+            goto err;
+    }
+    if (!TEST_true(EC_KEY_generate_key_batch(keys, OSSL_NELEM(keys))))
+        goto err;
+    for (i = 0; i < OSSL_NELEM(keys); i++) {
+        if (!TEST_true(EC_KEY_check_key(keys[i]))
+            || (i > 0
+                && !TEST_int_ne(BN_cmp(EC_KEY_get0_private_key(keys[i]),
+                                       EC_KEY_get0_private_key(keys[0])), 0)))
+            goto err;
+    }
+    /* Keys that already hold a key pair are regenerated in place */
+    if (!TEST_true(EC_KEY_generate_key_batch(keys, OSSL_NELEM(keys))))
+        goto err;
+    for (i = 0; i < OSSL_NELEM(keys); i++)
+        if (!TEST_true(EC_KEY_check_key(keys[i])))
+            goto err;
+    ret = 1;
+
+ err:
+    for (i = 0; i < OSSL_NELEM(keys); i++)
+        EC_KEY_free(keys[i]);
+    return ret;
+}
+
+/*
+ * secp256k1 multiplies with its endomorphism: check the single point and
+ * multi-point paths against the same curve built from its parameters.
+ */
+static int secp256k1_glv_mul(EC_GROUP *group, EC_GROUP *ref, EC_POINT *r,
+                             EC_POINT *rref, const BIGNUM *g_scalar,
+                             const EC_POINT *Q, const EC_POINT *Qref,
+                             const BIGNUM *scalar, BN_CTX *ctx)
+{
+    unsigned char buf1[65], buf2[65];
+    size_t len1, len2;
+
+    return TEST_true(EC_POINT_mul(group, r, g_scalar, Q, scalar, ctx))
+           && TEST_true(EC_POINT_mul(ref, rref, g_scalar, Qref, scalar, ctx))
+           && TEST_true(EC_POINT_is_on_curve(group, r, ctx))
+           && TEST_size_t_gt(len1 = EC_POINT_point2oct(group, r,
+                                         POINT_CONVERSION_UNCOMPRESSED,
+                                         buf1, sizeof(buf1), ctx), 0)
+           && TEST_size_t_gt(len2 = EC_POINT_point2oct(ref, rref,
+                                         POINT_CONVERSION_UNCOMPRESSED,
+                                         buf2, sizeof(buf2), ctx), 0)
+           && TEST_mem_eq(buf1, len1, buf2, len2);
+}
+
+static int secp256k1_glv_test(void)
+{
+    int ret = 0, i;
+    EC_GROUP *group = NULL, *ref = NULL;
+    EC_POINT *P = NULL, *Pref = NULL, *Q = NULL, *Qref = NULL, *G = NULL;
+    BN_CTX *ctx = NULL;
+    BIGNUM *p, *a, *b, *x, *y, *k, *u;
+    const BIGNUM *order;
+    unsigned char buf[65];
+
+    if (!TEST_ptr(ctx = BN_CTX_new()))
+        goto err;
+    BN_CTX_start(ctx);
+    p = BN_CTX_get(ctx);
+    a = BN_CTX_get(ctx);
+    b = BN_CTX_get(ctx);
+    x = BN_CTX_get(ctx);
+    y = BN_CTX_get(ctx);
+    k = BN_CTX_get(ctx);
+    u = BN_CTX_get(ctx);
+    if (!TEST_ptr(u)
+        || !TEST_ptr(group = EC_GROUP_new_by_curve_name(NID_secp256k1))
+        || !TEST_true(EC_GROUP_get_curve(group, p, a, b, ctx))
+        || !TEST_true(EC_POINT_get_affine_coordinates(group,
+                          EC_GROUP_get0_generator(group), x, y, ctx))
+        || !TEST_ptr(ref = EC_GROUP_new_curve_GFp(p, a, b, ctx))
+        || !TEST_ptr(G = EC_POINT_new(ref))
+        || !TEST_true(EC_POINT_set_affine_coordinates(ref, G, x, y, ctx))
+        || !TEST_true(EC_GROUP_set_generator(ref, G,
+                                             EC_GROUP_get0_order(group),
+                                             BN_value_one()))
+        || !TEST_ptr(P = EC_POINT_new(group))
+        || !TEST_ptr(Q = EC_POINT_new(group))
+        || !TEST_ptr(Pref = EC_POINT_new(ref))
+        || !TEST_ptr(Qref = EC_POINT_new(ref)))
+        goto err;
+    order = EC_GROUP_get0_order(group);
+
+    for (i = 0; i < 32; i++) {
+        switch (i) {
+        case 0:
+        case 1:
+        case 2:
+            /* 0, 1 and 2 */
+            if (!TEST_true(BN_set_word(k, i)))
+                goto err;
+            break;
+        case 3:
+        case 4:
+        case 5:
+            /* order - 1, order and order + 1 */
+            if (!TEST_ptr(BN_copy(k, order))
+                || !TEST_true(BN_add_word(k, 1))
+                || !TEST_true(BN_sub_word(k, 5 - i)))
+                goto err;
+            break;
+        case 6:
+            if (!TEST_true(BN_lshift(k, order, 8)))
+                goto err;
+            break;
+        default:
+            if (!TEST_true(BN_rand_range(k, order)))
+                goto err;
+            if (i == 7)
+                BN_set_negative(k, 1);
+            break;
+        }
+        /* Q = u * G is the same point in both groups */
+        if (!TEST_true(BN_rand_range(u, order))
+            || !TEST_true(EC_POINT_mul(ref, Qref, u, NULL, NULL, ctx))
+            || !TEST_size_t_eq(EC_POINT_point2oct(ref, Qref,
+                                   POINT_CONVERSION_UNCOMPRESSED,
+                                   buf, sizeof(buf), ctx), sizeof(buf))
+            || !TEST_true(EC_POINT_oct2point(group, Q, buf, sizeof(buf), ctx))
+            || !secp256k1_glv_mul(group, ref, P, Pref, k, NULL, NULL, NULL,
+                                  ctx)
+            || !secp256k1_glv_mul(group, ref, P, Pref, NULL, Q, Qref, k, ctx)
+            || !secp256k1_glv_mul(group, ref, P, Pref, u, Q, Qref, k, ctx))
+            goto err;
+        /* k * G + (order - k) * G is the point at infinity */
+        if (!TEST_true(BN_nnmod(k, k, order, ctx))
+            || !TEST_true(BN_sub(u, order, k))
+            || !TEST_true(EC_POINT_mul(group, P, k,
+                                       EC_GROUP_get0_generator(group), u,
+                                       ctx))
+            || !TEST_true(EC_POINT_is_at_infinity(group, P)))
+            goto err;
+    }
+    ret = 1;
+
+ err:
+    EC_POINT_free(P);
+    EC_POINT_free(Q);
+    EC_POINT_free(Pref);
+    EC_POINT_free(Qref);
+    EC_POINT_free(G);
+    EC_GROUP_free(group);
+    EC_GROUP_free(ref);
+    BN_CTX_end(ctx);
+    BN_CTX_free(ctx);
+    return ret;
+}
+
 #endif /* OPENSSL_NO_EC */
 
 int setup_tests(void)
@@ -2258,6 +2501,9 @@ int setup_tests(void)
     ADD_ALL_TESTS(check_named_curve_from_ecparameters, crv_len);
     ADD_ALL_TESTS(ec_point_hex2point_test, crv_len);
     ADD_ALL_TESTS(custom_generator_test, crv_len);
+    ADD_ALL_TESTS(fixed_base_test, OSSL_NELEM(fixed_base_nids));
+    ADD_TEST(secp256k1_glv_test);
+    ADD_ALL_TESTS(keygen_batch_test, OSSL_NELEM(keygen_batch_nids) + 1);
 #endif /* OPENSSL_NO_EC */
     return 1;
 }
@@ -348,6 +348,68 @@ static int test_redirect(void)
     OPENSSL_free(tmp);
     return to_return;
 }
+
+static EVP_PKEY_METHOD *test_select_meth = NULL;
+
+static int test_select_pkey_meths(ENGINE *e, EVP_PKEY_METHOD **pmeth,
+                                  const int **pnids, int nid)
+{
+    static const int rnid = EVP_PKEY_RSA;
+
+    if (pmeth == NULL) {
+        *pnids = &rnid;
+        return 1;
+    }
+    *pmeth = nid == EVP_PKEY_RSA ? test_select_meth : NULL;
+    return *pmeth != NULL;
+}
+
+/* Check that the ENGINE chosen for a nid follows (un)registrations */
+static int test_pkey_meth_engine_select(void)
+{
+    ENGINE *e = NULL, *found = NULL;
+    int i, to_return = 0;
+
+    if (!TEST_ptr(test_select_meth = EVP_PKEY_meth_new(EVP_PKEY_RSA, 0))
+            || !TEST_ptr(e = ENGINE_new())
+            || !TEST_true(ENGINE_set_id(e, "Test select engine"))
+            || !TEST_true(ENGINE_set_name(e, "Test select engine"))
+            || !TEST_true(ENGINE_set_pkey_meths(e, test_select_pkey_meths))
+            || !TEST_true(ENGINE_register_pkey_meths(e)))
+        goto err;
+
+    /* Repeated misses may be answered without looking at the table */
+    for (i = 0; i < 2; i++)
+        if (!TEST_ptr_null(ENGINE_get_pkey_meth_engine(EVP_PKEY_EC)))
+            goto err;
+    if (!TEST_ptr_eq(found = ENGINE_get_pkey_meth_engine(EVP_PKEY_RSA), e))
+        goto err;
+    ENGINE_finish(found);
+
+    ENGINE_unregister_pkey_meths(e);
+    for (i = 0; i < 2; i++)
+        if (!TEST_ptr_null(ENGINE_get_pkey_meth_engine(EVP_PKEY_RSA)))
+            goto err;
+
+    if (!TEST_true(ENGINE_register_pkey_meths(e))
+            || !TEST_ptr_eq(found = ENGINE_get_pkey_meth_engine(EVP_PKEY_RSA),
+                            e))
+        goto err;
+    ENGINE_finish(found);
+    if (!TEST_ptr_null(ENGINE_get_pkey_meth_engine(EVP_PKEY_EC)))
+        goto err;
+
+    to_return = 1;
+ err:
+    if (e != NULL) {
+        ENGINE_unregister_pkey_meths(e);
+        ENGINE_free(e);         /* frees |test_select_meth| too */
+    } else {
+        EVP_PKEY_meth_free(test_select_meth);
+    }
+    test_select_meth = NULL;
+    return to_return;
+}
 #endif
 
 int global_init(void)
@@ -366,6 +428,7 @@ int setup_tests(void)
 #else
     ADD_TEST(test_engines);
     ADD_TEST(test_redirect);
+    ADD_TEST(test_pkey_meth_engine_select);
 #endif
     return 1;
 }
@@ -7,8 +7,10 @@
  * https://www.openssl.org/source/license.html
  */
 
+#include <string.h>
 #include <openssl/opensslconf.h>
 #include <openssl/err.h>
+#include <openssl/evp.h>
 
 #include "testutil.h"
 
@@ -32,8 +34,101 @@ static int preserves_system_error(void)
 #endif
 }
 
+/* Test that raising an error, once the thread has its state, does too. */
+static int put_preserves_system_error(void)
+{
+    ERR_clear_error();
+#if defined(OPENSSL_SYS_WINDOWS)
+    SetLastError(ERROR_INVALID_FUNCTION);
+    EVPerr(EVP_F_EVP_DIGESTINIT_EX, EVP_R_INITIALIZATION_ERROR);
+    if (!TEST_int_eq(GetLastError(), ERROR_INVALID_FUNCTION))
+        return 0;
+#else
+    errno = EINVAL;
+    EVPerr(EVP_F_EVP_DIGESTINIT_EX, EVP_R_INITIALIZATION_ERROR);
+    if (!TEST_int_eq(errno, EINVAL))
+        return 0;
+#endif
+    return TEST_ulong_ne(ERR_get_error(), 0)
+           && TEST_ulong_eq(ERR_get_error(), 0);
+}
+
+/* Test that errors raised inside a mark are dropped with it. */
+static int pop_to_mark_drops_errors(void)
+{
+    unsigned long e;
+
+    ERR_clear_error();
+    EVPerr(EVP_F_EVP_DIGESTINIT_EX, EVP_R_INITIALIZATION_ERROR);
+    e = ERR_peek_last_error();
+    if (!TEST_true(ERR_set_mark()))
+        return 0;
+    EVPerr(EVP_F_EVP_DIGESTINIT_EX, EVP_R_UNSUPPORTED_ALGORITHM);
+    EVPerr(EVP_F_EVP_DIGESTINIT_EX, EVP_R_DECODE_ERROR);
+    return TEST_true(ERR_pop_to_mark())
+           && TEST_ulong_eq(ERR_get_error(), e)
+           && TEST_ulong_eq(ERR_get_error(), 0);
+}
+
+#ifndef OPENSSL_NO_ERR
+static ERR_STRING_DATA deferred_str[] = {
+    {0, "deferred test library"},
+    {0, NULL}
+};
+static int deferred_loads = 0;
+
+static int load_deferred_str(void)
+{
+    deferred_loads++;
+    return ERR_load_strings_const(deferred_str);
+}
+
+/* Test that deferred strings are loaded by the first lookup, and only then */
+static int deferred_strings_loaded_on_lookup(void)
+{
+    int lib = ERR_get_next_error_library();
+
+    deferred_str[0].error = ERR_PACK(lib, 0, 0);
+    if (!TEST_true(ERR_load_strings_deferred(load_deferred_str))
+            || !TEST_int_eq(deferred_loads, 0)
+            || !TEST_str_eq(ERR_lib_error_string(ERR_PACK(lib, 0, 0)),
+                            "deferred test library")
+            || !TEST_int_eq(deferred_loads, 1))
+        return 0;
+
+    /* Once strings have been looked up, a loader runs straight away */
+    return TEST_true(ERR_load_strings_deferred(load_deferred_str))
+           && TEST_int_eq(deferred_loads, 2);
+}
+
+/* Test that the library's strings are there when first looked up. */
+static int strings_loaded_on_lookup(void)
+{
+    char buf[256];
+    unsigned long e;
+
+    ERR_clear_error();
+    EVPerr(EVP_F_EVP_DIGESTINIT_EX, EVP_R_INITIALIZATION_ERROR);
+    e = ERR_get_error();
+    if (!TEST_str_eq(ERR_func_error_string(e), "EVP_DigestInit_ex")
+            || !TEST_str_eq(ERR_lib_error_string(e),
+                            "digital envelope routines")
+            || !TEST_str_eq(ERR_reason_error_string(e),
+                            "initialization error"))
+        return 0;
+    ERR_error_string_n(e, buf, sizeof(buf));
+    return TEST_ptr(strstr(buf, "initialization error"));
+}
+#endif
+
 int setup_tests(void)
 {
     ADD_TEST(preserves_system_error);
+    ADD_TEST(put_preserves_system_error);
+    ADD_TEST(pop_to_mark_drops_errors);
+#ifndef OPENSSL_NO_ERR
+    ADD_TEST(deferred_strings_loaded_on_lookup);
+    ADD_TEST(strings_loaded_on_lookup);
+#endif
     return 1;
 }
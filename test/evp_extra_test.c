@@ -11,6 +11,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <openssl/aes.h>
+#include <openssl/async.h>
 #include <openssl/bio.h>
 #include <openssl/crypto.h>
 #include <openssl/err.h>
@@ -18,9 +19,12 @@
 #include <openssl/rsa.h>
 #include <openssl/x509.h>
 #include <openssl/pem.h>
+#include <openssl/pkcs12.h>
 #include <openssl/kdf.h>
 #include <openssl/dh.h>
+#include <openssl/ec.h>
 #include <openssl/engine.h>
+#include <oqs/oqs.h>
 #include "testutil.h"
 #include "internal/nelem.h"
 #include "crypto/evp.h"
@@ -1723,8 +1727,303 @@ static int test_decrypt_null_chunks(void)
     EVP_CIPHER_CTX_free(ctx);
     return ret;
 }
+/*
+ * Texts longer than a few KB are encrypted and authenticated in chunks, make
+ * sure that gives the same result as feeding them in through small updates.
+ */
+static int test_chacha20_poly1305_long(void)
+{
+    EVP_CIPHER_CTX *ctx = NULL;
+    const unsigned char key[32] = { 0x42 };
+    const unsigned char iv[12] = { 0x24 };
+    const int len = 5155, step = 7;
+    unsigned char *msg = NULL, *ct1 = NULL, *ct2 = NULL;
+    unsigned char tag1[16], tag2[16];
+    int i, outl, n, ret = 0;
+
+    if (!TEST_ptr(msg = OPENSSL_malloc(len))
+            || !TEST_ptr(ct1 = OPENSSL_malloc(len))
+            || !TEST_ptr(ct2 = OPENSSL_malloc(len))
+            || !TEST_ptr(ctx = EVP_CIPHER_CTX_new()))
+        goto err;
+    for (i = 0; i < len; i++)
+        msg[i] = (unsigned char)(i * 7 + 3);
+
+    if (!TEST_true(EVP_EncryptInit_ex(ctx, EVP_chacha20_poly1305(), NULL,
+                                      key, iv))
+            || !TEST_true(EVP_EncryptUpdate(ctx, ct1, &outl, msg, len))
+            || !TEST_int_eq(outl, len)
+            || !TEST_true(EVP_EncryptFinal_ex(ctx, ct1 + outl, &outl))
+            || !TEST_true(EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG,
+                                              sizeof(tag1), tag1)))
+        goto err;
+
+    if (!TEST_true(EVP_EncryptInit_ex(ctx, NULL, NULL, NULL, iv)))
+        goto err;
+    for (i = 0; i < len; i += n) {
+        n = len - i < step ? len - i : step;
+        if (!TEST_true(EVP_EncryptUpdate(ctx, ct2 + i, &outl, msg + i, n))
+                || !TEST_int_eq(outl, n))
+            goto err;
+    }
+    if (!TEST_true(EVP_EncryptFinal_ex(ctx, ct2 + len, &outl))
+            || !TEST_true(EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG,
+                                              sizeof(tag2), tag2))
+            || !TEST_mem_eq(ct1, len, ct2, len)
+            || !TEST_mem_eq(tag1, sizeof(tag1), tag2, sizeof(tag2)))
+        goto err;
+
+    /* decrypt in place, the MAC has to see the text before it is replaced */
+    if (!TEST_true(EVP_DecryptInit_ex(ctx, NULL, NULL, NULL, iv))
+            || !TEST_true(EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG,
+                                              sizeof(tag1), tag1))
+            || !TEST_true(EVP_DecryptUpdate(ctx, ct1, &outl, ct1, len))
+            || !TEST_int_eq(outl, len)
+            || !TEST_true(EVP_DecryptFinal_ex(ctx, ct1 + outl, &outl))
+            || !TEST_mem_eq(msg, len, ct1, len))
+        goto err;
+
+    ret = 1;
+ err:
+    EVP_CIPHER_CTX_free(ctx);
+    OPENSSL_free(msg);
+    OPENSSL_free(ct1);
+    OPENSSL_free(ct2);
+    return ret;
+}
 #endif /* !defined(OPENSSL_NO_CHACHA) && !defined(OPENSSL_NO_POLY1305) */
 
+/*
+ * Large CTR and XTS updates may be split across threads, the output has to
+ * be the same as the serial one.  The CTR counter is set to wrap its low 32
+ * bits part way through, and the first update leaves a partial block.
+ */
+static int cipher_threads_run(const EVP_CIPHER *cipher, int enc, int threads,
+                              const unsigned char *in, unsigned char *out,
+                              int len, int first)
+{
+    EVP_CIPHER_CTX *ctx = NULL;
+    const unsigned char key[64] = { 0x11, 0x22, 0x33 };
+    const unsigned char iv[16] = {
+        0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+        0xa8, 0xa9, 0xaa, 0xab, 0xff, 0xff, 0xf0, 0x00
+    };
+    int outl, total, ret = 0;
+
+    if (!TEST_ptr(ctx = EVP_CIPHER_CTX_new())
+            || !TEST_true(EVP_CIPHER_CTX_set_num_threads(ctx, threads))
+            || !TEST_true(EVP_CipherInit_ex(ctx, cipher, NULL, key, iv, enc))
+            || !TEST_int_eq(EVP_CIPHER_CTX_num_threads(ctx), threads)
+            || !TEST_true(EVP_CipherUpdate(ctx, out, &outl, in, first)))
+        goto err;
+    total = outl;
+    if (!TEST_true(EVP_CipherUpdate(ctx, out + total, &outl, in + first,
+                                    len - first)))
+        goto err;
+    total += outl;
+    if (!TEST_true(EVP_CipherFinal_ex(ctx, out + total, &outl))
+            || !TEST_int_eq(total + outl, len))
+        goto err;
+    ret = 1;
+ err:
+    EVP_CIPHER_CTX_free(ctx);
+    return ret;
+}
+
+static int test_cipher_threads(int idx)
+{
+    const EVP_CIPHER *cipher;
+    const int len = 4 * 1024 * 1024 + 13;
+    unsigned char *msg = NULL, *ct1 = NULL, *ct2 = NULL;
+    EVP_CIPHER_CTX *ctx = NULL;
+    int i, first, ret = 0;
+
+    switch (idx) {
+    case 0:
+        cipher = EVP_aes_128_ctr();
+        first = 5;
+        break;
+    case 1:
+        cipher = EVP_aes_128_xts();
+        first = 0;
+        break;
+    default:
+        cipher = EVP_aes_256_xts();
+        first = 0;
+        break;
+    }
+
+    if (!TEST_ptr(ctx = EVP_CIPHER_CTX_new())
+            || !TEST_int_eq(EVP_CIPHER_CTX_num_threads(ctx), 1)
+            || !TEST_false(EVP_CIPHER_CTX_set_num_threads(ctx, 0))
+            || !TEST_false(EVP_CIPHER_CTX_set_num_threads(
+                               ctx, EVP_CIPHER_MAX_THREADS + 1)))
+        goto err;
+    if (!EVP_CIPHER_CTX_set_num_threads(ctx, 4)) {
+        TEST_info("threads not available, skipping");
+        ret = 1;
+        goto err;
+    }
+
+    if (!TEST_ptr(msg = OPENSSL_malloc(len))
+            || !TEST_ptr(ct1 = OPENSSL_malloc(len))
+            || !TEST_ptr(ct2 = OPENSSL_malloc(len)))
+        goto err;
+    for (i = 0; i < len; i++)
+        msg[i] = (unsigned char)(i * 13 + (i >> 16));
+
+    if (!TEST_true(cipher_threads_run(cipher, 1, 1, msg, ct1, len, first))
+            || !TEST_true(cipher_threads_run(cipher, 1, 4, msg, ct2, len,
+                                             first))
+            || !TEST_mem_eq(ct1, len, ct2, len)
+            || !TEST_true(cipher_threads_run(cipher, 0, 3, ct1, ct2, len,
+                                             first))
+            || !TEST_mem_eq(msg, len, ct2, len))
+        goto err;
+
+    ret = 1;
+ err:
+    EVP_CIPHER_CTX_free(ctx);
+    OPENSSL_free(msg);
+    OPENSSL_free(ct1);
+    OPENSSL_free(ct2);
+    return ret;
+}
+
+/*
+ * A keyed template copied into a working context, which then only gets an
+ * IV, has to behave exactly like a context keyed from scratch.  The copy
+ * reuses the working context's cipher data, so do it several times.
+ */
+static int cipher_template_init(EVP_CIPHER_CTX *ctx, const EVP_CIPHER *cipher,
+                                const unsigned char *iv, int ivlen)
+{
+    static const unsigned char key[32] = { 0x5a, 0xa5, 0x01 };
+
+    if (!EVP_EncryptInit_ex(ctx, cipher, NULL, NULL, NULL))
+        return 0;
+    if (ivlen != EVP_CIPHER_iv_length(cipher)
+            && !EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_IVLEN, ivlen, NULL))
+        return 0;
+    return EVP_EncryptInit_ex(ctx, NULL, NULL, key, iv);
+}
+
+static int cipher_template_encrypt(EVP_CIPHER_CTX *ctx,
+                                   const unsigned char *msg, int len,
+                                   unsigned char *out)
+{
+    int outl, total;
+
+    if (!EVP_EncryptUpdate(ctx, out, &outl, msg, len))
+        return 0;
+    total = outl;
+    if (!EVP_EncryptFinal_ex(ctx, out + total, &outl))
+        return 0;
+    total += outl;
+    if ((EVP_CIPHER_CTX_flags(ctx) & EVP_CIPH_FLAG_AEAD_CIPHER) != 0
+            && !EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, 16,
+                                    out + total))
+        return 0;
+    return 1;
+}
+
+static int test_cipher_ctx_template(int idx)
+{
+    const EVP_CIPHER *cipher;
+    EVP_CIPHER_CTX *tmpl = NULL, *work = NULL, *ref = NULL;
+    unsigned char msg[100], iv[20], out1[sizeof(msg) + 32];
+    unsigned char out2[sizeof(out1)];
+    int i, ivlen, ret = 0;
+
+    switch (idx) {
+    case 0:
+        cipher = EVP_aes_128_gcm();
+        ivlen = sizeof(iv);     /* kept in an allocated buffer */
+        break;
+    case 1:
+        cipher = EVP_aes_256_ctr();
+        ivlen = 16;
+        break;
+    default:
+#ifndef OPENSSL_NO_OCB
+        cipher = EVP_aes_128_ocb();
+        ivlen = 12;
+#else
+        TEST_info("OCB is disabled, skipping");
+        return 1;
+#endif
+        break;
+    }
+
+    memset(msg, 0xc3, sizeof(msg));
+    if (!TEST_ptr(tmpl = EVP_CIPHER_CTX_new())
+            || !TEST_ptr(work = EVP_CIPHER_CTX_new())
+            || !TEST_ptr(ref = EVP_CIPHER_CTX_new())
+            || !TEST_true(cipher_template_init(tmpl, cipher, NULL, ivlen)))
+        goto err;
+
+    for (i = 0; i < 3; i++) {
+        memset(out1, 0, sizeof(out1));
+        memset(out2, 0, sizeof(out2));
+        memset(iv, 0x10 + i, sizeof(iv));
+        if (!TEST_true(EVP_CIPHER_CTX_copy(work, tmpl))
+                || !TEST_true(EVP_EncryptInit_ex(work, NULL, NULL, NULL, iv))
+                || !TEST_true(cipher_template_encrypt(work, msg, sizeof(msg),
+                                                      out1))
+                || !TEST_true(cipher_template_init(ref, cipher, iv, ivlen))
+                || !TEST_true(cipher_template_encrypt(ref, msg, sizeof(msg),
+                                                      out2))
+                || !TEST_mem_eq(out1, sizeof(out1), out2, sizeof(out2)))
+            goto err;
+    }
+    ret = 1;
+ err:
+    EVP_CIPHER_CTX_free(tmpl);
+    EVP_CIPHER_CTX_free(work);
+    EVP_CIPHER_CTX_free(ref);
+    return ret;
+}
+
+/*
+ * Cipher and digest names are looked up in a table that is rebuilt after
+ * every change, make sure additions, replacements and removals show.
+ */
+static int test_EVP_get_byname_changes(void)
+{
+    const char *alias = "evp-extra-test-alias";
+    const char *name;
+
+    if (!TEST_ptr_eq(EVP_get_cipherbyname("aes-128-cbc"), EVP_aes_128_cbc())
+            || !TEST_ptr_eq(EVP_get_cipherbyname("AES-128-cbc"),
+                            EVP_aes_128_cbc())
+            || !TEST_ptr_eq(EVP_get_cipherbyname("aes128"), EVP_aes_128_cbc())
+            || !TEST_ptr(name = OBJ_NAME_get("aes128",
+                                             OBJ_NAME_TYPE_CIPHER_METH
+                                             | OBJ_NAME_ALIAS))
+            || !TEST_str_eq(name, SN_aes_128_cbc)
+            || !TEST_ptr_eq(EVP_get_digestbyname("sha256"), EVP_sha256())
+            || !TEST_ptr_null(EVP_get_cipherbyname(alias))
+            || !TEST_ptr_null(EVP_get_cipherbyname("no-such-cipher")))
+        return 0;
+
+    if (!TEST_true(EVP_add_cipher_alias(SN_aes_256_cbc, alias))
+            || !TEST_ptr_eq(EVP_get_cipherbyname(alias), EVP_aes_256_cbc())
+            || !TEST_ptr_null(EVP_get_digestbyname(alias))
+            || !TEST_true(EVP_add_cipher_alias(SN_aes_128_ctr, alias))
+            || !TEST_ptr_eq(EVP_get_cipherbyname(alias), EVP_aes_128_ctr())
+            || !TEST_true(OBJ_NAME_remove(alias, OBJ_NAME_TYPE_CIPHER_METH))
+            || !TEST_ptr_null(EVP_get_cipherbyname(alias)))
+        return 0;
+
+    if (!TEST_true(EVP_add_digest_alias(SN_sha512, alias))
+            || !TEST_ptr_eq(EVP_get_digestbyname(alias), EVP_sha512())
+            || !TEST_true(OBJ_NAME_remove(alias, OBJ_NAME_TYPE_MD_METH))
+            || !TEST_ptr_null(EVP_get_digestbyname(alias))
+            || !TEST_ptr_eq(EVP_get_digestbyname("sha256"), EVP_sha256()))
+        return 0;
+    return 1;
+}
+
 #ifndef OPENSSL_NO_DH
 static int test_EVP_PKEY_set1_DH(void)
 {
@@ -1792,6 +2091,326 @@ static int custom_md_cleanup(EVP_MD_CTX *ctx)
     return 1;
 }
 
+/* Batched digests must match one EVP_Digest() call per message */
+static const char *digest_batch_names[] = {
+    "SHA1", "SHA224", "SHA256", "SHA3-256", "SHAKE128", "SHAKE256"
+};
+
+static int test_EVP_DigestBatch(int idx)
+{
+    const EVP_MD *md = EVP_get_digestbyname(digest_batch_names[idx]);
+    int xof = md != NULL && (EVP_MD_flags(md) & EVP_MD_FLAG_XOF) != 0;
+    unsigned char msgs[21][300], outs[21][100], expected[100];
+    const void *data[21];
+    unsigned char *out[21];
+    size_t count[21], mdlen, i;
+    unsigned int len;
+    EVP_MD_CTX *ctx = NULL;
+    int testresult = 0;
+
+    if (!TEST_ptr(md))
+        goto err;
+    mdlen = xof ? sizeof(expected) : (size_t)EVP_MD_size(md);
+    for (i = 0; i < OSSL_NELEM(msgs); i++) {
+        memset(msgs[i], (int)i + 1, sizeof(msgs[i]));
+        data[i] = msgs[i];
+        /* covers empty input and both one and two padding blocks */
+        count[i] = (i * 157) % sizeof(msgs[i]);
+        out[i] = outs[i];
+    }
+    if (!TEST_true(EVP_DigestBatch(data, count, out, xof ? mdlen : 0,
+                                   OSSL_NELEM(msgs), md, NULL)))
+        goto err;
+
+    if (!TEST_ptr(ctx = EVP_MD_CTX_new()))
+        goto err;
+    for (i = 0; i < OSSL_NELEM(msgs); i++) {
+        if (!TEST_true(EVP_DigestInit_ex(ctx, md, NULL))
+                || !TEST_true(EVP_DigestUpdate(ctx, data[i], count[i])))
+            goto err;
+        if (xof) {
+            if (!TEST_true(EVP_DigestFinalXOF(ctx, expected, mdlen)))
+                goto err;
+        } else if (!TEST_true(EVP_DigestFinal_ex(ctx, expected, &len))) {
+            goto err;
+        }
+        if (!TEST_mem_eq(outs[i], mdlen, expected, mdlen))
+            goto err;
+    }
+
+    /* an XOF needs an output length, a fixed digest its own size */
+    if (!TEST_false(EVP_DigestBatch(data, count, out, xof ? 0 : mdlen + 1,
+                                    OSSL_NELEM(msgs), md, NULL)))
+        goto err;
+    testresult = 1;
+
+ err:
+    EVP_MD_CTX_free(ctx);
+    return testresult;
+}
+
+/*
+ * The KDF shortcuts of the built-in digests must match the generic code,
+ * which is what a copy of the digest method runs.
+ */
+static const char *kdf_digest_names[] = {
+    "SHA1", "SHA224", "SHA256", "SHA384", "SHA512"
+};
+
+static int test_kdf_digest_shortcuts(int idx)
+{
+    const EVP_MD *md = EVP_get_digestbyname(kdf_digest_names[idx]);
+    static const int iters[] = { 1, 2, 37 };
+    static const int passlens[] = { 0, 11, 200 };
+    unsigned char pass[200], salt[20], out[600], expected[600];
+    EVP_MD *copy = NULL;
+    int mdlen, keylens[4], i, j, k;
+    int testresult = 0;
+
+    if (!TEST_ptr(md) || !TEST_ptr(copy = EVP_MD_meth_dup(md)))
+        goto err;
+    mdlen = EVP_MD_size(md);
+    keylens[0] = 1;
+    keylens[1] = mdlen;
+    keylens[2] = mdlen + 1;
+    /* more blocks than the multi-buffer kernels have lanes */
+    keylens[3] = 9 * mdlen + 3;
+    memset(pass, 'p', sizeof(pass));
+    memset(salt, 's', sizeof(salt));
+
+    for (i = 0; i < (int)OSSL_NELEM(iters); i++) {
+        for (j = 0; j < (int)OSSL_NELEM(passlens); j++) {
+            for (k = 0; k < (int)OSSL_NELEM(keylens); k++) {
+                if (!TEST_true(PKCS5_PBKDF2_HMAC((char *)pass, passlens[j],
+                                                 salt, sizeof(salt), iters[i],
+                                                 md, keylens[k], out))
+                        || !TEST_true(PKCS5_PBKDF2_HMAC((char *)pass,
+                                                        passlens[j], salt,
+                                                        sizeof(salt),
+                                                        iters[i], copy,
+                                                        keylens[k],
+                                                        expected))
+                        || !TEST_mem_eq(out, keylens[k], expected,
+                                        keylens[k]))
+                    goto err;
+            }
+            if (!TEST_true(PKCS12_key_gen_uni(pass, passlens[j], salt,
+                                              sizeof(salt), PKCS12_KEY_ID,
+                                              iters[i], 2 * mdlen + 5, out,
+                                              md))
+                    || !TEST_true(PKCS12_key_gen_uni(pass, passlens[j], salt,
+                                                     sizeof(salt),
+                                                     PKCS12_KEY_ID, iters[i],
+                                                     2 * mdlen + 5, expected,
+                                                     copy))
+                    || !TEST_mem_eq(out, 2 * mdlen + 5, expected,
+                                    2 * mdlen + 5))
+                goto err;
+        }
+    }
+    testresult = 1;
+
+ err:
+    EVP_MD_meth_free(copy);
+    return testresult;
+}
+
+/* RFC 6070, with an output of two blocks */
+static int test_PBKDF2_SHA1_vector(void)
+{
+    static const unsigned char expected[] = {
+        0x3d, 0x2e, 0xec, 0x4f, 0xe4, 0x1c, 0x84, 0x9b, 0x80, 0xc8, 0xd8,
+        0x36, 0x62, 0xc0, 0xe4, 0x4a, 0x8b, 0x29, 0x1a, 0x96, 0x4c, 0xf2,
+        0xf0, 0x70, 0x38
+    };
+    const char *salt = "saltSALTsaltSALTsaltSALTsaltSALTsalt";
+    unsigned char out[sizeof(expected)];
+
+    return TEST_true(PKCS5_PBKDF2_HMAC("passwordPASSWORDpassword", -1,
+                                       (const unsigned char *)salt,
+                                       strlen(salt), 4096, EVP_sha1(),
+                                       sizeof(out), out))
+        && TEST_mem_eq(out, sizeof(out), expected, sizeof(expected));
+}
+
+#define KEM_BATCH 3
+
+/* The OQS KEMs, alone and in ECDH hybrids, through the EVP KEM calls */
+static const struct {
+    int nid;
+    const char *kem;
+} kem_tests[] = {
+    { NID_kyber512, OQS_KEM_alg_kyber_512 },
+    { NID_p256_kyber512, OQS_KEM_alg_kyber_512 },
+    { NID_p384_kyber768, OQS_KEM_alg_kyber_768 }
+};
+
+static int test_EVP_PKEY_kem(int idx)
+{
+    EVP_PKEY_CTX *ctx = NULL, *ectx[KEM_BATCH] = { NULL };
+    EVP_PKEY *key = NULL, *peer = NULL, *other = NULL;
+    unsigned char *pub = NULL, *ct = NULL, *secret = NULL, *expected = NULL;
+    size_t publen, ctlen, secretlen, len, i;
+    int testresult = 0;
+
+    /* Other key types do not encapsulate */
+    if (!TEST_ptr(other = load_example_rsa_key())
+            || !TEST_ptr(ctx = EVP_PKEY_CTX_new(other, NULL))
+            || !TEST_int_eq(EVP_PKEY_encapsulate_init(ctx), -2)
+            || !TEST_int_eq(EVP_PKEY_decapsulate_init(ctx), -2))
+        goto err;
+    EVP_PKEY_CTX_free(ctx);
+    ctx = NULL;
+
+    if (!OQS_KEM_alg_is_enabled(kem_tests[idx].kem)) {
+        TEST_info("Skipping: %s is not enabled", kem_tests[idx].kem);
+        testresult = 1;
+        goto err;
+    }
+    if (!TEST_ptr(ctx = EVP_PKEY_CTX_new_id(kem_tests[idx].nid, NULL))
+            || !TEST_int_gt(EVP_PKEY_keygen_init(ctx), 0)
+            || !TEST_int_gt(EVP_PKEY_keygen(ctx, &key), 0)
+            || !TEST_true(EVP_PKEY_get_raw_public_key(key, NULL, &publen))
+            || !TEST_ptr(pub = OPENSSL_malloc(publen))
+            || !TEST_true(EVP_PKEY_get_raw_public_key(key, pub, &publen))
+            || !TEST_ptr(peer = EVP_PKEY_new_raw_public_key(kem_tests[idx].nid,
+                                                            NULL, pub, publen))
+            || !TEST_int_eq(EVP_PKEY_cmp(key, peer), 1)
+            || !TEST_ptr_null(EVP_PKEY_new_raw_public_key(kem_tests[idx].nid,
+                                                          NULL, pub,
+                                                          publen - 1)))
+        goto err;
+    EVP_PKEY_CTX_free(ctx);
+    ctx = NULL;
+
+    /* One encapsulation, to the public key only */
+    if (!TEST_ptr(ctx = EVP_PKEY_CTX_new(peer, NULL))
+            || !TEST_int_gt(EVP_PKEY_encapsulate_init(ctx), 0)
+            || !TEST_int_gt(EVP_PKEY_encapsulate(ctx, NULL, &ctlen, NULL,
+                                                 &secretlen), 0)
+            || !TEST_ptr(ct = OPENSSL_malloc(KEM_BATCH * ctlen))
+            || !TEST_ptr(secret = OPENSSL_malloc(KEM_BATCH * secretlen))
+            || !TEST_ptr(expected = OPENSSL_malloc(secretlen))
+            || !TEST_int_gt(EVP_PKEY_encapsulate(ctx, ct, &ctlen, secret,
+                                                 &secretlen), 0)
+            || !TEST_int_le(EVP_PKEY_decapsulate(ctx, expected, &len, ct,
+                                                 ctlen), 0))
+        goto err;
+    EVP_PKEY_CTX_free(ctx);
+    if (!TEST_ptr(ctx = EVP_PKEY_CTX_new(key, NULL))
+            || !TEST_int_gt(EVP_PKEY_decapsulate_init(ctx), 0)
+            || !TEST_int_le(EVP_PKEY_decapsulate(ctx, expected, &len, ct,
+                                                 ctlen - 1), 0))
+        goto err;
+    len = secretlen;
+    if (!TEST_int_gt(EVP_PKEY_decapsulate(ctx, expected, &len, ct, ctlen), 0)
+            || !TEST_mem_eq(secret, secretlen, expected, len))
+        goto err;
+
+    /* A batch, each entry of which the private key decapsulates */
+    for (i = 0; i < KEM_BATCH; i++)
+        if (!TEST_ptr(ectx[i] = EVP_PKEY_CTX_new(peer, NULL))
+                || !TEST_int_gt(EVP_PKEY_encapsulate_init(ectx[i]), 0))
+            goto err;
+    if (!TEST_int_gt(EVP_PKEY_encapsulate_batch(ectx, KEM_BATCH, ct, &ctlen,
+                                                secret, &secretlen), 0))
+        goto err;
+    for (i = 0; i < KEM_BATCH; i++) {
+        len = secretlen;
+        if (!TEST_int_gt(EVP_PKEY_decapsulate(ctx, expected, &len,
+                                              ct + i * ctlen, ctlen), 0)
+                || !TEST_mem_eq(secret + i * secretlen, secretlen,
+                                expected, len))
+            goto err;
+    }
+    if (!TEST_mem_ne(secret, secretlen, secret + secretlen, secretlen))
+        goto err;
+    testresult = 1;
+
+ err:
+    for (i = 0; i < KEM_BATCH; i++)
+        EVP_PKEY_CTX_free(ectx[i]);
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(key);
+    EVP_PKEY_free(peer);
+    EVP_PKEY_free(other);
+    OPENSSL_free(pub);
+    OPENSSL_free(ct);
+    OPENSSL_free(secret);
+    OPENSSL_free(expected);
+    return testresult;
+}
+
+/*
+ * A hybrid signature verifies with its halves checked one after the other
+ * (idx 0) or in parallel (idx 1), and a damaged half or a malformed length fails either way.
+ */
+static int test_EVP_PKEY_oqs_hybrid_verify(int idx)
+{
+    static const unsigned char msg[] = "the hybrid signed message";
+    EVP_PKEY_CTX *ctx = NULL, *pctx;
+    EVP_MD_CTX *mdctx = NULL;
+    EVP_PKEY *key = NULL;
+    unsigned char *sig = NULL;
+    size_t siglen;
+    int testresult = 0;
+
+    if (!OQS_SIG_alg_is_enabled(OQS_SIG_alg_dilithium_2)) {
+        TEST_info("Skipping: %s is not enabled", OQS_SIG_alg_dilithium_2);
+        return 1;
+    }
+    if (!TEST_ptr(ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_P256_DILITHIUM2, NULL))
+            || !TEST_int_gt(EVP_PKEY_keygen_init(ctx), 0)
+            || !TEST_int_gt(EVP_PKEY_keygen(ctx, &key), 0)
+            || !TEST_ptr(mdctx = EVP_MD_CTX_new())
+            || !TEST_true(EVP_DigestSignInit(mdctx, NULL, NULL, NULL, key))
+            || !TEST_true(EVP_DigestSign(mdctx, NULL, &siglen, msg,
+                                         sizeof(msg)))
+            || !TEST_ptr(sig = OPENSSL_malloc(siglen))
+            || !TEST_true(EVP_DigestSign(mdctx, sig, &siglen, msg,
+                                         sizeof(msg))))
+        goto err;
+
+    if (!TEST_true(EVP_DigestVerifyInit(mdctx, &pctx, NULL, NULL, key))
+            || !TEST_int_le(EVP_PKEY_CTX_set_oqs_verify_threads(pctx, 3), 0)
+            || !TEST_int_gt(EVP_PKEY_CTX_set_oqs_verify_threads(pctx,
+                                                                idx + 1), 0)
+            || !TEST_int_eq(EVP_DigestVerify(mdctx, sig, siglen, msg,
+                                             sizeof(msg)), 1)
+            /* the PQ half is missing its last byte */
+            || !TEST_int_le(EVP_DigestVerify(mdctx, sig, siglen - 1, msg,
+                                             sizeof(msg)), 0)
+            || !TEST_int_le(EVP_DigestVerify(mdctx, sig, 3, msg,
+                                             sizeof(msg)), 0))
+        goto err;
+
+    /* the classical half is damaged */
+    sig[10] ^= 1;
+    if (!TEST_int_le(EVP_DigestVerify(mdctx, sig, siglen, msg, sizeof(msg)),
+                     0))
+        goto err;
+    sig[10] ^= 1;
+    /* the PQ half is damaged */
+    sig[siglen - 1] ^= 1;
+    if (!TEST_int_le(EVP_DigestVerify(mdctx, sig, siglen, msg, sizeof(msg)),
+                     0))
+        goto err;
+    sig[siglen - 1] ^= 1;
+    /* the classical length runs past the end of the signature */
+    sig[0] = 0x7f;
+    if (!TEST_int_le(EVP_DigestVerify(mdctx, sig, siglen, msg, sizeof(msg)),
+                     0))
+        goto err;
+    testresult = 1;
+
+ err:
+    EVP_MD_CTX_free(mdctx);
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(key);
+    OPENSSL_free(sig);
+    return testresult;
+}
+
 static int test_custom_md_meth(void)
 {
     EVP_MD_CTX *mdctx = NULL;
@@ -1996,6 +2615,182 @@ static int test_cipher_with_engine(void)
 
     return testresult;
 }
+
+# ifndef OPENSSL_NO_EC
+#  define DBATCH_NUM_JOBS   8
+
+typedef struct {
+    ENGINE *e;
+    EC_KEY *key;
+    const EC_POINT *peer;
+    const unsigned char *msg;
+    int msglen;
+    unsigned char ct[32];
+    unsigned char tag[16];
+    unsigned char secret[32];
+    int secretlen;
+} DBATCH_JOB;
+
+static const unsigned char dbatch_key[] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b,
+    0x0c, 0x0d, 0x0e, 0x0f
+};
+
+static const unsigned char dbatch_iv[] = {
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b
+};
+
+static int dbatch_gcm_encrypt(ENGINE *e, const unsigned char *msg, int msglen,
+                              unsigned char *ct, unsigned char *tag)
+{
+    EVP_CIPHER_CTX *ctx;
+    int len = 0, ret = 0;
+
+    if ((ctx = EVP_CIPHER_CTX_new()) != NULL
+            && EVP_EncryptInit_ex(ctx, EVP_aes_128_gcm(), e, dbatch_key,
+                                  dbatch_iv)
+            && EVP_EncryptUpdate(ctx, NULL, &len, dbatch_iv, sizeof(dbatch_iv))
+            && EVP_EncryptUpdate(ctx, ct, &len, msg, msglen)
+            && len == msglen
+            && EVP_EncryptFinal_ex(ctx, ct + len, &len)
+            && EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, 16, tag))
+        ret = 1;
+    EVP_CIPHER_CTX_free(ctx);
+    return ret;
+}
+
+static int dbatch_job(void *arg)
+{
+    DBATCH_JOB *job = *(DBATCH_JOB **)arg;
+
+    if (!dbatch_gcm_encrypt(job->e, job->msg, job->msglen, job->ct, job->tag))
+        return 0;
+    job->secretlen = ECDH_compute_key(job->secret, sizeof(job->secret),
+                                      job->peer, job->key, NULL);
+    return job->secretlen > 0;
+}
+
+/*
+ * Run AES-GCM and ECDH on the dbatch engine from several ASYNC jobs at once,
+ * with the completions drained by the engine's polling thread or by us.
+ */
+static int test_batching_engine(int tst)
+{
+    ENGINE *e;
+    const char *engine_id = "dbatch";
+    const unsigned char msg[] = "batched request";
+    DBATCH_JOB jobs[DBATCH_NUM_JOBS], *jobp;
+    ASYNC_JOB *ajobs[DBATCH_NUM_JOBS];
+    ASYNC_WAIT_CTX *waitctx[DBATCH_NUM_JOBS];
+    int results[DBATCH_NUM_JOBS], finished[DBATCH_NUM_JOBS];
+    EC_KEY *key = NULL, *peer = NULL;
+    unsigned char ct[sizeof(msg)], tag[16], secret[32];
+    unsigned long stats[2] = { 0, 0 };
+    int i, pending, secretlen, testresult = 0;
+
+    memset(jobs, 0, sizeof(jobs));
+    memset(ajobs, 0, sizeof(ajobs));
+    memset(waitctx, 0, sizeof(waitctx));
+    memset(finished, 0, sizeof(finished));
+
+    if (!TEST_ptr(e = ENGINE_by_id(engine_id)))
+        return 0;
+    if (!TEST_true(ENGINE_ctrl_cmd_string(e, "POLL_THREAD",
+                                          tst == 0 ? "1" : "0", 0))
+            || !TEST_true(ENGINE_ctrl_cmd_string(e, "BATCH_SIZE", "4", 0))
+            || !TEST_true(ENGINE_init(e))) {
+        ENGINE_free(e);
+        return 0;
+    }
+    /* The polling mode cannot be changed once the device is running */
+    if (!TEST_false(ENGINE_ctrl_cmd_string(e, "POLL_THREAD", "1", 0)))
+        goto err;
+    ERR_clear_error();
+
+    if (!TEST_ptr(key = EC_KEY_new_method(e))
+            || !TEST_ptr(peer = EC_KEY_new_by_curve_name(NID_X9_62_prime256v1))
+            || !TEST_true(EC_KEY_set_group(key, EC_KEY_get0_group(peer)))
+            || !TEST_true(EC_KEY_generate_key(key))
+            || !TEST_true(EC_KEY_generate_key(peer)))
+        goto err;
+
+    for (i = 0; i < DBATCH_NUM_JOBS; i++) {
+        jobs[i].e = e;
+        jobs[i].key = key;
+        jobs[i].peer = EC_KEY_get0_public_key(peer);
+        jobs[i].msg = msg;
+        jobs[i].msglen = sizeof(msg);
+        if (!TEST_ptr(waitctx[i] = ASYNC_WAIT_CTX_new()))
+            goto err;
+    }
+
+    do {
+        pending = 0;
+        for (i = 0; i < DBATCH_NUM_JOBS; i++) {
+            if (finished[i])
+                continue;
+            jobp = &jobs[i];
+            switch (ASYNC_start_job(&ajobs[i], waitctx[i], &results[i],
+                                    dbatch_job, &jobp, sizeof(jobp))) {
+            case ASYNC_FINISH:
+                finished[i] = 1;
+                break;
+            case ASYNC_PAUSE:
+                pending = 1;
+                break;
+            default:
+                TEST_error("ASYNC_start_job failed");
+                goto err;
+            }
+        }
+        if (tst == 1 && !TEST_true(ENGINE_ctrl_cmd(e, "POLL", 0, NULL, NULL,
+                                                   0)))
+            goto err;
+    } while (pending);
+
+    /*
+     * Compare with AES-GCM in software, and with ECDH done outside a job,
+     * where the request blocks until it completes
+     */
+    secretlen = ECDH_compute_key(secret, sizeof(secret),
+                                 EC_KEY_get0_public_key(peer), key, NULL);
+    if (!TEST_true(dbatch_gcm_encrypt(NULL, msg, sizeof(msg), ct, tag))
+            || !TEST_int_gt(secretlen, 0))
+        goto err;
+    for (i = 0; i < DBATCH_NUM_JOBS; i++) {
+        if (!TEST_true(results[i])
+                || !TEST_mem_eq(jobs[i].ct, sizeof(msg), ct, sizeof(msg))
+                || !TEST_mem_eq(jobs[i].tag, sizeof(tag), tag, sizeof(tag))
+                || !TEST_mem_eq(jobs[i].secret, jobs[i].secretlen,
+                                secret, secretlen))
+            goto err;
+    }
+
+    /* Check against the secret derived in software from the other side */
+    if (!TEST_int_eq(ECDH_compute_key(secret, sizeof(secret),
+                                      EC_KEY_get0_public_key(key), peer,
+                                      NULL), secretlen)
+            || !TEST_mem_eq(jobs[0].secret, jobs[0].secretlen,
+                            secret, secretlen))
+        goto err;
+
+    if (!TEST_true(ENGINE_ctrl_cmd(e, "GET_NUM_BATCHES", 0, stats, NULL, 0))
+            || !TEST_ulong_ge(stats[1], 2 * DBATCH_NUM_JOBS + 1)
+            || !TEST_ulong_le(stats[0], stats[1]))
+        goto err;
+
+    testresult = 1;
+ err:
+    for (i = 0; i < DBATCH_NUM_JOBS; i++)
+        ASYNC_WAIT_CTX_free(waitctx[i]);
+    EC_KEY_free(key);
+    EC_KEY_free(peer);
+    ENGINE_finish(e);
+    ENGINE_free(e);
+
+    return testresult;
+}
+# endif
 #endif /* !defined(OPENSSL_NO_ENGINE) && !defined(OPENSSL_NO_DYNAMIC_ENGINE) */
 
 int setup_tests(void)
@@ -2032,7 +2827,11 @@ int setup_tests(void)
 #endif
 #if !defined(OPENSSL_NO_CHACHA) && !defined(OPENSSL_NO_POLY1305)
     ADD_TEST(test_decrypt_null_chunks);
+    ADD_TEST(test_chacha20_poly1305_long);
 #endif
+    ADD_ALL_TESTS(test_cipher_threads, 3);
+    ADD_ALL_TESTS(test_cipher_ctx_template, 3);
+    ADD_TEST(test_EVP_get_byname_changes);
 #ifndef OPENSSL_NO_DH
     ADD_TEST(test_EVP_PKEY_set1_DH);
 #endif
@@ -2043,6 +2842,13 @@ int setup_tests(void)
     ADD_ALL_TESTS(test_evp_updated_iv, OSSL_NELEM(evp_updated_iv_tests));
 
     ADD_TEST(test_custom_md_meth);
+    ADD_ALL_TESTS(test_EVP_DigestBatch, OSSL_NELEM(digest_batch_names));
+    ADD_ALL_TESTS(test_kdf_digest_shortcuts, OSSL_NELEM(kdf_digest_names));
+    ADD_TEST(test_PBKDF2_SHA1_vector);
+#ifndef OPENSSL_NO_EC
+    ADD_ALL_TESTS(test_EVP_PKEY_kem, OSSL_NELEM(kem_tests));
+    ADD_ALL_TESTS(test_EVP_PKEY_oqs_hybrid_verify, 2);
+#endif
 #if !defined(OPENSSL_NO_ENGINE) && !defined(OPENSSL_NO_DYNAMIC_ENGINE)
 # ifndef OPENSSL_NO_EC
     ADD_ALL_TESTS(test_signatures_with_engine, 3);
@@ -2050,6 +2856,9 @@ int setup_tests(void)
     ADD_ALL_TESTS(test_signatures_with_engine, 2);
 # endif
     ADD_TEST(test_cipher_with_engine);
+# ifndef OPENSSL_NO_EC
+    ADD_ALL_TESTS(test_batching_engine, 2);
+# endif
 #endif
 
     return 1;
@@ -831,10 +831,11 @@ static int cipher_test_run(EVP_TEST *t)
 
         if (out_misalign == 1 && frag == 0) {
             /*
-             * XTS, CCM and Wrap modes have special requirements about input
-             * lengths so we don't fragment for those
+             * XTS, CCM, GCM-SIV and Wrap modes have special requirements
+             * about input lengths so we don't fragment for those
              */
             if (cdat->aead == EVP_CIPH_CCM_MODE
+                    || EVP_CIPHER_mode(cdat->cipher) == EVP_CIPH_GCM_SIV_MODE
                     || EVP_CIPHER_mode(cdat->cipher) == EVP_CIPH_XTS_MODE
                     || EVP_CIPHER_mode(cdat->cipher) == EVP_CIPH_WRAP_MODE)
                 break;
@@ -907,6 +908,14 @@ static int mac_test_init(EVP_TEST *t, const char *alg)
 #else
         t->skip = 1;
         return 1;
+#endif
+    } else if (strcmp(alg, "BLAKE2BMAC") == 0
+               || strcmp(alg, "BLAKE2SMAC") == 0) {
+#ifndef OPENSSL_NO_BLAKE2
+        type = alg[6] == 'B' ? EVP_PKEY_BLAKE2BMAC : EVP_PKEY_BLAKE2SMAC;
+#else
+        t->skip = 1;
+        return 1;
 #endif
     } else
         return 0;
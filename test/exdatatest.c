@@ -258,8 +258,95 @@ static int test_exdata(void)
       return 0;
 }
 
+/*
+ * More indexes than fit the callers' on-stack copies, registered while
+ * objects of the class already exist.
+ */
+#define NUM_LATE_IDX    12
+
+static int late_new_calls, late_free_calls, late_dup_calls;
+
+static void late_new(void *parent, void *ptr, CRYPTO_EX_DATA *ad,
+                     int idx, long argl, void *argp)
+{
+    late_new_calls++;
+    if (!TEST_true(CRYPTO_set_ex_data(ad, idx, (void *)(size_t)(argl + 1))))
+        gbl_result = 0;
+}
+
+static int late_dup(CRYPTO_EX_DATA *to, const CRYPTO_EX_DATA *from,
+                    void *from_d, int idx, long argl, void *argp)
+{
+    late_dup_calls++;
+    return 1;
+}
+
+static void late_free(void *parent, void *ptr, CRYPTO_EX_DATA *ad,
+                      int idx, long argl, void *argp)
+{
+    if (ptr != NULL && !TEST_ptr_eq(ptr, (void *)(size_t)(argl + 1)))
+        gbl_result = 0;
+    late_free_calls++;
+}
+
+static int test_exdata_late_index(void)
+{
+    const int cls = CRYPTO_EX_INDEX_UI_METHOD;
+    CRYPTO_EX_DATA early, late, copy;
+    int idx[NUM_LATE_IDX + 1];
+    int i, ret = 0;
+
+    gbl_result = 1;
+    memset(&early, 0, sizeof(early));
+    memset(&late, 0, sizeof(late));
+    memset(&copy, 0, sizeof(copy));
+    for (i = 0; i <= NUM_LATE_IDX; i++)
+        idx[i] = -1;
+    if (!TEST_true(CRYPTO_new_ex_data(cls, NULL, &early)))
+        return 0;
+    for (i = 0; i < NUM_LATE_IDX; i++)
+        if (!TEST_int_gt(idx[i] = CRYPTO_get_ex_new_index(cls, i, NULL,
+                                                          late_new, late_dup,
+                                                          late_free), 0))
+            goto end;
+
+    late_new_calls = late_free_calls = late_dup_calls = 0;
+    if (!TEST_true(CRYPTO_new_ex_data(cls, NULL, &late))
+            || !TEST_int_eq(late_new_calls, NUM_LATE_IDX)
+            || !TEST_ptr_null(CRYPTO_get_ex_data(&early, idx[0]))
+            || !TEST_ptr_eq(CRYPTO_get_ex_data(&late, idx[NUM_LATE_IDX - 1]),
+                            (void *)(size_t)NUM_LATE_IDX)
+            || !TEST_true(CRYPTO_dup_ex_data(cls, &copy, &late))
+            || !TEST_int_eq(late_dup_calls, NUM_LATE_IDX)
+            || !TEST_ptr_eq(CRYPTO_get_ex_data(&copy, idx[3]),
+                            (void *)(size_t)4))
+        goto end;
+
+    /* an index added now is seen by the next object, not the last one */
+    idx[NUM_LATE_IDX] = CRYPTO_get_ex_new_index(cls, NUM_LATE_IDX, NULL,
+                                                late_new, late_dup, late_free);
+    late_new_calls = 0;
+    CRYPTO_free_ex_data(cls, NULL, &late);
+    if (!TEST_int_gt(idx[NUM_LATE_IDX], idx[NUM_LATE_IDX - 1])
+            || !TEST_int_eq(late_free_calls, NUM_LATE_IDX + 1)
+            || !TEST_true(CRYPTO_new_ex_data(cls, NULL, &late))
+            || !TEST_int_eq(late_new_calls, NUM_LATE_IDX + 1))
+        goto end;
+
+    ret = gbl_result;
+ end:
+    for (i = 0; i <= NUM_LATE_IDX; i++)
+        if (idx[i] > 0)
+            CRYPTO_free_ex_index(cls, idx[i]);
+    CRYPTO_free_ex_data(cls, NULL, &early);
+    CRYPTO_free_ex_data(cls, NULL, &late);
+    CRYPTO_free_ex_data(cls, NULL, &copy);
+    return ret;
+}
+
 int setup_tests(void)
 {
     ADD_TEST(test_exdata);
+    ADD_TEST(test_exdata_late_index);
     return 1;
 }
@@ -18,6 +18,7 @@
 #include <openssl/rand.h>
 #include <openssl/err.h>
 
+#include "crypto/bn.h"
 #include "testutil.h"
 
 #define NUM_BITS        (BN_BITS2 * 4)
@@ -227,9 +228,150 @@ static int test_mod_exp(int round)
     return ret;
 }
 
+/*
+ * test_mod_exp_crt_sizes checks BN_mod_exp_mont_consttime against
+ * BN_mod_exp_mont for the 1536- and 2048-bit moduli of the CRT halves
+ * of RSA-3072 and RSA-4096, which have code paths of their own.
+ */
+static int test_mod_exp_crt_sizes(int round)
+{
+    BN_CTX *ctx;
+    int bits = (round & 1) ? 2048 : 1536;
+    int ret = 0;
+    BIGNUM *r_mont = NULL;
+    BIGNUM *r_mont_const = NULL;
+    BIGNUM *a = NULL;
+    BIGNUM *b = NULL;
+    BIGNUM *m = NULL;
+
+    if (!TEST_ptr(ctx = BN_CTX_new()))
+        goto err;
+
+    if (!TEST_ptr(r_mont = BN_new())
+        || !TEST_ptr(r_mont_const = BN_new())
+        || !TEST_ptr(a = BN_new())
+        || !TEST_ptr(b = BN_new())
+        || !TEST_ptr(m = BN_new()))
+        goto err;
+
+    /* a modulus just below 2^bits now and then, for the final carries */
+    if (round % 8 < 2) {
+        if (!TEST_true(BN_set_bit(m, bits))
+            || !TEST_true(BN_sub_word(m, 2 * round + 1)))
+            goto err;
+    } else if (!TEST_true(BN_rand(m, bits - round % 3, BN_RAND_TOP_ONE,
+                                  BN_RAND_BOTTOM_ODD))) {
+        goto err;
+    }
+    if (!TEST_true(BN_rand_range(a, m))
+        || !TEST_true(BN_rand(b, bits - round % 5, BN_RAND_TOP_ANY,
+                              BN_RAND_BOTTOM_ANY))
+        || !TEST_true(BN_mod_exp_mont(r_mont, a, b, m, ctx, NULL))
+        || !TEST_true(BN_mod_exp_mont_consttime(r_mont_const, a, b, m, ctx,
+                                                NULL)))
+        goto err;
+
+    if (!TEST_BN_eq(r_mont, r_mont_const)) {
+        BN_print_var(a);
+        BN_print_var(b);
+        BN_print_var(m);
+        goto err;
+    }
+
+    ret = 1;
+ err:
+    BN_free(r_mont);
+    BN_free(r_mont_const);
+    BN_free(a);
+    BN_free(b);
+    BN_free(m);
+    BN_CTX_free(ctx);
+
+    return ret;
+}
+
+/*
+ * test_mod_exp_x2 checks the two exponentiations of
+ * bn_mod_exp_mont_consttime_x2 against BN_mod_exp_mont, with the results
+ * written over the bases as the RSA CRT code does. Both moduli are 1536 or
+ * both 2048 bits, which runs them side by side where that is supported, and
+ * every fourth round they differ in size, which runs them one after the
+ * other.
+ */
+static int test_mod_exp_x2(int round)
+{
+    BN_CTX *ctx;
+    int bits = (round & 1) ? 2048 : 1536;
+    int bits2 = round % 4 == 3 ? 3584 - bits : bits;
+    int ret = 0;
+    BIGNUM *r1 = NULL, *r2 = NULL;
+    BIGNUM *a1 = NULL, *a2 = NULL;
+    BIGNUM *b1 = NULL, *b2 = NULL;
+    BIGNUM *m1 = NULL, *m2 = NULL;
+    BN_MONT_CTX *mont1 = NULL, *mont2 = NULL;
+
+    if (!TEST_ptr(ctx = BN_CTX_new()))
+        goto err;
+
+    if (!TEST_ptr(r1 = BN_new())
+        || !TEST_ptr(r2 = BN_new())
+        || !TEST_ptr(a1 = BN_new())
+        || !TEST_ptr(a2 = BN_new())
+        || !TEST_ptr(b1 = BN_new())
+        || !TEST_ptr(b2 = BN_new())
+        || !TEST_ptr(m1 = BN_new())
+        || !TEST_ptr(m2 = BN_new())
+        || !TEST_ptr(mont1 = BN_MONT_CTX_new())
+        || !TEST_ptr(mont2 = BN_MONT_CTX_new()))
+        goto err;
+
+    if (!TEST_true(BN_rand(m1, bits, BN_RAND_TOP_ONE, BN_RAND_BOTTOM_ODD))
+        || !TEST_true(BN_rand(m2, bits2, BN_RAND_TOP_ONE, BN_RAND_BOTTOM_ODD))
+        || !TEST_true(BN_rand_range(a1, m1))
+        || !TEST_true(BN_rand_range(a2, m2))
+        || !TEST_true(BN_rand(b1, bits - round % 5, BN_RAND_TOP_ANY,
+                              BN_RAND_BOTTOM_ANY))
+        || !TEST_true(BN_rand(b2, bits2 - round % 3, BN_RAND_TOP_ANY,
+                              BN_RAND_BOTTOM_ANY))
+        || !TEST_true(BN_MONT_CTX_set(mont1, m1, ctx))
+        || !TEST_true(BN_MONT_CTX_set(mont2, m2, ctx))
+        || !TEST_true(BN_mod_exp_mont(r1, a1, b1, m1, ctx, NULL))
+        || !TEST_true(BN_mod_exp_mont(r2, a2, b2, m2, ctx, NULL))
+        || !TEST_true(bn_mod_exp_mont_consttime_x2(a1, a1, b1, m1, mont1,
+                                                   a2, a2, b2, m2, mont2,
+                                                   ctx)))
+        goto err;
+
+    if (!TEST_BN_eq(r1, a1) || !TEST_BN_eq(r2, a2)) {
+        BN_print_var(b1);
+        BN_print_var(m1);
+        BN_print_var(b2);
+        BN_print_var(m2);
+        goto err;
+    }
+
+    ret = 1;
+ err:
+    BN_free(r1);
+    BN_free(r2);
+    BN_free(a1);
+    BN_free(a2);
+    BN_free(b1);
+    BN_free(b2);
+    BN_free(m1);
+    BN_free(m2);
+    BN_MONT_CTX_free(mont1);
+    BN_MONT_CTX_free(mont2);
+    BN_CTX_free(ctx);
+
+    return ret;
+}
+
 int setup_tests(void)
 {
     ADD_TEST(test_mod_exp_zero);
     ADD_ALL_TESTS(test_mod_exp, 200);
+    ADD_ALL_TESTS(test_mod_exp_crt_sizes, 32);
+    ADD_ALL_TESTS(test_mod_exp_x2, 32);
     return 1;
 }
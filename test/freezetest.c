@@ -0,0 +1,127 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <openssl/e_os2.h>
+#if !defined(OPENSSL_SYS_WINDOWS) && !defined(OPENSSL_SYS_VMS)
+# include <sys/types.h>
+# include <sys/wait.h>
+# include <unistd.h>
+# define FREEZE_FORK
+#endif
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+#include "internal/refcount.h"
+#include "ssltestlib.h"
+#include "testutil.h"
+
+static char *cert = NULL;
+static char *privkey = NULL;
+
+static int test_refcount(void)
+{
+    CRYPTO_REF_COUNT count = 1;
+    int ret;
+
+    if (!TEST_true(CRYPTO_UP_REF(&count, &ret, NULL))
+            || !TEST_int_eq(ret, 2)
+            || !TEST_true(CRYPTO_DOWN_REF(&count, &ret, NULL))
+            || !TEST_int_eq(ret, 1))
+        return 0;
+
+    CRYPTO_REF_FREEZE(&count);
+    if (!TEST_true(CRYPTO_UP_REF(&count, &ret, NULL))
+            || !TEST_int_eq(ret, CRYPTO_REF_FROZEN)
+            || !TEST_true(CRYPTO_DOWN_REF(&count, &ret, NULL))
+            || !TEST_true(CRYPTO_DOWN_REF(&count, &ret, NULL))
+            || !TEST_int_eq(ret, CRYPTO_REF_FROZEN)
+            || !TEST_int_eq((int)count, CRYPTO_REF_FROZEN))
+        return 0;
+    return 1;
+}
+
+static int handshake(SSL_CTX *sctx, SSL_CTX *cctx)
+{
+    SSL *serverssl = NULL, *clientssl = NULL;
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))) {
+        SSL_free(serverssl);
+        SSL_free(clientssl);
+        return 0;
+    }
+    shutdown_ssl_connection(serverssl, clientssl);
+    return 1;
+}
+
+/*
+ * Frozen objects are never freed, so this runs in a child process to keep
+ * them from being reported as leaks
+ */
+static int ctx_freeze(void)
+{
+    SSL_CTX *sctx = NULL, *cctx = NULL;
+    X509 *x;
+    int i, ret = 0;
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(), TLS1_VERSION, 0,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_true(SSL_CTX_freeze(sctx))
+            || !TEST_ptr(x = SSL_CTX_get0_certificate(sctx)))
+        goto end;
+
+    /* References to frozen objects can be dropped more than they are taken */
+    for (i = 0; i < 3; i++)
+        X509_free(x);
+    if (!TEST_true(X509_up_ref(x))
+            || !TEST_true(handshake(sctx, cctx)))
+        goto end;
+    SSL_CTX_free(sctx);
+    if (!TEST_true(handshake(sctx, cctx))
+            || !TEST_ptr_eq(SSL_CTX_get0_certificate(sctx), x))
+        goto end;
+    ret = 1;
+
+ end:
+    SSL_CTX_free(cctx);
+    return ret;
+}
+
+static int test_ctx_freeze(void)
+{
+#ifdef FREEZE_FORK
+    pid_t pid;
+    int status;
+
+    if (!TEST_int_ge(pid = fork(), 0))
+        return 0;
+    if (pid == 0)
+        _exit(ctx_freeze() ? 0 : 1);
+    if (!TEST_int_eq(waitpid(pid, &status, 0), pid))
+        return 0;
+    return TEST_true(WIFEXITED(status)) && TEST_int_eq(WEXITSTATUS(status), 0);
+#else
+    TEST_info("Skipping: needs fork()");
+    return 1;
+#endif
+}
+
+int setup_tests(void)
+{
+    if (!TEST_ptr(cert = test_get_argument(0))
+            || !TEST_ptr(privkey = test_get_argument(1)))
+        return 0;
+
+    ADD_TEST(test_refcount);
+    ADD_TEST(test_ctx_freeze);
+    return 1;
+}
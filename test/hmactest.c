@@ -245,6 +245,52 @@ err:
     return ret;
 }
 
+static int test_hmac_key(void)
+{
+    char *p;
+    HMAC_KEY *hkey = NULL;
+    HMAC_CTX *ctx = NULL;
+    unsigned char longkey[200];
+    unsigned char buf[EVP_MAX_MD_SIZE], buf2[EVP_MAX_MD_SIZE];
+    unsigned int len, len2;
+    int i, ret = 0;
+
+    hkey = HMAC_KEY_new();
+    ctx = HMAC_CTX_new();
+    if (!TEST_ptr(hkey) || !TEST_ptr(ctx)
+        || !TEST_true(HMAC_KEY_set(hkey, test[6].key, test[6].key_len,
+                                   EVP_sha256())))
+        goto err;
+
+    /* The key can be used for any number of messages */
+    for (i = 0; i < 2; i++) {
+        if (!TEST_true(HMAC_Init_key(ctx, hkey))
+            || !TEST_true(HMAC_Update(ctx, test[6].data, test[6].data_len))
+            || !TEST_true(HMAC_Final(ctx, buf, &len)))
+            goto err;
+        p = pt(buf, len);
+        if (!TEST_str_eq(p, (char *)test[6].digest))
+            goto err;
+    }
+
+    /* Keys longer than a block are hashed first */
+    memset(longkey, 0xaa, sizeof(longkey));
+    if (!TEST_true(HMAC_KEY_set(hkey, longkey, sizeof(longkey), EVP_sha1()))
+        || !TEST_true(HMAC_Init_key(ctx, hkey))
+        || !TEST_true(HMAC_Update(ctx, test[7].data, test[7].data_len))
+        || !TEST_true(HMAC_Final(ctx, buf, &len))
+        || !TEST_ptr(HMAC(EVP_sha1(), longkey, sizeof(longkey), test[7].data,
+                          test[7].data_len, buf2, &len2))
+        || !TEST_mem_eq(buf, len, buf2, len2))
+        goto err;
+
+    ret = 1;
+err:
+    HMAC_CTX_free(ctx);
+    HMAC_KEY_free(hkey);
+    return ret;
+}
+
 # ifndef OPENSSL_NO_MD5
 static char *pt(unsigned char *md, unsigned int len)
 {
@@ -264,6 +310,7 @@ int setup_tests(void)
     ADD_TEST(test_hmac_bad);
     ADD_TEST(test_hmac_run);
     ADD_TEST(test_hmac_copy);
+    ADD_TEST(test_hmac_key);
     return 1;
 }
 
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/objects.h>
+#include <openssl/ssl.h>
+#include "ssltestlib.h"
+#include "testutil.h"
+
+static char *cert = NULL;
+static char *privkey = NULL;
+
+/* Not needed by any cipher suite, so libssl never adds it */
+#define UNUSED_CIPHER   "AES-128-OFB"
+
+static const EVP_CIPHER *cipher_in_table(const char *name)
+{
+    return (const EVP_CIPHER *)OBJ_NAME_get(name, OBJ_NAME_TYPE_CIPHER_METH);
+}
+
+static int test_lazy_handshake(void)
+{
+    SSL_CTX *sctx = NULL, *cctx = NULL;
+    SSL *serverssl = NULL, *clientssl = NULL;
+    int testresult = 0;
+
+    if (!TEST_ptr_null(cipher_in_table(UNUSED_CIPHER)))
+        return 0;
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(), 0, 0,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_true(create_ssl_objects(sctx, cctx, &serverssl,
+                                             &clientssl, NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE)))
+        goto end;
+
+    /* Nothing the handshake did needed the full cipher table */
+    if (!TEST_ptr_null(cipher_in_table(UNUSED_CIPHER)))
+        goto end;
+
+    testresult = 1;
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return testresult;
+}
+
+static int test_lookup_on_demand(void)
+{
+    return TEST_ptr(EVP_get_cipherbyname(UNUSED_CIPHER))
+           && TEST_ptr(cipher_in_table(UNUSED_CIPHER))
+           && TEST_ptr(EVP_get_digestbyname("SHA3-256"));
+}
+
+static int test_ssl_strings_on_demand(void)
+{
+#ifndef OPENSSL_NO_ERR
+    unsigned long e = ERR_PACK(ERR_LIB_SSL, 0, SSL_R_NO_CIPHERS_AVAILABLE);
+
+    return TEST_str_eq(ERR_reason_error_string(e), "no ciphers available");
+#else
+    return 1;
+#endif
+}
+
+int global_init(void)
+{
+    return OPENSSL_init_ssl(OPENSSL_INIT_LAZY_ALGORITHMS, NULL);
+}
+
+int setup_tests(void)
+{
+    if (!TEST_ptr(cert = test_get_argument(0))
+            || !TEST_ptr(privkey = test_get_argument(1)))
+        return 0;
+
+    /* In this order: the first test needs the tables as libssl left them */
+    ADD_TEST(test_lazy_handshake);
+    ADD_TEST(test_lookup_on_demand);
+    ADD_TEST(test_ssl_strings_on_demand);
+    return 1;
+}
@@ -220,9 +220,93 @@ end:
     return testresult;
 }
 
+/*
+ * Insert and delete a sliding window of keys, so that nodes are recycled and
+ * the table repeatedly grows and shrinks while entries come and go.
+ */
+static int test_churn(void)
+{
+    LHASH_OF(int) *h = lh_int_new(&stress_hash, &int_cmp);
+    static int keys[4096];
+    const unsigned int window = 300;
+    unsigned int i, j;
+    int testresult = 0;
+
+    if (!TEST_ptr(h))
+        goto end;
+
+    for (i = 0; i < OSSL_NELEM(keys); i++)
+        keys[i] = 5 * i + 2;
+
+    for (i = 0; i < OSSL_NELEM(keys); i++) {
+        if (!TEST_ptr_null(lh_int_insert(h, &keys[i]))
+                || !TEST_int_eq(lh_int_error(h), 0))
+            goto end;
+        if (i >= window
+                && !TEST_ptr_eq(lh_int_delete(h, &keys[i - window]),
+                                &keys[i - window]))
+            goto end;
+        if ((i % 512) == 511) {
+            /* drain the table down to a handful of entries */
+            for (j = i - window + 1; j + 4 <= i; j++)
+                if (!TEST_ptr_eq(lh_int_delete(h, &keys[j]), &keys[j]))
+                    goto end;
+            for (j = i - window + 1; j + 4 <= i; j++)
+                if (!TEST_ptr_null(lh_int_insert(h, &keys[j])))
+                    goto end;
+        }
+        if (!TEST_ptr_eq(lh_int_retrieve(h, &keys[i]), &keys[i])
+                || (i >= window
+                    && !TEST_ptr_null(lh_int_retrieve(h, &keys[i - window]))))
+            goto end;
+    }
+    if (!TEST_int_eq(lh_int_num_items(h), window))
+        goto end;
+    for (i = OSSL_NELEM(keys) - window; i < OSSL_NELEM(keys); i++)
+        if (!TEST_ptr_eq(lh_int_retrieve(h, &keys[i]), &keys[i]))
+            goto end;
+
+    testresult = 1;
+end:
+    lh_int_free(h);
+    return testresult;
+}
+
+/*
+ * Keys sharing a long prefix, like the session IDs that all fell into one
+ * bucket with the old session hash, must spread over the table.
+ */
+static int test_keyed_hash(void)
+{
+    unsigned char id[32];
+    unsigned int counts[64];
+    unsigned long h;
+    unsigned int i;
+
+    memset(id, 0xab, sizeof(id));
+    memset(counts, 0, sizeof(counts));
+    h = OPENSSL_LH_keyed_hash(id, sizeof(id));
+    if (!TEST_ulong_eq(OPENSSL_LH_keyed_hash(id, sizeof(id)), h)
+            || !TEST_ulong_ne(OPENSSL_LH_keyed_hash(id, sizeof(id) - 1), h))
+        return 0;
+
+    for (i = 0; i < 64 * 64; i++) {
+        id[sizeof(id) - 2] = (unsigned char)(i >> 8);
+        id[sizeof(id) - 1] = (unsigned char)i;
+        counts[OPENSSL_LH_keyed_hash(id, sizeof(id)) % 64]++;
+    }
+    /* 64 per bucket on average: more than 3 times that is not random */
+    for (i = 0; i < OSSL_NELEM(counts); i++)
+        if (!TEST_uint_lt(counts[i], 3 * 64))
+            return 0;
+    return 1;
+}
+
 int setup_tests(void)
 {
     ADD_TEST(test_int_lhash);
     ADD_TEST(test_stress);
+    ADD_TEST(test_churn);
+    ADD_TEST(test_keyed_hash);
     return 1;
 }
@@ -150,6 +150,64 @@ static int test_resp_signer(void)
     return ret;
 }
 
+static int test_resp_cached_encoding(void)
+{
+    OCSP_BASICRESP *bs = NULL, *dec = NULL, *dec2 = NULL;
+    X509 *signer = NULL;
+    EVP_PKEY *key = NULL;
+    STACK_OF(X509) *certs = NULL;
+    unsigned char *der = NULL, *der2 = NULL;
+    const unsigned char *p;
+    int derlen, der2len, ret = 0;
+
+    if (!TEST_ptr(bs = make_dummy_resp())
+        || !TEST_true(get_cert_and_key(&signer, &key))
+        || !TEST_ptr(certs = sk_X509_new_null())
+        || !TEST_true(sk_X509_push(certs, signer))
+        || !TEST_true(OCSP_basic_sign(bs, signer, key, EVP_sha256(),
+                                      NULL, OCSP_NOCERTS))
+        || !TEST_int_gt(derlen = i2d_OCSP_BASICRESP(bs, &der), 0))
+        goto err;
+
+    /* A decoded response verifies against the encoding it was decoded from */
+    p = der;
+    if (!TEST_ptr(dec = d2i_OCSP_BASICRESP(NULL, &p, derlen))
+        || !TEST_int_eq(OCSP_basic_verify(dec, certs, NULL,
+                                          OCSP_NOVERIFY | OCSP_TRUSTOTHER), 1))
+        goto err;
+
+    /* Modifying it invalidates the cached encoding, and the signature */
+    if (!TEST_true(OCSP_basic_add1_nonce(dec, NULL, 16))
+        || !TEST_int_gt(der2len = i2d_OCSP_BASICRESP(dec, &der2), derlen))
+        goto err;
+    p = der2;
+    if (!TEST_ptr(dec2 = d2i_OCSP_BASICRESP(NULL, &p, der2len))
+        || !TEST_int_ge(OCSP_BASICRESP_get_ext_by_NID(dec2, NID_id_pkix_OCSP_Nonce,
+                                                      -1), 0)
+        || !TEST_int_le(OCSP_basic_verify(dec, certs, NULL,
+                                          OCSP_NOVERIFY | OCSP_TRUSTOTHER), 0))
+        goto err;
+
+    /* Signing it again signs the modified contents */
+    if (!TEST_true(OCSP_basic_sign(dec, signer, key, EVP_sha256(),
+                                   NULL, OCSP_NOCERTS))
+        || !TEST_int_eq(OCSP_basic_verify(dec, certs, NULL,
+                                          OCSP_NOVERIFY | OCSP_TRUSTOTHER), 1))
+        goto err;
+    ret = 1;
+ err:
+    ERR_clear_error();
+    OPENSSL_free(der);
+    OPENSSL_free(der2);
+    OCSP_BASICRESP_free(bs);
+    OCSP_BASICRESP_free(dec);
+    OCSP_BASICRESP_free(dec2);
+    sk_X509_free(certs);
+    X509_free(signer);
+    EVP_PKEY_free(key);
+    return ret;
+}
+
 static int test_access_description(int testcase)
 {
     ACCESS_DESCRIPTION *ad = ACCESS_DESCRIPTION_new();
@@ -218,6 +276,7 @@ int setup_tests(void)
         return 0;
 #ifndef OPENSSL_NO_OCSP
     ADD_TEST(test_resp_signer);
+    ADD_TEST(test_resp_cached_encoding);
     ADD_ALL_TESTS(test_access_description, 3);
     ADD_TEST(test_ocsp_url_svcloc_new);
 #endif
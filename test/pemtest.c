@@ -10,6 +10,7 @@
 #include <string.h>
 #include <openssl/bio.h>
 #include <openssl/pem.h>
+#include <openssl/err.h>
 
 #include "testutil.h"
 #include "internal/nelem.h"
@@ -112,10 +113,145 @@ static int test_empty_payload(void)
     return ret;
 }
 
+/*
+ * Inputs read through memory and file BIOs, which take the fast path of
+ * PEM_read_bio_ex(), and through a buffering BIO, read line by line
+ */
+static const char *flat_inputs[] = {
+    /* Leading garbage, then two blocks */
+    "junk\n-----BEGIN junk\n\n"
+    "-----BEGIN PEMTESTDATA-----\n"
+    "YSB2ZXJ5IG9vb29vb29vb29vb29vb29vb29vb29vb29vb29vb29vb29vb29vb29v\n"
+    "b29vb29vb29vb29vb29vb29vb29vb29vb29vb29vb29vb29uZyBpbnB1dA==\n"
+    "-----END PEMTESTDATA-----\n"
+    "-----BEGIN OTHER-----\n"
+    "aGVsbG8gd29ybGQ=\n"
+    "-----END OTHER-----\n"
+    "trailer\n",
+    /* CRLF line endings and trailing blanks */
+    "-----BEGIN PEMTESTDATA-----  \r\n"
+    "aGVsbG8gd29ybGQ=\r\n"
+    "-----END PEMTESTDATA-----\r\n",
+    /* Headers */
+    "-----BEGIN PEMTESTDATA-----\n"
+    "Proc-Type: 4,ENCRYPTED\n"
+    "\n"
+    "aGVsbG8gd29ybGQ=\n"
+    "-----END PEMTESTDATA-----\n",
+    /* Body line longer than what BIO_gets() is asked for */
+    "-----BEGIN PEMTESTDATA-----\n"
+    "YSB2ZXJ5IG9vb29vb29vb29vb29vb29vb29vb29vb29vb29vb29vb29vb29vb29v"
+    "YSB2ZXJ5IG9vb29vb29vb29vb29vb29vb29vb29vb29vb29vb29vb29vb29vb29v"
+    "YSB2ZXJ5IG9vb29vb29vb29vb29vb29vb29vb29vb29vb29vb29vb29vb29vb29v"
+    "YSB2ZXJ5IG9vb29vb29vb29vb29vb29vb29vb29vb29vb29vb29vb29vb29vb29v"
+    "aGVsbG8gd29ybGQ=\n"
+    "-----END PEMTESTDATA-----\n",
+    /* Mismatched END line */
+    "-----BEGIN PEMTESTDATA-----\n"
+    "aGVsbG8gd29ybGQ=\n"
+    "-----END OTHER-----\n",
+    /* No END line */
+    "-----BEGIN PEMTESTDATA-----\n"
+    "aGVsbG8gd29ybGQ=\n"
+};
+
+static const unsigned int flat_flags[] = {
+    PEM_FLAG_EAY_COMPATIBLE, 0, PEM_FLAG_ONLY_B64
+};
+
+/* Reads every block of |fast| and |slow| and checks they are the same */
+static int pem_read_same(BIO *fast, BIO *slow, unsigned int flags)
+{
+    char *name[2] = { NULL, NULL }, *header[2] = { NULL, NULL };
+    unsigned char *data[2] = { NULL, NULL };
+    long len[2];
+    char rest[2][64];
+    int ok[2], i, ret = 0;
+
+    do {
+        for (i = 0; i < 2; i++) {
+            OPENSSL_free(name[i]);
+            OPENSSL_free(header[i]);
+            OPENSSL_free(data[i]);
+        }
+        ok[0] = PEM_read_bio_ex(fast, &name[0], &header[0], &data[0], &len[0],
+                                flags);
+        ok[1] = PEM_read_bio_ex(slow, &name[1], &header[1], &data[1], &len[1],
+                                flags);
+        ERR_clear_error();
+        if (!TEST_int_eq(ok[0], ok[1]))
+            goto err;
+        if (ok[0]
+                && (!TEST_str_eq(name[0], name[1])
+                    || !TEST_str_eq(header[0], header[1])
+                    || !TEST_mem_eq(data[0], len[0], data[1], len[1])))
+            goto err;
+    } while (ok[0]);
+
+    /* Both were left at the same place */
+    len[0] = BIO_read(fast, rest[0], sizeof(rest[0]));
+    len[1] = BIO_read(slow, rest[1], sizeof(rest[1]));
+    if (!TEST_mem_eq(rest[0], len[0] > 0 ? len[0] : 0,
+                     rest[1], len[1] > 0 ? len[1] : 0))
+        goto err;
+    ret = 1;
+ err:
+    for (i = 0; i < 2; i++) {
+        OPENSSL_free(name[i]);
+        OPENSSL_free(header[i]);
+        OPENSSL_free(data[i]);
+    }
+    return ret;
+}
+
+static int test_read_flat(int idx)
+{
+    const char *in = flat_inputs[idx / OSSL_NELEM(flat_flags)];
+    unsigned int flags = flat_flags[idx % OSSL_NELEM(flat_flags)];
+    BIO *fast = NULL, *slow = NULL;
+    int ret = 0;
+#ifndef OPENSSL_NO_STDIO
+    FILE *fp = NULL;
+#endif
+
+    if (!TEST_ptr(fast = BIO_new_mem_buf(in, -1))
+            || !TEST_ptr(slow = BIO_new(BIO_f_buffer()))
+            || !TEST_ptr(BIO_push(slow, BIO_new_mem_buf(in, -1)))
+            || !TEST_true(pem_read_same(fast, slow, flags)))
+        goto err;
+
+#ifndef OPENSSL_NO_STDIO
+    BIO_free(fast);
+    BIO_free_all(slow);
+    fast = slow = NULL;
+    if (!TEST_ptr(fp = tmpfile())
+            || !TEST_size_t_eq(fwrite(in, 1, strlen(in), fp), strlen(in))
+            || !TEST_int_eq(fseek(fp, 0, SEEK_SET), 0)
+            || !TEST_ptr(fast = BIO_new_fp(fp, BIO_CLOSE)))
+        goto err;
+    fp = NULL;
+    if (!TEST_ptr(slow = BIO_new(BIO_f_buffer()))
+            || !TEST_ptr(BIO_push(slow, BIO_new_mem_buf(in, -1)))
+            || !TEST_true(pem_read_same(fast, slow, flags)))
+        goto err;
+#endif
+    ret = 1;
+ err:
+#ifndef OPENSSL_NO_STDIO
+    if (fp != NULL)
+        fclose(fp);
+#endif
+    BIO_free(fast);
+    BIO_free_all(slow);
+    return ret;
+}
+
 int setup_tests(void)
 {
     ADD_ALL_TESTS(test_b64, OSSL_NELEM(b64_pem_data));
     ADD_TEST(test_invalid);
     ADD_TEST(test_empty_payload);
+    ADD_ALL_TESTS(test_read_flat,
+                  OSSL_NELEM(flat_inputs) * OSSL_NELEM(flat_flags));
     return 1;
 }
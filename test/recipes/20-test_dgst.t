@@ -16,7 +16,7 @@ use OpenSSL::Test::Utils;
 
 setup("test_dgst");
 
-plan tests => 6;
+plan tests => 7;
 
 sub tsignverify {
     my $testtext = shift;
@@ -121,3 +121,23 @@ SKIP: {
         ok($macdata[0] =~ $expected, "SHA1: Check HASH value is as expected ($macdata[0]) vs ($expected)");
     }
 }
+
+SKIP: {
+    skip "dgst -threads is not supported by this OpenSSL build", 1
+        if disabled("threads") || $^O eq "MSWin32";
+
+    subtest "SHA256 of several files with `dgst -threads` CLI" => sub {
+        plan tests => 2;
+
+        my @files = (srctop_file('test', 'README'),
+                     srctop_file('test', 'data.bin'),
+                     srctop_file('test', 'README.external'));
+        my @serial = run(app(['openssl', 'dgst', '-sha256', @files]),
+                         capture => 1);
+        my @threaded = run(app(['openssl', 'dgst', '-sha256',
+                                '-threads', '2', @files]), capture => 1);
+        ok(@serial == 3, "Digested every file");
+        is(join('', @threaded), join('', @serial),
+           "Same digests in the same order");
+    }
+}
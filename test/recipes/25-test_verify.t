@@ -27,7 +27,7 @@ sub verify {
     run(app([@args]));
 }
 
-plan tests => 148;
+plan tests => 153;
 
 # Canonical success
 ok(verify("ee-cert", "sslserver", ["root-cert"], ["ca-cert"]),
@@ -420,3 +420,29 @@ ok(!verify("ee-cert-policies-bad", "sslserver", ["root-cert"], ["ca-pol-cert"],
            "-policy_check", "-policy", "1.3.6.1.4.1.16604.998855.1",
            "-explicit_policy"),
    "Bad certificate policy");
+
+# Batch verification
+ok(verify("ee-cert", "sslserver", ["root-cert"], ["ca-cert"], "-batch"),
+   "accept in batch mode");
+ok(!verify("ee-cert", "sslserver", ["root-cert"], [], "-batch"),
+   "fail missing intermediate in batch mode");
+
+# Bulk verification
+open(my $fh, ">", "verify-list.txt") or die "Can't write verify-list.txt\n";
+print $fh srctop_file("test", "certs", "ee-cert.pem"), "\n";
+close $fh;
+ok(verify("ca-cert", "sslserver", ["root-cert"], ["ca-cert"],
+          "-list", "verify-list.txt"),
+   "accept a list of certificates");
+ok(!verify("ee-expired", "sslserver", ["root-cert"], ["ca-cert"],
+           "-list", "verify-list.txt"),
+   "fail an expired certificate in a list");
+
+SKIP: {
+    skip "No threads support in this build", 1
+        if disabled("threads") || $^O eq "MSWin32";
+
+    ok(verify("ee-cert", "sslserver", ["root-cert"], ["ca-cert"],
+              "-threads", "2", "-list", "verify-list.txt"),
+       "accept with multiple threads");
+}
@@ -15,6 +15,7 @@ use File::Copy;
 use File::Basename;
 use OpenSSL::Glob;
 use OpenSSL::Test qw/:DEFAULT srctop_file/;
+use OpenSSL::Test::Utils;
 
 setup("test_rehash");
 
@@ -23,7 +24,7 @@ setup("test_rehash");
 plan skip_all => "test_rehash is not available on this platform"
     unless run(app(["openssl", "rehash", "-help"]));
 
-plan tests => 4;
+plan tests => 6;
 
 indir "rehash.$$" => sub {
     prepare();
@@ -56,6 +57,20 @@ indir "rehash.$$" => sub {
     chmod 0700, curdir();       # make it writable again, so cleanup works
 }, create => 1, cleanup => 1;
 
+indir "rehash.$$" => sub {
+    prepare();
+    my @threads = disabled("threads") ? () : ("-threads", "2");
+    ok(run(app(["openssl", "rehash", "-incremental", "-bundle", "ca.bundle",
+                @threads, curdir()]))
+       && -f ".rehash.manifest" && -s "ca.bundle",
+       'Testing incremental rehash with a bundle');
+    my @links = sort glob("*.[0-9]");
+    unlink $links[0];
+    ok(run(app(["openssl", "rehash", "-incremental", curdir()]))
+       && join(",", sort glob("*.[0-9]")) eq join(",", @links),
+       'Testing incremental rehash restoring a link');
+}, create => 1, cleanup => 1;
+
 sub prepare {
     my @pemsourcefiles = sort glob(srctop_file('test', "*.pem"));
     my @destfiles = ();
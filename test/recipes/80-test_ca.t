@@ -23,26 +23,61 @@ my $std_openssl_cnf =
 
 rmtree("demoCA", { safe => 0 });
 
-plan tests => 5;
+plan tests => 6;
  SKIP: {
      $ENV{OPENSSL_CONFIG} = '-config "'.srctop_file("test", "CAss.cnf").'"';
-     skip "failed creating CA structure", 4
+     skip "failed creating CA structure", 5
 	 if !ok(run(perlapp(["CA.pl","-newca"], stdin => undef)),
 		'creating CA structure');
 
      $ENV{OPENSSL_CONFIG} = '-config "'.srctop_file("test", "Uss.cnf").'"';
-     skip "failed creating new certificate request", 3
+     skip "failed creating new certificate request", 4
 	 if !ok(run(perlapp(["CA.pl","-newreq"])),
 		'creating certificate request');
 
      $ENV{OPENSSL_CONFIG} = '-rand_serial -config "'.$std_openssl_cnf.'"';
-     skip "failed to sign certificate request", 2
+     skip "failed to sign certificate request", 3
 	 if !is(yes(cmdstr(perlapp(["CA.pl", "-sign"]))), 0,
 		'signing certificate request');
 
      ok(run(perlapp(["CA.pl", "-verify", "newcert.pem"])),
         'verifying new certificate');
 
+     subtest 'signing a directory of requests' => sub {
+         my @threads = disabled("threads") || $^O eq "MSWin32"
+             ? () : ("-threads", "2");
+
+         plan tests => 5;
+
+         rmtree(["batchkeys", "batchreqs"], { safe => 0 });
+         mkdir "batchkeys";
+         mkdir "batchreqs";
+         ok(run(app(["openssl", "genpkey", "-algorithm", "EC",
+                     "-pkeyopt", "ec_paramgen_curve:P-256",
+                     "-count", "3", "-outdir", "batchkeys", @threads])),
+            'generating a batch of keys');
+         ok(run(app(["openssl", "req", "-config", $std_openssl_cnf,
+                     "-new", "-key", "batchkeys/1.pem", "-subj", "/CN=batch1",
+                     "-out", "batchreqs/1.csr"]))
+            && run(app(["openssl", "req", "-config", $std_openssl_cnf,
+                        "-new", "-key", "batchkeys/3.pem",
+                        "-subj", "/CN=batch3", "-out", "batchreqs/3.csr"])),
+            'creating certificate requests');
+         my $issued = () = glob("demoCA/newcerts/*.pem");
+         ok(run(app(["openssl", "ca", "-config", $std_openssl_cnf,
+                     "-batch", "-rand_serial", "-policy", "policy_anything",
+                     "-notext", "-out", "batchcerts.pem",
+                     "-indir", "batchreqs", @threads])),
+            'signing the requests');
+         ok(run(app(["openssl", "verify", "-CAfile", "demoCA/cacert.pem",
+                     "batchcerts.pem"])),
+            'verifying a new certificate');
+         is(scalar(() = glob("demoCA/newcerts/*.pem")), $issued + 2,
+            'writing both certificates');
+         rmtree(["batchkeys", "batchreqs"], { safe => 0 });
+         unlink "batchcerts.pem";
+     };
+
      skip "CT not configured, can't use -precert", 1
          if disabled("ct");
 
@@ -0,0 +1,20 @@
+#! /usr/bin/env perl
+# Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+#
+# Licensed under the OpenSSL license (the "License").  You may not use
+# this file except in compliance with the License.  You can obtain a copy
+# in the file LICENSE in the source distribution or at
+# https://www.openssl.org/source/license.html
+
+
+use OpenSSL::Test::Utils;
+use OpenSSL::Test qw/:DEFAULT/;
+
+setup("test_tsapi");
+
+plan skip_all => "TS is disabled in this build" if disabled("ts");
+plan skip_all => "EC is disabled in this build" if disabled("ec");
+
+plan tests => 1;
+
+ok(run(test(["tsapitest"])), "running tsapitest");
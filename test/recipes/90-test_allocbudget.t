@@ -0,0 +1,22 @@
+#! /usr/bin/env perl
+# Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+#
+# Licensed under the OpenSSL license (the "License").  You may not use
+# this file except in compliance with the License.  You can obtain a copy
+# in the file LICENSE in the source distribution or at
+# https://www.openssl.org/source/license.html
+
+
+use OpenSSL::Test::Utils;
+use OpenSSL::Test qw/:DEFAULT srctop_file data_file/;
+
+setup("test_allocbudget");
+
+plan skip_all => "TLSv1.3 is not supported by this OpenSSL build"
+    if disabled("tls1_3") || disabled("ec");
+
+plan tests => 1;
+
+ok(run(test(["allocbudgettest", srctop_file("apps", "server.pem"),
+             srctop_file("apps", "server.pem"), data_file("budgets.txt")])),
+   "running allocbudgettest");
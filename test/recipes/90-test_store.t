@@ -77,7 +77,7 @@ my $n = (3 * scalar @noexist_files)
     + (scalar keys %generated_file_files)
     + (scalar @noexist_file_files)
     + 3
-    + 11;
+    + 13;
 
 plan tests => $n;
 
@@ -186,6 +186,23 @@ indir "store_$$" => sub {
                     srctop_file('test', 'testcrl.pem')])),
            "Checking that -crls returns 1 object on a CRL file");
 
+    SKIP: {
+            skip "No threads support in this build", 2
+                if disabled("threads") || $^O eq "MSWin32";
+
+            my @serial = run(app(['openssl', 'storeutl', '-noout', '-r',
+                                  '-passin', 'pass:password', curdir()]),
+                             capture => 1);
+            my @threaded = run(app(['openssl', 'storeutl', '-noout', '-r',
+                                    '-passin', 'pass:password',
+                                    '-threads', '3', curdir()]),
+                               capture => 1);
+            ok(scalar @threaded > scalar @generated_files,
+               "Checking that -r -threads loads the whole directory");
+            is(join('', @threaded), join('', @serial),
+               "Checking that -r -threads prints the same as one thread");
+        }
+
     SKIP: {
             skip "failed rehash initialisation", 6 unless $rehash;
 
@@ -7,6 +7,10 @@
 # https://www.openssl.org/source/license.html
 
 
-use OpenSSL::Test::Simple;
+use OpenSSL::Test qw/:DEFAULT srctop_dir/;
 
-simple_test("test_threads", "threadstest");
+setup("test_threads");
+
+plan tests => 1;
+
+ok(run(test(["threadstest", srctop_dir("test", "certs")])));
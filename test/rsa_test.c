@@ -18,6 +18,9 @@
 #include <openssl/err.h>
 #include <openssl/rand.h>
 #include <openssl/bn.h>
+#include <openssl/async.h>
+#include <openssl/evp.h>
+#include <openssl/sha.h>
 
 #include "testutil.h"
 
@@ -349,11 +352,103 @@ err:
     return ret;
 }
 
+static RAND_METHOD fake_rand;
+static unsigned int fake_rand_counter;
+
+/* SHA-256 in counter mode, so that every key generation sees the same bytes */
+static int fake_rand_bytes(unsigned char *buf, int num)
+{
+    unsigned char block[SHA256_DIGEST_LENGTH], in[4];
+    int n;
+
+    while (num > 0) {
+        in[0] = (unsigned char)(fake_rand_counter >> 24);
+        in[1] = (unsigned char)(fake_rand_counter >> 16);
+        in[2] = (unsigned char)(fake_rand_counter >> 8);
+        in[3] = (unsigned char)fake_rand_counter;
+        fake_rand_counter++;
+        SHA256(in, sizeof(in), block);
+        n = num < (int)sizeof(block) ? num : (int)sizeof(block);
+        memcpy(buf, block, n);
+        buf += n;
+        num -= n;
+    }
+    return 1;
+}
+
+static BIGNUM *rsa_keygen_on_pool(OSSL_WORKER_POOL *pool)
+{
+    EVP_PKEY_CTX *ctx = NULL;
+    EVP_PKEY *pkey = NULL;
+    BIGNUM *n = NULL;
+    const BIGNUM *key_n;
+
+    fake_rand_counter = 0;
+    if (!TEST_ptr(ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, NULL))
+            || !TEST_int_gt(EVP_PKEY_keygen_init(ctx), 0)
+            || !TEST_int_gt(EVP_PKEY_CTX_set_rsa_keygen_bits(ctx, 1024), 0))
+        goto err;
+    EVP_PKEY_CTX_set0_worker_pool(ctx, pool);
+    if (!TEST_int_gt(EVP_PKEY_keygen(ctx, &pkey), 0)
+            || !TEST_int_eq(RSA_check_key(EVP_PKEY_get0_RSA(pkey)), 1))
+        goto err;
+    RSA_get0_key(EVP_PKEY_get0_RSA(pkey), &key_n, NULL, NULL);
+    n = BN_dup(key_n);
+ err:
+    EVP_PKEY_free(pkey);
+    EVP_PKEY_CTX_free(ctx);
+    return n;
+}
+
+/*
+ * The primes found on a worker pool only depend on the random numbers drawn,
+ * not on the number of threads.
+ */
+static int test_rsa_keygen_worker_pool(void)
+{
+    OSSL_WORKER_POOL *pool1 = NULL, *pool3 = NULL;
+    const RAND_METHOD *old_rand = NULL;
+    BIGNUM *n1 = NULL, *n3 = NULL;
+    int ret = 0;
+
+    ERR_set_mark();
+    if ((pool1 = OSSL_WORKER_POOL_new(1)) == NULL
+            || (pool3 = OSSL_WORKER_POOL_new(3)) == NULL) {
+        ERR_pop_to_mark();
+        TEST_note("no worker pool support - skipping");
+        ret = 1;
+        goto err;
+    }
+    ERR_clear_last_mark();
+
+    if (!TEST_ptr(old_rand = RAND_get_rand_method()))
+        goto err;
+    fake_rand = *old_rand;
+    fake_rand.bytes = fake_rand_bytes;
+    if (!TEST_true(RAND_set_rand_method(&fake_rand)))
+        goto err;
+    n1 = rsa_keygen_on_pool(pool1);
+    n3 = rsa_keygen_on_pool(pool3);
+    if (!TEST_true(RAND_set_rand_method(old_rand)))
+        goto err;
+
+    if (!TEST_ptr(n1) || !TEST_ptr(n3) || !TEST_BN_eq(n1, n3))
+        goto err;
+    ret = 1;
+ err:
+    BN_free(n1);
+    BN_free(n3);
+    OSSL_WORKER_POOL_free(pool1);
+    OSSL_WORKER_POOL_free(pool3);
+    return ret;
+}
+
 int setup_tests(void)
 {
     ADD_ALL_TESTS(test_rsa_pkcs1, 3);
     ADD_ALL_TESTS(test_rsa_sslv23, 3);
     ADD_ALL_TESTS(test_rsa_oaep, 3);
+    ADD_TEST(test_rsa_keygen_worker_pool);
     return 1;
 }
 #endif
@@ -175,9 +175,59 @@ err:
 #endif
 }
 
+/*
+ * A heap this size is split into a shared arena and per-thread arenas;
+ * all of it must stay reachable from a single thread.
+ */
+static int test_sec_mem_arenas(void)
+{
+#ifdef OPENSSL_SECURE_MEMORY
+    const size_t heap = 1 << 20, block = 32768;
+    char *p[(1 << 20) / 32768], *big = NULL;
+    size_t i, n = 0;
+    int res = 0;
+
+    if (!TEST_true(CRYPTO_secure_malloc_init(heap, 16)))
+        return 0;
+
+    /* larger than a thread arena: served by the shared arena */
+    if (!TEST_ptr(big = OPENSSL_secure_malloc(heap / 4))
+            || !TEST_true(CRYPTO_secure_allocated(big))
+            || !TEST_size_t_eq(CRYPTO_secure_actual_size(big), heap / 4)
+            || !TEST_ptr_null(OPENSSL_secure_malloc(heap / 2 + 1)))
+        goto err;
+    OPENSSL_secure_free(big);
+    big = NULL;
+
+    /* falls back to every other arena once its own is full */
+    for (n = 0; n < OSSL_NELEM(p); n++)
+        if (!TEST_ptr(p[n] = OPENSSL_secure_malloc(block))
+                || !TEST_true(CRYPTO_secure_allocated(p[n])))
+            goto err;
+    if (!TEST_size_t_eq(CRYPTO_secure_used(), heap)
+            || !TEST_ptr_null(big = OPENSSL_secure_malloc(16)))
+        goto err;
+    for (i = 1; i < n; i++)
+        if (!TEST_ptr_ne(p[i], p[i - 1]))
+            goto err;
+    res = 1;
+err:
+    while (n > 0)
+        OPENSSL_secure_free(p[--n]);
+    OPENSSL_secure_free(big);
+    if (!TEST_size_t_eq(CRYPTO_secure_used(), 0)
+            || !TEST_true(CRYPTO_secure_malloc_done()))
+        res = 0;
+    return res;
+#else
+    return 1;
+#endif
+}
+
 int setup_tests(void)
 {
     ADD_TEST(test_sec_mem);
     ADD_TEST(test_sec_mem_clear);
+    ADD_TEST(test_sec_mem_arenas);
     return 1;
 }
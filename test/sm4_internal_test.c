@@ -75,12 +75,63 @@ static int test_sm4_ecb(void)
 
     return 1;
 }
+
+/* The multi-block modes must agree with the single block functions */
+static int test_sm4_blocks(int idx)
+{
+    static const uint8_t k[SM4_BLOCK_SIZE] = {
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+        0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10
+    };
+    /* The counter wraps in the middle of the data */
+    static const uint8_t iv[SM4_BLOCK_SIZE] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+        0x08, 0x09, 0x0a, 0x0b, 0xff, 0xff, 0xff, 0xfd
+    };
+    size_t blocks = 1 + idx;
+    uint8_t in[9 * SM4_BLOCK_SIZE], out[9 * SM4_BLOCK_SIZE];
+    uint8_t expected[9 * SM4_BLOCK_SIZE], ctr[SM4_BLOCK_SIZE];
+    uint8_t ivec[SM4_BLOCK_SIZE], block[SM4_BLOCK_SIZE];
+    SM4_KEY key;
+    size_t i, j;
+
+    SM4_set_key(k, &key);
+    for (i = 0; i < sizeof(in); i++)
+        in[i] = (uint8_t)(i * 7);
+
+    memcpy(ctr, iv, sizeof(ctr));
+    for (i = 0; i < blocks; i++) {
+        SM4_encrypt(ctr, block, &key);
+        for (j = 0; j < SM4_BLOCK_SIZE; j++)
+            expected[16 * i + j] = in[16 * i + j] ^ block[j];
+        for (j = SM4_BLOCK_SIZE; j-- > 12 && ++ctr[j] == 0; )
+            continue;
+    }
+    SM4_ctr32_encrypt_blocks(in, out, blocks, &key, iv);
+    if (!TEST_mem_eq(out, 16 * blocks, expected, 16 * blocks))
+        return 0;
+
+    memcpy(block, iv, sizeof(block));
+    for (i = 0; i < blocks; i++) {
+        SM4_decrypt(in + 16 * i, expected + 16 * i, &key);
+        for (j = 0; j < SM4_BLOCK_SIZE; j++)
+            expected[16 * i + j] ^= block[j];
+        memcpy(block, in + 16 * i, SM4_BLOCK_SIZE);
+    }
+    /* In place, and the IV is updated to the last ciphertext block */
+    memcpy(out, in, sizeof(out));
+    memcpy(ivec, iv, sizeof(ivec));
+    SM4_cbc_decrypt_blocks(out, out, blocks, &key, ivec);
+    return TEST_mem_eq(out, 16 * blocks, expected, 16 * blocks)
+           && TEST_mem_eq(ivec, sizeof(ivec), block, sizeof(block));
+}
 #endif
 
 int setup_tests(void)
 {
 #ifndef OPENSSL_NO_SM4
     ADD_TEST(test_sm4_ecb);
+    ADD_ALL_TESTS(test_sm4_blocks, 9);
 #endif
     return 1;
 }
@@ -25,6 +25,14 @@
 #include "internal/nelem.h"
 #include "../ssl/ssl_local.h"
 
+#if (!defined(OPENSSL_NO_KTLS) || defined(OPENSSL_SYS_LINUX)) \
+    && !defined(OPENSSL_NO_SOCK)
+# include <unistd.h>
+#endif
+#if defined(OPENSSL_THREADS) && !defined(OPENSSL_SYS_WINDOWS)
+# include <sys/select.h>
+#endif
+
 #ifndef OPENSSL_NO_TLS1_3
 
 static SSL_SESSION *clientpsk = NULL;
@@ -1120,8 +1128,346 @@ static int test_tlsext_status_type(void)
 
     return testresult;
 }
+
+static unsigned char *staple_der = NULL;
+static int staple_der_len = 0;
+static int staple_received = 0;
+
+static int staple_client_cb(SSL *s, void *arg)
+{
+    const unsigned char *respderin;
+    long len = SSL_get_tlsext_status_ocsp_resp(s, &respderin);
+
+    /* Called with no response too; only count what was actually stapled */
+    if (len <= 0)
+        return 1;
+    staple_received = 1;
+    return TEST_mem_eq(staple_der, staple_der_len, respderin, len);
+}
+
+/* Sign a response for our own certificate, good until |valid| from now */
+static int make_staple(long valid)
+{
+    BIO *certbio = NULL, *keybio = NULL;
+    X509 *x = NULL;
+    EVP_PKEY *pkey = NULL;
+    OCSP_CERTID *id = NULL;
+    OCSP_BASICRESP *bs = NULL;
+    OCSP_RESPONSE *resp = NULL;
+    ASN1_TIME *thisupd = NULL, *nextupd = NULL;
+    int ret = 0;
+
+    OPENSSL_free(staple_der);
+    staple_der = NULL;
+    if (!TEST_ptr(certbio = BIO_new_file(cert, "r"))
+            || !TEST_ptr(keybio = BIO_new_file(privkey, "r"))
+            || !TEST_ptr(x = PEM_read_bio_X509(certbio, NULL, NULL, NULL))
+            || !TEST_ptr(pkey = PEM_read_bio_PrivateKey(keybio, NULL, NULL,
+                                                        NULL))
+            || !TEST_ptr(id = OCSP_cert_to_id(NULL, x, x))
+            || !TEST_ptr(bs = OCSP_BASICRESP_new())
+            || !TEST_ptr(thisupd = X509_gmtime_adj(NULL, valid - 60))
+            || !TEST_ptr(nextupd = X509_gmtime_adj(NULL, valid))
+            || !TEST_ptr(OCSP_basic_add1_status(bs, id,
+                                                V_OCSP_CERTSTATUS_GOOD, 0,
+                                                NULL, thisupd, nextupd))
+            || !TEST_true(OCSP_basic_sign(bs, x, pkey, EVP_sha256(), NULL, 0))
+            || !TEST_ptr(resp = OCSP_response_create(
+                                    OCSP_RESPONSE_STATUS_SUCCESSFUL, bs))
+            || !TEST_int_gt(staple_der_len = i2d_OCSP_RESPONSE(resp,
+                                                               &staple_der),
+                            0))
+        goto end;
+    ret = 1;
+
+ end:
+    ASN1_TIME_free(thisupd);
+    ASN1_TIME_free(nextupd);
+    OCSP_RESPONSE_free(resp);
+    OCSP_BASICRESP_free(bs);
+    OCSP_CERTID_free(id);
+    EVP_PKEY_free(pkey);
+    X509_free(x);
+    BIO_free(certbio);
+    BIO_free(keybio);
+    return ret;
+}
+
+/*
+ * Test SSL_CTX_set1_ocsp_staple()
+ * Test 0: A current response is stapled
+ * Test 1: An expired response is refused
+ * Test 2: A cleared response is not stapled
+ */
+static int test_ocsp_staple(int tst)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int testresult = 0;
+
+    staple_received = 0;
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(),
+                                       TLS1_VERSION, TLS_MAX_VERSION,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_true(make_staple(tst == 1 ? -3600 : 3600)))
+        goto end;
+
+    if (tst == 1) {
+        if (!TEST_false(SSL_CTX_set1_ocsp_staple(sctx, staple_der,
+                                                 staple_der_len)))
+            goto end;
+        testresult = 1;
+        goto end;
+    }
+    if (!TEST_true(SSL_CTX_set1_ocsp_staple(sctx, staple_der,
+                                            staple_der_len))
+            || (tst == 2
+                && !TEST_true(SSL_CTX_set1_ocsp_staple(sctx, NULL, 0)))
+            || !TEST_true(SSL_CTX_set_tlsext_status_type(cctx,
+                                                     TLSEXT_STATUSTYPE_ocsp)))
+        goto end;
+    SSL_CTX_set_tlsext_status_cb(cctx, staple_client_cb);
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_int_eq(staple_received, tst == 0))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    OPENSSL_free(staple_der);
+    staple_der = NULL;
+    return testresult;
+}
+
+/* A response with |status| for our certificate, signed by its issuer */
+static int make_issuer_staple(X509 *x, X509 *issuer, EVP_PKEY *issuerkey,
+                              int status)
+{
+    OCSP_CERTID *id = NULL;
+    OCSP_BASICRESP *bs = NULL;
+    OCSP_RESPONSE *resp = NULL;
+    ASN1_TIME *thisupd = NULL, *nextupd = NULL;
+    int ret = 0;
+
+    OPENSSL_free(staple_der);
+    staple_der = NULL;
+    if (!TEST_ptr(id = OCSP_cert_to_id(NULL, x, issuer))
+            || !TEST_ptr(bs = OCSP_BASICRESP_new())
+            || !TEST_ptr(thisupd = X509_gmtime_adj(NULL, -60))
+            || !TEST_ptr(nextupd = X509_gmtime_adj(NULL, 3600))
+            || !TEST_ptr(OCSP_basic_add1_status(bs, id, status,
+                                                OCSP_REVOKED_STATUS_NOSTATUS,
+                                                thisupd, thisupd, nextupd))
+            || !TEST_true(OCSP_basic_sign(bs, issuer, issuerkey, EVP_sha256(),
+                                          NULL, 0))
+            || !TEST_ptr(resp = OCSP_response_create(
+                                    OCSP_RESPONSE_STATUS_SUCCESSFUL, bs))
+            || !TEST_int_gt(staple_der_len = i2d_OCSP_RESPONSE(resp,
+                                                               &staple_der),
+                            0))
+        goto end;
+    ret = 1;
+
+ end:
+    ASN1_TIME_free(thisupd);
+    ASN1_TIME_free(nextupd);
+    OCSP_RESPONSE_free(resp);
+    OCSP_BASICRESP_free(bs);
+    OCSP_CERTID_free(id);
+    return ret;
+}
+
+static int staple_check_result;
+
+static int staple_check_cb(SSL *s, void *arg)
+{
+    staple_check_result = SSL_check_ocsp_staple(s);
+    return 1;
+}
+
+static int staple_check_connect(SSL_CTX *sctx, SSL_CTX *cctx)
+{
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int ret;
+
+    staple_check_result = -2;
+    ret = TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                       NULL, NULL))
+          && TEST_true(create_ssl_connection(serverssl, clientssl,
+                                             SSL_ERROR_NONE));
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    return ret;
+}
+
+/*
+ * Test SSL_check_ocsp_staple(), and that with a verify cache the signature
+ * of a response is only checked the first time: once it is cached, the
+ * response is accepted even when the trust store no longer has its signer.
+ */
+static int test_ocsp_verify_cache(void)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    X509_STORE *empty = NULL;
+    BIO *bio = NULL;
+    X509 *x = NULL, *root = NULL;
+    EVP_PKEY *rootkey = NULL;
+    char *rootfile = NULL, *rootkeyfile = NULL;
+    int testresult = 0;
+
+    if (!TEST_ptr(rootfile = test_mk_file_path(certsdir, "rootcert.pem"))
+            || !TEST_ptr(rootkeyfile = test_mk_file_path(certsdir,
+                                                         "rootkey.pem"))
+            || !TEST_ptr(bio = BIO_new_file(rootfile, "r"))
+            || !TEST_ptr(root = PEM_read_bio_X509(bio, NULL, NULL, NULL)))
+        goto end;
+    BIO_free(bio);
+    if (!TEST_ptr(bio = BIO_new_file(rootkeyfile, "r"))
+            || !TEST_ptr(rootkey = PEM_read_bio_PrivateKey(bio, NULL, NULL,
+                                                           NULL)))
+        goto end;
+    BIO_free(bio);
+    if (!TEST_ptr(bio = BIO_new_file(cert, "r"))
+            || !TEST_ptr(x = PEM_read_bio_X509(bio, NULL, NULL, NULL))
+            || !TEST_ptr(empty = X509_STORE_new()))
+        goto end;
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(),
+                                       TLS1_VERSION, TLS_MAX_VERSION,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_true(SSL_CTX_add1_chain_cert(sctx, root))
+            || !TEST_true(make_issuer_staple(x, root, rootkey,
+                                             V_OCSP_CERTSTATUS_GOOD))
+            || !TEST_true(SSL_CTX_set1_ocsp_staple(sctx, staple_der,
+                                                   staple_der_len))
+            || !TEST_true(SSL_CTX_load_verify_locations(cctx, rootfile, NULL))
+            || !TEST_true(SSL_CTX_set_tlsext_status_type(cctx,
+                                                     TLSEXT_STATUSTYPE_ocsp))
+            || !TEST_size_t_eq(SSL_CTX_get_ocsp_verify_cache_size(cctx), 0)
+            || !TEST_true(SSL_CTX_set_ocsp_verify_cache_size(cctx, 16))
+            || !TEST_size_t_eq(SSL_CTX_get_ocsp_verify_cache_size(cctx), 16))
+        goto end;
+    SSL_CTX_set_tlsext_status_cb(cctx, staple_check_cb);
+
+    if (!TEST_true(staple_check_connect(sctx, cctx))
+            || !TEST_int_eq(staple_check_result, 1))
+        goto end;
+
+    /* The cached response no longer needs the signer to be trusted */
+    if (!TEST_true(SSL_CTX_set1_verify_cert_store(cctx, empty))
+            || !TEST_true(staple_check_connect(sctx, cctx))
+            || !TEST_int_eq(staple_check_result, 1))
+        goto end;
+
+    /* But without the cache it does */
+    if (!TEST_true(SSL_CTX_set_ocsp_verify_cache_size(cctx, 0))
+            || !TEST_true(staple_check_connect(sctx, cctx))
+            || !TEST_int_eq(staple_check_result, 0))
+        goto end;
+
+    /* A revoked certificate is rejected, cached signature or not */
+    if (!TEST_true(SSL_CTX_set1_verify_cert_store(cctx, NULL))
+            || !TEST_true(SSL_CTX_set_ocsp_verify_cache_size(cctx, 16))
+            || !TEST_true(make_issuer_staple(x, root, rootkey,
+                                             V_OCSP_CERTSTATUS_REVOKED))
+            || !TEST_true(SSL_CTX_set1_ocsp_staple(sctx, staple_der,
+                                                   staple_der_len))
+            || !TEST_true(staple_check_connect(sctx, cctx))
+            || !TEST_int_eq(staple_check_result, 0)
+            || !TEST_true(staple_check_connect(sctx, cctx))
+            || !TEST_int_eq(staple_check_result, 0))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    X509_STORE_free(empty);
+    X509_free(x);
+    X509_free(root);
+    EVP_PKEY_free(rootkey);
+    BIO_free(bio);
+    OPENSSL_free(rootfile);
+    OPENSSL_free(rootkeyfile);
+    OPENSSL_free(staple_der);
+    staple_der = NULL;
+    return testresult;
+}
 #endif
 
+/*
+ * Test that a handshake whose server chain comes from the client's chain
+ * cache still reports the name that matched.
+ */
+static int test_chain_cache_peername(void)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    char *rootfile = NULL;
+    int testresult = 0, i;
+
+    if (!TEST_ptr(rootfile = test_mk_file_path(certsdir, "rootcert.pem"))
+            || !TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                              TLS_client_method(),
+                                              TLS1_VERSION, TLS_MAX_VERSION,
+                                              &sctx, &cctx, cert, privkey))
+            || !TEST_true(SSL_CTX_load_verify_locations(cctx, rootfile, NULL))
+            || !TEST_true(X509_STORE_set_chain_cache(
+                              SSL_CTX_get_cert_store(cctx), 8, 300)))
+        goto end;
+    SSL_CTX_set_verify(cctx, SSL_VERIFY_PEER, NULL);
+
+    /* The second handshake verifies the server from the cache */
+    for (i = 0; i < 2; i++) {
+        if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                          NULL, NULL))
+                || !TEST_true(SSL_set1_host(clientssl, "server.example"))
+                || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                    SSL_ERROR_NONE))
+                || !TEST_long_eq(SSL_get_verify_result(clientssl), X509_V_OK)
+                || !TEST_ptr(SSL_get0_peername(clientssl))
+                || !TEST_str_eq(SSL_get0_peername(clientssl),
+                                "server.example"))
+            goto end;
+        SSL_shutdown(clientssl);
+        SSL_shutdown(serverssl);
+        SSL_free(serverssl);
+        SSL_free(clientssl);
+        serverssl = clientssl = NULL;
+    }
+
+    /* A name the certificate does not have still fails on a hit */
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(SSL_set1_host(clientssl, "other.example"))
+            || !TEST_false(create_ssl_connection(serverssl, clientssl,
+                                                 SSL_ERROR_NONE))
+            || !TEST_long_eq(SSL_get_verify_result(clientssl),
+                             X509_V_ERR_HOSTNAME_MISMATCH))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    OPENSSL_free(rootfile);
+    return testresult;
+}
+
 #if !defined(OPENSSL_NO_TLS1_3) || !defined(OPENSSL_NO_TLS1_2)
 static int new_called, remove_called, get_called;
 
@@ -1478,76 +1824,489 @@ static int test_session_with_both_cache(void)
 #endif
 }
 
-#ifndef OPENSSL_NO_TLS1_3
-static SSL_SESSION *sesscache[6];
-static int do_cache;
-
-static int new_cachesession_cb(SSL *ssl, SSL_SESSION *sess)
+#ifndef OPENSSL_NO_TLS1_2
+/*
+ * Test resumption and the cache size limit with an internal session cache
+ * split into shards
+ */
+static int test_session_cache_shards(void)
 {
-    if (do_cache) {
-        sesscache[new_called] = sess;
-    } else {
-        /* We don't need the reference to the session, so free it */
-        SSL_SESSION_free(sess);
-    }
-    new_called++;
+    SSL_CTX *sctx = NULL, *cctx = NULL;
+    SSL *serverssl = NULL, *clientssl = NULL;
+    SSL_SESSION *sess = NULL, *clntsess = NULL;
+    unsigned char id[SSL_MAX_SSL_SESSION_ID_LENGTH];
+    int testresult = 0, i;
 
-    return 1;
-}
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(), TLS1_VERSION,
+                                       TLS1_2_VERSION, &sctx, &cctx, cert,
+                                       privkey)))
+        goto end;
+    SSL_CTX_set_options(sctx, SSL_OP_NO_TICKET);
 
-static int post_handshake_verify(SSL *sssl, SSL *cssl)
-{
-    SSL_set_verify(sssl, SSL_VERIFY_PEER, NULL);
-    if (!TEST_true(SSL_verify_client_post_handshake(sssl)))
-        return 0;
+    if (!TEST_long_eq(SSL_CTX_sess_get_cache_shards(sctx), 1)
+            || !TEST_false(SSL_CTX_sess_set_cache_shards(sctx, 0))
+            || !TEST_true(SSL_CTX_sess_set_cache_shards(sctx, 8))
+            || !TEST_long_eq(SSL_CTX_sess_get_cache_shards(sctx), 8))
+        goto end;
 
-    /* Start handshake on the server and client */
-    if (!TEST_int_eq(SSL_do_handshake(sssl), 1)
-            || !TEST_int_le(SSL_read(cssl, NULL, 0), 0)
-            || !TEST_int_le(SSL_read(sssl, NULL, 0), 0)
-            || !TEST_true(create_ssl_connection(sssl, cssl,
-                                                SSL_ERROR_NONE)))
-        return 0;
+    /* Each shard keeps its share of the sessions */
+    SSL_CTX_sess_set_cache_size(sctx, 16);
+    memset(id, 0, sizeof(id));
+    for (i = 0; i < 64; i++) {
+        id[0] = (unsigned char)i;
+        id[1] = (unsigned char)(i * 37);
+        if (!TEST_ptr(sess = SSL_SESSION_new())
+                || !TEST_true(SSL_SESSION_set1_id(sess, id, sizeof(id)))
+                || !TEST_true(SSL_CTX_add_session(sctx, sess)))
+            goto end;
+        SSL_SESSION_free(sess);
+        sess = NULL;
+    }
+    if (!TEST_long_gt(SSL_CTX_sess_number(sctx), 0)
+            || !TEST_long_le(SSL_CTX_sess_number(sctx), 16)
+            || !TEST_false(SSL_CTX_sess_set_cache_shards(sctx, 4)))
+        goto end;
 
-    return 1;
-}
+    /* Resume a session through the sharded cache */
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_ptr(clntsess = SSL_get1_session(clientssl)))
+        goto end;
+    shutdown_ssl_connection(serverssl, clientssl);
+    serverssl = clientssl = NULL;
 
-static int setup_ticket_test(int stateful, int idx, SSL_CTX **sctx,
-                             SSL_CTX **cctx)
-{
-    int sess_id_ctx = 1;
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(SSL_set_session(clientssl, clntsess))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_true(SSL_session_reused(clientssl)))
+        goto end;
 
-    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(), TLS_client_method(),
-                                       TLS1_VERSION, TLS_MAX_VERSION, sctx,
-                                       cctx, cert, privkey))
-            || !TEST_true(SSL_CTX_set_num_tickets(*sctx, idx))
-            || !TEST_true(SSL_CTX_set_session_id_context(*sctx,
-                                                         (void *)&sess_id_ctx,
-                                                         sizeof(sess_id_ctx))))
-        return 0;
+    /* Once the cache is empty again the number of shards can change */
+    SSL_CTX_flush_sessions(sctx, 0);
+    if (!TEST_long_eq(SSL_CTX_sess_number(sctx), 0)
+            || !TEST_true(SSL_CTX_sess_set_cache_shards(sctx, 4)))
+        goto end;
 
-    if (stateful)
-        SSL_CTX_set_options(*sctx, SSL_OP_NO_TICKET);
+    testresult = 1;
 
-    SSL_CTX_set_session_cache_mode(*cctx, SSL_SESS_CACHE_CLIENT
-                                          | SSL_SESS_CACHE_NO_INTERNAL_STORE);
-    SSL_CTX_sess_set_new_cb(*cctx, new_cachesession_cb);
+ end:
+    SSL_SESSION_free(sess);
+    SSL_SESSION_free(clntsess);
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
 
-    return 1;
+    return testresult;
 }
+#endif
 
-static int check_resumption(int idx, SSL_CTX *sctx, SSL_CTX *cctx, int succ)
+/*
+ * Test that SSL_CTX_flush_expired_sessions() removes expired sessions in
+ * steps, whatever order they were added in
+ * Test 0: One shard
+ * Test 1: Four shards
+ */
+static int test_session_cache_flush_expired(int tst)
 {
-    SSL *serverssl = NULL, *clientssl = NULL;
-    int i;
+    SSL_CTX *ctx = NULL;
+    SSL_SESSION *sess = NULL;
+    static const long timeouts[] = { 50, 10, 100, 30, 70, 20, 90, 40, 80, 60 };
+    unsigned char id[SSL_MAX_SSL_SESSION_ID_LENGTH];
+    int testresult = 0, ret;
+    size_t i;
 
-    /* Test that we can resume with all the tickets we got given */
-    for (i = 0; i < idx * 2; i++) {
-        new_called = 0;
-        if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl,
-                                              &clientssl, NULL, NULL))
-                || !TEST_true(SSL_set_session(clientssl, sesscache[i])))
-            goto end;
+    if (!TEST_ptr(ctx = SSL_CTX_new(TLS_server_method()))
+            || !TEST_true(SSL_CTX_sess_set_cache_shards(ctx, tst == 0 ? 1 : 4)))
+        goto end;
+
+    memset(id, 0, sizeof(id));
+    for (i = 0; i < OSSL_NELEM(timeouts); i++) {
+        id[0] = (unsigned char)i;
+        if (!TEST_ptr(sess = SSL_SESSION_new())
+                || !TEST_true(SSL_SESSION_set1_id(sess, id, sizeof(id)))
+                || !TEST_long_eq(SSL_SESSION_set_time(sess, 1000), 1000)
+                || !TEST_long_eq(SSL_SESSION_set_timeout(sess, timeouts[i]), 1)
+                || !TEST_true(SSL_CTX_add_session(ctx, sess)))
+            goto end;
+        SSL_SESSION_free(sess);
+        sess = NULL;
+    }
+
+    /* The five sessions with a timeout below 55 seconds expire */
+    for (i = 0; i < 10; i++) {
+        ret = SSL_CTX_flush_expired_sessions(ctx, 1055, 2, 0);
+        if (ret)
+            break;
+    }
+    if (!TEST_true(ret)
+            || !TEST_size_t_ge(i, tst == 0 ? 2 : 1)
+            || !TEST_long_eq(SSL_CTX_sess_number(ctx), 5))
+        goto end;
+
+    /* The sessions left expire later and a time of 0 removes all */
+    if (!TEST_true(SSL_CTX_flush_expired_sessions(ctx, 1055, 0, 1000000))
+            || !TEST_long_eq(SSL_CTX_sess_number(ctx), 5)
+            || !TEST_true(SSL_CTX_flush_expired_sessions(ctx, 0, 0, 0))
+            || !TEST_long_eq(SSL_CTX_sess_number(ctx), 0))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_SESSION_free(sess);
+    SSL_CTX_free(ctx);
+
+    return testresult;
+}
+
+#ifndef OPENSSL_NO_TLS1_2
+static SSL_SESSION *async_cache_sess = NULL;
+static int async_cache_paused;
+
+static int async_cache_new_cb(SSL *ssl, SSL_SESSION *sess)
+{
+    if (!TEST_true(SSL_sess_cb_pause(ssl, OSSL_BAD_ASYNC_FD)))
+        return 0;
+    async_cache_paused++;
+    SSL_SESSION_free(async_cache_sess);
+    async_cache_sess = sess;
+
+    return 1;
+}
+
+static SSL_SESSION *async_cache_get_cb(SSL *ssl, const unsigned char *id,
+                                       int len, int *copy)
+{
+    if (!TEST_true(SSL_sess_cb_pause(ssl, OSSL_BAD_ASYNC_FD)))
+        return NULL;
+    async_cache_paused++;
+    *copy = 1;
+
+    return async_cache_sess;
+}
+
+/*
+ * Check that a server running in an ASYNC job can suspend the handshake from
+ * within its external session cache callbacks
+ */
+static int test_session_cache_async(void)
+{
+    SSL_CTX *sctx = NULL, *cctx = NULL;
+    SSL *serverssl = NULL, *clientssl = NULL;
+    SSL_SESSION *clntsess = NULL;
+    OSSL_ASYNC_FD fd;
+    size_t numfds;
+    int testresult = 0, i;
+
+    if (!ASYNC_is_capable()) {
+        TEST_info("Skipping: ASYNC is not supported on this platform.");
+        return 1;
+    }
+
+    async_cache_paused = 0;
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(), TLS_client_method(),
+                                       TLS1_VERSION, TLS1_2_VERSION,
+                                       &sctx, &cctx, cert, privkey)))
+        goto end;
+
+    SSL_CTX_set_options(sctx, SSL_OP_NO_TICKET);
+    SSL_CTX_set_mode(sctx, SSL_MODE_ASYNC);
+    SSL_CTX_set_session_cache_mode(sctx, SSL_SESS_CACHE_SERVER
+                                         | SSL_SESS_CACHE_NO_INTERNAL);
+    SSL_CTX_sess_set_new_cb(sctx, async_cache_new_cb);
+    SSL_CTX_sess_set_get_cb(sctx, async_cache_get_cb);
+
+    /* The first handshake stores the session, the second one looks it up */
+    for (i = 0; i < 2; i++) {
+        if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                          NULL, NULL))
+                || (clntsess != NULL
+                    && !TEST_true(SSL_set_session(clientssl, clntsess)))
+                || !TEST_false(create_ssl_connection(serverssl, clientssl,
+                                                     SSL_ERROR_WANT_ASYNC))
+                || !TEST_int_eq(SSL_get_error(serverssl, 0),
+                                SSL_ERROR_WANT_ASYNC)
+                || !TEST_int_eq(async_cache_paused, i)
+                || !TEST_true(SSL_get_all_async_fds(serverssl, NULL, &numfds))
+                || !TEST_size_t_eq(numfds, 1)
+                || !TEST_true(SSL_get_all_async_fds(serverssl, &fd, &numfds))
+                || !TEST_true(fd == OSSL_BAD_ASYNC_FD)
+                || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                    SSL_ERROR_NONE))
+                || !TEST_int_eq(async_cache_paused, i + 1)
+                || !TEST_true(SSL_get_all_async_fds(serverssl, NULL, &numfds))
+                || !TEST_size_t_eq(numfds, 0)
+                || !TEST_int_eq(SSL_session_reused(clientssl), i))
+            goto end;
+
+        if (i == 0 && !TEST_ptr(clntsess = SSL_get1_session(clientssl)))
+            goto end;
+        shutdown_ssl_connection(serverssl, clientssl);
+        serverssl = clientssl = NULL;
+    }
+
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_SESSION_free(clntsess);
+    SSL_SESSION_free(async_cache_sess);
+    async_cache_sess = NULL;
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+#endif
+
+/*
+ * Test that sessions decode to what they were encoded from, through the fast
+ * path of d2i_SSL_SESSION() for DER and through the template decoder for BER.
+ */
+static int test_session_asn1(void)
+{
+    SSL_CTX *sctx = NULL, *cctx = NULL;
+    SSL *serverssl = NULL, *clientssl = NULL;
+    SSL_SESSION *sess = NULL, *sess2 = NULL;
+    unsigned char *der = NULL, *der2 = NULL, *ber = NULL;
+    const unsigned char *p;
+    int derlen, der2len, berlen, hdrlen, testresult = 0;
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(), TLS_client_method(),
+                                       TLS1_VERSION, 0,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                             NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_ptr(sess = SSL_get1_session(clientssl))
+            || !TEST_ptr(SSL_SESSION_get0_peer(sess))
+            || !TEST_int_gt(derlen = i2d_SSL_SESSION(sess, &der), 0))
+        goto end;
+
+    p = der;
+    if (!TEST_ptr(sess2 = d2i_SSL_SESSION(NULL, &p, derlen))
+            || !TEST_ptr_eq(p, der + derlen)
+            || !TEST_int_gt(der2len = i2d_SSL_SESSION(sess2, &der2), 0)
+            || !TEST_mem_eq(der, derlen, der2, der2len))
+        goto end;
+    SSL_SESSION_free(sess2);
+    sess2 = NULL;
+    OPENSSL_free(der2);
+    der2 = NULL;
+
+    /* The same with an indefinite length for the outer SEQUENCE */
+    hdrlen = 2 + ((der[1] & 0x80) != 0 ? der[1] & 0x7f : 0);
+    berlen = derlen - hdrlen + 4;
+    if (!TEST_ptr(ber = OPENSSL_malloc(berlen)))
+        goto end;
+    ber[0] = der[0];
+    ber[1] = 0x80;
+    memcpy(ber + 2, der + hdrlen, derlen - hdrlen);
+    ber[berlen - 2] = ber[berlen - 1] = 0;
+    p = ber;
+    if (!TEST_ptr(sess2 = d2i_SSL_SESSION(NULL, &p, berlen))
+            || !TEST_ptr_eq(p, ber + berlen)
+            || !TEST_int_gt(der2len = i2d_SSL_SESSION(sess2, &der2), 0)
+            || !TEST_mem_eq(der, derlen, der2, der2len))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    OPENSSL_free(der);
+    OPENSSL_free(der2);
+    OPENSSL_free(ber);
+    SSL_SESSION_free(sess);
+    SSL_SESSION_free(sess2);
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+
+/*
+ * Test that sessions survive the compact format with everything the ASN.1
+ * format has, and that the peer certificate can be left out for its digest
+ * while it is in the intern table.
+ */
+static int test_session_compact(void)
+{
+    SSL_CTX *sctx = NULL, *cctx = NULL;
+    SSL *serverssl = NULL, *clientssl = NULL;
+    SSL_SESSION *sess = NULL, *sess2 = NULL;
+    unsigned char *der = NULL, *der2 = NULL, *enc = NULL, *enc2 = NULL;
+    unsigned char *digenc = NULL;
+    const unsigned char *p;
+    int derlen, der2len, enclen, enc2len, digenclen, testresult = 0;
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(), TLS_client_method(),
+                                       TLS1_VERSION, 0,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                             NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_ptr(sess = SSL_get1_session(clientssl))
+            || !TEST_ptr(SSL_SESSION_get0_peer(sess))
+            || !TEST_int_gt(derlen = i2d_SSL_SESSION(sess, &der), 0)
+            || !TEST_int_gt(enclen = i2d_SSL_SESSION_compact(sess, &enc, 0), 0))
+        goto end;
+
+    p = enc;
+    if (!TEST_ptr(sess2 = d2i_SSL_SESSION_compact(NULL, &p, enclen))
+            || !TEST_ptr_eq(p, enc + enclen)
+            || !TEST_int_gt(der2len = i2d_SSL_SESSION(sess2, &der2), 0)
+            || !TEST_mem_eq(der, derlen, der2, der2len)
+            || !TEST_int_eq(i2d_SSL_SESSION_compact(sess2, NULL, 0), enclen))
+        goto end;
+    SSL_SESSION_free(sess2);
+    sess2 = NULL;
+
+    /* Truncated and DER input are rejected */
+    p = enc;
+    if (!TEST_ptr_null(d2i_SSL_SESSION_compact(NULL, &p, enclen - 1))
+            || !TEST_ptr_eq(p, enc))
+        goto end;
+    p = der;
+    if (!TEST_ptr_null(d2i_SSL_SESSION_compact(NULL, &p, derlen)))
+        goto end;
+
+    /* Without interning the certificate is written in full regardless */
+    if (!TEST_int_eq(enc2len = i2d_SSL_SESSION_compact(sess, &enc2,
+                                         SSL_SESSION_COMPACT_PEER_DIGEST),
+                     enclen)
+            || !TEST_mem_eq(enc, enclen, enc2, enc2len))
+        goto end;
+
+    X509_intern_enable(1);
+    if (!TEST_int_gt(digenclen = i2d_SSL_SESSION_compact(sess, &digenc,
+                                         SSL_SESSION_COMPACT_PEER_DIGEST), 0)
+            || !TEST_int_lt(digenclen, enclen - 200))
+        goto end;
+    p = digenc;
+    if (!TEST_ptr(sess2 = d2i_SSL_SESSION_compact(NULL, &p, digenclen))
+            || !TEST_ptr_eq(p, digenc + digenclen)
+            || !TEST_int_eq(X509_cmp(SSL_SESSION_get0_peer(sess),
+                                     SSL_SESSION_get0_peer(sess2)), 0))
+        goto end;
+    OPENSSL_free(der2);
+    der2 = NULL;
+    if (!TEST_int_gt(der2len = i2d_SSL_SESSION(sess2, &der2), 0)
+            || !TEST_mem_eq(der, derlen, der2, der2len))
+        goto end;
+
+    /* Once nothing else holds the certificate it cannot be found */
+    SSL_SESSION_free(sess);
+    SSL_SESSION_free(sess2);
+    sess = sess2 = NULL;
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    serverssl = clientssl = NULL;
+    X509_intern_flush();
+    p = digenc;
+    if (!TEST_ptr_null(d2i_SSL_SESSION_compact(NULL, &p, digenclen)))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    X509_intern_enable(0);
+    X509_intern_flush();
+    OPENSSL_free(der);
+    OPENSSL_free(der2);
+    OPENSSL_free(enc);
+    OPENSSL_free(enc2);
+    OPENSSL_free(digenc);
+    SSL_SESSION_free(sess);
+    SSL_SESSION_free(sess2);
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+
+#ifndef OPENSSL_NO_TLS1_3
+static SSL_SESSION *sesscache[6];
+static int do_cache;
+
+static int new_cachesession_cb(SSL *ssl, SSL_SESSION *sess)
+{
+    if (do_cache) {
+        sesscache[new_called] = sess;
+    } else {
+        /* We don't need the reference to the session, so free it */
+        SSL_SESSION_free(sess);
+    }
+    new_called++;
+
+    return 1;
+}
+
+static int post_handshake_verify(SSL *sssl, SSL *cssl)
+{
+    SSL_set_verify(sssl, SSL_VERIFY_PEER, NULL);
+    if (!TEST_true(SSL_verify_client_post_handshake(sssl)))
+        return 0;
+
+    /* Start handshake on the server and client */
+    if (!TEST_int_eq(SSL_do_handshake(sssl), 1)
+            || !TEST_int_le(SSL_read(cssl, NULL, 0), 0)
+            || !TEST_int_le(SSL_read(sssl, NULL, 0), 0)
+            || !TEST_true(create_ssl_connection(sssl, cssl,
+                                                SSL_ERROR_NONE)))
+        return 0;
+
+    return 1;
+}
+
+static int setup_ticket_test(int stateful, int idx, SSL_CTX **sctx,
+                             SSL_CTX **cctx)
+{
+    int sess_id_ctx = 1;
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(), TLS_client_method(),
+                                       TLS1_VERSION, TLS_MAX_VERSION, sctx,
+                                       cctx, cert, privkey))
+            || !TEST_true(SSL_CTX_set_num_tickets(*sctx, idx))
+            || !TEST_true(SSL_CTX_set_session_id_context(*sctx,
+                                                         (void *)&sess_id_ctx,
+                                                         sizeof(sess_id_ctx))))
+        return 0;
+
+    if (stateful)
+        SSL_CTX_set_options(*sctx, SSL_OP_NO_TICKET);
+
+    SSL_CTX_set_session_cache_mode(*cctx, SSL_SESS_CACHE_CLIENT
+                                          | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(*cctx, new_cachesession_cb);
+
+    return 1;
+}
+
+static int check_resumption(int idx, SSL_CTX *sctx, SSL_CTX *cctx, int succ)
+{
+    SSL *serverssl = NULL, *clientssl = NULL;
+    int i;
+
+    /* Test that we can resume with all the tickets we got given */
+    for (i = 0; i < idx * 2; i++) {
+        new_called = 0;
+        if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl,
+                                              &clientssl, NULL, NULL))
+                || !TEST_true(SSL_set_session(clientssl, sesscache[i])))
+            goto end;
 
         SSL_set_post_handshake_auth(clientssl, 1);
 
@@ -2757,37 +3516,155 @@ static int test_early_data_replay(int idx)
 }
 
 /*
- * Helper function to test that a server attempting to read early data can
- * handle a connection from a client where the early data should be skipped.
- * testtype: 0 == No HRR
- * testtype: 1 == HRR
- * testtype: 2 == HRR, invalid early_data sent after HRR
- * testtype: 3 == recv_max_early_data set to 0
+ * Test that a replay filter shared by two SSL_CTXs lets a ticket be used for
+ * early data more than once, but rejects the early data of a ClientHello
+ * replayed to the other SSL_CTX.
  */
-static int early_data_skip_helper(int testtype, int idx)
+static int test_replay_filter(void)
 {
-    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL_CTX *cctx = NULL, *sctx = NULL, *sctx2 = NULL;
     SSL *clientssl = NULL, *serverssl = NULL;
-    int testresult = 0;
+    SSL *clientssl2 = NULL, *serverssl2 = NULL;
+    SSL_REPLAY_FILTER *rf = NULL, *rf2 = NULL;
     SSL_SESSION *sess = NULL;
-    unsigned char buf[20];
-    size_t readbytes, written;
+    size_t len = SSL_REPLAY_FILTER_mem_size(1000);
+    unsigned char *mem = NULL, keys[80], buf[20], data[4096];
+    size_t readbytes, written, rawread, rawwritten;
+    int testresult = 0, i;
+
+    if (!TEST_size_t_gt(len, 0)
+            || !TEST_size_t_eq(SSL_REPLAY_FILTER_mem_size(0), 0)
+            || !TEST_ptr(mem = OPENSSL_zalloc(len))
+            || !TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                              TLS_client_method(),
+                                              TLS1_VERSION, TLS_MAX_VERSION,
+                                              &sctx, &cctx, cert, privkey))
+            || !TEST_ptr(sctx2 = SSL_CTX_new(TLS_server_method()))
+            || !TEST_int_eq(SSL_CTX_use_certificate_file(sctx2, cert,
+                                                         SSL_FILETYPE_PEM), 1)
+            || !TEST_int_eq(SSL_CTX_use_PrivateKey_file(sctx2, privkey,
+                                                        SSL_FILETYPE_PEM), 1)
+            || !TEST_true(SSL_CTX_set_max_early_data(sctx2,
+                                                     SSL3_RT_MAX_PLAIN_LENGTH))
+            || !TEST_long_gt(SSL_CTX_get_tlsext_ticket_keys(sctx, keys,
+                                                            sizeof(keys)), 0)
+            || !TEST_long_gt(SSL_CTX_set_tlsext_ticket_keys(sctx2, keys,
+                                                            sizeof(keys)), 0))
+        goto end;
+
+    /* The second "process" attaches to the memory the first initialised */
+    if (!TEST_ptr_null(SSL_REPLAY_FILTER_attach(mem, len))
+            || !TEST_ptr(rf = SSL_REPLAY_FILTER_new_mem(mem, len, 1000, 0))
+            || !TEST_ptr(rf2 = SSL_REPLAY_FILTER_attach(mem, len))
+            || !TEST_true(SSL_CTX_set1_replay_filter(sctx, rf))
+            || !TEST_true(SSL_CTX_set1_replay_filter(sctx2, rf2))
+            || !TEST_ptr_eq(SSL_CTX_get0_replay_filter(sctx), rf))
+        goto end;
 
     if (!TEST_true(setupearly_data_test(&cctx, &sctx, &clientssl,
-                                        &serverssl, &sess, idx)))
+                                        &serverssl, &sess, 0)))
         goto end;
 
-    if (testtype == 1 || testtype == 2) {
-        /* Force an HRR to occur */
-        if (!TEST_true(SSL_set1_groups_list(serverssl, "P-256")))
-            goto end;
-    } else if (idx == 2) {
-        /*
-         * We force early_data rejection by ensuring the PSK identity is
-         * unrecognised
-         */
-        srvid = "Dummy Identity";
-    } else {
+    /*
+     * The ticket isn't used up: it gets early data accepted twice. We keep
+     * what the client sent the first time to replay it.
+     */
+    for (i = 0; i < 2; i++) {
+        if (i > 0) {
+            SSL_shutdown(clientssl);
+            SSL_shutdown(serverssl);
+            SSL_free(serverssl);
+            SSL_free(clientssl);
+            serverssl = clientssl = NULL;
+            if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl,
+                                              &clientssl, NULL, NULL))
+                    || !TEST_true(SSL_set_session(clientssl, sess)))
+                goto end;
+        }
+        if (!TEST_true(SSL_write_early_data(clientssl, MSG1, strlen(MSG1),
+                                            &written)))
+            goto end;
+        if (i == 0
+                && (!TEST_true(BIO_read_ex(SSL_get_rbio(serverssl), data,
+                                           sizeof(data), &rawread))
+                    || !TEST_size_t_lt(rawread, sizeof(data))
+                    || !TEST_true(BIO_write_ex(SSL_get_rbio(serverssl), data,
+                                               rawread, &rawwritten))
+                    || !TEST_size_t_eq(rawwritten, rawread)))
+            goto end;
+        if (!TEST_int_eq(SSL_read_early_data(serverssl, buf, sizeof(buf),
+                                             &readbytes),
+                         SSL_READ_EARLY_DATA_SUCCESS)
+                || !TEST_mem_eq(MSG1, strlen(MSG1), buf, readbytes)
+                || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                    SSL_ERROR_NONE))
+                || !TEST_int_eq(SSL_get_early_data_status(serverssl),
+                                SSL_EARLY_DATA_ACCEPTED))
+            goto end;
+    }
+
+    /* The replayed ClientHello still resumes, without its early data */
+    if (!TEST_true(create_ssl_objects(sctx2, cctx, &serverssl2, &clientssl2,
+                                      NULL, NULL))
+            || !TEST_true(BIO_write_ex(SSL_get_rbio(serverssl2), data, rawread,
+                                       &rawwritten))
+            || !TEST_int_eq(SSL_read_early_data(serverssl2, buf, sizeof(buf),
+                                                &readbytes),
+                            SSL_READ_EARLY_DATA_FINISH)
+            || !TEST_int_eq(SSL_get_early_data_status(serverssl2),
+                            SSL_EARLY_DATA_REJECTED)
+            || !TEST_true(SSL_session_reused(serverssl2)))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_SESSION_free(sess);
+    SSL_free(serverssl);
+    SSL_free(serverssl2);
+    SSL_free(clientssl);
+    SSL_free(clientssl2);
+    SSL_REPLAY_FILTER_free(rf);
+    SSL_REPLAY_FILTER_free(rf2);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(sctx2);
+    SSL_CTX_free(cctx);
+    OPENSSL_free(mem);
+    return testresult;
+}
+
+/*
+ * Helper function to test that a server attempting to read early data can
+ * handle a connection from a client where the early data should be skipped.
+ * testtype: 0 == No HRR
+ * testtype: 1 == HRR
+ * testtype: 2 == HRR, invalid early_data sent after HRR
+ * testtype: 3 == recv_max_early_data set to 0
+ */
+static int early_data_skip_helper(int testtype, int idx)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int testresult = 0;
+    SSL_SESSION *sess = NULL;
+    unsigned char buf[20];
+    size_t readbytes, written;
+
+    if (!TEST_true(setupearly_data_test(&cctx, &sctx, &clientssl,
+                                        &serverssl, &sess, idx)))
+        goto end;
+
+    if (testtype == 1 || testtype == 2) {
+        /* Force an HRR to occur */
+        if (!TEST_true(SSL_set1_groups_list(serverssl, "P-256")))
+            goto end;
+    } else if (idx == 2) {
+        /*
+         * We force early_data rejection by ensuring the PSK identity is
+         * unrecognised
+         */
+        srvid = "Dummy Identity";
+    } else {
         /*
          * Deliberately corrupt the creation time. We take 20 seconds off the
          * time. It could be any value as long as it is not within tolerance.
@@ -4108,11 +4985,17 @@ static int test_stateless(void)
                                                 SSL_ERROR_WANT_READ))
                /* This should fail because there is no cookie */
             || !TEST_int_eq(SSL_stateless(serverssl), 0)
+               /* The key share picked a group but was left undecoded */
+            || !TEST_true(serverssl->s3->tmp.key_share_deferred)
+            || !TEST_int_ne(serverssl->s3->group_id, 0)
+            || !TEST_ptr_null(serverssl->s3->peer_tmp)
                /* Send the second ClientHello */
             || !TEST_false(create_ssl_connection(serverssl, clientssl,
                                                 SSL_ERROR_WANT_READ))
                /* This should succeed because a cookie is now present */
             || !TEST_int_eq(SSL_stateless(serverssl), 1)
+            || !TEST_false(serverssl->s3->tmp.key_share_deferred)
+            || !TEST_ptr(serverssl->s3->peer_tmp)
                /* Complete the connection */
             || !TEST_true(create_ssl_connection(serverssl, clientssl,
                                                 SSL_ERROR_NONE)))
@@ -5758,114 +6641,110 @@ static int test_ssl_pending(int tst)
     return testresult;
 }
 
-static struct {
-    unsigned int maxprot;
-    const char *clntciphers;
-    const char *clnttls13ciphers;
-    const char *srvrciphers;
-    const char *srvrtls13ciphers;
-    const char *shared;
-} shared_ciphers_data[] = {
-/*
- * We can't establish a connection (even in TLSv1.1) with these ciphersuites if
- * TLSv1.3 is enabled but TLSv1.2 is disabled.
- */
-#if defined(OPENSSL_NO_TLS1_3) || !defined(OPENSSL_NO_TLS1_2)
-    {
-        TLS1_2_VERSION,
-        "AES128-SHA:AES256-SHA",
-        NULL,
-        "AES256-SHA:DHE-RSA-AES128-SHA",
-        NULL,
-        "AES256-SHA"
-    },
-    {
-        TLS1_2_VERSION,
-        "AES128-SHA:DHE-RSA-AES128-SHA:AES256-SHA",
-        NULL,
-        "AES128-SHA:DHE-RSA-AES256-SHA:AES256-SHA",
-        NULL,
-        "AES128-SHA:AES256-SHA"
-    },
-    {
-        TLS1_2_VERSION,
-        "AES128-SHA:AES256-SHA",
-        NULL,
-        "AES128-SHA:DHE-RSA-AES128-SHA",
-        NULL,
-        "AES128-SHA"
-    },
-#endif
 /*
- * This test combines TLSv1.3 and TLSv1.2 ciphersuites so they must both be
- * enabled.
+ * Test SSL_writev_ex() and SSL_readv_ex()
+ * Test 0: TLS
+ * Test 1: DTLS
  */
-#if !defined(OPENSSL_NO_TLS1_3) && !defined(OPENSSL_NO_TLS1_2) \
-    && !defined(OPENSSL_NO_CHACHA) && !defined(OPENSSL_NO_POLY1305)
-    {
-        TLS1_3_VERSION,
-        "AES128-SHA:AES256-SHA",
-        NULL,
-        "AES256-SHA:AES128-SHA256",
-        NULL,
-        "TLS_AES_256_GCM_SHA384:TLS_CHACHA20_POLY1305_SHA256:"
-        "TLS_AES_128_GCM_SHA256:AES256-SHA"
-    },
-#endif
-#ifndef OPENSSL_NO_TLS1_3
-    {
-        TLS1_3_VERSION,
-        "AES128-SHA",
-        "TLS_AES_256_GCM_SHA384",
-        "AES256-SHA",
-        "TLS_AES_256_GCM_SHA384",
-        "TLS_AES_256_GCM_SHA384"
-    },
-#endif
-};
-
-static int test_ssl_get_shared_ciphers(int tst)
+static int test_writev_readv(int tst)
 {
     SSL_CTX *cctx = NULL, *sctx = NULL;
     SSL *clientssl = NULL, *serverssl = NULL;
     int testresult = 0;
-    char buf[1024];
+    unsigned char *msg = NULL, *buf = NULL;
+    size_t lens[3] = { 5, 20000, 3 };
+    SSL_IOVEC wiov[3], riov[2];
+    size_t i, total, contiglen, written, readbytes, off;
 
-    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
-                                       TLS_client_method(),
-                                       TLS1_VERSION,
-                                       shared_ciphers_data[tst].maxprot,
-                                       &sctx, &cctx, cert, privkey)))
-        goto end;
+    if (tst == 0) {
+        if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                           TLS_client_method(),
+                                           TLS1_VERSION, TLS_MAX_VERSION,
+                                           &sctx, &cctx, cert, privkey)))
+            goto end;
+    } else {
+#ifndef OPENSSL_NO_DTLS
+        if (!TEST_true(create_ssl_ctx_pair(DTLS_server_method(),
+                                           DTLS_client_method(),
+                                           DTLS1_VERSION, DTLS_MAX_VERSION,
+                                           &sctx, &cctx, cert, privkey)))
+            goto end;
+        /* A DTLS record has to fit the whole write */
+        lens[1] = 1000;
+#else
+        return 1;
+#endif
+    }
 
-    if (!TEST_true(SSL_CTX_set_cipher_list(cctx,
-                                        shared_ciphers_data[tst].clntciphers))
-            || (shared_ciphers_data[tst].clnttls13ciphers != NULL
-                && !TEST_true(SSL_CTX_set_ciphersuites(cctx,
-                                    shared_ciphers_data[tst].clnttls13ciphers)))
-            || !TEST_true(SSL_CTX_set_cipher_list(sctx,
-                                        shared_ciphers_data[tst].srvrciphers))
-            || (shared_ciphers_data[tst].srvrtls13ciphers != NULL
-                && !TEST_true(SSL_CTX_set_ciphersuites(sctx,
-                                    shared_ciphers_data[tst].srvrtls13ciphers))))
+    total = lens[0] + lens[1] + lens[2];
+    if (!TEST_ptr(msg = OPENSSL_malloc(total))
+            || !TEST_ptr(buf = OPENSSL_zalloc(total)))
         goto end;
-
+    for (i = 0; i < total; i++)
+        msg[i] = (unsigned char)(i * 7);
+    for (i = 0, off = 0; i < OSSL_NELEM(wiov); off += lens[i++]) {
+        wiov[i].base = msg + off;
+        wiov[i].len = lens[i];
+    }
 
     if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
-                                             NULL, NULL))
+                                      NULL, NULL))
             || !TEST_true(create_ssl_connection(serverssl, clientssl,
                                                 SSL_ERROR_NONE)))
         goto end;
 
-    if (!TEST_ptr(SSL_get_shared_ciphers(serverssl, buf, sizeof(buf)))
-            || !TEST_int_eq(strcmp(buf, shared_ciphers_data[tst].shared), 0)) {
-        TEST_info("Shared ciphers are: %s\n", buf);
+    /* The segments go out in the very same records as one buffer would */
+    if (!TEST_true(SSL_write_ex(serverssl, msg, total, &written))
+            || !TEST_size_t_eq(written, total))
         goto end;
+    contiglen = BIO_pending(SSL_get_wbio(serverssl));
+    for (off = 0; off < total; off += readbytes) {
+        if (!TEST_true(SSL_read_ex(clientssl, buf + off, total - off,
+                                   &readbytes)))
+            goto end;
+    }
+    if (!TEST_mem_eq(buf, total, msg, total)
+            || !TEST_true(SSL_writev_ex(serverssl, wiov, OSSL_NELEM(wiov),
+                                        &written))
+            || !TEST_size_t_eq(written, total))
+        goto end;
+    if (tst == 0
+            && !TEST_size_t_eq(BIO_pending(SSL_get_wbio(serverssl)),
+                               contiglen))
+        goto end;
+
+    /* Read back into two segments, the first one much smaller than a record */
+    memset(buf, 0, total);
+    for (off = 0; off < total; off += readbytes) {
+        riov[0].base = buf + off;
+        riov[0].len = (total - off) < 10 ? total - off : 10;
+        riov[1].base = buf + off + riov[0].len;
+        riov[1].len = total - off - riov[0].len;
+        if (!TEST_true(SSL_readv_ex(clientssl, riov, OSSL_NELEM(riov),
+                                    &readbytes)))
+            goto end;
     }
+    if (!TEST_mem_eq(buf, total, msg, total)
+            || !TEST_int_eq(SSL_pending(clientssl), 0))
+        goto end;
+
+    /* Empty segments are skipped */
+    wiov[1].base = NULL;
+    wiov[1].len = 0;
+    if (!TEST_true(SSL_writev_ex(serverssl, wiov, OSSL_NELEM(wiov), &written))
+            || !TEST_size_t_eq(written, lens[0] + lens[2])
+            || !TEST_true(SSL_read_ex(clientssl, buf, total, &readbytes))
+            || !TEST_size_t_eq(readbytes, lens[0] + lens[2])
+            || !TEST_mem_eq(buf, lens[0], msg, lens[0])
+            || !TEST_mem_eq(buf + lens[0], lens[2], msg + lens[0] + lens[1],
+                            lens[2]))
+        goto end;
 
     testresult = 1;
 
  end:
+    OPENSSL_free(msg);
+    OPENSSL_free(buf);
     SSL_free(serverssl);
     SSL_free(clientssl);
     SSL_CTX_free(sctx);
@@ -5874,224 +6753,263 @@ static int test_ssl_get_shared_ciphers(int tst)
     return testresult;
 }
 
-static const char *appdata = "Hello World";
-static int gen_tick_called, dec_tick_called, tick_key_cb_called;
-static int tick_key_renew = 0;
-static SSL_TICKET_RETURN tick_dec_ret = SSL_TICKET_RETURN_ABORT;
-
-static int gen_tick_cb(SSL *s, void *arg)
+/*
+ * Test that record buffers released by one connection are picked up again
+ * from the SSL_CTX pool
+ */
+static int test_record_buffer_pool(void)
 {
-    gen_tick_called = 1;
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL, *otherssl = NULL;
+    int testresult = 0;
+    unsigned char *rbuf, *wbuf;
+    size_t written, readbytes;
+    char msg[] = "A test message", buf[sizeof(msg)];
 
-    return SSL_SESSION_set1_ticket_appdata(SSL_get_session(s), appdata,
-                                           strlen(appdata));
-}
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(),
+                                       TLS1_VERSION, TLS_MAX_VERSION,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_size_t_eq(SSL_CTX_get_record_buffer_pool_size(sctx),
+                               SSL_MAX_BUF_FREELIST_LEN_DEFAULT))
+        goto end;
+    SSL_CTX_set_record_buffer_pool_size(sctx, 1);
+    if (!TEST_size_t_eq(SSL_CTX_get_record_buffer_pool_size(sctx), 1))
+        goto end;
 
-static SSL_TICKET_RETURN dec_tick_cb(SSL *s, SSL_SESSION *ss,
-                                     const unsigned char *keyname,
-                                     size_t keyname_length,
-                                     SSL_TICKET_STATUS status,
-                                     void *arg)
-{
-    void *tickdata;
-    size_t tickdlen;
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_ptr(otherssl = SSL_new(sctx)))
+        goto end;
+
+    /* Buffers given up by one connection are reused by the next one */
+    rbuf = serverssl->rlayer.rbuf.buf;
+    wbuf = serverssl->rlayer.wbuf[0].buf;
+    if (!TEST_ptr(rbuf)
+            || !TEST_ptr(wbuf)
+            || !TEST_size_t_eq(sctx->rbuf_freelist.len, 0)
+            || !TEST_size_t_eq(sctx->wbuf_freelist.len, 0)
+            || !TEST_true(SSL_free_buffers(serverssl))
+            || !TEST_size_t_eq(sctx->rbuf_freelist.len, 1)
+            || !TEST_size_t_eq(sctx->wbuf_freelist.len, 1)
+            || !TEST_true(SSL_alloc_buffers(otherssl))
+            || !TEST_ptr_eq(otherssl->rlayer.rbuf.buf, rbuf)
+            || !TEST_ptr_eq(otherssl->rlayer.wbuf[0].buf, wbuf)
+            || !TEST_size_t_eq(sctx->rbuf_freelist.len, 0)
+            || !TEST_size_t_eq(sctx->wbuf_freelist.len, 0))
+        goto end;
+
+    /* A full pool does not take any more buffers */
+    if (!TEST_true(SSL_alloc_buffers(serverssl))
+            || !TEST_true(SSL_free_buffers(serverssl))
+            || !TEST_true(SSL_free_buffers(otherssl))
+            || !TEST_size_t_eq(sctx->rbuf_freelist.len, 1)
+            || !TEST_size_t_eq(sctx->wbuf_freelist.len, 1))
+        goto end;
+
+    if (!TEST_true(SSL_write_ex(serverssl, msg, sizeof(msg), &written))
+            || !TEST_true(SSL_read_ex(clientssl, buf, sizeof(buf), &readbytes))
+            || !TEST_mem_eq(buf, readbytes, msg, sizeof(msg)))
+        goto end;
 
-    dec_tick_called = 1;
+    SSL_CTX_set_record_buffer_pool_size(sctx, 0);
+    if (!TEST_size_t_eq(sctx->rbuf_freelist.len, 0)
+            || !TEST_size_t_eq(sctx->wbuf_freelist.len, 0)
+            || !TEST_true(SSL_free_buffers(serverssl))
+            || !TEST_size_t_eq(sctx->rbuf_freelist.len, 0)
+            || !TEST_size_t_eq(sctx->wbuf_freelist.len, 0))
+        goto end;
 
-    if (status == SSL_TICKET_EMPTY)
-        return SSL_TICKET_RETURN_IGNORE_RENEW;
+    testresult = 1;
 
-    if (!TEST_true(status == SSL_TICKET_SUCCESS
-                   || status == SSL_TICKET_SUCCESS_RENEW))
-        return SSL_TICKET_RETURN_ABORT;
+ end:
+    SSL_free(otherssl);
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
 
-    if (!TEST_true(SSL_SESSION_get0_ticket_appdata(ss, &tickdata,
-                                                   &tickdlen))
-            || !TEST_size_t_eq(tickdlen, strlen(appdata))
-            || !TEST_int_eq(memcmp(tickdata, appdata, tickdlen), 0))
-        return SSL_TICKET_RETURN_ABORT;
+    return testresult;
+}
 
-    if (tick_key_cb_called)  {
-        /* Don't change what the ticket key callback wanted to do */
-        switch (status) {
-        case SSL_TICKET_NO_DECRYPT:
-            return SSL_TICKET_RETURN_IGNORE_RENEW;
-
-        case SSL_TICKET_SUCCESS:
-            return SSL_TICKET_RETURN_USE;
-
-        case SSL_TICKET_SUCCESS_RENEW:
-            return SSL_TICKET_RETURN_USE_RENEW;
-
-        default:
-            return SSL_TICKET_RETURN_ABORT;
-        }
-    }
-    return tick_dec_ret;
-
-}
-
-static int tick_key_cb(SSL *s, unsigned char key_name[16],
-                       unsigned char iv[EVP_MAX_IV_LENGTH], EVP_CIPHER_CTX *ctx,
-                       HMAC_CTX *hctx, int enc)
-{
-    const unsigned char tick_aes_key[16] = "0123456789abcdef";
-    const unsigned char tick_hmac_key[16] = "0123456789abcdef";
-
-    tick_key_cb_called = 1;
-    memset(iv, 0, AES_BLOCK_SIZE);
-    memset(key_name, 0, 16);
-    if (!EVP_CipherInit_ex(ctx, EVP_aes_128_cbc(), NULL, tick_aes_key, iv, enc)
-            || !HMAC_Init_ex(hctx, tick_hmac_key, sizeof(tick_hmac_key),
-                             EVP_sha256(), NULL))
-        return -1;
-
-    return tick_key_renew ? 2 : 1;
-}
-
-/*
- * Test the various ticket callbacks
- * Test 0: TLSv1.2, no ticket key callback, no ticket, no renewal
- * Test 1: TLSv1.3, no ticket key callback, no ticket, no renewal
- * Test 2: TLSv1.2, no ticket key callback, no ticket, renewal
- * Test 3: TLSv1.3, no ticket key callback, no ticket, renewal
- * Test 4: TLSv1.2, no ticket key callback, ticket, no renewal
- * Test 5: TLSv1.3, no ticket key callback, ticket, no renewal
- * Test 6: TLSv1.2, no ticket key callback, ticket, renewal
- * Test 7: TLSv1.3, no ticket key callback, ticket, renewal
- * Test 8: TLSv1.2, ticket key callback, ticket, no renewal
- * Test 9: TLSv1.3, ticket key callback, ticket, no renewal
- * Test 10: TLSv1.2, ticket key callback, ticket, renewal
- * Test 11: TLSv1.3, ticket key callback, ticket, renewal
- */
-static int test_ticket_callbacks(int tst)
-{
-    SSL_CTX *cctx = NULL, *sctx = NULL;
-    SSL *clientssl = NULL, *serverssl = NULL;
-    SSL_SESSION *clntsess = NULL;
-    int testresult = 0;
+/*
+ * Test that with max_pipelines > 1 AEAD ciphers read several records in one
+ * SSL_read_ex() call, and that a KeyUpdate ends such a batch
+ * Test 0: TLSv1.2, AES-GCM
+ * Test 1: TLSv1.2, ChaCha20-Poly1305
+ * Test 2: TLSv1.3, AES-GCM
+ * Test 3: TLSv1.3, ChaCha20-Poly1305
+ */
+static int test_aead_read_batch(int tst)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int testresult = 0, version = tst < 2 ? TLS1_2_VERSION : TLS1_3_VERSION;
+    const char *cipher;
+    unsigned char *msg = NULL, *buf = NULL;
+    size_t reclen = SSL3_RT_MAX_PLAIN_LENGTH, buflen = 8 * reclen;
+    size_t i, written, readbytes;
 
 #ifdef OPENSSL_NO_TLS1_2
-    if (tst % 2 == 0)
+    if (version == TLS1_2_VERSION)
         return 1;
 #endif
 #ifdef OPENSSL_NO_TLS1_3
+    if (version == TLS1_3_VERSION)
+        return 1;
+#endif
+#ifdef OPENSSL_NO_CHACHA
     if (tst % 2 == 1)
         return 1;
 #endif
 
-    gen_tick_called = dec_tick_called = tick_key_cb_called = 0;
-
-    /* Which tests the ticket key callback should request renewal for */
-    if (tst == 10 || tst == 11)
-        tick_key_renew = 1;
-    else
-        tick_key_renew = 0;
-
-    /* Which tests the decrypt ticket callback should request renewal for */
-    switch (tst) {
-    case 0:
-    case 1:
-        tick_dec_ret = SSL_TICKET_RETURN_IGNORE;
-        break;
-
-    case 2:
-    case 3:
-        tick_dec_ret = SSL_TICKET_RETURN_IGNORE_RENEW;
-        break;
-
-    case 4:
-    case 5:
-        tick_dec_ret = SSL_TICKET_RETURN_USE;
-        break;
-
-    case 6:
-    case 7:
-        tick_dec_ret = SSL_TICKET_RETURN_USE_RENEW;
-        break;
-
-    default:
-        tick_dec_ret = SSL_TICKET_RETURN_ABORT;
-    }
+    if (!TEST_ptr(msg = OPENSSL_malloc(buflen))
+            || !TEST_ptr(buf = OPENSSL_zalloc(buflen)))
+        goto end;
+    for (i = 0; i < buflen; i++)
+        msg[i] = (unsigned char)(i * 11);
 
     if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
                                        TLS_client_method(),
-                                       TLS1_VERSION,
-                                       ((tst % 2) == 0) ? TLS1_2_VERSION
-                                                        : TLS1_3_VERSION,
+                                       version, version,
                                        &sctx, &cctx, cert, privkey)))
         goto end;
-
-    /*
-     * We only want sessions to resume from tickets - not the session cache. So
-     * switch the cache off.
-     */
-    if (!TEST_true(SSL_CTX_set_session_cache_mode(sctx, SSL_SESS_CACHE_OFF)))
-        goto end;
-
-    if (!TEST_true(SSL_CTX_set_session_ticket_cb(sctx, gen_tick_cb, dec_tick_cb,
-                                                 NULL)))
-        goto end;
-
-    if (tst >= 8
-            && !TEST_true(SSL_CTX_set_tlsext_ticket_key_cb(sctx, tick_key_cb)))
+    if (version == TLS1_3_VERSION) {
+        cipher = tst % 2 == 0 ? "TLS_AES_128_GCM_SHA256"
+                              : "TLS_CHACHA20_POLY1305_SHA256";
+        if (!TEST_true(SSL_CTX_set_ciphersuites(sctx, cipher)))
+            goto end;
+    } else {
+        cipher = tst % 2 == 0 ? "ECDHE-RSA-AES128-GCM-SHA256"
+                              : "ECDHE-RSA-CHACHA20-POLY1305";
+        if (!TEST_true(SSL_CTX_set_cipher_list(sctx, cipher)))
+            goto end;
+    }
+    /* The read buffer has to take several records at once */
+    if (!TEST_true(SSL_CTX_set_max_pipelines(cctx, 4)))
         goto end;
+    SSL_CTX_set_default_read_buffer_len(cctx, buflen);
 
     if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
-                                             NULL, NULL))
+                                      NULL, NULL))
             || !TEST_true(create_ssl_connection(serverssl, clientssl,
                                                 SSL_ERROR_NONE)))
         goto end;
 
-    /*
-     * The decrypt ticket key callback in TLSv1.2 should be called even though
-     * we have no ticket yet, because it gets called with a status of
-     * SSL_TICKET_EMPTY (the client indicates support for tickets but does not
-     * actually send any ticket data). This does not happen in TLSv1.3 because
-     * it is not valid to send empty ticket data in TLSv1.3.
-     */
-    if (!TEST_int_eq(gen_tick_called, 1)
-            || !TEST_int_eq(dec_tick_called, ((tst % 2) == 0) ? 1 : 0))
+    /* Three records, a KeyUpdate in TLSv1.3 and two more records */
+    for (i = 0; i < 3; i++) {
+        if (!TEST_true(SSL_write_ex(serverssl, msg + i * reclen, reclen,
+                                    &written)))
+            goto end;
+    }
+    if (version == TLS1_3_VERSION
+            && (!TEST_true(SSL_key_update(serverssl,
+                                          SSL_KEY_UPDATE_NOT_REQUESTED))
+                || !TEST_true(SSL_do_handshake(serverssl))))
+        goto end;
+    for (i = 3; i < 5; i++) {
+        if (!TEST_true(SSL_write_ex(serverssl, msg + i * reclen, reclen,
+                                    &written)))
+            goto end;
+    }
+
+    /* The first read takes all records up to the limit of 4 or the KeyUpdate */
+    if (!TEST_true(SSL_read_ex(clientssl, buf, buflen, &readbytes))
+            || !TEST_size_t_eq(readbytes,
+                               (version == TLS1_3_VERSION ? 3 : 4) * reclen)
+            || !TEST_true(SSL_read_ex(clientssl, buf + readbytes,
+                                      buflen - readbytes, &written))
+            || !TEST_size_t_eq(readbytes + written, 5 * reclen)
+            || !TEST_mem_eq(buf, 5 * reclen, msg, 5 * reclen))
         goto end;
 
-    gen_tick_called = dec_tick_called = 0;
+    /* The connection is still fine in both directions */
+    if (!TEST_true(SSL_write_ex(clientssl, msg, 100, &written))
+            || !TEST_true(SSL_read_ex(serverssl, buf, buflen, &readbytes))
+            || !TEST_mem_eq(buf, readbytes, msg, 100)
+            || !TEST_true(SSL_write_ex(serverssl, msg, 100, &written))
+            || !TEST_true(SSL_read_ex(clientssl, buf, buflen, &readbytes))
+            || !TEST_mem_eq(buf, readbytes, msg, 100))
+        goto end;
 
-    clntsess = SSL_get1_session(clientssl);
-    SSL_shutdown(clientssl);
-    SSL_shutdown(serverssl);
+    testresult = 1;
+
+ end:
+    OPENSSL_free(msg);
+    OPENSSL_free(buf);
     SSL_free(serverssl);
     SSL_free(clientssl);
-    serverssl = clientssl = NULL;
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
 
-    /* Now do a resumption */
-    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl, NULL,
-                                      NULL))
-            || !TEST_true(SSL_set_session(clientssl, clntsess))
+    return testresult;
+}
+
+#ifndef OPENSSL_NO_TLS1_3
+/*
+ * Test reads with buffers large enough for a TLSv1.3 record to be decrypted
+ * into them directly, with a KeyUpdate and small reads in between
+ */
+static int test_tls13_read_direct(void)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int testresult = 0;
+    unsigned char *msg = NULL, *buf = NULL;
+    size_t reclen = SSL3_RT_MAX_PLAIN_LENGTH, buflen = 4 * reclen;
+    size_t i, written, readbytes, total;
+
+    if (!TEST_ptr(msg = OPENSSL_malloc(buflen))
+            || !TEST_ptr(buf = OPENSSL_zalloc(buflen)))
+        goto end;
+    for (i = 0; i < buflen; i++)
+        msg[i] = (unsigned char)(i * 7);
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(),
+                                       TLS1_3_VERSION, TLS1_3_VERSION,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_true(create_ssl_objects(sctx, cctx, &serverssl,
+                                             &clientssl, NULL, NULL))
             || !TEST_true(create_ssl_connection(serverssl, clientssl,
                                                 SSL_ERROR_NONE)))
         goto end;
 
-    if (tick_dec_ret == SSL_TICKET_RETURN_IGNORE
-            || tick_dec_ret == SSL_TICKET_RETURN_IGNORE_RENEW) {
-        if (!TEST_false(SSL_session_reused(clientssl)))
-            goto end;
-    } else {
-        if (!TEST_true(SSL_session_reused(clientssl)))
+    if (!TEST_true(SSL_write_ex(serverssl, msg, reclen, &written))
+            || !TEST_true(SSL_key_update(serverssl,
+                                         SSL_KEY_UPDATE_NOT_REQUESTED))
+            || !TEST_true(SSL_write_ex(serverssl, msg + reclen, 2 * reclen,
+                                       &written))
+            || !TEST_true(SSL_write_ex(serverssl, msg + 3 * reclen, reclen,
+                                       &written)))
+        goto end;
+
+    /* A short read of the first record, then large ones */
+    if (!TEST_true(SSL_read_ex(clientssl, buf, 10, &readbytes))
+            || !TEST_size_t_eq(readbytes, 10))
+        goto end;
+    for (total = 10; total < buflen; total += readbytes) {
+        if (!TEST_true(SSL_read_ex(clientssl, buf + total, buflen - total,
+                                   &readbytes))
+                || !TEST_size_t_le(readbytes, reclen))
             goto end;
     }
+    if (!TEST_mem_eq(buf, buflen, msg, buflen))
+        goto end;
 
-    if (!TEST_int_eq(gen_tick_called,
-                     (tick_key_renew
-                      || tick_dec_ret == SSL_TICKET_RETURN_IGNORE_RENEW
-                      || tick_dec_ret == SSL_TICKET_RETURN_USE_RENEW)
-                     ? 1 : 0)
-            || !TEST_int_eq(dec_tick_called, 1))
+    /* The client still has the right keys in both directions */
+    if (!TEST_true(SSL_write_ex(clientssl, msg, 100, &written))
+            || !TEST_true(SSL_read_ex(serverssl, buf, buflen, &readbytes))
+            || !TEST_mem_eq(buf, readbytes, msg, 100))
         goto end;
 
     testresult = 1;
 
  end:
-    SSL_SESSION_free(clntsess);
+    OPENSSL_free(msg);
+    OPENSSL_free(buf);
     SSL_free(serverssl);
     SSL_free(clientssl);
     SSL_CTX_free(sctx);
@@ -6099,784 +7017,3886 @@ static int test_ticket_callbacks(int tst)
 
     return testresult;
 }
+#endif
 
 /*
- * Test bi-directional shutdown.
- * Test 0: TLSv1.2
- * Test 1: TLSv1.2, server continues to read/write after client shutdown
- * Test 2: TLSv1.3, no pending NewSessionTicket messages
- * Test 3: TLSv1.3, pending NewSessionTicket messages
- * Test 4: TLSv1.3, server continues to read/write after client shutdown, server
- *                  sends key update, client reads it
- * Test 5: TLSv1.3, server continues to read/write after client shutdown, server
- *                  sends CertificateRequest, client reads and ignores it
- * Test 6: TLSv1.3, server continues to read/write after client shutdown, client
- *                  doesn't read it
+ * Test that dynamic record sizing starts with small records and doubles
+ * their size up to the maximum
  */
-static int test_shutdown(int tst)
+static int test_dynamic_record_size(void)
 {
     SSL_CTX *cctx = NULL, *sctx = NULL;
     SSL *clientssl = NULL, *serverssl = NULL;
     int testresult = 0;
-    char msg[] = "A test message";
-    char buf[80];
-    size_t written, readbytes;
-    SSL_SESSION *sess;
+    static const size_t expected[] = {
+        1024, 1024, 2048, 2048, 4096, 4096, 8192, 8192, 16384,
+        16384, 3616,
+        1024, 1024, 952
+    };
+    unsigned char *msg = NULL, *buf = NULL;
+    size_t buflen = 64 * 1024, i, written, readbytes;
 
-#ifdef OPENSSL_NO_TLS1_2
-    if (tst <= 1)
-        return 1;
-#endif
-#ifdef OPENSSL_NO_TLS1_3
-    if (tst >= 2)
-        return 1;
-#endif
+    if (!TEST_ptr(msg = OPENSSL_zalloc(buflen))
+            || !TEST_ptr(buf = OPENSSL_malloc(buflen)))
+        goto end;
 
     if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
                                        TLS_client_method(),
-                                       TLS1_VERSION,
-                                       (tst <= 1) ? TLS1_2_VERSION
-                                                  : TLS1_3_VERSION,
+                                       TLS1_VERSION, 0,
                                        &sctx, &cctx, cert, privkey)))
         goto end;
-
-    if (tst == 5)
-        SSL_CTX_set_post_handshake_auth(cctx, 1);
+    if (!TEST_false(SSL_CTX_set_dynamic_record_size(sctx, 100))
+            || !TEST_false(SSL_CTX_set_dynamic_record_ramp(sctx, 0))
+            || !TEST_true(SSL_CTX_set_dynamic_record_size(sctx, 1024))
+            || !TEST_true(SSL_CTX_set_dynamic_record_ramp(sctx, 2)))
+        goto end;
 
     if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
-                                             NULL, NULL)))
+                                      NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE)))
         goto end;
 
-    if (tst == 3) {
-        if (!TEST_true(create_bare_ssl_connection(serverssl, clientssl,
-                                                  SSL_ERROR_NONE, 1))
-                || !TEST_ptr_ne(sess = SSL_get_session(clientssl), NULL)
-                || !TEST_false(SSL_SESSION_is_resumable(sess)))
-            goto end;
-    } else if (!TEST_true(create_ssl_connection(serverssl, clientssl,
-                                              SSL_ERROR_NONE))
-            || !TEST_ptr_ne(sess = SSL_get_session(clientssl), NULL)
-            || !TEST_true(SSL_SESSION_is_resumable(sess))) {
+    /* The ramp carries on across writes and starts over with a new size */
+    if (!TEST_true(SSL_write_ex(serverssl, msg, 47104, &written))
+            || !TEST_true(SSL_write_ex(serverssl, msg, 20000, &written))
+            || !TEST_true(SSL_set_dynamic_record_size(serverssl, 1024))
+            || !TEST_true(SSL_write_ex(serverssl, msg, 3000, &written)))
         goto end;
+
+    /* Without pipelining every read returns a single record */
+    for (i = 0; i < OSSL_NELEM(expected); i++) {
+        if (!TEST_true(SSL_read_ex(clientssl, buf, buflen, &readbytes))
+                || !TEST_size_t_eq(readbytes, expected[i]))
+            goto end;
     }
 
-    if (!TEST_int_eq(SSL_shutdown(clientssl), 0))
-        goto end;
+    testresult = 1;
 
-    if (tst >= 4) {
-        /*
-         * Reading on the server after the client has sent close_notify should
-         * fail and provide SSL_ERROR_ZERO_RETURN
-         */
-        if (!TEST_false(SSL_read_ex(serverssl, buf, sizeof(buf), &readbytes))
-                || !TEST_int_eq(SSL_get_error(serverssl, 0),
-                                SSL_ERROR_ZERO_RETURN)
-                || !TEST_int_eq(SSL_get_shutdown(serverssl),
-                                SSL_RECEIVED_SHUTDOWN)
-                   /*
-                    * Even though we're shutdown on receive we should still be
-                    * able to write.
-                    */
-                || !TEST_true(SSL_write(serverssl, msg, sizeof(msg))))
-            goto end;
-        if (tst == 4
-                && !TEST_true(SSL_key_update(serverssl,
-                                             SSL_KEY_UPDATE_REQUESTED)))
-            goto end;
-        if (tst == 5) {
+ end:
+    OPENSSL_free(msg);
+    OPENSSL_free(buf);
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+
+static struct {
+    unsigned int maxprot;
+    const char *clntciphers;
+    const char *clnttls13ciphers;
+    const char *srvrciphers;
+    const char *srvrtls13ciphers;
+    const char *shared;
+} shared_ciphers_data[] = {
+/*
+ * We can't establish a connection (even in TLSv1.1) with these ciphersuites if
+ * TLSv1.3 is enabled but TLSv1.2 is disabled.
+ */
+#if defined(OPENSSL_NO_TLS1_3) || !defined(OPENSSL_NO_TLS1_2)
+    {
+        TLS1_2_VERSION,
+        "AES128-SHA:AES256-SHA",
+        NULL,
+        "AES256-SHA:DHE-RSA-AES128-SHA",
+        NULL,
+        "AES256-SHA"
+    },
+    {
+        TLS1_2_VERSION,
+        "AES128-SHA:DHE-RSA-AES128-SHA:AES256-SHA",
+        NULL,
+        "AES128-SHA:DHE-RSA-AES256-SHA:AES256-SHA",
+        NULL,
+        "AES128-SHA:AES256-SHA"
+    },
+    {
+        TLS1_2_VERSION,
+        "AES128-SHA:AES256-SHA",
+        NULL,
+        "AES128-SHA:DHE-RSA-AES128-SHA",
+        NULL,
+        "AES128-SHA"
+    },
+#endif
+/*
+ * This test combines TLSv1.3 and TLSv1.2 ciphersuites so they must both be
+ * enabled.
+ */
+#if !defined(OPENSSL_NO_TLS1_3) && !defined(OPENSSL_NO_TLS1_2) \
+    && !defined(OPENSSL_NO_CHACHA) && !defined(OPENSSL_NO_POLY1305)
+    {
+        TLS1_3_VERSION,
+        "AES128-SHA:AES256-SHA",
+        NULL,
+        "AES256-SHA:AES128-SHA256",
+        NULL,
+        "TLS_AES_256_GCM_SHA384:TLS_CHACHA20_POLY1305_SHA256:"
+        "TLS_AES_128_GCM_SHA256:AES256-SHA"
+    },
+#endif
+#ifndef OPENSSL_NO_TLS1_3
+    {
+        TLS1_3_VERSION,
+        "AES128-SHA",
+        "TLS_AES_256_GCM_SHA384",
+        "AES256-SHA",
+        "TLS_AES_256_GCM_SHA384",
+        "TLS_AES_256_GCM_SHA384"
+    },
+#endif
+};
+
+static int test_ssl_get_shared_ciphers(int tst)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int testresult = 0;
+    char buf[1024];
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(),
+                                       TLS1_VERSION,
+                                       shared_ciphers_data[tst].maxprot,
+                                       &sctx, &cctx, cert, privkey)))
+        goto end;
+
+    if (!TEST_true(SSL_CTX_set_cipher_list(cctx,
+                                        shared_ciphers_data[tst].clntciphers))
+            || (shared_ciphers_data[tst].clnttls13ciphers != NULL
+                && !TEST_true(SSL_CTX_set_ciphersuites(cctx,
+                                    shared_ciphers_data[tst].clnttls13ciphers)))
+            || !TEST_true(SSL_CTX_set_cipher_list(sctx,
+                                        shared_ciphers_data[tst].srvrciphers))
+            || (shared_ciphers_data[tst].srvrtls13ciphers != NULL
+                && !TEST_true(SSL_CTX_set_ciphersuites(sctx,
+                                    shared_ciphers_data[tst].srvrtls13ciphers))))
+        goto end;
+
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                             NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE)))
+        goto end;
+
+    if (!TEST_ptr(SSL_get_shared_ciphers(serverssl, buf, sizeof(buf)))
+            || !TEST_int_eq(strcmp(buf, shared_ciphers_data[tst].shared), 0)) {
+        TEST_info("Shared ciphers are: %s\n", buf);
+        goto end;
+    }
+
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+
+static const char *appdata = "Hello World";
+static int gen_tick_called, dec_tick_called, tick_key_cb_called;
+static int tick_key_renew = 0;
+static SSL_TICKET_RETURN tick_dec_ret = SSL_TICKET_RETURN_ABORT;
+
+static int gen_tick_cb(SSL *s, void *arg)
+{
+    gen_tick_called = 1;
+
+    return SSL_SESSION_set1_ticket_appdata(SSL_get_session(s), appdata,
+                                           strlen(appdata));
+}
+
+static SSL_TICKET_RETURN dec_tick_cb(SSL *s, SSL_SESSION *ss,
+                                     const unsigned char *keyname,
+                                     size_t keyname_length,
+                                     SSL_TICKET_STATUS status,
+                                     void *arg)
+{
+    void *tickdata;
+    size_t tickdlen;
+
+    dec_tick_called = 1;
+
+    if (status == SSL_TICKET_EMPTY)
+        return SSL_TICKET_RETURN_IGNORE_RENEW;
+
+    if (!TEST_true(status == SSL_TICKET_SUCCESS
+                   || status == SSL_TICKET_SUCCESS_RENEW))
+        return SSL_TICKET_RETURN_ABORT;
+
+    if (!TEST_true(SSL_SESSION_get0_ticket_appdata(ss, &tickdata,
+                                                   &tickdlen))
+            || !TEST_size_t_eq(tickdlen, strlen(appdata))
+            || !TEST_int_eq(memcmp(tickdata, appdata, tickdlen), 0))
+        return SSL_TICKET_RETURN_ABORT;
+
+    if (tick_key_cb_called)  {
+        /* Don't change what the ticket key callback wanted to do */
+        switch (status) {
+        case SSL_TICKET_NO_DECRYPT:
+            return SSL_TICKET_RETURN_IGNORE_RENEW;
+
+        case SSL_TICKET_SUCCESS:
+            return SSL_TICKET_RETURN_USE;
+
+        case SSL_TICKET_SUCCESS_RENEW:
+            return SSL_TICKET_RETURN_USE_RENEW;
+
+        default:
+            return SSL_TICKET_RETURN_ABORT;
+        }
+    }
+    return tick_dec_ret;
+
+}
+
+static int tick_key_cb(SSL *s, unsigned char key_name[16],
+                       unsigned char iv[EVP_MAX_IV_LENGTH], EVP_CIPHER_CTX *ctx,
+                       HMAC_CTX *hctx, int enc)
+{
+    const unsigned char tick_aes_key[16] = "0123456789abcdef";
+    const unsigned char tick_hmac_key[16] = "0123456789abcdef";
+
+    tick_key_cb_called = 1;
+    memset(iv, 0, AES_BLOCK_SIZE);
+    memset(key_name, 0, 16);
+    if (!EVP_CipherInit_ex(ctx, EVP_aes_128_cbc(), NULL, tick_aes_key, iv, enc)
+            || !HMAC_Init_ex(hctx, tick_hmac_key, sizeof(tick_hmac_key),
+                             EVP_sha256(), NULL))
+        return -1;
+
+    return tick_key_renew ? 2 : 1;
+}
+
+/*
+ * Test the various ticket callbacks
+ * Test 0: TLSv1.2, no ticket key callback, no ticket, no renewal
+ * Test 1: TLSv1.3, no ticket key callback, no ticket, no renewal
+ * Test 2: TLSv1.2, no ticket key callback, no ticket, renewal
+ * Test 3: TLSv1.3, no ticket key callback, no ticket, renewal
+ * Test 4: TLSv1.2, no ticket key callback, ticket, no renewal
+ * Test 5: TLSv1.3, no ticket key callback, ticket, no renewal
+ * Test 6: TLSv1.2, no ticket key callback, ticket, renewal
+ * Test 7: TLSv1.3, no ticket key callback, ticket, renewal
+ * Test 8: TLSv1.2, ticket key callback, ticket, no renewal
+ * Test 9: TLSv1.3, ticket key callback, ticket, no renewal
+ * Test 10: TLSv1.2, ticket key callback, ticket, renewal
+ * Test 11: TLSv1.3, ticket key callback, ticket, renewal
+ */
+static int test_ticket_callbacks(int tst)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    SSL_SESSION *clntsess = NULL;
+    int testresult = 0;
+
+#ifdef OPENSSL_NO_TLS1_2
+    if (tst % 2 == 0)
+        return 1;
+#endif
+#ifdef OPENSSL_NO_TLS1_3
+    if (tst % 2 == 1)
+        return 1;
+#endif
+
+    gen_tick_called = dec_tick_called = tick_key_cb_called = 0;
+
+    /* Which tests the ticket key callback should request renewal for */
+    if (tst == 10 || tst == 11)
+        tick_key_renew = 1;
+    else
+        tick_key_renew = 0;
+
+    /* Which tests the decrypt ticket callback should request renewal for */
+    switch (tst) {
+    case 0:
+    case 1:
+        tick_dec_ret = SSL_TICKET_RETURN_IGNORE;
+        break;
+
+    case 2:
+    case 3:
+        tick_dec_ret = SSL_TICKET_RETURN_IGNORE_RENEW;
+        break;
+
+    case 4:
+    case 5:
+        tick_dec_ret = SSL_TICKET_RETURN_USE;
+        break;
+
+    case 6:
+    case 7:
+        tick_dec_ret = SSL_TICKET_RETURN_USE_RENEW;
+        break;
+
+    default:
+        tick_dec_ret = SSL_TICKET_RETURN_ABORT;
+    }
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(),
+                                       TLS1_VERSION,
+                                       ((tst % 2) == 0) ? TLS1_2_VERSION
+                                                        : TLS1_3_VERSION,
+                                       &sctx, &cctx, cert, privkey)))
+        goto end;
+
+    /*
+     * We only want sessions to resume from tickets - not the session cache. So
+     * switch the cache off.
+     */
+    if (!TEST_true(SSL_CTX_set_session_cache_mode(sctx, SSL_SESS_CACHE_OFF)))
+        goto end;
+
+    if (!TEST_true(SSL_CTX_set_session_ticket_cb(sctx, gen_tick_cb, dec_tick_cb,
+                                                 NULL)))
+        goto end;
+
+    if (tst >= 8
+            && !TEST_true(SSL_CTX_set_tlsext_ticket_key_cb(sctx, tick_key_cb)))
+        goto end;
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                             NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE)))
+        goto end;
+
+    /*
+     * The decrypt ticket key callback in TLSv1.2 should be called even though
+     * we have no ticket yet, because it gets called with a status of
+     * SSL_TICKET_EMPTY (the client indicates support for tickets but does not
+     * actually send any ticket data). This does not happen in TLSv1.3 because
+     * it is not valid to send empty ticket data in TLSv1.3.
+     */
+    if (!TEST_int_eq(gen_tick_called, 1)
+            || !TEST_int_eq(dec_tick_called, ((tst % 2) == 0) ? 1 : 0))
+        goto end;
+
+    gen_tick_called = dec_tick_called = 0;
+
+    clntsess = SSL_get1_session(clientssl);
+    SSL_shutdown(clientssl);
+    SSL_shutdown(serverssl);
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    serverssl = clientssl = NULL;
+
+    /* Now do a resumption */
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl, NULL,
+                                      NULL))
+            || !TEST_true(SSL_set_session(clientssl, clntsess))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE)))
+        goto end;
+
+    if (tick_dec_ret == SSL_TICKET_RETURN_IGNORE
+            || tick_dec_ret == SSL_TICKET_RETURN_IGNORE_RENEW) {
+        if (!TEST_false(SSL_session_reused(clientssl)))
+            goto end;
+    } else {
+        if (!TEST_true(SSL_session_reused(clientssl)))
+            goto end;
+    }
+
+    if (!TEST_int_eq(gen_tick_called,
+                     (tick_key_renew
+                      || tick_dec_ret == SSL_TICKET_RETURN_IGNORE_RENEW
+                      || tick_dec_ret == SSL_TICKET_RETURN_USE_RENEW)
+                     ? 1 : 0)
+            || !TEST_int_eq(dec_tick_called, 1))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_SESSION_free(clntsess);
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+
+/*
+ * Test bi-directional shutdown.
+ * Test 0: TLSv1.2
+ * Test 1: TLSv1.2, server continues to read/write after client shutdown
+ * Test 2: TLSv1.3, no pending NewSessionTicket messages
+ * Test 3: TLSv1.3, pending NewSessionTicket messages
+ * Test 4: TLSv1.3, server continues to read/write after client shutdown, server
+ *                  sends key update, client reads it
+ * Test 5: TLSv1.3, server continues to read/write after client shutdown, server
+ *                  sends CertificateRequest, client reads and ignores it
+ * Test 6: TLSv1.3, server continues to read/write after client shutdown, client
+ *                  doesn't read it
+ */
+static int test_shutdown(int tst)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int testresult = 0;
+    char msg[] = "A test message";
+    char buf[80];
+    size_t written, readbytes;
+    SSL_SESSION *sess;
+
+#ifdef OPENSSL_NO_TLS1_2
+    if (tst <= 1)
+        return 1;
+#endif
+#ifdef OPENSSL_NO_TLS1_3
+    if (tst >= 2)
+        return 1;
+#endif
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(),
+                                       TLS1_VERSION,
+                                       (tst <= 1) ? TLS1_2_VERSION
+                                                  : TLS1_3_VERSION,
+                                       &sctx, &cctx, cert, privkey)))
+        goto end;
+
+    if (tst == 5)
+        SSL_CTX_set_post_handshake_auth(cctx, 1);
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                             NULL, NULL)))
+        goto end;
+
+    if (tst == 3) {
+        if (!TEST_true(create_bare_ssl_connection(serverssl, clientssl,
+                                                  SSL_ERROR_NONE, 1))
+                || !TEST_ptr_ne(sess = SSL_get_session(clientssl), NULL)
+                || !TEST_false(SSL_SESSION_is_resumable(sess)))
+            goto end;
+    } else if (!TEST_true(create_ssl_connection(serverssl, clientssl,
+                                              SSL_ERROR_NONE))
+            || !TEST_ptr_ne(sess = SSL_get_session(clientssl), NULL)
+            || !TEST_true(SSL_SESSION_is_resumable(sess))) {
+        goto end;
+    }
+
+    if (!TEST_int_eq(SSL_shutdown(clientssl), 0))
+        goto end;
+
+    if (tst >= 4) {
+        /*
+         * Reading on the server after the client has sent close_notify should
+         * fail and provide SSL_ERROR_ZERO_RETURN
+         */
+        if (!TEST_false(SSL_read_ex(serverssl, buf, sizeof(buf), &readbytes))
+                || !TEST_int_eq(SSL_get_error(serverssl, 0),
+                                SSL_ERROR_ZERO_RETURN)
+                || !TEST_int_eq(SSL_get_shutdown(serverssl),
+                                SSL_RECEIVED_SHUTDOWN)
+                   /*
+                    * Even though we're shutdown on receive we should still be
+                    * able to write.
+                    */
+                || !TEST_true(SSL_write(serverssl, msg, sizeof(msg))))
+            goto end;
+        if (tst == 4
+                && !TEST_true(SSL_key_update(serverssl,
+                                             SSL_KEY_UPDATE_REQUESTED)))
+            goto end;
+        if (tst == 5) {
             SSL_set_verify(serverssl, SSL_VERIFY_PEER, NULL);
             if (!TEST_true(SSL_verify_client_post_handshake(serverssl)))
                 goto end;
         }
-        if ((tst == 4 || tst == 5)
-                && !TEST_true(SSL_write(serverssl, msg, sizeof(msg))))
+        if ((tst == 4 || tst == 5)
+                && !TEST_true(SSL_write(serverssl, msg, sizeof(msg))))
+            goto end;
+        if (!TEST_int_eq(SSL_shutdown(serverssl), 1))
+            goto end;
+        if (tst == 4 || tst == 5) {
+            /* Should still be able to read data from server */
+            if (!TEST_true(SSL_read_ex(clientssl, buf, sizeof(buf),
+                                       &readbytes))
+                    || !TEST_size_t_eq(readbytes, sizeof(msg))
+                    || !TEST_int_eq(memcmp(msg, buf, readbytes), 0)
+                    || !TEST_true(SSL_read_ex(clientssl, buf, sizeof(buf),
+                                              &readbytes))
+                    || !TEST_size_t_eq(readbytes, sizeof(msg))
+                    || !TEST_int_eq(memcmp(msg, buf, readbytes), 0))
+                goto end;
+        }
+    }
+
+    /* Writing on the client after sending close_notify shouldn't be possible */
+    if (!TEST_false(SSL_write_ex(clientssl, msg, sizeof(msg), &written)))
+        goto end;
+
+    if (tst < 4) {
+        /*
+         * For these tests the client has sent close_notify but it has not yet
+         * been received by the server. The server has not sent close_notify
+         * yet.
+         */
+        if (!TEST_int_eq(SSL_shutdown(serverssl), 0)
+                   /*
+                    * Writing on the server after sending close_notify shouldn't
+                    * be possible.
+                    */
+                || !TEST_false(SSL_write_ex(serverssl, msg, sizeof(msg), &written))
+                || !TEST_int_eq(SSL_shutdown(clientssl), 1)
+                || !TEST_ptr_ne(sess = SSL_get_session(clientssl), NULL)
+                || !TEST_true(SSL_SESSION_is_resumable(sess))
+                || !TEST_int_eq(SSL_shutdown(serverssl), 1))
+            goto end;
+    } else if (tst == 4 || tst == 5) {
+        /*
+         * In this test the client has sent close_notify and it has been
+         * received by the server which has responded with a close_notify. The
+         * client needs to read the close_notify sent by the server.
+         */
+        if (!TEST_int_eq(SSL_shutdown(clientssl), 1)
+                || !TEST_ptr_ne(sess = SSL_get_session(clientssl), NULL)
+                || !TEST_true(SSL_SESSION_is_resumable(sess)))
+            goto end;
+    } else {
+        /*
+         * tst == 6
+         *
+         * The client has sent close_notify and is expecting a close_notify
+         * back, but instead there is application data first. The shutdown
+         * should fail with a fatal error.
+         */
+        if (!TEST_int_eq(SSL_shutdown(clientssl), -1)
+                || !TEST_int_eq(SSL_get_error(clientssl, -1), SSL_ERROR_SSL))
+            goto end;
+    }
+
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+
+#if !defined(OPENSSL_NO_TLS1_2) || !defined(OPENSSL_NO_TLS1_3)
+static int cert_cb_cnt;
+
+static int cert_cb(SSL *s, void *arg)
+{
+    SSL_CTX *ctx = (SSL_CTX *)arg;
+    BIO *in = NULL;
+    EVP_PKEY *pkey = NULL;
+    X509 *x509 = NULL, *rootx = NULL;
+    STACK_OF(X509) *chain = NULL;
+    char *rootfile = NULL, *ecdsacert = NULL, *ecdsakey = NULL;
+    int ret = 0;
+
+    if (cert_cb_cnt == 0) {
+        /* Suspend the handshake */
+        cert_cb_cnt++;
+        return -1;
+    } else if (cert_cb_cnt == 1) {
+        /*
+         * Update the SSL_CTX, set the certificate and private key and then
+         * continue the handshake normally.
+         */
+        if (ctx != NULL && !TEST_ptr(SSL_set_SSL_CTX(s, ctx)))
+            return 0;
+
+        if (!TEST_true(SSL_use_certificate_file(s, cert, SSL_FILETYPE_PEM))
+                || !TEST_true(SSL_use_PrivateKey_file(s, privkey,
+                                                      SSL_FILETYPE_PEM))
+                || !TEST_true(SSL_check_private_key(s)))
+            return 0;
+        cert_cb_cnt++;
+        return 1;
+    } else if (cert_cb_cnt == 3) {
+        int rv;
+
+        rootfile = test_mk_file_path(certsdir, "rootcert.pem");
+        ecdsacert = test_mk_file_path(certsdir, "server-ecdsa-cert.pem");
+        ecdsakey = test_mk_file_path(certsdir, "server-ecdsa-key.pem");
+        if (!TEST_ptr(rootfile) || !TEST_ptr(ecdsacert) || !TEST_ptr(ecdsakey))
+            goto out;
+        chain = sk_X509_new_null();
+        if (!TEST_ptr(chain))
+            goto out;
+        if (!TEST_ptr(in = BIO_new(BIO_s_file()))
+                || !TEST_int_ge(BIO_read_filename(in, rootfile), 0)
+                || !TEST_ptr(rootx = PEM_read_bio_X509(in, NULL, NULL, NULL))
+                || !TEST_true(sk_X509_push(chain, rootx)))
+            goto out;
+        rootx = NULL;
+        BIO_free(in);
+        if (!TEST_ptr(in = BIO_new(BIO_s_file()))
+                || !TEST_int_ge(BIO_read_filename(in, ecdsacert), 0)
+                || !TEST_ptr(x509 = PEM_read_bio_X509(in, NULL, NULL, NULL)))
+            goto out;
+        BIO_free(in);
+        if (!TEST_ptr(in = BIO_new(BIO_s_file()))
+                || !TEST_int_ge(BIO_read_filename(in, ecdsakey), 0)
+                || !TEST_ptr(pkey = PEM_read_bio_PrivateKey(in, NULL, NULL, NULL)))
+            goto out;
+        rv = SSL_check_chain(s, x509, pkey, chain);
+        /*
+         * If the cert doesn't show as valid here (e.g., because we don't
+         * have any shared sigalgs), then we will not set it, and there will
+         * be no certificate at all on the SSL or SSL_CTX.  This, in turn,
+         * will cause tls_choose_sigalgs() to fail the connection.
+         */
+        if ((rv & (CERT_PKEY_VALID | CERT_PKEY_CA_SIGNATURE))
+                == (CERT_PKEY_VALID | CERT_PKEY_CA_SIGNATURE)) {
+            if (!SSL_use_cert_and_key(s, x509, pkey, NULL, 1))
+                goto out;
+        }
+
+        ret = 1;
+    }
+
+    /* Abort the handshake */
+ out:
+    OPENSSL_free(ecdsacert);
+    OPENSSL_free(ecdsakey);
+    OPENSSL_free(rootfile);
+    BIO_free(in);
+    EVP_PKEY_free(pkey);
+    X509_free(x509);
+    X509_free(rootx);
+    sk_X509_pop_free(chain, X509_free);
+    return ret;
+}
+
+/*
+ * Test the certificate callback.
+ * Test 0: Callback fails
+ * Test 1: Success - no SSL_set_SSL_CTX() in the callback
+ * Test 2: Success - SSL_set_SSL_CTX() in the callback
+ * Test 3: Success - Call SSL_check_chain from the callback
+ * Test 4: Failure - SSL_check_chain fails from callback due to bad cert in the
+ *                   chain
+ * Test 5: Failure - SSL_check_chain fails from callback due to bad ee cert
+ */
+static int test_cert_cb_int(int prot, int tst)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL, *snictx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int testresult = 0, ret;
+
+#ifdef OPENSSL_NO_EC
+    /* We use an EC cert in these tests, so we skip in a no-ec build */
+    if (tst >= 3)
+        return 1;
+#endif
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(),
+                                       TLS1_VERSION,
+                                       prot,
+                                       &sctx, &cctx, NULL, NULL)))
+        goto end;
+
+    if (tst == 0)
+        cert_cb_cnt = -1;
+    else if (tst >= 3)
+        cert_cb_cnt = 3;
+    else
+        cert_cb_cnt = 0;
+
+    if (tst == 2)
+        snictx = SSL_CTX_new(TLS_server_method());
+    SSL_CTX_set_cert_cb(sctx, cert_cb, snictx);
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL)))
+        goto end;
+
+    if (tst == 4) {
+        /*
+         * We cause SSL_check_chain() to fail by specifying sig_algs that
+         * the chain doesn't meet (the root uses an RSA cert)
+         */
+        if (!TEST_true(SSL_set1_sigalgs_list(clientssl,
+                                             "ecdsa_secp256r1_sha256")))
+            goto end;
+    } else if (tst == 5) {
+        /*
+         * We cause SSL_check_chain() to fail by specifying sig_algs that
+         * the ee cert doesn't meet (the ee uses an ECDSA cert)
+         */
+        if (!TEST_true(SSL_set1_sigalgs_list(clientssl,
+                           "rsa_pss_rsae_sha256:rsa_pkcs1_sha256")))
+            goto end;
+    }
+
+    ret = create_ssl_connection(serverssl, clientssl, SSL_ERROR_NONE);
+    if (!TEST_true(tst == 0 || tst == 4 || tst == 5 ? !ret : ret)
+            || (tst > 0
+                && !TEST_int_eq((cert_cb_cnt - 2) * (cert_cb_cnt - 3), 0))) {
+        goto end;
+    }
+
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    SSL_CTX_free(snictx);
+
+    return testresult;
+}
+#endif
+
+static int test_cert_cb(int tst)
+{
+    int testresult = 1;
+
+#ifndef OPENSSL_NO_TLS1_2
+    testresult &= test_cert_cb_int(TLS1_2_VERSION, tst);
+#endif
+#ifndef OPENSSL_NO_TLS1_3
+    testresult &= test_cert_cb_int(TLS1_3_VERSION, tst);
+#endif
+
+    return testresult;
+}
+
+static int client_cert_cb(SSL *ssl, X509 **x509, EVP_PKEY **pkey)
+{
+    X509 *xcert, *peer;
+    EVP_PKEY *privpkey;
+    BIO *in = NULL;
+
+    /* Check that SSL_get_peer_certificate() returns something sensible */
+    peer = SSL_get_peer_certificate(ssl);
+    if (!TEST_ptr(peer))
+        return 0;
+    X509_free(peer);
+
+    in = BIO_new_file(cert, "r");
+    if (!TEST_ptr(in))
+        return 0;
+
+    xcert = PEM_read_bio_X509(in, NULL, NULL, NULL);
+    BIO_free(in);
+    if (!TEST_ptr(xcert))
+        return 0;
+
+    in = BIO_new_file(privkey, "r");
+    if (!TEST_ptr(in)) {
+        X509_free(xcert);
+        return 0;
+    }
+
+    privpkey = PEM_read_bio_PrivateKey(in, NULL, NULL, NULL);
+    BIO_free(in);
+    if (!TEST_ptr(privpkey)) {
+        X509_free(xcert);
+        return 0;
+    }
+
+    *x509 = xcert;
+    *pkey = privpkey;
+
+    return 1;
+}
+
+static int test_client_cert_cb(int tst)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int testresult = 0;
+
+#ifdef OPENSSL_NO_TLS1_2
+    if (tst == 0)
+        return 1;
+#endif
+#ifdef OPENSSL_NO_TLS1_3
+    if (tst == 1)
+        return 1;
+#endif
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(),
+                                       TLS1_VERSION,
+                                       tst == 0 ? TLS1_2_VERSION
+                                                : TLS1_3_VERSION,
+                                       &sctx, &cctx, cert, privkey)))
+        goto end;
+
+    /*
+     * Test that setting a client_cert_cb results in a client certificate being
+     * sent.
+     */
+    SSL_CTX_set_client_cert_cb(cctx, client_cert_cb);
+    SSL_CTX_set_verify(sctx,
+                       SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT,
+                       verify_cb);
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE)))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+
+#if !defined(OPENSSL_NO_TLS1_2) || !defined(OPENSSL_NO_TLS1_3)
+/*
+ * Test setting certificate authorities on both client and server.
+ *
+ * Test 0: SSL_CTX_set0_CA_list() only
+ * Test 1: Both SSL_CTX_set0_CA_list() and SSL_CTX_set_client_CA_list()
+ * Test 2: Only SSL_CTX_set_client_CA_list()
+ */
+static int test_ca_names_int(int prot, int tst)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int testresult = 0;
+    size_t i;
+    X509_NAME *name[] = { NULL, NULL, NULL, NULL };
+    char *strnames[] = { "Jack", "Jill", "John", "Joanne" };
+    STACK_OF(X509_NAME) *sk1 = NULL, *sk2 = NULL;
+    const STACK_OF(X509_NAME) *sktmp = NULL;
+
+    for (i = 0; i < OSSL_NELEM(name); i++) {
+        name[i] = X509_NAME_new();
+        if (!TEST_ptr(name[i])
+                || !TEST_true(X509_NAME_add_entry_by_txt(name[i], "CN",
+                                                         MBSTRING_ASC,
+                                                         (unsigned char *)
+                                                         strnames[i],
+                                                         -1, -1, 0)))
+            goto end;
+    }
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(),
+                                       TLS1_VERSION,
+                                       prot,
+                                       &sctx, &cctx, cert, privkey)))
+        goto end;
+
+    SSL_CTX_set_verify(sctx, SSL_VERIFY_PEER, NULL);
+
+    if (tst == 0 || tst == 1) {
+        if (!TEST_ptr(sk1 = sk_X509_NAME_new_null())
+                || !TEST_true(sk_X509_NAME_push(sk1, X509_NAME_dup(name[0])))
+                || !TEST_true(sk_X509_NAME_push(sk1, X509_NAME_dup(name[1])))
+                || !TEST_ptr(sk2 = sk_X509_NAME_new_null())
+                || !TEST_true(sk_X509_NAME_push(sk2, X509_NAME_dup(name[0])))
+                || !TEST_true(sk_X509_NAME_push(sk2, X509_NAME_dup(name[1]))))
+            goto end;
+
+        SSL_CTX_set0_CA_list(sctx, sk1);
+        SSL_CTX_set0_CA_list(cctx, sk2);
+        sk1 = sk2 = NULL;
+    }
+    if (tst == 1 || tst == 2) {
+        if (!TEST_ptr(sk1 = sk_X509_NAME_new_null())
+                || !TEST_true(sk_X509_NAME_push(sk1, X509_NAME_dup(name[2])))
+                || !TEST_true(sk_X509_NAME_push(sk1, X509_NAME_dup(name[3])))
+                || !TEST_ptr(sk2 = sk_X509_NAME_new_null())
+                || !TEST_true(sk_X509_NAME_push(sk2, X509_NAME_dup(name[2])))
+                || !TEST_true(sk_X509_NAME_push(sk2, X509_NAME_dup(name[3]))))
+            goto end;
+
+        SSL_CTX_set_client_CA_list(sctx, sk1);
+        SSL_CTX_set_client_CA_list(cctx, sk2);
+        sk1 = sk2 = NULL;
+    }
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE)))
+        goto end;
+
+    /*
+     * We only expect certificate authorities to have been sent to the server
+     * if we are using TLSv1.3 and SSL_set0_CA_list() was used
+     */
+    sktmp = SSL_get0_peer_CA_list(serverssl);
+    if (prot == TLS1_3_VERSION
+            && (tst == 0 || tst == 1)) {
+        if (!TEST_ptr(sktmp)
+                || !TEST_int_eq(sk_X509_NAME_num(sktmp), 2)
+                || !TEST_int_eq(X509_NAME_cmp(sk_X509_NAME_value(sktmp, 0),
+                                              name[0]), 0)
+                || !TEST_int_eq(X509_NAME_cmp(sk_X509_NAME_value(sktmp, 1),
+                                              name[1]), 0))
+            goto end;
+    } else if (!TEST_ptr_null(sktmp)) {
+        goto end;
+    }
+
+    /*
+     * In all tests we expect certificate authorities to have been sent to the
+     * client. However, SSL_set_client_CA_list() should override
+     * SSL_set0_CA_list()
+     */
+    sktmp = SSL_get0_peer_CA_list(clientssl);
+    if (!TEST_ptr(sktmp)
+            || !TEST_int_eq(sk_X509_NAME_num(sktmp), 2)
+            || !TEST_int_eq(X509_NAME_cmp(sk_X509_NAME_value(sktmp, 0),
+                                          name[tst == 0 ? 0 : 2]), 0)
+            || !TEST_int_eq(X509_NAME_cmp(sk_X509_NAME_value(sktmp, 1),
+                                          name[tst == 0 ? 1 : 3]), 0))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    for (i = 0; i < OSSL_NELEM(name); i++)
+        X509_NAME_free(name[i]);
+    sk_X509_NAME_pop_free(sk1, X509_NAME_free);
+    sk_X509_NAME_pop_free(sk2, X509_NAME_free);
+
+    return testresult;
+}
+#endif
+
+static int test_ca_names(int tst)
+{
+    int testresult = 1;
+
+#ifndef OPENSSL_NO_TLS1_2
+    testresult &= test_ca_names_int(TLS1_2_VERSION, tst);
+#endif
+#ifndef OPENSSL_NO_TLS1_3
+    testresult &= test_ca_names_int(TLS1_3_VERSION, tst);
+#endif
+
+    return testresult;
+}
+
+#ifndef OPENSSL_NO_TLS1_3
+/*
+ * Connect and check that the client received the first |num| names of
+ * |expect|.
+ */
+static int ca_names_cache_connect(SSL_CTX *sctx, SSL_CTX *cctx,
+                                  const STACK_OF(X509_NAME) *expect, int num)
+{
+    SSL *clientssl = NULL, *serverssl = NULL;
+    const STACK_OF(X509_NAME) *sktmp;
+    int i, testresult = 0;
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_ptr(sktmp = SSL_get0_peer_CA_list(clientssl))
+            || !TEST_int_eq(sk_X509_NAME_num(sktmp), num))
+        goto end;
+    for (i = 0; i < num; i++)
+        if (!TEST_int_eq(X509_NAME_cmp(sk_X509_NAME_value(sktmp, i),
+                                       sk_X509_NAME_value(expect, i)), 0))
+            goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    return testresult;
+}
+
+/*
+ * Test that the encoding of a large client CA list is reused, that it picks
+ * up names added to the list and that SSL_CTX_set_max_ca_names_len() leaves
+ * out the names beyond the limit.
+ */
+static int test_ca_names_cache(void)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    STACK_OF(X509_NAME) *sk = NULL;
+    const STACK_OF(X509_NAME) *list;
+    X509_NAME *name = NULL;
+    X509 *x;
+    char buf[32];
+    size_t len = 0;
+    int i, n, testresult = 0;
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(),
+                                       TLS1_3_VERSION, TLS1_3_VERSION,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_ptr(sk = sk_X509_NAME_new_null()))
+        goto end;
+    SSL_CTX_set_verify(sctx, SSL_VERIFY_PEER, NULL);
+
+    for (i = 0; i < 400; i++) {
+        BIO_snprintf(buf, sizeof(buf), "Client CA %d", i);
+        if (!TEST_ptr(name = X509_NAME_new())
+                || !TEST_true(X509_NAME_add_entry_by_txt(name, "CN",
+                                                         MBSTRING_ASC,
+                                                         (unsigned char *)buf,
+                                                         -1, -1, 0))
+                || !TEST_true(sk_X509_NAME_push(sk, name)))
+            goto end;
+        name = NULL;
+    }
+    SSL_CTX_set_client_CA_list(sctx, sk);
+    sk = NULL;
+    list = SSL_CTX_get_client_CA_list(sctx);
+
+    /* The second connection sends the encoding made for the first */
+    if (!TEST_true(ca_names_cache_connect(sctx, cctx, list, 400))
+            || !TEST_true(ca_names_cache_connect(sctx, cctx, list, 400)))
+        goto end;
+
+    SSL_CTX_set_max_ca_names_len(sctx, 1000);
+    if (!TEST_size_t_eq(SSL_CTX_get_max_ca_names_len(sctx), 1000))
+        goto end;
+    for (n = 0; n < sk_X509_NAME_num(list); n++) {
+        len += 2 + i2d_X509_NAME(sk_X509_NAME_value(list, n), NULL);
+        if (len > 1000)
+            break;
+    }
+    if (!TEST_int_gt(n, 0)
+            || !TEST_int_lt(n, 400)
+            || !TEST_true(ca_names_cache_connect(sctx, cctx, list, n)))
+        goto end;
+
+    SSL_CTX_set_max_ca_names_len(sctx, 0);
+    x = SSL_CTX_get0_certificate(sctx);
+    if (!TEST_true(SSL_CTX_add_client_CA(sctx, x))
+            || !TEST_true(ca_names_cache_connect(sctx, cctx, list, 401))
+            || !TEST_int_eq(X509_NAME_cmp(sk_X509_NAME_value(list, 400),
+                                          X509_get_subject_name(x)), 0))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    X509_NAME_free(name);
+    sk_X509_NAME_pop_free(sk, X509_NAME_free);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return testresult;
+}
+#endif
+
+#if !defined(OPENSSL_NO_DTLS1_2) && !defined(OPENSSL_NO_EC)
+static unsigned char cid_hdr[DTLS1_RT_HEADER_LENGTH + DTLS1_MAX_CID_LENGTH];
+static size_t cid_hdr_len;
+
+static void cid_hdr_cb(int write_p, int version, int content_type,
+                       const void *buf, size_t len, SSL *ssl, void *arg)
+{
+    if (write_p && content_type == SSL3_RT_HEADER && len <= sizeof(cid_hdr)) {
+        memcpy(cid_hdr, buf, len);
+        cid_hdr_len = len;
+    }
+}
+
+/*
+ * Test DTLS connection IDs
+ * Test 0: AES-GCM
+ * Test 1: AES-CCM8
+ * Test 2: ChaCha20-Poly1305
+ * Test 3: AES-CBC, which gets no connection IDs
+ */
+static int test_dtls_cid(int tst)
+{
+    static const char *ciphers[] = {
+        "ECDHE-RSA-AES128-GCM-SHA256",
+        "AES128-CCM8",
+        "ECDHE-RSA-CHACHA20-POLY1305",
+        "ECDHE-RSA-AES128-SHA"
+    };
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL, *found = NULL;
+    const unsigned char *cid, *peer_cid, *rec_cid;
+    size_t cid_len, peer_cid_len, written, readbytes;
+    char msg[] = "A test message", buf[80];
+    int testresult = 0;
+
+#ifdef OPENSSL_NO_CHACHA
+    if (tst == 2)
+        return 1;
+#endif
+    if (!TEST_true(create_ssl_ctx_pair(DTLS_server_method(),
+                                       DTLS_client_method(),
+                                       DTLS1_2_VERSION, DTLS1_2_VERSION,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_true(SSL_CTX_set_cipher_list(sctx, ciphers[tst]))
+            || !TEST_true(SSL_CTX_set_cipher_list(cctx, ciphers[tst]))
+            || !TEST_int_eq(SSL_CTX_get_dtls_cid_len(sctx), -1)
+            || !TEST_false(SSL_CTX_set_dtls_cid_len(sctx, 256))
+            || !TEST_true(SSL_CTX_set_dtls_cid_len(sctx, 8))
+            || !TEST_true(SSL_CTX_set_dtls_cid_len(cctx, 4))
+            || !TEST_int_eq(SSL_CTX_get_dtls_cid_len(sctx), 8)
+            || !TEST_true(create_ssl_objects(sctx, cctx, &serverssl,
+                                             &clientssl, NULL, NULL)))
+        goto end;
+    SSL_set_msg_callback(clientssl, cid_hdr_cb);
+    BIO_ctrl(SSL_get_wbio(clientssl), MEMPACKET_CTRL_SET_CID_LEN, 8, NULL);
+    BIO_ctrl(SSL_get_wbio(serverssl), MEMPACKET_CTRL_SET_CID_LEN, 4, NULL);
+
+    if (!TEST_true(create_ssl_connection(serverssl, clientssl,
+                                         SSL_ERROR_NONE)))
+        goto end;
+
+    if (tst == 3) {
+        if (!TEST_false(SSL_get0_dtls_cid(serverssl, &cid, &cid_len))
+                || !TEST_false(SSL_get0_peer_dtls_cid(clientssl, &peer_cid,
+                                                      &peer_cid_len)))
+            goto end;
+    } else {
+        if (!TEST_true(SSL_get0_dtls_cid(serverssl, &cid, &cid_len))
+                || !TEST_size_t_eq(cid_len, 8)
+                || !TEST_true(SSL_get0_peer_dtls_cid(clientssl, &peer_cid,
+                                                     &peer_cid_len))
+                || !TEST_mem_eq(cid, cid_len, peer_cid, peer_cid_len)
+                || !TEST_true(SSL_get0_dtls_cid(clientssl, &cid, &cid_len))
+                || !TEST_size_t_eq(cid_len, 4)
+                || !TEST_true(SSL_get0_peer_dtls_cid(serverssl, &peer_cid,
+                                                     &peer_cid_len))
+                || !TEST_mem_eq(cid, cid_len, peer_cid, peer_cid_len))
+            goto end;
+    }
+
+    if (!TEST_true(SSL_write_ex(clientssl, msg, sizeof(msg), &written))
+            || !TEST_true(SSL_read_ex(serverssl, buf, sizeof(buf), &readbytes))
+            || !TEST_mem_eq(buf, readbytes, msg, sizeof(msg))
+            || !TEST_true(SSL_write_ex(serverssl, msg, sizeof(msg), &written))
+            || !TEST_true(SSL_read_ex(clientssl, buf, sizeof(buf), &readbytes))
+            || !TEST_mem_eq(buf, readbytes, msg, sizeof(msg)))
+        goto end;
+
+    /* The header of the last record the client sent finds the server */
+    found = SSL_CTX_get1_ssl_by_dtls_cid(sctx, cid_hdr, cid_hdr_len);
+    if (tst == 3) {
+        if (!TEST_ptr_null(found)
+                || !TEST_false(DTLS_get0_record_cid(cid_hdr, cid_hdr_len, 8,
+                                                    &rec_cid)))
+            goto end;
+    } else {
+        if (!TEST_ptr_eq(found, serverssl)
+                || !TEST_true(SSL_get0_dtls_cid(serverssl, &cid, &cid_len))
+                || !TEST_true(DTLS_get0_record_cid(cid_hdr, cid_hdr_len, 8,
+                                                   &rec_cid))
+                || !TEST_mem_eq(rec_cid, 8, cid, cid_len))
+            goto end;
+    }
+
+    testresult = 1;
+
+ end:
+    SSL_free(found);
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return testresult;
+}
+#endif
+
+#ifndef OPENSSL_NO_DTLS1_2
+#define REPLAY_TEST_RECORDS     100
+
+/*
+ * Test that records arriving later than the replay window are dropped and
+ * that DTLS_set_replay_window() lets more of them through
+ * Test 0: Default window of 64 records
+ * Test 1: Window of 128 records
+ */
+static int test_dtls_replay_window(int tst)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    unsigned char (*pkts)[256] = NULL;
+    int lens[REPLAY_TEST_RECORDS];
+    unsigned char buf[16];
+    size_t written, readbytes;
+    BIO *c_to_s;
+    int i, num = 0, testresult = 0;
+
+    if (!TEST_true(create_ssl_ctx_pair(DTLS_server_method(),
+                                       DTLS_client_method(),
+                                       DTLS1_2_VERSION, DTLS1_2_VERSION,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_ptr(pkts = OPENSSL_malloc(REPLAY_TEST_RECORDS
+                                               * sizeof(*pkts)))
+            || !TEST_true(create_ssl_objects(sctx, cctx, &serverssl,
+                                             &clientssl, NULL, NULL))
+            || !TEST_long_eq(DTLS_get_replay_window(serverssl), 64)
+            || !TEST_false(DTLS_set_replay_window(serverssl, 0))
+            || !TEST_false(DTLS_set_replay_window(serverssl,
+                                                  DTLS1_MAX_REPLAY_WINDOW + 1)))
+        goto end;
+    if (tst == 1
+            && (!TEST_true(DTLS_set_replay_window(serverssl, 100))
+                || !TEST_long_eq(DTLS_get_replay_window(serverssl), 128)))
+        goto end;
+    if (!TEST_true(create_ssl_connection(serverssl, clientssl,
+                                         SSL_ERROR_NONE)))
+        goto end;
+
+    /* Deliver the records newest first */
+    c_to_s = SSL_get_wbio(clientssl);
+    for (i = 0; i < REPLAY_TEST_RECORDS; i++) {
+        buf[0] = (unsigned char)i;
+        if (!TEST_true(SSL_write_ex(clientssl, buf, 1, &written))
+                || !TEST_int_gt(lens[i] = BIO_read(c_to_s, pkts[i],
+                                                   sizeof(pkts[i])), 0))
+            goto end;
+    }
+    for (i = REPLAY_TEST_RECORDS - 1; i >= 0; i--)
+        if (!TEST_int_eq(BIO_write(c_to_s, pkts[i], lens[i]), lens[i]))
+            goto end;
+
+    while (SSL_read_ex(serverssl, buf, sizeof(buf), &readbytes)) {
+        if (!TEST_size_t_eq(readbytes, 1)
+                || !TEST_int_eq(buf[0], REPLAY_TEST_RECORDS - 1 - num))
+            goto end;
+        num++;
+    }
+    if (!TEST_int_eq(num, tst == 0 ? 64 : REPLAY_TEST_RECORDS))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    OPENSSL_free(pkts);
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return testresult;
+}
+#endif
+
+/*
+ * Test 0: Client sets servername and server acknowledges it (TLSv1.2)
+ * Test 1: Client sets servername and server does not acknowledge it (TLSv1.2)
+ * Test 2: Client sets inconsistent servername on resumption (TLSv1.2)
+ * Test 3: Client does not set servername on initial handshake (TLSv1.2)
+ * Test 4: Client does not set servername on resumption handshake (TLSv1.2)
+ * Test 5: Client sets servername and server acknowledges it (TLSv1.3)
+ * Test 6: Client sets servername and server does not acknowledge it (TLSv1.3)
+ * Test 7: Client sets inconsistent servername on resumption (TLSv1.3)
+ * Test 8: Client does not set servername on initial handshake(TLSv1.3)
+ * Test 9: Client does not set servername on resumption handshake (TLSv1.3)
+ */
+static int test_servername(int tst)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int testresult = 0;
+    SSL_SESSION *sess = NULL;
+    const char *sexpectedhost = NULL, *cexpectedhost = NULL;
+
+#ifdef OPENSSL_NO_TLS1_2
+    if (tst <= 4)
+        return 1;
+#endif
+#ifdef OPENSSL_NO_TLS1_3
+    if (tst >= 5)
+        return 1;
+#endif
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(),
+                                       TLS1_VERSION,
+                                       (tst <= 4) ? TLS1_2_VERSION
+                                                  : TLS1_3_VERSION,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                             NULL, NULL)))
+        goto end;
+
+    if (tst != 1 && tst != 6) {
+        if (!TEST_true(SSL_CTX_set_tlsext_servername_callback(sctx,
+                                                              hostname_cb)))
+            goto end;
+    }
+
+    if (tst != 3 && tst != 8) {
+        if (!TEST_true(SSL_set_tlsext_host_name(clientssl, "goodhost")))
+            goto end;
+        sexpectedhost = cexpectedhost = "goodhost";
+    }
+
+    if (!TEST_true(create_ssl_connection(serverssl, clientssl, SSL_ERROR_NONE)))
+        goto end;
+
+    if (!TEST_str_eq(SSL_get_servername(clientssl, TLSEXT_NAMETYPE_host_name),
+                     cexpectedhost)
+            || !TEST_str_eq(SSL_get_servername(serverssl,
+                                               TLSEXT_NAMETYPE_host_name),
+                            sexpectedhost))
+        goto end;
+
+    /* Now repeat with a resumption handshake */
+
+    if (!TEST_int_eq(SSL_shutdown(clientssl), 0)
+            || !TEST_ptr_ne(sess = SSL_get1_session(clientssl), NULL)
+            || !TEST_true(SSL_SESSION_is_resumable(sess))
+            || !TEST_int_eq(SSL_shutdown(serverssl), 0))
+        goto end;
+
+    SSL_free(clientssl);
+    SSL_free(serverssl);
+    clientssl = serverssl = NULL;
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl, NULL,
+                                      NULL)))
+        goto end;
+
+    if (!TEST_true(SSL_set_session(clientssl, sess)))
+        goto end;
+
+    sexpectedhost = cexpectedhost = "goodhost";
+    if (tst == 2 || tst == 7) {
+        /* Set an inconsistent hostname */
+        if (!TEST_true(SSL_set_tlsext_host_name(clientssl, "altgoodhost")))
+            goto end;
+        /*
+         * In TLSv1.2 we expect the hostname from the original handshake, in
+         * TLSv1.3 we expect the hostname from this handshake
+         */
+        if (tst == 7)
+            sexpectedhost = cexpectedhost = "altgoodhost";
+
+        if (!TEST_str_eq(SSL_get_servername(clientssl,
+                                            TLSEXT_NAMETYPE_host_name),
+                         "altgoodhost"))
+            goto end;
+    } else if (tst == 4 || tst == 9) {
+        /*
+         * A TLSv1.3 session does not associate a session with a servername,
+         * but a TLSv1.2 session does.
+         */
+        if (tst == 9)
+            sexpectedhost = cexpectedhost = NULL;
+
+        if (!TEST_str_eq(SSL_get_servername(clientssl,
+                                            TLSEXT_NAMETYPE_host_name),
+                         cexpectedhost))
+            goto end;
+    } else {
+        if (!TEST_true(SSL_set_tlsext_host_name(clientssl, "goodhost")))
+            goto end;
+        /*
+         * In a TLSv1.2 resumption where the hostname was not acknowledged
+         * we expect the hostname on the server to be empty. On the client we
+         * return what was requested in this case.
+         *
+         * Similarly if the client didn't set a hostname on an original TLSv1.2
+         * session but is now, the server hostname will be empty, but the client
+         * is as we set it.
+         */
+        if (tst == 1 || tst == 3)
+            sexpectedhost = NULL;
+
+        if (!TEST_str_eq(SSL_get_servername(clientssl,
+                                            TLSEXT_NAMETYPE_host_name),
+                         "goodhost"))
+            goto end;
+    }
+
+    if (!TEST_true(create_ssl_connection(serverssl, clientssl, SSL_ERROR_NONE)))
+        goto end;
+
+    if (!TEST_true(SSL_session_reused(clientssl))
+            || !TEST_true(SSL_session_reused(serverssl))
+            || !TEST_str_eq(SSL_get_servername(clientssl,
+                                               TLSEXT_NAMETYPE_host_name),
+                            cexpectedhost)
+            || !TEST_str_eq(SSL_get_servername(serverssl,
+                                               TLSEXT_NAMETYPE_host_name),
+                            sexpectedhost))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_SESSION_free(sess);
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+
+#ifndef OPENSSL_NO_TLS1_2
+static int test_ssl_dup(void)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL, *client2ssl = NULL;
+    int testresult = 0;
+    BIO *rbio = NULL, *wbio = NULL;
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(),
+                                       0,
+                                       0,
+                                       &sctx, &cctx, cert, privkey)))
+        goto end;
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                             NULL, NULL)))
+        goto end;
+
+    if (!TEST_true(SSL_set_min_proto_version(clientssl, TLS1_2_VERSION))
+            || !TEST_true(SSL_set_max_proto_version(clientssl, TLS1_2_VERSION)))
+        goto end;
+
+    client2ssl = SSL_dup(clientssl);
+    rbio = SSL_get_rbio(clientssl);
+    if (!TEST_ptr(rbio)
+            || !TEST_true(BIO_up_ref(rbio)))
+        goto end;
+    SSL_set0_rbio(client2ssl, rbio);
+    rbio = NULL;
+
+    wbio = SSL_get_wbio(clientssl);
+    if (!TEST_ptr(wbio) || !TEST_true(BIO_up_ref(wbio)))
+        goto end;
+    SSL_set0_wbio(client2ssl, wbio);
+    rbio = NULL;
+
+    if (!TEST_ptr(client2ssl)
+               /* Handshake not started so pointers should be different */
+            || !TEST_ptr_ne(clientssl, client2ssl))
+        goto end;
+
+    if (!TEST_int_eq(SSL_get_min_proto_version(client2ssl), TLS1_2_VERSION)
+            || !TEST_int_eq(SSL_get_max_proto_version(client2ssl), TLS1_2_VERSION))
+        goto end;
+
+    if (!TEST_true(create_ssl_connection(serverssl, client2ssl, SSL_ERROR_NONE)))
+        goto end;
+
+    SSL_free(clientssl);
+    clientssl = SSL_dup(client2ssl);
+    if (!TEST_ptr(clientssl)
+               /* Handshake has finished so pointers should be the same */
+            || !TEST_ptr_eq(clientssl, client2ssl))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_free(client2ssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+#endif
+
+#ifndef OPENSSL_NO_TLS1_3
+/*
+ * Test that setting an SNI callback works with TLSv1.3. Specifically we check
+ * that it works even without a certificate configured for the original
+ * SSL_CTX
+ */
+static int test_sni_tls13(void)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL, *sctx2 = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int testresult = 0;
+
+    /* Reset callback counter */
+    snicb = 0;
+
+    /* Create an initial SSL_CTX with no certificate configured */
+    sctx = SSL_CTX_new(TLS_server_method());
+    if (!TEST_ptr(sctx))
+        goto end;
+    /* Require TLSv1.3 as a minimum */
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(), TLS_client_method(),
+                                       TLS1_3_VERSION, 0, &sctx2, &cctx, cert,
+                                       privkey)))
+        goto end;
+
+    /* Set up SNI */
+    if (!TEST_true(SSL_CTX_set_tlsext_servername_callback(sctx, sni_cb))
+            || !TEST_true(SSL_CTX_set_tlsext_servername_arg(sctx, sctx2)))
+        goto end;
+
+    /*
+     * Connection should still succeed because the final SSL_CTX has the right
+     * certificates configured.
+     */
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl,
+                                      &clientssl, NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE)))
+        goto end;
+
+    /* We should have had the SNI callback called exactly once */
+    if (!TEST_int_eq(snicb, 1))
+        goto end;
+
+    testresult = 1;
+
+end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx2);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return testresult;
+}
+
+/*
+ * Test that the lifetime hint of a TLSv1.3 ticket is no more than 1 week
+ * 0 = TLSv1.2
+ * 1 = TLSv1.3
+ */
+static int test_ticket_lifetime(int idx)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int testresult = 0;
+    int version = TLS1_3_VERSION;
+
+#define ONE_WEEK_SEC (7 * 24 * 60 * 60)
+#define TWO_WEEK_SEC (2 * ONE_WEEK_SEC)
+
+    if (idx == 0) {
+#ifdef OPENSSL_NO_TLS1_2
+        TEST_info("Skipping: TLS 1.2 is disabled.");
+        return 1;
+#else
+        version = TLS1_2_VERSION;
+#endif
+    }
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(), version, version,
+                                       &sctx, &cctx, cert, privkey)))
+        goto end;
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl,
+                                      &clientssl, NULL, NULL)))
+        goto end;
+
+    /*
+     * Set the timeout to be more than 1 week
+     * make sure the returned value is the default
+     */
+    if (!TEST_long_eq(SSL_CTX_set_timeout(sctx, TWO_WEEK_SEC),
+                      SSL_get_default_timeout(serverssl)))
+        goto end;
+
+    if (!TEST_true(create_ssl_connection(serverssl, clientssl, SSL_ERROR_NONE)))
+        goto end;
+
+    if (idx == 0) {
+        /* TLSv1.2 uses the set value */
+        if (!TEST_ulong_eq(SSL_SESSION_get_ticket_lifetime_hint(SSL_get_session(clientssl)), TWO_WEEK_SEC))
+            goto end;
+    } else {
+        /* TLSv1.3 uses the limited value */
+        if (!TEST_ulong_le(SSL_SESSION_get_ticket_lifetime_hint(SSL_get_session(clientssl)), ONE_WEEK_SEC))
+            goto end;
+    }
+    testresult = 1;
+
+end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return testresult;
+}
+#endif
+/*
+ * Connect to |sctx| offering |sess|, if not NULL. Returns 1 if the session
+ * was resumed, 0 if not and -1 on error; the new session is in |*newsess|.
+ * If |server_peer| is not NULL it is set to whether the server has a peer
+ * certificate.
+ */
+static int ticket_test_connect(SSL_CTX *sctx, SSL_CTX *cctx,
+                               SSL_SESSION *sess, SSL_SESSION **newsess,
+                               int *server_peer)
+{
+    SSL *serverssl = NULL, *clientssl = NULL;
+    X509 *peer;
+    int ret = -1;
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || (sess != NULL && !TEST_true(SSL_set_session(clientssl, sess)))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_ptr(*newsess = SSL_get1_session(clientssl)))
+        goto end;
+    ret = SSL_session_reused(clientssl);
+    if (server_peer != NULL) {
+        peer = SSL_get_peer_certificate(serverssl);
+        *server_peer = peer != NULL;
+        X509_free(peer);
+    }
+    SSL_shutdown(clientssl);
+    SSL_shutdown(serverssl);
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    return ret;
+}
+
+/*
+ * Test that a ticket key ring can be shared by two SSL_CTXs and that
+ * tickets stay valid while their key is in the ring.
+ * Test 0: TLSv1.2
+ * Test 1: TLSv1.3
+ */
+static int test_ticket_key_ring(int idx)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL, *sctx2 = NULL;
+    SSL_SESSION *sess = NULL, *sess2 = NULL, *sess3 = NULL;
+    SSL_TICKET_KEY_RING *ring = NULL, *ring2 = NULL;
+    size_t len = SSL_TICKET_KEY_RING_mem_size(2);
+    unsigned char *mem = NULL;
+    const unsigned char *tick, *tick2;
+    size_t ticklen, ticklen2;
+    int testresult = 0, version = TLS1_3_VERSION;
+
+    if (idx == 0) {
+#ifdef OPENSSL_NO_TLS1_2
+        TEST_info("Skipping: TLS 1.2 is disabled.");
+        return 1;
+#else
+        version = TLS1_2_VERSION;
+#endif
+    } else {
+#ifdef OPENSSL_NO_TLS1_3
+        TEST_info("Skipping: TLS 1.3 is disabled.");
+        return 1;
+#endif
+    }
+
+    if (!TEST_size_t_gt(len, 0)
+            || !TEST_ptr(mem = OPENSSL_zalloc(len))
+            || !TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                              TLS_client_method(), version,
+                                              version, &sctx, &cctx, cert,
+                                              privkey))
+            || !TEST_ptr(sctx2 = SSL_CTX_new(TLS_server_method()))
+            || !TEST_true(SSL_CTX_set_min_proto_version(sctx2, version))
+            || !TEST_true(SSL_CTX_set_max_proto_version(sctx2, version))
+            || !TEST_int_eq(SSL_CTX_use_certificate_file(sctx2, cert,
+                                                         SSL_FILETYPE_PEM), 1)
+            || !TEST_int_eq(SSL_CTX_use_PrivateKey_file(sctx2, privkey,
+                                                        SSL_FILETYPE_PEM), 1))
+        goto end;
+
+    /* The second "process" attaches to the memory the first initialised */
+    if (!TEST_ptr_null(SSL_TICKET_KEY_RING_attach(mem, len))
+            || !TEST_ptr(ring = SSL_TICKET_KEY_RING_new_mem(mem, len, 2, 0))
+            || !TEST_ptr(ring2 = SSL_TICKET_KEY_RING_attach(mem, len))
+            || !TEST_true(SSL_CTX_set1_ticket_key_ring(sctx, ring))
+            || !TEST_true(SSL_CTX_set1_ticket_key_ring(sctx2, ring2))
+            || !TEST_ptr_eq(SSL_CTX_get0_ticket_key_ring(sctx), ring))
+        goto end;
+    SSL_CTX_set_session_cache_mode(sctx, SSL_SESS_CACHE_OFF);
+    SSL_CTX_set_session_cache_mode(sctx2, SSL_SESS_CACHE_OFF);
+
+    if (!TEST_int_eq(ticket_test_connect(sctx, cctx, NULL, &sess, NULL), 0)
+            || !TEST_int_eq(ticket_test_connect(sctx2, cctx, sess, &sess2, NULL), 1))
+        goto end;
+    SSL_SESSION_free(sess2);
+    sess2 = NULL;
+
+    /* After a rotation the old key still decrypts, and a new ticket is sent */
+    if (!TEST_true(SSL_TICKET_KEY_RING_rotate(ring2))
+            || !TEST_int_eq(ticket_test_connect(sctx, cctx, sess, &sess2, NULL), 1))
+        goto end;
+    SSL_SESSION_get0_ticket(sess, &tick, &ticklen);
+    SSL_SESSION_get0_ticket(sess2, &tick2, &ticklen2);
+    if (!TEST_size_t_ge(ticklen, TLSEXT_KEYNAME_LENGTH)
+            || !TEST_size_t_ge(ticklen2, TLSEXT_KEYNAME_LENGTH)
+            || !TEST_mem_ne(tick, TLSEXT_KEYNAME_LENGTH,
+                            tick2, TLSEXT_KEYNAME_LENGTH))
+        goto end;
+
+    /* Once its key has left the ring the ticket is no longer accepted */
+    if (!TEST_true(SSL_TICKET_KEY_RING_rotate(ring))
+            || !TEST_int_eq(ticket_test_connect(sctx2, cctx, sess, &sess3, NULL), 0))
+        goto end;
+    SSL_SESSION_free(sess3);
+    sess3 = NULL;
+    if (!TEST_int_eq(ticket_test_connect(sctx, cctx, sess2, &sess3, NULL), 1))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_SESSION_free(sess);
+    SSL_SESSION_free(sess2);
+    SSL_SESSION_free(sess3);
+    SSL_TICKET_KEY_RING_free(ring);
+    SSL_TICKET_KEY_RING_free(ring2);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(sctx2);
+    SSL_CTX_free(cctx);
+    OPENSSL_free(mem);
+    return testresult;
+}
+
+/*
+ * Test that tickets can leave the client certificate out and that the
+ * server gets it back from its cache on resumption.
+ * Test 0: TLSv1.2
+ * Test 1: TLSv1.3
+ */
+static int test_ticket_peer_cert_cache(int idx)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL_SESSION *sess = NULL, *sess2 = NULL, *sess3 = NULL;
+    const unsigned char *tick;
+    size_t ticklen, ticklen2;
+    int testresult = 0, version = TLS1_3_VERSION, peer = 0;
+    int sess_id_ctx = 1;
+
+    if (idx == 0) {
+#ifdef OPENSSL_NO_TLS1_2
+        TEST_info("Skipping: TLS 1.2 is disabled.");
+        return 1;
+#else
+        version = TLS1_2_VERSION;
+#endif
+    } else {
+#ifdef OPENSSL_NO_TLS1_3
+        TEST_info("Skipping: TLS 1.3 is disabled.");
+        return 1;
+#endif
+    }
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(), version, version,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_int_eq(SSL_CTX_use_certificate_file(cctx, cert,
+                                                         SSL_FILETYPE_PEM), 1)
+            || !TEST_int_eq(SSL_CTX_use_PrivateKey_file(cctx, privkey,
+                                                        SSL_FILETYPE_PEM), 1)
+            || !TEST_true(SSL_CTX_set_session_id_context(sctx,
+                                                         (void *)&sess_id_ctx,
+                                                         sizeof(sess_id_ctx))))
+        goto end;
+    SSL_CTX_set_verify(sctx, SSL_VERIFY_PEER, verify_cb);
+    SSL_CTX_set_session_cache_mode(sctx, SSL_SESS_CACHE_OFF);
+
+    if (!TEST_int_eq(ticket_test_connect(sctx, cctx, NULL, &sess, &peer), 0)
+            || !TEST_true(peer))
+        goto end;
+    SSL_SESSION_get0_ticket(sess, &tick, &ticklen);
+
+    /* With the cache the ticket has a digest instead of the certificate */
+    if (!TEST_size_t_eq(SSL_CTX_get_ticket_peer_cert_cache_size(sctx), 0)
+            || !TEST_false(SSL_CTX_set_ticket_peer_cert_cache_size(sctx,
+                                                                   1 << 20))
+            || !TEST_true(SSL_CTX_set_ticket_peer_cert_cache_size(sctx, 4))
+            || !TEST_size_t_eq(SSL_CTX_get_ticket_peer_cert_cache_size(sctx),
+                               4)
+            || !TEST_int_eq(ticket_test_connect(sctx, cctx, NULL, &sess2,
+                                                &peer), 0))
+        goto end;
+    SSL_SESSION_get0_ticket(sess2, &tick, &ticklen2);
+    if (!TEST_size_t_lt(ticklen2 + 200, ticklen))
+        goto end;
+
+    peer = 0;
+    if (!TEST_int_eq(ticket_test_connect(sctx, cctx, sess2, &sess3, &peer), 1)
+            || !TEST_true(peer))
+        goto end;
+    SSL_SESSION_free(sess3);
+    sess3 = NULL;
+
+    /* Tickets with the full certificate are still accepted */
+    peer = 0;
+    if (!TEST_int_eq(ticket_test_connect(sctx, cctx, sess, &sess3, &peer), 1)
+            || !TEST_true(peer))
+        goto end;
+    SSL_SESSION_free(sess3);
+    sess3 = NULL;
+
+    /* Without the certificate in the cache the ticket cannot be used */
+    if (!TEST_true(SSL_CTX_set_ticket_peer_cert_cache_size(sctx, 4))
+            || !TEST_int_eq(ticket_test_connect(sctx, cctx, sess2, &sess3,
+                                                NULL), 0))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_SESSION_free(sess);
+    SSL_SESSION_free(sess2);
+    SSL_SESSION_free(sess3);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return testresult;
+}
+
+static int cert_msg_type;
+static size_t cert_msg_len;
+
+static void cert_msg_cb(int write_p, int version, int content_type,
+                        const void *buf, size_t len, SSL *ssl, void *arg)
+{
+    const unsigned char *msg = buf;
+
+    if (!write_p && content_type == SSL3_RT_HANDSHAKE && len > 0
+            && (msg[0] == SSL3_MT_CERTIFICATE
+                || msg[0] == SSL3_MT_COMPRESSED_CERTIFICATE)) {
+        cert_msg_type = msg[0];
+        cert_msg_len = len;
+    }
+}
+
+#ifndef OPENSSL_NO_COMP
+
+/*
+ * Test RFC 8879 certificate compression of the server chain
+ * Test 0: Both sides want it
+ * Test 1: Only the client wants it
+ * Test 2: Only the server wants it
+ * Test 3: Both sides want it, but TLSv1.2 is negotiated
+ */
+static int test_cert_compression(int idx)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    static const int zlib[] = { TLSEXT_comp_cert_zlib };
+    static const int bad[] = { TLSEXT_comp_cert_zlib, TLSEXT_comp_cert_zlib };
+    int testresult = 0, i, expected = SSL3_MT_CERTIFICATE;
+    int version = idx == 3 ? TLS1_2_VERSION : TLS1_3_VERSION;
+    const SSL_CERT_COMP *cached = NULL;
+    X509 *peer = NULL;
+
+#ifdef OPENSSL_NO_TLS1_2
+    if (idx == 3)
+        return 1;
+#endif
+#ifdef OPENSSL_NO_TLS1_3
+    if (idx != 3)
+        return 1;
+#endif
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(), version, version,
+                                       &sctx, &cctx, cert, privkey)))
+        goto end;
+
+    if (COMP_get_type(COMP_zlib_oneshot()) == NID_undef) {
+        if (!TEST_false(SSL_CTX_set1_cert_comp_preference(sctx, zlib, 1)))
+            goto end;
+        TEST_info("Skipping: zlib is not available.");
+        testresult = 1;
+        goto end;
+    }
+    if (!TEST_false(SSL_CTX_set1_cert_comp_preference(sctx, bad, 2))
+            || ((idx == 0 || idx == 2 || idx == 3)
+                && !TEST_true(SSL_CTX_set1_cert_comp_preference(sctx, zlib,
+                                                                1)))
+            || ((idx == 0 || idx == 1 || idx == 3)
+                && !TEST_true(SSL_CTX_set1_cert_comp_preference(cctx, zlib,
+                                                                1))))
+        goto end;
+    if (idx == 0)
+        expected = SSL3_MT_COMPRESSED_CERTIFICATE;
+    SSL_CTX_set_msg_callback(cctx, cert_msg_cb);
+
+    /* The second time round the compressed chain comes from the cache */
+    for (i = 0; i < 2; i++) {
+        cert_msg_type = 0;
+        if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                          NULL, NULL))
+                || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                    SSL_ERROR_NONE))
+                || !TEST_int_eq(cert_msg_type, expected)
+                || !TEST_ptr(peer = SSL_get_peer_certificate(clientssl)))
+            goto end;
+        X509_free(peer);
+        if (idx == 0) {
+            if (i == 0
+                    && !TEST_ptr(cached = sctx->cert_comp_cache[SSL_PKEY_RSA]))
+                goto end;
+            if (i == 1
+                    && !TEST_ptr_eq(cached,
+                                    sctx->cert_comp_cache[SSL_PKEY_RSA]))
+                goto end;
+        }
+        shutdown_ssl_connection(serverssl, clientssl);
+        serverssl = clientssl = NULL;
+    }
+
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return testresult;
+}
+#endif
+
+#ifndef OPENSSL_NO_TLS1_3
+/*
+ * Test RFC 7924 cached_info for the server chain
+ * Test 0: The server sends the same chain twice
+ * Test 1: The server changes its certificate in between
+ * Test 2: The client does not set a server name
+ */
+static int test_cached_info(int idx)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    char *ecdsacert = NULL, *ecdsakey = NULL;
+    X509 *peer = NULL;
+    int testresult = 0, i;
+    /* The handshake header and the hash */
+    size_t hashed_len = SSL3_HM_HEADER_LENGTH + 1 + SHA256_DIGEST_LENGTH;
+
+#ifdef OPENSSL_NO_EC
+    if (idx == 1)
+        return 1;
+#endif
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(), TLS1_3_VERSION,
+                                       TLS1_3_VERSION, &sctx, &cctx, cert,
+                                       privkey))
+            || !TEST_size_t_eq(SSL_CTX_get_cached_info_cache_size(cctx), 0)
+            || !TEST_true(SSL_CTX_set_cached_info_cache_size(cctx, 8))
+            || !TEST_size_t_eq(SSL_CTX_get_cached_info_cache_size(cctx), 8))
+        goto end;
+    SSL_CTX_set_msg_callback(cctx, cert_msg_cb);
+
+    for (i = 0; i < 2; i++) {
+        cert_msg_type = 0;
+        cert_msg_len = 0;
+        if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                          NULL, NULL))
+                || (idx != 2
+                    && !TEST_true(SSL_set_tlsext_host_name(clientssl,
+                                                           "localhost"))))
+            goto end;
+        if (idx == 1 && i == 1) {
+            if (!TEST_ptr(ecdsacert = test_mk_file_path(certsdir,
+                                                "server-ecdsa-cert.pem"))
+                    || !TEST_ptr(ecdsakey = test_mk_file_path(certsdir,
+                                                "server-ecdsa-key.pem"))
+                    || !TEST_true(SSL_use_certificate_file(serverssl,
+                                                           ecdsacert,
+                                                           SSL_FILETYPE_PEM))
+                    || !TEST_true(SSL_use_PrivateKey_file(serverssl, ecdsakey,
+                                                          SSL_FILETYPE_PEM)))
+                goto end;
+        }
+        if (!TEST_true(create_ssl_connection(serverssl, clientssl,
+                                             SSL_ERROR_NONE))
+                || !TEST_int_eq(cert_msg_type, SSL3_MT_CERTIFICATE)
+                || !TEST_ptr(peer = SSL_get_peer_certificate(clientssl)))
+            goto end;
+        X509_free(peer);
+
+        /* Only a repeated chain is left out */
+        if (idx == 0 && i == 1) {
+            if (!TEST_size_t_eq(cert_msg_len, hashed_len))
+                goto end;
+        } else if (!TEST_size_t_gt(cert_msg_len, hashed_len)) {
+            goto end;
+        }
+        shutdown_ssl_connection(serverssl, clientssl);
+        serverssl = clientssl = NULL;
+    }
+
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    OPENSSL_free(ecdsacert);
+    OPENSSL_free(ecdsakey);
+    return testresult;
+}
+#endif
+
+/*
+ * Test that the server keeps the encoded chain of its certificate for the
+ * next handshakes, and builds it again once the store it was built from
+ * changes.
+ * Test 0: TLSv1.2
+ * Test 1: TLSv1.3
+ */
+static int test_cert_msg_cache(int idx)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    SSL_CERT_MSG *cached = NULL;
+    char *rootfile = NULL;
+    int testresult = 0, i;
+    int version = idx == 0 ? TLS1_2_VERSION : TLS1_3_VERSION;
+
+#ifdef OPENSSL_NO_TLS1_2
+    if (idx == 0)
+        return 1;
+#endif
+#ifdef OPENSSL_NO_TLS1_3
+    if (idx == 1)
+        return 1;
+#endif
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(), version, version,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_ptr(rootfile = test_mk_file_path(certsdir,
+                                                      "rootcert.pem")))
+        goto end;
+
+    for (i = 0; i < 3; i++) {
+        /* The root CA is available for the last chain */
+        if (i == 2
+                && !TEST_true(SSL_CTX_load_verify_locations(sctx, rootfile,
+                                                            NULL)))
+            goto end;
+        if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                          NULL, NULL))
+                || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                    SSL_ERROR_NONE))
+                || !TEST_int_eq(sk_X509_num(SSL_get_peer_cert_chain(clientssl)),
+                                i == 2 ? 2 : 1)
+                || !TEST_ptr(sctx->cert_msgs[SSL_PKEY_RSA]))
+            goto end;
+        if (i == 1) {
+            if (!TEST_ptr_eq(sctx->cert_msgs[SSL_PKEY_RSA], cached))
+                goto end;
+        } else if (!TEST_ptr_ne(sctx->cert_msgs[SSL_PKEY_RSA], cached)) {
+            goto end;
+        }
+        cached = sctx->cert_msgs[SSL_PKEY_RSA];
+        shutdown_ssl_connection(serverssl, clientssl);
+        serverssl = clientssl = NULL;
+    }
+
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    OPENSSL_free(rootfile);
+    return testresult;
+}
+
+#ifndef OPENSSL_NO_TLS1_3
+static int spec_dgst_num[2];
+
+static void spec_dgst_cb(int write_p, int version, int content_type,
+                         const void *buf, size_t len, SSL *ssl, void *arg)
+{
+    const unsigned char *msg = buf;
+    int i, num = 0;
+
+    if (content_type != SSL3_RT_HANDSHAKE || len == 0
+            || msg[0] != SSL3_MT_CLIENT_HELLO || spec_dgst_num[ssl->server] != 0)
+        return;
+
+    /* Only the first ClientHello is hashed speculatively */
+    for (i = 0; i < SSL_HANDSHAKE_SPEC_NUM; i++) {
+        if (ssl->s3->handshake_spec_dgst[i] != NULL)
+            num++;
+    }
+    spec_dgst_num[ssl->server] = ssl->s3->handshake_buffer == NULL ? num : -1;
+}
+
+/*
+ * Test that handshakes which can only be TLSv1.3 hash their ClientHello with
+ * the possible digests instead of buffering it.
+ * Test 0: Full handshake
+ * Test 1: HelloRetryRequest
+ * Test 2: Server with SHA-256 ciphersuites only
+ * Test 3: Early data after resumption
+ * Test 4: Early data with an external PSK
+ */
+static int test_handshake_spec_digest(int idx)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    SSL_SESSION *sess = NULL;
+    unsigned char buf[20];
+    size_t readbytes, written;
+    int testresult = 0;
+
+#ifdef OPENSSL_NO_EC
+    if (idx == 1)
+        return 1;
+#endif
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(), TLS1_3_VERSION, 0,
+                                       &sctx, &cctx, cert, privkey)))
+        goto end;
+    if (idx == 2
+            && !TEST_true(SSL_CTX_set_ciphersuites(sctx,
+                                                   "TLS_AES_128_GCM_SHA256")))
+        goto end;
+
+    if (idx >= 3) {
+        if (!TEST_true(setupearly_data_test(&cctx, &sctx, &clientssl,
+                                            &serverssl, &sess, idx - 2)))
+            goto end;
+    } else if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl,
+                                             &clientssl, NULL, NULL))) {
+        goto end;
+    }
+    if (idx == 1
+            && (!TEST_true(SSL_set1_groups_list(clientssl, "X25519:P-256"))
+                || !TEST_true(SSL_set1_groups_list(serverssl, "P-256"))))
+        goto end;
+
+    spec_dgst_num[0] = spec_dgst_num[1] = 0;
+    SSL_set_msg_callback(clientssl, spec_dgst_cb);
+    SSL_set_msg_callback(serverssl, spec_dgst_cb);
+
+    if (idx >= 3
+            && (!TEST_true(SSL_write_early_data(clientssl, MSG1, strlen(MSG1),
+                                                &written))
+                || !TEST_int_eq(SSL_read_early_data(serverssl, buf,
+                                                    sizeof(buf), &readbytes),
+                                SSL_READ_EARLY_DATA_SUCCESS)
+                || !TEST_mem_eq(MSG1, strlen(MSG1), buf, readbytes)))
+        goto end;
+
+    if (!TEST_true(create_ssl_connection(serverssl, clientssl, SSL_ERROR_NONE))
+            || !TEST_int_eq(spec_dgst_num[0], 2)
+            || !TEST_int_eq(spec_dgst_num[1], idx == 2 ? 1 : 2)
+            || (idx == 1
+                && !TEST_int_eq(serverssl->hello_retry_request,
+                                SSL_HRR_COMPLETE))
+            || (idx >= 3
+                && !TEST_int_eq(SSL_get_early_data_status(serverssl),
+                                SSL_EARLY_DATA_ACCEPTED)))
+        goto end;
+
+    /* The connection works */
+    if (!TEST_true(SSL_write_ex(clientssl, MSG2, strlen(MSG2), &written))
+            || !TEST_true(SSL_read_ex(serverssl, buf, sizeof(buf), &readbytes))
+            || !TEST_mem_eq(MSG2, strlen(MSG2), buf, readbytes))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_SESSION_free(sess);
+    SSL_SESSION_free(clientpsk);
+    SSL_SESSION_free(serverpsk);
+    clientpsk = serverpsk = NULL;
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return testresult;
+}
+#endif
+
+/*
+ * Test that cipher and group preferences compiled once configure several
+ * SSL_CTXs.
+ * Test 0: TLSv1.2
+ * Test 1: TLSv1.3
+ */
+static int test_cipher_group_prefs(int idx)
+{
+    SSL_CTX *cctx = NULL, *sctx[2] = { NULL, NULL };
+    SSL *clientssl = NULL, *serverssl = NULL;
+    SSL_CIPHER_PREFS *cprefs = NULL;
+#ifndef OPENSSL_NO_EC
+    SSL_GROUP_PREFS *gprefs = NULL;
+#endif
+    int version = idx == 0 ? TLS1_2_VERSION : TLS1_3_VERSION;
+    const char *expected = idx == 0 ? "AES128-SHA256"
+                                    : "TLS_AES_256_GCM_SHA384";
+    int testresult = 0, i;
+
+#ifdef OPENSSL_NO_TLS1_2
+    if (idx == 0)
+        return 1;
+#endif
+#ifdef OPENSSL_NO_TLS1_3
+    if (idx == 1)
+        return 1;
+#endif
+
+    if (!TEST_ptr_null(SSL_CIPHER_PREFS_new(TLS_server_method(),
+                                            "NoSuchCipher", NULL))
+            || !TEST_ptr(cprefs = SSL_CIPHER_PREFS_new(TLS_server_method(),
+                                                       "AES128-SHA256",
+                                                       "TLS_AES_256_GCM_SHA384"))
+            || !TEST_true(SSL_CIPHER_PREFS_up_ref(cprefs)))
+        goto end;
+    /* The extra reference is dropped straight away */
+    SSL_CIPHER_PREFS_free(cprefs);
+#ifndef OPENSSL_NO_EC
+    if (!TEST_ptr_null(SSL_GROUP_PREFS_new("NoSuchGroup"))
+            || !TEST_ptr(gprefs = SSL_GROUP_PREFS_new("P-384:X25519")))
+        goto end;
+#endif
+
+    for (i = 0; i < 2; i++) {
+        SSL_CTX_free(cctx);
+        cctx = NULL;
+        if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                           TLS_client_method(), version,
+                                           version, &sctx[i], &cctx, cert,
+                                           privkey))
+                || !TEST_true(SSL_CTX_set_cipher_prefs(sctx[i], cprefs)))
+            goto end;
+#ifndef OPENSSL_NO_EC
+        if (!TEST_true(SSL_CTX_set_group_prefs(sctx[i], gprefs))
+                || !TEST_size_t_eq(sctx[i]->ext.supportedgroups_len, 2)
+                || !TEST_int_eq(sctx[i]->ext.supportedgroups[0], 24)
+                || !TEST_int_eq(sctx[i]->ext.supportedgroups[1], 29))
+            goto end;
+#endif
+
+        if (!TEST_true(create_ssl_objects(sctx[i], cctx, &serverssl,
+                                          &clientssl, NULL, NULL))
+                || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                    SSL_ERROR_NONE))
+                || !TEST_str_eq(SSL_CIPHER_get_name(SSL_get_current_cipher(
+                                                        clientssl)),
+                                expected))
+            goto end;
+        shutdown_ssl_connection(serverssl, clientssl);
+        serverssl = clientssl = NULL;
+    }
+
+    /* Changing one SSL_CTX afterwards leaves the other alone */
+    if (!TEST_true(SSL_CTX_set_ciphersuites(sctx[0], "TLS_AES_128_GCM_SHA256"))
+            || !TEST_int_eq(sk_SSL_CIPHER_num(sctx[1]->tls13_ciphersuites), 1)
+            || !TEST_str_eq(SSL_CIPHER_get_name(
+                                sk_SSL_CIPHER_value(sctx[1]->tls13_ciphersuites,
+                                                    0)),
+                            "TLS_AES_256_GCM_SHA384"))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx[0]);
+    SSL_CTX_free(sctx[1]);
+    SSL_CTX_free(cctx);
+    SSL_CIPHER_PREFS_free(cprefs);
+#ifndef OPENSSL_NO_EC
+    SSL_GROUP_PREFS_free(gprefs);
+#endif
+    return testresult;
+}
+
+#ifndef OPENSSL_NO_EC
+/*
+ * Test the groups a server shares with a client, in the client's order
+ * (idx == 0) or the server's (idx == 1)
+ */
+static int test_shared_group(int idx)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int testresult = 0;
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(), TLS1_VERSION, 0,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_true(SSL_CTX_set1_groups_list(cctx,
+                                                   "P-521:X25519:P-384:P-256"))
+            || !TEST_true(SSL_CTX_set1_groups_list(sctx, "P-256:X448:P-384")))
+        goto end;
+    if (idx == 1)
+        SSL_CTX_set_options(sctx, SSL_OP_CIPHER_SERVER_PREFERENCE);
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_int_eq(SSL_get_shared_group(serverssl, -1), 2)
+            || !TEST_int_eq(SSL_get_shared_group(serverssl, 0),
+                            idx == 0 ? NID_secp384r1 : NID_X9_62_prime256v1)
+            || !TEST_int_eq(SSL_get_shared_group(serverssl, 1),
+                            idx == 0 ? NID_X9_62_prime256v1 : NID_secp384r1)
+            || !TEST_int_eq(SSL_get_shared_group(serverssl, 2), 0))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return testresult;
+}
+
+/*
+ * Test the signature algorithm a TLSv1.3 server chooses with an RSA and an
+ * ECDSA certificate.
+ * Test 0: The ECDSA certificate is set on the SSL_CTX
+ * Test 1: The ECDSA certificate is set on the SSL after it was created
+ * Test 2: The client only offers RSA-PSS
+ */
+static int test_cert_sigalgs(int idx)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    char *ecdsacert = NULL, *ecdsakey = NULL;
+    const char *sigalgs = idx == 2 ? "RSA-PSS+SHA256"
+                                   : "ECDSA+SHA256:RSA-PSS+SHA256";
+    int testresult = 0, nid;
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(), TLS1_3_VERSION,
+                                       TLS1_3_VERSION, &sctx, &cctx, cert,
+                                       privkey))
+            || !TEST_ptr(ecdsacert = test_mk_file_path(certsdir,
+                                                       "server-ecdsa-cert.pem"))
+            || !TEST_ptr(ecdsakey = test_mk_file_path(certsdir,
+                                                      "server-ecdsa-key.pem"))
+            || !TEST_true(SSL_CTX_set1_sigalgs_list(cctx, sigalgs)))
+        goto end;
+    if (idx != 1
+            && (!TEST_true(SSL_CTX_use_certificate_file(sctx, ecdsacert,
+                                                        SSL_FILETYPE_PEM))
+                || !TEST_true(SSL_CTX_use_PrivateKey_file(sctx, ecdsakey,
+                                                          SSL_FILETYPE_PEM))))
+        goto end;
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL)))
+        goto end;
+    if (idx == 1
+            && (!TEST_true(SSL_use_certificate_file(serverssl, ecdsacert,
+                                                    SSL_FILETYPE_PEM))
+                || !TEST_true(SSL_use_PrivateKey_file(serverssl, ecdsakey,
+                                                      SSL_FILETYPE_PEM))))
+        goto end;
+
+    if (!TEST_true(create_ssl_connection(serverssl, clientssl,
+                                         SSL_ERROR_NONE))
+            || !TEST_true(SSL_get_peer_signature_type_nid(clientssl, &nid))
+            || !TEST_int_eq(nid, idx == 2 ? EVP_PKEY_RSA_PSS : EVP_PKEY_EC))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    OPENSSL_free(ecdsacert);
+    OPENSSL_free(ecdsakey);
+    return testresult;
+}
+#endif
+
+static unsigned long hs_stat(SSL_CTX *ctx, int phase, int stat)
+{
+    return (unsigned long)SSL_CTX_get_handshake_stats(ctx, phase, stat);
+}
+
+/*
+ * Test that the phases of a full handshake are timed on both sides.
+ * Test 0: TLSv1.2
+ * Test 1: TLSv1.3
+ */
+static int test_handshake_stats(int idx)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    /* The phases each side goes through, whichever the version */
+    static const int server_phases[] = {
+        SSL_HS_PHASE_HANDSHAKE, SSL_HS_PHASE_SIGN, SSL_HS_PHASE_TRANSCRIPT
+    };
+    static const int client_phases[] = {
+        SSL_HS_PHASE_HANDSHAKE, SSL_HS_PHASE_KEYGEN, SSL_HS_PHASE_VERIFY,
+        SSL_HS_PHASE_CHAIN_VERIFY, SSL_HS_PHASE_TRANSCRIPT
+    };
+    unsigned long sum;
+    int testresult = 0, version = TLS1_3_VERSION, i, j;
+
+    if (idx == 0) {
+#ifdef OPENSSL_NO_TLS1_2
+        TEST_info("Skipping: TLS 1.2 is disabled.");
+        return 1;
+#else
+        version = TLS1_2_VERSION;
+#endif
+    } else {
+#ifdef OPENSSL_NO_TLS1_3
+        TEST_info("Skipping: TLS 1.3 is disabled.");
+        return 1;
+#endif
+    }
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(), version, version,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_true(SSL_CTX_enable_handshake_stats(sctx))
+            || !TEST_true(SSL_CTX_enable_handshake_stats(cctx))
+            || !TEST_true(create_ssl_objects(sctx, cctx, &serverssl,
+                                             &clientssl, NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE)))
+        goto end;
+
+    for (i = 0; i < (int)OSSL_NELEM(server_phases); i++)
+        if (!TEST_ulong_eq(hs_stat(sctx, server_phases[i],
+                                   SSL_HS_STAT_COUNT), 1))
+            goto end;
+    for (i = 0; i < (int)OSSL_NELEM(client_phases); i++)
+        if (!TEST_ulong_eq(hs_stat(cctx, client_phases[i],
+                                   SSL_HS_STAT_COUNT), 1))
+            goto end;
+
+    /* The ECDHE share is encapsulated by the side answering the other's */
+    if (!TEST_ulong_eq(hs_stat(idx == 0 ? cctx : sctx, SSL_HS_PHASE_ENCAPS,
+                               SSL_HS_STAT_COUNT), 1)
+            || !TEST_ulong_eq(hs_stat(idx == 0 ? sctx : cctx,
+                                      SSL_HS_PHASE_DECAPS,
+                                      SSL_HS_STAT_COUNT), 1)
+            || !TEST_ulong_eq(hs_stat(sctx, SSL_HS_PHASE_CHAIN_VERIFY,
+                                      SSL_HS_STAT_COUNT), 0)
+            || !TEST_ulong_eq(hs_stat(cctx, SSL_HS_PHASE_NUM,
+                                      SSL_HS_STAT_COUNT), 0))
+        goto end;
+
+    /* Every handshake is in one bucket of the histogram */
+    for (i = 0; i < SSL_HS_PHASE_NUM; i++) {
+        for (sum = 0, j = 0; j < SSL_HS_STAT_BUCKETS; j++)
+            sum += hs_stat(cctx, i, SSL_HS_STAT_BUCKET(j));
+        if (!TEST_ulong_eq(sum, hs_stat(cctx, i, SSL_HS_STAT_COUNT))
+                || !TEST_ulong_le(hs_stat(cctx, i, SSL_HS_STAT_MAX_WALL_US),
+                                  hs_stat(cctx, i, SSL_HS_STAT_WALL_US)))
+            goto end;
+    }
+
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return testresult;
+}
+
+static unsigned long rec_stat(const SSL *s, int stat)
+{
+    return (unsigned long)SSL_get_record_stats(s, stat);
+}
+
+static unsigned long ctx_rec_stat(const SSL_CTX *ctx, int stat)
+{
+    return (unsigned long)SSL_CTX_get_record_stats(ctx, stat);
+}
+
+/*
+ * Test that the record layer counters of both ends of a TLSv1.3 connection
+ * agree, and that the counters of an SSL object are added to its SSL_CTX
+ * when it is freed.
+ */
+static int test_record_stats(void)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    static const int stats[][2] = {
+        { SSL_REC_STAT_RECORDS_OUT, SSL_REC_STAT_RECORDS_IN },
+        { SSL_REC_STAT_BYTES_OUT, SSL_REC_STAT_BYTES_IN },
+        { SSL_REC_STAT_KEY_UPDATES_OUT, SSL_REC_STAT_KEY_UPDATES_IN }
+    };
+    unsigned long server_stats[SSL_REC_STAT_NUM];
+    unsigned char buf[20];
+    size_t written, readbytes;
+    int testresult = 0, i;
+
+#ifdef OPENSSL_NO_TLS1_3
+    TEST_info("Skipping: TLS 1.3 is disabled.");
+    return 1;
+#endif
+
+    /* Only the server side counts for all its connections */
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(), TLS1_3_VERSION,
+                                       TLS1_3_VERSION, &sctx, &cctx, cert,
+                                       privkey))
+            || !TEST_true(SSL_CTX_enable_record_stats(sctx))
+            || !TEST_true(create_ssl_objects(sctx, cctx, &serverssl,
+                                             &clientssl, NULL, NULL))
+            || !TEST_ulong_eq(rec_stat(clientssl, SSL_REC_STAT_RECORDS_OUT),
+                              0)
+            || !TEST_true(SSL_enable_record_stats(clientssl))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_true(SSL_write_ex(clientssl, "hello", 5, &written))
+            || !TEST_true(SSL_read_ex(serverssl, buf, sizeof(buf),
+                                      &readbytes))
+            || !TEST_true(SSL_key_update(clientssl,
+                                         SSL_KEY_UPDATE_NOT_REQUESTED))
+            || !TEST_true(SSL_write_ex(clientssl, "world", 5, &written))
+            || !TEST_true(SSL_read_ex(serverssl, buf, sizeof(buf),
+                                      &readbytes)))
+        goto end;
+
+    /* The server has read everything the client sent */
+    for (i = 0; i < (int)OSSL_NELEM(stats); i++)
+        if (!TEST_ulong_gt(rec_stat(clientssl, stats[i][0]), 0)
+                || !TEST_ulong_eq(rec_stat(clientssl, stats[i][0]),
+                                  rec_stat(serverssl, stats[i][1])))
+            goto end;
+    if (!TEST_ulong_ge(rec_stat(serverssl, SSL_REC_STAT_DECRYPTS), 3)
+            || !TEST_ulong_ge(rec_stat(serverssl, SSL_REC_STAT_ENCRYPTS), 3)
+            || !TEST_ulong_gt(rec_stat(serverssl, SSL_REC_STAT_FLUSHES), 0)
+            || !TEST_ulong_gt(rec_stat(serverssl, SSL_REC_STAT_BUFFER_ALLOCS),
+                              0)
+            || !TEST_ulong_gt(rec_stat(serverssl, SSL_REC_STAT_WANT_READ), 0)
+            || !TEST_ulong_eq(rec_stat(serverssl, SSL_REC_STAT_NUM), 0))
+        goto end;
+
+    /* Totals only cover the SSL objects that have been freed */
+    for (i = 0; i < SSL_REC_STAT_NUM; i++) {
+        server_stats[i] = rec_stat(serverssl, i);
+        if (!TEST_ulong_eq(ctx_rec_stat(sctx, i), 0))
+            goto end;
+    }
+    SSL_free(serverssl);
+    serverssl = NULL;
+    SSL_free(clientssl);
+    clientssl = NULL;
+    for (i = 0; i < SSL_REC_STAT_NUM; i++)
+        if (!TEST_ulong_eq(ctx_rec_stat(sctx, i), server_stats[i])
+                || !TEST_ulong_eq(ctx_rec_stat(cctx, i), 0))
+            goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return testresult;
+}
+
+/* Reads |len| bytes from |s| and checks they match |expected| */
+static int read_expected(SSL *s, const unsigned char *expected, size_t len)
+{
+    unsigned char buf[512];
+    size_t readbytes, got = 0;
+
+    while (got < len) {
+        if (!TEST_true(SSL_read_ex(s, buf, sizeof(buf), &readbytes))
+                || !TEST_size_t_le(readbytes, len - got)
+                || !TEST_mem_eq(buf, readbytes, expected + got, readbytes))
+            return 0;
+        got += readbytes;
+    }
+    return 1;
+}
+
+/*
+ * Test that SSL_MODE_CORK holds back small writes and sends them in one
+ * record when the threshold is reached, on SSL_uncork(), before a write that
+ * doesn't fit and before reading.
+ */
+static int test_cork(void)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    unsigned char data[300], tmp[10];
+    SSL_IOVEC iov[2];
+    size_t i, written, readbytes;
+    unsigned long records;
+    int testresult = 0;
+
+    for (i = 0; i < sizeof(data); i++)
+        data[i] = (unsigned char)i;
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(), TLS1_VERSION, 0,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_false(SSL_CTX_set_cork_threshold(cctx,
+                                              SSL3_RT_MAX_PLAIN_LENGTH + 1))
+            || !TEST_true(create_ssl_objects(sctx, cctx, &serverssl,
+                                             &clientssl, NULL, NULL))
+            || !TEST_true(SSL_enable_record_stats(clientssl))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE)))
+        goto end;
+    SSL_set_mode(clientssl, SSL_MODE_CORK);
+
+    /* Nothing is sent until SSL_uncork() */
+    records = rec_stat(clientssl, SSL_REC_STAT_RECORDS_OUT);
+    for (i = 0; i < 100; i += 10)
+        if (!TEST_true(SSL_write_ex(clientssl, data + i, 10, &written))
+                || !TEST_size_t_eq(written, 10))
+            goto end;
+    if (!TEST_size_t_eq(SSL_get_corked_bytes(clientssl), 100)
+            || !TEST_ulong_eq(rec_stat(clientssl, SSL_REC_STAT_RECORDS_OUT),
+                              records)
+            || !TEST_int_eq(SSL_uncork(clientssl), 1)
+            || !TEST_size_t_eq(SSL_get_corked_bytes(clientssl), 0)
+            || !TEST_ulong_eq(rec_stat(clientssl, SSL_REC_STAT_RECORDS_OUT),
+                              records + 1)
+            || !read_expected(serverssl, data, 100))
+        goto end;
+
+    /* A full threshold goes out straight away */
+    if (!TEST_true(SSL_set_cork_threshold(clientssl, 50)))
+        goto end;
+    for (i = 0; i < 50; i += 10)
+        if (!TEST_true(SSL_write_ex(clientssl, data + i, 10, &written)))
+            goto end;
+    if (!TEST_size_t_eq(SSL_get_corked_bytes(clientssl), 0)
+            || !TEST_ulong_eq(rec_stat(clientssl, SSL_REC_STAT_RECORDS_OUT),
+                              records + 2)
+            || !read_expected(serverssl, data, 50))
+        goto end;
+
+    /*
+     * A write that doesn't fit sends what is held back first, and gathered
+     * writes are held back too
+     */
+    iov[0].base = data;
+    iov[0].len = 15;
+    iov[1].base = data + 15;
+    iov[1].len = 15;
+    if (!TEST_true(SSL_writev_ex(clientssl, iov, 2, &written))
+            || !TEST_size_t_eq(written, 30)
+            || !TEST_true(SSL_write_ex(clientssl, data + 30, 30, &written))
+            || !TEST_size_t_eq(SSL_get_corked_bytes(clientssl), 30)
+            || !TEST_ulong_eq(rec_stat(clientssl, SSL_REC_STAT_RECORDS_OUT),
+                              records + 3)
+            /* A write of the threshold or more isn't held back */
+            || !TEST_true(SSL_write_ex(clientssl, data + 60, 240, &written))
+            || !TEST_size_t_eq(SSL_get_corked_bytes(clientssl), 0)
+            || !TEST_ulong_eq(rec_stat(clientssl, SSL_REC_STAT_RECORDS_OUT),
+                              records + 5)
+            || !read_expected(serverssl, data, 300))
+        goto end;
+
+    /* Reading sends what is held back */
+    if (!TEST_true(SSL_write_ex(clientssl, data, 20, &written))
+            || !TEST_false(SSL_read_ex(clientssl, tmp, sizeof(tmp),
+                                       &readbytes))
+            || !TEST_int_eq(SSL_get_error(clientssl, 0), SSL_ERROR_WANT_READ)
+            || !TEST_size_t_eq(SSL_get_corked_bytes(clientssl), 0)
+            || !read_expected(serverssl, data, 20))
+        goto end;
+
+    /* And so does shutting down, before the close_notify */
+    if (!TEST_true(SSL_write_ex(clientssl, data, 20, &written))
+            || !TEST_int_eq(SSL_shutdown(clientssl), 0)
+            || !read_expected(serverssl, data, 20)
+            || !TEST_false(SSL_read_ex(serverssl, tmp, sizeof(tmp),
+                                       &readbytes))
+            || !TEST_int_eq(SSL_get_error(serverssl, 0),
+                            SSL_ERROR_ZERO_RETURN))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return testresult;
+}
+
+static int mem_usage_sum(const SSL *s)
+{
+    size_t sum = 0;
+    int i;
+
+    for (i = 0; i < SSL_MEM_NUM; i++)
+        sum += SSL_get_memory_usage(s, i);
+    return sum == SSL_get_memory_usage(s, SSL_MEM_ALL);
+}
+
+static int test_memory_usage(void)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int testresult = 0;
+
+    /* Without tickets, the server caches the session */
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(), TLS1_VERSION, 0,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_true(SSL_CTX_set_options(sctx, SSL_OP_NO_TICKET))
+            || !TEST_size_t_gt(SSL_CTX_get_memory_usage(sctx,
+                                                       SSL_MEM_CERTIFICATES),
+                               0)
+            || !TEST_size_t_eq(SSL_CTX_get_memory_usage(sctx,
+                                                       SSL_MEM_SESSION), 0)
+            || !TEST_true(create_ssl_objects(sctx, cctx, &serverssl,
+                                             &clientssl, NULL, NULL))
+            || !TEST_size_t_eq(SSL_get_memory_usage(clientssl,
+                                                   SSL_MEM_RECORD_BUFFERS),
+                               0)
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE)))
+        goto end;
+
+    /* The client holds the certificate of the server in its session */
+    if (!TEST_size_t_gt(SSL_get_memory_usage(clientssl,
+                                             SSL_MEM_RECORD_BUFFERS), 0)
+            || !TEST_size_t_gt(SSL_get_memory_usage(clientssl,
+                                                    SSL_MEM_SESSION), 0)
+            || !TEST_size_t_gt(SSL_get_memory_usage(clientssl,
+                                                    SSL_MEM_CERTIFICATES), 0)
+            || !TEST_size_t_eq(SSL_get_memory_usage(serverssl,
+                                                    SSL_MEM_CERTIFICATES), 0)
+            || !TEST_size_t_gt(SSL_CTX_get_memory_usage(sctx,
+                                                        SSL_MEM_SESSION), 0)
+            || !TEST_size_t_eq(SSL_get_memory_usage(clientssl, SSL_MEM_NUM),
+                               0)
+            || !TEST_true(mem_usage_sum(clientssl))
+            || !TEST_true(mem_usage_sum(serverssl)))
+        goto end;
+
+    /* Released record buffers move to the pool of the SSL_CTX */
+    if (!TEST_true(SSL_free_buffers(clientssl))
+            || !TEST_size_t_eq(SSL_get_memory_usage(clientssl,
+                                                    SSL_MEM_RECORD_BUFFERS),
+                               0)
+            || !TEST_size_t_gt(SSL_CTX_get_memory_usage(cctx,
+                                                       SSL_MEM_RECORD_BUFFERS),
+                               0))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return testresult;
+}
+
+#ifndef OPENSSL_NO_TLS1_3
+static size_t post_hs_mem;
+
+static int hs_mem_session_cb(SSL *ssl, SSL_SESSION *sess)
+{
+    size_t mem = SSL_get_memory_usage(ssl, SSL_MEM_HANDSHAKE);
+
+    new_called++;
+    if (mem > post_hs_mem)
+        post_hs_mem = mem;
+    SSL_SESSION_free(sess);
+    return 1;
+}
+
+static void noop_msg_cb(int write_p, int version, int content_type,
+                        const void *buf, size_t len, SSL *ssl, void *arg)
+{
+}
+
+/*
+ * Runs a TLSv1.3 connection and a KeyUpdate, and stores in |*mem| how much
+ * handshake memory the client used for the NewSessionTickets it received
+ */
+static int post_handshake_mem(int msg_cb, size_t *mem)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    unsigned char buf[1];
+    size_t n, base;
+    int testresult = 0;
+
+    new_called = 0;
+    post_hs_mem = 0;
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(), TLS1_3_VERSION,
+                                       TLS1_3_VERSION, &sctx, &cctx, cert,
+                                       privkey)))
+        goto end;
+    SSL_CTX_set_session_cache_mode(cctx, SSL_SESS_CACHE_CLIENT
+                                         | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(cctx, hs_mem_session_cb);
+    if (msg_cb)
+        SSL_CTX_set_msg_callback(cctx, noop_msg_cb);
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_int_eq(new_called, 2)
+            || !TEST_size_t_gt(post_hs_mem, 0))
+        goto end;
+
+    /* init_buf is freed again after the KeyUpdate */
+    base = SSL_get_memory_usage(clientssl, SSL_MEM_HANDSHAKE);
+    if (!TEST_true(SSL_key_update(serverssl, SSL_KEY_UPDATE_REQUESTED))
+            || !TEST_true(SSL_write_ex(serverssl, "x", 1, &n))
+            || !TEST_true(SSL_read_ex(clientssl, buf, sizeof(buf), &n))
+            || !TEST_true(SSL_write_ex(clientssl, "y", 1, &n))
+            || !TEST_true(SSL_read_ex(serverssl, buf, sizeof(buf), &n))
+            || !TEST_size_t_eq(SSL_get_memory_usage(clientssl,
+                                                    SSL_MEM_HANDSHAKE), base))
+        goto end;
+
+    *mem = post_hs_mem;
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return testresult;
+}
+
+/*
+ * Test that post-handshake messages are parsed in the record buffer without
+ * being copied to init_buf, unless a message callback wants to see them
+ */
+static int test_post_handshake_in_record(void)
+{
+    size_t in_record, copied;
+
+    return TEST_true(post_handshake_mem(0, &in_record))
+           && TEST_true(post_handshake_mem(1, &copied))
+           && TEST_size_t_lt(in_record, copied)
+           && TEST_size_t_lt(copied, SSL3_RT_MAX_PLAIN_LENGTH);
+}
+#endif
+
+static size_t cert_msg_len, cert_msg_bufsize;
+
+static void cert_msg_size_cb(int write_p, int version, int content_type,
+                             const void *buf, size_t len, SSL *ssl, void *arg)
+{
+    if (write_p && content_type == SSL3_RT_HANDSHAKE && len > 0
+            && ((const unsigned char *)buf)[0] == SSL3_MT_CERTIFICATE) {
+        cert_msg_len = len;
+        cert_msg_bufsize = ssl->init_buf->max;
+    }
+}
+
+/*
+ * Test that init_buf is sized once for a Certificate message larger than it,
+ * once the chain has been encoded by an earlier handshake
+ */
+static int test_message_size_hint(void)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    X509 *x;
+    size_t len[2], bufsize[2];
+    int i, testresult = 0;
+
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                       TLS_client_method(), TLS1_VERSION,
+                                       TLS_MAX_VERSION, &sctx, &cctx, cert,
+                                       privkey)))
+        goto end;
+    for (i = 0; i < 20; i++) {
+        x = SSL_CTX_get0_certificate(sctx);
+        if (!TEST_true(X509_up_ref(x)))
+            goto end;
+        if (!TEST_true(SSL_CTX_add_extra_chain_cert(sctx, x))) {
+            X509_free(x);
+            goto end;
+        }
+    }
+    SSL_CTX_set_msg_callback(sctx, cert_msg_size_cb);
+
+    for (i = 0; i < 2; i++) {
+        cert_msg_len = cert_msg_bufsize = 0;
+        if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                          NULL, NULL))
+                || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                    SSL_ERROR_NONE)))
             goto end;
-        if (!TEST_int_eq(SSL_shutdown(serverssl), 1))
+        len[i] = cert_msg_len;
+        bufsize[i] = cert_msg_bufsize;
+        shutdown_ssl_connection(serverssl, clientssl);
+        serverssl = clientssl = NULL;
+    }
+
+    if (!TEST_size_t_gt(len[0], SSL3_RT_MAX_PLAIN_LENGTH)
+            || !TEST_size_t_eq(len[1], len[0])
+            || !TEST_size_t_ge(bufsize[1], len[1])
+            || !TEST_size_t_lt(bufsize[1], bufsize[0]))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return testresult;
+}
+
+#if !defined(OPENSSL_NO_TLS1_2) && !defined(OPENSSL_NO_TLS1_3)
+/*
+ * Test SSL_MODE_RELEASE_HANDSHAKE_STATE
+ * Test 0: TLSv1.2 followed by a renegotiation
+ * Test 1: TLSv1.3 followed by a KeyUpdate
+ * Test 2: TLSv1.3 followed by post-handshake authentication
+ */
+static int test_release_handshake_state(int tst)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int version = tst == 0 ? TLS1_2_VERSION : TLS1_3_VERSION;
+    unsigned char buf[1];
+    size_t mem[2], n;
+    X509 *peer = NULL;
+    int release, i, testresult = 0;
+
+    for (release = 0; release <= 1; release++) {
+        SSL_free(serverssl);
+        SSL_free(clientssl);
+        SSL_CTX_free(sctx);
+        SSL_CTX_free(cctx);
+        serverssl = clientssl = NULL;
+        sctx = cctx = NULL;
+
+        if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                           TLS_client_method(), version,
+                                           version, &sctx, &cctx, cert,
+                                           privkey))
+                || !TEST_int_eq(SSL_CTX_use_certificate_file(cctx, cert,
+                                                             SSL_FILETYPE_PEM),
+                                1)
+                || !TEST_int_eq(SSL_CTX_use_PrivateKey_file(cctx, privkey,
+                                                            SSL_FILETYPE_PEM),
+                                1))
             goto end;
-        if (tst == 4 || tst == 5) {
-            /* Should still be able to read data from server */
-            if (!TEST_true(SSL_read_ex(clientssl, buf, sizeof(buf),
-                                       &readbytes))
-                    || !TEST_size_t_eq(readbytes, sizeof(msg))
-                    || !TEST_int_eq(memcmp(msg, buf, readbytes), 0)
-                    || !TEST_true(SSL_read_ex(clientssl, buf, sizeof(buf),
-                                              &readbytes))
-                    || !TEST_size_t_eq(readbytes, sizeof(msg))
-                    || !TEST_int_eq(memcmp(msg, buf, readbytes), 0))
-                goto end;
+        if (tst == 2)
+            SSL_CTX_set_post_handshake_auth(cctx, 1);
+        if (release) {
+            SSL_CTX_set_mode(sctx, SSL_MODE_RELEASE_HANDSHAKE_STATE);
+            SSL_CTX_set_mode(cctx, SSL_MODE_RELEASE_HANDSHAKE_STATE);
         }
+
+        if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                          NULL, NULL))
+                || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                    SSL_ERROR_NONE)))
+            goto end;
+        mem[release] = SSL_get_memory_usage(clientssl, SSL_MEM_HANDSHAKE)
+                       + SSL_get_memory_usage(serverssl, SSL_MEM_HANDSHAKE);
     }
 
-    /* Writing on the client after sending close_notify shouldn't be possible */
-    if (!TEST_false(SSL_write_ex(clientssl, msg, sizeof(msg), &written)))
+    /* Only the transcript kept for post-handshake authentication is left */
+    if (!TEST_size_t_lt(mem[1], mem[0])
+            || (tst != 2 && !TEST_size_t_eq(mem[1], 0)))
         goto end;
 
-    if (tst < 4) {
-        /*
-         * For these tests the client has sent close_notify but it has not yet
-         * been received by the server. The server has not sent close_notify
-         * yet.
-         */
-        if (!TEST_int_eq(SSL_shutdown(serverssl), 0)
-                   /*
-                    * Writing on the server after sending close_notify shouldn't
-                    * be possible.
-                    */
-                || !TEST_false(SSL_write_ex(serverssl, msg, sizeof(msg), &written))
-                || !TEST_int_eq(SSL_shutdown(clientssl), 1)
-                || !TEST_ptr_ne(sess = SSL_get_session(clientssl), NULL)
-                || !TEST_true(SSL_SESSION_is_resumable(sess))
-                || !TEST_int_eq(SSL_shutdown(serverssl), 1))
+    switch (tst) {
+    case 0:
+        if (!TEST_true(SSL_renegotiate(clientssl)))
             goto end;
-    } else if (tst == 4 || tst == 5) {
-        /*
-         * In this test the client has sent close_notify and it has been
-         * received by the server which has responded with a close_notify. The
-         * client needs to read the close_notify sent by the server.
-         */
-        if (!TEST_int_eq(SSL_shutdown(clientssl), 1)
-                || !TEST_ptr_ne(sess = SSL_get_session(clientssl), NULL)
-                || !TEST_true(SSL_SESSION_is_resumable(sess)))
+        for (i = 0; i < 3; i++) {
+            if (!TEST_int_le(SSL_read_ex(clientssl, buf, sizeof(buf), &n), 0)
+                    || !TEST_int_eq(SSL_get_error(clientssl, 0),
+                                    SSL_ERROR_WANT_READ)
+                    || !TEST_int_le(SSL_read_ex(serverssl, buf, sizeof(buf),
+                                                &n), 0)
+                    || !TEST_int_eq(SSL_get_error(serverssl, 0),
+                                    SSL_ERROR_WANT_READ))
+                goto end;
+        }
+        if (!TEST_false(SSL_renegotiate_pending(clientssl))
+                || !TEST_int_eq(SSL_num_renegotiations(clientssl), 1))
             goto end;
-    } else {
-        /*
-         * tst == 6
-         *
-         * The client has sent close_notify and is expecting a close_notify
-         * back, but instead there is application data first. The shutdown
-         * should fail with a fatal error.
-         */
-        if (!TEST_int_eq(SSL_shutdown(clientssl), -1)
-                || !TEST_int_eq(SSL_get_error(clientssl, -1), SSL_ERROR_SSL))
+        break;
+    case 1:
+        if (!TEST_true(SSL_key_update(clientssl, SSL_KEY_UPDATE_REQUESTED)))
+            goto end;
+        break;
+    case 2:
+        SSL_set_verify(serverssl, SSL_VERIFY_PEER, verify_cb);
+        if (!TEST_true(SSL_verify_client_post_handshake(serverssl)))
             goto end;
+        break;
     }
 
+    if (!TEST_true(SSL_write_ex(serverssl, "x", 1, &n))
+            || !TEST_true(SSL_read_ex(clientssl, buf, sizeof(buf), &n))
+            || !TEST_int_eq(buf[0], 'x')
+            || !TEST_true(SSL_write_ex(clientssl, "y", 1, &n))
+            || !TEST_true(SSL_read_ex(serverssl, buf, sizeof(buf), &n))
+            || !TEST_int_eq(buf[0], 'y'))
+        goto end;
+
+    if (tst == 2 && !TEST_ptr(peer = SSL_get_peer_certificate(serverssl)))
+        goto end;
+
     testresult = 1;
 
  end:
+    X509_free(peer);
     SSL_free(serverssl);
     SSL_free(clientssl);
     SSL_CTX_free(sctx);
     SSL_CTX_free(cctx);
-
     return testresult;
 }
+#endif
 
-#if !defined(OPENSSL_NO_TLS1_2) || !defined(OPENSSL_NO_TLS1_3)
-static int cert_cb_cnt;
-
-static int cert_cb(SSL *s, void *arg)
+/*
+ * Test that SSL_CTX_swap_cert_bundle() changes the certificate sent in new
+ * handshakes while connections already set up keep the old one and sessions
+ * made before the swap can still be resumed
+ */
+static int test_swap_cert_bundle(void)
 {
-    SSL_CTX *ctx = (SSL_CTX *)arg;
-    BIO *in = NULL;
-    EVP_PKEY *pkey = NULL;
-    X509 *x509 = NULL, *rootx = NULL;
-    STACK_OF(X509) *chain = NULL;
-    char *rootfile = NULL, *ecdsacert = NULL, *ecdsakey = NULL;
-    int ret = 0;
+    SSL_CTX *cctx = NULL, *sctx = NULL, *src = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    SSL *clientssl2 = NULL, *serverssl2 = NULL;
+    SSL_SESSION *sess = NULL;
+    X509 *oldcert = NULL, *newcert, *peer = NULL;
+    char *newcertfile = NULL, *newkeyfile = NULL;
+    int testresult = 0;
 
-    if (cert_cb_cnt == 0) {
-        /* Suspend the handshake */
-        cert_cb_cnt++;
-        return -1;
-    } else if (cert_cb_cnt == 1) {
-        /*
-         * Update the SSL_CTX, set the certificate and private key and then
-         * continue the handshake normally.
-         */
-        if (ctx != NULL && !TEST_ptr(SSL_set_SSL_CTX(s, ctx)))
-            return 0;
+    if (!TEST_ptr(newcertfile = test_mk_file_path(certsdir, "ee-cert.pem"))
+            || !TEST_ptr(newkeyfile = test_mk_file_path(certsdir,
+                                                        "ee-key.pem"))
+            || !TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                              TLS_client_method(),
+                                              TLS1_VERSION, TLS_MAX_VERSION,
+                                              &sctx, &cctx, cert, privkey))
+            || !TEST_ptr(src = SSL_CTX_new(TLS_server_method()))
+            || !TEST_int_eq(SSL_CTX_use_certificate_file(src, newcertfile,
+                                                         SSL_FILETYPE_PEM), 1)
+            || !TEST_int_eq(SSL_CTX_use_PrivateKey_file(src, newkeyfile,
+                                                        SSL_FILETYPE_PEM), 1))
+        goto end;
+    oldcert = SSL_CTX_get0_certificate(sctx);
+    newcert = SSL_CTX_get0_certificate(src);
+    if (!TEST_true(X509_up_ref(oldcert))) {
+        oldcert = NULL;
+        goto end;
+    }
 
-        if (!TEST_true(SSL_use_certificate_file(s, cert, SSL_FILETYPE_PEM))
-                || !TEST_true(SSL_use_PrivateKey_file(s, privkey,
-                                                      SSL_FILETYPE_PEM))
-                || !TEST_true(SSL_check_private_key(s)))
-            return 0;
-        cert_cb_cnt++;
-        return 1;
-    } else if (cert_cb_cnt == 3) {
-        int rv;
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_ptr(sess = SSL_get1_session(clientssl)))
+        goto end;
+    shutdown_ssl_connection(serverssl, clientssl);
+    serverssl = clientssl = NULL;
 
-        rootfile = test_mk_file_path(certsdir, "rootcert.pem");
-        ecdsacert = test_mk_file_path(certsdir, "server-ecdsa-cert.pem");
-        ecdsakey = test_mk_file_path(certsdir, "server-ecdsa-key.pem");
-        if (!TEST_ptr(rootfile) || !TEST_ptr(ecdsacert) || !TEST_ptr(ecdsakey))
-            goto out;
-        chain = sk_X509_new_null();
-        if (!TEST_ptr(chain))
-            goto out;
-        if (!TEST_ptr(in = BIO_new(BIO_s_file()))
-                || !TEST_int_ge(BIO_read_filename(in, rootfile), 0)
-                || !TEST_ptr(rootx = PEM_read_bio_X509(in, NULL, NULL, NULL))
-                || !TEST_true(sk_X509_push(chain, rootx)))
-            goto out;
-        rootx = NULL;
-        BIO_free(in);
-        if (!TEST_ptr(in = BIO_new(BIO_s_file()))
-                || !TEST_int_ge(BIO_read_filename(in, ecdsacert), 0)
-                || !TEST_ptr(x509 = PEM_read_bio_X509(in, NULL, NULL, NULL)))
-            goto out;
-        BIO_free(in);
-        if (!TEST_ptr(in = BIO_new(BIO_s_file()))
-                || !TEST_int_ge(BIO_read_filename(in, ecdsakey), 0)
-                || !TEST_ptr(pkey = PEM_read_bio_PrivateKey(in, NULL, NULL, NULL)))
-            goto out;
-        rv = SSL_check_chain(s, x509, pkey, chain);
-        /*
-         * If the cert doesn't show as valid here (e.g., because we don't
-         * have any shared sigalgs), then we will not set it, and there will
-         * be no certificate at all on the SSL or SSL_CTX.  This, in turn,
-         * will cause tls_choose_sigalgs() to fail the connection.
-         */
-        if ((rv & (CERT_PKEY_VALID | CERT_PKEY_CA_SIGNATURE))
-                == (CERT_PKEY_VALID | CERT_PKEY_CA_SIGNATURE)) {
-            if (!SSL_use_cert_and_key(s, x509, pkey, NULL, 1))
-                goto out;
-        }
+    /* A connection set up before the swap keeps the old certificate */
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl2, &clientssl2,
+                                      NULL, NULL))
+            || !TEST_false(SSL_CTX_swap_cert_bundle(sctx, sctx))
+            || !TEST_true(SSL_CTX_swap_cert_bundle(sctx, src)))
+        goto end;
+    SSL_CTX_free(src);
+    src = NULL;
+    if (!TEST_ptr_eq(SSL_CTX_get0_certificate(sctx), newcert)
+            || !TEST_true(create_ssl_connection(serverssl2, clientssl2,
+                                                SSL_ERROR_NONE))
+            || !TEST_ptr(peer = SSL_get_peer_certificate(clientssl2))
+            || !TEST_int_eq(X509_cmp(peer, oldcert), 0))
+        goto end;
+    X509_free(peer);
+    peer = NULL;
 
-        ret = 1;
-    }
+    /* The session cache and ticket keys survive the swap */
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(SSL_set_session(clientssl, sess))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_true(SSL_session_reused(clientssl)))
+        goto end;
+    shutdown_ssl_connection(serverssl, clientssl);
+    serverssl = clientssl = NULL;
+
+    /* A full handshake sends the new certificate */
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_ptr(peer = SSL_get_peer_certificate(clientssl))
+            || !TEST_int_eq(X509_cmp(peer, newcert), 0))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    X509_free(peer);
+    X509_free(oldcert);
+    SSL_SESSION_free(sess);
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_free(serverssl2);
+    SSL_free(clientssl2);
+    SSL_CTX_free(src);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    OPENSSL_free(newcertfile);
+    OPENSSL_free(newkeyfile);
+    return testresult;
+}
+
+/*
+ * Test that an SNI map attached to the server SSL_CTX switches connections
+ * to the SSL_CTX registered for the exact name or a wildcard
+ */
+static int test_sni_map(int tst)
+{
+    static const struct {
+        const char *name;
+        int child;
+    } names[] = {
+        { "www.example.com", 1 },
+        { "WWW.Example.COM.", 1 },
+        { "mail.example.com", 2 },
+        { "a.b.example.com", 0 },
+        { "example.com", 0 },
+        { "www.example.org", 0 },
+    };
+    SSL_CTX *cctx = NULL, *sctx = NULL, *child[3] = { NULL, NULL, NULL };
+    SSL *clientssl = NULL, *serverssl = NULL;
+    SSL_SNI_MAP *map = NULL;
+    X509 *peer = NULL;
+    char *ecdsacert = NULL, *ecdsakey = NULL;
+    int testresult = 0;
+
+    if (!TEST_ptr(ecdsacert = test_mk_file_path(certsdir,
+                                                "server-ecdsa-cert.pem"))
+            || !TEST_ptr(ecdsakey = test_mk_file_path(certsdir,
+                                                      "server-ecdsa-key.pem"))
+            || !TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                              TLS_client_method(),
+                                              TLS1_VERSION, TLS_MAX_VERSION,
+                                              &sctx, &cctx, cert, privkey))
+            || !TEST_ptr(child[1] = SSL_CTX_new(TLS_server_method()))
+            || !TEST_int_eq(SSL_CTX_use_certificate_file(child[1], ecdsacert,
+                                                         SSL_FILETYPE_PEM), 1)
+            || !TEST_int_eq(SSL_CTX_use_PrivateKey_file(child[1], ecdsakey,
+                                                        SSL_FILETYPE_PEM), 1)
+            || !TEST_ptr(child[2] = SSL_CTX_new(TLS_server_method()))
+            || !TEST_int_eq(SSL_CTX_use_certificate_file(child[2], cert,
+                                                         SSL_FILETYPE_PEM), 1)
+            || !TEST_int_eq(SSL_CTX_use_PrivateKey_file(child[2], privkey,
+                                                        SSL_FILETYPE_PEM), 1)
+            || !TEST_ptr(map = SSL_SNI_MAP_new())
+            || !TEST_false(SSL_SNI_MAP_add(map, "*", child[1]))
+            || !TEST_false(SSL_SNI_MAP_add(map, "www.*.com", child[1]))
+            || !TEST_false(SSL_SNI_MAP_add(map, "www..example.com", child[1]))
+            || !TEST_true(SSL_SNI_MAP_add(map, "www.example.com", child[2]))
+            || !TEST_true(SSL_SNI_MAP_add(map, "*.example.com", child[2]))
+            || !TEST_true(SSL_SNI_MAP_add(map, "*.example.org", child[2]))
+            /* Replaces the first entry */
+            || !TEST_true(SSL_SNI_MAP_add(map, "Www.Example.com", child[1]))
+            || !TEST_true(SSL_SNI_MAP_remove(map, "*.example.org"))
+            || !TEST_false(SSL_SNI_MAP_remove(map, "*.example.org"))
+            || !TEST_true(SSL_CTX_set1_sni_map(sctx, map)))
+        goto end;
+    child[0] = sctx;
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(SSL_set_tlsext_host_name(clientssl,
+                                                   names[tst].name))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_ptr_eq(SSL_get_SSL_CTX(serverssl),
+                            child[names[tst].child])
+            || !TEST_ptr(peer = SSL_get_peer_certificate(clientssl))
+            || !TEST_int_eq(X509_cmp(peer, SSL_CTX_get0_certificate(
+                                               child[names[tst].child])), 0))
+        goto end;
+
+    testresult = 1;
 
-    /* Abort the handshake */
- out:
+ end:
+    X509_free(peer);
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_SNI_MAP_free(map);
+    SSL_CTX_free(child[1]);
+    SSL_CTX_free(child[2]);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
     OPENSSL_free(ecdsacert);
     OPENSSL_free(ecdsakey);
-    OPENSSL_free(rootfile);
-    BIO_free(in);
-    EVP_PKEY_free(pkey);
-    X509_free(x509);
-    X509_free(rootx);
-    sk_X509_pop_free(chain, X509_free);
+    return testresult;
+}
+
+/*
+ * Connect a client to |port| on the host the client session cache of |cctx|
+ * keys on, and report in |*reused| whether a session was resumed.
+ */
+static int client_cache_connect(SSL_CTX *sctx, SSL_CTX *cctx,
+                                unsigned int port, int *reused)
+{
+    SSL *serverssl = NULL, *clientssl = NULL;
+    int ret = 0;
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(SSL_set1_client_session_cache_key(clientssl,
+                                                            "localhost", port))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE)))
+        goto end;
+    *reused = SSL_session_reused(clientssl);
+    shutdown_ssl_connection(serverssl, clientssl);
+    serverssl = clientssl = NULL;
+    ret = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
     return ret;
 }
 
+/* Make new sessions look as if they had been made long ago */
+static int client_cache_expire_cb(SSL *ssl, SSL_SESSION *sess)
+{
+    SSL_SESSION_set_time(sess,
+                         (long)time(NULL) - 2 * SSL_SESSION_get_timeout(sess));
+    return 0;
+}
+
 /*
- * Test the certificate callback.
- * Test 0: Callback fails
- * Test 1: Success - no SSL_set_SSL_CTX() in the callback
- * Test 2: Success - SSL_set_SSL_CTX() in the callback
- * Test 3: Success - Call SSL_check_chain from the callback
- * Test 4: Failure - SSL_check_chain fails from callback due to bad cert in the
- *                   chain
- * Test 5: Failure - SSL_check_chain fails from callback due to bad ee cert
+ * Test that the client session cache resumes sessions with the server they
+ * came from, in TLSv1.3 (tst == 0) using each ticket once and in TLSv1.2
+ * (tst == 1) the same session again.
  */
-static int test_cert_cb_int(int prot, int tst)
+static int test_client_session_cache(int tst)
 {
-    SSL_CTX *cctx = NULL, *sctx = NULL, *snictx = NULL;
-    SSL *clientssl = NULL, *serverssl = NULL;
-    int testresult = 0, ret;
+    SSL_CTX *sctx = NULL, *cctx = NULL;
+    int version = tst == 0 ? TLS1_3_VERSION : TLS1_2_VERSION;
+    int reused, i, testresult = 0;
 
-#ifdef OPENSSL_NO_EC
-    /* We use an EC cert in these tests, so we skip in a no-ec build */
-    if (tst >= 3)
-        return 1;
+#ifdef OPENSSL_NO_TLS1_3
+    if (tst == 0)
+        return TEST_skip("TLSv1.3 is disabled");
+#endif
+#ifdef OPENSSL_NO_TLS1_2
+    if (tst == 1)
+        return TEST_skip("TLSv1.2 is disabled");
 #endif
 
-    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
-                                       TLS_client_method(),
-                                       TLS1_VERSION,
-                                       prot,
-                                       &sctx, &cctx, NULL, NULL)))
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(), TLS_client_method(),
+                                       version, version,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_size_t_eq(SSL_CTX_get_client_session_cache_size(cctx), 0))
         goto end;
 
-    if (tst == 0)
-        cert_cb_cnt = -1;
-    else if (tst >= 3)
-        cert_cb_cnt = 3;
-    else
-        cert_cb_cnt = 0;
-
-    if (tst == 2)
-        snictx = SSL_CTX_new(TLS_server_method());
-    SSL_CTX_set_cert_cb(sctx, cert_cb, snictx);
+    /* Not resumed unless enabled */
+    if (!TEST_true(client_cache_connect(sctx, cctx, 443, &reused))
+            || !TEST_false(reused)
+            || !TEST_true(client_cache_connect(sctx, cctx, 443, &reused))
+            || !TEST_false(reused))
+        goto end;
 
-    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
-                                      NULL, NULL)))
+    if (!TEST_true(SSL_CTX_set_client_session_cache_size(cctx, 2))
+            || !TEST_size_t_eq(SSL_CTX_get_client_session_cache_size(cctx), 2)
+            || !TEST_true(client_cache_connect(sctx, cctx, 443, &reused))
+            || !TEST_false(reused))
         goto end;
 
-    if (tst == 4) {
-        /*
-         * We cause SSL_check_chain() to fail by specifying sig_algs that
-         * the chain doesn't meet (the root uses an RSA cert)
-         */
-        if (!TEST_true(SSL_set1_sigalgs_list(clientssl,
-                                             "ecdsa_secp256r1_sha256")))
-            goto end;
-    } else if (tst == 5) {
-        /*
-         * We cause SSL_check_chain() to fail by specifying sig_algs that
-         * the ee cert doesn't meet (the ee uses an ECDSA cert)
-         */
-        if (!TEST_true(SSL_set1_sigalgs_list(clientssl,
-                           "rsa_pss_rsae_sha256:rsa_pkcs1_sha256")))
+    /* Every connection resumes, consuming tickets and getting new ones */
+    for (i = 0; i < 4; i++) {
+        if (!TEST_true(client_cache_connect(sctx, cctx, 443, &reused))
+                || !TEST_true(reused))
             goto end;
     }
 
-    ret = create_ssl_connection(serverssl, clientssl, SSL_ERROR_NONE);
-    if (!TEST_true(tst == 0 || tst == 4 || tst == 5 ? !ret : ret)
-            || (tst > 0
-                && !TEST_int_eq((cert_cb_cnt - 2) * (cert_cb_cnt - 3), 0))) {
+    /* Another port is another server */
+    if (!TEST_true(client_cache_connect(sctx, cctx, 8443, &reused))
+            || !TEST_false(reused)
+            || !TEST_true(client_cache_connect(sctx, cctx, 8443, &reused))
+            || !TEST_true(reused))
+        goto end;
+
+    /* With room for two servers a third evicts the least recently used */
+    if (!TEST_true(client_cache_connect(sctx, cctx, 444, &reused))
+            || !TEST_false(reused)
+            || !TEST_true(client_cache_connect(sctx, cctx, 443, &reused))
+            || !TEST_false(reused))
+        goto end;
+
+    /* Sessions that have expired are not resumed */
+    if (!TEST_true(client_cache_connect(sctx, cctx, 444, &reused))
+            || !TEST_true(reused))
+        goto end;
+    SSL_CTX_set_session_cache_mode(cctx, SSL_SESS_CACHE_CLIENT);
+    SSL_CTX_sess_set_new_cb(cctx, client_cache_expire_cb);
+    if (!TEST_true(client_cache_connect(sctx, cctx, 8443, &reused))
+            || !TEST_false(reused)
+            || !TEST_true(client_cache_connect(sctx, cctx, 8443, &reused))
+            || !TEST_false(reused))
         goto end;
-    }
 
     testresult = 1;
 
  end:
-    SSL_free(serverssl);
-    SSL_free(clientssl);
     SSL_CTX_free(sctx);
     SSL_CTX_free(cctx);
-    SSL_CTX_free(snictx);
+    return testresult;
+}
+
+/*
+ * Test that setting an ALPN does not violate RFC
+ */
+static int test_set_alpn(void)
+{
+    SSL_CTX *ctx = NULL;
+    SSL *ssl = NULL;
+    int testresult = 0;
+
+    unsigned char bad0[] = { 0x00, 'b', 'a', 'd' };
+    unsigned char good[] = { 0x04, 'g', 'o', 'o', 'd' };
+    unsigned char bad1[] = { 0x01, 'b', 'a', 'd' };
+    unsigned char bad2[] = { 0x03, 'b', 'a', 'd', 0x00};
+    unsigned char bad3[] = { 0x03, 'b', 'a', 'd', 0x01, 'b', 'a', 'd'};
+    unsigned char bad4[] = { 0x03, 'b', 'a', 'd', 0x06, 'b', 'a', 'd'};
 
+    /* Create an initial SSL_CTX with no certificate configured */
+    ctx = SSL_CTX_new(TLS_server_method());
+    if (!TEST_ptr(ctx))
+        goto end;
+
+    /* the set_alpn functions return 0 (false) on success, non-zero (true) on failure */
+    if (!TEST_false(SSL_CTX_set_alpn_protos(ctx, NULL, 2)))
+        goto end;
+    if (!TEST_false(SSL_CTX_set_alpn_protos(ctx, good, 0)))
+        goto end;
+    if (!TEST_false(SSL_CTX_set_alpn_protos(ctx, good, sizeof(good))))
+        goto end;
+    if (!TEST_true(SSL_CTX_set_alpn_protos(ctx, good, 1)))
+        goto end;
+    if (!TEST_true(SSL_CTX_set_alpn_protos(ctx, bad0, sizeof(bad0))))
+        goto end;
+    if (!TEST_true(SSL_CTX_set_alpn_protos(ctx, bad1, sizeof(bad1))))
+        goto end;
+    if (!TEST_true(SSL_CTX_set_alpn_protos(ctx, bad2, sizeof(bad2))))
+        goto end;
+    if (!TEST_true(SSL_CTX_set_alpn_protos(ctx, bad3, sizeof(bad3))))
+        goto end;
+    if (!TEST_true(SSL_CTX_set_alpn_protos(ctx, bad4, sizeof(bad4))))
+        goto end;
+
+    ssl = SSL_new(ctx);
+    if (!TEST_ptr(ssl))
+        goto end;
+
+    if (!TEST_false(SSL_set_alpn_protos(ssl, NULL, 2)))
+        goto end;
+    if (!TEST_false(SSL_set_alpn_protos(ssl, good, 0)))
+        goto end;
+    if (!TEST_false(SSL_set_alpn_protos(ssl, good, sizeof(good))))
+        goto end;
+    if (!TEST_true(SSL_set_alpn_protos(ssl, good, 1)))
+        goto end;
+    if (!TEST_true(SSL_set_alpn_protos(ssl, bad0, sizeof(bad0))))
+        goto end;
+    if (!TEST_true(SSL_set_alpn_protos(ssl, bad1, sizeof(bad1))))
+        goto end;
+    if (!TEST_true(SSL_set_alpn_protos(ssl, bad2, sizeof(bad2))))
+        goto end;
+    if (!TEST_true(SSL_set_alpn_protos(ssl, bad3, sizeof(bad3))))
+        goto end;
+    if (!TEST_true(SSL_set_alpn_protos(ssl, bad4, sizeof(bad4))))
+        goto end;
+
+    testresult = 1;
+
+end:
+    SSL_free(ssl);
+    SSL_CTX_free(ctx);
     return testresult;
 }
-#endif
 
-static int test_cert_cb(int tst)
+/*
+ * Test SSL_CTX_set1_verify/chain_cert_store and SSL_CTX_get_verify/chain_cert_store.
+ */
+static int test_set_verify_cert_store_ssl_ctx(void)
+{
+   SSL_CTX *ctx = NULL;
+   int testresult = 0;
+   X509_STORE *store = NULL, *new_store = NULL,
+              *cstore = NULL, *new_cstore = NULL;
+
+   /* Create an initial SSL_CTX. */
+   ctx = SSL_CTX_new(TLS_server_method());
+   if (!TEST_ptr(ctx))
+       goto end;
+
+   /* Retrieve verify store pointer. */
+   if (!TEST_true(SSL_CTX_get0_verify_cert_store(ctx, &store)))
+       goto end;
+
+   /* Retrieve chain store pointer. */
+   if (!TEST_true(SSL_CTX_get0_chain_cert_store(ctx, &cstore)))
+       goto end;
+
+   /* We haven't set any yet, so this should be NULL. */
+   if (!TEST_ptr_null(store) || !TEST_ptr_null(cstore))
+       goto end;
+
+   /* Create stores. We use separate stores so pointers are different. */
+   new_store = X509_STORE_new();
+   if (!TEST_ptr(new_store))
+       goto end;
+
+   new_cstore = X509_STORE_new();
+   if (!TEST_ptr(new_cstore))
+       goto end;
+
+   /* Set stores. */
+   if (!TEST_true(SSL_CTX_set1_verify_cert_store(ctx, new_store)))
+       goto end;
+
+   if (!TEST_true(SSL_CTX_set1_chain_cert_store(ctx, new_cstore)))
+       goto end;
+
+   /* Should be able to retrieve the same pointer. */
+   if (!TEST_true(SSL_CTX_get0_verify_cert_store(ctx, &store)))
+       goto end;
+
+   if (!TEST_true(SSL_CTX_get0_chain_cert_store(ctx, &cstore)))
+       goto end;
+
+   if (!TEST_ptr_eq(store, new_store) || !TEST_ptr_eq(cstore, new_cstore))
+       goto end;
+
+   /* Should be able to unset again. */
+   if (!TEST_true(SSL_CTX_set1_verify_cert_store(ctx, NULL)))
+       goto end;
+
+   if (!TEST_true(SSL_CTX_set1_chain_cert_store(ctx, NULL)))
+       goto end;
+
+   /* Should now be NULL. */
+   if (!TEST_true(SSL_CTX_get0_verify_cert_store(ctx, &store)))
+       goto end;
+
+   if (!TEST_true(SSL_CTX_get0_chain_cert_store(ctx, &cstore)))
+       goto end;
+
+   if (!TEST_ptr_null(store) || !TEST_ptr_null(cstore))
+       goto end;
+
+   testresult = 1;
+
+end:
+   X509_STORE_free(new_store);
+   X509_STORE_free(new_cstore);
+   SSL_CTX_free(ctx);
+   return testresult;
+}
+
+/*
+ * Test SSL_set1_verify/chain_cert_store and SSL_get_verify/chain_cert_store.
+ */
+static int test_set_verify_cert_store_ssl(void)
 {
-    int testresult = 1;
+   SSL_CTX *ctx = NULL;
+   SSL *ssl = NULL;
+   int testresult = 0;
+   X509_STORE *store = NULL, *new_store = NULL,
+              *cstore = NULL, *new_cstore = NULL;
 
-#ifndef OPENSSL_NO_TLS1_2
-    testresult &= test_cert_cb_int(TLS1_2_VERSION, tst);
-#endif
-#ifndef OPENSSL_NO_TLS1_3
-    testresult &= test_cert_cb_int(TLS1_3_VERSION, tst);
-#endif
+   /* Create an initial SSL_CTX. */
+   ctx = SSL_CTX_new(TLS_server_method());
+   if (!TEST_ptr(ctx))
+       goto end;
 
-    return testresult;
-}
+   /* Create an SSL object. */
+   ssl = SSL_new(ctx);
+   if (!TEST_ptr(ssl))
+       goto end;
 
-static int client_cert_cb(SSL *ssl, X509 **x509, EVP_PKEY **pkey)
-{
-    X509 *xcert, *peer;
-    EVP_PKEY *privpkey;
-    BIO *in = NULL;
+   /* Retrieve verify store pointer. */
+   if (!TEST_true(SSL_get0_verify_cert_store(ssl, &store)))
+       goto end;
 
-    /* Check that SSL_get_peer_certificate() returns something sensible */
-    peer = SSL_get_peer_certificate(ssl);
-    if (!TEST_ptr(peer))
-        return 0;
-    X509_free(peer);
+   /* Retrieve chain store pointer. */
+   if (!TEST_true(SSL_get0_chain_cert_store(ssl, &cstore)))
+       goto end;
 
-    in = BIO_new_file(cert, "r");
-    if (!TEST_ptr(in))
-        return 0;
+   /* We haven't set any yet, so this should be NULL. */
+   if (!TEST_ptr_null(store) || !TEST_ptr_null(cstore))
+       goto end;
 
-    xcert = PEM_read_bio_X509(in, NULL, NULL, NULL);
-    BIO_free(in);
-    if (!TEST_ptr(xcert))
-        return 0;
+   /* Create stores. We use separate stores so pointers are different. */
+   new_store = X509_STORE_new();
+   if (!TEST_ptr(new_store))
+       goto end;
 
-    in = BIO_new_file(privkey, "r");
-    if (!TEST_ptr(in)) {
-        X509_free(xcert);
-        return 0;
-    }
+   new_cstore = X509_STORE_new();
+   if (!TEST_ptr(new_cstore))
+       goto end;
 
-    privpkey = PEM_read_bio_PrivateKey(in, NULL, NULL, NULL);
-    BIO_free(in);
-    if (!TEST_ptr(privpkey)) {
-        X509_free(xcert);
-        return 0;
-    }
+   /* Set stores. */
+   if (!TEST_true(SSL_set1_verify_cert_store(ssl, new_store)))
+       goto end;
 
-    *x509 = xcert;
-    *pkey = privpkey;
+   if (!TEST_true(SSL_set1_chain_cert_store(ssl, new_cstore)))
+       goto end;
 
-    return 1;
-}
+   /* Should be able to retrieve the same pointer. */
+   if (!TEST_true(SSL_get0_verify_cert_store(ssl, &store)))
+       goto end;
 
-static int test_client_cert_cb(int tst)
-{
-    SSL_CTX *cctx = NULL, *sctx = NULL;
-    SSL *clientssl = NULL, *serverssl = NULL;
-    int testresult = 0;
+   if (!TEST_true(SSL_get0_chain_cert_store(ssl, &cstore)))
+       goto end;
 
-#ifdef OPENSSL_NO_TLS1_2
-    if (tst == 0)
-        return 1;
-#endif
-#ifdef OPENSSL_NO_TLS1_3
-    if (tst == 1)
-        return 1;
-#endif
+   if (!TEST_ptr_eq(store, new_store) || !TEST_ptr_eq(cstore, new_cstore))
+       goto end;
 
-    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
-                                       TLS_client_method(),
-                                       TLS1_VERSION,
-                                       tst == 0 ? TLS1_2_VERSION
-                                                : TLS1_3_VERSION,
-                                       &sctx, &cctx, cert, privkey)))
-        goto end;
+   /* Should be able to unset again. */
+   if (!TEST_true(SSL_set1_verify_cert_store(ssl, NULL)))
+       goto end;
 
-    /*
-     * Test that setting a client_cert_cb results in a client certificate being
-     * sent.
-     */
-    SSL_CTX_set_client_cert_cb(cctx, client_cert_cb);
-    SSL_CTX_set_verify(sctx,
-                       SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT,
-                       verify_cb);
+   if (!TEST_true(SSL_set1_chain_cert_store(ssl, NULL)))
+       goto end;
 
-    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
-                                      NULL, NULL))
-            || !TEST_true(create_ssl_connection(serverssl, clientssl,
-                                                SSL_ERROR_NONE)))
-        goto end;
+   /* Should now be NULL. */
+   if (!TEST_true(SSL_get0_verify_cert_store(ssl, &store)))
+       goto end;
 
-    testresult = 1;
+   if (!TEST_true(SSL_get0_chain_cert_store(ssl, &cstore)))
+       goto end;
 
- end:
-    SSL_free(serverssl);
-    SSL_free(clientssl);
-    SSL_CTX_free(sctx);
-    SSL_CTX_free(cctx);
+   if (!TEST_ptr_null(store) || !TEST_ptr_null(cstore))
+       goto end;
 
-    return testresult;
+   testresult = 1;
+
+end:
+   X509_STORE_free(new_store);
+   X509_STORE_free(new_cstore);
+   SSL_free(ssl);
+   SSL_CTX_free(ctx);
+   return testresult;
 }
 
-#if !defined(OPENSSL_NO_TLS1_2) || !defined(OPENSSL_NO_TLS1_3)
-/*
- * Test setting certificate authorities on both client and server.
- *
- * Test 0: SSL_CTX_set0_CA_list() only
- * Test 1: Both SSL_CTX_set0_CA_list() and SSL_CTX_set_client_CA_list()
- * Test 2: Only SSL_CTX_set_client_CA_list()
- */
-static int test_ca_names_int(int prot, int tst)
+static int test_inherit_verify_param(void)
 {
-    SSL_CTX *cctx = NULL, *sctx = NULL;
-    SSL *clientssl = NULL, *serverssl = NULL;
     int testresult = 0;
-    size_t i;
-    X509_NAME *name[] = { NULL, NULL, NULL, NULL };
-    char *strnames[] = { "Jack", "Jill", "John", "Joanne" };
-    STACK_OF(X509_NAME) *sk1 = NULL, *sk2 = NULL;
-    const STACK_OF(X509_NAME) *sktmp = NULL;
 
-    for (i = 0; i < OSSL_NELEM(name); i++) {
-        name[i] = X509_NAME_new();
-        if (!TEST_ptr(name[i])
-                || !TEST_true(X509_NAME_add_entry_by_txt(name[i], "CN",
-                                                         MBSTRING_ASC,
-                                                         (unsigned char *)
-                                                         strnames[i],
-                                                         -1, -1, 0)))
-            goto end;
-    }
+    SSL_CTX *ctx = NULL;
+    X509_VERIFY_PARAM *cp = NULL;
+    SSL *ssl = NULL;
+    X509_VERIFY_PARAM *sp = NULL;
+    int hostflags = X509_CHECK_FLAG_NEVER_CHECK_SUBJECT;
 
-    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
-                                       TLS_client_method(),
-                                       TLS1_VERSION,
-                                       prot,
-                                       &sctx, &cctx, cert, privkey)))
+    ctx = SSL_CTX_new(TLS_server_method());
+    if (!TEST_ptr(ctx))
         goto end;
 
-    SSL_CTX_set_verify(sctx, SSL_VERIFY_PEER, NULL);
-
-    if (tst == 0 || tst == 1) {
-        if (!TEST_ptr(sk1 = sk_X509_NAME_new_null())
-                || !TEST_true(sk_X509_NAME_push(sk1, X509_NAME_dup(name[0])))
-                || !TEST_true(sk_X509_NAME_push(sk1, X509_NAME_dup(name[1])))
-                || !TEST_ptr(sk2 = sk_X509_NAME_new_null())
-                || !TEST_true(sk_X509_NAME_push(sk2, X509_NAME_dup(name[0])))
-                || !TEST_true(sk_X509_NAME_push(sk2, X509_NAME_dup(name[1]))))
-            goto end;
-
-        SSL_CTX_set0_CA_list(sctx, sk1);
-        SSL_CTX_set0_CA_list(cctx, sk2);
-        sk1 = sk2 = NULL;
-    }
-    if (tst == 1 || tst == 2) {
-        if (!TEST_ptr(sk1 = sk_X509_NAME_new_null())
-                || !TEST_true(sk_X509_NAME_push(sk1, X509_NAME_dup(name[2])))
-                || !TEST_true(sk_X509_NAME_push(sk1, X509_NAME_dup(name[3])))
-                || !TEST_ptr(sk2 = sk_X509_NAME_new_null())
-                || !TEST_true(sk_X509_NAME_push(sk2, X509_NAME_dup(name[2])))
-                || !TEST_true(sk_X509_NAME_push(sk2, X509_NAME_dup(name[3]))))
-            goto end;
-
-        SSL_CTX_set_client_CA_list(sctx, sk1);
-        SSL_CTX_set_client_CA_list(cctx, sk2);
-        sk1 = sk2 = NULL;
-    }
-
-    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
-                                      NULL, NULL))
-            || !TEST_true(create_ssl_connection(serverssl, clientssl,
-                                                SSL_ERROR_NONE)))
+    cp = SSL_CTX_get0_param(ctx);
+    if (!TEST_ptr(cp))
         goto end;
-
-    /*
-     * We only expect certificate authorities to have been sent to the server
-     * if we are using TLSv1.3 and SSL_set0_CA_list() was used
-     */
-    sktmp = SSL_get0_peer_CA_list(serverssl);
-    if (prot == TLS1_3_VERSION
-            && (tst == 0 || tst == 1)) {
-        if (!TEST_ptr(sktmp)
-                || !TEST_int_eq(sk_X509_NAME_num(sktmp), 2)
-                || !TEST_int_eq(X509_NAME_cmp(sk_X509_NAME_value(sktmp, 0),
-                                              name[0]), 0)
-                || !TEST_int_eq(X509_NAME_cmp(sk_X509_NAME_value(sktmp, 1),
-                                              name[1]), 0))
-            goto end;
-    } else if (!TEST_ptr_null(sktmp)) {
+    if (!TEST_int_eq(X509_VERIFY_PARAM_get_hostflags(cp), 0))
         goto end;
-    }
 
-    /*
-     * In all tests we expect certificate authorities to have been sent to the
-     * client. However, SSL_set_client_CA_list() should override
-     * SSL_set0_CA_list()
-     */
-    sktmp = SSL_get0_peer_CA_list(clientssl);
-    if (!TEST_ptr(sktmp)
-            || !TEST_int_eq(sk_X509_NAME_num(sktmp), 2)
-            || !TEST_int_eq(X509_NAME_cmp(sk_X509_NAME_value(sktmp, 0),
-                                          name[tst == 0 ? 0 : 2]), 0)
-            || !TEST_int_eq(X509_NAME_cmp(sk_X509_NAME_value(sktmp, 1),
-                                          name[tst == 0 ? 1 : 3]), 0))
+    X509_VERIFY_PARAM_set_hostflags(cp, hostflags);
+
+    ssl = SSL_new(ctx);
+    if (!TEST_ptr(ssl))
+        goto end;
+
+    sp = SSL_get0_param(ssl);
+    if (!TEST_ptr(sp))
+        goto end;
+    if (!TEST_int_eq(X509_VERIFY_PARAM_get_hostflags(sp), hostflags))
         goto end;
 
     testresult = 1;
 
  end:
-    SSL_free(serverssl);
-    SSL_free(clientssl);
-    SSL_CTX_free(sctx);
-    SSL_CTX_free(cctx);
-    for (i = 0; i < OSSL_NELEM(name); i++)
-        X509_NAME_free(name[i]);
-    sk_X509_NAME_pop_free(sk1, X509_NAME_free);
-    sk_X509_NAME_pop_free(sk2, X509_NAME_free);
+    SSL_free(ssl);
+    SSL_CTX_free(ctx);
 
     return testresult;
 }
-#endif
 
-static int test_ca_names(int tst)
+#if !defined(OPENSSL_NO_TLS1_3) && defined(OPENSSL_THREADS) \
+    && !defined(OPENSSL_SYS_WINDOWS)
+/*
+ * Checks that |s| has paused its ASYNC job for an operation on the KEM
+ * workers and waits until the result is ready.
+ */
+static int oqs_wait_for_workers(SSL *s)
 {
-    int testresult = 1;
+    OSSL_ASYNC_FD fd;
+    size_t numfds = 1;
+    fd_set rfds;
 
-#ifndef OPENSSL_NO_TLS1_2
-    testresult &= test_ca_names_int(TLS1_2_VERSION, tst);
-#endif
-#ifndef OPENSSL_NO_TLS1_3
-    testresult &= test_ca_names_int(TLS1_3_VERSION, tst);
-#endif
+    if (!TEST_int_eq(SSL_get_error(s, -1), SSL_ERROR_WANT_ASYNC)
+            || !TEST_true(SSL_get_all_async_fds(s, &fd, &numfds))
+            || !TEST_size_t_eq(numfds, 1))
+        return 0;
+    FD_ZERO(&rfds);
+    FD_SET(fd, &rfds);
+    return TEST_int_eq(select(fd + 1, &rfds, NULL, NULL, NULL), 1);
+}
 
-    return testresult;
+/* Waits up to 5 seconds for the keypair pool of |ctx| to hold |count| pairs */
+static int oqs_wait_for_keypairs(SSL_CTX *ctx, size_t count)
+{
+    struct timeval tv;
+    int i;
+
+    for (i = 0; i < 500
+                && SSL_CTX_get_oqs_keypair_pool_count(ctx) != count; i++) {
+        tv.tv_sec = 0;
+        tv.tv_usec = 10000;
+        select(0, NULL, NULL, NULL, &tv);
+    }
+    return TEST_size_t_eq(SSL_CTX_get_oqs_keypair_pool_count(ctx), count);
 }
+#endif
 
 /*
- * Test 0: Client sets servername and server acknowledges it (TLSv1.2)
- * Test 1: Client sets servername and server does not acknowledge it (TLSv1.2)
- * Test 2: Client sets inconsistent servername on resumption (TLSv1.2)
- * Test 3: Client does not set servername on initial handshake (TLSv1.2)
- * Test 4: Client does not set servername on resumption handshake (TLSv1.2)
- * Test 5: Client sets servername and server acknowledges it (TLSv1.3)
- * Test 6: Client sets servername and server does not acknowledge it (TLSv1.3)
- * Test 7: Client sets inconsistent servername on resumption (TLSv1.3)
- * Test 8: Client does not set servername on initial handshake(TLSv1.3)
- * Test 9: Client does not set servername on resumption handshake (TLSv1.3)
+ * Test that KEM workers can be configured on an SSL_CTX and that, in async
+ * mode, the encapsulation on the server and the decapsulation on the client
+ * run on them.
  */
-static int test_servername(int tst)
+static int test_oqs_kem_workers(void)
 {
     SSL_CTX *cctx = NULL, *sctx = NULL;
     SSL *clientssl = NULL, *serverssl = NULL;
+    char *ecdsacert = NULL, *ecdsakey = NULL;
     int testresult = 0;
-    SSL_SESSION *sess = NULL;
-    const char *sexpectedhost = NULL, *cexpectedhost = NULL;
-
-#ifdef OPENSSL_NO_TLS1_2
-    if (tst <= 4)
-        return 1;
-#endif
-#ifdef OPENSSL_NO_TLS1_3
-    if (tst >= 5)
-        return 1;
-#endif
 
-    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
-                                       TLS_client_method(),
-                                       TLS1_VERSION,
-                                       (tst <= 4) ? TLS1_2_VERSION
-                                                  : TLS1_3_VERSION,
-                                       &sctx, &cctx, cert, privkey))
-            || !TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
-                                             NULL, NULL)))
+    /* With an ECDSA server key no signature goes to the workers */
+    if (!TEST_ptr(ecdsacert = test_mk_file_path(certsdir,
+                                                "server-ecdsa-cert.pem"))
+            || !TEST_ptr(ecdsakey = test_mk_file_path(certsdir,
+                                                      "server-ecdsa-key.pem"))
+            || !TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                              TLS_client_method(),
+                                              TLS1_VERSION, TLS_MAX_VERSION,
+                                              &sctx, &cctx, ecdsacert,
+                                              ecdsakey)))
         goto end;
 
-    if (tst != 1 && tst != 6) {
-        if (!TEST_true(SSL_CTX_set_tlsext_servername_callback(sctx,
-                                                              hostname_cb)))
-            goto end;
-    }
-
-    if (tst != 3 && tst != 8) {
-        if (!TEST_true(SSL_set_tlsext_host_name(clientssl, "goodhost")))
-            goto end;
-        sexpectedhost = cexpectedhost = "goodhost";
-    }
-
-    if (!TEST_true(create_ssl_connection(serverssl, clientssl, SSL_ERROR_NONE)))
+    if (!TEST_size_t_eq(SSL_CTX_get_oqs_kem_workers(sctx), 0))
         goto end;
-
-    if (!TEST_str_eq(SSL_get_servername(clientssl, TLSEXT_NAMETYPE_host_name),
-                     cexpectedhost)
-            || !TEST_str_eq(SSL_get_servername(serverssl,
-                                               TLSEXT_NAMETYPE_host_name),
-                            sexpectedhost))
+#if defined(OPENSSL_THREADS) && !defined(OPENSSL_SYS_WINDOWS)
+    if (!TEST_true(SSL_CTX_set_oqs_kem_workers(sctx, 2))
+            || !TEST_size_t_eq(SSL_CTX_get_oqs_kem_workers(sctx), 2)
+            /* Reconfiguring replaces the running workers */
+            || !TEST_true(SSL_CTX_set_oqs_kem_workers(sctx, 3))
+            || !TEST_size_t_eq(SSL_CTX_get_oqs_kem_workers(sctx), 3)
+            || !TEST_true(SSL_CTX_set_oqs_kem_workers(cctx, 1)))
         goto end;
-
-    /* Now repeat with a resumption handshake */
-
-    if (!TEST_int_eq(SSL_shutdown(clientssl), 0)
-            || !TEST_ptr_ne(sess = SSL_get1_session(clientssl), NULL)
-            || !TEST_true(SSL_SESSION_is_resumable(sess))
-            || !TEST_int_eq(SSL_shutdown(serverssl), 0))
+#else
+    if (!TEST_false(SSL_CTX_set_oqs_kem_workers(sctx, 2)))
         goto end;
+#endif
 
-    SSL_free(clientssl);
-    SSL_free(serverssl);
-    clientssl = serverssl = NULL;
-
-    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl, NULL,
-                                      NULL)))
+#ifndef OPENSSL_NO_TLS1_3
+    if (!TEST_true(SSL_CTX_set1_groups_list(sctx, "kyber512"))
+            || !TEST_true(SSL_CTX_set1_groups_list(cctx, "kyber512")))
         goto end;
-
-    if (!TEST_true(SSL_set_session(clientssl, sess)))
+    if (!OQS_KEM_alg_is_enabled(OQS_ALG_NAME(NID_kyber512))) {
+        TEST_info("Skipping handshake: kyber512 is disabled in liboqs");
+        testresult = 1;
         goto end;
-
-    sexpectedhost = cexpectedhost = "goodhost";
-    if (tst == 2 || tst == 7) {
-        /* Set an inconsistent hostname */
-        if (!TEST_true(SSL_set_tlsext_host_name(clientssl, "altgoodhost")))
-            goto end;
-        /*
-         * In TLSv1.2 we expect the hostname from the original handshake, in
-         * TLSv1.3 we expect the hostname from this handshake
-         */
-        if (tst == 7)
-            sexpectedhost = cexpectedhost = "altgoodhost";
-
-        if (!TEST_str_eq(SSL_get_servername(clientssl,
-                                            TLSEXT_NAMETYPE_host_name),
-                         "altgoodhost"))
-            goto end;
-    } else if (tst == 4 || tst == 9) {
-        /*
-         * A TLSv1.3 session does not associate a session with a servername,
-         * but a TLSv1.2 session does.
-         */
-        if (tst == 9)
-            sexpectedhost = cexpectedhost = NULL;
-
-        if (!TEST_str_eq(SSL_get_servername(clientssl,
-                                            TLSEXT_NAMETYPE_host_name),
-                         cexpectedhost))
-            goto end;
-    } else {
-        if (!TEST_true(SSL_set_tlsext_host_name(clientssl, "goodhost")))
-            goto end;
-        /*
-         * In a TLSv1.2 resumption where the hostname was not acknowledged
-         * we expect the hostname on the server to be empty. On the client we
-         * return what was requested in this case.
-         *
-         * Similarly if the client didn't set a hostname on an original TLSv1.2
-         * session but is now, the server hostname will be empty, but the client
-         * is as we set it.
-         */
-        if (tst == 1 || tst == 3)
-            sexpectedhost = NULL;
-
-        if (!TEST_str_eq(SSL_get_servername(clientssl,
-                                            TLSEXT_NAMETYPE_host_name),
-                         "goodhost"))
-            goto end;
     }
+    SSL_CTX_set_mode(sctx, SSL_MODE_ASYNC);
+    SSL_CTX_set_mode(cctx, SSL_MODE_ASYNC);
 
-    if (!TEST_true(create_ssl_connection(serverssl, clientssl, SSL_ERROR_NONE)))
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL)))
+        goto end;
+# if defined(OPENSSL_THREADS) && !defined(OPENSSL_SYS_WINDOWS)
+    /*
+     * The only operations left for the workers are the KEM ones, so each
+     * side pauses exactly once: the server to encapsulate and the client to
+     * decapsulate.
+     */
+    if (!TEST_int_le(SSL_connect(clientssl), 0)
+            || !TEST_int_eq(SSL_get_error(clientssl, -1), SSL_ERROR_WANT_READ)
+            || !TEST_int_le(SSL_accept(serverssl), 0)
+            || !oqs_wait_for_workers(serverssl)
+            || !TEST_int_le(SSL_accept(serverssl), 0)
+            || !TEST_int_eq(SSL_get_error(serverssl, -1), SSL_ERROR_WANT_READ)
+            || !TEST_int_le(SSL_connect(clientssl), 0)
+            || !oqs_wait_for_workers(clientssl))
+        goto end;
+# endif
+    if (!TEST_true(create_ssl_connection(serverssl, clientssl,
+                                         SSL_ERROR_NONE))
+            || !TEST_int_eq(serverssl->s3->group_id, 0x023A)
+            || !TEST_int_eq(clientssl->s3->group_id, 0x023A))
         goto end;
+#endif
 
-    if (!TEST_true(SSL_session_reused(clientssl))
-            || !TEST_true(SSL_session_reused(serverssl))
-            || !TEST_str_eq(SSL_get_servername(clientssl,
-                                               TLSEXT_NAMETYPE_host_name),
-                            cexpectedhost)
-            || !TEST_str_eq(SSL_get_servername(serverssl,
-                                               TLSEXT_NAMETYPE_host_name),
-                            sexpectedhost))
+    if (!TEST_true(SSL_CTX_set_oqs_kem_workers(sctx, 0))
+            || !TEST_size_t_eq(SSL_CTX_get_oqs_kem_workers(sctx), 0))
         goto end;
 
     testresult = 1;
 
  end:
-    SSL_SESSION_free(sess);
     SSL_free(serverssl);
     SSL_free(clientssl);
     SSL_CTX_free(sctx);
     SSL_CTX_free(cctx);
+    OPENSSL_free(ecdsacert);
+    OPENSSL_free(ecdsakey);
 
     return testresult;
 }
 
-#ifndef OPENSSL_NO_TLS1_2
-static int test_ssl_dup(void)
+#define OQS_POOL_HANDSHAKES 3
+
+static unsigned char *oqs_key_shares[OQS_POOL_HANDSHAKES];
+static size_t oqs_key_shares_len[OQS_POOL_HANDSHAKES];
+static int oqs_key_shares_num;
+
+/* Keeps a copy of the key_share extension of each ClientHello */
+static int oqs_key_share_cb(SSL *s, int *al, void *arg)
+{
+    const unsigned char *ext;
+    size_t len;
+
+    if (oqs_key_shares_num < OQS_POOL_HANDSHAKES
+            && SSL_client_hello_get0_ext(s, TLSEXT_TYPE_key_share, &ext, &len)
+            && (oqs_key_shares[oqs_key_shares_num]
+                = OPENSSL_memdup(ext, len)) != NULL)
+        oqs_key_shares_len[oqs_key_shares_num++] = len;
+    return SSL_CLIENT_HELLO_SUCCESS;
+}
+
+/*
+ * Test that client key shares are built from pooled keypairs once the pool
+ * has been filled, that the pool is refilled after a keypair has been used,
+ * and that no keypair is used twice.
+ */
+static int test_oqs_keypair_pool(void)
 {
     SSL_CTX *cctx = NULL, *sctx = NULL;
-    SSL *clientssl = NULL, *serverssl = NULL, *client2ssl = NULL;
-    int testresult = 0;
-    BIO *rbio = NULL, *wbio = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int testresult = 0, i, j;
 
-    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
-                                       TLS_client_method(),
-                                       0,
-                                       0,
+    oqs_key_shares_num = 0;
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(), TLS_client_method(),
+                                       TLS1_VERSION, TLS_MAX_VERSION,
                                        &sctx, &cctx, cert, privkey)))
         goto end;
 
-    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
-                                             NULL, NULL)))
+    if (!TEST_size_t_eq(SSL_CTX_get_oqs_keypair_pool_size(cctx), 0))
         goto end;
-
-    if (!TEST_true(SSL_set_min_proto_version(clientssl, TLS1_2_VERSION))
-            || !TEST_true(SSL_set_max_proto_version(clientssl, TLS1_2_VERSION)))
+#if defined(OPENSSL_THREADS) && !defined(OPENSSL_SYS_WINDOWS)
+    if (!TEST_true(SSL_CTX_set_oqs_keypair_pool_size(cctx, 4))
+            || !TEST_size_t_eq(SSL_CTX_get_oqs_keypair_pool_size(cctx), 4)
+            || !TEST_true(SSL_CTX_set_oqs_keypair_pool_size(cctx, 2))
+            || !TEST_size_t_eq(SSL_CTX_get_oqs_keypair_pool_size(cctx), 2)
+            || !TEST_size_t_eq(SSL_CTX_get_oqs_keypair_pool_count(cctx), 0)
+            || !TEST_ulong_eq((unsigned long)
+                              SSL_CTX_get_oqs_keypair_pool_hits(cctx), 0))
         goto end;
-
-    client2ssl = SSL_dup(clientssl);
-    rbio = SSL_get_rbio(clientssl);
-    if (!TEST_ptr(rbio)
-            || !TEST_true(BIO_up_ref(rbio)))
+#else
+    if (!TEST_false(SSL_CTX_set_oqs_keypair_pool_size(cctx, 4)))
         goto end;
-    SSL_set0_rbio(client2ssl, rbio);
-    rbio = NULL;
+#endif
 
-    wbio = SSL_get_wbio(clientssl);
-    if (!TEST_ptr(wbio) || !TEST_true(BIO_up_ref(wbio)))
+#ifndef OPENSSL_NO_TLS1_3
+    if (!TEST_true(SSL_CTX_set1_groups_list(sctx, "kyber512"))
+            || !TEST_true(SSL_CTX_set1_groups_list(cctx, "kyber512")))
         goto end;
-    SSL_set0_wbio(client2ssl, wbio);
-    rbio = NULL;
-
-    if (!TEST_ptr(client2ssl)
-               /* Handshake not started so pointers should be different */
-            || !TEST_ptr_ne(clientssl, client2ssl))
+    if (!OQS_KEM_alg_is_enabled(OQS_ALG_NAME(NID_kyber512))) {
+        TEST_info("Skipping handshakes: kyber512 is disabled in liboqs");
+        testresult = 1;
         goto end;
+    }
+    SSL_CTX_set_client_hello_cb(sctx, oqs_key_share_cb, NULL);
 
-    if (!TEST_int_eq(SSL_get_min_proto_version(client2ssl), TLS1_2_VERSION)
-            || !TEST_int_eq(SSL_get_max_proto_version(client2ssl), TLS1_2_VERSION))
-        goto end;
+    for (i = 0; i < OQS_POOL_HANDSHAKES; i++) {
+        if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                          NULL, NULL))
+                || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                    SSL_ERROR_NONE))
+                || !TEST_int_eq(clientssl->s3->group_id, 0x023A))
+            goto end;
+        SSL_shutdown(clientssl);
+        SSL_shutdown(serverssl);
+        SSL_free(serverssl);
+        SSL_free(clientssl);
+        serverssl = clientssl = NULL;
 
-    if (!TEST_true(create_ssl_connection(serverssl, client2ssl, SSL_ERROR_NONE)))
+# if defined(OPENSSL_THREADS) && !defined(OPENSSL_SYS_WINDOWS)
+        /*
+         * The first handshake starts the pool for kyber512 and generates its
+         * own keypair; the later ones each take one from the full pool,
+         * which is then topped up again.
+         */
+        if (!TEST_ulong_eq((unsigned long)
+                           SSL_CTX_get_oqs_keypair_pool_hits(cctx), i)
+                || !oqs_wait_for_keypairs(cctx, 2))
+            goto end;
+# endif
+    }
+
+    if (!TEST_int_eq(oqs_key_shares_num, OQS_POOL_HANDSHAKES))
         goto end;
+    for (i = 0; i < OQS_POOL_HANDSHAKES; i++)
+        for (j = i + 1; j < OQS_POOL_HANDSHAKES; j++)
+            if (!TEST_mem_ne(oqs_key_shares[i], oqs_key_shares_len[i],
+                             oqs_key_shares[j], oqs_key_shares_len[j]))
+                goto end;
+#endif
 
-    SSL_free(clientssl);
-    clientssl = SSL_dup(client2ssl);
-    if (!TEST_ptr(clientssl)
-               /* Handshake has finished so pointers should be the same */
-            || !TEST_ptr_eq(clientssl, client2ssl))
+    if (!TEST_true(SSL_CTX_set_oqs_keypair_pool_size(cctx, 0))
+            || !TEST_size_t_eq(SSL_CTX_get_oqs_keypair_pool_size(cctx), 0)
+            || !TEST_size_t_eq(SSL_CTX_get_oqs_keypair_pool_count(cctx), 0))
         goto end;
 
     testresult = 1;
@@ -6884,409 +10904,650 @@ static int test_ssl_dup(void)
  end:
     SSL_free(serverssl);
     SSL_free(clientssl);
-    SSL_free(client2ssl);
     SSL_CTX_free(sctx);
     SSL_CTX_free(cctx);
+    for (i = 0; i < oqs_key_shares_num; i++)
+        OPENSSL_free(oqs_key_shares[i]);
+    oqs_key_shares_num = 0;
 
     return testresult;
 }
-#endif
 
-#ifndef OPENSSL_NO_TLS1_3
+#if !defined(OPENSSL_NO_TLS1_3) && !defined(OPENSSL_NO_EC)
+static const struct {
+    const char *name;
+    uint16_t group_id;
+    int classical_group_id;
+} ecx_hybrid_groups[] = {
+    { "x25519_kyber512", 0x2F39, 29 },
+    { "x448_kyber768", 0x2F90, 30 },
+};
+
 /*
- * Test that setting an SNI callback works with TLSv1.3. Specifically we check
- * that it works even without a certificate configured for the original
- * SSL_CTX
+ * Test that the hybrids of an OQS KEM with X25519 or X448 can be configured
+ * and, when liboqs provides the KEM, negotiated.
  */
-static int test_sni_tls13(void)
+static int test_oqs_ecx_hybrid_groups(int idx)
 {
-    SSL_CTX *cctx = NULL, *sctx = NULL, *sctx2 = NULL;
+    SSL_CTX *cctx = NULL, *sctx = NULL;
     SSL *clientssl = NULL, *serverssl = NULL;
+    const char *name = ecx_hybrid_groups[idx].name;
+    uint16_t group_id = ecx_hybrid_groups[idx].group_id;
     int testresult = 0;
 
-    /* Reset callback counter */
-    snicb = 0;
-
-    /* Create an initial SSL_CTX with no certificate configured */
-    sctx = SSL_CTX_new(TLS_server_method());
-    if (!TEST_ptr(sctx))
+    if (!TEST_int_eq(OQS_KEM_CLASSICAL_CURVEID(group_id),
+                     ecx_hybrid_groups[idx].classical_group_id)
+            || !TEST_int_eq(OQS_HYBRID_KEM_NID(group_id), OBJ_sn2nid(name)))
         goto end;
-    /* Require TLSv1.3 as a minimum */
+
     if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(), TLS_client_method(),
-                                       TLS1_3_VERSION, 0, &sctx2, &cctx, cert,
-                                       privkey)))
+                                       TLS1_3_VERSION, TLS_MAX_VERSION,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_true(SSL_CTX_set1_groups_list(sctx, name))
+            || !TEST_true(SSL_CTX_set1_groups_list(cctx, name)))
         goto end;
 
-    /* Set up SNI */
-    if (!TEST_true(SSL_CTX_set_tlsext_servername_callback(sctx, sni_cb))
-            || !TEST_true(SSL_CTX_set_tlsext_servername_arg(sctx, sctx2)))
+    if (!OQS_KEM_alg_is_enabled(OQS_ALG_NAME(OQS_KEM_NID(group_id)))) {
+        TEST_info("Skipping handshake: %s is disabled in liboqs", name);
+        testresult = 1;
         goto end;
+    }
 
-    /*
-     * Connection should still succeed because the final SSL_CTX has the right
-     * certificates configured.
-     */
-    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl,
-                                      &clientssl, NULL, NULL))
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
             || !TEST_true(create_ssl_connection(serverssl, clientssl,
-                                                SSL_ERROR_NONE)))
-        goto end;
-
-    /* We should have had the SNI callback called exactly once */
-    if (!TEST_int_eq(snicb, 1))
+                                                SSL_ERROR_NONE))
+            || !TEST_int_eq(serverssl->s3->group_id, group_id)
+            || !TEST_int_eq(clientssl->s3->group_id, group_id))
         goto end;
 
     testresult = 1;
 
-end:
+ end:
     SSL_free(serverssl);
     SSL_free(clientssl);
-    SSL_CTX_free(sctx2);
     SSL_CTX_free(sctx);
     SSL_CTX_free(cctx);
+
     return testresult;
 }
+#endif
+
+#if !defined(OPENSSL_NO_TLS1_3) && !defined(OPENSSL_NO_EC)
+#define ECDHE_REUSE_HANDSHAKES 5
 
 /*
- * Test that the lifetime hint of a TLSv1.3 ticket is no more than 1 week
- * 0 = TLSv1.2
- * 1 = TLSv1.3
+ * Test that a server with ECDHE reuse on answers key shares with the same key
+ * until it has been used the maximum number of times, and that turning
+ * reuse off again gives every handshake a fresh key.
  */
-static int test_ticket_lifetime(int idx)
+static int test_ecdhe_reuse(int idx)
 {
     SSL_CTX *cctx = NULL, *sctx = NULL;
     SSL *clientssl = NULL, *serverssl = NULL;
-    int testresult = 0;
-    int version = TLS1_3_VERSION;
-
-#define ONE_WEEK_SEC (7 * 24 * 60 * 60)
-#define TWO_WEEK_SEC (2 * ONE_WEEK_SEC)
-
-    if (idx == 0) {
-#ifdef OPENSSL_NO_TLS1_2
-        TEST_info("Skipping: TLS 1.2 is disabled.");
-        return 1;
-#else
-        version = TLS1_2_VERSION;
-#endif
-    }
-
-    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(),
-                                       TLS_client_method(), version, version,
-                                       &sctx, &cctx, cert, privkey)))
-        goto end;
+    EVP_PKEY *keys[ECDHE_REUSE_HANDSHAKES] = { NULL };
+    static const char *groups[] = { "X25519", "P-256" };
+    unsigned int max_uses, max_seconds;
+    int testresult = 0, i;
 
-    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl,
-                                      &clientssl, NULL, NULL)))
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(), TLS_client_method(),
+                                       TLS1_3_VERSION, 0,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_true(SSL_CTX_set1_groups_list(cctx, groups[idx])))
         goto end;
 
-    /*
-     * Set the timeout to be more than 1 week
-     * make sure the returned value is the default
-     */
-    if (!TEST_long_eq(SSL_CTX_set_timeout(sctx, TWO_WEEK_SEC),
-                      SSL_get_default_timeout(serverssl)))
+    SSL_CTX_get_ecdhe_reuse(sctx, &max_uses, &max_seconds);
+    if (!TEST_uint_eq(max_uses, 0)
+            || !TEST_uint_eq(max_seconds, 0)
+            || !TEST_false(SSL_CTX_set_ecdhe_reuse(sctx, 3, 0))
+            || !TEST_false(SSL_CTX_set_ecdhe_reuse(sctx, 3,
+                                                   SSL_ECDHE_REUSE_MAX_SECONDS
+                                                   + 1))
+            || !TEST_true(SSL_CTX_set_ecdhe_reuse(sctx, 3, 60)))
         goto end;
-
-    if (!TEST_true(create_ssl_connection(serverssl, clientssl, SSL_ERROR_NONE)))
+    SSL_CTX_get_ecdhe_reuse(sctx, &max_uses, &max_seconds);
+    if (!TEST_uint_eq(max_uses, 3)
+            || !TEST_uint_eq(max_seconds, 60))
         goto end;
 
-    if (idx == 0) {
-        /* TLSv1.2 uses the set value */
-        if (!TEST_ulong_eq(SSL_SESSION_get_ticket_lifetime_hint(SSL_get_session(clientssl)), TWO_WEEK_SEC))
+    for (i = 0; i < ECDHE_REUSE_HANDSHAKES; i++) {
+        /* The last handshake runs with reuse turned off */
+        if (i == ECDHE_REUSE_HANDSHAKES - 1
+                && !TEST_true(SSL_CTX_set_ecdhe_reuse(sctx, 0, 0)))
             goto end;
-    } else {
-        /* TLSv1.3 uses the limited value */
-        if (!TEST_ulong_le(SSL_SESSION_get_ticket_lifetime_hint(SSL_get_session(clientssl)), ONE_WEEK_SEC))
+        if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                          NULL, NULL))
+                || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                    SSL_ERROR_NONE))
+                || !TEST_ptr(keys[i] = clientssl->s3->peer_tmp)
+                || !TEST_true(EVP_PKEY_up_ref(keys[i])))
             goto end;
+        SSL_free(serverssl);
+        SSL_free(clientssl);
+        serverssl = clientssl = NULL;
     }
+
+    /* Reuse ends once a key has been used three times, or is turned off */
+    if (!TEST_int_eq(EVP_PKEY_cmp(keys[0], keys[1]), 1)
+            || !TEST_int_eq(EVP_PKEY_cmp(keys[0], keys[2]), 1)
+            || !TEST_int_ne(EVP_PKEY_cmp(keys[0], keys[3]), 1)
+            || !TEST_int_ne(EVP_PKEY_cmp(keys[3], keys[4]), 1))
+        goto end;
+
     testresult = 1;
 
-end:
+ end:
+    for (i = 0; i < ECDHE_REUSE_HANDSHAKES; i++)
+        EVP_PKEY_free(keys[i]);
     SSL_free(serverssl);
     SSL_free(clientssl);
     SSL_CTX_free(sctx);
     SSL_CTX_free(cctx);
+
     return testresult;
 }
-#endif
+
 /*
- * Test that setting an ALPN does not violate RFC
+ * Test that calibrating the groups keeps those with at least the requested
+ * security, cheapest first, and that the client then sends its key share for
+ * the cheapest one.
  */
-static int test_set_alpn(void)
+static int test_calibrate_groups(void)
 {
-    SSL_CTX *ctx = NULL;
-    SSL *ssl = NULL;
-    int testresult = 0;
-
-    unsigned char bad0[] = { 0x00, 'b', 'a', 'd' };
-    unsigned char good[] = { 0x04, 'g', 'o', 'o', 'd' };
-    unsigned char bad1[] = { 0x01, 'b', 'a', 'd' };
-    unsigned char bad2[] = { 0x03, 'b', 'a', 'd', 0x00};
-    unsigned char bad3[] = { 0x03, 'b', 'a', 'd', 0x01, 'b', 'a', 'd'};
-    unsigned char bad4[] = { 0x03, 'b', 'a', 'd', 0x06, 'b', 'a', 'd'};
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int groups[64], ngroups, nid, i, testresult = 0;
+    long cost, prev_cost = 0;
+    EVP_PKEY *tmp;
 
-    /* Create an initial SSL_CTX with no certificate configured */
-    ctx = SSL_CTX_new(TLS_server_method());
-    if (!TEST_ptr(ctx))
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(), TLS_client_method(),
+                                       TLS1_3_VERSION, 0,
+                                       &sctx, &cctx, cert, privkey)))
         goto end;
 
-    /* the set_alpn functions return 0 (false) on success, non-zero (true) on failure */
-    if (!TEST_false(SSL_CTX_set_alpn_protos(ctx, NULL, 2)))
-        goto end;
-    if (!TEST_false(SSL_CTX_set_alpn_protos(ctx, good, 0)))
-        goto end;
-    if (!TEST_false(SSL_CTX_set_alpn_protos(ctx, good, sizeof(good))))
-        goto end;
-    if (!TEST_true(SSL_CTX_set_alpn_protos(ctx, good, 1)))
-        goto end;
-    if (!TEST_true(SSL_CTX_set_alpn_protos(ctx, bad0, sizeof(bad0))))
-        goto end;
-    if (!TEST_true(SSL_CTX_set_alpn_protos(ctx, bad1, sizeof(bad1))))
-        goto end;
-    if (!TEST_true(SSL_CTX_set_alpn_protos(ctx, bad2, sizeof(bad2))))
-        goto end;
-    if (!TEST_true(SSL_CTX_set_alpn_protos(ctx, bad3, sizeof(bad3))))
-        goto end;
-    if (!TEST_true(SSL_CTX_set_alpn_protos(ctx, bad4, sizeof(bad4))))
+    ngroups = SSL_CTX_get1_groups(cctx, NULL);
+    if (!TEST_int_gt(ngroups, 0)
+            || !TEST_long_eq(SSL_CTX_get_group_cost(cctx, NID_X25519), 0))
         goto end;
 
-    ssl = SSL_new(ctx);
-    if (!TEST_ptr(ssl))
+    /* No group is that strong, which leaves the configured ones alone */
+    if (!TEST_false(SSL_CTX_calibrate_groups(cctx, 1000))
+            || !TEST_int_eq(SSL_CTX_get1_groups(cctx, NULL), ngroups))
         goto end;
 
-    if (!TEST_false(SSL_set_alpn_protos(ssl, NULL, 2)))
-        goto end;
-    if (!TEST_false(SSL_set_alpn_protos(ssl, good, 0)))
-        goto end;
-    if (!TEST_false(SSL_set_alpn_protos(ssl, good, sizeof(good))))
+    if (!TEST_true(SSL_CTX_calibrate_groups(cctx, 192)))
         goto end;
-    if (!TEST_true(SSL_set_alpn_protos(ssl, good, 1)))
-        goto end;
-    if (!TEST_true(SSL_set_alpn_protos(ssl, bad0, sizeof(bad0))))
-        goto end;
-    if (!TEST_true(SSL_set_alpn_protos(ssl, bad1, sizeof(bad1))))
-        goto end;
-    if (!TEST_true(SSL_set_alpn_protos(ssl, bad2, sizeof(bad2))))
+    ngroups = SSL_CTX_get1_groups(cctx, NULL);
+    if (!TEST_int_gt(ngroups, 0)
+            || !TEST_int_le(ngroups, (int)OSSL_NELEM(groups)))
         goto end;
-    if (!TEST_true(SSL_set_alpn_protos(ssl, bad3, sizeof(bad3))))
+    SSL_CTX_get1_groups(cctx, groups);
+    for (i = 0; i < ngroups; i++) {
+        cost = SSL_CTX_get_group_cost(cctx, groups[i]);
+        if (!TEST_int_ne(groups[i], NID_X25519)
+                || !TEST_int_ne(groups[i], NID_X9_62_prime256v1)
+                || !TEST_long_gt(cost, 0)
+                || !TEST_long_ge(cost, prev_cost))
+            goto end;
+        prev_cost = cost;
+    }
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_ptr(tmp = clientssl->s3->peer_tmp))
         goto end;
-    if (!TEST_true(SSL_set_alpn_protos(ssl, bad4, sizeof(bad4))))
+    if ((nid = EVP_PKEY_id(tmp)) == EVP_PKEY_EC) {
+        const EC_GROUP *group = EC_KEY_get0_group(EVP_PKEY_get0_EC_KEY(tmp));
+
+        nid = EC_GROUP_get_curve_name(group);
+    }
+    if (!TEST_int_eq(nid, groups[0]))
         goto end;
 
     testresult = 1;
 
-end:
-    SSL_free(ssl);
-    SSL_CTX_free(ctx);
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+
     return testresult;
 }
+#endif
 
-/*
- * Test SSL_CTX_set1_verify/chain_cert_store and SSL_CTX_get_verify/chain_cert_store.
- */
-static int test_set_verify_cert_store_ssl_ctx(void)
-{
-   SSL_CTX *ctx = NULL;
-   int testresult = 0;
-   X509_STORE *store = NULL, *new_store = NULL,
-              *cstore = NULL, *new_cstore = NULL;
-
-   /* Create an initial SSL_CTX. */
-   ctx = SSL_CTX_new(TLS_server_method());
-   if (!TEST_ptr(ctx))
-       goto end;
-
-   /* Retrieve verify store pointer. */
-   if (!TEST_true(SSL_CTX_get0_verify_cert_store(ctx, &store)))
-       goto end;
+#if !defined(OPENSSL_NO_METRICS) && !defined(OPENSSL_NO_TLS1_3) \
+    && !defined(OPENSSL_NO_EC)
+typedef struct {
+    const char *name;
+    const char *labels;
+    int64_t value;
+} METRIC_LOOKUP;
 
-   /* Retrieve chain store pointer. */
-   if (!TEST_true(SSL_CTX_get0_chain_cert_store(ctx, &cstore)))
-       goto end;
+static int find_metric_cb(const char *name, const char *labels, int type,
+                          const char *help, int64_t value, void *arg)
+{
+    METRIC_LOOKUP *m = arg;
 
-   /* We haven't set any yet, so this should be NULL. */
-   if (!TEST_ptr_null(store) || !TEST_ptr_null(cstore))
-       goto end;
+    if (strcmp(name, m->name) != 0
+            || (labels == NULL) != (m->labels == NULL)
+            || (labels != NULL && strcmp(labels, m->labels) != 0))
+        return 1;
+    m->value = value;
+    return 0;
+}
 
-   /* Create stores. We use separate stores so pointers are different. */
-   new_store = X509_STORE_new();
-   if (!TEST_ptr(new_store))
-       goto end;
+/* The value of a metric, 0 if it isn't registered yet */
+static int64_t get_metric(const char *name, const char *labels)
+{
+    METRIC_LOOKUP m;
 
-   new_cstore = X509_STORE_new();
-   if (!TEST_ptr(new_cstore))
-       goto end;
+    m.name = name;
+    m.labels = labels;
+    m.value = 0;
+    OPENSSL_metrics_do_all(find_metric_cb, &m);
+    return m.value;
+}
 
-   /* Set stores. */
-   if (!TEST_true(SSL_CTX_set1_verify_cert_store(ctx, new_store)))
-       goto end;
+static int test_handshake_metrics(void)
+{
+    static const char *by_group = "openssl_ssl_handshakes_by_group_total";
+    static const char *by_sigalg = "openssl_ssl_handshakes_by_sigalg_total";
+    static const char *x25519 = "group=\"X25519\"";
+    static const char *pss = "sigalg=\"rsa_pss_rsae_sha256\"";
+    static const char *hits = "openssl_ssl_session_cache_hits_total";
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    SSL_SESSION *sess = NULL;
+    int64_t groups_before = get_metric(by_group, x25519);
+    int64_t sigalgs_before = get_metric(by_sigalg, pss);
+    int64_t hits_before = get_metric(hits, NULL);
+    int testresult = 0;
 
-   if (!TEST_true(SSL_CTX_set1_chain_cert_store(ctx, new_cstore)))
-       goto end;
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(), TLS_client_method(),
+                                       TLS1_3_VERSION, 0,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_true(SSL_CTX_set1_groups_list(cctx, "X25519"))
+            || !TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                             NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_ptr(sess = SSL_get1_session(clientssl)))
+        goto end;
+    shutdown_ssl_connection(serverssl, clientssl);
+    serverssl = clientssl = NULL;
 
-   /* Should be able to retrieve the same pointer. */
-   if (!TEST_true(SSL_CTX_get0_verify_cert_store(ctx, &store)))
-       goto end;
+    /* Both ends count the full handshake, the resumption has no signature */
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(SSL_set_session(clientssl, sess))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_true(SSL_session_reused(clientssl))
+            || !TEST_true(get_metric(by_group, x25519) == groups_before + 4)
+            || !TEST_true(get_metric(by_sigalg, pss) == sigalgs_before + 2)
+            || !TEST_true(get_metric(hits, NULL) > hits_before))
+        goto end;
 
-   if (!TEST_true(SSL_CTX_get0_chain_cert_store(ctx, &cstore)))
-       goto end;
+    testresult = 1;
 
-   if (!TEST_ptr_eq(store, new_store) || !TEST_ptr_eq(cstore, new_cstore))
-       goto end;
+ end:
+    SSL_SESSION_free(sess);
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
 
-   /* Should be able to unset again. */
-   if (!TEST_true(SSL_CTX_set1_verify_cert_store(ctx, NULL)))
-       goto end;
+    return testresult;
+}
+#endif
 
-   if (!TEST_true(SSL_CTX_set1_chain_cert_store(ctx, NULL)))
-       goto end;
+#ifndef OPENSSL_NO_TLS1_3
+/*
+ * Test that a client with a key share cache sends the group a server asked
+ * for in a HelloRetryRequest straight away on the next connection to that
+ * host, and only to that host.
+ */
+static int test_key_share_cache(void)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    static const char *hosts[] = {
+        "server.example", "server.example", "other.example"
+    };
+    static const int expect_hrr[] = { 1, 0, 1 };
+    int testresult = 0;
+    size_t i;
 
-   /* Should now be NULL. */
-   if (!TEST_true(SSL_CTX_get0_verify_cert_store(ctx, &store)))
-       goto end;
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(), TLS_client_method(),
+                                       TLS1_3_VERSION, 0,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_true(SSL_CTX_set1_groups_list(cctx, "X25519:P-256"))
+            || !TEST_true(SSL_CTX_set1_groups_list(sctx, "P-256"))
+            || !TEST_size_t_eq(SSL_CTX_get_key_share_cache_size(cctx), 0)
+            || !TEST_true(SSL_CTX_set_key_share_cache_size(cctx, 16))
+            || !TEST_size_t_eq(SSL_CTX_get_key_share_cache_size(cctx), 16))
+        goto end;
 
-   if (!TEST_true(SSL_CTX_get0_chain_cert_store(ctx, &cstore)))
-       goto end;
+    for (i = 0; i < OSSL_NELEM(hosts); i++) {
+        if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                          NULL, NULL))
+                || !TEST_true(SSL_set_tlsext_host_name(clientssl, hosts[i]))
+                || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                    SSL_ERROR_NONE))
+                || !TEST_int_eq(serverssl->hello_retry_request != SSL_HRR_NONE,
+                                expect_hrr[i]))
+            goto end;
+        shutdown_ssl_connection(serverssl, clientssl);
+        serverssl = clientssl = NULL;
+    }
 
-   if (!TEST_ptr_null(store) || !TEST_ptr_null(cstore))
-       goto end;
+    testresult = 1;
 
-   testresult = 1;
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
 
-end:
-   X509_STORE_free(new_store);
-   X509_STORE_free(new_cstore);
-   SSL_CTX_free(ctx);
-   return testresult;
+    return testresult;
 }
+#endif
+
+#if !defined(OPENSSL_NO_KTLS) && !defined(OPENSSL_NO_SOCK)
+# define KTLS_MAX_LOOPS 100000
 
 /*
- * Test SSL_set1_verify/chain_cert_store and SSL_get_verify/chain_cert_store.
+ * Send |len| bytes from |buf| from |sender| and read them back on |receiver|,
+ * both of which run on non-blocking sockets.
  */
-static int test_set_verify_cert_store_ssl(void)
+static int ktls_chk_write_read(SSL *sender, SSL *receiver,
+                               const unsigned char *buf, size_t len)
 {
-   SSL_CTX *ctx = NULL;
-   SSL *ssl = NULL;
-   int testresult = 0;
-   X509_STORE *store = NULL, *new_store = NULL,
-              *cstore = NULL, *new_cstore = NULL;
-
-   /* Create an initial SSL_CTX. */
-   ctx = SSL_CTX_new(TLS_server_method());
-   if (!TEST_ptr(ctx))
-       goto end;
-
-   /* Create an SSL object. */
-   ssl = SSL_new(ctx);
-   if (!TEST_ptr(ssl))
-       goto end;
+    unsigned char rbuf[1024];
+    size_t written, readbytes, total = 0;
+    int i;
 
-   /* Retrieve verify store pointer. */
-   if (!TEST_true(SSL_get0_verify_cert_store(ssl, &store)))
-       goto end;
+    if (!TEST_size_t_le(len, sizeof(rbuf))
+            || !TEST_true(SSL_write_ex(sender, buf, len, &written))
+            || !TEST_size_t_eq(written, len))
+        return 0;
 
-   /* Retrieve chain store pointer. */
-   if (!TEST_true(SSL_get0_chain_cert_store(ssl, &cstore)))
-       goto end;
+    for (i = 0; total < len && i < KTLS_MAX_LOOPS; i++) {
+        if (SSL_read_ex(receiver, rbuf + total, sizeof(rbuf) - total,
+                        &readbytes))
+            total += readbytes;
+        else if (!TEST_int_eq(SSL_get_error(receiver, 0), SSL_ERROR_WANT_READ))
+            return 0;
+    }
 
-   /* We haven't set any yet, so this should be NULL. */
-   if (!TEST_ptr_null(store) || !TEST_ptr_null(cstore))
-       goto end;
+    return TEST_mem_eq(rbuf, total, buf, len);
+}
 
-   /* Create stores. We use separate stores so pointers are different. */
-   new_store = X509_STORE_new();
-   if (!TEST_ptr(new_store))
-       goto end;
+/*
+ * Test kTLS offload of the send direction, or the fallback to user space
+ * encryption if the kernel has no TLS support:
+ * Test 0: TLSv1.2, AES128-GCM
+ * Test 1: TLSv1.2, AES256-GCM
+ * Test 2: TLSv1.2, ChaCha20-Poly1305
+ * Test 3: TLSv1.3, TLS_AES_128_GCM_SHA256
+ * Test 4: TLSv1.3, TLS_AES_256_GCM_SHA384
+ * Test 5: TLSv1.3, TLS_CHACHA20_POLY1305_SHA256
+ */
+static int test_ktls(int tst)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    static const char *ciphers[] = {
+        "ECDHE-RSA-AES128-GCM-SHA256",
+        "ECDHE-RSA-AES256-GCM-SHA384",
+        "ECDHE-RSA-CHACHA20-POLY1305",
+        "TLS_AES_128_GCM_SHA256",
+        "TLS_AES_256_GCM_SHA384",
+        "TLS_CHACHA20_POLY1305_SHA256"
+    };
+    static const unsigned char msg[] = "Hello over kTLS";
+    int version = tst < 3 ? TLS1_2_VERSION : TLS1_3_VERSION;
+    int cfd = -1, sfd = -1, ktls, testresult = 0;
+    FILE *f = NULL;
+    size_t i;
 
-   new_cstore = X509_STORE_new();
-   if (!TEST_ptr(new_cstore))
-       goto end;
+#ifdef OPENSSL_NO_TLS1_2
+    if (version == TLS1_2_VERSION)
+        return 1;
+#endif
+#ifdef OPENSSL_NO_TLS1_3
+    if (version == TLS1_3_VERSION)
+        return 1;
+#endif
+#ifdef OPENSSL_NO_CHACHA
+    if (tst == 2 || tst == 5)
+        return 1;
+#endif
 
-   /* Set stores. */
-   if (!TEST_true(SSL_set1_verify_cert_store(ssl, new_store)))
-       goto end;
+    if (!TEST_true(create_test_sockets(&cfd, &sfd)))
+        goto end;
 
-   if (!TEST_true(SSL_set1_chain_cert_store(ssl, new_cstore)))
-       goto end;
+    if (!TEST_true(create_ssl_ctx_pair(TLS_server_method(), TLS_client_method(),
+                                       version, version,
+                                       &sctx, &cctx, cert, privkey)))
+        goto end;
 
-   /* Should be able to retrieve the same pointer. */
-   if (!TEST_true(SSL_get0_verify_cert_store(ssl, &store)))
-       goto end;
+    if (version == TLS1_3_VERSION) {
+        if (!TEST_true(SSL_CTX_set_ciphersuites(cctx, ciphers[tst]))
+                || !TEST_true(SSL_CTX_set_ciphersuites(sctx, ciphers[tst])))
+            goto end;
+    } else {
+        if (!TEST_true(SSL_CTX_set_cipher_list(cctx, ciphers[tst]))
+                || !TEST_true(SSL_CTX_set_cipher_list(sctx, ciphers[tst])))
+            goto end;
+    }
+    SSL_CTX_set_options(cctx, SSL_OP_ENABLE_KTLS);
+    SSL_CTX_set_options(sctx, SSL_OP_ENABLE_KTLS);
 
-   if (!TEST_true(SSL_get0_chain_cert_store(ssl, &cstore)))
-       goto end;
+    if (!TEST_true(create_ssl_objects2(sctx, cctx, &serverssl, &clientssl,
+                                       sfd, cfd))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE)))
+        goto end;
 
-   if (!TEST_ptr_eq(store, new_store) || !TEST_ptr_eq(cstore, new_cstore))
-       goto end;
+    /* The kernel either takes over on both sides or on neither */
+    ktls = BIO_get_ktls_send(SSL_get_wbio(clientssl));
+    if (!TEST_int_eq(BIO_get_ktls_send(SSL_get_wbio(serverssl)), ktls))
+        goto end;
+    if (!ktls)
+        TEST_info("kTLS not supported by the kernel, testing the fallback");
 
-   /* Should be able to unset again. */
-   if (!TEST_true(SSL_set1_verify_cert_store(ssl, NULL)))
-       goto end;
+    for (i = 0; i < 2; i++) {
+        if (!TEST_true(ktls_chk_write_read(clientssl, serverssl, msg,
+                                           sizeof(msg)))
+                || !TEST_true(ktls_chk_write_read(serverssl, clientssl, msg,
+                                                  sizeof(msg))))
+            goto end;
+    }
 
-   if (!TEST_true(SSL_set1_chain_cert_store(ssl, NULL)))
-       goto end;
+    if (!TEST_ptr(f = tmpfile())
+            || !TEST_size_t_eq(fwrite(msg, 1, sizeof(msg), f), sizeof(msg))
+            || !TEST_int_eq(fflush(f), 0))
+        goto end;
 
-   /* Should now be NULL. */
-   if (!TEST_true(SSL_get0_verify_cert_store(ssl, &store)))
-       goto end;
+    if (!ktls) {
+        if (!TEST_int_eq((int)SSL_sendfile(serverssl, fileno(f), 0,
+                                           sizeof(msg), 0), -1))
+            goto end;
+        ERR_clear_error();
+    } else {
+        unsigned char rbuf[sizeof(msg)];
+        size_t readbytes, total = 0;
 
-   if (!TEST_true(SSL_get0_chain_cert_store(ssl, &cstore)))
-       goto end;
+        if (!TEST_int_eq((int)SSL_sendfile(serverssl, fileno(f), 0,
+                                           sizeof(msg), 0), (int)sizeof(msg)))
+            goto end;
+        for (i = 0; total < sizeof(msg) && i < KTLS_MAX_LOOPS; i++) {
+            if (SSL_read_ex(clientssl, rbuf + total, sizeof(rbuf) - total,
+                            &readbytes))
+                total += readbytes;
+            else if (!TEST_int_eq(SSL_get_error(clientssl, 0),
+                                  SSL_ERROR_WANT_READ))
+                goto end;
+        }
+        if (!TEST_mem_eq(rbuf, total, msg, sizeof(msg)))
+            goto end;
+    }
 
-   if (!TEST_ptr_null(store) || !TEST_ptr_null(cstore))
-       goto end;
+    testresult = 1;
 
-   testresult = 1;
+ end:
+    if (f != NULL)
+        fclose(f);
+    if (serverssl != NULL)
+        SSL_shutdown(serverssl);
+    if (clientssl != NULL)
+        SSL_shutdown(clientssl);
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    if (cfd != -1)
+        close(cfd);
+    if (sfd != -1)
+        close(sfd);
 
-end:
-   X509_STORE_free(new_store);
-   X509_STORE_free(new_cstore);
-   SSL_free(ssl);
-   SSL_CTX_free(ctx);
-   return testresult;
+    return testresult;
 }
+#endif
 
-static int test_inherit_verify_param(void)
+#if defined(OPENSSL_SYS_LINUX) && !defined(OPENSSL_NO_SOCK)
+# include <poll.h>
+# define ZEROCOPY_MSG_LEN   (256 * 1024)
+# define ZEROCOPY_MAX_LOOPS 100000
+
+/*
+ * Test MSG_ZEROCOPY sends from the client: the records must arrive intact
+ * although the write buffers are handed to the kernel as they are.
+ * Test 0: TLSv1.2
+ * Test 1: TLSv1.3
+ */
+static int test_zerocopy(int tst)
 {
-    int testresult = 0;
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int version = tst == 0 ? TLS1_2_VERSION : TLS1_3_VERSION;
+    unsigned char *msg = NULL, *rbuf = NULL;
+    size_t written = 0, total = 0, n;
+    int cfd = -1, sfd = -1, i, testresult = 0;
+    uint32_t sent;
+    BIO *wbio;
 
-    SSL_CTX *ctx = NULL;
-    X509_VERIFY_PARAM *cp = NULL;
-    SSL *ssl = NULL;
-    X509_VERIFY_PARAM *sp = NULL;
-    int hostflags = X509_CHECK_FLAG_NEVER_CHECK_SUBJECT;
+#ifdef OPENSSL_NO_TLS1_2
+    if (version == TLS1_2_VERSION)
+        return 1;
+#endif
+#ifdef OPENSSL_NO_TLS1_3
+    if (version == TLS1_3_VERSION)
+        return 1;
+#endif
 
-    ctx = SSL_CTX_new(TLS_server_method());
-    if (!TEST_ptr(ctx))
+    if (!TEST_ptr(msg = OPENSSL_malloc(ZEROCOPY_MSG_LEN))
+            || !TEST_ptr(rbuf = OPENSSL_malloc(ZEROCOPY_MSG_LEN)))
         goto end;
+    for (n = 0; n < ZEROCOPY_MSG_LEN; n++)
+        msg[n] = (unsigned char)(n + n / 251);
 
-    cp = SSL_CTX_get0_param(ctx);
-    if (!TEST_ptr(cp))
+    if (!TEST_true(create_test_sockets(&cfd, &sfd))
+            || !TEST_true(create_ssl_ctx_pair(TLS_server_method(),
+                                              TLS_client_method(),
+                                              version, version,
+                                              &sctx, &cctx, cert, privkey))
+            || !TEST_true(create_ssl_objects2(sctx, cctx, &serverssl,
+                                              &clientssl, sfd, cfd))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE)))
         goto end;
-    if (!TEST_int_eq(X509_VERIFY_PARAM_get_hostflags(cp), 0))
+
+    wbio = SSL_get_wbio(clientssl);
+    if (!BIO_set_zerocopy(wbio, 4096)) {
+        TEST_info("MSG_ZEROCOPY not supported by the kernel");
+        testresult = 1;
         goto end;
+    }
 
-    X509_VERIFY_PARAM_set_hostflags(cp, hostflags);
+    for (i = 0; total < ZEROCOPY_MSG_LEN && i < ZEROCOPY_MAX_LOOPS; i++) {
+        int progress = 0;
 
-    ssl = SSL_new(ctx);
-    if (!TEST_ptr(ssl))
+        if (written < ZEROCOPY_MSG_LEN) {
+            if (SSL_write_ex(clientssl, msg + written,
+                             ZEROCOPY_MSG_LEN - written, &n)) {
+                written += n;
+                progress = 1;
+            } else if (!TEST_int_eq(SSL_get_error(clientssl, 0),
+                                    SSL_ERROR_WANT_WRITE)) {
+                goto end;
+            }
+        }
+        if (SSL_read_ex(serverssl, rbuf + total, ZEROCOPY_MSG_LEN - total,
+                        &n)) {
+            total += n;
+            progress = 1;
+        } else if (!TEST_int_eq(SSL_get_error(serverssl, 0),
+                                SSL_ERROR_WANT_READ)) {
+            goto end;
+        }
+        /* Give the kernel time to move the data rather than spin */
+        if (!progress) {
+            struct pollfd pfd[2];
+
+            pfd[0].fd = sfd;
+            pfd[0].events = POLLIN;
+            pfd[1].fd = cfd;
+            pfd[1].events = written < ZEROCOPY_MSG_LEN ? POLLOUT : 0;
+            poll(pfd, 2, 10);
+        }
+    }
+    if (!TEST_mem_eq(rbuf, total, msg, ZEROCOPY_MSG_LEN))
         goto end;
 
-    sp = SSL_get0_param(ssl);
-    if (!TEST_ptr(sp))
-        goto end;
-    if (!TEST_int_eq(X509_VERIFY_PARAM_get_hostflags(sp), hostflags))
+    /*
+     * Loopback always copies, which turns zerocopy off again, but the sends
+     * made until then must all be reported done. The reports are queued on
+     * the socket error queue asynchronously, which poll() signals as POLLERR.
+     */
+    sent = BIO_get_zerocopy_sent(wbio);
+    for (i = 0; BIO_get_zerocopy_done(wbio) != sent && i < 1000; i++) {
+        struct pollfd pfd;
+
+        pfd.fd = cfd;
+        pfd.events = 0;
+        poll(&pfd, 1, 10);
+    }
+    if (!TEST_uint_gt(sent, 0)
+            || !TEST_uint_eq(BIO_get_zerocopy_done(wbio), sent)
+            || !TEST_true(BIO_set_zerocopy(wbio, 0)))
         goto end;
 
     testresult = 1;
 
  end:
-    SSL_free(ssl);
-    SSL_CTX_free(ctx);
+    if (serverssl != NULL)
+        SSL_shutdown(serverssl);
+    if (clientssl != NULL)
+        SSL_shutdown(clientssl);
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    if (cfd != -1)
+        close(cfd);
+    if (sfd != -1)
+        close(sfd);
+    OPENSSL_free(msg);
+    OPENSSL_free(rbuf);
 
     return testresult;
 }
+#endif
 
 int setup_tests(void)
 {
@@ -7329,10 +11590,22 @@ int setup_tests(void)
     ADD_ALL_TESTS(test_large_app_data, 28);
 #ifndef OPENSSL_NO_OCSP
     ADD_TEST(test_tlsext_status_type);
+    ADD_ALL_TESTS(test_ocsp_staple, 3);
+    ADD_TEST(test_ocsp_verify_cache);
 #endif
+    ADD_TEST(test_chain_cache_peername);
     ADD_TEST(test_session_with_only_int_cache);
     ADD_TEST(test_session_with_only_ext_cache);
     ADD_TEST(test_session_with_both_cache);
+#ifndef OPENSSL_NO_TLS1_2
+    ADD_TEST(test_session_cache_shards);
+#endif
+    ADD_ALL_TESTS(test_session_cache_flush_expired, 2);
+#ifndef OPENSSL_NO_TLS1_2
+    ADD_TEST(test_session_cache_async);
+#endif
+    ADD_TEST(test_session_asn1);
+    ADD_TEST(test_session_compact);
 #ifndef OPENSSL_NO_TLS1_3
     ADD_ALL_TESTS(test_stateful_tickets, 3);
     ADD_ALL_TESTS(test_stateless_tickets, 3);
@@ -7361,6 +11634,7 @@ int setup_tests(void)
      * in that scenario.
      */
     ADD_ALL_TESTS(test_early_data_replay, 2);
+    ADD_TEST(test_replay_filter);
     ADD_ALL_TESTS(test_early_data_skip, 3);
     ADD_ALL_TESTS(test_early_data_skip_hrr, 3);
     ADD_ALL_TESTS(test_early_data_skip_hrr_fail, 3);
@@ -7401,12 +11675,28 @@ int setup_tests(void)
 #endif
     ADD_ALL_TESTS(test_info_callback, 6);
     ADD_ALL_TESTS(test_ssl_pending, 2);
+    ADD_ALL_TESTS(test_writev_readv, 2);
+    ADD_TEST(test_record_buffer_pool);
+    ADD_ALL_TESTS(test_aead_read_batch, 4);
+    ADD_TEST(test_dynamic_record_size);
+#ifndef OPENSSL_NO_TLS1_3
+    ADD_TEST(test_tls13_read_direct);
+#endif
     ADD_ALL_TESTS(test_ssl_get_shared_ciphers, OSSL_NELEM(shared_ciphers_data));
     ADD_ALL_TESTS(test_ticket_callbacks, 12);
     ADD_ALL_TESTS(test_shutdown, 7);
     ADD_ALL_TESTS(test_cert_cb, 6);
     ADD_ALL_TESTS(test_client_cert_cb, 2);
     ADD_ALL_TESTS(test_ca_names, 3);
+#ifndef OPENSSL_NO_TLS1_3
+    ADD_TEST(test_ca_names_cache);
+#endif
+#if !defined(OPENSSL_NO_DTLS1_2) && !defined(OPENSSL_NO_EC)
+    ADD_ALL_TESTS(test_dtls_cid, 4);
+#endif
+#ifndef OPENSSL_NO_DTLS1_2
+    ADD_ALL_TESTS(test_dtls_replay_window, 2);
+#endif
     ADD_ALL_TESTS(test_servername, 10);
 #ifndef OPENSSL_NO_TLS1_2
     ADD_TEST(test_ssl_dup);
@@ -7415,12 +11705,63 @@ int setup_tests(void)
     ADD_TEST(test_sni_tls13);
     ADD_ALL_TESTS(test_ticket_lifetime, 2);
 #endif
+    ADD_ALL_TESTS(test_ticket_key_ring, 2);
+    ADD_ALL_TESTS(test_ticket_peer_cert_cache, 2);
+#ifndef OPENSSL_NO_COMP
+    ADD_ALL_TESTS(test_cert_compression, 4);
+#endif
+#ifndef OPENSSL_NO_TLS1_3
+    ADD_ALL_TESTS(test_cached_info, 3);
+#endif
+    ADD_ALL_TESTS(test_cert_msg_cache, 2);
+#ifndef OPENSSL_NO_TLS1_3
+    ADD_ALL_TESTS(test_handshake_spec_digest, 5);
+#endif
+    ADD_ALL_TESTS(test_cipher_group_prefs, 2);
+#ifndef OPENSSL_NO_EC
+    ADD_ALL_TESTS(test_shared_group, 2);
+    ADD_ALL_TESTS(test_cert_sigalgs, 3);
+#endif
+    ADD_ALL_TESTS(test_handshake_stats, 2);
+    ADD_TEST(test_record_stats);
+    ADD_TEST(test_cork);
+    ADD_TEST(test_memory_usage);
+#ifndef OPENSSL_NO_TLS1_3
+    ADD_TEST(test_post_handshake_in_record);
+#endif
+    ADD_TEST(test_message_size_hint);
+#if !defined(OPENSSL_NO_TLS1_2) && !defined(OPENSSL_NO_TLS1_3)
+    ADD_ALL_TESTS(test_release_handshake_state, 3);
+#endif
+    ADD_TEST(test_swap_cert_bundle);
+    ADD_ALL_TESTS(test_sni_map, 6);
+    ADD_ALL_TESTS(test_client_session_cache, 2);
     ADD_TEST(test_set_alpn);
     ADD_TEST(test_set_verify_cert_store_ssl_ctx);
     ADD_TEST(test_set_verify_cert_store_ssl);
     ADD_TEST(test_inherit_verify_param);
 #if !defined(OPENSSL_NO_TLS1_2) && !defined(OPENSSL_NO_TLS1_3)
     ADD_ALL_TESTS(test_serverinfo_custom, 4);
+#endif
+    ADD_TEST(test_oqs_kem_workers);
+    ADD_TEST(test_oqs_keypair_pool);
+#if !defined(OPENSSL_NO_TLS1_3) && !defined(OPENSSL_NO_EC)
+    ADD_ALL_TESTS(test_oqs_ecx_hybrid_groups, OSSL_NELEM(ecx_hybrid_groups));
+    ADD_ALL_TESTS(test_ecdhe_reuse, 2);
+    ADD_TEST(test_calibrate_groups);
+#endif
+#if !defined(OPENSSL_NO_METRICS) && !defined(OPENSSL_NO_TLS1_3) \
+    && !defined(OPENSSL_NO_EC)
+    ADD_TEST(test_handshake_metrics);
+#endif
+#ifndef OPENSSL_NO_TLS1_3
+    ADD_TEST(test_key_share_cache);
+#endif
+#if !defined(OPENSSL_NO_KTLS) && !defined(OPENSSL_NO_SOCK)
+    ADD_ALL_TESTS(test_ktls, 6);
+#endif
+#if defined(OPENSSL_SYS_LINUX) && !defined(OPENSSL_NO_SOCK)
+    ADD_ALL_TESTS(test_zerocopy, 2);
 #endif
     return 1;
 }
@@ -16,6 +16,11 @@
 
 #ifdef OPENSSL_SYS_UNIX
 # include <unistd.h>
+# if !defined(OPENSSL_NO_KTLS) || defined(OPENSSL_SYS_LINUX)
+#  include <fcntl.h>
+#  include <sys/socket.h>
+#  include <netinet/in.h>
+# endif
 
 static ossl_inline void ossl_sleep(unsigned int millis)
 {
@@ -297,6 +302,7 @@ typedef struct mempacket_test_ctx_st {
     unsigned int dropepoch;
     int droprec;
     int duprec;
+    size_t cidlen;
 } MEMPACKET_TEST_CTX;
 
 static int mempacket_test_new(BIO *bi);
@@ -361,17 +367,31 @@ static int mempacket_test_free(BIO *bio)
 #define EPOCH_HI        3
 #define EPOCH_LO        4
 #define RECORD_SEQUENCE 10
-#define RECORD_LEN_HI   11
-#define RECORD_LEN_LO   12
 
 #define STANDARD_PACKET                 0
 
+/*
+ * Length of the record at |rec| with its header, or -1 if the header is
+ * incomplete. Records with a connection ID have it before the length.
+ */
+static int mempacket_record_len(const MEMPACKET_TEST_CTX *ctx,
+                                const unsigned char *rec, int rem)
+{
+    int hdrlen = DTLS1_RT_HEADER_LENGTH;
+
+    if (rem > 0 && rec[0] == DTLS1_RT_TLS12_CID)
+        hdrlen += (int)ctx->cidlen;
+    if (rem < hdrlen)
+        return -1;
+    return ((rec[hdrlen - 2] << 8) | rec[hdrlen - 1]) + hdrlen;
+}
+
 static int mempacket_test_read(BIO *bio, char *out, int outl)
 {
     MEMPACKET_TEST_CTX *ctx = BIO_get_data(bio);
     MEMPACKET *thispkt;
     unsigned char *rec;
-    int rem;
+    int rem, reclen;
     unsigned int seq, offset, len, epoch;
 
     BIO_clear_retry_flags(bio);
@@ -411,10 +431,10 @@ static int mempacket_test_read(BIO *bio, char *out, int outl)
                 offset++;
             } while (seq > 0);
 
-            len = ((rec[RECORD_LEN_HI] << 8) | rec[RECORD_LEN_LO])
-                  + DTLS1_RT_HEADER_LENGTH;
-            if (rem < (int)len)
+            reclen = mempacket_record_len(ctx, rec, rem);
+            if (reclen < 0 || rem < reclen)
                 return -1;
+            len = (unsigned int)reclen;
             if (ctx->droprec == (int)ctx->currrec && ctx->dropepoch == epoch) {
                 if (rem > (int)len)
                     memmove(rec, rec + len, rem - len);
@@ -473,18 +493,17 @@ int mempacket_test_inject(BIO *bio, const char *in, int inl, int pktnum,
 {
     MEMPACKET_TEST_CTX *ctx = BIO_get_data(bio);
     MEMPACKET *thispkt = NULL, *looppkt, *nextpkt, *allpkts[3];
-    int i, duprec;
+    int i, duprec, len;
     const unsigned char *inu = (const unsigned char *)in;
-    size_t len = ((inu[RECORD_LEN_HI] << 8) | inu[RECORD_LEN_LO])
-                 + DTLS1_RT_HEADER_LENGTH;
 
     if (ctx == NULL)
         return -1;
 
-    if ((size_t)inl < len)
+    len = mempacket_record_len(ctx, inu, inl);
+    if (len < 0 || inl < len)
         return -1;
 
-    if ((size_t)inl == len)
+    if (inl == len)
         duprec = 0;
     else
         duprec = ctx->duprec > 0;
@@ -625,6 +644,9 @@ static long mempacket_test_ctrl(BIO *bio, int cmd, long num, void *ptr)
     case MEMPACKET_CTRL_SET_DUPLICATE_REC:
         ctx->duprec = (int)num;
         break;
+    case MEMPACKET_CTRL_SET_CID_LEN:
+        ctx->cidlen = (size_t)num;
+        break;
     case BIO_CTRL_RESET:
     case BIO_CTRL_DUP:
     case BIO_CTRL_PUSH:
@@ -855,6 +877,103 @@ int create_ssl_objects(SSL_CTX *serverctx, SSL_CTX *clientctx, SSL **sssl,
     return 0;
 }
 
+#if (!defined(OPENSSL_NO_KTLS) || defined(OPENSSL_SYS_LINUX)) \
+    && !defined(OPENSSL_NO_SOCK)
+static int set_nb(int fd)
+{
+    int flags;
+
+    flags = fcntl(fd, F_GETFL, 0);
+    if (flags == -1)
+        return flags;
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+/*
+ * Create a connected pair of non-blocking TCP sockets over the loopback
+ * interface, for tests that need a real kernel socket such as kTLS or
+ * MSG_ZEROCOPY.
+ */
+int create_test_sockets(int *cfdp, int *sfdp)
+{
+    struct sockaddr_in sin;
+    socklen_t slen = sizeof(sin);
+    int afd = -1, cfd = -1, sfd = -1, ret = 0;
+
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    afd = socket(AF_INET, SOCK_STREAM, 0);
+    if (afd < 0)
+        return 0;
+
+    if (bind(afd, (struct sockaddr *)&sin, sizeof(sin)) < 0
+            || getsockname(afd, (struct sockaddr *)&sin, &slen) < 0
+            || listen(afd, 1) < 0)
+        goto err;
+
+    cfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (cfd < 0
+            || connect(cfd, (struct sockaddr *)&sin, sizeof(sin)) < 0)
+        goto err;
+
+    sfd = accept(afd, NULL, NULL);
+    if (sfd < 0 || set_nb(cfd) == -1 || set_nb(sfd) == -1)
+        goto err;
+
+    *cfdp = cfd;
+    *sfdp = sfd;
+    cfd = sfd = -1;
+    ret = 1;
+
+ err:
+    if (cfd != -1)
+        close(cfd);
+    if (sfd != -1)
+        close(sfd);
+    close(afd);
+    return ret;
+}
+
+/*
+ * As create_ssl_objects() but connecting the two SSL objects through the
+ * sockets |sfd| and |cfd|, which stay owned by the caller.
+ */
+int create_ssl_objects2(SSL_CTX *serverctx, SSL_CTX *clientctx, SSL **sssl,
+                        SSL **cssl, int sfd, int cfd)
+{
+    SSL *serverssl = NULL, *clientssl = NULL;
+    BIO *s_to_c_bio = NULL, *c_to_s_bio = NULL;
+
+    if (*sssl != NULL)
+        serverssl = *sssl;
+    else if (!TEST_ptr(serverssl = SSL_new(serverctx)))
+        goto error;
+    if (*cssl != NULL)
+        clientssl = *cssl;
+    else if (!TEST_ptr(clientssl = SSL_new(clientctx)))
+        goto error;
+
+    if (!TEST_ptr(s_to_c_bio = BIO_new_socket(sfd, BIO_NOCLOSE))
+            || !TEST_ptr(c_to_s_bio = BIO_new_socket(cfd, BIO_NOCLOSE)))
+        goto error;
+
+    SSL_set_bio(clientssl, c_to_s_bio, c_to_s_bio);
+    SSL_set_bio(serverssl, s_to_c_bio, s_to_c_bio);
+    *sssl = serverssl;
+    *cssl = clientssl;
+    return 1;
+
+ error:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    BIO_free(s_to_c_bio);
+    BIO_free(c_to_s_bio);
+    return 0;
+}
+#endif
+
 /*
  * Create an SSL connection, but does not ready any post-handshake
  * NewSessionTicket messages.
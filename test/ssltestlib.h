@@ -18,6 +18,12 @@ int create_ssl_ctx_pair(const SSL_METHOD *sm, const SSL_METHOD *cm,
                         char *privkeyfile);
 int create_ssl_objects(SSL_CTX *serverctx, SSL_CTX *clientctx, SSL **sssl,
                        SSL **cssl, BIO *s_to_c_fbio, BIO *c_to_s_fbio);
+# if (!defined(OPENSSL_NO_KTLS) || defined(OPENSSL_SYS_LINUX)) \
+    && !defined(OPENSSL_NO_SOCK)
+int create_test_sockets(int *cfdp, int *sfdp);
+int create_ssl_objects2(SSL_CTX *serverctx, SSL_CTX *clientctx, SSL **sssl,
+                        SSL **cssl, int sfd, int cfd);
+# endif
 int create_bare_ssl_connection(SSL *serverssl, SSL *clientssl, int want,
                                int read);
 int create_ssl_connection(SSL *serverssl, SSL *clientssl, int want);
@@ -45,6 +51,8 @@ void bio_s_always_retry_free(void);
 #define MEMPACKET_CTRL_SET_DROP_REC         (2 << 15)
 #define MEMPACKET_CTRL_GET_DROP_REC         (3 << 15)
 #define MEMPACKET_CTRL_SET_DUPLICATE_REC    (4 << 15)
+/* Length of the connection IDs in the records written to the BIO */
+#define MEMPACKET_CTRL_SET_CID_LEN          (5 << 15)
 
 int mempacket_swap_recent(BIO *bio);
 int mempacket_test_inject(BIO *bio, const char *in, int inl, int pktnum,
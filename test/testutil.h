@@ -41,7 +41,10 @@
  * int global_init(void);
  *
  * This function should return zero if there is an unrecoverable error and
- * non-zero if the initialization was successful.
+ * non-zero if the initialization was successful.  It is called before
+ * anything is allocated, so it can install memory functions with
+ * CRYPTO_set_mem_functions(), but also before the output streams are
+ * opened, so it must not print.
  */
 
 /* Adds a simple test case. */
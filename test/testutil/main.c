@@ -34,10 +34,12 @@ static void check_arg_usage(void)
 int main(int argc, char *argv[])
 {
     int ret = EXIT_FAILURE;
+    /* Before anything is allocated, so that it can set the memory functions */
+    int global_ok = global_init();
 
     test_open_streams();
 
-    if (!global_init()) {
+    if (!global_ok) {
         test_printf_stderr("Global init failed - aborting\n");
         return ret;
     }
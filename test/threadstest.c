@@ -11,7 +11,19 @@
 # include <windows.h>
 #endif
 
+#include <string.h>
+#if !defined(OPENSSL_SYS_WINDOWS)
+# include <sys/time.h>
+#endif
 #include <openssl/crypto.h>
+#include <openssl/bio.h>
+#include <openssl/err.h>
+#include <openssl/rsa.h>
+#include <openssl/bn.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+#include "internal/nelem.h"
 #include "testutil.h"
 
 #if !defined(OPENSSL_THREADS) || defined(CRYPTO_TDEBUG)
@@ -184,10 +196,702 @@ static int test_thread_local(void)
     return 1;
 }
 
+#ifndef OPENSSL_NO_RSA
+# define RSA_THREADS    4
+# define RSA_SIGNATURES 16
+
+static RSA *multi_rsa = NULL;
+static CRYPTO_RWLOCK *multi_rsa_lock = NULL;
+static int multi_rsa_failed = 0;
+
+static void multi_rsa_thread_cb(void)
+{
+    unsigned char msg[32] = { 0 }, sig[256], out[256];
+    int i, len;
+
+    for (i = 0; i < RSA_SIGNATURES; i++) {
+        msg[0] = (unsigned char)i;
+        len = RSA_private_encrypt(sizeof(msg), msg, sig, multi_rsa,
+                                  RSA_PKCS1_PADDING);
+        if (len <= 0
+                || RSA_public_decrypt(len, sig, out, multi_rsa,
+                                      RSA_PKCS1_PADDING) != (int)sizeof(msg)
+                || memcmp(msg, out, sizeof(msg)) != 0) {
+            CRYPTO_THREAD_write_lock(multi_rsa_lock);
+            multi_rsa_failed = 1;
+            CRYPTO_THREAD_unlock(multi_rsa_lock);
+            return;
+        }
+    }
+}
+
+/* Private key operations from several threads share the key's blinding */
+static int test_multi_rsa(void)
+{
+    thread_t threads[RSA_THREADS];
+    BIGNUM *e = NULL;
+    int i, ret = 0;
+
+    multi_rsa_failed = 0;
+    if (!TEST_ptr(multi_rsa_lock = CRYPTO_THREAD_lock_new())
+            || !TEST_ptr(e = BN_new())
+            || !TEST_true(BN_set_word(e, RSA_F4))
+            || !TEST_ptr(multi_rsa = RSA_new())
+            || !TEST_true(RSA_generate_key_ex(multi_rsa, 1024, e, NULL)))
+        goto end;
+
+    /* The first signer owns the key's local blinding */
+    multi_rsa_thread_cb();
+    for (i = 0; i < RSA_THREADS; i++)
+        if (!TEST_true(run_thread(&threads[i], multi_rsa_thread_cb)))
+            goto end;
+    for (i = 0; i < RSA_THREADS; i++)
+        if (!TEST_true(wait_for_thread(threads[i])))
+            goto end;
+    if (!TEST_false(multi_rsa_failed))
+        goto end;
+    ret = 1;
+
+ end:
+    RSA_free(multi_rsa);
+    multi_rsa = NULL;
+    BN_free(e);
+    CRYPTO_THREAD_lock_free(multi_rsa_lock);
+    multi_rsa_lock = NULL;
+    return ret;
+}
+#endif
+
+#define SECMEM_THREADS  4
+#define SECMEM_BLOCKS   64
+
+static CRYPTO_RWLOCK *multi_secmem_lock = NULL;
+static int multi_secmem_failed = 0;
+static unsigned char multi_secmem_tag = 0;
+
+static void multi_secmem_thread_cb(void)
+{
+    unsigned char *p[SECMEM_BLOCKS];
+    unsigned char tag;
+    size_t len;
+    int i, round, bad = 0;
+
+    CRYPTO_THREAD_write_lock(multi_secmem_lock);
+    tag = ++multi_secmem_tag;
+    CRYPTO_THREAD_unlock(multi_secmem_lock);
+
+    for (round = 0; round < 8 && !bad; round++) {
+        for (i = 0; i < SECMEM_BLOCKS; i++) {
+            len = 16 + 97 * ((i + round) % 20);
+            if ((p[i] = OPENSSL_secure_malloc(len)) == NULL
+                    || !CRYPTO_secure_allocated(p[i])) {
+                bad = 1;
+                break;
+            }
+            memset(p[i], tag, len);
+        }
+        while (--i >= 0) {
+            size_t j;
+
+            len = 16 + 97 * ((i + round) % 20);
+            for (j = 0; j < len; j++)
+                if (p[i][j] != tag)
+                    bad = 1;
+            OPENSSL_secure_free(p[i]);
+        }
+    }
+    if (bad) {
+        CRYPTO_THREAD_write_lock(multi_secmem_lock);
+        multi_secmem_failed = 1;
+        CRYPTO_THREAD_unlock(multi_secmem_lock);
+    }
+}
+
+/* Threads allocating from a secure heap large enough to be split */
+static int test_multi_secure_heap(void)
+{
+    thread_t threads[SECMEM_THREADS];
+    int i, ret = 0;
+
+    if (!CRYPTO_secure_malloc_init(1 << 20, 16)) {
+        TEST_info("Secure memory is not available");
+        return 1;
+    }
+    multi_secmem_failed = 0;
+    if (!TEST_ptr(multi_secmem_lock = CRYPTO_THREAD_lock_new()))
+        goto end;
+
+    multi_secmem_thread_cb();
+    for (i = 0; i < SECMEM_THREADS; i++)
+        if (!TEST_true(run_thread(&threads[i], multi_secmem_thread_cb)))
+            goto end;
+    for (i = 0; i < SECMEM_THREADS; i++)
+        if (!TEST_true(wait_for_thread(threads[i])))
+            goto end;
+    if (!TEST_false(multi_secmem_failed)
+            || !TEST_size_t_eq(CRYPTO_secure_used(), 0))
+        goto end;
+    ret = 1;
+
+ end:
+    CRYPTO_THREAD_lock_free(multi_secmem_lock);
+    multi_secmem_lock = NULL;
+    if (!TEST_true(CRYPTO_secure_malloc_done()))
+        ret = 0;
+    return ret;
+}
+
+#define RWLOCK_MAX_THREADS      4
+#define RWLOCK_ROUNDS           (1 << 16)
+#define RWLOCK_WRITE_EVERY      64
+
+static CRYPTO_RWLOCK *rwlock = NULL;
+static int rwlock_a = 0, rwlock_b = 0;
+static int rwlock_failed = 0;
+
+/*
+ * Readers check that they never see a writer half way through updating the
+ * pair, some of them taking the read lock recursively.
+ */
+static void rwlock_thread_cb(void)
+{
+    int i, bad = 0;
+
+    for (i = 1; i <= RWLOCK_ROUNDS; i++) {
+        if (i % RWLOCK_WRITE_EVERY == 0) {
+            CRYPTO_THREAD_write_lock(rwlock);
+            rwlock_a++;
+            rwlock_b++;
+            CRYPTO_THREAD_unlock(rwlock);
+            continue;
+        }
+        CRYPTO_THREAD_read_lock(rwlock);
+        if (i % 7 == 0) {
+            CRYPTO_THREAD_read_lock(rwlock);
+            CRYPTO_THREAD_unlock(rwlock);
+        }
+        if (rwlock_a != rwlock_b)
+            bad = 1;
+        CRYPTO_THREAD_unlock(rwlock);
+    }
+    if (bad) {
+        CRYPTO_THREAD_write_lock(rwlock);
+        rwlock_failed = 1;
+        CRYPTO_THREAD_unlock(rwlock);
+    }
+}
+
+/* Runs the read-mostly load above on 1, 2 and 4 threads, reporting the cost */
+static int test_rwlock_scaling(void)
+{
+    thread_t threads[RWLOCK_MAX_THREADS];
+    int n, i, ret = 0;
+#if !defined(OPENSSL_SYS_WINDOWS)
+    struct timeval start, end;
+    double ns;
+#endif
+
+    if (!TEST_ptr(rwlock = CRYPTO_THREAD_lock_new()))
+        return 0;
+
+    for (n = 1; n <= RWLOCK_MAX_THREADS; n *= 2) {
+        rwlock_a = rwlock_b = 0;
+        rwlock_failed = 0;
+#if !defined(OPENSSL_SYS_WINDOWS)
+        gettimeofday(&start, NULL);
+#endif
+        for (i = 0; i < n; i++)
+            if (!TEST_true(run_thread(&threads[i], rwlock_thread_cb)))
+                goto end;
+        for (i = 0; i < n; i++)
+            if (!TEST_true(wait_for_thread(threads[i])))
+                goto end;
+#if !defined(OPENSSL_SYS_WINDOWS)
+        gettimeofday(&end, NULL);
+        ns = ((end.tv_sec - start.tv_sec) * 1e6
+              + (end.tv_usec - start.tv_usec)) * 1e3;
+        TEST_info("%d thread(s): %.1f ns per lock and unlock", n,
+                  ns / ((double)n * RWLOCK_ROUNDS));
+#endif
+        if (!TEST_false(rwlock_failed)
+                || !TEST_int_eq(rwlock_a, n * (RWLOCK_ROUNDS / RWLOCK_WRITE_EVERY))
+                || !TEST_int_eq(rwlock_b, rwlock_a))
+            goto end;
+    }
+    ret = 1;
+
+ end:
+    CRYPTO_THREAD_lock_free(rwlock);
+    rwlock = NULL;
+    return ret;
+}
+
+#ifndef OPENSSL_NO_LOCK_STATS
+static int test_lock_stats(void)
+{
+    CRYPTO_RWLOCK *lock = CRYPTO_THREAD_lock_new();
+    BIO *bio = NULL;
+    char *out;
+    long len;
+    int i, ret = 0;
+
+    if (!TEST_ptr(lock)
+            || !TEST_ptr(bio = BIO_new(BIO_s_mem())))
+        goto end;
+    for (i = 0; i < 3; i++)
+        if (!TEST_true(CRYPTO_THREAD_read_lock(lock))
+                || !TEST_true(CRYPTO_THREAD_unlock(lock)))
+            goto end;
+# if !defined(OPENSSL_THREADS) || defined(CRYPTO_TDEBUG) \
+     || defined(OPENSSL_SYS_WINDOWS)
+    ret = TEST_false(CRYPTO_THREAD_lock_stats(bio, 0));
+# else
+    if (!TEST_true(CRYPTO_THREAD_lock_stats(bio, 0))
+            || !TEST_long_gt(len = BIO_get_mem_data(bio, &out), 0)
+            || !TEST_ptr(strstr(out, "contended")))
+        goto end;
+    ret = 1;
+# endif
+ end:
+    BIO_free(bio);
+    CRYPTO_THREAD_lock_free(lock);
+    return ret;
+}
+#endif
+
+#ifndef OPENSSL_NO_METRICS
+# define METRICS_THREADS     4
+# define METRICS_ROUNDS      1000
+
+static int metric_id;
+
+static void metrics_thread_cb(void)
+{
+    int i;
+
+    for (i = 0; i < METRICS_ROUNDS; i++)
+        OPENSSL_metric_add(metric_id, 1);
+}
+
+static int metric_find_cb(const char *name, const char *labels, int type,
+                          const char *help, int64_t value, void *arg)
+{
+    if (strcmp(name, "test_metric_total") == 0 && labels != NULL
+            && strcmp(labels, "kind=\"a\"") == 0) {
+        *(int64_t *)arg = value;
+        return 0;
+    }
+    return 1;
+}
+
+static int test_metrics(void)
+{
+    thread_t threads[METRICS_THREADS];
+    int64_t value = -1;
+    BIO *bio = NULL;
+    char *out;
+    int i, gauge, ret = 0;
+
+    metric_id = OPENSSL_metric_register("test_metric_total", "kind=\"a\"",
+                                        OPENSSL_METRIC_COUNTER, "Test counter");
+    gauge = OPENSSL_metric_register("test_metric", NULL, OPENSSL_METRIC_GAUGE,
+                                    NULL);
+    if (!TEST_int_gt(metric_id, 0)
+            || !TEST_int_gt(gauge, metric_id)
+            /* Registering it again finds it */
+            || !TEST_int_eq(OPENSSL_metric_register("test_metric_total",
+                                                    "kind=\"a\"",
+                                                    OPENSSL_METRIC_COUNTER,
+                                                    NULL), metric_id)
+            /* All the metrics of a name have the same type */
+            || !TEST_int_eq(OPENSSL_metric_register("test_metric",
+                                                    "kind=\"b\"",
+                                                    OPENSSL_METRIC_COUNTER,
+                                                    NULL), 0)
+            || !TEST_int_eq(OPENSSL_metric_register("1test", NULL,
+                                                    OPENSSL_METRIC_COUNTER,
+                                                    NULL), 0))
+        goto end;
+    ERR_clear_error();
+
+    /* The threads exit before the metric is read */
+    for (i = 0; i < METRICS_THREADS; i++)
+        if (!TEST_true(run_thread(&threads[i], metrics_thread_cb)))
+            goto end;
+    for (i = 0; i < METRICS_THREADS; i++)
+        if (!TEST_true(wait_for_thread(threads[i])))
+            goto end;
+    OPENSSL_metric_add(metric_id, 5);
+    OPENSSL_metric_add(gauge, 2);
+    OPENSSL_metric_add(gauge, -3);
+
+    if (!TEST_false(OPENSSL_metrics_do_all(metric_find_cb, &value))
+            || !TEST_true(value == METRICS_THREADS * METRICS_ROUNDS + 5)
+            || !TEST_ptr(bio = BIO_new(BIO_s_mem()))
+            || !TEST_true(OPENSSL_metrics_print(bio))
+            || !TEST_long_gt(BIO_write(bio, "", 1), 0)
+            || !TEST_long_gt(BIO_get_mem_data(bio, &out), 0)
+            || !TEST_ptr(strstr(out, "# HELP test_metric_total Test counter\n"
+                                     "# TYPE test_metric_total counter\n"
+                                     "test_metric_total{kind=\"a\"} 4005\n"))
+            || !TEST_ptr(strstr(out, "# TYPE test_metric gauge\n"
+                                     "test_metric -1\n"))
+            || !TEST_ptr(strstr(out, "# TYPE openssl_async_jobs gauge\n")))
+        goto end;
+    ret = 1;
+ end:
+    BIO_free(bio);
+    return ret;
+}
+#endif
+
+#define X509_THREADS    4
+#define X509_ROUNDS     100
+
+static const char *certs_dir = NULL;
+static X509_STORE *x509_store = NULL;
+static X509 *x509_ee = NULL, *x509_root = NULL;
+static STACK_OF(X509) *x509_untrusted = NULL;
+/* Parsed afresh for the threads, so that they race to cache the extensions */
+static X509 *x509_fresh[2] = { NULL, NULL };
+static int x509_fresh_purpose[2];
+static int x509_fresh_ca[2];
+static int x509_fresh_expected[2];
+/* None of them can take part in the chain of x509_ee */
+static const char *x509_added_files[] = {
+    "ca-cert2.pem", "ca-name2.pem", "root-cert2.pem", "root-ed25519.pem",
+    "ee-cert2.pem", "ee-client.pem", "ee-ed25519.pem", "alt1-cert.pem",
+    "alt2-cert.pem", "goodcn1-cert.pem", "badalt1-cert.pem"
+};
+static X509 *x509_added[OSSL_NELEM(x509_added_files)];
+static CRYPTO_RWLOCK *x509_lock = NULL;
+static int x509_failed = 0;
+
+static X509 *load_cert(const char *file)
+{
+    char *path = test_mk_file_path(certs_dir, file);
+    BIO *bio = path != NULL ? BIO_new_file(path, "r") : NULL;
+    X509 *x = bio != NULL ? PEM_read_bio_X509(bio, NULL, NULL, NULL) : NULL;
+
+    BIO_free(bio);
+    OPENSSL_free(path);
+    return x;
+}
+
+static void x509_fail(void)
+{
+    CRYPTO_THREAD_write_lock(x509_lock);
+    x509_failed = 1;
+    CRYPTO_THREAD_unlock(x509_lock);
+}
+
+/*
+ * Look up certificates while the writer adds one in between its lookups,
+ * which leaves the objects of the store unsorted for the next lookup
+ */
+static void x509_lookups(int writer)
+{
+    X509_STORE_CTX *ctx = X509_STORE_CTX_new();
+    STACK_OF(X509) *certs;
+    int i, j;
+
+    if (ctx == NULL) {
+        x509_fail();
+        return;
+    }
+    for (i = 0; i < X509_ROUNDS; i++) {
+        if (writer && i < (int)OSSL_NELEM(x509_added)
+                && !X509_STORE_add_cert(x509_store, x509_added[i]))
+            goto err;
+        for (j = 0; j < 2; j++)
+            if (X509_check_purpose(x509_fresh[j], x509_fresh_purpose[j],
+                                   x509_fresh_ca[j])
+                    != x509_fresh_expected[j])
+                goto err;
+        if (!X509_STORE_CTX_init(ctx, x509_store, x509_ee, x509_untrusted)
+                || X509_verify_cert(ctx) != 1)
+            goto err;
+        certs = X509_STORE_CTX_get1_certs(ctx,
+                                          X509_get_subject_name(x509_root));
+        j = sk_X509_num(certs);
+        sk_X509_pop_free(certs, X509_free);
+        if (j < 1)
+            goto err;
+        X509_STORE_CTX_cleanup(ctx);
+    }
+    X509_STORE_CTX_free(ctx);
+    return;
+ err:
+    X509_STORE_CTX_free(ctx);
+    x509_fail();
+}
+
+static void x509_writer_thread_cb(void)
+{
+    x509_lookups(1);
+}
+
+static void x509_reader_thread_cb(void)
+{
+    x509_lookups(0);
+}
+
+/*
+ * Store lookups and purpose checks from several threads while certificates
+ * are being added to the store
+ */
+static int test_x509_store(void)
+{
+    thread_t threads[X509_THREADS + 1];
+    X509 *ca = NULL;
+    size_t i;
+    int ret = 0;
+
+    x509_failed = 0;
+    if (!TEST_ptr(x509_lock = CRYPTO_THREAD_lock_new())
+            || !TEST_ptr(x509_store = X509_STORE_new())
+            || !TEST_ptr(x509_untrusted = sk_X509_new_null())
+            || !TEST_ptr(x509_ee = load_cert("ee-cert.pem"))
+            || !TEST_ptr(x509_root = load_cert("sroot-cert.pem"))
+            || !TEST_ptr(ca = load_cert("ca-cert.pem"))
+            || !TEST_true(sk_X509_push(x509_untrusted, ca)))
+        goto end;
+    ca = NULL;
+    for (i = 0; i < OSSL_NELEM(x509_added); i++)
+        if (!TEST_ptr(x509_added[i] = load_cert(x509_added_files[i])))
+            goto end;
+    if (!TEST_true(X509_STORE_add_cert(x509_store, x509_root)))
+        goto end;
+
+    /* The expected results come from separately parsed copies */
+    x509_fresh_purpose[0] = X509_PURPOSE_SSL_SERVER;
+    x509_fresh_ca[0] = 0;
+    x509_fresh_purpose[1] = -1;
+    x509_fresh_ca[1] = 1;
+    x509_fresh_expected[0] = X509_check_purpose(x509_ee,
+                                                x509_fresh_purpose[0], 0);
+    x509_fresh_expected[1] = X509_check_purpose(sk_X509_value(x509_untrusted,
+                                                              0), -1, 1);
+    if (!TEST_int_eq(x509_fresh_expected[0], 1)
+            || !TEST_int_gt(x509_fresh_expected[1], 0)
+            || !TEST_ptr(x509_fresh[0] = load_cert("ee-cert.pem"))
+            || !TEST_ptr(x509_fresh[1] = load_cert("ca-cert.pem")))
+        goto end;
+
+    if (!TEST_true(run_thread(&threads[0], x509_writer_thread_cb)))
+        goto end;
+    for (i = 1; i <= X509_THREADS; i++)
+        if (!TEST_true(run_thread(&threads[i], x509_reader_thread_cb)))
+            goto end;
+    for (i = 0; i <= X509_THREADS; i++)
+        if (!TEST_true(wait_for_thread(threads[i])))
+            goto end;
+    if (!TEST_false(x509_failed))
+        goto end;
+    ret = 1;
+
+ end:
+    X509_STORE_free(x509_store);
+    x509_store = NULL;
+    sk_X509_pop_free(x509_untrusted, X509_free);
+    x509_untrusted = NULL;
+    X509_free(x509_ee);
+    X509_free(x509_root);
+    x509_ee = x509_root = NULL;
+    X509_free(ca);
+    for (i = 0; i < OSSL_NELEM(x509_fresh); i++) {
+        X509_free(x509_fresh[i]);
+        x509_fresh[i] = NULL;
+    }
+    for (i = 0; i < OSSL_NELEM(x509_added); i++) {
+        X509_free(x509_added[i]);
+        x509_added[i] = NULL;
+    }
+    CRYPTO_THREAD_lock_free(x509_lock);
+    x509_lock = NULL;
+    return ret;
+}
+
+/*
+ * OQS public keys parsed from DER are only decoded by X509_PUBKEY_get0(),
+ * see pubkey_cb() in crypto/x509/x_pubkey.c
+ */
+static X509_PUBKEY *oqs_pubkey = NULL;
+static EVP_PKEY *oqs_pubkey_got[X509_THREADS];
+static int oqs_pubkey_next = 0;
+
+/* Generates a Dilithium2 key, returning it and its X509_PUBKEY encoding */
+static EVP_PKEY *oqs_pubkey_new(unsigned char **der, int *derlen)
+{
+    EVP_PKEY_CTX *ctx = NULL;
+    EVP_PKEY *key = NULL;
+
+    *der = NULL;
+    if (!TEST_ptr(ctx = EVP_PKEY_CTX_new_id(NID_dilithium2, NULL))
+            || !TEST_int_gt(EVP_PKEY_keygen_init(ctx), 0)
+            || !TEST_int_gt(EVP_PKEY_keygen(ctx, &key), 0)
+            || !TEST_int_gt(*derlen = i2d_PUBKEY(key, der), 0)) {
+        EVP_PKEY_free(key);
+        key = NULL;
+    }
+    EVP_PKEY_CTX_free(ctx);
+    return key;
+}
+
+static int test_oqs_pubkey_deferred(void)
+{
+    X509_PUBKEY *xpk = NULL;
+    EVP_PKEY *key = NULL, *got, *ref = NULL;
+    unsigned char *der = NULL;
+    const unsigned char *p;
+    int derlen, ret = 0;
+
+    if (!OQS_SIG_alg_is_enabled(OQS_SIG_alg_dilithium_2)) {
+        TEST_info("Skipping: %s is not enabled", OQS_SIG_alg_dilithium_2);
+        return 1;
+    }
+    if (!TEST_ptr(key = oqs_pubkey_new(&der, &derlen)))
+        goto end;
+
+    p = der;
+    if (!TEST_ptr(xpk = d2i_X509_PUBKEY(NULL, &p, derlen))
+            || !TEST_ptr(got = X509_PUBKEY_get0(xpk))
+            || !TEST_int_eq(EVP_PKEY_cmp(got, key), 1)
+            /* The decoded key is cached */
+            || !TEST_ptr_eq(X509_PUBKEY_get0(xpk), got)
+            || !TEST_ptr_eq(ref = X509_PUBKEY_get(xpk), got))
+        goto end;
+    ret = 1;
+ end:
+    EVP_PKEY_free(ref);
+    X509_PUBKEY_free(xpk);
+    EVP_PKEY_free(key);
+    OPENSSL_free(der);
+    return ret;
+}
+
+/* A key that can't be decoded is reported by X509_PUBKEY_get0(), not d2i */
+static int test_oqs_pubkey_decode_error(void)
+{
+    static unsigned char pub[] = { 0x01, 0x02, 0x03, 0x04 };
+    X509_PUBKEY *xpk = NULL, *parsed = NULL;
+    unsigned char *penc, *der = NULL;
+    const unsigned char *p;
+    int i, derlen, ret = 0;
+
+    /* Dilithium2 keys must have no algorithm parameters */
+    if (!TEST_ptr(xpk = X509_PUBKEY_new())
+            || !TEST_ptr(penc = OPENSSL_memdup(pub, sizeof(pub))))
+        goto end;
+    if (!TEST_true(X509_PUBKEY_set0_param(xpk, OBJ_nid2obj(NID_dilithium2),
+                                          V_ASN1_NULL, NULL, penc,
+                                          sizeof(pub)))) {
+        OPENSSL_free(penc);
+        goto end;
+    }
+    if (!TEST_int_gt(derlen = i2d_X509_PUBKEY(xpk, &der), 0))
+        goto end;
+
+    ERR_clear_error();
+    p = der;
+    if (!TEST_ptr(parsed = d2i_X509_PUBKEY(NULL, &p, derlen))
+            || !TEST_ulong_eq(ERR_peek_error(), 0))
+        goto end;
+    /* The decode is retried, and the error reported, on every call */
+    for (i = 0; i < 2; i++) {
+        if (!TEST_ptr_null(X509_PUBKEY_get0(parsed))
+                || !TEST_int_eq(ERR_GET_REASON(ERR_peek_last_error()),
+                                X509_R_PUBLIC_KEY_DECODE_ERROR))
+            goto end;
+        ERR_clear_error();
+    }
+    ret = 1;
+ end:
+    X509_PUBKEY_free(parsed);
+    X509_PUBKEY_free(xpk);
+    OPENSSL_free(der);
+    return ret;
+}
+
+static void oqs_pubkey_thread_cb(void)
+{
+    EVP_PKEY *got = X509_PUBKEY_get0(oqs_pubkey);
+
+    CRYPTO_THREAD_write_lock(x509_lock);
+    oqs_pubkey_got[oqs_pubkey_next++] = got;
+    CRYPTO_THREAD_unlock(x509_lock);
+}
+
+/* Threads racing to decode the same key all get the one cached EVP_PKEY */
+static int test_oqs_pubkey_threads(void)
+{
+    thread_t threads[X509_THREADS];
+    EVP_PKEY *key = NULL;
+    unsigned char *der = NULL;
+    const unsigned char *p;
+    int derlen, i, ret = 0;
+
+    if (!OQS_SIG_alg_is_enabled(OQS_SIG_alg_dilithium_2)) {
+        TEST_info("Skipping: %s is not enabled", OQS_SIG_alg_dilithium_2);
+        return 1;
+    }
+    oqs_pubkey_next = 0;
+    if (!TEST_ptr(x509_lock = CRYPTO_THREAD_lock_new())
+            || !TEST_ptr(key = oqs_pubkey_new(&der, &derlen)))
+        goto end;
+    p = der;
+    if (!TEST_ptr(oqs_pubkey = d2i_X509_PUBKEY(NULL, &p, derlen)))
+        goto end;
+
+    for (i = 0; i < X509_THREADS; i++)
+        if (!TEST_true(run_thread(&threads[i], oqs_pubkey_thread_cb)))
+            goto end;
+    for (i = 0; i < X509_THREADS; i++)
+        if (!TEST_true(wait_for_thread(threads[i])))
+            goto end;
+    if (!TEST_int_eq(oqs_pubkey_next, X509_THREADS)
+            || !TEST_ptr(oqs_pubkey_got[0])
+            || !TEST_int_eq(EVP_PKEY_cmp(oqs_pubkey_got[0], key), 1)
+            || !TEST_ptr_eq(X509_PUBKEY_get0(oqs_pubkey), oqs_pubkey_got[0]))
+        goto end;
+    for (i = 1; i < X509_THREADS; i++)
+        if (!TEST_ptr_eq(oqs_pubkey_got[i], oqs_pubkey_got[0]))
+            goto end;
+    ret = 1;
+ end:
+    X509_PUBKEY_free(oqs_pubkey);
+    oqs_pubkey = NULL;
+    EVP_PKEY_free(key);
+    OPENSSL_free(der);
+    CRYPTO_THREAD_lock_free(x509_lock);
+    x509_lock = NULL;
+    return ret;
+}
+
 int setup_tests(void)
 {
+    if (!TEST_ptr(certs_dir = test_get_argument(0))) {
+        TEST_error("usage: threadstest certs-dir\n");
+        return 0;
+    }
+
     ADD_TEST(test_lock);
     ADD_TEST(test_once);
     ADD_TEST(test_thread_local);
+#ifndef OPENSSL_NO_RSA
+    ADD_TEST(test_multi_rsa);
+#endif
+    ADD_TEST(test_multi_secure_heap);
+    ADD_TEST(test_rwlock_scaling);
+#ifndef OPENSSL_NO_LOCK_STATS
+    ADD_TEST(test_lock_stats);
+#endif
+#ifndef OPENSSL_NO_METRICS
+    ADD_TEST(test_metrics);
+#endif
+    ADD_TEST(test_x509_store);
+    ADD_TEST(test_oqs_pubkey_deferred);
+    ADD_TEST(test_oqs_pubkey_decode_error);
+    ADD_TEST(test_oqs_pubkey_threads);
     return 1;
 }
@@ -0,0 +1,314 @@
+/*
+ * Copyright 2023 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <openssl/ts.h>
+#include <openssl/bio.h>
+#include <openssl/evp.h>
+#include <openssl/ec.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+
+#include "testutil.h"
+
+#define NUM_REQUESTS    6
+/* Asks for a digest the TSA does not accept */
+#define BAD_ALG_REQUEST 3
+/* Is not a request at all */
+#define BAD_DER_REQUEST 5
+
+static X509 *tsa_cert = NULL;
+static EVP_PKEY *tsa_key = NULL;
+static X509_STORE *tsa_store = NULL;
+static ASN1_OBJECT *tsa_policy = NULL;
+static TS_REQ *requests[NUM_REQUESTS];
+static unsigned char *requests_der[NUM_REQUESTS];
+static int requests_der_len[NUM_REQUESTS];
+
+/* A self-signed P-256 certificate usable for time stamping */
+static int make_tsa_cert(void)
+{
+    EVP_PKEY_CTX *pctx = NULL;
+    X509_NAME *name = NULL;
+    X509_EXTENSION *ext = NULL;
+    int ret = 0;
+
+    if (!TEST_ptr(pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, NULL))
+            || !TEST_int_gt(EVP_PKEY_keygen_init(pctx), 0)
+            || !TEST_int_gt(EVP_PKEY_CTX_set_ec_paramgen_curve_nid(
+                                pctx, NID_X9_62_prime256v1), 0)
+            || !TEST_int_gt(EVP_PKEY_keygen(pctx, &tsa_key), 0)
+            || !TEST_ptr(tsa_cert = X509_new())
+            || !TEST_true(X509_set_version(tsa_cert, 2))
+            || !TEST_true(ASN1_INTEGER_set(X509_get_serialNumber(tsa_cert),
+                                           1))
+            || !TEST_ptr(name = X509_NAME_new())
+            || !TEST_true(X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                                     (unsigned char *)"TSA",
+                                                     -1, -1, 0))
+            || !TEST_true(X509_set_subject_name(tsa_cert, name))
+            || !TEST_true(X509_set_issuer_name(tsa_cert, name))
+            || !TEST_ptr(X509_gmtime_adj(X509_getm_notBefore(tsa_cert), 0))
+            || !TEST_ptr(X509_gmtime_adj(X509_getm_notAfter(tsa_cert),
+                                         24 * 60 * 60))
+            || !TEST_true(X509_set_pubkey(tsa_cert, tsa_key))
+            || !TEST_ptr(ext = X509V3_EXT_conf_nid(NULL, NULL,
+                                                   NID_ext_key_usage,
+                                                   "critical,timeStamping"))
+            || !TEST_true(X509_add_ext(tsa_cert, ext, -1))
+            || !TEST_int_gt(X509_sign(tsa_cert, tsa_key, EVP_sha256()), 0))
+        goto end;
+    ret = 1;
+
+ end:
+    X509_EXTENSION_free(ext);
+    X509_NAME_free(name);
+    EVP_PKEY_CTX_free(pctx);
+    return ret;
+}
+
+/* A request for the SHA-256 (or SHA-1) imprint of "request |i|" */
+static TS_REQ *make_request(int i, const EVP_MD *md)
+{
+    TS_REQ *req = NULL, *ret = NULL;
+    TS_MSG_IMPRINT *imprint = NULL;
+    X509_ALGOR *algo = NULL;
+    ASN1_INTEGER *nonce = NULL;
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_len;
+    char data[32];
+
+    BIO_snprintf(data, sizeof(data), "request %d", i);
+    if (!TEST_true(EVP_Digest(data, strlen(data), digest, &digest_len, md,
+                              NULL))
+            || !TEST_ptr(req = TS_REQ_new())
+            || !TEST_true(TS_REQ_set_version(req, 1))
+            || !TEST_ptr(imprint = TS_MSG_IMPRINT_new())
+            || !TEST_ptr(algo = X509_ALGOR_new())
+            || !TEST_true(X509_ALGOR_set0(algo, OBJ_nid2obj(EVP_MD_type(md)),
+                                          V_ASN1_NULL, NULL))
+            || !TEST_true(TS_MSG_IMPRINT_set_algo(imprint, algo))
+            || !TEST_true(TS_MSG_IMPRINT_set_msg(imprint, digest,
+                                                 (int)digest_len))
+            || !TEST_true(TS_REQ_set_msg_imprint(req, imprint))
+            || !TEST_ptr(nonce = ASN1_INTEGER_new())
+            || !TEST_true(ASN1_INTEGER_set(nonce, 1000 + i))
+            || !TEST_true(TS_REQ_set_nonce(req, nonce))
+            || !TEST_true(TS_REQ_set_cert_req(req, 1)))
+        goto end;
+    ret = req;
+    req = NULL;
+
+ end:
+    ASN1_INTEGER_free(nonce);
+    X509_ALGOR_free(algo);
+    TS_MSG_IMPRINT_free(imprint);
+    TS_REQ_free(req);
+    return ret;
+}
+
+/* All responses get the same time, so that their TSTInfo can be compared */
+static int fixed_time_cb(TS_RESP_CTX *ctx, void *data, long *sec, long *usec)
+{
+    *sec = 1700000000;
+    *usec = 0;
+    return 1;
+}
+
+static TS_RESP_CTX *make_resp_ctx(void)
+{
+    TS_RESP_CTX *ctx = TS_RESP_CTX_new();
+
+    if (!TEST_ptr(ctx)
+            || !TEST_true(TS_RESP_CTX_set_signer_cert(ctx, tsa_cert))
+            || !TEST_true(TS_RESP_CTX_set_signer_key(ctx, tsa_key))
+            || !TEST_true(TS_RESP_CTX_set_def_policy(ctx, tsa_policy))
+            || !TEST_true(TS_RESP_CTX_add_md(ctx, EVP_sha256()))) {
+        TS_RESP_CTX_free(ctx);
+        return NULL;
+    }
+    TS_RESP_CTX_set_time_cb(ctx, fixed_time_cb, NULL);
+    return ctx;
+}
+
+static long resp_status(TS_RESP *resp)
+{
+    return ASN1_INTEGER_get(TS_STATUS_INFO_get0_status(
+                                TS_RESP_get_status_info(resp)));
+}
+
+/* Checks that the signature of granted response |i| verifies */
+static int verify_response(int i, TS_RESP *resp)
+{
+    TS_VERIFY_CTX *vctx = NULL;
+    int ret = 0;
+
+    if (!TEST_ptr(vctx = TS_REQ_to_TS_VERIFY_CTX(requests[i], NULL)))
+        return 0;
+    TS_VERIFY_CTX_add_flags(vctx, TS_VFY_SIGNATURE);
+    if (!TEST_true(X509_STORE_up_ref(tsa_store)))
+        goto end;
+    TS_VERIFY_CTX_set_store(vctx, tsa_store);
+    if (!TEST_true(TS_RESP_verify_response(vctx, resp))) {
+        TEST_info("response %d does not verify", i);
+        goto end;
+    }
+    ret = 1;
+
+ end:
+    TS_VERIFY_CTX_free(vctx);
+    return ret;
+}
+
+/* Checks that |batch| has the status and the content of |serial| */
+static int compare_responses(int i, TS_RESP *batch, TS_RESP *serial)
+{
+    const ASN1_BIT_STRING *bfail, *sfail;
+    unsigned char *bder = NULL, *sder = NULL;
+    int blen, slen, ret = 0;
+
+    bfail = TS_STATUS_INFO_get0_failure_info(TS_RESP_get_status_info(batch));
+    sfail = TS_STATUS_INFO_get0_failure_info(TS_RESP_get_status_info(serial));
+    if (!TEST_long_eq(resp_status(batch), resp_status(serial))
+            || !TEST_int_eq(bfail == NULL, sfail == NULL)
+            || (bfail != NULL && !TEST_int_eq(ASN1_STRING_cmp(bfail, sfail),
+                                              0)))
+        goto end;
+
+    if (resp_status(serial) != TS_STATUS_GRANTED) {
+        if (!TEST_ptr_null(TS_RESP_get_tst_info(batch)))
+            goto end;
+        ret = 1;
+        goto end;
+    }
+    if (!TEST_int_gt(blen = i2d_TS_TST_INFO(TS_RESP_get_tst_info(batch),
+                                            &bder), 0)
+            || !TEST_int_gt(slen = i2d_TS_TST_INFO(TS_RESP_get_tst_info(serial),
+                                                   &sder), 0)
+            || !TEST_mem_eq(bder, blen, sder, slen)
+            || !verify_response(i, batch)
+            || !verify_response(i, serial))
+        goto end;
+    ret = 1;
+
+ end:
+    if (!ret)
+        TEST_info("response %d differs", i);
+    OPENSSL_free(bder);
+    OPENSSL_free(sder);
+    return ret;
+}
+
+/*
+ * Test that TS_RESP_create_response_batch() gives every request the response
+ * TS_RESP_create_response() gives it, rejections included.
+ * Test 0: one thread
+ * Test 1: four threads
+ */
+static int test_response_batch(int idx)
+{
+    TS_RESP_CTX *ctx = NULL;
+    BIO *bios[NUM_REQUESTS] = { NULL };
+    TS_RESP *batch[NUM_REQUESTS] = { NULL }, *serial[NUM_REQUESTS] = { NULL };
+    int testresult = 0, i;
+
+    if (!TEST_ptr(ctx = make_resp_ctx())
+            || !TEST_false(TS_RESP_CTX_set_num_threads(ctx, 0))
+            || !TEST_false(TS_RESP_CTX_set_num_threads(ctx,
+                                                       TS_RESP_MAX_THREADS
+                                                       + 1))
+            || !TEST_true(TS_RESP_CTX_set_num_threads(ctx, idx == 0 ? 1 : 4)))
+        goto end;
+
+    for (i = 0; i < NUM_REQUESTS; i++)
+        if (!TEST_ptr(bios[i] = BIO_new_mem_buf(requests_der[i],
+                                                requests_der_len[i])))
+            goto end;
+    if (!TEST_true(TS_RESP_create_response_batch(ctx, bios, batch,
+                                                 NUM_REQUESTS)))
+        goto end;
+
+    for (i = 0; i < NUM_REQUESTS; i++) {
+        BIO_free(bios[i]);
+        if (!TEST_ptr(bios[i] = BIO_new_mem_buf(requests_der[i],
+                                                requests_der_len[i]))
+                || !TEST_ptr(serial[i] = TS_RESP_create_response(ctx,
+                                                                 bios[i])))
+            goto end;
+    }
+
+    for (i = 0; i < NUM_REQUESTS; i++) {
+        long expected = i == BAD_ALG_REQUEST || i == BAD_DER_REQUEST
+                        ? TS_STATUS_REJECTION : TS_STATUS_GRANTED;
+
+        if (!TEST_ptr(batch[i])
+                || !TEST_long_eq(resp_status(batch[i]), expected)
+                || !compare_responses(i, batch[i], serial[i]))
+            goto end;
+    }
+
+    testresult = 1;
+
+ end:
+    for (i = 0; i < NUM_REQUESTS; i++) {
+        BIO_free(bios[i]);
+        TS_RESP_free(batch[i]);
+        TS_RESP_free(serial[i]);
+    }
+    TS_RESP_CTX_free(ctx);
+    return testresult;
+}
+
+int setup_tests(void)
+{
+    static const unsigned char garbage[] = { 0x30, 0x03, 0x02, 0x01, 0x01 };
+    int i;
+
+    if (!make_tsa_cert()
+            || !TEST_ptr(tsa_store = X509_STORE_new())
+            || !TEST_true(X509_STORE_add_cert(tsa_store, tsa_cert))
+            || !TEST_ptr(tsa_policy = OBJ_txt2obj("1.2.3.4.1", 1)))
+        return 0;
+
+    for (i = 0; i < NUM_REQUESTS; i++) {
+        if (i == BAD_DER_REQUEST) {
+            if (!TEST_ptr(requests_der[i] = OPENSSL_memdup(garbage,
+                                                           sizeof(garbage))))
+                return 0;
+            requests_der_len[i] = sizeof(garbage);
+            continue;
+        }
+        if (!TEST_ptr(requests[i] = make_request(i, i == BAD_ALG_REQUEST
+                                                    ? EVP_sha1()
+                                                    : EVP_sha256()))
+                || !TEST_int_gt(requests_der_len[i]
+                                = i2d_TS_REQ(requests[i], &requests_der[i]),
+                                0))
+            return 0;
+    }
+
+    ADD_ALL_TESTS(test_response_batch, 2);
+    return 1;
+}
+
+void cleanup_tests(void)
+{
+    int i;
+
+    for (i = 0; i < NUM_REQUESTS; i++) {
+        TS_REQ_free(requests[i]);
+        OPENSSL_free(requests_der[i]);
+    }
+    ASN1_OBJECT_free(tsa_policy);
+    X509_STORE_free(tsa_store);
+    X509_free(tsa_cert);
+    EVP_PKEY_free(tsa_key);
+}
@@ -9,6 +9,7 @@
 
 #include <stdio.h>
 #include <openssl/crypto.h>
+#include <openssl/async.h>
 #include <openssl/bio.h>
 #include <openssl/x509.h>
 #include <openssl/x509v3.h>
@@ -21,9 +22,11 @@ static char *roots_f = NULL;
 static char *untrusted_f = NULL;
 static char *bad_f = NULL;
 static char *good_f = NULL;
+static char *root_cert = NULL;
 static char *sroot_cert = NULL;
 static char *ca_cert = NULL;
 static char *ee_cert = NULL;
+static char *ca_key = NULL;
 
 static X509 *load_cert_pem(const char *file)
 {
@@ -304,6 +307,427 @@ static int test_purpose_any(void)
     return do_test_purpose(X509_PURPOSE_ANY, 1);
 }
 
+/*
+ * Verify ee-cert twice with equal but distinct intermediates. The second
+ * chain holds the intermediate of the first verification if it came from
+ * the chain cache.
+ */
+static int test_chain_cache(void)
+{
+    X509 *eecert = load_cert_pem(ee_cert);
+    X509 *untr1 = load_cert_pem(ca_cert);
+    X509 *untr2 = load_cert_pem(ca_cert);
+    X509 *trcert = load_cert_pem(sroot_cert);
+    X509_CRL *crl = X509_CRL_new();
+    STACK_OF(X509) *untrusted1 = sk_X509_new_null();
+    STACK_OF(X509) *untrusted2 = sk_X509_new_null();
+    X509_STORE *store = X509_STORE_new();
+    X509_STORE_CTX *ctx = X509_STORE_CTX_new();
+    int i, testresult = 0;
+
+    if (!TEST_ptr(eecert)
+            || !TEST_ptr(untr1)
+            || !TEST_ptr(untr2)
+            || !TEST_ptr(trcert)
+            || !TEST_ptr(crl)
+            || !TEST_ptr(untrusted1)
+            || !TEST_ptr(untrusted2)
+            || !TEST_ptr(store)
+            || !TEST_ptr(ctx)
+            || !TEST_true(sk_X509_push(untrusted1, untr1)))
+        goto err;
+    untr1 = NULL;
+    if (!TEST_true(sk_X509_push(untrusted2, untr2)))
+        goto err;
+    untr2 = NULL;
+
+    if (!TEST_true(X509_STORE_add_cert(store, trcert))
+            || !TEST_false(X509_STORE_set_chain_cache(store, 8, 0))
+            || !TEST_true(X509_STORE_set_chain_cache(store, 8, 300)))
+        goto err;
+
+    /* Fill the cache */
+    if (!TEST_true(X509_STORE_CTX_init(ctx, store, eecert, untrusted1))
+            || !TEST_int_eq(X509_verify_cert(ctx), 1)
+            || !TEST_ptr_eq(sk_X509_value(X509_STORE_CTX_get0_chain(ctx), 1),
+                            sk_X509_value(untrusted1, 0)))
+        goto err;
+    X509_STORE_CTX_cleanup(ctx);
+
+    /* Served from the cache */
+    if (!TEST_true(X509_STORE_CTX_init(ctx, store, eecert, untrusted2))
+            || !TEST_int_eq(X509_verify_cert(ctx), 1)
+            || !TEST_int_eq(X509_STORE_CTX_get_error(ctx), X509_V_OK)
+            || !TEST_int_eq(X509_STORE_CTX_get_num_untrusted(ctx), 2)
+            || !TEST_int_eq(sk_X509_num(X509_STORE_CTX_get0_chain(ctx)), 3)
+            || !TEST_ptr_eq(sk_X509_value(X509_STORE_CTX_get0_chain(ctx), 0),
+                            eecert)
+            || !TEST_ptr_eq(sk_X509_value(X509_STORE_CTX_get0_chain(ctx), 1),
+                            sk_X509_value(untrusted1, 0)))
+        goto err;
+    X509_STORE_CTX_cleanup(ctx);
+
+    /* A chain served from the cache still reports the name that matched */
+    for (i = 0; i < 2; i++) {
+        if (!TEST_true(X509_STORE_CTX_init(ctx, store, eecert,
+                                           i == 0 ? untrusted1 : untrusted2))
+                || !TEST_true(X509_VERIFY_PARAM_set1_host(
+                                  X509_STORE_CTX_get0_param(ctx),
+                                  "server.example", 0))
+                || !TEST_int_eq(X509_verify_cert(ctx), 1)
+                || !TEST_ptr_eq(sk_X509_value(X509_STORE_CTX_get0_chain(ctx),
+                                              1),
+                                sk_X509_value(untrusted1, 0))
+                || !TEST_str_eq(X509_VERIFY_PARAM_get0_peername(
+                                    X509_STORE_CTX_get0_param(ctx)),
+                                "server.example"))
+            goto err;
+        X509_STORE_CTX_cleanup(ctx);
+    }
+
+    /* Other parameters do not match the cached result */
+    if (!TEST_true(X509_STORE_CTX_init(ctx, store, eecert, untrusted1))
+            || !TEST_true(X509_STORE_CTX_set_purpose(ctx,
+                                                     X509_PURPOSE_SSL_CLIENT))
+            || !TEST_int_eq(X509_verify_cert(ctx), 0))
+        goto err;
+    X509_STORE_CTX_cleanup(ctx);
+
+    /* Adding a CRL to the store empties the cache */
+    if (!TEST_true(X509_STORE_add_crl(store, crl))
+            || !TEST_true(X509_STORE_CTX_init(ctx, store, eecert, untrusted2))
+            || !TEST_int_eq(X509_verify_cert(ctx), 1)
+            || !TEST_ptr_eq(sk_X509_value(X509_STORE_CTX_get0_chain(ctx), 1),
+                            sk_X509_value(untrusted2, 0)))
+        goto err;
+
+    testresult = 1;
+ err:
+    X509_STORE_CTX_free(ctx);
+    X509_STORE_free(store);
+    sk_X509_pop_free(untrusted1, X509_free);
+    sk_X509_pop_free(untrusted2, X509_free);
+    X509_CRL_free(crl);
+    X509_free(eecert);
+    X509_free(untr1);
+    X509_free(untr2);
+    X509_free(trcert);
+    return testresult;
+}
+
+/* An empty CRL of |issuer|, valid for a day */
+static X509_CRL *make_crl(X509 *issuer, EVP_PKEY *key)
+{
+    X509_CRL *crl = X509_CRL_new();
+    ASN1_TIME *last = X509_gmtime_adj(NULL, -60);
+    ASN1_TIME *next = X509_gmtime_adj(NULL, 24 * 3600);
+
+    if (crl == NULL
+            || last == NULL
+            || next == NULL
+            || !X509_CRL_set_version(crl, 1)
+            || !X509_CRL_set_issuer_name(crl, X509_get_subject_name(issuer))
+            || !X509_CRL_set1_lastUpdate(crl, last)
+            || !X509_CRL_set1_nextUpdate(crl, next)
+            || !X509_CRL_sign(crl, key, EVP_sha256())) {
+        X509_CRL_free(crl);
+        crl = NULL;
+    }
+    ASN1_TIME_free(last);
+    ASN1_TIME_free(next);
+    return crl;
+}
+
+/*
+ * A CRL may expire, or be found by a lookup method, while a chain is
+ * cached, so with CRL checks every chain is built and checked afresh
+ */
+static int test_chain_cache_crl(void)
+{
+    X509 *eecert = load_cert_pem(ee_cert);
+    X509 *untr[2];
+    X509 *trcert = load_cert_pem(sroot_cert);
+    STACK_OF(X509) *untrusted[2] = { NULL, NULL };
+    X509_STORE *store = X509_STORE_new();
+    X509_STORE_CTX *ctx = X509_STORE_CTX_new();
+    X509_CRL *crl = NULL;
+    EVP_PKEY *key = NULL;
+    BIO *bio = NULL;
+    int i, testresult = 0;
+
+    /* Equal but distinct intermediates, as in test_chain_cache() */
+    untr[0] = load_cert_pem(ca_cert);
+    untr[1] = load_cert_pem(ca_cert);
+    if (!TEST_ptr(eecert)
+            || !TEST_ptr(untr[0])
+            || !TEST_ptr(untr[1])
+            || !TEST_ptr(trcert)
+            || !TEST_ptr(store)
+            || !TEST_ptr(ctx)
+            || !TEST_ptr(bio = BIO_new_file(ca_key, "r"))
+            || !TEST_ptr(key = PEM_read_bio_PrivateKey(bio, NULL, NULL, NULL))
+            || !TEST_ptr(crl = make_crl(untr[0], key))
+            || !TEST_true(X509_STORE_add_cert(store, trcert))
+            || !TEST_true(X509_STORE_add_crl(store, crl))
+            || !TEST_true(X509_STORE_set_flags(store, X509_V_FLAG_CRL_CHECK))
+            || !TEST_true(X509_STORE_set_chain_cache(store, 8, 300)))
+        goto err;
+    for (i = 0; i < 2; i++) {
+        if (!TEST_ptr(untrusted[i] = sk_X509_new_null())
+                || !TEST_true(sk_X509_push(untrusted[i], untr[i])))
+            goto err;
+        untr[i] = NULL;
+    }
+
+    /* Each chain holds its own intermediate, none came from the cache */
+    for (i = 0; i < 2; i++) {
+        if (!TEST_true(X509_STORE_CTX_init(ctx, store, eecert, untrusted[i]))
+                || !TEST_int_eq(X509_verify_cert(ctx), 1)
+                || !TEST_int_eq(X509_STORE_CTX_get_error(ctx), X509_V_OK)
+                || !TEST_ptr_eq(sk_X509_value(X509_STORE_CTX_get0_chain(ctx),
+                                              1),
+                                sk_X509_value(untrusted[i], 0)))
+            goto err;
+        X509_STORE_CTX_cleanup(ctx);
+    }
+
+    testresult = 1;
+ err:
+    X509_STORE_CTX_free(ctx);
+    X509_STORE_free(store);
+    for (i = 0; i < 2; i++)
+        sk_X509_pop_free(untrusted[i], X509_free);
+    X509_CRL_free(crl);
+    EVP_PKEY_free(key);
+    BIO_free(bio);
+    X509_free(eecert);
+    X509_free(untr[0]);
+    X509_free(untr[1]);
+    X509_free(trcert);
+    return testresult;
+}
+
+/*
+ * Write the root into a CA bundle, after a different certificate with the
+ * same subject, and verify ee-cert against a store that only has the bundle.
+ */
+static int test_bundle_lookup(void)
+{
+    const char *bundle = "verify_extra_test.cab";
+    X509 *eecert = load_cert_pem(ee_cert);
+    X509 *untr = load_cert_pem(ca_cert);
+    X509 *root = load_cert_pem(root_cert);
+    X509 *trcert = load_cert_pem(sroot_cert);
+    STACK_OF(X509) *untrusted = sk_X509_new_null();
+    STACK_OF(X509) *roots = sk_X509_new_null();
+    X509_STORE *store = X509_STORE_new();
+    X509_STORE_CTX *ctx = X509_STORE_CTX_new();
+    X509_LOOKUP *lookup;
+    BIO *out = NULL;
+    int testresult = 0;
+
+    if (!TEST_ptr(eecert)
+            || !TEST_ptr(untr)
+            || !TEST_ptr(root)
+            || !TEST_ptr(trcert)
+            || !TEST_ptr(untrusted)
+            || !TEST_ptr(roots)
+            || !TEST_ptr(store)
+            || !TEST_ptr(ctx)
+            || !TEST_true(sk_X509_push(untrusted, untr)))
+        goto err;
+    untr = NULL;
+    if (!TEST_true(sk_X509_push(roots, root)))
+        goto err;
+    root = NULL;
+    if (!TEST_true(sk_X509_push(roots, trcert)))
+        goto err;
+    trcert = NULL;
+
+    if (!TEST_ptr(out = BIO_new_file(bundle, "wb"))
+            || !TEST_true(X509_write_bundle_bio(out, roots)))
+        goto err;
+    BIO_free(out);
+    out = NULL;
+
+    if (!TEST_ptr(lookup = X509_STORE_add_lookup(store, X509_LOOKUP_bundle()))
+            || !TEST_false(X509_LOOKUP_add_bundle(lookup, ee_cert))
+            || !TEST_true(X509_LOOKUP_add_bundle(lookup, bundle))
+            || !TEST_true(X509_STORE_CTX_init(ctx, store, eecert, untrusted))
+            || !TEST_int_eq(X509_verify_cert(ctx), 1)
+            || !TEST_int_eq(sk_X509_num(X509_STORE_CTX_get0_chain(ctx)), 3))
+        goto err;
+
+    testresult = 1;
+ err:
+    BIO_free(out);
+    X509_STORE_CTX_free(ctx);
+    X509_STORE_free(store);
+    sk_X509_pop_free(untrusted, X509_free);
+    sk_X509_pop_free(roots, X509_free);
+    X509_free(eecert);
+    X509_free(untr);
+    X509_free(root);
+    X509_free(trcert);
+    remove(bundle);
+    return testresult;
+}
+
+static int sig_jobs_run;
+
+/* Run the jobs inline, last first, to check that the order does not matter */
+static int reverse_dispatch(X509_STORE_CTX *ctx, void (*run)(void *job),
+                            void **jobs, int njobs, void *arg)
+{
+    while (njobs-- > 0) {
+        run(jobs[njobs]);
+        sig_jobs_run++;
+    }
+    return *(int *)arg;
+}
+
+static int test_sig_dispatch(int tst)
+{
+    X509 *eecert = load_cert_pem(ee_cert);
+    X509 *untr = load_cert_pem(ca_cert);
+    X509 *trcert = load_cert_pem(sroot_cert);
+    STACK_OF(X509) *untrusted = sk_X509_new_null();
+    X509_STORE *store = X509_STORE_new();
+    X509_STORE_CTX *ctx = X509_STORE_CTX_new();
+    int dispatch_ok = tst == 0;
+    int testresult = 0;
+
+    if (!TEST_ptr(eecert)
+            || !TEST_ptr(untr)
+            || !TEST_ptr(trcert)
+            || !TEST_ptr(untrusted)
+            || !TEST_ptr(store)
+            || !TEST_ptr(ctx)
+            || !TEST_true(sk_X509_push(untrusted, untr)))
+        goto err;
+    untr = NULL;
+
+    sig_jobs_run = 0;
+    if (!TEST_true(X509_STORE_add_cert(store, trcert))
+            || !TEST_true(X509_STORE_CTX_init(ctx, store, eecert, untrusted)))
+        goto err;
+    X509_STORE_CTX_set_sig_dispatch(ctx, reverse_dispatch, &dispatch_ok);
+    if (!TEST_int_eq(X509_verify_cert(ctx), 1)
+            || !TEST_int_eq(X509_STORE_CTX_get_error(ctx), X509_V_OK)
+            || !TEST_int_eq(sig_jobs_run, 2))
+        goto err;
+
+    testresult = 1;
+ err:
+    X509_STORE_CTX_free(ctx);
+    X509_STORE_free(store);
+    sk_X509_pop_free(untrusted, X509_free);
+    X509_free(eecert);
+    X509_free(untr);
+    X509_free(trcert);
+    return testresult;
+}
+
+/* A worker pool on the store is picked up by each X509_STORE_CTX_init() */
+static int test_store_worker_pool(void)
+{
+    X509 *eecert = load_cert_pem(ee_cert);
+    X509 *untr = load_cert_pem(ca_cert);
+    X509 *trcert = load_cert_pem(sroot_cert);
+    STACK_OF(X509) *untrusted = sk_X509_new_null();
+    X509_STORE *store = X509_STORE_new();
+    X509_STORE_CTX *ctx = X509_STORE_CTX_new();
+    /* Without thread support this is NULL and the checks run inline */
+    OSSL_WORKER_POOL *pool = OSSL_WORKER_POOL_new(2);
+    int i, testresult = 0;
+
+    if (!TEST_ptr(eecert)
+            || !TEST_ptr(untr)
+            || !TEST_ptr(trcert)
+            || !TEST_ptr(untrusted)
+            || !TEST_ptr(store)
+            || !TEST_ptr(ctx)
+            || !TEST_true(sk_X509_push(untrusted, untr)))
+        goto err;
+    untr = NULL;
+
+    if (!TEST_ptr_null(X509_STORE_get0_worker_pool(store))
+            || !TEST_true(X509_STORE_add_cert(store, trcert)))
+        goto err;
+    X509_STORE_set0_worker_pool(store, pool);
+    if (!TEST_ptr_eq(X509_STORE_get0_worker_pool(store), pool))
+        goto err;
+
+    /* The second time round the store's pool is overridden */
+    for (i = 0; i < 2; i++) {
+        sig_jobs_run = 0;
+        if (!TEST_true(X509_STORE_CTX_init(ctx, store, eecert, untrusted)))
+            goto err;
+        if (i == 1)
+            X509_STORE_CTX_set_sig_dispatch(ctx, reverse_dispatch, &i);
+        if (!TEST_int_eq(X509_verify_cert(ctx), 1)
+                || !TEST_int_eq(X509_STORE_CTX_get_error(ctx), X509_V_OK)
+                || !TEST_int_eq(sig_jobs_run, i == 0 ? 0 : 2))
+            goto err;
+        X509_STORE_CTX_cleanup(ctx);
+    }
+
+    testresult = 1;
+ err:
+    X509_STORE_CTX_free(ctx);
+    X509_STORE_free(store);
+    OSSL_WORKER_POOL_free(pool);
+    sk_X509_pop_free(untrusted, X509_free);
+    X509_free(eecert);
+    X509_free(untr);
+    X509_free(trcert);
+    return testresult;
+}
+
+static int test_verify_batch(void)
+{
+    X509 *certs[3] = { NULL, NULL, NULL };
+    STACK_OF(X509) *untrusted[3] = { NULL, NULL, NULL };
+    X509 *untr = load_cert_pem(ca_cert);
+    X509 *trcert = load_cert_pem(sroot_cert);
+    X509_STORE *store = X509_STORE_new();
+    int errors[3], i, testresult = 0;
+
+    if (!TEST_ptr(untr)
+            || !TEST_ptr(trcert)
+            || !TEST_ptr(store)
+            || !TEST_true(X509_STORE_add_cert(store, trcert)))
+        goto err;
+    for (i = 0; i < 3; i++)
+        if (!TEST_ptr(certs[i] = load_cert_pem(ee_cert)))
+            goto err;
+    /* The third certificate has no path to the root */
+    for (i = 0; i < 2; i++)
+        if (!TEST_ptr(untrusted[i] = sk_X509_new_null())
+                || !TEST_true(sk_X509_push(untrusted[i], untr))
+                || !TEST_true(X509_up_ref(untr)))
+            goto err;
+
+    if (!TEST_int_eq(X509_verify_cert_batch(store, certs, untrusted, 3,
+                                            errors), 2)
+            || !TEST_int_eq(errors[0], X509_V_OK)
+            || !TEST_int_eq(errors[1], X509_V_OK)
+            || !TEST_int_eq(errors[2],
+                            X509_V_ERR_UNABLE_TO_GET_ISSUER_CERT_LOCALLY))
+        goto err;
+
+    testresult = 1;
+ err:
+    for (i = 0; i < 3; i++) {
+        X509_free(certs[i]);
+        sk_X509_pop_free(untrusted[i], X509_free);
+    }
+    X509_STORE_free(store);
+    X509_free(untr);
+    X509_free(trcert);
+    return testresult;
+}
+
 int setup_tests(void)
 {
     if (!TEST_ptr(certs_dir = test_get_argument(0))) {
@@ -315,9 +739,11 @@ int setup_tests(void)
             || !TEST_ptr(untrusted_f = test_mk_file_path(certs_dir, "untrusted.pem"))
             || !TEST_ptr(bad_f = test_mk_file_path(certs_dir, "bad.pem"))
             || !TEST_ptr(good_f = test_mk_file_path(certs_dir, "rootCA.pem"))
+            || !TEST_ptr(root_cert = test_mk_file_path(certs_dir, "root-cert.pem"))
             || !TEST_ptr(sroot_cert = test_mk_file_path(certs_dir, "sroot-cert.pem"))
             || !TEST_ptr(ca_cert = test_mk_file_path(certs_dir, "ca-cert.pem"))
-            || !TEST_ptr(ee_cert = test_mk_file_path(certs_dir, "ee-cert.pem")))
+            || !TEST_ptr(ee_cert = test_mk_file_path(certs_dir, "ee-cert.pem"))
+            || !TEST_ptr(ca_key = test_mk_file_path(certs_dir, "ca-key.pem")))
         goto err;
 
     ADD_TEST(test_alt_chains_cert_forgery);
@@ -327,6 +753,12 @@ int setup_tests(void)
     ADD_TEST(test_purpose_ssl_client);
     ADD_TEST(test_purpose_ssl_server);
     ADD_TEST(test_purpose_any);
+    ADD_TEST(test_chain_cache);
+    ADD_TEST(test_chain_cache_crl);
+    ADD_TEST(test_bundle_lookup);
+    ADD_ALL_TESTS(test_sig_dispatch, 2);
+    ADD_TEST(test_store_worker_pool);
+    ADD_TEST(test_verify_batch);
     return 1;
  err:
     cleanup_tests();
@@ -339,7 +771,9 @@ void cleanup_tests(void)
     OPENSSL_free(untrusted_f);
     OPENSSL_free(bad_f);
     OPENSSL_free(good_f);
+    OPENSSL_free(root_cert);
     OPENSSL_free(sroot_cert);
     OPENSSL_free(ca_cert);
     OPENSSL_free(ee_cert);
+    OPENSSL_free(ca_key);
 }
@@ -21,6 +21,7 @@
 # pragma names restore
 #endif
 
+#include "internal/nelem.h"
 #include "testutil.h"
 
 static const unsigned char simple1[] = { 0xff };
@@ -28,6 +29,9 @@ static const unsigned char simple2[] = { 0x01, 0xff };
 static const unsigned char simple3[] = { 0x00, 0x00, 0x00, 0x01, 0xff };
 static const unsigned char nestedsub[] = { 0x03, 0xff, 0x01, 0xff };
 static const unsigned char seqsub[] = { 0x01, 0xff, 0x01, 0xff };
+static const unsigned char deepsub[] = {
+    0x0b, 0x0a, 0x09, 0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, 0xff
+};
 static const unsigned char empty[] = { 0x00 };
 static const unsigned char alloc[] = { 0x02, 0xfe, 0xff };
 static const unsigned char submem[] = { 0x03, 0x02, 0xfe, 0xff };
@@ -169,6 +173,7 @@ static int test_WPACKET_start_sub_packet(void)
     WPACKET pkt;
     size_t written;
     size_t len;
+    size_t i;
 
     if (!TEST_true(WPACKET_init(&pkt, buf))
             || !TEST_true(WPACKET_start_sub_packet(&pkt))
@@ -242,6 +247,31 @@ static int test_WPACKET_start_sub_packet(void)
             || !TEST_true(WPACKET_finish(&pkt)))
         return cleanup(&pkt);
 
+    /* Nesting deeper than the sub-packets kept inside the WPACKET */
+    if (!TEST_true(WPACKET_init(&pkt, buf)))
+        return cleanup(&pkt);
+    for (i = 0; i < OSSL_NELEM(deepsub) - 1; i++)
+        if (!TEST_true(WPACKET_start_sub_packet_u8(&pkt)))
+            return cleanup(&pkt);
+    if (!TEST_true(WPACKET_put_bytes_u8(&pkt, 0xff)))
+        return cleanup(&pkt);
+    for (i = 0; i < OSSL_NELEM(deepsub) - 1; i++)
+        if (!TEST_true(WPACKET_close(&pkt)))
+            return cleanup(&pkt);
+    if (!TEST_false(WPACKET_close(&pkt))
+            || !TEST_true(WPACKET_finish(&pkt))
+            || !TEST_true(WPACKET_get_total_written(&pkt, &written))
+            || !TEST_mem_eq(buf->data, written, deepsub, sizeof(deepsub)))
+        return cleanup(&pkt);
+
+    /* Abandoning a deeply nested packet frees the allocated levels */
+    if (!TEST_true(WPACKET_init(&pkt, buf)))
+        return cleanup(&pkt);
+    for (i = 0; i < OSSL_NELEM(deepsub); i++)
+        if (!TEST_true(WPACKET_start_sub_packet_u8(&pkt)))
+            return cleanup(&pkt);
+    WPACKET_cleanup(&pkt);
+
     return 1;
 }
 
@@ -12,10 +12,12 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <openssl/pem.h>
 #include <openssl/x509.h>
 #include <openssl/x509v3.h>
 #include "testutil.h"
 #include "internal/nelem.h"
+#include "crypto/x509.h"
 
 /**********************************************************************
  *
@@ -111,9 +113,274 @@ static int test_a2i_ipaddress(int idx)
     return good;
 }
 
+static X509_NAME *make_name(const char *cn)
+{
+    X509_NAME *nm = X509_NAME_new();
+
+    if (nm != NULL && cn != NULL
+        && !X509_NAME_add_entry_by_txt(nm, "CN", MBSTRING_ASC,
+                                       (const unsigned char *)cn, -1, -1, 0)) {
+        X509_NAME_free(nm);
+        nm = NULL;
+    }
+    return nm;
+}
+
+static const struct {
+    const char *a, *b;
+    int equal;
+} name_equal_tests[] = {
+    {"Test CA", "Test CA", 1},
+    {"Test CA", "  test   ca ", 1},
+    {"Test CA", "Test CB", 0},
+    {"Test CA", "Test CA 2", 0},
+    {"Test CA", NULL, 0},
+    {NULL, NULL, 1},
+};
+
+static int test_x509_name_equal(int idx)
+{
+    X509_NAME *a = make_name(name_equal_tests[idx].a);
+    X509_NAME *b = make_name(name_equal_tests[idx].b);
+    int good = TEST_ptr(a)
+        && TEST_ptr(b)
+        && TEST_int_eq(x509_name_equal(a, b), name_equal_tests[idx].equal)
+        && TEST_int_eq(X509_NAME_cmp(a, b) == 0, name_equal_tests[idx].equal);
+
+    X509_NAME_free(a);
+    X509_NAME_free(b);
+    return good;
+}
+
+static const char flat_cert[] =
+    "-----BEGIN CERTIFICATE-----\n"
+    "MIIBOjCB7aADAgECAgkAhPEIPRzjLZUwBQYDK2VwMBkxFzAVBgNVBAMMDklFVEYg\n"
+    "VGVzdCBEZW1vMCAXDTE3MDQxOTIxMzYzOVoYDzIxMjIxMTExMTUzNzA1WjAZMRcw\n"
+    "FQYDVQQDDA5JRVRGIFRlc3QgRGVtbzAqMAUGAytlcAMhABm/RAlphM3+hUG6wWfc\n"
+    "O5bIUIaqMLa2ywxcOK1wMWbho1AwTjAdBgNVHQ4EFgQUoozB+G5ZYNPgOudcliyX\n"
+    "qNRIKTwwHwYDVR0jBBgwFoAUoozB+G5ZYNPgOudcliyXqNRIKTwwDAYDVR0TBAUw\n"
+    "AwEB/zAFBgMrZXADQQAI+fxJNwwDZO2QcInr8WnKdTtxFY/rgEUA24ibZkacpOFQ\n"
+    "xVlDmGY3bbdZUV20nR2JJbT2h0O30zuFuY7hqEYE\n"
+    "-----END CERTIFICATE-----\n";
+
+static int test_x509_flat(void)
+{
+    BIO *bio = NULL;
+    X509 *x = NULL, *flat = NULL, *dup = NULL;
+    ASN1_BIT_STRING *key;
+    unsigned char *der = NULL, *der2 = NULL;
+    const unsigned char *p;
+    int derlen, der2len = 0, ret = 0;
+
+    if (!TEST_ptr(bio = BIO_new_mem_buf(flat_cert, -1))
+            || !TEST_ptr(x = PEM_read_bio_X509(bio, NULL, NULL, NULL))
+            || !TEST_int_gt(derlen = i2d_X509(x, &der), 0))
+        goto err;
+
+    /* The flat decoding must be the same certificate, sharing the DER */
+    p = der;
+    if (!TEST_ptr(flat = d2i_X509_flat(NULL, &p, derlen))
+            || !TEST_ptr_eq(p, der + derlen)
+            || !TEST_int_eq(X509_cmp(x, flat), 0)
+            || !TEST_ptr(key = X509_get0_pubkey_bitstr(flat))
+            || !TEST_true(key->flags & ASN1_STRING_FLAG_BORROWED)
+            || !TEST_true(flat->signature.flags & ASN1_STRING_FLAG_BORROWED)
+            || !TEST_false(flat->cert_info.enc.modified)
+            || !TEST_int_eq(der2len = i2d_X509(flat, &der2), derlen)
+            || !TEST_mem_eq(der, derlen, der2, der2len)
+            || !TEST_int_eq(ASN1_OCTET_STRING_cmp(X509_get0_subject_key_id(x),
+                                                  X509_get0_subject_key_id(flat)),
+                            0))
+        goto err;
+#ifndef OPENSSL_NO_EC
+    if (!TEST_int_eq(X509_verify(flat, X509_get0_pubkey(flat)), 1))
+        goto err;
+#endif
+
+    /* Copies own their content */
+    if (!TEST_ptr(dup = X509_dup(flat))
+            || !TEST_false(X509_get0_pubkey_bitstr(dup)->flags
+                           & ASN1_STRING_FLAG_BORROWED)
+            || !TEST_int_eq(X509_cmp(dup, flat), 0))
+        goto err;
+
+    /* Borrowed content is copied before it is modified */
+    if (!TEST_true(ASN1_BIT_STRING_set_bit(key, 0, 0))
+            || !TEST_false(key->flags & ASN1_STRING_FLAG_BORROWED)
+            || !TEST_mem_eq(key->data, key->length,
+                            X509_get0_pubkey_bitstr(x)->data,
+                            X509_get0_pubkey_bitstr(x)->length))
+        goto err;
+
+    /* Decoding into an existing flat certificate replaces it */
+    p = der;
+    if (!TEST_ptr(d2i_X509_flat(&dup, &p, derlen))
+            || !TEST_int_eq(X509_cmp(dup, x), 0))
+        goto err;
+    ret = 1;
+
+ err:
+    OPENSSL_free(der);
+    OPENSSL_free(der2);
+    X509_free(dup);
+    X509_free(flat);
+    X509_free(x);
+    BIO_free(bio);
+    return ret;
+}
+
+static int test_x509_shared(void)
+{
+    BIO *bio = NULL;
+    X509 *x = NULL, *a = NULL, *b = NULL;
+    ASN1_SHARED_BUF *buf = NULL;
+    unsigned char *der = NULL, *chain = NULL;
+    const unsigned char *p;
+    int derlen, ret = 0;
+
+    if (!TEST_ptr(bio = BIO_new_mem_buf(flat_cert, -1))
+            || !TEST_ptr(x = PEM_read_bio_X509(bio, NULL, NULL, NULL))
+            || !TEST_int_gt(derlen = i2d_X509(x, &der), 0)
+            || !TEST_ptr(chain = OPENSSL_malloc(2 * derlen)))
+        goto err;
+    memcpy(chain, der, derlen);
+    memcpy(chain + derlen, der, derlen);
+    if (!TEST_ptr(buf = ASN1_SHARED_BUF_new0(chain, 2 * derlen)))
+        goto err;
+    chain = NULL;
+
+    /* Two certificates from one buffer, both pointing into it */
+    p = ASN1_SHARED_BUF_get0_data(buf);
+    if (!TEST_ptr(a = d2i_X509_shared(NULL, buf, &p, 2 * derlen))
+            || !TEST_ptr(b = d2i_X509_shared(NULL, buf, &p, derlen))
+            || !TEST_ptr_eq(p, ASN1_SHARED_BUF_get0_data(buf) + 2 * derlen)
+            || !TEST_ptr_eq(X509_get0_pubkey_bitstr(b)->data,
+                            X509_get0_pubkey_bitstr(a)->data + derlen))
+        goto err;
+
+    /* A range that isn't all within the buffer is refused */
+    p = der;
+    if (!TEST_ptr_null(d2i_X509_shared(NULL, buf, &p, derlen)))
+        goto err;
+    p = ASN1_SHARED_BUF_get0_data(buf) + derlen;
+    if (!TEST_ptr_null(d2i_X509_shared(NULL, buf, &p, derlen + 1)))
+        goto err;
+    ERR_clear_error();
+
+    /* The certificates keep the buffer alive */
+    ASN1_SHARED_BUF_free(buf);
+    buf = NULL;
+    if (!TEST_int_eq(X509_cmp(a, x), 0)
+            || !TEST_int_eq(X509_cmp(b, x), 0))
+        goto err;
+#ifndef OPENSSL_NO_EC
+    if (!TEST_int_eq(X509_verify(b, X509_get0_pubkey(a)), 1))
+        goto err;
+#endif
+    ret = 1;
+
+ err:
+    OPENSSL_free(der);
+    OPENSSL_free(chain);
+    ASN1_SHARED_BUF_free(buf);
+    X509_free(a);
+    X509_free(b);
+    X509_free(x);
+    BIO_free(bio);
+    return ret;
+}
+
+static int test_x509_intern(void)
+{
+    BIO *bio = NULL;
+    X509 *x = NULL, *a = NULL, *b = NULL, *c = NULL, *d = NULL;
+    X509_STORE *store = NULL;
+    STACK_OF(X509_OBJECT) *objs;
+    unsigned char *der = NULL;
+    const unsigned char *p;
+    int derlen, ret = 0;
+
+    X509_intern_enable(1);
+    if (!TEST_ptr(bio = BIO_new_mem_buf(flat_cert, -1))
+            || !TEST_ptr(x = PEM_read_bio_X509(bio, NULL, NULL, NULL))
+            || !TEST_int_gt(derlen = i2d_X509(x, &der), 0))
+        goto err;
+
+    /* The same encoding decodes to the same object */
+    p = der;
+    if (!TEST_ptr(a = d2i_X509_intern(NULL, &p, derlen))
+            || !TEST_ptr_eq(p, der + derlen)
+            || !TEST_int_eq(X509_cmp(a, x), 0))
+        goto err;
+    p = der;
+    if (!TEST_ptr(b = d2i_X509_intern(NULL, &p, derlen))
+            || !TEST_ptr_eq(p, der + derlen)
+            || !TEST_ptr_eq(b, a))
+        goto err;
+
+    /* A certificate decoded elsewhere is swapped for the shared one */
+    if (!TEST_ptr(c = X509_dup(x))
+            || !TEST_ptr_eq(c = X509_intern(c), a))
+        goto err;
+
+    /* Not one with trust settings though */
+    if (!TEST_ptr(d = X509_dup(x))
+            || !TEST_true(X509_alias_set1(d, (unsigned char *)"d", -1))
+            || !TEST_ptr_eq(X509_intern(d), d))
+        goto err;
+
+    /* Stores hold the shared certificate */
+    if (!TEST_ptr(store = X509_STORE_new())
+            || !TEST_true(X509_STORE_add_cert(store, x))
+            || !TEST_ptr(objs = X509_STORE_get0_objects(store))
+            || !TEST_int_eq(sk_X509_OBJECT_num(objs), 1)
+            || !TEST_ptr_eq(X509_OBJECT_get0_X509(sk_X509_OBJECT_value(objs,
+                                                                       0)),
+                            a))
+        goto err;
+
+    /* Certificates only the table refers to are dropped */
+    if (!TEST_size_t_eq(X509_intern_flush(), 1))
+        goto err;
+    X509_STORE_free(store);
+    store = NULL;
+    X509_free(a);
+    X509_free(b);
+    X509_free(c);
+    a = b = c = NULL;
+    if (!TEST_size_t_eq(X509_intern_flush(), 0))
+        goto err;
+
+    /* Nothing is shared while interning is off */
+    X509_intern_enable(0);
+    p = der;
+    if (!TEST_ptr(a = d2i_X509_intern(NULL, &p, derlen))
+            || !TEST_ptr(b = X509_dup(a))
+            || !TEST_ptr_eq(X509_intern(b), b)
+            || !TEST_size_t_eq(X509_intern_flush(), 0))
+        goto err;
+    ret = 1;
+
+ err:
+    X509_intern_enable(0);
+    OPENSSL_free(der);
+    X509_STORE_free(store);
+    X509_free(a);
+    X509_free(b);
+    X509_free(c);
+    X509_free(d);
+    X509_free(x);
+    BIO_free(bio);
+    return ret;
+}
+
 int setup_tests(void)
 {
     ADD_TEST(test_standard_exts);
     ADD_ALL_TESTS(test_a2i_ipaddress, OSSL_NELEM(a2i_ipaddress_tests));
+    ADD_ALL_TESTS(test_x509_name_equal, OSSL_NELEM(name_equal_tests));
+    ADD_TEST(test_x509_flat);
+    ADD_TEST(test_x509_shared);
+    ADD_TEST(test_x509_intern);
     return 1;
 }